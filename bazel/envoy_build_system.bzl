@@ -24,6 +24,12 @@ def envoy_copts(repository, test = False):
     }) + select({
         repository + "//bazel:disable_signal_trace": [],
         "//conditions:default": ["-DENVOY_HANDLE_SIGNALS"],
+    }) + select({
+        repository + "//bazel:enable_native_buffer": ["-DENVOY_NATIVE_BUFFER"],
+        "//conditions:default": [],
+    }) + select({
+        repository + "//bazel:std_regex": ["-DENVOY_STD_REGEX"],
+        "//conditions:default": [],
     }) + select({
         # TCLAP command line parser needs this to support int64_t/uint64_t
         "@bazel_tools//tools/osx:darwin": ["-DHAVE_LONG_LONG"],
@@ -229,6 +235,36 @@ def envoy_cc_test(name,
         local = local,
     )
 
+# Envoy C++ micro-benchmark binaries should be specified with this function. These are not run
+# as part of the test suite; build and run them explicitly, e.g.
+# bazel run -c opt //test/common/http:header_map_impl_speed_test.
+def envoy_cc_benchmark_binary(name,
+                              srcs = [],
+                              data = [],
+                              external_deps = [],
+                              deps = [],
+                              repository = ""):
+    envoy_cc_test_library(
+        name = name + "_lib",
+        srcs = srcs,
+        data = data,
+        external_deps = external_deps + ["benchmark"],
+        deps = deps,
+        repository = repository,
+    )
+    native.cc_binary(
+        name = name,
+        testonly = 1,
+        copts = envoy_copts(repository, test = True),
+        linkopts = envoy_test_linkopts(),
+        linkstatic = 1,
+        malloc = tcmalloc_external_dep(repository),
+        deps = [
+            ":" + name + "_lib",
+            repository + "//test/benchmark:main",
+        ],
+    )
+
 # Envoy C++ test related libraries (that want gtest, gmock) should be specified
 # with this function.
 def envoy_cc_test_library(name,
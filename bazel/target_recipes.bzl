@@ -3,12 +3,17 @@
 # ci/build_container/build_recipes.
 TARGET_RECIPES = {
     "ares": "cares",
+    "benchmark": "benchmark",
+    "brotlidec": "brotli",
+    "brotlienc": "brotli",
     "event": "libevent",
     "event_pthreads": "libevent",
     "tcmalloc_and_profiler": "gperftools",
     "luajit": "luajit",
     "nghttp2": "nghttp2",
+    "re2": "re2",
     "ssl": "boringssl",
     "yaml_cpp": "yaml-cpp",
     "zlib": "zlib",
+    "zstd": "zstd",
 }
@@ -0,0 +1,15 @@
+#!/bin/bash
+
+set -e
+
+VERSION=1.0.2
+
+wget -O brotli-"$VERSION".tar.gz https://github.com/google/brotli/archive/v"$VERSION".tar.gz
+tar xf brotli-"$VERSION".tar.gz
+cd brotli-"$VERSION"
+cmake -DCMAKE_INSTALL_PREFIX:PATH="$THIRDPARTY_BUILD" \
+  -DCMAKE_C_FLAGS:STRING="${CFLAGS} ${CPPFLAGS}" \
+  -DCMAKE_BUILD_TYPE=RelWithDebInfo .
+make VERBOSE=1 install
+# Envoy links the static libraries, which are not installed by every release.
+cp libbrotlicommon-static.a libbrotlidec-static.a libbrotlienc-static.a "$THIRDPARTY_BUILD"/lib
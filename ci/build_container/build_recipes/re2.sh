@@ -0,0 +1,11 @@
+#!/bin/bash
+
+set -e
+
+VERSION=2018-02-01
+
+wget -O re2-"$VERSION".tar.gz https://github.com/google/re2/archive/"$VERSION".tar.gz
+tar xf re2-"$VERSION".tar.gz
+cd re2-"$VERSION"
+make CXXFLAGS="$CXXFLAGS -O3 -pthread" obj/libre2.a
+make prefix="$THIRDPARTY_BUILD" static-install
@@ -77,6 +77,15 @@ public:
   virtual std::string format(const Http::HeaderMap& request_headers,
                              const Http::HeaderMap& response_headers,
                              const RequestInfo::RequestInfo& request_info) const PURE;
+  /**
+   * Append the formatted value to a string rather than returning it, so that a caller formatting
+   * many values can reuse one string for all of them.
+   * @param output supplies the string to append to.
+   */
+  virtual void formatTo(const Http::HeaderMap& request_headers,
+                        const Http::HeaderMap& response_headers,
+                        const RequestInfo::RequestInfo& request_info,
+                        std::string& output) const PURE;
 };
 
 typedef std::unique_ptr<Formatter> FormatterPtr;
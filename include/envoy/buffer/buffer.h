@@ -44,6 +44,15 @@ public:
    */
   virtual void add(const Instance& data) PURE;
 
+  /**
+   * Add the data of another buffer by sharing its memory rather than copying it, where the
+   * implementation supports that, and copy it otherwise. The shared memory is reference counted,
+   * so the other buffer may be drained or destroyed afterwards, but it must not be added to while
+   * this buffer holds the data.
+   * @param data supplies the buffer to share.
+   */
+  virtual void addBufferReference(const Instance& data) PURE;
+
   /**
    * Commit a set of slices originally obtained from reserve(). The number of slices can be
    * different from the number obtained from reserve(). The size of each slice can also be altered.
@@ -52,6 +61,14 @@ public:
    */
   virtual void commit(RawSlice* iovecs, uint64_t num_iovecs) PURE;
 
+  /**
+   * Release memory which the buffer holds beyond the data it contains, e.g. the drained and
+   * reservable space of the slices that a small amount of data is left in. This may copy the data,
+   * so it is meant for buffers that are not expected to change for a while, such as those of idle
+   * connections. The length and content of the buffer are unchanged.
+   */
+  virtual void compact() PURE;
+
   /**
    * Copy out a section of the buffer.
    * @param start supplies the buffer index to start copying from.
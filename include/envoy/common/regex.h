@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "envoy/common/pure.h"
+
+namespace Envoy {
+namespace Regex {
+
+/**
+ * A compiled regular expression.
+ */
+class CompiledMatcher {
+public:
+  virtual ~CompiledMatcher() {}
+
+  /**
+   * @param value supplies the start of the value to match.
+   * @param size supplies the length of the value.
+   * @return bool whether the entire value matches the expression.
+   */
+  virtual bool match(const char* value, size_t size) const PURE;
+};
+
+typedef std::unique_ptr<const CompiledMatcher> CompiledMatcherPtr;
+typedef std::shared_ptr<const CompiledMatcher> CompiledMatcherSharedPtr;
+
+/**
+ * A set of regular expressions compiled together so that a value can be matched against all of
+ * them in a single pass.
+ */
+class CompiledMatcherSet {
+public:
+  virtual ~CompiledMatcherSet() {}
+
+  /**
+   * @param value supplies the start of the value to match.
+   * @param size supplies the length of the value.
+   * @param matches supplies the vector that the indexes (in the order the expressions were
+   *        supplied at compilation) of every expression that matches the entire value are
+   *        appended to, in ascending order.
+   */
+  virtual void match(const char* value, size_t size, std::vector<uint32_t>& matches) const PURE;
+};
+
+typedef std::unique_ptr<const CompiledMatcherSet> CompiledMatcherSetPtr;
+
+} // namespace Regex
+} // namespace Envoy
@@ -1,12 +1,14 @@
 #pragma once
 
+#include <memory>
+
 #include "envoy/buffer/buffer.h"
 
 namespace Envoy {
 namespace Compressor {
 
 /**
- * Allows compressing data.
+ * Allows compressing data. A compressor writes a single stream at a time.
  */
 class Compressor {
 public:
@@ -18,7 +20,31 @@ public:
    * @param output_buffer supplies the buffer to output compressed data.
    */
   virtual void compress(const Buffer::Instance& input_buffer, Buffer::Instance& output_buffer) PURE;
+
+  /**
+   * Compresses any input that the compressor is holding on to and writes all of the output
+   * produced so far, so that a decompressor can decode everything passed to compress() without
+   * waiting for the end of the stream. Flushing often degrades the compression ratio.
+   * @param output_buffer supplies the buffer to output compressed data.
+   */
+  virtual void flush(Buffer::Instance& output_buffer) PURE;
+
+  /**
+   * Ends the stream once all data has been passed to compress(). Compresses any remaining input
+   * and writes the end of the stream to the output buffer. No more data can be compressed until
+   * reset() is called.
+   * @param output_buffer supplies the buffer to output compressed data.
+   */
+  virtual void finish(Buffer::Instance& output_buffer) PURE;
+
+  /**
+   * Prepares the compressor to start a new stream with the parameters it was initialized with. This
+   * is cheaper than creating a new compressor, as most of the compression state is reused.
+   */
+  virtual void reset() PURE;
 };
 
+typedef std::unique_ptr<Compressor> CompressorPtr;
+
 } // namespace Compressor
 } // namespace Envoy
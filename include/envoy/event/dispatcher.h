@@ -6,6 +6,7 @@
 #include <string>
 #include <vector>
 
+#include "envoy/common/time.h"
 #include "envoy/event/file_event.h"
 #include "envoy/event/signal.h"
 #include "envoy/event/timer.h"
@@ -122,6 +123,16 @@ public:
    */
   virtual TimerPtr createTimer(TimerCb cb) PURE;
 
+  /**
+   * Allocate a timer for a timeout that does not need millisecond precision, such as an idle
+   * timeout. It fires no earlier than requested, but may fire up to a few tens of milliseconds
+   * later. In exchange, arming and disarming it are much cheaper than for createTimer(), which
+   * matters for timers that are re-armed on every read. @see Event::Timer for docs on how to use
+   * the timer.
+   * @param cb supplies the callback to invoke when the timer fires.
+   */
+  virtual TimerPtr createCoarseTimer(TimerCb cb) PURE;
+
   /**
    * Submit an item for deferred delete. @see DeferredDeletable.
    */
@@ -163,6 +174,45 @@ public:
    * @return the watermark buffer factory for this dispatcher.
    */
   virtual Buffer::WatermarkFactory& getWatermarkFactory() PURE;
+
+  /**
+   * Start exporting stats for resources owned by the dispatcher, such as the buffer slice pool
+   * shared by all connections running on it.
+   * @param scope supplies the scope to create the stats in.
+   * @param prefix supplies the stat prefix, e.g. "server.worker_0.".
+   */
+  virtual void initializeStats(Stats::Scope& scope, const std::string& prefix) PURE;
+
+  /**
+   * Start timing the event loop. Every iteration records how long the loop waited for events and
+   * how long it then spent running callbacks, and callbacks that block the loop for too long are
+   * counted and logged along with their event type. Must be called before run().
+   * @param scope supplies the scope to create the stats in.
+   * @param prefix supplies the stat prefix, e.g. "server.worker_0.". The stats are created under
+   *        "<prefix>dispatcher.".
+   */
+  virtual void initializeLoopStats(Stats::Scope& scope, const std::string& prefix) PURE;
+
+  /**
+   * @return a monotonic time source that reads the clock at most once per event loop iteration.
+   *         While the loop runs, every read in the same iteration returns the same time, which
+   *         may lag the real time by however long the iteration's callbacks have run so far. Only
+   *         use it where loop granularity is good enough, such as for request timing.
+   */
+  virtual MonotonicTimeSource& approximateMonotonicTimeSource() PURE;
+
+  /**
+   * @return a system time source that reads the clock at most once per event loop iteration.
+   *         @see approximateMonotonicTimeSource().
+   */
+  virtual SystemTimeSource& approximateSystemTimeSource() PURE;
+
+  /**
+   * @return const char* the kind of event whose callback the loop is running, e.g. "timer",
+   *         "file_event" or "post", or nullptr if it is not running one. Safe to call from any
+   *         thread, so that a stalled loop can be reported on from outside of it.
+   */
+  virtual const char* runningCallbackType() const PURE;
 };
 
 typedef std::unique_ptr<Dispatcher> DispatcherPtr;
@@ -54,6 +54,13 @@ public:
    * stream object and no further callbacks will be invoked.
    */
   virtual void resetStream() PURE;
+
+  /***
+   * @return bool whether the messages sent so far are backed up in the upstream connection beyond
+   *         its high watermark. Callers that send periodically may skip a send while this holds,
+   *         rather than queue more behind it.
+   */
+  virtual bool isAboveWriteBufferHighWatermark() const PURE;
 };
 
 template <class ResponseType> class AsyncRequestCallbacks {
@@ -78,6 +78,19 @@ public:
      * Called when the async HTTP stream is reset.
      */
     virtual void onReset() PURE;
+
+    /**
+     * Called when the upstream connection has more request data queued than its high watermark
+     * allows. Callers should hold off sending more data until onBelowWriteBufferLowWatermark().
+     * The watermarks are those of the upstream connection, which are set by the buffer limits of
+     * the cluster.
+     */
+    virtual void onAboveWriteBufferHighWatermark() PURE;
+
+    /**
+     * Called when the queued request data has drained below the low watermark again.
+     */
+    virtual void onBelowWriteBufferLowWatermark() PURE;
   };
 
   /**
@@ -126,6 +139,20 @@ public:
      * Reset the stream.
      */
     virtual void reset() PURE;
+
+    /***
+     * @return bool whether the upstream connection has more request data queued than its high
+     *         watermark allows, in which case callers should hold off sending more.
+     */
+    virtual bool isAboveWriteBufferHighWatermark() const PURE;
+
+    /***
+     * Stop or resume reading response data from upstream, e.g. because the caller can not keep up
+     * with it. The upstream stream stops being read, so that flow control pushes back on the
+     * remote. Calls nest: reading resumes once every disable has been matched by an enable.
+     * @param disable supplies whether to stop or resume reading.
+     */
+    virtual void readDisable(bool disable) PURE;
   };
 
   virtual ~AsyncClient() {}
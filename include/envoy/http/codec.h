@@ -192,6 +192,9 @@ struct Http2Settings {
   uint32_t max_concurrent_streams_{DEFAULT_MAX_CONCURRENT_STREAMS};
   uint32_t initial_stream_window_size_{DEFAULT_INITIAL_STREAM_WINDOW_SIZE};
   uint32_t initial_connection_window_size_{DEFAULT_INITIAL_CONNECTION_WINDOW_SIZE};
+  // Grow the receive windows past their initial sizes, up to MAX_AUTO_TUNED_WINDOW_SIZE, when the
+  // data received within one round trip (measured with PING frames) comes close to filling them.
+  bool window_auto_tuning_{false};
 
   // disable HPACK compression
   static const uint32_t MIN_HPACK_TABLE_SIZE = 0;
@@ -225,6 +228,9 @@ struct Http2Settings {
   // our default connection-level window also equals to our stream-level
   static const uint32_t DEFAULT_INITIAL_CONNECTION_WINDOW_SIZE = 256 * 1024 * 1024;
   static const uint32_t MAX_INITIAL_CONNECTION_WINDOW_SIZE = (1U << 31) - 1;
+
+  // auto-tuning never grows a window past 16MiB, which covers 1Gbps with a 128ms round trip
+  static const uint32_t MAX_AUTO_TUNED_WINDOW_SIZE = 16 * 1024 * 1024;
 };
 
 /**
@@ -326,6 +332,13 @@ public:
    * @return StreamEncoder& supplies the encoder to write the request into.
    */
   virtual StreamEncoder& newStream(StreamDecoder& response_decoder) PURE;
+
+  /**
+   * @return uint64_t the number of streams that the remote currently allows to be open at once.
+   *         Streams created beyond this limit are queued by the codec until earlier streams
+   *         complete.
+   */
+  virtual uint64_t maxConcurrentStreams() PURE;
 };
 
 typedef std::unique_ptr<ClientConnection> ClientConnectionPtr;
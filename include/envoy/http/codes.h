@@ -1,5 +1,9 @@
 #pragma once
 
+#include <cstdint>
+
+#include "envoy/common/pure.h"
+
 namespace Envoy {
 namespace Http {
 
@@ -72,5 +76,24 @@ enum class Code {
   // clang-format on
 };
 
+/**
+ * Response code counters of an upstream, resolved once so that charging a response does not need
+ * to build stat names.
+ */
+class CodeStats {
+public:
+  virtual ~CodeStats() {}
+
+  /**
+   * Charge the counters of a response, e.g. upstream_rq_2xx and upstream_rq_200, along with the
+   * canary. and the internal. or external. variants of them.
+   * @param response_code supplies the response code.
+   * @param upstream_canary supplies whether the response is from a canary host.
+   * @param internal_request supplies whether the request is internal.
+   */
+  virtual void chargeResponseStat(uint64_t response_code, bool upstream_canary,
+                                  bool internal_request) PURE;
+};
+
 } // namespace Http
 } // namespace Envoy
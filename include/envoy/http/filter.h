@@ -195,6 +195,20 @@ public:
    */
   virtual void addDecodedData(Buffer::Instance& data, bool streaming_filter) PURE;
 
+  /**
+   * Decode data with the filters after this one, without buffering it in the connection manager.
+   * This is used by a filter which has held the body back itself, having returned StopIteration
+   * from decodeHeaders() and StopIterationNoBuffer from decodeData(), and which then passes it on
+   * in pieces. The first call sends the headers to the further filters. If the request has
+   * trailers, the filter calls continueDecoding() after the last piece to send them.
+   *
+   * It is an error to call this method from within a callback of this filter.
+   *
+   * @param data supplies the data to be decoded.
+   * @param end_stream supplies whether this is the last data and there are no trailers.
+   */
+  virtual void injectDecodedDataToFilterChain(Buffer::Instance& data, bool end_stream) PURE;
+
   /**
    * Called with headers to be encoded, optionally indicating end of stream.
    *
@@ -235,6 +249,14 @@ public:
    */
   virtual void onDecoderFilterBelowWriteBufferLowWatermark() PURE;
 
+  /**
+   * @return bool whether a decoder filter has called onDecoderFilterAboveWriteBufferHighWatermark()
+   *         more times than onDecoderFilterBelowWriteBufferLowWatermark(), i.e. the request is
+   *         paused because a buffer it is sent to is backed up. A filter which injects data should
+   *         wait until this is false again.
+   */
+  virtual bool aboveDecoderWriteBufferHighWatermark() PURE;
+
   /**
    * This routine can be called by a filter to subscribe to watermark events on the downstream
    * stream and downstream connection.
@@ -475,6 +497,13 @@ public:
    * @param handler supplies the handler to add.
    */
   virtual void addAccessLogHandler(AccessLog::InstanceSharedPtr handler) PURE;
+
+  /**
+   * Name the filters that are added after this call, e.g. after the filter config that adds them.
+   * The name is used for per filter statistics.
+   * @param name supplies the name, which must outlive the stream.
+   */
+  virtual void setFilterName(const std::string& name) PURE;
 };
 
 /**
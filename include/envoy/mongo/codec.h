@@ -152,6 +152,15 @@ class DecoderCallbacks {
 public:
   virtual ~DecoderCallbacks() {}
 
+  /**
+   * Called once the header of a message has been decoded.
+   * @param op_code supplies the message's op code.
+   * @param response_to supplies the id of the request the message responds to.
+   * @return bool whether to decode the rest of the message. Messages that are not decoded are
+   *         skipped without calling any of the decode*() callbacks.
+   */
+  virtual bool shouldDecode(Message::OpCode op_code, int32_t response_to) PURE;
+
   virtual void decodeGetMore(GetMoreMessagePtr&& message) PURE;
   virtual void decodeInsert(InsertMessagePtr&& message) PURE;
   virtual void decodeKillCursors(KillCursorsMessagePtr&& message) PURE;
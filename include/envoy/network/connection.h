@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <string>
 
@@ -78,6 +79,12 @@ public:
    */
   typedef std::function<void(uint64_t bytes_sent)> BytesSentCb;
 
+  /**
+   * Callback function for when bytes have been spliced out of a connection, see spliceTo().
+   * @param bytes_spliced supplies the number of bytes read from the connection.
+   */
+  typedef std::function<void(uint64_t bytes_spliced)> BytesSplicedCb;
+
   struct ConnectionStats {
     Stats::Counter& read_total_;
     Stats::Gauge& read_current_;
@@ -85,6 +92,15 @@ public:
     Stats::Gauge& write_current_;
     // Counter* as this is an optional counter. Bind errors will not be tracked if this is nullptr.
     Stats::Counter* bind_errors_;
+    // Histogram* as this is an optional histogram. If set, the number of bytes read from the socket
+    // is recorded for every read event that returns data.
+    Stats::Histogram* read_size_;
+    // Histogram* as this is an optional histogram. If set, the number of bytes written to the
+    // socket is recorded for every write event that writes data.
+    Stats::Histogram* write_size_;
+    // Histogram* as this is an optional histogram. If set, the number of write() calls whose data
+    // a write event is the first to write is recorded for every such write event.
+    Stats::Histogram* writes_per_flush_;
   };
 
   virtual ~Connection() {}
@@ -94,6 +110,12 @@ public:
    */
   virtual void addConnectionCallbacks(ConnectionCallbacks& cb) PURE;
 
+  /**
+   * Unregister callbacks that were registered with addConnectionCallbacks(). This must not be
+   * called from within the callbacks of the connection.
+   */
+  virtual void removeConnectionCallbacks(ConnectionCallbacks& cb) PURE;
+
   /**
    * Register for callback everytime bytes are written to the underlying TransportSocket.
    */
@@ -216,6 +238,49 @@ public:
    * @return boolean telling if the connection is currently above the high watermark.
    */
   virtual bool aboveHighWatermark() const PURE;
+
+  /**
+   * Forward all data that arrives on this connection to another connection within the kernel, by
+   * splicing it through a pipe, instead of reading it into the read buffer and raising it to the
+   * read filters. The data is written to the destination after whatever is already in its write
+   * buffer, without going through its write filters. Splicing stops when either connection closes.
+   * @param destination supplies the connection to forward data to.
+   * @param cb supplies the callback to invoke with the number of bytes read from this connection.
+   * @return bool whether splicing started. It does not if this connection is not a plaintext
+   *         socket, the destination is neither a plaintext socket nor a TLS socket whose kernel
+   *         encrypts its writes, this connection has a read filter besides the caller or has
+   *         buffered read data, the destination has write filters, or the platform lacks
+   *         splice(2). The caller keeps forwarding data through buffers in that case.
+   */
+  virtual bool spliceTo(Connection& destination, BytesSplicedCb cb) PURE;
+
+  /**
+   * Release the memory that the read and write buffers hold beyond the data they contain if the
+   * connection has not read or written since the previous call. Calling this periodically releases
+   * the buffers of the connections that were idle for a whole period.
+   * @return bool whether the connection was idle.
+   */
+  virtual bool releaseIdleBuffers() PURE;
+
+  /**
+   * @return uint64_t the number of bytes held in the read and write buffers of the connection.
+   */
+  virtual uint64_t bufferedBytes() const PURE;
+
+  /**
+   * Register a callback that winds the connection down gracefully when it is asked to drain with
+   * startDrain(), e.g. by sending an HTTP/2 GOAWAY and closing once the active requests are done.
+   * Filters that speak a protocol with such a mechanism register one.
+   * @param cb supplies the callback. It is kept for the life of the connection.
+   */
+  virtual void addDrainCallback(std::function<void()> cb) PURE;
+
+  /**
+   * Ask the filters of the connection to wind it down gracefully by invoking the drain callbacks.
+   * Connections without drain callbacks are left alone.
+   * @return bool whether any drain callback was invoked.
+   */
+  virtual bool startDrain() PURE;
 };
 
 typedef std::unique_ptr<Connection> ConnectionPtr;
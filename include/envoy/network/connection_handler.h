@@ -75,6 +75,24 @@ public:
    * Stop all listeners. This will not close any connections and is used for draining.
    */
   virtual void stopListeners() PURE;
+
+  /**
+   * Stop accepting connections on all listeners, including listeners added later, until
+   * enableListeners() is called. Unlike stopListeners(), the listeners keep their sockets.
+   */
+  virtual void disableListeners() PURE;
+
+  /**
+   * Accept connections on all listeners again after disableListeners().
+   */
+  virtual void enableListeners() PURE;
+
+  /**
+   * Cap the buffer limits of connections accepted from now on, e.g. while the server is short of
+   * memory.
+   * @param limit supplies the cap in bytes, or 0 to accept connections with their listener's limit.
+   */
+  virtual void setConnectionBufferLimitCap(uint32_t limit) PURE;
 };
 
 typedef std::unique_ptr<ConnectionHandler> ConnectionHandlerPtr;
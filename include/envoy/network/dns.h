@@ -4,6 +4,7 @@
 #include <list>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "envoy/common/pure.h"
 #include "envoy/network/address.h"
@@ -26,6 +27,15 @@ public:
 
 enum class DnsLookupFamily { V4Only, V6Only, Auto };
 
+/**
+ * The IP addresses that a DNS name resolved to.
+ */
+struct DnsResult {
+  std::string dns_name_;
+  DnsLookupFamily dns_lookup_family_;
+  std::vector<std::string> addresses_;
+};
+
 /**
  * An asynchronous DNS resolver.
  */
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <sys/socket.h>
+
+#include <chrono>
 #include <cstdint>
 #include <memory>
 #include <string>
@@ -10,6 +13,8 @@
 namespace Envoy {
 namespace Network {
 
+class ConnectionBalancer;
+
 /**
  * Listener configurations options.
  */
@@ -25,6 +30,19 @@ struct ListenerOptions {
   bool use_original_dst_;
   // Soft limit on size of the listener's new connection read and write buffers.
   uint32_t per_connection_buffer_limit_bytes_;
+  // If set, accepted sockets may be handed to the same listener on a less loaded worker before a
+  // connection is created for them. The balancer is shared by the listener on every worker.
+  ConnectionBalancer* connection_balancer_;
+  // Create the connections, and so the filter chains, of accepted sockets on the next event loop
+  // iteration rather than as they are accepted. This spreads the cost of a burst of new connections
+  // between the worker's other events.
+  bool defer_connection_creation_;
+  // If non-zero, the buffers of connections that did no I/O for this long are compacted, see
+  // Connection::releaseIdleBuffers().
+  std::chrono::milliseconds idle_buffer_release_interval_;
+  // If non-zero, the connections of the listener are asked to drain at this rate once the
+  // listener is stopped, see Connection::startDrain().
+  uint32_t drain_connections_per_second_;
 
   /**
    * Factory for ListenerOptions with bind_to_port_ set.
@@ -34,7 +52,11 @@ struct ListenerOptions {
     return {.bind_to_port_ = true,
             .use_proxy_proto_ = false,
             .use_original_dst_ = false,
-            .per_connection_buffer_limit_bytes_ = 0};
+            .per_connection_buffer_limit_bytes_ = 0,
+            .connection_balancer_ = nullptr,
+            .defer_connection_creation_ = false,
+            .idle_buffer_release_interval_ = std::chrono::milliseconds(0),
+            .drain_connections_per_second_ = 0};
   }
 };
 
@@ -58,10 +80,131 @@ public:
 class Listener {
 public:
   virtual ~Listener() {}
+
+  /**
+   * Temporarily stop accepting connections. Connections already accepted are not affected.
+   */
+  virtual void disable() PURE;
+
+  /**
+   * Accept connections again after disable().
+   */
+  virtual void enable() PURE;
 };
 
 typedef std::unique_ptr<Listener> ListenerPtr;
 
+/**
+ * A datagram read by a UDP listener. It is only valid during the callback it is passed to.
+ */
+struct UdpRecvData {
+  const sockaddr_storage& peer_address_;
+  socklen_t peer_address_len_;
+  const char* data_;
+  size_t length_;
+};
+
+/**
+ * Callbacks invoked by a UDP listener.
+ */
+class UdpListenerCallbacks {
+public:
+  virtual ~UdpListenerCallbacks() {}
+
+  /**
+   * Called for each datagram read from the socket.
+   * @param data supplies the datagram.
+   */
+  virtual void onData(const UdpRecvData& data) PURE;
+
+  /**
+   * Called once the datagrams of a readiness event of the socket have all been passed to onData(),
+   * e.g. to update stats or to send replies once per batch rather than once per datagram.
+   */
+  virtual void onReadComplete() PURE;
+};
+
+/**
+ * A listener on a datagram socket. Datagrams are read and sent in batches.
+ */
+class UdpListener : public Listener {
+public:
+  /**
+   * Queue a datagram to a peer. Queued datagrams are sent by flush(), or as soon as the queue is
+   * full. Datagrams that cannot be sent right away are dropped.
+   * @param peer_address supplies the address of the peer.
+   * @param peer_address_len supplies the length of the address of the peer.
+   * @param data supplies the datagram, which is copied.
+   * @param length supplies the length of the datagram.
+   */
+  virtual void send(const sockaddr_storage& peer_address, socklen_t peer_address_len,
+                    const char* data, size_t length) PURE;
+
+  /**
+   * Send the queued datagrams.
+   */
+  virtual void flush() PURE;
+};
+
+typedef std::unique_ptr<UdpListener> UdpListenerPtr;
+
+/**
+ * The listener on one worker, as seen by a ConnectionBalancer.
+ */
+class BalancedConnectionHandler {
+public:
+  virtual ~BalancedConnectionHandler() {}
+
+  /**
+   * @return uint64_t the number of connections on the handler's worker, including sockets that
+   *         were posted to it and have not become connections yet. Called from any thread.
+   */
+  virtual uint64_t numConnections() PURE;
+
+  /**
+   * Hand an accepted socket to the handler's worker, which creates the connection for it. Called
+   * from the thread of the worker that accepted the socket.
+   * @param fd supplies the accepted socket. Ownership is transferred.
+   * @param remote_address supplies the remote address of the socket.
+   * @param local_address supplies the local address of the socket.
+   * @param using_original_dst supplies whether the local address is the original destination.
+   */
+  virtual void post(int fd, Address::InstanceConstSharedPtr remote_address,
+                    Address::InstanceConstSharedPtr local_address, bool using_original_dst) PURE;
+};
+
+/**
+ * Spreads the accepted sockets of one listener across its handlers on all workers.
+ */
+class ConnectionBalancer {
+public:
+  virtual ~ConnectionBalancer() {}
+
+  /**
+   * Add a handler that sockets can be posted to. Called from the handler's worker.
+   */
+  virtual void registerHandler(BalancedConnectionHandler& handler) PURE;
+
+  /**
+   * Remove a handler. No socket is posted to it once this returns. Called from the handler's
+   * worker.
+   */
+  virtual void unregisterHandler(BalancedConnectionHandler& handler) PURE;
+
+  /**
+   * Pick the handler for a socket accepted by current, and post the socket to it if it is not
+   * current.
+   * @return bool true if the socket was posted to another handler, false if current should create
+   *         the connection itself.
+   */
+  virtual bool balance(BalancedConnectionHandler& current, int fd,
+                       Address::InstanceConstSharedPtr remote_address,
+                       Address::InstanceConstSharedPtr local_address,
+                       bool using_original_dst) PURE;
+};
+
+typedef std::unique_ptr<ConnectionBalancer> ConnectionBalancerPtr;
+
 /**
  * Thrown when there is a runtime error creating/binding a listener.
  */
@@ -116,6 +116,13 @@ public:
    * Called when underlying transport is established.
    */
   virtual void onConnected() PURE;
+
+  /**
+   * @return bool whether data written straight to the file descriptor, bypassing doWrite(), reaches
+   *         the peer as if it had gone through doWrite(). This holds for plaintext sockets, and for
+   *         TLS sockets once the kernel encrypts what they write.
+   */
+  virtual bool directWritesSupported() const PURE;
 };
 
 typedef std::unique_ptr<TransportSocket> TransportSocketPtr;
@@ -22,8 +22,15 @@ enum class RespType { Null, SimpleString, BulkString, Integer, Error, Array };
 class RespValue {
 public:
   RespValue() : type_(RespType::Null) {}
+  RespValue(const RespValue& other);
   ~RespValue() { cleanup(); }
 
+  /**
+   * Make the value a deep copy of another. A bulk string held in a buffer is copied into a new
+   * buffer.
+   */
+  RespValue& operator=(const RespValue& other);
+
   /**
    * Convert a RESP value to a string for debugging purposes.
    */
@@ -40,6 +47,22 @@ public:
   int64_t& asInteger();
   int64_t asInteger() const;
 
+  /**
+   * A bulk string can also be held in a buffer, which the decoder does for large ones so that
+   * their data is moved rather than copied on its way from the connection it arrived on to the
+   * one it is sent on. asString() copies a bulk string held in a buffer into a std::string, which
+   * then holds it from there on.
+   */
+  bool hasBuffer() const { return buffer_ != nullptr; }
+  Buffer::Instance& asBuffer();
+  const Buffer::Instance& asBuffer() const;
+
+  /**
+   * Make the value a bulk string held in a buffer.
+   * @param buffer supplies the buffer, which is now owned by the value.
+   */
+  void buffer(Buffer::InstancePtr&& buffer);
+
   /**
    * Get/set the type of the RespValue. A RespValue can only be a single type at a time. Each time
    * type() is called the type is changed and then the type specific as* methods can be used.
@@ -57,6 +80,7 @@ private:
   void cleanup();
 
   RespType type_;
+  Buffer::InstancePtr buffer_;
 };
 
 typedef std::unique_ptr<RespValue> RespValuePtr;
@@ -119,6 +143,14 @@ public:
    * @param out supplies the buffer to encode to.
    */
   virtual void encode(const RespValue& value, Buffer::Instance& out) PURE;
+
+  /**
+   * Encode a RESP value to a buffer, moving the data of the bulk strings it holds in buffers
+   * rather than copying it.
+   * @param value supplies the value to encode, which is consumed.
+   * @param out supplies the buffer to encode to.
+   */
+  virtual void encode(RespValuePtr&& value, Buffer::Instance& out) PURE;
 };
 
 typedef std::unique_ptr<Encoder> EncoderPtr;
@@ -48,7 +48,9 @@ public:
 
   /**
    * Make a split redis request.
-   * @param request supplies the split request to make.
+   * @param request supplies the split request to make. It must stay valid until the request
+   *        completes or is cancelled, as requests that are redirected by the upstream are made
+   *        again.
    * @param callbacks supplies the split request completion callbacks.
    * @return SplitRequestPtr a handle to the active request or nullptr if the request has already
    *         been satisfied (via onResponse() being called). The splitter ALWAYS calls
@@ -3,6 +3,7 @@
 #include <chrono>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "envoy/redis/codec.h"
 #include "envoy/upstream/cluster_manager.h"
@@ -129,6 +130,41 @@ public:
    */
   virtual PoolRequest* makeRequest(const std::string& hash_key, const RespValue& request,
                                    PoolCallbacks& callbacks) PURE;
+
+  /**
+   * Makes a read only redis request, which is made to a replica of the host that serves the key
+   * if the pool knows of one, as it does for a redis cluster, and like makeRequest() otherwise.
+   * @param hash_key supplies the key to use for consistent hashing.
+   * @param request supplies the request to make.
+   * @param callbacks supplies the request completion callbacks.
+   * @return PoolRequest* a handle to the active request or nullptr if the request could not be made
+   *         for some reason.
+   */
+  virtual PoolRequest* makeReplicaRequest(const std::string& hash_key, const RespValue& request,
+                                          PoolCallbacks& callbacks) PURE;
+
+  /**
+   * Groups keys whose requests are made to the same upstream, and which can therefore be requested
+   * together in one multi key command made with any of them as the hash key.
+   * @param hash_keys supplies the keys.
+   * @return std::vector<std::vector<uint32_t>> the groups, as indexes into hash_keys. Every key is
+   *         in exactly one group, and the keys of a group are in the order of hash_keys.
+   */
+  virtual std::vector<std::vector<uint32_t>>
+  groupKeys(const std::vector<const std::string*>& hash_keys) PURE;
+
+  /**
+   * Makes a redis request again after a redis cluster node answered it with a MOVED or ASK
+   * redirection to the node that serves the slot of its key.
+   * @param redirection supplies the error the request was answered with.
+   * @param request supplies the request to make.
+   * @param callbacks supplies the request completion callbacks.
+   * @return PoolRequest* a handle to the active request or nullptr if the error is not a
+   *         redirection or names a host that is not part of the cluster.
+   */
+  virtual PoolRequest* makeRedirectedRequest(const RespValue& redirection,
+                                             const RespValue& request,
+                                             PoolCallbacks& callbacks) PURE;
 };
 
 typedef std::unique_ptr<Instance> InstancePtr;
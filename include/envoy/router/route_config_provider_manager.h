@@ -13,6 +13,7 @@
 #include "envoy/upstream/cluster_manager.h"
 
 #include "api/filter/network/http_connection_manager.pb.h"
+#include "api/rds.pb.h"
 
 namespace Envoy {
 namespace Router {
@@ -42,6 +43,18 @@ public:
   getRouteConfigProvider(const envoy::api::v2::filter::network::Rds& rds,
                          Upstream::ClusterManager& cm, Stats::Scope& scope,
                          const std::string& stat_prefix, Init::Manager& init_manager) PURE;
+
+  /**
+   * Get a RouteConfigProviderSharedPtr for a static route configuration. Providers with equal
+   * route configurations may share their route table.
+   * @param route_config supplies the route configuration.
+   * @param runtime supplies the runtime loader.
+   * @param cm supplies the cluster manager, which the clusters of the routes are validated
+   *        against unless the route configuration turns that off.
+   */
+  virtual RouteConfigProviderSharedPtr
+  getStaticRouteConfigProvider(const envoy::api::v2::RouteConfiguration& route_config,
+                               Runtime::Loader& runtime, Upstream::ClusterManager& cm) PURE;
 };
 
 /**
@@ -20,6 +20,10 @@
 #include "common/protobuf/utility.h"
 
 namespace Envoy {
+namespace Upstream {
+class ClusterHandle;
+} // namespace Upstream
+
 namespace Router {
 
 /**
@@ -55,6 +59,12 @@ public:
    */
   virtual const std::list<std::string>& allowOrigins() const PURE;
 
+  /**
+   * @param origin supplies the origin of a request.
+   * @return bool whether allowOrigins() contains the origin or "*".
+   */
+  virtual bool originAllowed(const std::string& origin) const PURE;
+
   /**
    * @return std::string access-control-allow-methods value.
    */
@@ -178,6 +188,28 @@ public:
   virtual const std::string& runtimeKey() const PURE;
 };
 
+/**
+ * Per route policy for request hedging. A hedged request is sent again to another upstream host if
+ * the first host has not responded within a percentile of the cluster's recent response times.
+ * Whichever response arrives first is used and the other request is reset.
+ */
+class HedgePolicy {
+public:
+  virtual ~HedgePolicy() {}
+
+  /**
+   * @return double the percentile of the cluster's recent response times to wait for before
+   *         hedging, between 0 and 100. 0 means that requests are not hedged.
+   */
+  virtual double latencyPercentile() const PURE;
+
+  /**
+   * @return std::chrono::milliseconds the least time to wait for before hedging, however fast the
+   *         cluster's recent responses were.
+   */
+  virtual std::chrono::milliseconds minDelay() const PURE;
+};
+
 /**
  * Virtual cluster definition (allows splitting a virtual host into virtual clusters orthogonal to
  * routes for stat tracking and priority purposes).
@@ -290,6 +322,12 @@ public:
    */
   virtual const std::string& clusterName() const PURE;
 
+  /**
+   * @return const Upstream::ClusterHandle* the handle of clusterName(), resolved when the route was
+   *         configured, or nullptr if the cluster is only looked up by name.
+   */
+  virtual const Upstream::ClusterHandle* clusterHandle() const PURE;
+
   /**
    * Returns the HTTP status code to use when configured cluster is not found.
    * @return Http::Code to use when configured cluster is not found.
@@ -348,6 +386,12 @@ public:
    */
   virtual const ShadowPolicy& shadowPolicy() const PURE;
 
+  /**
+   * @return const HedgePolicy& the hedge policy for the route. All routes have a hedge policy even
+   *         if it is disabled.
+   */
+  virtual const HedgePolicy& hedgePolicy() const PURE;
+
   /**
    * @return std::chrono::milliseconds the route's timeout.
    */
@@ -458,6 +502,12 @@ public:
   virtual RouteConstSharedPtr route(const Http::HeaderMap& headers,
                                     uint64_t random_value) const PURE;
 
+  /**
+   * @return bool whether route() only depends on the host and path headers of the request, so that
+   *         its result may be reused for later requests with the same host and path.
+   */
+  virtual bool routeCacheable() const PURE;
+
   /**
    * Return a list of headers that will be cleaned from any requests that are not from an internal
    * (RFC1918) source.
@@ -4,15 +4,46 @@
 #include <memory>
 #include <string>
 
+#include "envoy/buffer/buffer.h"
+#include "envoy/http/header_map.h"
 #include "envoy/http/message.h"
 
 namespace Envoy {
 namespace Router {
 
 /**
- * Interface used to shadow complete requests to an alternate upstream cluster in a "fire and
- * forget" fashion. Right now this interface takes a fully buffered request and cannot be used for
- * streaming. This is sufficient for current use cases.
+ * A shadowed request whose body and trailers are streamed to the shadow cluster as they arrive.
+ * @see ShadowWriter::streamShadow().
+ */
+class ShadowStream {
+public:
+  virtual ~ShadowStream() {}
+
+  /**
+   * Send the next part of the request body. If the shadow's upstream connection is backed up the
+   * shadow is reset instead, so that it never holds back the request it shadows.
+   * @param data supplies the data, which is copied.
+   * @param end_stream supplies whether this is the end of the request. The handle must not be
+   *        used once it has been sent.
+   */
+  virtual void sendData(Buffer::Instance& data, bool end_stream) PURE;
+
+  /**
+   * Send the request trailers, which ends the request. The handle must not be used afterwards.
+   * @param trailers supplies the trailers, which are copied.
+   */
+  virtual void sendTrailers(const Http::HeaderMap& trailers) PURE;
+
+  /**
+   * Reset the shadow, e.g. because the request it shadows was reset. The handle must not be used
+   * afterwards.
+   */
+  virtual void cancel() PURE;
+};
+
+/**
+ * Interface used to shadow requests to an alternate upstream cluster in a "fire and forget"
+ * fashion. Requests are either shadowed complete, or streamed to the shadow as they arrive.
  */
 class ShadowWriter {
 public:
@@ -26,6 +57,20 @@ public:
    */
   virtual void shadow(const std::string& cluster, Http::MessagePtr&& request,
                       std::chrono::milliseconds timeout) PURE;
+
+  /**
+   * Start shadowing a request of which only the headers have arrived, so that the request need
+   * not be buffered before it is shadowed.
+   * @param cluster supplies the cluster name to shadow to.
+   * @param headers supplies the request headers.
+   * @param end_stream supplies whether the request ends with the headers.
+   * @param timeout supplies the shadowed request timeout.
+   * @return ShadowStream* a handle to send the rest of the request with, which stays valid until
+   *         the request has been ended or the shadow cancelled through it. nullptr if end_stream
+   *         is set or the shadow failed right away, in which case there is nothing more to send.
+   */
+  virtual ShadowStream* streamShadow(const std::string& cluster, Http::HeaderMapPtr&& headers,
+                                     bool end_stream, std::chrono::milliseconds timeout) PURE;
 };
 
 typedef std::unique_ptr<ShadowWriter> ShadowWriterPtr;
@@ -1,8 +1,12 @@
 #pragma once
 
 #include <cstdint>
+#include <cstring>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "envoy/common/pure.h"
 
@@ -26,10 +30,72 @@ public:
    * for example, 7c25513b-0466-4558-a64c-12c6704f37ed
    */
   virtual std::string uuid() PURE;
+
+  /**
+   * Write a new uuid4 without allocating, e.g. straight into the buffer of a header.
+   * @param out supplies the buffer to write the UUID_LENGTH chars of the uuid to.
+   */
+  virtual void writeUuid(char* out) {
+    const std::string uuid = this->uuid();
+    memcpy(out, uuid.data(), uuid.size());
+  }
+
+  static const size_t UUID_LENGTH = 36;
 };
 
 typedef std::unique_ptr<RandomGenerator> RandomGeneratorPtr;
 
+/**
+ * A runtime key that is created once, e.g. as a static or at configuration time, rather than for
+ * every lookup. Each distinct key name is given an index, which snapshots resolve when they load
+ * so that lookups through a Key are an array access instead of hashing the name.
+ */
+class Key {
+public:
+  explicit Key(const std::string& name) : name_(name), index_(registry().indexOf(name)) {}
+
+  const std::string& name() const { return name_; }
+  uint32_t index() const { return index_; }
+
+  /**
+   * @return std::vector<std::string> the names of all keys created so far, ordered by index.
+   */
+  static std::vector<std::string> names() { return registry().names(); }
+
+private:
+  class Registry {
+  public:
+    uint32_t indexOf(const std::string& name) {
+      std::unique_lock<std::mutex> lock(lock_);
+      auto it = indexes_.find(name);
+      if (it != indexes_.end()) {
+        return it->second;
+      }
+      names_.push_back(name);
+      return indexes_[name] = names_.size() - 1;
+    }
+
+    std::vector<std::string> names() {
+      std::unique_lock<std::mutex> lock(lock_);
+      return names_;
+    }
+
+  private:
+    std::mutex lock_;
+    std::unordered_map<std::string, uint32_t> indexes_;
+    std::vector<std::string> names_;
+  };
+
+  // Never destroyed, so that static keys can be created and used during static destruction.
+  static Registry& registry() {
+    static Registry* registry = new Registry();
+    return *registry;
+  }
+
+  const std::string name_;
+  const uint32_t index_;
+};
+
 /**
  * A snapshot of runtime data.
  */
@@ -96,6 +162,26 @@ public:
    * @return uint64_t the runtime value or the default value.
    */
   virtual uint64_t getInteger(const std::string& key, uint64_t default_value) const PURE;
+
+  /**
+   * Variants of the lookups above for keys created ahead of time, which implementations can look
+   * up without hashing the name of the key. By default they look up the name.
+   */
+  virtual bool featureEnabled(const Key& key, uint64_t default_value) const {
+    return featureEnabled(key.name(), default_value);
+  }
+  virtual bool featureEnabled(const Key& key, uint64_t default_value,
+                              uint64_t random_value) const {
+    return featureEnabled(key.name(), default_value, random_value);
+  }
+  virtual bool featureEnabled(const Key& key, uint64_t default_value, uint64_t random_value,
+                              uint16_t num_buckets) const {
+    return featureEnabled(key.name(), default_value, random_value, num_buckets);
+  }
+  virtual const std::string& get(const Key& key) const { return get(key.name()); }
+  virtual uint64_t getInteger(const Key& key, uint64_t default_value) const {
+    return getInteger(key.name(), default_value);
+  }
 };
 
 /**
@@ -2,9 +2,11 @@
 
 #include <cstdint>
 #include <string>
+#include <vector>
 
 #include "envoy/common/pure.h"
 #include "envoy/event/dispatcher.h"
+#include "envoy/network/dns.h"
 
 namespace Envoy {
 namespace Server {
@@ -39,9 +41,12 @@ public:
    * Retrieve a listening socket on the specified address from the parent process. The socket will
    * be duplicated across process boundaries.
    * @param address supplies the address of the socket to duplicate, e.g. tcp://127.0.0.1:5000.
+   * @param worker_index supplies the worker the socket is for. If the parent listener has a
+   *        SO_REUSEPORT socket per worker, this selects the socket. Otherwise the parent listener's
+   *        only socket is returned for any index.
    * @return int the fd or -1 if there is no bound listen port in the parent.
    */
-  virtual int duplicateParentListenSocket(const std::string& address) PURE;
+  virtual int duplicateParentListenSocket(const std::string& address, uint32_t worker_index) PURE;
 
   /**
    * Retrieve stats from our parent process.
@@ -49,6 +54,13 @@ public:
    */
   virtual void getParentStats(GetParentStatsInfo& info) PURE;
 
+  /**
+   * Retrieve the latest DNS results of our parent process, so that our clusters can start with the
+   * hosts our parent is using rather than waiting for DNS.
+   * @param results will be filled with the results of our parent if they can be retrieved.
+   */
+  virtual void getParentDnsResults(std::vector<Network::DnsResult>& results) PURE;
+
   /**
    * Initialize the restarter after primary server initialization begins. The hot restart
    * implementation needs to be created early to deal with shared memory, logging, etc. so
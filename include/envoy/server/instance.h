@@ -3,6 +3,8 @@
 #include <chrono>
 #include <cstdint>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "envoy/access_log/access_log.h"
 #include "envoy/api/api.h"
@@ -16,6 +18,7 @@
 #include "envoy/server/hot_restart.h"
 #include "envoy/server/listener_manager.h"
 #include "envoy/server/options.h"
+#include "envoy/server/overload_manager.h"
 #include "envoy/ssl/context_manager.h"
 #include "envoy/thread_local/thread_local.h"
 #include "envoy/tracing/http_tracer.h"
@@ -24,6 +27,11 @@
 namespace Envoy {
 namespace Server {
 
+/**
+ * The name and duration of each phase of startup, in the order they ran.
+ */
+typedef std::vector<std::pair<std::string, std::chrono::milliseconds>> StartupPhases;
+
 /**
  * An instance of the running server.
  */
@@ -88,6 +96,12 @@ public:
    */
   virtual void getParentStats(HotRestart::GetParentStatsInfo& info) PURE;
 
+  /**
+   * Fetch the latest DNS results of this process for a hot restarted child process.
+   * @param results supplies the vector to fill.
+   */
+  virtual void getDnsResults(std::vector<Network::DnsResult>& results) PURE;
+
   /**
    * @return whether external healthchecks are currently failed or not.
    */
@@ -118,6 +132,11 @@ public:
    */
   virtual Options& options() PURE;
 
+  /**
+   * @return the server's overload manager.
+   */
+  virtual OverloadManager& overloadManager() PURE;
+
   /**
    * @return RandomGenerator& the random generator for the server.
    */
@@ -159,6 +178,12 @@ public:
    */
   virtual time_t startTimeFirstEpoch() PURE;
 
+  /**
+   * @return StartupPhases& the phases of startup that ran so far. Code that initializes the server
+   *         appends the phases it times.
+   */
+  virtual StartupPhases& startupPhases() PURE;
+
   /**
    * @return the server-wide stats store.
    */
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <chrono>
+
 #include "envoy/network/filter.h"
 #include "envoy/network/listen_socket.h"
 #include "envoy/server/drain_manager.h"
@@ -30,6 +32,16 @@ public:
   virtual Network::ListenSocketSharedPtr
   createListenSocket(Network::Address::InstanceConstSharedPtr address, bool bind_to_port) PURE;
 
+  /**
+   * Creates a bound socket with SO_REUSEPORT set, for a listener with a socket per worker.
+   * @param address supplies the socket's address.
+   * @param worker_index supplies the worker the socket is for.
+   * @return Network::ListenSocketSharedPtr an initialized and bound socket.
+   */
+  virtual Network::ListenSocketSharedPtr
+  createReusePortListenSocket(Network::Address::InstanceConstSharedPtr address,
+                              uint32_t worker_index) PURE;
+
   /**
    * Creates a list of filter factories.
    * @param filters supplies the proto configuration.
@@ -71,6 +83,21 @@ public:
    */
   virtual Network::ListenSocket& socket() PURE;
 
+  /**
+   * @return uint32_t the number of sockets the listener accepts on. This is 1 unless the listener
+   *         has a SO_REUSEPORT socket per worker, in which case the kernel balances new
+   *         connections across the workers' sockets.
+   */
+  virtual uint32_t numSockets() PURE;
+
+  /**
+   * @param worker_index supplies the worker, which must be less than numSockets() if the listener
+   *        has more than one socket.
+   * @return Network::ListenSocket& the socket the worker accepts on. This is socket() if the
+   *         listener has a single socket.
+   */
+  virtual Network::ListenSocket& workerSocket(uint32_t worker_index) PURE;
+
   /**
    * @return Ssl::ServerContext* the default SSL context.
    */
@@ -101,6 +128,32 @@ public:
    */
   virtual uint32_t perConnectionBufferLimitBytes() PURE;
 
+  /**
+   * @return Network::ConnectionBalancer* the balancer that spreads the listener's accepted
+   *         sockets across the workers, or nullptr to leave each socket on the worker that
+   *         accepted it.
+   */
+  virtual Network::ConnectionBalancer* connectionBalancer() PURE;
+
+  /**
+   * @return bool whether workers create the connections of accepted sockets on the next event loop
+   *         iteration instead of as they are accepted.
+   */
+  virtual bool deferConnectionCreation() PURE;
+
+  /**
+   * @return std::chrono::milliseconds how long the connections of the listener must do no I/O
+   *         before their buffers are compacted, or 0 to leave their buffers alone.
+   */
+  virtual std::chrono::milliseconds idleBufferReleaseInterval() PURE;
+
+  /**
+   * @return uint32_t how many of the listener's connections each worker asks to drain per second
+   *         once the listener is stopped, or 0 to leave them to the drain decision of their next
+   *         request.
+   */
+  virtual uint32_t drainConnectionsPerSecond() PURE;
+
   /**
    * @return Stats::Scope& the stats scope to use for all listener specific stats.
    */
@@ -112,6 +112,12 @@ public:
    */
   virtual std::chrono::milliseconds fileFlushIntervalMsec() PURE;
 
+  /**
+   * @return uint64_t the number of bytes each thread can buffer for a log file before further
+   *         writes of the thread to it are dropped.
+   */
+  virtual uint64_t fileWriteBufferBytes() PURE;
+
   /**
    * @return const std::string& the server's cluster.
    */
@@ -137,6 +143,37 @@ public:
    * router/cluster/listener.
    */
   virtual uint64_t maxObjNameLength() PURE;
+
+  /**
+   * @return bool whether the main thread and worker dispatchers time their event loop iterations
+   *         and callbacks and export the results as stats.
+   */
+  virtual bool dispatcherStatsEnabled() PURE;
+
+  /**
+   * @return bool whether logging to stderr is buffered and written from the file flush thread, as
+   *         is done for a log file, rather than written synchronously by the logging thread.
+   */
+  virtual bool logAsync() PURE;
+
+  /**
+   * @return bool whether each worker thread is pinned to one of the CPUs the process may run on,
+   *         and listeners with a socket per worker steer connections to the socket of the worker
+   *         on the CPU that receives them.
+   */
+  virtual bool workerCpuAffinity() PURE;
+
+  /**
+   * @return uint32_t the number of threads that run the private key operations of TLS handshakes
+   *         on listeners. 0 runs them inline on the workers.
+   */
+  virtual uint32_t sslPrivateKeyThreads() PURE;
+
+  /**
+   * @return std::chrono::milliseconds how long the server's DNS resolver caches non-empty results
+   *         for the clusters that share it. 0 turns the cache off.
+   */
+  virtual std::chrono::milliseconds dnsCacheTtl() PURE;
 };
 
 } // namespace Server
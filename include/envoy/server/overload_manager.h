@@ -0,0 +1,61 @@
+#pragma once
+
+#include <functional>
+
+#include "envoy/common/pure.h"
+#include "envoy/event/dispatcher.h"
+
+namespace Envoy {
+namespace Server {
+
+/**
+ * Actions the server takes to shed load when it runs short of resources.
+ */
+enum class OverloadActionName {
+  // Close HTTP connections after their current request instead of keeping them alive.
+  DisableHttpKeepAlive,
+  // Cap the buffer limits of new connections.
+  ShrinkBufferLimits,
+  // Stop accepting new connections on all listeners.
+  StopAcceptingConnections,
+};
+
+enum class OverloadActionState { Inactive, Active };
+
+/**
+ * Callback invoked when an overload action changes state.
+ */
+typedef std::function<void(OverloadActionState state)> OverloadActionCb;
+
+/**
+ * Watches the server's resource usage on the main thread and activates overload actions as the
+ * usage approaches the configured limits.
+ */
+class OverloadManager {
+public:
+  virtual ~OverloadManager() {}
+
+  /**
+   * Start watching resource usage. Called on the main thread once the server is ready to serve.
+   */
+  virtual void start() PURE;
+
+  /**
+   * Register a callback for state changes of an action. Must be called on the main thread. The
+   * event loop lag of every dispatcher that callbacks are registered for is one of the watched
+   * resources.
+   * @param action supplies the action to watch.
+   * @param dispatcher supplies the dispatcher the callback is posted to.
+   * @param callback supplies the callback. It is posted right away if the action is active.
+   */
+  virtual void registerForAction(OverloadActionName action, Event::Dispatcher& dispatcher,
+                                 OverloadActionCb callback) PURE;
+
+  /**
+   * @return bool whether an action is active. Can be called from any thread.
+   */
+  virtual bool isActive(OverloadActionName action) const PURE;
+};
+
+} // namespace Server
+} // namespace Envoy
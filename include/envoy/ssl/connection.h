@@ -42,6 +42,12 @@ public:
    *         certificate, or no SAN field, or no URI.
    **/
   virtual std::string uriSanPeerCertificate() PURE;
+
+  /**
+   * @return whether any of the data of the last read was TLS 1.3 early data, which was sent before
+   *         the handshake completed and so may have been replayed by an attacker.
+   **/
+  virtual bool receivedEarlyData() const PURE;
 };
 
 } // namespace Ssl
@@ -92,6 +92,11 @@ public:
     std::array<uint8_t, 256 / 8> aes_key_; // AES256 key size, in bytes
   };
 
+  struct CertificateFiles {
+    std::string cert_chain_file_;
+    std::string private_key_file_;
+  };
+
   /**
    * @return True if client certificate is required, false otherwise.
    */
@@ -103,6 +108,20 @@ public:
    * are candidates for decrypting received tickets.
    */
   virtual const std::vector<SessionTicketKey>& sessionTicketKeys() const PURE;
+
+  /**
+   * @return The files that the session ticket keys were read from, in the same order as the keys,
+   * or an empty vector if any key was configured inline. Replacing one of the files rotates the
+   * keys without a listener update.
+   */
+  virtual const std::vector<std::string>& sessionTicketKeyFiles() const PURE;
+
+  /**
+   * @return The certificates served besides the one of certChainFile() and privateKeyFile(), e.g.
+   * an RSA certificate for clients that do not support the ECDSA one. Each handshake uses the
+   * first of all the certificates that the client supports, or the first one if it supports none.
+   */
+  virtual const std::vector<CertificateFiles>& additionalCertificates() const PURE;
 };
 
 } // namespace Ssl
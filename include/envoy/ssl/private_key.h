@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "envoy/common/pure.h"
+#include "envoy/event/dispatcher.h"
+
+#include "openssl/base.h"
+
+namespace Envoy {
+namespace Ssl {
+
+/**
+ * Callbacks for the completion of a PrivateKeyOperation.
+ */
+class PrivateKeyOperationCallbacks {
+public:
+  virtual ~PrivateKeyOperationCallbacks() {}
+
+  /**
+   * Called on the dispatcher that the operation was started with once the operation completed,
+   * whether it succeeded or not. Never called from within the call that started the operation.
+   */
+  virtual void onPrivateKeyOperationComplete() PURE;
+};
+
+/**
+ * A signature or decryption with a private key on behalf of a TLS handshake, which may run on
+ * another thread or on hardware. Destroying an operation that has not completed cancels it, after
+ * which its callbacks are not called.
+ */
+class PrivateKeyOperation {
+public:
+  virtual ~PrivateKeyOperation() {}
+
+  /**
+   * @return bool whether the operation completed.
+   */
+  virtual bool completed() const PURE;
+
+  /**
+   * @return const std::vector<uint8_t>* the output of a completed operation, or nullptr if it
+   *         failed.
+   */
+  virtual const std::vector<uint8_t>* output() const PURE;
+};
+
+typedef std::unique_ptr<PrivateKeyOperation> PrivateKeyOperationPtr;
+
+/**
+ * Runs the private key operations of TLS handshakes away from the threads of the connections, so
+ * that a burst of handshakes does not keep workers from serving established connections.
+ */
+class PrivateKeyMethodProvider {
+public:
+  virtual ~PrivateKeyMethodProvider() {}
+
+  /**
+   * Start signing a handshake message.
+   * @param key supplies the private key.
+   * @param signature_algorithm supplies the TLS SignatureScheme to sign with.
+   * @param in supplies the message, which is copied.
+   * @param in_len supplies the length of the message.
+   * @param dispatcher supplies the dispatcher to call the callbacks on.
+   * @param callbacks supplies the callbacks for the completion of the operation.
+   * @return PrivateKeyOperationPtr the operation, or nullptr if it could not be started.
+   */
+  virtual PrivateKeyOperationPtr sign(EVP_PKEY& key, uint16_t signature_algorithm,
+                                      const uint8_t* in, size_t in_len,
+                                      Event::Dispatcher& dispatcher,
+                                      PrivateKeyOperationCallbacks& callbacks) PURE;
+
+  /**
+   * Start decrypting the premaster secret of an RSA key exchange, without removing the padding.
+   * @see sign() for the parameters and the return value.
+   */
+  virtual PrivateKeyOperationPtr decrypt(EVP_PKEY& key, const uint8_t* in, size_t in_len,
+                                         Event::Dispatcher& dispatcher,
+                                         PrivateKeyOperationCallbacks& callbacks) PURE;
+};
+
+typedef std::unique_ptr<PrivateKeyMethodProvider> PrivateKeyMethodProviderPtr;
+
+} // namespace Ssl
+} // namespace Envoy
@@ -2,6 +2,7 @@
 
 #include <chrono>
 #include <cstdint>
+#include <functional>
 #include <list>
 #include <memory>
 #include <string>
@@ -65,19 +66,20 @@ class Metric {
 public:
   virtual ~Metric() {}
   /**
-   * Returns the full name of the Metric.
+   * Returns the full name of the Metric. Implementations may store names compactly and render
+   * them on each call, so callers on hot paths should keep the result rather than call repeatedly.
    */
-  virtual const std::string& name() const PURE;
+  virtual std::string name() const PURE;
 
   /**
    * Returns a vector of configurable tags to identify this Metric.
    */
-  virtual const std::vector<Tag>& tags() const PURE;
+  virtual std::vector<Tag> tags() const PURE;
 
   /**
    * Returns the name of the Metric with the portions designated as tags removed.
    */
-  virtual const std::string& tagExtractedName() const PURE;
+  virtual std::string tagExtractedName() const PURE;
 };
 
 /**
@@ -135,6 +137,71 @@ public:
 
 typedef std::shared_ptr<Histogram> HistogramSharedPtr;
 
+/**
+ * Summary statistics computed over a set of histogram samples.
+ */
+class HistogramStatistics {
+public:
+  virtual ~HistogramStatistics() {}
+
+  /**
+   * @return a human readable "P<quantile>: <value>" list of the computed quantiles.
+   */
+  virtual std::string summary() const PURE;
+
+  /**
+   * @return the quantiles, in [0, 1] and ascending order, that computedQuantiles() reports.
+   */
+  virtual const std::vector<double>& supportedQuantiles() const PURE;
+
+  /**
+   * @return the value at each of supportedQuantiles(). Values are NaN when there are no samples.
+   */
+  virtual const std::vector<double>& computedQuantiles() const PURE;
+
+  /**
+   * @return the number of samples the statistics were computed over.
+   */
+  virtual uint64_t sampleCount() const PURE;
+
+  /**
+   * @return the sum of the samples the statistics were computed over.
+   */
+  virtual uint64_t sampleSum() const PURE;
+};
+
+/**
+ * A histogram whose samples are recorded on many threads and aggregated by the store. merge()
+ * folds the samples recorded since the previous merge into the statistics returned by
+ * intervalStatistics() and cumulativeStatistics().
+ */
+class ParentHistogram : public virtual Histogram {
+public:
+  virtual ~ParentHistogram() {}
+
+  /**
+   * Aggregate the samples recorded on every thread. Must be called on the main thread.
+   */
+  virtual void merge() PURE;
+
+  /**
+   * @return statistics over the samples recorded between the last two calls to merge().
+   */
+  virtual const HistogramStatistics& intervalStatistics() const PURE;
+
+  /**
+   * @return statistics over every sample recorded before the last call to merge().
+   */
+  virtual const HistogramStatistics& cumulativeStatistics() const PURE;
+
+  /**
+   * @return a human readable "P<quantile>(<interval value>,<cumulative value>)" list.
+   */
+  virtual std::string summary() const PURE;
+};
+
+typedef std::shared_ptr<ParentHistogram> ParentHistogramSharedPtr;
+
 /**
  * A sink for stats. Each sink is responsible for writing stats to a backing store.
  */
@@ -143,8 +210,8 @@ public:
   virtual ~Sink() {}
 
   /**
-   * This will be called before a sequence of flushCounter() and flushGauge() calls. Sinks can
-   * choose to optimize writing if desired with a paired endFlush() call.
+   * This will be called before a sequence of flushCounter(), flushGauge() and flushHistogram()
+   * calls. Sinks can choose to optimize writing if desired with a paired endFlush() call.
    */
   virtual void beginFlush() PURE;
 
@@ -159,15 +226,17 @@ public:
   virtual void flushGauge(const Gauge& gauge, uint64_t value) PURE;
 
   /**
-   * This will be called after beginFlush(), some number of flushCounter(), and some number of
-   * flushGauge(). Sinks can use this to optimize writing if desired.
+   * Flush a histogram after it has been merged. Histogram samples are aggregated in the store, so
+   * this is the only way sinks see them.
    */
-  virtual void endFlush() PURE;
+  virtual void flushHistogram(const ParentHistogram& histogram) PURE;
 
   /**
-   * Flush a histogram value.
+   * This will be called after beginFlush(), some number of flushCounter(), some number of
+   * flushGauge() and some number of flushHistogram(). Sinks can use this to optimize writing if
+   * desired.
    */
-  virtual void onHistogramComplete(const Histogram& histogram, uint64_t value) PURE;
+  virtual void endFlush() PURE;
 };
 
 typedef std::unique_ptr<Sink> SinkPtr;
@@ -192,7 +261,9 @@ public:
   virtual ScopePtr createScope(const std::string& name) PURE;
 
   /**
-   * Deliver an individual histogram value to all registered sinks.
+   * Deliver an individual histogram value recorded by a histogram allocated from this scope.
+   * Stores that aggregate histograms themselves (see ParentHistogram) do not route samples
+   * through here and may ignore it.
    */
   virtual void deliverHistogramToSinks(const Histogram& histogram, uint64_t value) PURE;
 
@@ -226,6 +297,32 @@ public:
    * @return a list of all known gauges.
    */
   virtual std::list<GaugeSharedPtr> gauges() const PURE;
+
+  /**
+   * @return a list of all known histograms that aggregate their samples. Stores that do not
+   *         aggregate histograms return an empty list.
+   */
+  virtual std::list<ParentHistogramSharedPtr> histograms() const PURE;
+
+  /**
+   * Invoke a callback for every known counter. Unlike counters(), this neither copies the set of
+   * counters nor takes references to them, so it is the preferred way to read every value. The
+   * store may be locked while iterating, so the callback must not create stats or scopes.
+   * @param cb supplies the callback.
+   */
+  virtual void forEachCounter(const std::function<void(Counter&)>& cb) const PURE;
+
+  /**
+   * Invoke a callback for every known gauge. See forEachCounter().
+   * @param cb supplies the callback.
+   */
+  virtual void forEachGauge(const std::function<void(Gauge&)>& cb) const PURE;
+
+  /**
+   * Invoke a callback for every known histogram that aggregates its samples. See forEachCounter().
+   * @param cb supplies the callback.
+   */
+  virtual void forEachHistogram(const std::function<void(ParentHistogram&)>& cb) const PURE;
 };
 
 typedef std::unique_ptr<Store> StorePtr;
@@ -235,11 +332,6 @@ typedef std::unique_ptr<Store> StorePtr;
  */
 class StoreRoot : public Store {
 public:
-  /**
-   * Add a sink that is used for stat flushing.
-   */
-  virtual void addSink(Sink& sink) PURE;
-
   /**
    * Set the set of extractors to extract a portions of stats names as tags.
    */
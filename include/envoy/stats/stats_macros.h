@@ -30,6 +30,9 @@ namespace Envoy {
 #define GENERATE_GAUGE_STRUCT(NAME) Stats::Gauge& NAME##_;
 #define GENERATE_HISTOGRAM_STRUCT(NAME) Stats::Histogram& NAME##_;
 
+// Counts the stats of a stats macro, e.g. 0 MY_COOL_STATS(GENERATE_STAT_COUNT, ...).
+#define GENERATE_STAT_COUNT(NAME) +1
+
 #define FINISH_STAT_DECL_(X) + std::string(#X)),
 
 #define POOL_COUNTER_PREFIX(POOL, PREFIX) (POOL).counter(PREFIX FINISH_STAT_DECL_
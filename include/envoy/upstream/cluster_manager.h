@@ -22,6 +22,30 @@
 namespace Envoy {
 namespace Upstream {
 
+/**
+ * A cluster name that was resolved ahead of time, e.g. when a route was configured, so that
+ * looking the cluster up on the workers does not hash its name. A handle is not tied to one
+ * cluster: it always finds the current cluster of its name, as clusters are added, updated and
+ * removed.
+ */
+class ClusterHandle {
+public:
+  virtual ~ClusterHandle() {}
+
+  /**
+   * Same as ClusterManager::get() for the handle's cluster name.
+   */
+  virtual ThreadLocalCluster* get() const PURE;
+
+  /**
+   * Same as ClusterManager::httpConnPoolForCluster() for the handle's cluster name.
+   */
+  virtual Http::ConnectionPool::Instance* httpConnPool(ResourcePriority priority,
+                                                       LoadBalancerContext* context) const PURE;
+};
+
+typedef std::shared_ptr<const ClusterHandle> ClusterHandleConstSharedPtr;
+
 /**
  * Manages connection pools and load balancing for upstream clusters. The cluster manager is
  * persistent and shared among multiple ongoing requests/connections.
@@ -65,6 +89,13 @@ public:
    */
   virtual ThreadLocalCluster* get(const std::string& cluster) PURE;
 
+  /**
+   * Resolve a cluster name for lookups on the workers. This is thread safe.
+   * @param cluster supplies the cluster name. The cluster does not need to exist yet.
+   * @return ClusterHandleConstSharedPtr the handle, which may be used on any thread.
+   */
+  virtual ClusterHandleConstSharedPtr clusterHandle(const std::string& cluster) PURE;
+
   /**
    * Allocate a load balanced HTTP connection pool for a cluster. This is *per-thread* so that
    * callers do not need to worry about per thread synchronization. The load balancing policy that
@@ -17,8 +17,12 @@ namespace Upstream {
  * All per host stats. @see stats_macros.h
  *
  * {rq_success, rq_error} have specific semantics driven by the needs of EDS load reporting. See
- * envoy.api.v2.UpstreamLocalityStats for the definitions of success/error. These are latched by
- * LoadStatsReporter, independent of the normal stats sink flushing.
+ * envoy.api.v2.UpstreamLocalityStats for the definitions of success/error. They roll up into the
+ * LocalityLoadStats of the host's locality, which LoadStatsReporter latches independent of the
+ * normal stats sink flushing.
+ *
+ * rq_latency_ewma_us is a moving average of the host's response times, kept up to date with
+ * HostUtility::recordResponseTime().
  */
 // clang-format off
 #define ALL_HOST_STATS(COUNTER, GAUGE)                                                             \
@@ -29,7 +33,8 @@ namespace Upstream {
   COUNTER(rq_timeout)                                                                              \
   COUNTER(rq_success)                                                                              \
   COUNTER(rq_error)                                                                                \
-  GAUGE  (rq_active)
+  GAUGE  (rq_active)                                                                               \
+  GAUGE  (rq_latency_ewma_us)
 // clang-format on
 
 /**
@@ -39,6 +44,28 @@ struct HostStats {
   ALL_HOST_STATS(GENERATE_COUNTER_STRUCT, GENERATE_GAUGE_STRUCT)
 };
 
+/**
+ * The load reporting stats of all hosts of a cluster in one locality and at one priority, as load
+ * reports break them down. Each is the sum of the host stat of the same name, kept up to date as
+ * the host stats are written, so that load reports are built per locality rather than per host.
+ * @see stats_macros.h
+ */
+// clang-format off
+#define ALL_LOCALITY_LOAD_STATS(COUNTER, GAUGE)                                                    \
+  COUNTER(rq_success)                                                                              \
+  COUNTER(rq_error)                                                                                \
+  GAUGE  (rq_active)
+// clang-format on
+
+/**
+ * Struct definition for all locality load stats. @see stats_macros.h
+ */
+struct LocalityLoadStats {
+  ALL_LOCALITY_LOAD_STATS(GENERATE_COUNTER_STRUCT, GENERATE_GAUGE_STRUCT)
+};
+
+typedef std::shared_ptr<LocalityLoadStats> LocalityLoadStatsSharedPtr;
+
 class ClusterInfo;
 
 /**
@@ -94,6 +121,12 @@ public:
    *         unknown.
    */
   virtual const envoy::api::v2::Locality& locality() const PURE;
+
+  /**
+   * @return the load stats of the host's locality, which the host's load stats roll up into, or
+   *         nullptr if they are not aggregated for this host.
+   */
+  virtual LocalityLoadStats* localityLoadStats() const PURE;
 };
 
 typedef std::shared_ptr<const HostDescription> HostDescriptionConstSharedPtr;
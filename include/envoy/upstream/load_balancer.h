@@ -57,5 +57,39 @@ public:
 
 typedef std::unique_ptr<LoadBalancer> LoadBalancerPtr;
 
+/**
+ * Factory for load balancers, which may be shared by all workers.
+ */
+class LoadBalancerFactory {
+public:
+  virtual ~LoadBalancerFactory() {}
+
+  /**
+   * @return LoadBalancerPtr a new load balancer for the calling thread, using the most recent
+   *         state of the cluster's hosts. It can be called from any thread.
+   */
+  virtual LoadBalancerPtr create() PURE;
+};
+
+typedef std::shared_ptr<LoadBalancerFactory> LoadBalancerFactorySharedPtr;
+
+/**
+ * A load balancer that does its expensive work once on the main thread on behalf of all workers.
+ * A single instance is created on the main thread on the cluster's priority set. Each worker gets
+ * its load balancers from the shared factory, and creates a new one every time its copy of the
+ * cluster's hosts is updated.
+ */
+class ThreadAwareLoadBalancer {
+public:
+  virtual ~ThreadAwareLoadBalancer() {}
+
+  /**
+   * @return LoadBalancerFactorySharedPtr the factory for worker load balancers.
+   */
+  virtual LoadBalancerFactorySharedPtr factory() PURE;
+};
+
+typedef std::unique_ptr<ThreadAwareLoadBalancer> ThreadAwareLoadBalancerPtr;
+
 } // namespace Upstream
 } // namespace Envoy
@@ -11,6 +11,7 @@
 #include "envoy/common/callback.h"
 #include "envoy/common/optional.h"
 #include "envoy/http/codec.h"
+#include "envoy/http/codes.h"
 #include "envoy/network/connection.h"
 #include "envoy/ssl/context.h"
 #include "envoy/upstream/health_check_host_monitor.h"
@@ -238,6 +239,9 @@ public:
   GAUGE    (upstream_cx_active)                                                                    \
   COUNTER  (upstream_cx_http1_total)                                                               \
   COUNTER  (upstream_cx_http2_total)                                                               \
+  COUNTER  (upstream_cx_http2_stream_limit_total)                                                  \
+  COUNTER  (upstream_cx_idle_timeout)                                                              \
+  COUNTER  (upstream_cx_preconnect_total)                                                          \
   COUNTER  (upstream_cx_connect_fail)                                                              \
   COUNTER  (upstream_cx_connect_timeout)                                                           \
   COUNTER  (upstream_cx_connect_attempts_exceeded)                                                 \
@@ -273,6 +277,9 @@ public:
   COUNTER  (upstream_rq_retry)                                                                     \
   COUNTER  (upstream_rq_retry_success)                                                             \
   COUNTER  (upstream_rq_retry_overflow)                                                            \
+  COUNTER  (upstream_rq_hedge)                                                                     \
+  COUNTER  (upstream_rq_hedge_success)                                                             \
+  COUNTER  (upstream_rq_hedge_same_host)                                                           \
   COUNTER  (upstream_flow_control_paused_reading_total)                                            \
   COUNTER  (upstream_flow_control_resumed_reading_total)                                           \
   COUNTER  (upstream_flow_control_backed_up_total)                                                 \
@@ -314,6 +321,27 @@ struct ClusterLoadReportStats {
   ALL_CLUSTER_LOAD_REPORT_STATS(GENERATE_COUNTER_STRUCT)
 };
 
+/**
+ * Recent upstream response times of a cluster, written by every worker.
+ */
+class LatencyEstimator {
+public:
+  virtual ~LatencyEstimator() {}
+
+  /**
+   * Record the response time of a request to the cluster.
+   * @param response_time supplies the time from the end of the request to the response headers.
+   */
+  virtual void putResponseTime(std::chrono::milliseconds response_time) PURE;
+
+  /**
+   * @param percentile supplies the percentile to estimate, between 0 and 100.
+   * @return Optional<std::chrono::milliseconds> the percentile of the recent response times, or an
+   *         invalid Optional if too few responses have been recorded to estimate it.
+   */
+  virtual Optional<std::chrono::milliseconds> percentile(double percentile) const PURE;
+};
+
 /**
  * Information about a given upstream cluster.
  */
@@ -337,6 +365,12 @@ public:
    */
   virtual std::chrono::milliseconds connectTimeout() const PURE;
 
+  /**
+   * @return how long an upstream connection may sit idle in a connection pool before the pool
+   *         closes it. 0 indicates no timeout.
+   */
+  virtual std::chrono::milliseconds idleTimeout() const PURE;
+
   /**
    * @return soft limit on size of the cluster's connections read and write buffers.
    */
@@ -378,6 +412,14 @@ public:
    */
   virtual uint64_t maxRequestsPerConnection() const PURE;
 
+  /**
+   * @return uint64_t how many spare connections a connection pool keeps to each host, as a
+   *         percentage of the requests that are currently active or pending on that host. The
+   *         spare connections are opened before they are needed so that a rise in load does not
+   *         wait for connection setup. 0 disables preconnecting.
+   */
+  virtual uint64_t preconnectPercent() const PURE;
+
   /**
    * @return the human readable name of the cluster.
    */
@@ -410,6 +452,30 @@ public:
    */
   virtual ClusterLoadReportStats& loadReportStats() const PURE;
 
+  /**
+   * @return Http::CodeStats& the response code counters of the cluster, in its stats scope.
+   */
+  virtual Http::CodeStats& codeStats() const PURE;
+
+  /**
+   * Invoke a callback for every counter of stats() that has not been created in statsScope() yet.
+   * Clusters create their counters when first written if the upstream.lazy_stats runtime key was
+   * set when they were created, so that the stats store lists only the counters in use. Readers
+   * that want every counter, e.g. with a zero value, can list the rest with this.
+   * @param cb supplies the callback.
+   */
+  virtual void forEachLazyCounter(const std::function<void(Stats::Counter&)>& cb) const PURE;
+
+  /**
+   * @param locality supplies a locality of the cluster's hosts.
+   * @param priority supplies the priority of the hosts.
+   * @return LocalityLoadStatsSharedPtr the load stats shared by the cluster's hosts in the
+   *         locality at the priority. They are created by the first such host and freed with the
+   *         last.
+   */
+  virtual LocalityLoadStatsSharedPtr localityLoadStats(const envoy::api::v2::Locality& locality,
+                                                       uint32_t priority) const PURE;
+
   /**
    * Returns an optional source address for upstream connections to bind to.
    *
@@ -421,6 +487,11 @@ public:
    * @return the configuration for load balancer subsets.
    */
   virtual const LoadBalancerSubsetInfo& lbSubsetInfo() const PURE;
+
+  /**
+   * @return LatencyEstimator& the recent response times of the cluster.
+   */
+  virtual LatencyEstimator& latencyEstimator() const PURE;
 };
 
 typedef std::shared_ptr<const ClusterInfo> ClusterInfoConstSharedPtr;
@@ -57,12 +57,17 @@ std::string FormatterImpl::format(const Http::HeaderMap& request_headers,
                                   const RequestInfo::RequestInfo& request_info) const {
   std::string log_line;
   log_line.reserve(256);
+  formatTo(request_headers, response_headers, request_info, log_line);
+  return log_line;
+}
 
+void FormatterImpl::formatTo(const Http::HeaderMap& request_headers,
+                             const Http::HeaderMap& response_headers,
+                             const RequestInfo::RequestInfo& request_info,
+                             std::string& output) const {
   for (const FormatterPtr& formatter : formatters_) {
-    log_line += formatter->format(request_headers, response_headers, request_info);
+    formatter->formatTo(request_headers, response_headers, request_info, output);
   }
-
-  return log_line;
 }
 
 void AccessLogFormatParser::parseCommand(const std::string& token, const size_t start,
@@ -157,94 +162,107 @@ std::vector<FormatterPtr> AccessLogFormatParser::parse(const std::string& format
   return formatters;
 }
 
+// Append an integer without formatting it into a string of its own first.
+template <class Integer> static void appendInteger(Integer value, std::string& output) {
+  const fmt::FormatInt formatted(value);
+  output.append(formatted.data(), formatted.size());
+}
+
+static void appendDuration(const Optional<std::chrono::microseconds>& duration,
+                           std::string& output) {
+  if (duration.valid()) {
+    appendInteger(
+        std::chrono::duration_cast<std::chrono::milliseconds>(duration.value()).count(), output);
+  } else {
+    output += UnspecifiedValueString;
+  }
+}
+
 RequestInfoFormatter::RequestInfoFormatter(const std::string& field_name) {
   if (field_name == "START_TIME") {
-    field_extractor_ = [](const RequestInfo::RequestInfo& request_info) {
-      return AccessLogDateTimeFormatter::fromTime(request_info.startTime());
+    field_writer_ = [](const RequestInfo::RequestInfo& request_info, std::string& output) {
+      output += AccessLogDateTimeFormatter::fromTime(request_info.startTime());
     };
   } else if (field_name == "REQUEST_DURATION") {
-    field_extractor_ = [](const RequestInfo::RequestInfo& request_info) {
-      Optional<std::chrono::microseconds> duration = request_info.requestReceivedDuration();
-      if (duration.valid()) {
-        return std::to_string(
-            std::chrono::duration_cast<std::chrono::milliseconds>(duration.value()).count());
-      } else {
-        return UnspecifiedValueString;
-      }
+    field_writer_ = [](const RequestInfo::RequestInfo& request_info, std::string& output) {
+      appendDuration(request_info.requestReceivedDuration(), output);
     };
   } else if (field_name == "RESPONSE_DURATION") {
-    field_extractor_ = [](const RequestInfo::RequestInfo& request_info) {
-      Optional<std::chrono::microseconds> duration = request_info.responseReceivedDuration();
-      if (duration.valid()) {
-        return std::to_string(
-            std::chrono::duration_cast<std::chrono::milliseconds>(duration.value()).count());
-      } else {
-        return UnspecifiedValueString;
-      }
+    field_writer_ = [](const RequestInfo::RequestInfo& request_info, std::string& output) {
+      appendDuration(request_info.responseReceivedDuration(), output);
     };
   } else if (field_name == "BYTES_RECEIVED") {
-    field_extractor_ = [](const RequestInfo::RequestInfo& request_info) {
-      return std::to_string(request_info.bytesReceived());
+    field_writer_ = [](const RequestInfo::RequestInfo& request_info, std::string& output) {
+      appendInteger(request_info.bytesReceived(), output);
     };
   } else if (field_name == "PROTOCOL") {
-    field_extractor_ = [](const RequestInfo::RequestInfo& request_info) {
-      return AccessLogFormatUtils::protocolToString(request_info.protocol());
+    field_writer_ = [](const RequestInfo::RequestInfo& request_info, std::string& output) {
+      output += AccessLogFormatUtils::protocolToString(request_info.protocol());
     };
   } else if (field_name == "RESPONSE_CODE") {
-    field_extractor_ = [](const RequestInfo::RequestInfo& request_info) {
-      return request_info.responseCode().valid()
-                 ? std::to_string(request_info.responseCode().value())
-                 : "0";
+    field_writer_ = [](const RequestInfo::RequestInfo& request_info, std::string& output) {
+      appendInteger(request_info.responseCode().valid() ? request_info.responseCode().value() : 0,
+                    output);
     };
   } else if (field_name == "BYTES_SENT") {
-    field_extractor_ = [](const RequestInfo::RequestInfo& request_info) {
-      return std::to_string(request_info.bytesSent());
+    field_writer_ = [](const RequestInfo::RequestInfo& request_info, std::string& output) {
+      appendInteger(request_info.bytesSent(), output);
     };
   } else if (field_name == "DURATION") {
-    field_extractor_ = [](const RequestInfo::RequestInfo& request_info) {
-      return std::to_string(
-          std::chrono::duration_cast<std::chrono::milliseconds>(request_info.duration()).count());
+    field_writer_ = [](const RequestInfo::RequestInfo& request_info, std::string& output) {
+      appendInteger(
+          std::chrono::duration_cast<std::chrono::milliseconds>(request_info.duration()).count(),
+          output);
     };
   } else if (field_name == "RESPONSE_FLAGS") {
-    field_extractor_ = [](const RequestInfo::RequestInfo& request_info) {
-      return RequestInfo::ResponseFlagUtils::toShortString(request_info);
+    field_writer_ = [](const RequestInfo::RequestInfo& request_info, std::string& output) {
+      output += RequestInfo::ResponseFlagUtils::toShortString(request_info);
     };
   } else if (field_name == "UPSTREAM_HOST") {
-    field_extractor_ = [](const RequestInfo::RequestInfo& request_info) {
+    field_writer_ = [](const RequestInfo::RequestInfo& request_info, std::string& output) {
       if (request_info.upstreamHost()) {
-        return request_info.upstreamHost()->address()->asString();
+        output += request_info.upstreamHost()->address()->asString();
       } else {
-        return UnspecifiedValueString;
+        output += UnspecifiedValueString;
       }
     };
   } else if (field_name == "UPSTREAM_CLUSTER") {
-    field_extractor_ = [](const RequestInfo::RequestInfo& request_info) {
-      std::string upstream_cluster_name;
-      if (nullptr != request_info.upstreamHost()) {
-        upstream_cluster_name = request_info.upstreamHost()->cluster().name();
+    field_writer_ = [](const RequestInfo::RequestInfo& request_info, std::string& output) {
+      if (nullptr != request_info.upstreamHost() &&
+          !request_info.upstreamHost()->cluster().name().empty()) {
+        output += request_info.upstreamHost()->cluster().name();
+      } else {
+        output += UnspecifiedValueString;
       }
-
-      return upstream_cluster_name.empty() ? UnspecifiedValueString : upstream_cluster_name;
     };
   } else if (field_name == "UPSTREAM_LOCAL_ADDRESS") {
-    field_extractor_ = [](const RequestInfo::RequestInfo& request_info) {
+    field_writer_ = [](const RequestInfo::RequestInfo& request_info, std::string& output) {
       const Optional<std::string>& upstream_local_address = request_info.upstreamLocalAddress();
-      return upstream_local_address.valid() ? upstream_local_address.value()
-                                            : UnspecifiedValueString;
+      output += upstream_local_address.valid() ? upstream_local_address.value()
+                                               : UnspecifiedValueString;
     };
   } else if (field_name == "DOWNSTREAM_ADDRESS") {
-    field_extractor_ = [](const RequestInfo::RequestInfo& request_info) {
+    field_writer_ = [](const RequestInfo::RequestInfo& request_info, std::string& output) {
       const std::string& downstream_address = request_info.getDownstreamAddress();
-      return downstream_address.empty() ? UnspecifiedValueString : downstream_address;
+      output += downstream_address.empty() ? UnspecifiedValueString : downstream_address;
     };
   } else {
     throw EnvoyException(fmt::format("Not supported field in RequestInfo: {}", field_name));
   }
 }
 
-std::string RequestInfoFormatter::format(const Http::HeaderMap&, const Http::HeaderMap&,
+std::string RequestInfoFormatter::format(const Http::HeaderMap& request_headers,
+                                         const Http::HeaderMap& response_headers,
                                          const RequestInfo::RequestInfo& request_info) const {
-  return field_extractor_(request_info);
+  std::string output;
+  formatTo(request_headers, response_headers, request_info, output);
+  return output;
+}
+
+void RequestInfoFormatter::formatTo(const Http::HeaderMap&, const Http::HeaderMap&,
+                                    const RequestInfo::RequestInfo& request_info,
+                                    std::string& output) const {
+  field_writer_(request_info, output);
 }
 
 PlainStringFormatter::PlainStringFormatter(const std::string& str) : str_(str) {}
@@ -254,30 +272,41 @@ std::string PlainStringFormatter::format(const Http::HeaderMap&, const Http::Hea
   return str_;
 }
 
+void PlainStringFormatter::formatTo(const Http::HeaderMap&, const Http::HeaderMap&,
+                                    const RequestInfo::RequestInfo&, std::string& output) const {
+  output += str_;
+}
+
 HeaderFormatter::HeaderFormatter(const std::string& main_header,
                                  const std::string& alternative_header,
                                  const Optional<size_t>& max_length)
     : main_header_(main_header), alternative_header_(alternative_header), max_length_(max_length) {}
 
 std::string HeaderFormatter::format(const Http::HeaderMap& headers) const {
+  std::string output;
+  formatTo(headers, output);
+  return output;
+}
+
+void HeaderFormatter::formatTo(const Http::HeaderMap& headers, std::string& output) const {
   const Http::HeaderEntry* header = headers.get(main_header_);
 
   if (!header && !alternative_header_.get().empty()) {
     header = headers.get(alternative_header_);
   }
 
-  std::string header_value_string;
-  if (!header) {
-    header_value_string = UnspecifiedValueString;
-  } else {
-    header_value_string = header->value().c_str();
+  const char* value = UnspecifiedValueString.c_str();
+  size_t length = UnspecifiedValueString.length();
+  if (header) {
+    value = header->value().c_str();
+    length = header->value().size();
   }
 
-  if (max_length_.valid() && header_value_string.length() > max_length_.value()) {
-    return header_value_string.substr(0, max_length_.value());
+  if (max_length_.valid() && length > max_length_.value()) {
+    length = max_length_.value();
   }
 
-  return header_value_string;
+  output.append(value, length);
 }
 
 ResponseHeaderFormatter::ResponseHeaderFormatter(const std::string& main_header,
@@ -291,6 +320,12 @@ std::string ResponseHeaderFormatter::format(const Http::HeaderMap&,
   return HeaderFormatter::format(response_headers);
 }
 
+void ResponseHeaderFormatter::formatTo(const Http::HeaderMap&,
+                                       const Http::HeaderMap& response_headers,
+                                       const RequestInfo::RequestInfo&, std::string& output) const {
+  HeaderFormatter::formatTo(response_headers, output);
+}
+
 RequestHeaderFormatter::RequestHeaderFormatter(const std::string& main_header,
                                                const std::string& alternative_header,
                                                const Optional<size_t>& max_length)
@@ -302,5 +337,11 @@ std::string RequestHeaderFormatter::format(const Http::HeaderMap& request_header
   return HeaderFormatter::format(request_headers);
 }
 
+void RequestHeaderFormatter::formatTo(const Http::HeaderMap& request_headers,
+                                      const Http::HeaderMap&, const RequestInfo::RequestInfo&,
+                                      std::string& output) const {
+  HeaderFormatter::formatTo(request_headers, output);
+}
+
 } // namespace AccessLog
 } // namespace Envoy
@@ -43,10 +43,12 @@ class FormatterImpl : public Formatter {
 public:
   FormatterImpl(const std::string& format);
 
-  // Formatter::format
+  // Formatter
   std::string format(const Http::HeaderMap& request_headers,
                      const Http::HeaderMap& response_headers,
                      const RequestInfo::RequestInfo& request_info) const override;
+  void formatTo(const Http::HeaderMap& request_headers, const Http::HeaderMap& response_headers,
+                const RequestInfo::RequestInfo& request_info, std::string& output) const override;
 
 private:
   std::vector<FormatterPtr> formatters_;
@@ -60,9 +62,11 @@ class PlainStringFormatter : public Formatter {
 public:
   PlainStringFormatter(const std::string& str);
 
-  // Formatter::format
+  // Formatter
   std::string format(const Http::HeaderMap&, const Http::HeaderMap&,
                      const RequestInfo::RequestInfo&) const override;
+  void formatTo(const Http::HeaderMap&, const Http::HeaderMap&, const RequestInfo::RequestInfo&,
+                std::string& output) const override;
 
 private:
   std::string str_;
@@ -74,6 +78,7 @@ public:
                   const Optional<size_t>& max_length);
 
   std::string format(const Http::HeaderMap& headers) const;
+  void formatTo(const Http::HeaderMap& headers, std::string& output) const;
 
 private:
   Http::LowerCaseString main_header_;
@@ -89,9 +94,11 @@ public:
   RequestHeaderFormatter(const std::string& main_header, const std::string& alternative_header,
                          const Optional<size_t>& max_length);
 
-  // Formatter::format
+  // Formatter
   std::string format(const Http::HeaderMap& request_headers, const Http::HeaderMap&,
                      const RequestInfo::RequestInfo&) const override;
+  void formatTo(const Http::HeaderMap& request_headers, const Http::HeaderMap&,
+                const RequestInfo::RequestInfo&, std::string& output) const override;
 };
 
 /**
@@ -102,9 +109,11 @@ public:
   ResponseHeaderFormatter(const std::string& main_header, const std::string& alternative_header,
                           const Optional<size_t>& max_length);
 
-  // Formatter::format
+  // Formatter
   std::string format(const Http::HeaderMap&, const Http::HeaderMap& response_headers,
                      const RequestInfo::RequestInfo&) const override;
+  void formatTo(const Http::HeaderMap&, const Http::HeaderMap& response_headers,
+                const RequestInfo::RequestInfo&, std::string& output) const override;
 };
 
 /**
@@ -114,12 +123,15 @@ class RequestInfoFormatter : public Formatter {
 public:
   RequestInfoFormatter(const std::string& field_name);
 
-  // Formatter::format
+  // Formatter
   std::string format(const Http::HeaderMap&, const Http::HeaderMap&,
                      const RequestInfo::RequestInfo& request_info) const override;
+  void formatTo(const Http::HeaderMap&, const Http::HeaderMap&,
+                const RequestInfo::RequestInfo& request_info, std::string& output) const override;
 
 private:
-  std::function<std::string(const RequestInfo::RequestInfo&)> field_extractor_;
+  // Appends the field's value to the output.
+  std::function<void(const RequestInfo::RequestInfo&, std::string&)> field_writer_;
 };
 
 } // namespace AccessLog
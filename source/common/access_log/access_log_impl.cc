@@ -190,8 +190,11 @@ void FileAccessLog::log(const Http::HeaderMap* request_headers,
     }
   }
 
-  std::string access_log_line =
-      formatter_->format(*request_headers, *response_headers, request_info);
+  // Access logs are written from every worker, so each formats its lines into its own string. The
+  // string keeps its capacity from line to line.
+  static thread_local std::string access_log_line;
+  access_log_line.clear();
+  formatter_->formatTo(*request_headers, *response_headers, request_info, access_log_line);
   log_file_->write(access_log_line);
 }
 
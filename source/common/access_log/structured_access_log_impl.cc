@@ -0,0 +1,197 @@
+#include "common/access_log/structured_access_log_impl.h"
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include "common/access_log/access_log_formatter.h"
+#include "common/common/assert.h"
+#include "common/http/header_map_impl.h"
+#include "common/http/headers.h"
+#include "common/protobuf/protobuf.h"
+#include "common/request_info/utility.h"
+
+namespace Envoy {
+namespace AccessLog {
+
+static std::string headerValue(const Http::HeaderEntry* header) {
+  return header ? header->value().c_str() : "";
+}
+
+void StructuredAccessLogUtility::fillEntry(const Http::HeaderMap& request_headers,
+                                           const Http::HeaderMap&,
+                                           const RequestInfo::RequestInfo& request_info,
+                                           envoy::accesslog::HttpAccessLogEntry& entry) {
+  entry.set_start_time_us(std::chrono::duration_cast<std::chrono::microseconds>(
+                              request_info.startTime().time_since_epoch())
+                              .count());
+  entry.set_duration_us(request_info.duration().count());
+  if (request_info.requestReceivedDuration().valid()) {
+    entry.set_request_received_duration_us(request_info.requestReceivedDuration().value().count());
+  }
+  if (request_info.responseReceivedDuration().valid()) {
+    entry.set_response_received_duration_us(
+        request_info.responseReceivedDuration().value().count());
+  }
+
+  if (request_info.protocol().valid()) {
+    entry.set_protocol(AccessLogFormatUtils::protocolToString(request_info.protocol()));
+  }
+  entry.set_method(headerValue(request_headers.Method()));
+  entry.set_path(headerValue(request_headers.EnvoyOriginalPath()
+                                 ? request_headers.EnvoyOriginalPath()
+                                 : request_headers.Path()));
+  entry.set_authority(headerValue(request_headers.Host()));
+  entry.set_user_agent(headerValue(request_headers.UserAgent()));
+  entry.set_forwarded_for(headerValue(request_headers.ForwardedFor()));
+  entry.set_request_id(headerValue(request_headers.RequestId()));
+
+  if (request_info.responseCode().valid()) {
+    entry.set_response_code(request_info.responseCode().value());
+  }
+  entry.set_response_flags(RequestInfo::ResponseFlagUtils::toShortString(request_info));
+  entry.set_bytes_received(request_info.bytesReceived());
+  entry.set_bytes_sent(request_info.bytesSent());
+
+  if (request_info.upstreamHost()) {
+    entry.set_upstream_host(request_info.upstreamHost()->address()->asString());
+    entry.set_upstream_cluster(request_info.upstreamHost()->cluster().name());
+  }
+  if (request_info.upstreamLocalAddress().valid()) {
+    entry.set_upstream_local_address(request_info.upstreamLocalAddress().value());
+  }
+  entry.set_downstream_address(request_info.getDownstreamAddress());
+}
+
+bool StructuredAccessLogUtility::evaluate(Filter* filter, const Http::HeaderMap*& request_headers,
+                                          const Http::HeaderMap*& response_headers,
+                                          const RequestInfo::RequestInfo& request_info) {
+  static Http::HeaderMapImpl empty_headers;
+  if (!request_headers) {
+    request_headers = &empty_headers;
+  }
+  if (!response_headers) {
+    response_headers = &empty_headers;
+  }
+
+  return !filter || filter->evaluate(request_info, *request_headers);
+}
+
+BinaryFileAccessLog::BinaryFileAccessLog(const std::string& access_log_path, FilterPtr&& filter,
+                                         AccessLogManager& log_manager)
+    : filter_(std::move(filter)) {
+  log_file_ = log_manager.createAccessLog(access_log_path);
+}
+
+void BinaryFileAccessLog::log(const Http::HeaderMap* request_headers,
+                              const Http::HeaderMap* response_headers,
+                              const RequestInfo::RequestInfo& request_info) {
+  if (!StructuredAccessLogUtility::evaluate(filter_.get(), request_headers, response_headers,
+                                            request_info)) {
+    return;
+  }
+
+  envoy::accesslog::HttpAccessLogEntry entry;
+  StructuredAccessLogUtility::fillEntry(*request_headers, *response_headers, request_info, entry);
+
+  // Write the record and its length prefix in one go, so that records logged concurrently by
+  // different workers do not interleave.
+  static thread_local std::string record;
+  record.clear();
+  {
+    Protobuf::io::StringOutputStream stream(&record);
+    Protobuf::io::CodedOutputStream coded_stream(&stream);
+    coded_stream.WriteVarint32(entry.ByteSize());
+    entry.SerializeWithCachedSizes(&coded_stream);
+  }
+  log_file_->write(record);
+}
+
+GrpcAccessLog::GrpcAccessLog(const envoy::accesslog::StructuredAccessLog& config,
+                             FilterPtr&& filter, AsyncClientFactory async_client_factory,
+                             ThreadLocal::SlotAllocator& tls,
+                             const LocalInfo::LocalInfo& local_info)
+    : filter_(std::move(filter)), tls_slot_(tls.allocateSlot()) {
+  std::shared_ptr<SharedConfig> shared_config = std::make_shared<SharedConfig>();
+  shared_config->identifier_.set_node_id(local_info.nodeName());
+  shared_config->identifier_.set_cluster(local_info.clusterName());
+  shared_config->identifier_.set_log_name(config.log_name());
+  shared_config->buffer_size_bytes_ =
+      config.buffer_size_bytes() > 0 ? config.buffer_size_bytes() : 16384;
+  shared_config->buffer_flush_interval_ = std::chrono::milliseconds(
+      config.buffer_flush_interval_ms() > 0 ? config.buffer_flush_interval_ms() : 1000);
+  shared_config->async_client_factory_ = async_client_factory;
+
+  SharedConfigConstSharedPtr const_config = shared_config;
+  tls_slot_->set([const_config](Event::Dispatcher& dispatcher)
+                     -> ThreadLocal::ThreadLocalObjectSharedPtr {
+    return std::make_shared<ThreadLocalLogger>(const_config, dispatcher);
+  });
+}
+
+void GrpcAccessLog::log(const Http::HeaderMap* request_headers,
+                        const Http::HeaderMap* response_headers,
+                        const RequestInfo::RequestInfo& request_info) {
+  if (!StructuredAccessLogUtility::evaluate(filter_.get(), request_headers, response_headers,
+                                            request_info)) {
+    return;
+  }
+
+  tls_slot_->getTyped<ThreadLocalLogger>().log(*request_headers, *response_headers,
+                                                request_info);
+}
+
+GrpcAccessLog::ThreadLocalLogger::ThreadLocalLogger(SharedConfigConstSharedPtr config,
+                                                    Event::Dispatcher& dispatcher)
+    : config_(config), client_(config_->async_client_factory_()) {
+  flush_timer_ = dispatcher.createTimer([this]() -> void {
+    flush();
+    flush_timer_->enableTimer(config_->buffer_flush_interval_);
+  });
+  flush_timer_->enableTimer(config_->buffer_flush_interval_);
+}
+
+void GrpcAccessLog::ThreadLocalLogger::log(const Http::HeaderMap& request_headers,
+                                           const Http::HeaderMap& response_headers,
+                                           const RequestInfo::RequestInfo& request_info) {
+  envoy::accesslog::HttpAccessLogEntry* entry = message_.add_entries();
+  StructuredAccessLogUtility::fillEntry(request_headers, response_headers, request_info, *entry);
+  pending_bytes_ += entry->ByteSize();
+  if (pending_bytes_ >= config_->buffer_size_bytes_) {
+    flush();
+  }
+}
+
+void GrpcAccessLog::ThreadLocalLogger::flush() {
+  if (message_.entries().empty()) {
+    return;
+  }
+
+  if (stream_ == nullptr) {
+    stream_ = client_->start(*Protobuf::DescriptorPool::generated_pool()->FindMethodByName(
+                                 "envoy.accesslog.AccessLogService.StreamAccessLogs"),
+                             *this);
+    if (stream_ != nullptr) {
+      message_.mutable_identifier()->CopyFrom(config_->identifier_);
+    }
+  }
+
+  if (stream_ != nullptr) {
+    stream_->sendMessage(message_, false);
+  } else {
+    ENVOY_LOG(debug, "dropping {} access log entries: AccessLogService unavailable",
+              message_.entries_size());
+  }
+  message_.Clear();
+  pending_bytes_ = 0;
+}
+
+void GrpcAccessLog::ThreadLocalLogger::onRemoteClose(Grpc::Status::GrpcStatus status,
+                                                     const std::string& message) {
+  ENVOY_LOG(debug, "AccessLogService stream closed: {} {}", status, message);
+  // The next flush opens a new stream.
+  stream_ = nullptr;
+}
+
+} // namespace AccessLog
+} // namespace Envoy
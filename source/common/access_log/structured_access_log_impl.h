@@ -0,0 +1,130 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "envoy/access_log/access_log.h"
+#include "envoy/event/dispatcher.h"
+#include "envoy/event/timer.h"
+#include "envoy/filesystem/filesystem.h"
+#include "envoy/grpc/async_client.h"
+#include "envoy/local_info/local_info.h"
+#include "envoy/thread_local/thread_local.h"
+#include "envoy/upstream/cluster_manager.h"
+
+#include "common/access_log/structured_access_log.pb.h"
+#include "common/common/logger.h"
+
+namespace Envoy {
+namespace AccessLog {
+
+typedef Grpc::AsyncClient<envoy::accesslog::StreamAccessLogsMessage,
+                          envoy::accesslog::StreamAccessLogsResponse>
+    AccessLogServiceAsyncClient;
+typedef std::unique_ptr<AccessLogServiceAsyncClient> AccessLogServiceAsyncClientPtr;
+
+/**
+ * Utility for the structured access logs.
+ */
+class StructuredAccessLogUtility {
+public:
+  /**
+   * Record a request in an access log entry.
+   */
+  static void fillEntry(const Http::HeaderMap& request_headers,
+                        const Http::HeaderMap& response_headers,
+                        const RequestInfo::RequestInfo& request_info,
+                        envoy::accesslog::HttpAccessLogEntry& entry);
+
+  /**
+   * Apply an access log filter, defaulting absent headers to an empty header map the same way the
+   * text access log does.
+   * @return bool whether the request is to be logged.
+   */
+  static bool evaluate(Filter* filter, const Http::HeaderMap*& request_headers,
+                       const Http::HeaderMap*& response_headers,
+                       const RequestInfo::RequestInfo& request_info);
+};
+
+/**
+ * Access log Instance that appends requests to a file as length delimited HttpAccessLogEntry
+ * records, which log pipelines can read without parsing text.
+ */
+class BinaryFileAccessLog : public Instance {
+public:
+  BinaryFileAccessLog(const std::string& access_log_path, FilterPtr&& filter,
+                      AccessLogManager& log_manager);
+
+  // AccessLog::Instance
+  void log(const Http::HeaderMap* request_headers, const Http::HeaderMap* response_headers,
+           const RequestInfo::RequestInfo& request_info) override;
+
+private:
+  Filesystem::FileSharedPtr log_file_;
+  FilterPtr filter_;
+};
+
+/**
+ * Access log Instance that streams requests to an AccessLogService. Each worker batches its
+ * entries and sends them on its own stream once enough bytes are pending or the flush interval
+ * passes. Entries that cannot be sent because the service is unavailable are dropped.
+ */
+class GrpcAccessLog : public Instance {
+public:
+  typedef std::function<AccessLogServiceAsyncClientPtr()> AsyncClientFactory;
+
+  GrpcAccessLog(const envoy::accesslog::StructuredAccessLog& config, FilterPtr&& filter,
+                AsyncClientFactory async_client_factory, ThreadLocal::SlotAllocator& tls,
+                const LocalInfo::LocalInfo& local_info);
+
+  // AccessLog::Instance
+  void log(const Http::HeaderMap* request_headers, const Http::HeaderMap* response_headers,
+           const RequestInfo::RequestInfo& request_info) override;
+
+private:
+  // Settings shared with the per-worker loggers, which may outlive the access log.
+  struct SharedConfig {
+    envoy::accesslog::StreamAccessLogsMessage::Identifier identifier_;
+    uint64_t buffer_size_bytes_;
+    std::chrono::milliseconds buffer_flush_interval_;
+    AsyncClientFactory async_client_factory_;
+  };
+  typedef std::shared_ptr<const SharedConfig> SharedConfigConstSharedPtr;
+
+  class ThreadLocalLogger
+      : public ThreadLocal::ThreadLocalObject,
+        public Grpc::AsyncStreamCallbacks<envoy::accesslog::StreamAccessLogsResponse>,
+        Logger::Loggable<Logger::Id::misc> {
+  public:
+    ThreadLocalLogger(SharedConfigConstSharedPtr config, Event::Dispatcher& dispatcher);
+
+    void log(const Http::HeaderMap& request_headers, const Http::HeaderMap& response_headers,
+             const RequestInfo::RequestInfo& request_info);
+    void flush();
+
+    // Grpc::AsyncStreamCallbacks
+    void onCreateInitialMetadata(Http::HeaderMap&) override {}
+    void onReceiveInitialMetadata(Http::HeaderMapPtr&&) override {}
+    void onReceiveMessage(std::unique_ptr<envoy::accesslog::StreamAccessLogsResponse>&&) override {
+    }
+    void onReceiveTrailingMetadata(Http::HeaderMapPtr&&) override {}
+    void onRemoteClose(Grpc::Status::GrpcStatus status, const std::string& message) override;
+
+  private:
+    SharedConfigConstSharedPtr config_;
+    AccessLogServiceAsyncClientPtr client_;
+    Grpc::AsyncStream<envoy::accesslog::StreamAccessLogsMessage>* stream_{};
+    envoy::accesslog::StreamAccessLogsMessage message_;
+    uint64_t pending_bytes_{};
+    Event::TimerPtr flush_timer_;
+  };
+
+  FilterPtr filter_;
+  ThreadLocal::SlotPtr tls_slot_;
+};
+
+} // namespace AccessLog
+} // namespace Envoy
@@ -13,13 +13,15 @@ Event::DispatcherPtr Impl::allocateDispatcher() {
   return Event::DispatcherPtr{new Event::DispatcherImpl()};
 }
 
-Impl::Impl(std::chrono::milliseconds file_flush_interval_msec)
-    : file_flush_interval_msec_(file_flush_interval_msec) {}
+Impl::Impl(std::chrono::milliseconds file_flush_interval_msec, uint64_t file_write_buffer_bytes)
+    : file_flush_interval_msec_(file_flush_interval_msec),
+      file_write_buffer_bytes_(file_write_buffer_bytes) {}
 
 Filesystem::FileSharedPtr Impl::createFile(const std::string& path, Event::Dispatcher& dispatcher,
                                            Thread::BasicLockable& lock, Stats::Store& stats_store) {
-  return std::make_shared<Filesystem::FileImpl>(path, dispatcher, lock, stats_store,
-                                                file_flush_interval_msec_);
+  return std::make_shared<Filesystem::FileImpl>(path, dispatcher, lock, file_flush_executor_,
+                                                stats_store, file_flush_interval_msec_,
+                                                file_write_buffer_bytes_);
 }
 
 bool Impl::fileExists(const std::string& path) { return Filesystem::fileExists(path); }
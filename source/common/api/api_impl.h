@@ -1,11 +1,14 @@
 #pragma once
 
 #include <chrono>
+#include <cstdint>
 #include <string>
 
 #include "envoy/api/api.h"
 #include "envoy/filesystem/filesystem.h"
 
+#include "common/filesystem/filesystem_impl.h"
+
 namespace Envoy {
 namespace Api {
 
@@ -14,7 +17,7 @@ namespace Api {
  */
 class Impl : public Api::Api {
 public:
-  Impl(std::chrono::milliseconds file_flush_interval_msec);
+  Impl(std::chrono::milliseconds file_flush_interval_msec, uint64_t file_write_buffer_bytes);
 
   // Api::Api
   Event::DispatcherPtr allocateDispatcher() override;
@@ -26,6 +29,9 @@ public:
 
 private:
   std::chrono::milliseconds file_flush_interval_msec_;
+  uint64_t file_write_buffer_bytes_;
+  // Flushes every file created by this Api, which must destroy its files before the Api.
+  Filesystem::FlushExecutor file_flush_executor_;
 };
 
 } // namespace Api
@@ -1,7 +1,12 @@
 #include "common/buffer/buffer_impl.h"
 
+#include <sys/uio.h>
+
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <string>
+#include <vector>
 
 #include "common/common/assert.h"
 
@@ -19,13 +24,15 @@ static_assert(offsetof(RawSlice, mem_) == offsetof(evbuffer_iovec, iov_base),
 static_assert(offsetof(RawSlice, len_) == offsetof(evbuffer_iovec, iov_len),
               "RawSlice != evbuffer_iovec");
 
-void OwnedImpl::add(const void* data, uint64_t size) { evbuffer_add(buffer_.get(), data, size); }
+void LibEventOwnedImpl::add(const void* data, uint64_t size) {
+  evbuffer_add(buffer_.get(), data, size);
+}
 
-void OwnedImpl::add(const std::string& data) {
+void LibEventOwnedImpl::add(const std::string& data) {
   evbuffer_add(buffer_.get(), data.c_str(), data.size());
 }
 
-void OwnedImpl::add(const Instance& data) {
+void LibEventOwnedImpl::add(const Instance& data) {
   uint64_t num_slices = data.getRawSlices(nullptr, 0);
   RawSlice slices[num_slices];
   data.getRawSlices(slices, num_slices);
@@ -34,14 +41,41 @@ void OwnedImpl::add(const Instance& data) {
   }
 }
 
-void OwnedImpl::commit(RawSlice* iovecs, uint64_t num_iovecs) {
+void LibEventOwnedImpl::addBufferReference(const Instance& data) {
+  // See move() for why we do the static cast. Taking a reference leaves the data of the other
+  // evbuffer alone and only pins its chains, which libevent does through a non-const pointer.
+  evbuffer* other = const_cast<LibEventInstance&>(static_cast<const LibEventInstance&>(data))
+                        .buffer()
+                        .get();
+  if (evbuffer_add_buffer_reference(buffer_.get(), other) != 0) {
+    // libevent refuses to reference a buffer which itself holds references.
+    add(data);
+  }
+}
+
+void LibEventOwnedImpl::commit(RawSlice* iovecs, uint64_t num_iovecs) {
   int rc =
       evbuffer_commit_space(buffer_.get(), reinterpret_cast<evbuffer_iovec*>(iovecs), num_iovecs);
   ASSERT(rc == 0);
   UNREFERENCED_PARAMETER(rc);
 }
 
-void OwnedImpl::copyOut(size_t start, uint64_t size, void* data) const {
+void LibEventOwnedImpl::compact() {
+  const uint64_t size = length();
+  if (size == 0 || size > CompactThreshold) {
+    return;
+  }
+
+  // Draining frees every chain that held the data, and adding it back copies it into a single chain
+  // sized for it. The evbuffer is used directly so that subclasses see no change in length.
+  uint8_t data[CompactThreshold];
+  int rc = evbuffer_remove(buffer_.get(), data, size);
+  ASSERT(static_cast<uint64_t>(rc) == size);
+  UNREFERENCED_PARAMETER(rc);
+  evbuffer_add(buffer_.get(), data, size);
+}
+
+void LibEventOwnedImpl::copyOut(size_t start, uint64_t size, void* data) const {
   ASSERT(start + size <= length());
 
   evbuffer_ptr start_ptr;
@@ -54,26 +88,26 @@ void OwnedImpl::copyOut(size_t start, uint64_t size, void* data) const {
   UNREFERENCED_PARAMETER(copied);
 }
 
-void OwnedImpl::drain(uint64_t size) {
+void LibEventOwnedImpl::drain(uint64_t size) {
   ASSERT(size <= length());
   int rc = evbuffer_drain(buffer_.get(), size);
   ASSERT(rc == 0);
   UNREFERENCED_PARAMETER(rc);
 }
 
-uint64_t OwnedImpl::getRawSlices(RawSlice* out, uint64_t out_size) const {
+uint64_t LibEventOwnedImpl::getRawSlices(RawSlice* out, uint64_t out_size) const {
   return evbuffer_peek(buffer_.get(), -1, nullptr, reinterpret_cast<evbuffer_iovec*>(out),
                        out_size);
 }
 
-uint64_t OwnedImpl::length() const { return evbuffer_get_length(buffer_.get()); }
+uint64_t LibEventOwnedImpl::length() const { return evbuffer_get_length(buffer_.get()); }
 
-void* OwnedImpl::linearize(uint32_t size) {
+void* LibEventOwnedImpl::linearize(uint32_t size) {
   ASSERT(size <= length());
   return evbuffer_pullup(buffer_.get(), size);
 }
 
-void OwnedImpl::move(Instance& rhs) {
+void LibEventOwnedImpl::move(Instance& rhs) {
   // We do the static cast here because in practice we only have one buffer implementation right
   // now and this is safe. Using the evbuffer move routines require having access to both evbuffers.
   // This is a reasonable compromise in a high performance path where we want to maintain an
@@ -84,7 +118,7 @@ void OwnedImpl::move(Instance& rhs) {
   static_cast<LibEventInstance&>(rhs).postProcess();
 }
 
-void OwnedImpl::move(Instance& rhs, uint64_t length) {
+void LibEventOwnedImpl::move(Instance& rhs, uint64_t length) {
   // See move() above for why we do the static cast.
   int rc = evbuffer_remove_buffer(static_cast<LibEventInstance&>(rhs).buffer().get(), buffer_.get(),
                                   length);
@@ -93,18 +127,48 @@ void OwnedImpl::move(Instance& rhs, uint64_t length) {
   static_cast<LibEventInstance&>(rhs).postProcess();
 }
 
-int OwnedImpl::read(int fd, uint64_t max_length) {
-  return evbuffer_read(buffer_.get(), fd, max_length);
+int LibEventOwnedImpl::read(int fd, uint64_t max_length) {
+  if (max_length == 0) {
+    return 0;
+  }
+
+  // evbuffer_read() issues an ioctl() before every read to find out how much data is available,
+  // and then reads at most 4K. Reading into reserved space avoids both.
+  RawSlice slices[2];
+  const uint64_t num_slices = reserve(max_length, slices, 2);
+  iovec iov[2];
+  uint64_t remaining = max_length;
+  for (uint64_t i = 0; i < num_slices; i++) {
+    iov[i].iov_base = slices[i].mem_;
+    iov[i].iov_len = std::min(slices[i].len_, remaining);
+    remaining -= iov[i].iov_len;
+  }
+
+  const ssize_t rc = ::readv(fd, iov, num_slices);
+  if (rc <= 0) {
+    commit(slices, 0);
+    return rc;
+  }
+
+  uint64_t to_commit = rc;
+  uint64_t num_to_commit = 0;
+  while (to_commit > 0) {
+    slices[num_to_commit].len_ = std::min<uint64_t>(iov[num_to_commit].iov_len, to_commit);
+    to_commit -= slices[num_to_commit].len_;
+    num_to_commit++;
+  }
+  commit(slices, num_to_commit);
+  return rc;
 }
 
-uint64_t OwnedImpl::reserve(uint64_t length, RawSlice* iovecs, uint64_t num_iovecs) {
+uint64_t LibEventOwnedImpl::reserve(uint64_t length, RawSlice* iovecs, uint64_t num_iovecs) {
   uint64_t ret = evbuffer_reserve_space(buffer_.get(), length,
                                         reinterpret_cast<evbuffer_iovec*>(iovecs), num_iovecs);
   ASSERT(ret >= 1);
   return ret;
 }
 
-ssize_t OwnedImpl::search(const void* data, uint64_t size, size_t start) const {
+ssize_t LibEventOwnedImpl::search(const void* data, uint64_t size, size_t start) const {
   evbuffer_ptr start_ptr;
   if (-1 == evbuffer_ptr_set(buffer_.get(), &start_ptr, start, EVBUFFER_PTR_SET)) {
     return -1;
@@ -115,15 +179,496 @@ ssize_t OwnedImpl::search(const void* data, uint64_t size, size_t start) const {
   return result_ptr.pos;
 }
 
-int OwnedImpl::write(int fd) { return evbuffer_write(buffer_.get(), fd); }
+int LibEventOwnedImpl::write(int fd) { return evbuffer_write(buffer_.get(), fd); }
+
+LibEventOwnedImpl::LibEventOwnedImpl() : buffer_(evbuffer_new()) {}
+
+LibEventOwnedImpl::LibEventOwnedImpl(const std::string& data) : LibEventOwnedImpl() { add(data); }
+
+LibEventOwnedImpl::LibEventOwnedImpl(const Instance& data) : LibEventOwnedImpl() { add(data); }
+
+LibEventOwnedImpl::LibEventOwnedImpl(const void* data, uint64_t size) : LibEventOwnedImpl() {
+  add(data, size);
+}
+
+const uint64_t Slice::DefaultSize;
+const uint64_t SliceOwnedImpl::MoveCopyThreshold;
+const uint64_t SliceOwnedImpl::MaxIoSlices;
+const uint64_t SliceOwnedImpl::MaxWriteSlices;
+
+const uint64_t SlicePool::DefaultLowWatermark;
+const uint64_t SlicePool::DefaultHighWatermark;
+
+namespace {
+
+// The pool installed for the thread via SlicePool::setCurrent(), if any.
+thread_local SlicePool* current_slice_pool = nullptr;
+
+} // namespace
+
+void SliceDeleter::operator()(Slice* slice) const {
+  if (slice->capacity() == Slice::DefaultSize) {
+    SlicePool::current().release(slice);
+  } else {
+    delete slice;
+  }
+}
+
+SlicePtr Slice::create(uint64_t min_capacity) {
+  if (min_capacity <= DefaultSize) {
+    return SlicePool::current().allocate();
+  }
+
+  return SlicePtr{new Slice(min_capacity)};
+}
+
+SlicePool::SlicePool(uint64_t low_watermark, uint64_t high_watermark)
+    : low_watermark_(low_watermark), high_watermark_(high_watermark) {
+  ASSERT(low_watermark_ <= high_watermark_);
+}
+
+SlicePool::~SlicePool() {
+  for (Slice* slice : slices_) {
+    delete slice;
+  }
+}
+
+void SlicePool::initializeStats(Stats::Scope& scope, const std::string& prefix) {
+  const std::string final_prefix = prefix + "slice_pool.";
+  stats_.reset(
+      new SlicePoolStats{ALL_SLICE_POOL_STATS(POOL_COUNTER_PREFIX(scope, final_prefix),
+                                              POOL_GAUGE_PREFIX(scope, final_prefix))});
+  updatePooledGauge();
+}
+
+SlicePtr SlicePool::allocate() {
+  if (slices_.empty()) {
+    if (stats_) {
+      stats_->allocated_.inc();
+    }
+    return SlicePtr{new Slice(Slice::DefaultSize)};
+  }
+
+  Slice* slice = slices_.back();
+  slices_.pop_back();
+  if (stats_) {
+    stats_->reused_.inc();
+    updatePooledGauge();
+  }
+  return SlicePtr{slice};
+}
+
+void SlicePool::release(Slice* slice) {
+  ASSERT(slice->capacity() == Slice::DefaultSize);
+  slice->reset();
+  slices_.push_back(slice);
+
+  if (slices_.size() > high_watermark_) {
+    // Trim in one batch so that a pool hovering around the high watermark does not free and
+    // allocate a slice on every release/allocate pair.
+    const uint64_t num_freed = slices_.size() - low_watermark_;
+    for (uint64_t i = low_watermark_; i < slices_.size(); i++) {
+      delete slices_[i];
+    }
+    slices_.resize(low_watermark_);
+    if (stats_) {
+      stats_->freed_.add(num_freed);
+    }
+  }
+
+  updatePooledGauge();
+}
+
+SlicePool& SlicePool::current() {
+  if (current_slice_pool != nullptr) {
+    return *current_slice_pool;
+  }
+
+  // Per-thread default pool used when no dispatcher pool is installed. Buffers are only accessed
+  // from the thread which owns them, so no synchronization is needed.
+  static thread_local SlicePool default_pool;
+  return default_pool;
+}
+
+SlicePool* SlicePool::setCurrent(SlicePool* pool) {
+  SlicePool* previous = current_slice_pool;
+  current_slice_pool = pool;
+  return previous;
+}
+
+uint64_t Slice::append(const void* data, uint64_t size) {
+  const uint64_t copy_size = std::min(size, reservableSize());
+  memcpy(reservableStart(), data, copy_size);
+  reservable_ += copy_size;
+  return copy_size;
+}
+
+void SliceOwnedImpl::add(const void* data, uint64_t size) {
+  const uint8_t* src = static_cast<const uint8_t*>(data);
+  length_ += size;
+  while (size > 0) {
+    if (slices_.empty() || slices_.back()->reservableSize() == 0) {
+      slices_.emplace_back(Slice::create());
+    }
+
+    const uint64_t copied = slices_.back()->append(src, size);
+    src += copied;
+    size -= copied;
+  }
+}
+
+void SliceOwnedImpl::add(const std::string& data) { add(data.c_str(), data.size()); }
+
+void SliceOwnedImpl::add(const Instance& data) {
+  uint64_t num_slices = data.getRawSlices(nullptr, 0);
+  RawSlice slices[num_slices];
+  data.getRawSlices(slices, num_slices);
+  for (RawSlice& slice : slices) {
+    add(slice.mem_, slice.len_);
+  }
+}
+
+void SliceOwnedImpl::commit(RawSlice* iovecs, uint64_t num_iovecs) {
+  if (num_iovecs == 0) {
+    trimEmptyTail();
+    return;
+  }
+
+  // Reserved space always lives in the last slices of the deque. Find the slice which holds the
+  // first iovec and commit the rest of the iovecs into the slices that follow it.
+  uint64_t first = slices_.size();
+  while (first > 0 && slices_[first - 1]->reservableStart() != iovecs[0].mem_) {
+    first--;
+  }
+  ASSERT(first > 0);
+  first--;
+  ASSERT(first + num_iovecs <= slices_.size());
+
+  for (uint64_t i = 0; i < num_iovecs; i++) {
+    Slice& slice = *slices_[first + i];
+    ASSERT(slice.reservableStart() == iovecs[i].mem_);
+    ASSERT(iovecs[i].len_ <= slice.reservableSize());
+    slice.commit(iovecs[i].len_);
+    length_ += iovecs[i].len_;
+  }
+
+  // Remove any reserved slices that ended up without data so that only the tail of the deque can
+  // contain empty slices.
+  for (uint64_t i = first; i < slices_.size();) {
+    if (slices_[i]->dataSize() == 0) {
+      slices_.erase(slices_.begin() + i);
+    } else {
+      i++;
+    }
+  }
+}
+
+void SliceOwnedImpl::compact() {
+  trimEmptyTail();
+  if (length_ == 0 || length_ > CompactThreshold ||
+      (slices_.size() == 1 && slices_.front()->capacity() == length_)) {
+    return;
+  }
+
+  // Copy the data into a slice that is exactly its size, which returns the slices it was spread
+  // over to the pool.
+  SlicePtr compacted = Slice::createExact(length_);
+  for (const SlicePtr& slice : slices_) {
+    compacted->append(slice->data(), slice->dataSize());
+  }
+  slices_.clear();
+  slices_.shrink_to_fit();
+  slices_.emplace_back(std::move(compacted));
+}
+
+void SliceOwnedImpl::copyOut(size_t start, uint64_t size, void* data) const {
+  ASSERT(start + size <= length());
+
+  uint8_t* dest = static_cast<uint8_t*>(data);
+  for (const SlicePtr& slice : slices_) {
+    if (size == 0) {
+      break;
+    }
+
+    const uint64_t slice_size = slice->dataSize();
+    if (start >= slice_size) {
+      start -= slice_size;
+      continue;
+    }
+
+    const uint64_t copy_size = std::min(size, slice_size - start);
+    memcpy(dest, slice->data() + start, copy_size);
+    dest += copy_size;
+    size -= copy_size;
+    start = 0;
+  }
+}
+
+void SliceOwnedImpl::drain(uint64_t size) {
+  ASSERT(size <= length_);
+  length_ -= size;
+  while (size > 0) {
+    Slice& slice = *slices_.front();
+    const uint64_t drain_size = std::min(size, slice.dataSize());
+    slice.drain(drain_size);
+    size -= drain_size;
+    if (slice.dataSize() == 0) {
+      slices_.pop_front();
+    }
+  }
+}
+
+uint64_t SliceOwnedImpl::getRawSlices(RawSlice* out, uint64_t out_size) const {
+  uint64_t num_slices = 0;
+  for (const SlicePtr& slice : slices_) {
+    if (slice->dataSize() == 0) {
+      continue;
+    }
+
+    if (num_slices < out_size) {
+      out[num_slices].mem_ = const_cast<uint8_t*>(slice->data());
+      out[num_slices].len_ = slice->dataSize();
+    }
+    num_slices++;
+  }
+
+  return num_slices;
+}
+
+void* SliceOwnedImpl::linearize(uint32_t size) {
+  ASSERT(size <= length_);
+  if (slices_.empty()) {
+    return nullptr;
+  }
+
+  if (slices_.front()->dataSize() >= size) {
+    return slices_.front()->data();
+  }
+
+  SlicePtr slice = Slice::create(size);
+  copyOut(0, size, slice->reservableStart());
+  slice->commit(size);
+  drain(size);
+  length_ += size;
+  slices_.emplace_front(std::move(slice));
+  return slices_.front()->data();
+}
+
+void SliceOwnedImpl::appendSliceData(Slice& slice, uint64_t size) {
+  ASSERT(size <= slice.dataSize());
+  add(slice.data(), size);
+  slice.drain(size);
+}
+
+void SliceOwnedImpl::move(Instance& rhs) {
+  // We do the static cast here because only one owned buffer implementation is in use for a
+  // given build. See the similar comment in LibEventOwnedImpl::move().
+  SliceOwnedImpl& other = static_cast<SliceOwnedImpl&>(rhs);
+  move(other, other.length());
+}
+
+void SliceOwnedImpl::move(Instance& rhs, uint64_t length) {
+  // See move() above for why we do the static cast.
+  SliceOwnedImpl& other = static_cast<SliceOwnedImpl&>(rhs);
+  ASSERT(length <= other.length_);
+  trimEmptyTail();
+
+  other.length_ -= length;
+  while (length > 0) {
+    SlicePtr& slice = other.slices_.front();
+    const uint64_t slice_size = slice->dataSize();
+    if (slice_size > length) {
+      // Only part of this slice is being moved so the data must be copied.
+      appendSliceData(*slice, length);
+      break;
+    }
+
+    if (slice_size <= MoveCopyThreshold && !slices_.empty() &&
+        slices_.back()->reservableSize() >= slice_size) {
+      appendSliceData(*slice, slice_size);
+    } else {
+      length_ += slice_size;
+      slices_.emplace_back(std::move(slice));
+    }
+    other.slices_.pop_front();
+    length -= slice_size;
+  }
+
+  other.postProcess();
+}
+
+int SliceOwnedImpl::read(int fd, uint64_t max_length) {
+  if (max_length == 0) {
+    return 0;
+  }
+
+  // Read into the remaining space of the last slice and as many pooled slices as it takes to hold
+  // max_length, so that a large read neither allocates an outsized slice nor is split into many
+  // small readv() operations.
+  RawSlice slices[MaxIoSlices];
+  const uint64_t num_slices =
+      reserve(max_length, slices, std::min(MaxIoSlices, max_length / Slice::DefaultSize + 2));
+  iovec iov[MaxIoSlices];
+  uint64_t remaining = max_length;
+  for (uint64_t i = 0; i < num_slices; i++) {
+    iov[i].iov_base = slices[i].mem_;
+    iov[i].iov_len = std::min(slices[i].len_, remaining);
+    remaining -= iov[i].iov_len;
+  }
+
+  const ssize_t rc = ::readv(fd, iov, num_slices);
+  if (rc <= 0) {
+    trimEmptyTail();
+    return rc;
+  }
+
+  uint64_t to_commit = rc;
+  for (uint64_t i = 0; i < num_slices; i++) {
+    slices[i].len_ = std::min<uint64_t>(iov[i].iov_len, to_commit);
+    to_commit -= slices[i].len_;
+  }
+  commit(slices, num_slices);
+  return rc;
+}
+
+uint64_t SliceOwnedImpl::reserve(uint64_t length, RawSlice* iovecs, uint64_t num_iovecs) {
+  ASSERT(num_iovecs > 0);
+  // Any previous reservation which was not committed is abandoned.
+  trimEmptyTail();
+
+  uint64_t reserved = 0;
+  uint64_t num_used = 0;
+  // Hand out the remaining space of the last slice first, unless the caller needs a single
+  // contiguous region which that space cannot satisfy.
+  if (!slices_.empty() && slices_.back()->reservableSize() > 0 &&
+      (num_iovecs > 1 || slices_.back()->reservableSize() >= length)) {
+    Slice& slice = *slices_.back();
+    iovecs[0].mem_ = slice.reservableStart();
+    iovecs[0].len_ = slice.reservableSize();
+    reserved += iovecs[0].len_;
+    num_used++;
+  }
+
+  while (reserved < length && num_used < num_iovecs) {
+    // The last available iovec must be able to hold the remainder of the reservation.
+    const uint64_t remaining = length - reserved;
+    slices_.emplace_back(
+        Slice::create(num_used == num_iovecs - 1 ? remaining : Slice::DefaultSize));
+    Slice& slice = *slices_.back();
+    iovecs[num_used].mem_ = slice.reservableStart();
+    iovecs[num_used].len_ = slice.reservableSize();
+    reserved += iovecs[num_used].len_;
+    num_used++;
+  }
+
+  ASSERT(num_used >= 1);
+  return num_used;
+}
+
+ssize_t SliceOwnedImpl::search(const void* data, uint64_t size, size_t start) const {
+  if (start + size > length_) {
+    return -1;
+  }
+
+  const uint8_t* needle = static_cast<const uint8_t*>(data);
+  if (size == 0) {
+    return start;
+  }
+
+  uint64_t offset = 0;
+  for (uint64_t slice_index = 0; slice_index < slices_.size(); slice_index++) {
+    const Slice& slice = *slices_[slice_index];
+    const uint8_t* slice_data = slice.data();
+    const uint64_t slice_size = slice.dataSize();
+    if (offset + slice_size <= start) {
+      offset += slice_size;
+      continue;
+    }
+
+    uint64_t i = start > offset ? start - offset : 0;
+    while (i < slice_size) {
+      const void* first_byte = memchr(slice_data + i, needle[0], slice_size - i);
+      if (first_byte == nullptr) {
+        break;
+      }
+      i = static_cast<const uint8_t*>(first_byte) - slice_data;
+      if (offset + i + size > length_) {
+        return -1;
+      }
+
+      // Compare the rest of the needle, which may continue into the following slices.
+      uint64_t matched = 0;
+      uint64_t match_slice = slice_index;
+      uint64_t match_offset = i;
+      while (matched < size) {
+        const Slice& current = *slices_[match_slice];
+        if (match_offset == current.dataSize()) {
+          match_slice++;
+          match_offset = 0;
+          continue;
+        }
+
+        const uint64_t compare_size = std::min(size - matched, current.dataSize() - match_offset);
+        if (memcmp(current.data() + match_offset, needle + matched, compare_size) != 0) {
+          break;
+        }
+        matched += compare_size;
+        match_offset += compare_size;
+      }
+
+      if (matched == size) {
+        return offset + i;
+      }
+      i++;
+    }
+
+    offset += slice_size;
+  }
+
+  return -1;
+}
+
+int SliceOwnedImpl::write(int fd) {
+  iovec iov[MaxWriteSlices];
+  uint64_t num_iov = 0;
+  for (const SlicePtr& slice : slices_) {
+    if (num_iov == MaxWriteSlices) {
+      break;
+    }
+
+    if (slice->dataSize() > 0) {
+      iov[num_iov].iov_base = slice->data();
+      iov[num_iov].iov_len = slice->dataSize();
+      num_iov++;
+    }
+  }
+
+  if (num_iov == 0) {
+    return 0;
+  }
+
+  const ssize_t rc = ::writev(fd, iov, num_iov);
+  if (rc > 0) {
+    drain(rc);
+  }
+  return rc;
+}
+
+void SliceOwnedImpl::trimEmptyTail() {
+  while (!slices_.empty() && slices_.back()->dataSize() == 0) {
+    slices_.pop_back();
+  }
+}
 
-OwnedImpl::OwnedImpl() : buffer_(evbuffer_new()) {}
+SliceOwnedImpl::SliceOwnedImpl() {}
 
-OwnedImpl::OwnedImpl(const std::string& data) : OwnedImpl() { add(data); }
+SliceOwnedImpl::SliceOwnedImpl(const std::string& data) : SliceOwnedImpl() { add(data); }
 
-OwnedImpl::OwnedImpl(const Instance& data) : OwnedImpl() { add(data); }
+SliceOwnedImpl::SliceOwnedImpl(const Instance& data) : SliceOwnedImpl() { add(data); }
 
-OwnedImpl::OwnedImpl(const void* data, uint64_t size) : OwnedImpl() { add(data, size); }
+SliceOwnedImpl::SliceOwnedImpl(const void* data, uint64_t size) : SliceOwnedImpl() {
+  add(data, size);
+}
 
 } // namespace Buffer
 } // namespace Envoy
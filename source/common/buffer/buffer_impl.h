@@ -1,11 +1,17 @@
 #pragma once
 
 #include <cstdint>
+#include <deque>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "envoy/buffer/buffer.h"
+#include "envoy/stats/stats.h"
+#include "envoy/stats/stats_macros.h"
 
 #include "common/event/libevent.h"
+#include "common/memory/accounting.h"
 
 namespace Envoy {
 namespace Buffer {
@@ -21,21 +27,23 @@ public:
 /**
  * Wraps an allocated and owned evbuffer.
  *
- * Note that due to the internals of move() accessing buffer(), OwnedImpl is not
+ * Note that due to the internals of move() accessing buffer(), LibEventOwnedImpl is not
  * compatible with non-LibEventInstance buffers.
  */
-class OwnedImpl : public LibEventInstance {
+class LibEventOwnedImpl : public LibEventInstance {
 public:
-  OwnedImpl();
-  OwnedImpl(const std::string& data);
-  OwnedImpl(const Instance& data);
-  OwnedImpl(const void* data, uint64_t size);
+  LibEventOwnedImpl();
+  LibEventOwnedImpl(const std::string& data);
+  LibEventOwnedImpl(const Instance& data);
+  LibEventOwnedImpl(const void* data, uint64_t size);
 
   // LibEventInstance
   void add(const void* data, uint64_t size) override;
   void add(const std::string& data) override;
   void add(const Instance& data) override;
+  void addBufferReference(const Instance& data) override;
   void commit(RawSlice* iovecs, uint64_t num_iovecs) override;
+  void compact() override;
   void copyOut(size_t start, uint64_t size, void* data) const override;
   void drain(uint64_t size) override;
   uint64_t getRawSlices(RawSlice* out, uint64_t out_size) const override;
@@ -51,9 +59,248 @@ public:
 
   Event::Libevent::BufferPtr& buffer() override { return buffer_; }
 
+  // Buffers holding more data than this are left as they are by compact().
+  static const uint64_t CompactThreshold = 4096;
+
 private:
   Event::Libevent::BufferPtr buffer_;
 };
 
+class Slice;
+
+/**
+ * Returns slices of the default size to the calling thread's SlicePool instead of freeing them.
+ */
+struct SliceDeleter {
+  void operator()(Slice* slice) const;
+};
+
+typedef std::unique_ptr<Slice, SliceDeleter> SlicePtr;
+
+/**
+ * A contiguous, fixed capacity region of memory which is the unit of storage of
+ * SliceOwnedImpl. The region is split into three parts:
+ *   [0, data_)                 drained space which is not reused until the slice is recycled.
+ *   [data_, reservable_)       readable data.
+ *   [reservable_, capacity_)   space which may be appended to or handed out by reserve().
+ */
+class Slice {
+public:
+  // Capacity of the slices that are pooled. Larger slices are only allocated when a caller asks
+  // for a contiguous region bigger than this and are freed rather than pooled.
+  static const uint64_t DefaultSize = 16384;
+
+  /**
+   * @param min_capacity supplies the minimum capacity of the new slice.
+   * @return SlicePtr an empty slice, recycled from the calling thread's SlicePool when possible.
+   */
+  static SlicePtr create(uint64_t min_capacity = DefaultSize);
+
+  /**
+   * @param capacity supplies the capacity of the new slice.
+   * @return SlicePtr an empty slice of exactly the given capacity, which is not taken from a pool.
+   */
+  static SlicePtr createExact(uint64_t capacity) { return SlicePtr{new Slice(capacity)}; }
+
+  uint8_t* data() { return base_.get() + data_; }
+  const uint8_t* data() const { return base_.get() + data_; }
+  uint64_t dataSize() const { return reservable_ - data_; }
+  uint8_t* reservableStart() { return base_.get() + reservable_; }
+  uint64_t reservableSize() const { return capacity_ - reservable_; }
+  uint64_t capacity() const { return capacity_; }
+
+  /**
+   * Remove data from the front of the slice.
+   * @param size supplies the amount of data to remove, which must be <= dataSize().
+   */
+  void drain(uint64_t size) { data_ += size; }
+
+  /**
+   * Mark space previously obtained via reservableStart() as readable data.
+   * @param size supplies the amount of space to commit, which must be <= reservableSize().
+   */
+  void commit(uint64_t size) { reservable_ += size; }
+
+  /**
+   * Copy as much of the supplied data as fits into the reservable space of the slice.
+   * @param data supplies the data to copy.
+   * @param size supplies the size of the data.
+   * @return uint64_t the number of bytes copied.
+   */
+  uint64_t append(const void* data, uint64_t size);
+
+private:
+  Slice(uint64_t capacity)
+      : capacity_(capacity), base_(new uint8_t[capacity]),
+        accounted_(Memory::Category::Buffers, capacity) {}
+
+  void reset() { data_ = reservable_ = 0; }
+
+  const uint64_t capacity_;
+  std::unique_ptr<uint8_t[]> base_;
+  uint64_t data_{0};
+  uint64_t reservable_{0};
+  Memory::AccountedBytes accounted_;
+
+  friend class SlicePool;
+};
+
+/**
+ * All stats for a slice pool. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_SLICE_POOL_STATS(COUNTER, GAUGE)                                                       \
+  COUNTER(allocated)                                                                               \
+  COUNTER(reused)                                                                                  \
+  COUNTER(freed)                                                                                   \
+  GAUGE  (pooled)
+// clang-format on
+
+/**
+ * Struct definition for all slice pool stats. @see stats_macros.h
+ */
+struct SlicePoolStats {
+  ALL_SLICE_POOL_STATS(GENERATE_COUNTER_STRUCT, GENERATE_GAUGE_STRUCT)
+};
+
+/**
+ * Free list of DefaultSize slices shared by all of the buffers used on a thread, so that memory
+ * released by one connection is reused by the next one instead of going back to malloc. Once more
+ * than high_watermark slices are pooled the pool is trimmed back down to low_watermark slices.
+ *
+ * Each thread has a default pool. A dispatcher installs its own pool as the current pool of the
+ * thread while its event loop runs, which makes that pool shared by every connection on a worker.
+ */
+class SlicePool {
+public:
+  static const uint64_t DefaultLowWatermark = 64;
+  static const uint64_t DefaultHighWatermark = 128;
+
+  SlicePool(uint64_t low_watermark = DefaultLowWatermark,
+            uint64_t high_watermark = DefaultHighWatermark);
+  ~SlicePool();
+
+  /**
+   * Start exporting stats for the pool.
+   * @param scope supplies the scope to create the stats in.
+   * @param prefix supplies the stat prefix, e.g. "server.worker_0.".
+   */
+  void initializeStats(Stats::Scope& scope, const std::string& prefix);
+
+  /**
+   * @return SlicePtr an empty DefaultSize slice, reused from the pool when possible.
+   */
+  SlicePtr allocate();
+
+  /**
+   * Take ownership of a DefaultSize slice which is no longer in use.
+   */
+  void release(Slice* slice);
+
+  /**
+   * @return uint64_t the number of slices currently pooled.
+   */
+  uint64_t size() const { return slices_.size(); }
+
+  /**
+   * @return SlicePool& the pool in use for the calling thread.
+   */
+  static SlicePool& current();
+
+  /**
+   * Install a pool as the current pool of the calling thread.
+   * @param pool supplies the pool to install, or nullptr to revert to the thread's default pool.
+   * @return SlicePool* the previously installed pool, or nullptr if the default pool was in use.
+   */
+  static SlicePool* setCurrent(SlicePool* pool);
+
+private:
+  void updatePooledGauge() {
+    if (stats_) {
+      stats_->pooled_.set(slices_.size());
+    }
+  }
+
+  const uint64_t low_watermark_;
+  const uint64_t high_watermark_;
+  std::vector<Slice*> slices_;
+  std::unique_ptr<SlicePoolStats> stats_;
+};
+
+/**
+ * Buffer implementation backed by a deque of Envoy owned slices. move() between two
+ * SliceOwnedImpl buffers transfers whole slices without copying data.
+ *
+ * Note that due to the internals of move() accessing the slices of the source buffer,
+ * SliceOwnedImpl is not compatible with buffers of other implementations.
+ */
+class SliceOwnedImpl : public Instance {
+public:
+  SliceOwnedImpl();
+  SliceOwnedImpl(const std::string& data);
+  SliceOwnedImpl(const Instance& data);
+  SliceOwnedImpl(const void* data, uint64_t size);
+
+  // Buffer::Instance
+  void add(const void* data, uint64_t size) override;
+  void add(const std::string& data) override;
+  void add(const Instance& data) override;
+  // Slices are owned by a single buffer, so this copies the data.
+  void addBufferReference(const Instance& data) override { add(data); }
+  void commit(RawSlice* iovecs, uint64_t num_iovecs) override;
+  void compact() override;
+  void copyOut(size_t start, uint64_t size, void* data) const override;
+  void drain(uint64_t size) override;
+  uint64_t getRawSlices(RawSlice* out, uint64_t out_size) const override;
+  uint64_t length() const override { return length_; }
+  void* linearize(uint32_t size) override;
+  void move(Instance& rhs) override;
+  void move(Instance& rhs, uint64_t length) override;
+  int read(int fd, uint64_t max_length) override;
+  uint64_t reserve(uint64_t length, RawSlice* iovecs, uint64_t num_iovecs) override;
+  ssize_t search(const void* data, uint64_t size, size_t start) const override;
+  int write(int fd) override;
+
+  // Called after the slices of this buffer have been taken by move() to allow any
+  // post-processing.
+  virtual void postProcess() {}
+
+  // Slices whose data is no larger than this are copied into the reservable space of the
+  // destination by move() rather than transferred, so that moving many small writes does not
+  // produce a long chain of mostly empty slices.
+  static const uint64_t MoveCopyThreshold = 512;
+
+  // Maximum number of slices passed to a single readv() call.
+  static const uint64_t MaxIoSlices = 16;
+
+  // Maximum number of slices passed to a single writev() call. This is the same as libevent's, so
+  // that both buffer implementations flush many small slices, e.g. the frames of multiplexed
+  // streams, with as few system calls.
+  static const uint64_t MaxWriteSlices = 128;
+
+  // Buffers holding more data than this are left as they are by compact().
+  static const uint64_t CompactThreshold = 4096;
+
+private:
+  // Drop any empty slices at the end of the deque. These are left behind by reservations which
+  // were not (fully) committed.
+  void trimEmptyTail();
+  // Copy a single slice worth of data to the end of the buffer.
+  void appendSliceData(Slice& slice, uint64_t size);
+
+  std::deque<SlicePtr> slices_;
+  uint64_t length_{0};
+};
+
+/**
+ * The owned buffer implementation in use for this build. The evbuffer backed implementation is the
+ * default and the native slice implementation is selected via --define=buffer=native.
+ */
+#ifdef ENVOY_NATIVE_BUFFER
+typedef SliceOwnedImpl OwnedImpl;
+#else
+typedef LibEventOwnedImpl OwnedImpl;
+#endif
+
 } // namespace Buffer
 } // namespace Envoy
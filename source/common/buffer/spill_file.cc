@@ -0,0 +1,64 @@
+#include "common/buffer/spill_file.h"
+
+#include <unistd.h>
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "common/common/assert.h"
+
+namespace Envoy {
+namespace Buffer {
+
+SpillFile::~SpillFile() { ::close(fd_); }
+
+SpillFilePtr SpillFile::create(const std::string& directory) {
+  const std::string path_template = directory + "/envoy_spill_XXXXXX";
+  std::vector<char> path(path_template.begin(), path_template.end());
+  path.push_back('\0');
+  const int fd = ::mkstemp(path.data());
+  if (fd == -1) {
+    return nullptr;
+  }
+
+  ::unlink(path.data());
+  return SpillFilePtr{new SpillFile(fd)};
+}
+
+bool SpillFile::write(Instance& data) {
+  ASSERT(!reading_);
+  while (data.length() > 0) {
+    // Writing drains the buffer.
+    const int rc = data.write(fd_);
+    if (rc <= 0) {
+      return false;
+    }
+    written_ += rc;
+  }
+  return true;
+}
+
+bool SpillFile::read(Instance& data, uint64_t max_length) {
+  if (!reading_) {
+    if (::lseek(fd_, 0, SEEK_SET) != 0) {
+      return false;
+    }
+    reading_ = true;
+  }
+
+  const uint64_t length = max_length < unreadLength() ? max_length : unreadLength();
+  uint64_t remaining = length;
+  while (remaining > 0) {
+    const int rc = data.read(fd_, remaining);
+    if (rc <= 0) {
+      return false;
+    }
+    remaining -= rc;
+  }
+  read_ += length;
+  return true;
+}
+
+} // namespace Buffer
+} // namespace Envoy
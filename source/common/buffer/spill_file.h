@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "envoy/buffer/buffer.h"
+
+#include "common/common/non_copyable.h"
+
+namespace Envoy {
+namespace Buffer {
+
+class SpillFile;
+typedef std::unique_ptr<SpillFile> SpillFilePtr;
+
+/**
+ * A temporary file which buffered data is written to and later read back in order, so that a
+ * large body can be held without keeping it in memory. The file is unlinked as soon as it is
+ * created, so it goes away when it is closed even if the process dies. All of the data must be
+ * written before any of it is read.
+ */
+class SpillFile : NonCopyable {
+public:
+  ~SpillFile();
+
+  /**
+   * Create a spill file.
+   * @param directory supplies the directory to create the file in.
+   * @return SpillFilePtr the file, or nullptr if it could not be created.
+   */
+  static SpillFilePtr create(const std::string& directory);
+
+  /**
+   * Append data to the file.
+   * @param data supplies the data to write, which is drained.
+   * @return bool whether all of the data was written.
+   */
+  bool write(Instance& data);
+
+  /**
+   * Read back the next part of the data.
+   * @param data supplies the buffer to add the data to.
+   * @param max_length supplies the maximum number of bytes to read.
+   * @return bool whether the read succeeded.
+   */
+  bool read(Instance& data, uint64_t max_length);
+
+  /**
+   * @return uint64_t the number of bytes written.
+   */
+  uint64_t length() const { return written_; }
+
+  /**
+   * @return uint64_t the number of bytes which have been written but not read back yet.
+   */
+  uint64_t unreadLength() const { return written_ - read_; }
+
+private:
+  SpillFile(int fd) : fd_(fd) {}
+
+  const int fd_;
+  uint64_t written_{0};
+  uint64_t read_{0};
+  bool reading_{false};
+};
+
+} // namespace Buffer
+} // namespace Envoy
@@ -0,0 +1,67 @@
+#include "common/common/arena.h"
+
+#include <algorithm>
+#include <new>
+
+namespace Envoy {
+
+namespace {
+
+const size_t Alignment = alignof(std::max_align_t);
+
+size_t alignUp(size_t size) { return (size + Alignment - 1) / Alignment * Alignment; }
+
+/**
+ * Prefixed to every ArenaAllocated object so that operator delete knows where the memory came
+ * from. Padded to keep the object itself aligned.
+ */
+struct alignas(std::max_align_t) ArenaAllocatedHeader {
+  bool from_arena_;
+};
+
+} // namespace
+
+const size_t Arena::DefaultBlockSize;
+
+void* Arena::allocate(size_t size) {
+  size = alignUp(size);
+  if (size > remaining_) {
+    // Oversized requests get a dedicated block so that they do not waste the rest of a normal
+    // block.
+    const size_t block_size = std::max(size, block_size_);
+    blocks_.emplace_back(new uint8_t[block_size]);
+    next_ = blocks_.back().get();
+    remaining_ = block_size;
+  }
+
+  void* allocation = next_;
+  next_ += size;
+  remaining_ -= size;
+  bytes_allocated_ += size;
+  return allocation;
+}
+
+void* ArenaAllocated::allocate(size_t size, Arena* arena) {
+  const size_t total_size = sizeof(ArenaAllocatedHeader) + size;
+  void* memory = arena != nullptr ? arena->allocate(total_size) : ::operator new(total_size);
+  ArenaAllocatedHeader* header = new (memory) ArenaAllocatedHeader();
+  header->from_arena_ = arena != nullptr;
+  return header + 1;
+}
+
+void* ArenaAllocated::operator new(size_t size, Arena* arena) { return allocate(size, arena); }
+
+void ArenaAllocated::operator delete(void* object) {
+  if (object == nullptr) {
+    return;
+  }
+
+  ArenaAllocatedHeader* header = static_cast<ArenaAllocatedHeader*>(object) - 1;
+  if (!header->from_arena_) {
+    ::operator delete(header);
+  }
+}
+
+void ArenaAllocated::operator delete(void* object, Arena*) { operator delete(object); }
+
+} // namespace Envoy
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "common/common/non_copyable.h"
+
+namespace Envoy {
+
+/**
+ * A simple bump allocator. Memory is carved sequentially out of blocks and is only released, all
+ * at once, when the arena is destroyed. This is intended for allocations that share a lifetime,
+ * e.g. the per-stream state of an HTTP request. An arena is not thread safe.
+ */
+class Arena : NonCopyable {
+public:
+  static const size_t DefaultBlockSize = 4096;
+
+  Arena(size_t block_size = DefaultBlockSize) : block_size_(block_size) {}
+
+  /**
+   * @param size supplies the number of bytes to allocate.
+   * @return void* memory aligned for any fundamental type, valid until the arena is destroyed.
+   */
+  void* allocate(size_t size);
+
+  /**
+   * @return uint64_t the total number of bytes handed out by allocate().
+   */
+  uint64_t bytesAllocated() const { return bytes_allocated_; }
+
+  /**
+   * @return size_t the number of blocks obtained from the heap.
+   */
+  size_t blockCount() const { return blocks_.size(); }
+
+private:
+  const size_t block_size_;
+  std::vector<std::unique_ptr<uint8_t[]>> blocks_;
+  uint8_t* next_{};
+  size_t remaining_{};
+  uint64_t bytes_allocated_{};
+};
+
+/**
+ * Mixin for classes that are owned through std::unique_ptr and that may be allocated either from
+ * an Arena or from the heap, decided at runtime:
+ *
+ *   std::unique_ptr<Foo> foo(new (arena) Foo()); // arena may be nullptr for a heap allocation.
+ *
+ * Deleting an arena allocated object runs its destructor but leaves the memory to the arena, so
+ * the arena must outlive every object allocated from it.
+ */
+class ArenaAllocated {
+public:
+  static void* operator new(size_t size, Arena* arena);
+  static void operator delete(void* object);
+  // Called if the constructor of an object allocated with operator new(size_t, Arena*) throws.
+  static void operator delete(void* object, Arena* arena);
+
+private:
+  static void* allocate(size_t size, Arena* arena);
+};
+
+/**
+ * Stateful allocator for standard containers, e.g. the nodes of a std::list, that allocates from
+ * an Arena, or from the heap when constructed with a nullptr arena. As with ArenaAllocated, the
+ * arena must outlive the container.
+ */
+template <class T> class ArenaAllocator {
+public:
+  typedef T value_type;
+
+  ArenaAllocator(Arena* arena) : arena_(arena) {}
+  template <class U> ArenaAllocator(const ArenaAllocator<U>& other) : arena_(other.arena_) {}
+
+  T* allocate(size_t n) {
+    return static_cast<T*>(arena_ != nullptr ? arena_->allocate(n * sizeof(T))
+                                             : ::operator new(n * sizeof(T)));
+  }
+  void deallocate(T* p, size_t) {
+    if (arena_ == nullptr) {
+      ::operator delete(p);
+    }
+  }
+
+  template <class U> bool operator==(const ArenaAllocator<U>& other) const {
+    return arena_ == other.arena_;
+  }
+  template <class U> bool operator!=(const ArenaAllocator<U>& other) const {
+    return arena_ != other.arena_;
+  }
+
+private:
+  template <class U> friend class ArenaAllocator;
+
+  Arena* arena_;
+};
+
+} // namespace Envoy
@@ -1,5 +1,6 @@
 #include "common/common/base64.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <string>
 
@@ -24,82 +25,126 @@ static const unsigned char REVERSE_LOOKUP_TABLE[256] = {
     64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
     64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64};
 
-std::string Base64::decode(const std::string& input) {
-  if (input.length() % 4 || input.empty()) {
-    return EMPTY_STRING;
+// Decode a group of 4 characters into 3 bytes 8 bits each. Only the last group of the input may
+// end in padding. Returns the number of bytes written to out, or -1 if the group is invalid.
+static int decodeGroup(const uint8_t* chars, bool last, uint8_t* out) {
+  // Use conversion table to map char to decoded value (value is between 0 and 63 inclusive for a
+  // valid character, 64 otherwise).
+  const unsigned char a = REVERSE_LOOKUP_TABLE[chars[0]];
+  const unsigned char b = REVERSE_LOOKUP_TABLE[chars[1]];
+  const unsigned char c = REVERSE_LOOKUP_TABLE[chars[2]];
+  const unsigned char d = REVERSE_LOOKUP_TABLE[chars[3]];
+  if ((a | b) & 64) {
+    // Input contains an invalid character.
+    return -1;
+  }
+  // Take first 6 bits from 1st converted char and first 2 bits from 2nd converted char.
+  out[0] = a << 2 | b >> 4;
+
+  // Decoded value 64 means invalid character unless it is valid padding, in which case there must
+  // be no unused bits in the preceding character.
+  if (c == 64) {
+    if (!last || chars[2] != '=' || chars[3] != '=' || (b & 0b1111)) {
+      return -1;
+    }
+    return 1;
   }
+  // Take last 4 bits from 2nd converted char and 4 first bits from 3rd converted char.
+  out[1] = b << 4 | c >> 2;
 
-  // First position of "valid" padding character.
-  uint64_t first_padding_index = input.length();
-  int max_length = input.length() / 4 * 3;
-  // At most last two chars can be '='.
-  if (input[input.length() - 1] == '=') {
-    max_length--;
-    first_padding_index = input.length() - 1;
-    if (input[input.length() - 2] == '=') {
-      max_length--;
-      first_padding_index = input.length() - 2;
+  if (d == 64) {
+    if (!last || chars[3] != '=' || (c & 0b11)) {
+      return -1;
     }
+    return 2;
+  }
+  // Take last 2 bits from 3rd converted char and all(6) bits from 4th converted char.
+  out[2] = c << 6 | d;
+  return 3;
+}
+
+// Encode a group of 3 bytes into 4 characters 6 bits each.
+static void encodeGroup(const uint8_t* bytes, char* out) {
+  out[0] = CHAR_TABLE[bytes[0] >> 2];
+  out[1] = CHAR_TABLE[(bytes[0] & 0x03) << 4 | bytes[1] >> 4];
+  out[2] = CHAR_TABLE[(bytes[1] & 0x0f) << 2 | bytes[2] >> 6];
+  out[3] = CHAR_TABLE[bytes[2] & 0x3f];
+}
+
+std::string Base64::decode(const char* input, uint64_t length) {
+  if (length % 4 || length == 0) {
+    return EMPTY_STRING;
   }
-  std::string result;
-  result.reserve(max_length);
 
-  uint64_t bytes_left = input.length();
-  uint64_t cur_read = 0;
+  std::string result(length / 4 * 3, '\0');
+  uint8_t* out = reinterpret_cast<uint8_t*>(&result[0]);
+  const uint8_t* chars = reinterpret_cast<const uint8_t*>(input);
+  uint64_t result_length = 0;
 
   // Read input string by group of 4 chars, length of input string must be divided evenly by 4.
-  // Decode 4 chars 6 bits each into 3 chars 8 bits each.
-  while (bytes_left > 0) {
-    // Take first 6 bits from 1st converted char and first 2 bits from 2nd converted char,
-    // make 8 bits char from it.
-    // Use conversion table to map char to decoded value (value is between 0 and 63 inclusive for a
-    // valid character).
-    const unsigned char a = REVERSE_LOOKUP_TABLE[static_cast<uint32_t>(input[cur_read])];
-    const unsigned char b = REVERSE_LOOKUP_TABLE[static_cast<uint32_t>(input[cur_read + 1])];
-    if (a == 64 || b == 64) {
-      // Input contains an invalid character.
+  for (uint64_t cur_read = 0; cur_read < length; cur_read += 4) {
+    const int decoded =
+        decodeGroup(chars + cur_read, cur_read + 4 == length, out + result_length);
+    if (decoded < 0) {
       return EMPTY_STRING;
     }
-    result.push_back(a << 2 | b >> 4);
-    const unsigned char c = REVERSE_LOOKUP_TABLE[static_cast<uint32_t>(input[cur_read + 2])];
-
-    // Decoded value 64 means invalid character unless we already know it is a valid padding.
-    // If so, following characters are all padding.
-    // Also we should check there are no unused bits.
-    if (c == 64) {
-      if (first_padding_index != cur_read + 2) {
-        // Input contains an invalid character.
-        return EMPTY_STRING;
-      } else if (b & 0b1111) {
-        // There are unused bits at tail.
-        return EMPTY_STRING;
+    result_length += decoded;
+  }
+
+  result.resize(result_length);
+  return result;
+}
+
+bool Base64::decode(const Buffer::Instance& input, Buffer::Instance& output) {
+  const uint64_t length = input.length();
+  if (length % 4 || length == 0) {
+    return false;
+  }
+
+  Buffer::RawSlice out;
+  output.reserve(length / 4 * 3, &out, 1);
+  uint8_t* out_mem = static_cast<uint8_t*>(out.mem_);
+  uint64_t out_length = 0;
+
+  uint64_t num_slices = input.getRawSlices(nullptr, 0);
+  Buffer::RawSlice slices[num_slices];
+  input.getRawSlices(slices, num_slices);
+
+  // Groups are decoded straight from the slices, except for those that straddle two slices, which
+  // are gathered in group first.
+  uint8_t group[4];
+  uint64_t group_length = 0;
+  uint64_t consumed = 0;
+  for (const Buffer::RawSlice& slice : slices) {
+    const uint8_t* mem = static_cast<const uint8_t*>(slice.mem_);
+    uint64_t i = 0;
+    while (i < slice.len_) {
+      const uint8_t* chars;
+      if (group_length == 0 && slice.len_ - i >= 4) {
+        chars = mem + i;
+        i += 4;
       } else {
-        return result;
+        group[group_length++] = mem[i++];
+        if (group_length < 4) {
+          continue;
+        }
+        chars = group;
+        group_length = 0;
       }
-    }
-    // Take last 4 bits from 2nd converted char and 4 first bits from 3rd converted char.
-    result.push_back(b << 4 | c >> 2);
-
-    const unsigned char d = REVERSE_LOOKUP_TABLE[static_cast<uint32_t>(input[cur_read + 3])];
-    if (d == 64) {
-      if (first_padding_index != cur_read + 3) {
-        // Input contains an invalid character.
-        return EMPTY_STRING;
-      } else if (c & 0b11) {
-        // There are unused bits at tail.
-        return EMPTY_STRING;
-      } else {
-        return result;
+
+      consumed += 4;
+      const int decoded = decodeGroup(chars, consumed == length, out_mem + out_length);
+      if (decoded < 0) {
+        output.commit(&out, 0);
+        return false;
       }
+      out_length += decoded;
     }
-    // Take last 2 bits from 3rd converted char and all(6) bits from 4th converted char.
-    result.push_back(c << 6 | d);
-
-    cur_read += 4;
-    bytes_left -= 4;
   }
 
-  return result;
+  out.len_ = out_length;
+  output.commit(&out, 1);
+  return true;
 }
 
 void Base64::encodeBase(const uint8_t cur_char, uint64_t pos, uint8_t& next_c, std::string& ret) {
@@ -164,6 +209,83 @@ std::string Base64::encode(const Buffer::Instance& buffer, uint64_t length) {
   return ret;
 }
 
+void Base64::encode(const Buffer::Instance& input, Buffer::Instance& output) {
+  const uint64_t length = input.length();
+  if (length == 0) {
+    return;
+  }
+
+  Buffer::RawSlice out;
+  output.reserve((length + 2) / 3 * 4, &out, 1);
+  char* out_mem = static_cast<char*>(out.mem_);
+  uint64_t out_length = 0;
+
+  uint64_t num_slices = input.getRawSlices(nullptr, 0);
+  Buffer::RawSlice slices[num_slices];
+  input.getRawSlices(slices, num_slices);
+
+  // Groups are encoded straight from the slices, except for those that straddle two slices, which
+  // are gathered in group first.
+  uint8_t group[3];
+  uint64_t group_length = 0;
+  for (const Buffer::RawSlice& slice : slices) {
+    const uint8_t* mem = static_cast<const uint8_t*>(slice.mem_);
+    uint64_t i = 0;
+    while (i < slice.len_) {
+      const uint8_t* bytes;
+      if (group_length == 0 && slice.len_ - i >= 3) {
+        bytes = mem + i;
+        i += 3;
+      } else {
+        group[group_length++] = mem[i++];
+        if (group_length < 3) {
+          continue;
+        }
+        bytes = group;
+        group_length = 0;
+      }
+      encodeGroup(bytes, out_mem + out_length);
+      out_length += 4;
+    }
+  }
+
+  // Pad the last group with zero bits, and replace the characters that encode only padding with
+  // '='.
+  if (group_length > 0) {
+    std::fill(group + group_length, group + 3, 0);
+    encodeGroup(group, out_mem + out_length);
+    out_mem[out_length + 3] = '=';
+    if (group_length == 1) {
+      out_mem[out_length + 2] = '=';
+    }
+    out_length += 4;
+  }
+
+  out.len_ = out_length;
+  output.commit(&out, 1);
+}
+
+void Base64::encode(const char* input, uint64_t length, char* output) {
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(input);
+  uint64_t i = 0;
+  for (; i + 3 <= length; i += 3) {
+    encodeGroup(bytes + i, output);
+    output += 4;
+  }
+
+  // Pad the last group with zero bits, and replace the characters that encode only padding with
+  // '='.
+  if (i < length) {
+    uint8_t group[3] = {};
+    std::copy(bytes + i, bytes + length, group);
+    encodeGroup(group, output);
+    output[3] = '=';
+    if (length - i == 1) {
+      output[2] = '=';
+    }
+  }
+}
+
 std::string Base64::encode(const char* input, uint64_t length) {
   uint64_t output_length = (length + 2) / 3 * 4;
   std::string ret;
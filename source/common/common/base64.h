@@ -29,7 +29,48 @@ public:
    * Note, decoded string may contain '\0' at any position, it should be treated as a sequence of
    * bytes.
    */
-  static std::string decode(const std::string& input);
+  static std::string decode(const std::string& input) {
+    return decode(input.data(), input.size());
+  }
+
+  /**
+   * Base64 decode an input char buffer with a given length, e.g. a header value, without copying it
+   * first.
+   * @param input char array to decode, which need not be null terminated.
+   * @param length of the input array.
+   */
+  static std::string decode(const char* input, uint64_t length);
+
+  /**
+   * Base64 encode an input char buffer into a caller supplied one.
+   * @param input char array to encode.
+   * @param length of the input array.
+   * @param output supplies the buffer to write to, which must have room for encodedLength(length)
+   *        characters. No null terminator is written.
+   */
+  static void encode(const char* input, uint64_t length, char* output);
+
+  /**
+   * @return the number of characters that encoding length bytes produces.
+   */
+  static constexpr uint64_t encodedLength(uint64_t length) { return (length + 2) / 3 * 4; }
+
+  /**
+   * Base64 encode a buffer into another, reading the input slice by slice and writing the encoded
+   * characters straight into the output's memory.
+   * @param input supplies the buffer to encode.
+   * @param output supplies the buffer to append the encoded characters to.
+   */
+  static void encode(const Buffer::Instance& input, Buffer::Instance& output);
+
+  /**
+   * Base64 decode a buffer into another, reading the input slice by slice and writing the decoded
+   * bytes straight into the output's memory.
+   * @param input supplies the buffer to decode. Its length must be a non-zero multiple of 4.
+   * @param output supplies the buffer to append the decoded bytes to.
+   * @return bool whether the input was valid base64. If not, output is left unchanged.
+   */
+  static bool decode(const Buffer::Instance& input, Buffer::Instance& output);
 
 private:
   /**
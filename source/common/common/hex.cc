@@ -1,6 +1,5 @@
 #include "common/common/hex.h"
 
-#include <array>
 #include <cstdint>
 #include <string>
 #include <vector>
@@ -12,6 +11,8 @@
 #include "fmt/format.h"
 
 namespace Envoy {
+const size_t Hex::UINT64_HEX_LENGTH;
+
 std::string Hex::encode(const uint8_t* data, size_t length) {
   static const char* const digits = "0123456789abcdef";
 
@@ -47,18 +48,38 @@ std::vector<uint8_t> Hex::decode(const std::string& hex_string) {
 }
 
 std::string Hex::uint64ToHex(uint64_t value) {
-  std::array<uint8_t, 8> data;
-
-  // This is explicitly done for performance reasons
-  data[7] = (value & 0x00000000000000FF);
-  data[6] = (value & 0x000000000000FF00) >> 8;
-  data[5] = (value & 0x0000000000FF0000) >> 16;
-  data[4] = (value & 0x00000000FF000000) >> 24;
-  data[3] = (value & 0x000000FF00000000) >> 32;
-  data[2] = (value & 0x0000FF0000000000) >> 40;
-  data[1] = (value & 0x00FF000000000000) >> 48;
-  data[0] = (value & 0xFF00000000000000) >> 56;
-
-  return encode(&data[0], data.size());
+  std::string ret(UINT64_HEX_LENGTH, '0');
+  uint64ToHex(value, &ret[0]);
+  return ret;
+}
+
+void Hex::uint64ToHex(uint64_t value, char* out) {
+  static const char* const digits = "0123456789abcdef";
+
+  for (size_t i = UINT64_HEX_LENGTH; i > 0; i--) {
+    out[i - 1] = digits[value & 0xf];
+    value >>= 4;
+  }
+}
+
+bool Hex::hexToUint64(const char* in, uint64_t& value) {
+  uint64_t result = 0;
+  for (size_t i = 0; i < UINT64_HEX_LENGTH; i++) {
+    const char c = in[i];
+    uint64_t digit;
+    if (c >= '0' && c <= '9') {
+      digit = c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+      digit = c - 'a' + 10;
+    } else if (c >= 'A' && c <= 'F') {
+      digit = c - 'A' + 10;
+    } else {
+      return false;
+    }
+    result = result << 4 | digit;
+  }
+
+  value = result;
+  return true;
 }
 } // namespace Envoy
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -39,5 +41,24 @@ public:
    * @param value The integer to be converted.
    */
   static std::string uint64ToHex(uint64_t value);
+
+  /**
+   * Writes the given 64-bit integer as hexadecimal into a caller supplied buffer.
+   * @param value The integer to be converted.
+   * @param out supplies the buffer, which must have room for UINT64_HEX_LENGTH characters. No null
+   *        terminator is written.
+   */
+  static void uint64ToHex(uint64_t value, char* out);
+
+  /**
+   * Parses UINT64_HEX_LENGTH hexadecimal digits into a 64-bit integer.
+   * @param in supplies the digits, which need not be null terminated.
+   * @param value supplies the integer to set.
+   * @return bool whether all of the characters were hex digits. If not, value is unchanged.
+   */
+  static bool hexToUint64(const char* in, uint64_t& value);
+
+  // The number of digits in the hexadecimal form of a 64-bit integer.
+  static constexpr size_t UINT64_HEX_LENGTH = 16;
 };
 } // namespace Envoy
@@ -8,11 +8,12 @@
 namespace Envoy {
 /**
  * Mixin class that allows an object contained in a unique pointer to be easily linked and unlinked
- * from lists.
+ * from lists. The list nodes are obtained from Allocator, e.g. an ArenaAllocator for objects whose
+ * lists share a lifetime.
  */
-template <class T> class LinkedObject {
+template <class T, class Allocator = std::allocator<std::unique_ptr<T>>> class LinkedObject {
 public:
-  typedef std::list<std::unique_ptr<T>> ListType;
+  typedef std::list<std::unique_ptr<T>, Allocator> ListType;
 
   /**
    * @return the list iterator for the object.
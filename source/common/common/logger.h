@@ -197,6 +197,12 @@ protected:
  */
 #define ENVOY_LOG(LEVEL, ...) ENVOY_LOG_TO_LOGGER(ENVOY_LOGGER(), LEVEL, ##__VA_ARGS__)
 
+/**
+ * Convenience macro to check whether the class' logger logs at a level, for log arguments that are
+ * expensive to compute. Log macro arguments are evaluated even when nothing is logged.
+ */
+#define ENVOY_LOG_CHECK_LEVEL(LEVEL) (ENVOY_LOGGER().level() <= spdlog::level::LEVEL)
+
 /**
  * Convenience macro to log to the misc logger, which allows for logging without of direct access to
  * a logger.
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+
+#include "common/common/non_copyable.h"
+
+namespace Envoy {
+
+/**
+ * Intrusive multi-producer single-consumer queue that takes no locks. Producers push with a
+ * single atomic exchange and never wait on each other or on the consumer. Based on the queue by
+ * Dmitry Vyukov.
+ *
+ * Elements derive from MpscQueue<T>::Node and are owned by the caller; the queue only links them.
+ * Any thread may push(), but only one thread at a time may pop().
+ */
+template <class T> class MpscQueue : NonCopyable {
+public:
+  class Node {
+  protected:
+    Node() {}
+
+  private:
+    std::atomic<Node*> next_{};
+
+    friend class MpscQueue;
+  };
+
+  MpscQueue() : head_(&stub_), tail_(&stub_) {}
+
+  /**
+   * Append an element. Safe to call from any thread.
+   * @param element supplies the element, which must not be queued already.
+   */
+  void push(T& element) { push(static_cast<Node*>(&element)); }
+
+  /**
+   * Remove the oldest element. Must only be called by the consumer.
+   * @return T* the element, or nullptr if the queue is empty. nullptr is also returned while the
+   *         oldest element is still being pushed, in which case its producer has not returned
+   *         from push() yet. Callers that are told about pushes after they return, as with a
+   *         wakeup, see the element then.
+   */
+  T* pop() {
+    Node* tail = tail_;
+    Node* next = tail->next_.load(std::memory_order_acquire);
+    if (tail == &stub_) {
+      if (next == nullptr) {
+        return nullptr;
+      }
+      tail_ = next;
+      tail = next;
+      next = next->next_.load(std::memory_order_acquire);
+    }
+
+    if (next != nullptr) {
+      tail_ = next;
+      return static_cast<T*>(tail);
+    }
+
+    if (tail != head_.load(std::memory_order_acquire)) {
+      return nullptr;
+    }
+
+    // tail is the last element. Queue the stub behind it so that it can be unlinked.
+    push(&stub_);
+    next = tail->next_.load(std::memory_order_acquire);
+    if (next != nullptr) {
+      tail_ = next;
+      return static_cast<T*>(tail);
+    }
+    return nullptr;
+  }
+
+private:
+  struct Stub : public Node {};
+
+  void push(Node* node) {
+    node->next_.store(nullptr, std::memory_order_relaxed);
+    Node* prev = head_.exchange(node, std::memory_order_acq_rel);
+    prev->next_.store(node, std::memory_order_release);
+  }
+
+  Stub stub_;
+  std::atomic<Node*> head_; // Most recently pushed.
+  Node* tail_;              // Oldest, only accessed by the consumer.
+};
+
+} // namespace Envoy
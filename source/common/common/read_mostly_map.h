@@ -0,0 +1,126 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/common/hash.h"
+#include "common/common/non_copyable.h"
+
+namespace Envoy {
+
+/**
+ * Insert-only hash map from string to Value whose lookups take no locks, in the spirit of RCU.
+ * Writers serialize on a lock owned by the caller and publish each insertion with a release store,
+ * so readers never block and never observe a partially built entry.
+ *
+ * Entries and hash chains are immutable once published. Growing the table builds a new bucket
+ * array and atomically swaps it in. Superseded tables are kept until the map is destroyed because
+ * a lock-free reader may still be walking them; their total size is bounded by the current
+ * table's, so the map uses at most about twice the memory of a plain hash table.
+ */
+template <class Value> class ReadMostlyMap : NonCopyable {
+public:
+  /**
+   * Look up a key without locking. A key inserted concurrently may be missed, so callers that
+   * need a definitive answer must look again while holding the writer lock.
+   * @param key supplies the key.
+   * @return a pointer to the value, valid until the map is destroyed, or nullptr.
+   */
+  const Value* find(const std::string& key) const {
+    const Table* table = table_.load(std::memory_order_acquire);
+    if (table == nullptr) {
+      return nullptr;
+    }
+
+    const Link* link = table->buckets_[HashUtil::xxHash64(key) & table->mask_].load(
+        std::memory_order_acquire);
+    for (; link != nullptr; link = link->next_) {
+      if (link->entry_->key_ == key) {
+        return &link->entry_->value_;
+      }
+    }
+    return nullptr;
+  }
+
+  /**
+   * Insert a key that is not in the map. Must be called with the writer lock held.
+   * @param key supplies the key.
+   * @param value supplies the value.
+   * @return the inserted value, which stays valid until the map is destroyed.
+   */
+  const Value& insert(const std::string& key, Value&& value) {
+    entries_.emplace_back(new Entry{key, std::move(value)});
+    const Entry& entry = *entries_.back();
+
+    if (tables_.empty() || entries_.size() > tables_.back()->mask_ + 1) {
+      // Keep the load factor at most 1 by doubling. The new table is filled in before it is
+      // published, so readers see either the old table or the complete new one.
+      const size_t buckets = tables_.empty() ? InitialBuckets : 2 * (tables_.back()->mask_ + 1);
+      tables_.emplace_back(new Table(buckets));
+      for (const std::unique_ptr<Entry>& existing : entries_) {
+        link(*tables_.back(), *existing);
+      }
+      table_.store(tables_.back().get(), std::memory_order_release);
+    } else {
+      link(*tables_.back(), entry);
+    }
+
+    return entry.value_;
+  }
+
+  /**
+   * Invoke cb(key, value) for every entry in insertion order. Must be called with the writer
+   * lock held.
+   */
+  template <class Callback> void forEach(Callback cb) const {
+    for (const std::unique_ptr<Entry>& entry : entries_) {
+      cb(entry->key_, entry->value_);
+    }
+  }
+
+  /**
+   * @return the number of entries. Must be called with the writer lock held.
+   */
+  size_t size() const { return entries_.size(); }
+
+private:
+  static const size_t InitialBuckets = 8;
+
+  struct Entry {
+    const std::string key_;
+    const Value value_;
+  };
+
+  struct Link {
+    const Entry* const entry_;
+    const Link* const next_;
+  };
+
+  struct Table {
+    Table(size_t buckets) : buckets_(new std::atomic<const Link*>[buckets]()), mask_(buckets - 1) {}
+
+    const std::unique_ptr<std::atomic<const Link*>[]> buckets_;
+    const size_t mask_;
+    // A deque never moves its elements, so links can be referenced while more are added.
+    std::deque<Link> links_;
+  };
+
+  static void link(Table& table, const Entry& entry) {
+    std::atomic<const Link*>& bucket = table.buckets_[HashUtil::xxHash64(entry.key_) & table.mask_];
+    table.links_.push_back({&entry, bucket.load(std::memory_order_relaxed)});
+    bucket.store(&table.links_.back(), std::memory_order_release);
+  }
+
+  std::vector<std::unique_ptr<Entry>> entries_;
+  // Every table ever published. Only the last one is current for writers.
+  std::vector<std::unique_ptr<Table>> tables_;
+  std::atomic<const Table*> table_{};
+};
+
+template <class Value> const size_t ReadMostlyMap<Value>::InitialBuckets;
+
+} // namespace Envoy
@@ -0,0 +1,104 @@
+#include "common/common/regex.h"
+
+#include <algorithm>
+
+#include "envoy/common/exception.h"
+
+#include "fmt/format.h"
+
+namespace Envoy {
+namespace Regex {
+
+namespace {
+
+std::regex compileStdRegex(const std::string& regex) {
+  try {
+    return std::regex(regex, std::regex::optimize);
+  } catch (const std::regex_error& e) {
+    throw EnvoyException(fmt::format("invalid regex '{}': {}", regex, e.what()));
+  }
+}
+
+} // namespace
+
+StdRegexMatcher::StdRegexMatcher(const std::string& regex) : regex_(compileStdRegex(regex)) {}
+
+bool StdRegexMatcher::match(const char* value, size_t size) const {
+  return std::regex_match(value, value + size, regex_);
+}
+
+Re2Matcher::Re2Matcher(const std::string& regex) : regex_(regex, re2::RE2::Quiet) {
+  if (!regex_.ok()) {
+    throw EnvoyException(fmt::format("invalid regex '{}': {}", regex, regex_.error()));
+  }
+}
+
+bool Re2Matcher::match(const char* value, size_t size) const {
+  return re2::RE2::FullMatch(re2::StringPiece(value, size), regex_);
+}
+
+StdRegexMatcherSet::StdRegexMatcherSet(const std::vector<std::string>& regexes) {
+  matchers_.reserve(regexes.size());
+  for (const std::string& regex : regexes) {
+    matchers_.emplace_back(regex);
+  }
+}
+
+void StdRegexMatcherSet::match(const char* value, size_t size,
+                               std::vector<uint32_t>& matches) const {
+  for (uint32_t i = 0; i < matchers_.size(); i++) {
+    if (matchers_[i].match(value, size)) {
+      matches.push_back(i);
+    }
+  }
+}
+
+re2::RE2::Options Re2MatcherSet::options() {
+  re2::RE2::Options options;
+  options.set_log_errors(false);
+  return options;
+}
+
+Re2MatcherSet::Re2MatcherSet(const std::vector<std::string>& regexes)
+    : set_(options(), re2::RE2::ANCHOR_BOTH) {
+  for (const std::string& regex : regexes) {
+    std::string error;
+    if (set_.Add(regex, &error) < 0) {
+      throw EnvoyException(fmt::format("invalid regex '{}': {}", regex, error));
+    }
+  }
+  if (!set_.Compile()) {
+    throw EnvoyException(
+        fmt::format("unable to compile set of {} regexes: out of memory", regexes.size()));
+  }
+}
+
+void Re2MatcherSet::match(const char* value, size_t size, std::vector<uint32_t>& matches) const {
+  // RE2::Set reports matching expressions in no particular order.
+  static thread_local std::vector<int> set_matches;
+  set_matches.clear();
+  if (!set_.Match(re2::StringPiece(value, size), &set_matches)) {
+    return;
+  }
+  std::sort(set_matches.begin(), set_matches.end());
+  matches.insert(matches.end(), set_matches.begin(), set_matches.end());
+}
+
+CompiledMatcherPtr Utility::parseRegex(const std::string& regex) {
+#ifdef ENVOY_STD_REGEX
+  return CompiledMatcherPtr{new StdRegexMatcher(regex)};
+#else
+  return CompiledMatcherPtr{new Re2Matcher(regex)};
+#endif
+}
+
+CompiledMatcherSetPtr Utility::parseRegexSet(const std::vector<std::string>& regexes) {
+#ifdef ENVOY_STD_REGEX
+  return CompiledMatcherSetPtr{new StdRegexMatcherSet(regexes)};
+#else
+  return CompiledMatcherSetPtr{new Re2MatcherSet(regexes)};
+#endif
+}
+
+} // namespace Regex
+} // namespace Envoy
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "envoy/common/regex.h"
+
+#include "re2/re2.h"
+#include "re2/set.h"
+
+namespace Envoy {
+namespace Regex {
+
+/**
+ * CompiledMatcher backed by std::regex (ECMAScript grammar). libstdc++'s implementation
+ * backtracks, so matching time can grow exponentially with the input for some expressions.
+ */
+class StdRegexMatcher : public CompiledMatcher {
+public:
+  /**
+   * @throw EnvoyException if the expression is invalid.
+   */
+  StdRegexMatcher(const std::string& regex);
+
+  // Regex::CompiledMatcher
+  bool match(const char* value, size_t size) const override;
+
+private:
+  std::regex regex_;
+};
+
+/**
+ * CompiledMatcher backed by RE2, which guarantees matching time linear in the input. RE2 does not
+ * support backreferences or lookaround assertions.
+ */
+class Re2Matcher : public CompiledMatcher {
+public:
+  /**
+   * @throw EnvoyException if the expression is invalid.
+   */
+  Re2Matcher(const std::string& regex);
+
+  // Regex::CompiledMatcher
+  bool match(const char* value, size_t size) const override;
+
+private:
+  re2::RE2 regex_;
+};
+
+/**
+ * CompiledMatcherSet that tries each std::regex expression in turn.
+ */
+class StdRegexMatcherSet : public CompiledMatcherSet {
+public:
+  /**
+   * @throw EnvoyException if any expression is invalid.
+   */
+  StdRegexMatcherSet(const std::vector<std::string>& regexes);
+
+  // Regex::CompiledMatcherSet
+  void match(const char* value, size_t size, std::vector<uint32_t>& matches) const override;
+
+private:
+  std::vector<StdRegexMatcher> matchers_;
+};
+
+/**
+ * CompiledMatcherSet backed by RE2::Set, which matches the value against every expression in one
+ * linear pass.
+ */
+class Re2MatcherSet : public CompiledMatcherSet {
+public:
+  /**
+   * @throw EnvoyException if any expression is invalid or the set is too large to compile.
+   */
+  Re2MatcherSet(const std::vector<std::string>& regexes);
+
+  // Regex::CompiledMatcherSet
+  void match(const char* value, size_t size, std::vector<uint32_t>& matches) const override;
+
+private:
+  static re2::RE2::Options options();
+
+  re2::RE2::Set set_;
+};
+
+class Utility {
+public:
+  /**
+   * Compile a regular expression used for request matching with the engine selected at build
+   * time: RE2 by default, std::regex with --define regex_engine=std.
+   * @param regex supplies the expression.
+   * @return CompiledMatcherPtr the compiled expression.
+   * @throw EnvoyException if the expression is invalid.
+   */
+  static CompiledMatcherPtr parseRegex(const std::string& regex);
+
+  /**
+   * Compile a set of regular expressions with the engine selected at build time.
+   * @param regexes supplies the expressions.
+   * @return CompiledMatcherSetPtr the compiled set.
+   * @throw EnvoyException if any expression is invalid.
+   */
+  static CompiledMatcherSetPtr parseRegexSet(const std::vector<std::string>& regexes);
+};
+
+} // namespace Regex
+} // namespace Envoy
@@ -1,12 +1,21 @@
 #include "common/common/thread.h"
 
 #ifdef __linux__
+#include <sched.h>
 #include <sys/syscall.h>
 #elif defined(__APPLE__)
 #include <pthread.h>
 #endif
 
+#include <time.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
 #include <functional>
+#include <mutex>
+#include <vector>
 
 #include "common/common/assert.h"
 #include "common/common/macros.h"
@@ -37,11 +46,120 @@ int32_t Thread::currentThreadId() {
 #endif
 }
 
+std::chrono::nanoseconds Thread::currentThreadCpuTime() {
+  timespec ts;
+  int rc = clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  RELEASE_ASSERT(rc == 0);
+  UNREFERENCED_PARAMETER(rc);
+  return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+}
+
+std::vector<uint32_t> Thread::currentThreadCpus() {
+  std::vector<uint32_t> cpus;
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+    for (uint32_t cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+      if (CPU_ISSET(cpu, &set)) {
+        cpus.push_back(cpu);
+      }
+    }
+  }
+#endif
+  return cpus;
+}
+
+bool Thread::pinCurrentThread(uint32_t cpu) {
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+  UNREFERENCED_PARAMETER(cpu);
+  return false;
+#endif
+}
+
 void Thread::join() {
   int rc = pthread_join(thread_id_, nullptr);
   RELEASE_ASSERT(rc == 0);
   UNREFERENCED_PARAMETER(rc);
 }
 
+WorkQueueThread::WorkQueueThread()
+    : thread_(new Thread([this]() -> void { threadRoutine(); })) {}
+
+WorkQueueThread::~WorkQueueThread() {
+  {
+    std::unique_lock<std::mutex> lock(lock_);
+    exit_ = true;
+    work_event_.notify_one();
+  }
+  thread_->join();
+}
+
+void WorkQueueThread::post(std::function<void()> work) {
+  std::unique_lock<std::mutex> lock(lock_);
+  queue_.push_back(std::move(work));
+  work_event_.notify_one();
+}
+
+void WorkQueueThread::threadRoutine() {
+  std::unique_lock<std::mutex> lock(lock_);
+  while (true) {
+    while (queue_.empty() && !exit_) {
+      work_event_.wait(lock);
+    }
+
+    if (exit_) {
+      return;
+    }
+
+    std::function<void()> work = std::move(queue_.front());
+    queue_.pop_front();
+    lock.unlock();
+    work();
+    lock.lock();
+  }
+}
+
+void parallelFor(size_t count, uint32_t concurrency, const std::function<void(size_t)>& fn) {
+  std::atomic<size_t> next{0};
+  std::atomic<bool> failed{false};
+  std::mutex lock;
+  std::exception_ptr exception;
+  auto run = [&]() -> void {
+    // Threads do not propagate exceptions, so the first one is handed over to the calling thread.
+    try {
+      for (size_t i = next++; i < count && !failed; i = next++) {
+        fn(i);
+      }
+    } catch (...) {
+      std::unique_lock<std::mutex> guard(lock);
+      if (!exception) {
+        exception = std::current_exception();
+      }
+      failed = true;
+    }
+  };
+
+  std::vector<ThreadPtr> threads;
+  // The calling thread is one of the threads.
+  const size_t thread_count = std::min<size_t>(concurrency, count);
+  for (size_t i = 1; i < thread_count; i++) {
+    threads.emplace_back(new Thread(run));
+  }
+  run();
+  for (ThreadPtr& thread : threads) {
+    thread->join();
+  }
+
+  if (exception) {
+    std::rethrow_exception(exception);
+  }
+}
+
 } // namespace Thread
 } // namespace Envoy
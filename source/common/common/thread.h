@@ -1,8 +1,13 @@
 #pragma once
 
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
 #include <functional>
 #include <memory>
 #include <mutex>
+#include <vector>
 
 #include "envoy/thread/thread.h"
 
@@ -24,6 +29,24 @@ public:
    */
   static ThreadId currentThreadId();
 
+  /**
+   * @return std::chrono::nanoseconds the CPU time used by the current thread so far.
+   */
+  static std::chrono::nanoseconds currentThreadCpuTime();
+
+  /**
+   * @return std::vector<uint32_t> the CPUs the current thread may run on, in ascending order.
+   *         Empty if the platform does not support CPU affinity.
+   */
+  static std::vector<uint32_t> currentThreadCpus();
+
+  /**
+   * Restrict the current thread to a single CPU.
+   * @param cpu supplies the CPU.
+   * @return bool whether the thread was pinned.
+   */
+  static bool pinCurrentThread(uint32_t cpu);
+
   /**
    * Join on thread exit.
    */
@@ -36,6 +59,41 @@ private:
 
 typedef std::unique_ptr<Thread> ThreadPtr;
 
+/**
+ * A thread that runs posted functions one at a time, in the order they were posted. Functions that
+ * did not start yet when it is destroyed are dropped, and the destructor waits for the running one.
+ */
+class WorkQueueThread {
+public:
+  WorkQueueThread();
+  ~WorkQueueThread();
+
+  /**
+   * Queue a function to run on the thread. May be called from any thread.
+   */
+  void post(std::function<void()> work);
+
+private:
+  void threadRoutine();
+
+  std::mutex lock_;
+  std::condition_variable work_event_; // Signalled when work is queued or on exit.
+  std::deque<std::function<void()>> queue_;
+  bool exit_{};
+  ThreadPtr thread_;
+};
+
+/**
+ * Call a function for each index in [0, count) on up to the given number of threads, the calling
+ * thread included, and return once all calls returned. Once a call throws, the indices that have
+ * not been started yet are skipped and the first exception is rethrown on the calling thread.
+ * @param count supplies the number of indices.
+ * @param concurrency supplies the maximum number of threads to use.
+ * @param fn supplies the function to call with each index, which must be safe to call
+ *        concurrently.
+ */
+void parallelFor(size_t count, uint32_t concurrency, const std::function<void(size_t)>& fn);
+
 /**
  * Implementation of BasicLockable
  */
@@ -1,5 +1,8 @@
 #include "common/common/to_lower_table.h"
 
+#include <cstdint>
+#include <cstring>
+
 namespace Envoy {
 ToLowerTable::ToLowerTable() {
   for (size_t c = 0; c < 256; c++) {
@@ -11,8 +14,30 @@ ToLowerTable::ToLowerTable() {
 }
 
 void ToLowerTable::toLowerCase(char* buffer, uint32_t size) const {
-  for (size_t i = 0; i < size; i++) {
+  size_t i = 0;
+  for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+    uint64_t word;
+    memcpy(&word, buffer + i, sizeof(word));
+    word = toLowerCase(word);
+    memcpy(buffer + i, &word, sizeof(word));
+  }
+
+  for (; i < size; i++) {
     buffer[i] = table_[static_cast<uint8_t>(buffer[i])];
   }
 }
+
+uint64_t ToLowerTable::toLowerCase(uint64_t word) {
+  const uint64_t high_bits = 0x8080808080808080ULL;
+  // The low 7 bits of each byte. Adding to them never carries into the next byte.
+  const uint64_t low_bits = word & ~high_bits;
+  // The high bit of a byte is set in above_z if its low bits are above 'Z', and in at_least_a if
+  // they are at least 'A'.
+  const uint64_t above_z = low_bits + 0x2525252525252525ULL;
+  const uint64_t at_least_a = low_bits + 0x3f3f3f3f3f3f3f3fULL;
+  // Only ASCII bytes, whose high bit is clear, are converted.
+  const uint64_t upper = (at_least_a & ~above_z) & ~word & high_bits;
+  // Moves the high bit of each upper case byte to its 0x20 bit.
+  return word | (upper >> 2);
+}
 } // namespace Envoy
@@ -1,12 +1,13 @@
 #pragma once
 
 #include <array>
+#include <cstdint>
 #include <string>
 
 namespace Envoy {
 /**
- * Convenience class for converting ASCII strings to lower case using a lookup table for maximum
- * speed.
+ * Convenience class for converting ASCII strings to lower case. Strings are converted eight bytes
+ * at a time with word arithmetic, and the lookup table handles the remaining bytes.
  */
 class ToLowerTable {
 public:
@@ -25,6 +26,14 @@ public:
    */
   void toLowerCase(std::string& string) const { toLowerCase(&string[0], string.size()); }
 
+  /**
+   * Convert the eight ASCII characters packed into a word to lower case. Bytes that are not ASCII
+   * are left alone.
+   * @param word supplies the characters.
+   * @return the converted characters.
+   */
+  static uint64_t toLowerCase(uint64_t word);
+
 private:
   std::array<uint8_t, 256> table_;
 };
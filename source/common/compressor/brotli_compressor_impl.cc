@@ -0,0 +1,82 @@
+#include "common/compressor/brotli_compressor_impl.h"
+
+#include "common/common/assert.h"
+
+namespace Envoy {
+namespace Compressor {
+
+BrotliCompressorImpl::BrotliCompressorImpl() : BrotliCompressorImpl(4096) {}
+
+BrotliCompressorImpl::BrotliCompressorImpl(uint64_t chunk_size)
+    : chunk_size_{chunk_size}, initialized_{false}, quality_{0}, window_bits_{0},
+      chunk_ptr_(new uint8_t[chunk_size]),
+      state_ptr_(nullptr, [](BrotliEncoderState* state) { BrotliEncoderDestroyInstance(state); }) {}
+
+void BrotliCompressorImpl::init(uint32_t quality, uint32_t window_bits) {
+  ASSERT(initialized_ == false);
+  RELEASE_ASSERT(quality <= BROTLI_MAX_QUALITY);
+  RELEASE_ASSERT(window_bits >= BROTLI_MIN_WINDOW_BITS && window_bits <= BROTLI_MAX_WINDOW_BITS);
+  quality_ = quality;
+  window_bits_ = window_bits;
+  createEncoder();
+  initialized_ = true;
+}
+
+void BrotliCompressorImpl::createEncoder() {
+  state_ptr_.reset(BrotliEncoderCreateInstance(nullptr, nullptr, nullptr));
+  RELEASE_ASSERT(state_ptr_ != nullptr);
+  BrotliEncoderSetParameter(state_ptr_.get(), BROTLI_PARAM_QUALITY, quality_);
+  BrotliEncoderSetParameter(state_ptr_.get(), BROTLI_PARAM_LGWIN, window_bits_);
+}
+
+void BrotliCompressorImpl::compress(const Buffer::Instance& input_buffer,
+                                    Buffer::Instance& output_buffer) {
+  ASSERT(initialized_);
+  const uint64_t num_slices = input_buffer.getRawSlices(nullptr, 0);
+  Buffer::RawSlice slices[num_slices];
+  input_buffer.getRawSlices(slices, num_slices);
+
+  for (const Buffer::RawSlice& input_slice : slices) {
+    process(static_cast<const uint8_t*>(input_slice.mem_), input_slice.len_,
+            BROTLI_OPERATION_PROCESS, output_buffer);
+  }
+}
+
+void BrotliCompressorImpl::flush(Buffer::Instance& output_buffer) {
+  ASSERT(initialized_);
+  process(nullptr, 0, BROTLI_OPERATION_FLUSH, output_buffer);
+}
+
+void BrotliCompressorImpl::finish(Buffer::Instance& output_buffer) {
+  ASSERT(initialized_);
+  process(nullptr, 0, BROTLI_OPERATION_FINISH, output_buffer);
+}
+
+void BrotliCompressorImpl::reset() {
+  ASSERT(initialized_);
+  // Brotli has no way to reuse an encoder for a new stream, so start over with a new one.
+  createEncoder();
+}
+
+void BrotliCompressorImpl::process(const uint8_t* input, size_t length,
+                                   BrotliEncoderOperation operation,
+                                   Buffer::Instance& output_buffer) {
+  size_t available_in = length;
+  const uint8_t* next_in = input;
+  do {
+    size_t available_out = chunk_size_;
+    uint8_t* next_out = chunk_ptr_.get();
+    const BROTLI_BOOL result =
+        BrotliEncoderCompressStream(state_ptr_.get(), operation, &available_in, &next_in,
+                                    &available_out, &next_out, nullptr);
+    RELEASE_ASSERT(result == BROTLI_TRUE);
+
+    const uint64_t n_output = chunk_size_ - available_out;
+    if (n_output > 0) {
+      output_buffer.add(static_cast<void*>(chunk_ptr_.get()), n_output);
+    }
+  } while (available_in > 0 || BrotliEncoderHasMoreOutput(state_ptr_.get()));
+}
+
+} // namespace Compressor
+} // namespace Envoy
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+
+#include "envoy/compressor/compressor.h"
+
+#include "brotli/encode.h"
+
+namespace Envoy {
+namespace Compressor {
+
+/**
+ * Implementation of compressor's interface that writes Brotli streams. @see RFC 7932
+ */
+class BrotliCompressorImpl : public Compressor {
+public:
+  BrotliCompressorImpl();
+
+  /**
+   * Constructor that allows setting the size of compressor's output buffer.
+   * @param chunk_size amount of memory reserved for the compressor output.
+   */
+  BrotliCompressorImpl(uint64_t chunk_size);
+
+  /**
+   * Init must be called in order to initialize the compressor. Once compressor is initialized, it
+   * cannot be initialized again. Init should run before compressing any data.
+   * @param quality sets the compression level, from 0 (fastest) to 11 (smallest output).
+   * @param window_bits sets the base 2 logarithm of the sliding window size, from 10 to 24. Larger
+   * values result in better compression, but use more memory on both ends.
+   */
+  void init(uint32_t quality, uint32_t window_bits);
+
+  // Compressor
+  void compress(const Buffer::Instance& input_buffer, Buffer::Instance& output_buffer) override;
+  void flush(Buffer::Instance& output_buffer) override;
+  void finish(Buffer::Instance& output_buffer) override;
+  void reset() override;
+
+private:
+  void createEncoder();
+  void process(const uint8_t* input, size_t length, BrotliEncoderOperation operation,
+               Buffer::Instance& output_buffer);
+
+  const uint64_t chunk_size_;
+  bool initialized_;
+  uint32_t quality_;
+  uint32_t window_bits_;
+
+  std::unique_ptr<uint8_t[]> chunk_ptr_;
+  std::unique_ptr<BrotliEncoderState, std::function<void(BrotliEncoderState*)>> state_ptr_;
+};
+
+} // namespace Compressor
+} // namespace Envoy
@@ -24,17 +24,49 @@ ZlibCompressorImpl::ZlibCompressorImpl(uint64_t chunk_size)
 
 void ZlibCompressorImpl::init(CompressionLevel comp_level, CompressionStrategy comp_strategy,
                               int64_t window_bits, uint64_t memory_level = 8) {
+  init(comp_level, comp_strategy, window_bits, memory_level, "");
+}
+
+void ZlibCompressorImpl::init(CompressionLevel comp_level, CompressionStrategy comp_strategy,
+                              int64_t window_bits, uint64_t memory_level,
+                              const std::string& dictionary) {
   ASSERT(initialized_ == false);
   const int result = deflateInit2(zstream_ptr_.get(), static_cast<int64_t>(comp_level), Z_DEFLATED,
                                   window_bits, memory_level, static_cast<uint64_t>(comp_strategy));
   RELEASE_ASSERT(result >= 0);
+  dictionary_ = dictionary;
+  setDictionary();
   initialized_ = true;
 }
 
+void ZlibCompressorImpl::setDictionary() {
+  if (dictionary_.empty()) {
+    return;
+  }
+
+  const int result = deflateSetDictionary(
+      zstream_ptr_.get(), reinterpret_cast<const Bytef*>(dictionary_.data()), dictionary_.size());
+  RELEASE_ASSERT(result == Z_OK);
+}
+
 void ZlibCompressorImpl::flush(Buffer::Instance& output_buffer) {
   process(output_buffer, Z_SYNC_FLUSH);
 }
 
+void ZlibCompressorImpl::finish(Buffer::Instance& output_buffer) {
+  process(output_buffer, Z_FINISH);
+}
+
+void ZlibCompressorImpl::reset() {
+  ASSERT(initialized_);
+  const int result = deflateReset(zstream_ptr_.get());
+  RELEASE_ASSERT(result == Z_OK);
+  // Resetting drops the dictionary, so every stream has to be primed again.
+  setDictionary();
+  zstream_ptr_->avail_out = chunk_size_;
+  zstream_ptr_->next_out = chunk_char_ptr_.get();
+}
+
 uint64_t ZlibCompressorImpl::checksum() { return zstream_ptr_->adler; }
 
 void ZlibCompressorImpl::compress(const Buffer::Instance& input_buffer,
@@ -55,6 +87,9 @@ bool ZlibCompressorImpl::deflateNext(int64_t flush_state) {
   if (result == Z_BUF_ERROR && zstream_ptr_->avail_in == 0) {
     return false; // This means that zlib needs more input, so stop here.
   }
+  if (result == Z_STREAM_END) {
+    return false; // The stream was finished and all of its output has been produced.
+  }
 
   RELEASE_ASSERT(result == Z_OK);
   return true;
@@ -67,7 +102,7 @@ void ZlibCompressorImpl::process(Buffer::Instance& output_buffer, int64_t flush_
     }
   }
 
-  if (flush_state == Z_SYNC_FLUSH) {
+  if (flush_state == Z_SYNC_FLUSH || flush_state == Z_FINISH) {
     updateOutput(output_buffer);
   }
 }
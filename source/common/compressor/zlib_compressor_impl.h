@@ -1,5 +1,7 @@
 #pragma once
 
+#include <string>
+
 #include "envoy/compressor/compressor.h"
 
 #include "zlib.h"
@@ -64,13 +66,16 @@ public:
             uint64_t memory_level);
 
   /**
-   * Flush should be called when no more data needs to be compressed. It will compress
-   * any remaining input available in the compressor and flush the compressed data to the output
-   * buffer. Note that forcing flush frequently degrades the compression ratio, so this should only
-   * be called when necessary.
-   * @param output_buffer supplies the buffer to output compressed data.
+   * Like init() above, but primes every stream with a preset dictionary. Deflate can then encode
+   * the start of a stream as references into the dictionary, which makes a large difference for
+   * short inputs that share most of their strings, e.g. small JSON documents with the same keys.
+   * The decompressor has to be given the same dictionary. Only zlib (window_bits 8 to 15) and raw
+   * deflate (window_bits -8 to -15) streams can use a dictionary; gzip streams cannot.
+   * @param dictionary supplies the dictionary. The strings most likely to occur should be at its
+   * end. Only the last 2^window_bits bytes are used.
    */
-  void flush(Buffer::Instance& output_buffer);
+  void init(CompressionLevel level, CompressionStrategy strategy, int64_t window_bits,
+            uint64_t memory_level, const std::string& dictionary);
 
   /**
    * It returns the checksum of all output produced so far. Compressor's checksum at the end of the
@@ -82,14 +87,19 @@ public:
 
   // Compressor
   void compress(const Buffer::Instance& input_buffer, Buffer::Instance& output_buffer) override;
+  void flush(Buffer::Instance& output_buffer) override;
+  void finish(Buffer::Instance& output_buffer) override;
+  void reset() override;
 
 private:
   bool deflateNext(int64_t flush_state);
   void process(Buffer::Instance& output_buffer, int64_t flush_state);
   void updateOutput(Buffer::Instance& output_buffer);
+  void setDictionary();
 
   const uint64_t chunk_size_;
   bool initialized_;
+  std::string dictionary_;
 
   std::unique_ptr<unsigned char[]> chunk_char_ptr_;
   std::unique_ptr<z_stream, std::function<void(z_stream*)>> zstream_ptr_;
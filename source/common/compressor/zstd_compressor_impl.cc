@@ -0,0 +1,86 @@
+#include "common/compressor/zstd_compressor_impl.h"
+
+#include "common/common/assert.h"
+
+namespace Envoy {
+namespace Compressor {
+
+ZstdCompressorImpl::ZstdCompressorImpl() : ZstdCompressorImpl(4096) {}
+
+ZstdCompressorImpl::ZstdCompressorImpl(uint64_t chunk_size)
+    : chunk_size_{chunk_size}, initialized_{false}, level_{0}, chunk_ptr_(new uint8_t[chunk_size]),
+      stream_ptr_(ZSTD_createCStream(), [](ZSTD_CStream* stream) { ZSTD_freeCStream(stream); }) {
+  RELEASE_ASSERT(stream_ptr_ != nullptr);
+}
+
+void ZstdCompressorImpl::init(int level) {
+  ASSERT(initialized_ == false);
+  RELEASE_ASSERT(level >= 1 && level <= ZSTD_maxCLevel());
+  level_ = level;
+  const size_t result = ZSTD_initCStream(stream_ptr_.get(), level_);
+  RELEASE_ASSERT(!ZSTD_isError(result));
+  initialized_ = true;
+}
+
+void ZstdCompressorImpl::compress(const Buffer::Instance& input_buffer,
+                                  Buffer::Instance& output_buffer) {
+  ASSERT(initialized_);
+  const uint64_t num_slices = input_buffer.getRawSlices(nullptr, 0);
+  Buffer::RawSlice slices[num_slices];
+  input_buffer.getRawSlices(slices, num_slices);
+
+  ZSTD_outBuffer output{chunk_ptr_.get(), chunk_size_, 0};
+  for (const Buffer::RawSlice& input_slice : slices) {
+    ZSTD_inBuffer input{input_slice.mem_, input_slice.len_, 0};
+    while (input.pos < input.size) {
+      const size_t result = ZSTD_compressStream(stream_ptr_.get(), &output, &input);
+      RELEASE_ASSERT(!ZSTD_isError(result));
+      if (output.pos == output.size) {
+        updateOutput(output, output_buffer);
+      }
+    }
+  }
+  updateOutput(output, output_buffer);
+}
+
+void ZstdCompressorImpl::flush(Buffer::Instance& output_buffer) {
+  ASSERT(initialized_);
+  drain(output_buffer, [this](ZSTD_outBuffer* output) -> size_t {
+    return ZSTD_flushStream(stream_ptr_.get(), output);
+  });
+}
+
+void ZstdCompressorImpl::finish(Buffer::Instance& output_buffer) {
+  ASSERT(initialized_);
+  drain(output_buffer, [this](ZSTD_outBuffer* output) -> size_t {
+    return ZSTD_endStream(stream_ptr_.get(), output);
+  });
+}
+
+void ZstdCompressorImpl::reset() {
+  ASSERT(initialized_);
+  // Initializing a stream again starts a new frame, and keeps the memory the stream allocated.
+  const size_t result = ZSTD_initCStream(stream_ptr_.get(), level_);
+  RELEASE_ASSERT(!ZSTD_isError(result));
+}
+
+void ZstdCompressorImpl::drain(Buffer::Instance& output_buffer,
+                               std::function<size_t(ZSTD_outBuffer*)> step) {
+  size_t remaining;
+  do {
+    ZSTD_outBuffer output{chunk_ptr_.get(), chunk_size_, 0};
+    remaining = step(&output);
+    RELEASE_ASSERT(!ZSTD_isError(remaining));
+    updateOutput(output, output_buffer);
+  } while (remaining > 0);
+}
+
+void ZstdCompressorImpl::updateOutput(ZSTD_outBuffer& output, Buffer::Instance& output_buffer) {
+  if (output.pos > 0) {
+    output_buffer.add(output.dst, output.pos);
+  }
+  output.pos = 0;
+}
+
+} // namespace Compressor
+} // namespace Envoy
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+
+#include "envoy/compressor/compressor.h"
+
+#include "zstd.h"
+
+namespace Envoy {
+namespace Compressor {
+
+/**
+ * Implementation of compressor's interface that writes Zstandard frames. @see RFC 8478
+ */
+class ZstdCompressorImpl : public Compressor {
+public:
+  ZstdCompressorImpl();
+
+  /**
+   * Constructor that allows setting the size of compressor's output buffer. zstd suggests
+   * ZSTD_CStreamOutSize(), about 128K, as a size that always fits a whole compressed block.
+   * @param chunk_size amount of memory reserved for the compressor output.
+   */
+  ZstdCompressorImpl(uint64_t chunk_size);
+
+  /**
+   * Init must be called in order to initialize the compressor. Once compressor is initialized, it
+   * cannot be initialized again. Init should run before compressing any data.
+   * @param level sets the compression level, from 1 (fastest) to ZSTD_maxCLevel() (smallest
+   * output). 3 is zstd's default.
+   */
+  void init(int level);
+
+  // Compressor
+  void compress(const Buffer::Instance& input_buffer, Buffer::Instance& output_buffer) override;
+  void flush(Buffer::Instance& output_buffer) override;
+  void finish(Buffer::Instance& output_buffer) override;
+  void reset() override;
+
+private:
+  /**
+   * Drain the stream with ZSTD_flushStream() or ZSTD_endStream() until it has no output left.
+   */
+  void drain(Buffer::Instance& output_buffer, std::function<size_t(ZSTD_outBuffer*)> step);
+  void updateOutput(ZSTD_outBuffer& output, Buffer::Instance& output_buffer);
+
+  const uint64_t chunk_size_;
+  bool initialized_;
+  int level_;
+
+  std::unique_ptr<uint8_t[]> chunk_ptr_;
+  std::unique_ptr<ZSTD_CStream, std::function<void(ZSTD_CStream*)>> stream_ptr_;
+};
+
+} // namespace Compressor
+} // namespace Envoy
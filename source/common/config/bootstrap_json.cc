@@ -1,6 +1,9 @@
 #include "common/config/bootstrap_json.h"
 
+#include <vector>
+
 #include "common/common/assert.h"
+#include "common/common/thread.h"
 #include "common/config/address_json.h"
 #include "common/config/cds_json.h"
 #include "common/config/json_utility.h"
@@ -14,7 +17,8 @@ namespace Envoy {
 namespace Config {
 
 void BootstrapJson::translateClusterManagerBootstrap(const Json::Object& json_cluster_manager,
-                                                     envoy::api::v2::Bootstrap& bootstrap) {
+                                                     envoy::api::v2::Bootstrap& bootstrap,
+                                                     uint32_t concurrency) {
   json_cluster_manager.validateSchema(Json::Schema::CLUSTER_MANAGER_SCHEMA);
 
   Optional<envoy::api::v2::ConfigSource> eds_config;
@@ -37,11 +41,19 @@ void BootstrapJson::translateClusterManagerBootstrap(const Json::Object& json_cl
         *json_cds, *bootstrap.mutable_dynamic_resources()->mutable_cds_config());
   }
 
-  for (const Json::ObjectSharedPtr& json_cluster :
-       json_cluster_manager.getObjectArray("clusters")) {
-    auto* cluster = bootstrap.mutable_static_resources()->mutable_clusters()->Add();
-    Config::CdsJson::translateCluster(*json_cluster, eds_config, *cluster);
+  // Schema validation dominates the translation of large configs, so the clusters are translated
+  // in parallel into messages that are added up front.
+  const std::vector<Json::ObjectSharedPtr> json_clusters =
+      json_cluster_manager.getObjectArray("clusters");
+  auto* clusters = bootstrap.mutable_static_resources()->mutable_clusters();
+  const int first_cluster = clusters->size();
+  for (size_t i = 0; i < json_clusters.size(); i++) {
+    clusters->Add();
   }
+  Thread::parallelFor(json_clusters.size(), concurrency, [&](size_t i) -> void {
+    Config::CdsJson::translateCluster(*json_clusters[i], eds_config,
+                                      *clusters->Mutable(first_cluster + i));
+  });
 
   auto* cluster_manager = bootstrap.mutable_cluster_manager();
   JSON_UTIL_SET_STRING(json_cluster_manager, *cluster_manager, local_cluster_name);
@@ -52,20 +64,27 @@ void BootstrapJson::translateClusterManagerBootstrap(const Json::Object& json_cl
 }
 
 void BootstrapJson::translateBootstrap(const Json::Object& json_config,
-                                       envoy::api::v2::Bootstrap& bootstrap) {
+                                       envoy::api::v2::Bootstrap& bootstrap,
+                                       uint32_t concurrency) {
   json_config.validateSchema(Json::Schema::TOP_LEVEL_CONFIG_SCHEMA);
 
-  translateClusterManagerBootstrap(*json_config.getObject("cluster_manager"), bootstrap);
+  translateClusterManagerBootstrap(*json_config.getObject("cluster_manager"), bootstrap,
+                                   concurrency);
 
   if (json_config.hasObject("lds")) {
     auto* lds_config = bootstrap.mutable_dynamic_resources()->mutable_lds_config();
     Config::Utility::translateLdsConfig(*json_config.getObject("lds"), *lds_config);
   }
 
-  for (const auto json_listener : json_config.getObjectArray("listeners")) {
-    auto* listener = bootstrap.mutable_static_resources()->mutable_listeners()->Add();
-    Config::LdsJson::translateListener(*json_listener, *listener);
+  const std::vector<Json::ObjectSharedPtr> json_listeners = json_config.getObjectArray("listeners");
+  auto* listeners = bootstrap.mutable_static_resources()->mutable_listeners();
+  const int first_listener = listeners->size();
+  for (size_t i = 0; i < json_listeners.size(); i++) {
+    listeners->Add();
   }
+  Thread::parallelFor(json_listeners.size(), concurrency, [&](size_t i) -> void {
+    Config::LdsJson::translateListener(*json_listeners[i], *listeners->Mutable(first_listener + i));
+  });
 
   JSON_UTIL_SET_STRING(json_config, bootstrap, flags_path);
 
@@ -13,17 +13,21 @@ public:
    * Translate a v1 JSON cluster manager object to v2 envoy::api::v2::Bootstrap.
    * @param json_cluster_manager source v1 JSON cluster manager object.
    * @param bootstrap destination v2 envoy::api::v2::Bootstrap.
+   * @param concurrency supplies the number of threads to validate and translate clusters on.
    */
   static void translateClusterManagerBootstrap(const Json::Object& json_cluster_manager,
-                                               envoy::api::v2::Bootstrap& bootstrap);
+                                               envoy::api::v2::Bootstrap& bootstrap,
+                                               uint32_t concurrency = 1);
 
   /**
    * Translate a v1 JSON static config object to v2 envoy::api::v2::Bootstrap.
    * @param json_config source v1 JSON static config object.
    * @param bootstrap destination v2 envoy::api::v2::Bootstrap.
+   * @param concurrency supplies the number of threads to validate and translate clusters and
+   *        listeners on.
    */
   static void translateBootstrap(const Json::Object& json_config,
-                                 envoy::api::v2::Bootstrap& bootstrap);
+                                 envoy::api::v2::Bootstrap& bootstrap, uint32_t concurrency = 1);
 };
 
 } // namespace Config
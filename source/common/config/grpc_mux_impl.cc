@@ -161,29 +161,36 @@ void GrpcMuxImpl::onReceiveMessage(std::unique_ptr<envoy::api::v2::DiscoveryResp
     return;
   }
   try {
-    // To avoid O(n^2) explosion (e.g. when we have 1000s of EDS watches), we
-    // build a map here from resource name to resource and then walk watches_.
-    // We have to walk all watches (and need an efficient map as a result) to
-    // ensure we deliver empty config updates when a resource is dropped.
-    std::unordered_map<std::string, ProtobufWkt::Any> resources;
     for (const auto& resource : message->resources()) {
       if (type_url != resource.type_url()) {
         throw EnvoyException(fmt::format("{} does not match {} type URL is DiscoveryResponse {}",
                                          resource.type_url(), type_url, message->DebugString()));
       }
-      const std::string resource_name = Utility::resourceName(resource);
-      resources.emplace(resource_name, resource);
     }
+    // To avoid O(n^2) explosion (e.g. when we have 1000s of EDS watches), we
+    // build a map here from resource name to resource and then walk watches_.
+    // We have to walk all watches (and need an efficient map as a result) to
+    // ensure we deliver empty config updates when a resource is dropped. Getting
+    // a resource name means parsing the resource, so the map is only built once
+    // a watch asks for named resources, which wildcard (e.g. CDS) watches don't.
+    std::unordered_map<std::string, const ProtobufWkt::Any*> resources;
+    bool resources_indexed = false;
     for (auto watch : api_state_[type_url].watches_) {
       if (watch->resources_.empty()) {
         watch->callbacks_.onConfigUpdate(message->resources(), message->version_info());
         continue;
       }
+      if (!resources_indexed) {
+        for (const auto& resource : message->resources()) {
+          resources.emplace(Utility::resourceName(resource), &resource);
+        }
+        resources_indexed = true;
+      }
       Protobuf::RepeatedPtrField<ProtobufWkt::Any> found_resources;
       for (auto watched_resource_name : watch->resources_) {
         auto it = resources.find(watched_resource_name);
         if (it != resources.end()) {
-          found_resources.Add()->MergeFrom(it->second);
+          found_resources.Add()->MergeFrom(*it->second);
         }
       }
       watch->callbacks_.onConfigUpdate(found_resources, message->version_info());
@@ -4,6 +4,7 @@
 #include "envoy/config/subscription.h"
 
 #include "common/common/assert.h"
+#include "common/common/hash.h"
 #include "common/common/logger.h"
 #include "common/grpc/common.h"
 #include "common/protobuf/protobuf.h"
@@ -47,11 +48,29 @@ public:
   // Config::GrpcMuxCallbacks
   void onConfigUpdate(const Protobuf::RepeatedPtrField<ProtobufWkt::Any>& resources,
                       const std::string& version_info) override {
+    // Every update resends all resources, even if only one of them changed. When none of the
+    // resources of this subscription changed since the last accepted update, skip parsing them and
+    // applying them again.
+    uint64_t resources_hash = 0;
+    for (const auto& resource : resources) {
+      resources_hash = HashUtil::xxHash64(resource.value(), resources_hash);
+    }
+    if (resources_hash_.valid() && resources_hash_.value() == resources_hash) {
+      stats_.update_success_.inc();
+      stats_.update_attempt_.inc();
+      version_info_ = version_info;
+      stats_.version_.set(HashUtil::xxHash64(version_info_));
+      ENVOY_LOG(debug, "gRPC config for {} accepted with {} unchanged resources", type_url_,
+                resources.size());
+      return;
+    }
+
     Protobuf::RepeatedPtrField<ResourceType> typed_resources;
     std::transform(resources.cbegin(), resources.cend(),
                    Protobuf::RepeatedPtrFieldBackInserter(&typed_resources),
                    MessageUtil::anyConvert<ResourceType>);
     callbacks_->onConfigUpdate(typed_resources);
+    resources_hash_.value(resources_hash);
     stats_.update_success_.inc();
     stats_.update_attempt_.inc();
     version_info_ = version_info;
@@ -80,6 +99,8 @@ private:
   SubscriptionCallbacks<ResourceType>* callbacks_{};
   GrpcMuxWatchPtr watch_{};
   std::string version_info_;
+  // Hash of the resources of the last accepted update.
+  Optional<uint64_t> resources_hash_;
 };
 
 } // namespace Config
@@ -93,6 +93,8 @@ typedef ConstSingleton<AddressResolverNameValues> AddressResolverNames;
  */
 class HttpFilterNameValues {
 public:
+  // Adaptive concurrency filter
+  const std::string ADAPTIVE_CONCURRENCY = "envoy.adaptive_concurrency";
   // Buffer filter
   const std::string BUFFER = "envoy.buffer";
   // CORS filter
@@ -107,12 +109,16 @@ public:
   const std::string GRPC_JSON_TRANSCODER = "envoy.grpc_json_transcoder";
   // GRPC web filter
   const std::string GRPC_WEB = "envoy.grpc_web";
+  // Gzip filter
+  const std::string GZIP = "envoy.gzip";
   // IP tagging filter
   const std::string IP_TAGGING = "envoy.ip_tagging";
   // Rate limit filter
   const std::string RATE_LIMIT = "envoy.rate_limit";
   // Router filter
   const std::string ROUTER = "envoy.router";
+  // HTTP cache filter
+  const std::string HTTP_CACHE = "envoy.http_cache";
   // Health checking filter
   const std::string HEALTH_CHECK = "envoy.health_check";
   // Lua filter
@@ -163,6 +169,8 @@ class AccessLogNameValues {
 public:
   // File access log
   const std::string FILE = "envoy.file_access_log";
+  // Structured access log, written to a file or streamed over gRPC
+  const std::string STRUCTURED = "envoy.structured_access_log";
 };
 
 typedef ConstSingleton<AccessLogNameValues> AccessLogNames;
@@ -0,0 +1,43 @@
+#include "common/decompressor/brotli_decompressor_impl.h"
+
+#include "common/common/assert.h"
+
+namespace Envoy {
+namespace Decompressor {
+
+BrotliDecompressorImpl::BrotliDecompressorImpl() : BrotliDecompressorImpl(4096) {}
+
+BrotliDecompressorImpl::BrotliDecompressorImpl(uint64_t chunk_size)
+    : chunk_size_{chunk_size}, chunk_ptr_(new uint8_t[chunk_size]),
+      state_ptr_(BrotliDecoderCreateInstance(nullptr, nullptr, nullptr),
+                 [](BrotliDecoderState* state) { BrotliDecoderDestroyInstance(state); }) {
+  RELEASE_ASSERT(state_ptr_ != nullptr);
+}
+
+void BrotliDecompressorImpl::decompress(const Buffer::Instance& input_buffer,
+                                        Buffer::Instance& output_buffer) {
+  const uint64_t num_slices = input_buffer.getRawSlices(nullptr, 0);
+  Buffer::RawSlice slices[num_slices];
+  input_buffer.getRawSlices(slices, num_slices);
+
+  for (const Buffer::RawSlice& input_slice : slices) {
+    size_t available_in = input_slice.len_;
+    const uint8_t* next_in = static_cast<const uint8_t*>(input_slice.mem_);
+    BrotliDecoderResult result;
+    do {
+      size_t available_out = chunk_size_;
+      uint8_t* next_out = chunk_ptr_.get();
+      result = BrotliDecoderDecompressStream(state_ptr_.get(), &available_in, &next_in,
+                                             &available_out, &next_out, nullptr);
+      RELEASE_ASSERT(result != BROTLI_DECODER_RESULT_ERROR);
+
+      const uint64_t n_output = chunk_size_ - available_out;
+      if (n_output > 0) {
+        output_buffer.add(static_cast<void*>(chunk_ptr_.get()), n_output);
+      }
+    } while (result == BROTLI_DECODER_RESULT_NEEDS_MORE_OUTPUT);
+  }
+}
+
+} // namespace Decompressor
+} // namespace Envoy
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+
+#include "envoy/decompressor/decompressor.h"
+
+#include "brotli/decode.h"
+
+namespace Envoy {
+namespace Decompressor {
+
+/**
+ * Implementation of decompressor's interface that reads Brotli streams. @see RFC 7932
+ */
+class BrotliDecompressorImpl : public Decompressor {
+public:
+  BrotliDecompressorImpl();
+
+  /**
+   * Constructor that allows setting the size of decompressor's output buffer.
+   * @param chunk_size amount of memory reserved for the decompressor output.
+   */
+  BrotliDecompressorImpl(uint64_t chunk_size);
+
+  // Decompressor
+  void decompress(const Buffer::Instance& input_buffer, Buffer::Instance& output_buffer) override;
+
+private:
+  const uint64_t chunk_size_;
+
+  std::unique_ptr<uint8_t[]> chunk_ptr_;
+  std::unique_ptr<BrotliDecoderState, std::function<void(BrotliDecoderState*)>> state_ptr_;
+};
+
+} // namespace Decompressor
+} // namespace Envoy
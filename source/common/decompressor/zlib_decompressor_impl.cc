@@ -22,13 +22,26 @@ ZlibDecompressorImpl::ZlibDecompressorImpl(uint64_t chunk_size)
   zstream_ptr_->next_out = chunk_char_ptr_.get();
 }
 
-void ZlibDecompressorImpl::init(int64_t window_bits) {
+void ZlibDecompressorImpl::init(int64_t window_bits) { init(window_bits, ""); }
+
+void ZlibDecompressorImpl::init(int64_t window_bits, const std::string& dictionary) {
   ASSERT(initialized_ == false);
   const int result = inflateInit2(zstream_ptr_.get(), window_bits);
   RELEASE_ASSERT(result >= 0);
+  dictionary_ = dictionary;
+  // A raw deflate stream does not ask for its dictionary, so it has to be set up front.
+  if (window_bits < 0 && !dictionary_.empty()) {
+    setDictionary();
+  }
   initialized_ = true;
 }
 
+void ZlibDecompressorImpl::setDictionary() {
+  const int result = inflateSetDictionary(
+      zstream_ptr_.get(), reinterpret_cast<const Bytef*>(dictionary_.data()), dictionary_.size());
+  RELEASE_ASSERT(result == Z_OK);
+}
+
 uint64_t ZlibDecompressorImpl::checksum() { return zstream_ptr_->adler; }
 
 void ZlibDecompressorImpl::decompress(const Buffer::Instance& input_buffer,
@@ -62,6 +75,13 @@ bool ZlibDecompressorImpl::inflateNext() {
   if (result == Z_BUF_ERROR && zstream_ptr_->avail_in == 0) {
     return false; // This means that zlib needs more input, so stop here.
   }
+  if (result == Z_STREAM_END) {
+    return false; // The end of a finished stream was reached.
+  }
+  if (result == Z_NEED_DICT && !dictionary_.empty()) {
+    setDictionary(); // A zlib stream asks for its dictionary after reading the header.
+    return true;
+  }
 
   RELEASE_ASSERT(result == Z_OK);
   return true;
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <string>
+
 #include "envoy/decompressor/decompressor.h"
 
 #include "zlib.h"
@@ -32,6 +34,13 @@ public:
    */
   void init(int64_t window_bits);
 
+  /**
+   * Like init() above, for streams that were compressed with a preset dictionary.
+   * @param dictionary supplies the dictionary the stream was compressed with. A zlib stream
+   * records the checksum of its dictionary, so decompressing it with another dictionary fails.
+   */
+  void init(int64_t window_bits, const std::string& dictionary);
+
   /**
    * It returns the checksum of all output produced so far. Decompressor's checksum at the end of
    * the stream has to match compressor's checksum produced at the end of the compression.
@@ -45,9 +54,11 @@ public:
 
 private:
   bool inflateNext();
+  void setDictionary();
 
   uint64_t chunk_size_;
   bool initialized_;
+  std::string dictionary_;
 
   std::unique_ptr<unsigned char[]> chunk_char_ptr_;
   std::unique_ptr<z_stream, std::function<void(z_stream*)>> zstream_ptr_;
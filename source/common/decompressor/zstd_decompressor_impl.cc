@@ -0,0 +1,40 @@
+#include "common/decompressor/zstd_decompressor_impl.h"
+
+#include "common/common/assert.h"
+
+namespace Envoy {
+namespace Decompressor {
+
+ZstdDecompressorImpl::ZstdDecompressorImpl() : ZstdDecompressorImpl(4096) {}
+
+ZstdDecompressorImpl::ZstdDecompressorImpl(uint64_t chunk_size)
+    : chunk_size_{chunk_size}, chunk_ptr_(new uint8_t[chunk_size]),
+      stream_ptr_(ZSTD_createDStream(), [](ZSTD_DStream* stream) { ZSTD_freeDStream(stream); }) {
+  RELEASE_ASSERT(stream_ptr_ != nullptr);
+  const size_t result = ZSTD_initDStream(stream_ptr_.get());
+  RELEASE_ASSERT(!ZSTD_isError(result));
+}
+
+void ZstdDecompressorImpl::decompress(const Buffer::Instance& input_buffer,
+                                      Buffer::Instance& output_buffer) {
+  const uint64_t num_slices = input_buffer.getRawSlices(nullptr, 0);
+  Buffer::RawSlice slices[num_slices];
+  input_buffer.getRawSlices(slices, num_slices);
+
+  for (const Buffer::RawSlice& input_slice : slices) {
+    ZSTD_inBuffer input{input_slice.mem_, input_slice.len_, 0};
+    ZSTD_outBuffer output{chunk_ptr_.get(), chunk_size_, 0};
+    // A full output buffer may leave decoded data inside the stream even once all input is read.
+    do {
+      output.pos = 0;
+      const size_t result = ZSTD_decompressStream(stream_ptr_.get(), &output, &input);
+      RELEASE_ASSERT(!ZSTD_isError(result));
+      if (output.pos > 0) {
+        output_buffer.add(output.dst, output.pos);
+      }
+    } while (input.pos < input.size || output.pos == output.size);
+  }
+}
+
+} // namespace Decompressor
+} // namespace Envoy
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+
+#include "envoy/decompressor/decompressor.h"
+
+#include "zstd.h"
+
+namespace Envoy {
+namespace Decompressor {
+
+/**
+ * Implementation of decompressor's interface that reads Zstandard frames. @see RFC 8478
+ */
+class ZstdDecompressorImpl : public Decompressor {
+public:
+  ZstdDecompressorImpl();
+
+  /**
+   * Constructor that allows setting the size of decompressor's output buffer.
+   * @param chunk_size amount of memory reserved for the decompressor output.
+   */
+  ZstdDecompressorImpl(uint64_t chunk_size);
+
+  // Decompressor
+  void decompress(const Buffer::Instance& input_buffer, Buffer::Instance& output_buffer) override;
+
+private:
+  const uint64_t chunk_size_;
+
+  std::unique_ptr<uint8_t[]> chunk_ptr_;
+  std::unique_ptr<ZSTD_DStream, std::function<void(ZSTD_DStream*)>> stream_ptr_;
+};
+
+} // namespace Decompressor
+} // namespace Envoy
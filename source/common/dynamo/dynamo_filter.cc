@@ -12,7 +12,6 @@
 #include "common/http/codes.h"
 #include "common/http/exception.h"
 #include "common/http/utility.h"
-#include "common/json/json_loader.h"
 
 #include "fmt/format.h"
 
@@ -52,11 +51,10 @@ Http::FilterTrailersStatus DynamoFilter::decodeTrailers(Http::HeaderMap&) {
 }
 
 void DynamoFilter::onDecodeComplete(const Buffer::Instance& data) {
-  std::string body = buildBody(decoder_callbacks_->decodingBuffer(), data);
+  std::vector<Buffer::RawSlice> body = bodySlices(decoder_callbacks_->decodingBuffer(), data);
   if (!body.empty()) {
     try {
-      Json::ObjectSharedPtr json_body = Json::Factory::loadFromString(body);
-      table_descriptor_ = RequestParser::parseTable(operation_, *json_body);
+      table_descriptor_ = RequestParser::parseTable(operation_, body);
     } catch (const Json::Exception& jsonEx) {
       // Body parsing failed. This should not happen, just put a stat for that.
       scope_.counter(fmt::format("{}invalid_req_body", stat_prefix_)).inc();
@@ -69,21 +67,35 @@ void DynamoFilter::onEncodeComplete(const Buffer::Instance& data) {
   uint64_t status = Http::Utility::getResponseStatus(*response_headers_);
   chargeBasicStats(status);
 
-  std::string body = buildBody(encoder_callbacks_->encodingBuffer(), data);
+  std::vector<Buffer::RawSlice> body = bodySlices(encoder_callbacks_->encodingBuffer(), data);
   if (!body.empty()) {
-    try {
-      Json::ObjectSharedPtr json_body = Json::Factory::loadFromString(body);
-      chargeTablePartitionIdStats(*json_body);
+    // Only extract the fields that stats will be charged for, so that parsing stops as early as
+    // possible.
+    uint32_t fields = 0;
+    if (!table_descriptor_.table_name.empty() && !operation_.empty()) {
+      fields |= RequestParser::Partitions;
+    }
+    if (Http::CodeUtility::is4xx(status)) {
+      fields |= RequestParser::ErrorType;
+    }
+    // Batch Operations will always return status 200 for a partial or full success. Check
+    // unprocessed keys to determine partial success.
+    // http://docs.aws.amazon.com/amazondynamodb/latest/developerguide/Programming.Errors.html#Programming.Errors.BatchOperations
+    if (RequestParser::isBatchOperation(operation_)) {
+      fields |= RequestParser::UnprocessedKeys;
+    }
+    if (fields == 0) {
+      return;
+    }
 
-      if (Http::CodeUtility::is4xx(status)) {
-        chargeFailureSpecificStats(*json_body);
-      }
-      // Batch Operations will always return status 200 for a partial or full success. Check
-      // unprocessed keys to determine partial success.
-      // http://docs.aws.amazon.com/amazondynamodb/latest/developerguide/Programming.Errors.html#Programming.Errors.BatchOperations
-      if (RequestParser::isBatchOperation(operation_)) {
-        chargeUnProcessedKeysStats(*json_body);
+    try {
+      const RequestParser::ResponseDescriptor response =
+          RequestParser::parseResponse(body, fields);
+      chargeTablePartitionIdStats(response.partitions_);
+      if (fields & RequestParser::ErrorType) {
+        chargeFailureSpecificStats(response.error_type_);
       }
+      chargeUnProcessedKeysStats(response.unprocessed_tables_);
     } catch (const Json::Exception&) {
       // Body parsing failed. This should not happen, just put a stat for that.
       scope_.counter(fmt::format("{}invalid_resp_body", stat_prefix_)).inc();
@@ -129,26 +141,25 @@ Http::FilterTrailersStatus DynamoFilter::encodeTrailers(Http::HeaderMap&) {
   return Http::FilterTrailersStatus::Continue;
 }
 
-std::string DynamoFilter::buildBody(const Buffer::Instance* buffered,
-                                    const Buffer::Instance& last) {
-  std::string body;
-  if (buffered) {
-    uint64_t num_slices = buffered->getRawSlices(nullptr, 0);
-    Buffer::RawSlice slices[num_slices];
-    buffered->getRawSlices(slices, num_slices);
-    for (Buffer::RawSlice& slice : slices) {
-      body.append(static_cast<const char*>(slice.mem_), slice.len_);
+std::vector<Buffer::RawSlice> DynamoFilter::bodySlices(const Buffer::Instance* buffered,
+                                                      const Buffer::Instance& last) {
+  std::vector<Buffer::RawSlice> slices;
+  for (const Buffer::Instance* data : {buffered, &last}) {
+    if (data != nullptr) {
+      const uint64_t num_slices = data->getRawSlices(nullptr, 0);
+      const size_t offset = slices.size();
+      slices.resize(offset + num_slices);
+      data->getRawSlices(slices.data() + offset, num_slices);
     }
   }
 
-  uint64_t num_slices = last.getRawSlices(nullptr, 0);
-  Buffer::RawSlice slices[num_slices];
-  last.getRawSlices(slices, num_slices);
-  for (Buffer::RawSlice& slice : slices) {
-    body.append(static_cast<const char*>(slice.mem_), slice.len_);
+  // An empty body is not parsed at all.
+  for (const Buffer::RawSlice& slice : slices) {
+    if (slice.len_ > 0) {
+      return slices;
+    }
   }
-
-  return body;
+  return {};
 }
 
 void DynamoFilter::chargeBasicStats(uint64_t status) {
@@ -197,10 +208,10 @@ void DynamoFilter::chargeStatsPerEntity(const std::string& entity, const std::st
       .recordValue(latency.count());
 }
 
-void DynamoFilter::chargeUnProcessedKeysStats(const Json::Object& json_body) {
+void DynamoFilter::chargeUnProcessedKeysStats(
+    const std::vector<std::string>& unprocessed_tables) {
   // The unprocessed keys block contains a list of tables and keys for that table that did not
   // complete apart of the batch operation. Only the table names will be logged for errors.
-  std::vector<std::string> unprocessed_tables = RequestParser::parseBatchUnProcessedKeys(json_body);
   for (const std::string& unprocessed_table : unprocessed_tables) {
     scope_
         .counter(
@@ -209,9 +220,7 @@ void DynamoFilter::chargeUnProcessedKeysStats(const Json::Object& json_body) {
   }
 }
 
-void DynamoFilter::chargeFailureSpecificStats(const Json::Object& json_body) {
-  std::string error_type = RequestParser::parseErrorType(json_body);
-
+void DynamoFilter::chargeFailureSpecificStats(const std::string& error_type) {
   if (!error_type.empty()) {
     if (table_descriptor_.table_name.empty()) {
       scope_.counter(fmt::format("{}error.no_table.{}", stat_prefix_, error_type)).inc();
@@ -226,13 +235,8 @@ void DynamoFilter::chargeFailureSpecificStats(const Json::Object& json_body) {
   }
 }
 
-void DynamoFilter::chargeTablePartitionIdStats(const Json::Object& json_body) {
-  if (table_descriptor_.table_name.empty() || operation_.empty()) {
-    return;
-  }
-
-  std::vector<RequestParser::PartitionDescriptor> partitions =
-      RequestParser::parsePartitions(json_body);
+void DynamoFilter::chargeTablePartitionIdStats(
+    const std::vector<RequestParser::PartitionDescriptor>& partitions) {
   for (const RequestParser::PartitionDescriptor& partition : partitions) {
     std::string scope_string = Utility::buildPartitionStatString(
         stat_prefix_, table_descriptor_.table_name, operation_, partition.partition_id_);
@@ -3,10 +3,18 @@
 #include <cmath>
 #include <cstdint>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "envoy/json/json_object.h"
+
+#include "common/common/assert.h"
 #include "common/common/utility.h"
 
+#include "fmt/format.h"
+#include "rapidjson/error/en.h"
+#include "rapidjson/reader.h"
+
 namespace Envoy {
 namespace Dynamo {
 
@@ -65,56 +73,267 @@ std::string RequestParser::parseOperation(const Http::HeaderMap& headerMap) {
   return operation;
 }
 
-RequestParser::TableDescriptor RequestParser::parseTable(const std::string& operation,
-                                                         const Json::Object& json_data) {
-  TableDescriptor table{"", true};
+namespace {
 
-  // Simple operations on a single table, have "TableName" explicitly specified.
-  if (find(SINGLE_TABLE_OPERATIONS.begin(), SINGLE_TABLE_OPERATIONS.end(), operation) !=
-      SINGLE_TABLE_OPERATIONS.end()) {
-    table.table_name = json_data.getString("TableName", "");
-  } else if (find(BATCH_OPERATIONS.begin(), BATCH_OPERATIONS.end(), operation) !=
-             BATCH_OPERATIONS.end()) {
-    Json::ObjectSharedPtr tables = json_data.getObject("RequestItems", true);
-    tables->iterate([&table](const std::string& key, const Json::Object&) {
-      if (table.table_name.empty()) {
-        table.table_name = key;
-      } else {
-        if (table.table_name != key) {
-          table.table_name = "";
-          table.is_single_table = false;
-          return false;
-        }
+/**
+ * rapidjson input stream over the slices of a body, which saves copying the body into a contiguous
+ * string before parsing it.
+ */
+class SliceStream {
+public:
+  typedef char Ch;
+
+  SliceStream(const std::vector<Buffer::RawSlice>& slices) : slices_(slices) { skipEmptySlices(); }
+
+  Ch Peek() const {
+    return slice_ < slices_.size() ? static_cast<const Ch*>(slices_[slice_].mem_)[offset_] : '\0';
+  }
+
+  Ch Take() {
+    const Ch c = Peek();
+    if (slice_ < slices_.size()) {
+      tell_++;
+      if (++offset_ == slices_[slice_].len_) {
+        slice_++;
+        offset_ = 0;
+        skipEmptySlices();
       }
-      return true;
-    });
+    }
+    return c;
   }
 
-  return table;
-}
-std::vector<std::string> RequestParser::parseBatchUnProcessedKeys(const Json::Object& json_data) {
-  std::vector<std::string> unprocessed_tables;
-  Json::ObjectSharedPtr tables = json_data.getObject("UnprocessedKeys", true);
-  tables->iterate([&unprocessed_tables](const std::string& key, const Json::Object&) {
-    unprocessed_tables.emplace_back(key);
-    return true;
-  });
-
-  return unprocessed_tables;
+  size_t Tell() const { return tell_; }
+
+  // Only used by in situ parsing, which the body does not allow.
+  Ch* PutBegin() { NOT_REACHED; }
+  void Put(Ch) { NOT_REACHED; }
+  void Flush() { NOT_REACHED; }
+  size_t PutEnd(Ch*) { NOT_REACHED; }
+
+private:
+  void skipEmptySlices() {
+    while (slice_ < slices_.size() && slices_[slice_].len_ == 0) {
+      slice_++;
+    }
+  }
+
+  const std::vector<Buffer::RawSlice>& slices_;
+  size_t slice_{};
+  size_t offset_{};
+  size_t tell_{};
+};
+
+/**
+ * Base of the SAX handlers that extract fields out of a body. It keeps track of the keys of the
+ * objects that enclose the current value, up to MAX_DEPTH levels deep, and stops the parse once
+ * the derived handler has set finished_. Values that are nested deeper are parsed but not copied.
+ */
+class FieldExtractor : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, FieldExtractor> {
+public:
+  virtual ~FieldExtractor() {}
+
+  bool finished() const { return finished_; }
+
+  // rapidjson::BaseReaderHandler
+  bool StartObject() { return startContainer(); }
+  bool EndObject(rapidjson::SizeType) {
+    onEndObject();
+    return endContainer();
+  }
+  bool StartArray() { return startContainer(); }
+  bool EndArray(rapidjson::SizeType) { return endContainer(); }
+  bool Key(const char* value, rapidjson::SizeType size, bool) {
+    if (depth_ <= MAX_DEPTH) {
+      keys_[depth_ - 1].assign(value, size);
+      onKey();
+    }
+    return !finished_;
+  }
+  bool String(const char* value, rapidjson::SizeType size, bool) {
+    if (depth_ <= MAX_DEPTH) {
+      onString(value, size);
+    }
+    return !finished_;
+  }
+  bool Int(int value) { return number(value); }
+  bool Uint(unsigned value) { return number(value); }
+  bool Int64(int64_t value) { return number(value); }
+  bool Uint64(uint64_t value) { return number(value); }
+  bool Double(double value) { return number(value); }
+  bool Default() { return !finished_; }
+
+protected:
+  static const uint32_t MAX_DEPTH = 3;
+
+  /**
+   * @return whether the current value is at the given depth, with the given keys leading to it.
+   * Containers count as the depth of the values they hold.
+   */
+  bool at(uint32_t depth, const char* key1, const char* key2 = nullptr) const {
+    return depth_ == depth && keys_[0] == key1 && (key2 == nullptr || keys_[1] == key2);
+  }
+
+  // Called when a key, a string or a number is seen within MAX_DEPTH levels, and when an object
+  // ends, before depth_ is decreased.
+  virtual void onKey() {}
+  virtual void onString(const char*, rapidjson::SizeType) {}
+  virtual void onNumber(double) {}
+  virtual void onEndObject() {}
+
+  uint32_t depth_{};
+  std::string keys_[MAX_DEPTH];
+  bool finished_{};
+
+private:
+  bool startContainer() {
+    if (++depth_ <= MAX_DEPTH) {
+      keys_[depth_ - 1].clear();
+    }
+    return !finished_;
+  }
+
+  bool endContainer() {
+    depth_--;
+    return !finished_;
+  }
+
+  bool number(double value) {
+    if (depth_ <= MAX_DEPTH) {
+      onNumber(value);
+    }
+    return !finished_;
+  }
+};
+
+class TableExtractor : public FieldExtractor {
+public:
+  TableExtractor(bool batch) : batch_(batch) {}
+
+  RequestParser::TableDescriptor table_{"", true};
+
+private:
+  // FieldExtractor
+  void onKey() override {
+    // Every key of "RequestItems" is a table name.
+    if (batch_ && at(2, "RequestItems")) {
+      if (table_.table_name.empty()) {
+        table_.table_name = keys_[1];
+      } else if (table_.table_name != keys_[1]) {
+        table_.table_name = "";
+        table_.is_single_table = false;
+        finished_ = true;
+      }
+    }
+  }
+  void onString(const char* value, rapidjson::SizeType size) override {
+    if (!batch_ && at(1, "TableName")) {
+      table_.table_name.assign(value, size);
+      finished_ = true;
+    }
+  }
+  void onEndObject() override {
+    if (batch_ && at(2, "RequestItems")) {
+      finished_ = true;
+    }
+  }
+
+  const bool batch_;
+};
+
+class ResponseExtractor : public FieldExtractor {
+public:
+  ResponseExtractor(uint32_t fields) : pending_(fields) {}
+
+  RequestParser::ResponseDescriptor response_;
+
+private:
+  void done(uint32_t field) {
+    pending_ &= ~field;
+    finished_ = pending_ == 0;
+  }
+
+  // FieldExtractor
+  void onKey() override {
+    if ((pending_ & RequestParser::UnprocessedKeys) && at(2, "UnprocessedKeys")) {
+      response_.unprocessed_tables_.emplace_back(keys_[1]);
+    }
+  }
+  void onString(const char* value, rapidjson::SizeType size) override {
+    if ((pending_ & RequestParser::ErrorType) && at(1, "__type")) {
+      response_.error_type_.assign(value, size);
+      done(RequestParser::ErrorType);
+    }
+  }
+  void onNumber(double value) override {
+    if ((pending_ & RequestParser::Partitions) && at(3, "ConsumedCapacity", "Partitions")) {
+      // For a given partition id, the amount of capacity used is returned in the body as a
+      // double. A stat will be created to track the capacity consumed for the operation, table
+      // and partition. Stats counter only increments by whole numbers, capacity is round up to
+      // the nearest integer to account for this.
+      response_.partitions_.emplace_back(keys_[2], static_cast<uint64_t>(std::ceil(value)));
+    }
+  }
+  void onEndObject() override {
+    if (at(2, "UnprocessedKeys")) {
+      done(RequestParser::UnprocessedKeys);
+    } else if (at(3, "ConsumedCapacity", "Partitions") || at(2, "ConsumedCapacity")) {
+      done(RequestParser::Partitions);
+    }
+  }
+
+  uint32_t pending_;
+};
+
+void parse(const std::vector<Buffer::RawSlice>& body, FieldExtractor& extractor) {
+  SliceStream stream(body);
+  rapidjson::Reader reader;
+  reader.Parse(stream, extractor);
+
+  // The extractor terminates the parse itself once it has seen everything it needs.
+  if (reader.HasParseError() && !extractor.finished()) {
+    throw Json::Exception(fmt::format("JSON supplied is not valid. Error(offset {}): {}",
+                                      reader.GetErrorOffset(),
+                                      GetParseError_En(reader.GetParseErrorCode())));
+  }
 }
-std::string RequestParser::parseErrorType(const Json::Object& json_data) {
-  std::string error_type = json_data.getString("__type", "");
-  if (error_type.empty()) {
-    return "";
+
+} // namespace
+
+RequestParser::TableDescriptor
+RequestParser::parseTable(const std::string& operation, const std::vector<Buffer::RawSlice>& body) {
+  // Simple operations on a single table, have "TableName" explicitly specified. Batch operations
+  // name their tables as the keys of "RequestItems".
+  bool batch;
+  if (find(SINGLE_TABLE_OPERATIONS.begin(), SINGLE_TABLE_OPERATIONS.end(), operation) !=
+      SINGLE_TABLE_OPERATIONS.end()) {
+    batch = false;
+  } else if (isBatchOperation(operation)) {
+    batch = true;
+  } else {
+    return {"", true};
   }
 
+  TableExtractor extractor(batch);
+  parse(body, extractor);
+  return extractor.table_;
+}
+
+RequestParser::ResponseDescriptor
+RequestParser::parseResponse(const std::vector<Buffer::RawSlice>& body, uint32_t fields) {
+  ResponseExtractor extractor(fields);
+  parse(body, extractor);
+
+  ResponseDescriptor response = std::move(extractor.response_);
+  std::string error_type;
+  error_type.swap(response.error_type_);
   for (const std::string& supported_error_type : SUPPORTED_ERROR_TYPES) {
     if (StringUtil::endsWith(error_type, supported_error_type)) {
-      return supported_error_type;
+      response.error_type_ = supported_error_type;
+      break;
     }
   }
 
-  return "";
+  return response;
 }
 
 bool RequestParser::isBatchOperation(const std::string& operation) {
@@ -122,25 +341,5 @@ bool RequestParser::isBatchOperation(const std::string& operation) {
          BATCH_OPERATIONS.end();
 }
 
-std::vector<RequestParser::PartitionDescriptor>
-RequestParser::parsePartitions(const Json::Object& json_data) {
-  std::vector<RequestParser::PartitionDescriptor> partition_descriptors;
-
-  Json::ObjectSharedPtr partitions =
-      json_data.getObject("ConsumedCapacity", true)->getObject("Partitions", true);
-  partitions->iterate([&partition_descriptors, &partitions](const std::string& key,
-                                                            const Json::Object&) {
-    // For a given partition id, the amount of capacity used is returned in the body as a double.
-    // A stat will be created to track the capacity consumed for the operation, table and partition.
-    // Stats counter only increments by whole numbers, capacity is round up to the nearest integer
-    // to account for this.
-    uint64_t capacity_integer = static_cast<uint64_t>(std::ceil(partitions->getDouble(key, 0.0)));
-    partition_descriptors.emplace_back(key, capacity_integer);
-    return true;
-  });
-
-  return partition_descriptors;
-}
-
 } // namespace Dynamo
 } // namespace Envoy
@@ -4,10 +4,9 @@
 #include <string>
 #include <vector>
 
+#include "envoy/buffer/buffer.h"
 #include "envoy/http/header_map.h"
 
-#include "common/json/json_loader.h"
-
 namespace Envoy {
 namespace Dynamo {
 
@@ -39,56 +38,65 @@ public:
   static std::string parseOperation(const Http::HeaderMap& headerMap);
 
   /**
-   * Parse table name out of data, based on the operation.
-   * @return empty string as TableDescriptor.table_name if table name cannot be parsed out of valid
-   *json data
-   * or if operation is not in the list of operations that we support.
+   * Fields of a response body that parseResponse() extracts.
+   */
+  enum ResponseField : uint32_t {
+    ErrorType = 0x1,
+    UnprocessedKeys = 0x2,
+    Partitions = 0x4,
+  };
+
+  struct ResponseDescriptor {
+    std::string error_type_;
+    std::vector<std::string> unprocessed_tables_;
+    std::vector<PartitionDescriptor> partitions_;
+  };
+
+  /**
+   * Parse table name out of a request body, based on the operation. The body is read with a
+   * streaming JSON parser that stops as soon as the table names are known, so neither a DOM nor a
+   * contiguous copy of the body is built.
+   * @param operation supplies the operation parsed out of the headers.
+   * @param body supplies the slices of the request body, in order.
+   * @return empty string as TableDescriptor.table_name if table name cannot be parsed out of the
+   * body or if operation is not in the list of operations that we support.
    *
    * For simple operations on single table, e.g., GetItem, PutItem, Query etc @return table
    * name in TableDescriptor.table_name.
    *
    * For batch operations, e.g. BatchGetItem/BatchWriteItem, @return table name in
-   *TableDescriptor.table_name if it's only one
-   * table used in all operations, @return empty string in TableDescriptor.table_name and
-   *TableDescriptor.is_single_table=false in case of multiple.
+   * TableDescriptor.table_name if it's only one table used in all operations, @return empty string
+   * in TableDescriptor.table_name and TableDescriptor.is_single_table=false in case of multiple.
    *
-   * @throw Json::Exception if data is not in valid Json format.
+   * @throw Json::Exception if the body is not valid JSON up to the point where parsing stopped.
    */
-  static TableDescriptor parseTable(const std::string& operation, const Json::Object& json_data);
+  static TableDescriptor parseTable(const std::string& operation,
+                                    const std::vector<Buffer::RawSlice>& body);
 
   /**
-   * Parse error details which might be provided for a given response code.
-   * @return empty string if cannot get error details.
-   * For the full list of errors, see
-   * http://docs.aws.amazon.com/amazondynamodb/latest/APIReference/CommonErrors.html
-   * Operation specific errors, for example, error section of
-   * http://docs.aws.amazon.com/amazondynamodb/latest/APIReference/API_UpdateItem.html
+   * Parse the fields of a response body that are needed for stats, in a single pass that stops as
+   * soon as all of them have been seen.
+   * @param body supplies the slices of the response body, in order.
+   * @param fields supplies the ResponseField values to extract, or'ed together.
+   * @return ResponseDescriptor with:
+   *  error_type_: the error details which might be provided for a given response code, or empty
+   *    string if they cannot be parsed. For the full list of errors, see
+   *    http://docs.aws.amazon.com/amazondynamodb/latest/APIReference/CommonErrors.html
+   *    Operation specific errors, for example, error section of
+   *    http://docs.aws.amazon.com/amazondynamodb/latest/APIReference/API_UpdateItem.html
+   *  unprocessed_tables_: the table names that did not get processed in a batch operation.
+   *  partitions_: the partition ids and the capacity they consumed, rounded up to an integer.
    *
-   * @throw Json::Exception if data is not in valid Json format.
+   * @throw Json::Exception if the body is not valid JSON up to the point where parsing stopped.
    */
-  static std::string parseErrorType(const Json::Object& json_data);
-
-  /**
-   * Parse unprocessed keys for batch operation results.
-   * @return empty set if there are no unprocessed keys or a set of table names that did not get
-   * processed in the batch operation.
-   */
-  static std::vector<std::string> parseBatchUnProcessedKeys(const Json::Object& json_data);
+  static ResponseDescriptor parseResponse(const std::vector<Buffer::RawSlice>& body,
+                                          uint32_t fields);
 
   /**
    * @return true if the operation is in the set of supported BATCH_OPERATIONS
    */
   static bool isBatchOperation(const std::string& operation);
 
-  /**
-   * Parse the Partition ids and the consumed capacity from the body.
-   * @return empty set if there is no partition data or a set of partition data containing
-   * the partition id as a string and the capacity consumed as an integer.
-   *
-   * @throw Json::Exception if data is not in valid Json format.
-   */
-  static std::vector<PartitionDescriptor> parsePartitions(const Json::Object& json_data);
-
 private:
   static const Http::LowerCaseString X_AMZ_TARGET;
   static const std::vector<std::string> SINGLE_TABLE_OPERATIONS;
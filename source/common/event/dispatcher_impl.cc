@@ -1,9 +1,10 @@
 #include "common/event/dispatcher_impl.h"
 
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
 #include <functional>
-#include <mutex>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -11,9 +12,11 @@
 #include "envoy/network/listener.h"
 
 #include "common/buffer/buffer_impl.h"
+#include "common/common/utility.h"
 #include "common/event/file_event_impl.h"
 #include "common/event/signal_impl.h"
 #include "common/event/timer_impl.h"
+#include "common/event/timer_wheel.h"
 #include "common/filesystem/watcher_impl.h"
 #include "common/network/connection_impl.h"
 #include "common/network/dns_impl.h"
@@ -25,47 +28,89 @@
 namespace Envoy {
 namespace Event {
 
+const std::chrono::milliseconds DispatcherImpl::SLOW_CALLBACK_THRESHOLD{25};
+const size_t DispatcherImpl::MAX_DEFERRED_DELETES_PER_ITERATION;
+const std::chrono::milliseconds DispatcherImpl::POST_CALLBACK_BUDGET{10};
+
 DispatcherImpl::DispatcherImpl()
     : DispatcherImpl(Buffer::WatermarkFactoryPtr{new Buffer::WatermarkBufferFactory}) {}
 
 DispatcherImpl::DispatcherImpl(Buffer::WatermarkFactoryPtr&& factory)
     : buffer_factory_(std::move(factory)), base_(event_base_new()),
-      deferred_delete_timer_(createTimer([this]() -> void { clearDeferredDeleteList(); })),
-      post_timer_(createTimer([this]() -> void { runPostCallbacks(); })),
-      current_to_delete_(&to_delete_1_) {}
+      deferred_delete_timer_(new TimerImpl(
+          *this, [this]() -> void { deleteDeferred(MAX_DEFERRED_DELETES_PER_ITERATION); },
+          "deferred_delete")),
+      post_timer_(new TimerImpl(*this, [this]() -> void { runPostCallbacks(true); }, "post")) {}
+
+DispatcherImpl::~DispatcherImpl() {
+  // Callbacks that were never run are dropped, as they were before the queue was lock free.
+  while (PostCallback* callback = post_callbacks_.pop()) {
+    delete callback;
+  }
+}
+
+void DispatcherImpl::initializeStats(Stats::Scope& scope, const std::string& prefix) {
+  slice_pool_.initializeStats(scope, prefix);
+}
+
+void DispatcherImpl::initializeLoopStats(Stats::Scope& scope, const std::string& prefix) {
+  ASSERT(run_tid_ == 0);
+  loop_stats_prefix_ = prefix + "dispatcher.";
+  loop_stats_.reset(new DispatcherLoopStats{
+      ALL_DISPATCHER_LOOP_STATS(POOL_COUNTER_PREFIX(scope, loop_stats_prefix_),
+                                POOL_GAUGE_PREFIX(scope, loop_stats_prefix_),
+                                POOL_HISTOGRAM_PREFIX(scope, loop_stats_prefix_))});
+}
 
-DispatcherImpl::~DispatcherImpl() {}
+MonotonicTime DispatcherImpl::onCallbackStart() {
+  const MonotonicTime now = ProdMonotonicTimeSource::instance_.currentTime();
+  if (!iteration_ran_callbacks_) {
+    // The first callback of an iteration marks the end of the wait for events.
+    iteration_ran_callbacks_ = true;
+    first_callback_start_ = now;
+    loop_stats_->poll_delay_us_.recordValue(
+        std::chrono::duration_cast<std::chrono::microseconds>(now - iteration_start_).count());
+  }
+
+  return now;
+}
+
+void DispatcherImpl::onCallbackEnd(const char* type, MonotonicTime start) {
+  const std::chrono::milliseconds duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+      ProdMonotonicTimeSource::instance_.currentTime() - start);
+  if (duration >= SLOW_CALLBACK_THRESHOLD) {
+    loop_stats_->slow_callbacks_.inc();
+    ENVOY_LOG(warn, "{}: {} callback blocked the event loop for {}ms", loop_stats_prefix_, type,
+              duration.count());
+  }
+}
 
 void DispatcherImpl::clearDeferredDeleteList() {
   ASSERT(isThreadSafe());
-  std::vector<DeferredDeletablePtr>* to_delete = current_to_delete_;
+  deleteDeferred(to_delete_.size());
+}
 
-  size_t num_to_delete = to_delete->size();
+void DispatcherImpl::deleteDeferred(size_t max_to_delete) {
+  const size_t num_to_delete = std::min(max_to_delete, to_delete_.size());
   if (deferred_deleting_ || !num_to_delete) {
     return;
   }
 
-  ENVOY_LOG(trace, "clearing deferred deletion list (size={})", num_to_delete);
-
-  // Swap the current deletion vector so that if we do deferred delete while we are deleting, we
-  // use the other vector. We will get another callback to delete that vector.
-  if (current_to_delete_ == &to_delete_1_) {
-    current_to_delete_ = &to_delete_2_;
-  } else {
-    current_to_delete_ = &to_delete_1_;
-  }
-
+  ENVOY_LOG(trace, "clearing deferred deletion list (size={}, deleting={})", to_delete_.size(),
+            num_to_delete);
   deferred_deleting_ = true;
 
-  // Calling clear() on the vector does not specify which order destructors run in. We want to
-  // destroy in FIFO order so just do it manually. This required 2 passes over the vector which is
-  // not optimal but can be cleaned up later if needed.
+  // Destroy in FIFO order. Each item is taken off the list before its destructor runs, so anything
+  // the destructor defers is appended behind it and waits for a later pass.
   for (size_t i = 0; i < num_to_delete; i++) {
-    (*to_delete)[i].reset();
+    DeferredDeletablePtr to_delete = std::move(to_delete_.front());
+    to_delete_.pop_front();
   }
 
-  to_delete->clear();
   deferred_deleting_ = false;
+  if (!to_delete_.empty()) {
+    deferred_delete_timer_->enableTimerNextIteration();
+  }
 }
 
 Network::ClientConnectionPtr
@@ -124,14 +169,22 @@ DispatcherImpl::createSslListener(Network::ConnectionHandler& conn_handler,
 
 TimerPtr DispatcherImpl::createTimer(TimerCb cb) {
   ASSERT(isThreadSafe());
-  return TimerPtr{new TimerImpl(*this, cb)};
+  return TimerPtr{new TimerImpl(*this, cb, "timer")};
+}
+
+TimerPtr DispatcherImpl::createCoarseTimer(TimerCb cb) {
+  ASSERT(isThreadSafe());
+  if (timer_wheel_ == nullptr) {
+    timer_wheel_.reset(new TimerWheel(*this, ProdMonotonicTimeSource::instance_));
+  }
+  return TimerPtr{new CoarseTimerImpl(*timer_wheel_, cb)};
 }
 
 void DispatcherImpl::deferredDelete(DeferredDeletablePtr&& to_delete) {
   ASSERT(isThreadSafe());
-  current_to_delete_->emplace_back(std::move(to_delete));
-  ENVOY_LOG(trace, "item added to deferred deletion list (size={})", current_to_delete_->size());
-  if (1 == current_to_delete_->size()) {
+  to_delete_.emplace_back(std::move(to_delete));
+  ENVOY_LOG(trace, "item added to deferred deletion list (size={})", to_delete_.size());
+  if (1 == to_delete_.size()) {
     deferred_delete_timer_->enableTimer(std::chrono::milliseconds(0));
   }
 }
@@ -144,39 +197,89 @@ SignalEventPtr DispatcherImpl::listenForSignal(int signal_num, SignalCb cb) {
 }
 
 void DispatcherImpl::post(std::function<void()> callback) {
-  bool do_post;
-  {
-    std::unique_lock<std::mutex> lock(post_lock_);
-    do_post = post_callbacks_.empty();
-    post_callbacks_.push_back(callback);
+  if (loop_stats_ != nullptr) {
+    loop_stats_->posted_callbacks_.inc();
+    loop_stats_->post_queue_depth_.inc();
   }
 
-  if (do_post) {
+  post_callbacks_.push(*new PostCallback(std::move(callback)));
+
+  // The callback is queued before the flag is read, so either the pending run of the post timer
+  // sees it, or this post arms the timer again.
+  if (!post_scheduled_.exchange(true)) {
     post_timer_->enableTimer(std::chrono::milliseconds(0));
   }
 }
 
 void DispatcherImpl::run(RunType type) {
   run_tid_ = Thread::Thread::currentThreadId();
+  // All buffers used on this thread while the loop runs share the dispatcher's slice pool.
+  Buffer::SlicePool* previous_pool = Buffer::SlicePool::setCurrent(&slice_pool_);
 
   // Flush all post callbacks before we run the event loop. We do this because there are post
   // callbacks that have to get run before the initial event loop starts running. libevent does
   // not gaurantee that events are run in any particular order. So even if we post() and call
   // event_base_once() before some other event, the other event might get called first.
-  runPostCallbacks();
+  runPostCallbacks(false);
+
+  runLoop(type);
+  invalidateTimeCache(false);
+  Buffer::SlicePool::setCurrent(previous_pool);
+}
 
-  event_base_loop(base_.get(), type == RunType::NonBlock ? EVLOOP_NONBLOCK : 0);
+void DispatcherImpl::runLoop(RunType type) {
+  // Run the loop one iteration at a time, so that the cached time can be refreshed for every
+  // iteration, and so that the wait for events can be told apart from the callbacks that the
+  // events then run.
+  while (true) {
+    invalidateTimeCache(true);
+    if (loop_stats_ != nullptr) {
+      iteration_start_ = ProdMonotonicTimeSource::instance_.currentTime();
+      iteration_ran_callbacks_ = false;
+    }
+
+    const int rc =
+        event_base_loop(base_.get(), type == RunType::NonBlock ? EVLOOP_NONBLOCK : EVLOOP_ONCE);
+    if (loop_stats_ != nullptr && iteration_ran_callbacks_) {
+      loop_stats_->loop_duration_us_.recordValue(
+          std::chrono::duration_cast<std::chrono::microseconds>(
+              ProdMonotonicTimeSource::instance_.currentTime() - first_callback_start_)
+              .count());
+    }
+
+    // A non-zero return means that no events are left, which also ends a blocking run.
+    if (type == RunType::NonBlock || rc != 0 || event_base_got_exit(base_.get()) ||
+        event_base_got_break(base_.get())) {
+      return;
+    }
+  }
 }
 
-void DispatcherImpl::runPostCallbacks() {
-  std::unique_lock<std::mutex> lock(post_lock_);
-  while (!post_callbacks_.empty()) {
-    std::function<void()> callback = post_callbacks_.front();
-    post_callbacks_.pop_front();
+void DispatcherImpl::invalidateTimeCache(bool cache) {
+  monotonic_time_.invalidate(cache);
+  system_time_.invalidate(cache);
+}
 
-    lock.unlock();
-    callback();
-    lock.lock();
+void DispatcherImpl::runPostCallbacks(bool bounded) {
+  const MonotonicTime deadline =
+      ProdMonotonicTimeSource::instance_.currentTime() + POST_CALLBACK_BUDGET;
+  // Clear the flag before looking at the queue, so that a post that is not seen below arms the
+  // timer again.
+  post_scheduled_.exchange(false);
+  while (PostCallback* callback = post_callbacks_.pop()) {
+    std::unique_ptr<PostCallback> owned(callback);
+    if (loop_stats_ != nullptr) {
+      loop_stats_->post_queue_depth_.dec();
+    }
+    owned->callback_();
+
+    if (bounded && ProdMonotonicTimeSource::instance_.currentTime() >= deadline) {
+      // Let the loop poll for I/O before running the rest. post() only arms the timer when no run
+      // is pending, so it has to be re-armed here.
+      post_scheduled_.store(true);
+      post_timer_->enableTimerNextIteration();
+      return;
+    }
   }
 }
 
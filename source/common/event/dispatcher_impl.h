@@ -1,22 +1,87 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <cstdint>
+#include <deque>
 #include <functional>
 #include <list>
-#include <mutex>
+#include <memory>
+#include <string>
 #include <vector>
 
+#include "envoy/common/time.h"
 #include "envoy/event/deferred_deletable.h"
 #include "envoy/event/dispatcher.h"
 #include "envoy/network/connection_handler.h"
+#include "envoy/stats/stats_macros.h"
 
+#include "common/buffer/buffer_impl.h"
 #include "common/common/logger.h"
+#include "common/common/mpsc_queue.h"
 #include "common/common/thread.h"
+#include "common/common/utility.h"
 #include "common/event/libevent.h"
 
 namespace Envoy {
 namespace Event {
 
+class TimerImpl;
+class TimerWheel;
+
+/**
+ * All event loop stats. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_DISPATCHER_LOOP_STATS(COUNTER, GAUGE, HISTOGRAM)                                       \
+  COUNTER  (posted_callbacks)                                                                      \
+  COUNTER  (slow_callbacks)                                                                        \
+  GAUGE    (post_queue_depth)                                                                      \
+  HISTOGRAM(loop_duration_us)                                                                      \
+  HISTOGRAM(poll_delay_us)
+// clang-format on
+
+/**
+ * Struct definition for all event loop stats. @see stats_macros.h
+ */
+struct DispatcherLoopStats {
+  ALL_DISPATCHER_LOOP_STATS(GENERATE_COUNTER_STRUCT, GENERATE_GAUGE_STRUCT,
+                            GENERATE_HISTOGRAM_STRUCT)
+};
+
+/**
+ * Time source that keeps returning the first time it read from another time source until it is
+ * invalidated.
+ */
+template <class Source, class Time> class CachingTimeSource : public Source {
+public:
+  CachingTimeSource(Source& source) : source_(source) {}
+
+  /**
+   * Drop the cached time, so that the next read reads the underlying time source again.
+   * @param cache supplies whether the time read next is cached. If not, every read is exact.
+   */
+  void invalidate(bool cache) {
+    cached_ = false;
+    caching_ = cache;
+  }
+
+  // Source
+  Time currentTime() override {
+    if (!cached_) {
+      time_ = source_.currentTime();
+      cached_ = caching_;
+    }
+    return time_;
+  }
+
+private:
+  Source& source_;
+  Time time_;
+  bool caching_{};
+  bool cached_{};
+};
+
 /**
  * libevent implementation of Event::Dispatcher.
  */
@@ -54,15 +119,62 @@ public:
                                          Network::ListenerCallbacks& cb, Stats::Scope& scope,
                                          const Network::ListenerOptions& listener_options) override;
   TimerPtr createTimer(TimerCb cb) override;
+  TimerPtr createCoarseTimer(TimerCb cb) override;
   void deferredDelete(DeferredDeletablePtr&& to_delete) override;
   void exit() override;
   SignalEventPtr listenForSignal(int signal_num, SignalCb cb) override;
   void post(std::function<void()> callback) override;
   void run(RunType type) override;
   Buffer::WatermarkFactory& getWatermarkFactory() override { return *buffer_factory_; }
+  void initializeStats(Stats::Scope& scope, const std::string& prefix) override;
+  void initializeLoopStats(Stats::Scope& scope, const std::string& prefix) override;
+  MonotonicTimeSource& approximateMonotonicTimeSource() override { return monotonic_time_; }
+  SystemTimeSource& approximateSystemTimeSource() override { return system_time_; }
+  const char* runningCallbackType() const override {
+    return running_callback_type_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Run a callback of one of the dispatcher's events. It is timed when loop stats are enabled.
+   * @param type supplies the kind of event, used when logging a slow callback.
+   * @param callback supplies the callback. The event that owns it may be destroyed while it runs.
+   */
+  template <class Callback> void runEventCallback(const char* type, const Callback& callback) {
+    // Restored afterwards, since a callback may run the loop in non-blocking mode.
+    const char* previous_type = running_callback_type_.exchange(type, std::memory_order_relaxed);
+    if (loop_stats_ == nullptr) {
+      callback();
+    } else {
+      const MonotonicTime start = onCallbackStart();
+      callback();
+      onCallbackEnd(type, start);
+    }
+    running_callback_type_.store(previous_type, std::memory_order_relaxed);
+  }
+
+  // Callbacks that run for at least this long are counted as slow.
+  static const std::chrono::milliseconds SLOW_CALLBACK_THRESHOLD;
+  // The most deferred deletions done by one run of the deferred delete timer. The rest carry over
+  // to the next loop iteration, so that tearing down many connections at once does not stall
+  // the loop.
+  static const size_t MAX_DEFERRED_DELETES_PER_ITERATION = 1000;
+  // How long one run of the post timer may spend running posted callbacks before the rest carry
+  // over to the next loop iteration.
+  static const std::chrono::milliseconds POST_CALLBACK_BUDGET;
 
 private:
-  void runPostCallbacks();
+  struct PostCallback : public MpscQueue<PostCallback>::Node {
+    PostCallback(std::function<void()>&& callback) : callback_(std::move(callback)) {}
+
+    std::function<void()> callback_;
+  };
+
+  void deleteDeferred(size_t max_to_delete);
+  MonotonicTime onCallbackStart();
+  void onCallbackEnd(const char* type, MonotonicTime start);
+  void runLoop(RunType type);
+  void invalidateTimeCache(bool cache);
+  void runPostCallbacks(bool bounded);
 #ifndef NDEBUG
   // Validate that an operation is thread safe, i.e. it's invoked on the same thread that the
   // dispatcher run loop is executing on. We allow run_tid_ == 0 for tests where we don't invoke
@@ -74,15 +186,31 @@ private:
 
   Thread::ThreadId run_tid_{};
   Buffer::WatermarkFactoryPtr buffer_factory_;
+  // Slices released by the buffers of all connections on this dispatcher are pooled here.
+  Buffer::SlicePool slice_pool_;
   Libevent::BasePtr base_;
-  TimerPtr deferred_delete_timer_;
-  TimerPtr post_timer_;
-  std::vector<DeferredDeletablePtr> to_delete_1_;
-  std::vector<DeferredDeletablePtr> to_delete_2_;
-  std::vector<DeferredDeletablePtr>* current_to_delete_;
-  std::mutex post_lock_;
-  std::list<std::function<void()>> post_callbacks_;
+  std::unique_ptr<TimerImpl> deferred_delete_timer_;
+  std::unique_ptr<TimerImpl> post_timer_;
+  // Created along with the first coarse timer.
+  std::unique_ptr<TimerWheel> timer_wheel_;
+  std::deque<DeferredDeletablePtr> to_delete_;
+  // Posting takes no locks, so that threads posting to a busy dispatcher do not wait on each
+  // other. Only the post that finds no run of the post timer pending arms the timer, which
+  // coalesces the wakeups of a burst of posts.
+  MpscQueue<PostCallback> post_callbacks_;
+  std::atomic<bool> post_scheduled_{};
+  // Read by the guard dog when the loop stalls.
+  std::atomic<const char*> running_callback_type_{};
   bool deferred_deleting_{};
+  std::string loop_stats_prefix_;
+  std::unique_ptr<DispatcherLoopStats> loop_stats_;
+  // Re-read once per loop iteration while the loop runs, and exact otherwise.
+  CachingTimeSource<MonotonicTimeSource, MonotonicTime> monotonic_time_{
+      ProdMonotonicTimeSource::instance_};
+  CachingTimeSource<SystemTimeSource, SystemTime> system_time_{ProdSystemTimeSource::instance_};
+  MonotonicTime iteration_start_;
+  MonotonicTime first_callback_start_;
+  bool iteration_ran_callbacks_{};
 };
 
 } // namespace Event
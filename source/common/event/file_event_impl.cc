@@ -12,7 +12,7 @@ namespace Event {
 
 FileEventImpl::FileEventImpl(DispatcherImpl& dispatcher, int fd, FileReadyCb cb,
                              FileTriggerType trigger, uint32_t events)
-    : cb_(cb), base_(&dispatcher.base()), fd_(fd), trigger_(trigger) {
+    : dispatcher_(dispatcher), cb_(cb), base_(&dispatcher.base()), fd_(fd), trigger_(trigger) {
   assignEvents(events);
   event_add(&raw_event_, nullptr);
 }
@@ -57,7 +57,8 @@ void FileEventImpl::assignEvents(uint32_t events) {
                  }
 
                  ASSERT(events);
-                 event->cb_(events);
+                 event->dispatcher_.runEventCallback(
+                     "file_event", [event, events]() -> void { event->cb_(events); });
                },
                this);
 }
@@ -10,11 +10,16 @@
 namespace Envoy {
 namespace Event {
 
-TimerImpl::TimerImpl(DispatcherImpl& dispatcher, TimerCb cb) : cb_(cb) {
+TimerImpl::TimerImpl(DispatcherImpl& dispatcher, TimerCb cb, const char* type)
+    : dispatcher_(dispatcher), cb_(cb), type_(type) {
   ASSERT(cb_);
-  evtimer_assign(
-      &raw_event_, &dispatcher.base(),
-      [](evutil_socket_t, short, void* arg) -> void { static_cast<TimerImpl*>(arg)->cb_(); }, this);
+  evtimer_assign(&raw_event_, &dispatcher.base(),
+                 [](evutil_socket_t, short, void* arg) -> void {
+                   TimerImpl* timer = static_cast<TimerImpl*>(arg);
+                   timer->dispatcher_.runEventCallback(timer->type_,
+                                                       [timer]() -> void { timer->cb_(); });
+                 },
+                 this);
 }
 
 void TimerImpl::disableTimer() { event_del(&raw_event_); }
@@ -31,5 +36,11 @@ void TimerImpl::enableTimer(const std::chrono::milliseconds& d) {
   }
 }
 
+void TimerImpl::enableTimerNextIteration() {
+  // A zero timeout goes through the timer heap, which is only checked after the next poll.
+  timeval tv{};
+  event_add(&raw_event_, &tv);
+}
+
 } // namespace Event
 } // namespace Envoy
@@ -15,14 +15,26 @@ namespace Event {
  */
 class TimerImpl : public Timer, ImplBase {
 public:
-  TimerImpl(DispatcherImpl& dispatcher, TimerCb cb);
+  /**
+   * @param type supplies the kind of timer, used when logging a slow callback.
+   */
+  TimerImpl(DispatcherImpl& dispatcher, TimerCb cb, const char* type);
 
   // Event::Timer
   void disableTimer() override;
   void enableTimer(const std::chrono::milliseconds& d) override;
 
+  /**
+   * Fire the timer in the next event loop iteration, after the loop has polled for I/O. Unlike
+   * enableTimer(0), which may run the callback again in the current iteration, this lets other
+   * events run in between.
+   */
+  void enableTimerNextIteration();
+
 private:
+  DispatcherImpl& dispatcher_;
   TimerCb cb_;
+  const char* type_;
 };
 
 } // namespace Event
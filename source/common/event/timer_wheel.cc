@@ -0,0 +1,205 @@
+#include "common/event/timer_wheel.h"
+
+#include <algorithm>
+
+#include "common/common/assert.h"
+
+namespace Envoy {
+namespace Event {
+
+CoarseTimerImpl::CoarseTimerImpl(TimerWheel& wheel, TimerCb cb) : wheel_(wheel), cb_(cb) {
+  ASSERT(cb_);
+}
+
+CoarseTimerImpl::~CoarseTimerImpl() { wheel_.cancel(*this); }
+
+void CoarseTimerImpl::disableTimer() { wheel_.cancel(*this); }
+
+void CoarseTimerImpl::enableTimer(const std::chrono::milliseconds& d) { wheel_.schedule(*this, d); }
+
+const std::chrono::milliseconds TimerWheel::TICK{10};
+
+TimerWheel::TimerWheel(Dispatcher& dispatcher, MonotonicTimeSource& time_source)
+    : time_source_(time_source), start_(time_source.currentTime()),
+      tick_timer_(dispatcher.createTimer([this]() -> void { onTick(); })) {}
+
+TimerWheel::~TimerWheel() {
+  // Any timer still armed is owned elsewhere and must not point back into the slots.
+  for (Slot& slot : level0_) {
+    while (!slot.empty()) {
+      unlink(*static_cast<CoarseTimerImpl*>(slot.next_));
+    }
+  }
+  for (auto& level : upper_levels_) {
+    for (Slot& slot : level) {
+      while (!slot.empty()) {
+        unlink(*static_cast<CoarseTimerImpl*>(slot.next_));
+      }
+    }
+  }
+}
+
+uint64_t TimerWheel::currentTick() { return (time_source_.currentTime() - start_) / TICK; }
+
+MonotonicTime TimerWheel::tickStart(uint64_t tick) const {
+  return start_ + TICK * static_cast<int64_t>(tick);
+}
+
+void TimerWheel::schedule(CoarseTimerImpl& timer, std::chrono::milliseconds delay) {
+  cancel(timer);
+  if (armed_timers_ == 0) {
+    // All slots are empty, so an idle wheel can skip straight to the current tick.
+    processed_tick_ = std::max(processed_tick_, currentTick());
+  }
+
+  // Round up so that the timer never fires early.
+  const MonotonicTime::duration due = time_source_.currentTime() - start_ + delay;
+  uint64_t expiry_tick = due / TICK;
+  if (due % TICK != MonotonicTime::duration::zero()) {
+    expiry_tick++;
+  }
+  timer.expiry_tick_ = std::max(expiry_tick, processed_tick_ + 1);
+  insert(timer);
+  armed_timers_++;
+
+  // The tick timer is always armed for a tick no later than the next first level wrap around, so
+  // only a first level slot can require an earlier wake up.
+  if (wakeup_tick_ == 0) {
+    armTickTimer(nextWakeupTick());
+  } else if (timer.expiry_tick_ < wakeup_tick_) {
+    armTickTimer(timer.expiry_tick_);
+  }
+}
+
+void TimerWheel::cancel(CoarseTimerImpl& timer) {
+  if (!timer.armed()) {
+    return;
+  }
+
+  unlink(timer);
+  ASSERT(armed_timers_ > 0);
+  if (--armed_timers_ == 0 && wakeup_tick_ != 0) {
+    tick_timer_->disableTimer();
+    wakeup_tick_ = 0;
+  }
+}
+
+void TimerWheel::insert(CoarseTimerImpl& timer) {
+  // Cascading re-inserts timers that are due in the tick being processed, so this can be 0.
+  const uint64_t delta =
+      timer.expiry_tick_ > processed_tick_ ? timer.expiry_tick_ - processed_tick_ : 0;
+  if (delta < LEVEL0_SLOTS) {
+    link(level0_[timer.expiry_tick_ & (LEVEL0_SLOTS - 1)], timer);
+    return;
+  }
+
+  // Timers beyond the last level wait in its furthest slot and are placed again from there.
+  const uint64_t placement_tick =
+      delta < MAX_TICKS ? timer.expiry_tick_ : processed_tick_ + MAX_TICKS - 1;
+  for (uint32_t level = 0; level < UPPER_LEVELS; level++) {
+    const uint32_t shift = LEVEL0_BITS + level * LEVEL_BITS;
+    if (placement_tick - processed_tick_ < (1ULL << (shift + LEVEL_BITS))) {
+      link(upper_levels_[level][(placement_tick >> shift) & (LEVEL_SLOTS - 1)], timer);
+      return;
+    }
+  }
+  NOT_REACHED;
+}
+
+void TimerWheel::link(TimerWheelLink& list, CoarseTimerImpl& timer) {
+  TimerWheelLink& link = timer;
+  link.prev_ = list.prev_;
+  link.next_ = &list;
+  list.prev_->next_ = &link;
+  list.prev_ = &link;
+}
+
+void TimerWheel::unlink(CoarseTimerImpl& timer) {
+  TimerWheelLink& link = timer;
+  link.prev_->next_ = link.next_;
+  link.next_->prev_ = link.prev_;
+  link.prev_ = link.next_ = nullptr;
+}
+
+void TimerWheel::moveAll(Slot& from, Slot& to) {
+  ASSERT(to.empty());
+  if (from.empty()) {
+    return;
+  }
+
+  to.next_ = from.next_;
+  to.prev_ = from.prev_;
+  to.next_->prev_ = &to;
+  to.prev_->next_ = &to;
+  from.next_ = from.prev_ = &from;
+}
+
+void TimerWheel::cascade(Slot& slot) {
+  Slot cascading;
+  moveAll(slot, cascading);
+  while (!cascading.empty()) {
+    CoarseTimerImpl& timer = *static_cast<CoarseTimerImpl*>(cascading.next_);
+    unlink(timer);
+    insert(timer);
+  }
+}
+
+void TimerWheel::expire(Slot& slot) {
+  // Callbacks may arm, disarm or destroy any timer, including others that are due now. Those are
+  // unlinked from the local list in that case, so it is safe to keep popping from it.
+  Slot expired;
+  moveAll(slot, expired);
+  while (!expired.empty()) {
+    CoarseTimerImpl& timer = *static_cast<CoarseTimerImpl*>(expired.next_);
+    unlink(timer);
+    armed_timers_--;
+    timer.cb_();
+  }
+}
+
+void TimerWheel::onTick() {
+  wakeup_tick_ = 0;
+  const uint64_t current_tick = currentTick();
+  while (processed_tick_ < current_tick && armed_timers_ > 0) {
+    const uint64_t tick = ++processed_tick_;
+    if ((tick & (LEVEL0_SLOTS - 1)) == 0) {
+      for (uint32_t level = 0; level < UPPER_LEVELS; level++) {
+        const uint32_t index = (tick >> (LEVEL0_BITS + level * LEVEL_BITS)) & (LEVEL_SLOTS - 1);
+        cascade(upper_levels_[level][index]);
+        if (index != 0) {
+          break;
+        }
+      }
+    }
+
+    expire(level0_[tick & (LEVEL0_SLOTS - 1)]);
+  }
+
+  if (armed_timers_ > 0 && wakeup_tick_ == 0) {
+    armTickTimer(nextWakeupTick());
+  }
+}
+
+void TimerWheel::armTickTimer(uint64_t tick) {
+  wakeup_tick_ = tick;
+  const MonotonicTime::duration wait = tickStart(tick) - time_source_.currentTime();
+  // Round up so that the tick has begun when the timer fires.
+  std::chrono::milliseconds wait_ms = std::chrono::duration_cast<std::chrono::milliseconds>(wait);
+  if (wait_ms < wait) {
+    wait_ms++;
+  }
+  tick_timer_->enableTimer(std::max(wait_ms, std::chrono::milliseconds(0)));
+}
+
+uint64_t TimerWheel::nextWakeupTick() const {
+  // Either the next non-empty first level slot, or the next wrap around, where a cascade may bring
+  // timers down from the upper levels.
+  uint64_t tick = processed_tick_ + 1;
+  while (level0_[tick & (LEVEL0_SLOTS - 1)].empty() && (tick & (LEVEL0_SLOTS - 1)) != 0) {
+    tick++;
+  }
+  return tick;
+}
+
+} // namespace Event
+} // namespace Envoy
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+#include "envoy/common/time.h"
+#include "envoy/event/dispatcher.h"
+#include "envoy/event/timer.h"
+
+#include "common/common/non_copyable.h"
+
+namespace Envoy {
+namespace Event {
+
+class TimerWheel;
+
+/**
+ * Intrusive doubly linked list node. Wheel slots are circular lists of timers, so that arming,
+ * disarming and firing a timer never allocate.
+ */
+struct TimerWheelLink {
+  TimerWheelLink* prev_{};
+  TimerWheelLink* next_{};
+};
+
+/**
+ * A timer scheduled on a TimerWheel. It fires no earlier than requested, and at most one wheel tick
+ * later.
+ */
+class CoarseTimerImpl : public Timer, TimerWheelLink, NonCopyable {
+public:
+  CoarseTimerImpl(TimerWheel& wheel, TimerCb cb);
+  ~CoarseTimerImpl();
+
+  // Event::Timer
+  void disableTimer() override;
+  void enableTimer(const std::chrono::milliseconds& d) override;
+
+private:
+  friend class TimerWheel;
+
+  bool armed() const { return next_ != nullptr; }
+
+  TimerWheel& wheel_;
+  TimerCb cb_;
+  uint64_t expiry_tick_{};
+};
+
+/**
+ * Hierarchical timer wheel, in the style of the Linux kernel's, for timeouts that do not need
+ * millisecond precision, such as idle timeouts that are re-armed on every read. Arming, re-arming
+ * and disarming a timer are O(1) list operations. The libevent min-heap costs O(log n) for each of
+ * these.
+ *
+ * Time is counted in ticks of TICK. The first level has one slot per tick for the next 256 ticks.
+ * Each of the next three levels has 64 slots that each cover all the slots of the level below.
+ * When the first level wraps around, the next due slot of the level above is spread back down
+ * ("cascaded"). A single dispatcher timer wakes the wheel up only when a first level slot is due
+ * or a cascade is needed.
+ */
+class TimerWheel : NonCopyable {
+public:
+  TimerWheel(Dispatcher& dispatcher, MonotonicTimeSource& time_source);
+  ~TimerWheel();
+
+  static const std::chrono::milliseconds TICK;
+
+private:
+  friend class CoarseTimerImpl;
+
+  static const uint32_t LEVEL0_BITS = 8;
+  static const uint32_t LEVEL0_SLOTS = 1 << LEVEL0_BITS;
+  static const uint32_t LEVEL_BITS = 6;
+  static const uint32_t LEVEL_SLOTS = 1 << LEVEL_BITS;
+  static const uint32_t UPPER_LEVELS = 3;
+  // Timers further out than this are kept in the last slot reachable and re-cascaded.
+  static const uint64_t MAX_TICKS = 1ULL << (LEVEL0_BITS + UPPER_LEVELS * LEVEL_BITS);
+
+  /**
+   * Head of the circular list of the timers due in a slot.
+   */
+  struct Slot : TimerWheelLink {
+    Slot() { prev_ = next_ = this; }
+    bool empty() const { return next_ == this; }
+  };
+
+  void schedule(CoarseTimerImpl& timer, std::chrono::milliseconds delay);
+  void cancel(CoarseTimerImpl& timer);
+
+  uint64_t currentTick();
+  MonotonicTime tickStart(uint64_t tick) const;
+  void insert(CoarseTimerImpl& timer);
+  static void link(TimerWheelLink& list, CoarseTimerImpl& timer);
+  static void unlink(CoarseTimerImpl& timer);
+  static void moveAll(Slot& from, Slot& to);
+  void cascade(Slot& slot);
+  void onTick();
+  void expire(Slot& slot);
+  void armTickTimer(uint64_t tick);
+  uint64_t nextWakeupTick() const;
+
+  MonotonicTimeSource& time_source_;
+  const MonotonicTime start_;
+  // The last tick that the wheel has processed.
+  uint64_t processed_tick_{};
+  uint64_t armed_timers_{};
+  TimerPtr tick_timer_;
+  // The tick that tick_timer_ is armed for, or 0 if it is not armed.
+  uint64_t wakeup_tick_{};
+  std::array<Slot, LEVEL0_SLOTS> level0_;
+  std::array<std::array<Slot, LEVEL_SLOTS>, UPPER_LEVELS> upper_levels_;
+};
+
+} // namespace Event
+} // namespace Envoy
@@ -2,13 +2,16 @@
 
 #include <dirent.h>
 
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <mutex>
 #include <sstream>
 #include <string>
+#include <unordered_map>
 
 #include "envoy/common/exception.h"
 #include "envoy/event/dispatcher.h"
@@ -53,12 +56,132 @@ std::string fileReadToEnd(const std::string& path) {
   return file_string.str();
 }
 
+WriteRing::WriteRing(uint64_t capacity) : capacity_(capacity), data_(new char[capacity]) {
+  ASSERT(capacity > 0);
+}
+
+bool WriteRing::push(const std::string& data) {
+  const uint64_t tail = tail_.load(std::memory_order_relaxed);
+  // The acquire pairs with the release in drainTo(), so that the consumer is done reading the
+  // space it freed before it is written again.
+  const uint64_t head = head_.load(std::memory_order_acquire);
+  if (capacity_ - (tail - head) < data.size()) {
+    return false;
+  }
+
+  const uint64_t offset = tail % capacity_;
+  const uint64_t first = std::min<uint64_t>(data.size(), capacity_ - offset);
+  memcpy(data_.get() + offset, data.data(), first);
+  memcpy(data_.get(), data.data() + first, data.size() - first);
+  tail_.store(tail + data.size(), std::memory_order_release);
+  return true;
+}
+
+uint64_t WriteRing::drainTo(Buffer::Instance& output) {
+  const uint64_t head = head_.load(std::memory_order_relaxed);
+  const uint64_t tail = tail_.load(std::memory_order_acquire);
+  const uint64_t length = tail - head;
+  if (length == 0) {
+    return 0;
+  }
+
+  const uint64_t offset = head % capacity_;
+  const uint64_t first = std::min(length, capacity_ - offset);
+  output.add(data_.get() + offset, first);
+  if (first < length) {
+    output.add(data_.get(), length - first);
+  }
+  head_.store(tail, std::memory_order_release);
+  return length;
+}
+
+uint64_t WriteRing::size() const {
+  return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+}
+
+FlushExecutor::~FlushExecutor() {
+  {
+    std::unique_lock<std::mutex> lock(lock_);
+    ASSERT(pending_.empty());
+    exit_ = true;
+    work_event_.notify_one();
+  }
+
+  if (flush_thread_ != nullptr) {
+    flush_thread_->join();
+  }
+}
+
+void FlushExecutor::schedule(FileImpl& file) {
+  // Writers call this for every write once their ring is past the flush threshold, so skip the
+  // lock while the file is queued already.
+  if (file.flush_scheduled_) {
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock(lock_);
+  if (file.flush_scheduled_) {
+    return;
+  }
+
+  if (flush_thread_ == nullptr) {
+    flush_thread_.reset(new Thread::Thread([this]() -> void { flushThreadFunc(); }));
+  }
+
+  file.flush_scheduled_ = true;
+  pending_.push_back(&file);
+  work_event_.notify_one();
+}
+
+void FlushExecutor::cancel(FileImpl& file) {
+  std::unique_lock<std::mutex> lock(lock_);
+  if (file.flush_scheduled_) {
+    file.flush_scheduled_ = false;
+    pending_.erase(std::find(pending_.begin(), pending_.end(), &file));
+  }
+
+  while (current_ == &file) {
+    flush_done_event_.wait(lock);
+  }
+}
+
+void FlushExecutor::flushThreadFunc() {
+  std::unique_lock<std::mutex> lock(lock_);
+  while (true) {
+    while (pending_.empty() && !exit_) {
+      work_event_.wait(lock);
+    }
+
+    if (exit_) {
+      return;
+    }
+
+    // Files are flushed one at a time without the lock held, so that other files can be scheduled
+    // in the meantime and a file being destroyed only waits for its own flush.
+    current_ = pending_.front();
+    pending_.pop_front();
+    current_->flush_scheduled_ = false;
+    lock.unlock();
+    current_->flushPending();
+    lock.lock();
+    current_ = nullptr;
+    flush_done_event_.notify_all();
+  }
+}
+
+static std::atomic<uint64_t> next_file_id;
+
 FileImpl::FileImpl(const std::string& path, Event::Dispatcher& dispatcher,
-                   Thread::BasicLockable& lock, Stats::Store& stats_store,
-                   std::chrono::milliseconds flush_interval_msec)
-    : path_(path), file_lock_(lock), flush_timer_(dispatcher.createTimer([this]() -> void {
+                   Thread::BasicLockable& lock, FlushExecutor& flush_executor,
+                   Stats::Store& stats_store, std::chrono::milliseconds flush_interval_msec,
+                   uint64_t write_buffer_bytes)
+    : path_(path), id_(++next_file_id), file_lock_(lock), flush_executor_(flush_executor),
+      write_buffer_bytes_(write_buffer_bytes),
+      flush_threshold_(write_buffer_bytes / 2 < MIN_FLUSH_SIZE ? write_buffer_bytes / 2
+                                                               : MIN_FLUSH_SIZE),
+      flush_timer_(dispatcher.createTimer([this]() -> void {
         stats_.flushed_by_timer_.inc();
-        flush_event_.notify_one();
+        flush_executor_.schedule(*this);
         flush_timer_->enableTimer(flush_interval_msec_);
       })),
       os_sys_calls_(Api::OsSysCallsSingleton::get()), flush_interval_msec_(flush_interval_msec),
@@ -79,20 +202,13 @@ void FileImpl::open() {
 void FileImpl::reopen() { reopen_file_ = true; }
 
 FileImpl::~FileImpl() {
-  {
-    std::unique_lock<std::mutex> lock(write_lock_);
-    flush_thread_exit_ = true;
-    flush_event_.notify_one();
-  }
-
-  if (flush_thread_ != nullptr) {
-    flush_thread_->join();
-  }
+  flush_executor_.cancel(*this);
 
   // Flush any remaining data. If file was not opened for some reason, skip flushing part.
   if (fd_ != -1) {
-    if (flush_buffer_.length() > 0) {
-      doWrite(flush_buffer_);
+    collectPending();
+    if (about_to_write_buffer_.length() > 0) {
+      doWrite(about_to_write_buffer_);
     }
 
     os_sys_calls_.close(fd_);
@@ -109,9 +225,9 @@ void FileImpl::doWrite(Buffer::Instance& buffer) {
   // restart or if calling code opens the same underlying file into a different FileImpl in the
   // same process.
   // TODO PERF: Currently, we use a single cross process lock to serialize all disk writes. This
-  //            will never block network workers, but does mean that only a single flush thread can
-  //            actually flush to disk. In the future it would be nice if we did away with the cross
-  //            process lock or had multiple locks.
+  //            will never block network workers, but does mean that only a single file can
+  //            actually be flushed to disk at a time. In the future it would be nice if we did away
+  //            with the cross process lock or had multiple locks, along with more flush threads.
   {
     std::lock_guard<Thread::BasicLockable> lock(file_lock_);
     for (Buffer::RawSlice& slice : slices) {
@@ -126,90 +242,95 @@ void FileImpl::doWrite(Buffer::Instance& buffer) {
   buffer.drain(buffer.length());
 }
 
-void FileImpl::flushThreadFunc() {
-
-  while (true) {
-    std::unique_lock<std::mutex> flush_lock;
+void FileImpl::collectPending() {
+  std::lock_guard<std::mutex> lock(rings_lock_);
+  for (const std::shared_ptr<WriteRing>& ring : rings_) {
+    ring->drainTo(about_to_write_buffer_);
+  }
+}
 
-    {
-      std::unique_lock<std::mutex> write_lock(write_lock_);
+void FileImpl::flushPending() {
+  std::lock_guard<std::mutex> flush_lock(flush_lock_);
 
-      // flush_event_ can be woken up either by large enough flush_buffer or by timer.
-      // In case it was timer, flush_buffer_ can be empty.
-      while (flush_buffer_.length() == 0 && !flush_thread_exit_) {
-        flush_event_.wait(write_lock);
-      }
+  // The file can be scheduled either by a full enough ring or by the timer. In case it was the
+  // timer, there can be nothing to write.
+  collectPending();
+  if (about_to_write_buffer_.length() == 0) {
+    return;
+  }
 
-      if (flush_thread_exit_) {
-        return;
+  // if we failed to open file before (-1 == fd_), then simply ignore
+  if (fd_ != -1) {
+    try {
+      if (reopen_file_) {
+        reopen_file_ = false;
+        os_sys_calls_.close(fd_);
+        open();
       }
 
-      flush_lock = std::unique_lock<std::mutex>(flush_lock_);
-      ASSERT(flush_buffer_.length() > 0);
-      about_to_write_buffer_.move(flush_buffer_);
-      ASSERT(flush_buffer_.length() == 0);
-    }
-
-    // if we failed to open file before (-1 == fd_), then simply ignore
-    if (fd_ != -1) {
-      try {
-        if (reopen_file_) {
-          reopen_file_ = false;
-          os_sys_calls_.close(fd_);
-          open();
-        }
-
-        doWrite(about_to_write_buffer_);
-      } catch (const EnvoyException&) {
-        stats_.reopen_failed_.inc();
-      }
+      doWrite(about_to_write_buffer_);
+    } catch (const EnvoyException&) {
+      stats_.reopen_failed_.inc();
     }
   }
 }
 
 void FileImpl::flush() {
-  std::unique_lock<std::mutex> flush_buffer_lock;
-
-  {
-    std::lock_guard<std::mutex> write_lock(write_lock_);
-
-    // flush_lock_ must be held while checking this or else it is
-    // possible that flushThreadFunc() has already moved data from
-    // flush_buffer_ to about_to_write_buffer_, has unlocked write_lock_,
-    // but has not yet completed doWrite(). This would allow flush() to
-    // return before the pending data has actually been written to disk.
-    flush_buffer_lock = std::unique_lock<std::mutex>(flush_lock_);
+  // flush_lock_ is held until the write completes or else it is possible that flushThreadFunc()
+  // has already moved data from the rings to about_to_write_buffer_ but has not yet completed
+  // doWrite(). This would allow flush() to return before the pending data has actually been
+  // written to disk.
+  std::lock_guard<std::mutex> flush_lock(flush_lock_);
+
+  collectPending();
+  if (about_to_write_buffer_.length() == 0) {
+    return;
+  }
 
-    if (flush_buffer_.length() == 0) {
-      return;
-    }
+  doWrite(about_to_write_buffer_);
+}
 
-    about_to_write_buffer_.move(flush_buffer_);
-    ASSERT(flush_buffer_.length() == 0);
+WriteRing& FileImpl::localRing() {
+  // Rings are looked up by file id rather than by address, so that a file allocated where a
+  // destroyed one used to be does not find the ring of the destroyed one.
+  static thread_local std::unordered_map<uint64_t, std::weak_ptr<WriteRing>> local_rings;
+  auto it = local_rings.find(id_);
+  if (it != local_rings.end()) {
+    // The file owns the ring, so it is alive for as long as the file is being written to.
+    return *it->second.lock();
   }
 
-  doWrite(about_to_write_buffer_);
+  // First write from this thread. Forget the rings of destroyed files while here.
+  for (auto expired = local_rings.begin(); expired != local_rings.end();) {
+    expired = expired->second.expired() ? local_rings.erase(expired) : std::next(expired);
+  }
+  std::shared_ptr<WriteRing> ring = std::make_shared<WriteRing>(write_buffer_bytes_);
+  {
+    std::lock_guard<std::mutex> lock(rings_lock_);
+    rings_.push_back(ring);
+  }
+  local_rings.emplace(id_, ring);
+  return *ring;
 }
 
 void FileImpl::write(const std::string& data) {
-  std::lock_guard<std::mutex> lock(write_lock_);
+  if (!flush_timer_enabled_.load(std::memory_order_relaxed) &&
+      !flush_timer_enabled_.exchange(true)) {
+    flush_timer_->enableTimer(flush_interval_msec_);
+  }
 
-  if (flush_thread_ == nullptr) {
-    createFlushStructures();
+  WriteRing& ring = localRing();
+  if (!ring.push(data)) {
+    stats_.write_dropped_.inc();
+    return;
   }
 
   stats_.write_buffered_.inc();
   stats_.write_total_buffered_.add(data.length());
-  flush_buffer_.add(data);
-  if (flush_buffer_.length() > MIN_FLUSH_SIZE) {
-    flush_event_.notify_one();
+  if (ring.size() > flush_threshold_) {
+    flush_executor_.schedule(*this);
   }
 }
 
-void FileImpl::createFlushStructures() {
-  flush_thread_.reset(new Thread::Thread([this]() -> void { flushThreadFunc(); }));
-  flush_timer_->enableTimer(flush_interval_msec_);
-}
-
 } // namespace Filesystem
 } // namespace Envoy
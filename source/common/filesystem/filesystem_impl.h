@@ -4,8 +4,11 @@
 #include <chrono>
 #include <condition_variable>
 #include <cstdint>
+#include <deque>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <vector>
 
 #include "envoy/api/os_sys_calls.h"
 #include "envoy/event/dispatcher.h"
@@ -19,6 +22,7 @@ namespace Envoy {
 // clang-format off
 #define FILESYSTEM_STATS(COUNTER, GAUGE)                                                           \
   COUNTER(write_buffered)                                                                          \
+  COUNTER(write_dropped)                                                                           \
   COUNTER(write_completed)                                                                         \
   COUNTER(flushed_by_timer)                                                                        \
   COUNTER(reopen_failed)                                                                           \
@@ -47,17 +51,92 @@ bool directoryExists(const std::string& path);
  */
 std::string fileReadToEnd(const std::string& path);
 
+class FileImpl;
+
+/**
+ * Bounded queue of bytes for a single producer and a single consumer thread. The producer appends
+ * with push() while the consumer takes everything queued so far with drainTo(), without either of
+ * them taking a lock or waiting on the other.
+ */
+class WriteRing {
+public:
+  WriteRing(uint64_t capacity);
+
+  /**
+   * Append data, unless it does not fit in the space left. Only called by the producer.
+   * @return bool whether data was queued.
+   */
+  bool push(const std::string& data);
+
+  /**
+   * Move everything queued so far into output. Only called by the consumer.
+   * @return uint64_t the number of bytes moved.
+   */
+  uint64_t drainTo(Buffer::Instance& output);
+
+  /**
+   * @return uint64_t the number of bytes queued.
+   */
+  uint64_t size() const;
+
+private:
+  const uint64_t capacity_;
+  std::unique_ptr<char[]> data_;
+  std::atomic<uint64_t> head_{}; // Total bytes ever drained. Only written by the consumer.
+  std::atomic<uint64_t> tail_{}; // Total bytes ever pushed. Only written by the producer.
+};
+
+/**
+ * Flushes the buffered data of any number of FileImpl instances from a single thread. All disk
+ * writes are serialized by the cross process file lock anyway, so one thread for every file
+ * loses no write parallelism, while a process with hundreds of access logs no longer runs a
+ * thread per file. Each time the thread wakes up it flushes every file that has been scheduled
+ * since, one after another.
+ */
+class FlushExecutor {
+public:
+  ~FlushExecutor();
+
+  /**
+   * Queue a file for flushing on the flush thread, starting the thread if needed. Scheduling a
+   * file that is already queued is a no-op.
+   */
+  void schedule(FileImpl& file);
+
+  /**
+   * Remove a file from the queue, waiting for an in progress flush of it to complete. The file
+   * must not be scheduled again after this returns.
+   */
+  void cancel(FileImpl& file);
+
+private:
+  void flushThreadFunc();
+
+  std::mutex lock_;
+  std::condition_variable work_event_;       // Signalled when a file is queued or on exit.
+  std::condition_variable flush_done_event_; // Signalled when the flush of current_ completes.
+  std::deque<FileImpl*> pending_;
+  FileImpl* current_{};
+  bool exit_{};
+  Thread::ThreadPtr flush_thread_;
+};
+
 /**
  * This is a file implementation geared for writing out access logs. It turn out that in certain
  * cases even if a standard file is opened with O_NONBLOCK, the kernel can still block when writing.
- * This implementation uses a flush thread per file, with the idea there there aren't that many
- * files. If this turns out to be a good implementation we can potentially have a single flush
- * thread that flushes all files, but we will start with this.
+ * This implementation buffers writes and hands the actual disk writes to a FlushExecutor thread
+ * that is shared by all files.
+ *
+ * Every thread that writes to the file buffers its writes in a WriteRing of its own, so that
+ * writers never contend with each other or with the flush thread. A write that does not fit in
+ * the ring of its thread is dropped and counted rather than blocking the writer. Data written by
+ * different threads is only ordered per thread.
  */
 class FileImpl : public File {
 public:
   FileImpl(const std::string& path, Event::Dispatcher& dispatcher, Thread::BasicLockable& lock,
-           Stats::Store& stats_store, std::chrono::milliseconds flush_interval_msec);
+           FlushExecutor& flush_executor, Stats::Store& stats_store,
+           std::chrono::milliseconds flush_interval_msec, uint64_t write_buffer_bytes);
   ~FileImpl();
 
   // Filesystem::File
@@ -74,21 +153,24 @@ public:
   // Fileystem::File
   void flush() override;
 
+  // Minimum size a ring fills up to before the file is scheduled on the flush thread. Also the
+  // smallest write buffer the server accepts.
+  static const uint64_t MIN_FLUSH_SIZE = 1024 * 64;
+
 private:
+  void collectPending();
   void doWrite(Buffer::Instance& buffer);
-  void flushThreadFunc();
+  void flushPending();
+  WriteRing& localRing();
   void open();
-  void createFlushStructures();
-
-  // Minimum size before the flush thread will be told to flush.
-  static const uint64_t MIN_FLUSH_SIZE = 1024 * 64;
 
   int fd_;
   std::string path_;
+  const uint64_t id_; // Unique for the life of the process. Threads find their ring by it.
 
   // These locks are always acquired in the following order if multiple locks are held:
-  //    1) write_lock_
-  //    2) flush_lock_
+  //    1) flush_lock_
+  //    2) rings_lock_
   //    3) file_lock_
   Thread::BasicLockable& file_lock_; // This lock is used only by the flush thread when writing
                                      // to disk. This is used to make sure that file blocks do
@@ -98,28 +180,30 @@ private:
                                      // the flush thread and a syncronous flush. This protects
                                      // concurrent access to the about_to_write_buffer_, fd_,
                                      // and all other data used during flushing and file
-                                     // re-opening.
-  std::mutex write_lock_;            // The lock is used when filling the flush buffer. It allows
-                                     // multiple threads to write to the same file at relatively
-                                     // high performance. It is always local to the process.
-  Thread::ThreadPtr flush_thread_;
-  std::condition_variable_any flush_event_;
-  std::atomic<bool> flush_thread_exit_{};
+                                     // re-opening, and makes the flushing thread the single
+                                     // consumer of every ring.
+  std::mutex rings_lock_;            // This lock protects rings_. Writers only take it the first
+                                     // time they write to the file.
+  FlushExecutor& flush_executor_;
+  std::atomic<bool> flush_scheduled_{}; // Whether the file is queued on flush_executor_. Only
+                                        // changed under the executor's lock.
+  std::atomic<bool> flush_timer_enabled_{};
   std::atomic<bool> reopen_file_{};
-  Buffer::OwnedImpl flush_buffer_; // This buffer is used by multiple threads. It gets filled and
-                                   // then flushed either when max size is reached or when a timer
-                                   // fires.
-  Buffer::OwnedImpl about_to_write_buffer_; // This buffer is used only by the flush thread. Data
-                                            // is moved from flush_buffer_ under lock, and then
-                                            // the lock is released so that flush_buffer_ can
-                                            // continue to fill. This buffer is then used for the
-                                            // final write to disk.
+  const uint64_t write_buffer_bytes_; // Capacity of the ring of each writing thread.
+  const uint64_t flush_threshold_;    // Ring size at which the file is scheduled for flushing.
+  std::vector<std::shared_ptr<WriteRing>> rings_; // One per thread that wrote to the file.
+  Buffer::OwnedImpl about_to_write_buffer_; // This buffer is used only while flushing. Data
+                                            // is moved from the rings into it under flush_lock_,
+                                            // while the writers continue to fill the rings. This
+                                            // buffer is then used for the final write to disk.
   Event::TimerPtr flush_timer_;
   Api::OsSysCalls& os_sys_calls_;
   const std::chrono::milliseconds flush_interval_msec_; // Time interval buffer gets flushed no
                                                         // matter if it reached the MIN_FLUSH_SIZE
                                                         // or not.
   FileSystemStats stats_;
+
+  friend class FlushExecutor;
 };
 
 } // namespace Filesystem
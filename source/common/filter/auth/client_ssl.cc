@@ -3,6 +3,8 @@
 #include <chrono>
 #include <cstdint>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "envoy/network/connection.h"
 
@@ -20,13 +22,32 @@ namespace Filter {
 namespace Auth {
 namespace ClientSsl {
 
+namespace {
+
+std::vector<std::pair<std::string, std::vector<Network::Address::CidrRange>>>
+whiteListTagData(const Protobuf::RepeatedPtrField<envoy::api::v2::CidrRange>& cidrs) {
+  std::vector<Network::Address::CidrRange> ranges;
+  for (const envoy::api::v2::CidrRange& entry : cidrs) {
+    Network::Address::CidrRange range = Network::Address::CidrRange::create(entry);
+    if (!range.isValid()) {
+      throw EnvoyException(
+          fmt::format("invalid ip/mask combo '{}/{}' (format is <ip>/<# mask bits>)",
+                      entry.address_prefix(), entry.prefix_len().value()));
+    }
+    ranges.push_back(range);
+  }
+  return {{"white_list", std::move(ranges)}};
+}
+
+} // namespace
+
 Config::Config(const envoy::api::v2::filter::network::ClientSSLAuth& config,
                ThreadLocal::SlotAllocator& tls, Upstream::ClusterManager& cm,
                Event::Dispatcher& dispatcher, Stats::Scope& scope, Runtime::RandomGenerator& random)
     : RestApiFetcher(
           cm, config.auth_api_cluster(), dispatcher, random,
           std::chrono::milliseconds(PROTOBUF_GET_MS_OR_DEFAULT(config, refresh_delay, 60000))),
-      tls_(tls.allocateSlot()), ip_white_list_(config.ip_white_list()),
+      tls_(tls.allocateSlot()), ip_white_list_(whiteListTagData(config.ip_white_list())),
       stats_(generateStats(scope, config.stat_prefix())) {
 
   if (!cm.get(remote_cluster_name_)) {
@@ -68,10 +89,15 @@ void Config::parseResponse(const Http::Message& message) {
     return new_principals;
   });
 
+  const Http::HeaderEntry* etag = message.headers().get(Http::Headers::get().Etag);
+  etag_ = etag != nullptr ? std::string(etag->value().c_str()) : "";
+
   stats_.update_success_.inc();
   stats_.total_principals_.set(new_principals->size());
 }
 
+void Config::onFetchNotModified() { stats_.update_not_modified_.inc(); }
+
 void Config::onFetchFailure(const EnvoyException*) { stats_.update_failure_.inc(); }
 
 static const std::string Path = "/v1/certs/list/approved";
@@ -79,6 +105,9 @@ static const std::string Path = "/v1/certs/list/approved";
 void Config::createRequest(Http::Message& request) {
   request.headers().insertMethod().value().setReference(Http::Headers::get().MethodValues.Get);
   request.headers().insertPath().value(Path);
+  if (!etag_.empty()) {
+    request.headers().addCopy(Http::Headers::get().IfNoneMatch, etag_);
+  }
 }
 
 Network::FilterStatus Instance::onData(Buffer::Instance&) {
@@ -103,7 +132,7 @@ void Instance::onEvent(Network::ConnectionEvent event) {
   }
 
   ASSERT(read_callbacks_->connection().ssl());
-  if (config_->ipWhiteList().contains(*read_callbacks_->connection().remoteAddress())) {
+  if (config_->ipWhiteListed(*read_callbacks_->connection().remoteAddress())) {
     config_->stats().auth_ip_white_list_.inc();
     read_callbacks_->continueReading();
     return;
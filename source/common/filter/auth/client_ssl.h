@@ -13,6 +13,7 @@
 
 #include "common/http/rest_api_fetcher.h"
 #include "common/network/cidr_range.h"
+#include "common/network/lc_trie.h"
 #include "common/network/utility.h"
 #include "common/protobuf/utility.h"
 
@@ -30,6 +31,7 @@ namespace ClientSsl {
 #define ALL_CLIENT_SSL_AUTH_STATS(COUNTER, GAUGE)                                                  \
   COUNTER(update_success)                                                                          \
   COUNTER(update_failure)                                                                          \
+  COUNTER(update_not_modified)                                                                     \
   COUNTER(auth_no_ssl)                                                                             \
   COUNTER(auth_ip_white_list)                                                                      \
   COUNTER(auth_digest_match)                                                                       \
@@ -71,7 +73,8 @@ typedef std::shared_ptr<Config> ConfigSharedPtr;
 /**
  * Global configuration for client SSL authentication. The config contacts a JSON API to fetch the
  * list of allowed principals, caches it, then makes auth decisions on it and any associated IP
- * white list.
+ * white list. Refreshes are conditional on the ETag of the last list, so that an unchanged list is
+ * neither sent again nor parsed again.
  */
 class Config : public Http::RestApiFetcher {
 public:
@@ -81,7 +84,13 @@ public:
                                 Runtime::RandomGenerator& random);
 
   const AllowedPrincipals& allowedPrincipals();
-  const Network::Address::IpList& ipWhiteList() { return ip_white_list_; }
+  /**
+   * @param address supplies the address to check.
+   * @return bool whether the address is in the IP white list.
+   */
+  bool ipWhiteListed(const Network::Address::Instance& address) const {
+    return !ip_white_list_.getTags(address).empty();
+  }
   GlobalStats& stats() { return stats_; }
 
 private:
@@ -94,12 +103,17 @@ private:
   // Http::RestApiFetcher
   void createRequest(Http::Message& request) override;
   void parseResponse(const Http::Message& response) override;
+  void onFetchNotModified() override;
   void onFetchComplete() override {}
   void onFetchFailure(const EnvoyException* e) override;
 
   ThreadLocal::SlotPtr tls_;
-  Network::Address::IpList ip_white_list_;
+  // The white list is kept in an LC-trie with a single tag, so that lookups do not depend on the
+  // number of ranges.
+  const Network::LcTrie::LcTrie ip_white_list_;
   GlobalStats stats_;
+  // The ETag of the last list of principals, if the API returned one.
+  std::string etag_;
 };
 
 /**
@@ -1,5 +1,7 @@
 #include "common/filter/tcp_proxy.h"
 
+#include <algorithm>
+#include <chrono>
 #include <cstdint>
 #include <string>
 
@@ -38,8 +40,9 @@ TcpProxyConfig::Route::Route(
 
 TcpProxyConfig::TcpProxyConfig(const envoy::api::v2::filter::network::TcpProxy& config,
                                Server::Configuration::FactoryContext& context)
-    : stats_(generateStats(config.stat_prefix(), context.scope())),
-      max_connect_attempts_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, max_connect_attempts, 1)) {
+    : runtime_(context.runtime()), stats_(generateStats(config.stat_prefix(), context.scope())),
+      max_connect_attempts_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, max_connect_attempts, 1)),
+      conn_pool_(context.clusterManager(), context.runtime(), context.threadLocal()) {
 
   if (config.has_idle_timeout()) {
     idle_timeout_.value(std::chrono::milliseconds(
@@ -99,7 +102,100 @@ const std::string& TcpProxyConfig::getRouteFromEntries(Network::Connection& conn
   return EMPTY_STRING;
 }
 
-// TODO(ggreenway): refactor this and websocket code so that config_ is always non-null.
+TcpProxyConnPool::TcpProxyConnPool(Upstream::ClusterManager& cluster_manager,
+                                   Runtime::Loader& runtime, ThreadLocal::SlotAllocator& tls)
+    : cluster_manager_(cluster_manager), runtime_(runtime), tls_(tls.allocateSlot()) {
+  tls_->set([](Event::Dispatcher& dispatcher) -> ThreadLocal::ThreadLocalObjectSharedPtr {
+    return std::make_shared<ThreadLocalPool>(dispatcher);
+  });
+}
+
+Upstream::Host::CreateConnectionData TcpProxyConnPool::take(const std::string& cluster_name) {
+  Upstream::Host::CreateConnectionData data{nullptr, nullptr};
+  const Runtime::Snapshot& snapshot = runtime_.snapshot();
+  const uint64_t target_size = snapshot.getInteger("tcp_proxy.conn_pool.target_size", 0);
+  if (target_size == 0) {
+    return data;
+  }
+
+  Upstream::ThreadLocalCluster* cluster = cluster_manager_.get(cluster_name);
+  if (cluster == nullptr ||
+      cluster->info()->lbType() == Upstream::LoadBalancerType::OriginalDst) {
+    return data;
+  }
+
+  ThreadLocalPool& pool = tls_->getTyped<ThreadLocalPool>();
+  std::list<ActiveConnPtr>& conns = pool.clusters_[cluster_name];
+  auto ready = std::find_if(conns.begin(), conns.end(),
+                            [](const ActiveConnPtr& conn) -> bool { return conn->connected_; });
+  if (ready != conns.end()) {
+    data = (*ready)->release();
+    conns.erase(ready);
+  }
+
+  const std::chrono::milliseconds max_idle(
+      snapshot.getInteger("tcp_proxy.conn_pool.max_idle_ms", 60000));
+  Upstream::ResourceManager& resources =
+      cluster->info()->resourceManager(Upstream::ResourcePriority::Default);
+  while (conns.size() < target_size && resources.connections().canCreate()) {
+    Upstream::Host::CreateConnectionData new_data =
+        cluster_manager_.tcpConnForCluster(cluster_name, nullptr);
+    if (!new_data.connection_) {
+      break;
+    }
+
+    ActiveConnPtr conn(new ActiveConn(pool, conns, std::move(new_data),
+                                      cluster->info()->connectTimeout(), max_idle));
+    conn->moveIntoListBack(std::move(conn), conns);
+  }
+
+  return data;
+}
+
+TcpProxyConnPool::ActiveConn::ActiveConn(ThreadLocalPool& pool, std::list<ActiveConnPtr>& conns,
+                                         Upstream::Host::CreateConnectionData&& data,
+                                         std::chrono::milliseconds connect_timeout,
+                                         std::chrono::milliseconds max_idle)
+    : pool_(pool), conns_(conns), data_(std::move(data)), max_idle_(max_idle) {
+  data_.connection_->addConnectionCallbacks(*this);
+  // Nothing reads from the connection until a session takes it, but a close by the host is still
+  // noticed.
+  data_.connection_->readDisable(true);
+  data_.connection_->connect();
+  data_.connection_->noDelay(true);
+  timer_ = pool_.dispatcher_.createTimer(
+      [this]() -> void { data_.connection_->close(Network::ConnectionCloseType::NoFlush); });
+  timer_->enableTimer(connect_timeout);
+}
+
+TcpProxyConnPool::ActiveConn::~ActiveConn() {
+  if (data_.connection_ != nullptr) {
+    data_.connection_->removeConnectionCallbacks(*this);
+    data_.connection_->close(Network::ConnectionCloseType::NoFlush);
+  }
+}
+
+Upstream::Host::CreateConnectionData TcpProxyConnPool::ActiveConn::release() {
+  timer_->disableTimer();
+  data_.connection_->removeConnectionCallbacks(*this);
+  data_.connection_->readDisable(false);
+  return std::move(data_);
+}
+
+void TcpProxyConnPool::ActiveConn::onEvent(Network::ConnectionEvent event) {
+  if (event == Network::ConnectionEvent::Connected) {
+    connected_ = true;
+    timer_->enableTimer(max_idle_);
+    return;
+  }
+
+  // The connection failed, timed out, or was closed by the host while it was ready.
+  ENVOY_CONN_LOG(debug, "removing pooled connection", *data_.connection_);
+  timer_->disableTimer();
+  pool_.dispatcher_.deferredDelete(removeFromList(conns_));
+}
+
+// TODO(ggreenway): config_ is only null in tests, make it always non-null.
 TcpProxy::TcpProxy(TcpProxyConfigSharedPtr config, Upstream::ClusterManager& cluster_manager)
     : config_(config), cluster_manager_(cluster_manager), downstream_callbacks_(*this),
       upstream_callbacks_(new UpstreamCallbacks(*this)) {}
@@ -160,7 +256,7 @@ void TcpProxy::initializeReadFilterCallbacks(Network::ReadFilterCallbacks& callb
       {config_->stats().downstream_cx_rx_bytes_total_,
        config_->stats().downstream_cx_rx_bytes_buffered_,
        config_->stats().downstream_cx_tx_bytes_total_,
-       config_->stats().downstream_cx_tx_bytes_buffered_, nullptr});
+       config_->stats().downstream_cx_tx_bytes_buffered_, nullptr, nullptr, nullptr, nullptr});
 }
 
 void TcpProxy::readDisableUpstream(bool disable) {
@@ -187,7 +283,6 @@ void TcpProxy::readDisableUpstream(bool disable) {
 
 void TcpProxy::readDisableDownstream(bool disable) {
   read_callbacks_->connection().readDisable(disable);
-  // The WsHandlerImpl class uses TCP Proxy code with a null config.
   if (!config_) {
     return;
   }
@@ -259,8 +354,15 @@ Network::FilterStatus TcpProxy::initializeUpstreamConnection() {
     return Network::FilterStatus::StopIteration;
   }
 
-  Upstream::Host::CreateConnectionData conn_info =
-      cluster_manager_.tcpConnForCluster(cluster_name, this);
+  // Sessions start right away on connections that were established ahead of time.
+  Upstream::Host::CreateConnectionData conn_info{nullptr, nullptr};
+  if (config_ != nullptr) {
+    conn_info = config_->connPool().take(cluster_name);
+  }
+  const bool pooled = conn_info.connection_ != nullptr;
+  if (!pooled) {
+    conn_info = cluster_manager_.tcpConnForCluster(cluster_name, this);
+  }
 
   upstream_connection_ = std::move(conn_info.connection_);
   read_callbacks_->upstreamHost(conn_info.host_description_);
@@ -280,16 +382,21 @@ Network::FilterStatus TcpProxy::initializeUpstreamConnection() {
        read_callbacks_->upstreamHost()->cluster().stats().upstream_cx_rx_bytes_buffered_,
        read_callbacks_->upstreamHost()->cluster().stats().upstream_cx_tx_bytes_total_,
        read_callbacks_->upstreamHost()->cluster().stats().upstream_cx_tx_bytes_buffered_,
-       &read_callbacks_->upstreamHost()->cluster().stats().bind_errors_});
-  upstream_connection_->connect();
-  upstream_connection_->noDelay(true);
+       &read_callbacks_->upstreamHost()->cluster().stats().bind_errors_, nullptr, nullptr,
+       nullptr});
+  if (!pooled) {
+    upstream_connection_->connect();
+    upstream_connection_->noDelay(true);
+  }
   request_info_.onUpstreamHostSelected(conn_info.host_description_);
   request_info_.upstream_local_address_ = upstream_connection_->localAddress()->asString();
 
   ASSERT(connect_timeout_timer_ == nullptr);
-  connect_timeout_timer_ = read_callbacks_->connection().dispatcher().createTimer(
-      [this]() -> void { onConnectTimeout(); });
-  connect_timeout_timer_->enableTimer(cluster->connectTimeout());
+  if (!pooled) {
+    connect_timeout_timer_ = read_callbacks_->connection().dispatcher().createTimer(
+        [this]() -> void { onConnectTimeout(); });
+    connect_timeout_timer_->enableTimer(cluster->connectTimeout());
+  }
 
   read_callbacks_->upstreamHost()->cluster().stats().upstream_cx_total_.inc();
   read_callbacks_->upstreamHost()->cluster().stats().upstream_cx_active_.inc();
@@ -300,6 +407,11 @@ Network::FilterStatus TcpProxy::initializeUpstreamConnection() {
   connected_timespan_.reset(new Stats::Timespan(
       read_callbacks_->upstreamHost()->cluster().stats().upstream_cx_length_ms_));
 
+  if (pooled) {
+    config_->stats().downstream_cx_pooled_total_.inc();
+    onUpstreamEvent(Network::ConnectionEvent::Connected);
+  }
+
   return Network::FilterStatus::Continue;
 }
 
@@ -386,13 +498,36 @@ void TcpProxy::onUpstreamEvent(Network::ConnectionEvent event) {
     onConnectionSuccess();
 
     if (config_ != nullptr && config_->idleTimeout().valid()) {
-      idle_timer_ = read_callbacks_->connection().dispatcher().createTimer(
+      idle_timer_ = read_callbacks_->connection().dispatcher().createCoarseTimer(
           [this]() -> void { onIdleTimeout(); });
       resetIdleTimer();
       Network::Connection::BytesSentCb cb = [this](uint64_t) { resetIdleTimer(); };
       read_callbacks_->connection().addBytesSentCallback(cb);
       upstream_connection_->addBytesSentCallback(cb);
     }
+
+    if (config_ != nullptr && config_->spliceEnabled()) {
+      startSplicing();
+    }
+  }
+}
+
+void TcpProxy::startSplicing() {
+  // Spliced data never reaches onData() or onUpstreamData(), so it is accounted for here. Each
+  // direction falls back to buffers on its own if it cannot be spliced, e.g. because of TLS or
+  // other filters.
+  const bool downstream_spliced = read_callbacks_->connection().spliceTo(
+      *upstream_connection_, [this](uint64_t bytes) -> void {
+        request_info_.bytes_received_ += bytes;
+        resetIdleTimer();
+      });
+  const bool upstream_spliced =
+      upstream_connection_->spliceTo(read_callbacks_->connection(), [this](uint64_t bytes) -> void {
+        request_info_.bytes_sent_ += bytes;
+        resetIdleTimer();
+      });
+  if (downstream_spliced || upstream_spliced) {
+    config_->stats().downstream_cx_splice_total_.inc();
   }
 }
 
@@ -1,20 +1,28 @@
 #pragma once
 
+#include <chrono>
 #include <cstdint>
+#include <list>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "envoy/access_log/access_log.h"
+#include "envoy/event/deferred_deletable.h"
+#include "envoy/event/dispatcher.h"
 #include "envoy/event/timer.h"
 #include "envoy/network/connection.h"
 #include "envoy/network/filter.h"
+#include "envoy/runtime/runtime.h"
 #include "envoy/server/filter_config.h"
 #include "envoy/stats/stats_macros.h"
 #include "envoy/stats/timespan.h"
+#include "envoy/thread_local/thread_local.h"
 #include "envoy/upstream/cluster_manager.h"
 #include "envoy/upstream/upstream.h"
 
+#include "common/common/linked_object.h"
 #include "common/common/logger.h"
 #include "common/network/cidr_range.h"
 #include "common/network/filter_impl.h"
@@ -37,6 +45,8 @@ namespace Filter {
   GAUGE  (downstream_cx_tx_bytes_buffered)                                                         \
   COUNTER(downstream_cx_total)                                                                     \
   COUNTER(downstream_cx_no_route)                                                                  \
+  COUNTER(downstream_cx_pooled_total)                                                              \
+  COUNTER(downstream_cx_splice_total)                                                              \
   COUNTER(downstream_flow_control_paused_reading_total)                                            \
   COUNTER(downstream_flow_control_resumed_reading_total)                                           \
   COUNTER(idle_timeout)
@@ -49,6 +59,77 @@ struct TcpProxyStats {
   ALL_TCP_PROXY_STATS(GENERATE_COUNTER_STRUCT, GENERATE_GAUGE_STRUCT)
 };
 
+/**
+ * Per worker pools of established upstream connections, which new sessions take instead of waiting
+ * for connections of their own to be set up. The pools are configured via runtime:
+ *   tcp_proxy.conn_pool.target_size: how many connections each worker keeps ready for each
+ *     cluster. 0, the default, disables pooling.
+ *   tcp_proxy.conn_pool.max_idle_ms: how long a connection is kept ready before it is closed.
+ *
+ * A worker fills its pool for a cluster up whenever a session takes a connection from it, so that
+ * failed connections are replaced no faster than sessions arrive. The hosts of pooled connections
+ * are picked by the load balancer of the cluster without any session context, which is why
+ * clusters that use the original destination load balancer are never pooled. Pooled connections
+ * only count against the connection limit of the cluster once a session takes them.
+ */
+class TcpProxyConnPool : Logger::Loggable<Logger::Id::pool> {
+public:
+  TcpProxyConnPool(Upstream::ClusterManager& cluster_manager, Runtime::Loader& runtime,
+                   ThreadLocal::SlotAllocator& tls);
+
+  /**
+   * Take an established connection to a host of a cluster out of the pool of the calling worker,
+   * and fill the pool up again.
+   * @param cluster_name supplies the name of the cluster.
+   * @return the connection and its host. The connection is nullptr if none was ready, and has
+   *         neither callbacks nor stats otherwise.
+   */
+  Upstream::Host::CreateConnectionData take(const std::string& cluster_name);
+
+private:
+  struct ThreadLocalPool;
+
+  struct ActiveConn : public Network::ConnectionCallbacks,
+                      public LinkedObject<ActiveConn>,
+                      public Event::DeferredDeletable {
+    ActiveConn(ThreadLocalPool& pool, std::list<std::unique_ptr<ActiveConn>>& conns,
+               Upstream::Host::CreateConnectionData&& data,
+               std::chrono::milliseconds connect_timeout, std::chrono::milliseconds max_idle);
+    ~ActiveConn();
+
+    /**
+     * Hand the connection over to a session.
+     */
+    Upstream::Host::CreateConnectionData release();
+
+    // Network::ConnectionCallbacks
+    void onEvent(Network::ConnectionEvent event) override;
+    void onAboveWriteBufferHighWatermark() override {}
+    void onBelowWriteBufferLowWatermark() override {}
+
+    ThreadLocalPool& pool_;
+    std::list<std::unique_ptr<ActiveConn>>& conns_;
+    Upstream::Host::CreateConnectionData data_;
+    // Bounds the time the connection takes to connect first, and then the time it is kept ready.
+    Event::TimerPtr timer_;
+    const std::chrono::milliseconds max_idle_;
+    bool connected_{};
+  };
+
+  typedef std::unique_ptr<ActiveConn> ActiveConnPtr;
+
+  struct ThreadLocalPool : public ThreadLocal::ThreadLocalObject {
+    ThreadLocalPool(Event::Dispatcher& dispatcher) : dispatcher_(dispatcher) {}
+
+    Event::Dispatcher& dispatcher_;
+    std::unordered_map<std::string, std::list<ActiveConnPtr>> clusters_;
+  };
+
+  Upstream::ClusterManager& cluster_manager_;
+  Runtime::Loader& runtime_;
+  ThreadLocal::SlotPtr tls_;
+};
+
 /**
  * Filter configuration.
  */
@@ -71,6 +152,16 @@ public:
   const std::vector<AccessLog::InstanceSharedPtr>& accessLogs() { return access_logs_; }
   uint32_t maxConnectAttempts() const { return max_connect_attempts_; }
   const Optional<std::chrono::milliseconds>& idleTimeout() { return idle_timeout_; }
+  TcpProxyConnPool& connPool() { return conn_pool_; }
+
+  /**
+   * @return bool whether data should be spliced between the downstream and upstream connections
+   * within the kernel where they allow it, which the tcp_proxy.splice_enabled runtime feature
+   * controls.
+   */
+  bool spliceEnabled() const {
+    return runtime_.snapshot().featureEnabled("tcp_proxy.splice_enabled", 0);
+  }
 
 private:
   struct Route {
@@ -86,10 +177,12 @@ private:
   static TcpProxyStats generateStats(const std::string& name, Stats::Scope& scope);
 
   std::vector<Route> routes_;
+  Runtime::Loader& runtime_;
   const TcpProxyStats stats_;
   std::vector<AccessLog::InstanceSharedPtr> access_logs_;
   const uint32_t max_connect_attempts_;
   Optional<std::chrono::milliseconds> idle_timeout_;
+  TcpProxyConnPool conn_pool_;
 };
 
 typedef std::shared_ptr<TcpProxyConfig> TcpProxyConfigSharedPtr;
@@ -181,6 +274,7 @@ protected:
   void finalizeUpstreamConnectionStats();
   void closeUpstreamConnection();
   void onIdleTimeout();
+  void startSplicing();
   void resetIdleTimer();
   void disableIdleTimer();
 
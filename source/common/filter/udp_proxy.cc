@@ -0,0 +1,151 @@
+#include "common/filter/udp_proxy.h"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include "envoy/network/address.h"
+
+#include "common/common/assert.h"
+#include "common/common/hash.h"
+
+#include "fmt/format.h"
+
+namespace Envoy {
+namespace Filter {
+
+namespace {
+
+UdpProxyStats generateStats(const std::string& name, Stats::Scope& scope) {
+  const std::string final_prefix = fmt::format("udp.{}.", name);
+  return {ALL_UDP_PROXY_STATS(POOL_COUNTER_PREFIX(scope, final_prefix),
+                              POOL_GAUGE_PREFIX(scope, final_prefix))};
+}
+
+} // namespace
+
+size_t UdpProxy::PeerKeyHash::operator()(const PeerKey& key) const {
+  return HashUtil::xxHash64(reinterpret_cast<const char*>(&key.address_), key.length_);
+}
+
+UdpProxy::UdpProxy(Event::Dispatcher& dispatcher, Upstream::ClusterManager& cluster_manager,
+                   Stats::Scope& scope, const UdpProxyConfig& config)
+    : dispatcher_(dispatcher), cluster_manager_(cluster_manager), config_(config),
+      stats_(generateStats(config.stat_prefix_, scope)) {
+  ASSERT(config_.idle_timeout_.count() > 0);
+  // Sessions are closed between one and two idle timeouts after their last datagram.
+  idle_timer_ = dispatcher_.createTimer([this]() -> void { onIdleTimer(); });
+  idle_timer_->enableTimer(config_.idle_timeout_);
+}
+
+UdpProxy::~UdpProxy() { sessions_.clear(); }
+
+void UdpProxy::onData(const Network::UdpRecvData& data) {
+  ASSERT(listener_ != nullptr);
+  pending_rx_datagrams_++;
+
+  const PeerKey peer(data.peer_address_, data.peer_address_len_);
+  auto it = sessions_.find(peer);
+  Session* session = it != sessions_.end() ? it->second.get() : createSession(peer);
+  if (session != nullptr) {
+    session->write(data);
+  }
+}
+
+void UdpProxy::onReadComplete() {
+  stats_.downstream_rx_datagrams_.add(pending_rx_datagrams_);
+  pending_rx_datagrams_ = 0;
+}
+
+UdpProxy::Session* UdpProxy::createSession(const PeerKey& peer) {
+  Upstream::ThreadLocalCluster* cluster = cluster_manager_.get(config_.cluster_);
+  Upstream::HostConstSharedPtr host =
+      cluster != nullptr ? cluster->loadBalancer().chooseHost(nullptr) : nullptr;
+  if (host == nullptr) {
+    ENVOY_LOG(debug, "udp proxy: no upstream host in cluster '{}'", config_.cluster_);
+    stats_.downstream_sess_no_route_.inc();
+    return nullptr;
+  }
+
+  const int fd = host->address()->socket(Network::Address::SocketType::Datagram);
+  RELEASE_ASSERT(fd != -1);
+  // Connecting a datagram socket only sets its default destination, so it does not block.
+  if (host->address()->connect(fd) == -1) {
+    ENVOY_LOG(debug, "udp proxy: cannot connect to '{}': {}", host->address()->asString(),
+              strerror(errno));
+    ::close(fd);
+    stats_.downstream_sess_no_route_.inc();
+    return nullptr;
+  }
+
+  Session* session = new Session(*this, peer, host, fd);
+  sessions_.emplace(peer, SessionPtr{session});
+  return session;
+}
+
+void UdpProxy::onIdleTimer() {
+  const MonotonicTime now = std::chrono::steady_clock::now();
+  for (auto it = sessions_.begin(); it != sessions_.end();) {
+    if (now - it->second->last_activity_ >= config_.idle_timeout_) {
+      stats_.idle_timeout_.inc();
+      it = sessions_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  idle_timer_->enableTimer(config_.idle_timeout_);
+}
+
+UdpProxy::Session::Session(UdpProxy& parent, const PeerKey& peer,
+                           Upstream::HostConstSharedPtr host, int fd)
+    : last_activity_(std::chrono::steady_clock::now()), parent_(parent), peer_(peer),
+      host_(std::move(host)), fd_(fd) {
+  ENVOY_LOG(debug, "udp proxy: new session to {}", host_->address()->asString());
+  file_event_ = parent_.dispatcher_.createFileEvent(fd_, [this](uint32_t) { onReadReady(); },
+                                                    Event::FileTriggerType::Level,
+                                                    Event::FileReadyType::Read);
+  parent_.stats_.downstream_sess_total_.inc();
+  parent_.stats_.downstream_sess_active_.inc();
+}
+
+UdpProxy::Session::~Session() {
+  file_event_.reset();
+  ::close(fd_);
+  parent_.stats_.downstream_sess_active_.dec();
+}
+
+void UdpProxy::Session::write(const Network::UdpRecvData& data) {
+  last_activity_ = std::chrono::steady_clock::now();
+  if (::send(fd_, data.data_, data.length_, MSG_DONTWAIT) == -1) {
+    parent_.stats_.upstream_tx_errors_.inc();
+  }
+}
+
+void UdpProxy::Session::onReadReady() {
+  // Replies are queued on the listener and sent together once the socket is drained, or once per
+  // batch limit so that one busy session does not hold up the worker.
+  Network::UdpRecvBatch& batch = parent_.recv_batch_;
+  uint64_t received = 0;
+  for (uint32_t i = 0; i < Network::UdpListenerImpl::MAX_BATCHES_PER_SOCKET_EVENT; i++) {
+    const uint32_t count = batch.recv(fd_);
+    for (uint32_t j = 0; j < count; j++) {
+      const Network::UdpRecvData data = batch.datagram(j);
+      parent_.listener_->send(peer_.address_, peer_.length_, data.data_, data.length_);
+    }
+    received += count;
+    if (count < Network::UdpRecvBatch::MAX_DATAGRAMS && batch.truncated() == 0) {
+      break;
+    }
+  }
+
+  parent_.listener_->flush();
+  if (received > 0) {
+    last_activity_ = std::chrono::steady_clock::now();
+    parent_.stats_.upstream_rx_datagrams_.add(received);
+  }
+}
+
+} // namespace Filter
+} // namespace Envoy
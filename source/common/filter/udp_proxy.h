@@ -0,0 +1,146 @@
+#pragma once
+
+#include <sys/socket.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "envoy/common/time.h"
+#include "envoy/event/dispatcher.h"
+#include "envoy/event/file_event.h"
+#include "envoy/event/timer.h"
+#include "envoy/network/listener.h"
+#include "envoy/stats/stats_macros.h"
+#include "envoy/upstream/cluster_manager.h"
+
+#include "common/common/logger.h"
+#include "common/network/udp_listener_impl.h"
+
+namespace Envoy {
+namespace Filter {
+
+/**
+ * All udp proxy stats. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_UDP_PROXY_STATS(COUNTER, GAUGE)                                                        \
+  COUNTER(downstream_sess_total)                                                                   \
+  GAUGE  (downstream_sess_active)                                                                  \
+  COUNTER(downstream_sess_no_route)                                                                \
+  COUNTER(downstream_rx_datagrams)                                                                 \
+  COUNTER(upstream_rx_datagrams)                                                                   \
+  COUNTER(upstream_tx_errors)                                                                      \
+  COUNTER(idle_timeout)
+// clang-format on
+
+/**
+ * Struct definition for all udp proxy stats. @see stats_macros.h
+ */
+struct UdpProxyStats {
+  ALL_UDP_PROXY_STATS(GENERATE_COUNTER_STRUCT, GENERATE_GAUGE_STRUCT)
+};
+
+/**
+ * Proxy configuration.
+ */
+struct UdpProxyConfig {
+  // The cluster datagrams are proxied to.
+  std::string cluster_;
+  // Sessions that see no datagram in either direction for this long are closed.
+  std::chrono::milliseconds idle_timeout_;
+  // The prefix of the stats, e.g. "dns".
+  std::string stat_prefix_;
+};
+
+/**
+ * Proxies the datagrams of a UDP listener to a cluster. Each downstream peer gets a session with
+ * its own connected upstream socket, so that replies can be sent back to the peer they are for.
+ * Sessions are keyed by the address of the peer, which with the local address of the listener
+ * makes up the 4-tuple of the datagrams, and are closed once idle.
+ *
+ * There is a proxy per worker, each on the worker's own listen socket, which SO_REUSEPORT spreads
+ * the peers over.
+ */
+class UdpProxy : public Network::UdpListenerCallbacks, Logger::Loggable<Logger::Id::filter> {
+public:
+  UdpProxy(Event::Dispatcher& dispatcher, Upstream::ClusterManager& cluster_manager,
+           Stats::Scope& scope, const UdpProxyConfig& config);
+  ~UdpProxy();
+
+  /**
+   * Set the listener that datagrams are read from and replies are sent on. Must be called before
+   * the listener reads any datagram.
+   */
+  void setListener(Network::UdpListener& listener) { listener_ = &listener; }
+
+  /**
+   * @return uint64_t the number of sessions.
+   */
+  uint64_t numSessions() const { return sessions_.size(); }
+
+  // Network::UdpListenerCallbacks
+  void onData(const Network::UdpRecvData& data) override;
+  void onReadComplete() override;
+
+private:
+  struct PeerKey {
+    PeerKey(const sockaddr_storage& address, socklen_t length) : length_(length) {
+      memcpy(&address_, &address, length);
+    }
+
+    bool operator==(const PeerKey& other) const {
+      return length_ == other.length_ && memcmp(&address_, &other.address_, length_) == 0;
+    }
+
+    sockaddr_storage address_;
+    socklen_t length_;
+  };
+
+  struct PeerKeyHash {
+    size_t operator()(const PeerKey& key) const;
+  };
+
+  class Session : Logger::Loggable<Logger::Id::filter> {
+  public:
+    Session(UdpProxy& parent, const PeerKey& peer, Upstream::HostConstSharedPtr host, int fd);
+    ~Session();
+
+    void write(const Network::UdpRecvData& data);
+
+    MonotonicTime last_activity_;
+
+  private:
+    void onReadReady();
+
+    UdpProxy& parent_;
+    const PeerKey peer_;
+    const Upstream::HostConstSharedPtr host_;
+    const int fd_;
+    Event::FileEventPtr file_event_;
+  };
+
+  typedef std::unique_ptr<Session> SessionPtr;
+
+  Session* createSession(const PeerKey& peer);
+  void onIdleTimer();
+
+  Event::Dispatcher& dispatcher_;
+  Upstream::ClusterManager& cluster_manager_;
+  const UdpProxyConfig config_;
+  UdpProxyStats stats_;
+  Network::UdpListener* listener_{};
+  std::unordered_map<PeerKey, SessionPtr, PeerKeyHash> sessions_;
+  // Shared by the upstream sockets of all sessions, which are read one after the other.
+  Network::UdpRecvBatch recv_batch_;
+  // Sweeps idle sessions, so that datagrams do not need to touch a timer each.
+  Event::TimerPtr idle_timer_;
+  // Datagrams read since the last onReadComplete(), which are added to the stats at once.
+  uint64_t pending_rx_datagrams_{};
+};
+
+} // namespace Filter
+} // namespace Envoy
@@ -180,9 +180,16 @@ public:
     streamError(Status::GrpcStatus::Internal);
   }
 
+  // The owner learns about this through isAboveWriteBufferHighWatermark().
+  void onAboveWriteBufferHighWatermark() override {}
+  void onBelowWriteBufferLowWatermark() override {}
+
   // Grpc::AsyncStream
   void sendMessage(const RequestType& request, bool end_stream) override {
-    stream_->sendData(*Common::serializeBody(request), end_stream);
+    // The buffer is reused across messages. The router normally takes all of it.
+    Common::serializeBody(request, send_buffer_);
+    stream_->sendData(send_buffer_, end_stream);
+    send_buffer_.drain(send_buffer_.length());
     if (end_stream) {
       closeLocal();
     }
@@ -202,6 +209,10 @@ public:
     cleanup();
   }
 
+  bool isAboveWriteBufferHighWatermark() const override {
+    return stream_ != nullptr && stream_->isAboveWriteBufferHighWatermark();
+  }
+
   bool hasResetStream() const { return http_reset_; }
 
 private:
@@ -245,6 +256,7 @@ private:
 
   Event::Dispatcher* dispatcher_{};
   Http::MessagePtr headers_message_;
+  Buffer::OwnedImpl send_buffer_;
   AsyncClientImpl<RequestType, ResponseType>& parent_;
   const Protobuf::MethodDescriptor& service_method_;
   AsyncStreamCallbacks<ResponseType>& callbacks_;
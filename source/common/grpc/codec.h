@@ -12,6 +12,8 @@ namespace Grpc {
 const uint8_t GRPC_FH_DEFAULT = 0b0u;
 // Last bit for a compressed message.
 const uint8_t GRPC_FH_COMPRESSED = 0b1u;
+// Size of the header in front of every GRPC data frame.
+const uint64_t GRPC_FRAME_HEADER_SIZE = 5;
 
 enum class CompressionAlgorithm { None, Gzip };
 
@@ -39,7 +41,10 @@ public:
   // Decodes the given buffer with GRPC data frame. Drains the input buffer when
   // decoding succeeded (returns true). If the input is not sufficient to make a
   // complete GRPC data frame, it will be buffered in the decoder. If a decoding
-  // error happened, the input buffer remains unchanged.
+  // error happened, the frames before the bad one are output and drained, and the
+  // input buffer holds the data from the start of the bad frame on.
+  // Frame data is moved out of the input rather than copied, so whole slices of
+  // the input become part of the frames.
   // @param input supplies the binary octets wrapped in a GRPC data frame.
   // @param output supplies the buffer to store the decoded data.
   // @return bool whether the decoding succeeded or not.
@@ -65,26 +70,17 @@ private:
   // "R" bits are reserved for future use.
   // The next four "L" bytes represent the message length in BigEndian format.
   enum class State {
-    // Waiting for decoding the flags (1 byte) of the GRPC data frame.
-    FH_FLAG,
-    // Waiting for decoding the 1st byte of the length (4 bytes in total) of the
-    // GRPC data frame.
-    FH_LEN_0,
-    // Waiting for decoding the 2nd byte of the length (4 bytes in total) of the
-    // GRPC data frame.
-    FH_LEN_1,
-    // Waiting for decoding the 3rd byte of the length (4 bytes in total) of the
-    // GRPC data frame.
-    FH_LEN_2,
-    // Waiting for decoding the 4th byte of the length (4 bytes in total) of the
-    // GRPC data frame.
-    FH_LEN_3,
-    // Waiting for decoding the data.
+    // Waiting for the rest of the frame header.
+    HEADER,
+    // Waiting for the rest of the frame data.
     DATA,
   };
 
   State state_;
   Frame frame_;
+  // The header of the current frame, which may arrive over several calls to decode().
+  std::array<uint8_t, GRPC_FRAME_HEADER_SIZE> header_;
+  uint64_t header_length_{};
 };
 } // namespace Grpc
 } // namespace Envoy
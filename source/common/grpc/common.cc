@@ -197,13 +197,18 @@ uint64_t Common::grpcToHttpStatus(Status::GrpcStatus grpc_status) {
 }
 
 Buffer::InstancePtr Common::serializeBody(const Protobuf::Message& message) {
+  Buffer::InstancePtr body(new Buffer::OwnedImpl());
+  serializeBody(message, *body);
+  return body;
+}
+
+void Common::serializeBody(const Protobuf::Message& message, Buffer::Instance& output) {
   // http://www.grpc.io/docs/guides/wire.html
   // Reserve enough space for the entire message and the 5 byte header.
-  Buffer::InstancePtr body(new Buffer::OwnedImpl());
   const uint32_t size = message.ByteSize();
   const uint32_t alloc_size = size + 5;
   Buffer::RawSlice iovec;
-  body->reserve(alloc_size, &iovec, 1);
+  output.reserve(alloc_size, &iovec, 1);
   ASSERT(iovec.len_ >= alloc_size);
   iovec.len_ = alloc_size;
   uint8_t* current = reinterpret_cast<uint8_t*>(iovec.mem_);
@@ -214,8 +219,7 @@ Buffer::InstancePtr Common::serializeBody(const Protobuf::Message& message) {
   Protobuf::io::ArrayOutputStream stream(current, size, -1);
   Protobuf::io::CodedOutputStream codec_stream(&stream);
   message.SerializeWithCachedSizes(&codec_stream);
-  body->commit(&iovec, 1);
-  return body;
+  output.commit(&iovec, 1);
 }
 
 Http::MessagePtr Common::prepareHeaders(const std::string& upstream_cluster,
@@ -112,6 +112,14 @@ public:
    */
   static Buffer::InstancePtr serializeBody(const Protobuf::Message& message);
 
+  /**
+   * Serialize protobuf message as a gRPC frame, directly into space reserved at the end of a
+   * buffer.
+   * @param message supplies the message.
+   * @param output supplies the buffer to append the frame to.
+   */
+  static void serializeBody(const Protobuf::Message& message, Buffer::Instance& output);
+
   /**
    * Prepare headers for protobuf service.
    */
@@ -4,6 +4,7 @@
 #include "envoy/http/filter.h"
 
 #include "common/common/assert.h"
+#include "common/common/empty_string.h"
 #include "common/common/enum_to_int.h"
 #include "common/common/utility.h"
 #include "common/filesystem/filesystem_impl.h"
@@ -37,6 +38,49 @@ namespace Grpc {
 
 namespace {
 
+// The dotted field paths of the variables in an HTTP path template, e.g. "shelf" and "book.id" in
+// "/shelves/{shelf}/books/{book.id=*}".
+std::vector<std::string> templateVariables(const std::string& path_template) {
+  std::vector<std::string> variables;
+  size_t start = path_template.find('{');
+  while (start != std::string::npos) {
+    const size_t end = path_template.find_first_of("=}", start);
+    if (end == std::string::npos) {
+      break;
+    }
+    variables.push_back(path_template.substr(start + 1, end - start - 1));
+    start = path_template.find('{', end);
+  }
+  return variables;
+}
+
+const std::string& httpRulePath(const google::api::HttpRule& rule) {
+  switch (rule.pattern_case()) {
+  case google::api::HttpRule::kGet:
+    return rule.get();
+  case google::api::HttpRule::kPut:
+    return rule.put();
+  case google::api::HttpRule::kPost:
+    return rule.post();
+  case google::api::HttpRule::kDelete:
+    return rule.delete_();
+  case google::api::HttpRule::kPatch:
+    return rule.patch();
+  case google::api::HttpRule::kCustom:
+    return rule.custom().path();
+  default:
+    return EMPTY_STRING;
+  }
+}
+
+std::string joinFieldPath(const std::vector<ProtobufTypes::String>& field_path) {
+  std::string joined;
+  for (const auto& field : field_path) {
+    joined += joined.empty() ? field : "." + field;
+  }
+  return joined;
+}
+
 // Transcoder:
 // https://github.com/grpc-ecosystem/grpc-httpjson-transcoding/blob/master/src/include/grpc_transcoding/transcoder.h
 // implementation based on JsonRequestTranslator & ResponseToJsonTranslator
@@ -98,7 +142,11 @@ JsonTranscoderConfig::JsonTranscoderConfig(
     }
   }
 
-  PathMatcherBuilder<const Protobuf::MethodDescriptor*> pmb;
+  type_helper_.reset(
+      new google::grpc::transcoding::TypeHelper(Protobuf::util::NewTypeResolverForDescriptorPool(
+          Common::typeUrlPrefix(), &descriptor_pool_)));
+
+  PathMatcherBuilder<const MethodInfo*> pmb;
 
   for (const auto& service_name : proto_config.services()) {
     auto service = descriptor_pool_.FindServiceByName(service_name);
@@ -108,8 +156,9 @@ JsonTranscoderConfig::JsonTranscoderConfig(
     }
     for (int i = 0; i < service->method_count(); ++i) {
       auto method = service->method(i);
+      methods_.emplace_back(createMethodInfo(method));
       if (!PathMatcherUtility::RegisterByHttpRule(
-              pmb, method->options().GetExtension(google::api::http), method)) {
+              pmb, method->options().GetExtension(google::api::http), methods_.back().get())) {
         throw EnvoyException("transcoding_filter: Cannot register '" + method->full_name() +
                              "' to path matcher");
       }
@@ -118,10 +167,6 @@ JsonTranscoderConfig::JsonTranscoderConfig(
 
   path_matcher_ = pmb.Build();
 
-  type_helper_.reset(
-      new google::grpc::transcoding::TypeHelper(Protobuf::util::NewTypeResolverForDescriptorPool(
-          Common::typeUrlPrefix(), &descriptor_pool_)));
-
   const auto print_config = proto_config.print_options();
   print_options_.add_whitespace = print_config.add_whitespace();
   print_options_.always_print_primitive_fields = print_config.always_print_primitive_fields();
@@ -132,7 +177,7 @@ JsonTranscoderConfig::JsonTranscoderConfig(
 ProtobufUtil::Status JsonTranscoderConfig::createTranscoder(
     const Http::HeaderMap& headers, ZeroCopyInputStream& request_input,
     google::grpc::transcoding::TranscoderInputStream& response_input,
-    std::unique_ptr<Transcoder>& transcoder, const Protobuf::MethodDescriptor*& method_descriptor) {
+    std::unique_ptr<Transcoder>& transcoder, const MethodInfo*& method_info) {
   const ProtobufTypes::String method = headers.Method()->value().c_str();
   ProtobufTypes::String path = headers.Path()->value().c_str();
   ProtobufTypes::String args;
@@ -145,23 +190,30 @@ ProtobufUtil::Status JsonTranscoderConfig::createTranscoder(
 
   struct RequestInfo request_info;
   std::vector<VariableBinding> variable_bindings;
-  method_descriptor =
+  method_info =
       path_matcher_->Lookup(method, path, args, &variable_bindings, &request_info.body_field_path);
-  if (!method_descriptor) {
+  if (!method_info) {
     return ProtobufUtil::Status(Code::NOT_FOUND, "Could not resolve " + path + " to a method");
   }
 
-  auto status = methodToRequestInfo(method_descriptor, &request_info);
-  if (!status.ok()) {
-    return status;
+  const Protobuf::MethodDescriptor* method_descriptor = method_info->descriptor_;
+  request_info.message_type = method_info->request_type_;
+  if (request_info.message_type == nullptr) {
+    return ProtobufUtil::Status(Code::NOT_FOUND, "Could not resolve type: " +
+                                                     method_descriptor->input_type()->full_name());
   }
 
   for (const auto& binding : variable_bindings) {
     google::grpc::transcoding::RequestWeaver::BindingInfo resolved_binding;
-    status = type_helper_->ResolveFieldPath(*request_info.message_type, binding.field_path,
-                                            &resolved_binding.field_path);
-    if (!status.ok()) {
-      return status;
+    const auto field_path = method_info->field_paths_.find(joinFieldPath(binding.field_path));
+    if (field_path != method_info->field_paths_.end()) {
+      resolved_binding.field_path = field_path->second;
+    } else {
+      const auto status = type_helper_->ResolveFieldPath(
+          *request_info.message_type, binding.field_path, &resolved_binding.field_path);
+      if (!status.ok()) {
+        return status;
+      }
     }
 
     resolved_binding.value = binding.value;
@@ -173,9 +225,9 @@ ProtobufUtil::Status JsonTranscoderConfig::createTranscoder(
       new JsonRequestTranslator(type_helper_->Resolver(), &request_input, request_info,
                                 method_descriptor->client_streaming(), true)};
 
-  const auto response_type_url = Common::typeUrl(method_descriptor->output_type()->full_name());
   std::unique_ptr<ResponseToJsonTranslator> response_translator{new ResponseToJsonTranslator(
-      type_helper_->Resolver(), response_type_url, method_descriptor->server_streaming(),
+      type_helper_->Resolver(), method_info->response_type_url_,
+      method_descriptor->server_streaming(),
       &response_input, print_options_)};
 
   transcoder.reset(
@@ -183,18 +235,36 @@ ProtobufUtil::Status JsonTranscoderConfig::createTranscoder(
   return ProtobufUtil::Status();
 }
 
-ProtobufUtil::Status
-JsonTranscoderConfig::methodToRequestInfo(const Protobuf::MethodDescriptor* method,
-                                          google::grpc::transcoding::RequestInfo* info) {
-  auto request_type_url = Common::typeUrl(method->input_type()->full_name());
-  info->message_type = type_helper_->Info()->GetTypeByTypeUrl(request_type_url);
-  if (info->message_type == nullptr) {
+std::unique_ptr<MethodInfo>
+JsonTranscoderConfig::createMethodInfo(const Protobuf::MethodDescriptor* method) {
+  std::unique_ptr<MethodInfo> info(new MethodInfo());
+  info->descriptor_ = method;
+  info->request_type_ =
+      type_helper_->Info()->GetTypeByTypeUrl(Common::typeUrl(method->input_type()->full_name()));
+  info->response_type_url_ = Common::typeUrl(method->output_type()->full_name());
+  info->grpc_path_ = "/" + method->service()->full_name() + "/" + method->name();
+  if (info->request_type_ == nullptr) {
     ENVOY_LOG(debug, "Cannot resolve input-type: {}", method->input_type()->full_name());
-    return ProtobufUtil::Status(Code::NOT_FOUND,
-                                "Could not resolve type: " + method->input_type()->full_name());
+    return info;
   }
 
-  return ProtobufUtil::Status();
+  // Resolve the fields of the path variables now rather than on each request. Variables that do
+  // not resolve are left out, and fail the requests that bind them as before.
+  const auto& http_rule = method->options().GetExtension(google::api::http);
+  std::vector<std::string> variables = templateVariables(httpRulePath(http_rule));
+  for (const auto& binding : http_rule.additional_bindings()) {
+    const std::vector<std::string> binding_variables = templateVariables(httpRulePath(binding));
+    variables.insert(variables.end(), binding_variables.begin(), binding_variables.end());
+  }
+  for (const auto& variable : variables) {
+    std::vector<const Protobuf::Field*> fields;
+    if (type_helper_->ResolveFieldPath(*info->request_type_,
+                                       StringUtil::split(variable, '.'), &fields)
+            .ok()) {
+      info->field_paths_.emplace(variable, std::move(fields));
+    }
+  }
+  return info;
 }
 
 JsonTranscoderFilter::JsonTranscoderFilter(JsonTranscoderConfig& config) : config_(config) {}
@@ -213,7 +283,7 @@ Http::FilterHeadersStatus JsonTranscoderFilter::decodeHeaders(Http::HeaderMap& h
   headers.removeContentLength();
   headers.insertContentType().value().setReference(Http::Headers::get().ContentTypeValues.Grpc);
   headers.insertEnvoyOriginalPath().value(*headers.Path());
-  headers.insertPath().value("/" + method_->service()->full_name() + "/" + method_->name());
+  headers.insertPath().value(method_->grpc_path_);
   headers.insertMethod().value().setReference(Http::Headers::get().MethodValues.Post);
   headers.insertTE().value().setReference(Http::Headers::get().TEValues.Trailers);
 
@@ -249,6 +319,7 @@ Http::FilterDataStatus JsonTranscoderFilter::decodeData(Buffer::Instance& data,
     return Http::FilterDataStatus::Continue;
   }
 
+  request_message_bytes_ += data.length();
   request_in_.move(data);
 
   if (end_stream) {
@@ -257,6 +328,22 @@ Http::FilterDataStatus JsonTranscoderFilter::decodeData(Buffer::Instance& data,
 
   readToBuffer(*transcoder_->RequestOutput(), data);
 
+  // The transcoder emits each message as soon as it has been parsed, but has to hold on to the
+  // message until then: the gRPC frame starts with the length of the message. Bound how much of a
+  // single message is held the same way buffering filters bound the request body.
+  if (data.length() > 0) {
+    request_message_bytes_ = 0;
+  } else {
+    const uint32_t limit = decoder_callbacks_->decoderBufferLimit();
+    if (limit > 0 && request_message_bytes_ > limit) {
+      ENVOY_LOG(debug, "Transcoding request error: message exceeds {} bytes", limit);
+      error_ = true;
+      Http::Utility::sendLocalReply(*decoder_callbacks_, stream_reset_,
+                                    Http::Code::PayloadTooLarge, "Request message too large");
+      return Http::FilterDataStatus::StopIterationNoBuffer;
+    }
+  }
+
   const auto& request_status = transcoder_->RequestStatus();
 
   if (!request_status.ok()) {
@@ -309,7 +396,7 @@ Http::FilterHeadersStatus JsonTranscoderFilter::encodeHeaders(Http::HeaderMap& h
   }
 
   headers.insertContentType().value().setReference(Http::Headers::get().ContentTypeValues.Json);
-  if (!method_->server_streaming()) {
+  if (!method_->descriptor_->server_streaming()) {
     return Http::FilterHeadersStatus::StopIteration;
   }
 
@@ -329,7 +416,7 @@ Http::FilterDataStatus JsonTranscoderFilter::encodeData(Buffer::Instance& data,
 
   readToBuffer(*transcoder_->ResponseOutput(), data);
 
-  if (!method_->server_streaming()) {
+  if (!method_->descriptor_->server_streaming()) {
     // Buffer until the response is complete.
     return Http::FilterDataStatus::StopIterationAndBuffer;
   }
@@ -352,7 +439,7 @@ Http::FilterTrailersStatus JsonTranscoderFilter::encodeTrailers(Http::HeaderMap&
     encoder_callbacks_->addEncodedData(data, true);
   }
 
-  if (method_->server_streaming()) {
+  if (method_->descriptor_->server_streaming()) {
     // For streaming case, the headers are already sent, so just continue here.
     return Http::FilterTrailersStatus::Continue;
   }
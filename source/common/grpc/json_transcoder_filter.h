@@ -1,5 +1,10 @@
 #pragma once
 
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 #include "envoy/buffer/buffer.h"
 #include "envoy/http/filter.h"
 #include "envoy/http/header_map.h"
@@ -35,6 +40,22 @@ struct VariableBinding {
   ProtobufTypes::String value;
 };
 
+/**
+ * A method that the transcoder maps HTTP requests to, with everything about it that transcoding a
+ * request needs resolved once, when the configuration is loaded.
+ */
+struct MethodInfo {
+  const Protobuf::MethodDescriptor* descriptor_{};
+  // Type of the request message, or nullptr if the descriptor pool does not define it.
+  const Protobuf::Type* request_type_{};
+  std::string response_type_url_;
+  // Path of the method in gRPC requests, e.g. "/bookstore.Bookstore/GetShelf".
+  std::string grpc_path_;
+  // Resolved fields of the variables in the method's HTTP path templates, keyed by their dotted
+  // field paths, e.g. "shelf.theme".
+  std::unordered_map<std::string, std::vector<const Protobuf::Field*>> field_paths_;
+};
+
 /**
  * Global configuration for the gRPC JSON transcoder filter. Factory for the Transcoder interface.
  */
@@ -52,25 +73,24 @@ public:
    * @param request_input a ZeroCopyInputStream reading from downstream request body
    * @param response_input a TranscoderInputStream reading from upstream response body
    * @param transcoder output parameter for the instance of Transcoder interface
-   * @param method_descriptor output parameter for the method looked up from config
+   * @param method_info output parameter for the method looked up from config
    * @return status whether the Transcoder instance are successfully created or not
    */
   ProtobufUtil::Status
   createTranscoder(const Http::HeaderMap& headers, Protobuf::io::ZeroCopyInputStream& request_input,
                    google::grpc::transcoding::TranscoderInputStream& response_input,
                    std::unique_ptr<google::grpc::transcoding::Transcoder>& transcoder,
-                   const Protobuf::MethodDescriptor*& method_descriptor);
+                   const MethodInfo*& method_info);
 
 private:
   /**
-   * Convert method descriptor to RequestInfo that needed for transcoding library
+   * Resolve everything about a method that transcoding its requests needs.
    */
-  ProtobufUtil::Status methodToRequestInfo(const Protobuf::MethodDescriptor* method,
-                                           google::grpc::transcoding::RequestInfo* info);
+  std::unique_ptr<MethodInfo> createMethodInfo(const Protobuf::MethodDescriptor* method);
 
-private:
   Protobuf::DescriptorPool descriptor_pool_;
-  google::grpc::transcoding::PathMatcherPtr<const Protobuf::MethodDescriptor*> path_matcher_;
+  std::vector<std::unique_ptr<MethodInfo>> methods_;
+  google::grpc::transcoding::PathMatcherPtr<const MethodInfo*> path_matcher_;
   std::unique_ptr<google::grpc::transcoding::TypeHelper> type_helper_;
   Protobuf::util::JsonPrintOptions print_options_;
 };
@@ -108,8 +128,10 @@ private:
   TranscoderInputStreamImpl response_in_;
   Http::StreamDecoderFilterCallbacks* decoder_callbacks_{nullptr};
   Http::StreamEncoderFilterCallbacks* encoder_callbacks_{nullptr};
-  const Protobuf::MethodDescriptor* method_{nullptr};
+  const MethodInfo* method_{nullptr};
   Http::HeaderMap* response_headers_{nullptr};
+  // JSON bytes of the request message that the transcoder is currently working on.
+  uint64_t request_message_bytes_{0};
 
   bool error_{false};
   bool stream_reset_{false};
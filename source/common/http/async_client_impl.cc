@@ -18,6 +18,7 @@ const std::vector<std::reference_wrapper<const Router::RateLimitPolicyEntry>>
 const AsyncStreamImpl::NullRateLimitPolicy AsyncStreamImpl::RouteEntryImpl::rate_limit_policy_;
 const AsyncStreamImpl::NullRetryPolicy AsyncStreamImpl::RouteEntryImpl::retry_policy_;
 const AsyncStreamImpl::NullShadowPolicy AsyncStreamImpl::RouteEntryImpl::shadow_policy_;
+const AsyncStreamImpl::NullHedgePolicy AsyncStreamImpl::RouteEntryImpl::hedge_policy_;
 const AsyncStreamImpl::NullVirtualHost AsyncStreamImpl::RouteEntryImpl::virtual_host_;
 const AsyncStreamImpl::NullRateLimitPolicy AsyncStreamImpl::NullVirtualHost::rate_limit_policy_;
 const std::multimap<std::string, std::string> AsyncStreamImpl::RouteEntryImpl::opaque_config_;
@@ -142,6 +143,48 @@ void AsyncStreamImpl::sendTrailers(HeaderMap& trailers) {
   closeLocal(true);
 }
 
+void AsyncStreamImpl::readDisable(bool disable) {
+  if (disable) {
+    if (read_disable_count_++ == 0) {
+      for (DownstreamWatermarkCallbacks* callbacks : watermark_callbacks_) {
+        callbacks->onAboveWriteBufferHighWatermark();
+      }
+    }
+  } else {
+    ASSERT(read_disable_count_ > 0);
+    if (--read_disable_count_ == 0) {
+      for (DownstreamWatermarkCallbacks* callbacks : watermark_callbacks_) {
+        callbacks->onBelowWriteBufferLowWatermark();
+      }
+    }
+  }
+}
+
+void AsyncStreamImpl::onDecoderFilterAboveWriteBufferHighWatermark() {
+  if (high_watermark_count_++ == 0) {
+    stream_callbacks_.onAboveWriteBufferHighWatermark();
+  }
+}
+
+void AsyncStreamImpl::onDecoderFilterBelowWriteBufferLowWatermark() {
+  ASSERT(high_watermark_count_ > 0);
+  if (--high_watermark_count_ == 0) {
+    stream_callbacks_.onBelowWriteBufferLowWatermark();
+  }
+}
+
+void AsyncStreamImpl::addDownstreamWatermarkCallbacks(DownstreamWatermarkCallbacks& callbacks) {
+  watermark_callbacks_.push_back(&callbacks);
+  // Upstream requests that start while reads are disabled start out paused.
+  if (read_disable_count_ > 0) {
+    callbacks.onAboveWriteBufferHighWatermark();
+  }
+}
+
+void AsyncStreamImpl::removeDownstreamWatermarkCallbacks(DownstreamWatermarkCallbacks& callbacks) {
+  watermark_callbacks_.remove(&callbacks);
+}
+
 void AsyncStreamImpl::closeLocal(bool end_stream) {
   ASSERT(!(local_closed_ && end_stream));
 
@@ -78,6 +78,8 @@ public:
   void sendData(Buffer::Instance& data, bool end_stream) override;
   void sendTrailers(HeaderMap& trailers) override;
   void reset() override;
+  bool isAboveWriteBufferHighWatermark() const override { return high_watermark_count_ > 0; }
+  void readDisable(bool disable) override;
 
 protected:
   bool remoteClosed() { return remote_closed_; }
@@ -88,6 +90,7 @@ private:
   struct NullCorsPolicy : public Router::CorsPolicy {
     // Router::CorsPolicy
     const std::list<std::string>& allowOrigins() const override { return allow_origin_; };
+    bool originAllowed(const std::string&) const override { return false; };
     const std::string& allowMethods() const override { return EMPTY_STRING; };
     const std::string& allowHeaders() const override { return EMPTY_STRING; };
     const std::string& exposeHeaders() const override { return EMPTY_STRING; };
@@ -126,6 +129,12 @@ private:
     const std::string& runtimeKey() const override { return EMPTY_STRING; }
   };
 
+  struct NullHedgePolicy : public Router::HedgePolicy {
+    // Router::HedgePolicy
+    double latencyPercentile() const override { return 0; }
+    std::chrono::milliseconds minDelay() const override { return std::chrono::milliseconds(0); }
+  };
+
   struct NullVirtualHost : public Router::VirtualHost {
     // Router::VirtualHost
     const std::string& name() const override { return EMPTY_STRING; }
@@ -142,6 +151,7 @@ private:
 
     // Router::RouteEntry
     const std::string& clusterName() const override { return cluster_name_; }
+    const Upstream::ClusterHandle* clusterHandle() const override { return nullptr; }
     Http::Code clusterNotFoundResponseCode() const override {
       return Http::Code::InternalServerError;
     }
@@ -157,6 +167,7 @@ private:
     const Router::RateLimitPolicy& rateLimitPolicy() const override { return rate_limit_policy_; }
     const Router::RetryPolicy& retryPolicy() const override { return retry_policy_; }
     const Router::ShadowPolicy& shadowPolicy() const override { return shadow_policy_; }
+    const Router::HedgePolicy& hedgePolicy() const override { return hedge_policy_; }
     std::chrono::milliseconds timeout() const override {
       if (timeout_.valid()) {
         return timeout_.value();
@@ -178,6 +189,7 @@ private:
     static const NullRateLimitPolicy rate_limit_policy_;
     static const NullRetryPolicy retry_policy_;
     static const NullShadowPolicy shadow_policy_;
+    static const NullHedgePolicy hedge_policy_;
     static const NullVirtualHost virtual_host_;
     static const std::multimap<std::string, std::string> opaque_config_;
 
@@ -215,14 +227,16 @@ private:
   const std::string& downstreamAddress() override { return EMPTY_STRING; }
   void continueDecoding() override { NOT_IMPLEMENTED; }
   void addDecodedData(Buffer::Instance&, bool) override { NOT_IMPLEMENTED; }
+  void injectDecodedDataToFilterChain(Buffer::Instance&, bool) override { NOT_IMPLEMENTED; }
   const Buffer::Instance* decodingBuffer() override { return buffered_body_.get(); }
   void encodeHeaders(HeaderMapPtr&& headers, bool end_stream) override;
   void encodeData(Buffer::Instance& data, bool end_stream) override;
   void encodeTrailers(HeaderMapPtr&& trailers) override;
-  void onDecoderFilterAboveWriteBufferHighWatermark() override {}
-  void onDecoderFilterBelowWriteBufferLowWatermark() override {}
-  void addDownstreamWatermarkCallbacks(DownstreamWatermarkCallbacks&) override {}
-  void removeDownstreamWatermarkCallbacks(DownstreamWatermarkCallbacks&) override {}
+  void onDecoderFilterAboveWriteBufferHighWatermark() override;
+  void onDecoderFilterBelowWriteBufferLowWatermark() override;
+  bool aboveDecoderWriteBufferHighWatermark() override { return high_watermark_count_ > 0; }
+  void addDownstreamWatermarkCallbacks(DownstreamWatermarkCallbacks& callbacks) override;
+  void removeDownstreamWatermarkCallbacks(DownstreamWatermarkCallbacks& callbacks) override;
   void setDecoderBufferLimit(uint32_t) override {}
   uint32_t decoderBufferLimit() override { return 0; }
 
@@ -235,6 +249,12 @@ private:
   std::shared_ptr<RouteImpl> route_;
   bool local_closed_{};
   bool remote_closed_{};
+  // A count, since the router reports each of its upstream requests that is backed up.
+  uint32_t high_watermark_count_{};
+  uint32_t read_disable_count_{};
+  // Registered by the router for each of its upstream requests, to pause reading from them while
+  // reads are disabled.
+  std::list<DownstreamWatermarkCallbacks*> watermark_callbacks_;
   Buffer::InstancePtr buffered_body_;
   friend class AsyncClientImpl;
 };
@@ -258,6 +278,9 @@ private:
   void onData(Buffer::Instance& data, bool end_stream) override;
   void onTrailers(HeaderMapPtr&& trailers) override;
   void onReset() override;
+  // The whole request is sent at once, so there is nothing to hold off.
+  void onAboveWriteBufferHighWatermark() override {}
+  void onBelowWriteBufferLowWatermark() override {}
 
   // Http::StreamDecoderFilterCallbacks
   const Buffer::Instance* decodingBuffer() override { return request_->body().get(); }
@@ -81,6 +81,11 @@ public:
    */
   size_t numActiveRequests() { return active_requests_.size(); }
 
+  /**
+   * @return uint64_t the number of requests that the peer currently allows to be active at once.
+   */
+  uint64_t maxConcurrentRequests() { return codec_->maxConcurrentStreams(); }
+
   /**
    * Create a new stream. Note: The CodecClient will NOT buffer multiple requests for HTTP1
    * connections. Thus, calling newStream() before the previous request has been fully encoded
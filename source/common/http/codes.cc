@@ -1,6 +1,7 @@
 #include "common/http/codes.h"
 
 #include <cstdint>
+#include <memory>
 #include <string>
 
 #include "envoy/http/header_map.h"
@@ -26,37 +27,52 @@ void CodeUtility::chargeBasicResponseStat(Stats::Scope& scope, const std::string
 
 void CodeUtility::chargeResponseStat(const ResponseStatInfo& info) {
   const uint64_t response_code = info.response_status_code_;
-  chargeBasicResponseStat(info.cluster_scope_, info.prefix_, static_cast<Code>(response_code));
+  if (info.code_stats_ != nullptr) {
+    info.code_stats_->chargeResponseStat(response_code, info.upstream_canary_,
+                                         info.internal_request_);
+  } else {
+    chargeBasicResponseStat(info.cluster_scope_, info.prefix_, static_cast<Code>(response_code));
+  }
+
+  const bool vcluster = !info.request_vcluster_name_.empty();
+  const bool zone = !info.from_zone_.empty() && !info.to_zone_.empty();
+  if (info.code_stats_ != nullptr && !vcluster && !zone) {
+    return;
+  }
 
   std::string group_string = groupStringForResponseCode(static_cast<Code>(response_code));
 
-  // If the response is from a canary, also create canary stats.
-  if (info.upstream_canary_) {
-    info.cluster_scope_.counter(fmt::format("{}canary.upstream_rq_{}", info.prefix_, group_string))
-        .inc();
-    info.cluster_scope_.counter(fmt::format("{}canary.upstream_rq_{}", info.prefix_, response_code))
-        .inc();
-  }
+  if (info.code_stats_ == nullptr) {
+    // If the response is from a canary, also create canary stats.
+    if (info.upstream_canary_) {
+      info.cluster_scope_
+          .counter(fmt::format("{}canary.upstream_rq_{}", info.prefix_, group_string))
+          .inc();
+      info.cluster_scope_
+          .counter(fmt::format("{}canary.upstream_rq_{}", info.prefix_, response_code))
+          .inc();
+    }
 
-  // Split stats into external vs. internal.
-  if (info.internal_request_) {
-    info.cluster_scope_
-        .counter(fmt::format("{}internal.upstream_rq_{}", info.prefix_, group_string))
-        .inc();
-    info.cluster_scope_
-        .counter(fmt::format("{}internal.upstream_rq_{}", info.prefix_, response_code))
-        .inc();
-  } else {
-    info.cluster_scope_
-        .counter(fmt::format("{}external.upstream_rq_{}", info.prefix_, group_string))
-        .inc();
-    info.cluster_scope_
-        .counter(fmt::format("{}external.upstream_rq_{}", info.prefix_, response_code))
-        .inc();
+    // Split stats into external vs. internal.
+    if (info.internal_request_) {
+      info.cluster_scope_
+          .counter(fmt::format("{}internal.upstream_rq_{}", info.prefix_, group_string))
+          .inc();
+      info.cluster_scope_
+          .counter(fmt::format("{}internal.upstream_rq_{}", info.prefix_, response_code))
+          .inc();
+    } else {
+      info.cluster_scope_
+          .counter(fmt::format("{}external.upstream_rq_{}", info.prefix_, group_string))
+          .inc();
+      info.cluster_scope_
+          .counter(fmt::format("{}external.upstream_rq_{}", info.prefix_, response_code))
+          .inc();
+    }
   }
 
   // Handle request virtual cluster.
-  if (!info.request_vcluster_name_.empty()) {
+  if (vcluster) {
     info.global_scope_
         .counter(fmt::format("vhost.{}.vcluster.{}.upstream_rq_{}", info.request_vhost_name_,
                              info.request_vcluster_name_, group_string))
@@ -68,7 +84,7 @@ void CodeUtility::chargeResponseStat(const ResponseStatInfo& info) {
   }
 
   // Handle per zone stats.
-  if (!info.from_zone_.empty() && !info.to_zone_.empty()) {
+  if (zone) {
     info.cluster_scope_
         .counter(fmt::format("{}zone.{}.{}.upstream_rq_{}", info.prefix_, info.from_zone_,
                              info.to_zone_, group_string))
@@ -126,6 +142,68 @@ std::string CodeUtility::groupStringForResponseCode(Code response_code) {
   }
 }
 
+CodeStatsImpl::CodeStatsImpl(Stats::Scope& scope)
+    : all_(scope, ""), canary_(scope, "canary."), internal_(scope, "internal."),
+      external_(scope, "external.") {}
+
+void CodeStatsImpl::chargeResponseStat(uint64_t response_code, bool upstream_canary,
+                                       bool internal_request) {
+  all_.charge(response_code);
+  if (upstream_canary) {
+    canary_.charge(response_code);
+  }
+
+  if (internal_request) {
+    internal_.charge(response_code);
+  } else {
+    external_.charge(response_code);
+  }
+}
+
+CodeStatsImpl::Counters::Counters(Stats::Scope& scope, const std::string& prefix)
+    : scope_(scope), prefix_(prefix) {}
+
+CodeStatsImpl::Counters::~Counters() {
+  for (std::atomic<CodeCounters*>& codes : code_counters_) {
+    delete codes.load();
+  }
+}
+
+void CodeStatsImpl::Counters::charge(uint64_t response_code) {
+  if (response_code < 100 || response_code >= 100 * (NUM_CLASSES + 1)) {
+    CodeUtility::chargeBasicResponseStat(scope_, prefix_, static_cast<Code>(response_code));
+    return;
+  }
+
+  // Looking a counter up more than once when threads race is harmless, since the scope returns
+  // the same counter.
+  const uint64_t code_class = response_code / 100 - 1;
+  Stats::Counter* class_counter = class_counters_[code_class].load(std::memory_order_acquire);
+  if (class_counter == nullptr) {
+    class_counter = &scope_.counter(fmt::format(
+        "{}upstream_rq_{}", prefix_,
+        CodeUtility::groupStringForResponseCode(static_cast<Code>(response_code))));
+    class_counters_[code_class].store(class_counter, std::memory_order_release);
+  }
+  class_counter->inc();
+
+  CodeCounters* codes = code_counters_[code_class].load(std::memory_order_acquire);
+  if (codes == nullptr) {
+    std::unique_ptr<CodeCounters> new_codes(new CodeCounters());
+    if (code_counters_[code_class].compare_exchange_strong(codes, new_codes.get())) {
+      codes = new_codes.release();
+    }
+  }
+
+  std::atomic<Stats::Counter*>& handle = (*codes)[response_code % 100];
+  Stats::Counter* code_counter = handle.load(std::memory_order_acquire);
+  if (code_counter == nullptr) {
+    code_counter = &scope_.counter(fmt::format("{}upstream_rq_{}", prefix_, response_code));
+    handle.store(code_counter, std::memory_order_release);
+  }
+  code_counter->inc();
+}
+
 const char* CodeUtility::toString(Code code) {
   // clang-format off
   switch (code) {
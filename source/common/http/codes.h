@@ -1,5 +1,7 @@
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <chrono>
 #include <cstdint>
 #include <string>
@@ -33,6 +35,9 @@ public:
     const std::string& from_zone_;
     const std::string& to_zone_;
     bool upstream_canary_;
+    // If set, charges the code, canary and internal/external counters rather than looking them up
+    // by name under cluster_scope_ and prefix_.
+    CodeStats* code_stats_{};
   };
 
   /**
@@ -78,5 +83,46 @@ public:
   static std::string groupStringForResponseCode(Code response_code);
 };
 
+/**
+ * CodeStats implementation for a stats scope. Each counter is looked up in the scope the first
+ * time it is charged, from any thread, and its handle is kept for later responses.
+ */
+class CodeStatsImpl : public CodeStats {
+public:
+  CodeStatsImpl(Stats::Scope& scope);
+
+  // Http::CodeStats
+  void chargeResponseStat(uint64_t response_code, bool upstream_canary,
+                          bool internal_request) override;
+
+private:
+  /**
+   * The counters under one stat prefix. The handles of the codes of a class, such as 2xx, are
+   * allocated when a code of the class is first charged.
+   */
+  class Counters {
+  public:
+    Counters(Stats::Scope& scope, const std::string& prefix);
+    ~Counters();
+
+    void charge(uint64_t response_code);
+
+  private:
+    typedef std::array<std::atomic<Stats::Counter*>, 100> CodeCounters;
+
+    static const uint64_t NUM_CLASSES = 5;
+
+    Stats::Scope& scope_;
+    const std::string prefix_;
+    std::array<std::atomic<Stats::Counter*>, NUM_CLASSES> class_counters_{};
+    std::array<std::atomic<CodeCounters*>, NUM_CLASSES> code_counters_{};
+  };
+
+  Counters all_;
+  Counters canary_;
+  Counters internal_;
+  Counters external_;
+};
+
 } // namespace Http
 } // namespace Envoy
@@ -34,6 +34,16 @@
 namespace Envoy {
 namespace Http {
 
+namespace {
+// Large enough for the filter wrappers and list nodes of a typical filter chain.
+const size_t StreamArenaBlockSize = 2048;
+// Enough for the distinct request shapes of a typical gRPC or API client connection.
+const uint32_t RouteCacheMaxEntries = 16;
+
+const Runtime::Key TailSamplingKey("tracing.tail_sampling");
+const Runtime::Key TailSamplingLatencyKey("tracing.tail_sampling_latency_ms");
+} // namespace
+
 ConnectionManagerStats ConnectionManagerImpl::generateStats(const std::string& prefix,
                                                             Stats::Scope& scope) {
   return {
@@ -63,7 +73,11 @@ ConnectionManagerImpl::ConnectionManagerImpl(ConnectionManagerConfig& config,
       conn_length_(new Stats::Timespan(stats_.named_.downstream_cx_length_ms_)),
       drain_close_(drain_close), random_generator_(random_generator), tracer_(tracer),
       runtime_(runtime), local_info_(local_info), cluster_manager_(cluster_manager),
-      listener_stats_(config_.listenerStats()) {}
+      listener_stats_(config_.listenerStats()) {
+  if (runtime_.snapshot().featureEnabled("http.route_cache.enabled", 0)) {
+    route_cache_.reset(new Router::RouteCache(RouteCacheMaxEntries));
+  }
+}
 
 void ConnectionManagerImpl::initializeReadFilterCallbacks(Network::ReadFilterCallbacks& callbacks) {
   read_callbacks_ = &callbacks;
@@ -75,9 +89,10 @@ void ConnectionManagerImpl::initializeReadFilterCallbacks(Network::ReadFilterCal
   }
 
   read_callbacks_->connection().addConnectionCallbacks(*this);
+  read_callbacks_->connection().addDrainCallback([this]() -> void { onDrainRequested(); });
 
   if (config_.idleTimeout().valid()) {
-    idle_timer_ = read_callbacks_->connection().dispatcher().createTimer(
+    idle_timer_ = read_callbacks_->connection().dispatcher().createCoarseTimer(
         [this]() -> void { onIdleTimeout(); });
     idle_timer_->enableTimer(config_.idleTimeout().value());
   }
@@ -85,7 +100,9 @@ void ConnectionManagerImpl::initializeReadFilterCallbacks(Network::ReadFilterCal
   read_callbacks_->connection().setConnectionStats(
       {stats_.named_.downstream_cx_rx_bytes_total_, stats_.named_.downstream_cx_rx_bytes_buffered_,
        stats_.named_.downstream_cx_tx_bytes_total_, stats_.named_.downstream_cx_tx_bytes_buffered_,
-       nullptr});
+       nullptr, &stats_.named_.downstream_cx_rx_bytes_per_read_,
+       &stats_.named_.downstream_cx_tx_bytes_per_write_,
+       &stats_.named_.downstream_cx_tx_writes_per_flush_});
 }
 
 ConnectionManagerImpl::~ConnectionManagerImpl() {
@@ -315,6 +332,22 @@ void ConnectionManagerImpl::onIdleTimeout() {
   }
 }
 
+void ConnectionManagerImpl::onDrainRequested() {
+  // Upgraded connections have no way to ask the client to go elsewhere, so they are left to end
+  // on their own.
+  if (isWebSocketConnection()) {
+    return;
+  }
+
+  ENVOY_CONN_LOG(debug, "drain requested", read_callbacks_->connection());
+  if (!codec_) {
+    read_callbacks_->connection().close(Network::ConnectionCloseType::FlushWrite);
+  } else if (drain_state_ == DrainState::NotDraining) {
+    startDrainSequence();
+    stats_.named_.downstream_cx_drain_close_.inc();
+  }
+}
+
 void ConnectionManagerImpl::onDrainTimeout() {
   ASSERT(drain_state_ != DrainState::NotDraining);
   codec_->goAway();
@@ -345,10 +378,22 @@ void ConnectionManagerImpl::chargeTracingStats(const Tracing::Reason& tracing_re
 
 ConnectionManagerImpl::ActiveStream::ActiveStream(ConnectionManagerImpl& connection_manager)
     : connection_manager_(connection_manager),
+      arena_(connection_manager.runtime_.snapshot().featureEnabled("http.stream_arena.enabled", 0)
+                 ? new Arena(StreamArenaBlockSize)
+                 : nullptr),
       snapped_route_config_(connection_manager.config_.routeConfigProvider().config()),
-      stream_id_(connection_manager.random_generator_.random()),
-      request_timer_(new Stats::Timespan(connection_manager_.stats_.named_.downstream_rq_time_)),
-      request_info_(connection_manager_.codec_->protocol()) {
+      stream_id_(connection_manager.random_generator_.random()), decoder_filters_(arena_.get()),
+      encoder_filters_(arena_.get()),
+      request_timer_(connection_manager_.stats_.named_.downstream_rq_time_),
+      request_info_(connection_manager_.codec_->protocol(),
+                    connection_manager_.read_callbacks_->connection()
+                        .dispatcher()
+                        .approximateSystemTimeSource(),
+                    connection_manager_.read_callbacks_->connection()
+                        .dispatcher()
+                        .approximateMonotonicTimeSource()) {
+  time_filters_ =
+      connection_manager_.runtime_.snapshot().featureEnabled("http.filter_timing.enabled", 0);
   connection_manager_.stats_.named_.downstream_rq_total_.inc();
   connection_manager_.stats_.named_.downstream_rq_active_.inc();
   if (connection_manager_.codec_->protocol() == Protocol::Http2) {
@@ -374,19 +419,59 @@ ConnectionManagerImpl::ActiveStream::~ActiveStream() {
                                              *this);
   }
 
+  if (time_filters_) {
+    recordFilterTimes();
+  }
+
   ASSERT(state_.filter_call_state_ == 0);
 }
 
+void ConnectionManagerImpl::ActiveStream::recordFilterTimes() {
+  // A filter that decodes and encodes has two wrappers, whose time is recorded together.
+  std::vector<std::pair<const std::string*, std::chrono::nanoseconds>> times;
+  auto add_time = [&times](const ActiveStreamFilterBase& filter) -> void {
+    if (filter.name_ == nullptr) {
+      return;
+    }
+    for (auto& time : times) {
+      if (time.first == filter.name_) {
+        time.second += filter.time_;
+        return;
+      }
+    }
+    times.emplace_back(filter.name_, filter.time_);
+  };
+  for (const ActiveStreamDecoderFilterPtr& filter : decoder_filters_) {
+    add_time(*filter);
+  }
+  for (const ActiveStreamEncoderFilterPtr& filter : encoder_filters_) {
+    add_time(*filter);
+  }
+
+  Stats::Scope& scope = connection_manager_.stats_.scope_;
+  for (const auto& time : times) {
+    const std::string prefix = connection_manager_.stats_.prefix_ + "filter." + *time.first + ".";
+    scope.counter(prefix + "time_ns").add(time.second.count());
+    scope.counter(prefix + "rq_sampled").inc();
+    scope.histogram(prefix + "time_us")
+        .recordValue(std::chrono::duration_cast<std::chrono::microseconds>(time.second).count());
+  }
+}
+
 void ConnectionManagerImpl::ActiveStream::addStreamDecoderFilterWorker(
     StreamDecoderFilterSharedPtr filter, bool dual_filter) {
-  ActiveStreamDecoderFilterPtr wrapper(new ActiveStreamDecoderFilter(*this, filter, dual_filter));
+  ActiveStreamDecoderFilterPtr wrapper(
+      new (arena_.get()) ActiveStreamDecoderFilter(*this, filter, dual_filter));
+  wrapper->name_ = filter_name_;
   filter->setDecoderFilterCallbacks(*wrapper);
   wrapper->moveIntoListBack(std::move(wrapper), decoder_filters_);
 }
 
 void ConnectionManagerImpl::ActiveStream::addStreamEncoderFilterWorker(
     StreamEncoderFilterSharedPtr filter, bool dual_filter) {
-  ActiveStreamEncoderFilterPtr wrapper(new ActiveStreamEncoderFilter(*this, filter, dual_filter));
+  ActiveStreamEncoderFilterPtr wrapper(
+      new (arena_.get()) ActiveStreamEncoderFilter(*this, filter, dual_filter));
+  wrapper->name_ = filter_name_;
   filter->setEncoderFilterCallbacks(*wrapper);
   wrapper->moveIntoListBack(std::move(wrapper), encoder_filters_);
 }
@@ -507,7 +592,7 @@ void ConnectionManagerImpl::ActiveStream::decodeHeaders(HeaderMapPtr&& headers,
       connection_manager_.runtime_, connection_manager_.local_info_);
 
   ASSERT(!cached_route_.valid());
-  cached_route_.value(snapped_route_config_->route(*request_headers_, stream_id_));
+  refreshCachedRoute();
 
   // Check for WebSocket upgrade request if the route exists, and supports WebSockets.
   // TODO if there are no filters when starting a filter iteration, the connection manager
@@ -522,7 +607,8 @@ void ConnectionManagerImpl::ActiveStream::decodeHeaders(HeaderMapPtr&& headers,
 
       connection_manager_.ws_connection_.reset(new WebSocket::WsHandlerImpl(
           *request_headers_, request_info_, *route_entry, *this,
-          connection_manager_.cluster_manager_, connection_manager_.read_callbacks_));
+          connection_manager_.cluster_manager_, connection_manager_.runtime_,
+          connection_manager_.read_callbacks_));
       connection_manager_.ws_connection_->onNewConnection();
       connection_manager_.stats_.named_.downstream_cx_websocket_active_.inc();
       connection_manager_.stats_.named_.downstream_cx_http1_active_.dec();
@@ -548,18 +634,37 @@ void ConnectionManagerImpl::ActiveStream::decodeHeaders(HeaderMapPtr&& headers,
   decodeHeaders(nullptr, *request_headers_, end_stream);
 }
 
+void ConnectionManagerImpl::ActiveStream::refreshCachedRoute() {
+  if (connection_manager_.route_cache_ != nullptr) {
+    cached_route_.value(
+        connection_manager_.route_cache_->route(snapped_route_config_, *request_headers_,
+                                                stream_id_));
+  } else {
+    cached_route_.value(snapped_route_config_->route(*request_headers_, stream_id_));
+  }
+}
+
 void ConnectionManagerImpl::ActiveStream::traceRequest() {
   Tracing::Decision tracing_decision =
       Tracing::HttpTracerUtility::isTracing(request_info_, *request_headers_);
   ConnectionManagerImpl::chargeTracingStats(tracing_decision.reason,
                                             connection_manager_.config_.tracingStats());
 
-  if (!tracing_decision.is_tracing) {
+  if (tracing_decision.is_tracing) {
+    active_span_ = connection_manager_.tracer_.startSpan(*this, *request_headers_, request_info_);
+  } else if (tracing_decision.reason == Tracing::Reason::NotTraceableRequestId &&
+             connection_manager_.runtime_.snapshot().featureEnabled(TailSamplingKey, 0)) {
+    // Record a span that is only exported if the request turns out to be slow or to fail.
+    connection_manager_.config_.tracingStats().tail_sampling_.inc();
+    const std::chrono::milliseconds latency_threshold(
+        connection_manager_.runtime_.snapshot().getInteger(TailSamplingLatencyKey, 1000));
+    active_span_.reset(new Tracing::TailSampledSpan(connection_manager_.tracer_, *this,
+                                                    *request_headers_, request_info_,
+                                                    latency_threshold));
+  } else {
     return;
   }
 
-  active_span_ = connection_manager_.tracer_.startSpan(*this, *request_headers_, request_info_);
-
   // TODO: Need to investigate the following code based on the cached route, as may
   // be broken in the case a filter changes the route.
 
@@ -604,8 +709,8 @@ void ConnectionManagerImpl::ActiveStream::traceRequest() {
 
 void ConnectionManagerImpl::ActiveStream::decodeHeaders(ActiveStreamDecoderFilter* filter,
                                                         HeaderMap& headers, bool end_stream) {
-  std::list<ActiveStreamDecoderFilterPtr>::iterator entry;
-  std::list<ActiveStreamDecoderFilterPtr>::iterator continue_data_entry = decoder_filters_.end();
+  ActiveStreamDecoderFilterList::iterator entry;
+  ActiveStreamDecoderFilterList::iterator continue_data_entry = decoder_filters_.end();
   if (!filter) {
     entry = decoder_filters_.begin();
   } else {
@@ -615,8 +720,10 @@ void ConnectionManagerImpl::ActiveStream::decodeHeaders(ActiveStreamDecoderFilte
   for (; entry != decoder_filters_.end(); entry++) {
     ASSERT(!(state_.filter_call_state_ & FilterCallState::DecodeHeaders));
     state_.filter_call_state_ |= FilterCallState::DecodeHeaders;
+    FilterTimer timer(**entry);
     FilterHeadersStatus status = (*entry)->handle_->decodeHeaders(
         headers, end_stream && continue_data_entry == decoder_filters_.end());
+    timer.stop();
     state_.filter_call_state_ &= ~FilterCallState::DecodeHeaders;
     ENVOY_STREAM_LOG(trace, "decode headers called: filter={} status={}", *this,
                      static_cast<const void*>((*entry).get()), static_cast<uint64_t>(status));
@@ -663,7 +770,7 @@ void ConnectionManagerImpl::ActiveStream::decodeData(ActiveStreamDecoderFilter*
     return;
   }
 
-  std::list<ActiveStreamDecoderFilterPtr>::iterator entry;
+  ActiveStreamDecoderFilterList::iterator entry;
   if (!filter) {
     entry = decoder_filters_.begin();
   } else {
@@ -673,7 +780,9 @@ void ConnectionManagerImpl::ActiveStream::decodeData(ActiveStreamDecoderFilter*
   for (; entry != decoder_filters_.end(); entry++) {
     ASSERT(!(state_.filter_call_state_ & FilterCallState::DecodeData));
     state_.filter_call_state_ |= FilterCallState::DecodeData;
+    FilterTimer timer(**entry);
     FilterDataStatus status = (*entry)->handle_->decodeData(data, end_stream);
+    timer.stop();
     state_.filter_call_state_ &= ~FilterCallState::DecodeData;
     ENVOY_STREAM_LOG(trace, "decode data called: filter={} status={}", *this,
                      static_cast<const void*>((*entry).get()), static_cast<uint64_t>(status));
@@ -718,7 +827,7 @@ void ConnectionManagerImpl::ActiveStream::decodeTrailers(ActiveStreamDecoderFilt
     return;
   }
 
-  std::list<ActiveStreamDecoderFilterPtr>::iterator entry;
+  ActiveStreamDecoderFilterList::iterator entry;
   if (!filter) {
     entry = decoder_filters_.begin();
   } else {
@@ -728,7 +837,9 @@ void ConnectionManagerImpl::ActiveStream::decodeTrailers(ActiveStreamDecoderFilt
   for (; entry != decoder_filters_.end(); entry++) {
     ASSERT(!(state_.filter_call_state_ & FilterCallState::DecodeTrailers));
     state_.filter_call_state_ |= FilterCallState::DecodeTrailers;
+    FilterTimer timer(**entry);
     FilterTrailersStatus status = (*entry)->handle_->decodeTrailers(trailers);
+    timer.stop();
     state_.filter_call_state_ &= ~FilterCallState::DecodeTrailers;
     ENVOY_STREAM_LOG(trace, "decode trailers called: filter={} status={}", *this,
                      static_cast<const void*>((*entry).get()), static_cast<uint64_t>(status));
@@ -738,7 +849,7 @@ void ConnectionManagerImpl::ActiveStream::decodeTrailers(ActiveStreamDecoderFilt
   }
 }
 
-std::list<ConnectionManagerImpl::ActiveStreamEncoderFilterPtr>::iterator
+ConnectionManagerImpl::ActiveStreamEncoderFilterList::iterator
 ConnectionManagerImpl::ActiveStream::commonEncodePrefix(ActiveStreamEncoderFilter* filter,
                                                         bool end_stream) {
   // Only do base state setting on the initial call. Subsequent calls for filtering do not touch
@@ -766,14 +877,16 @@ void ConnectionManagerImpl::startDrainSequence() {
 
 void ConnectionManagerImpl::ActiveStream::encodeHeaders(ActiveStreamEncoderFilter* filter,
                                                         HeaderMap& headers, bool end_stream) {
-  std::list<ActiveStreamEncoderFilterPtr>::iterator entry = commonEncodePrefix(filter, end_stream);
-  std::list<ActiveStreamEncoderFilterPtr>::iterator continue_data_entry = encoder_filters_.end();
+  ActiveStreamEncoderFilterList::iterator entry = commonEncodePrefix(filter, end_stream);
+  ActiveStreamEncoderFilterList::iterator continue_data_entry = encoder_filters_.end();
 
   for (; entry != encoder_filters_.end(); entry++) {
     ASSERT(!(state_.filter_call_state_ & FilterCallState::EncodeHeaders));
     state_.filter_call_state_ |= FilterCallState::EncodeHeaders;
+    FilterTimer timer(**entry);
     FilterHeadersStatus status = (*entry)->handle_->encodeHeaders(
         headers, end_stream && continue_data_entry == encoder_filters_.end());
+    timer.stop();
     state_.filter_call_state_ &= ~FilterCallState::EncodeHeaders;
     ENVOY_STREAM_LOG(trace, "encode headers called: filter={} status={}", *this,
                      static_cast<const void*>((*entry).get()), static_cast<uint64_t>(status));
@@ -905,11 +1018,13 @@ void ConnectionManagerImpl::ActiveStream::addEncodedData(ActiveStreamEncoderFilt
 
 void ConnectionManagerImpl::ActiveStream::encodeData(ActiveStreamEncoderFilter* filter,
                                                      Buffer::Instance& data, bool end_stream) {
-  std::list<ActiveStreamEncoderFilterPtr>::iterator entry = commonEncodePrefix(filter, end_stream);
+  ActiveStreamEncoderFilterList::iterator entry = commonEncodePrefix(filter, end_stream);
   for (; entry != encoder_filters_.end(); entry++) {
     ASSERT(!(state_.filter_call_state_ & FilterCallState::EncodeData));
     state_.filter_call_state_ |= FilterCallState::EncodeData;
+    FilterTimer timer(**entry);
     FilterDataStatus status = (*entry)->handle_->encodeData(data, end_stream);
+    timer.stop();
     state_.filter_call_state_ &= ~FilterCallState::EncodeData;
     ENVOY_STREAM_LOG(trace, "encode data called: filter={} status={}", *this,
                      static_cast<const void*>((*entry).get()), static_cast<uint64_t>(status));
@@ -928,11 +1043,13 @@ void ConnectionManagerImpl::ActiveStream::encodeData(ActiveStreamEncoderFilter*
 
 void ConnectionManagerImpl::ActiveStream::encodeTrailers(ActiveStreamEncoderFilter* filter,
                                                          HeaderMap& trailers) {
-  std::list<ActiveStreamEncoderFilterPtr>::iterator entry = commonEncodePrefix(filter, true);
+  ActiveStreamEncoderFilterList::iterator entry = commonEncodePrefix(filter, true);
   for (; entry != encoder_filters_.end(); entry++) {
     ASSERT(!(state_.filter_call_state_ & FilterCallState::EncodeTrailers));
     state_.filter_call_state_ |= FilterCallState::EncodeTrailers;
+    FilterTimer timer(**entry);
     FilterTrailersStatus status = (*entry)->handle_->encodeTrailers(trailers);
+    timer.stop();
     state_.filter_call_state_ &= ~FilterCallState::EncodeTrailers;
     ENVOY_STREAM_LOG(trace, "encode trailers called: filter={} status={}", *this,
                      static_cast<const void*>((*entry).get()), static_cast<uint64_t>(status));
@@ -958,7 +1075,7 @@ void ConnectionManagerImpl::ActiveStream::encodeTrailers(ActiveStreamEncoderFilt
 
 void ConnectionManagerImpl::ActiveStream::maybeEndEncode(bool end_stream) {
   if (end_stream) {
-    request_timer_->complete();
+    request_timer_.complete();
     connection_manager_.doEndStream(*this);
   }
 }
@@ -1146,10 +1263,23 @@ Tracing::Span& ConnectionManagerImpl::ActiveStreamFilterBase::activeSpan() {
 
 Tracing::Config& ConnectionManagerImpl::ActiveStreamFilterBase::tracingConfig() { return parent_; }
 
+ConnectionManagerImpl::FilterTimer::FilterTimer(ActiveStreamFilterBase& filter)
+    : filter_(filter), running_(filter.parent_.time_filters_) {
+  if (running_) {
+    start_ = std::chrono::steady_clock::now();
+  }
+}
+
+void ConnectionManagerImpl::FilterTimer::stop() {
+  if (running_) {
+    filter_.time_ += std::chrono::steady_clock::now() - start_;
+    running_ = false;
+  }
+}
+
 Router::RouteConstSharedPtr ConnectionManagerImpl::ActiveStreamFilterBase::route() {
   if (!parent_.cached_route_.valid()) {
-    parent_.cached_route_.value(
-        parent_.snapped_route_config_->route(*parent_.request_headers_, parent_.stream_id_));
+    parent_.refreshCachedRoute();
   }
 
   return parent_.cached_route_.value();
@@ -1172,6 +1302,16 @@ void ConnectionManagerImpl::ActiveStreamDecoderFilter::addDecodedData(Buffer::In
   parent_.addDecodedData(*this, data, streaming);
 }
 
+void ConnectionManagerImpl::ActiveStreamDecoderFilter::injectDecodedDataToFilterChain(
+    Buffer::Instance& data, bool end_stream) {
+  ASSERT(parent_.state_.filter_call_state_ == 0);
+  if (!headers_continued_) {
+    headers_continued_ = true;
+    doHeaders(false);
+  }
+  parent_.decodeData(this, data, end_stream);
+}
+
 void ConnectionManagerImpl::ActiveStreamDecoderFilter::continueDecoding() { commonContinue(); }
 
 void ConnectionManagerImpl::ActiveStreamDecoderFilter::encodeHeaders(HeaderMapPtr&& headers,
@@ -1193,6 +1333,7 @@ void ConnectionManagerImpl::ActiveStreamDecoderFilter::encodeTrailers(HeaderMapP
 void ConnectionManagerImpl::ActiveStreamDecoderFilter::
     onDecoderFilterAboveWriteBufferHighWatermark() {
   ENVOY_STREAM_LOG(debug, "Read-disabling downstream stream due to filter callbacks.", parent_);
+  parent_.decoder_high_watermark_count_++;
   parent_.response_encoder_->getStream().readDisable(true);
   parent_.connection_manager_.stats_.named_.downstream_flow_control_paused_reading_total_.inc();
 }
@@ -1217,6 +1358,8 @@ void ConnectionManagerImpl::ActiveStreamDecoderFilter::requestDataDrained() {
 void ConnectionManagerImpl::ActiveStreamDecoderFilter::
     onDecoderFilterBelowWriteBufferLowWatermark() {
   ENVOY_STREAM_LOG(debug, "Read-enabling downstream stream due to filter callbacks.", parent_);
+  ASSERT(parent_.decoder_high_watermark_count_ > 0);
+  parent_.decoder_high_watermark_count_--;
   parent_.response_encoder_->getStream().readDisable(false);
   parent_.connection_manager_.stats_.named_.downstream_flow_control_resumed_reading_total_.inc();
 }
@@ -9,6 +9,7 @@
 #include <vector>
 
 #include "envoy/access_log/access_log.h"
+#include "envoy/common/time.h"
 #include "envoy/event/deferred_deletable.h"
 #include "envoy/http/codec.h"
 #include "envoy/http/filter.h"
@@ -24,11 +25,13 @@
 #include "envoy/upstream/upstream.h"
 
 #include "common/buffer/watermark_buffer.h"
+#include "common/common/arena.h"
 #include "common/common/linked_object.h"
 #include "common/http/date_provider.h"
 #include "common/http/user_agent.h"
 #include "common/http/websocket/ws_handler_impl.h"
 #include "common/request_info/request_info_impl.h"
+#include "common/router/route_cache.h"
 #include "common/tracing/http_tracer_impl.h"
 
 namespace Envoy {
@@ -59,8 +62,11 @@ namespace Http {
   HISTOGRAM(downstream_cx_length_ms)                                                               \
   COUNTER  (downstream_cx_rx_bytes_total)                                                          \
   GAUGE    (downstream_cx_rx_bytes_buffered)                                                       \
+  HISTOGRAM(downstream_cx_rx_bytes_per_read)                                                       \
   COUNTER  (downstream_cx_tx_bytes_total)                                                          \
   GAUGE    (downstream_cx_tx_bytes_buffered)                                                       \
+  HISTOGRAM(downstream_cx_tx_bytes_per_write)                                                      \
+  HISTOGRAM(downstream_cx_tx_writes_per_flush)                                                     \
   COUNTER  (downstream_cx_drain_close)                                                             \
   COUNTER  (downstream_cx_idle_timeout)                                                            \
   COUNTER  (downstream_flow_control_paused_reading_total)                                          \
@@ -105,7 +111,8 @@ struct ConnectionManagerStats {
   COUNTER(service_forced)                                                                          \
   COUNTER(client_enabled)                                                                          \
   COUNTER(not_traceable)                                                                           \
-  COUNTER(health_check)
+  COUNTER(health_check)                                                                            \
+  COUNTER(tail_sampling)
 // clang-format on
 
 /**
@@ -328,7 +335,7 @@ private:
   /**
    * Base class wrapper for both stream encoder and decoder filters.
    */
-  struct ActiveStreamFilterBase : public virtual StreamFilterCallbacks {
+  struct ActiveStreamFilterBase : public virtual StreamFilterCallbacks, public ArenaAllocated {
     ActiveStreamFilterBase(ActiveStream& parent, bool dual_filter)
         : parent_(parent), headers_continued_(false), stopped_(false), dual_filter_(dual_filter) {}
 
@@ -361,17 +368,41 @@ private:
     const std::string& downstreamAddress() override;
 
     ActiveStream& parent_;
+    // The name of the filter config that added the filter, if known.
+    const std::string* name_{};
+    // Time spent in the filter's callbacks, if the stream is sampled for filter timing.
+    std::chrono::nanoseconds time_{};
     bool headers_continued_ : 1;
     bool stopped_ : 1;
     const bool dual_filter_ : 1;
   };
 
+  /**
+   * Adds the time from its construction until stop() to the time of a filter, if the stream is
+   * sampled for filter timing. The time includes any other filters that the filter invokes
+   * synchronously, e.g. by sending a local reply.
+   */
+  class FilterTimer {
+  public:
+    FilterTimer(ActiveStreamFilterBase& filter);
+    ~FilterTimer() { stop(); }
+
+    void stop();
+
+  private:
+    ActiveStreamFilterBase& filter_;
+    bool running_;
+    MonotonicTime start_;
+  };
+
   /**
    * Wrapper for a stream decoder filter.
    */
   struct ActiveStreamDecoderFilter : public ActiveStreamFilterBase,
                                      public StreamDecoderFilterCallbacks,
-                                     LinkedObject<ActiveStreamDecoderFilter> {
+                                     LinkedObject<ActiveStreamDecoderFilter,
+                                                  ArenaAllocator<std::unique_ptr<
+                                                      ActiveStreamDecoderFilter>>> {
     ActiveStreamDecoderFilter(ActiveStream& parent, StreamDecoderFilterSharedPtr filter,
                               bool dual_filter)
         : ActiveStreamFilterBase(parent, dual_filter), handle_(filter) {}
@@ -399,6 +430,7 @@ private:
 
     // Http::StreamDecoderFilterCallbacks
     void addDecodedData(Buffer::Instance& data, bool streaming) override;
+    void injectDecodedDataToFilterChain(Buffer::Instance& data, bool end_stream) override;
     void continueDecoding() override;
     const Buffer::Instance* decodingBuffer() override {
       return parent_.buffered_request_data_.get();
@@ -408,6 +440,9 @@ private:
     void encodeTrailers(HeaderMapPtr&& trailers) override;
     void onDecoderFilterAboveWriteBufferHighWatermark() override;
     void onDecoderFilterBelowWriteBufferLowWatermark() override;
+    bool aboveDecoderWriteBufferHighWatermark() override {
+      return parent_.decoder_high_watermark_count_ > 0;
+    }
     void
     addDownstreamWatermarkCallbacks(DownstreamWatermarkCallbacks& watermark_callbacks) override;
     void
@@ -422,13 +457,16 @@ private:
   };
 
   typedef std::unique_ptr<ActiveStreamDecoderFilter> ActiveStreamDecoderFilterPtr;
+  typedef ActiveStreamDecoderFilter::ListType ActiveStreamDecoderFilterList;
 
   /**
    * Wrapper for a stream encoder filter.
    */
   struct ActiveStreamEncoderFilter : public ActiveStreamFilterBase,
                                      public StreamEncoderFilterCallbacks,
-                                     LinkedObject<ActiveStreamEncoderFilter> {
+                                     LinkedObject<ActiveStreamEncoderFilter,
+                                                  ArenaAllocator<std::unique_ptr<
+                                                      ActiveStreamEncoderFilter>>> {
     ActiveStreamEncoderFilter(ActiveStream& parent, StreamEncoderFilterSharedPtr filter,
                               bool dual_filter)
         : ActiveStreamFilterBase(parent, dual_filter), handle_(filter) {}
@@ -465,6 +503,7 @@ private:
   };
 
   typedef std::unique_ptr<ActiveStreamEncoderFilter> ActiveStreamEncoderFilterPtr;
+  typedef ActiveStreamEncoderFilter::ListType ActiveStreamEncoderFilterList;
 
   /**
    * Wraps a single active stream on the connection. These are either full request/response pairs
@@ -483,7 +522,7 @@ private:
     void addStreamDecoderFilterWorker(StreamDecoderFilterSharedPtr filter, bool dual_filter);
     void addStreamEncoderFilterWorker(StreamEncoderFilterSharedPtr filter, bool dual_filter);
     void chargeStats(HeaderMap& headers);
-    std::list<ActiveStreamEncoderFilterPtr>::iterator
+    ActiveStreamEncoderFilterList::iterator
     commonEncodePrefix(ActiveStreamEncoderFilter* filter, bool end_stream);
     uint64_t connectionId();
     const Network::Connection* connection();
@@ -521,6 +560,7 @@ private:
       addStreamEncoderFilterWorker(filter, true);
     }
     void addAccessLogHandler(AccessLog::InstanceSharedPtr handler) override;
+    void setFilterName(const std::string& name) override { filter_name_ = &name; }
 
     // Http::WsHandlerCallbacks
     void sendHeadersOnlyResponse(HeaderMap& headers) override {
@@ -532,6 +572,8 @@ private:
     virtual const std::vector<Http::LowerCaseString>& requestHeadersForTags() const override;
 
     void traceRequest();
+    void refreshCachedRoute();
+    void recordFilterTimes();
 
     // Pass on watermark callbacks to watermark subscribers. This boils down to passing watermark
     // events for this stream and the downstream connection to the router filter.
@@ -572,6 +614,10 @@ private:
     void setBufferLimit(uint32_t limit);
 
     ConnectionManagerImpl& connection_manager_;
+    // Backs the filter wrappers and the nodes of the filter lists when the stream arena is enabled
+    // via runtime, so that the filter chain of a stream takes a single allocation. Declared ahead
+    // of the filter lists so that it is destroyed after them.
+    std::unique_ptr<Arena> arena_;
     Router::ConfigConstSharedPtr snapped_route_config_;
     Tracing::SpanPtr active_span_;
     const uint64_t stream_id_;
@@ -582,17 +628,23 @@ private:
     HeaderMapPtr request_headers_;
     Buffer::WatermarkBufferPtr buffered_request_data_;
     HeaderMapPtr request_trailers_;
-    std::list<ActiveStreamDecoderFilterPtr> decoder_filters_;
-    std::list<ActiveStreamEncoderFilterPtr> encoder_filters_;
+    ActiveStreamDecoderFilterList decoder_filters_;
+    ActiveStreamEncoderFilterList encoder_filters_;
     std::list<AccessLog::InstanceSharedPtr> access_log_handlers_;
-    Stats::TimespanPtr request_timer_;
+    Stats::Timespan request_timer_;
     State state_;
     RequestInfo::RequestInfoImpl request_info_;
     Optional<Router::RouteConstSharedPtr> cached_route_;
     DownstreamWatermarkCallbacks* watermark_callbacks_{nullptr};
     uint32_t buffer_limit_{0};
     uint32_t high_watermark_count_{0};
+    // The number of buffers that decoder filters send the request to which are backed up.
+    uint32_t decoder_high_watermark_count_{0};
     const std::string* decorated_operation_{nullptr};
+    // The name given to the filters that are added next.
+    const std::string* filter_name_{};
+    // Set if the http.filter_timing.enabled runtime feature sampled the stream.
+    bool time_filters_{};
   };
 
   typedef std::unique_ptr<ActiveStream> ActiveStreamPtr;
@@ -616,6 +668,7 @@ private:
 
   void resetAllStreams();
   void onIdleTimeout();
+  void onDrainRequested();
   void onDrainTimeout();
   void startDrainSequence();
 
@@ -642,6 +695,8 @@ private:
   WebSocket::WsHandlerImplPtr ws_connection_{};
   Network::ReadFilterCallbacks* read_callbacks_{};
   ConnectionManagerListenerStats& listener_stats_;
+  // Set if the http.route_cache.enabled runtime feature was on when the connection was created.
+  Router::RouteCachePtr route_cache_;
 };
 
 } // Http
@@ -45,6 +45,13 @@ void ConnectionManagerUtility::mutateRequestHeaders(
   request_headers.removeProxyConnection();
   request_headers.removeTransferEncoding();
 
+  // Requests received in TLS early data can be replayed, so they are marked as such (RFC 8470) for
+  // upstreams to reject with 425 if they are not safe to replay. A client's own header is kept.
+  if (connection.ssl() && connection.ssl()->receivedEarlyData() &&
+      request_headers.get(Headers::get().EarlyData) == nullptr) {
+    request_headers.addReference(Headers::get().EarlyData, Headers::get().EarlyDataValues.True);
+  }
+
   // If we are "using remote address" this means that we create/append to XFF with our immediate
   // peer. Cases where we don't "use remote address" include trusted double proxy where we expect
   // our peer to have already properly set XFF, etc.
@@ -122,10 +129,9 @@ void ConnectionManagerUtility::mutateRequestHeaders(
 
   // Generate x-request-id for all edge requests, or if there is none.
   if (config.generateRequestId() && (edge_request || !request_headers.RequestId())) {
-    // TODO(PiotrSikora) PERF: Write UUID directly to the header map.
-    const std::string uuid = random.uuid();
-    ASSERT(!uuid.empty());
-    request_headers.insertRequestId().value(uuid);
+    char uuid[Runtime::RandomGenerator::UUID_LENGTH];
+    random.writeUuid(uuid);
+    request_headers.insertRequestId().value(uuid, sizeof(uuid));
   }
 
   if (config.tracingConfig()) {
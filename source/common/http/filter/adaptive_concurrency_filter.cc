@@ -0,0 +1,141 @@
+#include "common/http/filter/adaptive_concurrency_filter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+#include "envoy/http/codes.h"
+#include "envoy/request_info/request_info.h"
+#include "envoy/stats/stats.h"
+
+#include "common/common/assert.h"
+#include "common/http/codes.h"
+#include "common/http/utility.h"
+
+namespace Envoy {
+namespace Http {
+
+AdaptiveConcurrencyController::AdaptiveConcurrencyController(Runtime::Loader& runtime,
+                                                             const std::string& stats_prefix,
+                                                             Stats::Scope& scope,
+                                                             MonotonicTimeSource& time_source)
+    : runtime_(runtime), stats_(generateStats(stats_prefix, scope)), time_source_(time_source) {
+  limit_ = clampLimit(runtime_.snapshot().getInteger("adaptive_concurrency.initial_limit", 50));
+  stats_.concurrency_limit_.set(limit_);
+}
+
+AdaptiveConcurrencyStats AdaptiveConcurrencyController::generateStats(const std::string& prefix,
+                                                                      Stats::Scope& scope) {
+  std::string final_prefix = prefix + "adaptive_concurrency.";
+  return {ALL_ADAPTIVE_CONCURRENCY_STATS(POOL_COUNTER_PREFIX(scope, final_prefix),
+                                         POOL_GAUGE_PREFIX(scope, final_prefix))};
+}
+
+bool AdaptiveConcurrencyController::tryAcquire() {
+  uint32_t current = in_flight_;
+  do {
+    if (current >= limit_) {
+      return false;
+    }
+  } while (!in_flight_.compare_exchange_weak(current, current + 1));
+
+  stats_.rq_active_.inc();
+  return true;
+}
+
+void AdaptiveConcurrencyController::release() {
+  ASSERT(in_flight_ > 0);
+  in_flight_--;
+  stats_.rq_active_.dec();
+}
+
+void AdaptiveConcurrencyController::recordLatency(std::chrono::microseconds rtt) {
+  std::lock_guard<std::mutex> guard(sample_lock_);
+  num_samples_++;
+  sample_sum_ += rtt;
+  sample_min_ = std::min(sample_min_, rtt);
+
+  const uint64_t window_size = std::max<uint64_t>(
+      1, runtime_.snapshot().getInteger("adaptive_concurrency.sample_window_size", 100));
+  if (num_samples_ < window_size) {
+    return;
+  }
+
+  updateLimit(sample_sum_ / num_samples_);
+  num_samples_ = 0;
+  sample_sum_ = std::chrono::microseconds(0);
+  sample_min_ = std::chrono::microseconds::max();
+}
+
+void AdaptiveConcurrencyController::updateLimit(std::chrono::microseconds sample_rtt) {
+  const uint64_t recalc_windows =
+      runtime_.snapshot().getInteger("adaptive_concurrency.min_rtt_recalc_windows", 50);
+  if (++windows_since_min_rtt_reset_ >= recalc_windows) {
+    min_rtt_ = sample_min_;
+    windows_since_min_rtt_reset_ = 0;
+  } else {
+    min_rtt_ = std::min(min_rtt_, sample_min_);
+  }
+  stats_.min_rtt_ms_.set(std::chrono::duration_cast<std::chrono::milliseconds>(min_rtt_).count());
+
+  // A window of zero latency responses carries no signal about queueing.
+  if (sample_rtt.count() == 0) {
+    return;
+  }
+
+  const double tolerance =
+      runtime_.snapshot().getInteger("adaptive_concurrency.rtt_tolerance_percent", 150) / 100.0;
+  const double gradient = std::max(
+      0.5, std::min(1.0, tolerance * min_rtt_.count() / static_cast<double>(sample_rtt.count())));
+  const double limit = limit_;
+  limit_ = clampLimit(static_cast<uint64_t>(limit * gradient + std::sqrt(limit)));
+  stats_.concurrency_limit_.set(limit_);
+}
+
+uint32_t AdaptiveConcurrencyController::clampLimit(uint64_t limit) {
+  const uint64_t min_limit =
+      std::max<uint64_t>(1, runtime_.snapshot().getInteger("adaptive_concurrency.min_limit", 1));
+  const uint64_t max_limit = std::max<uint64_t>(
+      min_limit, runtime_.snapshot().getInteger("adaptive_concurrency.max_limit", 1000));
+  return std::max(min_limit, std::min(max_limit, limit));
+}
+
+FilterHeadersStatus AdaptiveConcurrencyFilter::decodeHeaders(HeaderMap&, bool) {
+  if (!controller_->tryAcquire()) {
+    controller_->stats().rq_blocked_.inc();
+    decoder_callbacks_->requestInfo().setResponseFlag(
+        RequestInfo::ResponseFlag::UpstreamOverflow);
+    Utility::sendLocalReply(*decoder_callbacks_, stream_destroyed_, Code::ServiceUnavailable,
+                            "reached concurrency limit");
+    return FilterHeadersStatus::StopIteration;
+  }
+
+  admitted_ = true;
+  start_time_ = controller_->timeSource().currentTime();
+  return FilterHeadersStatus::Continue;
+}
+
+FilterHeadersStatus AdaptiveConcurrencyFilter::encodeHeaders(HeaderMap& headers, bool) {
+  // Only sample the first response of an admitted request. 5xx responses are often returned
+  // without doing the work, and would pull the measured latency down.
+  if (admitted_ && !sampled_) {
+    sampled_ = true;
+    if (!CodeUtility::is5xx(Utility::getResponseStatus(headers))) {
+      controller_->recordLatency(std::chrono::duration_cast<std::chrono::microseconds>(
+          controller_->timeSource().currentTime() - start_time_));
+    }
+  }
+
+  return FilterHeadersStatus::Continue;
+}
+
+void AdaptiveConcurrencyFilter::onDestroy() {
+  stream_destroyed_ = true;
+  if (admitted_) {
+    controller_->release();
+    admitted_ = false;
+  }
+}
+
+} // namespace Http
+} // namespace Envoy
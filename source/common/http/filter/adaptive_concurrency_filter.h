@@ -0,0 +1,144 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "envoy/common/time.h"
+#include "envoy/http/filter.h"
+#include "envoy/runtime/runtime.h"
+#include "envoy/stats/stats_macros.h"
+
+namespace Envoy {
+namespace Http {
+
+/**
+ * All stats for the adaptive concurrency filter. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_ADAPTIVE_CONCURRENCY_STATS(COUNTER, GAUGE)                                             \
+  COUNTER(rq_blocked)                                                                              \
+  GAUGE  (rq_active)                                                                               \
+  GAUGE  (concurrency_limit)                                                                       \
+  GAUGE  (min_rtt_ms)
+// clang-format on
+
+/**
+ * Wrapper struct for adaptive concurrency filter stats. @see stats_macros.h
+ */
+struct AdaptiveConcurrencyStats {
+  ALL_ADAPTIVE_CONCURRENCY_STATS(GENERATE_COUNTER_STRUCT, GENERATE_GAUGE_STRUCT)
+};
+
+/**
+ * Concurrency limit shared by every worker's filter instances. The limit starts at
+ * adaptive_concurrency.initial_limit and is recomputed each time
+ * adaptive_concurrency.sample_window_size responses have been sampled, gradient style:
+ *
+ *   gradient = clamp(min_rtt * rtt_tolerance_percent / 100 / sample_rtt, 0.5, 1.0)
+ *   limit = clamp(limit * gradient + sqrt(limit), min_limit, max_limit)
+ *
+ * where sample_rtt is the mean response time of the window and min_rtt is the lowest response
+ * time seen since the last min RTT reset. While latency stays near the min RTT the limit grows
+ * by sqrt(limit) per window, and once requests start to queue upstream it shrinks in proportion.
+ * The min RTT is reset to the current window's minimum every
+ * adaptive_concurrency.min_rtt_recalc_windows windows, so that it follows the upstream when its
+ * unloaded latency changes.
+ */
+class AdaptiveConcurrencyController {
+public:
+  AdaptiveConcurrencyController(Runtime::Loader& runtime, const std::string& stats_prefix,
+                                Stats::Scope& scope, MonotonicTimeSource& time_source);
+
+  /**
+   * Admit a request if there is room under the concurrency limit. Every successful call must be
+   * matched by a call to release().
+   * @return bool whether the request was admitted.
+   */
+  bool tryAcquire();
+
+  /**
+   * Release a request that was admitted by tryAcquire().
+   */
+  void release();
+
+  /**
+   * Record the response time of an admitted request, and update the limit when the sample window
+   * is full.
+   */
+  void recordLatency(std::chrono::microseconds rtt);
+
+  uint32_t concurrencyLimit() const { return limit_; }
+  AdaptiveConcurrencyStats& stats() { return stats_; }
+  MonotonicTimeSource& timeSource() { return time_source_; }
+
+private:
+  static AdaptiveConcurrencyStats generateStats(const std::string& prefix, Stats::Scope& scope);
+  void updateLimit(std::chrono::microseconds sample_rtt);
+  uint32_t clampLimit(uint64_t limit);
+
+  Runtime::Loader& runtime_;
+  AdaptiveConcurrencyStats stats_;
+  MonotonicTimeSource& time_source_;
+  std::atomic<uint32_t> in_flight_{};
+  std::atomic<uint32_t> limit_;
+
+  // Sample window state, guarded by sample_lock_.
+  std::mutex sample_lock_;
+  uint64_t num_samples_{};
+  std::chrono::microseconds sample_sum_{};
+  std::chrono::microseconds sample_min_{std::chrono::microseconds::max()};
+  std::chrono::microseconds min_rtt_{std::chrono::microseconds::max()};
+  uint64_t windows_since_min_rtt_reset_{};
+};
+
+typedef std::shared_ptr<AdaptiveConcurrencyController> AdaptiveConcurrencyControllerSharedPtr;
+
+/**
+ * A filter that limits the number of requests in flight to what the controller currently allows,
+ * and rejects the rest with a 503 before they reach the router.
+ */
+class AdaptiveConcurrencyFilter : public StreamFilter {
+public:
+  AdaptiveConcurrencyFilter(AdaptiveConcurrencyControllerSharedPtr controller)
+      : controller_(controller) {}
+
+  // Http::StreamFilterBase
+  void onDestroy() override;
+
+  // Http::StreamDecoderFilter
+  FilterHeadersStatus decodeHeaders(HeaderMap& headers, bool end_stream) override;
+  FilterDataStatus decodeData(Buffer::Instance&, bool) override {
+    return FilterDataStatus::Continue;
+  }
+  FilterTrailersStatus decodeTrailers(HeaderMap&) override {
+    return FilterTrailersStatus::Continue;
+  }
+  void setDecoderFilterCallbacks(StreamDecoderFilterCallbacks& callbacks) override {
+    decoder_callbacks_ = &callbacks;
+  }
+
+  // Http::StreamEncoderFilter
+  FilterHeadersStatus encodeHeaders(HeaderMap& headers, bool end_stream) override;
+  FilterDataStatus encodeData(Buffer::Instance&, bool) override {
+    return FilterDataStatus::Continue;
+  }
+  FilterTrailersStatus encodeTrailers(HeaderMap&) override {
+    return FilterTrailersStatus::Continue;
+  }
+  void setEncoderFilterCallbacks(StreamEncoderFilterCallbacks&) override {}
+
+private:
+  AdaptiveConcurrencyControllerSharedPtr controller_;
+  StreamDecoderFilterCallbacks* decoder_callbacks_{};
+  MonotonicTime start_time_;
+  bool admitted_{};
+  bool sampled_{};
+  bool stream_destroyed_{};
+};
+
+} // namespace Http
+} // namespace Envoy
@@ -17,9 +17,14 @@
 namespace Envoy {
 namespace Http {
 
+const std::chrono::milliseconds BufferFilter::REPLAY_RETRY_INTERVAL(10);
+
 BufferFilter::BufferFilter(BufferFilterConfigConstSharedPtr config) : config_(config) {}
 
-BufferFilter::~BufferFilter() { ASSERT(!request_timeout_); }
+BufferFilter::~BufferFilter() {
+  ASSERT(!request_timeout_);
+  ASSERT(!replay_timer_);
+}
 
 FilterHeadersStatus BufferFilter::decodeHeaders(HeaderMap&, bool end_stream) {
   if (end_stream) {
@@ -34,7 +39,11 @@ FilterHeadersStatus BufferFilter::decodeHeaders(HeaderMap&, bool end_stream) {
   }
 }
 
-FilterDataStatus BufferFilter::decodeData(Buffer::Instance&, bool end_stream) {
+FilterDataStatus BufferFilter::decodeData(Buffer::Instance& data, bool end_stream) {
+  if (spill_threshold_ > 0) {
+    return decodeDataAndSpill(data, end_stream);
+  }
+
   if (end_stream) {
     resetInternalState();
     return FilterDataStatus::Continue;
@@ -44,8 +53,106 @@ FilterDataStatus BufferFilter::decodeData(Buffer::Instance&, bool end_stream) {
   return FilterDataStatus::StopIterationAndBuffer;
 }
 
+FilterDataStatus BufferFilter::decodeDataAndSpill(Buffer::Instance& data, bool end_stream) {
+  received_bytes_ += data.length();
+  if (received_bytes_ > config_->max_request_bytes_) {
+    // The same response that the connection manager sends when its buffer limit is exceeded.
+    config_->stats_.rq_too_large_.inc();
+    data.drain(data.length());
+    Http::Utility::sendLocalReply(*callbacks_, stream_destroyed_, Http::Code::PayloadTooLarge,
+                                  CodeUtility::toString(Http::Code::PayloadTooLarge));
+    return FilterDataStatus::StopIterationNoBuffer;
+  }
+
+  if (spill_file_) {
+    if (!spill_file_->write(data)) {
+      ENVOY_STREAM_LOG(debug, "failed to write spilled request body", *callbacks_);
+      config_->stats_.rq_spill_failed_.inc();
+      callbacks_->resetStream();
+      return FilterDataStatus::StopIterationNoBuffer;
+    }
+  } else {
+    body_.move(data);
+    if (body_.length() > spill_threshold_ && !spill_failed_) {
+      spill();
+    }
+  }
+
+  if (end_stream) {
+    resetInternalState();
+    // The body can't be passed on from within this callback.
+    scheduleReplay(std::chrono::milliseconds(0));
+  }
+  return FilterDataStatus::StopIterationNoBuffer;
+}
+
+void BufferFilter::spill() {
+  const std::string& directory = config_->runtime_.snapshot().get("buffer.spill_directory");
+  spill_file_ = Buffer::SpillFile::create(directory.empty() ? "/tmp" : directory);
+  if (!spill_file_ || !spill_file_->write(body_)) {
+    // Keep the body in memory, as without spilling.
+    ENVOY_STREAM_LOG(debug, "failed to spill request body", *callbacks_);
+    config_->stats_.rq_spill_failed_.inc();
+    spill_file_.reset();
+    spill_failed_ = true;
+    return;
+  }
+
+  ENVOY_STREAM_LOG(debug, "spilled request body", *callbacks_);
+  config_->stats_.rq_spilled_.inc();
+}
+
+void BufferFilter::scheduleReplay(std::chrono::milliseconds delay) {
+  if (!replay_timer_) {
+    replay_timer_ = callbacks_->dispatcher().createTimer([this]() -> void { replayBody(); });
+  }
+  replay_timer_->enableTimer(delay);
+}
+
+void BufferFilter::replayBody() {
+  // Data is injected at least once, so that the headers and end of stream are passed on even if
+  // the body is empty.
+  bool done = false;
+  while (!done) {
+    if (callbacks_->aboveDecoderWriteBufferHighWatermark()) {
+      scheduleReplay(REPLAY_RETRY_INTERVAL);
+      return;
+    }
+
+    Buffer::OwnedImpl chunk;
+    if (spill_file_) {
+      if (!spill_file_->read(chunk, REPLAY_CHUNK_SIZE)) {
+        ENVOY_STREAM_LOG(debug, "failed to read spilled request body", *callbacks_);
+        config_->stats_.rq_spill_failed_.inc();
+        callbacks_->resetStream();
+        return;
+      }
+    } else {
+      chunk.move(body_);
+    }
+
+    done = body_.length() == 0 && (!spill_file_ || spill_file_->unreadLength() == 0);
+    callbacks_->injectDecodedDataToFilterChain(chunk, done && !has_trailers_);
+    if (stream_destroyed_) {
+      // A further filter responded, and the stream is gone.
+      return;
+    }
+  }
+
+  replay_timer_.reset();
+  spill_file_.reset();
+  if (has_trailers_) {
+    callbacks_->continueDecoding();
+  }
+}
+
 FilterTrailersStatus BufferFilter::decodeTrailers(HeaderMap&) {
   resetInternalState();
+  if (spill_threshold_ > 0 && received_bytes_ > 0) {
+    has_trailers_ = true;
+    scheduleReplay(std::chrono::milliseconds(0));
+    return FilterTrailersStatus::StopIteration;
+  }
   return FilterTrailersStatus::Continue;
 }
 
@@ -56,6 +163,8 @@ BufferFilterStats BufferFilter::generateStats(const std::string& prefix, Stats::
 
 void BufferFilter::onDestroy() {
   resetInternalState();
+  replay_timer_.reset();
+  spill_file_.reset();
   stream_destroyed_ = true;
 }
 
@@ -69,7 +178,12 @@ void BufferFilter::resetInternalState() { request_timeout_.reset(); }
 
 void BufferFilter::setDecoderFilterCallbacks(StreamDecoderFilterCallbacks& callbacks) {
   callbacks_ = &callbacks;
-  callbacks_->setDecoderBufferLimit(config_->max_request_bytes_);
+  spill_threshold_ = config_->runtime_.snapshot().getInteger("buffer.spill_threshold_bytes", 0);
+  if (spill_threshold_ == 0) {
+    callbacks_->setDecoderBufferLimit(config_->max_request_bytes_);
+  }
+  // Otherwise the connection manager does not buffer the body, and its limit is left alone so
+  // that buffers further along, which size themselves by it, stay small.
 }
 
 } // namespace Http
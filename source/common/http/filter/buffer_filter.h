@@ -6,9 +6,12 @@
 #include <string>
 
 #include "envoy/http/filter.h"
+#include "envoy/runtime/runtime.h"
 #include "envoy/stats/stats_macros.h"
 
 #include "common/buffer/buffer_impl.h"
+#include "common/buffer/spill_file.h"
+#include "common/common/logger.h"
 
 namespace Envoy {
 namespace Http {
@@ -18,7 +21,10 @@ namespace Http {
  */
 // clang-format off
 #define ALL_BUFFER_FILTER_STATS(COUNTER)                                                           \
-  COUNTER(rq_timeout)
+  COUNTER(rq_timeout)                                                                              \
+  COUNTER(rq_too_large)                                                                            \
+  COUNTER(rq_spilled)                                                                              \
+  COUNTER(rq_spill_failed)
 // clang-format on
 
 /**
@@ -35,14 +41,21 @@ struct BufferFilterConfig {
   BufferFilterStats stats_;
   uint64_t max_request_bytes_;
   std::chrono::seconds max_request_time_;
+  Runtime::Loader& runtime_;
 };
 
 typedef std::shared_ptr<const BufferFilterConfig> BufferFilterConfigConstSharedPtr;
 
 /**
  * A filter that is capable of buffering an entire request before dispatching it upstream.
+ *
+ * If the runtime key buffer.spill_threshold_bytes is set, the filter holds the body itself rather
+ * than in the connection manager, and writes it to a temporary file in buffer.spill_directory
+ * (default /tmp) once it grows past the threshold. The complete body is then streamed to the
+ * following filters in pieces, pausing whenever the upstream is backed up, so that memory per
+ * request stays bounded however large max_request_bytes is.
  */
-class BufferFilter : public StreamDecoderFilter {
+class BufferFilter : public StreamDecoderFilter, Logger::Loggable<Logger::Id::filter> {
 public:
   BufferFilter(BufferFilterConfigConstSharedPtr config);
   ~BufferFilter();
@@ -58,7 +71,16 @@ public:
   FilterTrailersStatus decodeTrailers(HeaderMap& trailers) override;
   void setDecoderFilterCallbacks(StreamDecoderFilterCallbacks& callbacks) override;
 
+  // The size of the pieces that a spilled body is read back in.
+  static const uint64_t REPLAY_CHUNK_SIZE = 65536;
+  // How long to wait before checking again whether an upstream which is backed up has drained.
+  static const std::chrono::milliseconds REPLAY_RETRY_INTERVAL;
+
 private:
+  FilterDataStatus decodeDataAndSpill(Buffer::Instance& data, bool end_stream);
+  void spill();
+  void scheduleReplay(std::chrono::milliseconds delay);
+  void replayBody();
   void onRequestTimeout();
   void resetInternalState();
 
@@ -66,6 +88,15 @@ private:
   StreamDecoderFilterCallbacks* callbacks_{};
   Event::TimerPtr request_timeout_;
   bool stream_destroyed_{};
+  // Zero unless the body is held by the filter.
+  uint64_t spill_threshold_{};
+  uint64_t received_bytes_{};
+  // The body held by the filter before it spills.
+  Buffer::OwnedImpl body_;
+  Buffer::SpillFilePtr spill_file_;
+  bool spill_failed_{};
+  bool has_trailers_{};
+  Event::TimerPtr replay_timer_;
 };
 
 } // Http
@@ -0,0 +1,287 @@
+#include "common/http/filter/cache/cache_filter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "envoy/http/codes.h"
+#include "envoy/stats/stats.h"
+
+#include "common/common/assert.h"
+#include "common/common/enum_to_int.h"
+#include "common/common/utility.h"
+#include "common/http/filter/cache/disk_http_cache.h"
+#include "common/http/filter/cache/http_cache_impl.h"
+#include "common/http/filter/cache/lru_http_cache.h"
+#include "common/http/header_map_impl.h"
+#include "common/http/headers.h"
+#include "common/http/utility.h"
+#include "common/json/config_schemas.h"
+
+namespace Envoy {
+namespace Http {
+namespace Filter {
+namespace Cache {
+
+bool CollapsedRequests::joinOrLead(const std::string& key, Event::Dispatcher& dispatcher,
+                                   WakeCb wake_cb) {
+  std::lock_guard<std::mutex> guard(lock_);
+  auto it = in_flight_.find(key);
+  if (it == in_flight_.end()) {
+    in_flight_.emplace(key, std::vector<Waiter>());
+    return true;
+  }
+
+  it->second.push_back({dispatcher, wake_cb});
+  return false;
+}
+
+void CollapsedRequests::release(const std::string& key) {
+  std::vector<Waiter> waiters;
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    auto it = in_flight_.find(key);
+    ASSERT(it != in_flight_.end());
+    waiters.swap(it->second);
+    in_flight_.erase(it);
+  }
+
+  for (Waiter& waiter : waiters) {
+    waiter.dispatcher_.post(waiter.wake_cb_);
+  }
+}
+
+CacheFilterConfig::CacheFilterConfig(const Json::Object& json_config,
+                                     const std::string& stats_prefix, Stats::Scope& scope,
+                                     SystemTimeSource& time_source)
+    : max_entry_bytes_(json_config.getInteger("max_entry_bytes", 1024 * 1024)),
+      stats_(generateStats(stats_prefix, scope)), time_source_(time_source) {
+  json_config.validateSchema(Json::Schema::HTTP_CACHE_FILTER_SCHEMA);
+
+  cache_ = std::make_shared<LruHttpCache>(
+      json_config.getInteger("max_memory_bytes", 64 * 1024 * 1024));
+  if (json_config.hasObject("disk_cache")) {
+    Json::ObjectSharedPtr disk_config = json_config.getObject("disk_cache");
+    cache_ = std::make_shared<TieredHttpCache>(
+        cache_, std::make_shared<DiskHttpCache>(disk_config->getString("directory"),
+                                                disk_config->getInteger("max_bytes",
+                                                                        1024 * 1024 * 1024)));
+  }
+}
+
+CacheFilterConfig::CacheFilterConfig(HttpCacheSharedPtr cache, uint64_t max_entry_bytes,
+                                     const std::string& stats_prefix, Stats::Scope& scope,
+                                     SystemTimeSource& time_source)
+    : cache_(cache), max_entry_bytes_(max_entry_bytes), stats_(generateStats(stats_prefix, scope)),
+      time_source_(time_source) {}
+
+CacheFilterStats CacheFilterConfig::generateStats(const std::string& prefix,
+                                                  Stats::Scope& scope) {
+  std::string final_prefix = prefix + "cache.";
+  return {ALL_CACHE_FILTER_STATS(POOL_COUNTER_PREFIX(scope, final_prefix))};
+}
+
+bool CacheFilter::isCacheableRequest(const HeaderMap& headers) {
+  if (headers.Method() == nullptr || headers.Host() == nullptr || headers.Path() == nullptr ||
+      headers.Method()->value() != Headers::get().MethodValues.Get.c_str() ||
+      headers.Authorization() != nullptr) {
+    return false;
+  }
+
+  const CacheControl cache_control = CacheUtility::parseCacheControl(headers);
+  return !cache_control.no_cache_ && !cache_control.no_store_;
+}
+
+std::string CacheFilter::variantKey(const std::string& key, const std::vector<std::string>& vary,
+                                    const HeaderMap& request_headers) {
+  std::string variant_key = key;
+  for (const std::string& name : vary) {
+    const HeaderEntry* header = request_headers.get(LowerCaseString(name));
+    variant_key += fmt::format("\n{}:{}", name, header ? header->value().c_str() : "");
+  }
+  return variant_key;
+}
+
+FilterHeadersStatus CacheFilter::decodeHeaders(HeaderMap& headers, bool) {
+  if (!isCacheableRequest(headers)) {
+    return FilterHeadersStatus::Continue;
+  }
+
+  request_headers_ = &headers;
+  // The scheme keeps responses for http and https URLs apart. HTTP/1 requests have no :scheme here,
+  // but the connection manager has set x-forwarded-proto on them.
+  const HeaderEntry* scheme = headers.Scheme() ? headers.Scheme() : headers.ForwardedProto();
+  key_ = fmt::format("{}://{}{}", scheme ? scheme->value().c_str() : "",
+                     headers.Host()->value().c_str(), headers.Path()->value().c_str());
+  if (serveFromCache()) {
+    return FilterHeadersStatus::StopIteration;
+  }
+
+  config_->stats().miss_.inc();
+  std::weak_ptr<CacheFilter> weak_this = shared_from_this();
+  if (config_->collapsedRequests().joinOrLead(key_, decoder_callbacks_->dispatcher(),
+                                              [weak_this]() -> void {
+                                                std::shared_ptr<CacheFilter> filter =
+                                                    weak_this.lock();
+                                                if (filter) {
+                                                  filter->onLeaderReleased();
+                                                }
+                                              })) {
+    leader_ = true;
+    return FilterHeadersStatus::Continue;
+  }
+
+  config_->stats().collapsed_.inc();
+  waiting_ = true;
+  return FilterHeadersStatus::StopIteration;
+}
+
+bool CacheFilter::serveFromCache() {
+  CachedResponseConstSharedPtr response = config_->cache().lookup(key_);
+  if (response) {
+    if (!response->varyHeaders().empty()) {
+      response =
+          config_->cache().lookup(variantKey(key_, response->varyHeaders(), *request_headers_));
+    }
+  }
+  if (!response) {
+    return false;
+  }
+
+  const std::chrono::seconds age = std::chrono::duration_cast<std::chrono::seconds>(
+      config_->timeSource().currentTime() - response->responseTime());
+  if (age >= response->maxAge()) {
+    return false;
+  }
+
+  config_->stats().hit_.inc();
+  served_from_cache_ = true;
+  HeaderMapPtr headers(new HeaderMapImpl(response->headers()));
+  headers->remove(Headers::get().Age);
+  headers->addReferenceKey(Headers::get().Age, std::max<int64_t>(0, age.count()));
+
+  if (response->bodySize() == 0) {
+    decoder_callbacks_->encodeHeaders(std::move(headers), true);
+    return true;
+  }
+
+  decoder_callbacks_->encodeHeaders(std::move(headers), false);
+  Buffer::OwnedImpl body;
+  response->addBodyTo(body);
+  decoder_callbacks_->encodeData(body, true);
+  return true;
+}
+
+void CacheFilter::onLeaderReleased() {
+  if (stream_destroyed_ || !waiting_) {
+    return;
+  }
+
+  // The leader's response is in the cache now unless it was not cacheable, in which case this
+  // request goes upstream on its own rather than leading a new round of waiters.
+  waiting_ = false;
+  if (!serveFromCache()) {
+    decoder_callbacks_->continueDecoding();
+  }
+}
+
+FilterHeadersStatus CacheFilter::encodeHeaders(HeaderMap& headers, bool end_stream) {
+  if (!leader_ || served_from_cache_) {
+    return FilterHeadersStatus::Continue;
+  }
+
+  const CacheControl cache_control = CacheUtility::parseCacheControl(headers);
+  const Optional<std::chrono::seconds>& max_age =
+      cache_control.s_maxage_.valid() ? cache_control.s_maxage_ : cache_control.max_age_;
+  vary_ = CacheUtility::varyHeaders(headers);
+  if (Utility::getResponseStatus(headers) != enumToInt(Code::OK) || cache_control.no_store_ ||
+      cache_control.no_cache_ || cache_control.private_ || !max_age.valid() ||
+      max_age.value().count() == 0 ||
+      std::find(vary_.begin(), vary_.end(), "*") != vary_.end() ||
+      headers.get(Headers::get().SetCookie) != nullptr) {
+    releaseLeadership();
+    return FilterHeadersStatus::Continue;
+  }
+
+  // The response was generated before it got here if upstream is a cache itself.
+  uint64_t age = 0;
+  const HeaderEntry* age_header = headers.get(Headers::get().Age);
+  if (age_header) {
+    StringUtil::atoul(age_header->value().c_str(), age);
+  }
+
+  caching_ = true;
+  response_headers_.reset(new HeaderMapImpl(headers));
+  response_time_ = config_->timeSource().currentTime() - std::chrono::seconds(age);
+  max_age_ = max_age.value();
+  if (end_stream) {
+    insert();
+  }
+  return FilterHeadersStatus::Continue;
+}
+
+FilterDataStatus CacheFilter::encodeData(Buffer::Instance& data, bool end_stream) {
+  if (!caching_) {
+    return FilterDataStatus::Continue;
+  }
+
+  if (response_body_.length() + data.length() > config_->maxEntryBytes()) {
+    config_->stats().too_large_.inc();
+    response_body_.drain(response_body_.length());
+    releaseLeadership();
+    return FilterDataStatus::Continue;
+  }
+
+  response_body_.add(data);
+  if (end_stream) {
+    insert();
+  }
+  return FilterDataStatus::Continue;
+}
+
+FilterTrailersStatus CacheFilter::encodeTrailers(HeaderMap&) {
+  // Trailers are not cached. The response is complete without them.
+  if (caching_) {
+    insert();
+  }
+  return FilterTrailersStatus::Continue;
+}
+
+void CacheFilter::insert() {
+  ASSERT(caching_);
+  if (vary_.empty()) {
+    config_->cache().insert(key_, *response_headers_, response_body_, response_time_, max_age_);
+  } else {
+    config_->cache().insert(variantKey(key_, vary_, *request_headers_), *response_headers_,
+                            response_body_, response_time_, max_age_);
+    HeaderMapImpl marker;
+    marker.addCopy(Headers::get().Vary,
+                   response_headers_->get(Headers::get().Vary)->value().c_str());
+    config_->cache().insert(key_, marker, Buffer::OwnedImpl(), response_time_, max_age_);
+  }
+
+  config_->stats().insert_.inc();
+  response_headers_.reset();
+  response_body_.drain(response_body_.length());
+  releaseLeadership();
+}
+
+void CacheFilter::releaseLeadership() {
+  caching_ = false;
+  if (leader_) {
+    leader_ = false;
+    config_->collapsedRequests().release(key_);
+  }
+}
+
+void CacheFilter::onDestroy() {
+  stream_destroyed_ = true;
+  releaseLeadership();
+}
+
+} // namespace Cache
+} // namespace Filter
+} // namespace Http
+} // namespace Envoy
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "envoy/common/time.h"
+#include "envoy/event/dispatcher.h"
+#include "envoy/http/filter.h"
+#include "envoy/json/json_object.h"
+#include "envoy/stats/stats_macros.h"
+
+#include "common/buffer/buffer_impl.h"
+#include "common/http/filter/cache/http_cache.h"
+
+namespace Envoy {
+namespace Http {
+namespace Filter {
+namespace Cache {
+
+/**
+ * All stats for the cache filter. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_CACHE_FILTER_STATS(COUNTER)                                                            \
+  COUNTER(hit)                                                                                     \
+  COUNTER(miss)                                                                                    \
+  COUNTER(collapsed)                                                                               \
+  COUNTER(insert)                                                                                  \
+  COUNTER(too_large)
+// clang-format on
+
+/**
+ * Wrapper struct for cache filter stats. @see stats_macros.h
+ */
+struct CacheFilterStats {
+  ALL_CACHE_FILTER_STATS(GENERATE_COUNTER_STRUCT)
+};
+
+/**
+ * Tracks the cache misses that are currently being fetched from upstream, so that concurrent
+ * misses for the same key make a single upstream request. The first miss for a key leads: it goes
+ * upstream and calls release() once its response is cached or turns out not to be cacheable. Later
+ * misses wait, and are woken on their own dispatcher when the leader releases the key. Shared by
+ * all workers.
+ */
+class CollapsedRequests {
+public:
+  typedef std::function<void()> WakeCb;
+
+  /**
+   * @param key supplies the cache key that missed.
+   * @param dispatcher supplies the dispatcher to run wake_cb on.
+   * @param wake_cb supplies the callback to run once the leader releases the key.
+   * @return bool true if the caller is the leader for the key, in which case wake_cb is not kept.
+   */
+  bool joinOrLead(const std::string& key, Event::Dispatcher& dispatcher, WakeCb wake_cb);
+
+  /**
+   * Release a key that the caller leads and wake all of its waiters.
+   */
+  void release(const std::string& key);
+
+private:
+  struct Waiter {
+    Event::Dispatcher& dispatcher_;
+    WakeCb wake_cb_;
+  };
+
+  std::mutex lock_;
+  std::unordered_map<std::string, std::vector<Waiter>> in_flight_;
+};
+
+/**
+ * Configuration for the cache filter.
+ */
+class CacheFilterConfig {
+public:
+  CacheFilterConfig(const Json::Object& json_config, const std::string& stats_prefix,
+                    Stats::Scope& scope, SystemTimeSource& time_source);
+  CacheFilterConfig(HttpCacheSharedPtr cache, uint64_t max_entry_bytes,
+                    const std::string& stats_prefix, Stats::Scope& scope,
+                    SystemTimeSource& time_source);
+
+  HttpCache& cache() { return *cache_; }
+  uint64_t maxEntryBytes() const { return max_entry_bytes_; }
+  CacheFilterStats& stats() { return stats_; }
+  SystemTimeSource& timeSource() { return time_source_; }
+  CollapsedRequests& collapsedRequests() { return collapsed_requests_; }
+
+private:
+  static CacheFilterStats generateStats(const std::string& prefix, Stats::Scope& scope);
+
+  HttpCacheSharedPtr cache_;
+  const uint64_t max_entry_bytes_;
+  CacheFilterStats stats_;
+  SystemTimeSource& time_source_;
+  CollapsedRequests collapsed_requests_;
+};
+
+typedef std::shared_ptr<CacheFilterConfig> CacheFilterConfigSharedPtr;
+
+/**
+ * A filter that serves GET requests from an HttpCache while the cached response is fresh, and
+ * caches the 200 responses that Cache-Control allows a shared cache to store and that do not set
+ * cookies. Responses are keyed by scheme, host and path. Responses with a Vary header are stored
+ * under a key that includes the request's values of the varied headers, next to a marker entry
+ * under the plain key that records which headers vary.
+ */
+class CacheFilter : public StreamFilter, public std::enable_shared_from_this<CacheFilter> {
+public:
+  CacheFilter(CacheFilterConfigSharedPtr config) : config_(config) {}
+
+  // Http::StreamFilterBase
+  void onDestroy() override;
+
+  // Http::StreamDecoderFilter
+  FilterHeadersStatus decodeHeaders(HeaderMap& headers, bool end_stream) override;
+  FilterDataStatus decodeData(Buffer::Instance&, bool) override {
+    return FilterDataStatus::Continue;
+  }
+  FilterTrailersStatus decodeTrailers(HeaderMap&) override {
+    return FilterTrailersStatus::Continue;
+  }
+  void setDecoderFilterCallbacks(StreamDecoderFilterCallbacks& callbacks) override {
+    decoder_callbacks_ = &callbacks;
+  }
+
+  // Http::StreamEncoderFilter
+  FilterHeadersStatus encodeHeaders(HeaderMap& headers, bool end_stream) override;
+  FilterDataStatus encodeData(Buffer::Instance& data, bool end_stream) override;
+  FilterTrailersStatus encodeTrailers(HeaderMap& trailers) override;
+  void setEncoderFilterCallbacks(StreamEncoderFilterCallbacks&) override {}
+
+private:
+  static bool isCacheableRequest(const HeaderMap& headers);
+  static std::string variantKey(const std::string& key, const std::vector<std::string>& vary,
+                                const HeaderMap& request_headers);
+
+  /**
+   * Send the cached response for the request, if there is a fresh one.
+   * @return bool whether a response was sent.
+   */
+  bool serveFromCache();
+  void onLeaderReleased();
+  void insert();
+  void releaseLeadership();
+
+  CacheFilterConfigSharedPtr config_;
+  StreamDecoderFilterCallbacks* decoder_callbacks_{};
+  const HeaderMap* request_headers_{};
+  std::string key_;
+
+  // Response being cached. Only used by the leader of a miss.
+  HeaderMapPtr response_headers_;
+  Buffer::OwnedImpl response_body_;
+  SystemTime response_time_;
+  std::chrono::seconds max_age_{};
+  std::vector<std::string> vary_;
+
+  bool leader_{};
+  bool caching_{};
+  bool waiting_{};
+  bool served_from_cache_{};
+  bool stream_destroyed_{};
+};
+
+} // namespace Cache
+} // namespace Filter
+} // namespace Http
+} // namespace Envoy
@@ -0,0 +1,291 @@
+#include "common/http/filter/cache/disk_http_cache.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "envoy/common/exception.h"
+
+#include "common/common/hash.h"
+#include "common/common/utility.h"
+#include "common/http/filter/cache/http_cache_impl.h"
+
+#include "fmt/format.h"
+
+namespace Envoy {
+namespace Http {
+namespace Filter {
+namespace Cache {
+
+namespace {
+
+// Cache file layout, in host byte order since files never outlive the process that wrote them:
+//   magic, response time (ns since epoch), max age (s), key size, key,
+//   header count, (name size, name, value size, value) per header, body size, body.
+const char FILE_MAGIC[8] = {'E', 'N', 'V', 'O', 'Y', 'H', 'C', '1'};
+
+template <class T> void appendInt(std::string& out, T value) {
+  out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void appendString(std::string& out, const char* data, uint32_t size) {
+  appendInt<uint32_t>(out, size);
+  out.append(data, size);
+}
+
+/**
+ * Bounds checked reads from a cache file.
+ */
+class FileReader {
+public:
+  FileReader(const uint8_t* data, uint64_t size) : data_(data), size_(size) {}
+
+  template <class T> bool readInt(T& value) {
+    if (size_ - offset_ < sizeof(T)) {
+      return false;
+    }
+    memcpy(&value, data_ + offset_, sizeof(T));
+    offset_ += sizeof(T);
+    return true;
+  }
+
+  bool readString(std::string& value) {
+    uint32_t size;
+    if (!readInt(size) || size_ - offset_ < size) {
+      return false;
+    }
+    value.assign(reinterpret_cast<const char*>(data_ + offset_), size);
+    offset_ += size;
+    return true;
+  }
+
+  bool readBytes(const uint8_t*& bytes, uint64_t size) {
+    if (size_ - offset_ < size) {
+      return false;
+    }
+    bytes = data_ + offset_;
+    offset_ += size;
+    return true;
+  }
+
+  bool done() const { return offset_ == size_; }
+
+private:
+  const uint8_t* data_;
+  const uint64_t size_;
+  uint64_t offset_{};
+};
+
+bool writeAll(int fd, const void* data, uint64_t size) {
+  const uint8_t* position = static_cast<const uint8_t*>(data);
+  while (size > 0) {
+    const ssize_t rc = ::write(fd, position, size);
+    if (rc < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    position += rc;
+    size -= rc;
+  }
+  return true;
+}
+
+} // namespace
+
+MappedFile::~MappedFile() { ::munmap(const_cast<void*>(data_), size_); }
+
+DiskCachedResponse::DiskCachedResponse(MappedFileConstSharedPtr file, const HeaderMap& headers,
+                                       SystemTime response_time, std::chrono::seconds max_age,
+                                       const uint8_t* body, uint64_t body_size)
+    : file_(file), headers_(headers), vary_(CacheUtility::varyHeaders(headers)),
+      response_time_(response_time), max_age_(max_age), body_(body), body_size_(body_size) {}
+
+void DiskCachedResponse::addBodyTo(Buffer::Instance& buffer) const {
+  CacheUtility::addBufferReference(buffer, body_, body_size_, file_);
+}
+
+const std::string DiskHttpCache::FILE_PREFIX = "envoy_cache_";
+
+DiskHttpCache::DiskHttpCache(const std::string& directory, uint64_t max_bytes)
+    : directory_(createDirectory(directory)), max_bytes_(max_bytes) {}
+
+DiskHttpCache::~DiskHttpCache() {
+  // Only this cache writes to its directory. Responses that are still mapped stay readable.
+  DIR* dir = ::opendir(directory_.c_str());
+  if (dir != nullptr) {
+    while (dirent* entry = ::readdir(dir)) {
+      if (StringUtil::startsWith(entry->d_name, FILE_PREFIX)) {
+        ::unlink((directory_ + "/" + entry->d_name).c_str());
+      }
+    }
+    ::closedir(dir);
+  }
+  ::rmdir(directory_.c_str());
+}
+
+std::string DiskHttpCache::createDirectory(const std::string& parent) {
+  std::string path = parent + "/" + FILE_PREFIX + "XXXXXX";
+  if (::mkdtemp(&path[0]) == nullptr) {
+    throw EnvoyException(fmt::format("unable to create cache directory in '{}'", parent));
+  }
+  return path;
+}
+
+std::string DiskHttpCache::fileName(const std::string& key) const {
+  return fmt::format("{}{:016x}", FILE_PREFIX, HashUtil::xxHash64(key));
+}
+
+CachedResponseConstSharedPtr DiskHttpCache::lookup(const std::string& key) {
+  const std::string file_name = fileName(key);
+  const int fd = ::open((directory_ + "/" + file_name).c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return nullptr;
+  }
+
+  struct stat file_stat;
+  void* data = MAP_FAILED;
+  if (::fstat(fd, &file_stat) == 0 && file_stat.st_size > 0) {
+    data = ::mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  }
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    return nullptr;
+  }
+  MappedFileConstSharedPtr file = std::make_shared<MappedFile>(data, file_stat.st_size);
+
+  // Any file that does not parse, or that holds another key with the same hash, is a miss.
+  FileReader reader(file->data(), file->size());
+  const uint8_t* magic;
+  int64_t response_time_ns;
+  uint64_t max_age_s;
+  std::string file_key;
+  uint32_t num_headers;
+  if (!reader.readBytes(magic, sizeof(FILE_MAGIC)) ||
+      memcmp(magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 || !reader.readInt(response_time_ns) ||
+      !reader.readInt(max_age_s) || !reader.readString(file_key) || file_key != key ||
+      !reader.readInt(num_headers)) {
+    return nullptr;
+  }
+
+  HeaderMapImpl headers;
+  for (uint32_t i = 0; i < num_headers; i++) {
+    std::string name;
+    std::string value;
+    if (!reader.readString(name) || !reader.readString(value)) {
+      return nullptr;
+    }
+    headers.addCopy(LowerCaseString(name), value);
+  }
+
+  uint64_t body_size;
+  const uint8_t* body;
+  if (!reader.readInt(body_size) || !reader.readBytes(body, body_size) || !reader.done()) {
+    return nullptr;
+  }
+
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    auto it = index_.find(file_name);
+    if (it != index_.end()) {
+      files_.splice(files_.begin(), files_, it->second);
+    }
+  }
+
+  return std::make_shared<DiskCachedResponse>(
+      file, headers,
+      SystemTime(std::chrono::duration_cast<SystemTime::duration>(
+          std::chrono::nanoseconds(response_time_ns))),
+      std::chrono::seconds(max_age_s), body, body_size);
+}
+
+void DiskHttpCache::insert(const std::string& key, const HeaderMap& headers,
+                           const Buffer::Instance& body, SystemTime response_time,
+                           std::chrono::seconds max_age) {
+  std::string header_block(FILE_MAGIC, sizeof(FILE_MAGIC));
+  appendInt<int64_t>(header_block, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                       response_time.time_since_epoch())
+                                       .count());
+  appendInt<uint64_t>(header_block, max_age.count());
+  appendString(header_block, key.data(), key.size());
+  appendInt<uint32_t>(header_block, headers.size());
+  headers.iterate(
+      [](const HeaderEntry& header, void* context) -> HeaderMap::Iterate {
+        std::string& out = *static_cast<std::string*>(context);
+        appendString(out, header.key().c_str(), header.key().size());
+        appendString(out, header.value().c_str(), header.value().size());
+        return HeaderMap::Iterate::Continue;
+      },
+      &header_block);
+  appendInt<uint64_t>(header_block, body.length());
+
+  const uint64_t size = header_block.size() + body.length();
+  if (size > max_bytes_) {
+    return;
+  }
+
+  const std::string file_name = fileName(key);
+  const std::string path = directory_ + "/" + file_name;
+  const std::string temp_path =
+      fmt::format("{}/{}.tmp{}", directory_, file_name, next_temp_file_id_++);
+  const int fd = ::open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+  if (fd < 0) {
+    return;
+  }
+
+  bool written = writeAll(fd, header_block.data(), header_block.size());
+  const uint64_t num_slices = body.getRawSlices(nullptr, 0);
+  Buffer::RawSlice slices[num_slices];
+  body.getRawSlices(slices, num_slices);
+  for (uint64_t i = 0; written && i < num_slices; i++) {
+    written = writeAll(fd, slices[i].mem_, slices[i].len_);
+  }
+  ::close(fd);
+
+  if (!written || ::rename(temp_path.c_str(), path.c_str()) != 0) {
+    ::unlink(temp_path.c_str());
+    return;
+  }
+
+  addFile(file_name, size);
+}
+
+void DiskHttpCache::addFile(const std::string& file_name, uint64_t size) {
+  std::lock_guard<std::mutex> guard(lock_);
+  auto existing = index_.find(file_name);
+  if (existing != index_.end()) {
+    bytes_ -= existing->second->second;
+    files_.erase(existing->second);
+  }
+  files_.emplace_front(file_name, size);
+  index_[file_name] = files_.begin();
+  bytes_ += size;
+
+  while (bytes_ > max_bytes_) {
+    const std::pair<std::string, uint64_t>& oldest = files_.back();
+    ::unlink((directory_ + "/" + oldest.first).c_str());
+    bytes_ -= oldest.second;
+    index_.erase(oldest.first);
+    files_.pop_back();
+  }
+}
+
+uint64_t DiskHttpCache::bytes() {
+  std::lock_guard<std::mutex> guard(lock_);
+  return bytes_;
+}
+
+} // namespace Cache
+} // namespace Filter
+} // namespace Http
+} // namespace Envoy
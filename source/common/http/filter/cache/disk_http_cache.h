@@ -0,0 +1,121 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common/http/filter/cache/http_cache.h"
+#include "common/http/header_map_impl.h"
+
+namespace Envoy {
+namespace Http {
+namespace Filter {
+namespace Cache {
+
+/**
+ * A read only memory mapping of a whole file, unmapped on destruction.
+ */
+class MappedFile {
+public:
+  MappedFile(const void* data, uint64_t size) : data_(data), size_(size) {}
+  ~MappedFile();
+
+  const uint8_t* data() const { return static_cast<const uint8_t*>(data_); }
+  uint64_t size() const { return size_; }
+
+private:
+  const void* data_;
+  const uint64_t size_;
+};
+
+typedef std::shared_ptr<const MappedFile> MappedFileConstSharedPtr;
+
+/**
+ * A cached response whose body is served from a memory mapping of its cache file.
+ */
+class DiskCachedResponse : public CachedResponse {
+public:
+  DiskCachedResponse(MappedFileConstSharedPtr file, const HeaderMap& headers,
+                     SystemTime response_time, std::chrono::seconds max_age,
+                     const uint8_t* body, uint64_t body_size);
+
+  // Cache::CachedResponse
+  const HeaderMap& headers() const override { return headers_; }
+  const std::vector<std::string>& varyHeaders() const override { return vary_; }
+  SystemTime responseTime() const override { return response_time_; }
+  std::chrono::seconds maxAge() const override { return max_age_; }
+  uint64_t bodySize() const override { return body_size_; }
+  void addBodyTo(Buffer::Instance& buffer) const override;
+
+private:
+  MappedFileConstSharedPtr file_;
+  const HeaderMapImpl headers_;
+  const std::vector<std::string> vary_;
+  const SystemTime response_time_;
+  const std::chrono::seconds max_age_;
+  const uint8_t* body_;
+  const uint64_t body_size_;
+};
+
+/**
+ * Cache that keeps each response in its own file in a directory, and serves bodies straight from
+ * a read only memory mapping of the file, so that a hit neither reads nor copies the body. Files
+ * are written to a temporary name and renamed into place, so a lookup never sees a partial file,
+ * and a file that is evicted while it is mapped stays readable until it is unmapped. Once the
+ * files add up to more than max_bytes the least recently used ones are removed.
+ *
+ * Each cache keeps its files in a subdirectory of its own, created on construction and removed
+ * along with its files on destruction, so caches that share a directory (those of different
+ * filter chains, or of a listener and the listener replacing it) never touch each other's files.
+ * Files are read and written on the calling worker, so the directory should be on fast local
+ * storage.
+ */
+class DiskHttpCache : public HttpCache {
+public:
+  DiskHttpCache(const std::string& directory, uint64_t max_bytes);
+  ~DiskHttpCache();
+
+  // Cache::HttpCache
+  CachedResponseConstSharedPtr lookup(const std::string& key) override;
+  void insert(const std::string& key, const HeaderMap& headers, const Buffer::Instance& body,
+              SystemTime response_time, std::chrono::seconds max_age) override;
+
+  /**
+   * @return uint64_t the total size of the cache files.
+   */
+  uint64_t bytes();
+
+  /**
+   * @return const std::string& the subdirectory that holds the files of this cache.
+   */
+  const std::string& directory() const { return directory_; }
+
+  static const std::string FILE_PREFIX;
+
+private:
+  static std::string createDirectory(const std::string& parent);
+  std::string fileName(const std::string& key) const;
+  // Account for a file that was just written, and evict files to stay within max_bytes_.
+  void addFile(const std::string& file_name, uint64_t size);
+
+  const std::string directory_;
+  const uint64_t max_bytes_;
+  std::atomic<uint64_t> next_temp_file_id_{};
+
+  std::mutex lock_;
+  // File names and sizes, most recently used first.
+  std::list<std::pair<std::string, uint64_t>> files_;
+  std::unordered_map<std::string, std::list<std::pair<std::string, uint64_t>>::iterator> index_;
+  uint64_t bytes_{};
+};
+
+} // namespace Cache
+} // namespace Filter
+} // namespace Http
+} // namespace Envoy
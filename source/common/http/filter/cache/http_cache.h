@@ -0,0 +1,99 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "envoy/buffer/buffer.h"
+#include "envoy/common/pure.h"
+#include "envoy/common/time.h"
+#include "envoy/http/header_map.h"
+
+namespace Envoy {
+namespace Http {
+namespace Filter {
+namespace Cache {
+
+/**
+ * A response held by an HttpCache. Cached responses are immutable and may be shared by any number
+ * of streams on any thread.
+ */
+class CachedResponse {
+public:
+  virtual ~CachedResponse() {}
+
+  /**
+   * @return const HeaderMap& the response headers as received from upstream. The map is shared by
+   *         every stream the response is served to, so callers copy it rather than looking up
+   *         headers in it; anything needed per lookup is parsed when the response is stored.
+   */
+  virtual const HeaderMap& headers() const PURE;
+
+  /**
+   * @return const std::vector<std::string>& the lower case header names listed by the Vary
+   *         header, parsed when the response was stored.
+   */
+  virtual const std::vector<std::string>& varyHeaders() const PURE;
+
+  /**
+   * @return SystemTime the time at which the response was generated by the origin, i.e. the time
+   *         it was received less any age it already had.
+   */
+  virtual SystemTime responseTime() const PURE;
+
+  /**
+   * @return std::chrono::seconds how long after responseTime() the response stays fresh.
+   */
+  virtual std::chrono::seconds maxAge() const PURE;
+
+  /**
+   * @return uint64_t the size of the body.
+   */
+  virtual uint64_t bodySize() const PURE;
+
+  /**
+   * Append the body to a buffer. Implementations reference the cached memory instead of copying it
+   * where the buffer supports that, and keep it alive for as long as the buffer refers to it.
+   * @param buffer supplies the buffer to append to.
+   */
+  virtual void addBodyTo(Buffer::Instance& buffer) const PURE;
+};
+
+typedef std::shared_ptr<const CachedResponse> CachedResponseConstSharedPtr;
+
+/**
+ * Storage for cached responses. Implementations are shared by all workers and must be thread safe.
+ * Freshness is up to the caller: storage returns whatever it has for a key, and may drop entries
+ * at any time to stay within its size limits.
+ */
+class HttpCache {
+public:
+  virtual ~HttpCache() {}
+
+  /**
+   * @param key supplies the cache key.
+   * @return CachedResponseConstSharedPtr the response stored for the key, or nullptr.
+   */
+  virtual CachedResponseConstSharedPtr lookup(const std::string& key) PURE;
+
+  /**
+   * Store a response, replacing any response stored for the same key.
+   * @param key supplies the cache key.
+   * @param headers supplies the response headers.
+   * @param body supplies the response body.
+   * @param response_time supplies the time at which the response was generated.
+   * @param max_age supplies how long after response_time the response stays fresh.
+   */
+  virtual void insert(const std::string& key, const HeaderMap& headers,
+                      const Buffer::Instance& body, SystemTime response_time,
+                      std::chrono::seconds max_age) PURE;
+};
+
+typedef std::shared_ptr<HttpCache> HttpCacheSharedPtr;
+
+} // namespace Cache
+} // namespace Filter
+} // namespace Http
+} // namespace Envoy
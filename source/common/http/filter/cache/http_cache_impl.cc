@@ -0,0 +1,153 @@
+#include "common/http/filter/cache/http_cache_impl.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/common/utility.h"
+#include "common/http/headers.h"
+
+#include "event2/buffer.h"
+
+namespace Envoy {
+namespace Http {
+namespace Filter {
+namespace Cache {
+
+namespace {
+
+std::string trimAndLower(const std::string& source) {
+  const size_t start = source.find_first_not_of(" \t");
+  if (start == std::string::npos) {
+    return "";
+  }
+  const size_t end = source.find_last_not_of(" \t");
+  std::string result = source.substr(start, end - start + 1);
+  std::transform(result.begin(), result.end(), result.begin(), ::tolower);
+  return result;
+}
+
+Optional<std::chrono::seconds> parseSeconds(const std::string& value) {
+  uint64_t seconds;
+  if (!StringUtil::atoul(value.c_str(), seconds)) {
+    return Optional<std::chrono::seconds>();
+  }
+  return Optional<std::chrono::seconds>(std::chrono::seconds(seconds));
+}
+
+} // namespace
+
+CacheControl CacheUtility::parseCacheControl(const HeaderMap& headers) {
+  CacheControl cache_control;
+  const HeaderEntry* header = headers.get(Headers::get().CacheControl);
+  if (header == nullptr) {
+    return cache_control;
+  }
+
+  for (const std::string& token : StringUtil::split(header->value().c_str(), ',')) {
+    const std::string directive = trimAndLower(token);
+    const size_t equals = directive.find('=');
+    const std::string name = directive.substr(0, equals);
+    const std::string value =
+        equals == std::string::npos ? "" : trimAndLower(directive.substr(equals + 1));
+
+    if (name == "no-cache") {
+      cache_control.no_cache_ = true;
+    } else if (name == "no-store") {
+      cache_control.no_store_ = true;
+    } else if (name == "private") {
+      cache_control.private_ = true;
+    } else if (name == "max-age") {
+      cache_control.max_age_ = parseSeconds(value);
+    } else if (name == "s-maxage") {
+      cache_control.s_maxage_ = parseSeconds(value);
+    }
+  }
+
+  return cache_control;
+}
+
+std::vector<std::string> CacheUtility::varyHeaders(const HeaderMap& headers) {
+  std::vector<std::string> names;
+  const HeaderEntry* header = headers.get(Headers::get().Vary);
+  if (header == nullptr) {
+    return names;
+  }
+
+  for (const std::string& token : StringUtil::split(header->value().c_str(), ',')) {
+    const std::string name = trimAndLower(token);
+    if (!name.empty()) {
+      names.push_back(name);
+    }
+  }
+  return names;
+}
+
+void CacheUtility::addBufferReference(Buffer::Instance& buffer, const void* data, uint64_t size,
+                                      std::shared_ptr<const void> owner) {
+  Buffer::LibEventInstance* libevent_buffer = dynamic_cast<Buffer::LibEventInstance*>(&buffer);
+  if (libevent_buffer == nullptr || size == 0) {
+    buffer.add(data, size);
+    return;
+  }
+
+  // The evbuffer calls the cleanup function once it no longer refers to the memory, which may be
+  // after the data has been moved on to other evbuffers.
+  std::shared_ptr<const void>* reference = new std::shared_ptr<const void>(std::move(owner));
+  evbuffer_add_reference(
+      libevent_buffer->buffer().get(), data, size,
+      [](const void*, size_t, void* arg) -> void {
+        delete static_cast<std::shared_ptr<const void>*>(arg);
+      },
+      reference);
+  libevent_buffer->postProcess();
+}
+
+InMemoryCachedResponse::InMemoryCachedResponse(const HeaderMap& headers,
+                                               const Buffer::Instance& body,
+                                               SystemTime response_time,
+                                               std::chrono::seconds max_age)
+    : headers_(headers), vary_(CacheUtility::varyHeaders(headers)), response_time_(response_time),
+      max_age_(max_age) {
+  std::string* body_copy = new std::string(body.length(), '\0');
+  body.copyOut(0, body.length(), &(*body_copy)[0]);
+  body_.reset(body_copy);
+}
+
+void InMemoryCachedResponse::addBodyTo(Buffer::Instance& buffer) const {
+  CacheUtility::addBufferReference(buffer, body_->data(), body_->size(), body_);
+}
+
+CachedResponseConstSharedPtr TieredHttpCache::lookup(const std::string& key) {
+  CachedResponseConstSharedPtr response = first_->lookup(key);
+  if (response != nullptr) {
+    return response;
+  }
+
+  response = second_->lookup(key);
+  if (response != nullptr) {
+    // Promote the response so that the next lookup is served from the first tier. The headers of
+    // a cached response are shared, so they are copied before the first tier parses them.
+    const HeaderMapImpl headers(response->headers());
+    Buffer::OwnedImpl body;
+    response->addBodyTo(body);
+    first_->insert(key, headers, body, response->responseTime(), response->maxAge());
+  }
+  return response;
+}
+
+void TieredHttpCache::insert(const std::string& key, const HeaderMap& headers,
+                             const Buffer::Instance& body, SystemTime response_time,
+                             std::chrono::seconds max_age) {
+  first_->insert(key, headers, body, response_time, max_age);
+  second_->insert(key, headers, body, response_time, max_age);
+}
+
+} // namespace Cache
+} // namespace Filter
+} // namespace Http
+} // namespace Envoy
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "envoy/buffer/buffer.h"
+#include "envoy/common/optional.h"
+#include "envoy/http/header_map.h"
+
+#include "common/http/filter/cache/http_cache.h"
+#include "common/http/header_map_impl.h"
+
+namespace Envoy {
+namespace Http {
+namespace Filter {
+namespace Cache {
+
+/**
+ * The Cache-Control directives that the cache filter acts on.
+ */
+struct CacheControl {
+  bool no_cache_{};
+  bool no_store_{};
+  bool private_{};
+  Optional<std::chrono::seconds> max_age_;
+  Optional<std::chrono::seconds> s_maxage_;
+};
+
+class CacheUtility {
+public:
+  /**
+   * @param headers supplies the request or response headers.
+   * @return CacheControl the directives of the Cache-Control header. Unknown directives are
+   *         ignored.
+   */
+  static CacheControl parseCacheControl(const HeaderMap& headers);
+
+  /**
+   * @param headers supplies the response headers.
+   * @return std::vector<std::string> the lower case header names listed by the Vary header.
+   */
+  static std::vector<std::string> varyHeaders(const HeaderMap& headers);
+
+  /**
+   * Append memory to a buffer without copying it when the buffer is backed by an evbuffer, and by
+   * copying it otherwise.
+   * @param buffer supplies the buffer to append to.
+   * @param data supplies the memory to append.
+   * @param size supplies the size of the memory.
+   * @param owner supplies an object which keeps the memory alive. The buffer holds on to it for as
+   *        long as it refers to the memory.
+   */
+  static void addBufferReference(Buffer::Instance& buffer, const void* data, uint64_t size,
+                                 std::shared_ptr<const void> owner);
+};
+
+/**
+ * A cached response that keeps its headers and body in memory.
+ */
+class InMemoryCachedResponse : public CachedResponse {
+public:
+  InMemoryCachedResponse(const HeaderMap& headers, const Buffer::Instance& body,
+                         SystemTime response_time, std::chrono::seconds max_age);
+
+  // Cache::CachedResponse
+  const HeaderMap& headers() const override { return headers_; }
+  const std::vector<std::string>& varyHeaders() const override { return vary_; }
+  SystemTime responseTime() const override { return response_time_; }
+  std::chrono::seconds maxAge() const override { return max_age_; }
+  uint64_t bodySize() const override { return body_->size(); }
+  void addBodyTo(Buffer::Instance& buffer) const override;
+
+private:
+  const HeaderMapImpl headers_;
+  const std::vector<std::string> vary_;
+  std::shared_ptr<const std::string> body_;
+  const SystemTime response_time_;
+  const std::chrono::seconds max_age_;
+};
+
+/**
+ * A cache that stores every response in two tiers and looks up the first tier before the second,
+ * e.g. a small in memory cache in front of a larger disk cache.
+ */
+class TieredHttpCache : public HttpCache {
+public:
+  TieredHttpCache(HttpCacheSharedPtr first, HttpCacheSharedPtr second)
+      : first_(first), second_(second) {}
+
+  // Cache::HttpCache
+  CachedResponseConstSharedPtr lookup(const std::string& key) override;
+  void insert(const std::string& key, const HeaderMap& headers, const Buffer::Instance& body,
+              SystemTime response_time, std::chrono::seconds max_age) override;
+
+private:
+  HttpCacheSharedPtr first_;
+  HttpCacheSharedPtr second_;
+};
+
+} // namespace Cache
+} // namespace Filter
+} // namespace Http
+} // namespace Envoy
@@ -0,0 +1,67 @@
+#include "common/http/filter/cache/lru_http_cache.h"
+
+#include <chrono>
+#include <cstdint>
+#include <iterator>
+#include <string>
+
+#include "common/http/filter/cache/http_cache_impl.h"
+
+namespace Envoy {
+namespace Http {
+namespace Filter {
+namespace Cache {
+
+CachedResponseConstSharedPtr LruHttpCache::lookup(const std::string& key) {
+  std::lock_guard<std::mutex> guard(lock_);
+  auto it = index_.find(key);
+  if (it == index_.end()) {
+    return nullptr;
+  }
+
+  entries_.splice(entries_.begin(), entries_, it->second);
+  return it->second->response_;
+}
+
+void LruHttpCache::insert(const std::string& key, const HeaderMap& headers,
+                          const Buffer::Instance& body, SystemTime response_time,
+                          std::chrono::seconds max_age) {
+  const uint64_t size = key.size() + headers.byteSize() + body.length();
+  if (size > max_bytes_) {
+    return;
+  }
+
+  // Copy the response before taking the lock.
+  CachedResponseConstSharedPtr response =
+      std::make_shared<InMemoryCachedResponse>(headers, body, response_time, max_age);
+
+  std::lock_guard<std::mutex> guard(lock_);
+  auto existing = index_.find(key);
+  if (existing != index_.end()) {
+    remove(existing->second);
+  }
+
+  entries_.push_front({key, response, size});
+  index_[key] = entries_.begin();
+  bytes_ += size;
+
+  while (bytes_ > max_bytes_) {
+    remove(std::prev(entries_.end()));
+  }
+}
+
+uint64_t LruHttpCache::bytes() {
+  std::lock_guard<std::mutex> guard(lock_);
+  return bytes_;
+}
+
+void LruHttpCache::remove(std::list<Entry>::iterator entry) {
+  bytes_ -= entry->size_;
+  index_.erase(entry->key_);
+  entries_.erase(entry);
+}
+
+} // namespace Cache
+} // namespace Filter
+} // namespace Http
+} // namespace Envoy
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "common/http/filter/cache/http_cache.h"
+
+namespace Envoy {
+namespace Http {
+namespace Filter {
+namespace Cache {
+
+/**
+ * In memory cache shared by all workers, which evicts the least recently used responses once the
+ * responses it holds add up to more than max_bytes. Lookups hand out the cached response itself,
+ * so an evicted response stays alive until the last stream serving it is done with it.
+ */
+class LruHttpCache : public HttpCache {
+public:
+  LruHttpCache(uint64_t max_bytes) : max_bytes_(max_bytes) {}
+
+  // Cache::HttpCache
+  CachedResponseConstSharedPtr lookup(const std::string& key) override;
+  void insert(const std::string& key, const HeaderMap& headers, const Buffer::Instance& body,
+              SystemTime response_time, std::chrono::seconds max_age) override;
+
+  /**
+   * @return uint64_t the number of bytes accounted to the cached responses.
+   */
+  uint64_t bytes();
+
+private:
+  struct Entry {
+    std::string key_;
+    CachedResponseConstSharedPtr response_;
+    uint64_t size_;
+  };
+
+  // Remove an entry. Must be called with lock_ held.
+  void remove(std::list<Entry>::iterator entry);
+
+  const uint64_t max_bytes_;
+  std::mutex lock_;
+  // Most recently used first.
+  std::list<Entry> entries_;
+  std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+  uint64_t bytes_{};
+};
+
+} // namespace Cache
+} // namespace Filter
+} // namespace Http
+} // namespace Envoy
@@ -101,21 +101,14 @@ void CorsFilter::setDecoderFilterCallbacks(StreamDecoderFilterCallbacks& callbac
 };
 
 bool CorsFilter::isOriginAllowed(const Http::HeaderString& origin) {
-  if (allowOrigins() == nullptr) {
-    return false;
-  }
-  for (const auto& o : *allowOrigins()) {
-    if (o == "*" || origin == o.c_str()) {
-      return true;
-    }
-  }
-  return false;
+  const Envoy::Router::CorsPolicy* policy = originPolicy();
+  return policy != nullptr && policy->originAllowed(std::string(origin.c_str(), origin.size()));
 }
 
-const std::list<std::string>* CorsFilter::allowOrigins() {
+const Envoy::Router::CorsPolicy* CorsFilter::originPolicy() {
   for (const auto policy : policies_) {
     if (policy && !policy->allowOrigins().empty()) {
-      return &policy->allowOrigins();
+      return policy;
     }
   }
   return nullptr;
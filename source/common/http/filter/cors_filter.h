@@ -39,7 +39,7 @@ public:
 private:
   friend class CorsFilterTest;
 
-  const std::list<std::string>* allowOrigins();
+  const Envoy::Router::CorsPolicy* originPolicy();
   const std::string& allowMethods();
   const std::string& allowHeaders();
   const std::string& exposeHeaders();
@@ -24,10 +24,10 @@
 namespace Envoy {
 namespace Http {
 
-const std::string FaultFilter::DELAY_PERCENT_KEY = "fault.http.delay.fixed_delay_percent";
-const std::string FaultFilter::ABORT_PERCENT_KEY = "fault.http.abort.abort_percent";
-const std::string FaultFilter::DELAY_DURATION_KEY = "fault.http.delay.fixed_duration_ms";
-const std::string FaultFilter::ABORT_HTTP_STATUS_KEY = "fault.http.abort.http_status";
+const Runtime::Key FaultFilter::DELAY_PERCENT_KEY("fault.http.delay.fixed_delay_percent");
+const Runtime::Key FaultFilter::ABORT_PERCENT_KEY("fault.http.abort.abort_percent");
+const Runtime::Key FaultFilter::DELAY_DURATION_KEY("fault.http.delay.fixed_duration_ms");
+const Runtime::Key FaultFilter::ABORT_HTTP_STATUS_KEY("fault.http.abort.http_status");
 
 FaultFilterConfig::FaultFilterConfig(const envoy::api::v2::filter::http::HTTPFault& fault,
                                      Runtime::Loader& runtime, const std::string& stats_prefix,
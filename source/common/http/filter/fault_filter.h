@@ -117,10 +117,10 @@ private:
   std::string downstream_cluster_delay_duration_key_{};
   std::string downstream_cluster_abort_http_status_key_{};
 
-  const static std::string DELAY_PERCENT_KEY;
-  const static std::string ABORT_PERCENT_KEY;
-  const static std::string DELAY_DURATION_KEY;
-  const static std::string ABORT_HTTP_STATUS_KEY;
+  const static Runtime::Key DELAY_PERCENT_KEY;
+  const static Runtime::Key ABORT_PERCENT_KEY;
+  const static Runtime::Key DELAY_DURATION_KEY;
+  const static Runtime::Key ABORT_HTTP_STATUS_KEY;
 };
 
 } // Http
@@ -0,0 +1,398 @@
+#include "common/http/filter/gzip_filter.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "envoy/common/exception.h"
+#include "envoy/stats/stats.h"
+
+#include "common/buffer/buffer_impl.h"
+#include "common/common/assert.h"
+#include "common/common/enum_to_int.h"
+#include "common/common/macros.h"
+#include "common/common/utility.h"
+#include "common/compressor/brotli_compressor_impl.h"
+#include "common/compressor/zstd_compressor_impl.h"
+#include "common/filesystem/filesystem_impl.h"
+#include "common/http/headers.h"
+#include "common/json/config_schemas.h"
+
+namespace Envoy {
+namespace Http {
+
+namespace {
+
+// Strip whitespace and parameters, e.g. "text/html; charset=UTF-8" becomes "text/html", and lower
+// case what is left.
+std::string normalizeToken(const std::string& value) {
+  std::string token = value.substr(0, value.find(';'));
+  token.erase(0, token.find_first_not_of(" \t"));
+  StringUtil::rtrim(token);
+  std::transform(token.begin(), token.end(), token.begin(), ::tolower);
+  return token;
+}
+
+// The q value of an Accept-Encoding entry, 1 if it has none. A q value of 0 refuses an encoding.
+double quality(const std::string& value) {
+  for (const std::string& param : StringUtil::split(value, ';')) {
+    std::string name_value = param;
+    name_value.erase(std::remove_if(name_value.begin(), name_value.end(), ::isspace),
+                     name_value.end());
+    if (StringUtil::startsWith(name_value.c_str(), "q=", false)) {
+      return std::strtod(name_value.c_str() + 2, nullptr);
+    }
+  }
+  return 1;
+}
+
+// Whether a Vary header value already covers a request header.
+bool varies(const std::string& vary, const std::string& header) {
+  for (const std::string& name : StringUtil::split(vary, ',')) {
+    const std::string normalized = normalizeToken(name);
+    if (normalized == header || normalized == "*") {
+      return true;
+    }
+  }
+  return false;
+}
+
+const std::vector<std::string>& defaultContentTypes() {
+  CONSTRUCT_ON_FIRST_USE(std::vector<std::string>, {"application/javascript", "application/json",
+                                                    "application/xhtml+xml", "image/svg+xml",
+                                                    "text/css", "text/html", "text/plain",
+                                                    "text/xml"});
+}
+
+Compressor::ZlibCompressorImpl::CompressionLevel compressionLevel(const std::string& level) {
+  if (level == "best") {
+    return Compressor::ZlibCompressorImpl::CompressionLevel::Best;
+  } else if (level == "speed") {
+    return Compressor::ZlibCompressorImpl::CompressionLevel::Speed;
+  }
+  return Compressor::ZlibCompressorImpl::CompressionLevel::Standard;
+}
+
+Compressor::ZlibCompressorImpl::CompressionStrategy
+compressionStrategy(const std::string& strategy) {
+  if (strategy == "filtered") {
+    return Compressor::ZlibCompressorImpl::CompressionStrategy::Filtered;
+  } else if (strategy == "huffman") {
+    return Compressor::ZlibCompressorImpl::CompressionStrategy::Huffman;
+  } else if (strategy == "rle") {
+    return Compressor::ZlibCompressorImpl::CompressionStrategy::Rle;
+  }
+  return Compressor::ZlibCompressorImpl::CompressionStrategy::Standard;
+}
+
+GzipFilterConfig::Encoding parseEncoding(const std::string& name) {
+  if (name == Headers::get().ContentEncodingValues.Brotli) {
+    return GzipFilterConfig::Encoding::Brotli;
+  } else if (name == Headers::get().ContentEncodingValues.Zstd) {
+    return GzipFilterConfig::Encoding::Zstd;
+  }
+  ASSERT(name == Headers::get().ContentEncodingValues.Gzip);
+  return GzipFilterConfig::Encoding::Gzip;
+}
+
+} // namespace
+
+GzipFilterConfig::GzipFilterConfig(const Json::Object& json_config, const std::string& stats_prefix,
+                                   Stats::Scope& scope, ThreadLocal::SlotAllocator& tls)
+    : stats_(generateStats(stats_prefix, scope)), tls_(tls.allocateSlot()) {
+  json_config.validateSchema(Json::Schema::GZIP_HTTP_FILTER_SCHEMA);
+
+  compression_level_ = compressionLevel(json_config.getString("compression_level", "default"));
+  compression_strategy_ =
+      compressionStrategy(json_config.getString("compression_strategy", "default"));
+  window_bits_ = json_config.getInteger("window_bits", 15);
+  memory_level_ = json_config.getInteger("memory_level", 8);
+  minimum_length_ = json_config.getInteger("content_length", 30);
+  content_types_ = json_config.getStringArray("content_type", true);
+  if (content_types_.empty()) {
+    content_types_ = defaultContentTypes();
+  }
+  brotli_quality_ = json_config.getInteger("brotli_quality", 5);
+  brotli_window_bits_ = json_config.getInteger("brotli_window_bits", 18);
+  zstd_level_ = json_config.getInteger("zstd_level", 3);
+  for (const std::string& name : json_config.getStringArray("encodings", true)) {
+    encodings_.push_back(parseEncoding(name));
+  }
+  if (encodings_.empty()) {
+    encodings_.push_back(Encoding::Gzip);
+  }
+
+  if (json_config.hasObject("dictionary")) {
+    Json::ObjectSharedPtr dictionary_config = json_config.getObject("dictionary");
+    dictionary_encoding_ = normalizeToken(dictionary_config->getString("encoding"));
+    if (dictionary_encoding_.empty() || dictionary_encoding_ == "*" ||
+        dictionary_encoding_ == Headers::get().ContentEncodingValues.Brotli ||
+        dictionary_encoding_ == Headers::get().ContentEncodingValues.Gzip ||
+        dictionary_encoding_ == Headers::get().ContentEncodingValues.Zstd) {
+      throw EnvoyException(
+          fmt::format("gzip filter: invalid dictionary encoding '{}'", dictionary_encoding_));
+    }
+    dictionary_ = Filesystem::fileReadToEnd(dictionary_config->getString("filename"));
+    if (dictionary_.empty()) {
+      throw EnvoyException("gzip filter: empty dictionary");
+    }
+    // A client only lists the token if it has the dictionary, so it wins over general purpose
+    // encodings of the same weight.
+    encodings_.insert(encodings_.begin(), Encoding::Dictionary);
+  }
+
+  tls_->set([](Event::Dispatcher&) -> ThreadLocal::ThreadLocalObjectSharedPtr {
+    return std::make_shared<CompressorPool>();
+  });
+}
+
+GzipStats GzipFilterConfig::generateStats(const std::string& prefix, Stats::Scope& scope) {
+  std::string final_prefix = prefix + "gzip.";
+  return {ALL_GZIP_STATS(POOL_COUNTER_PREFIX(scope, final_prefix))};
+}
+
+const std::string& GzipFilterConfig::encodingName(Encoding encoding) const {
+  switch (encoding) {
+  case Encoding::Brotli:
+    return Headers::get().ContentEncodingValues.Brotli;
+  case Encoding::Zstd:
+    return Headers::get().ContentEncodingValues.Zstd;
+  case Encoding::Gzip:
+    return Headers::get().ContentEncodingValues.Gzip;
+  case Encoding::Dictionary:
+    return dictionary_encoding_;
+  }
+
+  NOT_REACHED;
+}
+
+Compressor::CompressorPtr GzipFilterConfig::acquireCompressor(Encoding encoding) {
+  std::vector<Compressor::CompressorPtr>& pool =
+      tls_->getTyped<CompressorPool>().compressors_[enumToInt(encoding)];
+  if (!pool.empty()) {
+    Compressor::CompressorPtr compressor = std::move(pool.back());
+    pool.pop_back();
+    return compressor;
+  }
+
+  switch (encoding) {
+  case Encoding::Brotli: {
+    std::unique_ptr<Compressor::BrotliCompressorImpl> compressor(
+        new Compressor::BrotliCompressorImpl());
+    compressor->init(brotli_quality_, brotli_window_bits_);
+    return std::move(compressor);
+  }
+  case Encoding::Zstd: {
+    std::unique_ptr<Compressor::ZstdCompressorImpl> compressor(
+        new Compressor::ZstdCompressorImpl());
+    compressor->init(zstd_level_);
+    return std::move(compressor);
+  }
+  case Encoding::Gzip: {
+    std::unique_ptr<Compressor::ZlibCompressorImpl> compressor(
+        new Compressor::ZlibCompressorImpl());
+    // Adding 16 to the window bits makes zlib write a gzip header and trailer.
+    compressor->init(compression_level_, compression_strategy_, window_bits_ | 16, memory_level_);
+    return std::move(compressor);
+  }
+  case Encoding::Dictionary: {
+    // gzip has no way to name a dictionary, so these are zlib streams. The zlib header records the
+    // dictionary's checksum.
+    std::unique_ptr<Compressor::ZlibCompressorImpl> compressor(
+        new Compressor::ZlibCompressorImpl());
+    compressor->init(compression_level_, compression_strategy_, window_bits_, memory_level_,
+                     dictionary_);
+    return std::move(compressor);
+  }
+  }
+
+  NOT_REACHED;
+}
+
+void GzipFilterConfig::releaseCompressor(Encoding encoding, Compressor::CompressorPtr compressor) {
+  std::vector<Compressor::CompressorPtr>& pool =
+      tls_->getTyped<CompressorPool>().compressors_[enumToInt(encoding)];
+  if (pool.size() < MAX_POOLED_COMPRESSORS) {
+    compressor->reset();
+    pool.push_back(std::move(compressor));
+  }
+}
+
+bool GzipFilterConfig::isContentTypeAllowed(const HeaderMap& headers) const {
+  if (headers.ContentType() == nullptr) {
+    return false;
+  }
+
+  const std::string content_type = normalizeToken(headers.ContentType()->value().c_str());
+  return std::find(content_types_.begin(), content_types_.end(), content_type) !=
+         content_types_.end();
+}
+
+Optional<GzipFilterConfig::Encoding>
+GzipFilterConfig::chooseEncoding(const std::string& accept_encoding) const {
+  // An explicit entry wins over the wildcard, which covers every coding not listed.
+  std::unordered_map<std::string, double> qualities;
+  double wildcard_quality = 0;
+  for (const std::string& coding : StringUtil::split(accept_encoding, ',')) {
+    const std::string name = normalizeToken(coding);
+    if (name == "*") {
+      wildcard_quality = quality(coding);
+    } else {
+      qualities[name] = quality(coding);
+    }
+  }
+
+  Optional<Encoding> chosen;
+  double chosen_quality = 0;
+  for (Encoding encoding : encodings_) {
+    auto it = qualities.find(encodingName(encoding));
+    // The wildcard does not cover the dictionary, as the client has to have it.
+    const double encoding_quality =
+        it != qualities.end() ? it->second
+                              : (encoding == Encoding::Dictionary ? 0 : wildcard_quality);
+    if (encoding_quality > chosen_quality) {
+      chosen.value(encoding);
+      chosen_quality = encoding_quality;
+    }
+  }
+  return chosen;
+}
+
+FilterHeadersStatus GzipFilter::decodeHeaders(HeaderMap& headers, bool) {
+  const HeaderEntry* accept_encoding = headers.get(Headers::get().AcceptEncoding);
+  if (accept_encoding == nullptr) {
+    config_->stats().no_accept_header_.inc();
+    return FilterHeadersStatus::Continue;
+  }
+
+  encoding_ = config_->chooseEncoding(accept_encoding->value().c_str());
+  return FilterHeadersStatus::Continue;
+}
+
+bool GzipFilter::isCompressible(const HeaderMap& headers) const {
+  if (headers.get(Headers::get().ContentEncoding) != nullptr ||
+      !config_->isContentTypeAllowed(headers)) {
+    return false;
+  }
+
+  const HeaderEntry* cache_control = headers.get(Headers::get().CacheControl);
+  if (cache_control != nullptr) {
+    for (const std::string& directive : StringUtil::split(cache_control->value().c_str(), ',')) {
+      if (normalizeToken(directive) == "no-transform") {
+        return false;
+      }
+    }
+  }
+
+  uint64_t content_length;
+  if (headers.ContentLength() != nullptr &&
+      StringUtil::atoul(headers.ContentLength()->value().c_str(), content_length) &&
+      content_length < config_->minimumLength()) {
+    return false;
+  }
+  return true;
+}
+
+FilterHeadersStatus GzipFilter::encodeHeaders(HeaderMap& headers, bool end_stream) {
+  if (!encoding_.valid() || end_stream) {
+    return FilterHeadersStatus::Continue;
+  }
+
+  if (!isCompressible(headers)) {
+    config_->stats().not_compressed_.inc();
+    return FilterHeadersStatus::Continue;
+  }
+
+  countEncoding();
+  compressor_ = config_->acquireCompressor(encoding_.value());
+  headers.removeContentLength();
+  headers.addReferenceKey(Headers::get().ContentEncoding,
+                          config_->encodingName(encoding_.value()));
+
+  // Caches must keep the compressed and uncompressed responses apart.
+  const HeaderEntry* vary = headers.get(Headers::get().Vary);
+  if (vary == nullptr) {
+    headers.addReferenceKey(Headers::get().Vary, Headers::get().AcceptEncoding.get());
+  } else if (!varies(vary->value().c_str(), Headers::get().AcceptEncoding.get())) {
+    const std::string value =
+        fmt::format("{}, {}", vary->value().c_str(), Headers::get().AcceptEncoding.get());
+    headers.remove(Headers::get().Vary);
+    headers.addCopy(Headers::get().Vary, value);
+  }
+
+  // The compressed body is not byte for byte the same as the original, so a strong validator no
+  // longer applies to it.
+  const HeaderEntry* etag = headers.get(Headers::get().Etag);
+  if (etag != nullptr && !StringUtil::startsWith(etag->value().c_str(), "W/")) {
+    const std::string value = fmt::format("W/{}", etag->value().c_str());
+    headers.remove(Headers::get().Etag);
+    headers.addCopy(Headers::get().Etag, value);
+  }
+
+  return FilterHeadersStatus::Continue;
+}
+
+FilterDataStatus GzipFilter::encodeData(Buffer::Instance& data, bool end_stream) {
+  if (!compressor_) {
+    return FilterDataStatus::Continue;
+  }
+
+  config_->stats().total_uncompressed_bytes_.add(data.length());
+  Buffer::OwnedImpl output;
+  compressor_->compress(data, output);
+  data.drain(data.length());
+  if (end_stream) {
+    finishCompression(output);
+  } else {
+    // Flush every frame, so that a streamed response reaches the client as it is produced.
+    compressor_->flush(output);
+    config_->stats().total_compressed_bytes_.add(output.length());
+  }
+  data.move(output);
+  return FilterDataStatus::Continue;
+}
+
+FilterTrailersStatus GzipFilter::encodeTrailers(HeaderMap&) {
+  if (compressor_) {
+    Buffer::OwnedImpl output;
+    finishCompression(output);
+    encoder_callbacks_->addEncodedData(output, true);
+  }
+  return FilterTrailersStatus::Continue;
+}
+
+void GzipFilter::countEncoding() {
+  config_->stats().compressed_.inc();
+  switch (encoding_.value()) {
+  case GzipFilterConfig::Encoding::Brotli:
+    config_->stats().compressed_br_.inc();
+    break;
+  case GzipFilterConfig::Encoding::Zstd:
+    config_->stats().compressed_zstd_.inc();
+    break;
+  case GzipFilterConfig::Encoding::Gzip:
+    config_->stats().compressed_gzip_.inc();
+    break;
+  case GzipFilterConfig::Encoding::Dictionary:
+    config_->stats().compressed_dictionary_.inc();
+    break;
+  }
+}
+
+void GzipFilter::finishCompression(Buffer::Instance& output) {
+  compressor_->finish(output);
+  config_->stats().total_compressed_bytes_.add(output.length());
+  config_->releaseCompressor(encoding_.value(), std::move(compressor_));
+}
+
+void GzipFilter::onDestroy() {
+  if (compressor_) {
+    config_->releaseCompressor(encoding_.value(), std::move(compressor_));
+  }
+}
+
+} // namespace Http
+} // namespace Envoy
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "envoy/common/optional.h"
+#include "envoy/compressor/compressor.h"
+#include "envoy/http/filter.h"
+#include "envoy/json/json_object.h"
+#include "envoy/stats/stats_macros.h"
+#include "envoy/thread_local/thread_local.h"
+
+#include "common/compressor/zlib_compressor_impl.h"
+
+namespace Envoy {
+namespace Http {
+
+/**
+ * All stats for the gzip filter. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_GZIP_STATS(COUNTER)                                                                    \
+  COUNTER(compressed)                                                                              \
+  COUNTER(compressed_br)                                                                           \
+  COUNTER(compressed_dictionary)                                                                   \
+  COUNTER(compressed_gzip)                                                                         \
+  COUNTER(compressed_zstd)                                                                         \
+  COUNTER(not_compressed)                                                                          \
+  COUNTER(no_accept_header)                                                                        \
+  COUNTER(total_uncompressed_bytes)                                                                \
+  COUNTER(total_compressed_bytes)
+// clang-format on
+
+/**
+ * Wrapper struct for gzip filter stats. @see stats_macros.h
+ */
+struct GzipStats {
+  ALL_GZIP_STATS(GENERATE_COUNTER_STRUCT)
+};
+
+/**
+ * Configuration for the gzip filter. Besides gzip, the filter can encode responses with Brotli or
+ * zstd, or as zlib streams with a preset dictionary for clients that know it. It keeps a pool of
+ * initialized compressors per worker and encoding, so that streams reuse the compression state of
+ * earlier streams instead of allocating their own.
+ */
+class GzipFilterConfig {
+public:
+  enum class Encoding { Brotli, Zstd, Gzip, Dictionary };
+
+  // Idle compressors kept per worker and encoding. Each holds from a few hundred KB to a few MB of
+  // compression state with the default settings.
+  static const uint64_t MAX_POOLED_COMPRESSORS = 16;
+
+  GzipFilterConfig(const Json::Object& json_config, const std::string& stats_prefix,
+                   Stats::Scope& scope, ThreadLocal::SlotAllocator& tls);
+
+  /**
+   * @return const std::string& the Content-Encoding token of an encoding.
+   */
+  const std::string& encodingName(Encoding encoding) const;
+
+  /**
+   * Pick the encoding of a response from the request's Accept-Encoding header value. Among the
+   * configured encodings that the client accepts, the one with the highest q value wins, and ties
+   * go to the one configured first. A dictionary encoding comes before all others.
+   * @param accept_encoding supplies the Accept-Encoding header value.
+   * @return Optional<Encoding> the encoding to use, if the client accepts any.
+   */
+  Optional<Encoding> chooseEncoding(const std::string& accept_encoding) const;
+
+  /**
+   * @return Compressor::CompressorPtr an initialized compressor for an encoding from the calling
+   *         worker's pool, or a new one if the pool is empty.
+   */
+  Compressor::CompressorPtr acquireCompressor(Encoding encoding);
+
+  /**
+   * Reset a compressor and return it to the calling worker's pool.
+   */
+  void releaseCompressor(Encoding encoding, Compressor::CompressorPtr compressor);
+
+  /**
+   * @return bool whether the content type of a response is one that is compressed.
+   */
+  bool isContentTypeAllowed(const HeaderMap& headers) const;
+
+  uint64_t minimumLength() const { return minimum_length_; }
+  GzipStats& stats() { return stats_; }
+
+private:
+  struct CompressorPool : public ThreadLocal::ThreadLocalObject {
+    // Indexed by Encoding.
+    std::array<std::vector<Compressor::CompressorPtr>, 4> compressors_;
+  };
+
+  static GzipStats generateStats(const std::string& prefix, Stats::Scope& scope);
+
+  Compressor::ZlibCompressorImpl::CompressionLevel compression_level_;
+  Compressor::ZlibCompressorImpl::CompressionStrategy compression_strategy_;
+  int64_t window_bits_;
+  uint64_t memory_level_;
+  uint32_t brotli_quality_;
+  uint32_t brotli_window_bits_;
+  int zstd_level_;
+  std::string dictionary_encoding_;
+  std::string dictionary_;
+  std::vector<Encoding> encodings_;
+  uint64_t minimum_length_;
+  std::vector<std::string> content_types_;
+  GzipStats stats_;
+  ThreadLocal::SlotPtr tls_;
+};
+
+typedef std::shared_ptr<GzipFilterConfig> GzipFilterConfigSharedPtr;
+
+/**
+ * A filter that compresses response bodies with the configured encoding that the client's
+ * Accept-Encoding weighs highest. Each data frame is compressed and flushed as it passes through,
+ * so bodies are never buffered and streaming responses keep flowing.
+ */
+class GzipFilter : public StreamFilter {
+public:
+  GzipFilter(GzipFilterConfigSharedPtr config) : config_(config) {}
+
+  // Http::StreamFilterBase
+  void onDestroy() override;
+
+  // Http::StreamDecoderFilter
+  FilterHeadersStatus decodeHeaders(HeaderMap& headers, bool end_stream) override;
+  FilterDataStatus decodeData(Buffer::Instance&, bool) override {
+    return FilterDataStatus::Continue;
+  }
+  FilterTrailersStatus decodeTrailers(HeaderMap&) override {
+    return FilterTrailersStatus::Continue;
+  }
+  void setDecoderFilterCallbacks(StreamDecoderFilterCallbacks&) override {}
+
+  // Http::StreamEncoderFilter
+  FilterHeadersStatus encodeHeaders(HeaderMap& headers, bool end_stream) override;
+  FilterDataStatus encodeData(Buffer::Instance& data, bool end_stream) override;
+  FilterTrailersStatus encodeTrailers(HeaderMap& trailers) override;
+  void setEncoderFilterCallbacks(StreamEncoderFilterCallbacks& callbacks) override {
+    encoder_callbacks_ = &callbacks;
+  }
+
+private:
+  bool isCompressible(const HeaderMap& headers) const;
+  void countEncoding();
+  void finishCompression(Buffer::Instance& output);
+
+  GzipFilterConfigSharedPtr config_;
+  StreamEncoderFilterCallbacks* encoder_callbacks_{};
+  Optional<GzipFilterConfig::Encoding> encoding_;
+  Compressor::CompressorPtr compressor_;
+};
+
+} // namespace Http
+} // namespace Envoy
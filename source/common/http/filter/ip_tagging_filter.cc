@@ -1,15 +1,68 @@
 #include "common/http/filter/ip_tagging_filter.h"
 
+#include "common/common/utility.h"
+#include "common/http/headers.h"
+#include "common/network/cidr_range.h"
+#include "common/network/utility.h"
+
+#include "fmt/format.h"
+
 namespace Envoy {
 namespace Http {
 
+IpTaggingFilterConfig::IpTaggingFilterConfig(const Json::Object& json_config)
+    : Json::Validator(json_config, Json::Schema::IP_TAGGING_HTTP_FILTER_SCHEMA),
+      request_type_(stringToType(json_config.getString("request_type", "both"))) {
+  std::vector<std::pair<std::string, std::vector<Network::Address::CidrRange>>> tag_data;
+  for (const Json::ObjectSharedPtr& ip_tag : json_config.getObjectArray("ip_tags", true)) {
+    std::vector<Network::Address::CidrRange> ranges;
+    for (const std::string& entry : ip_tag->getStringArray("ip_list")) {
+      Network::Address::CidrRange range = Network::Address::CidrRange::create(entry);
+      if (!range.isValid()) {
+        throw EnvoyException(
+            fmt::format("invalid ip/mask combo '{}' (format is <ip>/<# mask bits>)", entry));
+      }
+      ranges.push_back(range);
+    }
+    tag_data.emplace_back(ip_tag->getString("ip_tag_name"), std::move(ranges));
+  }
+  trie_.reset(new Network::LcTrie::LcTrie(tag_data));
+}
+
 IpTaggingFilter::IpTaggingFilter(IpTaggingFilterConfigSharedPtr config) : config_(config) {}
 
 IpTaggingFilter::~IpTaggingFilter() {}
 
 void IpTaggingFilter::onDestroy() {}
 
-FilterHeadersStatus IpTaggingFilter::decodeHeaders(HeaderMap&, bool) {
+FilterHeadersStatus IpTaggingFilter::decodeHeaders(HeaderMap& headers, bool) {
+  const bool is_internal_request =
+      headers.EnvoyInternalRequest() &&
+      (headers.EnvoyInternalRequest()->value() ==
+       Headers::get().EnvoyInternalRequestValues.True.c_str());
+
+  if ((is_internal_request && config_->requestType() == FilterRequestType::External) ||
+      (!is_internal_request && config_->requestType() == FilterRequestType::Internal)) {
+    return FilterHeadersStatus::Continue;
+  }
+
+  Network::Address::InstanceConstSharedPtr address =
+      Network::Utility::parseInternetAddressNoThrow(callbacks_->downstreamAddress());
+  if (address == nullptr) {
+    return FilterHeadersStatus::Continue;
+  }
+
+  const std::vector<std::string>& tags = config_->trie().getTags(*address);
+  if (!tags.empty()) {
+    std::string tags_value = StringUtil::join(tags, ",");
+    const HeaderEntry* existing = headers.get(Headers::get().EnvoyIpTags);
+    if (existing != nullptr) {
+      tags_value = fmt::format("{},{}", existing->value().c_str(), tags_value);
+      headers.remove(Headers::get().EnvoyIpTags);
+    }
+    headers.addCopy(Headers::get().EnvoyIpTags, tags_value);
+  }
+
   return FilterHeadersStatus::Continue;
 }
 
@@ -11,6 +11,7 @@
 #include "common/common/assert.h"
 #include "common/json/config_schemas.h"
 #include "common/json/json_validator.h"
+#include "common/network/lc_trie.h"
 
 namespace Envoy {
 namespace Http {
@@ -25,11 +26,10 @@ enum class FilterRequestType { Internal, External, Both };
  */
 class IpTaggingFilterConfig : Json::Validator {
 public:
-  IpTaggingFilterConfig(const Json::Object& json_config)
-      : Json::Validator(json_config, Json::Schema::IP_TAGGING_HTTP_FILTER_SCHEMA),
-        request_type_(stringToType(json_config.getString("request_type", "both"))) {}
+  IpTaggingFilterConfig(const Json::Object& json_config);
 
   FilterRequestType requestType() const { return request_type_; }
+  const Network::LcTrie::LcTrie& trie() const { return *trie_; }
 
 private:
   static FilterRequestType stringToType(const std::string& request_type) {
@@ -44,6 +44,7 @@ private:
   }
 
   const FilterRequestType request_type_;
+  std::unique_ptr<Network::LcTrie::LcTrie> trie_;
 };
 
 typedef std::shared_ptr<IpTaggingFilterConfig> IpTaggingFilterConfigSharedPtr;
@@ -5,6 +5,7 @@
 #include "common/buffer/buffer_impl.h"
 #include "common/common/assert.h"
 #include "common/common/enum_to_int.h"
+#include "common/common/utility.h"
 #include "common/http/message_impl.h"
 
 namespace Envoy {
@@ -154,28 +155,28 @@ HeaderMapPtr StreamHandleWrapper::buildHeadersFromTable(lua_State* state, int ta
   return headers;
 }
 
-int StreamHandleWrapper::luaHttpCall(lua_State* state) {
-  ASSERT(state_ == State::Running);
-
-  const std::string cluster = luaL_checkstring(state, 2);
-  luaL_checktype(state, 3, LUA_TTABLE);
+MessagePtr StreamHandleWrapper::buildHttpCallMessage(lua_State* state, int index,
+                                                     std::string& cluster,
+                                                     Optional<std::chrono::milliseconds>& timeout) {
+  cluster = luaL_checkstring(state, index);
+  luaL_checktype(state, index + 1, LUA_TTABLE);
   size_t body_size;
-  const char* body = luaL_optlstring(state, 4, nullptr, &body_size);
-  int timeout_ms = luaL_checkint(state, 5);
+  const char* body = luaL_optlstring(state, index + 2, nullptr, &body_size);
+  int timeout_ms = luaL_checkint(state, index + 3);
   if (timeout_ms < 0) {
-    return luaL_error(state, "http call timeout must be >= 0");
+    luaL_error(state, "http call timeout must be >= 0");
   }
 
   if (filter_.clusterManager().get(cluster) == nullptr) {
-    return luaL_error(state, "http call cluster invalid. Must be configured");
+    luaL_error(state, "http call cluster invalid. Must be configured");
   }
 
-  Http::MessagePtr message(new Http::RequestMessageImpl(buildHeadersFromTable(state, 3)));
+  Http::MessagePtr message(new Http::RequestMessageImpl(buildHeadersFromTable(state, index + 1)));
 
   // Check that we were provided certain headers.
   if (message->headers().Path() == nullptr || message->headers().Method() == nullptr ||
       message->headers().Host() == nullptr) {
-    return luaL_error(state, "http call headers must include ':path', ':method', and ':authority'");
+    luaL_error(state, "http call headers must include ':path', ':method', and ':authority'");
   }
 
   if (body != nullptr) {
@@ -183,11 +184,20 @@ int StreamHandleWrapper::luaHttpCall(lua_State* state) {
     message->headers().insertContentLength().value(body_size);
   }
 
-  Optional<std::chrono::milliseconds> timeout;
   if (timeout_ms > 0) {
     timeout.value(std::chrono::milliseconds(timeout_ms));
   }
 
+  return message;
+}
+
+int StreamHandleWrapper::luaHttpCall(lua_State* state) {
+  ASSERT(state_ == State::Running);
+
+  std::string cluster;
+  Optional<std::chrono::milliseconds> timeout;
+  MessagePtr message = buildHttpCallMessage(state, 2, cluster, timeout);
+
   http_request_ = filter_.clusterManager().httpAsyncClientForCluster(cluster).send(
       std::move(message), *this, timeout);
   if (http_request_) {
@@ -200,14 +210,69 @@ int StreamHandleWrapper::luaHttpCall(lua_State* state) {
   }
 }
 
-void StreamHandleWrapper::onSuccess(MessagePtr&& response) {
-  ASSERT(state_ == State::HttpCall || state_ == State::Running);
-  ENVOY_LOG(debug, "async HTTP response complete");
-  http_request_ = nullptr;
+int StreamHandleWrapper::luaHttpCalls(lua_State* state) {
+  ASSERT(state_ == State::Running);
+
+  luaL_checktype(state, 2, LUA_TTABLE);
+  const int num_calls = lua_objlen(state, 2);
+  const int wait_for = luaL_optint(state, 3, num_calls);
+  if (wait_for < 1 || wait_for > num_calls) {
+    return luaL_error(state, "http calls must wait for between 1 and the number of calls");
+  }
+
+  // Build all of the requests before starting any of them so that invalid parameters do not
+  // leave calls behind.
+  std::vector<std::pair<std::string, MessagePtr>> messages;
+  std::vector<Optional<std::chrono::milliseconds>> timeouts(num_calls);
+  for (int i = 0; i < num_calls; i++) {
+    lua_rawgeti(state, 2, i + 1);
+    luaL_checktype(state, -1, LUA_TTABLE);
+    const int call_index = lua_gettop(state);
+    for (int parameter = 1; parameter <= 4; parameter++) {
+      lua_rawgeti(state, call_index, parameter);
+    }
+    std::string cluster;
+    MessagePtr message = buildHttpCallMessage(state, call_index + 1, cluster, timeouts[i]);
+    messages.emplace_back(cluster, std::move(message));
+    lua_settop(state, call_index - 1);
+  }
 
+  // Calls that fail immediately complete while they are started, in which case there may be no
+  // need to start the rest.
+  batched_http_calls_needed_ = wait_for;
+  for (int i = 0; i < num_calls; i++) {
+    batched_http_calls_.emplace_back(new BatchedHttpCall(*this));
+    if (batched_http_calls_needed_ == 0) {
+      continue;
+    }
+
+    BatchedHttpCall& call = *batched_http_calls_.back();
+    call.request_ = filter_.clusterManager()
+                        .httpAsyncClientForCluster(messages[i].first)
+                        .send(std::move(messages[i].second), call, timeouts[i]);
+  }
+
+  if (batched_http_calls_needed_ == 0) {
+    pushBatchedHttpCallResults(state);
+    return 1;
+  }
+
+  state_ = State::HttpCall;
+  return lua_yield(state, 0);
+}
+
+MessagePtr StreamHandleWrapper::failedHttpCallResponse() {
+  // Just fake a basic 503 response.
+  MessagePtr response_message(new ResponseMessageImpl(HeaderMapPtr{new HeaderMapImpl{
+      {Headers::get().Status, std::to_string(enumToInt(Code::ServiceUnavailable))}}}));
+  response_message->body().reset(new Buffer::OwnedImpl("upstream failure"));
+  return response_message;
+}
+
+void StreamHandleWrapper::pushHttpCallResponse(lua_State* state, Message& response) {
   // We need to build a table with the headers as return param 1. The body will be return param 2.
-  lua_newtable(coroutine_->luaState());
-  response->headers().iterate(
+  lua_newtable(state);
+  response.headers().iterate(
       [](const HeaderEntry& header, void* context) -> HeaderMap::Iterate {
         lua_State* state = static_cast<lua_State*>(context);
         lua_pushstring(state, header.key().c_str());
@@ -215,44 +280,101 @@ void StreamHandleWrapper::onSuccess(MessagePtr&& response) {
         lua_settable(state, -3);
         return HeaderMap::Iterate::Continue;
       },
-      coroutine_->luaState());
+      state);
 
   // TODO(mattklein123): Avoid double copy here.
-  if (response->body() != nullptr) {
-    lua_pushstring(coroutine_->luaState(), response->bodyAsString().c_str());
+  if (response.body() != nullptr) {
+    lua_pushstring(state, response.bodyAsString().c_str());
   } else {
-    lua_pushnil(coroutine_->luaState());
+    lua_pushnil(state);
+  }
+}
+
+void StreamHandleWrapper::resumeHttpCall(int num_args) {
+  state_ = State::Running;
+  markLive();
+
+  try {
+    coroutine_->resume(num_args, yield_callback_);
+    markDead();
+  } catch (const Envoy::Lua::LuaException& e) {
+    filter_.scriptError(e);
+  }
+
+  if (state_ == State::Running) {
+    headers_continued_ = true;
+    callbacks_.continueIteration();
   }
+}
+
+void StreamHandleWrapper::onSuccess(MessagePtr&& response) {
+  ASSERT(state_ == State::HttpCall || state_ == State::Running);
+  ENVOY_LOG(debug, "async HTTP response complete");
+  http_request_ = nullptr;
+  pushHttpCallResponse(coroutine_->luaState(), *response);
 
   // In the immediate failure case, we are just going to immediately return to the script. We
   // have already pushed the return arguments onto the stack.
   if (state_ == State::HttpCall) {
-    state_ = State::Running;
-    markLive();
-
-    try {
-      coroutine_->resume(2, yield_callback_);
-      markDead();
-    } catch (const Envoy::Lua::LuaException& e) {
-      filter_.scriptError(e);
-    }
-
-    if (state_ == State::Running) {
-      headers_continued_ = true;
-      callbacks_.continueIteration();
-    }
+    resumeHttpCall(2);
   }
 }
 
 void StreamHandleWrapper::onFailure(AsyncClient::FailureReason) {
   ASSERT(state_ == State::HttpCall || state_ == State::Running);
   ENVOY_LOG(debug, "async HTTP failure");
+  onSuccess(failedHttpCallResponse());
+}
 
-  // Just fake a basic 503 response.
-  MessagePtr response_message(new ResponseMessageImpl(HeaderMapPtr{new HeaderMapImpl{
-      {Headers::get().Status, std::to_string(enumToInt(Code::ServiceUnavailable))}}}));
-  response_message->body().reset(new Buffer::OwnedImpl("upstream failure"));
-  onSuccess(std::move(response_message));
+void StreamHandleWrapper::BatchedHttpCall::onSuccess(MessagePtr&& response) {
+  ENVOY_LOG(debug, "batched async HTTP response complete");
+  request_ = nullptr;
+  response_ = std::move(response);
+  parent_.onBatchedHttpCallComplete();
+}
+
+void StreamHandleWrapper::BatchedHttpCall::onFailure(AsyncClient::FailureReason) {
+  ENVOY_LOG(debug, "batched async HTTP failure");
+  onSuccess(failedHttpCallResponse());
+}
+
+void StreamHandleWrapper::onBatchedHttpCallComplete() {
+  ASSERT(batched_http_calls_needed_ > 0);
+  // While the calls are being started, luaHttpCalls() returns the results itself.
+  if (--batched_http_calls_needed_ > 0 || state_ != State::HttpCall) {
+    return;
+  }
+
+  pushBatchedHttpCallResults(coroutine_->luaState());
+  resumeHttpCall(1);
+}
+
+void StreamHandleWrapper::pushBatchedHttpCallResults(lua_State* state) {
+  lua_createtable(state, batched_http_calls_.size(), 0);
+  for (size_t i = 0; i < batched_http_calls_.size(); i++) {
+    const BatchedHttpCallPtr& call = batched_http_calls_[i];
+    if (call->response_ == nullptr) {
+      continue;
+    }
+
+    lua_createtable(state, 0, 2);
+    pushHttpCallResponse(state, *call->response_);
+    lua_setfield(state, -3, "body");
+    lua_setfield(state, -2, "headers");
+    lua_rawseti(state, -2, i + 1);
+  }
+
+  cancelBatchedHttpCalls();
+}
+
+void StreamHandleWrapper::cancelBatchedHttpCalls() {
+  for (const BatchedHttpCallPtr& call : batched_http_calls_) {
+    if (call->request_ != nullptr) {
+      call->request_->cancel();
+    }
+  }
+  batched_http_calls_.clear();
+  batched_http_calls_needed_ = 0;
 }
 
 int StreamHandleWrapper::luaHeaders(lua_State* state) {
@@ -392,8 +514,10 @@ int StreamHandleWrapper::luaLogCritical(lua_State* state) {
 }
 
 FilterConfig::FilterConfig(const std::string& lua_code, ThreadLocal::SlotAllocator& tls,
-                           Upstream::ClusterManager& cluster_manager)
-    : cluster_manager_(cluster_manager), lua_state_(lua_code, tls) {
+                           Upstream::ClusterManager& cluster_manager, Runtime::Loader& runtime,
+                           const std::string& stats_prefix, Stats::Scope& scope)
+    : cluster_manager_(cluster_manager), lua_state_(lua_code, tls), runtime_(runtime),
+      stats_{ALL_LUA_FILTER_STATS(POOL_HISTOGRAM_PREFIX(scope, stats_prefix + "lua."))} {
   lua_state_.registerType<Envoy::Lua::BufferWrapper>();
   lua_state_.registerType<HeaderMapWrapper>();
   lua_state_.registerType<HeaderMapIterator>();
@@ -403,13 +527,37 @@ FilterConfig::FilterConfig(const std::string& lua_code, ThreadLocal::SlotAllocat
   response_function_slot_ = lua_state_.registerGlobal("envoy_on_response");
 }
 
+void FilterConfig::onStreamComplete() {
+  // By default LuaJIT collects garbage in steps as the script allocates, which may make a request
+  // in the middle of a script pay for the garbage of earlier ones.
+  const uint64_t step_kb = runtime_.snapshot().getInteger("lua.gc_step_kb", 0);
+  if (step_kb > 0) {
+    const MonotonicTime start = ProdMonotonicTimeSource::instance_.currentTime();
+    lua_state_.collectGarbage(step_kb);
+    stats_.gc_step_us_.recordValue(std::chrono::duration_cast<std::chrono::microseconds>(
+                                       ProdMonotonicTimeSource::instance_.currentTime() - start)
+                                       .count());
+  }
+  stats_.memory_kb_.recordValue(lua_state_.runtimeBytesUsed() / 1024);
+}
+
 void Filter::onDestroy() {
   destroyed_ = true;
-  if (request_stream_wrapper_.get()) {
-    request_stream_wrapper_.get()->onReset();
+  const bool ran_script = request_stream_wrapper_.get() || response_stream_wrapper_.get();
+  releaseCoroutine(request_stream_wrapper_);
+  releaseCoroutine(response_stream_wrapper_);
+  if (ran_script) {
+    config_->onStreamComplete();
   }
-  if (response_stream_wrapper_.get()) {
-    response_stream_wrapper_.get()->onReset();
+}
+
+void Filter::releaseCoroutine(StreamHandleRef& handle) {
+  if (handle.get()) {
+    handle.get()->onReset();
+    // Kill the wrapper before the coroutine is pooled, since the reference to it was taken on the
+    // coroutine.
+    Envoy::Lua::CoroutinePtr coroutine = handle.get()->releaseCoroutine();
+    handle.reset();
   }
 }
 
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "envoy/http/filter.h"
+#include "envoy/runtime/runtime.h"
+#include "envoy/stats/stats_macros.h"
 #include "envoy/upstream/cluster_manager.h"
 
 #include "common/http/filter/lua/wrappers.h"
@@ -92,15 +94,24 @@ public:
       http_request_->cancel();
       http_request_ = nullptr;
     }
+    cancelBatchedHttpCalls();
   }
 
+  /**
+   * Give up the coroutine once the stream is done so that it can be reused without waiting for
+   * the wrapper to be garbage collected. The wrapper must be dead by the time the coroutine is
+   * destroyed.
+   */
+  Envoy::Lua::CoroutinePtr releaseCoroutine() { return std::move(coroutine_); }
+
   static ExportedFunctions exportedFunctions() {
     return {{"headers", static_luaHeaders},       {"body", static_luaBody},
             {"bodyChunks", static_luaBodyChunks}, {"trailers", static_luaTrailers},
             {"logTrace", static_luaLogTrace},     {"logDebug", static_luaLogDebug},
             {"logInfo", static_luaLogInfo},       {"logWarn", static_luaLogWarn},
             {"logErr", static_luaLogErr},         {"logCritical", static_luaLogCritical},
-            {"httpCall", static_luaHttpCall},     {"respond", static_luaRespond}};
+            {"httpCall", static_luaHttpCall},     {"httpCalls", static_luaHttpCalls},
+            {"respond", static_luaRespond}};
   }
 
 private:
@@ -114,6 +125,18 @@ private:
    */
   DECLARE_LUA_FUNCTION(StreamHandleWrapper, luaHttpCall);
 
+  /**
+   * Perform several HTTP calls at once, and wait until all of them or a given number of them
+   * complete. Calls that are still outstanding at that point are cancelled.
+   * @param 1 (table): An array of calls, each of which is an array of the parameters of
+   *        httpCall().
+   * @param 2 (int): The number of calls to wait for. Optional, defaults to all of them.
+   * @return an array with a table for each call in the order of the calls, which holds the
+   *         response headers (table) in 'headers' and the response body (string/nil) in 'body',
+   *         or nil for calls that were cancelled.
+   */
+  DECLARE_LUA_FUNCTION(StreamHandleWrapper, luaHttpCalls);
+
   /**
    * Perform an inline response. This call is currently only valid on the request path. Further
    * filter iteration will stop. No further script code will run after this call.
@@ -165,8 +188,38 @@ private:
    */
   DECLARE_LUA_CLOSURE(StreamHandleWrapper, luaBodyIterator);
 
+  /**
+   * One of the HTTP calls started by luaHttpCalls().
+   */
+  struct BatchedHttpCall : public AsyncClient::Callbacks {
+    BatchedHttpCall(StreamHandleWrapper& parent) : parent_(parent) {}
+
+    // Http::AsyncClient::Callbacks
+    void onSuccess(MessagePtr&& response) override;
+    void onFailure(AsyncClient::FailureReason) override;
+
+    StreamHandleWrapper& parent_;
+    AsyncClient::Request* request_{};
+    MessagePtr response_;
+  };
+
+  typedef std::unique_ptr<BatchedHttpCall> BatchedHttpCallPtr;
+
   static HeaderMapPtr buildHeadersFromTable(lua_State* state, int table_index);
 
+  /**
+   * Build the request of an HTTP call from the parameters of httpCall(), which start at the given
+   * stack index.
+   */
+  MessagePtr buildHttpCallMessage(lua_State* state, int index, std::string& cluster,
+                                  Optional<std::chrono::milliseconds>& timeout);
+  static MessagePtr failedHttpCallResponse();
+  static void pushHttpCallResponse(lua_State* state, Message& response);
+  void resumeHttpCall(int num_args);
+  void onBatchedHttpCallComplete();
+  void pushBatchedHttpCallResults(lua_State* state);
+  void cancelBatchedHttpCalls();
+
   // Envoy::Lua::BaseLuaObject
   void onMarkDead() override {
     // Headers/body/trailers wrappers do not survive any yields. The user can request them
@@ -195,6 +248,25 @@ private:
   State state_{State::Running};
   std::function<void()> yield_callback_;
   AsyncClient::Request* http_request_{};
+  std::vector<BatchedHttpCallPtr> batched_http_calls_;
+  // The number of batched calls that still need to complete before the script resumes.
+  uint32_t batched_http_calls_needed_{};
+};
+
+/**
+ * All stats for the Lua filter. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_LUA_FILTER_STATS(HISTOGRAM)                                                            \
+  HISTOGRAM(gc_step_us)                                                                            \
+  HISTOGRAM(memory_kb)
+// clang-format on
+
+/**
+ * Struct definition for all Lua filter stats. @see stats_macros.h
+ */
+struct LuaFilterStats {
+  ALL_LUA_FILTER_STATS(GENERATE_HISTOGRAM_STRUCT)
 };
 
 /**
@@ -203,23 +275,31 @@ private:
 class FilterConfig : Logger::Loggable<Logger::Id::lua> {
 public:
   FilterConfig(const std::string& lua_code, ThreadLocal::SlotAllocator& tls,
-               Upstream::ClusterManager& cluster_manager);
+               Upstream::ClusterManager& cluster_manager, Runtime::Loader& runtime,
+               const std::string& stats_prefix, Stats::Scope& scope);
   Envoy::Lua::CoroutinePtr createCoroutine() { return lua_state_.createCoroutine(); }
   int requestFunctionRef() { return lua_state_.getGlobalRef(request_function_slot_); }
   int responseFunctionRef() { return lua_state_.getGlobalRef(response_function_slot_); }
 
+  /**
+   * Called on the worker once a stream that ran a script is done. Runs the incremental garbage
+   * collection step that the runtime asks for, and records the memory used by the worker's
+   * state.
+   */
+  void onStreamComplete();
+
   Upstream::ClusterManager& cluster_manager_;
 
 private:
   Envoy::Lua::ThreadLocalState lua_state_;
+  Runtime::Loader& runtime_;
+  LuaFilterStats stats_;
   uint64_t request_function_slot_;
   uint64_t response_function_slot_;
 };
 
 typedef std::shared_ptr<FilterConfig> FilterConfigConstSharedPtr;
 
-// TODO(mattklein123): Filter stats.
-
 /**
  * The HTTP Lua filter. Allows scripts to run in both the request an response flow.
  */
@@ -303,6 +383,7 @@ private:
                                 int function_ref, HeaderMap& headers, bool end_stream);
   FilterDataStatus doData(StreamHandleRef& handle, Buffer::Instance& data, bool end_stream);
   FilterTrailersStatus doTrailers(StreamHandleRef& handle, HeaderMap& trailers);
+  static void releaseCoroutine(StreamHandleRef& handle);
 
   FilterConfigConstSharedPtr config_;
   DecoderCallbacks decoder_callbacks_{*this};
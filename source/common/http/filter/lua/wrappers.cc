@@ -48,6 +48,18 @@ int HeaderMapWrapper::luaGet(lua_State* state) {
   }
 }
 
+int HeaderMapWrapper::luaGetRaw(lua_State* state) {
+  const char* key = luaL_checkstring(state, 2);
+  const HeaderEntry* entry = headers_.get(LowerCaseString(key));
+  if (entry != nullptr) {
+    lua_pushlightuserdata(state, const_cast<char*>(entry->value().c_str()));
+    lua_pushnumber(state, entry->value().size());
+    return 2;
+  } else {
+    return 0;
+  }
+}
+
 int HeaderMapWrapper::luaPairs(lua_State* state) {
   if (iterator_.get() != nullptr) {
     luaL_error(state, "cannot create a second iterator before completing the first");
@@ -41,6 +41,7 @@ public:
   static ExportedFunctions exportedFunctions() {
     return {{"add", static_luaAdd},
             {"get", static_luaGet},
+            {"getRaw", static_luaGetRaw},
             {"remove", static_luaRemove},
             {"__pairs", static_luaPairs}};
   }
@@ -61,6 +62,15 @@ private:
    */
   DECLARE_LUA_FUNCTION(HeaderMapWrapper, luaGet);
 
+  /**
+   * Get a header value from the map without copying it into a Lua string. LuaJIT FFI can read the
+   * value in place, e.g. via ffi.string(ffi.cast("const char*", pointer), length) once it needs a
+   * string. The pointer is only valid until the map is modified or the script yields.
+   * @param 1 (string): header name.
+   * @return light userdata pointing at the value and int length of the value if found or nil.
+   */
+  DECLARE_LUA_FUNCTION(HeaderMapWrapper, luaGetRaw);
+
   /**
    * Implementation of the __pairs metamethod so a headers wrapper can be iterated over using
    * pairs().
@@ -1,5 +1,7 @@
 #include "common/http/header_map_impl.h"
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <list>
 #include <string>
@@ -224,38 +226,126 @@ HeaderMapImpl::StaticLookupTable::StaticLookupTable() {
   add(Headers::get().HostLegacy.get().c_str(), [](HeaderMapImpl& h) -> StaticLookupResponse {
     return {&h.inline_headers_.Host_, &Headers::get().Host};
   });
+
+  placeEntries();
 }
 
 void HeaderMapImpl::StaticLookupTable::add(const char* key, StaticLookupEntry::EntryCb cb) {
-  StaticLookupEntry* current = &root_;
-  while (uint8_t c = *key) {
-    if (!current->entries_[c]) {
-      current->entries_[c].reset(new StaticLookupEntry());
+  // The keys are the static header names, which outlive the table.
+  const size_t size = strlen(key);
+  RELEASE_ASSERT(size <= MaxKeySize);
+  RELEASE_ASSERT(entries_.size() < EmptySlot);
+  entries_.push_back({key, size, cb});
+  sizes_ |= 1ULL << size;
+}
+
+void HeaderMapImpl::StaticLookupTable::placeEntries() {
+  for (seed_ = 0;; seed_++) {
+    slots_.fill(EmptySlot);
+    bool collision = false;
+    for (size_t i = 0; i < entries_.size() && !collision; i++) {
+      uint8_t& index = slots_[slot(entries_[i].key_, entries_[i].size_)];
+      collision = index != EmptySlot;
+      index = i;
+    }
+    if (!collision) {
+      return;
     }
+  }
+}
+
+HeaderMapImpl::StaticLookupEntry::EntryCb
+HeaderMapImpl::StaticLookupTable::find(const char* key, size_t size) const {
+  if (size > MaxKeySize || (sizes_ & (1ULL << size)) == 0) {
+    return nullptr;
+  }
 
-    current = current->entries_[c].get();
-    key++;
+  const uint8_t index = slots_[slot(key, size)];
+  if (index == EmptySlot) {
+    return nullptr;
   }
 
-  current->cb_ = cb;
+  const StaticLookupEntry& entry = entries_[index];
+  return entry.size_ == size && memcmp(entry.key_, key, size) == 0 ? entry.cb_ : nullptr;
 }
 
-HeaderMapImpl::StaticLookupEntry::EntryCb
-HeaderMapImpl::StaticLookupTable::find(const char* key) const {
-  const StaticLookupEntry* current = &root_;
-  while (uint8_t c = *key) {
-    current = current->entries_[c].get();
-    if (current) {
-      key++;
-    } else {
-      return nullptr;
-    }
+const size_t HeaderMapImpl::StaticLookupTable::Slots;
+const size_t HeaderMapImpl::StaticLookupTable::MaxKeySize;
+const uint8_t HeaderMapImpl::StaticLookupTable::EmptySlot;
+const size_t HeaderMapImpl::NodeArena::InitialBlockNodes;
+const size_t HeaderMapImpl::NodeArena::MaxBlockNodes;
+const size_t HeaderMapImpl::CustomHeaderIndexThreshold;
+
+void* HeaderMapImpl::NodeArena::allocate(size_t size) {
+  // Every node of a given list type has the same size. Anything else (which no std::list
+  // implementation requests in practice) goes to the heap.
+  if (node_size_ == 0) {
+    // Keep each node in a block suitably aligned.
+    const size_t alignment = alignof(std::max_align_t);
+    node_size_ = (size + alignment - 1) / alignment * alignment;
+  }
+  if (size > node_size_) {
+    return ::operator new(size);
+  }
+
+  if (free_list_ != nullptr) {
+    FreeNode* node = free_list_;
+    free_list_ = node->next_;
+    return node;
+  }
+
+  if (blocks_.empty() || next_node_ == block_nodes_) {
+    block_nodes_ =
+        block_nodes_ == 0 ? InitialBlockNodes : std::min(block_nodes_ * 2, MaxBlockNodes);
+    blocks_.emplace_back(new uint8_t[block_nodes_ * node_size_]);
+    next_node_ = 0;
+  }
+  return blocks_.back().get() + node_size_ * next_node_++;
+}
+
+void HeaderMapImpl::NodeArena::deallocate(void* node, size_t size) {
+  if (size > node_size_) {
+    ::operator delete(node);
+    return;
   }
 
-  return current->cb_;
+  FreeNode* free_node = static_cast<FreeNode*>(node);
+  free_node->next_ = free_list_;
+  free_list_ = free_node;
 }
 
-HeaderMapImpl::HeaderMapImpl() { memset(&inline_headers_, 0, sizeof(inline_headers_)); }
+HeaderMapImpl::HeaderMapImpl()
+    : arena_(new NodeArena()), headers_(NodeAllocator<HeaderEntryImpl>(*arena_)) {
+  memset(&inline_headers_, 0, sizeof(inline_headers_));
+}
+
+HeaderMapImpl::HeaderMapImpl(HeaderMapImpl&& rhs)
+    : inline_headers_(rhs.inline_headers_), arena_(std::move(rhs.arena_)),
+      headers_(std::move(rhs.headers_)),
+      custom_header_index_(std::move(rhs.custom_header_index_)) {
+  rhs.resetMovedFrom();
+}
+
+HeaderMapImpl& HeaderMapImpl::operator=(HeaderMapImpl&& rhs) {
+  if (this != &rhs) {
+    // Our nodes are freed into our arena while it is still alive. Then the nodes of rhs and the
+    // arena that holds them are taken over together.
+    custom_header_index_ = std::move(rhs.custom_header_index_);
+    headers_ = std::move(rhs.headers_);
+    arena_ = std::move(rhs.arena_);
+    inline_headers_ = rhs.inline_headers_;
+    rhs.resetMovedFrom();
+  }
+  return *this;
+}
+
+void HeaderMapImpl::resetMovedFrom() {
+  // The nodes and the arena belong to another map now, so start over with an arena of our own.
+  custom_header_index_.reset();
+  arena_.reset(new NodeArena());
+  headers_ = HeaderList(NodeAllocator<HeaderEntryImpl>(*arena_));
+  memset(&inline_headers_, 0, sizeof(inline_headers_));
+}
 
 HeaderMapImpl::HeaderMapImpl(const HeaderMap& rhs) : HeaderMapImpl() {
   rhs.iterate(
@@ -300,7 +390,8 @@ bool HeaderMapImpl::operator==(const HeaderMapImpl& rhs) const {
 }
 
 void HeaderMapImpl::insertByKey(HeaderString&& key, HeaderString&& value) {
-  StaticLookupEntry::EntryCb cb = ConstSingleton<StaticLookupTable>::get().find(key.c_str());
+  StaticLookupEntry::EntryCb cb =
+      ConstSingleton<StaticLookupTable>::get().find(key.c_str(), key.size());
   if (cb) {
     // TODO(mattklein123): Currently, for all of the inline headers, we don't support appending. The
     // only inline header where we should be converting multiple headers into a comma delimited
@@ -311,9 +402,9 @@ void HeaderMapImpl::insertByKey(HeaderString&& key, HeaderString&& value) {
     StaticLookupResponse ref_lookup_response = cb(*this);
     maybeCreateInline(ref_lookup_response.entry_, *ref_lookup_response.key_, std::move(value));
   } else {
-    std::list<HeaderEntryImpl>::iterator i =
-        headers_.emplace(headers_.end(), std::move(key), std::move(value));
+    HeaderList::iterator i = headers_.emplace(headers_.end(), std::move(key), std::move(value));
     i->entry_ = i;
+    updateCustomHeaderIndex(&(*i));
   }
 }
 
@@ -321,6 +412,26 @@ void HeaderMapImpl::addViaMove(HeaderString&& key, HeaderString&& value) {
   insertByKey(std::move(key), std::move(value));
 }
 
+HeaderEntry* HeaderMapImpl::addViaMoveKey(HeaderString&& key) {
+  StaticLookupEntry::EntryCb cb =
+      ConstSingleton<StaticLookupTable>::get().find(key.c_str(), key.size());
+  if (cb) {
+    key.clear();
+    StaticLookupResponse ref_lookup_response = cb(*this);
+    if (*ref_lookup_response.entry_) {
+      return nullptr;
+    }
+
+    return &maybeCreateInline(ref_lookup_response.entry_, *ref_lookup_response.key_);
+  }
+
+  HeaderList::iterator i = headers_.emplace(headers_.end(), std::move(key), HeaderString());
+  i->entry_ = i;
+  updateCustomHeaderIndex(&(*i));
+
+  return &(*i);
+}
+
 void HeaderMapImpl::addReference(const LowerCaseString& key, const std::string& value) {
   HeaderString ref_key(key);
   HeaderString ref_value(value);
@@ -390,6 +501,18 @@ uint64_t HeaderMapImpl::byteSize() const {
 }
 
 const HeaderEntry* HeaderMapImpl::get(const LowerCaseString& key) const {
+  if (custom_header_index_) {
+    // Inline headers are never in the index; they are found directly via the static table.
+    StaticLookupEntry::EntryCb cb =
+        ConstSingleton<StaticLookupTable>::get().find(key.get().c_str(), key.get().size());
+    if (cb) {
+      return *cb(const_cast<HeaderMapImpl&>(*this)).entry_;
+    }
+
+    auto it = custom_header_index_->find(HeaderKeyRef{key.get().c_str(), key.get().size()});
+    return it != custom_header_index_->end() ? it->second : nullptr;
+  }
+
   for (const HeaderEntryImpl& header : headers_) {
     if (header.key() == key.get().c_str()) {
       return &header;
@@ -417,7 +540,8 @@ void HeaderMapImpl::iterateReverse(ConstIterateCb cb, void* context) const {
 
 HeaderMap::Lookup HeaderMapImpl::lookup(const LowerCaseString& key,
                                         const HeaderEntry** entry) const {
-  StaticLookupEntry::EntryCb cb = ConstSingleton<StaticLookupTable>::get().find(key.get().c_str());
+  StaticLookupEntry::EntryCb cb =
+      ConstSingleton<StaticLookupTable>::get().find(key.get().c_str(), key.get().size());
   if (cb) {
     // The accessor callbacks for predefined inline headers take a HeaderMapImpl& as an argument;
     // even though we don't make any modifications, we need to cast_cast in order to use the
@@ -439,11 +563,16 @@ HeaderMap::Lookup HeaderMapImpl::lookup(const LowerCaseString& key,
 }
 
 void HeaderMapImpl::remove(const LowerCaseString& key) {
-  StaticLookupEntry::EntryCb cb = ConstSingleton<StaticLookupTable>::get().find(key.get().c_str());
+  StaticLookupEntry::EntryCb cb =
+      ConstSingleton<StaticLookupTable>::get().find(key.get().c_str(), key.get().size());
   if (cb) {
     StaticLookupResponse ref_lookup_response = cb(*this);
     removeInline(ref_lookup_response.entry_);
   } else {
+    if (custom_header_index_ &&
+        custom_header_index_->count(HeaderKeyRef{key.get().c_str(), key.get().size()}) == 0) {
+      return;
+    }
     for (auto i = headers_.begin(); i != headers_.end();) {
       if (i->key() == key.get().c_str()) {
         i = headers_.erase(i);
@@ -451,6 +580,35 @@ void HeaderMapImpl::remove(const LowerCaseString& key) {
         ++i;
       }
     }
+    if (custom_header_index_) {
+      custom_header_index_->erase(HeaderKeyRef{key.get().c_str(), key.get().size()});
+    }
+  }
+}
+
+void HeaderMapImpl::updateCustomHeaderIndex(HeaderEntryImpl* added) {
+  if (custom_header_index_) {
+    if (added != nullptr) {
+      // emplace() does not replace an existing entry, so the index keeps pointing at the first
+      // header with this key.
+      custom_header_index_->emplace(HeaderKeyRef{added->key().c_str(), added->key().size()},
+                                    added);
+    }
+  } else if (headers_.size() > CustomHeaderIndexThreshold) {
+    buildCustomHeaderIndex();
+  }
+}
+
+void HeaderMapImpl::buildCustomHeaderIndex() {
+  custom_header_index_.reset(new CustomHeaderIndex());
+  custom_header_index_->reserve(headers_.size());
+  const StaticLookupTable& static_table = ConstSingleton<StaticLookupTable>::get();
+  for (HeaderEntryImpl& header : headers_) {
+    if (static_table.find(header.key().c_str(), header.key().size())) {
+      continue;
+    }
+    custom_header_index_->emplace(HeaderKeyRef{header.key().c_str(), header.key().size()},
+                                  &header);
   }
 }
 
@@ -460,9 +618,10 @@ HeaderMapImpl::HeaderEntryImpl& HeaderMapImpl::maybeCreateInline(HeaderEntryImpl
     return **entry;
   }
 
-  std::list<HeaderEntryImpl>::iterator i = headers_.emplace(headers_.end(), key);
+  HeaderList::iterator i = headers_.emplace(headers_.end(), key);
   i->entry_ = i;
   *entry = &(*i);
+  updateCustomHeaderIndex(nullptr);
   return **entry;
 }
 
@@ -474,9 +633,10 @@ HeaderMapImpl::HeaderEntryImpl& HeaderMapImpl::maybeCreateInline(HeaderEntryImpl
     return **entry;
   }
 
-  std::list<HeaderEntryImpl>::iterator i = headers_.emplace(headers_.end(), key, std::move(value));
+  HeaderList::iterator i = headers_.emplace(headers_.end(), key, std::move(value));
   i->entry_ = i;
   *entry = &(*i);
+  updateCustomHeaderIndex(nullptr);
   return **entry;
 }
 
@@ -2,12 +2,17 @@
 
 #include <array>
 #include <cstdint>
+#include <cstring>
 #include <list>
 #include <memory>
 #include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
 
 #include "envoy/http/header_map.h"
 
+#include "common/common/hash.h"
 #include "common/common/non_copyable.h"
 #include "common/http/headers.h"
 
@@ -41,12 +46,28 @@ public:
   HeaderMapImpl(const std::initializer_list<std::pair<LowerCaseString, std::string>>& values);
   HeaderMapImpl(const HeaderMap& rhs);
 
+  /**
+   * Move the headers of rhs without copying them. The arena that holds the headers moves with them,
+   * so their addresses do not change. rhs is left empty and can be reused.
+   */
+  HeaderMapImpl(HeaderMapImpl&& rhs);
+  HeaderMapImpl& operator=(HeaderMapImpl&& rhs);
+
   /**
    * Add a header via full move. This is the expected high performance paths for codecs populating
    * a map when receiving.
    */
   void addViaMove(HeaderString&& key, HeaderString&& value);
 
+  /**
+   * Add a header via key move, leaving the value to be filled in by the caller. This lets a codec
+   * decode a value directly into the map rather than into a temporary that is then moved in, which
+   * copies any value short enough to be stored inline.
+   * @return the added header, or nullptr if the key is an inline header that is already present. In
+   *         that case the value should be dropped, the same as addViaMove() would do.
+   */
+  HeaderEntry* addViaMoveKey(HeaderString&& key);
+
   /**
    * For testing. Equality is based on equality of the backing list. This is an exact match
    * comparison (order matters).
@@ -71,6 +92,62 @@ public:
   size_t size() const override { return headers_.size(); }
 
 protected:
+  /**
+   * Backing storage for the nodes of headers_. Nodes are carved out of contiguous blocks owned by
+   * the map, so populating a map costs a few block allocations instead of one allocation per
+   * header, and iterating touches adjacent memory. Freed nodes are recycled for later inserts.
+   * Node addresses are stable for the life of the node, which the inline header pointers and the
+   * custom header index depend on.
+   */
+  class NodeArena : NonCopyable {
+  public:
+    void* allocate(size_t size);
+    void deallocate(void* node, size_t size);
+
+  private:
+    struct FreeNode {
+      FreeNode* next_;
+    };
+
+    static const size_t InitialBlockNodes = 8;
+    static const size_t MaxBlockNodes = 64;
+
+    std::vector<std::unique_ptr<uint8_t[]>> blocks_;
+    size_t node_size_{};
+    size_t block_nodes_{};
+    size_t next_node_{};
+    FreeNode* free_list_{};
+  };
+
+  /**
+   * Minimal stateful allocator that routes std::list node allocation to a NodeArena.
+   */
+  template <class T> struct NodeAllocator {
+    typedef T value_type;
+
+    // A list that is move assigned takes the nodes of the other list, and so must take its arena.
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+
+    NodeAllocator(NodeArena& arena) : arena_(&arena) {}
+    template <class U> NodeAllocator(const NodeAllocator<U>& other) : arena_(other.arena_) {}
+
+    T* allocate(size_t n) { return static_cast<T*>(arena_->allocate(n * sizeof(T))); }
+    void deallocate(T* p, size_t n) { arena_->deallocate(p, n * sizeof(T)); }
+
+    template <class U> bool operator==(const NodeAllocator<U>& other) const {
+      return arena_ == other.arena_;
+    }
+    template <class U> bool operator!=(const NodeAllocator<U>& other) const {
+      return arena_ != other.arena_;
+    }
+
+    NodeArena* arena_;
+  };
+
+  struct HeaderEntryImpl;
+  typedef std::list<HeaderEntryImpl, NodeAllocator<HeaderEntryImpl>> HeaderList;
+
   struct HeaderEntryImpl : public HeaderEntry, NonCopyable {
     HeaderEntryImpl(const LowerCaseString& key);
     HeaderEntryImpl(const LowerCaseString& key, HeaderString&& value);
@@ -87,7 +164,7 @@ protected:
 
     HeaderString key_;
     HeaderString value_;
-    std::list<HeaderEntryImpl>::iterator entry_;
+    HeaderList::iterator entry_;
   };
 
   struct StaticLookupResponse {
@@ -98,34 +175,102 @@ protected:
   struct StaticLookupEntry {
     typedef StaticLookupResponse (*EntryCb)(HeaderMapImpl&);
 
-    EntryCb cb_{};
-    std::array<std::unique_ptr<StaticLookupEntry>, 256> entries_;
+    const char* key_;
+    size_t size_;
+    EntryCb cb_;
   };
 
   /**
    * This is the static lookup table that is used to determine whether a header is one of the O(1)
-   * headers. This uses a trie for lookup time at most equal to the size of the incoming string.
+   * headers. It is a perfect hash table: the hash seed is searched for at construction so that no
+   * two keys share a slot, so a lookup hashes the key once and compares it with at most one
+   * entry. Keys of a length that no entry has are rejected without hashing them.
    */
   struct StaticLookupTable {
     StaticLookupTable();
     void add(const char* key, StaticLookupEntry::EntryCb cb);
-    StaticLookupEntry::EntryCb find(const char* key) const;
+    StaticLookupEntry::EntryCb find(const char* key, size_t size) const;
+
+  private:
+    // Sized so that a collision free seed is found after a handful of attempts.
+    static const size_t Slots = 1024;
+    static const size_t MaxKeySize = 63;
+    static const uint8_t EmptySlot = 0xff;
 
-    StaticLookupEntry root_;
+    size_t slot(const char* key, size_t size) const {
+      return HashUtil::xxHash64(key, size, seed_) & (Slots - 1);
+    }
+    void placeEntries();
+
+    std::vector<StaticLookupEntry> entries_;
+    // Indexes into entries_.
+    std::array<uint8_t, Slots> slots_;
+    // Bit N is set if an entry has size N.
+    uint64_t sizes_{};
+    uint64_t seed_{};
   };
 
   struct AllInlineHeaders {
     ALL_INLINE_HEADERS(DEFINE_INLINE_HEADER_STRUCT)
   };
 
+  /**
+   * A non-owning reference to a header key, used as the key of the custom header index. The
+   * referenced characters are owned by a HeaderEntryImpl in headers_ (or by the caller for the
+   * duration of a lookup).
+   */
+  struct HeaderKeyRef {
+    const char* data_;
+    size_t size_;
+  };
+
+  struct HeaderKeyRefHash {
+    size_t operator()(const HeaderKeyRef& key) const {
+      return HashUtil::xxHash64(key.data_, key.size_);
+    }
+  };
+
+  struct HeaderKeyRefEqual {
+    bool operator()(const HeaderKeyRef& lhs, const HeaderKeyRef& rhs) const {
+      return lhs.size_ == rhs.size_ && memcmp(lhs.data_, rhs.data_, lhs.size_) == 0;
+    }
+  };
+
+  /**
+   * Maps a non-inline header key to the first header in headers_ with that key.
+   */
+  typedef std::unordered_map<HeaderKeyRef, HeaderEntryImpl*, HeaderKeyRefHash, HeaderKeyRefEqual>
+      CustomHeaderIndex;
+
+  /**
+   * Once the map holds more than this many headers, the custom header index is built so that
+   * lookups of non-inline headers no longer scan the list. Smaller maps are faster to scan than to
+   * index.
+   */
+  static const size_t CustomHeaderIndexThreshold = 16;
+
   void insertByKey(HeaderString&& key, HeaderString&& value);
   HeaderEntryImpl& maybeCreateInline(HeaderEntryImpl** entry, const LowerCaseString& key);
   HeaderEntryImpl& maybeCreateInline(HeaderEntryImpl** entry, const LowerCaseString& key,
                                      HeaderString&& value);
   void removeInline(HeaderEntryImpl** entry);
+  /**
+   * Called after a header is added to headers_. Indexes the header if it is a custom header
+   * (added is non-null) and the index exists, or builds the index once the map crosses
+   * CustomHeaderIndexThreshold.
+   */
+  void updateCustomHeaderIndex(HeaderEntryImpl* added);
+  void buildCustomHeaderIndex();
+  void resetMovedFrom();
 
   AllInlineHeaders inline_headers_;
-  std::list<HeaderEntryImpl> headers_;
+  // Held by pointer so that its address, which the allocator of headers_ refers to, does not change
+  // when the map is moved. Must be declared before headers_ so that it outlives the list nodes.
+  std::unique_ptr<NodeArena> arena_;
+  HeaderList headers_;
+  // Built and kept in sync by the mutating paths only, so that const lookups never write and a
+  // map that is no longer modified can be read from several threads.
+  std::unique_ptr<CustomHeaderIndex> custom_header_index_;
 
   ALL_INLINE_HEADERS(DEFINE_INLINE_HEADER_FUNCS)
 };
@@ -2,6 +2,7 @@
 
 #include <cstdint>
 #include <string>
+#include <vector>
 
 #include "envoy/buffer/buffer.h"
 #include "envoy/http/header_map.h"
@@ -22,6 +23,11 @@ namespace Http1 {
 const std::string StreamEncoderImpl::CRLF = "\r\n";
 const std::string StreamEncoderImpl::LAST_CHUNK = "0\r\n\r\n";
 
+// Header lines that the encoder adds itself, serialized ahead of time.
+static const char CONTENT_LENGTH_ZERO_LINE[] = "content-length: 0\r\n";
+static const char TRANSFER_ENCODING_CHUNKED_LINE[] = "transfer-encoding: chunked\r\n";
+static const char CONTINUE_RESPONSE[] = "HTTP/1.1 100 Continue\r\n\r\n";
+
 void StreamEncoderImpl::encodeHeader(const char* key, uint32_t key_size, const char* value,
                                      uint32_t value_size) {
 
@@ -72,19 +78,19 @@ void StreamEncoderImpl::encodeHeaders(const HeaderMap& headers, bool end_stream)
     chunk_encoding_ = false;
   } else {
     if (end_stream) {
-      encodeHeader(Headers::get().ContentLength.get().c_str(),
-                   Headers::get().ContentLength.get().size(), "0", 1);
+      connection_.reserveBuffer(sizeof(CONTENT_LENGTH_ZERO_LINE) - 1 + 2);
+      connection_.copyToBuffer(CONTENT_LENGTH_ZERO_LINE, sizeof(CONTENT_LENGTH_ZERO_LINE) - 1);
       chunk_encoding_ = false;
     } else {
-      encodeHeader(Headers::get().TransferEncoding.get().c_str(),
-                   Headers::get().TransferEncoding.get().size(),
-                   Headers::get().TransferEncodingValues.Chunked.c_str(),
-                   Headers::get().TransferEncodingValues.Chunked.size());
+      connection_.reserveBuffer(sizeof(TRANSFER_ENCODING_CHUNKED_LINE) - 1 + 2);
+      connection_.copyToBuffer(TRANSFER_ENCODING_CHUNKED_LINE,
+                               sizeof(TRANSFER_ENCODING_CHUNKED_LINE) - 1);
       chunk_encoding_ = true;
     }
+  } else {
+    connection_.reserveBuffer(2);
   }
 
-  connection_.reserveBuffer(2);
   connection_.addCharToBuffer('\r');
   connection_.addCharToBuffer('\n');
 
@@ -100,7 +106,10 @@ void StreamEncoderImpl::encodeData(Buffer::Instance& data, bool end_stream) {
   // atually write the zero length buffer out.
   if (data.length() > 0) {
     if (chunk_encoding_) {
-      connection_.buffer().add(fmt::format("{:x}\r\n", data.length()));
+      // At most 16 hex digits followed by CRLF.
+      char chunk_header[18];
+      const uint32_t chunk_header_size = formatChunkHeader(data.length(), chunk_header);
+      connection_.buffer().add(chunk_header, chunk_header_size);
     }
 
     connection_.buffer().move(data);
@@ -119,6 +128,22 @@ void StreamEncoderImpl::encodeData(Buffer::Instance& data, bool end_stream) {
 
 void StreamEncoderImpl::encodeTrailers(const HeaderMap&) { endEncode(); }
 
+uint32_t StreamEncoderImpl::formatChunkHeader(uint64_t length, char* out) {
+  static const char hex_digits[] = "0123456789abcdef";
+  uint32_t digits = 1;
+  while (digits < 16 && (length >> (4 * digits)) != 0) {
+    digits++;
+  }
+
+  for (uint32_t i = 0; i < digits; i++) {
+    out[digits - i - 1] = hex_digits[(length >> (4 * i)) & 0xf];
+  }
+
+  out[digits] = '\r';
+  out[digits + 1] = '\n';
+  return digits + 2;
+}
+
 void StreamEncoderImpl::endEncode() {
   if (chunk_encoding_) {
     connection_.buffer().add(LAST_CHUNK);
@@ -135,6 +160,10 @@ void ConnectionImpl::flushOutput() {
     reserved_current_ = nullptr;
   }
 
+  if (defer_output_) {
+    return;
+  }
+
   connection().write(output_buffer_);
   ASSERT(0UL == output_buffer_.length());
 }
@@ -184,21 +213,47 @@ uint32_t StreamEncoderImpl::bufferLimit() { return connection_.bufferLimit(); }
 
 static const char RESPONSE_PREFIX[] = "HTTP/1.1 ";
 
+const std::string* ResponseStreamEncoderImpl::statusLine(uint64_t numeric_status) {
+  static const std::vector<std::string>* status_lines = []() {
+    std::vector<std::string>* status_lines = new std::vector<std::string>();
+    for (uint64_t code = MinCachedStatus; code <= MaxCachedStatus; code++) {
+      status_lines->push_back(fmt::format("{}{} {}\r\n", RESPONSE_PREFIX, code,
+                                          CodeUtility::toString(static_cast<Code>(code))));
+    }
+    return status_lines;
+  }();
+
+  if (numeric_status < MinCachedStatus || numeric_status > MaxCachedStatus) {
+    return nullptr;
+  }
+
+  return &(*status_lines)[numeric_status - MinCachedStatus];
+}
+
 void ResponseStreamEncoderImpl::encodeHeaders(const HeaderMap& headers, bool end_stream) {
   started_response_ = true;
   uint64_t numeric_status = Utility::getResponseStatus(headers);
+  close_connection_ =
+      headers.Connection() &&
+      0 == StringUtil::caseInsensitiveCompare(headers.Connection()->value().c_str(),
+                                              Headers::get().ConnectionValues.Close.c_str());
 
   connection_.reserveBuffer(4096);
-  connection_.copyToBuffer(RESPONSE_PREFIX, sizeof(RESPONSE_PREFIX) - 1);
-  connection_.addIntToBuffer(numeric_status);
-  connection_.addCharToBuffer(' ');
+  const std::string* status_line = statusLine(numeric_status);
+  if (status_line) {
+    connection_.copyToBuffer(status_line->c_str(), status_line->size());
+  } else {
+    connection_.copyToBuffer(RESPONSE_PREFIX, sizeof(RESPONSE_PREFIX) - 1);
+    connection_.addIntToBuffer(numeric_status);
+    connection_.addCharToBuffer(' ');
 
-  const char* status_string = CodeUtility::toString(static_cast<Code>(numeric_status));
-  uint32_t status_string_len = strlen(status_string);
-  connection_.copyToBuffer(status_string, status_string_len);
+    const char* status_string = CodeUtility::toString(static_cast<Code>(numeric_status));
+    uint32_t status_string_len = strlen(status_string);
+    connection_.copyToBuffer(status_string, status_string_len);
 
-  connection_.addCharToBuffer('\r');
-  connection_.addCharToBuffer('\n');
+    connection_.addCharToBuffer('\r');
+    connection_.addCharToBuffer('\n');
+  }
 
   StreamEncoderImpl::encodeHeaders(headers, end_stream);
 }
@@ -271,18 +326,26 @@ ConnectionImpl::ConnectionImpl(Network::Connection& connection, http_parser_type
   parser_.data = this;
 }
 
+void ConnectionImpl::addCurrentHeaderField() {
+  ASSERT(header_parsing_state_ == HeaderParsingState::Field);
+  toLowerTable().toLowerCase(current_header_field_.buffer(), current_header_field_.size());
+  current_header_ = current_header_map_->addViaMoveKey(std::move(current_header_field_));
+  header_parsing_state_ = HeaderParsingState::Value;
+}
+
 void ConnectionImpl::completeLastHeader() {
-  ENVOY_CONN_LOG(trace, "completed header: key={} value={}", connection_,
-                 current_header_field_.c_str(), current_header_value_.c_str());
-  if (!current_header_field_.empty()) {
-    toLowerTable().toLowerCase(current_header_field_.buffer(), current_header_field_.size());
-    current_header_map_->addViaMove(std::move(current_header_field_),
-                                    std::move(current_header_value_));
+  if (header_parsing_state_ == HeaderParsingState::Field && !current_header_field_.empty()) {
+    addCurrentHeaderField();
+  }
+
+  if (current_header_) {
+    ENVOY_CONN_LOG(trace, "completed header: key={} value={}", connection_,
+                   current_header_->key().c_str(), current_header_->value().c_str());
+    current_header_ = nullptr;
   }
 
   header_parsing_state_ = HeaderParsingState::Field;
   ASSERT(current_header_field_.empty());
-  ASSERT(current_header_value_.empty());
 }
 
 void ConnectionImpl::dispatch(Buffer::Instance& data) {
@@ -337,8 +400,13 @@ void ConnectionImpl::onHeaderValue(const char* data, size_t length) {
     return;
   }
 
-  header_parsing_state_ = HeaderParsingState::Value;
-  current_header_value_.append(data, length);
+  if (header_parsing_state_ == HeaderParsingState::Field) {
+    addCurrentHeaderField();
+  }
+
+  if (current_header_) {
+    current_header_->value().append(data, length);
+  }
 }
 
 int ConnectionImpl::onHeadersCompleteBase() {
@@ -374,8 +442,30 @@ ServerConnectionImpl::ServerConnectionImpl(Network::Connection& connection,
                                            Http1Settings settings)
     : ConnectionImpl(connection, HTTP_REQUEST), callbacks_(callbacks), codec_settings_(settings) {}
 
+void ServerConnectionImpl::dispatch(Buffer::Instance& data) {
+  // Responses that are encoded while requests are decoded, as with pipelined requests that are
+  // answered locally, are collected and written to the connection once per dispatch.
+  defer_output_ = true;
+  try {
+    ConnectionImpl::dispatch(data);
+  } catch (const CodecProtocolException&) {
+    defer_output_ = false;
+    flushOutput();
+    throw;
+  }
+
+  defer_output_ = false;
+  if (wantsToWrite()) {
+    flushOutput();
+  }
+}
+
 void ServerConnectionImpl::onEncodeComplete() {
   ASSERT(active_request_);
+  if (active_request_->response_encoder_.closeConnection()) {
+    close_after_response_ = true;
+  }
+
   if (active_request_->remote_complete_) {
     // Only do this if remote is complete. If we are replying before the request is complete the
     // only logical thing to do is for higher level code to reset() / close the connection so we
@@ -480,8 +570,9 @@ int ServerConnectionImpl::onHeadersComplete(HeaderMapImplPtr&& headers) {
     if (headers->Expect() &&
         0 == StringUtil::caseInsensitiveCompare(headers->Expect()->value().c_str(),
                                                 Headers::get().ExpectValues._100Continue.c_str())) {
-      Buffer::OwnedImpl continue_response("HTTP/1.1 100 Continue\r\n\r\n");
-      connection_.write(continue_response);
+      // Written through the output buffer so that it follows any responses that are deferred.
+      buffer().add(CONTINUE_RESPONSE, sizeof(CONTINUE_RESPONSE) - 1);
+      flushOutput();
       headers->removeExpect();
     }
 
@@ -547,10 +638,20 @@ void ServerConnectionImpl::onMessageComplete() {
     }
   }
 
-  // Always pause the parser so that the calling code can process 1 request at a time and apply
-  // back pressure. However this means that the calling code needs to detect if there is more data
-  // in the buffer and dispatch it again.
-  http_parser_pause(&parser_, 1);
+  // If the response has already been encoded, keep decoding any pipelined requests that are
+  // buffered behind this one. Otherwise pause the parser so that the calling code can process 1
+  // request at a time and apply back pressure. However this means that the calling code needs to
+  // detect if there is more data in the buffer and dispatch it again.
+  if (active_request_ || resetStreamCalled() || close_after_response_ ||
+      connection_.state() != Network::Connection::State::Open ||
+      connection_.aboveHighWatermark() || outputAboveLimit()) {
+    http_parser_pause(&parser_, 1);
+  }
+}
+
+bool ServerConnectionImpl::outputAboveLimit() {
+  const uint32_t limit = bufferLimit();
+  return limit > 0 && buffer().length() >= limit;
 }
 
 void ServerConnectionImpl::onResetStream(StreamResetReason reason) {
@@ -569,7 +670,9 @@ void ServerConnectionImpl::sendProtocolError() {
         fmt::format("HTTP/1.1 {} {}\r\ncontent-length: 0\r\nconnection: close\r\n\r\n",
                     std::to_string(enumToInt(error_code_)), CodeUtility::toString(error_code_)));
 
-    connection_.write(bad_request_response);
+    // Follows any responses that are deferred, once dispatch() unwinds.
+    buffer().move(bad_request_response);
+    flushOutput();
   }
 }
 
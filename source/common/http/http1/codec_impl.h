@@ -63,6 +63,14 @@ private:
    */
   void encodeHeader(const char* key, uint32_t key_size, const char* value, uint32_t value_size);
 
+  /**
+   * Format the header line of an HTTP/1.1 chunk.
+   * @param length supplies the chunk length.
+   * @param out supplies the output buffer, which must hold at least 18 bytes.
+   * @return the number of bytes written.
+   */
+  static uint32_t formatChunkHeader(uint64_t length, char* out);
+
   /**
    * Called to finalize a stream encode.
    */
@@ -80,11 +88,26 @@ public:
 
   bool startedResponse() { return started_response_; }
 
+  /**
+   * @return whether the response headers asked for the connection to be closed.
+   */
+  bool closeConnection() { return close_connection_; }
+
   // Http::StreamEncoder
   void encodeHeaders(const HeaderMap& headers, bool end_stream) override;
 
 private:
+  static const uint64_t MinCachedStatus = 100;
+  static const uint64_t MaxCachedStatus = 599;
+
+  /**
+   * @return the complete status line, such as "HTTP/1.1 200 OK\r\n", for a status code, or
+   *         nullptr if the code is outside of the range of codes that have one precomputed.
+   */
+  static const std::string* statusLine(uint64_t numeric_status);
+
   bool started_response_{};
+  bool close_connection_{};
 };
 
 /**
@@ -126,7 +149,8 @@ public:
   void onResetStreamBase(StreamResetReason reason);
 
   /**
-   * Flush all pending output from encoding.
+   * Flush all pending output from encoding. While output is deferred it is only committed to the
+   * output buffer, and is written when the deferral ends.
    */
   void flushOutput();
 
@@ -142,7 +166,7 @@ public:
   void goAway() override {} // Called during connection manager drain flow
   Protocol protocol() override { return protocol_; }
   void shutdownNotice() override {} // Called during connection manager drain flow
-  bool wantsToWrite() override { return false; }
+  bool wantsToWrite() override { return output_buffer_.length() > 0; }
   void onUnderlyingConnectionAboveWriteBufferHighWatermark() override { onAboveHighWatermark(); }
   void onUnderlyingConnectionBelowWriteBufferLowWatermark() override { onBelowLowWatermark(); }
 
@@ -158,10 +182,18 @@ protected:
   http_parser parser_;
   HeaderMapPtr deferred_end_stream_headers_;
   Http::Code error_code_{Http::Code::BadRequest};
+  // Set while output is collected rather than written to the connection.
+  bool defer_output_{};
 
 private:
   enum class HeaderParsingState { Field, Value, Done };
 
+  /**
+   * Called once the field name of the in progress header is complete. Adds the header to the map
+   * so that its value can be decoded in place.
+   */
+  void addCurrentHeaderField();
+
   /**
    * Called in order to complete an in progress header decode.
    */
@@ -250,7 +282,8 @@ private:
   HeaderMapImplPtr current_header_map_;
   HeaderParsingState header_parsing_state_{HeaderParsingState::Field};
   HeaderString current_header_field_;
-  HeaderString current_header_value_;
+  // The header whose value is being decoded, or nullptr if the value is being dropped.
+  HeaderEntry* current_header_{};
   bool reset_stream_called_{};
   Buffer::WatermarkBuffer output_buffer_;
   Buffer::RawSlice reserved_iovec_;
@@ -266,6 +299,9 @@ public:
   ServerConnectionImpl(Network::Connection& connection, ServerConnectionCallbacks& callbacks,
                        Http1Settings settings);
 
+  // Http::Connection
+  void dispatch(Buffer::Instance& data) override;
+
 private:
   /**
    * An active HTTP/1.1 request.
@@ -289,6 +325,11 @@ private:
    */
   void handlePath(HeaderMapImpl& headers, unsigned int method);
 
+  /**
+   * @return whether the deferred output has reached the connection's buffer limit.
+   */
+  bool outputAboveLimit();
+
   // ConnectionImpl
   void onEncodeComplete() override;
   void onMessageBegin() override;
@@ -304,6 +345,9 @@ private:
   ServerConnectionCallbacks& callbacks_;
   std::unique_ptr<ActiveRequest> active_request_;
   Http1Settings codec_settings_;
+  // Whether an encoded response asked for the connection to be closed, after which no further
+  // pipelined requests are decoded.
+  bool close_after_response_{};
 };
 
 /**
@@ -315,6 +359,7 @@ public:
 
   // Http::ClientConnection
   StreamEncoder& newStream(StreamDecoder& response_decoder) override;
+  uint64_t maxConcurrentStreams() override { return 1; }
 
 private:
   struct PendingResponse {
@@ -1,5 +1,6 @@
 #include "common/http/http1/conn_pool.h"
 
+#include <chrono>
 #include <cstdint>
 #include <list>
 
@@ -70,9 +71,15 @@ void ConnPoolImpl::createNewConnection() {
 ConnectionPool::Cancellable* ConnPoolImpl::newStream(StreamDecoder& response_decoder,
                                                      ConnectionPool::Callbacks& callbacks) {
   if (!ready_clients_.empty()) {
+    // Idle clients are pushed onto the front of the ready list, so this reuses the most recently
+    // used connection. That keeps the others idle, so that they can time out after load drops.
     ready_clients_.front()->moveBetweenLists(ready_clients_, busy_clients_);
+    if (busy_clients_.front()->idle_timer_) {
+      busy_clients_.front()->idle_timer_->disableTimer();
+    }
     ENVOY_CONN_LOG(debug, "using existing connection", *busy_clients_.front()->codec_client_);
     attachRequestToClient(*busy_clients_.front(), response_decoder, callbacks);
+    preconnect();
     return nullptr;
   }
 
@@ -91,6 +98,7 @@ ConnectionPool::Cancellable* ConnPoolImpl::newStream(StreamDecoder& response_dec
     ENVOY_LOG(debug, "queueing request due to no available connections");
     PendingRequestPtr pending_request(new PendingRequest(*this, response_decoder, callbacks));
     pending_request->moveIntoList(std::move(pending_request), pending_requests_);
+    preconnect();
     return pending_requests_.front().get();
   } else {
     ENVOY_LOG(debug, "max pending requests overflow");
@@ -205,12 +213,41 @@ void ConnPoolImpl::onResponseComplete(ActiveClient& client) {
   }
 }
 
+void ConnPoolImpl::preconnect() {
+  const uint64_t percent = host_->cluster().preconnectPercent();
+  if (percent == 0) {
+    return;
+  }
+
+  // Keep a connection for every active or pending request, plus the configured share of spare
+  // connections. Spare connections land in the ready list once they connect. This is only done
+  // when a stream is requested, so that closing connections never opens new ones.
+  const uint64_t load = num_active_requests_ + pending_requests_.size();
+  const uint64_t wanted = load + (load * percent + 99) / 100;
+  while (ready_clients_.size() + busy_clients_.size() < wanted &&
+         host_->cluster().resourceManager(priority_).connections().canCreate()) {
+    ENVOY_LOG(debug, "preconnecting");
+    host_->cluster().stats().upstream_cx_preconnect_total_.inc();
+    createNewConnection();
+  }
+}
+
 void ConnPoolImpl::processIdleClient(ActiveClient& client) {
   client.stream_wrapper_.reset();
   if (pending_requests_.empty()) {
     // There is nothing to service so just move the connection into the ready list.
     ENVOY_CONN_LOG(debug, "moving to ready", *client.codec_client_);
     client.moveBetweenLists(busy_clients_, ready_clients_);
+
+    const std::chrono::milliseconds idle_timeout = host_->cluster().idleTimeout();
+    if (idle_timeout.count() > 0) {
+      if (!client.idle_timer_) {
+        client.idle_timer_ = dispatcher_.createCoarseTimer([&client]() -> void {
+          client.onIdleTimeout();
+        });
+      }
+      client.idle_timer_->enableTimer(idle_timeout);
+    }
   } else {
     // There is work to do so bind a request to the client and move it to the busy list. Pending
     // requests are pushed onto the front, so pull from the back.
@@ -232,11 +269,13 @@ ConnPoolImpl::StreamWrapper::StreamWrapper(StreamDecoder& response_decoder, Acti
   parent_.parent_.host_->cluster().stats().upstream_rq_active_.inc();
   parent_.parent_.host_->stats().rq_total_.inc();
   parent_.parent_.host_->stats().rq_active_.inc();
+  parent_.parent_.num_active_requests_++;
 }
 
 ConnPoolImpl::StreamWrapper::~StreamWrapper() {
   parent_.parent_.host_->cluster().stats().upstream_rq_active_.dec();
   parent_.parent_.host_->stats().rq_active_.dec();
+  parent_.parent_.num_active_requests_--;
 }
 
 void ConnPoolImpl::StreamWrapper::onEncodeComplete() { encode_complete_ = true; }
@@ -296,7 +335,7 @@ ConnPoolImpl::ActiveClient::ActiveClient(ConnPoolImpl& parent)
        parent_.host_->cluster().stats().upstream_cx_rx_bytes_buffered_,
        parent_.host_->cluster().stats().upstream_cx_tx_bytes_total_,
        parent_.host_->cluster().stats().upstream_cx_tx_bytes_buffered_,
-       &parent_.host_->cluster().stats().bind_errors_});
+       &parent_.host_->cluster().stats().bind_errors_, nullptr, nullptr, nullptr});
 }
 
 ConnPoolImpl::ActiveClient::~ActiveClient() {
@@ -314,6 +353,12 @@ void ConnPoolImpl::ActiveClient::onConnectTimeout() {
   codec_client_->close();
 }
 
+void ConnPoolImpl::ActiveClient::onIdleTimeout() {
+  ENVOY_CONN_LOG(debug, "idle timeout", *codec_client_);
+  parent_.host_->cluster().stats().upstream_cx_idle_timeout_.inc();
+  codec_client_->close();
+}
+
 CodecClientPtr ConnPoolImplProd::createCodecClient(Upstream::Host::CreateConnectionData& data) {
   CodecClientPtr codec{new CodecClientProd(CodecClient::Type::HTTP1, std::move(data.connection_),
                                            data.host_description_)};
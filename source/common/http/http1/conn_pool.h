@@ -15,6 +15,7 @@
 #include "common/common/linked_object.h"
 #include "common/http/codec_client.h"
 #include "common/http/codec_wrappers.h"
+#include "common/memory/accounting.h"
 
 namespace Envoy {
 namespace Http {
@@ -78,6 +79,7 @@ protected:
     ~ActiveClient();
 
     void onConnectTimeout();
+    void onIdleTimeout();
 
     // Network::ConnectionCallbacks
     void onEvent(Network::ConnectionEvent event) override {
@@ -91,8 +93,12 @@ protected:
     Upstream::HostDescriptionConstSharedPtr real_host_description_;
     StreamWrapperPtr stream_wrapper_;
     Event::TimerPtr connect_timer_;
+    // Created the first time the client becomes idle, and only if the cluster has an idle timeout.
+    Event::TimerPtr idle_timer_;
     Stats::TimespanPtr conn_length_;
     uint64_t remaining_requests_;
+    const Memory::AccountedBytes accounted_{Memory::Category::ConnectionPools,
+                                            sizeof(ActiveClient)};
   };
 
   typedef std::unique_ptr<ActiveClient> ActiveClientPtr;
@@ -121,6 +127,7 @@ protected:
   void onDownstreamReset(ActiveClient& client);
   void onPendingRequestCancel(PendingRequest& request);
   void onResponseComplete(ActiveClient& client);
+  void preconnect();
   void processIdleClient(ActiveClient& client);
 
   Stats::TimespanPtr conn_connect_ms_;
@@ -131,6 +138,7 @@ protected:
   std::list<PendingRequestPtr> pending_requests_;
   std::list<DrainedCb> drained_callbacks_;
   Upstream::ResourcePriority priority_;
+  uint64_t num_active_requests_{};
 };
 
 /**
@@ -1,6 +1,8 @@
 #include "common/http/http2/codec_impl.h"
 
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <memory>
 #include <vector>
 
@@ -42,10 +44,11 @@ ConnectionImpl::Http2Options ConnectionImpl::http2_options_;
 const std::unique_ptr<const Http::HeaderMap> ConnectionImpl::CONTINUE_HEADER{
     new Http::HeaderMapImpl{
         {Http::Headers::get().Status, std::to_string(enumToInt(Code::Continue))}}};
+const uint8_t ConnectionImpl::BDP_PING_DATA[8] = {'e', 'n', 'v', 'o', 'y', 'b', 'd', 'p'};
 
 /**
  * Helper to remove const during a cast. nghttp2 takes non-const pointers for headers even though
- * it copies them.
+ * it never modifies them.
  */
 template <typename T> static T* remove_const(const void* object) {
   return const_cast<T*>(reinterpret_cast<const T*>(object));
@@ -62,12 +65,13 @@ ConnectionImpl::StreamImpl::StreamImpl(ConnectionImpl& parent, uint32_t buffer_l
   }
 }
 
-static void insertHeader(std::vector<nghttp2_nv>& headers, const HeaderEntry& header) {
+static void insertHeader(std::vector<nghttp2_nv>& headers, const HeaderEntry& header,
+                         bool no_copy) {
   uint8_t flags = 0;
-  if (header.key().type() == HeaderString::Type::Reference) {
+  if (no_copy || header.key().type() == HeaderString::Type::Reference) {
     flags |= NGHTTP2_NV_FLAG_NO_COPY_NAME;
   }
-  if (header.value().type() == HeaderString::Type::Reference) {
+  if (no_copy || header.value().type() == HeaderString::Type::Reference) {
     flags |= NGHTTP2_NV_FLAG_NO_COPY_VALUE;
   }
   headers.push_back({remove_const<uint8_t>(header.key().c_str()),
@@ -76,34 +80,36 @@ static void insertHeader(std::vector<nghttp2_nv>& headers, const HeaderEntry& he
 }
 
 void ConnectionImpl::StreamImpl::buildHeaders(std::vector<nghttp2_nv>& final_headers,
-                                              const HeaderMap& headers) {
+                                              const HeaderMap& headers, bool no_copy) {
   // nghttp2 requires that all ':' headers come before all other headers. To avoid making higher
   // layers understand that we do two passes here to build the final header list to encode.
+  final_headers.clear();
   final_headers.reserve(headers.size());
+  std::pair<std::vector<nghttp2_nv>*, bool> context{&final_headers, no_copy};
   headers.iterate(
       [](const HeaderEntry& header, void* context) -> HeaderMap::Iterate {
-        std::vector<nghttp2_nv>* final_headers = static_cast<std::vector<nghttp2_nv>*>(context);
+        auto* build_context = static_cast<std::pair<std::vector<nghttp2_nv>*, bool>*>(context);
         if (header.key().c_str()[0] == ':') {
-          insertHeader(*final_headers, header);
+          insertHeader(*build_context->first, header, build_context->second);
         }
         return HeaderMap::Iterate::Continue;
       },
-      &final_headers);
+      &context);
 
   headers.iterate(
       [](const HeaderEntry& header, void* context) -> HeaderMap::Iterate {
-        std::vector<nghttp2_nv>* final_headers = static_cast<std::vector<nghttp2_nv>*>(context);
+        auto* build_context = static_cast<std::pair<std::vector<nghttp2_nv>*, bool>*>(context);
         if (header.key().c_str()[0] != ':') {
-          insertHeader(*final_headers, header);
+          insertHeader(*build_context->first, header, build_context->second);
         }
         return HeaderMap::Iterate::Continue;
       },
-      &final_headers);
+      &context);
 }
 
 void ConnectionImpl::StreamImpl::encodeHeaders(const HeaderMap& headers, bool end_stream) {
-  std::vector<nghttp2_nv> final_headers;
-  buildHeaders(final_headers, headers);
+  std::vector<nghttp2_nv>& final_headers = parent_.final_headers_;
+  buildHeaders(final_headers, headers, headersSentOnSubmit());
 
   nghttp2_data_provider provider;
   if (!end_stream) {
@@ -129,7 +135,7 @@ void ConnectionImpl::StreamImpl::encodeTrailers(const HeaderMap& trailers) {
     ASSERT(!pending_trailers_);
     pending_trailers_.reset(new HeaderMapImpl(trailers));
   } else {
-    submitTrailers(trailers);
+    submitTrailers(trailers, headersSentOnSubmit());
     parent_.sendPendingFrames();
   }
 }
@@ -184,9 +190,9 @@ void ConnectionImpl::StreamImpl::saveHeader(HeaderString&& name, HeaderString&&
   }
 }
 
-void ConnectionImpl::StreamImpl::submitTrailers(const HeaderMap& trailers) {
-  std::vector<nghttp2_nv> final_headers;
-  buildHeaders(final_headers, trailers);
+void ConnectionImpl::StreamImpl::submitTrailers(const HeaderMap& trailers, bool no_copy) {
+  std::vector<nghttp2_nv>& final_headers = parent_.final_headers_;
+  buildHeaders(final_headers, trailers, no_copy);
   int rc =
       nghttp2_submit_trailer(parent_.session_, stream_id_, &final_headers[0], final_headers.size());
   ASSERT(rc == 0);
@@ -204,8 +210,10 @@ ssize_t ConnectionImpl::StreamImpl::onDataSourceRead(uint64_t length, uint32_t*
       *data_flags |= NGHTTP2_DATA_FLAG_EOF;
       if (pending_trailers_) {
         // We need to tell the library to not set end stream so that we can emit the trailers.
+        // The trailers are released right away but only serialized later, so nghttp2 must copy
+        // them.
         *data_flags |= NGHTTP2_DATA_FLAG_NO_END_STREAM;
-        submitTrailers(*pending_trailers_);
+        submitTrailers(*pending_trailers_, false);
         pending_trailers_.reset();
       }
     }
@@ -220,9 +228,8 @@ int ConnectionImpl::StreamImpl::onDataSourceSend(const uint8_t* framehd, size_t
   // https://nghttp2.org/documentation/types.html#c.nghttp2_send_data_callback
   static const uint64_t FRAME_HEADER_SIZE = 9;
 
-  Buffer::OwnedImpl output(framehd, FRAME_HEADER_SIZE);
-  output.move(pending_send_data_, length);
-  parent_.connection_.write(output);
+  parent_.send_buffer_.add(framehd, FRAME_HEADER_SIZE);
+  parent_.send_buffer_.move(pending_send_data_, length);
   return 0;
 }
 
@@ -234,6 +241,12 @@ void ConnectionImpl::ClientStreamImpl::submitHeaders(const std::vector<nghttp2_n
   ASSERT(stream_id_ > 0);
 }
 
+bool ConnectionImpl::ServerStreamImpl::headersSentOnSubmit() {
+  // Response and trailer HEADERS frames are not subject to stream concurrency limits, so they are
+  // serialized by the sendPendingFrames() that follows the submit, unless sending is deferred.
+  return parent_.canSendPendingFrames();
+}
+
 void ConnectionImpl::ServerStreamImpl::submitHeaders(const std::vector<nghttp2_nv>& final_headers,
                                                      nghttp2_data_provider* provider) {
   ASSERT(stream_id_ != -1);
@@ -329,9 +342,70 @@ int ConnectionImpl::onData(int32_t stream_id, const uint8_t* data, size_t len) {
   } else {
     stream->unconsumed_bytes_ += len;
   }
+
+  if (window_auto_tuning_) {
+    onBdpData(len);
+  }
   return 0;
 }
 
+void ConnectionImpl::onBdpData(size_t length) {
+  if (bdp_ping_outstanding_) {
+    bdp_bytes_ += length;
+    return;
+  }
+
+  if (local_stream_window_ >= Http2Settings::MAX_AUTO_TUNED_WINDOW_SIZE) {
+    return;
+  }
+
+  // Start a new sample. The DATA received until the peer acknowledges the PING is what the
+  // connection carries in one round trip.
+  int rc = nghttp2_submit_ping(session_, NGHTTP2_FLAG_NONE, BDP_PING_DATA);
+  ASSERT(rc == 0);
+  UNREFERENCED_PARAMETER(rc);
+  bdp_ping_outstanding_ = true;
+  bdp_bytes_ = 0;
+}
+
+void ConnectionImpl::onBdpPingAck() {
+  bdp_ping_outstanding_ = false;
+
+  // Once a round trip's worth of data comes close to the window, the window rather than the link
+  // limits the throughput of a stream.
+  if (bdp_bytes_ * 3 < static_cast<uint64_t>(local_stream_window_) * 2) {
+    return;
+  }
+
+  const uint32_t window = static_cast<uint32_t>(std::min<uint64_t>(
+      bdp_bytes_ * 2, static_cast<uint64_t>(Http2Settings::MAX_AUTO_TUNED_WINDOW_SIZE)));
+  if (window <= local_stream_window_) {
+    return;
+  }
+
+  ENVOY_CONN_LOG(debug, "growing receive window from {} to {}, {} bytes per round trip",
+                 connection_, local_stream_window_, window, bdp_bytes_);
+  stats_.window_auto_tuned_.inc();
+  local_stream_window_ = window;
+  nghttp2_settings_entry iv = {NGHTTP2_SETTINGS_INITIAL_WINDOW_SIZE, window};
+  int rc = nghttp2_submit_settings(session_, NGHTTP2_FLAG_NONE, &iv, 1);
+  ASSERT(rc == 0);
+
+  if (local_connection_window_ < window) {
+    rc = nghttp2_session_set_local_window_size(session_, NGHTTP2_FLAG_NONE, 0, window);
+    ASSERT(rc == 0);
+    local_connection_window_ = window;
+  }
+  UNREFERENCED_PARAMETER(rc);
+
+  // The receive buffers stay as large as the window, so that the watermarks stop window updates
+  // at the same point as before.
+  per_stream_buffer_limit_ = window;
+  for (StreamImplPtr& stream : active_streams_) {
+    stream->pending_recv_data_.setWatermarks(window / 2, window);
+  }
+}
+
 void ConnectionImpl::goAway() {
   int rc = nghttp2_submit_goaway(session_, NGHTTP2_FLAG_NONE,
                                  nghttp2_session_get_last_proc_stream_id(session_),
@@ -355,6 +429,13 @@ int ConnectionImpl::onFrameReceived(const nghttp2_frame* frame) {
 
   // Only raise GOAWAY once, since we don't currently expose stream information. Shutdown
   // notifications are the same as a normal GOAWAY.
+  if (frame->hd.type == NGHTTP2_PING && (frame->hd.flags & NGHTTP2_FLAG_ACK) &&
+      bdp_ping_outstanding_ &&
+      0 == memcmp(frame->ping.opaque_data, BDP_PING_DATA, sizeof(BDP_PING_DATA))) {
+    onBdpPingAck();
+    return 0;
+  }
+
   if (frame->hd.type == NGHTTP2_GOAWAY && !raised_goaway_) {
     ASSERT(frame->hd.stream_id == 0);
     raised_goaway_ = true;
@@ -380,8 +461,9 @@ int ConnectionImpl::onFrameReceived(const nghttp2_frame* frame) {
                                                 Headers::get().ExpectValues._100Continue.c_str())) {
       // Deal with expect: 100-continue here since higher layers are never going to do anything
       // other than say to continue so that we can respond before request complete if necessary.
-      std::vector<nghttp2_nv> final_headers;
-      StreamImpl::buildHeaders(final_headers, *CONTINUE_HEADER);
+      // CONTINUE_HEADER is static, so nghttp2 never needs to copy it.
+      std::vector<nghttp2_nv>& final_headers = final_headers_;
+      StreamImpl::buildHeaders(final_headers, *CONTINUE_HEADER, true);
       int rc = nghttp2_submit_headers(session_, 0, stream->stream_id_, nullptr, &final_headers[0],
                                       final_headers.size(), nullptr);
       ASSERT(rc == 0);
@@ -505,8 +587,7 @@ int ConnectionImpl::onInvalidFrame(int error_code) {
 
 ssize_t ConnectionImpl::onSend(const uint8_t* data, size_t length) {
   ENVOY_CONN_LOG(trace, "send data: bytes={}", connection_, length);
-  Buffer::OwnedImpl buffer(data, length);
-  connection_.write(buffer);
+  send_buffer_.add(data, length);
   return length;
 }
 
@@ -558,12 +639,23 @@ int ConnectionImpl::saveHeader(const nghttp2_frame* frame, HeaderString&& name,
   }
 }
 
+bool ConnectionImpl::canSendPendingFrames() const {
+  return !dispatching_ && connection_.state() != Network::Connection::State::Closed;
+}
+
 void ConnectionImpl::sendPendingFrames() {
-  if (dispatching_ || connection_.state() == Network::Connection::State::Closed) {
+  if (!canSendPendingFrames()) {
     return;
   }
 
+  // Frames are collected in send_buffer_ and written to the connection together, rather than with
+  // one write per frame.
   int rc = nghttp2_session_send(session_);
+  if (send_buffer_.length() > 0) {
+    connection_.write(send_buffer_);
+    ASSERT(send_buffer_.length() == 0);
+  }
+
   if (rc != 0) {
     ASSERT(rc == NGHTTP2_ERR_CALLBACK_FAILURE);
     throw CodecProtocolException(fmt::format("{}", nghttp2_strerror(rc)));
@@ -764,6 +856,10 @@ Http::StreamEncoder& ClientConnectionImpl::newStream(StreamDecoder& decoder) {
   return *active_streams_.front();
 }
 
+uint64_t ClientConnectionImpl::maxConcurrentStreams() {
+  return nghttp2_session_get_remote_settings(session_, NGHTTP2_SETTINGS_MAX_CONCURRENT_STREAMS);
+}
+
 int ClientConnectionImpl::onBeginHeaders(const nghttp2_frame* frame) {
   // The client code explicitly does not currently suport push promise.
   RELEASE_ASSERT(frame->hd.type == NGHTTP2_HEADERS);
@@ -41,7 +41,8 @@ const std::string CLIENT_MAGIC_PREFIX = "PRI * HTTP/2";
   COUNTER(tx_reset)                                                                                \
   COUNTER(header_overflow)                                                                         \
   COUNTER(trailers)                                                                                \
-  COUNTER(headers_cb_no_stream)
+  COUNTER(headers_cb_no_stream)                                                                    \
+  COUNTER(window_auto_tuned)
 // clang-format on
 
 /**
@@ -73,8 +74,11 @@ public:
                  const Http2Settings& http2_settings)
       : stats_{ALL_HTTP2_CODEC_STATS(POOL_COUNTER_PREFIX(stats, "http2."))},
         connection_(connection),
-        per_stream_buffer_limit_(http2_settings.initial_stream_window_size_), dispatching_(false),
-        raised_goaway_(false), pending_deferred_reset_(false) {}
+        per_stream_buffer_limit_(http2_settings.initial_stream_window_size_),
+        local_stream_window_(http2_settings.initial_stream_window_size_),
+        local_connection_window_(http2_settings.initial_connection_window_size_),
+        dispatching_(false), raised_goaway_(false), pending_deferred_reset_(false),
+        window_auto_tuning_(http2_settings.window_auto_tuning_), bdp_ping_outstanding_(false) {}
 
   ~ConnectionImpl();
 
@@ -140,11 +144,25 @@ protected:
     ssize_t onDataSourceRead(uint64_t length, uint32_t* data_flags);
     int onDataSourceSend(const uint8_t* framehd, size_t length);
     void resetStreamWorker(StreamResetReason reason);
-    static void buildHeaders(std::vector<nghttp2_nv>& final_headers, const HeaderMap& headers);
+    /**
+     * Build the nghttp2 header list for a header map.
+     * @param final_headers supplies the list to fill in. Any previous contents are discarded.
+     * @param headers supplies the headers to encode.
+     * @param no_copy supplies whether nghttp2 can reference all header strings rather than copy
+     *        them. This is only safe when the frame is serialized before the map can change.
+     *        Reference strings are never copied.
+     */
+    static void buildHeaders(std::vector<nghttp2_nv>& final_headers, const HeaderMap& headers,
+                             bool no_copy);
     void saveHeader(HeaderString&& name, HeaderString&& value);
     virtual void submitHeaders(const std::vector<nghttp2_nv>& final_headers,
                                nghttp2_data_provider* provider) PURE;
-    void submitTrailers(const HeaderMap& trailers);
+    /**
+     * @return whether a HEADERS frame submitted now is sure to be serialized by the
+     *         sendPendingFrames() call that follows the submit.
+     */
+    virtual bool headersSentOnSubmit() PURE;
+    void submitTrailers(const HeaderMap& trailers, bool no_copy);
 
     // Http::StreamEncoder
     void encodeHeaders(const HeaderMap& headers, bool end_stream) override;
@@ -214,6 +232,8 @@ protected:
     // StreamImpl
     void submitHeaders(const std::vector<nghttp2_nv>& final_headers,
                        nghttp2_data_provider* provider) override;
+    // Requests can be queued by nghttp2 until the peer allows more concurrent streams.
+    bool headersSentOnSubmit() override { return false; }
   };
 
   /**
@@ -225,11 +245,13 @@ protected:
     // StreamImpl
     void submitHeaders(const std::vector<nghttp2_nv>& final_headers,
                        nghttp2_data_provider* provider) override;
+    bool headersSentOnSubmit() override;
   };
 
   ConnectionImpl* base() { return this; }
   StreamImpl* getStream(int32_t stream_id);
   int saveHeader(const nghttp2_frame* frame, HeaderString&& name, HeaderString&& value);
+  bool canSendPendingFrames() const;
   void sendPendingFrames();
   void sendSettings(const Http2Settings& http2_settings, bool disable_push);
 
@@ -241,6 +263,12 @@ protected:
   CodecStats stats_;
   Network::Connection& connection_;
   uint32_t per_stream_buffer_limit_;
+  // Scratch header list reused for every submitted header block. nghttp2 copies the list itself
+  // when a block is submitted, so it is only used between building and submitting.
+  std::vector<nghttp2_nv> final_headers_;
+  // Serialized frames that have not been written to the connection yet. DATA payloads are moved in
+  // from the stream send buffers without copying.
+  Buffer::OwnedImpl send_buffer_;
 
 private:
   virtual ConnectionCallbacks& callbacks() PURE;
@@ -252,12 +280,23 @@ private:
   int onInvalidFrame(int error_code);
   ssize_t onSend(const uint8_t* data, size_t length);
   int onStreamClose(int32_t stream_id, uint32_t error_code);
+  void onBdpData(size_t length);
+  void onBdpPingAck();
 
   static const std::unique_ptr<const Http::HeaderMap> CONTINUE_HEADER;
+  // Opaque data of the PING frames used to measure the bandwidth-delay product.
+  static const uint8_t BDP_PING_DATA[8];
+
+  uint32_t local_stream_window_;
+  uint32_t local_connection_window_;
+  // DATA payload received since the outstanding BDP PING was sent.
+  uint64_t bdp_bytes_{};
 
   bool dispatching_ : 1;
   bool raised_goaway_ : 1;
   bool pending_deferred_reset_ : 1;
+  const bool window_auto_tuning_ : 1;
+  bool bdp_ping_outstanding_ : 1;
 };
 
 /**
@@ -270,6 +309,7 @@ public:
 
   // Http::ClientConnection
   Http::StreamEncoder& newStream(StreamDecoder& response_decoder) override;
+  uint64_t maxConcurrentStreams() override;
 
 private:
   // ConnectionImpl
@@ -1,5 +1,6 @@
 #include "common/http/http2/conn_pool.h"
 
+#include <chrono>
 #include <cstdint>
 
 #include "envoy/event/dispatcher.h"
@@ -26,12 +27,12 @@ ConnPoolImpl::~ConnPoolImpl() {
 }
 
 void ConnPoolImpl::ConnPoolImpl::closeConnections() {
-  if (primary_client_) {
-    primary_client_->client_->close();
+  while (!ready_clients_.empty()) {
+    ready_clients_.front()->client_->close();
   }
 
-  if (draining_client_) {
-    draining_client_->client_->close();
+  while (!draining_clients_.empty()) {
+    draining_clients_.front()->client_->close();
   }
 }
 
@@ -46,17 +47,19 @@ void ConnPoolImpl::checkForDrained() {
   }
 
   bool drained = true;
-  if (primary_client_) {
-    if (primary_client_->client_->numActiveRequests() == 0) {
-      primary_client_->client_->close();
-      ASSERT(!primary_client_);
+  for (auto it = ready_clients_.begin(); it != ready_clients_.end();) {
+    // Closing the client removes it from the list.
+    ActiveClient& client = **it++;
+    if (client.client_->numActiveRequests() == 0) {
+      client.client_->close();
     } else {
       drained = false;
     }
   }
 
-  ASSERT(!draining_client_ || (draining_client_->client_->numActiveRequests() > 0));
-  if (draining_client_ && draining_client_->client_->numActiveRequests() > 0) {
+  for (const ActiveClientPtr& client : draining_clients_) {
+    ASSERT(client->client_->numActiveRequests() > 0);
+    UNREFERENCED_PARAMETER(client);
     drained = false;
   }
 
@@ -68,6 +71,39 @@ void ConnPoolImpl::checkForDrained() {
   }
 }
 
+ConnPoolImpl::ActiveClient* ConnPoolImpl::pickClient() {
+  // Use the least loaded client that is below its concurrent stream limit.
+  ActiveClient* picked = nullptr;
+  for (const ActiveClientPtr& client : ready_clients_) {
+    const uint64_t active_requests = client->client_->numActiveRequests();
+    if (active_requests < client->client_->maxConcurrentRequests() &&
+        (picked == nullptr || active_requests < picked->client_->numActiveRequests())) {
+      picked = client.get();
+    }
+  }
+
+  if (picked != nullptr || ready_clients_.empty()) {
+    return picked;
+  }
+
+  // All of the clients are at their limit, so open another one if the circuit breaker allows.
+  // Otherwise use the least loaded client, which queues the stream until the peer allows more.
+  if (host_->cluster().resourceManager(priority_).connections().canCreate()) {
+    host_->cluster().stats().upstream_cx_http2_stream_limit_total_.inc();
+    return nullptr;
+  }
+
+  host_->cluster().stats().upstream_cx_overflow_.inc();
+  for (const ActiveClientPtr& client : ready_clients_) {
+    if (picked == nullptr ||
+        client->client_->numActiveRequests() < picked->client_->numActiveRequests()) {
+      picked = client.get();
+    }
+  }
+
+  return picked;
+}
+
 ConnectionPool::Cancellable* ConnPoolImpl::newStream(Http::StreamDecoder& response_decoder,
                                                      ConnectionPool::Callbacks& callbacks) {
   ASSERT(drained_callbacks_.empty());
@@ -78,12 +114,19 @@ ConnectionPool::Cancellable* ConnPoolImpl::newStream(Http::StreamDecoder& respon
     max_streams = maxTotalStreams();
   }
 
-  if (primary_client_ && primary_client_->total_streams_ >= max_streams) {
-    movePrimaryClientToDraining();
+  for (auto it = ready_clients_.begin(); it != ready_clients_.end();) {
+    // Draining the client removes it from the list.
+    ActiveClient& client = **it++;
+    if (client.total_streams_ >= max_streams) {
+      moveClientToDraining(client);
+    }
   }
 
-  if (!primary_client_) {
-    primary_client_.reset(new ActiveClient(*this));
+  ActiveClient* client = pickClient();
+  if (client == nullptr) {
+    ActiveClientPtr new_client(new ActiveClient(*this));
+    client = new_client.get();
+    new_client->moveIntoListBack(std::move(new_client), ready_clients_);
   }
 
   if (!host_->cluster().resourceManager(priority_).requests().canCreate()) {
@@ -91,15 +134,18 @@ ConnectionPool::Cancellable* ConnPoolImpl::newStream(Http::StreamDecoder& respon
     callbacks.onPoolFailure(ConnectionPool::PoolFailureReason::Overflow, nullptr);
     host_->cluster().stats().upstream_rq_pending_overflow_.inc();
   } else {
-    ENVOY_CONN_LOG(debug, "creating stream", *primary_client_->client_);
-    primary_client_->total_streams_++;
+    ENVOY_CONN_LOG(debug, "creating stream", *client->client_);
+    if (client->idle_timer_) {
+      client->idle_timer_->disableTimer();
+    }
+    client->total_streams_++;
     host_->stats().rq_total_.inc();
     host_->stats().rq_active_.inc();
     host_->cluster().stats().upstream_rq_total_.inc();
     host_->cluster().stats().upstream_rq_active_.inc();
     host_->cluster().resourceManager(priority_).requests().inc();
-    callbacks.onPoolReady(primary_client_->client_->newStream(response_decoder),
-                          primary_client_->real_host_description_);
+    callbacks.onPoolReady(client->client_->newStream(response_decoder),
+                          client->real_host_description_);
   }
 
   return nullptr;
@@ -118,12 +164,12 @@ void ConnPoolImpl::onConnectionEvent(ActiveClient& client, Network::ConnectionEv
       }
     }
 
-    if (&client == primary_client_.get()) {
-      ENVOY_CONN_LOG(debug, "destroying primary client", *client.client_);
-      dispatcher_.deferredDelete(std::move(primary_client_));
-    } else {
+    if (client.draining_) {
       ENVOY_CONN_LOG(debug, "destroying draining client", *client.client_);
-      dispatcher_.deferredDelete(std::move(draining_client_));
+      dispatcher_.deferredDelete(client.removeFromList(draining_clients_));
+    } else {
+      ENVOY_CONN_LOG(debug, "destroying ready client", *client.client_);
+      dispatcher_.deferredDelete(client.removeFromList(ready_clients_));
     }
 
     if (client.connect_timer_) {
@@ -146,25 +192,16 @@ void ConnPoolImpl::onConnectionEvent(ActiveClient& client, Network::ConnectionEv
   }
 }
 
-void ConnPoolImpl::movePrimaryClientToDraining() {
-  ENVOY_CONN_LOG(debug, "moving primary to draining", *primary_client_->client_);
-  if (draining_client_) {
-    // This should pretty much never happen, but is possible if we start draining and then get
-    // a goaway for example. In this case just kill the current draining connection. It's not
-    // worth keeping a list.
-    draining_client_->client_->close();
-  }
-
-  ASSERT(!draining_client_);
-  if (primary_client_->client_->numActiveRequests() == 0) {
-    // If we are making a new connection and the primary does not have any active requests just
-    // close it now.
-    primary_client_->client_->close();
+void ConnPoolImpl::moveClientToDraining(ActiveClient& client) {
+  ENVOY_CONN_LOG(debug, "moving client to draining", *client.client_);
+  ASSERT(!client.draining_);
+  if (client.client_->numActiveRequests() == 0) {
+    // If the client does not have any active requests just close it now.
+    client.client_->close();
   } else {
-    draining_client_ = std::move(primary_client_);
+    client.moveBetweenLists(ready_clients_, draining_clients_);
+    client.draining_ = true;
   }
-
-  ASSERT(!primary_client_);
 }
 
 void ConnPoolImpl::onConnectTimeout(ActiveClient& client) {
@@ -176,20 +213,37 @@ void ConnPoolImpl::onConnectTimeout(ActiveClient& client) {
 void ConnPoolImpl::onGoAway(ActiveClient& client) {
   ENVOY_CONN_LOG(debug, "remote goaway", *client.client_);
   host_->cluster().stats().upstream_cx_close_notify_.inc();
-  if (&client == primary_client_.get()) {
-    movePrimaryClientToDraining();
+  if (!client.draining_) {
+    moveClientToDraining(client);
   }
 }
 
+void ConnPoolImpl::onIdleTimeout(ActiveClient& client) {
+  ENVOY_CONN_LOG(debug, "idle timeout", *client.client_);
+  host_->cluster().stats().upstream_cx_idle_timeout_.inc();
+  client.client_->close();
+}
+
 void ConnPoolImpl::onStreamDestroy(ActiveClient& client) {
   ENVOY_CONN_LOG(debug, "destroying stream: {} remaining", *client.client_,
                  client.client_->numActiveRequests());
   host_->stats().rq_active_.dec();
   host_->cluster().stats().upstream_rq_active_.dec();
   host_->cluster().resourceManager(priority_).requests().dec();
-  if (&client == draining_client_.get() && client.client_->numActiveRequests() == 0) {
+  if (client.draining_ && client.client_->numActiveRequests() == 0) {
     // Close out the draining client if we no long have active requests.
     client.client_->close();
+  } else if (client.client_->numActiveRequests() == 0) {
+    // Most connections to low traffic hosts sit idle on every worker. Closing them shrinks the
+    // number of upstream connections, at the cost of connection setup for the next stream.
+    const std::chrono::milliseconds idle_timeout = host_->cluster().idleTimeout();
+    if (idle_timeout.count() > 0) {
+      if (!client.idle_timer_) {
+        client.idle_timer_ =
+            dispatcher_.createCoarseTimer([&client]() -> void { client.onIdleTimeout(); });
+      }
+      client.idle_timer_->enableTimer(idle_timeout);
+    }
   }
 
   // If we are destroying this stream because of a disconnect, do not check for drain here. We will
@@ -231,18 +285,21 @@ ConnPoolImpl::ActiveClient::ActiveClient(ConnPoolImpl& parent)
   parent_.host_->cluster().stats().upstream_cx_total_.inc();
   parent_.host_->cluster().stats().upstream_cx_active_.inc();
   parent_.host_->cluster().stats().upstream_cx_http2_total_.inc();
+  parent_.host_->cluster().resourceManager(parent_.priority_).connections().inc();
   conn_length_.reset(new Stats::Timespan(parent_.host_->cluster().stats().upstream_cx_length_ms_));
 
   client_->setConnectionStats({parent_.host_->cluster().stats().upstream_cx_rx_bytes_total_,
                                parent_.host_->cluster().stats().upstream_cx_rx_bytes_buffered_,
                                parent_.host_->cluster().stats().upstream_cx_tx_bytes_total_,
                                parent_.host_->cluster().stats().upstream_cx_tx_bytes_buffered_,
-                               &parent_.host_->cluster().stats().bind_errors_});
+                               &parent_.host_->cluster().stats().bind_errors_, nullptr, nullptr,
+                               nullptr});
 }
 
 ConnPoolImpl::ActiveClient::~ActiveClient() {
   parent_.host_->stats().cx_active_.dec();
   parent_.host_->cluster().stats().upstream_cx_active_.dec();
+  parent_.host_->cluster().resourceManager(parent_.priority_).connections().dec();
   conn_length_->complete();
 }
 
@@ -37,6 +37,13 @@ protected:
    */
   virtual void parseResponse(const Message& response) PURE;
 
+  /**
+   * This will be called when a 304 response is returned by the API, i.e. when the request was
+   * conditional and what it asked for has not changed since it was last fetched. The default does
+   * nothing.
+   */
+  virtual void onFetchNotModified() {}
+
   /**
    * This will be called either in the success case or in the failure case for each fetch. It can
    * be used to hold common post request logic.
@@ -44,7 +51,8 @@ protected:
   virtual void onFetchComplete() PURE;
 
   /**
-   * This will be called if the fetch fails (either due to non-200 response, network error, etc.).
+   * This will be called if the fetch fails (either due to non-200/304 response, network error,
+   * etc.).
    * @param e supplies any exception data on why the fetch failed. May be nullptr.
    */
   virtual void onFetchFailure(const EnvoyException* e) PURE;
@@ -208,6 +208,14 @@ Http2Settings Utility::parseHttp2Settings(const envoy::api::v2::Http2ProtocolOpt
   return ret;
 }
 
+Http2Settings Utility::parseHttp2Settings(const envoy::api::v2::Http2ProtocolOptions& config,
+                                          Runtime::Loader& runtime,
+                                          const std::string& window_auto_tuning_key) {
+  Http2Settings ret = parseHttp2Settings(config);
+  ret.window_auto_tuning_ = runtime.snapshot().getInteger(window_auto_tuning_key, 0) != 0;
+  return ret;
+}
+
 Http1Settings Utility::parseHttp1Settings(const envoy::api::v2::Http1ProtocolOptions& config) {
   Http1Settings ret;
   ret.allow_absolute_url_ = PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, allow_absolute_url, false);
@@ -254,17 +262,27 @@ void Utility::sendRedirect(StreamDecoderFilterCallbacks& callbacks, const std::s
 }
 
 std::string Utility::getLastAddressFromXFF(const Http::HeaderMap& request_headers) {
-  if (!request_headers.ForwardedFor()) {
+  const HeaderEntry* xff = request_headers.ForwardedFor();
+  if (!xff) {
     return EMPTY_STRING;
   }
 
-  std::vector<std::string> xff_address_list =
-      StringUtil::split(request_headers.ForwardedFor()->value().c_str(), ", ");
+  // This runs for every request, so walk back from the end of the header value rather than
+  // splitting all of it into copies. Addresses are separated by ", " and empty ones are skipped.
+  const char* value = xff->value().c_str();
+  const auto is_separator_before = [value](size_t index) -> bool {
+    return index >= 2 && value[index - 2] == ',' && value[index - 1] == ' ';
+  };
 
-  if (xff_address_list.empty()) {
-    return EMPTY_STRING;
+  size_t end = xff->value().size();
+  while (is_separator_before(end)) {
+    end -= 2;
+  }
+  size_t start = end;
+  while (start > 0 && !is_separator_before(start)) {
+    start--;
   }
-  return xff_address_list.back();
+  return std::string(value + start, end - start);
 }
 
 } // namespace Http
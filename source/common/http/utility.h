@@ -6,6 +6,7 @@
 
 #include "envoy/http/codes.h"
 #include "envoy/http/filter.h"
+#include "envoy/runtime/runtime.h"
 
 #include "common/json/json_loader.h"
 
@@ -106,6 +107,15 @@ public:
    */
   static Http2Settings parseHttp2Settings(const envoy::api::v2::Http2ProtocolOptions& config);
 
+  /**
+   * @return Http2Settings An Http2Settings populated from the envoy::api::v2::Http2ProtocolOptions
+   *         config, with window auto-tuning enabled if the window_auto_tuning_key runtime key is
+   *         non-zero. The config has no field for it yet.
+   */
+  static Http2Settings parseHttp2Settings(const envoy::api::v2::Http2ProtocolOptions& config,
+                                          Runtime::Loader& runtime,
+                                          const std::string& window_auto_tuning_key);
+
   /**
    * @return Http1Settings An Http1Settings populated from the envoy::api::v2::Http1ProtocolOptions
    *         config.
@@ -1,9 +1,10 @@
 #include "common/http/websocket/ws_handler_impl.h"
 
+#include "envoy/event/dispatcher.h"
 #include "envoy/network/connection.h"
 
+#include "common/common/assert.h"
 #include "common/common/enum_to_int.h"
-#include "common/http/codes.h"
 #include "common/http/header_map_impl.h"
 #include "common/http/http1/codec_impl.h"
 
@@ -16,28 +17,85 @@ namespace WebSocket {
 WsHandlerImpl::WsHandlerImpl(HeaderMap& request_headers,
                              const RequestInfo::RequestInfo& request_info,
                              const Router::RouteEntry& route_entry, WsHandlerCallbacks& callbacks,
-                             Upstream::ClusterManager& cluster_manager,
+                             Upstream::ClusterManager& cluster_manager, Runtime::Loader& runtime,
                              Network::ReadFilterCallbacks* read_callbacks)
-    : Filter::TcpProxy(nullptr, cluster_manager), request_headers_(request_headers),
-      request_info_(request_info), route_entry_(route_entry), ws_callbacks_(callbacks) {
+    : request_headers_(request_headers), request_info_(request_info), route_entry_(route_entry),
+      ws_callbacks_(callbacks), cluster_manager_(cluster_manager), runtime_(runtime),
+      read_callbacks_(*read_callbacks), downstream_callbacks_(*this),
+      upstream_callbacks_(new UpstreamCallbacks(*this)) {
+  ENVOY_CONN_LOG(debug, "new websocket tunnel", read_callbacks_.connection());
+  read_callbacks_.connection().addConnectionCallbacks(downstream_callbacks_);
 
-  initializeReadFilterCallbacks(*read_callbacks);
+  // Need to disable reads so that we don't write to an upstream that might fail in onData(). This
+  // will get re-enabled when the upstream connection is established.
+  read_callbacks_.connection().readDisable(true);
 }
 
-void WsHandlerImpl::onInitFailure(UpstreamFailureReason failure_reason) {
-  Code http_code = Code::InternalServerError;
-  switch (failure_reason) {
-  case UpstreamFailureReason::CONNECT_FAILED:
-    http_code = Code::GatewayTimeout;
-    break;
-  case UpstreamFailureReason::NO_HEALTHY_UPSTREAM:
-  case UpstreamFailureReason::RESOURCE_LIMIT_EXCEEDED:
-  case UpstreamFailureReason::NO_ROUTE:
-    http_code = Code::ServiceUnavailable;
-    break;
+WsHandlerImpl::~WsHandlerImpl() {
+  if (upstream_connection_) {
+    finalizeUpstreamConnectionStats();
   }
+}
+
+Network::FilterStatus WsHandlerImpl::onNewConnection() {
+  const std::string& cluster_name = route_entry_.clusterName();
+  Upstream::ThreadLocalCluster* thread_local_cluster = cluster_manager_.get(cluster_name);
+  if (thread_local_cluster == nullptr) {
+    onInitFailure(Code::ServiceUnavailable);
+    return Network::FilterStatus::StopIteration;
+  }
+
+  Upstream::ClusterInfoConstSharedPtr cluster = thread_local_cluster->info();
+  if (!cluster->resourceManager(Upstream::ResourcePriority::Default).connections().canCreate()) {
+    cluster->stats().upstream_cx_overflow_.inc();
+    onInitFailure(Code::ServiceUnavailable);
+    return Network::FilterStatus::StopIteration;
+  }
+
+  Upstream::Host::CreateConnectionData conn_info =
+      cluster_manager_.tcpConnForCluster(cluster_name, this);
+  upstream_connection_ = std::move(conn_info.connection_);
+  read_callbacks_.upstreamHost(conn_info.host_description_);
+  if (!upstream_connection_) {
+    // tcpConnForCluster() increments cluster->stats().upstream_cx_none_healthy.
+    onInitFailure(Code::ServiceUnavailable);
+    return Network::FilterStatus::StopIteration;
+  }
+
+  const Upstream::ClusterStats& cluster_stats = cluster->stats();
+  cluster->resourceManager(Upstream::ResourcePriority::Default).connections().inc();
+  upstream_connection_->addReadFilter(upstream_callbacks_);
+  upstream_connection_->addConnectionCallbacks(*upstream_callbacks_);
+  upstream_connection_->setConnectionStats(
+      {cluster_stats.upstream_cx_rx_bytes_total_, cluster_stats.upstream_cx_rx_bytes_buffered_,
+       cluster_stats.upstream_cx_tx_bytes_total_, cluster_stats.upstream_cx_tx_bytes_buffered_,
+       &cluster_stats.bind_errors_, nullptr, nullptr, nullptr});
+  upstream_connection_->connect();
+  upstream_connection_->noDelay(true);
+
+  connecting_ = true;
+  timer_ = read_callbacks_.connection().dispatcher().createCoarseTimer(
+      [this]() -> void { onTimeout(); });
+  timer_->enableTimer(cluster->connectTimeout());
+
+  cluster_stats.upstream_cx_total_.inc();
+  cluster_stats.upstream_cx_active_.inc();
+  conn_info.host_description_->stats().cx_total_.inc();
+  conn_info.host_description_->stats().cx_active_.inc();
+  start_time_ = std::chrono::steady_clock::now();
+  return Network::FilterStatus::Continue;
+}
 
-  HeaderMapImpl headers{{Headers::get().Status, std::to_string(enumToInt(http_code))}};
+Network::FilterStatus WsHandlerImpl::onData(Buffer::Instance& data) {
+  ENVOY_CONN_LOG(trace, "received {} bytes", read_callbacks_.connection(), data.length());
+  upstream_connection_->write(data);
+  ASSERT(0 == data.length());
+  resetIdleTimer();
+  return Network::FilterStatus::StopIteration;
+}
+
+void WsHandlerImpl::onInitFailure(Code code) {
+  HeaderMapImpl headers{{Headers::get().Status, std::to_string(enumToInt(code))}};
   ws_callbacks_.sendHeadersOnlyResponse(headers);
 }
 
@@ -45,8 +103,8 @@ void WsHandlerImpl::onConnectionSuccess() {
   // path and host rewrites
   route_entry_.finalizeRequestHeaders(request_headers_, request_info_);
   // for auto host rewrite
-  if (route_entry_.autoHostRewrite() && !read_callbacks_->upstreamHost()->hostname().empty()) {
-    request_headers_.Host()->value(read_callbacks_->upstreamHost()->hostname());
+  if (route_entry_.autoHostRewrite() && !read_callbacks_.upstreamHost()->hostname().empty()) {
+    request_headers_.Host()->value(read_callbacks_.upstreamHost()->hostname());
   }
 
   // Wrap upstream connection in HTTP Connection, so that we can
@@ -66,11 +124,136 @@ void WsHandlerImpl::onConnectionSuccess() {
   // the connection pool. The current approach is a stop gap solution, where
   // we put the onus on the user to tell us if a route (and corresponding upstream)
   // is supposed to allow websocket upgrades or not.
-  Http1::ClientConnectionImpl upstream_http(*upstream_connection_, http_conn_callbacks_);
+  NullHttpConnectionCallbacks http_conn_callbacks;
+  Http1::ClientConnectionImpl upstream_http(*upstream_connection_, http_conn_callbacks);
   Http1::RequestStreamEncoderImpl upstream_request = Http1::RequestStreamEncoderImpl(upstream_http);
   upstream_request.encodeHeaders(request_headers_, false);
 }
 
+void WsHandlerImpl::onDownstreamEvent(Network::ConnectionEvent event) {
+  if ((event == Network::ConnectionEvent::RemoteClose ||
+       event == Network::ConnectionEvent::LocalClose) &&
+      upstream_connection_) {
+    upstream_connection_->close(Network::ConnectionCloseType::NoFlush);
+    timer_.reset();
+  }
+}
+
+void WsHandlerImpl::onUpstreamData(Buffer::Instance& data) {
+  read_callbacks_.connection().write(data);
+  ASSERT(0 == data.length());
+  resetIdleTimer();
+}
+
+void WsHandlerImpl::onUpstreamEvent(Network::ConnectionEvent event) {
+  const bool connecting = connecting_;
+  connecting_ = false;
+  if (event == Network::ConnectionEvent::RemoteClose ||
+      event == Network::ConnectionEvent::LocalClose) {
+    timer_.reset();
+  }
+
+  if (event == Network::ConnectionEvent::RemoteClose) {
+    read_callbacks_.upstreamHost()->cluster().stats().upstream_cx_destroy_remote_.inc();
+    if (connecting) {
+      read_callbacks_.upstreamHost()->outlierDetector().putResult(
+          Upstream::Outlier::Result::CONNECT_FAILED);
+      read_callbacks_.upstreamHost()->cluster().stats().upstream_cx_connect_fail_.inc();
+      read_callbacks_.upstreamHost()->stats().cx_connect_fail_.inc();
+      onConnectFailure();
+    } else {
+      read_callbacks_.connection().close(Network::ConnectionCloseType::FlushWrite);
+    }
+  } else if (event == Network::ConnectionEvent::LocalClose) {
+    read_callbacks_.upstreamHost()->cluster().stats().upstream_cx_destroy_local_.inc();
+  } else if (event == Network::ConnectionEvent::Connected) {
+    const MonotonicTime now = std::chrono::steady_clock::now();
+    read_callbacks_.upstreamHost()->cluster().stats().upstream_cx_connect_ms_.recordValue(
+        std::chrono::duration_cast<std::chrono::milliseconds>(now - start_time_).count());
+    start_time_ = now;
+
+    // Re-enable downstream reads now that the upstream connection is established so we have a
+    // place to send downstream data to.
+    read_callbacks_.connection().readDisable(false);
+
+    read_callbacks_.upstreamHost()->outlierDetector().putResult(
+        Upstream::Outlier::Result::SUCCESS);
+    onConnectionSuccess();
+
+    idle_timeout_ = std::chrono::milliseconds(
+        runtime_.snapshot().getInteger("websocket.idle_timeout_ms", 0));
+    if (idle_timeout_.count() > 0) {
+      resetIdleTimer();
+    } else {
+      timer_.reset();
+    }
+  }
+}
+
+void WsHandlerImpl::onTimeout() {
+  if (connecting_) {
+    ENVOY_CONN_LOG(debug, "connect timeout", read_callbacks_.connection());
+    connecting_ = false;
+    read_callbacks_.upstreamHost()->outlierDetector().putResult(
+        Upstream::Outlier::Result::TIMEOUT);
+    read_callbacks_.upstreamHost()->cluster().stats().upstream_cx_connect_timeout_.inc();
+    onConnectFailure();
+    return;
+  }
+
+  ENVOY_CONN_LOG(debug, "websocket idle timeout", read_callbacks_.connection());
+  read_callbacks_.connection().close(Network::ConnectionCloseType::NoFlush);
+}
+
+void WsHandlerImpl::onConnectFailure() {
+  // WebSocket upgrades make a single connect attempt.
+  read_callbacks_.upstreamHost()->cluster().stats().upstream_cx_connect_attempts_exceeded_.inc();
+  closeUpstreamConnection();
+  onInitFailure(Code::GatewayTimeout);
+}
+
+void WsHandlerImpl::closeUpstreamConnection() {
+  finalizeUpstreamConnectionStats();
+  timer_.reset();
+  upstream_connection_->close(Network::ConnectionCloseType::NoFlush);
+  read_callbacks_.connection().dispatcher().deferredDelete(std::move(upstream_connection_));
+}
+
+void WsHandlerImpl::finalizeUpstreamConnectionStats() {
+  Upstream::HostDescriptionConstSharedPtr host = read_callbacks_.upstreamHost();
+  host->cluster().stats().upstream_cx_destroy_.inc();
+  host->cluster().stats().upstream_cx_active_.dec();
+  host->stats().cx_active_.dec();
+  host->cluster().resourceManager(Upstream::ResourcePriority::Default).connections().dec();
+  host->cluster().stats().upstream_cx_length_ms_.recordValue(
+      std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() -
+                                                            start_time_)
+          .count());
+}
+
+void WsHandlerImpl::readDisableUpstream(bool disable) {
+  if (upstream_connection_ == nullptr ||
+      upstream_connection_->state() != Network::Connection::State::Open) {
+    // The upstream may already be closed while the downstream is still being flushed.
+    return;
+  }
+
+  upstream_connection_->readDisable(disable);
+  if (disable) {
+    read_callbacks_.upstreamHost()->cluster().stats().upstream_flow_control_paused_reading_total_
+        .inc();
+  } else {
+    read_callbacks_.upstreamHost()->cluster().stats().upstream_flow_control_resumed_reading_total_
+        .inc();
+  }
+}
+
+void WsHandlerImpl::resetIdleTimer() {
+  if (timer_ != nullptr && !connecting_) {
+    timer_->enableTimer(idle_timeout_);
+  }
+}
+
 } // namespace WebSocket
 } // namespace Http
 } // namespace Envoy
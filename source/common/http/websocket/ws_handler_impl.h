@@ -1,52 +1,139 @@
 #pragma once
 
+#include <chrono>
+#include <cstdint>
+#include <memory>
 #include <string>
 
+#include "envoy/common/time.h"
+#include "envoy/event/timer.h"
 #include "envoy/http/codec.h"
 #include "envoy/http/header_map.h"
 #include "envoy/http/websocket.h"
+#include "envoy/network/connection.h"
 #include "envoy/network/filter.h"
 #include "envoy/router/router.h"
+#include "envoy/runtime/runtime.h"
 #include "envoy/upstream/cluster_manager.h"
+#include "envoy/upstream/load_balancer.h"
 
-#include "common/filter/tcp_proxy.h"
+#include "common/common/logger.h"
+#include "common/http/codes.h"
+#include "common/network/filter_impl.h"
 
 namespace Envoy {
 namespace Http {
 namespace WebSocket {
 
 /**
- * An implementation of a WebSocket proxy based on TCP proxy. This will be used for
- * handling client connection only after a WebSocket upgrade request succeeds
- * (i.e, it is requested by client and allowed by config). This implementation will
- * instantiate a new outgoing TCP connection for the configured upstream cluster.
- * All data will be proxied back and forth between the two connections, without any
- * knowledge of the underlying WebSocket protocol.
+ * A tunnel that proxies a client connection to the configured upstream cluster once a WebSocket
+ * upgrade request succeeds (i.e, it is requested by client and allowed by config). This
+ * implementation will instantiate a new outgoing TCP connection for the cluster of the route. All
+ * data will be proxied back and forth between the two connections, without any knowledge of the
+ * underlying WebSocket protocol.
+ *
+ * Upgraded connections tend to be long lived and mostly idle, so a tunnel keeps as little state as
+ * it can: data is moved straight between the connections without buffering it here, and a single
+ * coarse timer bounds first the upstream connect and then, if the websocket.idle_timeout_ms
+ * runtime key is set, the time without traffic in either direction.
  */
-class WsHandlerImpl : public Envoy::Filter::TcpProxy {
+class WsHandlerImpl : Upstream::LoadBalancerContext, Logger::Loggable<Logger::Id::filter> {
 public:
   WsHandlerImpl(HeaderMap& request_headers, const RequestInfo::RequestInfo& request_info,
                 const Router::RouteEntry& route_entry, WsHandlerCallbacks& callbacks,
-                Upstream::ClusterManager& cluster_manager,
+                Upstream::ClusterManager& cluster_manager, Runtime::Loader& runtime,
                 Network::ReadFilterCallbacks* read_callbacks);
+  ~WsHandlerImpl();
 
-protected:
-  // Filter::TcpProxy
-  const std::string& getUpstreamCluster() override { return route_entry_.clusterName(); }
-  void onInitFailure(UpstreamFailureReason failure_reason) override;
-  void onConnectionSuccess() override;
+  /**
+   * Open the upstream connection. Reads on the client connection are disabled until it is
+   * established.
+   * @return Network::FilterStatus Continue, or StopIteration if an error response was sent.
+   */
+  Network::FilterStatus onNewConnection();
+
+  /**
+   * Proxy data that was read from the client connection.
+   * @param data supplies the data, which is drained.
+   * @return Network::FilterStatus always StopIteration.
+   */
+  Network::FilterStatus onData(Buffer::Instance& data);
+
+  // Upstream::LoadBalancerContext
+  Optional<uint64_t> computeHashKey() override { return {}; }
+  const Router::MetadataMatchCriteria* metadataMatchCriteria() const override { return nullptr; }
+  const Network::Connection* downstreamConnection() const override {
+    return &read_callbacks_.connection();
+  }
 
 private:
+  struct DownstreamCallbacks : public Network::ConnectionCallbacks {
+    DownstreamCallbacks(WsHandlerImpl& parent) : parent_(parent) {}
+
+    // Network::ConnectionCallbacks
+    void onEvent(Network::ConnectionEvent event) override { parent_.onDownstreamEvent(event); }
+    void onAboveWriteBufferHighWatermark() override { parent_.readDisableUpstream(true); }
+    void onBelowWriteBufferLowWatermark() override { parent_.readDisableUpstream(false); }
+
+    WsHandlerImpl& parent_;
+  };
+
+  struct UpstreamCallbacks : public Network::ConnectionCallbacks,
+                             public Network::ReadFilterBaseImpl {
+    UpstreamCallbacks(WsHandlerImpl& parent) : parent_(parent) {}
+
+    // Network::ConnectionCallbacks
+    void onEvent(Network::ConnectionEvent event) override { parent_.onUpstreamEvent(event); }
+    void onAboveWriteBufferHighWatermark() override {
+      parent_.read_callbacks_.connection().readDisable(true);
+    }
+    void onBelowWriteBufferLowWatermark() override {
+      parent_.read_callbacks_.connection().readDisable(false);
+    }
+
+    // Network::ReadFilter
+    Network::FilterStatus onData(Buffer::Instance& data) override {
+      parent_.onUpstreamData(data);
+      return Network::FilterStatus::StopIteration;
+    }
+
+    WsHandlerImpl& parent_;
+  };
+
   struct NullHttpConnectionCallbacks : public ConnectionCallbacks {
     // Http::ConnectionCallbacks
     void onGoAway() override {}
   };
 
+  void onInitFailure(Code code);
+  void onConnectionSuccess();
+  void onDownstreamEvent(Network::ConnectionEvent event);
+  void onUpstreamData(Buffer::Instance& data);
+  void onUpstreamEvent(Network::ConnectionEvent event);
+  void onTimeout();
+  void onConnectFailure();
+  void closeUpstreamConnection();
+  void finalizeUpstreamConnectionStats();
+  void readDisableUpstream(bool disable);
+  void resetIdleTimer();
+
   HeaderMap& request_headers_;
   const RequestInfo::RequestInfo& request_info_;
   const Router::RouteEntry& route_entry_;
   WsHandlerCallbacks& ws_callbacks_;
-  NullHttpConnectionCallbacks http_conn_callbacks_;
+  Upstream::ClusterManager& cluster_manager_;
+  Runtime::Loader& runtime_;
+  Network::ReadFilterCallbacks& read_callbacks_;
+  DownstreamCallbacks downstream_callbacks_;
+  // shared_ptr required for passing as a read filter.
+  std::shared_ptr<UpstreamCallbacks> upstream_callbacks_;
+  Network::ClientConnectionPtr upstream_connection_;
+  // The connect timeout while connecting, and the idle timeout once connected.
+  Event::TimerPtr timer_;
+  // When the upstream connection was created, and then when it was established.
+  MonotonicTime start_time_;
+  std::chrono::milliseconds idle_timeout_{};
+  bool connecting_{};
 };
 
 typedef std::unique_ptr<WsHandlerImpl> WsHandlerImplPtr;
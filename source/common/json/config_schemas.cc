@@ -956,6 +956,73 @@ const std::string Json::Schema::SQUASH_HTTP_FILTER_SCHEMA(R"EOF(
   }
   )EOF");
 
+const std::string Json::Schema::GZIP_HTTP_FILTER_SCHEMA(R"EOF(
+  {
+    "$schema": "http://json-schema.org/schema#",
+    "type" : "object",
+    "properties" : {
+      "compression_level" : {
+        "type" : "string",
+        "enum" : ["best", "speed", "default"]
+      },
+      "compression_strategy" : {
+        "type" : "string",
+        "enum" : ["default", "filtered", "huffman", "rle"]
+      },
+      "window_bits" : {"type" : "integer", "minimum" : 9, "maximum" : 15},
+      "memory_level" : {"type" : "integer", "minimum" : 1, "maximum" : 9},
+      "content_length" : {"type" : "integer", "minimum" : 0},
+      "content_type" : {
+        "type" : "array",
+        "items" : {"type" : "string"}
+      },
+      "encodings" : {
+        "type" : "array",
+        "minItems" : 1,
+        "uniqueItems" : true,
+        "items" : {
+          "type" : "string",
+          "enum" : ["br", "zstd", "gzip"]
+        }
+      },
+      "brotli_quality" : {"type" : "integer", "minimum" : 0, "maximum" : 11},
+      "brotli_window_bits" : {"type" : "integer", "minimum" : 10, "maximum" : 24},
+      "zstd_level" : {"type" : "integer", "minimum" : 1, "maximum" : 19},
+      "dictionary" : {
+        "type" : "object",
+        "properties" : {
+          "encoding" : {"type" : "string"},
+          "filename" : {"type" : "string"}
+        },
+        "required" : ["encoding", "filename"],
+        "additionalProperties" : false
+      }
+    },
+    "additionalProperties" : false
+  }
+  )EOF");
+
+const std::string Json::Schema::HTTP_CACHE_FILTER_SCHEMA(R"EOF(
+  {
+    "$schema": "http://json-schema.org/schema#",
+    "type" : "object",
+    "properties" : {
+      "max_memory_bytes" : {"type" : "integer", "minimum" : 0},
+      "max_entry_bytes" : {"type" : "integer", "minimum" : 0},
+      "disk_cache" : {
+        "type" : "object",
+        "properties" : {
+          "directory" : {"type" : "string"},
+          "max_bytes" : {"type" : "integer", "minimum" : 0}
+        },
+        "required" : ["directory"],
+        "additionalProperties" : false
+      }
+    },
+    "additionalProperties" : false
+  }
+  )EOF");
+
 const std::string Json::Schema::FAULT_HTTP_FILTER_SCHEMA(R"EOF(
   {
     "$schema": "http://json-schema.org/schema#",
@@ -1258,7 +1325,8 @@ const std::string Json::Schema::TOP_LEVEL_CONFIG_SCHEMA(R"EOF(
             "type" : "object",
             "properties" : {
               "collector_cluster" : {"type" : "string"},
-              "collector_endpoint": {"type": "string"}
+              "collector_endpoint": {"type": "string"},
+              "collector_encoding": {"type": "string", "enum": ["json", "thrift"]}
             },
             "required": ["collector_cluster"],
             "additionalProperties" : false
@@ -37,6 +37,7 @@ public:
   // HTTP Filter Schemas
   static const std::string BUFFER_HTTP_FILTER_SCHEMA;
   static const std::string FAULT_HTTP_FILTER_SCHEMA;
+  static const std::string GZIP_HTTP_FILTER_SCHEMA;
   static const std::string GRPC_JSON_TRANSCODER_FILTER_SCHEMA;
   static const std::string HEALTH_CHECK_HTTP_FILTER_SCHEMA;
   static const std::string IP_TAGGING_HTTP_FILTER_SCHEMA;
@@ -44,6 +45,7 @@ public:
   static const std::string ROUTER_HTTP_FILTER_SCHEMA;
   static const std::string LUA_HTTP_FILTER_SCHEMA;
   static const std::string SQUASH_HTTP_FILTER_SCHEMA;
+  static const std::string HTTP_CACHE_FILTER_SCHEMA;
 
   // Cluster Schemas
   static const std::string CLUSTER_MANAGER_SCHEMA;
@@ -3,6 +3,8 @@
 #include <cstdint>
 #include <fstream>
 #include <limits>
+#include <memory>
+#include <mutex>
 #include <sstream>
 #include <stack>
 #include <string>
@@ -168,9 +170,12 @@ private:
     return value_.integer_value_;
   }
 
-  rapidjson::Document asRapidJsonDocument() const;
-  static void buildRapidJsonDocument(const Field& field, rapidjson::Value& value,
-                                     rapidjson::Document::AllocatorType& allocator);
+  /**
+   * Pass the field to a rapidjson SAX handler as if it was parsed, which spares building a
+   * rapidjson::Document to serialize or validate it.
+   * @return bool false if the handler stopped the traversal.
+   */
+  template <class Handler> bool accept(Handler& handler) const;
 
   uint64_t line_number_start_ = 0;
   uint64_t line_number_end_ = 0;
@@ -241,89 +246,49 @@ private:
   FieldSharedPtr root_;
 };
 
-void Field::buildRapidJsonDocument(const Field& field, rapidjson::Value& value,
-                                   rapidjson::Document::AllocatorType& allocator) {
-
-  switch (field.type_) {
-  case Type::Array: {
-    value.SetArray();
-    value.Reserve(field.value_.array_value_.size(), allocator);
-    for (const auto& element : field.value_.array_value_) {
-      switch (element->type_) {
-      case Type::Array:
-      case Type::Object: {
-        rapidjson::Value nested_value;
-        buildRapidJsonDocument(*element, nested_value, allocator);
-        value.PushBack(nested_value, allocator);
-        break;
-      }
-      case Type::Boolean:
-        value.PushBack(element->value_.boolean_value_, allocator);
-        break;
-      case Type::Double:
-        value.PushBack(element->value_.double_value_, allocator);
-        break;
-      case Type::Integer:
-        value.PushBack(element->value_.integer_value_, allocator);
-        break;
-      case Type::Null:
-        value.PushBack(rapidjson::Value(), allocator);
-        break;
-      case Type::String:
-        value.PushBack(rapidjson::StringRef(element->value_.string_value_.c_str()), allocator);
-      }
+template <class Handler> bool Field::accept(Handler& handler) const {
+  switch (type_) {
+  case Type::Array:
+    if (!handler.StartArray()) {
+      return false;
     }
-    break;
-  }
-  case Type::Object: {
-    value.SetObject();
-    for (const auto& item : field.value_.object_value_) {
-      auto name = rapidjson::StringRef(item.first.c_str());
-
-      switch (item.second->type_) {
-      case Type::Array:
-      case Type::Object: {
-        rapidjson::Value nested_value;
-        buildRapidJsonDocument(*item.second, nested_value, allocator);
-        value.AddMember(name, nested_value, allocator);
-        break;
+    for (const auto& element : value_.array_value_) {
+      if (!element->accept(handler)) {
+        return false;
       }
-      case Type::Boolean:
-        value.AddMember(name, item.second->value_.boolean_value_, allocator);
-        break;
-      case Type::Double:
-        value.AddMember(name, item.second->value_.double_value_, allocator);
-        break;
-      case Type::Integer:
-        value.AddMember(name, item.second->value_.integer_value_, allocator);
-        break;
-      case Type::Null:
-        value.AddMember(name, rapidjson::Value(), allocator);
-        break;
-      case Type::String:
-        value.AddMember(name, rapidjson::StringRef(item.second->value_.string_value_.c_str()),
-                        allocator);
-        break;
+    }
+    return handler.EndArray(static_cast<rapidjson::SizeType>(value_.array_value_.size()));
+  case Type::Object:
+    if (!handler.StartObject()) {
+      return false;
+    }
+    for (const auto& item : value_.object_value_) {
+      if (!handler.Key(item.first.c_str(), static_cast<rapidjson::SizeType>(item.first.size()),
+                       false) ||
+          !item.second->accept(handler)) {
+        return false;
       }
     }
-    break;
+    return handler.EndObject(static_cast<rapidjson::SizeType>(value_.object_value_.size()));
+  case Type::Boolean:
+    return handler.Bool(value_.boolean_value_);
+  case Type::Double:
+    return handler.Double(value_.double_value_);
+  case Type::Integer:
+    return handler.Int64(value_.integer_value_);
+  case Type::Null:
+    return handler.Null();
+  case Type::String:
+    return handler.String(value_.string_value_.c_str(),
+                          static_cast<rapidjson::SizeType>(value_.string_value_.size()), false);
   }
-  default:
-    NOT_REACHED;
-  }
-}
-
-rapidjson::Document Field::asRapidJsonDocument() const {
-  rapidjson::Document document;
-  rapidjson::Document::AllocatorType& allocator = document.GetAllocator();
-  buildRapidJsonDocument(*this, document, allocator);
-  return document;
+  NOT_REACHED;
 }
 
 uint64_t Field::hash() const {
   rapidjson::StringBuffer buffer;
   rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
-  asRapidJsonDocument().Accept(writer);
+  accept(writer);
   return HashUtil::xxHash64(buffer.GetString());
 }
 
@@ -474,8 +439,7 @@ std::vector<ObjectSharedPtr> Field::asObjectArray() const {
 std::string Field::asJsonString() const {
   rapidjson::StringBuffer buffer;
   rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
-  rapidjson::Document document = asRapidJsonDocument();
-  document.Accept(writer);
+  accept(writer);
   return buffer.GetString();
 }
 
@@ -506,18 +470,46 @@ void Field::iterate(const ObjectCallback& callback) const {
   }
 }
 
-void Field::validateSchema(const std::string& schema) const {
-  rapidjson::Document schema_document;
-  if (schema_document.Parse<0>(schema.c_str()).HasParseError()) {
+/**
+ * A parsed and compiled schema. It is immutable once compiled, so validators on any thread can
+ * share it.
+ */
+struct CompiledSchema {
+  rapidjson::Document document_;
+  std::unique_ptr<rapidjson::SchemaDocument> schema_document_;
+};
+
+/**
+ * @return const rapidjson::SchemaDocument& the compiled schema, which is compiled on first use and
+ *         kept for the life of the process. Config loads validate thousands of objects against the
+ *         same few schemas, which are all constants.
+ * @throw std::invalid_argument if the schema is not valid JSON.
+ */
+const rapidjson::SchemaDocument& compiledSchema(const std::string& schema) {
+  static std::mutex* lock = new std::mutex();
+  static auto* cache = new std::unordered_map<std::string, std::unique_ptr<CompiledSchema>>();
+
+  std::unique_lock<std::mutex> guard(*lock);
+  auto it = cache->find(schema);
+  if (it != cache->end()) {
+    return *it->second->schema_document_;
+  }
+
+  std::unique_ptr<CompiledSchema> compiled(new CompiledSchema());
+  if (compiled->document_.Parse<0>(schema.c_str()).HasParseError()) {
     throw std::invalid_argument(fmt::format(
         "Schema supplied to validateSchema is not valid JSON\n Error(offset {}) : {}\n",
-        schema_document.GetErrorOffset(), GetParseError_En(schema_document.GetParseError())));
+        compiled->document_.GetErrorOffset(),
+        GetParseError_En(compiled->document_.GetParseError())));
   }
+  compiled->schema_document_.reset(new rapidjson::SchemaDocument(compiled->document_));
+  return *cache->emplace(schema, std::move(compiled)).first->second->schema_document_;
+}
 
-  rapidjson::SchemaDocument schema_document_for_validator(schema_document);
-  rapidjson::SchemaValidator schema_validator(schema_document_for_validator);
+void Field::validateSchema(const std::string& schema) const {
+  rapidjson::SchemaValidator schema_validator(compiledSchema(schema));
 
-  if (!asRapidJsonDocument().Accept(schema_validator)) {
+  if (!accept(schema_validator)) {
     rapidjson::StringBuffer schema_string_buffer;
     rapidjson::StringBuffer document_string_buffer;
 
@@ -691,32 +683,41 @@ ObjectSharedPtr Factory::loadFromFile(const std::string& file_path) {
 
 namespace {
 
+/**
+ * Call a visitor with the value of a YAML scalar, as a bool, int64_t, double or std::string.
+ */
+template <class Visitor> auto visitYamlScalar(const YAML::Node& node, Visitor visitor) {
+  // Due to the fact that we prefer to parse without schema or application knowledge (e.g. since
+  // we may have embedded opaque configs), we must use heuristics to resolve what the type of the
+  // scalar is. See discussion in https://github.com/jbeder/yaml-cpp/issues/261.
+  // First, if we know this has been explicitly quoted as a string, do that.
+  if (node.Tag() == "!") {
+    return visitor(node.as<std::string>());
+  }
+  bool bool_value;
+  if (YAML::convert<bool>::decode(node, bool_value)) {
+    return visitor(bool_value);
+  }
+  int64_t int_value;
+  if (YAML::convert<int64_t>::decode(node, int_value)) {
+    return visitor(int_value);
+  }
+  double double_value;
+  if (YAML::convert<double>::decode(node, double_value)) {
+    return visitor(double_value);
+  }
+  // Otherwise, fall back on string.
+  return visitor(node.as<std::string>());
+}
+
 FieldSharedPtr parseYamlNode(YAML::Node node) {
   switch (node.Type()) {
   case YAML::NodeType::Null:
     return Field::createNull();
   case YAML::NodeType::Scalar:
-    // Due to the fact that we prefer to parse without schema or application knowledge (e.g. since
-    // we may have embedded opaque configs), we must use heuristics to resolve what the type of the
-    // scalar is. See discussion in https://github.com/jbeder/yaml-cpp/issues/261.
-    // First, if we know this has been explicitly quoted as a string, do that.
-    if (node.Tag() == "!") {
-      return Field::createValue(node.as<std::string>());
-    }
-    bool bool_value;
-    if (YAML::convert<bool>::decode(node, bool_value)) {
-      return Field::createValue(bool_value);
-    }
-    int64_t int_value;
-    if (YAML::convert<int64_t>::decode(node, int_value)) {
-      return Field::createValue(int_value);
-    }
-    double double_value;
-    if (YAML::convert<double>::decode(node, double_value)) {
-      return Field::createValue(double_value);
-    }
-    // Otherwise, fall back on string.
-    return Field::createValue(node.as<std::string>());
+    return visitYamlScalar(node, [](auto value) -> FieldSharedPtr {
+      return Field::createValue(value);
+    });
   case YAML::NodeType::Sequence: {
     FieldSharedPtr array = Field::createArray();
     for (auto it : node) {
@@ -737,6 +738,45 @@ FieldSharedPtr parseYamlNode(YAML::Node node) {
   NOT_REACHED;
 }
 
+typedef rapidjson::Writer<rapidjson::StringBuffer> JsonWriter;
+
+void writeJsonScalar(JsonWriter& writer, bool value) { writer.Bool(value); }
+void writeJsonScalar(JsonWriter& writer, int64_t value) { writer.Int64(value); }
+void writeJsonScalar(JsonWriter& writer, double value) { writer.Double(value); }
+void writeJsonScalar(JsonWriter& writer, const std::string& value) {
+  writer.String(value.c_str(), static_cast<rapidjson::SizeType>(value.size()));
+}
+
+void writeYamlNode(const YAML::Node& node, JsonWriter& writer) {
+  switch (node.Type()) {
+  case YAML::NodeType::Null:
+    writer.Null();
+    return;
+  case YAML::NodeType::Scalar:
+    visitYamlScalar(node, [&writer](const auto& value) -> void { writeJsonScalar(writer, value); });
+    return;
+  case YAML::NodeType::Sequence:
+    writer.StartArray();
+    for (auto it : node) {
+      writeYamlNode(it, writer);
+    }
+    writer.EndArray();
+    return;
+  case YAML::NodeType::Map:
+    writer.StartObject();
+    for (auto it : node) {
+      const std::string key = it.first.as<std::string>();
+      writer.Key(key.c_str(), static_cast<rapidjson::SizeType>(key.size()));
+      writeYamlNode(it.second, writer);
+    }
+    writer.EndObject();
+    return;
+  case YAML::NodeType::Undefined:
+    throw EnvoyException("Undefined YAML value");
+  }
+  NOT_REACHED;
+}
+
 } // namespace
 
 ObjectSharedPtr Factory::loadFromYamlString(const std::string& yaml) {
@@ -747,6 +787,17 @@ ObjectSharedPtr Factory::loadFromYamlString(const std::string& yaml) {
   }
 }
 
+std::string Factory::yamlAsJsonString(const std::string& yaml) {
+  rapidjson::StringBuffer buffer;
+  JsonWriter writer(buffer);
+  try {
+    writeYamlNode(YAML::Load(yaml), writer);
+  } catch (YAML::ParserException& e) {
+    throw EnvoyException(e.what());
+  }
+  return buffer.GetString();
+}
+
 ObjectSharedPtr Factory::loadFromString(const std::string& json) {
   LineCountingStringStream json_stream(json.c_str());
 
@@ -25,6 +25,12 @@ public:
    */
   static ObjectSharedPtr loadFromYamlString(const std::string& yaml);
 
+  /**
+   * Converts a YAML string to JSON without building a Json Object, e.g. to parse it into a
+   * protobuf.
+   */
+  static std::string yamlAsJsonString(const std::string& yaml);
+
   static const std::string listAsJsonString(const std::list<std::string>& items);
 };
 
@@ -6,9 +6,49 @@
 
 namespace Envoy {
 namespace Lua {
+namespace {
 
-Coroutine::Coroutine(const std::pair<lua_State*, lua_State*>& new_thread_state)
-    : coroutine_state_(new_thread_state, false) {}
+int writeBytecode(lua_State*, const void* data, size_t size, void* bytecode) {
+  static_cast<std::string*>(bytecode)->append(static_cast<const char*>(data), size);
+  return 0;
+}
+
+} // namespace
+
+std::pair<lua_State*, lua_State*> CoroutinePool::acquire() {
+  if (coroutines_.empty()) {
+    return {lua_newthread(state_), state_};
+  }
+
+  lua_State* coroutine_state = coroutines_.back().first;
+  lua_rawgeti(state_, LUA_REGISTRYINDEX, coroutines_.back().second);
+  luaL_unref(state_, LUA_REGISTRYINDEX, coroutines_.back().second);
+  coroutines_.pop_back();
+  return {coroutine_state, state_};
+}
+
+void CoroutinePool::release(lua_State* coroutine_state) {
+  if (closed_ || coroutines_.size() >= MaxSize) {
+    return;
+  }
+
+  // Drop whatever the function returned so that the coroutine starts with an empty stack.
+  lua_settop(coroutine_state, 0);
+  lua_pushthread(coroutine_state);
+  lua_xmove(coroutine_state, state_, 1);
+  coroutines_.emplace_back(coroutine_state, luaL_ref(state_, LUA_REGISTRYINDEX));
+}
+
+Coroutine::Coroutine(const std::pair<lua_State*, lua_State*>& new_thread_state,
+                     CoroutinePool* pool)
+    : coroutine_state_(new_thread_state, false), pool_(pool) {}
+
+Coroutine::~Coroutine() {
+  // A coroutine that returned can be started again. One that yielded or failed cannot.
+  if (pool_ != nullptr && reusable_) {
+    pool_->release(coroutine_state_.get());
+  }
+}
 
 void Coroutine::start(int function_ref, int num_args, const std::function<void()>& yield_callback) {
   ASSERT(state_ == State::NotStarted);
@@ -29,6 +69,7 @@ void Coroutine::resume(int num_args, const std::function<void()>& yield_callback
 
   if (0 == rc) {
     state_ = State::Finished;
+    reusable_ = true;
     ENVOY_LOG(debug, "coroutine finished");
   } else if (LUA_YIELD == rc) {
     state_ = State::Yielded;
@@ -44,17 +85,21 @@ void Coroutine::resume(int num_args, const std::function<void()>& yield_callback
 ThreadLocalState::ThreadLocalState(const std::string& code, ThreadLocal::SlotAllocator& tls)
     : tls_slot_(tls.allocateSlot()) {
 
-  // First verify that the supplied code can be parsed.
+  // First verify that the supplied code can be parsed and run. The workers load the resulting
+  // bytecode so that the script is only compiled once.
   CSmartPtr<lua_State, lua_close> state(lua_open());
   luaL_openlibs(state.get());
 
-  if (0 != luaL_dostring(state.get(), code.c_str())) {
+  std::string bytecode;
+  if (0 != luaL_loadstring(state.get(), code.c_str()) ||
+      0 != lua_dump(state.get(), writeBytecode, &bytecode) ||
+      0 != lua_pcall(state.get(), 0, LUA_MULTRET, 0)) {
     throw LuaException(fmt::format("script load error: {}", lua_tostring(state.get(), -1)));
   }
 
   // Now initialize on all threads.
-  tls_slot_->set([code](Event::Dispatcher&) {
-    return ThreadLocal::ThreadLocalObjectSharedPtr{new LuaThreadLocal(code)};
+  tls_slot_->set([bytecode](Event::Dispatcher&) {
+    return ThreadLocal::ThreadLocalObjectSharedPtr{new LuaThreadLocal(bytecode)};
   });
 }
 
@@ -81,16 +126,34 @@ uint64_t ThreadLocalState::registerGlobal(const std::string& global) {
 }
 
 CoroutinePtr ThreadLocalState::createCoroutine() {
+  LuaThreadLocal& tls = tls_slot_->getTyped<LuaThreadLocal>();
+  return CoroutinePtr{new Coroutine(tls.coroutine_pool_.acquire(), &tls.coroutine_pool_)};
+}
+
+void ThreadLocalState::collectGarbage(uint64_t step_kb) {
+  lua_gc(tls_slot_->getTyped<LuaThreadLocal>().state_.get(), LUA_GCSTEP, step_kb);
+}
+
+uint64_t ThreadLocalState::runtimeBytesUsed() {
   lua_State* state = tls_slot_->getTyped<LuaThreadLocal>().state_.get();
-  return CoroutinePtr{new Coroutine({lua_newthread(state), state})};
+  return static_cast<uint64_t>(lua_gc(state, LUA_GCCOUNT, 0)) * 1024 +
+         lua_gc(state, LUA_GCCOUNTB, 0);
 }
 
-ThreadLocalState::LuaThreadLocal::LuaThreadLocal(const std::string& code) : state_(lua_open()) {
+ThreadLocalState::LuaThreadLocal::LuaThreadLocal(const std::string& bytecode)
+    : state_(lua_open()), coroutine_pool_(state_.get()) {
   luaL_openlibs(state_.get());
-  int rc = luaL_dostring(state_.get(), code.c_str());
+  int rc = luaL_loadbuffer(state_.get(), bytecode.data(), bytecode.size(), "envoy") ||
+           lua_pcall(state_.get(), 0, LUA_MULTRET, 0);
   ASSERT(rc == 0);
   UNREFERENCED_PARAMETER(rc);
 }
 
+ThreadLocalState::LuaThreadLocal::~LuaThreadLocal() {
+  // Closing the state destroys the objects that own coroutines, which must not be pooled.
+  coroutine_pool_.close();
+  state_.reset();
+}
+
 } // namespace Lua
 } // namespace Envoy
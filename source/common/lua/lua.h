@@ -292,6 +292,42 @@ public:
   }
 };
 
+/**
+ * The finished coroutines of a worker's Lua state, which are kept for reuse so that running a
+ * script does not allocate a new Lua thread and stack each time.
+ */
+class CoroutinePool {
+public:
+  CoroutinePool(lua_State* state) : state_(state) {}
+
+  /**
+   * @return a pooled coroutine, or a new one if the pool is empty. Like lua_newthread(), the
+   *         coroutine is pushed onto the stack of the owning state, and the pair holds the
+   *         coroutine and the owning state.
+   */
+  std::pair<lua_State*, lua_State*> acquire();
+
+  /**
+   * Keep a coroutine that finished without error for reuse, unless the pool is full.
+   * @param coroutine_state supplies the coroutine.
+   */
+  void release(lua_State* coroutine_state);
+
+  /**
+   * Stop keeping coroutines. Called before the owning state is closed, which destroys the objects
+   * that own coroutines.
+   */
+  void close() { closed_ = true; }
+
+  static const size_t MaxSize = 1024;
+
+private:
+  lua_State* state_;
+  // The coroutines and their registry references.
+  std::vector<std::pair<lua_State*, int>> coroutines_;
+  bool closed_{};
+};
+
 /**
  * This is a wraper for a Lua coroutine. Lua intermixes coroutine and "thread." Lua does not have
  * real threads, only cooperatively scheduled coroutines.
@@ -300,7 +336,14 @@ class Coroutine : Logger::Loggable<Logger::Id::lua> {
 public:
   enum class State { NotStarted, Yielded, Finished };
 
-  Coroutine(const std::pair<lua_State*, lua_State*>& new_thread_state);
+  /**
+   * @param new_thread_state supplies the coroutine and its owning state.
+   * @param pool supplies an optional pool to return the coroutine to if it finishes without error.
+   */
+  Coroutine(const std::pair<lua_State*, lua_State*>& new_thread_state,
+            CoroutinePool* pool = nullptr);
+  ~Coroutine();
+
   lua_State* luaState() { return coroutine_state_.get(); }
   State state() { return state_; }
 
@@ -325,6 +368,8 @@ public:
 private:
   LuaRef<lua_State> coroutine_state_;
   State state_{State::NotStarted};
+  CoroutinePool* pool_;
+  bool reusable_{};
 };
 
 typedef std::unique_ptr<Coroutine> CoroutinePtr;
@@ -339,10 +384,22 @@ public:
   ThreadLocalState(const std::string& code, ThreadLocal::SlotAllocator& tls);
 
   /**
-   * @return CoroutinePtr a new coroutine.
+   * @return CoroutinePtr a new coroutine, which reuses a coroutine that finished earlier on the
+   *         same worker where possible.
    */
   CoroutinePtr createCoroutine();
 
+  /**
+   * Run an incremental garbage collection step on the state of the current worker.
+   * @param step_kb supplies the size of the step, as for LUA_GCSTEP.
+   */
+  void collectGarbage(uint64_t step_kb);
+
+  /**
+   * @return uint64_t the number of bytes in use by the state of the current worker.
+   */
+  uint64_t runtimeBytesUsed();
+
   /**
    * @return a global reference previously registered via registerGlobal(). This may return
    *         LUA_REFNIL if there was no such global.
@@ -368,9 +425,11 @@ public:
 
 private:
   struct LuaThreadLocal : public ThreadLocal::ThreadLocalObject {
-    LuaThreadLocal(const std::string& code);
+    LuaThreadLocal(const std::string& bytecode);
+    ~LuaThreadLocal();
 
     CSmartPtr<lua_State, lua_close> state_;
+    CoroutinePool coroutine_pool_;
     std::vector<int> global_slots_;
   };
 
@@ -16,12 +16,57 @@ int BufferWrapper::luaGetBytes(lua_State* state) {
     luaL_error(state, "index/length must be >= 0 and (index + length) must be <= buffer size");
   }
 
-  // TODO(mattklein123): Reduce copies here by using Lua direct buffer builds.
+  // Push the bytes straight out of the buffer if they are in a single slice, which is usually the
+  // case for small reads.
+  uint64_t slice_start = 0;
+  for (const Buffer::RawSlice& slice : rawSlices()) {
+    if (static_cast<uint64_t>(index) < slice_start + slice.len_) {
+      if (static_cast<uint64_t>(index) + length <= slice_start + slice.len_) {
+        lua_pushlstring(state, static_cast<const char*>(slice.mem_) + (index - slice_start),
+                        length);
+        return 1;
+      }
+      break;
+    }
+    slice_start += slice.len_;
+  }
+
   std::unique_ptr<char[]> data(new char[length]);
   data_.copyOut(index, length, data.get());
   lua_pushlstring(state, data.get(), length);
   return 1;
 }
 
+int BufferWrapper::luaRawSlices(lua_State* state) {
+  // The iterator keeps the wrapper and the index of the next slice as upvalues.
+  lua_pushvalue(state, 1);
+  lua_pushinteger(state, 0);
+  lua_pushcclosure(state, static_luaRawSliceIterator, 2);
+  return 1;
+}
+
+int BufferWrapper::luaRawSliceIterator(lua_State* state) {
+  const std::vector<Buffer::RawSlice>& slices = rawSlices();
+  const lua_Integer current = lua_tointeger(state, lua_upvalueindex(2));
+  if (current >= static_cast<lua_Integer>(slices.size())) {
+    return 0;
+  }
+
+  lua_pushinteger(state, current + 1);
+  lua_replace(state, lua_upvalueindex(2));
+  lua_pushlightuserdata(state, slices[current].mem_);
+  lua_pushnumber(state, slices[current].len_);
+  return 2;
+}
+
+const std::vector<Buffer::RawSlice>& BufferWrapper::rawSlices() {
+  if (!raw_slices_valid_) {
+    raw_slices_.resize(data_.getRawSlices(nullptr, 0));
+    data_.getRawSlices(raw_slices_.data(), raw_slices_.size());
+    raw_slices_valid_ = true;
+  }
+  return raw_slices_;
+}
+
 } // namespace Lua
 } // namespace Envoy
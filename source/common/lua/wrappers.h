@@ -1,5 +1,7 @@
 #pragma once
 
+#include <vector>
+
 #include "envoy/buffer/buffer.h"
 
 #include "common/lua/lua.h"
@@ -15,7 +17,9 @@ public:
   BufferWrapper(const Buffer::Instance& data) : data_(data) {}
 
   static ExportedFunctions exportedFunctions() {
-    return {{"length", static_luaLength}, {"getBytes", static_luaGetBytes}};
+    return {{"length", static_luaLength},
+            {"getBytes", static_luaGetBytes},
+            {"rawSlices", static_luaRawSlices}};
   }
 
 private:
@@ -32,7 +36,26 @@ private:
    */
   DECLARE_LUA_FUNCTION(BufferWrapper, luaGetBytes);
 
+  /**
+   * @return an iterator over the slices of the buffer, which returns the start of each slice as
+   *         light userdata and its length. LuaJIT FFI can read the bytes in place, e.g. via
+   *         ffi.cast("const char*", pointer), instead of copying them into Lua strings. The
+   *         pointers are only valid for as long as the buffer wrapper is, which does not survive
+   *         the script yielding. The iterator fails once the wrapper is dead.
+   */
+  DECLARE_LUA_FUNCTION(BufferWrapper, luaRawSlices);
+
+  /**
+   * This is the closure/iterator returned by luaRawSlices() above.
+   */
+  DECLARE_LUA_CLOSURE(BufferWrapper, luaRawSliceIterator);
+
+  const std::vector<Buffer::RawSlice>& rawSlices();
+
   const Buffer::Instance& data_;
+  // The slices of the buffer, which does not change while the wrapper is alive.
+  std::vector<Buffer::RawSlice> raw_slices_;
+  bool raw_slices_valid_{};
 };
 
 } // namespace Lua
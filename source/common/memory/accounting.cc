@@ -0,0 +1,9 @@
+#include "common/memory/accounting.h"
+
+namespace Envoy {
+namespace Memory {
+
+std::array<Accounting::Count, Accounting::NumCategories> Accounting::counts_;
+
+} // namespace Memory
+} // namespace Envoy
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#include "common/common/non_copyable.h"
+
+namespace Envoy {
+namespace Memory {
+
+/**
+ * The subsystems whose memory is accounted separately.
+ */
+enum class Category : uint8_t {
+  // Slices of Envoy owned buffers, pooled or in use.
+  Buffers,
+  // Raw stat data allocated on the heap.
+  Stats,
+  // Route tables, estimated from the size of the route configurations they are built from.
+  RouteConfigs,
+  // Upstream hosts.
+  Hosts,
+  // Connections of HTTP connection pools, not counting their buffers.
+  ConnectionPools,
+};
+
+/**
+ * Process wide count of the bytes held by each subsystem. Subsystems charge what they allocate
+ * and credit it back when they free it, which costs one relaxed atomic add. The counts complement
+ * Memory::Stats, which only knows the total held by the heap.
+ */
+class Accounting {
+public:
+  static void charge(Category category, uint64_t bytes) {
+    counts_[static_cast<size_t>(category)].bytes_.fetch_add(bytes, std::memory_order_relaxed);
+  }
+
+  static void credit(Category category, uint64_t bytes) {
+    counts_[static_cast<size_t>(category)].bytes_.fetch_sub(bytes, std::memory_order_relaxed);
+  }
+
+  /**
+   * @return uint64_t the bytes currently held by a subsystem.
+   */
+  static uint64_t bytes(Category category) {
+    return counts_[static_cast<size_t>(category)].bytes_.load(std::memory_order_relaxed);
+  }
+
+  static const size_t NumCategories = static_cast<size_t>(Category::ConnectionPools) + 1;
+
+private:
+  // Each count has a cache line of its own, so that subsystems busy on different threads do not
+  // contend.
+  struct alignas(64) Count {
+    std::atomic<uint64_t> bytes_;
+  };
+
+  static std::array<Count, NumCategories> counts_;
+};
+
+/**
+ * Bytes charged to a category for as long as the object lives. Meant to be a member of the object
+ * whose memory it accounts for.
+ */
+class AccountedBytes : NonCopyable {
+public:
+  AccountedBytes(Category category, uint64_t bytes) : category_(category), bytes_(bytes) {
+    Accounting::charge(category_, bytes_);
+  }
+  ~AccountedBytes() { Accounting::credit(category_, bytes_); }
+
+private:
+  const Category category_;
+  const uint64_t bytes_;
+};
+
+} // namespace Memory
+} // namespace Envoy
@@ -1,9 +1,11 @@
 #include "common/mongo/bson_impl.h"
 
 #include <cstdint>
+#include <cstring>
 #include <sstream>
 #include <string>
 
+#include "common/buffer/buffer_impl.h"
 #include "common/common/assert.h"
 #include "common/common/byte_order.h"
 #include "common/common/hex.h"
@@ -355,28 +357,38 @@ std::string FieldImpl::toString() const {
   NOT_REACHED;
 }
 
-void DocumentImpl::fromBuffer(Buffer::Instance& data) {
+void DocumentImpl::fromBuffer(Buffer::Instance& data, bool validate_document) {
   uint64_t original_buffer_length = data.length();
-  int32_t message_length = BufferHelper::removeInt32(data);
-  if (static_cast<uint64_t>(message_length) > original_buffer_length) {
+  int32_t message_length = BufferHelper::peakInt32(data);
+  if (message_length < 5 || static_cast<uint64_t>(message_length) > original_buffer_length) {
     throw EnvoyException("invalid BSON message length");
   }
 
   ENVOY_LOG(trace, "BSON document length: {} data length: {}", message_length,
             original_buffer_length);
 
-  while (true) {
-    uint64_t document_bytes_remaining = data.length() - (original_buffer_length - message_length);
-    ENVOY_LOG(trace, "BSON document bytes remaining: {}", document_bytes_remaining);
-    if (document_bytes_remaining == 1) {
-      uint8_t last_byte = BufferHelper::removeByte(data);
-      if (last_byte != 0) {
-        throw EnvoyException("invalid document");
-      }
+  raw_.reset(new Buffer::OwnedImpl());
+  raw_->move(data, message_length);
+  if (validate_document) {
+    validate(static_cast<const uint8_t*>(raw_->linearize(message_length)),
+                           message_length);
+  }
+}
 
-      return;
-    }
+DocumentSharedPtr DocumentImpl::createValidated(Buffer::Instance& data) {
+  std::shared_ptr<DocumentImpl> new_doc{new DocumentImpl()};
+  new_doc->fromBuffer(data, false);
+  return new_doc;
+}
+
+void DocumentImpl::decode() const {
+  if (!raw_) {
+    return;
+  }
 
+  Buffer::Instance& data = *raw_;
+  BufferHelper::removeInt32(data);
+  while (data.length() > 1) {
     uint8_t element_type = BufferHelper::removeByte(data);
     std::string key = BufferHelper::removeCString(data);
     ENVOY_LOG(trace, "BSON element type: {:#x} key: {}", element_type, key);
@@ -384,60 +396,60 @@ void DocumentImpl::fromBuffer(Buffer::Instance& data) {
     case Field::Type::DOUBLE: {
       double value = BufferHelper::removeDouble(data);
       ENVOY_LOG(trace, "BSON double: {}", value);
-      addDouble(key, value);
+      fields_.emplace_back(new FieldImpl(key, value));
       break;
     }
 
     case Field::Type::STRING: {
       std::string value = BufferHelper::removeString(data);
       ENVOY_LOG(trace, "BSON string: {}", value);
-      addString(key, std::move(value));
+      fields_.emplace_back(new FieldImpl(Field::Type::STRING, key, std::move(value)));
       break;
     }
 
     case Field::Type::DOCUMENT: {
       ENVOY_LOG(trace, "BSON document");
-      addDocument(key, DocumentImpl::create(data));
+      fields_.emplace_back(new FieldImpl(Field::Type::DOCUMENT, key, createValidated(data)));
       break;
     }
 
     case Field::Type::ARRAY: {
       ENVOY_LOG(trace, "BSON array");
-      addArray(key, DocumentImpl::create(data));
+      fields_.emplace_back(new FieldImpl(Field::Type::ARRAY, key, createValidated(data)));
       break;
     }
 
     case Field::Type::BINARY: {
       std::string value = BufferHelper::removeBinary(data);
       ENVOY_LOG(trace, "BSON binary: {}", value);
-      addBinary(key, std::move(value));
+      fields_.emplace_back(new FieldImpl(Field::Type::BINARY, key, std::move(value)));
       break;
     }
 
     case Field::Type::OBJECT_ID: {
       Field::ObjectId value;
       BufferHelper::removeBytes(data, &value[0], value.size());
-      addObjectId(key, std::move(value));
+      fields_.emplace_back(new FieldImpl(key, std::move(value)));
       break;
     }
 
     case Field::Type::BOOLEAN: {
       bool value = BufferHelper::removeByte(data) != 0;
       ENVOY_LOG(trace, "BSON boolean: {}", value);
-      addBoolean(key, value);
+      fields_.emplace_back(new FieldImpl(key, value));
       break;
     }
 
     case Field::Type::DATETIME: {
       int64_t value = BufferHelper::removeInt64(data);
       ENVOY_LOG(trace, "BSON datetime: {}", value);
-      addDatetime(key, value);
+      fields_.emplace_back(new FieldImpl(Field::Type::DATETIME, key, value));
       break;
     }
 
     case Field::Type::NULL_VALUE: {
       ENVOY_LOG(trace, "BSON null value");
-      addNull(key);
+      fields_.emplace_back(new FieldImpl(key));
       break;
     }
 
@@ -446,39 +458,148 @@ void DocumentImpl::fromBuffer(Buffer::Instance& data) {
       value.pattern_ = BufferHelper::removeCString(data);
       value.options_ = BufferHelper::removeCString(data);
       ENVOY_LOG(trace, "BSON regex pattern: {} options: {}", value.pattern_, value.options_);
-      addRegex(key, std::move(value));
+      fields_.emplace_back(new FieldImpl(key, std::move(value)));
       break;
     }
 
     case Field::Type::INT32: {
       int32_t value = BufferHelper::removeInt32(data);
       ENVOY_LOG(trace, "BSON int32: {}", value);
-      addInt32(key, value);
+      fields_.emplace_back(new FieldImpl(key, value));
       break;
     }
 
     case Field::Type::TIMESTAMP: {
       int64_t value = BufferHelper::removeInt64(data);
       ENVOY_LOG(trace, "BSON timestamp: {}", value);
-      addTimestamp(key, value);
+      fields_.emplace_back(new FieldImpl(Field::Type::TIMESTAMP, key, value));
       break;
     }
 
     case Field::Type::INT64: {
       int64_t value = BufferHelper::removeInt64(data);
       ENVOY_LOG(trace, "BSON int64: {}", value);
-      addInt64(key, value);
+      fields_.emplace_back(new FieldImpl(Field::Type::INT64, key, value));
+      break;
+    }
+
+    default:
+      NOT_REACHED;
+    }
+  }
+
+  raw_.reset();
+}
+
+void DocumentImpl::validate(const uint8_t* data, uint64_t length) {
+  // Walk the elements of the document, and of the documents embedded in it, without decoding them.
+  // Each element is a type byte, a key CString and a value whose size depends on the type.
+  auto read_int32 = [data](uint64_t offset) -> int32_t {
+    int32_t value;
+    std::memcpy(&value, data + offset, sizeof(int32_t));
+    return le32toh(value);
+  };
+  auto cstring_end = [data, length](uint64_t offset) -> uint64_t {
+    const void* end = std::memchr(data + offset, '\0', length - 1 - offset);
+    if (end == nullptr) {
+      throw EnvoyException("invalid CString");
+    }
+    return static_cast<const uint8_t*>(end) - data;
+  };
+
+  if (data[length - 1] != 0) {
+    throw EnvoyException("invalid document");
+  }
+
+  const uint64_t end = length - 1;
+  uint64_t offset = sizeof(int32_t);
+  while (offset < end) {
+    const uint8_t element_type = data[offset++];
+    const uint64_t key_end = cstring_end(offset);
+    const uint64_t value_offset = key_end + 1;
+
+    int64_t value_size;
+    switch (static_cast<Field::Type>(element_type)) {
+    case Field::Type::DOUBLE:
+    case Field::Type::DATETIME:
+    case Field::Type::TIMESTAMP:
+    case Field::Type::INT64: {
+      value_size = sizeof(int64_t);
+      break;
+    }
+
+    case Field::Type::STRING:
+    case Field::Type::BINARY: {
+      if (value_offset + sizeof(int32_t) > end) {
+        throw EnvoyException("invalid buffer size");
+      }
+      // Strings include their terminating null, binaries are followed by a subtype byte.
+      const int32_t size = read_int32(value_offset);
+      const bool string = static_cast<Field::Type>(element_type) == Field::Type::STRING;
+      if (size < (string ? 1 : 0)) {
+        throw EnvoyException("invalid BSON string length");
+      }
+      value_size = static_cast<int64_t>(sizeof(int32_t)) + size + (string ? 0 : 1);
+      break;
+    }
+
+    case Field::Type::DOCUMENT:
+    case Field::Type::ARRAY: {
+      if (value_offset + sizeof(int32_t) > end) {
+        throw EnvoyException("invalid buffer size");
+      }
+      value_size = read_int32(value_offset);
+      if (value_size < 5 || value_offset + value_size > end) {
+        throw EnvoyException("invalid BSON message length");
+      }
+      validate(data + value_offset, value_size);
+      break;
+    }
+
+    case Field::Type::OBJECT_ID: {
+      value_size = sizeof(Field::ObjectId);
+      break;
+    }
+
+    case Field::Type::BOOLEAN: {
+      value_size = 1;
+      break;
+    }
+
+    case Field::Type::NULL_VALUE: {
+      value_size = 0;
+      break;
+    }
+
+    case Field::Type::REGEX: {
+      // Pattern and options CStrings.
+      value_size = cstring_end(cstring_end(value_offset) + 1) + 1 - value_offset;
+      break;
+    }
+
+    case Field::Type::INT32: {
+      value_size = sizeof(int32_t);
       break;
     }
 
     default:
       throw EnvoyException(
-          fmt::format("invalid BSON element type: {:#x} key: {}", element_type, key));
+          fmt::format("invalid BSON element type: {:#x} key: {}", element_type,
+                      std::string(reinterpret_cast<const char*>(data + offset), key_end - offset)));
     }
+
+    if (value_offset + value_size > end) {
+      throw EnvoyException("invalid buffer size");
+    }
+    offset = value_offset + value_size;
   }
 }
 
 int32_t DocumentImpl::byteSize() const {
+  if (raw_) {
+    return raw_->length();
+  }
+
   // Minimum size is 5.
   int32_t total_size = sizeof(int32_t) + 1;
   for (const FieldPtr& field : fields_) {
@@ -489,6 +610,11 @@ int32_t DocumentImpl::byteSize() const {
 }
 
 void DocumentImpl::encode(Buffer::Instance& output) const {
+  if (raw_) {
+    output.add(*raw_);
+    return;
+  }
+
   BufferHelper::writeInt32(output, byteSize());
   for (const FieldPtr& field : fields_) {
     field->encode(output);
@@ -515,6 +641,7 @@ bool DocumentImpl::operator==(const Document& rhs) const {
 }
 
 std::string DocumentImpl::toString() const {
+  decode();
   std::stringstream out;
   out << "{";
 
@@ -533,6 +660,7 @@ std::string DocumentImpl::toString() const {
 }
 
 const Field* DocumentImpl::find(const std::string& name) const {
+  decode();
   for (const FieldPtr& field : fields_) {
     if (field->key() == name) {
       return field.get();
@@ -543,6 +671,7 @@ const Field* DocumentImpl::find(const std::string& name) const {
 }
 
 const Field* DocumentImpl::find(const std::string& name, Field::Type type) const {
+  decode();
   for (const FieldPtr& field : fields_) {
     if (field->key() == name && field->type() == type) {
       return field.get();
@@ -168,6 +168,12 @@ private:
   Value value_;
 };
 
+/**
+ * A BSON document. Documents decoded from a buffer keep the raw bytes and only decode them into
+ * fields once the fields are accessed, so that documents which are only passed along, or only
+ * measured, are never materialized. The raw bytes are validated when the document is created so
+ * that malformed documents are still rejected while decoding the message that contains them.
+ */
 class DocumentImpl : public Document,
                      Logger::Loggable<Logger::Id::mongo>,
                      public std::enable_shared_from_this<DocumentImpl> {
@@ -175,74 +181,61 @@ public:
   static DocumentSharedPtr create() { return DocumentSharedPtr{new DocumentImpl()}; }
   static DocumentSharedPtr create(Buffer::Instance& data) {
     std::shared_ptr<DocumentImpl> new_doc{new DocumentImpl()};
-    new_doc->fromBuffer(data);
+    new_doc->fromBuffer(data, true);
     return new_doc;
   }
 
   // Mongo::Document
   DocumentSharedPtr addDouble(const std::string& key, double value) override {
-    fields_.emplace_back(new FieldImpl(key, value));
-    return shared_from_this();
+    return addField(new FieldImpl(key, value));
   }
 
   DocumentSharedPtr addString(const std::string& key, std::string&& value) override {
-    fields_.emplace_back(new FieldImpl(Field::Type::STRING, key, std::move(value)));
-    return shared_from_this();
+    return addField(new FieldImpl(Field::Type::STRING, key, std::move(value)));
   }
 
   DocumentSharedPtr addDocument(const std::string& key, DocumentSharedPtr value) override {
-    fields_.emplace_back(new FieldImpl(Field::Type::DOCUMENT, key, value));
-    return shared_from_this();
+    return addField(new FieldImpl(Field::Type::DOCUMENT, key, value));
   }
 
   DocumentSharedPtr addArray(const std::string& key, DocumentSharedPtr value) override {
-    fields_.emplace_back(new FieldImpl(Field::Type::ARRAY, key, value));
-    return shared_from_this();
+    return addField(new FieldImpl(Field::Type::ARRAY, key, value));
   }
 
   DocumentSharedPtr addBinary(const std::string& key, std::string&& value) override {
-    fields_.emplace_back(new FieldImpl(Field::Type::BINARY, key, std::move(value)));
-    return shared_from_this();
+    return addField(new FieldImpl(Field::Type::BINARY, key, std::move(value)));
   }
 
   DocumentSharedPtr addObjectId(const std::string& key, Field::ObjectId&& value) override {
-    fields_.emplace_back(new FieldImpl(key, std::move(value)));
-    return shared_from_this();
+    return addField(new FieldImpl(key, std::move(value)));
   }
 
   DocumentSharedPtr addBoolean(const std::string& key, bool value) override {
-    fields_.emplace_back(new FieldImpl(key, value));
-    return shared_from_this();
+    return addField(new FieldImpl(key, value));
   }
 
   DocumentSharedPtr addDatetime(const std::string& key, int64_t value) override {
-    fields_.emplace_back(new FieldImpl(Field::Type::DATETIME, key, value));
-    return shared_from_this();
+    return addField(new FieldImpl(Field::Type::DATETIME, key, value));
   }
 
   DocumentSharedPtr addNull(const std::string& key) override {
-    fields_.emplace_back(new FieldImpl(key));
-    return shared_from_this();
+    return addField(new FieldImpl(key));
   }
 
   DocumentSharedPtr addRegex(const std::string& key, Field::Regex&& value) override {
-    fields_.emplace_back(new FieldImpl(key, std::move(value)));
-    return shared_from_this();
+    return addField(new FieldImpl(key, std::move(value)));
   }
 
   DocumentSharedPtr addInt32(const std::string& key, int32_t value) override {
-    fields_.emplace_back(new FieldImpl(key, value));
-    return shared_from_this();
+    return addField(new FieldImpl(key, value));
   }
 
   DocumentSharedPtr addTimestamp(const std::string& key, int64_t value) override {
-    fields_.emplace_back(new FieldImpl(Field::Type::TIMESTAMP, key, value));
-    return shared_from_this();
+    return addField(new FieldImpl(Field::Type::TIMESTAMP, key, value));
   }
 
   DocumentSharedPtr addInt64(const std::string& key, int64_t value) override {
-    fields_.emplace_back(new FieldImpl(Field::Type::INT64, key, value));
-    return shared_from_this();
+    return addField(new FieldImpl(Field::Type::INT64, key, value));
   }
 
   bool operator==(const Document& rhs) const override;
@@ -251,14 +244,29 @@ public:
   const Field* find(const std::string& name) const override;
   const Field* find(const std::string& name, Field::Type type) const override;
   std::string toString() const override;
-  const std::list<FieldPtr>& values() const override { return fields_; }
+  const std::list<FieldPtr>& values() const override {
+    decode();
+    return fields_;
+  }
 
 private:
   DocumentImpl() {}
 
-  void fromBuffer(Buffer::Instance& data);
+  DocumentSharedPtr addField(FieldImpl* field) {
+    decode();
+    fields_.emplace_back(field);
+    return shared_from_this();
+  }
+
+  // Embedded documents are validated along with the document that contains them.
+  static DocumentSharedPtr createValidated(Buffer::Instance& data);
+  void fromBuffer(Buffer::Instance& data, bool validate_document);
+  void decode() const;
+  static void validate(const uint8_t* data, uint64_t length);
 
-  std::list<FieldPtr> fields_;
+  // The raw bytes of a document decoded from a buffer, until its fields are decoded.
+  mutable std::unique_ptr<Buffer::Instance> raw_;
+  mutable std::list<FieldPtr> fields_;
 };
 
 } // namespace Bson
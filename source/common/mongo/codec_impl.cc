@@ -42,7 +42,9 @@ void GetMoreMessageImpl::fromBuffer(uint32_t, Buffer::Instance& data) {
   full_collection_name_ = Bson::BufferHelper::removeCString(data);
   number_to_return_ = Bson::BufferHelper::removeInt32(data);
   cursor_id_ = Bson::BufferHelper::removeInt64(data);
-  ENVOY_LOG(trace, "{}", toString(true));
+  if (ENVOY_LOG_CHECK_LEVEL(trace)) {
+    ENVOY_LOG(trace, "{}", toString(true));
+  }
 }
 
 bool GetMoreMessageImpl::operator==(const GetMoreMessage& rhs) const {
@@ -69,7 +71,9 @@ void InsertMessageImpl::fromBuffer(uint32_t message_length, Buffer::Instance& da
     documents_.emplace_back(Bson::DocumentImpl::create(data));
   }
 
-  ENVOY_LOG(trace, "{}", toString(true));
+  if (ENVOY_LOG_CHECK_LEVEL(trace)) {
+    ENVOY_LOG(trace, "{}", toString(true));
+  }
 }
 
 bool InsertMessageImpl::operator==(const InsertMessage& rhs) const {
@@ -105,7 +109,9 @@ void KillCursorsMessageImpl::fromBuffer(uint32_t, Buffer::Instance& data) {
     cursor_ids_.push_back(Bson::BufferHelper::removeInt64(data));
   }
 
-  ENVOY_LOG(trace, "{}", toString(true));
+  if (ENVOY_LOG_CHECK_LEVEL(trace)) {
+    ENVOY_LOG(trace, "{}", toString(true));
+  }
 }
 
 bool KillCursorsMessageImpl::operator==(const KillCursorsMessage& rhs) const {
@@ -146,7 +152,9 @@ void QueryMessageImpl::fromBuffer(uint32_t message_length, Buffer::Instance& dat
     return_fields_selector_ = Bson::DocumentImpl::create(data);
   }
 
-  ENVOY_LOG(trace, "{}", toString(true));
+  if (ENVOY_LOG_CHECK_LEVEL(trace)) {
+    ENVOY_LOG(trace, "{}", toString(true));
+  }
 }
 
 bool QueryMessageImpl::operator==(const QueryMessage& rhs) const {
@@ -191,7 +199,9 @@ void ReplyMessageImpl::fromBuffer(uint32_t, Buffer::Instance& data) {
     documents_.emplace_back(Bson::DocumentImpl::create(data));
   }
 
-  ENVOY_LOG(trace, "{}", toString(true));
+  if (ENVOY_LOG_CHECK_LEVEL(trace)) {
+    ENVOY_LOG(trace, "{}", toString(true));
+  }
 }
 
 bool ReplyMessageImpl::operator==(const ReplyMessage& rhs) const {
@@ -243,6 +253,12 @@ bool DecoderImpl::decode(Buffer::Instance& data) {
   // parsed off before passing the final value.
   message_length -= 16;
 
+  if (!callbacks_.shouldDecode(op_code, response_to)) {
+    ENVOY_LOG(trace, "skipping {} bytes", message_length);
+    data.drain(message_length);
+    return true;
+  }
+
   switch (op_code) {
   case Message::OpCode::OP_REPLY: {
     std::unique_ptr<ReplyMessageImpl> message(new ReplyMessageImpl(request_id, response_to));
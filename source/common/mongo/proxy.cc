@@ -1,5 +1,6 @@
 #include "common/mongo/proxy.h"
 
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
 #include <string>
@@ -53,12 +54,72 @@ ProxyFilter::ProxyFilter(const std::string& stat_prefix, Stats::Scope& scope,
 
 ProxyFilter::~ProxyFilter() { ASSERT(!delay_timer_); }
 
+bool ProxyFilter::shouldDecode(Message::OpCode op_code, int32_t response_to) {
+  const uint64_t interval = std::max<uint64_t>(
+      1, runtime_.snapshot().getInteger(MongoRuntimeConfig::get().DecodeSampleInterval, 1));
+  decode_scale_ = interval;
+  if (interval == 1) {
+    return true;
+  }
+
+  Stats::Counter* op_counter;
+  switch (op_code) {
+  case Message::OpCode::OP_REPLY: {
+    // Replies are decoded when they answer a query that was decoded.
+    for (const ActiveQueryPtr& active_query : active_query_list_) {
+      if (active_query->query_info_.requestId() == response_to) {
+        return true;
+      }
+    }
+
+    stats_.op_reply_.inc();
+    checkDrainClose();
+    return false;
+  }
+
+  case Message::OpCode::OP_QUERY: {
+    op_counter = &stats_.op_query_;
+    break;
+  }
+
+  case Message::OpCode::OP_GET_MORE: {
+    op_counter = &stats_.op_get_more_;
+    break;
+  }
+
+  case Message::OpCode::OP_INSERT: {
+    op_counter = &stats_.op_insert_;
+    break;
+  }
+
+  case Message::OpCode::OP_KILL_CURSORS: {
+    op_counter = &stats_.op_kill_cursors_;
+    break;
+  }
+
+  default:
+    // Let the decoder deal with op codes it does not support.
+    return true;
+  }
+
+  if (++requests_since_decode_ >= interval) {
+    requests_since_decode_ = 0;
+    return true;
+  }
+
+  tryInjectDelay();
+  op_counter->inc();
+  return false;
+}
+
 void ProxyFilter::decodeGetMore(GetMoreMessagePtr&& message) {
   tryInjectDelay();
 
   stats_.op_get_more_.inc();
   logMessage(*message, true);
-  ENVOY_LOG(debug, "decoded GET_MORE: {}", message->toString(true));
+  if (ENVOY_LOG_CHECK_LEVEL(debug)) {
+    ENVOY_LOG(debug, "decoded GET_MORE: {}", message->toString(true));
+  }
 }
 
 void ProxyFilter::decodeInsert(InsertMessagePtr&& message) {
@@ -66,7 +127,9 @@ void ProxyFilter::decodeInsert(InsertMessagePtr&& message) {
 
   stats_.op_insert_.inc();
   logMessage(*message, true);
-  ENVOY_LOG(debug, "decoded INSERT: {}", message->toString(true));
+  if (ENVOY_LOG_CHECK_LEVEL(debug)) {
+    ENVOY_LOG(debug, "decoded INSERT: {}", message->toString(true));
+  }
 }
 
 void ProxyFilter::decodeKillCursors(KillCursorsMessagePtr&& message) {
@@ -74,7 +137,9 @@ void ProxyFilter::decodeKillCursors(KillCursorsMessagePtr&& message) {
 
   stats_.op_kill_cursors_.inc();
   logMessage(*message, true);
-  ENVOY_LOG(debug, "decoded KILL_CURSORS: {}", message->toString(true));
+  if (ENVOY_LOG_CHECK_LEVEL(debug)) {
+    ENVOY_LOG(debug, "decoded KILL_CURSORS: {}", message->toString(true));
+  }
 }
 
 void ProxyFilter::decodeQuery(QueryMessagePtr&& message) {
@@ -82,26 +147,28 @@ void ProxyFilter::decodeQuery(QueryMessagePtr&& message) {
 
   stats_.op_query_.inc();
   logMessage(*message, true);
-  ENVOY_LOG(debug, "decoded QUERY: {}", message->toString(true));
+  if (ENVOY_LOG_CHECK_LEVEL(debug)) {
+    ENVOY_LOG(debug, "decoded QUERY: {}", message->toString(true));
+  }
 
   if (message->flags() & QueryMessage::Flags::TailableCursor) {
-    stats_.op_query_tailable_cursor_.inc();
+    stats_.op_query_tailable_cursor_.add(decode_scale_);
   }
   if (message->flags() & QueryMessage::Flags::NoCursorTimeout) {
-    stats_.op_query_no_cursor_timeout_.inc();
+    stats_.op_query_no_cursor_timeout_.add(decode_scale_);
   }
   if (message->flags() & QueryMessage::Flags::AwaitData) {
-    stats_.op_query_await_data_.inc();
+    stats_.op_query_await_data_.add(decode_scale_);
   }
   if (message->flags() & QueryMessage::Flags::Exhaust) {
-    stats_.op_query_exhaust_.inc();
+    stats_.op_query_exhaust_.add(decode_scale_);
   }
 
   ActiveQueryPtr active_query(new ActiveQuery(*this, *message));
   if (!active_query->query_info_.command().empty()) {
     // First field key is the operation.
     scope_.counter(fmt::format("{}cmd.{}.total", stat_prefix_, active_query->query_info_.command()))
-        .inc();
+        .add(decode_scale_);
   } else {
     // Normal query, get stats on a per collection basis first.
     std::string collection_stat_prefix =
@@ -119,12 +186,12 @@ void ProxyFilter::decodeQuery(QueryMessagePtr&& message) {
 
     // Global stats.
     if (active_query->query_info_.max_time() < 1) {
-      stats_.op_query_no_max_time_.inc();
+      stats_.op_query_no_max_time_.add(decode_scale_);
     }
     if (query_type == QueryMessageInfo::QueryType::ScatterGet) {
-      stats_.op_query_scatter_get_.inc();
+      stats_.op_query_scatter_get_.add(decode_scale_);
     } else if (query_type == QueryMessageInfo::QueryType::MultiGet) {
-      stats_.op_query_multi_get_.inc();
+      stats_.op_query_multi_get_.add(decode_scale_);
     }
   }
 
@@ -133,27 +200,29 @@ void ProxyFilter::decodeQuery(QueryMessagePtr&& message) {
 
 void ProxyFilter::chargeQueryStats(const std::string& prefix,
                                    QueryMessageInfo::QueryType query_type) {
-  scope_.counter(fmt::format("{}.query.total", prefix)).inc();
+  scope_.counter(fmt::format("{}.query.total", prefix)).add(decode_scale_);
   if (query_type == QueryMessageInfo::QueryType::ScatterGet) {
-    scope_.counter(fmt::format("{}.query.scatter_get", prefix)).inc();
+    scope_.counter(fmt::format("{}.query.scatter_get", prefix)).add(decode_scale_);
   } else if (query_type == QueryMessageInfo::QueryType::MultiGet) {
-    scope_.counter(fmt::format("{}.query.multi_get", prefix)).inc();
+    scope_.counter(fmt::format("{}.query.multi_get", prefix)).add(decode_scale_);
   }
 }
 
 void ProxyFilter::decodeReply(ReplyMessagePtr&& message) {
   stats_.op_reply_.inc();
   logMessage(*message, false);
-  ENVOY_LOG(debug, "decoded REPLY: {}", message->toString(true));
+  if (ENVOY_LOG_CHECK_LEVEL(debug)) {
+    ENVOY_LOG(debug, "decoded REPLY: {}", message->toString(true));
+  }
 
   if (message->cursorId() != 0) {
-    stats_.op_reply_valid_cursor_.inc();
+    stats_.op_reply_valid_cursor_.add(decode_scale_);
   }
   if (message->flags() & ReplyMessage::Flags::CursorNotFound) {
-    stats_.op_reply_cursor_not_found_.inc();
+    stats_.op_reply_cursor_not_found_.add(decode_scale_);
   }
   if (message->flags() & ReplyMessage::Flags::QueryFailure) {
-    stats_.op_reply_query_failure_.inc();
+    stats_.op_reply_query_failure_.add(decode_scale_);
   }
 
   for (auto i = active_query_list_.begin(); i != active_query_list_.end(); i++) {
@@ -185,6 +254,10 @@ void ProxyFilter::decodeReply(ReplyMessagePtr&& message) {
     break;
   }
 
+  checkDrainClose();
+}
+
+void ProxyFilter::checkDrainClose() {
   if (active_query_list_.empty() && drain_decision_.drainClose() &&
       runtime_.snapshot().featureEnabled(MongoRuntimeConfig::get().DrainCloseEnabled, 100)) {
     ENVOY_LOG(debug, "drain closing mongo connection");
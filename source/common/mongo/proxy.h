@@ -37,6 +37,7 @@ public:
   const std::string ProxyEnabled{"mongo.proxy_enabled"};
   const std::string ConnectionLoggingEnabled{"mongo.connection_logging_enabled"};
   const std::string DrainCloseEnabled{"mongo.drain_close_enabled"};
+  const std::string DecodeSampleInterval{"mongo.decode_sample_interval"};
 };
 
 typedef ConstSingleton<MongoRuntimeConfigKeys> MongoRuntimeConfig;
@@ -113,6 +114,11 @@ typedef std::shared_ptr<const FaultConfig> FaultConfigSharedPtr;
 /**
  * A sniffing filter for mongo traffic. The current implementation makes a copy of read/written
  * data, decodes it, and generates stats.
+ *
+ * When the mongo.decode_sample_interval runtime key is N > 1, only one in N requests is decoded,
+ * along with the replies to the queries among them, and the rest only have their header parsed.
+ * The op_* counters still count every message. Stats that need the rest of a message are charged
+ * N times for each decoded message. Access log entries are only written for decoded messages.
  */
 class ProxyFilter : public Network::Filter,
                     public DecoderCallbacks,
@@ -138,6 +144,7 @@ public:
   Network::FilterStatus onWrite(Buffer::Instance& data) override;
 
   // Mongo::DecoderCallback
+  bool shouldDecode(Message::OpCode op_code, int32_t response_to) override;
   void decodeGetMore(GetMoreMessagePtr&& message) override;
   void decodeInsert(InsertMessagePtr&& message) override;
   void decodeKillCursors(KillCursorsMessagePtr&& message) override;
@@ -174,6 +181,7 @@ private:
   void chargeQueryStats(const std::string& prefix, QueryMessageInfo::QueryType query_type);
   void chargeReplyStats(ActiveQuery& active_query, const std::string& prefix,
                         const ReplyMessage& message);
+  void checkDrainClose();
   void doDecode(Buffer::Instance& buffer);
   void logMessage(Message& message, bool full);
   void onDrainClose();
@@ -196,6 +204,10 @@ private:
   const FaultConfigSharedPtr fault_config_;
   Event::TimerPtr delay_timer_;
   Event::TimerPtr drain_close_timer_;
+  // Requests seen since the last one that was decoded, and how many messages the stats of the
+  // message that is being decoded stand for.
+  uint64_t requests_since_decode_{};
+  uint64_t decode_scale_{1};
 };
 
 class ProdProxyFilter : public ProxyFilter {
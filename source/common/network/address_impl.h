@@ -7,6 +7,7 @@
 
 #include <array>
 #include <cstdint>
+#include <mutex>
 #include <string>
 
 #include "envoy/network/address.h"
@@ -41,13 +42,14 @@ InstanceConstSharedPtr addressFromFd(int fd);
 InstanceConstSharedPtr peerAddressFromFd(int fd);
 
 /**
- * Base class for all address types.
+ * Base class for all address types. The human-readable name is formatted on first use, so that
+ * the addresses of accepted connections only pay for it if something logs or compares them.
  */
 class InstanceBase : public Instance {
 public:
   // Network::Address::Instance
   bool operator==(const Instance& rhs) const override { return asString() == rhs.asString(); }
-  const std::string& asString() const override { return friendly_name_; }
+  const std::string& asString() const override;
   // Default logical name is the human-readable name.
   const std::string& logicalName() const override { return asString(); }
   Type type() const override { return type_; }
@@ -56,10 +58,16 @@ protected:
   InstanceBase(Type type) : type_(type) {}
   int socketFromSocketType(SocketType type) const;
 
-  std::string friendly_name_;
+  /**
+   * @return std::string the human-readable name of the address. Called at most once.
+   */
+  virtual std::string makeFriendlyName() const PURE;
 
 private:
   const Type type_;
+  // Addresses are shared across threads, so the name is set under a once flag.
+  mutable std::once_flag friendly_name_once_;
+  mutable std::string friendly_name_;
 };
 
 /**
@@ -98,11 +106,13 @@ private:
   struct Ipv4Helper : public Ipv4 {
     uint32_t address() const override { return address_.sin_addr.s_addr; }
 
+    std::string makeFriendlyAddress() const;
+
     sockaddr_in address_;
   };
 
   struct IpHelper : public Ip {
-    const std::string& addressAsString() const override { return friendly_address_; }
+    const std::string& addressAsString() const override;
     bool isAnyAddress() const override { return ipv4_.address_.sin_addr.s_addr == INADDR_ANY; }
     bool isUnicastAddress() const override {
       return !isAnyAddress() && (ipv4_.address_.sin_addr.s_addr != INADDR_BROADCAST) &&
@@ -115,9 +125,13 @@ private:
     IpVersion version() const override { return IpVersion::v4; }
 
     Ipv4Helper ipv4_;
-    std::string friendly_address_;
+    mutable std::once_flag friendly_address_once_;
+    mutable std::string friendly_address_;
   };
 
+  // InstanceBase
+  std::string makeFriendlyName() const override;
+
   IpHelper ip_;
 };
 
@@ -164,7 +178,7 @@ private:
   };
 
   struct IpHelper : public Ip {
-    const std::string& addressAsString() const override { return friendly_address_; }
+    const std::string& addressAsString() const override;
     bool isAnyAddress() const override {
       return 0 == memcmp(&ipv6_.address_.sin6_addr, &in6addr_any, sizeof(struct in6_addr));
     }
@@ -177,9 +191,13 @@ private:
     IpVersion version() const override { return IpVersion::v6; }
 
     Ipv6Helper ipv6_;
-    std::string friendly_address_;
+    mutable std::once_flag friendly_address_once_;
+    mutable std::string friendly_address_;
   };
 
+  // InstanceBase
+  std::string makeFriendlyName() const override;
+
   IpHelper ip_;
 };
 
@@ -205,6 +223,9 @@ public:
   int socket(SocketType type) const override;
 
 private:
+  // InstanceBase
+  std::string makeFriendlyName() const override { return address_.sun_path; }
+
   sockaddr_un address_;
 };
 
@@ -0,0 +1,94 @@
+#include "common/network/caching_dns_resolver.h"
+
+#include "common/common/assert.h"
+
+namespace Envoy {
+namespace Network {
+
+CachingDnsResolver::CachingDnsResolver(DnsResolverSharedPtr resolver,
+                                       std::chrono::milliseconds ttl,
+                                       MonotonicTimeSource& time_source, Stats::Scope& scope)
+    : resolver_(resolver), ttl_(ttl), time_source_(time_source),
+      stats_({ALL_DNS_CACHE_STATS(POOL_COUNTER_PREFIX(scope, "dns_cache."),
+                                  POOL_GAUGE_PREFIX(scope, "dns_cache."))}) {}
+
+CachingDnsResolver::~CachingDnsResolver() {
+  // The queries in flight refer to this resolver, and the handles of the lookups that wait for
+  // them become invalid now.
+  for (auto& query : queries_) {
+    if (query.second->active_) {
+      query.second->active_->cancel();
+    }
+  }
+}
+
+ActiveDnsQuery* CachingDnsResolver::resolve(const std::string& dns_name,
+                                            DnsLookupFamily dns_lookup_family,
+                                            ResolveCb callback) {
+  const Key key(dns_name, dns_lookup_family);
+  auto entry = cache_.find(key);
+  if (entry != cache_.end()) {
+    if (time_source_.currentTime() < entry->second.expiry_) {
+      stats_.hit_.inc();
+      callback(std::list<Address::InstanceConstSharedPtr>(entry->second.address_list_));
+      return nullptr;
+    }
+    cache_.erase(entry);
+    stats_.entries_.set(cache_.size());
+  }
+
+  auto in_flight = queries_.find(key);
+  if (in_flight != queries_.end()) {
+    stats_.coalesced_.inc();
+    return addWaiter(*in_flight->second, callback);
+  }
+
+  stats_.miss_.inc();
+  // Held here since the resolver may complete the query before it returns, which removes it from
+  // queries_ and invalidates the handle of the waiter.
+  QuerySharedPtr query = std::make_shared<Query>();
+  queries_.emplace(key, query);
+  ActiveDnsQuery* waiter = addWaiter(*query, callback);
+  ActiveDnsQuery* active = resolver_->resolve(
+      dns_name, dns_lookup_family,
+      [this, key](std::list<Address::InstanceConstSharedPtr>&& address_list) -> void {
+        onResolved(key, std::move(address_list));
+      });
+  if (query->completed_) {
+    return nullptr;
+  }
+
+  query->active_ = active;
+  return waiter;
+}
+
+ActiveDnsQuery* CachingDnsResolver::addWaiter(Query& query, ResolveCb callback) {
+  WaiterPtr waiter(new Waiter(query, callback));
+  ActiveDnsQuery* handle = waiter.get();
+  waiter->moveIntoListBack(std::move(waiter), query.waiters_);
+  return handle;
+}
+
+void CachingDnsResolver::onResolved(const Key& key,
+                                    std::list<Address::InstanceConstSharedPtr>&& address_list) {
+  auto it = queries_.find(key);
+  ASSERT(it != queries_.end());
+  QuerySharedPtr query = it->second;
+  queries_.erase(it);
+  query->completed_ = true;
+
+  if (!address_list.empty() && ttl_.count() > 0) {
+    cache_[key] = {time_source_.currentTime() + ttl_, address_list};
+    stats_.entries_.set(cache_.size());
+  }
+
+  // The callbacks may cancel lookups that wait for the same query, so each waiter is unlinked
+  // before its callback runs.
+  while (!query->waiters_.empty()) {
+    WaiterPtr waiter = query->waiters_.front()->removeFromList(query->waiters_);
+    waiter->callback_(std::list<Address::InstanceConstSharedPtr>(address_list));
+  }
+}
+
+} // namespace Network
+} // namespace Envoy
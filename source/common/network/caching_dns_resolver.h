@@ -0,0 +1,103 @@
+#pragma once
+
+#include <chrono>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "envoy/common/time.h"
+#include "envoy/network/dns.h"
+#include "envoy/stats/stats.h"
+#include "envoy/stats/stats_macros.h"
+
+#include "common/common/linked_object.h"
+
+namespace Envoy {
+namespace Network {
+
+/**
+ * All DNS cache stats. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_DNS_CACHE_STATS(COUNTER, GAUGE)                                                        \
+  COUNTER(hit)                                                                                     \
+  COUNTER(miss)                                                                                    \
+  COUNTER(coalesced)                                                                               \
+  GAUGE  (entries)
+// clang-format on
+
+/**
+ * Struct definition for all DNS cache stats. @see stats_macros.h
+ */
+struct DnsCacheStats {
+  ALL_DNS_CACHE_STATS(GENERATE_COUNTER_STRUCT, GENERATE_GAUGE_STRUCT)
+};
+
+/**
+ * DnsResolver that is shared by every cluster that resolves through the server's resolver. Lookups
+ * of a name that is already being resolved wait for that resolution rather than sending a query of
+ * their own, and non-empty results answer lookups of the same name for the cache TTL. Failures are
+ * not cached. All calls happen on the thread of the wrapped resolver.
+ */
+class CachingDnsResolver : public DnsResolver {
+public:
+  /**
+   * @param resolver supplies the resolver that sends the queries.
+   * @param ttl supplies how long results are cached. 0 only coalesces concurrent lookups.
+   * @param time_source supplies the time source the cache TTL is measured with.
+   * @param scope supplies the scope of the cache stats.
+   */
+  CachingDnsResolver(DnsResolverSharedPtr resolver, std::chrono::milliseconds ttl,
+                     MonotonicTimeSource& time_source, Stats::Scope& scope);
+  ~CachingDnsResolver();
+
+  // Network::DnsResolver
+  ActiveDnsQuery* resolve(const std::string& dns_name, DnsLookupFamily dns_lookup_family,
+                          ResolveCb callback) override;
+
+private:
+  typedef std::pair<std::string, DnsLookupFamily> Key;
+
+  struct Query;
+
+  struct Waiter : public ActiveDnsQuery, LinkedObject<Waiter> {
+    Waiter(Query& query, ResolveCb callback) : query_(query), callback_(callback) {}
+
+    // Network::ActiveDnsQuery
+    void cancel() override { removeFromList(query_.waiters_); }
+
+    Query& query_;
+    const ResolveCb callback_;
+  };
+
+  typedef std::unique_ptr<Waiter> WaiterPtr;
+
+  // A query that is in flight and the lookups that wait for it.
+  struct Query {
+    ActiveDnsQuery* active_{};
+    bool completed_{};
+    std::list<WaiterPtr> waiters_;
+  };
+
+  typedef std::shared_ptr<Query> QuerySharedPtr;
+
+  struct Entry {
+    MonotonicTime expiry_;
+    std::list<Address::InstanceConstSharedPtr> address_list_;
+  };
+
+  ActiveDnsQuery* addWaiter(Query& query, ResolveCb callback);
+  void onResolved(const Key& key, std::list<Address::InstanceConstSharedPtr>&& address_list);
+
+  DnsResolverSharedPtr resolver_;
+  const std::chrono::milliseconds ttl_;
+  MonotonicTimeSource& time_source_;
+  DnsCacheStats stats_;
+  std::map<Key, QuerySharedPtr> queries_;
+  std::map<Key, Entry> cache_;
+};
+
+} // namespace Network
+} // namespace Envoy
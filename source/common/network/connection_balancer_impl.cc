@@ -0,0 +1,43 @@
+#include "common/network/connection_balancer_impl.h"
+
+#include <algorithm>
+
+namespace Envoy {
+namespace Network {
+
+void ConnectionBalancerImpl::registerHandler(BalancedConnectionHandler& handler) {
+  std::unique_lock<std::mutex> lock(lock_);
+  handlers_.push_back(&handler);
+}
+
+void ConnectionBalancerImpl::unregisterHandler(BalancedConnectionHandler& handler) {
+  std::unique_lock<std::mutex> lock(lock_);
+  handlers_.erase(std::remove(handlers_.begin(), handlers_.end(), &handler), handlers_.end());
+}
+
+bool ConnectionBalancerImpl::balance(BalancedConnectionHandler& current, int fd,
+                                     Address::InstanceConstSharedPtr remote_address,
+                                     Address::InstanceConstSharedPtr local_address,
+                                     bool using_original_dst) {
+  std::unique_lock<std::mutex> lock(lock_);
+  BalancedConnectionHandler* target = &current;
+  uint64_t min_connections = current.numConnections();
+  for (BalancedConnectionHandler* handler : handlers_) {
+    const uint64_t connections = handler->numConnections();
+    if (connections < min_connections) {
+      target = handler;
+      min_connections = connections;
+    }
+  }
+
+  if (target == &current) {
+    return false;
+  }
+
+  // Post while holding the lock so that the target cannot unregister and go away in between.
+  target->post(fd, remote_address, local_address, using_original_dst);
+  return true;
+}
+
+} // namespace Network
+} // namespace Envoy
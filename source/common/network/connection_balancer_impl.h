@@ -0,0 +1,31 @@
+#pragma once
+
+#include <mutex>
+#include <vector>
+
+#include "envoy/network/listener.h"
+
+namespace Envoy {
+namespace Network {
+
+/**
+ * Balancer that hands each accepted socket to the handler with the fewest connections. All
+ * decisions are made under one lock, so it is only meant for listeners whose connections are long
+ * lived enough that the kernel's distribution across workers leaves them skewed.
+ */
+class ConnectionBalancerImpl : public ConnectionBalancer {
+public:
+  // Network::ConnectionBalancer
+  void registerHandler(BalancedConnectionHandler& handler) override;
+  void unregisterHandler(BalancedConnectionHandler& handler) override;
+  bool balance(BalancedConnectionHandler& current, int fd,
+               Address::InstanceConstSharedPtr remote_address,
+               Address::InstanceConstSharedPtr local_address, bool using_original_dst) override;
+
+private:
+  std::mutex lock_;
+  std::vector<BalancedConnectionHandler*> handlers_;
+};
+
+} // namespace Network
+} // namespace Envoy
@@ -1,5 +1,6 @@
 #include "common/network/connection_impl.h"
 
+#include <fcntl.h>
 #include <netinet/tcp.h>
 #include <sys/socket.h>
 #include <sys/types.h>
@@ -134,7 +135,7 @@ void ConnectionImpl::close(ConnectionCloseType type) {
     return;
   }
 
-  uint64_t data_to_write = write_buffer_->length();
+  uint64_t data_to_write = pendingWriteBytes();
   ENVOY_CONN_LOG(debug, "closing data_to_write={} type={}", *this, data_to_write, enumToInt(type));
   if (data_to_write == 0 || type == ConnectionCloseType::NoFlush ||
       !transport_socket_->canFlushClose()) {
@@ -142,6 +143,9 @@ void ConnectionImpl::close(ConnectionCloseType type) {
       // We aren't going to wait to flush, but try to write as much as we can if there is pending
       // data.
       transport_socket_->doWrite(*write_buffer_);
+      if (splice_pipe_bytes_ > 0 && write_buffer_->length() == 0) {
+        doSpliceWrite();
+      }
     }
 
     closeSocket(ConnectionEvent::LocalClose);
@@ -171,6 +175,7 @@ void ConnectionImpl::closeSocket(ConnectionEvent close_type) {
 
   ENVOY_CONN_LOG(debug, "closing socket: {}", *this, static_cast<uint32_t>(close_type));
   transport_socket_->closeSocket(close_type);
+  stopSplicing();
 
   // Drain input and output buffers.
   updateReadBufferStats(0, 0);
@@ -278,8 +283,9 @@ void ConnectionImpl::readDisable(bool disable) {
     file_event_->setEnabled(Event::FileReadyType::Read | Event::FileReadyType::Write);
     // If the connection has data buffered there's no guarantee there's also data in the kernel
     // which will kick off the filter chain. Instead fake an event to make sure the buffered data
-    // gets processed regardless.
-    if (read_buffer_.length() > 0) {
+    // gets processed regardless. The same goes for data that was left in the kernel while a pipe
+    // that the connection splices to was full.
+    if (read_buffer_.length() > 0 || splice_destination_ != nullptr) {
       file_event_->activate(Event::FileReadyType::Read);
     }
   }
@@ -297,6 +303,8 @@ bool ConnectionImpl::readEnabled() const { return state_ & InternalState::ReadEn
 
 void ConnectionImpl::addConnectionCallbacks(ConnectionCallbacks& cb) { callbacks_.push_back(&cb); }
 
+void ConnectionImpl::removeConnectionCallbacks(ConnectionCallbacks& cb) { callbacks_.remove(&cb); }
+
 void ConnectionImpl::addBytesSentCallback(BytesSentCb cb) {
   bytes_sent_callbacks_.emplace_back(cb);
 }
@@ -305,6 +313,7 @@ void ConnectionImpl::write(Buffer::Instance& data) {
   // NOTE: This is kind of a hack, but currently we don't support restart/continue on the write
   //       path, so we just pass around the buffer passed to us in this function. If we ever support
   //       buffer/restart/continue on the write path this needs to get more complicated.
+  active_since_idle_check_ = true;
   current_write_buffer_ = &data;
   FilterStatus status = filter_manager_.onWrite();
   current_write_buffer_ = nullptr;
@@ -322,6 +331,7 @@ void ConnectionImpl::write(Buffer::Instance& data) {
     // That code assumes that we never change existing write_buffer_ chain elements between calls
     // to SSL_write(). That code will have to change if we ever copy here.
     write_buffer_->move(data);
+    writes_since_flush_++;
 
     // Activating a write event before the socket is connected has the side-effect of tricking
     // doWriteReady into thinking the socket is connected. On OS X, the underlying write may fail
@@ -358,6 +368,29 @@ void ConnectionImpl::setBufferLimits(uint32_t limit) {
   }
 }
 
+bool ConnectionImpl::releaseIdleBuffers() {
+  if (active_since_idle_check_) {
+    active_since_idle_check_ = false;
+    return false;
+  }
+
+  read_buffer_.compact();
+  write_buffer_->compact();
+  return true;
+}
+
+bool ConnectionImpl::startDrain() {
+  if (state() != State::Open || drain_callbacks_.empty()) {
+    return false;
+  }
+
+  ENVOY_CONN_LOG(debug, "draining", *this);
+  for (const std::function<void()>& cb : drain_callbacks_) {
+    cb();
+  }
+  return true;
+}
+
 void ConnectionImpl::onLowWatermark() {
   ENVOY_CONN_LOG(debug, "onBelowWriteBufferLowWatermark", *this);
   ASSERT(above_high_watermark_);
@@ -378,6 +411,7 @@ void ConnectionImpl::onHighWatermark() {
 
 void ConnectionImpl::onFileEvent(uint32_t events) {
   ENVOY_CONN_LOG(trace, "socket event: {}", *this, events);
+  active_since_idle_check_ = true;
 
   if (state_ & InternalState::ImmediateConnectionError) {
     ENVOY_CONN_LOG(debug, "raising immediate connect error", *this);
@@ -421,7 +455,15 @@ void ConnectionImpl::onReadReady() {
 
   ASSERT(!(state_ & InternalState::Connecting));
 
+  if (splice_destination_ != nullptr) {
+    onSpliceReadReady();
+    return;
+  }
+
   IoResult result = transport_socket_->doRead(read_buffer_);
+  if (result.bytes_processed_ > 0 && connection_stats_ && connection_stats_->read_size_) {
+    connection_stats_->read_size_->recordValue(result.bytes_processed_);
+  }
   uint64_t new_buffer_size = read_buffer_.length();
   updateReadBufferStats(result.bytes_processed_, new_buffer_size);
   onRead(new_buffer_size);
@@ -460,8 +502,17 @@ void ConnectionImpl::onWriteReady() {
   }
 
   IoResult result = transport_socket_->doWrite(*write_buffer_);
-  uint64_t new_buffer_size = write_buffer_->length();
+  // Spliced data is only written once everything that was written to the connection before it is.
+  if (result.action_ == PostIoAction::KeepOpen && splice_pipe_bytes_ > 0 &&
+      write_buffer_->length() == 0) {
+    const IoResult splice_result = doSpliceWrite();
+    result = {splice_result.action_, result.bytes_processed_ + splice_result.bytes_processed_};
+  }
+  uint64_t new_buffer_size = pendingWriteBytes();
   updateWriteBufferStats(result.bytes_processed_, new_buffer_size);
+  if (result.bytes_processed_ > 0) {
+    recordWriteSizeStats(result.bytes_processed_);
+  }
 
   if (result.action_ == PostIoAction::Close) {
     // It is possible (though unlikely) for the connection to have already been closed during the
@@ -483,6 +534,164 @@ void ConnectionImpl::onWriteReady() {
   }
 }
 
+bool ConnectionImpl::spliceTo(Connection& destination, BytesSplicedCb cb) {
+#ifdef __linux__
+  // Spliced data bypasses the filters of both connections, so only the caller may see it.
+  ConnectionImpl* peer = dynamic_cast<ConnectionImpl*>(&destination);
+  if (peer == nullptr || splice_destination_ != nullptr || peer->splice_source_ != nullptr ||
+      !canSpliceFrom() || !peer->canSpliceTo() || read_buffer_.length() > 0 ||
+      filter_manager_.readFilterCount() > 1 || peer->filter_manager_.writeFilterCount() > 0) {
+    return false;
+  }
+
+  int fds[2];
+  if (::pipe2(fds, O_NONBLOCK | O_CLOEXEC) != 0) {
+    ENVOY_CONN_LOG(debug, "unable to create splice pipe: {}", *this, errno);
+    return false;
+  }
+  const int pipe_size = ::fcntl(fds[1], F_GETPIPE_SZ);
+
+  ENVOY_CONN_LOG(debug, "splicing to [C{}]", *this, peer->id());
+  peer->splice_pipe_[0] = fds[0];
+  peer->splice_pipe_[1] = fds[1];
+  peer->splice_pipe_size_ = pipe_size > 0 ? pipe_size : 65536;
+  peer->splice_source_ = this;
+  splice_destination_ = peer;
+  bytes_spliced_cb_ = cb;
+
+  // Pick up whatever the socket already holds.
+  if (readEnabled()) {
+    file_event_->activate(Event::FileReadyType::Read);
+  }
+  return true;
+#else
+  UNREFERENCED_PARAMETER(destination);
+  UNREFERENCED_PARAMETER(cb);
+  return false;
+#endif
+}
+
+bool ConnectionImpl::canSpliceFrom() const {
+  // Only plaintext sockets pass data on unchanged.
+  return state() == State::Open && !(state_ & InternalState::Connecting) &&
+         dynamic_cast<RawBufferSocket*>(transport_socket_.get()) != nullptr;
+}
+
+bool ConnectionImpl::canSpliceTo() const {
+  // Sockets with kernel TLS encrypt spliced data on their way out.
+  return state() == State::Open && !(state_ & InternalState::Connecting) &&
+         transport_socket_->directWritesSupported();
+}
+
+void ConnectionImpl::onSpliceReadReady() {
+#ifdef __linux__
+  if (!(state_ & InternalState::ReadEnabled)) {
+    return;
+  }
+
+  ConnectionImpl& destination = *splice_destination_;
+  PostIoAction action = PostIoAction::KeepOpen;
+  uint64_t bytes_read = 0;
+  splice_read_blocked_ = false;
+  do {
+    if (destination.splice_pipe_bytes_ >= destination.splice_pipe_size_) {
+      splice_read_blocked_ = true;
+      break;
+    }
+
+    const ssize_t rc = ::splice(fd_, nullptr, destination.splice_pipe_[1], nullptr,
+                                destination.splice_pipe_size_ - destination.splice_pipe_bytes_,
+                                SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+    ENVOY_CONN_LOG(trace, "splice read returns: {}", *this, rc);
+    if (rc == 0) {
+      action = PostIoAction::Close;
+      break;
+    } else if (rc == -1) {
+      ENVOY_CONN_LOG(trace, "splice read error: {}", *this, errno);
+      if (errno == EAGAIN) {
+        // Either the socket is drained or the pipe is full, which it can be before it holds
+        // splice_pipe_size_ bytes as every splice takes up at least one of its pages. Only the
+        // former is possible when the pipe is empty.
+        splice_read_blocked_ = destination.splice_pipe_bytes_ > 0;
+      } else {
+        action = PostIoAction::Close;
+      }
+      break;
+    } else {
+      bytes_read += rc;
+      destination.splice_pipe_bytes_ += rc;
+    }
+  } while (true);
+
+  if (bytes_read > 0) {
+    if (connection_stats_ && connection_stats_->read_size_) {
+      connection_stats_->read_size_->recordValue(bytes_read);
+    }
+    updateReadBufferStats(bytes_read, 0);
+    destination.updateWriteBufferStats(0, destination.pendingWriteBytes());
+    destination.file_event_->activate(Event::FileReadyType::Write);
+    bytes_spliced_cb_(bytes_read);
+  }
+
+  if (action == PostIoAction::Close) {
+    ENVOY_CONN_LOG(debug, "remote close", *this);
+    closeSocket(ConnectionEvent::RemoteClose);
+  }
+#else
+  NOT_REACHED;
+#endif
+}
+
+IoResult ConnectionImpl::doSpliceWrite() {
+#ifdef __linux__
+  PostIoAction action = PostIoAction::KeepOpen;
+  uint64_t bytes_written = 0;
+  while (splice_pipe_bytes_ > 0) {
+    const ssize_t rc = ::splice(splice_pipe_[0], nullptr, fd_, nullptr, splice_pipe_bytes_,
+                                SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+    ENVOY_CONN_LOG(trace, "splice write returns: {}", *this, rc);
+    if (rc <= 0) {
+      if (rc == -1 && errno != EAGAIN) {
+        ENVOY_CONN_LOG(trace, "splice write error: {}", *this, errno);
+        action = PostIoAction::Close;
+      }
+      break;
+    }
+    bytes_written += rc;
+    splice_pipe_bytes_ -= rc;
+  }
+
+  if (bytes_written > 0 && splice_source_ != nullptr && splice_source_->splice_read_blocked_) {
+    splice_source_->splice_read_blocked_ = false;
+    splice_source_->file_event_->activate(Event::FileReadyType::Read);
+  }
+  return {action, bytes_written};
+#else
+  NOT_REACHED;
+#endif
+}
+
+void ConnectionImpl::stopSplicing() {
+  if (splice_destination_ != nullptr) {
+    splice_destination_->splice_source_ = nullptr;
+    splice_destination_ = nullptr;
+    splice_read_blocked_ = false;
+  }
+  if (splice_source_ != nullptr) {
+    splice_source_->splice_destination_ = nullptr;
+    splice_source_->splice_read_blocked_ = false;
+    splice_source_ = nullptr;
+  }
+  // Whatever is left in the pipe is lost, just like the write buffer.
+  if (splice_pipe_[0] != -1) {
+    ::close(splice_pipe_[0]);
+    ::close(splice_pipe_[1]);
+    splice_pipe_[0] = -1;
+    splice_pipe_[1] = -1;
+    splice_pipe_bytes_ = 0;
+  }
+}
+
 void ConnectionImpl::doConnect() {
   ENVOY_CONN_LOG(debug, "connecting to {}", *this, remote_address_->asString());
   int rc = remote_address_->connect(fd_);
@@ -524,6 +733,16 @@ void ConnectionImpl::updateReadBufferStats(uint64_t num_read, uint64_t new_size)
                                            connection_stats_->read_current_);
 }
 
+void ConnectionImpl::recordWriteSizeStats(uint64_t num_written) {
+  if (connection_stats_ && connection_stats_->write_size_) {
+    connection_stats_->write_size_->recordValue(num_written);
+  }
+  if (writes_since_flush_ > 0 && connection_stats_ && connection_stats_->writes_per_flush_) {
+    connection_stats_->writes_per_flush_->recordValue(writes_since_flush_);
+  }
+  writes_since_flush_ = 0;
+}
+
 void ConnectionImpl::updateWriteBufferStats(uint64_t num_written, uint64_t new_size) {
   if (!connection_stats_) {
     return;
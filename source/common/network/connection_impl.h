@@ -2,6 +2,7 @@
 
 #include <atomic>
 #include <cstdint>
+#include <functional>
 #include <list>
 #include <memory>
 #include <string>
@@ -69,6 +70,7 @@ public:
 
   // Network::Connection
   void addConnectionCallbacks(ConnectionCallbacks& cb) override;
+  void removeConnectionCallbacks(ConnectionCallbacks& cb) override;
   void addBytesSentCallback(BytesSentCb cb) override;
   void close(ConnectionCloseType type) override;
   Event::Dispatcher& dispatcher() override;
@@ -89,6 +91,13 @@ public:
   uint32_t bufferLimit() const override { return read_buffer_limit_; }
   bool usingOriginalDst() const override { return using_original_dst_; }
   bool aboveHighWatermark() const override { return above_high_watermark_; }
+  bool spliceTo(Connection& destination, BytesSplicedCb cb) override;
+  bool releaseIdleBuffers() override;
+  uint64_t bufferedBytes() const override {
+    return read_buffer_.length() + write_buffer_->length();
+  }
+  void addDrainCallback(std::function<void()> cb) override { drain_callbacks_.push_back(cb); }
+  bool startDrain() override;
 
   // Network::BufferSource
   Buffer::Instance& getReadBuffer() override { return read_buffer_; }
@@ -141,8 +150,15 @@ private:
   void onRead(uint64_t read_buffer_size);
   void onReadReady();
   void onWriteReady();
+  bool canSpliceFrom() const;
+  bool canSpliceTo() const;
+  void onSpliceReadReady();
+  IoResult doSpliceWrite();
+  uint64_t pendingWriteBytes() const { return write_buffer_->length() + splice_pipe_bytes_; }
+  void stopSplicing();
   void updateReadBufferStats(uint64_t num_read, uint64_t new_size);
   void updateWriteBufferStats(uint64_t num_written, uint64_t new_size);
+  void recordWriteSizeStats(uint64_t num_written);
 
   static std::atomic<uint64_t> next_global_id_;
 
@@ -156,6 +172,9 @@ private:
   Buffer::Instance* current_write_buffer_{};
   uint64_t last_read_buffer_size_{};
   uint64_t last_write_buffer_size_{};
+  // write() calls that added data since the last write event that wrote any. All the writes of an
+  // event loop iteration are flushed together by the write event they activate.
+  uint64_t writes_since_flush_{};
   std::unique_ptr<ConnectionStats> connection_stats_;
   // Tracks the number of times reads have been disabled. If N different components call
   // readDisabled(true) this allows the connection to only resume reads when readDisabled(false)
@@ -164,6 +183,21 @@ private:
   const bool using_original_dst_;
   bool above_high_watermark_{false};
   bool detect_early_close_{true};
+  // Set by any I/O, and cleared by releaseIdleBuffers().
+  bool active_since_idle_check_{};
+  std::list<std::function<void()>> drain_callbacks_;
+
+  // Splicing, see spliceTo(). The source of the data splices it from its socket into the pipe of
+  // the destination, which drains the pipe into its socket once its write buffer is empty.
+  ConnectionImpl* splice_destination_{};
+  ConnectionImpl* splice_source_{};
+  BytesSplicedCb bytes_spliced_cb_;
+  // Set when the source stopped reading because the pipe may be full. The destination raises a
+  // read event on the source once it has drained some of the pipe.
+  bool splice_read_blocked_{};
+  int splice_pipe_[2]{-1, -1};
+  uint64_t splice_pipe_size_{};
+  uint64_t splice_pipe_bytes_{};
 };
 
 /**
@@ -0,0 +1,79 @@
+#include "common/network/lc_trie.h"
+
+#include <arpa/inet.h>
+
+namespace Envoy {
+namespace Network {
+namespace LcTrie {
+
+LcTrie::LcTrie(
+    const std::vector<std::pair<std::string, std::vector<Address::CidrRange>>>& tag_data) {
+  std::vector<Trie<Ipv4>::Range> ipv4_ranges;
+  std::vector<Trie<Ipv6>::Range> ipv6_ranges;
+  for (const auto& tag : tag_data) {
+    const uint32_t tag_index = tags_.size();
+    tags_.push_back(tag.first);
+    for (const Address::CidrRange& range : tag.second) {
+      ASSERT(range.isValid());
+      const uint32_t length = range.length();
+      if (range.ip()->version() == Address::IpVersion::v4) {
+        ipv4_ranges.push_back({toBits(*range.ip()->ipv4()), length, {tag_index}});
+      } else {
+        ipv6_ranges.push_back({toBits(*range.ip()->ipv6()), length, {tag_index}});
+      }
+    }
+  }
+
+  std::map<std::vector<uint32_t>, uint32_t> tag_set_indexes;
+  ipv4_trie_.build(std::move(ipv4_ranges), tag_set_indexes);
+  ipv6_trie_.build(std::move(ipv6_ranges), tag_set_indexes);
+
+  tag_sets_.resize(tag_set_indexes.size());
+  for (const auto& tag_set : tag_set_indexes) {
+    for (uint32_t tag_index : tag_set.first) {
+      tag_sets_[tag_set.second].push_back(tags_[tag_index]);
+    }
+  }
+}
+
+const std::vector<std::string>& LcTrie::getTags(const Address::Instance& ip_address) const {
+  static const std::vector<std::string> no_tags;
+  if (ip_address.type() != Address::Type::Ip) {
+    return no_tags;
+  }
+
+  const Address::Ip& ip = *ip_address.ip();
+  const uint32_t tag_set = ip.version() == Address::IpVersion::v4
+                               ? ipv4_trie_.find(toBits(*ip.ipv4()))
+                               : ipv6_trie_.find(toBits(*ip.ipv6()));
+  return tag_set == Trie<Ipv4>::NoTagSet ? no_tags : tag_sets_[tag_set];
+}
+
+uint32_t LcTrie::commonPrefixLength(Ipv4 a, Ipv4 b) {
+  const Ipv4 difference = a ^ b;
+  return difference == 0 ? 32 : __builtin_clz(difference);
+}
+
+uint32_t LcTrie::commonPrefixLength(Ipv6 a, Ipv6 b) {
+  const Ipv6 difference = a ^ b;
+  const uint64_t high = static_cast<uint64_t>(difference >> 64);
+  const uint64_t low = static_cast<uint64_t>(difference);
+  if (high != 0) {
+    return __builtin_clzll(high);
+  }
+  return low == 0 ? 128 : 64 + __builtin_clzll(low);
+}
+
+LcTrie::Ipv4 LcTrie::toBits(const Address::Ipv4& ip) { return ntohl(ip.address()); }
+
+LcTrie::Ipv6 LcTrie::toBits(const Address::Ipv6& ip) {
+  Ipv6 bits = 0;
+  for (uint8_t byte : ip.address()) {
+    bits = (bits << 8) | byte;
+  }
+  return bits;
+}
+
+} // namespace LcTrie
+} // namespace Network
+} // namespace Envoy
@@ -0,0 +1,285 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "envoy/network/address.h"
+
+#include "common/common/assert.h"
+#include "common/common/non_copyable.h"
+#include "common/network/cidr_range.h"
+
+namespace Envoy {
+namespace Network {
+namespace LcTrie {
+
+/**
+ * Maps IP addresses to the tags of every CIDR range that contains them. Ranges are compiled at
+ * construction into one level-compressed trie (LC-trie, see Nilsson and Karlsson, "IP-address
+ * lookup using LC-tries") per IP version, so a lookup touches a handful of nodes regardless of
+ * the number of ranges.
+ *
+ * LC-tries require a prefix-free set of keys. Overlapping ranges are therefore first expanded
+ * into disjoint ranges, each carrying the union of the tags of every configured range that
+ * covers it.
+ */
+class LcTrie : NonCopyable {
+public:
+  /**
+   * @param tag_data supplies pairs of a tag and the ranges tagged with it.
+   */
+  LcTrie(const std::vector<std::pair<std::string, std::vector<Address::CidrRange>>>& tag_data);
+
+  /**
+   * @param ip_address supplies the address to look up.
+   * @return the tags of every range that contains the address in the order they were configured,
+   *         or an empty vector if there are none or the address is not an IP address.
+   */
+  const std::vector<std::string>& getTags(const Address::Instance& ip_address) const;
+
+private:
+  typedef uint32_t Ipv4;
+  typedef __uint128_t Ipv6;
+
+  /**
+   * Returns the number of leading bits that a and b share.
+   */
+  static uint32_t commonPrefixLength(Ipv4 a, Ipv4 b);
+  static uint32_t commonPrefixLength(Ipv6 a, Ipv6 b);
+
+  static Ipv4 toBits(const Address::Ipv4& ip);
+  static Ipv6 toBits(const Address::Ipv6& ip);
+
+  template <class IpType> class Trie {
+  public:
+    static const uint32_t AddressBits = sizeof(IpType) * 8;
+    static const uint32_t NoTagSet = UINT32_MAX;
+    // The maximum number of bits consumed by a single internal node. Bounds the node array to
+    // 2^MaxBranch children per node for very dense ranges.
+    static const uint32_t MaxBranch = 16;
+
+    struct Range {
+      IpType address_;
+      uint32_t length_;
+      // Sorted indexes into the owning LcTrie's tags_.
+      std::vector<uint32_t> tags_;
+    };
+
+    /**
+     * @param ranges supplies the configured ranges. Overlaps and duplicates are allowed.
+     * @param tag_set_indexes supplies the owning LcTrie's map from each distinct tag set to its
+     *        index, which new tag sets are added to.
+     */
+    void build(std::vector<Range>&& ranges,
+               std::map<std::vector<uint32_t>, uint32_t>& tag_set_indexes);
+
+    /**
+     * @return the index of the tag set of the range containing address, or NoTagSet.
+     */
+    uint32_t find(IpType address) const;
+
+  private:
+    struct Leaf {
+      IpType address_;
+      uint32_t length_;
+      uint32_t tag_set_;
+    };
+
+    struct Node {
+      // Number of address bits used to select a child, or 0 for a leaf.
+      uint8_t branch_;
+      // Number of address bits skipped (path compression) before branching.
+      uint8_t skip_;
+      // Index of the first child in nodes_, or of the leaf in leaves_.
+      uint32_t index_;
+    };
+
+    static IpType mask(IpType address, uint32_t length) {
+      return length == 0 ? 0 : address & (~IpType(0) << (AddressBits - length));
+    }
+
+    static uint32_t extract(IpType address, uint32_t position, uint32_t count) {
+      ASSERT(count > 0 && position + count <= AddressBits);
+      return static_cast<uint32_t>((address << position) >> (AddressBits - count));
+    }
+
+    void expand(IpType address, uint32_t length, const Range* begin, const Range* end,
+                std::vector<uint32_t> inherited,
+                std::map<std::vector<uint32_t>, uint32_t>& tag_set_indexes);
+    void buildNode(uint32_t node, uint32_t first, uint32_t count, uint32_t position);
+
+    std::vector<Leaf> leaves_;
+    std::vector<Node> nodes_;
+  };
+
+  std::vector<std::string> tags_;
+  // Each distinct combination of tags found in a leaf, as tag names.
+  std::vector<std::vector<std::string>> tag_sets_;
+  Trie<Ipv4> ipv4_trie_;
+  Trie<Ipv6> ipv6_trie_;
+};
+
+template <class IpType> const uint32_t LcTrie::Trie<IpType>::AddressBits;
+template <class IpType> const uint32_t LcTrie::Trie<IpType>::NoTagSet;
+template <class IpType> const uint32_t LcTrie::Trie<IpType>::MaxBranch;
+
+template <class IpType>
+void LcTrie::Trie<IpType>::build(std::vector<Range>&& ranges,
+                                 std::map<std::vector<uint32_t>, uint32_t>& tag_set_indexes) {
+  std::sort(ranges.begin(), ranges.end(), [](const Range& a, const Range& b) {
+    return a.address_ < b.address_ || (a.address_ == b.address_ && a.length_ < b.length_);
+  });
+
+  // Merge duplicate ranges so that every (address, length) pair appears once.
+  std::vector<Range> unique;
+  for (Range& range : ranges) {
+    if (!unique.empty() && unique.back().address_ == range.address_ &&
+        unique.back().length_ == range.length_) {
+      std::vector<uint32_t> merged;
+      std::set_union(unique.back().tags_.begin(), unique.back().tags_.end(), range.tags_.begin(),
+                     range.tags_.end(), std::back_inserter(merged));
+      unique.back().tags_ = std::move(merged);
+    } else {
+      unique.push_back(std::move(range));
+    }
+  }
+
+  if (unique.empty()) {
+    return;
+  }
+
+  expand(0, 0, unique.data(), unique.data() + unique.size(), {}, tag_set_indexes);
+  if (leaves_.empty()) {
+    return;
+  }
+
+  nodes_.push_back(Node());
+  buildNode(0, 0, leaves_.size(), 0);
+}
+
+template <class IpType>
+void LcTrie::Trie<IpType>::expand(IpType address, uint32_t length, const Range* begin,
+                                  const Range* end, std::vector<uint32_t> inherited,
+                                  std::map<std::vector<uint32_t>, uint32_t>& tag_set_indexes) {
+  // [begin, end) holds the sorted ranges contained in address/length.
+  if (begin != end && begin->address_ == address && begin->length_ == length) {
+    std::vector<uint32_t> merged;
+    std::set_union(inherited.begin(), inherited.end(), begin->tags_.begin(), begin->tags_.end(),
+                   std::back_inserter(merged));
+    inherited = std::move(merged);
+    ++begin;
+  }
+
+  if (begin == end) {
+    if (!inherited.empty()) {
+      auto it = tag_set_indexes.emplace(inherited, tag_set_indexes.size()).first;
+      leaves_.push_back({address, length, it->second});
+    }
+    return;
+  }
+
+  if (inherited.empty()) {
+    // Nothing needs filling in, so jump straight to the longest prefix shared by all remaining
+    // ranges. Ranges are sorted, so the first and last bound the set.
+    const uint32_t shared =
+        std::min({commonPrefixLength(begin->address_, (end - 1)->address_), begin->length_,
+                  (end - 1)->length_});
+    if (shared > length) {
+      expand(mask(begin->address_, shared), shared, begin, end, std::move(inherited),
+             tag_set_indexes);
+      return;
+    }
+  }
+
+  // Split on the next bit. Every remaining range is longer than length, and ranges with the bit
+  // clear sort before those with it set.
+  const IpType upper_address = address | (IpType(1) << (AddressBits - length - 1));
+  const Range* upper =
+      std::lower_bound(begin, end, upper_address,
+                       [](const Range& range, IpType value) { return range.address_ < value; });
+  expand(address, length + 1, begin, upper, inherited, tag_set_indexes);
+  expand(upper_address, length + 1, upper, end, std::move(inherited), tag_set_indexes);
+}
+
+template <class IpType>
+void LcTrie::Trie<IpType>::buildNode(uint32_t node, uint32_t first, uint32_t count,
+                                     uint32_t position) {
+  if (count == 1) {
+    nodes_[node] = {0, 0, first};
+    return;
+  }
+
+  // Leaves are prefix-free and sorted, so the first and last leaves differ before either ends
+  // and their shared prefix is shared by every leaf in between.
+  const uint32_t last = first + count - 1;
+  const uint32_t skip = commonPrefixLength(leaves_[first].address_, leaves_[last].address_) -
+                        position;
+  position += skip;
+
+  // Use the largest branching factor for which every child is non-empty.
+  uint32_t branch = 1;
+  while (branch < MaxBranch && position + branch < AddressBits) {
+    const uint32_t next = branch + 1;
+    uint32_t patterns = 0;
+    bool complete = true;
+    int64_t previous = -1;
+    for (uint32_t i = first; i <= last && complete; i++) {
+      if (leaves_[i].length_ < position + next) {
+        complete = false;
+      } else {
+        const int64_t pattern = extract(leaves_[i].address_, position, next);
+        if (pattern != previous) {
+          patterns++;
+          previous = pattern;
+        }
+      }
+    }
+    if (!complete || patterns != (1U << next)) {
+      break;
+    }
+    branch = next;
+  }
+
+  const uint32_t children = nodes_.size();
+  nodes_[node] = {static_cast<uint8_t>(branch), static_cast<uint8_t>(skip), children};
+  nodes_.resize(children + (1U << branch));
+
+  uint32_t child_first = first;
+  for (uint32_t child = 0; child < (1U << branch); child++) {
+    uint32_t child_end = child_first;
+    while (child_end <= last && extract(leaves_[child_end].address_, position, branch) == child) {
+      child_end++;
+    }
+    ASSERT(child_end > child_first);
+    buildNode(children + child, child_first, child_end - child_first, position + branch);
+    child_first = child_end;
+  }
+}
+
+template <class IpType> uint32_t LcTrie::Trie<IpType>::find(IpType address) const {
+  if (nodes_.empty()) {
+    return NoTagSet;
+  }
+
+  const Node* node = &nodes_[0];
+  uint32_t position = node->skip_;
+  while (node->branch_ != 0) {
+    const uint32_t child = node->index_ + extract(address, position, node->branch_);
+    position += node->branch_;
+    node = &nodes_[child];
+    position += node->skip_;
+  }
+
+  // Skipped bits were never compared, so confirm the address is really in the leaf's range.
+  const Leaf& leaf = leaves_[node->index_];
+  return mask(address, leaf.length_) == leaf.address_ ? leaf.tag_set_ : NoTagSet;
+}
+
+} // namespace LcTrie
+} // namespace Network
+} // namespace Envoy
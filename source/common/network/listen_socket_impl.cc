@@ -30,7 +30,8 @@ void ListenSocketImpl::doBind() {
   }
 }
 
-TcpListenSocket::TcpListenSocket(Address::InstanceConstSharedPtr address, bool bind_to_port) {
+TcpListenSocket::TcpListenSocket(Address::InstanceConstSharedPtr address, bool bind_to_port,
+                                 bool reuse_port) {
   local_address_ = address;
   fd_ = local_address_->socket(Address::SocketType::Stream);
   RELEASE_ASSERT(fd_ != -1);
@@ -39,6 +40,15 @@ TcpListenSocket::TcpListenSocket(Address::InstanceConstSharedPtr address, bool b
   int rc = setsockopt(fd_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
   RELEASE_ASSERT(rc != -1);
 
+  if (reuse_port) {
+    rc = setsockopt(fd_, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+    if (rc == -1) {
+      close();
+      throw EnvoyException(fmt::format("cannot set SO_REUSEPORT on '{}': {}",
+                                       local_address_->asString(), strerror(errno)));
+    }
+  }
+
   if (bind_to_port) {
     doBind();
   }
@@ -49,6 +59,24 @@ TcpListenSocket::TcpListenSocket(int fd, Address::InstanceConstSharedPtr address
   local_address_ = address;
 }
 
+UdpListenSocket::UdpListenSocket(Address::InstanceConstSharedPtr address, bool reuse_port) {
+  local_address_ = address;
+  fd_ = local_address_->socket(Address::SocketType::Datagram);
+  RELEASE_ASSERT(fd_ != -1);
+
+  if (reuse_port) {
+    int on = 1;
+    int rc = setsockopt(fd_, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+    if (rc == -1) {
+      close();
+      throw EnvoyException(fmt::format("cannot set SO_REUSEPORT on '{}': {}",
+                                       local_address_->asString(), strerror(errno)));
+    }
+  }
+
+  doBind();
+}
+
 UdsListenSocket::UdsListenSocket(const std::string& uds_path) {
   remove(uds_path.c_str());
   local_address_.reset(new Address::PipeInstance(uds_path));
@@ -39,12 +39,30 @@ protected:
  */
 class TcpListenSocket : public ListenSocketImpl {
 public:
-  TcpListenSocket(Address::InstanceConstSharedPtr address, bool bind_to_port);
+  TcpListenSocket(Address::InstanceConstSharedPtr address, bool bind_to_port)
+      : TcpListenSocket(address, bind_to_port, false) {}
+  /**
+   * @param reuse_port supplies whether to set SO_REUSEPORT before binding, so that other sockets
+   *        with SO_REUSEPORT set can bind to the same address and share incoming connections.
+   */
+  TcpListenSocket(Address::InstanceConstSharedPtr address, bool bind_to_port, bool reuse_port);
   TcpListenSocket(int fd, Address::InstanceConstSharedPtr address);
 };
 
 typedef std::unique_ptr<TcpListenSocket> TcpListenSocketPtr;
 
+/**
+ * Wraps a datagram socket bound to an IP address.
+ */
+class UdpListenSocket : public ListenSocketImpl {
+public:
+  /**
+   * @param reuse_port supplies whether to set SO_REUSEPORT before binding, so that a socket per
+   *        worker can be bound to the same address and share the incoming datagrams.
+   */
+  UdpListenSocket(Address::InstanceConstSharedPtr address, bool reuse_port);
+};
+
 class UdsListenSocket : public ListenSocketImpl {
 public:
   UdsListenSocket(const std::string& uds_path);
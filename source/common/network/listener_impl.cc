@@ -1,10 +1,17 @@
 #include "common/network/listener_impl.h"
 
+#include <fcntl.h>
+#include <sys/socket.h>
 #include <sys/un.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
 
 #include "envoy/common/exception.h"
 #include "envoy/network/connection_handler.h"
 
+#include "common/common/assert.h"
 #include "common/common/empty_string.h"
 #include "common/event/dispatcher_impl.h"
 #include "common/event/file_event_impl.h"
@@ -13,23 +20,80 @@
 #include "common/network/utility.h"
 #include "common/ssl/connection_impl.h"
 
-#include "event2/listener.h"
 #include "fmt/format.h"
 
 namespace Envoy {
 namespace Network {
 
 Address::InstanceConstSharedPtr ListenerImpl::getLocalAddress(int fd) {
-  return Address::addressFromFd(fd);
+  // A listener on the any address sees connections to only a few local addresses, so connections
+  // to the same one share its instance instead of each creating and formatting their own.
+  sockaddr_storage ss;
+  socklen_t ss_len = sizeof(ss);
+  if (::getsockname(fd, reinterpret_cast<sockaddr*>(&ss), &ss_len) != 0) {
+    throw EnvoyException(fmt::format("getsockname failed for '{}': {}", fd, strerror(errno)));
+  }
+
+  for (const CachedLocalAddress& cached : local_addresses_) {
+    if (cached.length_ == ss_len && memcmp(&cached.address_, &ss, ss_len) == 0) {
+      return cached.instance_;
+    }
+  }
+
+  Address::InstanceConstSharedPtr address = Address::addressFromSockAddr(ss, ss_len);
+  if (local_addresses_.size() < MAX_CACHED_LOCAL_ADDRESSES) {
+    local_addresses_.push_back({ss, ss_len, address});
+  }
+  return address;
 }
 
 Address::InstanceConstSharedPtr ListenerImpl::getOriginalDst(int fd) {
   return Utility::getOriginalDst(fd);
 }
 
-void ListenerImpl::listenCallback(evconnlistener*, evutil_socket_t fd, sockaddr* remote_addr,
-                                  int remote_addr_len, void* arg) {
-  ListenerImpl* listener = static_cast<ListenerImpl*>(arg);
+namespace {
+
+int acceptNonBlocking(int fd, sockaddr* remote_addr, socklen_t* remote_addr_len) {
+#if defined(__APPLE__)
+  const int new_fd = ::accept(fd, remote_addr, remote_addr_len);
+  if (new_fd != -1) {
+    RELEASE_ASSERT(fcntl(new_fd, F_SETFL, O_NONBLOCK) != -1);
+  }
+  return new_fd;
+#else
+  return ::accept4(fd, remote_addr, remote_addr_len, SOCK_NONBLOCK);
+#endif
+}
+
+} // namespace
+
+void ListenerImpl::onSocketEvent() {
+  // The listen socket is level triggered, so anything left in the accept queue once the limit is
+  // reached is picked up on the next event loop iteration, after other ready events have run.
+  for (uint32_t i = 0; i < MAX_ACCEPTS_PER_SOCKET_EVENT; i++) {
+    sockaddr_storage remote_addr;
+    socklen_t remote_addr_len = sizeof(remote_addr);
+    const int fd = acceptNonBlocking(socket_.fd(), reinterpret_cast<sockaddr*>(&remote_addr),
+                                     &remote_addr_len);
+    if (fd == -1) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        return;
+      }
+      if (errno == EINTR || errno == ECONNABORTED) {
+        continue;
+      }
+
+      // This can happen if we run out of FDs or memory. In those cases just crash.
+      PANIC(fmt::format("listener accept failure: {}", strerror(errno)));
+    }
+
+    onAccept(fd, remote_addr, remote_addr_len);
+  }
+}
+
+void ListenerImpl::onAccept(int fd, const sockaddr_storage& remote_addr,
+                            socklen_t remote_addr_len) {
+  ListenerImpl* listener = this;
   Address::InstanceConstSharedPtr final_local_address = listener->socket_.localAddress();
   bool using_original_dst = false;
 
@@ -67,20 +131,48 @@ void ListenerImpl::listenCallback(evconnlistener*, evutil_socket_t fd, sockaddr*
     listener->proxy_protocol_.newConnection(listener->dispatcher_, fd, *listener);
   } else {
     Address::InstanceConstSharedPtr final_remote_address;
-    if (remote_addr->sa_family == AF_UNIX) {
+    if (remote_addr.ss_family == AF_UNIX) {
       // The accept() call that filled in remote_addr doesn't fill in more than the sa_family field
       // for Unix domain sockets; apparently there isn't a mechanism in the kernel to get the
       // sockaddr_un associated with the client socket when starting from the server socket.
       // We work around this by using our own name for the socket in this case.
       final_remote_address = Address::peerAddressFromFd(fd);
     } else {
-      final_remote_address = Address::addressFromSockAddr(
-          *reinterpret_cast<const sockaddr_storage*>(remote_addr), remote_addr_len);
+      final_remote_address = Address::addressFromSockAddr(remote_addr, remote_addr_len);
     }
     // TODO(jamessynge): We need to keep per-family stats. BUT, should it be based on the original
     // family or the local family? Probably local family, as the original proxy can take care of
     // stats for the original family.
-    listener->newConnection(fd, final_remote_address, final_local_address, using_original_dst);
+    listener->acceptConnection(fd, final_remote_address, final_local_address, using_original_dst);
+  }
+}
+
+void ListenerImpl::acceptConnection(int fd, Address::InstanceConstSharedPtr remote_address,
+                                    Address::InstanceConstSharedPtr local_address,
+                                    bool using_original_dst) {
+  if (options_.connection_balancer_ != nullptr &&
+      options_.connection_balancer_->balance(*this, fd, remote_address, local_address,
+                                             using_original_dst)) {
+    return;
+  }
+
+  if (options_.defer_connection_creation_) {
+    if (pending_connections_.empty()) {
+      deferred_connections_timer_->enableTimer(std::chrono::milliseconds(0));
+    }
+    pending_connections_.push_back({fd, remote_address, local_address, using_original_dst});
+    return;
+  }
+
+  newConnection(fd, remote_address, local_address, using_original_dst);
+}
+
+void ListenerImpl::createPendingConnections() {
+  std::list<PendingConnection> pending;
+  pending.swap(pending_connections_);
+  for (const PendingConnection& connection : pending) {
+    newConnection(connection.fd_, connection.remote_address_, connection.local_address_,
+                  connection.using_original_dst_);
   }
 }
 
@@ -89,25 +181,72 @@ ListenerImpl::ListenerImpl(Network::ConnectionHandler& conn_handler,
                            ListenerCallbacks& cb, Stats::Scope& scope,
                            const Network::ListenerOptions& listener_options)
     : connection_handler_(conn_handler), dispatcher_(dispatcher), socket_(socket), cb_(cb),
-      proxy_protocol_(scope), options_(listener_options), listener_(nullptr) {
+      proxy_protocol_(scope), options_(listener_options) {
 
   if (options_.bind_to_port_) {
-    listener_.reset(
-        evconnlistener_new(&dispatcher_.base(), listenCallback, this, 0, -1, socket.fd()));
-
-    if (!listener_) {
+    // Same backlog libevent's evconnlistener used.
+    if (::listen(socket.fd(), 128) == -1) {
       throw CreateListenerException(
           fmt::format("cannot listen on socket: {}", socket.localAddress()->asString()));
     }
 
-    evconnlistener_set_error_cb(listener_.get(), errorCallback);
+    file_event_ = dispatcher_.createFileEvent(socket.fd(),
+                                              [this](uint32_t events) -> void {
+                                                ASSERT(events == Event::FileReadyType::Read);
+                                                onSocketEvent();
+                                              },
+                                              Event::FileTriggerType::Level,
+                                              Event::FileReadyType::Read);
+
+    if (options_.connection_balancer_ != nullptr) {
+      options_.connection_balancer_->registerHandler(*this);
+    }
+  }
+
+  if (options_.defer_connection_creation_) {
+    deferred_connections_timer_ = dispatcher_.createTimer([this]() -> void {
+      createPendingConnections();
+    });
   }
 }
 
-void ListenerImpl::errorCallback(evconnlistener*, void*) {
-  // We should never get an error callback. This can happen if we run out of FDs or memory. In those
-  // cases just crash.
-  PANIC(fmt::format("listener accept failure: {}", strerror(errno)));
+void ListenerImpl::disable() {
+  if (file_event_) {
+    file_event_->setEnabled(0);
+  }
+}
+
+void ListenerImpl::enable() {
+  if (file_event_) {
+    file_event_->setEnabled(Event::FileReadyType::Read);
+  }
+}
+
+ListenerImpl::~ListenerImpl() {
+  if (file_event_ && options_.connection_balancer_ != nullptr) {
+    options_.connection_balancer_->unregisterHandler(*this);
+  }
+
+  for (const PendingConnection& connection : pending_connections_) {
+    ::close(connection.fd_);
+  }
+}
+
+void ListenerImpl::post(int fd, Address::InstanceConstSharedPtr remote_address,
+                        Address::InstanceConstSharedPtr local_address, bool using_original_dst) {
+  posted_connections_++;
+  std::weak_ptr<bool> alive = alive_;
+  dispatcher_.post([this, alive, fd, remote_address, local_address, using_original_dst]() -> void {
+    // The listener is destroyed on this thread, so it either still exists here or is gone for
+    // good, in which case nobody owns the socket but us.
+    if (alive.expired()) {
+      ::close(fd);
+      return;
+    }
+
+    posted_connections_--;
+    newConnection(fd, remote_address, local_address, using_original_dst);
+  });
 }
 
 void ListenerImpl::newConnection(int fd, Address::InstanceConstSharedPtr remote_address,
@@ -1,26 +1,40 @@
 #pragma once
 
+#include <sys/socket.h>
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <vector>
+
+#include "envoy/event/file_event.h"
+#include "envoy/event/timer.h"
 #include "envoy/network/connection_handler.h"
 #include "envoy/network/listener.h"
 
 #include "common/event/dispatcher_impl.h"
-#include "common/event/libevent.h"
 #include "common/network/listen_socket_impl.h"
 #include "common/network/proxy_protocol.h"
 
-#include "event2/event.h"
-
 namespace Envoy {
 namespace Network {
 
 /**
- * libevent implementation of Network::Listener.
+ * libevent implementation of Network::Listener. If the listener options have a connection
+ * balancer, the listener registers with it and counts every connection of its connection handler.
  */
-class ListenerImpl : public Listener {
+class ListenerImpl : public Listener, public BalancedConnectionHandler {
 public:
+  // Accepts done per readiness event of the listen socket. Bounding them keeps a reconnect storm
+  // from starving the worker's established connections.
+  static const uint32_t MAX_ACCEPTS_PER_SOCKET_EVENT = 64;
+  // Local addresses kept per listener on the any address, see getLocalAddress().
+  static const uint32_t MAX_CACHED_LOCAL_ADDRESSES = 16;
+
   ListenerImpl(Network::ConnectionHandler& conn_handler, Event::DispatcherImpl& dispatcher,
                ListenSocket& socket, ListenerCallbacks& cb, Stats::Scope& scope,
                const ListenerOptions& listener_options);
+  ~ListenerImpl();
 
   /**
    * Accept/process a new connection.
@@ -37,6 +51,17 @@ public:
    */
   ListenSocket& socket() { return socket_; }
 
+  // Network::Listener
+  void disable() override;
+  void enable() override;
+
+  // Network::BalancedConnectionHandler
+  uint64_t numConnections() override {
+    return connection_handler_.numConnections() + posted_connections_;
+  }
+  void post(int fd, Address::InstanceConstSharedPtr remote_address,
+            Address::InstanceConstSharedPtr local_address, bool using_original_dst) override;
+
 protected:
   virtual Address::InstanceConstSharedPtr getLocalAddress(int fd);
   virtual Address::InstanceConstSharedPtr getOriginalDst(int fd);
@@ -49,11 +74,39 @@ protected:
   const ListenerOptions options_;
 
 private:
-  static void errorCallback(evconnlistener* listener, void* context);
-  static void listenCallback(evconnlistener*, evutil_socket_t fd, sockaddr* remote_addr,
-                             int remote_addr_len, void* arg);
+  /**
+   * An accepted socket whose connection is created on a later event loop iteration.
+   */
+  struct PendingConnection {
+    int fd_;
+    Address::InstanceConstSharedPtr remote_address_;
+    Address::InstanceConstSharedPtr local_address_;
+    bool using_original_dst_;
+  };
+
+  /**
+   * A local address that connections accepted on the any address were made to.
+   */
+  struct CachedLocalAddress {
+    sockaddr_storage address_;
+    socklen_t length_;
+    Address::InstanceConstSharedPtr instance_;
+  };
+
+  void onSocketEvent();
+  void onAccept(int fd, const sockaddr_storage& remote_addr, socklen_t remote_addr_len);
+  void acceptConnection(int fd, Address::InstanceConstSharedPtr remote_address,
+                        Address::InstanceConstSharedPtr local_address, bool using_original_dst);
+  void createPendingConnections();
 
-  Event::Libevent::ListenerPtr listener_;
+  Event::FileEventPtr file_event_;
+  Event::TimerPtr deferred_connections_timer_;
+  std::list<PendingConnection> pending_connections_;
+  std::vector<CachedLocalAddress> local_addresses_;
+  // Sockets posted to this listener by the connection balancer that have not been handled yet.
+  std::atomic<uint64_t> posted_connections_{};
+  // Lets posted sockets find out whether the listener went away before they ran.
+  const std::shared_ptr<bool> alive_{std::make_shared<bool>(true)};
 };
 
 class SslListenerImpl : public ListenerImpl {
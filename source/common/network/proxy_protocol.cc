@@ -1,8 +1,13 @@
 #include "common/network/proxy_protocol.h"
 
+#include <netinet/in.h>
+#include <sys/socket.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <memory>
 #include <string>
 
@@ -20,6 +25,19 @@
 namespace Envoy {
 namespace Network {
 
+namespace {
+
+const uint8_t PROXY_PROTO_V2_SIGNATURE[] = {0x0d, 0x0a, 0x0d, 0x0a, 0x00, 0x0d,
+                                            0x0a, 0x51, 0x55, 0x49, 0x54, 0x0a};
+const uint8_t PROXY_PROTO_V2_PROXY = 0x1;
+const uint8_t PROXY_PROTO_V2_AF_INET = 0x1;
+const uint8_t PROXY_PROTO_V2_AF_INET6 = 0x2;
+const uint8_t PROXY_PROTO_V2_STREAM = 0x1;
+const ptrdiff_t PROXY_PROTO_V2_INET_ADDRESSES_LEN = 12;
+const ptrdiff_t PROXY_PROTO_V2_INET6_ADDRESSES_LEN = 36;
+
+} // namespace
+
 ProxyProtocol::ProxyProtocol(Stats::Scope& scope)
     : stats_{ALL_PROXY_PROTOCOL_STATS(POOL_COUNTER(scope))} {}
 
@@ -31,7 +49,7 @@ void ProxyProtocol::newConnection(Event::Dispatcher& dispatcher, int fd, Listene
 ProxyProtocol::ActiveConnection::ActiveConnection(ProxyProtocol& parent,
                                                   Event::Dispatcher& dispatcher, int fd,
                                                   ListenerImpl& listener)
-    : parent_(parent), fd_(fd), listener_(listener), search_index_(1) {
+    : parent_(parent), fd_(fd), listener_(listener) {
   file_event_ =
       dispatcher.createFileEvent(fd,
                                  [this](uint32_t events) {
@@ -58,14 +76,47 @@ void ProxyProtocol::ActiveConnection::onRead() {
 }
 
 void ProxyProtocol::ActiveConnection::onReadWorker() {
-  std::string proxy_line;
-  if (!readLine(fd_, proxy_line)) {
+  const ssize_t nread = recv(fd_, buf_, sizeof(buf_), MSG_PEEK);
+  if (nread == -1 && errno == EAGAIN) {
     return;
+  } else if (nread < 1) {
+    throw EnvoyException("failed to read proxy protocol");
   }
+  const size_t len = nread;
+
+  // Anything that does not start like a V2 header is read as V1, which rejects it once a line is
+  // complete.
+  if (memcmp(buf_, PROXY_PROTO_V2_SIGNATURE, std::min(len, sizeof(PROXY_PROTO_V2_SIGNATURE))) ==
+      0) {
+    if (len < PROXY_PROTO_V2_HEADER_LEN) {
+      return;
+    }
+    const size_t header_len =
+        PROXY_PROTO_V2_HEADER_LEN + ((static_cast<size_t>(buf_[14]) << 8) | buf_[15]);
+    if (header_len > MAX_PROXY_PROTO_V2_LEN) {
+      throw EnvoyException("failed to read proxy protocol");
+    }
+    if (len < header_len) {
+      return;
+    }
 
-  // Remove the line feed at the end
-  StringUtil::rtrim(proxy_line);
+    parseV2(buf_, header_len);
+    return;
+  }
+
+  const size_t search_len = len < MAX_PROXY_PROTO_LEN ? len : MAX_PROXY_PROTO_LEN;
+  for (size_t i = 1; i < search_len; i++) {
+    if (buf_[i] == '\n' && buf_[i - 1] == '\r') {
+      parseV1(std::string(reinterpret_cast<const char*>(buf_), i - 1), i + 1);
+      return;
+    }
+  }
+  if (search_len == MAX_PROXY_PROTO_LEN) {
+    throw EnvoyException("failed to read proxy protocol");
+  }
+}
 
+void ProxyProtocol::ActiveConnection::parseV1(const std::string& proxy_line, size_t len) {
   // Parse proxy protocol line with format: PROXY TCP4/TCP6/UNKNOWN SOURCE_ADDRESS
   // DESTINATION_ADDRESS SOURCE_PORT DESTINATION_PORT.
   const auto line_parts = StringUtil::split(proxy_line, " ", true);
@@ -85,6 +136,7 @@ void ProxyProtocol::ActiveConnection::onReadWorker() {
     } else {
       remote_address = std::make_shared<Address::Ipv6Instance>(Address::Ipv6Instance("::"));
     }
+    consume(len);
     finishConnection(remote_address, local_address);
     return;
   }
@@ -125,9 +177,95 @@ void ProxyProtocol::ActiveConnection::onReadWorker() {
     throw EnvoyException("failed to read proxy protocol");
   }
 
+  consume(len);
   finishConnection(remote_address, local_address);
 }
 
+void ProxyProtocol::ActiveConnection::parseV2(const uint8_t* header, size_t len) {
+  const uint8_t version = header[12] >> 4;
+  const uint8_t command = header[12] & 0xf;
+  const uint8_t family = header[13] >> 4;
+  const uint8_t transport = header[13] & 0xf;
+  if (version != 2 || command > PROXY_PROTO_V2_PROXY) {
+    throw EnvoyException("failed to read proxy protocol");
+  }
+
+  const uint8_t* body = header + PROXY_PROTO_V2_HEADER_LEN;
+  const uint8_t* end = header + len;
+  Address::InstanceConstSharedPtr remote_address;
+  Address::InstanceConstSharedPtr local_address;
+  // LOCAL is sent by the proxy itself, e.g. for health checks, and unspecified or unsupported
+  // families carry no addresses that apply to TCP. The connection's own addresses are used then.
+  if (command == PROXY_PROTO_V2_PROXY &&
+      (family == PROXY_PROTO_V2_AF_INET || family == PROXY_PROTO_V2_AF_INET6)) {
+    if (transport != PROXY_PROTO_V2_STREAM) {
+      throw EnvoyException("failed to read proxy protocol");
+    }
+
+    if (family == PROXY_PROTO_V2_AF_INET) {
+      if (end - body < PROXY_PROTO_V2_INET_ADDRESSES_LEN) {
+        throw EnvoyException("failed to read proxy protocol");
+      }
+      sockaddr_in remote{};
+      sockaddr_in local{};
+      remote.sin_family = local.sin_family = AF_INET;
+      memcpy(&remote.sin_addr, body, 4);
+      memcpy(&local.sin_addr, body + 4, 4);
+      memcpy(&remote.sin_port, body + 8, 2);
+      memcpy(&local.sin_port, body + 10, 2);
+      remote_address = std::make_shared<Address::Ipv4Instance>(&remote);
+      local_address = std::make_shared<Address::Ipv4Instance>(&local);
+      body += PROXY_PROTO_V2_INET_ADDRESSES_LEN;
+    } else {
+      if (end - body < PROXY_PROTO_V2_INET6_ADDRESSES_LEN) {
+        throw EnvoyException("failed to read proxy protocol");
+      }
+      sockaddr_in6 remote{};
+      sockaddr_in6 local{};
+      remote.sin6_family = local.sin6_family = AF_INET6;
+      memcpy(&remote.sin6_addr, body, 16);
+      memcpy(&local.sin6_addr, body + 16, 16);
+      memcpy(&remote.sin6_port, body + 32, 2);
+      memcpy(&local.sin6_port, body + 34, 2);
+      remote_address = std::make_shared<Address::Ipv6Instance>(remote);
+      local_address = std::make_shared<Address::Ipv6Instance>(local);
+      body += PROXY_PROTO_V2_INET6_ADDRESSES_LEN;
+    }
+
+    if (!remote_address->ip()->isUnicastAddress() || !local_address->ip()->isUnicastAddress()) {
+      throw EnvoyException("failed to read proxy protocol");
+    }
+  } else {
+    local_address = Address::addressFromFd(fd_);
+    remote_address = Address::peerAddressFromFd(fd_);
+    // The addresses of other families are skipped along with the TLVs.
+    body = end;
+  }
+
+  // The rest is a sequence of TLVs, each a type byte and a big endian length. None of the types
+  // are used yet, but a malformed sequence means that the header is corrupt.
+  while (body < end) {
+    if (end - body < 3) {
+      throw EnvoyException("failed to read proxy protocol");
+    }
+    const size_t value_len = (static_cast<size_t>(body[1]) << 8) | body[2];
+    if (static_cast<size_t>(end - body - 3) < value_len) {
+      throw EnvoyException("failed to read proxy protocol");
+    }
+    body += 3 + value_len;
+  }
+
+  consume(len);
+  finishConnection(remote_address, local_address);
+}
+
+void ProxyProtocol::ActiveConnection::consume(size_t len) {
+  // This should never fail, as the bytes have already been peeked.
+  const ssize_t nread = recv(fd_, buf_, len, 0);
+  ASSERT(size_t(nread) == len);
+  UNREFERENCED_PARAMETER(nread);
+}
+
 void ProxyProtocol::ActiveConnection::finishConnection(
     Address::InstanceConstSharedPtr remote_address, Address::InstanceConstSharedPtr local_address) {
 
@@ -146,42 +284,5 @@ void ProxyProtocol::ActiveConnection::close() {
   removeFromList(parent_.connections_);
 }
 
-bool ProxyProtocol::ActiveConnection::readLine(int fd, std::string& s) {
-  while (buf_off_ < MAX_PROXY_PROTO_LEN) {
-    ssize_t nread = recv(fd, buf_ + buf_off_, MAX_PROXY_PROTO_LEN - buf_off_, MSG_PEEK);
-
-    if (nread == -1 && errno == EAGAIN) {
-      return false;
-    } else if (nread < 1) {
-      throw EnvoyException("failed to read proxy protocol");
-    }
-
-    bool found = false;
-    // continue searching buf_ from where we left off
-    for (; search_index_ < buf_off_ + nread; search_index_++) {
-      if (buf_[search_index_] == '\n' && buf_[search_index_ - 1] == '\r') {
-        search_index_++;
-        found = true;
-        break;
-      }
-    }
-
-    // Read the data upto and including the line feed, if available, but not past it.
-    // This should never fail, as search_index_ - buf_off_ <= nread, so we're asking
-    // only for bytes we have already seen.
-    nread = recv(fd, buf_ + buf_off_, search_index_ - buf_off_, 0);
-    ASSERT(size_t(nread) == search_index_ - buf_off_);
-
-    buf_off_ += nread;
-
-    if (found) {
-      s.assign(buf_, buf_off_);
-      return true;
-    }
-  }
-
-  throw EnvoyException("failed to read proxy protocol");
-}
-
 } // namespace Network
 } // namespace Envoy
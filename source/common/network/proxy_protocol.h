@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <list>
 #include <memory>
 #include <string>
@@ -30,8 +31,8 @@ struct ProxyProtocolStats {
 };
 
 /**
- * Implementation the PROXY Protocol V1
- * (http://www.haproxy.org/download/1.5/doc/proxy-protocol.txt)
+ * Implementation of the PROXY protocol, both the V1 text and the V2 binary header
+ * (http://www.haproxy.org/download/1.8/doc/proxy-protocol.txt)
  */
 class ProxyProtocol {
 public:
@@ -43,16 +44,33 @@ public:
 
   private:
     static const size_t MAX_PROXY_PROTO_LEN = 108;
+    // The fixed part of a V2 header, which is followed by the addresses and TLVs.
+    static const size_t PROXY_PROTO_V2_HEADER_LEN = 16;
+    // V2 headers may declare up to 64KiB of addresses and TLVs. Longer ones than this, which real
+    // senders do not send, are rejected so that the whole header fits in buf_.
+    static const size_t MAX_PROXY_PROTO_V2_LEN = 2048;
 
     void onRead();
     void onReadWorker();
 
     /**
-     * Helper function that attempts to read a line (delimited by '\r\n') from the socket.
-     * throws EnvoyException on any socket errors.
-     * @return bool true if a line should be read, false if more data is needed.
+     * Parse a V1 header.
+     * @param line supplies the header line, without the trailing '\r\n'.
+     * @param len supplies the length of the header, including the trailing '\r\n'.
      */
-    bool readLine(int fd, std::string& s);
+    void parseV1(const std::string& line, size_t len);
+
+    /**
+     * Parse a V2 header, including its TLVs.
+     * @param header supplies the whole header.
+     * @param len supplies the length of the header.
+     */
+    void parseV2(const uint8_t* header, size_t len);
+
+    /**
+     * Remove the header from the socket once it has been parsed from the peeked data.
+     */
+    void consume(size_t len);
     void close();
 
     /**
@@ -66,14 +84,9 @@ public:
     ListenerImpl& listener_;
     Event::FileEventPtr file_event_;
 
-    // The offset in buf_ that has been fully read
-    size_t buf_off_{};
-
-    // The index in buf_ where the search for '\r\n' should continue from
-    size_t search_index_;
-
-    // Stores the portion of the first line that has been read so far.
-    char buf_[MAX_PROXY_PROTO_LEN];
+    // The header is peeked into buf_ until it is complete, and only then read off the socket, so
+    // that a header that arrives in one segment costs a single peek and a single read.
+    uint8_t buf_[MAX_PROXY_PROTO_V2_LEN];
   };
 
   ProxyProtocol(Stats::Scope& scope);
@@ -1,5 +1,8 @@
 #include "common/network/raw_buffer_socket.h"
 
+#include <algorithm>
+
+#include "common/buffer/buffer_impl.h"
 #include "common/common/empty_string.h"
 
 namespace Envoy {
@@ -9,16 +12,16 @@ void RawBufferSocket::setTransportSocketCallbacks(TransportSocketCallbacks& call
   callbacks_ = &callbacks;
 }
 
+const uint64_t RawBufferSocket::MIN_READ_SIZE;
+const uint64_t RawBufferSocket::DEFAULT_READ_SIZE;
+const uint64_t RawBufferSocket::MAX_READ_SIZE;
+
 IoResult RawBufferSocket::doRead(Buffer::Instance& buffer) {
   PostIoAction action = PostIoAction::KeepOpen;
   uint64_t bytes_read = 0;
   do {
-    // 16K read is arbitrary. IIRC, libevent will currently clamp this to 4K. libevent will also
-    // use an ioctl() before every read to figure out how much data there is to read.
-    //
-    // TODO(mattklein123) PERF: Tune the read size and figure out a way of getting rid of the
-    // ioctl(). The extra syscall is not worth it.
-    int rc = buffer.read(callbacks_->fd(), 16384);
+    const uint64_t read_size = nextReadSize(buffer);
+    int rc = buffer.read(callbacks_->fd(), read_size);
     ENVOY_CONN_LOG(trace, "read returns: {}", callbacks_->connection(), rc);
 
     // Remote close. Might need to raise data before raising close.
@@ -35,6 +38,7 @@ IoResult RawBufferSocket::doRead(Buffer::Instance& buffer) {
       break;
     } else {
       bytes_read += rc;
+      adaptReadSize(read_size, rc);
       if (callbacks_->shouldDrainReadBuffer()) {
         callbacks_->setReadBufferReady();
         break;
@@ -45,6 +49,36 @@ IoResult RawBufferSocket::doRead(Buffer::Instance& buffer) {
   return {action, bytes_read};
 }
 
+uint64_t RawBufferSocket::nextReadSize(const Buffer::Instance& buffer) const {
+  // Don't read far past the read buffer limit, so that the watermarks stay meaningful for
+  // connections that read a lot at once.
+  const uint64_t limit = callbacks_->connection().bufferLimit();
+  if (limit == 0) {
+    return read_size_;
+  }
+
+  const uint64_t room = limit > buffer.length() ? limit - buffer.length() : 0;
+  return std::min(read_size_, std::max(room, MIN_READ_SIZE));
+}
+
+void RawBufferSocket::adaptReadSize(uint64_t requested, uint64_t bytes_read) {
+  if (bytes_read == requested) {
+    small_reads_ = 0;
+    // The socket had at least as much as was asked for. Only grow if the read was not capped by
+    // the read buffer limit.
+    if (requested == read_size_) {
+      read_size_ = std::min(read_size_ * 2, MAX_READ_SIZE);
+    }
+  } else if (bytes_read <= read_size_ / 2) {
+    if (++small_reads_ == 2) {
+      small_reads_ = 0;
+      read_size_ = std::max(read_size_ / 2, MIN_READ_SIZE);
+    }
+  } else {
+    small_reads_ = 0;
+  }
+}
+
 IoResult RawBufferSocket::doWrite(Buffer::Instance& buffer) {
   PostIoAction action;
   uint64_t bytes_written = 0;
@@ -53,6 +87,11 @@ IoResult RawBufferSocket::doWrite(Buffer::Instance& buffer) {
       action = PostIoAction::KeepOpen;
       break;
     }
+    // Every buffer implementation writes at least this many slices at once, so in that case a
+    // write that takes less than the whole buffer means that the socket's send buffer is full.
+    const uint64_t length = buffer.length();
+    const bool whole_buffer_offered =
+        buffer.getRawSlices(nullptr, 0) <= Buffer::SliceOwnedImpl::MaxWriteSlices;
     int rc = buffer.write(callbacks_->fd());
     ENVOY_CONN_LOG(trace, "write returns: {}", callbacks_->connection(), rc);
     if (rc == -1) {
@@ -66,6 +105,12 @@ IoResult RawBufferSocket::doWrite(Buffer::Instance& buffer) {
       break;
     } else {
       bytes_written += rc;
+      if (whole_buffer_offered && static_cast<uint64_t>(rc) < length) {
+        // Don't spend a syscall on a write that would just fail with EAGAIN. The socket becomes
+        // writable again, which raises a new write event, once the peer acknowledges some data.
+        action = PostIoAction::KeepOpen;
+        break;
+      }
     }
   } while (true);
 
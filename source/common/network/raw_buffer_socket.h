@@ -18,9 +18,22 @@ public:
   void onConnected() override;
   IoResult doRead(Buffer::Instance& buffer) override;
   IoResult doWrite(Buffer::Instance& buffer) override;
+  bool directWritesSupported() const override { return true; }
+
+  // Bounds of the size of a single read. Each connection starts at DEFAULT_READ_SIZE, doubles it
+  // after every read that fills it, and halves it after two reads in a row that would have fit
+  // into half of it.
+  static const uint64_t MIN_READ_SIZE = 4096;
+  static const uint64_t DEFAULT_READ_SIZE = 16384;
+  static const uint64_t MAX_READ_SIZE = 262144;
 
 private:
+  uint64_t nextReadSize(const Buffer::Instance& buffer) const;
+  void adaptReadSize(uint64_t requested, uint64_t bytes_read);
+
   TransportSocketCallbacks* callbacks_{};
+  uint64_t read_size_{DEFAULT_READ_SIZE};
+  uint32_t small_reads_{};
 };
 
 } // namespace Network
@@ -0,0 +1,189 @@
+#include "common/network/udp_listener_impl.h"
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include "common/common/assert.h"
+
+namespace Envoy {
+namespace Network {
+
+const uint32_t UdpRecvBatch::MAX_DATAGRAMS;
+const uint32_t UdpRecvBatch::MAX_DATAGRAM_BYTES;
+const uint32_t UdpSendBatch::MAX_DATAGRAMS;
+const uint32_t UdpSendBatch::MAX_DATAGRAM_BYTES;
+const uint32_t UdpListenerImpl::MAX_BATCHES_PER_SOCKET_EVENT;
+
+UdpRecvBatch::UdpRecvBatch() : data_(MAX_DATAGRAMS * MAX_DATAGRAM_BYTES) {}
+
+uint32_t UdpRecvBatch::recv(int fd) {
+  truncated_ = 0;
+#if defined(__linux__)
+  iovec iovecs[MAX_DATAGRAMS];
+  mmsghdr headers[MAX_DATAGRAMS];
+  memset(headers, 0, sizeof(headers));
+  for (uint32_t i = 0; i < MAX_DATAGRAMS; i++) {
+    iovecs[i].iov_base = &data_[i * MAX_DATAGRAM_BYTES];
+    iovecs[i].iov_len = MAX_DATAGRAM_BYTES;
+    headers[i].msg_hdr.msg_iov = &iovecs[i];
+    headers[i].msg_hdr.msg_iovlen = 1;
+    headers[i].msg_hdr.msg_name = &peers_[i];
+    headers[i].msg_hdr.msg_namelen = sizeof(peers_[i]);
+  }
+
+  const int rc = ::recvmmsg(fd, headers, MAX_DATAGRAMS, MSG_DONTWAIT, nullptr);
+  if (rc <= 0) {
+    return 0;
+  }
+
+  // Drop truncated datagrams by moving the following ones down.
+  uint32_t count = 0;
+  for (int i = 0; i < rc; i++) {
+    if (headers[i].msg_hdr.msg_flags & MSG_TRUNC) {
+      truncated_++;
+      continue;
+    }
+    if (count != static_cast<uint32_t>(i)) {
+      memmove(&data_[count * MAX_DATAGRAM_BYTES], &data_[i * MAX_DATAGRAM_BYTES],
+              headers[i].msg_len);
+      peers_[count] = peers_[i];
+    }
+    peer_lengths_[count] = headers[i].msg_hdr.msg_namelen;
+    lengths_[count] = headers[i].msg_len;
+    count++;
+  }
+  return count;
+#else
+  uint32_t count = 0;
+  uint32_t reads = 0;
+  while (reads++ < MAX_DATAGRAMS) {
+    iovec iov{&data_[count * MAX_DATAGRAM_BYTES], MAX_DATAGRAM_BYTES};
+    msghdr header{};
+    header.msg_iov = &iov;
+    header.msg_iovlen = 1;
+    header.msg_name = &peers_[count];
+    header.msg_namelen = sizeof(peers_[count]);
+    const ssize_t rc = ::recvmsg(fd, &header, MSG_DONTWAIT);
+    if (rc < 0) {
+      break;
+    }
+    if (header.msg_flags & MSG_TRUNC) {
+      truncated_++;
+      continue;
+    }
+    peer_lengths_[count] = header.msg_namelen;
+    lengths_[count++] = rc;
+  }
+  return count;
+#endif
+}
+
+UdpSendBatch::UdpSendBatch() : data_(MAX_DATAGRAMS * MAX_DATAGRAM_BYTES) {}
+
+bool UdpSendBatch::add(const sockaddr_storage& peer_address, socklen_t peer_address_len,
+                       const char* data, size_t length) {
+  if (size_ == MAX_DATAGRAMS) {
+    return false;
+  }
+
+  ASSERT(length <= MAX_DATAGRAM_BYTES);
+  memcpy(&peers_[size_], &peer_address, peer_address_len);
+  peer_lengths_[size_] = peer_address_len;
+  memcpy(&data_[size_ * MAX_DATAGRAM_BYTES], data, length);
+  lengths_[size_] = length;
+  size_++;
+  return true;
+}
+
+uint32_t UdpSendBatch::send(int fd) {
+  uint32_t sent = 0;
+#if defined(__linux__)
+  iovec iovecs[MAX_DATAGRAMS];
+  mmsghdr headers[MAX_DATAGRAMS];
+  memset(headers, 0, sizeof(headers));
+  for (uint32_t i = 0; i < size_; i++) {
+    iovecs[i].iov_base = &data_[i * MAX_DATAGRAM_BYTES];
+    iovecs[i].iov_len = lengths_[i];
+    headers[i].msg_hdr.msg_iov = &iovecs[i];
+    headers[i].msg_hdr.msg_iovlen = 1;
+    headers[i].msg_hdr.msg_name = &peers_[i];
+    headers[i].msg_hdr.msg_namelen = peer_lengths_[i];
+  }
+
+  uint32_t done = 0;
+  while (done < size_) {
+    const int rc = ::sendmmsg(fd, &headers[done], size_ - done, MSG_DONTWAIT);
+    if (rc > 0) {
+      sent += rc;
+      done += rc;
+    } else {
+      // The first unsent datagram is dropped, e.g. when the socket buffer is full.
+      done++;
+    }
+  }
+#else
+  for (uint32_t i = 0; i < size_; i++) {
+    if (::sendto(fd, &data_[i * MAX_DATAGRAM_BYTES], lengths_[i], 0,
+                 reinterpret_cast<const sockaddr*>(&peers_[i]), peer_lengths_[i]) >= 0) {
+      sent++;
+    }
+  }
+#endif
+  size_ = 0;
+  return sent;
+}
+
+UdpListenerImpl::UdpListenerImpl(Event::Dispatcher& dispatcher, ListenSocket& socket,
+                                 UdpListenerCallbacks& cb)
+    : socket_(socket), cb_(cb) {
+  file_event_ = dispatcher.createFileEvent(socket_.fd(), [this](uint32_t) { onSocketEvent(); },
+                                           Event::FileTriggerType::Level,
+                                           Event::FileReadyType::Read);
+}
+
+void UdpListenerImpl::disable() { file_event_->setEnabled(0); }
+
+void UdpListenerImpl::enable() { file_event_->setEnabled(Event::FileReadyType::Read); }
+
+void UdpListenerImpl::send(const sockaddr_storage& peer_address, socklen_t peer_address_len,
+                           const char* data, size_t length) {
+  if (length > UdpSendBatch::MAX_DATAGRAM_BYTES) {
+    ENVOY_LOG(debug, "udp listener: dropping {} byte datagram", length);
+    return;
+  }
+
+  if (!send_batch_.add(peer_address, peer_address_len, data, length)) {
+    flush();
+    send_batch_.add(peer_address, peer_address_len, data, length);
+  }
+}
+
+void UdpListenerImpl::flush() {
+  if (!send_batch_.empty()) {
+    send_batch_.send(socket_.fd());
+  }
+}
+
+void UdpListenerImpl::onSocketEvent() {
+  for (uint32_t batch = 0; batch < MAX_BATCHES_PER_SOCKET_EVENT; batch++) {
+    const uint32_t count = recv_batch_.recv(socket_.fd());
+    if (recv_batch_.truncated() > 0) {
+      ENVOY_LOG(debug, "udp listener: dropped {} truncated datagrams", recv_batch_.truncated());
+    }
+    for (uint32_t i = 0; i < count; i++) {
+      cb_.onData(recv_batch_.datagram(i));
+    }
+    if (count < UdpRecvBatch::MAX_DATAGRAMS && recv_batch_.truncated() == 0) {
+      break;
+    }
+  }
+
+  cb_.onReadComplete();
+  flush();
+}
+
+} // namespace Network
+} // namespace Envoy
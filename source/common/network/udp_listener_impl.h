@@ -0,0 +1,130 @@
+#pragma once
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "envoy/event/dispatcher.h"
+#include "envoy/event/file_event.h"
+#include "envoy/network/listen_socket.h"
+#include "envoy/network/listener.h"
+
+#include "common/common/logger.h"
+#include "common/common/non_copyable.h"
+
+namespace Envoy {
+namespace Network {
+
+/**
+ * Buffers for reading a batch of datagrams from a socket with a single recvmmsg() where it is
+ * available, and with recvfrom() per datagram elsewhere.
+ */
+class UdpRecvBatch : NonCopyable {
+public:
+  // Datagrams read per call.
+  static const uint32_t MAX_DATAGRAMS = 16;
+  // Larger datagrams are truncated by the kernel, and dropped. This covers jumbo frames.
+  static const uint32_t MAX_DATAGRAM_BYTES = 9000;
+
+  UdpRecvBatch();
+
+  /**
+   * Read the datagrams that are ready, up to MAX_DATAGRAMS.
+   * @param fd supplies the non blocking socket.
+   * @return uint32_t the number of datagrams read, which is 0 once none are ready.
+   */
+  uint32_t recv(int fd);
+
+  /**
+   * @return UdpRecvData a datagram of the last recv().
+   */
+  UdpRecvData datagram(uint32_t index) const {
+    return {peers_[index], peer_lengths_[index], &data_[index * MAX_DATAGRAM_BYTES],
+            lengths_[index]};
+  }
+
+  /**
+   * @return uint32_t the number of datagrams of the last recv() that were truncated, and so are
+   *         not returned.
+   */
+  uint32_t truncated() const { return truncated_; }
+
+private:
+  std::vector<char> data_;
+  sockaddr_storage peers_[MAX_DATAGRAMS];
+  socklen_t peer_lengths_[MAX_DATAGRAMS];
+  size_t lengths_[MAX_DATAGRAMS];
+  uint32_t truncated_{};
+};
+
+/**
+ * Buffers for sending a batch of datagrams on a socket with a single sendmmsg() where it is
+ * available, and with sendto() per datagram elsewhere.
+ */
+class UdpSendBatch : NonCopyable {
+public:
+  static const uint32_t MAX_DATAGRAMS = UdpRecvBatch::MAX_DATAGRAMS;
+  static const uint32_t MAX_DATAGRAM_BYTES = UdpRecvBatch::MAX_DATAGRAM_BYTES;
+
+  UdpSendBatch();
+
+  /**
+   * Queue a datagram, which is copied.
+   * @return bool false if the batch is full, in which case it must be sent first.
+   */
+  bool add(const sockaddr_storage& peer_address, socklen_t peer_address_len, const char* data,
+           size_t length);
+
+  /**
+   * Send the queued datagrams, dropping those the socket has no room for.
+   * @param fd supplies the non blocking socket.
+   * @return uint32_t the number of datagrams that were sent.
+   */
+  uint32_t send(int fd);
+
+  bool empty() const { return size_ == 0; }
+
+private:
+  std::vector<char> data_;
+  sockaddr_storage peers_[MAX_DATAGRAMS];
+  socklen_t peer_lengths_[MAX_DATAGRAMS];
+  size_t lengths_[MAX_DATAGRAMS];
+  uint32_t size_{};
+};
+
+/**
+ * libevent implementation of Network::UdpListener. Every datagram is passed to the callbacks, so
+ * sessions and the like are up to them.
+ */
+class UdpListenerImpl : public UdpListener, Logger::Loggable<Logger::Id::connection> {
+public:
+  // Batches read per readiness event of the socket. Bounding them keeps a flood of datagrams from
+  // starving the worker's other events. The socket is level triggered, so the rest is read on the
+  // next event loop iteration.
+  static const uint32_t MAX_BATCHES_PER_SOCKET_EVENT = 4;
+
+  UdpListenerImpl(Event::Dispatcher& dispatcher, ListenSocket& socket, UdpListenerCallbacks& cb);
+
+  // Network::Listener
+  void disable() override;
+  void enable() override;
+
+  // Network::UdpListener
+  void send(const sockaddr_storage& peer_address, socklen_t peer_address_len, const char* data,
+            size_t length) override;
+  void flush() override;
+
+private:
+  void onSocketEvent();
+
+  ListenSocket& socket_;
+  UdpListenerCallbacks& cb_;
+  Event::FileEventPtr file_event_;
+  UdpRecvBatch recv_batch_;
+  UdpSendBatch send_batch_;
+};
+
+} // namespace Network
+} // namespace Envoy
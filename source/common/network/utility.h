@@ -81,6 +81,16 @@ public:
   static Address::InstanceConstSharedPtr parseInternetAddress(const std::string& ip_address,
                                                               uint16_t port = 0);
 
+  /**
+   * Parse an internet host address (IPv4 or IPv6) and create an Instance from it. The address must
+   * not include a port number. Suitable for untrusted input on the request path.
+   * @param ip_address string to be parsed as an internet address.
+   * @param port optional port to include in Instance created from ip_address, 0 by default.
+   * @return pointer to the Instance, or nullptr if unable to parse the address.
+   */
+  static Address::InstanceConstSharedPtr parseInternetAddressNoThrow(const std::string& ip_address,
+                                                                     uint16_t port = 0);
+
   /**
    * Parse an internet host address (IPv4 or IPv6) AND port, and create an Instance from it. Throws
    * EnvoyException if unable to parse the address. This is needed when a shared pointer is needed
@@ -0,0 +1,58 @@
+#include "common/network/warm_dns_resolver.h"
+
+#include "common/network/utility.h"
+
+namespace Envoy {
+namespace Network {
+
+void WarmDnsResolver::addHints(const std::vector<DnsResult>& results) {
+  for (const DnsResult& result : results) {
+    std::list<Address::InstanceConstSharedPtr> address_list;
+    for (const std::string& address : result.addresses_) {
+      Address::InstanceConstSharedPtr parsed = Utility::parseInternetAddress(address);
+      if (parsed) {
+        address_list.push_back(parsed);
+      }
+    }
+    if (!address_list.empty()) {
+      hints_[Key(result.dns_name_, result.dns_lookup_family_)] = std::move(address_list);
+    }
+  }
+}
+
+std::vector<DnsResult> WarmDnsResolver::results() const {
+  std::vector<DnsResult> results;
+  results.reserve(results_.size());
+  for (const auto& result : results_) {
+    results.push_back({result.first.first, result.first.second, result.second});
+  }
+  return results;
+}
+
+ActiveDnsQuery* WarmDnsResolver::resolve(const std::string& dns_name,
+                                         DnsLookupFamily dns_lookup_family, ResolveCb callback) {
+  const Key key(dns_name, dns_lookup_family);
+  auto hint = hints_.find(key);
+  if (hint != hints_.end()) {
+    std::list<Address::InstanceConstSharedPtr> address_list = std::move(hint->second);
+    hints_.erase(hint);
+    callback(std::move(address_list));
+    return nullptr;
+  }
+
+  return resolver_->resolve(
+      dns_name, dns_lookup_family,
+      [this, key, callback](std::list<Address::InstanceConstSharedPtr>&& address_list) -> void {
+        if (!address_list.empty()) {
+          std::vector<std::string>& addresses = results_[key];
+          addresses.clear();
+          for (const Address::InstanceConstSharedPtr& address : address_list) {
+            addresses.push_back(address->ip()->addressAsString());
+          }
+        }
+        callback(std::move(address_list));
+      });
+}
+
+} // namespace Network
+} // namespace Envoy
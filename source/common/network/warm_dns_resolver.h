@@ -0,0 +1,52 @@
+#pragma once
+
+#include <list>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "envoy/network/dns.h"
+
+namespace Envoy {
+namespace Network {
+
+/**
+ * DnsResolver that keeps the latest addresses each name resolved to, so that they can be handed
+ * to the next process on hot restart, and that answers the first lookup of a name from the
+ * results the previous process handed over. Clusters of the new process then start with the hosts
+ * the previous process was using rather than waiting for DNS, and later lookups go to DNS as
+ * usual. All calls happen on the thread of the wrapped resolver.
+ */
+class WarmDnsResolver : public DnsResolver {
+public:
+  WarmDnsResolver(DnsResolverSharedPtr resolver) : resolver_(resolver) {}
+
+  /**
+   * Answer the first lookup of each name in results from results rather than from DNS. Addresses
+   * that do not parse are ignored.
+   */
+  void addHints(const std::vector<DnsResult>& results);
+
+  /**
+   * @return std::vector<DnsResult> the latest non-empty result of every name that was resolved.
+   */
+  std::vector<DnsResult> results() const;
+
+  // Network::DnsResolver
+  ActiveDnsQuery* resolve(const std::string& dns_name, DnsLookupFamily dns_lookup_family,
+                          ResolveCb callback) override;
+
+private:
+  typedef std::pair<std::string, DnsLookupFamily> Key;
+
+  std::map<Key, std::list<Address::InstanceConstSharedPtr>> hints_;
+  std::map<Key, std::vector<std::string>> results_;
+  // Declared last so that no lookup completes into the maps above while they are destroyed.
+  DnsResolverSharedPtr resolver_;
+};
+
+typedef std::shared_ptr<WarmDnsResolver> WarmDnsResolverSharedPtr;
+
+} // namespace Network
+} // namespace Envoy
@@ -28,11 +28,31 @@ public:
 };
 
 /**
- * Process wide heap profiling
+ * Process wide heap profiling.
  */
 class Heap {
-private:
-  static void forceLink();
+public:
+  /**
+   * @return whether the profiler is running or not.
+   */
+  static bool profilerEnabled();
+
+  /**
+   * Start the profiler. Profiles are written to files named after the specified prefix.
+   * @return bool whether the call to start the profiler succeeded.
+   */
+  static bool startProfiler(const std::string& output_prefix);
+
+  /**
+   * Write a profile of the memory that is currently in use, if the profiler is running.
+   * @param reason supplies why the profile was written, which is recorded in the profile.
+   */
+  static void dumpProfile(const std::string& reason);
+
+  /**
+   * Stop the profiler.
+   */
+  static void stopProfiler();
 };
 
 } // namespace Profiler
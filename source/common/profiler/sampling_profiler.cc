@@ -0,0 +1,201 @@
+#include "common/profiler/sampling_profiler.h"
+
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <signal.h>
+#include <sys/time.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "common/common/hash.h"
+#include "common/profiler/profiler.h"
+
+#include "fmt/format.h"
+
+namespace Envoy {
+namespace Profiler {
+
+namespace {
+
+// The frames of the signal handler and of the signal trampoline that precede the interrupted one.
+const int SKIPPED_FRAMES = 2;
+
+/**
+ * A distinct stack. The thread whose sample first claims the entry by setting its hash writes the
+ * frames and then sets ready_. Samples of the same stack on other threads only count.
+ */
+struct StackEntry {
+  std::atomic<uint64_t> hash_;
+  std::atomic<bool> ready_;
+  std::atomic<uint64_t> count_;
+  uint32_t depth_;
+  void* frames_[Sampling::MAX_STACK_DEPTH];
+};
+
+// Zero initialized, so that it is usable from the signal handler without any setup.
+std::array<StackEntry, Sampling::MAX_STACKS> stacks_;
+std::atomic<uint64_t> dropped_samples_;
+std::atomic<bool> running_;
+// Serializes starting and stopping. Never taken by the signal handler.
+std::mutex lock_;
+
+void recordSample(void* const* frames, int depth) {
+  // Hash zero marks a free entry.
+  const uint64_t hash =
+      HashUtil::xxHash64(reinterpret_cast<const char*>(frames), depth * sizeof(void*)) | 1;
+  for (uint32_t probe = 0; probe < Sampling::MAX_STACKS; probe++) {
+    StackEntry& entry = stacks_[(hash + probe) % Sampling::MAX_STACKS];
+    uint64_t entry_hash = entry.hash_.load(std::memory_order_acquire);
+    if (entry_hash == 0 && entry.hash_.compare_exchange_strong(entry_hash, hash)) {
+      entry.depth_ = depth;
+      std::copy(frames, frames + depth, entry.frames_);
+      entry.ready_.store(true, std::memory_order_release);
+      entry.count_++;
+      return;
+    }
+
+    if (entry_hash == hash) {
+      entry.count_++;
+      return;
+    }
+  }
+
+  dropped_samples_++;
+}
+
+// Only calls functions that are safe in a signal handler once backtrace() has been called outside
+// of one, which startProfiler() does.
+void onSample(int) {
+  if (!running_.load(std::memory_order_relaxed)) {
+    return;
+  }
+
+  const int saved_errno = errno;
+  void* frames[Sampling::MAX_STACK_DEPTH + SKIPPED_FRAMES];
+  const int depth = backtrace(frames, Sampling::MAX_STACK_DEPTH + SKIPPED_FRAMES);
+  if (depth > SKIPPED_FRAMES) {
+    recordSample(frames + SKIPPED_FRAMES, depth - SKIPPED_FRAMES);
+  }
+  errno = saved_errno;
+}
+
+bool setTimer(uint32_t frequency_hz) {
+  itimerval timer{};
+  if (frequency_hz > 0) {
+    const uint32_t interval_us = std::max<uint32_t>(1000000 / frequency_hz, 1);
+    timer.it_interval.tv_sec = interval_us / 1000000;
+    timer.it_interval.tv_usec = interval_us % 1000000;
+    timer.it_value = timer.it_interval;
+  }
+  return setitimer(ITIMER_PROF, &timer, nullptr) == 0;
+}
+
+std::string symbolize(void* address) {
+  Dl_info info;
+  if (dladdr(address, &info) == 0 || info.dli_sname == nullptr) {
+    return fmt::format("{}", address);
+  }
+
+  int status;
+  char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+  if (demangled == nullptr) {
+    return info.dli_sname;
+  }
+  std::string name(demangled);
+  free(demangled);
+  return name;
+}
+
+} // namespace
+
+bool Sampling::profilerEnabled() { return running_; }
+
+bool Sampling::startProfiler(uint32_t frequency_hz) {
+  std::unique_lock<std::mutex> lock(lock_);
+  if (running_ || Cpu::profilerEnabled() || frequency_hz == 0) {
+    return false;
+  }
+
+  // The first call to backtrace() may load the unwinder, which must not happen in the handler.
+  void* frame;
+  backtrace(&frame, 1);
+
+  for (StackEntry& entry : stacks_) {
+    entry.hash_ = 0;
+    entry.ready_ = false;
+    entry.count_ = 0;
+  }
+  dropped_samples_ = 0;
+
+  // The handler stays installed once the profiler stops, since the default action of a SIGPROF
+  // that is still pending would terminate the process.
+  struct sigaction action {};
+  action.sa_handler = onSample;
+  action.sa_flags = SA_RESTART;
+  sigemptyset(&action.sa_mask);
+  if (sigaction(SIGPROF, &action, nullptr) != 0) {
+    return false;
+  }
+
+  running_ = true;
+  if (!setTimer(frequency_hz)) {
+    running_ = false;
+    return false;
+  }
+  return true;
+}
+
+void Sampling::stopProfiler() {
+  std::unique_lock<std::mutex> lock(lock_);
+  if (!running_) {
+    return;
+  }
+
+  setTimer(0);
+  running_ = false;
+}
+
+std::string Sampling::foldedStacks() {
+  std::unordered_map<void*, std::string> symbols;
+  std::map<std::string, uint64_t> folded;
+  for (StackEntry& entry : stacks_) {
+    if (!entry.ready_.load(std::memory_order_acquire)) {
+      continue;
+    }
+
+    std::string stack;
+    for (uint32_t i = entry.depth_; i > 0; i--) {
+      void* address = entry.frames_[i - 1];
+      auto it = symbols.find(address);
+      if (it == symbols.end()) {
+        it = symbols.emplace(address, symbolize(address)).first;
+      }
+      if (!stack.empty()) {
+        stack += ';';
+      }
+      stack += it->second;
+    }
+    // Distinct return addresses in the same functions fold into one line.
+    folded[stack] += entry.count_;
+  }
+
+  std::string output;
+  for (const auto& stack : folded) {
+    output += fmt::format("{} {}\n", stack.first, stack.second);
+  }
+  return output;
+}
+
+uint64_t Sampling::droppedSamples() { return dropped_samples_; }
+
+} // namespace Profiler
+} // namespace Envoy
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace Envoy {
+namespace Profiler {
+
+/**
+ * Process wide sampling CPU profiler that is cheap enough to run on production traffic. A SIGPROF
+ * timer interrupts whichever thread is using CPU, and the signal handler counts the interrupted
+ * stack in a fixed size table without locking or allocating. Unlike Profiler::Cpu it needs no
+ * special build, and the profile is read back in memory rather than from a file.
+ *
+ * Only one of this profiler and Profiler::Cpu may run at a time, since both use SIGPROF.
+ */
+class Sampling {
+public:
+  /**
+   * @return whether the profiler is running or not.
+   */
+  static bool profilerEnabled();
+
+  /**
+   * Drop the samples of the previous run and start sampling.
+   * @param frequency_hz supplies how many times per second of CPU time to sample.
+   * @return bool whether the profiler was started. It fails if it is already running.
+   */
+  static bool startProfiler(uint32_t frequency_hz);
+
+  /**
+   * Stop sampling. The samples are kept until the profiler is started again.
+   */
+  static void stopProfiler();
+
+  /**
+   * @return std::string the samples in the folded stack format used to draw flame graphs, one
+   *         line per distinct stack with the outermost frame first, e.g.
+   *         "main;Envoy::Event::DispatcherImpl::run(...);... 42". Frames that cannot be
+   *         symbolized are written as addresses, which tools/stack_decode.py can resolve.
+   */
+  static std::string foldedStacks();
+
+  /**
+   * @return uint64_t the number of samples that were dropped because the table of distinct
+   *         stacks was full.
+   */
+  static uint64_t droppedSamples();
+
+  static const uint32_t DEFAULT_FREQUENCY_HZ = 100;
+  static const uint32_t MAX_STACK_DEPTH = 64;
+  static const uint32_t MAX_STACKS = 4096;
+};
+
+} // namespace Profiler
+} // namespace Envoy
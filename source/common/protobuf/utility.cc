@@ -29,8 +29,7 @@ void MessageUtil::loadFromJson(const std::string& json, Protobuf::Message& messa
 }
 
 void MessageUtil::loadFromYaml(const std::string& yaml, Protobuf::Message& message) {
-  const std::string json = Json::Factory::loadFromYamlString(yaml)->asJsonString();
-  loadFromJson(json, message);
+  loadFromJson(Json::Factory::yamlAsJsonString(yaml), message);
 }
 
 void MessageUtil::loadFromFile(const std::string& path, Protobuf::Message& message) {
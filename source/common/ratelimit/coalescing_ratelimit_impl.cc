@@ -0,0 +1,185 @@
+#include "common/ratelimit/coalescing_ratelimit_impl.h"
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "envoy/stats/stats.h"
+
+#include "common/common/assert.h"
+
+namespace Envoy {
+namespace RateLimit {
+
+void CoalescingThreadLocalState::PendingCall::complete(LimitStatus status) {
+  if (status == LimitStatus::OverLimit) {
+    const uint64_t ttl_ms =
+        parent_.runtime_.snapshot().getInteger("ratelimit.over_limit_cache_ttl_ms", 0);
+    if (ttl_ms > 0) {
+      const MonotonicTime now = parent_.time_source_.currentTime();
+      state_.cacheOverLimit(
+          key_, now, now + std::chrono::milliseconds(ttl_ms),
+          parent_.runtime_.snapshot().getInteger("ratelimit.over_limit_cache_max_entries", 10000));
+    }
+  }
+
+  // Detach every waiter before calling any of them, since a waiter's callbacks may cancel other
+  // waiters.
+  std::list<CoalescingClientImpl*> waiters;
+  waiters.swap(waiters_);
+  for (CoalescingClientImpl* waiter : waiters) {
+    waiter->pending_call_ = nullptr;
+  }
+  state_.removePendingCall(*this);
+
+  for (CoalescingClientImpl* waiter : waiters) {
+    waiter->complete(status);
+  }
+}
+
+CoalescingThreadLocalState::PendingCall&
+CoalescingThreadLocalState::addPendingCall(PendingCallPtr&& call, bool coalesce) {
+  PendingCall& new_call = *call;
+  pending_calls_.emplace_front(std::move(call));
+  new_call.entry_ = pending_calls_.begin();
+  if (coalesce) {
+    coalescable_calls_[new_call.key_] = &new_call;
+  }
+  return new_call;
+}
+
+void CoalescingThreadLocalState::removePendingCall(PendingCall& call) {
+  auto coalescable = coalescable_calls_.find(call.key_);
+  if (coalescable != coalescable_calls_.end() && coalescable->second == &call) {
+    coalescable_calls_.erase(coalescable);
+  }
+
+  auto entry = call.entry_;
+  dispatcher_.deferredDelete(std::move(*entry));
+  pending_calls_.erase(entry);
+}
+
+void CoalescingThreadLocalState::cacheOverLimit(const std::string& key, MonotonicTime now,
+                                                MonotonicTime expires, uint64_t max_entries) {
+  if (over_limit_cache_.size() >= max_entries && over_limit_cache_.count(key) == 0) {
+    for (auto it = over_limit_cache_.begin(); it != over_limit_cache_.end();) {
+      if (it->second <= now) {
+        it = over_limit_cache_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    if (over_limit_cache_.size() >= max_entries) {
+      return;
+    }
+  }
+
+  over_limit_cache_[key] = expires;
+}
+
+CoalescingClientImpl::~CoalescingClientImpl() {
+  if (pending_call_ != nullptr) {
+    cancel();
+  }
+}
+
+void CoalescingClientImpl::cancel() {
+  if (pending_call_ != nullptr) {
+    pending_call_->waiters_.remove(this);
+    if (pending_call_->waiters_.empty()) {
+      pending_call_->client_->cancel();
+      pending_call_->state_.removePendingCall(*pending_call_);
+    }
+    pending_call_ = nullptr;
+  }
+  callbacks_ = nullptr;
+}
+
+void CoalescingClientImpl::limit(RequestCallbacks& callbacks, const std::string& domain,
+                                 const std::vector<Descriptor>& descriptors,
+                                 Tracing::Span& parent_span) {
+  ASSERT(callbacks_ == nullptr);
+  CoalescingThreadLocalState& state = parent_.tls_->getTyped<CoalescingThreadLocalState>();
+  const std::string key = cacheKey(domain, descriptors);
+
+  auto cached = state.over_limit_cache_.find(key);
+  if (cached != state.over_limit_cache_.end()) {
+    if (parent_.time_source_.currentTime() < cached->second) {
+      parent_.stats_.over_limit_cache_hit_.inc();
+      callbacks.complete(LimitStatus::OverLimit);
+      return;
+    }
+    state.over_limit_cache_.erase(cached);
+  }
+
+  callbacks_ = &callbacks;
+  const bool coalesce =
+      parent_.runtime_.snapshot().featureEnabled("ratelimit.coalesce_requests", 0);
+  if (coalesce) {
+    auto in_flight = state.coalescable_calls_.find(key);
+    if (in_flight != state.coalescable_calls_.end()) {
+      parent_.stats_.coalesced_.inc();
+      pending_call_ = in_flight->second;
+      pending_call_->waiters_.push_back(this);
+      return;
+    }
+  }
+
+  CoalescingThreadLocalState::PendingCall& call =
+      state.addPendingCall(CoalescingThreadLocalState::PendingCallPtr{
+                               new CoalescingThreadLocalState::PendingCall(
+                                   parent_, state, key, parent_.global_factory_->create(timeout_))},
+                           coalesce);
+  pending_call_ = &call;
+  call.waiters_.push_back(this);
+  call.client_->limit(call, domain, descriptors, parent_span);
+}
+
+void CoalescingClientImpl::complete(LimitStatus status) {
+  ASSERT(pending_call_ == nullptr);
+  if (callbacks_ == nullptr) {
+    // Cancelled while the pending call was completing.
+    return;
+  }
+
+  RequestCallbacks* callbacks = callbacks_;
+  callbacks_ = nullptr;
+  callbacks->complete(status);
+}
+
+std::string CoalescingClientImpl::cacheKey(const std::string& domain,
+                                           const std::vector<Descriptor>& descriptors) {
+  // Descriptors, keys and values are separated by distinct control characters so that no two
+  // distinct requests share a key.
+  std::string key = domain;
+  for (const Descriptor& descriptor : descriptors) {
+    key.push_back('\x01');
+    for (const DescriptorEntry& entry : descriptor.entries_) {
+      key.push_back('\x02');
+      key += entry.key_;
+      key.push_back('\x03');
+      key += entry.value_;
+    }
+  }
+  return key;
+}
+
+CoalescingFactoryImpl::CoalescingFactoryImpl(ClientFactoryPtr&& global_factory,
+                                             ThreadLocal::SlotAllocator& tls,
+                                             Runtime::Loader& runtime, Stats::Scope& scope,
+                                             MonotonicTimeSource& time_source)
+    : global_factory_(std::move(global_factory)), tls_(tls.allocateSlot()), runtime_(runtime),
+      stats_(generateStats(scope)), time_source_(time_source) {
+  tls_->set([](Event::Dispatcher& dispatcher) -> ThreadLocal::ThreadLocalObjectSharedPtr {
+    return std::make_shared<CoalescingThreadLocalState>(dispatcher);
+  });
+}
+
+CoalescingRateLimitStats CoalescingFactoryImpl::generateStats(Stats::Scope& scope) {
+  std::string final_prefix = "ratelimit.";
+  return {ALL_COALESCING_RATE_LIMIT_STATS(POOL_COUNTER_PREFIX(scope, final_prefix))};
+}
+
+} // namespace RateLimit
+} // namespace Envoy
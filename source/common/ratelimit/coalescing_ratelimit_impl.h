@@ -0,0 +1,164 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "envoy/common/time.h"
+#include "envoy/event/deferred_deletable.h"
+#include "envoy/event/dispatcher.h"
+#include "envoy/ratelimit/ratelimit.h"
+#include "envoy/runtime/runtime.h"
+#include "envoy/stats/stats_macros.h"
+#include "envoy/thread_local/thread_local.h"
+
+namespace Envoy {
+namespace RateLimit {
+
+/**
+ * All stats for rate limit request coalescing. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_COALESCING_RATE_LIMIT_STATS(COUNTER)                                                   \
+  COUNTER(coalesced)                                                                               \
+  COUNTER(over_limit_cache_hit)
+// clang-format on
+
+/**
+ * Struct definition for all rate limit coalescing stats. @see stats_macros.h
+ */
+struct CoalescingRateLimitStats {
+  ALL_COALESCING_RATE_LIMIT_STATS(GENERATE_COUNTER_STRUCT)
+};
+
+class CoalescingClientImpl;
+class CoalescingFactoryImpl;
+
+/**
+ * Per worker state shared by all coalescing clients on that worker.
+ */
+class CoalescingThreadLocalState : public ThreadLocal::ThreadLocalObject {
+public:
+  CoalescingThreadLocalState(Event::Dispatcher& dispatcher) : dispatcher_(dispatcher) {}
+
+  /**
+   * A call to the rate limit service that one or more clients are waiting for.
+   */
+  struct PendingCall : public RequestCallbacks, public Event::DeferredDeletable {
+    PendingCall(CoalescingFactoryImpl& parent, CoalescingThreadLocalState& state,
+                const std::string& key, ClientPtr&& client)
+        : parent_(parent), state_(state), key_(key), client_(std::move(client)) {}
+
+    // RateLimit::RequestCallbacks
+    void complete(LimitStatus status) override;
+
+    CoalescingFactoryImpl& parent_;
+    CoalescingThreadLocalState& state_;
+    const std::string key_;
+    ClientPtr client_;
+    std::list<CoalescingClientImpl*> waiters_;
+    std::list<std::unique_ptr<PendingCall>>::iterator entry_;
+  };
+
+  typedef std::unique_ptr<PendingCall> PendingCallPtr;
+
+  /**
+   * Start tracking a new call. Calls that can be coalesced are also indexed by their key.
+   */
+  PendingCall& addPendingCall(PendingCallPtr&& call, bool coalesce);
+
+  /**
+   * Remove a pending call once it has completed or has no waiters left. It is deleted once the
+   * stack unwinds, since it may be inside its own client's callback.
+   */
+  void removePendingCall(PendingCall& call);
+
+  /**
+   * Remember an over limit answer until expires. Expired answers are swept when the cache is
+   * full, and nothing more is remembered while it stays full.
+   */
+  void cacheOverLimit(const std::string& key, MonotonicTime now, MonotonicTime expires,
+                      uint64_t max_entries);
+
+  Event::Dispatcher& dispatcher_;
+  std::list<PendingCallPtr> pending_calls_;
+  // In flight calls that later identical requests can wait for, by key.
+  std::unordered_map<std::string, PendingCall*> coalescable_calls_;
+  // Descriptor sets that the service found over limit, and when that answer expires.
+  std::unordered_map<std::string, MonotonicTime> over_limit_cache_;
+};
+
+/**
+ * Client that shares calls to the rate limit service between requests on the same worker. While a
+ * call for a domain and descriptor set is in flight, further requests with the same domain and
+ * descriptors wait for its answer instead of making their own call
+ * (ratelimit.coalesce_requests). Over limit answers are remembered for
+ * ratelimit.over_limit_cache_ttl_ms, during which identical requests complete as over limit
+ * without a call. The service counts one hit per call, so coalesced requests are not counted
+ * against the limit individually.
+ */
+class CoalescingClientImpl : public Client {
+public:
+  CoalescingClientImpl(CoalescingFactoryImpl& parent,
+                       const Optional<std::chrono::milliseconds>& timeout)
+      : parent_(parent), timeout_(timeout) {}
+  ~CoalescingClientImpl();
+
+  // RateLimit::Client
+  void cancel() override;
+  void limit(RequestCallbacks& callbacks, const std::string& domain,
+             const std::vector<Descriptor>& descriptors, Tracing::Span& parent_span) override;
+
+  /**
+   * Called by the pending call this client is waiting for.
+   */
+  void complete(LimitStatus status);
+
+  /**
+   * @return std::string a key that is equal for requests with the same domain and descriptors.
+   */
+  static std::string cacheKey(const std::string& domain,
+                              const std::vector<Descriptor>& descriptors);
+
+private:
+  CoalescingFactoryImpl& parent_;
+  const Optional<std::chrono::milliseconds> timeout_;
+  RequestCallbacks* callbacks_{};
+  CoalescingThreadLocalState::PendingCall* pending_call_{};
+
+  friend struct CoalescingThreadLocalState::PendingCall;
+};
+
+/**
+ * Factory for CoalescingClientImpl, wrapping the factory for the rate limit service client.
+ */
+class CoalescingFactoryImpl : public ClientFactory {
+public:
+  CoalescingFactoryImpl(ClientFactoryPtr&& global_factory, ThreadLocal::SlotAllocator& tls,
+                        Runtime::Loader& runtime, Stats::Scope& scope,
+                        MonotonicTimeSource& time_source);
+
+  // RateLimit::ClientFactory
+  ClientPtr create(const Optional<std::chrono::milliseconds>& timeout) override {
+    return ClientPtr{new CoalescingClientImpl(*this, timeout)};
+  }
+
+private:
+  static CoalescingRateLimitStats generateStats(Stats::Scope& scope);
+
+  ClientFactoryPtr global_factory_;
+  ThreadLocal::SlotPtr tls_;
+  Runtime::Loader& runtime_;
+  CoalescingRateLimitStats stats_;
+  MonotonicTimeSource& time_source_;
+
+  friend class CoalescingClientImpl;
+  friend class CoalescingThreadLocalState;
+};
+
+} // namespace RateLimit
+} // namespace Envoy
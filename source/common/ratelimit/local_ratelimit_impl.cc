@@ -0,0 +1,241 @@
+#include "common/ratelimit/local_ratelimit_impl.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "envoy/stats/stats.h"
+
+#include "common/common/assert.h"
+
+namespace Envoy {
+namespace RateLimit {
+
+namespace {
+
+int64_t tokenIntervalNs(uint64_t tokens_per_second) {
+  ASSERT(tokens_per_second > 0);
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::seconds(1)).count() /
+         tokens_per_second;
+}
+
+} // namespace
+
+int64_t TokenBucket::nowNs() const {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             time_source_.currentTime().time_since_epoch())
+      .count();
+}
+
+bool TokenBucket::consume(uint64_t tokens_per_second, uint64_t max_tokens) {
+  const int64_t interval = tokenIntervalNs(tokens_per_second);
+  const int64_t now = nowNs();
+  int64_t full_at = full_at_ns_;
+  int64_t new_full_at;
+  do {
+    new_full_at = std::max(full_at, now) + interval;
+    if (new_full_at - now > interval * static_cast<int64_t>(max_tokens)) {
+      return false;
+    }
+  } while (!full_at_ns_.compare_exchange_weak(full_at, new_full_at));
+
+  return true;
+}
+
+void TokenBucket::drain(uint64_t tokens_per_second, uint64_t max_tokens) {
+  const int64_t empty_until =
+      nowNs() + tokenIntervalNs(tokens_per_second) * static_cast<int64_t>(max_tokens);
+  int64_t full_at = full_at_ns_;
+  while (full_at < empty_until && !full_at_ns_.compare_exchange_weak(full_at, empty_until)) {
+  }
+}
+
+LocalRateLimiter::LocalRateLimiter(Runtime::Loader& runtime, Stats::Scope& scope,
+                                   MonotonicTimeSource& time_source)
+    : runtime_(runtime), stats_(generateStats(scope)), time_source_(time_source) {}
+
+LocalRateLimitStats LocalRateLimiter::generateStats(Stats::Scope& scope) {
+  std::string final_prefix = "ratelimit.local.";
+  return {ALL_LOCAL_RATE_LIMIT_STATS(POOL_COUNTER_PREFIX(scope, final_prefix))};
+}
+
+LimitStatus LocalRateLimiter::limit(const std::string& domain,
+                                    const std::vector<Descriptor>& descriptors) {
+  bool limited_locally = false;
+  for (const Descriptor& descriptor : descriptors) {
+    BucketLimits limits;
+    if (!bucketLimits(domain, descriptor, limits)) {
+      continue;
+    }
+    TokenBucket* token_bucket = bucket(domain, descriptor);
+    if (token_bucket == nullptr) {
+      continue;
+    }
+
+    limited_locally = true;
+    if (!token_bucket->consume(limits.tokens_per_second_, limits.max_tokens_)) {
+      stats_.over_limit_.inc();
+      return LimitStatus::OverLimit;
+    }
+  }
+
+  if (limited_locally) {
+    stats_.ok_.inc();
+  }
+  return LimitStatus::OK;
+}
+
+void LocalRateLimiter::drain(const std::string& domain,
+                             const std::vector<Descriptor>& descriptors) {
+  for (const Descriptor& descriptor : descriptors) {
+    BucketLimits limits;
+    if (!bucketLimits(domain, descriptor, limits)) {
+      continue;
+    }
+    TokenBucket* token_bucket = bucket(domain, descriptor);
+    if (token_bucket != nullptr) {
+      token_bucket->drain(limits.tokens_per_second_, limits.max_tokens_);
+    }
+  }
+}
+
+bool LocalRateLimiter::preauthorize() {
+  return runtime_.snapshot().featureEnabled("ratelimit.local.preauthorize", 0);
+}
+
+bool LocalRateLimiter::bucketLimits(const std::string& domain, const Descriptor& descriptor,
+                                    BucketLimits& limits) {
+  std::string runtime_prefix = "ratelimit.local." + domain;
+  for (const DescriptorEntry& entry : descriptor.entries_) {
+    runtime_prefix += "." + entry.key_;
+  }
+
+  limits.tokens_per_second_ =
+      runtime_.snapshot().getInteger(runtime_prefix + ".tokens_per_second", 0);
+  if (limits.tokens_per_second_ == 0) {
+    return false;
+  }
+  limits.max_tokens_ = std::max<uint64_t>(
+      1, runtime_.snapshot().getInteger(runtime_prefix + ".max_tokens", limits.tokens_per_second_));
+  return true;
+}
+
+TokenBucket* LocalRateLimiter::bucket(const std::string& domain, const Descriptor& descriptor) {
+  // Entries are separated by NUL so that no two distinct descriptors share a key.
+  std::string key = domain;
+  for (const DescriptorEntry& entry : descriptor.entries_) {
+    key.push_back('\0');
+    key += entry.key_;
+    key.push_back('\0');
+    key += entry.value_;
+  }
+  const uint64_t max_buckets = runtime_.snapshot().getInteger("ratelimit.local.max_buckets", 10000);
+
+  std::lock_guard<std::mutex> guard(buckets_lock_);
+  auto it = buckets_.find(key);
+  if (it != buckets_.end()) {
+    return it->second.get();
+  }
+  if (buckets_.size() >= max_buckets) {
+    stats_.bucket_overflow_.inc();
+    return nullptr;
+  }
+
+  std::unique_ptr<TokenBucket>& new_bucket = buckets_[key];
+  new_bucket.reset(new TokenBucket(time_source_));
+  return new_bucket.get();
+}
+
+LocalReconciler::~LocalReconciler() {
+  for (const BackgroundCallPtr& call : calls_) {
+    call->client_->cancel();
+  }
+}
+
+void LocalReconciler::BackgroundCall::complete(LimitStatus status) {
+  if (status == LimitStatus::OverLimit) {
+    limiter_.drain(domain_, descriptors_);
+    limiter_.stats().reconcile_over_limit_.inc();
+  }
+
+  // Deleted once the stack unwinds, since this is inside the client's callback.
+  auto entry = entry_;
+  parent_.dispatcher_.deferredDelete(std::move(*entry));
+  parent_.calls_.erase(entry);
+}
+
+void LocalReconciler::start(BackgroundCallPtr&& call, Tracing::Span& parent_span) {
+  BackgroundCall& new_call = *call;
+  calls_.emplace_front(std::move(call));
+  new_call.entry_ = calls_.begin();
+  new_call.client_->limit(new_call, new_call.domain_, new_call.descriptors_, parent_span);
+}
+
+LocalClientImpl::~LocalClientImpl() {
+  if (callbacks_ != nullptr) {
+    cancel();
+  }
+}
+
+void LocalClientImpl::cancel() {
+  if (callbacks_ != nullptr) {
+    global_client_->cancel();
+    callbacks_ = nullptr;
+  }
+}
+
+void LocalClientImpl::limit(RequestCallbacks& callbacks, const std::string& domain,
+                            const std::vector<Descriptor>& descriptors,
+                            Tracing::Span& parent_span) {
+  ASSERT(callbacks_ == nullptr);
+  LocalRateLimiter& limiter = parent_.limiter_;
+  if (limiter.limit(domain, descriptors) == LimitStatus::OverLimit) {
+    callbacks.complete(LimitStatus::OverLimit);
+    return;
+  }
+
+  if (limiter.preauthorize()) {
+    // The call is started before the request is allowed, since the caller may destroy this client
+    // from its callbacks.
+    LocalReconciler& reconciler = parent_.tls_->getTyped<LocalReconciler>();
+    reconciler.start(LocalReconciler::BackgroundCallPtr{new LocalReconciler::BackgroundCall(
+                         reconciler, limiter, parent_.global_factory_->create(timeout_), domain,
+                         descriptors)},
+                     parent_span);
+    callbacks.complete(LimitStatus::OK);
+    return;
+  }
+
+  if (global_client_ == nullptr) {
+    global_client_ = parent_.global_factory_->create(timeout_);
+  }
+  domain_ = domain;
+  descriptors_ = descriptors;
+  callbacks_ = &callbacks;
+  global_client_->limit(*this, domain, descriptors, parent_span);
+}
+
+void LocalClientImpl::complete(LimitStatus status) {
+  if (status == LimitStatus::OverLimit) {
+    parent_.limiter_.drain(domain_, descriptors_);
+  }
+
+  RequestCallbacks* callbacks = callbacks_;
+  callbacks_ = nullptr;
+  callbacks->complete(status);
+}
+
+LocalFactoryImpl::LocalFactoryImpl(ClientFactoryPtr&& global_factory,
+                                   ThreadLocal::SlotAllocator& tls, Runtime::Loader& runtime,
+                                   Stats::Scope& scope, MonotonicTimeSource& time_source)
+    : global_factory_(std::move(global_factory)), tls_(tls.allocateSlot()),
+      limiter_(runtime, scope, time_source) {
+  tls_->set([](Event::Dispatcher& dispatcher) -> ThreadLocal::ThreadLocalObjectSharedPtr {
+    return std::make_shared<LocalReconciler>(dispatcher);
+  });
+}
+
+} // namespace RateLimit
+} // namespace Envoy
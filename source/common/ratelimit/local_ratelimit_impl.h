@@ -0,0 +1,229 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "envoy/common/time.h"
+#include "envoy/event/deferred_deletable.h"
+#include "envoy/event/dispatcher.h"
+#include "envoy/ratelimit/ratelimit.h"
+#include "envoy/runtime/runtime.h"
+#include "envoy/stats/stats_macros.h"
+#include "envoy/thread_local/thread_local.h"
+
+namespace Envoy {
+namespace RateLimit {
+
+/**
+ * All stats for local rate limiting. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_LOCAL_RATE_LIMIT_STATS(COUNTER)                                                        \
+  COUNTER(ok)                                                                                      \
+  COUNTER(over_limit)                                                                              \
+  COUNTER(bucket_overflow)                                                                         \
+  COUNTER(reconcile_over_limit)
+// clang-format on
+
+/**
+ * Struct definition for all local rate limit stats. @see stats_macros.h
+ */
+struct LocalRateLimitStats {
+  ALL_LOCAL_RATE_LIMIT_STATS(GENERATE_COUNTER_STRUCT)
+};
+
+/**
+ * Token bucket that any number of threads can take tokens from without a lock. Instead of a token
+ * count the bucket keeps the time at which it will be full again (the generic cell rate
+ * algorithm): each token pushes that time interval = 1 / tokens_per_second into the future, and a
+ * token can be taken as long as that does not put it more than max_tokens intervals ahead of now.
+ * The rate and size are passed on every call, so they can follow runtime changes.
+ */
+class TokenBucket {
+public:
+  TokenBucket(MonotonicTimeSource& time_source) : time_source_(time_source) {}
+
+  /**
+   * @return bool whether a token was available and was taken.
+   */
+  bool consume(uint64_t tokens_per_second, uint64_t max_tokens);
+
+  /**
+   * Take every token that is left, so that the bucket has to refill before it allows more.
+   */
+  void drain(uint64_t tokens_per_second, uint64_t max_tokens);
+
+private:
+  int64_t nowNs() const;
+
+  MonotonicTimeSource& time_source_;
+  // Monotonic time in ns at which the bucket is full again.
+  std::atomic<int64_t> full_at_ns_{};
+};
+
+/**
+ * Local token buckets for rate limit descriptors, shared by all workers. A descriptor is limited
+ * locally when the runtime has ratelimit.local.<domain>.<key 1>...<key n>.tokens_per_second for
+ * its entry keys, with an optional max_tokens burst size next to it (which defaults to
+ * tokens_per_second). Every distinct descriptor, keys and values, gets its own bucket, so a limit
+ * on remote_address applies per address. The number of buckets is capped by
+ * ratelimit.local.max_buckets; descriptors beyond the cap are not limited locally.
+ */
+class LocalRateLimiter {
+public:
+  LocalRateLimiter(Runtime::Loader& runtime, Stats::Scope& scope,
+                   MonotonicTimeSource& time_source);
+
+  /**
+   * Take a token for each locally limited descriptor.
+   * @return LimitStatus OverLimit if any of them is out of tokens, otherwise OK.
+   */
+  LimitStatus limit(const std::string& domain, const std::vector<Descriptor>& descriptors);
+
+  /**
+   * Drain the buckets of locally limited descriptors, after the rate limit service found a request
+   * with them over limit.
+   */
+  void drain(const std::string& domain, const std::vector<Descriptor>& descriptors);
+
+  /**
+   * @return bool whether requests that pass the local limits should be allowed right away, with the
+   *         rate limit service consulted in the background (ratelimit.local.preauthorize).
+   */
+  bool preauthorize();
+
+  LocalRateLimitStats& stats() { return stats_; }
+
+private:
+  struct BucketLimits {
+    uint64_t tokens_per_second_;
+    uint64_t max_tokens_;
+  };
+
+  static LocalRateLimitStats generateStats(Stats::Scope& scope);
+  bool bucketLimits(const std::string& domain, const Descriptor& descriptor,
+                    BucketLimits& limits);
+  TokenBucket* bucket(const std::string& domain, const Descriptor& descriptor);
+
+  Runtime::Loader& runtime_;
+  LocalRateLimitStats stats_;
+  MonotonicTimeSource& time_source_;
+  std::mutex buckets_lock_;
+  // Buckets are never removed, so pointers to them stay valid outside of the lock.
+  std::unordered_map<std::string, std::unique_ptr<TokenBucket>> buckets_;
+};
+
+/**
+ * Per worker owner of the rate limit service calls made in the background for preauthorized
+ * requests. The calls belong to the worker rather than to the request's client, so that a request
+ * that ends before the service answers is still reconciled. Calls that are still in flight when
+ * the worker shuts down are cancelled.
+ */
+class LocalReconciler : public ThreadLocal::ThreadLocalObject {
+public:
+  LocalReconciler(Event::Dispatcher& dispatcher) : dispatcher_(dispatcher) {}
+  ~LocalReconciler();
+
+  /**
+   * A call to the rate limit service for a request that has already been allowed.
+   */
+  struct BackgroundCall : public RequestCallbacks, public Event::DeferredDeletable {
+    BackgroundCall(LocalReconciler& parent, LocalRateLimiter& limiter, ClientPtr&& client,
+                   const std::string& domain, const std::vector<Descriptor>& descriptors)
+        : parent_(parent), limiter_(limiter), client_(std::move(client)), domain_(domain),
+          descriptors_(descriptors) {}
+
+    // RateLimit::RequestCallbacks
+    void complete(LimitStatus status) override;
+
+    LocalReconciler& parent_;
+    LocalRateLimiter& limiter_;
+    ClientPtr client_;
+    const std::string domain_;
+    const std::vector<Descriptor> descriptors_;
+    std::list<std::unique_ptr<BackgroundCall>>::iterator entry_;
+  };
+
+  typedef std::unique_ptr<BackgroundCall> BackgroundCallPtr;
+
+  /**
+   * Take ownership of a call and start it. It is deleted once it completes.
+   */
+  void start(BackgroundCallPtr&& call, Tracing::Span& parent_span);
+
+  /**
+   * @return size_t the number of calls in flight.
+   */
+  size_t size() const { return calls_.size(); }
+
+private:
+  Event::Dispatcher& dispatcher_;
+  std::list<BackgroundCallPtr> calls_;
+};
+
+class LocalFactoryImpl;
+
+/**
+ * Client that checks the local token buckets before the rate limit service. Requests that are over
+ * a local limit complete as OverLimit without calling the service. Otherwise the service is called
+ * as usual, or with ratelimit.local.preauthorize the request completes as OK right away and the
+ * worker's LocalReconciler calls the service in the background. Either way, when the service finds
+ * the request over limit the request's local buckets are drained, so that the local limits catch
+ * up with the global ones.
+ */
+class LocalClientImpl : public Client, public RequestCallbacks {
+public:
+  LocalClientImpl(LocalFactoryImpl& parent, const Optional<std::chrono::milliseconds>& timeout)
+      : parent_(parent), timeout_(timeout) {}
+  ~LocalClientImpl();
+
+  // RateLimit::Client
+  void cancel() override;
+  void limit(RequestCallbacks& callbacks, const std::string& domain,
+             const std::vector<Descriptor>& descriptors, Tracing::Span& parent_span) override;
+
+  // RateLimit::RequestCallbacks
+  void complete(LimitStatus status) override;
+
+private:
+  LocalFactoryImpl& parent_;
+  const Optional<std::chrono::milliseconds> timeout_;
+  // Client for the calls that the caller waits for, created on first use.
+  ClientPtr global_client_;
+  // The caller's callbacks while it waits for the service.
+  RequestCallbacks* callbacks_{};
+  std::string domain_;
+  std::vector<Descriptor> descriptors_;
+};
+
+/**
+ * Factory for LocalClientImpl, wrapping the factory for the rate limit service client.
+ */
+class LocalFactoryImpl : public ClientFactory {
+public:
+  LocalFactoryImpl(ClientFactoryPtr&& global_factory, ThreadLocal::SlotAllocator& tls,
+                   Runtime::Loader& runtime, Stats::Scope& scope,
+                   MonotonicTimeSource& time_source);
+
+  // RateLimit::ClientFactory
+  ClientPtr create(const Optional<std::chrono::milliseconds>& timeout) override {
+    return ClientPtr{new LocalClientImpl(*this, timeout)};
+  }
+
+private:
+  ClientFactoryPtr global_factory_;
+  ThreadLocal::SlotPtr tls_;
+  LocalRateLimiter limiter_;
+
+  friend class LocalClientImpl;
+};
+
+} // namespace RateLimit
+} // namespace Envoy
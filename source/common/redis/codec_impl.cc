@@ -4,6 +4,7 @@
 #include <string>
 #include <vector>
 
+#include "common/buffer/buffer_impl.h"
 #include "common/common/assert.h"
 #include "common/common/utility.h"
 
@@ -12,6 +13,45 @@
 namespace Envoy {
 namespace Redis {
 
+RespValue::RespValue(const RespValue& other) : type_(RespType::Null) { *this = other; }
+
+RespValue& RespValue::operator=(const RespValue& other) {
+  if (&other == this) {
+    return *this;
+  }
+
+  type(other.type());
+  switch (type_) {
+  case RespType::Array: {
+    array_ = other.array_;
+    break;
+  }
+  case RespType::BulkString: {
+    if (other.hasBuffer()) {
+      Buffer::InstancePtr copy(new Buffer::OwnedImpl());
+      copy->add(*other.buffer_);
+      buffer_ = std::move(copy);
+      break;
+    }
+    FALLTHRU;
+  }
+  case RespType::SimpleString:
+  case RespType::Error: {
+    string_ = other.string_;
+    break;
+  }
+  case RespType::Integer: {
+    integer_ = other.integer_;
+    break;
+  }
+  case RespType::Null: {
+    break;
+  }
+  }
+
+  return *this;
+}
+
 std::string RespValue::toString() const {
   switch (type_) {
   case RespType::Array: {
@@ -24,8 +64,15 @@ std::string RespValue::toString() const {
     }
     return ret + "]";
   }
-  case RespType::SimpleString:
   case RespType::BulkString:
+    if (buffer_ != nullptr) {
+      // Leave the bulk string in its buffer.
+      std::string string(buffer_->length(), '\0');
+      buffer_->copyOut(0, buffer_->length(), &string[0]);
+      return fmt::format("\"{}\"", string);
+    }
+    FALLTHRU;
+  case RespType::SimpleString:
   case RespType::Error:
     return fmt::format("\"{}\"", asString());
   case RespType::Null:
@@ -50,13 +97,33 @@ const std::vector<RespValue>& RespValue::asArray() const {
 std::string& RespValue::asString() {
   ASSERT(type_ == RespType::BulkString || type_ == RespType::Error ||
          type_ == RespType::SimpleString);
+  if (buffer_ != nullptr) {
+    string_.resize(buffer_->length());
+    buffer_->copyOut(0, buffer_->length(), &string_[0]);
+    buffer_.reset();
+  }
+
   return string_;
 }
 
 const std::string& RespValue::asString() const {
-  ASSERT(type_ == RespType::BulkString || type_ == RespType::Error ||
-         type_ == RespType::SimpleString);
-  return string_;
+  // Moving a bulk string from its buffer into string_ does not change the value.
+  return const_cast<RespValue*>(this)->asString();
+}
+
+Buffer::Instance& RespValue::asBuffer() {
+  ASSERT(type_ == RespType::BulkString && buffer_ != nullptr);
+  return *buffer_;
+}
+
+const Buffer::Instance& RespValue::asBuffer() const {
+  ASSERT(type_ == RespType::BulkString && buffer_ != nullptr);
+  return *buffer_;
+}
+
+void RespValue::buffer(Buffer::InstancePtr&& buffer) {
+  type(RespType::BulkString);
+  buffer_ = std::move(buffer);
 }
 
 int64_t& RespValue::asInteger() {
@@ -70,6 +137,8 @@ int64_t RespValue::asInteger() const {
 }
 
 void RespValue::cleanup() {
+  buffer_.reset();
+
   // Need to manually delete because of the union.
   switch (type_) {
   case RespType::Array: {
@@ -113,21 +182,38 @@ void RespValue::type(RespType type) {
 }
 
 void DecoderImpl::decode(Buffer::Instance& data) {
-  uint64_t num_slices = data.getRawSlices(nullptr, 0);
-  Buffer::RawSlice slices[num_slices];
-  data.getRawSlices(slices, num_slices);
-  for (const Buffer::RawSlice& slice : slices) {
-    parseSlice(slice);
-  }
+  while (data.length() > 0) {
+    if (state_ == State::BulkStringBuffer) {
+      const uint64_t length = std::min(pending_integer_.integer_, data.length());
+      pending_value_stack_.front().value_->asBuffer().move(data, length);
+      pending_integer_.integer_ -= length;
+      if (pending_integer_.integer_ == 0) {
+        state_ = State::CR;
+      }
+      continue;
+    }
 
-  data.drain(data.length());
+    uint64_t num_slices = data.getRawSlices(nullptr, 0);
+    Buffer::RawSlice slices[num_slices];
+    data.getRawSlices(slices, num_slices);
+    uint64_t consumed = 0;
+    for (const Buffer::RawSlice& slice : slices) {
+      consumed += parseSlice(slice);
+      if (state_ == State::BulkStringBuffer) {
+        // Everything parsed so far is drained before the bulk string is moved out of data.
+        break;
+      }
+    }
+
+    data.drain(consumed);
+  }
 }
 
-void DecoderImpl::parseSlice(const Buffer::RawSlice& slice) {
+uint64_t DecoderImpl::parseSlice(const Buffer::RawSlice& slice) {
   const char* buffer = reinterpret_cast<const char*>(slice.mem_);
   uint64_t remaining = slice.len_;
 
-  while (remaining || state_ == State::ValueComplete) {
+  while ((remaining || state_ == State::ValueComplete) && state_ != State::BulkStringBuffer) {
     ENVOY_LOG(trace, "parse slice: {} remaining", remaining);
     switch (state_) {
     case State::ValueRootStart: {
@@ -241,13 +327,16 @@ void DecoderImpl::parseSlice(const Buffer::RawSlice& slice) {
         state_ = State::ValueComplete;
       } else {
         ASSERT(current_value.value_->type() == RespType::BulkString);
-        if (!pending_integer_.negative_) {
-          // TODO(mattklein123): reserve and define max length since we don't stream currently.
-          state_ = State::BulkStringBody;
-        } else {
+        if (pending_integer_.negative_) {
           // Null bulk string. Switch type to null and move to value complete.
           current_value.value_->type(RespType::Null);
           state_ = State::ValueComplete;
+        } else if (pending_integer_.integer_ >= LARGE_BULK_STRING_SIZE) {
+          current_value.value_->buffer(Buffer::InstancePtr{new Buffer::OwnedImpl()});
+          state_ = State::BulkStringBuffer;
+        } else {
+          // TODO(mattklein123): reserve and define max length since we don't stream currently.
+          state_ = State::BulkStringBody;
         }
       }
 
@@ -272,6 +361,11 @@ void DecoderImpl::parseSlice(const Buffer::RawSlice& slice) {
       break;
     }
 
+    case State::BulkStringBuffer: {
+      // Handled by decode(), which moves the bulk string straight from the input.
+      NOT_REACHED;
+    }
+
     case State::CR: {
       ENVOY_LOG(trace, "parse slice: CR");
       if (buffer[0] != '\r') {
@@ -331,12 +425,21 @@ void DecoderImpl::parseSlice(const Buffer::RawSlice& slice) {
     }
     }
   }
+
+  return slice.len_ - remaining;
 }
 
-void EncoderImpl::encode(const RespValue& value, Buffer::Instance& out) {
+static void addBuffer(const Buffer::Instance& buffer, Buffer::Instance& out) { out.add(buffer); }
+
+static void addBuffer(Buffer::Instance& buffer, Buffer::Instance& out) { out.move(buffer); }
+
+template <class Value> void EncoderImpl::encodeValue(Value& value, Buffer::Instance& out) {
   switch (value.type()) {
   case RespType::Array: {
-    encodeArray(value.asArray(), out);
+    encodeArrayLength(value.asArray().size(), out);
+    for (Value& element : value.asArray()) {
+      encodeValue(element, out);
+    }
     break;
   }
   case RespType::SimpleString: {
@@ -344,7 +447,13 @@ void EncoderImpl::encode(const RespValue& value, Buffer::Instance& out) {
     break;
   }
   case RespType::BulkString: {
-    encodeBulkString(value.asString(), out);
+    if (value.hasBuffer()) {
+      encodeBulkStringLength(value.asBuffer().length(), out);
+      addBuffer(value.asBuffer(), out);
+      out.add("\r\n", 2);
+    } else {
+      encodeBulkString(value.asString(), out);
+    }
     break;
   }
   case RespType::Error: {
@@ -361,28 +470,32 @@ void EncoderImpl::encode(const RespValue& value, Buffer::Instance& out) {
   }
 }
 
-void EncoderImpl::encodeArray(const std::vector<RespValue>& array, Buffer::Instance& out) {
+void EncoderImpl::encode(const RespValue& value, Buffer::Instance& out) { encodeValue(value, out); }
+
+void EncoderImpl::encode(RespValuePtr&& value, Buffer::Instance& out) { encodeValue(*value, out); }
+
+void EncoderImpl::encodeArrayLength(uint64_t length, Buffer::Instance& out) {
   char buffer[32];
   char* current = buffer;
   *current++ = '*';
-  current += StringUtil::itoa(current, 31, array.size());
+  current += StringUtil::itoa(current, 31, length);
   *current++ = '\r';
   *current++ = '\n';
   out.add(buffer, current - buffer);
-
-  for (const RespValue& value : array) {
-    encode(value, out);
-  }
 }
 
-void EncoderImpl::encodeBulkString(const std::string& string, Buffer::Instance& out) {
+void EncoderImpl::encodeBulkStringLength(uint64_t length, Buffer::Instance& out) {
   char buffer[32];
   char* current = buffer;
   *current++ = '$';
-  current += StringUtil::itoa(current, 31, string.size());
+  current += StringUtil::itoa(current, 31, length);
   *current++ = '\r';
   *current++ = '\n';
   out.add(buffer, current - buffer);
+}
+
+void EncoderImpl::encodeBulkString(const std::string& string, Buffer::Instance& out) {
+  encodeBulkStringLength(string.size(), out);
   out.add(string);
   out.add("\r\n", 2);
 }
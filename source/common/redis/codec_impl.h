@@ -16,6 +16,8 @@ namespace Redis {
  * Decoder implementation of https://redis.io/topics/protocol
  *
  * This implementation buffers when needed and will always consume all bytes passed for decoding.
+ * Bulk strings of at least LARGE_BULK_STRING_SIZE bytes are moved from the input into a buffer
+ * held by the value instead of being copied into a std::string.
  */
 class DecoderImpl : public Decoder, Logger::Loggable<Logger::Id::redis> {
 public:
@@ -24,6 +26,8 @@ public:
   // Redis::Decoder
   void decode(Buffer::Instance& data) override;
 
+  static const uint64_t LARGE_BULK_STRING_SIZE = 16 * 1024;
+
 private:
   enum class State {
     ValueRootStart,
@@ -32,6 +36,7 @@ private:
     Integer,
     IntegerLF,
     BulkStringBody,
+    BulkStringBuffer,
     CR,
     LF,
     SimpleString,
@@ -53,7 +58,7 @@ private:
     uint64_t current_array_element_;
   };
 
-  void parseSlice(const Buffer::RawSlice& slice);
+  uint64_t parseSlice(const Buffer::RawSlice& slice);
 
   DecoderCallbacks& callbacks_;
   State state_{State::ValueRootStart};
@@ -80,9 +85,14 @@ class EncoderImpl : public Encoder {
 public:
   // Redis::Encoder
   void encode(const RespValue& value, Buffer::Instance& out) override;
+  void encode(RespValuePtr&& value, Buffer::Instance& out) override;
 
 private:
-  void encodeArray(const std::vector<RespValue>& array, Buffer::Instance& out);
+  // Value is either const RespValue, whose buffers are copied, or RespValue, whose buffers are
+  // moved.
+  template <class Value> void encodeValue(Value& value, Buffer::Instance& out);
+  void encodeArrayLength(uint64_t length, Buffer::Instance& out);
+  void encodeBulkStringLength(uint64_t length, Buffer::Instance& out);
   void encodeBulkString(const std::string& string, Buffer::Instance& out);
   void encodeError(const std::string& string, Buffer::Instance& out);
   void encodeInteger(int64_t integer, Buffer::Instance& out);
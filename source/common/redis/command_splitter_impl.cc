@@ -31,6 +31,16 @@ SingleServerRequest::~SingleServerRequest() { ASSERT(!handle_); }
 
 void SingleServerRequest::onResponse(RespValuePtr&& response) {
   handle_ = nullptr;
+  // A redis cluster node answers requests for keys of slots it does not serve with a MOVED or ASK
+  // error naming the node that does. The request is made again there, once, and the error is
+  // passed through if that is not possible.
+  if (!redirected_ && response->type() == RespType::Error) {
+    handle_ = conn_pool_.makeRedirectedRequest(*response, incoming_request_, *this);
+    if (handle_) {
+      redirected_ = true;
+      return;
+    }
+  }
   callbacks_.onResponse(std::move(response));
 }
 
@@ -47,7 +57,8 @@ void SingleServerRequest::cancel() {
 SplitRequestPtr SimpleRequest::create(ConnPool::Instance& conn_pool,
                                       const RespValue& incoming_request,
                                       SplitCallbacks& callbacks) {
-  std::unique_ptr<SimpleRequest> request_ptr{new SimpleRequest(callbacks)};
+  std::unique_ptr<SimpleRequest> request_ptr{
+      new SimpleRequest(conn_pool, incoming_request, callbacks)};
 
   request_ptr->handle_ = conn_pool.makeRequest(incoming_request.asArray()[1].asString(),
                                                incoming_request, *request_ptr);
@@ -59,6 +70,22 @@ SplitRequestPtr SimpleRequest::create(ConnPool::Instance& conn_pool,
   return std::move(request_ptr);
 }
 
+SplitRequestPtr ReplicaReadRequest::create(ConnPool::Instance& conn_pool,
+                                           const RespValue& incoming_request,
+                                           SplitCallbacks& callbacks) {
+  std::unique_ptr<ReplicaReadRequest> request_ptr{
+      new ReplicaReadRequest(conn_pool, incoming_request, callbacks)};
+
+  request_ptr->handle_ = conn_pool.makeReplicaRequest(incoming_request.asArray()[1].asString(),
+                                                      incoming_request, *request_ptr);
+  if (!request_ptr->handle_) {
+    request_ptr->callbacks_.onResponse(Utility::makeError("no upstream host"));
+    return nullptr;
+  }
+
+  return std::move(request_ptr);
+}
+
 SplitRequestPtr EvalRequest::create(ConnPool::Instance& conn_pool,
                                     const RespValue& incoming_request, SplitCallbacks& callbacks) {
 
@@ -69,7 +96,8 @@ SplitRequestPtr EvalRequest::create(ConnPool::Instance& conn_pool,
     return nullptr;
   }
 
-  std::unique_ptr<EvalRequest> request_ptr{new EvalRequest(callbacks)};
+  std::unique_ptr<EvalRequest> request_ptr{
+      new EvalRequest(conn_pool, incoming_request, callbacks)};
   request_ptr->handle_ = conn_pool.makeRequest(incoming_request.asArray()[3].asString(),
                                                incoming_request, *request_ptr);
   if (!request_ptr->handle_) {
@@ -101,34 +129,54 @@ void FragmentedRequest::onChildFailure(uint32_t index) {
   onChildResponse(Utility::makeError("upstream failure"), index);
 }
 
+/**
+ * Groups the keys of a multi key command by upstream. The keys are the arguments of the command
+ * starting with the first and then every stride'th one.
+ */
+static std::vector<std::vector<uint32_t>> groupKeys(ConnPool::Instance& conn_pool,
+                                                    const RespValue& incoming_request,
+                                                    uint32_t stride) {
+  std::vector<const std::string*> keys;
+  keys.reserve(incoming_request.asArray().size() / stride);
+  for (uint64_t i = 1; i < incoming_request.asArray().size(); i += stride) {
+    keys.push_back(&incoming_request.asArray()[i].asString());
+  }
+  return conn_pool.groupKeys(keys);
+}
+
 SplitRequestPtr MGETRequest::create(ConnPool::Instance& conn_pool,
                                     const RespValue& incoming_request, SplitCallbacks& callbacks) {
   std::unique_ptr<MGETRequest> request_ptr{new MGETRequest(callbacks)};
+  std::vector<std::vector<uint32_t>> groups = groupKeys(conn_pool, incoming_request, 1);
 
-  request_ptr->num_pending_responses_ = incoming_request.asArray().size() - 1;
-  request_ptr->pending_requests_.reserve(request_ptr->num_pending_responses_);
+  request_ptr->num_pending_responses_ = groups.size();
+  request_ptr->pending_requests_.reserve(groups.size());
 
   request_ptr->pending_response_.reset(new RespValue());
   request_ptr->pending_response_->type(RespType::Array);
-  std::vector<RespValue> responses(request_ptr->num_pending_responses_);
+  std::vector<RespValue> responses(incoming_request.asArray().size() - 1);
   request_ptr->pending_response_->asArray().swap(responses);
 
-  std::vector<RespValue> values(2);
-  values[0].type(RespType::BulkString);
-  values[0].asString() = "get";
-  values[1].type(RespType::BulkString);
-  RespValue single_mget;
-  single_mget.type(RespType::Array);
-  single_mget.asArray().swap(values);
-
-  for (uint64_t i = 1; i < incoming_request.asArray().size(); i++) {
-    request_ptr->pending_requests_.emplace_back(*request_ptr, i - 1);
+  for (uint32_t group = 0; group < groups.size(); group++) {
+    request_ptr->pending_requests_.emplace_back(*request_ptr, group);
     PendingRequest& pending_request = request_ptr->pending_requests_.back();
+    pending_request.keys_.swap(groups[group]);
+
+    std::vector<RespValue> values(pending_request.keys_.size() + 1);
+    values[0].type(RespType::BulkString);
+    values[0].asString() = pending_request.keys_.size() == 1 ? "get" : "mget";
+    for (uint64_t i = 0; i < pending_request.keys_.size(); i++) {
+      const uint64_t argument = pending_request.keys_[i] + 1;
+      values[i + 1].type(RespType::BulkString);
+      values[i + 1].asString() = incoming_request.asArray()[argument].asString();
+    }
+    RespValue fragment;
+    fragment.type(RespType::Array);
+    fragment.asArray().swap(values);
 
-    single_mget.asArray()[1].asString() = incoming_request.asArray()[i].asString();
-    ENVOY_LOG(debug, "redis: parallel get: '{}'", single_mget.toString());
-    pending_request.handle_ = conn_pool.makeRequest(incoming_request.asArray()[i].asString(),
-                                                    single_mget, pending_request);
+    ENVOY_LOG(debug, "redis: parallel get: '{}'", fragment.toString());
+    pending_request.handle_ =
+        conn_pool.makeRequest(fragment.asArray()[1].asString(), fragment, pending_request);
     if (!pending_request.handle_) {
       pending_request.onResponse(Utility::makeError("no upstream host"));
     }
@@ -137,16 +185,14 @@ SplitRequestPtr MGETRequest::create(ConnPool::Instance& conn_pool,
   return request_ptr->num_pending_responses_ > 0 ? std::move(request_ptr) : nullptr;
 }
 
-void MGETRequest::onChildResponse(RespValuePtr&& value, uint32_t index) {
-  pending_requests_[index].handle_ = nullptr;
-
-  pending_response_->asArray()[index].type(value->type());
-  switch (value->type()) {
+void MGETRequest::onKeyResponse(RespValue& value, uint32_t key) {
+  pending_response_->asArray()[key].type(value.type());
+  switch (value.type()) {
   case RespType::Array:
   case RespType::Integer:
   case RespType::SimpleString: {
-    pending_response_->asArray()[index].type(RespType::Error);
-    pending_response_->asArray()[index].asString() = "upstream protocol error";
+    pending_response_->asArray()[key].type(RespType::Error);
+    pending_response_->asArray()[key].asString() = "upstream protocol error";
     error_count_++;
     break;
   }
@@ -155,12 +201,35 @@ void MGETRequest::onChildResponse(RespValuePtr&& value, uint32_t index) {
     FALLTHRU;
   }
   case RespType::BulkString: {
-    pending_response_->asArray()[index].asString().swap(value->asString());
+    pending_response_->asArray()[key].asString().swap(value.asString());
     break;
   }
   case RespType::Null:
     break;
   }
+}
+
+void MGETRequest::onChildResponse(RespValuePtr&& value, uint32_t index) {
+  pending_requests_[index].handle_ = nullptr;
+
+  const std::vector<uint32_t>& keys = pending_requests_[index].keys_;
+  if (keys.size() == 1) {
+    onKeyResponse(*value, keys[0]);
+  } else if (value->type() == RespType::Array && value->asArray().size() == keys.size()) {
+    for (uint64_t i = 0; i < keys.size(); i++) {
+      onKeyResponse(value->asArray()[i], keys[i]);
+    }
+  } else {
+    // The whole MGET failed. Each of its keys gets the error, or a protocol error if the response
+    // is not an error either.
+    for (const uint32_t key : keys) {
+      RespValue error;
+      error.type(RespType::Error);
+      error.asString() =
+          value->type() == RespType::Error ? value->asString() : "upstream protocol error";
+      onKeyResponse(error, key);
+    }
+  }
 
   ASSERT(num_pending_responses_ > 0);
   if (--num_pending_responses_ == 0) {
@@ -177,33 +246,36 @@ SplitRequestPtr MSETRequest::create(ConnPool::Instance& conn_pool,
   }
 
   std::unique_ptr<MSETRequest> request_ptr{new MSETRequest(callbacks)};
+  std::vector<std::vector<uint32_t>> groups = groupKeys(conn_pool, incoming_request, 2);
 
-  request_ptr->num_pending_responses_ = (incoming_request.asArray().size() - 1) / 2;
-  request_ptr->pending_requests_.reserve(request_ptr->num_pending_responses_);
+  request_ptr->num_pending_responses_ = groups.size();
+  request_ptr->pending_requests_.reserve(groups.size());
 
   request_ptr->pending_response_.reset(new RespValue());
   request_ptr->pending_response_->type(RespType::SimpleString);
 
-  std::vector<RespValue> values(3);
-  values[0].type(RespType::BulkString);
-  values[0].asString() = "set";
-  values[1].type(RespType::BulkString);
-  values[2].type(RespType::BulkString);
-  RespValue single_mset;
-  single_mset.type(RespType::Array);
-  single_mset.asArray().swap(values);
-
-  uint64_t fragment_index = 0;
-  for (uint64_t i = 1; i < incoming_request.asArray().size(); i += 2) {
-    request_ptr->pending_requests_.emplace_back(*request_ptr, fragment_index++);
+  for (uint32_t group = 0; group < groups.size(); group++) {
+    request_ptr->pending_requests_.emplace_back(*request_ptr, group);
     PendingRequest& pending_request = request_ptr->pending_requests_.back();
+    pending_request.keys_.swap(groups[group]);
+
+    std::vector<RespValue> values(pending_request.keys_.size() * 2 + 1);
+    values[0].type(RespType::BulkString);
+    values[0].asString() = pending_request.keys_.size() == 1 ? "set" : "mset";
+    for (uint64_t i = 0; i < pending_request.keys_.size(); i++) {
+      const uint64_t argument = pending_request.keys_[i] * 2 + 1;
+      values[i * 2 + 1].type(RespType::BulkString);
+      values[i * 2 + 1].asString() = incoming_request.asArray()[argument].asString();
+      values[i * 2 + 2].type(RespType::BulkString);
+      values[i * 2 + 2].asString() = incoming_request.asArray()[argument + 1].asString();
+    }
+    RespValue fragment;
+    fragment.type(RespType::Array);
+    fragment.asArray().swap(values);
 
-    single_mset.asArray()[1].asString() = incoming_request.asArray()[i].asString();
-    single_mset.asArray()[2].asString() = incoming_request.asArray()[i + 1].asString();
-
-    ENVOY_LOG(debug, "redis: parallel set: '{}'", single_mset.toString());
-    pending_request.handle_ = conn_pool.makeRequest(incoming_request.asArray()[i].asString(),
-                                                    single_mset, pending_request);
+    ENVOY_LOG(debug, "redis: parallel set: '{}'", fragment.toString());
+    pending_request.handle_ =
+        conn_pool.makeRequest(fragment.asArray()[1].asString(), fragment, pending_request);
     if (!pending_request.handle_) {
       pending_request.onResponse(Utility::makeError("no upstream host"));
     }
@@ -223,7 +295,8 @@ void MSETRequest::onChildResponse(RespValuePtr&& value, uint32_t index) {
     FALLTHRU;
   }
   default: {
-    error_count_++;
+    // Errors are counted per key and value pair.
+    error_count_ += pending_requests_[index].keys_.size();
     break;
   }
   }
@@ -302,10 +375,32 @@ void SplitKeysSumResultRequest::onChildResponse(RespValuePtr&& value, uint32_t i
   }
 }
 
+SplitRequestPtr CachedReadRequest::create(CommandHandler& handler, HotKeyCache& cache,
+                                          uint64_t generation, const RespValue& incoming_request,
+                                          SplitCallbacks& callbacks) {
+  std::unique_ptr<CachedReadRequest> request_ptr{
+      new CachedReadRequest(cache, generation, incoming_request, callbacks)};
+
+  request_ptr->handle_ = handler.startRequest(incoming_request, *request_ptr);
+  return request_ptr->handle_ ? std::move(request_ptr) : nullptr;
+}
+
+void CachedReadRequest::onResponse(RespValuePtr&& response) {
+  if (response->type() != RespType::Error) {
+    cache_.insert(incoming_request_, *response, generation_);
+  }
+  callbacks_.onResponse(std::move(response));
+}
+
+void CachedReadRequest::cancel() { handle_->cancel(); }
+
 InstanceImpl::InstanceImpl(ConnPool::InstancePtr&& conn_pool, Stats::Scope& scope,
-                           const std::string& stat_prefix)
-    : conn_pool_(std::move(conn_pool)), simple_command_handler_(*conn_pool_),
-      eval_command_handler_(*conn_pool_), mget_handler_(*conn_pool_), mset_handler_(*conn_pool_),
+                           const std::string& stat_prefix, Runtime::Loader& runtime,
+                           ThreadLocal::SlotAllocator& tls, MonotonicTimeSource& time_source)
+    : conn_pool_(std::move(conn_pool)), runtime_(runtime),
+      hot_key_cache_(runtime, tls, time_source), simple_command_handler_(*conn_pool_),
+      replica_read_handler_(*conn_pool_), eval_command_handler_(*conn_pool_),
+      mget_handler_(*conn_pool_), mset_handler_(*conn_pool_),
       split_keys_sum_result_handler_(*conn_pool_),
       stats_{ALL_COMMAND_SPLITTER_STATS(POOL_COUNTER_PREFIX(scope, stat_prefix + "splitter."))} {
   // TODO(mattklein123) PERF: Make this a trie (like in header_map_impl).
@@ -323,6 +418,10 @@ InstanceImpl::InstanceImpl(ConnPool::InstancePtr&& conn_pool, Stats::Scope& scop
 
   addHandler(scope, stat_prefix, SupportedCommands::mget(), mget_handler_);
   addHandler(scope, stat_prefix, SupportedCommands::mset(), mset_handler_);
+
+  for (const std::string& command : SupportedCommands::readOnlyCommands()) {
+    command_map_.at(command).read_only_ = true;
+  }
 }
 
 SplitRequestPtr InstanceImpl::makeRequest(const RespValue& request, SplitCallbacks& callbacks) {
@@ -351,9 +450,37 @@ SplitRequestPtr InstanceImpl::makeRequest(const RespValue& request, SplitCallbac
 
   ENVOY_LOG(debug, "redis: splitting '{}'", request.toString());
   handler->second.total_.inc();
+  if (handler->second.read_only_) {
+    return makeReadRequest(handler->second, request, callbacks);
+  }
+
+  hot_key_cache_.invalidate(request);
   return handler->second.handler_.get().startRequest(request, callbacks);
 }
 
+SplitRequestPtr InstanceImpl::makeReadRequest(const HandlerData& handler,
+                                              const RespValue& request,
+                                              SplitCallbacks& callbacks) {
+  CommandHandler& read_handler =
+      runtime_.snapshot().featureEnabled("redis.read_from_replicas", 0)
+          ? static_cast<CommandHandler&>(replica_read_handler_)
+          : handler.handler_.get();
+  if (!hot_key_cache_.enabled(request.asArray()[1].asString())) {
+    return read_handler.startRequest(request, callbacks);
+  }
+
+  uint64_t generation;
+  RespValuePtr response = hot_key_cache_.lookup(request, generation);
+  if (response) {
+    stats_.hot_key_cache_hit_.inc();
+    callbacks.onResponse(std::move(response));
+    return nullptr;
+  }
+
+  stats_.hot_key_cache_miss_.inc();
+  return CachedReadRequest::create(read_handler, hot_key_cache_, generation, request, callbacks);
+}
+
 void InstanceImpl::onInvalidRequest(SplitCallbacks& callbacks) {
   stats_.invalid_request_.inc();
   callbacks.onResponse(Utility::makeError("invalid request"));
@@ -366,7 +493,7 @@ void InstanceImpl::addHandler(Stats::Scope& scope, const std::string& stat_prefi
   command_map_.emplace(
       to_lower_name,
       HandlerData{scope.counter(fmt::format("{}command.{}.total", stat_prefix, to_lower_name)),
-                  handler});
+                  handler, false});
 }
 
 } // namespace CommandSplitter
@@ -5,11 +5,15 @@
 #include <unordered_map>
 #include <vector>
 
+#include "envoy/common/time.h"
 #include "envoy/redis/command_splitter.h"
 #include "envoy/redis/conn_pool.h"
+#include "envoy/runtime/runtime.h"
+#include "envoy/thread_local/thread_local.h"
 
 #include "common/common/logger.h"
 #include "common/common/to_lower_table.h"
+#include "common/redis/hot_key_cache.h"
 
 namespace Envoy {
 namespace Redis {
@@ -54,10 +58,15 @@ public:
   void cancel() override;
 
 protected:
-  SingleServerRequest(SplitCallbacks& callbacks) : callbacks_(callbacks) {}
+  SingleServerRequest(ConnPool::Instance& conn_pool, const RespValue& incoming_request,
+                      SplitCallbacks& callbacks)
+      : conn_pool_(conn_pool), incoming_request_(incoming_request), callbacks_(callbacks) {}
 
+  ConnPool::Instance& conn_pool_;
+  const RespValue& incoming_request_;
   SplitCallbacks& callbacks_;
   ConnPool::PoolRequest* handle_{};
+  bool redirected_{};
 };
 
 /**
@@ -69,7 +78,24 @@ public:
                                 SplitCallbacks& callbacks);
 
 private:
-  SimpleRequest(SplitCallbacks& callbacks) : SingleServerRequest(callbacks) {}
+  SimpleRequest(ConnPool::Instance& conn_pool, const RespValue& incoming_request,
+                SplitCallbacks& callbacks)
+      : SingleServerRequest(conn_pool, incoming_request, callbacks) {}
+};
+
+/**
+ * ReplicaReadRequest hashes the first argument as the key, like SimpleRequest, and is made to a
+ * replica where possible. Only read only commands are made this way.
+ */
+class ReplicaReadRequest : public SingleServerRequest {
+public:
+  static SplitRequestPtr create(ConnPool::Instance& conn_pool, const RespValue& incoming_request,
+                                SplitCallbacks& callbacks);
+
+private:
+  ReplicaReadRequest(ConnPool::Instance& conn_pool, const RespValue& incoming_request,
+                     SplitCallbacks& callbacks)
+      : SingleServerRequest(conn_pool, incoming_request, callbacks) {}
 };
 
 /**
@@ -81,7 +107,9 @@ public:
                                 SplitCallbacks& callbacks);
 
 private:
-  EvalRequest(SplitCallbacks& callbacks) : SingleServerRequest(callbacks) {}
+  EvalRequest(ConnPool::Instance& conn_pool, const RespValue& incoming_request,
+                SplitCallbacks& callbacks)
+      : SingleServerRequest(conn_pool, incoming_request, callbacks) {}
 };
 
 /**
@@ -111,6 +139,9 @@ protected:
     FragmentedRequest& parent_;
     const uint32_t index_;
     ConnPool::PoolRequest* handle_{};
+    // The keys of the incoming request, as indexes into its arguments, that the fragment covers
+    // when it combines the keys of one upstream.
+    std::vector<uint32_t> keys_;
   };
 
   virtual void onChildResponse(RespValuePtr&& value, uint32_t index) PURE;
@@ -124,8 +155,9 @@ protected:
 };
 
 /**
- * MGETRequest takes each key from the command and sends a GET for each to the appropriate Redis
- * server. The response contains the result from each command.
+ * MGETRequest groups the keys of the command by the Redis server they hash to and sends an MGET
+ * for each group, or a GET if the group has a single key. The response contains the result for
+ * each key, in the order of the command.
  */
 class MGETRequest : public FragmentedRequest, Logger::Loggable<Logger::Id::redis> {
 public:
@@ -135,6 +167,8 @@ public:
 private:
   MGETRequest(SplitCallbacks& callbacks) : FragmentedRequest(callbacks) {}
 
+  void onKeyResponse(RespValue& value, uint32_t key);
+
   // Redis::CommandSplitter::FragmentedRequest
   void onChildResponse(RespValuePtr&& value, uint32_t index) override;
 };
@@ -160,9 +194,9 @@ private:
 };
 
 /**
- * MSETRequest takes each key and value pair from the command and sends a SET for each to the
- * appropriate Redis server. The response is an OK if all commands succeeded or an ERR if any
- * failed.
+ * MSETRequest groups the key and value pairs of the command by the Redis server their keys hash
+ * to and sends an MSET for each group, or a SET if the group has a single pair. The response is
+ * an OK if all commands succeeded or an ERR if any failed.
  */
 class MSETRequest : public FragmentedRequest, Logger::Loggable<Logger::Id::redis> {
 public:
@@ -176,6 +210,34 @@ private:
   void onChildResponse(RespValuePtr&& value, uint32_t index) override;
 };
 
+/**
+ * CachedReadRequest wraps a read only request that missed the hot key cache, and caches its
+ * response unless it is an error.
+ */
+class CachedReadRequest : public SplitRequest, public SplitCallbacks {
+public:
+  static SplitRequestPtr create(CommandHandler& handler, HotKeyCache& cache, uint64_t generation,
+                                const RespValue& incoming_request, SplitCallbacks& callbacks);
+
+  // Redis::CommandSplitter::SplitCallbacks
+  void onResponse(RespValuePtr&& response) override;
+
+  // Redis::CommandSplitter::SplitRequest
+  void cancel() override;
+
+private:
+  CachedReadRequest(HotKeyCache& cache, uint64_t generation, const RespValue& incoming_request,
+                    SplitCallbacks& callbacks)
+      : cache_(cache), generation_(generation), incoming_request_(incoming_request),
+        callbacks_(callbacks) {}
+
+  HotKeyCache& cache_;
+  const uint64_t generation_;
+  const RespValue& incoming_request_;
+  SplitCallbacks& callbacks_;
+  SplitRequestPtr handle_;
+};
+
 /**
  * CommandHandlerFactory is placed in the command lookup map for each supported command and is used
  * to create Request objects.
@@ -195,7 +257,9 @@ public:
 // clang-format off
 #define ALL_COMMAND_SPLITTER_STATS(COUNTER)                                                        \
   COUNTER(invalid_request)                                                                         \
-  COUNTER(unsupported_command)
+  COUNTER(unsupported_command)                                                                     \
+  COUNTER(hot_key_cache_hit)                                                                       \
+  COUNTER(hot_key_cache_miss)
 // clang-format on
 
 /**
@@ -208,7 +272,8 @@ struct InstanceStats {
 class InstanceImpl : public Instance, Logger::Loggable<Logger::Id::redis> {
 public:
   InstanceImpl(ConnPool::InstancePtr&& conn_pool, Stats::Scope& scope,
-               const std::string& stat_prefix);
+               const std::string& stat_prefix, Runtime::Loader& runtime,
+               ThreadLocal::SlotAllocator& tls, MonotonicTimeSource& time_source);
 
   // Redis::CommandSplitter::Instance
   SplitRequestPtr makeRequest(const RespValue& request, SplitCallbacks& callbacks) override;
@@ -217,14 +282,21 @@ private:
   struct HandlerData {
     Stats::Counter& total_;
     std::reference_wrapper<CommandHandler> handler_;
+    // Whether the command only reads, so that it can be made to a replica or served from cache.
+    bool read_only_;
   };
 
   void addHandler(Stats::Scope& scope, const std::string& stat_prefix, const std::string& name,
                   CommandHandler& handler);
   void onInvalidRequest(SplitCallbacks& callbacks);
+  SplitRequestPtr makeReadRequest(const HandlerData& handler, const RespValue& request,
+                                  SplitCallbacks& callbacks);
 
   ConnPool::InstancePtr conn_pool_;
+  Runtime::Loader& runtime_;
+  HotKeyCache hot_key_cache_;
   CommandHandlerFactory<SimpleRequest> simple_command_handler_;
+  CommandHandlerFactory<ReplicaReadRequest> replica_read_handler_;
   CommandHandlerFactory<EvalRequest> eval_command_handler_;
   CommandHandlerFactory<MGETRequest> mget_handler_;
   CommandHandlerFactory<MSETRequest> mset_handler_;
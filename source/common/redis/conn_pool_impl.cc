@@ -1,11 +1,17 @@
 #include "common/redis/conn_pool_impl.h"
 
+#include <algorithm>
+#include <array>
 #include <cstdint>
+#include <map>
 #include <memory>
 #include <string>
 #include <vector>
 
 #include "common/common/assert.h"
+#include "common/common/utility.h"
+
+#include "fmt/format.h"
 
 namespace Envoy {
 namespace Redis {
@@ -32,7 +38,13 @@ ClientImpl::ClientImpl(Upstream::HostConstSharedPtr host, Event::Dispatcher& dis
                        EncoderPtr&& encoder, DecoderFactory& decoder_factory, const Config& config)
     : host_(host), encoder_(std::move(encoder)), decoder_(decoder_factory.create(*this)),
       config_(config),
-      connect_or_op_timer_(dispatcher.createTimer([this]() -> void { onConnectOrOpTimeout(); })) {
+      connect_or_op_timer_(dispatcher.createTimer([this]() -> void { onConnectOrOpTimeout(); })),
+      flush_timer_(dispatcher.createTimer([this]() -> void {
+        flush_scheduled_ = false;
+        flushBuffer();
+      })),
+      stats_{ALL_REDIS_CLIENT_STATS(
+          POOL_HISTOGRAM_PREFIX(host->cluster().statsScope(), "redis."))} {
   host->cluster().stats().upstream_cx_total_.inc();
   host->cluster().stats().upstream_cx_active_.inc();
   host->stats().cx_total_.inc();
@@ -54,7 +66,16 @@ PoolRequest* ClientImpl::makeRequest(const RespValue& request, PoolCallbacks& ca
 
   pending_requests_.emplace_back(*this, callbacks);
   encoder_->encode(request, encoder_buffer_);
-  connection_->write(encoder_buffer_);
+
+  // Requests made during the same dispatcher iteration, such as a burst of commands from many
+  // downstream clients, are written to the connection together once the iteration is done with
+  // them, rather than as one write per request.
+  if (encoder_buffer_.length() >= MAX_BUFFER_SIZE_BEFORE_FLUSH) {
+    flushBuffer();
+  } else if (!flush_scheduled_) {
+    flush_scheduled_ = true;
+    flush_timer_->enableTimer(std::chrono::milliseconds(0));
+  }
 
   // Only boost the op timeout if:
   // - We are not already connected. Otherwise, we are governed by the connect timeout and the timer
@@ -69,6 +90,19 @@ PoolRequest* ClientImpl::makeRequest(const RespValue& request, PoolCallbacks& ca
   return &pending_requests_.back();
 }
 
+void ClientImpl::flushBuffer() {
+  if (written_requests_ == pending_requests_.size()) {
+    return;
+  }
+
+  // Requests are added behind the ones that have been written and responses arrive in order, so
+  // the pending requests past the first written_requests_ are the ones in this write.
+  stats_.upstream_rq_batch_size_.recordValue(pending_requests_.size() - written_requests_);
+  stats_.upstream_rq_pipeline_depth_.recordValue(pending_requests_.size());
+  written_requests_ = pending_requests_.size();
+  connection_->write(encoder_buffer_);
+}
+
 void ClientImpl::onConnectOrOpTimeout() {
   putOutlierEvent(Upstream::Outlier::Result::TIMEOUT);
   if (connected_) {
@@ -110,6 +144,8 @@ void ClientImpl::onEvent(Network::ConnectionEvent event) {
       }
     }
 
+    encoder_buffer_.drain(encoder_buffer_.length());
+    written_requests_ = 0;
     while (!pending_requests_.empty()) {
       PendingRequest& request = pending_requests_.front();
       if (!request.canceled_) {
@@ -121,6 +157,8 @@ void ClientImpl::onEvent(Network::ConnectionEvent event) {
     }
 
     connect_or_op_timer_->disableTimer();
+    flush_timer_->disableTimer();
+    flush_scheduled_ = false;
   } else if (event == Network::ConnectionEvent::Connected) {
     connected_ = true;
     ASSERT(!pending_requests_.empty());
@@ -142,6 +180,8 @@ void ClientImpl::onRespValue(RespValuePtr&& value) {
     host_->cluster().stats().upstream_rq_cancelled_.inc();
   }
   pending_requests_.pop_front();
+  ASSERT(written_requests_ > 0);
+  written_requests_--;
 
   // If there are no remaining ops in the pipeline we need to disable the timer.
   // Otherwise we boost the timer since we are receiving responses and there are more to flush out.
@@ -198,9 +238,76 @@ PoolRequest* InstanceImpl::makeRequest(const std::string& hash_key, const RespVa
   return tls_->getTyped<ThreadLocalPool>().makeRequest(hash_key, value, callbacks);
 }
 
+PoolRequest* InstanceImpl::makeReplicaRequest(const std::string& hash_key, const RespValue& value,
+                                              PoolCallbacks& callbacks) {
+  return tls_->getTyped<ThreadLocalPool>().makeReplicaRequest(hash_key, value, callbacks);
+}
+
+std::vector<std::vector<uint32_t>>
+InstanceImpl::groupKeys(const std::vector<const std::string*>& hash_keys) {
+  return tls_->getTyped<ThreadLocalPool>().groupKeys(hash_keys);
+}
+
+PoolRequest* InstanceImpl::makeRedirectedRequest(const RespValue& redirection,
+                                                 const RespValue& value,
+                                                 PoolCallbacks& callbacks) {
+  return tls_->getTyped<ThreadLocalPool>().makeRedirectedRequest(redirection, value, callbacks);
+}
+
+uint16_t InstanceImpl::clusterSlot(const std::string& key) {
+  // CRC16/XMODEM (polynomial 0x1021), as specified by redis cluster.
+  static const std::array<uint16_t, 256> table = []() {
+    std::array<uint16_t, 256> crc_table;
+    for (uint32_t i = 0; i < crc_table.size(); i++) {
+      uint16_t crc = i << 8;
+      for (uint32_t bit = 0; bit < 8; bit++) {
+        crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+      }
+      crc_table[i] = crc;
+    }
+    return crc_table;
+  }();
+
+  const char* data = key.data();
+  size_t length = key.size();
+  const size_t tag_start = key.find('{');
+  if (tag_start != std::string::npos) {
+    const size_t tag_end = key.find('}', tag_start + 1);
+    if (tag_end != std::string::npos && tag_end != tag_start + 1) {
+      data += tag_start + 1;
+      length = tag_end - tag_start - 1;
+    }
+  }
+
+  uint16_t crc = 0;
+  for (size_t i = 0; i < length; i++) {
+    crc = (crc << 8) ^ table[((crc >> 8) ^ static_cast<uint8_t>(data[i])) & 0xff];
+  }
+  return crc % CLUSTER_SLOTS;
+}
+
+void InstanceImpl::SlotsRefresh::onResponse(RespValuePtr&& value) {
+  handle_ = nullptr;
+  parent_.onClusterSlots(*value);
+}
+
+static void makeCommand(RespValue& command, const std::vector<std::string>& args) {
+  std::vector<RespValue> values(args.size());
+  for (uint64_t i = 0; i < args.size(); i++) {
+    values[i].type(RespType::BulkString);
+    values[i].asString() = args[i];
+  }
+  command.type(RespType::Array);
+  command.asArray().swap(values);
+}
+
 InstanceImpl::ThreadLocalPool::ThreadLocalPool(InstanceImpl& parent, Event::Dispatcher& dispatcher,
                                                const std::string& cluster_name)
-    : parent_(parent), dispatcher_(dispatcher), cluster_(parent_.cm_.get(cluster_name)) {
+    : parent_(parent), dispatcher_(dispatcher), cluster_(parent_.cm_.get(cluster_name)),
+      slots_refresh_(*this) {
+  makeCommand(asking_request_, {"ASKING"});
+  makeCommand(cluster_slots_request_, {"CLUSTER", "SLOTS"});
+  makeCommand(readonly_request_, {"READONLY"});
 
   // TODO(mattklein123): Redis is not currently safe for use with CDS. In order to make this work
   //                     we will need to add thread local cluster removal callbacks so that we can
@@ -215,6 +322,9 @@ InstanceImpl::ThreadLocalPool::ThreadLocalPool(InstanceImpl& parent, Event::Disp
 
 InstanceImpl::ThreadLocalPool::~ThreadLocalPool() {
   local_host_set_member_update_cb_handle_->remove();
+  if (slots_refresh_.handle_) {
+    slots_refresh_.handle_->cancel();
+  }
   while (!client_map_.empty()) {
     client_map_.begin()->second->redis_client_->close();
   }
@@ -229,18 +339,187 @@ void InstanceImpl::ThreadLocalPool::onHostsRemoved(
       // we just close the connection. This will fail any pending requests.
       it->second->redis_client_->close();
     }
+
+    for (Upstream::HostConstSharedPtr& slot_host : slots_) {
+      if (slot_host == host) {
+        slot_host = nullptr;
+      }
+    }
+  }
+
+  // Replicas are learned again on the next refresh of the slot map.
+  if (!hosts_removed.empty()) {
+    slot_replicas_.clear();
   }
 }
 
 PoolRequest* InstanceImpl::ThreadLocalPool::makeRequest(const std::string& hash_key,
                                                         const RespValue& request,
                                                         PoolCallbacks& callbacks) {
+  Upstream::HostConstSharedPtr host = chooseHost(hash_key);
+  if (!host) {
+    return nullptr;
+  }
+
+  return makeRequestToHost(host, request, callbacks);
+}
+
+PoolRequest* InstanceImpl::ThreadLocalPool::makeReplicaRequest(const std::string& hash_key,
+                                                               const RespValue& request,
+                                                               PoolCallbacks& callbacks) {
+  if (!slot_replicas_.empty()) {
+    const auto& replicas = slot_replicas_[clusterSlot(hash_key)];
+    if (replicas && !replicas->empty()) {
+      return makeRequestToHost((*replicas)[next_replica_++ % replicas->size()], request, callbacks,
+                               true);
+    }
+  }
+
+  return makeRequest(hash_key, request, callbacks);
+}
+
+Upstream::HostConstSharedPtr
+InstanceImpl::ThreadLocalPool::chooseHost(const std::string& hash_key) {
+  if (!slots_.empty()) {
+    Upstream::HostConstSharedPtr host = slots_[clusterSlot(hash_key)];
+    if (host) {
+      return host;
+    }
+  }
+
   LbContextImpl lb_context(hash_key);
-  Upstream::HostConstSharedPtr host = cluster_->loadBalancer().chooseHost(&lb_context);
+  return cluster_->loadBalancer().chooseHost(&lb_context);
+}
+
+std::vector<std::vector<uint32_t>>
+InstanceImpl::ThreadLocalPool::groupKeys(const std::vector<const std::string*>& hash_keys) {
+  std::vector<std::vector<uint32_t>> groups;
+  // Redis cluster nodes only accept multi key commands for keys of a single slot, so the keys
+  // are grouped by slot as well once the upstream is known to be a redis cluster.
+  std::map<std::pair<const Upstream::HostDescription*, uint16_t>, uint32_t> group_indexes;
+  for (uint32_t i = 0; i < hash_keys.size(); i++) {
+    Upstream::HostConstSharedPtr host = chooseHost(*hash_keys[i]);
+    if (!host) {
+      // The request for the key fails on its own.
+      groups.push_back({i});
+      continue;
+    }
+
+    const uint16_t slot = slots_.empty() ? 0 : clusterSlot(*hash_keys[i]);
+    auto it = group_indexes.emplace(std::make_pair(host.get(), slot), groups.size()).first;
+    if (it->second == groups.size()) {
+      groups.emplace_back();
+    }
+    groups[it->second].push_back(i);
+  }
+  return groups;
+}
+
+PoolRequest* InstanceImpl::ThreadLocalPool::makeRedirectedRequest(const RespValue& redirection,
+                                                                  const RespValue& request,
+                                                                  PoolCallbacks& callbacks) {
+  // Redirections look like: MOVED <slot> <ip>:<port> or ASK <slot> <ip>:<port>
+  const std::vector<std::string> parts = StringUtil::split(redirection.asString(), ' ');
+  if (parts.size() != 3 || (parts[0] != "MOVED" && parts[0] != "ASK")) {
+    return nullptr;
+  }
+  uint64_t slot;
+  if (!StringUtil::atoul(parts[1].c_str(), slot) || slot >= CLUSTER_SLOTS) {
+    return nullptr;
+  }
+  Upstream::HostConstSharedPtr host = findHost(parts[2]);
   if (!host) {
     return nullptr;
   }
 
+  if (parts[0] == "ASK") {
+    // The slot is being migrated and the key has already moved. The node only serves the key to
+    // a request that follows an ASKING command on the same connection, and the slot map is left
+    // alone until the migration is done.
+    makeRequestToHost(host, asking_request_, ignored_response_);
+    return makeRequestToHost(host, request, callbacks);
+  }
+
+  // Slots usually move together, on resharding or failover, so the whole slot map is refreshed
+  // from the node as well.
+  if (slots_.empty()) {
+    slots_.resize(CLUSTER_SLOTS);
+  }
+  slots_[slot] = host;
+  if (!slots_refresh_.handle_) {
+    slots_refresh_.handle_ = makeRequestToHost(host, cluster_slots_request_, slots_refresh_);
+  }
+  return makeRequestToHost(host, request, callbacks);
+}
+
+Upstream::HostConstSharedPtr
+InstanceImpl::ThreadLocalPool::findHost(const std::string& address) {
+  for (const Upstream::HostSetPtr& host_set : cluster_->prioritySet().hostSetsPerPriority()) {
+    for (const Upstream::HostSharedPtr& host : host_set->hosts()) {
+      if (host->address()->asString() == address) {
+        return host;
+      }
+    }
+  }
+  return nullptr;
+}
+
+void InstanceImpl::ThreadLocalPool::onClusterSlots(const RespValue& value) {
+  // CLUSTER SLOTS returns an array of slot ranges, each of which looks like:
+  // [<first slot>, <last slot>, [<master ip>, <master port>, ...], [<replica ip>, ...], ...]
+  if (value.type() != RespType::Array) {
+    return;
+  }
+
+  std::vector<Upstream::HostConstSharedPtr> slots(CLUSTER_SLOTS);
+  std::vector<std::shared_ptr<const std::vector<Upstream::HostConstSharedPtr>>> slot_replicas(
+      CLUSTER_SLOTS);
+  for (const RespValue& range : value.asArray()) {
+    if (range.type() != RespType::Array || range.asArray().size() < 3 ||
+        range.asArray()[0].type() != RespType::Integer ||
+        range.asArray()[1].type() != RespType::Integer) {
+      continue;
+    }
+
+    Upstream::HostConstSharedPtr host = findNode(range.asArray()[2]);
+    if (!host) {
+      continue;
+    }
+    auto replicas = std::make_shared<std::vector<Upstream::HostConstSharedPtr>>();
+    for (uint64_t i = 3; i < range.asArray().size(); i++) {
+      Upstream::HostConstSharedPtr replica = findNode(range.asArray()[i]);
+      if (replica) {
+        replicas->push_back(replica);
+      }
+    }
+
+    const int64_t first = std::max<int64_t>(range.asArray()[0].asInteger(), 0);
+    const int64_t last = std::min<int64_t>(range.asArray()[1].asInteger(), CLUSTER_SLOTS - 1);
+    for (int64_t slot = first; slot <= last; slot++) {
+      slots[slot] = host;
+      slot_replicas[slot] = replicas;
+    }
+  }
+
+  slots_.swap(slots);
+  slot_replicas_.swap(slot_replicas);
+}
+
+Upstream::HostConstSharedPtr InstanceImpl::ThreadLocalPool::findNode(const RespValue& node) {
+  // Nodes look like: [<ip>, <port>, <node id>...]
+  if (node.type() != RespType::Array || node.asArray().size() < 2 ||
+      node.asArray()[0].type() != RespType::BulkString ||
+      node.asArray()[1].type() != RespType::Integer) {
+    return nullptr;
+  }
+  return findHost(
+      fmt::format("{}:{}", node.asArray()[0].asString(), node.asArray()[1].asInteger()));
+}
+
+PoolRequest* InstanceImpl::ThreadLocalPool::makeRequestToHost(Upstream::HostConstSharedPtr host,
+                                                              const RespValue& request,
+                                                              PoolCallbacks& callbacks,
+                                                              bool replica) {
   ThreadLocalActiveClientPtr& client = client_map_[host];
   if (!client) {
     client.reset(new ThreadLocalActiveClient(*this));
@@ -249,6 +528,11 @@ PoolRequest* InstanceImpl::ThreadLocalPool::makeRequest(const std::string& hash_
     client->redis_client_->addConnectionCallbacks(*client);
   }
 
+  if (replica && !client->readonly_) {
+    client->redis_client_->makeRequest(readonly_request_, ignored_response_);
+    client->readonly_ = true;
+  }
+
   return client->redis_client_->makeRequest(request, callbacks);
 }
 
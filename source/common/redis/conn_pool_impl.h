@@ -9,6 +9,7 @@
 #include <vector>
 
 #include "envoy/redis/conn_pool.h"
+#include "envoy/stats/stats_macros.h"
 #include "envoy/thread_local/thread_local.h"
 #include "envoy/upstream/cluster_manager.h"
 
@@ -26,6 +27,22 @@ namespace ConnPool {
 // TODO(mattklein123): Circuit breaking
 // TODO(rshriram): Fault injection
 
+/**
+ * All redis client stats, kept in the scope of the upstream cluster. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_REDIS_CLIENT_STATS(HISTOGRAM)                                                          \
+  HISTOGRAM(upstream_rq_batch_size)                                                                \
+  HISTOGRAM(upstream_rq_pipeline_depth)
+// clang-format on
+
+/**
+ * Struct definition for all redis client stats. @see stats_macros.h
+ */
+struct RedisClientStats {
+  ALL_REDIS_CLIENT_STATS(GENERATE_HISTOGRAM_STRUCT)
+};
+
 class ConfigImpl : public Config {
 public:
   ConfigImpl(const envoy::api::v2::filter::network::RedisProxy::ConnPoolSettings& config);
@@ -79,6 +96,7 @@ private:
 
   ClientImpl(Upstream::HostConstSharedPtr host, Event::Dispatcher& dispatcher, EncoderPtr&& encoder,
              DecoderFactory& decoder_factory, const Config& config);
+  void flushBuffer();
   void onConnectOrOpTimeout();
   void onData(Buffer::Instance& data);
   void putOutlierEvent(Upstream::Outlier::Result result);
@@ -98,8 +116,16 @@ private:
   DecoderPtr decoder_;
   const Config& config_;
   std::list<PendingRequest> pending_requests_;
+  uint64_t written_requests_{}; // The number of pending requests written to the connection.
   Event::TimerPtr connect_or_op_timer_;
+  Event::TimerPtr flush_timer_;
+  bool flush_scheduled_{};
   bool connected_{};
+  RedisClientStats stats_;
+
+  // Size of the encoded requests at which they are written without waiting for the end of the
+  // dispatcher iteration.
+  static const uint64_t MAX_BUFFER_SIZE_BEFORE_FLUSH = 64 * 1024;
 };
 
 class ClientFactoryImpl : public ClientFactory {
@@ -123,10 +149,44 @@ public:
   // Redis::ConnPool::Instance
   PoolRequest* makeRequest(const std::string& hash_key, const RespValue& request,
                            PoolCallbacks& callbacks) override;
+  PoolRequest* makeReplicaRequest(const std::string& hash_key, const RespValue& request,
+                                  PoolCallbacks& callbacks) override;
+  std::vector<std::vector<uint32_t>>
+  groupKeys(const std::vector<const std::string*>& hash_keys) override;
+  PoolRequest* makeRedirectedRequest(const RespValue& redirection, const RespValue& request,
+                                     PoolCallbacks& callbacks) override;
+
+  /**
+   * @return uint16_t the redis cluster slot of a key, which is the CRC16 of the key modulo 16384.
+   *         If the key contains a non empty hash tag between a { and the first } after it, only
+   *         the hash tag is hashed.
+   */
+  static uint16_t clusterSlot(const std::string& key);
+
+  static const uint16_t CLUSTER_SLOTS = 16384;
 
 private:
   struct ThreadLocalPool;
 
+  // Refreshes the slot map of a pool from the CLUSTER SLOTS response of a cluster node.
+  struct SlotsRefresh : public PoolCallbacks {
+    SlotsRefresh(ThreadLocalPool& parent) : parent_(parent) {}
+
+    // Redis::ConnPool::PoolCallbacks
+    void onResponse(RespValuePtr&& value) override;
+    void onFailure() override { handle_ = nullptr; }
+
+    ThreadLocalPool& parent_;
+    PoolRequest* handle_{};
+  };
+
+  // Callbacks of the ASKING commands that precede requests redirected with ASK.
+  struct IgnoredResponse : public PoolCallbacks {
+    // Redis::ConnPool::PoolCallbacks
+    void onResponse(RespValuePtr&&) override {}
+    void onFailure() override {}
+  };
+
   struct ThreadLocalActiveClient : public Network::ConnectionCallbacks {
     ThreadLocalActiveClient(ThreadLocalPool& parent) : parent_(parent) {}
 
@@ -138,6 +198,8 @@ private:
     ThreadLocalPool& parent_;
     Upstream::HostConstSharedPtr host_;
     ClientPtr redis_client_;
+    // Whether READONLY has been sent, which redis cluster replicas require before serving reads.
+    bool readonly_{};
   };
 
   typedef std::unique_ptr<ThreadLocalActiveClient> ThreadLocalActiveClientPtr;
@@ -148,6 +210,17 @@ private:
     ~ThreadLocalPool();
     PoolRequest* makeRequest(const std::string& hash_key, const RespValue& request,
                              PoolCallbacks& callbacks);
+    PoolRequest* makeReplicaRequest(const std::string& hash_key, const RespValue& request,
+                                    PoolCallbacks& callbacks);
+    std::vector<std::vector<uint32_t>> groupKeys(const std::vector<const std::string*>& hash_keys);
+    PoolRequest* makeRedirectedRequest(const RespValue& redirection, const RespValue& request,
+                                       PoolCallbacks& callbacks);
+    Upstream::HostConstSharedPtr chooseHost(const std::string& hash_key);
+    PoolRequest* makeRequestToHost(Upstream::HostConstSharedPtr host, const RespValue& request,
+                                   PoolCallbacks& callbacks, bool replica = false);
+    Upstream::HostConstSharedPtr findHost(const std::string& address);
+    Upstream::HostConstSharedPtr findNode(const RespValue& node);
+    void onClusterSlots(const RespValue& value);
     void onHostsRemoved(const std::vector<Upstream::HostSharedPtr>& hosts_removed);
 
     InstanceImpl& parent_;
@@ -155,6 +228,19 @@ private:
     Upstream::ThreadLocalCluster* cluster_;
     std::unordered_map<Upstream::HostConstSharedPtr, ThreadLocalActiveClientPtr> client_map_;
     Common::CallbackHandle* local_host_set_member_update_cb_handle_;
+    // The host serving each redis cluster slot. Empty until a request is redirected with MOVED,
+    // which only redis cluster nodes do, and null for slots whose host is not known. Requests for
+    // keys of slots without a known host are routed by the load balancer.
+    std::vector<Upstream::HostConstSharedPtr> slots_;
+    // The replicas of each slot as listed by CLUSTER SLOTS, shared by the slots of a range. Empty
+    // until the slot map has been refreshed.
+    std::vector<std::shared_ptr<const std::vector<Upstream::HostConstSharedPtr>>> slot_replicas_;
+    uint64_t next_replica_{};
+    SlotsRefresh slots_refresh_;
+    IgnoredResponse ignored_response_;
+    RespValue asking_request_;
+    RespValue cluster_slots_request_;
+    RespValue readonly_request_;
   };
 
   struct LbContextImpl : public Upstream::LoadBalancerContext {
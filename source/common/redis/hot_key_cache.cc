@@ -0,0 +1,118 @@
+#include "common/redis/hot_key_cache.h"
+
+#include <chrono>
+#include <cstdint>
+#include <iterator>
+#include <string>
+
+#include "common/common/utility.h"
+
+namespace Envoy {
+namespace Redis {
+
+HotKeyCache::HotKeyCache(Runtime::Loader& runtime, ThreadLocal::SlotAllocator& tls,
+                         MonotonicTimeSource& time_source)
+    : runtime_(runtime), tls_(tls.allocateSlot()), time_source_(time_source) {
+  tls_->set([](Event::Dispatcher&) -> ThreadLocal::ThreadLocalObjectSharedPtr {
+    return std::make_shared<ThreadLocalCache>();
+  });
+}
+
+bool HotKeyCache::enabled(const std::string& key) {
+  const Runtime::Snapshot& snapshot = runtime_.snapshot();
+  if (snapshot.getInteger("redis.hot_key_cache.ttl_ms", 0) == 0) {
+    return false;
+  }
+
+  ThreadLocalCache& cache = tls_->getTyped<ThreadLocalCache>();
+  const std::string& prefixes = snapshot.get("redis.hot_key_cache.prefixes");
+  if (prefixes != cache.prefixes_value_) {
+    cache.prefixes_value_ = prefixes;
+    cache.prefixes_ = StringUtil::split(prefixes, ',');
+  }
+
+  for (const std::string& prefix : cache.prefixes_) {
+    if (key.compare(0, prefix.size(), prefix) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+RespValuePtr HotKeyCache::lookup(const RespValue& request, uint64_t& generation) {
+  ThreadLocalCache& cache = tls_->getTyped<ThreadLocalCache>();
+  const std::string& key = request.asArray()[1].asString();
+
+  auto it = cache.keys_.find(key);
+  if (it != cache.keys_.end()) {
+    auto response = it->second.responses_.find(requestArguments(request));
+    if (response != it->second.responses_.end()) {
+      if (response->second.expiry_ > time_source_.currentTime()) {
+        return RespValuePtr{new RespValue(response->second.response_)};
+      }
+      it->second.responses_.erase(response);
+    }
+  } else {
+    const uint64_t max_entries =
+        runtime_.snapshot().getInteger("redis.hot_key_cache.max_entries", 10000);
+    if (cache.keys_.size() >= max_entries) {
+      // Make room by dropping the keys that have no responses, which are mostly keys of reads that
+      // failed, and everything if that is not enough.
+      for (auto key_it = cache.keys_.begin(); key_it != cache.keys_.end();) {
+        key_it = key_it->second.responses_.empty() ? cache.keys_.erase(key_it) : std::next(key_it);
+      }
+      if (cache.keys_.size() >= max_entries) {
+        cache.keys_.clear();
+      }
+    }
+    it = cache.keys_.emplace(key, Key{++cache.next_generation_, {}}).first;
+  }
+
+  generation = it->second.generation_;
+  return nullptr;
+}
+
+void HotKeyCache::insert(const RespValue& request, const RespValue& response,
+                         uint64_t generation) {
+  ThreadLocalCache& cache = tls_->getTyped<ThreadLocalCache>();
+  auto it = cache.keys_.find(request.asArray()[1].asString());
+  if (it == cache.keys_.end() || it->second.generation_ != generation) {
+    return;
+  }
+
+  Entry& entry = it->second.responses_[requestArguments(request)];
+  entry.response_ = response;
+  entry.expiry_ = time_source_.currentTime() +
+                  std::chrono::milliseconds(
+                      runtime_.snapshot().getInteger("redis.hot_key_cache.ttl_ms", 0));
+}
+
+void HotKeyCache::invalidate(const RespValue& request) {
+  ThreadLocalCache& cache = tls_->getTyped<ThreadLocalCache>();
+  if (cache.keys_.empty()) {
+    return;
+  }
+
+  // Keys are created again with a new generation, which keeps responses to reads that were in
+  // flight during the write out of the cache.
+  for (uint64_t i = 1; i < request.asArray().size(); i++) {
+    cache.keys_.erase(request.asArray()[i].asString());
+  }
+}
+
+std::string HotKeyCache::requestArguments(const RespValue& request) {
+  // Each argument is prefixed by its length so that different arguments never look the same.
+  std::string arguments;
+  for (uint64_t i = 0; i < request.asArray().size(); i++) {
+    if (i != 1) {
+      const std::string& argument = request.asArray()[i].asString();
+      arguments.append(std::to_string(argument.size()));
+      arguments.push_back(':');
+      arguments.append(argument);
+    }
+  }
+  return arguments;
+}
+
+} // namespace Redis
+} // namespace Envoy
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "envoy/common/time.h"
+#include "envoy/redis/codec.h"
+#include "envoy/runtime/runtime.h"
+#include "envoy/thread_local/thread_local.h"
+
+namespace Envoy {
+namespace Redis {
+
+/**
+ * A per worker cache of the responses to read only commands, which absorbs the load of keys that
+ * are read far more often than they are written. The cache is configured via runtime:
+ *   redis.hot_key_cache.ttl_ms: how long responses are cached for. 0, the default, disables it.
+ *   redis.hot_key_cache.prefixes: comma separated prefixes of the keys whose responses are cached.
+ *   redis.hot_key_cache.max_entries: how many keys each worker caches responses for at most.
+ *
+ * The responses for a key are dropped when the worker that cached them sees a write to the key.
+ * Writes that other workers see, or that do not go through the proxy, are only picked up once the
+ * responses expire.
+ */
+class HotKeyCache {
+public:
+  HotKeyCache(Runtime::Loader& runtime, ThreadLocal::SlotAllocator& tls,
+              MonotonicTimeSource& time_source);
+
+  /**
+   * @return bool whether responses for a key are cached.
+   */
+  bool enabled(const std::string& key);
+
+  /**
+   * Look up the response to a read only request for a key that is enabled().
+   * @param request supplies the request, whose second argument is the key.
+   * @param generation is set to the value that insert() takes if there is no cached response.
+   * @return RespValuePtr a copy of the cached response, or nullptr if there is none.
+   */
+  RespValuePtr lookup(const RespValue& request, uint64_t& generation);
+
+  /**
+   * Cache the response to a read only request. The response is dropped if the key was written to
+   * since lookup().
+   * @param request supplies the request.
+   * @param response supplies the response, which is copied.
+   * @param generation supplies the value lookup() set.
+   */
+  void insert(const RespValue& request, const RespValue& response, uint64_t generation);
+
+  /**
+   * Drop the responses for any key that a request writes to. All arguments of the request are
+   * taken to be keys.
+   */
+  void invalidate(const RespValue& request);
+
+private:
+  struct Entry {
+    RespValue response_;
+    MonotonicTime expiry_;
+  };
+
+  struct Key {
+    // Changes whenever the key is written to, so that responses to reads that were in flight at
+    // the time are not cached.
+    uint64_t generation_;
+    // Responses by the arguments of the request that follow the key.
+    std::unordered_map<std::string, Entry> responses_;
+  };
+
+  struct ThreadLocalCache : public ThreadLocal::ThreadLocalObject {
+    std::unordered_map<std::string, Key> keys_;
+    uint64_t next_generation_{};
+    std::string prefixes_value_;
+    std::vector<std::string> prefixes_;
+  };
+
+  static std::string requestArguments(const RespValue& request);
+
+  Runtime::Loader& runtime_;
+  ThreadLocal::SlotPtr tls_;
+  MonotonicTimeSource& time_source_;
+};
+
+} // namespace Redis
+} // namespace Envoy
@@ -46,7 +46,7 @@ void ProxyFilter::initializeReadFilterCallbacks(Network::ReadFilterCallbacks& ca
                                                config_->stats_.downstream_cx_rx_bytes_buffered_,
                                                config_->stats_.downstream_cx_tx_bytes_total_,
                                                config_->stats_.downstream_cx_tx_bytes_buffered_,
-                                               nullptr});
+                                               nullptr, nullptr, nullptr, nullptr});
 }
 
 void ProxyFilter::onRespValue(RespValuePtr&& value) {
@@ -57,6 +57,9 @@ void ProxyFilter::onRespValue(RespValuePtr&& value) {
     // The splitter can immediately respond and destroy the pending request. Only store the handle
     // if the request is still alive.
     request.request_handle_ = std::move(split);
+    // The splitter may make the request again if the upstream redirects it, so it is kept until
+    // the response arrives.
+    request.request_ = std::move(value);
   }
 }
 
@@ -80,7 +83,7 @@ void ProxyFilter::onResponse(PendingRequest& request, RespValuePtr&& value) {
   // The response we got might not be in order, so flush out what we can. (A new response may
   // unlock several out of order responses).
   while (!pending_requests_.empty() && pending_requests_.front().pending_response_) {
-    encoder_->encode(*pending_requests_.front().pending_response_, encoder_buffer_);
+    encoder_->encode(std::move(pending_requests_.front().pending_response_), encoder_buffer_);
     pending_requests_.pop_front();
   }
 
@@ -98,6 +98,7 @@ private:
     void onResponse(RespValuePtr&& value) override { parent_.onResponse(*this, std::move(value)); }
 
     ProxyFilter& parent_;
+    RespValuePtr request_;
     RespValuePtr pending_response_;
     CommandSplitter::SplitRequestPtr request_handle_;
   };
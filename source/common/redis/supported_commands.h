@@ -28,6 +28,20 @@ struct SupportedCommands {
         "zrevrangebylex", "zrevrangebyscore", "zrevrank", "zscan", "zscore");
   }
 
+  /**
+   * @return commands of simpleCommands() which only read, and which can therefore be served by
+   *         replicas and from cached responses
+   */
+  static const std::vector<std::string>& readOnlyCommands() {
+    CONSTRUCT_ON_FIRST_USE(
+        std::vector<std::string>, "bitcount", "bitpos", "dump", "geodist", "geohash", "geopos",
+        "get", "getbit", "getrange", "hexists", "hget", "hgetall", "hkeys", "hlen", "hmget",
+        "hstrlen", "hvals", "lindex", "llen", "lrange", "scard", "sismember", "smembers",
+        "strlen", "type", "zcard", "zcount", "zlexcount", "zrange", "zrangebylex",
+        "zrangebyscore", "zrank", "zrevrange", "zrevrangebylex", "zrevrangebyscore", "zrevrank",
+        "zscore");
+  }
+
   /**
    * @return commands which hash on the fourth argument
    */
@@ -3,18 +3,36 @@
 #include <chrono>
 #include <cstdint>
 
+#include "envoy/common/time.h"
 #include "envoy/request_info/request_info.h"
 
+#include "common/common/utility.h"
+
 namespace Envoy {
 namespace RequestInfo {
 
 struct RequestInfoImpl : public RequestInfo {
   RequestInfoImpl()
-      : start_time_(std::chrono::system_clock::now()),
-        start_time_monotonic_(std::chrono::steady_clock::now()) {}
+      : RequestInfoImpl(ProdSystemTimeSource::instance_, ProdMonotonicTimeSource::instance_) {}
 
   RequestInfoImpl(Http::Protocol protocol) : RequestInfoImpl() { protocol_ = protocol; }
 
+  /**
+   * @param system_time_source supplies the source of the start time.
+   * @param monotonic_time_source supplies the source of the times that durations are measured
+   *        with, e.g. a dispatcher's approximate time source.
+   */
+  RequestInfoImpl(SystemTimeSource& system_time_source, MonotonicTimeSource& monotonic_time_source)
+      : monotonic_time_source_(monotonic_time_source),
+        start_time_(system_time_source.currentTime()),
+        start_time_monotonic_(monotonic_time_source.currentTime()) {}
+
+  RequestInfoImpl(Http::Protocol protocol, SystemTimeSource& system_time_source,
+                  MonotonicTimeSource& monotonic_time_source)
+      : RequestInfoImpl(system_time_source, monotonic_time_source) {
+    protocol_ = protocol;
+  }
+
   // RequestInfo::RequestInfo
   SystemTime startTime() const override { return start_time_; }
 
@@ -44,8 +62,8 @@ struct RequestInfoImpl : public RequestInfo {
   uint64_t bytesSent() const override { return bytes_sent_; }
 
   std::chrono::microseconds duration() const override {
-    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() -
-                                                                 start_time_monotonic_);
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        monotonic_time_source_.currentTime() - start_time_monotonic_);
   }
 
   void setResponseFlag(ResponseFlag response_flag) override { response_flags_ |= response_flag; }
@@ -69,6 +87,7 @@ struct RequestInfoImpl : public RequestInfo {
   const std::string& getDownstreamAddress() const override { return downstream_address_; };
 
   Optional<Http::Protocol> protocol_;
+  MonotonicTimeSource& monotonic_time_source_;
   const SystemTime start_time_;
   const MonotonicTime start_time_monotonic_;
   Optional<std::chrono::microseconds> request_received_duration_{};
@@ -5,7 +5,6 @@
 #include <cstdint>
 #include <map>
 #include <memory>
-#include <regex>
 #include <string>
 #include <vector>
 
@@ -17,6 +16,7 @@
 #include "common/common/assert.h"
 #include "common/common/empty_string.h"
 #include "common/common/hash.h"
+#include "common/common/regex.h"
 #include "common/common/utility.h"
 #include "common/config/metadata.h"
 #include "common/config/rds_json.h"
@@ -50,6 +50,11 @@ RetryPolicyImpl::RetryPolicyImpl(const envoy::api::v2::RouteAction& config) {
 CorsPolicyImpl::CorsPolicyImpl(const envoy::api::v2::CorsPolicy& config) {
   for (const auto& origin : config.allow_origin()) {
     allow_origin_.push_back(origin);
+    if (origin == "*") {
+      allow_any_origin_ = true;
+    } else {
+      allow_origin_set_.insert(origin);
+    }
   }
   allow_methods_ = config.allow_methods();
   allow_headers_ = config.allow_headers();
@@ -70,6 +75,31 @@ ShadowPolicyImpl::ShadowPolicyImpl(const envoy::api::v2::RouteAction& config) {
   runtime_key_ = config.request_mirror_policy().runtime_key();
 }
 
+HedgePolicyImpl::HedgePolicyImpl(const envoy::api::v2::Route& route) {
+  const auto filter_metadata =
+      route.metadata().filter_metadata().find(Envoy::Config::HttpFilterNames::get().ROUTER);
+  if (filter_metadata == route.metadata().filter_metadata().end()) {
+    return;
+  }
+
+  const auto& fields = filter_metadata->second.fields();
+  const auto percentile = fields.find("hedge_latency_percentile");
+  if (percentile == fields.end()) {
+    return;
+  }
+  latency_percentile_ = percentile->second.number_value();
+  if (latency_percentile_ < 0 || latency_percentile_ > 100) {
+    throw EnvoyException(
+        fmt::format("route: hedge_latency_percentile {} must be between 0 and 100",
+                    latency_percentile_));
+  }
+
+  const auto min_delay = fields.find("hedge_min_delay_ms");
+  if (min_delay != fields.end()) {
+    min_delay_ = std::chrono::milliseconds(static_cast<uint64_t>(min_delay->second.number_value()));
+  }
+}
+
 class HeaderHashMethod : public HashPolicyImpl::HashMethod {
 public:
   HeaderHashMethod(const std::string& header_name) : header_name_(header_name) {}
@@ -218,13 +248,16 @@ const std::string& DecoratorImpl::getOperation() const { return operation_; }
 const uint64_t RouteEntryImplBase::WeightedClusterEntry::MAX_CLUSTER_WEIGHT = 100UL;
 
 RouteEntryImplBase::RouteEntryImplBase(const VirtualHostImpl& vhost,
-                                       const envoy::api::v2::Route& route, Runtime::Loader& loader)
+                                       const envoy::api::v2::Route& route, Runtime::Loader& loader,
+                                       Upstream::ClusterManager& cm)
     : case_sensitive_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(route.match(), case_sensitive, true)),
       prefix_rewrite_(route.route().prefix_rewrite()), host_rewrite_(route.route().host_rewrite()),
       vhost_(vhost),
       auto_host_rewrite_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(route.route(), auto_host_rewrite, false)),
       use_websocket_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(route.route(), use_websocket, false)),
-      cluster_name_(route.route().cluster()), cluster_header_name_(route.route().cluster_header()),
+      cluster_name_(route.route().cluster()),
+      cluster_handle_(cluster_name_.empty() ? nullptr : cm.clusterHandle(cluster_name_)),
+      cluster_header_name_(route.route().cluster_header()),
       cluster_not_found_response_code_(ConfigUtility::parseClusterNotFoundResponseCode(
           route.route().cluster_not_found_response_code())),
       timeout_(PROTOBUF_GET_MS_OR_DEFAULT(route.route(), timeout, DEFAULT_ROUTE_TIMEOUT_MS)),
@@ -232,6 +265,7 @@ RouteEntryImplBase::RouteEntryImplBase(const VirtualHostImpl& vhost,
       host_redirect_(route.redirect().host_redirect()),
       path_redirect_(route.redirect().path_redirect()), retry_policy_(route.route()),
       rate_limit_policy_(route.route().rate_limits()), shadow_policy_(route.route()),
+      hedge_policy_(route),
       priority_(ConfigUtility::parsePriority(route.route().priority())),
       request_headers_parser_(HeaderParser::configure(route.route().request_headers_to_add())),
       response_headers_parser_(HeaderParser::configure(route.route().response_headers_to_add(),
@@ -276,7 +310,7 @@ RouteEntryImplBase::RouteEntryImplBase(const VirtualHostImpl& vhost,
       std::unique_ptr<WeightedClusterEntry> cluster_entry(
           new WeightedClusterEntry(this, runtime_key_prefix + "." + cluster_name, loader_,
                                    cluster_name, PROTOBUF_GET_WRAPPED_REQUIRED(cluster, weight),
-                                   std::move(cluster_metadata_match_criteria)));
+                                   std::move(cluster_metadata_match_criteria), cm));
       weighted_clusters_.emplace_back(std::move(cluster_entry));
       total_weight += weighted_clusters_.back()->clusterWeight();
     }
@@ -319,6 +353,11 @@ bool RouteEntryImplBase::matchRoute(const Http::HeaderMap& headers, uint64_t ran
   return matches;
 }
 
+bool RouteEntryImplBase::cacheable() const {
+  return !runtime_.valid() && config_headers_.empty() && weighted_clusters_.empty() &&
+         cluster_header_name_.get().empty();
+}
+
 const std::string& RouteEntryImplBase::clusterName() const { return cluster_name_; }
 
 void RouteEntryImplBase::finalizeRequestHeaders(
@@ -506,8 +545,8 @@ void RouteEntryImplBase::validateClusters(Upstream::ClusterManager& cm) const {
 
 PrefixRouteEntryImpl::PrefixRouteEntryImpl(const VirtualHostImpl& vhost,
                                            const envoy::api::v2::Route& route,
-                                           Runtime::Loader& loader)
-    : RouteEntryImplBase(vhost, route, loader), prefix_(route.match().prefix()) {}
+                                           Runtime::Loader& loader, Upstream::ClusterManager& cm)
+    : RouteEntryImplBase(vhost, route, loader, cm), prefix_(route.match().prefix()) {}
 
 void PrefixRouteEntryImpl::finalizeRequestHeaders(
     Http::HeaderMap& headers, const RequestInfo::RequestInfo& request_info) const {
@@ -526,8 +565,9 @@ RouteConstSharedPtr PrefixRouteEntryImpl::matches(const Http::HeaderMap& headers
 }
 
 PathRouteEntryImpl::PathRouteEntryImpl(const VirtualHostImpl& vhost,
-                                       const envoy::api::v2::Route& route, Runtime::Loader& loader)
-    : RouteEntryImplBase(vhost, route, loader), path_(route.match().path()) {}
+                                       const envoy::api::v2::Route& route, Runtime::Loader& loader,
+                                       Upstream::ClusterManager& cm)
+    : RouteEntryImplBase(vhost, route, loader, cm), path_(route.match().path()) {}
 
 void PathRouteEntryImpl::finalizeRequestHeaders(
     Http::HeaderMap& headers, const RequestInfo::RequestInfo& request_info) const {
@@ -566,9 +606,9 @@ RouteConstSharedPtr PathRouteEntryImpl::matches(const Http::HeaderMap& headers,
 
 RegexRouteEntryImpl::RegexRouteEntryImpl(const VirtualHostImpl& vhost,
                                          const envoy::api::v2::Route& route,
-                                         Runtime::Loader& loader)
-    : RouteEntryImplBase(vhost, route, loader),
-      regex_(std::regex{route.match().regex().c_str(), std::regex::optimize}) {}
+                                         Runtime::Loader& loader, Upstream::ClusterManager& cm)
+    : RouteEntryImplBase(vhost, route, loader, cm),
+      regex_(Regex::Utility::parseRegex(route.match().regex())) {}
 
 void RegexRouteEntryImpl::finalizeRequestHeaders(
     Http::HeaderMap& headers, const RequestInfo::RequestInfo& request_info) const {
@@ -576,7 +616,7 @@ void RegexRouteEntryImpl::finalizeRequestHeaders(
 
   const Http::HeaderString& path = headers.Path()->value();
   const char* query_string_start = Http::Utility::findQueryStringStart(path);
-  ASSERT(std::regex_match(path.c_str(), query_string_start, regex_));
+  ASSERT(regex_->match(path.c_str(), query_string_start - path.c_str()));
   std::string matched_path(path.c_str(), query_string_start);
   finalizePathHeader(headers, matched_path);
 }
@@ -586,7 +626,7 @@ RouteConstSharedPtr RegexRouteEntryImpl::matches(const Http::HeaderMap& headers,
   if (RouteEntryImplBase::matchRoute(headers, random_value)) {
     const Http::HeaderString& path = headers.Path()->value();
     const char* query_string_start = Http::Utility::findQueryStringStart(path);
-    if (std::regex_match(path.c_str(), query_string_start, regex_)) {
+    if (regex_->match(path.c_str(), query_string_start - path.c_str())) {
       return clusterEntry(headers, random_value);
     }
   }
@@ -622,28 +662,43 @@ VirtualHostImpl::VirtualHostImpl(const envoy::api::v2::VirtualHost& virtual_host
     const bool has_regex =
         route.match().path_specifier_case() == envoy::api::v2::RouteMatch::kRegex;
     if (has_prefix) {
-      routes_.emplace_back(new PrefixRouteEntryImpl(*this, route, runtime));
+      routes_.emplace_back(new PrefixRouteEntryImpl(*this, route, runtime, cm));
     } else if (has_path) {
-      routes_.emplace_back(new PathRouteEntryImpl(*this, route, runtime));
+      routes_.emplace_back(new PathRouteEntryImpl(*this, route, runtime, cm));
     } else {
       ASSERT(has_regex);
       UNREFERENCED_PARAMETER(has_regex);
-      routes_.emplace_back(new RegexRouteEntryImpl(*this, route, runtime));
+      routes_.emplace_back(new RegexRouteEntryImpl(*this, route, runtime, cm));
     }
+  }
 
-    if (validate_clusters) {
-      routes_.back()->validateClusters(cm);
-      if (!routes_.back()->shadowPolicy().cluster().empty()) {
-        if (!cm.get(routes_.back()->shadowPolicy().cluster())) {
-          throw EnvoyException(fmt::format("route: unknown shadow cluster '{}'",
-                                           routes_.back()->shadowPolicy().cluster()));
-        }
+  if (validate_clusters) {
+    validateClusters(cm);
+  }
+
+  if (routes_.size() >= MinRoutesForPathIndex) {
+    path_index_.reset(new PathMatchIndex());
+    for (int rank = 0; rank < virtual_host.routes_size(); rank++) {
+      const envoy::api::v2::RouteMatch& match = virtual_host.routes(rank).match();
+      if (!PROTOBUF_GET_WRAPPED_OR_DEFAULT(match, case_sensitive, true)) {
+        path_index_->addUnindexed(rank);
+      } else if (match.path_specifier_case() == envoy::api::v2::RouteMatch::kPrefix) {
+        path_index_->addPrefix(match.prefix(), rank);
+      } else if (match.path_specifier_case() == envoy::api::v2::RouteMatch::kPath) {
+        path_index_->addPath(match.path(), rank);
+      } else {
+        path_index_->addUnindexed(rank);
       }
     }
   }
 
+  std::vector<std::string> virtual_cluster_patterns;
   for (const auto& virtual_cluster : virtual_host.virtual_clusters()) {
     virtual_clusters_.push_back(VirtualClusterEntry(virtual_cluster));
+    virtual_cluster_patterns.push_back(virtual_cluster.pattern());
+  }
+  if (!virtual_clusters_.empty()) {
+    virtual_cluster_patterns_ = Regex::Utility::parseRegexSet(virtual_cluster_patterns);
   }
 
   if (virtual_host.has_cors()) {
@@ -651,43 +706,34 @@ VirtualHostImpl::VirtualHostImpl(const envoy::api::v2::VirtualHost& virtual_host
   }
 }
 
+void VirtualHostImpl::validateClusters(Upstream::ClusterManager& cm) const {
+  for (const RouteEntryImplBaseConstSharedPtr& route : routes_) {
+    route->validateClusters(cm);
+    if (!route->shadowPolicy().cluster().empty()) {
+      if (!cm.get(route->shadowPolicy().cluster())) {
+        throw EnvoyException(
+            fmt::format("route: unknown shadow cluster '{}'", route->shadowPolicy().cluster()));
+      }
+    }
+  }
+}
+
 VirtualHostImpl::VirtualClusterEntry::VirtualClusterEntry(
     const envoy::api::v2::VirtualCluster& virtual_cluster) {
   if (virtual_cluster.method() != envoy::api::v2::RequestMethod::METHOD_UNSPECIFIED) {
     method_ = envoy::api::v2::RequestMethod_Name(virtual_cluster.method());
   }
 
-  const std::string pattern = virtual_cluster.pattern();
-  pattern_ = std::regex{pattern, std::regex::optimize};
   name_ = virtual_cluster.name();
 }
 
-const VirtualHostImpl* RouteMatcher::findWildcardVirtualHost(const std::string& host) const {
-  // We do a longest wildcard suffix match against the host that's passed in.
-  // (e.g. foo-bar.baz.com should match *-bar.baz.com before matching *.baz.com)
-  // This is done by scanning the length => wildcards map looking for every
-  // wildcard whose size is < length.
-  for (const auto& iter : wildcard_virtual_host_suffixes_) {
-    const uint32_t wildcard_length = iter.first;
-    const auto& wildcard_map = iter.second;
-    // >= because *.foo.com shouldn't match .foo.com.
-    if (wildcard_length >= host.size()) {
-      continue;
-    }
-    const auto& match = wildcard_map.find(host.substr(host.size() - wildcard_length));
-    if (match != wildcard_map.end()) {
-      return match->second.get();
-    }
-  }
-  return nullptr;
-}
-
 RouteMatcher::RouteMatcher(const envoy::api::v2::RouteConfiguration& route_config,
                            const ConfigImpl& global_route_config, Runtime::Loader& runtime,
                            Upstream::ClusterManager& cm, bool validate_clusters) {
   for (const auto& virtual_host_config : route_config.virtual_hosts()) {
     VirtualHostSharedPtr virtual_host(new VirtualHostImpl(virtual_host_config, global_route_config,
                                                           runtime, cm, validate_clusters));
+    const uint32_t id = virtual_hosts_.size();
     for (const std::string& domain : virtual_host_config.domains()) {
       if ("*" == domain) {
         if (default_virtual_host_) {
@@ -695,19 +741,31 @@ RouteMatcher::RouteMatcher(const envoy::api::v2::RouteConfiguration& route_confi
         }
         default_virtual_host_ = virtual_host;
       } else if (domain.size() > 0 && '*' == domain[0]) {
-        wildcard_virtual_host_suffixes_[domain.size() - 1].emplace(domain.substr(1), virtual_host);
-      } else {
-        if (virtual_hosts_.find(domain) != virtual_hosts_.end()) {
-          throw EnvoyException(fmt::format(
-              "Only unique values for domains are permitted. Duplicate entry of domain {}",
-              domain));
-        }
-        virtual_hosts_.emplace(domain, virtual_host);
+        domain_index_.addWildcardSuffix(domain.substr(1), id);
+      } else if (!domain_index_.addExact(domain, id)) {
+        throw EnvoyException(fmt::format(
+            "Only unique values for domains are permitted. Duplicate entry of domain {}", domain));
       }
     }
+    virtual_hosts_.push_back(virtual_host);
+    cacheable_ &= virtual_host->cacheable();
   }
 }
 
+bool VirtualHostImpl::cacheable() const {
+  // SSL redirects depend on the x-forwarded-proto and x-envoy-internal headers.
+  if (ssl_requirements_ != SslRequirements::NONE) {
+    return false;
+  }
+
+  for (const RouteEntryImplBaseConstSharedPtr& route : routes_) {
+    if (!route->cacheable()) {
+      return false;
+    }
+  }
+  return true;
+}
+
 RouteConstSharedPtr VirtualHostImpl::getRouteFromEntries(const Http::HeaderMap& headers,
                                                          uint64_t random_value) const {
   // First check for ssl redirect.
@@ -718,6 +776,25 @@ RouteConstSharedPtr VirtualHostImpl::getRouteFromEntries(const Http::HeaderMap&
     return SSL_REDIRECT_ROUTE;
   }
 
+  if (path_index_) {
+    const Http::HeaderString& path = headers.Path()->value();
+    const char* query_string_start = Http::Utility::findQueryStringStart(path);
+    const size_t path_without_query_size =
+        query_string_start != nullptr ? query_string_start - path.c_str() : path.size();
+
+    // Scratch space reused across lookups on this thread to avoid an allocation per request.
+    static thread_local std::vector<uint32_t> candidates;
+    path_index_->findCandidates(path.c_str(), path.size(), path_without_query_size, candidates);
+    for (uint32_t rank : candidates) {
+      RouteConstSharedPtr route_entry = routes_[rank]->matches(headers, random_value);
+      if (nullptr != route_entry) {
+        return route_entry;
+      }
+    }
+
+    return nullptr;
+  }
+
   // Check for a route that matches the request.
   for (const RouteEntryImplBaseConstSharedPtr& route : routes_) {
     RouteConstSharedPtr route_entry = route->matches(headers, random_value);
@@ -731,22 +808,16 @@ RouteConstSharedPtr VirtualHostImpl::getRouteFromEntries(const Http::HeaderMap&
 
 const VirtualHostImpl* RouteMatcher::findVirtualHost(const Http::HeaderMap& headers) const {
   // Fast path the case where we only have a default virtual host.
-  if (virtual_hosts_.empty() && default_virtual_host_) {
+  if (domain_index_.empty()) {
     return default_virtual_host_.get();
   }
 
   // TODO (@rshriram) Match Origin header in WebSocket
   // request with VHost, using wildcard match
-  const char* host = headers.Host()->value().c_str();
-  const auto& iter = virtual_hosts_.find(host);
-  if (iter != virtual_hosts_.end()) {
-    return iter->second.get();
-  }
-  if (!wildcard_virtual_host_suffixes_.empty()) {
-    const VirtualHostImpl* vhost = findWildcardVirtualHost(host);
-    if (vhost != nullptr) {
-      return vhost;
-    }
+  const Http::HeaderString& host = headers.Host()->value();
+  const uint32_t id = domain_index_.find(host.c_str(), host.size());
+  if (id != DomainMatchIndex::NoMatch) {
+    return virtual_hosts_[id].get();
   }
   return default_virtual_host_.get();
 }
@@ -768,24 +839,35 @@ const std::shared_ptr<const SslRedirectRoute> VirtualHostImpl::SSL_REDIRECT_ROUT
 
 const VirtualCluster*
 VirtualHostImpl::virtualClusterFromEntries(const Http::HeaderMap& headers) const {
-  for (const VirtualClusterEntry& entry : virtual_clusters_) {
-    bool method_matches =
-        !entry.method_.valid() || headers.Method()->value().c_str() == entry.method_.value();
+  if (virtual_clusters_.empty()) {
+    return nullptr;
+  }
 
-    if (method_matches && std::regex_match(headers.Path()->value().c_str(), entry.pattern_)) {
+  // Match every pattern in one pass, then take the first matching entry whose method also
+  // matches.
+  static thread_local std::vector<uint32_t> matches;
+  matches.clear();
+  const Http::HeaderString& path = headers.Path()->value();
+  virtual_cluster_patterns_->match(path.c_str(), path.size(), matches);
+  for (uint32_t index : matches) {
+    const VirtualClusterEntry& entry = virtual_clusters_[index];
+    if (!entry.method_.valid() || headers.Method()->value().c_str() == entry.method_.value()) {
       return &entry;
     }
   }
 
-  if (virtual_clusters_.size() > 0) {
-    return &VIRTUAL_CLUSTER_CATCH_ALL;
-  }
+  return &VIRTUAL_CLUSTER_CATCH_ALL;
+}
 
-  return nullptr;
+void RouteMatcher::validateClusters(Upstream::ClusterManager& cm) const {
+  for (const VirtualHostSharedPtr& virtual_host : virtual_hosts_) {
+    virtual_host->validateClusters(cm);
+  }
 }
 
 ConfigImpl::ConfigImpl(const envoy::api::v2::RouteConfiguration& config, Runtime::Loader& runtime,
-                       Upstream::ClusterManager& cm, bool validate_clusters_default) {
+                       Upstream::ClusterManager& cm, bool validate_clusters_default)
+    : accounted_(Memory::Category::RouteConfigs, config.SpaceUsedLong()) {
   route_matcher_.reset(new RouteMatcher(
       config, *this, runtime, cm,
       PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, validate_clusters, validate_clusters_default)));
@@ -5,19 +5,23 @@
 #include <list>
 #include <map>
 #include <memory>
-#include <regex>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "envoy/common/optional.h"
+#include "envoy/common/regex.h"
 #include "envoy/router/router.h"
 #include "envoy/runtime/runtime.h"
 #include "envoy/upstream/cluster_manager.h"
 
+#include "common/memory/accounting.h"
 #include "common/router/config_utility.h"
+#include "common/router/domain_match_index.h"
 #include "common/router/header_formatter.h"
 #include "common/router/header_parser.h"
+#include "common/router/path_match_index.h"
 #include "common/router/router_ratelimit.h"
 
 #include "api/rds.pb.h"
@@ -76,6 +80,9 @@ public:
 
   // Router::CorsPolicy
   const std::list<std::string>& allowOrigins() const override { return allow_origin_; };
+  bool originAllowed(const std::string& origin) const override {
+    return allow_any_origin_ || allow_origin_set_.count(origin) > 0;
+  }
   const std::string& allowMethods() const override { return allow_methods_; };
   const std::string& allowHeaders() const override { return allow_headers_; };
   const std::string& exposeHeaders() const override { return expose_headers_; };
@@ -85,6 +92,9 @@ public:
 
 private:
   std::list<std::string> allow_origin_;
+  // The origins are indexed, so checking one does not take longer with the number of origins.
+  std::unordered_set<std::string> allow_origin_set_;
+  bool allow_any_origin_{};
   std::string allow_methods_;
   std::string allow_headers_;
   std::string expose_headers_;
@@ -110,6 +120,16 @@ public:
   const HeaderParser& requestHeaderParser() const { return *request_headers_parser_; };
   const HeaderParser& responseHeaderParser() const { return *response_headers_parser_; };
 
+  /**
+   * Throws an EnvoyException if a route refers to a cluster that the cluster manager does not have.
+   */
+  void validateClusters(Upstream::ClusterManager& cm) const;
+
+  /**
+   * @return whether routing within the virtual host only depends on the path of the request.
+   */
+  bool cacheable() const;
+
   // Router::VirtualHost
   const CorsPolicy* corsPolicy() const override { return cors_policy_.get(); }
   const std::string& name() const override { return name_; }
@@ -124,7 +144,6 @@ private:
     // Router::VirtualCluster
     const std::string& name() const override { return name_; }
 
-    std::regex pattern_;
     Optional<std::string> method_;
     std::string name_;
   };
@@ -139,9 +158,16 @@ private:
   static const CatchAllVirtualCluster VIRTUAL_CLUSTER_CATCH_ALL;
   static const std::shared_ptr<const SslRedirectRoute> SSL_REDIRECT_ROUTE;
 
+  // Virtual hosts with at least this many routes match paths through a PathMatchIndex rather than
+  // by testing every route in turn.
+  static const size_t MinRoutesForPathIndex = 16;
+
   const std::string name_;
   std::vector<RouteEntryImplBaseConstSharedPtr> routes_;
+  PathMatchIndexPtr path_index_;
   std::vector<VirtualClusterEntry> virtual_clusters_;
+  // Patterns of virtual_clusters_, in the same order, compiled into a single set.
+  Regex::CompiledMatcherSetPtr virtual_cluster_patterns_;
   SslRequirements ssl_requirements_;
   const RateLimitPolicyImpl rate_limit_policy_;
   std::unique_ptr<const CorsPolicyImpl> cors_policy_;
@@ -187,6 +213,24 @@ private:
   std::string runtime_key_;
 };
 
+/**
+ * Implementation of HedgePolicy that reads from the route's envoy.router filter metadata, since the
+ * route config has no hedge policy. The hedge_latency_percentile field enables hedging and the
+ * optional hedge_min_delay_ms field sets the least delay.
+ */
+class HedgePolicyImpl : public HedgePolicy {
+public:
+  HedgePolicyImpl(const envoy::api::v2::Route& route);
+
+  // Router::HedgePolicy
+  double latencyPercentile() const override { return latency_percentile_; }
+  std::chrono::milliseconds minDelay() const override { return min_delay_; }
+
+private:
+  double latency_percentile_{};
+  std::chrono::milliseconds min_delay_{0};
+};
+
 /**
  * Implementation of HashPolicy that reads from the proto route config and only currently supports
  * hashing on an HTTP header.
@@ -291,15 +335,22 @@ class RouteEntryImplBase : public RouteEntry,
                            public std::enable_shared_from_this<RouteEntryImplBase> {
 public:
   RouteEntryImplBase(const VirtualHostImpl& vhost, const envoy::api::v2::Route& route,
-                     Runtime::Loader& loader);
+                     Runtime::Loader& loader, Upstream::ClusterManager& cm);
 
   bool isRedirect() const { return !host_redirect_.empty() || !path_redirect_.empty(); }
 
   bool matchRoute(const Http::HeaderMap& headers, uint64_t random_value) const;
   void validateClusters(Upstream::ClusterManager& cm) const;
 
+  /**
+   * @return whether the route matches and resolves by host and path alone, i.e. it has no runtime
+   *         fraction, header matchers, weighted clusters or cluster header.
+   */
+  bool cacheable() const;
+
   // Router::RouteEntry
   const std::string& clusterName() const override;
+  const Upstream::ClusterHandle* clusterHandle() const override { return cluster_handle_.get(); }
   Http::Code clusterNotFoundResponseCode() const override {
     return cluster_not_found_response_code_;
   }
@@ -317,6 +368,7 @@ public:
   const RateLimitPolicy& rateLimitPolicy() const override { return rate_limit_policy_; }
   const RetryPolicy& retryPolicy() const override { return retry_policy_; }
   const ShadowPolicy& shadowPolicy() const override { return shadow_policy_; }
+  const HedgePolicy& hedgePolicy() const override { return hedge_policy_; }
   const VirtualCluster* virtualCluster(const Http::HeaderMap& headers) const override {
     return vhost_.virtualClusterFromEntries(headers);
   }
@@ -362,6 +414,7 @@ private:
 
     // Router::RouteEntry
     const std::string& clusterName() const override { return cluster_name_; }
+    const Upstream::ClusterHandle* clusterHandle() const override { return nullptr; }
     Http::Code clusterNotFoundResponseCode() const override {
       return parent_->clusterNotFoundResponseCode();
     }
@@ -381,6 +434,7 @@ private:
     const RateLimitPolicy& rateLimitPolicy() const override { return parent_->rateLimitPolicy(); }
     const RetryPolicy& retryPolicy() const override { return parent_->retryPolicy(); }
     const ShadowPolicy& shadowPolicy() const override { return parent_->shadowPolicy(); }
+    const HedgePolicy& hedgePolicy() const override { return parent_->hedgePolicy(); }
     std::chrono::milliseconds timeout() const override { return parent_->timeout(); }
     const MetadataMatchCriteria* metadataMatchCriteria() const override {
       return parent_->metadataMatchCriteria();
@@ -421,15 +475,19 @@ private:
   public:
     WeightedClusterEntry(const RouteEntryImplBase* parent, const std::string runtime_key,
                          Runtime::Loader& loader, const std::string& name, uint64_t weight,
-                         MetadataMatchCriteriaImplConstPtr cluster_metadata_match_criteria)
+                         MetadataMatchCriteriaImplConstPtr cluster_metadata_match_criteria,
+                         Upstream::ClusterManager& cm)
         : DynamicRouteEntry(parent, name), runtime_key_(runtime_key), loader_(loader),
           cluster_weight_(weight),
-          cluster_metadata_match_criteria_(std::move(cluster_metadata_match_criteria)) {}
+          cluster_metadata_match_criteria_(std::move(cluster_metadata_match_criteria)),
+          cluster_handle_(cm.clusterHandle(name)) {}
 
     uint64_t clusterWeight() const {
       return loader_.snapshot().getInteger(runtime_key_, cluster_weight_);
     }
 
+    const Upstream::ClusterHandle* clusterHandle() const override { return cluster_handle_.get(); }
+
     const MetadataMatchCriteria* metadataMatchCriteria() const override {
       if (cluster_metadata_match_criteria_) {
         return cluster_metadata_match_criteria_.get();
@@ -444,6 +502,7 @@ private:
     Runtime::Loader& loader_;
     const uint64_t cluster_weight_;
     MetadataMatchCriteriaImplConstPtr cluster_metadata_match_criteria_;
+    const Upstream::ClusterHandleConstSharedPtr cluster_handle_;
   };
 
   typedef std::shared_ptr<WeightedClusterEntry> WeightedClusterEntrySharedPtr;
@@ -464,6 +523,8 @@ private:
   const bool auto_host_rewrite_;
   const bool use_websocket_;
   const std::string cluster_name_;
+  // Set if the route has a single cluster_name_.
+  const Upstream::ClusterHandleConstSharedPtr cluster_handle_;
   const Http::LowerCaseString cluster_header_name_;
   const Http::Code cluster_not_found_response_code_;
   const std::chrono::milliseconds timeout_;
@@ -474,6 +535,7 @@ private:
   const RetryPolicyImpl retry_policy_;
   const RateLimitPolicyImpl rate_limit_policy_;
   const ShadowPolicyImpl shadow_policy_;
+  const HedgePolicyImpl hedge_policy_;
   const Upstream::ResourcePriority priority_;
   std::vector<ConfigUtility::HeaderData> config_headers_;
   std::vector<WeightedClusterEntrySharedPtr> weighted_clusters_;
@@ -495,7 +557,7 @@ private:
 class PrefixRouteEntryImpl : public RouteEntryImplBase {
 public:
   PrefixRouteEntryImpl(const VirtualHostImpl& vhost, const envoy::api::v2::Route& route,
-                       Runtime::Loader& loader);
+                       Runtime::Loader& loader, Upstream::ClusterManager& cm);
 
   // Router::RouteEntry
   void finalizeRequestHeaders(Http::HeaderMap& headers,
@@ -514,7 +576,7 @@ private:
 class PathRouteEntryImpl : public RouteEntryImplBase {
 public:
   PathRouteEntryImpl(const VirtualHostImpl& vhost, const envoy::api::v2::Route& route,
-                     Runtime::Loader& loader);
+                     Runtime::Loader& loader, Upstream::ClusterManager& cm);
 
   // Router::RouteEntry
   void finalizeRequestHeaders(Http::HeaderMap& headers,
@@ -533,7 +595,7 @@ private:
 class RegexRouteEntryImpl : public RouteEntryImplBase {
 public:
   RegexRouteEntryImpl(const VirtualHostImpl& vhost, const envoy::api::v2::Route& route,
-                      Runtime::Loader& loader);
+                      Runtime::Loader& loader, Upstream::ClusterManager& cm);
 
   // Router::RouteEntry
   void finalizeRequestHeaders(Http::HeaderMap& headers,
@@ -543,7 +605,7 @@ public:
   RouteConstSharedPtr matches(const Http::HeaderMap& headers, uint64_t random_value) const override;
 
 private:
-  const std::regex regex_;
+  const Regex::CompiledMatcherPtr regex_;
 };
 
 /**
@@ -557,24 +619,19 @@ public:
                Upstream::ClusterManager& cm, bool validate_clusters);
 
   RouteConstSharedPtr route(const Http::HeaderMap& headers, uint64_t random_value) const;
+  void validateClusters(Upstream::ClusterManager& cm) const;
+  bool cacheable() const { return cacheable_; }
 
 private:
   const VirtualHostImpl* findVirtualHost(const Http::HeaderMap& headers) const;
-  const VirtualHostImpl* findWildcardVirtualHost(const std::string& host) const;
-
-  std::unordered_map<std::string, VirtualHostSharedPtr> virtual_hosts_;
-  // std::greater as a minor optimization to iterate from more to less specific
-  //
-  // A note on using an unordered_map versus a vector of (string, VirtualHostSharedPtr) pairs:
-  //
-  // Based on local benchmarks, each vector entry costs around 20ns for recall and (string)
-  // comparison with a fixed cost of about 25ns. For unordered_map, the empty map costs about 65ns
-  // and climbs to about 110ns once there are any entries.
-  //
-  // The break-even is 4 entries.
-  std::map<int64_t, std::unordered_map<std::string, VirtualHostSharedPtr>, std::greater<int64_t>>
-      wildcard_virtual_host_suffixes_;
+
+  // Every virtual host other than the default, indexed by position in domain_index_.
+  std::vector<VirtualHostSharedPtr> virtual_hosts_;
+  // Exact and wildcard suffix domains of virtual_hosts_.
+  DomainMatchIndex domain_index_;
   VirtualHostSharedPtr default_virtual_host_;
+  // Whether every virtual host is cacheable.
+  bool cacheable_{true};
 };
 
 /**
@@ -588,16 +645,28 @@ public:
   const HeaderParser& requestHeaderParser() const { return *request_headers_parser_; };
   const HeaderParser& responseHeaderParser() const { return *response_headers_parser_; };
 
+  /**
+   * Throws an EnvoyException if a route refers to a cluster that the cluster manager does not have.
+   * A config that is shared between route config providers is validated for each of them.
+   */
+  void validateClusters(Upstream::ClusterManager& cm) const {
+    route_matcher_->validateClusters(cm);
+  }
+
   // Router::Config
   RouteConstSharedPtr route(const Http::HeaderMap& headers, uint64_t random_value) const override {
     return route_matcher_->route(headers, random_value);
   }
 
+  bool routeCacheable() const override { return route_matcher_->cacheable(); }
+
   const std::list<Http::LowerCaseString>& internalOnlyHeaders() const override {
     return internal_only_headers_;
   }
 
 private:
+  // The size of the route configuration proto, which approximates that of the route table.
+  const Memory::AccountedBytes accounted_;
   std::unique_ptr<RouteMatcher> route_matcher_;
   std::list<Http::LowerCaseString> internal_only_headers_;
   HeaderParserPtr request_headers_parser_;
@@ -611,6 +680,7 @@ class NullConfigImpl : public Config {
 public:
   // Router::Config
   RouteConstSharedPtr route(const Http::HeaderMap&, uint64_t) const override { return nullptr; }
+  bool routeCacheable() const override { return true; }
 
   const std::list<Http::LowerCaseString>& internalOnlyHeaders() const override {
     return internal_only_headers_;
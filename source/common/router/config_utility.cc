@@ -1,7 +1,7 @@
 #include "common/router/config_utility.h"
 
-#include <regex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "common/common/assert.h"
@@ -21,20 +21,40 @@ ConfigUtility::parsePriority(const envoy::api::v2::RoutingPriority& priority) {
   }
 }
 
+ConfigUtility::HeaderData::InlineHeaderGetter
+ConfigUtility::HeaderData::inlineHeaderGetter(const Http::LowerCaseString& name) {
+  typedef std::unordered_map<std::string, InlineHeaderGetter> GetterMap;
+  static const GetterMap* getters = [] {
+    GetterMap* map = new GetterMap();
+#define INLINE_HEADER_GETTER(name) (*map)[Http::Headers::get().name.get()] = &Http::HeaderMap::name;
+    ALL_INLINE_HEADERS(INLINE_HEADER_GETTER)
+#undef INLINE_HEADER_GETTER
+    return map;
+  }();
+
+  auto it = getters->find(name.get());
+  return it != getters->end() ? it->second : nullptr;
+}
+
 bool ConfigUtility::matchHeaders(const Http::HeaderMap& request_headers,
                                  const std::vector<HeaderData>& config_headers) {
   bool matches = true;
 
   if (!config_headers.empty()) {
     for (const HeaderData& cfg_header_data : config_headers) {
-      const Http::HeaderEntry* header = request_headers.get(cfg_header_data.name_);
+      const Http::HeaderEntry* header = cfg_header_data.inline_header_ != nullptr
+                                            ? (request_headers.*cfg_header_data.inline_header_)()
+                                            : request_headers.get(cfg_header_data.name_);
       if (cfg_header_data.value_.empty()) {
         matches &= (header != nullptr);
       } else if (!cfg_header_data.is_regex_) {
-        matches &= (header != nullptr) && (header->value() == cfg_header_data.value_.c_str());
+        // Compare sizes first, which rules out most mismatches without looking at the value.
+        matches &= (header != nullptr) && header->value().size() == cfg_header_data.value_.size() &&
+                   (header->value() == cfg_header_data.value_.c_str());
       } else {
         matches &= (header != nullptr) &&
-                   std::regex_match(header->value().c_str(), cfg_header_data.regex_pattern_);
+                   cfg_header_data.regex_pattern_->match(header->value().c_str(),
+                                                         header->value().size());
       }
       if (!matches) {
         break;
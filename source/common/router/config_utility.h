@@ -1,14 +1,16 @@
 #pragma once
 
-#include <regex>
 #include <string>
 #include <vector>
 
+#include "envoy/common/regex.h"
 #include "envoy/http/codes.h"
+#include "envoy/http/header_map.h"
 #include "envoy/json/json_object.h"
 #include "envoy/upstream/resource_manager.h"
 
 #include "common/common/empty_string.h"
+#include "common/common/regex.h"
 #include "common/config/rds_json.h"
 #include "common/http/headers.h"
 #include "common/protobuf/utility.h"
@@ -24,13 +26,16 @@ namespace Router {
 class ConfigUtility {
 public:
   struct HeaderData {
+    typedef const Http::HeaderEntry* (Http::HeaderMap::*InlineHeaderGetter)() const;
+
     // An empty header value allows for matching to be only based on header presence.
     // Regex is an opt-in. Unless explicitly mentioned, the header values will be used for
     // exact string matching.
     HeaderData(const envoy::api::v2::HeaderMatcher& config)
         : name_(config.name()), value_(config.value()),
-          regex_pattern_(value_, std::regex::optimize),
-          is_regex_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, regex, false)) {}
+          is_regex_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, regex, false)),
+          regex_pattern_(is_regex_ ? Regex::Utility::parseRegex(value_) : nullptr),
+          inline_header_(inlineHeaderGetter(name_)) {}
     HeaderData(const Json::Object& config)
         : HeaderData([&config] {
             envoy::api::v2::HeaderMatcher header_matcher;
@@ -40,8 +45,15 @@ public:
 
     const Http::LowerCaseString name_;
     const std::string value_;
-    const std::regex regex_pattern_;
     const bool is_regex_;
+    // Only compiled when is_regex_ is set.
+    const Regex::CompiledMatcherSharedPtr regex_pattern_;
+    // Set if name_ is one of the inline headers (e.g. :method or :authority), which are read
+    // directly rather than searched for by name.
+    const InlineHeaderGetter inline_header_;
+
+  private:
+    static InlineHeaderGetter inlineHeaderGetter(const Http::LowerCaseString& name);
   };
 
   /**
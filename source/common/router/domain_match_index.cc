@@ -0,0 +1,80 @@
+#include "common/router/domain_match_index.h"
+
+#include <algorithm>
+
+namespace Envoy {
+namespace Router {
+
+namespace {
+
+template <class Edges> typename Edges::const_iterator findEdge(const Edges& edges, char c) {
+  return std::lower_bound(edges.begin(), edges.end(), c,
+                          [](const typename Edges::value_type& edge, char c) -> bool {
+                            return edge.first < c;
+                          });
+}
+
+} // namespace
+
+const uint32_t DomainMatchIndex::NoMatch;
+
+DomainMatchIndex::DomainMatchIndex() {}
+
+DomainMatchIndex::TrieNode* DomainMatchIndex::TrieNode::child(char c) const {
+  auto it = findEdge(children_, c);
+  if (it != children_.end() && it->first == c) {
+    return it->second.get();
+  }
+  return nullptr;
+}
+
+DomainMatchIndex::TrieNode& DomainMatchIndex::findOrCreate(const std::string& key) {
+  empty_ = false;
+  TrieNode* node = &root_;
+  for (auto it = key.rbegin(); it != key.rend(); ++it) {
+    TrieNode* child = node->child(*it);
+    if (child == nullptr) {
+      std::unique_ptr<TrieNode> new_child(new TrieNode());
+      child = new_child.get();
+      node->children_.emplace(findEdge(node->children_, *it), *it, std::move(new_child));
+    }
+    node = child;
+  }
+  return *node;
+}
+
+bool DomainMatchIndex::addExact(const std::string& domain, uint32_t id) {
+  TrieNode& node = findOrCreate(domain);
+  if (node.exact_id_ != NoMatch) {
+    return false;
+  }
+  node.exact_id_ = id;
+  return true;
+}
+
+void DomainMatchIndex::addWildcardSuffix(const std::string& suffix, uint32_t id) {
+  TrieNode& node = findOrCreate(suffix);
+  if (node.wildcard_id_ == NoMatch) {
+    node.wildcard_id_ = id;
+  }
+}
+
+uint32_t DomainMatchIndex::find(const char* host, size_t size) const {
+  uint32_t longest_wildcard = NoMatch;
+  const TrieNode* node = &root_;
+  for (size_t depth = 0; depth < size; depth++) {
+    // A wildcard must match at least one character so *.foo.com does not match .foo.com.
+    if (node->wildcard_id_ != NoMatch) {
+      longest_wildcard = node->wildcard_id_;
+    }
+    node = node->child(host[size - depth - 1]);
+    if (node == nullptr) {
+      return longest_wildcard;
+    }
+  }
+
+  return node->exact_id_ != NoMatch ? node->exact_id_ : longest_wildcard;
+}
+
+} // namespace Router
+} // namespace Envoy
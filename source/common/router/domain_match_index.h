@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/common/non_copyable.h"
+
+namespace Envoy {
+namespace Router {
+
+/**
+ * Index over the exact and wildcard suffix domains of a route configuration's virtual hosts. Each
+ * virtual host is identified by an id supplied by the caller. Domains are stored in a character
+ * trie keyed by the reversed domain, so resolving a host to the exact or longest wildcard suffix
+ * match is a single walk from the end of the host, bounded by its length.
+ */
+class DomainMatchIndex : NonCopyable {
+public:
+  static const uint32_t NoMatch = std::numeric_limits<uint32_t>::max();
+
+  DomainMatchIndex();
+
+  /**
+   * Index a domain that must equal the host.
+   * @return bool false if the domain has already been added.
+   */
+  bool addExact(const std::string& domain, uint32_t id);
+
+  /**
+   * Index a wildcard domain (e.g. "*.foo.com" or "*-bar.foo.com") by its suffix, i.e. the domain
+   * without the leading '*'. The suffix matches any host that ends with it and is longer than
+   * it. If the same suffix is added more than once, the first id added wins.
+   */
+  void addWildcardSuffix(const std::string& suffix, uint32_t id);
+
+  /**
+   * @return bool whether no domain has been added.
+   */
+  bool empty() const { return empty_; }
+
+  /**
+   * Find the virtual host for a host. An exact match is preferred over any wildcard, and longer
+   * wildcard suffixes are preferred over shorter ones.
+   * @param host supplies the host.
+   * @param size supplies the length of host.
+   * @return uint32_t the matching id or NoMatch.
+   */
+  uint32_t find(const char* host, size_t size) const;
+
+private:
+  struct TrieNode {
+    TrieNode* child(char c) const;
+
+    // Children sorted by edge character.
+    std::vector<std::pair<char, std::unique_ptr<TrieNode>>> children_;
+    uint32_t exact_id_{NoMatch};
+    uint32_t wildcard_id_{NoMatch};
+  };
+
+  TrieNode& findOrCreate(const std::string& key);
+
+  TrieNode root_;
+  bool empty_{true};
+};
+
+} // namespace Router
+} // namespace Envoy
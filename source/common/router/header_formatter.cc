@@ -5,6 +5,7 @@
 #include "envoy/common/optional.h"
 
 #include "common/access_log/access_log_formatter.h"
+#include "common/common/assert.h"
 #include "common/common/logger.h"
 #include "common/common/utility.h"
 #include "common/config/metadata.h"
@@ -30,12 +31,11 @@ std::string formatUpstreamMetadataParseException(const std::string& params,
                      params, reason);
 }
 
-// Parses the parameters for UPSTREAM_METADATA and returns a function suitable for accessing the
-// specified metadata from an RequestInfo::RequestInfo. Expects a string formatted as:
+// Parses the parameters for UPSTREAM_METADATA and returns the metadata namespace followed by the
+// keys. Expects a string formatted as:
 //   (["a", "b", "c"])
 // There must be at least 2 array elements (a metadata namespace and at least 1 key).
-std::function<std::string(const Envoy::RequestInfo::RequestInfo&)>
-parseUpstreamMetadataField(const std::string& params_str) {
+std::vector<std::string> parseUpstreamMetadataField(const std::string& params_str) {
   if (params_str.empty() || params_str.front() != '(' || params_str.back() != ')') {
     throw EnvoyException(formatUpstreamMetadataParseException(params_str));
   }
@@ -57,82 +57,170 @@ parseUpstreamMetadataField(const std::string& params_str) {
     throw EnvoyException(formatUpstreamMetadataParseException(params_str));
   }
 
-  return [params](const Envoy::RequestInfo::RequestInfo& request_info) -> std::string {
-    Upstream::HostDescriptionConstSharedPtr host = request_info.upstreamHost();
-    if (!host) {
-      return std::string();
-    }
-
-    const ProtobufWkt::Value* value =
-        &Config::Metadata::metadataValue(host->metadata(), params[0], params[1]);
-    if (value->kind_case() == ProtobufWkt::Value::KIND_NOT_SET) {
-      // No kind indicates default ProtobufWkt::Value which means namespace or key not
-      // found.
-      return std::string();
-    }
-
-    size_t i = 2;
-    while (i < params.size()) {
-      if (!value->has_struct_value()) {
-        break;
-      }
+  return params;
+}
 
-      const auto field_it = value->struct_value().fields().find(params[i]);
-      if (field_it == value->struct_value().fields().end()) {
-        return std::string();
-      }
+// Returns the metadata value that params (as returned by parseUpstreamMetadataField) refer to, or
+// nullptr if there is none. The value belongs to host.
+const ProtobufWkt::Value* upstreamMetadataValue(const Upstream::HostDescription& host,
+                                                const std::vector<std::string>& params) {
+  const ProtobufWkt::Value* value =
+      &Config::Metadata::metadataValue(host.metadata(), params[0], params[1]);
+  if (value->kind_case() == ProtobufWkt::Value::KIND_NOT_SET) {
+    // No kind indicates default ProtobufWkt::Value which means namespace or key not
+    // found.
+    return nullptr;
+  }
 
-      value = &field_it->second;
-      i++;
+  size_t i = 2;
+  while (i < params.size()) {
+    if (!value->has_struct_value()) {
+      break;
     }
 
-    if (i < params.size()) {
-      // Didn't find all the keys.
-      return std::string();
+    const auto field_it = value->struct_value().fields().find(params[i]);
+    if (field_it == value->struct_value().fields().end()) {
+      return nullptr;
     }
 
-    switch (value->kind_case()) {
-    case ProtobufWkt::Value::kNumberValue:
-      return fmt::format("{}", value->number_value());
+    value = &field_it->second;
+    i++;
+  }
 
-    case ProtobufWkt::Value::kStringValue:
-      return value->string_value();
+  if (i < params.size()) {
+    // Didn't find all the keys.
+    return nullptr;
+  }
 
-    case ProtobufWkt::Value::kBoolValue:
-      return value->bool_value() ? "true" : "false";
+  switch (value->kind_case()) {
+  case ProtobufWkt::Value::kNumberValue:
+  case ProtobufWkt::Value::kStringValue:
+  case ProtobufWkt::Value::kBoolValue:
+    return value;
+
+  default:
+    // Unsupported type or null value.
+    ENVOY_LOG_MISC(debug, "unsupported value type for metadata [{}]",
+                   StringUtil::join(params, ", "));
+    return nullptr;
+  }
+}
 
-    default:
-      // Unsupported type or null value.
-      ENVOY_LOG_MISC(debug, "unsupported value type for metadata [{}]",
-                     StringUtil::join(params, ", "));
-      return std::string();
-    }
-  };
+const std::string& boolToString(bool value) {
+  static const std::string* true_string = new std::string("true");
+  static const std::string* false_string = new std::string("false");
+  return value ? *true_string : *false_string;
+}
+
+void addValue(Http::HeaderMap& headers, const Http::LowerCaseString& key, const std::string& value,
+              bool append) {
+  if (value.empty()) {
+    return;
+  }
+  if (append) {
+    headers.addReferenceKey(key, value);
+  } else {
+    headers.setReferenceKey(key, value);
+  }
+}
+
+void addReferenceValue(Http::HeaderMap& headers, const Http::LowerCaseString& key,
+                       const std::string& value, bool append) {
+  if (value.empty()) {
+    return;
+  }
+  if (append) {
+    headers.addReference(key, value);
+  } else {
+    headers.setReference(key, value);
+  }
 }
 
 } // namespace
 
-RequestInfoHeaderFormatter::RequestInfoHeaderFormatter(const std::string& field_name, bool append)
-    : append_(append) {
+RequestInfoHeaderFormatter::Field
+RequestInfoHeaderFormatter::parseField(const std::string& field_name) {
   if (field_name == "PROTOCOL") {
-    field_extractor_ = [](const Envoy::RequestInfo::RequestInfo& request_info) {
-      return Envoy::AccessLog::AccessLogFormatUtils::protocolToString(request_info.protocol());
-    };
+    return Field::Protocol;
   } else if (field_name == "CLIENT_IP") {
-    field_extractor_ = [](const Envoy::RequestInfo::RequestInfo& request_info) {
-      return request_info.getDownstreamAddress();
-    };
+    return Field::ClientIp;
   } else if (StringUtil::startsWith(field_name.c_str(), "UPSTREAM_METADATA")) {
-    field_extractor_ =
+    return Field::UpstreamMetadata;
+  }
+  throw EnvoyException(fmt::format("field '{}' not supported as custom header", field_name));
+}
+
+RequestInfoHeaderFormatter::RequestInfoHeaderFormatter(const std::string& field_name, bool append)
+    : field_(parseField(field_name)), append_(append) {
+  if (field_ == Field::UpstreamMetadata) {
+    upstream_metadata_path_ =
         parseUpstreamMetadataField(field_name.substr(sizeof("UPSTREAM_METADATA") - 1));
-  } else {
-    throw EnvoyException(fmt::format("field '{}' not supported as custom header", field_name));
   }
 }
 
 const std::string
 RequestInfoHeaderFormatter::format(const Envoy::RequestInfo::RequestInfo& request_info) const {
-  return field_extractor_(request_info);
+  switch (field_) {
+  case Field::Protocol:
+    return Envoy::AccessLog::AccessLogFormatUtils::protocolToString(request_info.protocol());
+  case Field::ClientIp:
+    return request_info.getDownstreamAddress();
+  case Field::UpstreamMetadata: {
+    Upstream::HostDescriptionConstSharedPtr host = request_info.upstreamHost();
+    const ProtobufWkt::Value* value =
+        host ? upstreamMetadataValue(*host, upstream_metadata_path_) : nullptr;
+    if (value == nullptr) {
+      return std::string();
+    }
+    switch (value->kind_case()) {
+    case ProtobufWkt::Value::kNumberValue:
+      return fmt::format("{}", value->number_value());
+    case ProtobufWkt::Value::kStringValue:
+      return value->string_value();
+    default:
+      return boolToString(value->bool_value());
+    }
+  }
+  }
+
+  NOT_REACHED;
+}
+
+void RequestInfoHeaderFormatter::evaluate(
+    Http::HeaderMap& headers, const Http::LowerCaseString& key,
+    const Envoy::RequestInfo::RequestInfo& request_info) const {
+  switch (field_) {
+  case Field::Protocol:
+    // The protocol names are static.
+    addReferenceValue(headers, key,
+                      Envoy::AccessLog::AccessLogFormatUtils::protocolToString(
+                          request_info.protocol()),
+                      append_);
+    return;
+  case Field::ClientIp:
+    addValue(headers, key, request_info.getDownstreamAddress(), append_);
+    return;
+  case Field::UpstreamMetadata: {
+    // Holds the host, which owns the value, until the value has been copied.
+    Upstream::HostDescriptionConstSharedPtr host = request_info.upstreamHost();
+    const ProtobufWkt::Value* value =
+        host ? upstreamMetadataValue(*host, upstream_metadata_path_) : nullptr;
+    if (value == nullptr) {
+      return;
+    }
+    switch (value->kind_case()) {
+    case ProtobufWkt::Value::kNumberValue:
+      addValue(headers, key, fmt::format("{}", value->number_value()), append_);
+      return;
+    case ProtobufWkt::Value::kStringValue:
+      addValue(headers, key, value->string_value(), append_);
+      return;
+    default:
+      addReferenceValue(headers, key, boolToString(value->bool_value()), append_);
+      return;
+    }
+  }
+  }
 }
 
 } // namespace Router
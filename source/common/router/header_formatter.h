@@ -1,10 +1,11 @@
 #pragma once
 
-#include <functional>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "envoy/access_log/access_log.h"
+#include "envoy/http/header_map.h"
 
 namespace Envoy {
 namespace Router {
@@ -18,6 +19,17 @@ public:
 
   virtual const std::string format(const Envoy::RequestInfo::RequestInfo& request_info) const PURE;
 
+  /**
+   * Add the formatted header to a header map, or replace it there if append() is false. Nothing is
+   * added if the value is empty. Unlike format(), this copies the value at most once, straight
+   * into the header map, and not at all when the value outlives the header map.
+   * @param headers supplies the header map.
+   * @param key supplies the header name, which must outlive the header map.
+   * @param request_info supplies the request info that dynamic values are read from.
+   */
+  virtual void evaluate(Http::HeaderMap& headers, const Http::LowerCaseString& key,
+                        const Envoy::RequestInfo::RequestInfo& request_info) const PURE;
+
   /**
    * @return bool indicating whether the formatted header should be appended to the existing
    *              headers
@@ -36,10 +48,20 @@ public:
 
   // HeaderFormatter::format
   const std::string format(const Envoy::RequestInfo::RequestInfo& request_info) const override;
+  void evaluate(Http::HeaderMap& headers, const Http::LowerCaseString& key,
+                const Envoy::RequestInfo::RequestInfo& request_info) const override;
   bool append() const override { return append_; }
 
 private:
-  std::function<std::string(const Envoy::RequestInfo::RequestInfo&)> field_extractor_;
+  // Selected once at configuration time, so that formatting is a switch rather than a call
+  // through a std::function.
+  enum class Field { Protocol, ClientIp, UpstreamMetadata };
+
+  static Field parseField(const std::string& field_name);
+
+  const Field field_;
+  // The metadata namespace followed by the keys, for UPSTREAM_METADATA.
+  std::vector<std::string> upstream_metadata_path_;
   const bool append_;
 };
 
@@ -55,6 +77,19 @@ public:
   const std::string format(const Envoy::RequestInfo::RequestInfo&) const override {
     return static_value_;
   };
+  // Header maps reference the value, which lives as long as the route configuration that the
+  // header names already belong to.
+  void evaluate(Http::HeaderMap& headers, const Http::LowerCaseString& key,
+                const Envoy::RequestInfo::RequestInfo&) const override {
+    if (static_value_.empty()) {
+      return;
+    }
+    if (append_) {
+      headers.addReference(key, static_value_);
+    } else {
+      headers.setReference(key, static_value_);
+    }
+  }
   bool append() const override { return append_; }
 
 private:
@@ -56,14 +56,7 @@ HeaderParserPtr HeaderParser::configure(
 void HeaderParser::evaluateHeaders(Http::HeaderMap& headers,
                                    const RequestInfo::RequestInfo& request_info) const {
   for (const auto& formatter : headers_to_add_) {
-    const std::string value = formatter.second->format(request_info);
-    if (!value.empty()) {
-      if (formatter.second->append()) {
-        headers.addReferenceKey(formatter.first, value);
-      } else {
-        headers.setReferenceKey(formatter.first, value);
-      }
-    }
+    formatter.second->evaluate(headers, formatter.first, request_info);
   }
 
   for (const auto& header : headers_to_remove_) {
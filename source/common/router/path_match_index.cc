@@ -0,0 +1,75 @@
+#include "common/router/path_match_index.h"
+
+#include <algorithm>
+
+namespace Envoy {
+namespace Router {
+
+namespace {
+
+template <class Edges> typename Edges::const_iterator findEdge(const Edges& edges, char c) {
+  return std::lower_bound(edges.begin(), edges.end(), c,
+                          [](const typename Edges::value_type& edge, char c) -> bool {
+                            return edge.first < c;
+                          });
+}
+
+} // namespace
+
+PathMatchIndex::PathMatchIndex() {}
+
+PathMatchIndex::TrieNode* PathMatchIndex::TrieNode::child(char c) const {
+  auto it = findEdge(children_, c);
+  if (it != children_.end() && it->first == c) {
+    return it->second.get();
+  }
+  return nullptr;
+}
+
+PathMatchIndex::TrieNode& PathMatchIndex::findOrCreate(const std::string& key) {
+  TrieNode* node = &root_;
+  for (char c : key) {
+    TrieNode* child = node->child(c);
+    if (child == nullptr) {
+      std::unique_ptr<TrieNode> new_child(new TrieNode());
+      child = new_child.get();
+      node->children_.emplace(findEdge(node->children_, c), c, std::move(new_child));
+    }
+    node = child;
+  }
+  return *node;
+}
+
+void PathMatchIndex::addPrefix(const std::string& prefix, uint32_t rank) {
+  findOrCreate(prefix).prefix_ranks_.push_back(rank);
+}
+
+void PathMatchIndex::addPath(const std::string& path, uint32_t rank) {
+  findOrCreate(path).path_ranks_.push_back(rank);
+}
+
+void PathMatchIndex::addUnindexed(uint32_t rank) { unindexed_.push_back(rank); }
+
+void PathMatchIndex::findCandidates(const char* path, size_t path_size,
+                                    size_t path_without_query_size,
+                                    std::vector<uint32_t>& candidates) const {
+  candidates.assign(unindexed_.begin(), unindexed_.end());
+
+  const TrieNode* node = &root_;
+  size_t depth = 0;
+  while (node != nullptr) {
+    candidates.insert(candidates.end(), node->prefix_ranks_.begin(), node->prefix_ranks_.end());
+    if (depth == path_without_query_size) {
+      candidates.insert(candidates.end(), node->path_ranks_.begin(), node->path_ranks_.end());
+    }
+    if (depth == path_size) {
+      break;
+    }
+    node = node->child(path[depth++]);
+  }
+
+  std::sort(candidates.begin(), candidates.end());
+}
+
+} // namespace Router
+} // namespace Envoy
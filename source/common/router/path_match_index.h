@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/common/non_copyable.h"
+
+namespace Envoy {
+namespace Router {
+
+/**
+ * Index over the path matching criteria of an ordered list of routes. Each route is identified by
+ * its rank (position) in the list. Given a request path, the index returns, in ascending rank
+ * order, the ranks of every route whose path criteria may match. A route's full match (runtime,
+ * headers, etc.) still has to be evaluated by the caller, so first-match semantics are preserved
+ * by evaluating candidates in the returned order.
+ *
+ * Case sensitive prefixes and exact paths share a character trie, so a lookup is a single walk
+ * bounded by the path length. Any route that cannot be indexed (regex, case insensitive) is
+ * returned as a candidate for every path.
+ */
+class PathMatchIndex : NonCopyable {
+public:
+  PathMatchIndex();
+
+  /**
+   * Index a route that matches any path starting with prefix.
+   */
+  void addPrefix(const std::string& prefix, uint32_t rank);
+
+  /**
+   * Index a route that matches a path (excluding the query string) equal to path.
+   */
+  void addPath(const std::string& path, uint32_t rank);
+
+  /**
+   * Add a route that must be considered for every path.
+   */
+  void addUnindexed(uint32_t rank);
+
+  /**
+   * Find the candidate routes for a path.
+   * @param path supplies the full request path, including any query string.
+   * @param path_size supplies the length of path.
+   * @param path_without_query_size supplies the length of path excluding the query string.
+   * @param candidates supplies the vector that is cleared and filled with candidate ranks in
+   *        ascending order.
+   */
+  void findCandidates(const char* path, size_t path_size, size_t path_without_query_size,
+                      std::vector<uint32_t>& candidates) const;
+
+private:
+  struct TrieNode {
+    TrieNode* child(char c) const;
+
+    // Children sorted by edge character.
+    std::vector<std::pair<char, std::unique_ptr<TrieNode>>> children_;
+    // Ranks of prefixes ending at this node.
+    std::vector<uint32_t> prefix_ranks_;
+    // Ranks of exact paths ending at this node.
+    std::vector<uint32_t> path_ranks_;
+  };
+
+  TrieNode& findOrCreate(const std::string& key);
+
+  TrieNode root_;
+  std::vector<uint32_t> unindexed_;
+};
+
+typedef std::unique_ptr<PathMatchIndex> PathMatchIndexPtr;
+
+} // namespace Router
+} // namespace Envoy
@@ -25,8 +25,8 @@ RouteConfigProviderSharedPtr RouteConfigProviderUtil::create(
     Init::Manager& init_manager, RouteConfigProviderManager& route_config_provider_manager) {
   switch (config.route_specifier_case()) {
   case envoy::api::v2::filter::network::HttpConnectionManager::kRouteConfig:
-    return RouteConfigProviderSharedPtr{
-        new StaticRouteConfigProviderImpl(config.route_config(), runtime, cm)};
+    return route_config_provider_manager.getStaticRouteConfigProvider(config.route_config(),
+                                                                      runtime, cm);
   case envoy::api::v2::filter::network::HttpConnectionManager::kRds:
     return route_config_provider_manager.getRouteConfigProvider(config.rds(), cm, scope,
                                                                 stat_prefix, init_manager);
@@ -35,11 +35,6 @@ RouteConfigProviderSharedPtr RouteConfigProviderUtil::create(
   }
 }
 
-StaticRouteConfigProviderImpl::StaticRouteConfigProviderImpl(
-    const envoy::api::v2::RouteConfiguration& config, Runtime::Loader& runtime,
-    Upstream::ClusterManager& cm)
-    : config_(new ConfigImpl(config, runtime, cm, true)) {}
-
 // TODO(htuch): If support for multiple clusters is added per #1170 cluster_name_
 // initialization needs to be fixed.
 RdsRouteConfigProviderImpl::RdsRouteConfigProviderImpl(
@@ -114,19 +109,85 @@ void RdsRouteConfigProviderImpl::onConfigUpdate(const ResourceVector& resources)
   }
   const uint64_t new_hash = MessageUtil::hash(route_config);
   if (new_hash != last_config_hash_ || !initialized_) {
-    ConfigConstSharedPtr new_config(new ConfigImpl(route_config, runtime_, cm_, false));
-    initialized_ = true;
-    last_config_hash_ = new_hash;
-    stats_.config_reload_.inc();
     ENVOY_LOG(debug, "rds: loading new configuration: config_name={} hash={}", route_config_name_,
               new_hash);
-    tls_->runOnAllThreads(
-        [this, new_config]() -> void { tls_->getTyped<ThreadLocalConfig>().config_ = new_config; });
-    route_config_proto_ = route_config;
+    // Validating the clusters of the routes needs the thread local cluster manager, so only
+    // configs that do not validate them can be built on the config thread.
+    if (route_config_provider_manager_.config_thread_ &&
+        !PROTOBUF_GET_WRAPPED_OR_DEFAULT(route_config, validate_clusters, false) &&
+        !route_config_provider_manager_.findSharedConfig(route_config, new_hash)) {
+      initialized_ = true;
+      last_config_hash_ = new_hash;
+      buildConfigOnConfigThread(route_config, new_hash);
+      // The initialize callback runs once the config is built.
+      return;
+    }
+
+    ConfigConstSharedPtr new_config(
+        route_config_provider_manager_.sharedConfig(route_config, new_hash, runtime_, cm_, false));
+    initialized_ = true;
+    last_config_hash_ = new_hash;
+    last_build_++;
+    applyConfig(route_config, new_config);
+  }
+  runInitializeCallbackIfAny();
+}
+
+void RdsRouteConfigProviderImpl::buildConfigOnConfigThread(
+    const envoy::api::v2::RouteConfiguration& route_config, uint64_t hash) {
+  // Building the route table of a large config would stall the main thread, so only the result is
+  // posted back to it. The work only holds a weak reference to the provider, which may be
+  // destroyed meanwhile.
+  const uint64_t build = ++last_build_;
+  std::weak_ptr<RdsRouteConfigProviderImpl> weak_this = shared_from_this();
+  auto config_proto = std::make_shared<const envoy::api::v2::RouteConfiguration>(route_config);
+  Runtime::Loader& runtime = runtime_;
+  Upstream::ClusterManager& cm = cm_;
+  Event::Dispatcher& dispatcher = route_config_provider_manager_.dispatcher_;
+  route_config_provider_manager_.config_thread_->post(
+      [weak_this, build, hash, config_proto, &runtime, &cm, &dispatcher]() -> void {
+        std::shared_ptr<const ConfigImpl> new_config;
+        std::string error;
+        try {
+          new_config = std::make_shared<const ConfigImpl>(*config_proto, runtime, cm, false);
+        } catch (const EnvoyException& e) {
+          error = e.what();
+        }
+        dispatcher.post([weak_this, build, hash, config_proto, new_config, error]() -> void {
+          std::shared_ptr<RdsRouteConfigProviderImpl> provider = weak_this.lock();
+          if (provider) {
+            provider->onConfigBuilt(build, hash, *config_proto, new_config, error);
+          }
+        });
+      });
+}
+
+void RdsRouteConfigProviderImpl::onConfigBuilt(
+    uint64_t build, uint64_t hash, const envoy::api::v2::RouteConfiguration& route_config,
+    std::shared_ptr<const ConfigImpl> new_config, const std::string& error) {
+  if (build == last_build_) {
+    if (new_config) {
+      applyConfig(route_config,
+                  route_config_provider_manager_.addSharedConfig(route_config, hash, new_config));
+    } else {
+      // The update was already accepted, so it can only be reported. The next update is built
+      // even if it is the same.
+      ENVOY_LOG(warn, "rds: unable to build configuration {}: {}", route_config_name_, error);
+      stats_.config_build_failed_.inc();
+      initialized_ = false;
+    }
   }
   runInitializeCallbackIfAny();
 }
 
+void RdsRouteConfigProviderImpl::applyConfig(const envoy::api::v2::RouteConfiguration& route_config,
+                                             ConfigConstSharedPtr new_config) {
+  stats_.config_reload_.inc();
+  tls_->runOnAllThreads(
+      [this, new_config]() -> void { tls_->getTyped<ThreadLocalConfig>().config_ = new_config; });
+  route_config_proto_ = route_config;
+}
+
 void RdsRouteConfigProviderImpl::onConfigUpdateFailed(const EnvoyException*) {
   // We need to allow server startup to continue, even if we have a bad
   // config.
@@ -146,9 +207,11 @@ void RdsRouteConfigProviderImpl::registerInitTarget(Init::Manager& init_manager)
 
 RouteConfigProviderManagerImpl::RouteConfigProviderManagerImpl(
     Runtime::Loader& runtime, Event::Dispatcher& dispatcher, Runtime::RandomGenerator& random,
-    const LocalInfo::LocalInfo& local_info, ThreadLocal::SlotAllocator& tls, Server::Admin& admin)
+    const LocalInfo::LocalInfo& local_info, ThreadLocal::SlotAllocator& tls, Server::Admin& admin,
+    bool use_config_thread)
     : runtime_(runtime), dispatcher_(dispatcher), random_(random), local_info_(local_info),
-      tls_(tls), admin_(admin) {
+      tls_(tls), admin_(admin),
+      config_thread_(use_config_thread ? new Thread::WorkQueueThread() : nullptr) {
   admin_.addHandler("/routes", "print out currently loaded dynamic HTTP route tables",
                     MAKE_ADMIN_HANDLER(RouteConfigProviderManagerImpl::handlerRoutes), true);
 }
@@ -205,6 +268,66 @@ Router::RouteConfigProviderSharedPtr RouteConfigProviderManagerImpl::getRouteCon
   return new_provider;
 };
 
+RouteConfigProviderSharedPtr RouteConfigProviderManagerImpl::getStaticRouteConfigProvider(
+    const envoy::api::v2::RouteConfiguration& route_config, Runtime::Loader& runtime,
+    Upstream::ClusterManager& cm) {
+  return std::make_shared<StaticRouteConfigProviderImpl>(
+      sharedConfig(route_config, MessageUtil::hash(route_config), runtime, cm, true));
+}
+
+std::shared_ptr<const ConfigImpl> RouteConfigProviderManagerImpl::findSharedConfig(
+    const envoy::api::v2::RouteConfiguration& route_config, uint64_t hash) {
+  auto range = shared_configs_.equal_range(hash);
+  for (auto it = range.first; it != range.second; ++it) {
+    std::shared_ptr<const ConfigImpl> config = it->second.config_.lock();
+    if (config && Protobuf::util::MessageDifferencer::Equals(it->second.route_config_,
+                                                             route_config)) {
+      return config;
+    }
+  }
+  return nullptr;
+}
+
+std::shared_ptr<const ConfigImpl> RouteConfigProviderManagerImpl::addSharedConfig(
+    const envoy::api::v2::RouteConfiguration& route_config, uint64_t hash,
+    std::shared_ptr<const ConfigImpl> config) {
+  std::shared_ptr<const ConfigImpl> existing = findSharedConfig(route_config, hash);
+  if (existing) {
+    return existing;
+  }
+
+  if (shared_configs_.size() >= 2 * shared_configs_after_prune_) {
+    for (auto it = shared_configs_.begin(); it != shared_configs_.end();) {
+      if (it->second.config_.expired()) {
+        it = shared_configs_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    shared_configs_after_prune_ = shared_configs_.size() + 1;
+  }
+  shared_configs_.emplace(hash, SharedConfig{route_config, config});
+  return config;
+}
+
+std::shared_ptr<const ConfigImpl> RouteConfigProviderManagerImpl::sharedConfig(
+    const envoy::api::v2::RouteConfiguration& route_config, uint64_t hash,
+    Runtime::Loader& runtime, Upstream::ClusterManager& cm, bool validate_clusters_default) {
+  std::shared_ptr<const ConfigImpl> config = findSharedConfig(route_config, hash);
+  if (config) {
+    // The route table may have been built by a provider that did not validate its clusters.
+    if (PROTOBUF_GET_WRAPPED_OR_DEFAULT(route_config, validate_clusters,
+                                        validate_clusters_default)) {
+      config->validateClusters(cm);
+    }
+    return config;
+  }
+
+  return addSharedConfig(route_config, hash,
+                         std::make_shared<const ConfigImpl>(route_config, runtime, cm,
+                                                            validate_clusters_default));
+}
+
 Http::Code RouteConfigProviderManagerImpl::handlerRoutes(const std::string& url,
                                                          Buffer::Instance& response) {
   Http::Utility::QueryParams query_params = Http::Utility::parseQueryString(url);
@@ -2,8 +2,10 @@
 
 #include <cstdint>
 #include <functional>
+#include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "envoy/config/subscription.h"
 #include "envoy/http/codes.h"
@@ -16,6 +18,7 @@
 #include "envoy/thread_local/thread_local.h"
 
 #include "common/common/logger.h"
+#include "common/common/thread.h"
 #include "common/protobuf/utility.h"
 
 #include "api/filter/network/http_connection_manager.pb.h"
@@ -24,6 +27,8 @@
 namespace Envoy {
 namespace Router {
 
+class ConfigImpl;
+
 /**
  * Route configuration provider utilities.
  */
@@ -45,8 +50,7 @@ public:
  */
 class StaticRouteConfigProviderImpl : public RouteConfigProvider {
 public:
-  StaticRouteConfigProviderImpl(const envoy::api::v2::RouteConfiguration& config,
-                                Runtime::Loader& runtime, Upstream::ClusterManager& cm);
+  StaticRouteConfigProviderImpl(ConfigConstSharedPtr config) : config_(config) {}
 
   // Router::RouteConfigProvider
   Router::ConfigConstSharedPtr config() override { return config_; }
@@ -61,6 +65,7 @@ private:
  */
 // clang-format off
 #define ALL_RDS_STATS(COUNTER)                                                                     \
+  COUNTER(config_build_failed)                                                                     \
   COUNTER(config_reload)                                                                           \
   COUNTER(update_empty)
 
@@ -82,6 +87,7 @@ class RouteConfigProviderManagerImpl;
 class RdsRouteConfigProviderImpl
     : public RdsRouteConfigProvider,
       public Init::Target,
+      public std::enable_shared_from_this<RdsRouteConfigProviderImpl>,
       Envoy::Config::SubscriptionCallbacks<envoy::api::v2::RouteConfiguration>,
       Logger::Loggable<Logger::Id::router> {
 public:
@@ -125,6 +131,13 @@ private:
 
   void registerInitTarget(Init::Manager& init_manager);
   void runInitializeCallbackIfAny();
+  void buildConfigOnConfigThread(const envoy::api::v2::RouteConfiguration& route_config,
+                                 uint64_t hash);
+  void onConfigBuilt(uint64_t build, uint64_t hash,
+                     const envoy::api::v2::RouteConfiguration& route_config,
+                     std::shared_ptr<const ConfigImpl> new_config, const std::string& error);
+  void applyConfig(const envoy::api::v2::RouteConfiguration& route_config,
+                   ConfigConstSharedPtr new_config);
 
   Runtime::Loader& runtime_;
   Upstream::ClusterManager& cm_;
@@ -134,6 +147,9 @@ private:
   const std::string route_config_name_;
   bool initialized_{};
   uint64_t last_config_hash_{};
+  // Counts the configs that were built, so that a config built on the config thread is dropped if
+  // a newer one was built meanwhile.
+  uint64_t last_build_{};
   Stats::ScopePtr scope_;
   RdsStats stats_;
   std::function<void()> initialize_callback_;
@@ -150,7 +166,8 @@ public:
   RouteConfigProviderManagerImpl(Runtime::Loader& runtime, Event::Dispatcher& dispatcher,
                                  Runtime::RandomGenerator& random,
                                  const LocalInfo::LocalInfo& local_info,
-                                 ThreadLocal::SlotAllocator& tls, Server::Admin& admin);
+                                 ThreadLocal::SlotAllocator& tls, Server::Admin& admin,
+                                 bool use_config_thread = false);
   ~RouteConfigProviderManagerImpl();
 
   // ServerRouteConfigProviderManager
@@ -160,8 +177,41 @@ public:
   getRouteConfigProvider(const envoy::api::v2::filter::network::Rds& rds,
                          Upstream::ClusterManager& cm, Stats::Scope& scope,
                          const std::string& stat_prefix, Init::Manager& init_manager) override;
+  RouteConfigProviderSharedPtr
+  getStaticRouteConfigProvider(const envoy::api::v2::RouteConfiguration& route_config,
+                               Runtime::Loader& runtime, Upstream::ClusterManager& cm) override;
 
 private:
+  struct SharedConfig {
+    envoy::api::v2::RouteConfiguration route_config_;
+    std::weak_ptr<const ConfigImpl> config_;
+  };
+
+  /**
+   * @return the route table of a provider whose route config equals route_config, or nullptr if
+   *         there is none.
+   * @param hash supplies MessageUtil::hash(route_config).
+   */
+  std::shared_ptr<const ConfigImpl>
+  findSharedConfig(const envoy::api::v2::RouteConfiguration& route_config, uint64_t hash);
+
+  /**
+   * Make a route table available to providers with an equal route config.
+   * @return the route table to use, which is one that was added meanwhile if there is one.
+   */
+  std::shared_ptr<const ConfigImpl>
+  addSharedConfig(const envoy::api::v2::RouteConfiguration& route_config, uint64_t hash,
+                  std::shared_ptr<const ConfigImpl> config);
+
+  /**
+   * @return the shared route table for route_config, which is built if there is none. Its
+   *         clusters are validated against cm if the route config asks for it.
+   */
+  std::shared_ptr<const ConfigImpl>
+  sharedConfig(const envoy::api::v2::RouteConfiguration& route_config, uint64_t hash,
+               Runtime::Loader& runtime, Upstream::ClusterManager& cm,
+               bool validate_clusters_default);
+
   /**
    * The handler used in the Admin /routes endpoint. This handler is used to
    * populate the response Buffer::Instance with information about the currently
@@ -190,6 +240,14 @@ private:
   const LocalInfo::LocalInfo& local_info_;
   ThreadLocal::SlotAllocator& tls_;
   Server::Admin& admin_;
+  // Route tables by the hash of their route config. Listeners often route the same way, and
+  // sharing their route tables saves building and holding the duplicates. Entries whose route
+  // table was destroyed are pruned once they make up half of the map.
+  std::unordered_multimap<uint64_t, SharedConfig> shared_configs_;
+  size_t shared_configs_after_prune_{};
+  // Builds RDS route tables away from the main thread when set. Declared last so that it stops
+  // before anything its work refers to is destroyed.
+  std::unique_ptr<Thread::WorkQueueThread> config_thread_;
 
   friend class RdsRouteConfigProviderImpl;
 };
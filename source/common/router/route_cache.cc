@@ -0,0 +1,46 @@
+#include "common/router/route_cache.h"
+
+#include <cstdint>
+#include <iterator>
+#include <string>
+
+namespace Envoy {
+namespace Router {
+
+RouteConstSharedPtr RouteCache::route(const ConfigConstSharedPtr& config,
+                                      const Http::HeaderMap& headers, uint64_t random_value) {
+  if (!config->routeCacheable() || headers.Host() == nullptr || headers.Path() == nullptr) {
+    return config->route(headers, random_value);
+  }
+
+  if (config != config_) {
+    entries_.clear();
+    config_ = config;
+  }
+
+  const Http::HeaderString& host = headers.Host()->value();
+  const Http::HeaderString& path = headers.Path()->value();
+  for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+    if (it->path_ == path.c_str() && it->host_ == host.c_str()) {
+      entries_.splice(entries_.begin(), entries_, it);
+      return it->route_;
+    }
+  }
+
+  RouteConstSharedPtr route = config->route(headers, random_value);
+  if (entries_.size() == max_entries_) {
+    // Reuse the least recently used entry and its string buffers.
+    entries_.splice(entries_.begin(), entries_, std::prev(entries_.end()));
+    Entry& entry = entries_.front();
+    entry.host_.assign(host.c_str(), host.size());
+    entry.path_.assign(path.c_str(), path.size());
+    entry.route_ = route;
+  } else {
+    entries_.push_front({std::string(host.c_str(), host.size()),
+                         std::string(path.c_str(), path.size()), route});
+  }
+  return route;
+}
+
+} // namespace Router
+} // namespace Envoy
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+
+#include "envoy/http/header_map.h"
+#include "envoy/router/router.h"
+
+#include "common/common/non_copyable.h"
+
+namespace Envoy {
+namespace Router {
+
+/**
+ * Small LRU cache of the routes resolved by a route configuration, keyed by the host and path of
+ * the request. It is meant for a single connection whose requests tend to repeat the same few
+ * shapes, e.g. the gRPC methods called over a HTTP/2 connection, and is not thread safe. Only
+ * configurations that route by host and path alone (Config::routeCacheable()) are cached. The
+ * cache is flushed when it is used with a different configuration than before, so a route config
+ * update is picked up by the next request.
+ */
+class RouteCache : NonCopyable {
+public:
+  /**
+   * @param max_entries supplies the number of routes kept, which must be greater than zero.
+   */
+  RouteCache(uint32_t max_entries) : max_entries_(max_entries) {}
+
+  /**
+   * Resolve the route of a request, as Config::route() does.
+   * @param config supplies the route configuration that is snapped by the request. The cache
+   *        keeps a reference to it while it holds routes of it, since routes reference their
+   *        configuration.
+   * @param headers supplies the request headers.
+   * @param random_value supplies the random seed of the request.
+   * @return the route or nullptr if there is no matching route for the request.
+   */
+  RouteConstSharedPtr route(const ConfigConstSharedPtr& config, const Http::HeaderMap& headers,
+                            uint64_t random_value);
+
+  uint32_t size() const { return entries_.size(); }
+
+private:
+  struct Entry {
+    std::string host_;
+    std::string path_;
+    RouteConstSharedPtr route_;
+  };
+
+  const uint32_t max_entries_;
+  ConfigConstSharedPtr config_;
+  // Most recently used first. Linear search is faster than hashing the key for a few entries.
+  std::list<Entry> entries_;
+};
+
+typedef std::unique_ptr<RouteCache> RouteCachePtr;
+
+} // namespace Router
+} // namespace Envoy
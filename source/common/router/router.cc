@@ -1,5 +1,6 @@
 #include "common/router/router.h"
 
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
 #include <string>
@@ -26,11 +27,16 @@
 #include "common/router/config_impl.h"
 #include "common/router/retry_state_impl.h"
 #include "common/tracing/http_tracer_impl.h"
+#include "common/upstream/host_utility.h"
 
 namespace Envoy {
 namespace Router {
 namespace {
 uint32_t getLength(const Buffer::Instance* instance) { return instance ? instance->length() : 0; }
+
+// How many times the load balancer is asked for a host for a hedged request before giving up on
+// finding one other than the host of the original request.
+const uint32_t MaxHedgeHostAttempts = 3;
 } // namespace
 
 void FilterUtility::setUpstreamScheme(Http::HeaderMap& headers,
@@ -139,7 +145,8 @@ void Filter::chargeUpstreamCode(uint64_t response_status_code,
                                                                : EMPTY_STRING,
                                              zone_name,
                                              upstream_zone,
-                                             is_canary};
+                                             is_canary,
+                                             &cluster_->codeStats()};
 
     Http::CodeUtility::chargeResponseStat(info);
 
@@ -219,7 +226,10 @@ Http::FilterHeadersStatus Filter::decodeHeaders(Http::HeaderMap& headers, bool e
 
   // A route entry matches for the request.
   route_entry_ = route_->routeEntry();
-  Upstream::ThreadLocalCluster* cluster = config_.cm_.get(route_entry_->clusterName());
+  const Upstream::ClusterHandle* cluster_handle = route_entry_->clusterHandle();
+  Upstream::ThreadLocalCluster* cluster = cluster_handle != nullptr
+                                              ? cluster_handle->get()
+                                              : config_.cm_.get(route_entry_->clusterName());
   if (!cluster) {
     config_.stats_.no_cluster_.inc();
     ENVOY_STREAM_LOG(debug, "unknown cluster '{}'", *callbacks_, route_entry_->clusterName());
@@ -273,8 +283,7 @@ Http::FilterHeadersStatus Filter::decodeHeaders(Http::HeaderMap& headers, bool e
   retry_state_ =
       createRetryState(route_entry_->retryPolicy(), headers, *cluster_, config_.runtime_,
                        config_.random_, callbacks_->dispatcher(), route_entry_->priority());
-  do_shadowing_ = FilterUtility::shouldShadow(route_entry_->shadowPolicy(), config_.runtime_,
-                                              callbacks_->streamId());
+  do_hedging_ = route_entry_->hedgePolicy().latencyPercentile() > 0;
 
 #ifndef NVLOG
   headers.iterate(
@@ -294,6 +303,14 @@ Http::FilterHeadersStatus Filter::decodeHeaders(Http::HeaderMap& headers, bool e
   ASSERT(headers.Host());
   ASSERT(headers.Path());
 
+  if (FilterUtility::shouldShadow(route_entry_->shadowPolicy(), config_.runtime_,
+                                 callbacks_->streamId())) {
+    // The shadow is streamed, so that the request is not buffered for it.
+    shadow_stream_ = config_.shadowWriter().streamShadow(
+        route_entry_->shadowPolicy().cluster(),
+        Http::HeaderMapPtr{new Http::HeaderMapImpl(headers)}, end_stream, timeout_.global_timeout_);
+  }
+
   grpc_request_ = Grpc::Common::hasGrpcContentType(headers);
   upstream_request_.reset(new UpstreamRequest(*this, *conn_pool));
   upstream_request_->encodeHeaders(end_stream);
@@ -305,6 +322,10 @@ Http::FilterHeadersStatus Filter::decodeHeaders(Http::HeaderMap& headers, bool e
 }
 
 Http::ConnectionPool::Instance* Filter::getConnPool() {
+  const Upstream::ClusterHandle* cluster_handle = route_entry_->clusterHandle();
+  if (cluster_handle != nullptr) {
+    return cluster_handle->httpConnPool(route_entry_->priority(), this);
+  }
   return config_.cm_.httpConnPoolForCluster(route_entry_->clusterName(), route_entry_->priority(),
                                             this);
 }
@@ -316,18 +337,26 @@ void Filter::sendNoHealthyUpstreamResponse() {
 }
 
 Http::FilterDataStatus Filter::decodeData(Buffer::Instance& data, bool end_stream) {
-  bool buffering = (retry_state_ && retry_state_->enabled()) || do_shadowing_;
+  // The shadow copies the data, since it is moved to the upstream request below.
+  if (shadow_stream_) {
+    shadow_stream_->sendData(data, end_stream);
+    if (end_stream) {
+      shadow_stream_ = nullptr;
+    }
+  }
+
+  bool buffering = (retry_state_ && retry_state_->enabled()) || do_hedging_;
   if (buffering && buffer_limit_ > 0 &&
       getLength(callbacks_->decodingBuffer()) + data.length() > buffer_limit_) {
-    // The request is larger than we should buffer. Give up on the retry/shadow
+    // The request is larger than we should buffer. Give up on the retry/hedge
     cluster_->stats().retry_or_shadow_abandoned_.inc();
     retry_state_.reset();
     buffering = false;
-    do_shadowing_ = false;
+    do_hedging_ = false;
   }
 
-  // If we are going to buffer for retries or shadowing, we need to make a copy before encoding
-  // since it's all moves from here on.
+  // If we are going to buffer for retries or hedging, we need to make a copy before encoding since
+  // it's all moves from here on.
   if (buffering) {
     Buffer::OwnedImpl copy(data);
     upstream_request_->encodeData(copy, end_stream);
@@ -339,7 +368,7 @@ Http::FilterDataStatus Filter::decodeData(Buffer::Instance& data, bool end_strea
     onRequestComplete();
   }
 
-  // If we are potentially going to retry or shadow this request we need to buffer.
+  // If we are potentially going to retry or hedge this request we need to buffer.
   // This will not cause the connection manager to 413 because before we hit the
   // buffer limit we give up on retries and buffering.
   return buffering ? Http::FilterDataStatus::StopIterationAndBuffer
@@ -348,6 +377,10 @@ Http::FilterDataStatus Filter::decodeData(Buffer::Instance& data, bool end_strea
 
 Http::FilterTrailersStatus Filter::decodeTrailers(Http::HeaderMap& trailers) {
   downstream_trailers_ = &trailers;
+  if (shadow_stream_) {
+    shadow_stream_->sendTrailers(trailers);
+    shadow_stream_ = nullptr;
+  }
   upstream_request_->encodeTrailers(trailers);
   onRequestComplete();
   return Http::FilterTrailersStatus::StopIteration;
@@ -363,35 +396,22 @@ void Filter::setDecoderFilterCallbacks(Http::StreamDecoderFilterCallbacks& callb
 
 void Filter::cleanup() {
   upstream_request_.reset();
+  hedge_request_.reset();
   retry_state_.reset();
   if (response_timeout_) {
     response_timeout_->disableTimer();
     response_timeout_.reset();
   }
-}
-
-void Filter::maybeDoShadowing() {
-  if (!do_shadowing_) {
-    return;
-  }
-
-  ASSERT(!route_entry_->shadowPolicy().cluster().empty());
-  Http::MessagePtr request(new Http::RequestMessageImpl(
-      Http::HeaderMapPtr{new Http::HeaderMapImpl(*downstream_headers_)}));
-  if (callbacks_->decodingBuffer()) {
-    request->body().reset(new Buffer::OwnedImpl(*callbacks_->decodingBuffer()));
+  if (hedge_timeout_) {
+    hedge_timeout_->disableTimer();
+    hedge_timeout_.reset();
   }
-  if (downstream_trailers_) {
-    request->trailers(Http::HeaderMapPtr{new Http::HeaderMapImpl(*downstream_trailers_)});
-  }
-
-  config_.shadowWriter().shadow(route_entry_->shadowPolicy().cluster(), std::move(request),
-                                timeout_.global_timeout_);
 }
 
 void Filter::onRequestComplete() {
   downstream_end_stream_ = true;
-  downstream_request_complete_time_ = std::chrono::steady_clock::now();
+  downstream_request_complete_time_ =
+      callbacks_->dispatcher().approximateMonotonicTimeSource().currentTime();
   callbacks_->requestInfo().requestReceivedDuration(downstream_request_complete_time_);
 
   // Possible that we got an immediate reset.
@@ -399,23 +419,147 @@ void Filter::onRequestComplete() {
     // Nominally how long it took to send the request.
     upstream_request_->request_info_.requestReceivedDuration(downstream_request_complete_time_);
 
-    // Even if we got an immediate reset, we could still shadow, but that is a riskier change and
-    // seems unnecessary right now.
-    maybeDoShadowing();
-
     upstream_request_->setupPerTryTimeout();
     if (timeout_.global_timeout_.count() > 0) {
       response_timeout_ =
           callbacks_->dispatcher().createTimer([this]() -> void { onResponseTimeout(); });
       response_timeout_->enableTimer(timeout_.global_timeout_);
     }
+
+    setupHedge();
+  }
+}
+
+void Filter::setupHedge() {
+  if (!do_hedging_) {
+    return;
+  }
+
+  const HedgePolicy& policy = route_entry_->hedgePolicy();
+  const Optional<std::chrono::milliseconds> latency =
+      cluster_->latencyEstimator().percentile(policy.latencyPercentile());
+  if (!latency.valid()) {
+    // Too few responses have been seen yet to tell a slow request from a normal one.
+    return;
+  }
+
+  const std::chrono::milliseconds delay = std::max(latency.value(), policy.minDelay());
+  if (timeout_.global_timeout_.count() > 0 && delay >= timeout_.global_timeout_) {
+    return;
+  }
+
+  hedge_timeout_ = callbacks_->dispatcher().createTimer([this]() -> void { onHedgeTimeout(); });
+  hedge_timeout_->enableTimer(delay);
+}
+
+void Filter::onHedgeTimeout() {
+  // Only hedge a request that is still waiting for its first response, and only once.
+  if (!upstream_request_ || hedge_request_ || downstream_response_started_) {
+    return;
+  }
+
+  // A hedge to the host that is already slow to answer would not help. Connection pools are per
+  // host, and the original request may still be waiting for a connection, so hosts are told apart
+  // by their pools.
+  Http::ConnectionPool::Instance* conn_pool = nullptr;
+  choosing_hedge_host_ = true;
+  for (uint32_t attempt = 0; attempt < MaxHedgeHostAttempts; attempt++) {
+    conn_pool = getConnPool();
+    if (conn_pool != &upstream_request_->conn_pool_) {
+      break;
+    }
+  }
+  choosing_hedge_host_ = false;
+  if (!conn_pool) {
+    return;
+  }
+  if (conn_pool == &upstream_request_->conn_pool_) {
+    ENVOY_STREAM_LOG(debug, "not hedging, no other upstream host was picked", *callbacks_);
+    cluster_->stats().upstream_rq_hedge_same_host_.inc();
+    return;
+  }
+
+  ENVOY_STREAM_LOG(debug, "hedging upstream request", *callbacks_);
+  cluster_->stats().upstream_rq_hedge_.inc();
+  hedge_request_.reset(new UpstreamRequest(*this, *conn_pool));
+  hedge_request_->encodeHeaders(!callbacks_->decodingBuffer() && !downstream_trailers_);
+  // It's possible we got immediately reset.
+  if (hedge_request_) {
+    if (callbacks_->decodingBuffer()) {
+      // The request is complete, so the body can be shared with the buffered request.
+      Buffer::OwnedImpl body;
+      body.addBufferReference(*callbacks_->decodingBuffer());
+      hedge_request_->encodeData(body, !downstream_trailers_);
+    }
+
+    if (downstream_trailers_) {
+      hedge_request_->encodeTrailers(*downstream_trailers_);
+    }
+
+    hedge_request_->setupPerTryTimeout();
   }
 }
 
+void Filter::pickHedgeWinner(UpstreamRequest& winner) {
+  // Once any response has arrived there is no point in hedging.
+  if (hedge_timeout_) {
+    hedge_timeout_->disableTimer();
+  }
+
+  if (!hedge_request_) {
+    return;
+  }
+
+  if (&winner == hedge_request_.get()) {
+    ENVOY_STREAM_LOG(debug, "hedged upstream request responded first", *callbacks_);
+    cluster_->stats().upstream_rq_hedge_success_.inc();
+    upstream_request_->resetStream();
+    upstream_request_ = std::move(hedge_request_);
+  } else {
+    hedge_request_->resetStream();
+    hedge_request_.reset();
+  }
+
+  callbacks_->requestInfo().onUpstreamHostSelected(upstream_request_->upstream_host_);
+}
+
+bool Filter::dropFailedHedgeRequest(UpstreamRequest& failed, UpstreamResetType type) {
+  if (!hedge_request_) {
+    return false;
+  }
+
+  ENVOY_STREAM_LOG(debug, "hedged upstream request failed, waiting for the other", *callbacks_);
+  if (failed.upstream_host_) {
+    const Http::Code code =
+        type == UpstreamResetType::Reset ? Http::Code::ServiceUnavailable : timeout_response_code_;
+    failed.upstream_host_->outlierDetector().putHttpResponseCode(enumToInt(code));
+    failed.upstream_host_->stats().rq_error_.inc();
+  }
+
+  if (&failed == hedge_request_.get()) {
+    hedge_request_.reset();
+  } else {
+    upstream_request_ = std::move(hedge_request_);
+  }
+
+  if (upstream_request_->upstream_host_) {
+    callbacks_->requestInfo().onUpstreamHostSelected(upstream_request_->upstream_host_);
+  }
+  return true;
+}
+
 void Filter::onDestroy() {
+  // The request was reset before it was complete, so the shadow would never be.
+  if (shadow_stream_) {
+    shadow_stream_->cancel();
+    shadow_stream_ = nullptr;
+  }
   if (upstream_request_) {
     upstream_request_->resetStream();
   }
+  if (hedge_request_) {
+    hedge_request_->resetStream();
+  }
   stream_destroyed_ = true;
   cleanup();
 }
@@ -432,6 +576,9 @@ void Filter::onResponseTimeout() {
     }
     upstream_request_->resetStream();
   }
+  if (hedge_request_) {
+    hedge_request_->resetStream();
+  }
 
   onUpstreamReset(UpstreamResetType::GlobalTimeout, Optional<Http::StreamResetReason>());
 }
@@ -582,7 +729,8 @@ void Filter::onUpstreamHeaders(const uint64_t response_code, Http::HeaderMapPtr&
   // Only send upstream service time if we received the complete request and this is not a
   // premature response.
   if (DateUtil::timePointValid(downstream_request_complete_time_)) {
-    MonotonicTime response_received_time = std::chrono::steady_clock::now();
+    MonotonicTime response_received_time =
+        callbacks_->dispatcher().approximateMonotonicTimeSource().currentTime();
     std::chrono::milliseconds ms = std::chrono::duration_cast<std::chrono::milliseconds>(
         response_received_time - downstream_request_complete_time_);
     headers->insertEnvoyUpstreamServiceTime().value(ms.count());
@@ -650,9 +798,12 @@ void Filter::onUpstreamComplete() {
   if (config_.emit_dynamic_stats_ && !callbacks_->requestInfo().healthCheck() &&
       DateUtil::timePointValid(downstream_request_complete_time_)) {
     std::chrono::milliseconds response_time = std::chrono::duration_cast<std::chrono::milliseconds>(
-        std::chrono::steady_clock::now() - downstream_request_complete_time_);
+        callbacks_->dispatcher().approximateMonotonicTimeSource().currentTime() -
+        downstream_request_complete_time_);
 
     upstream_request_->upstream_host_->outlierDetector().putResponseTime(response_time);
+    cluster_->latencyEstimator().putResponseTime(response_time);
+    Upstream::HostUtility::recordResponseTime(*upstream_request_->upstream_host_, response_time);
 
     const Http::HeaderEntry* internal_request_header = downstream_headers_->EnvoyInternalRequest();
     const bool internal_request =
@@ -709,6 +860,11 @@ bool Filter::setupRetry(bool end_stream) {
     upstream_request_->resetStream();
   }
 
+  // The retry is not hedged.
+  if (hedge_timeout_) {
+    hedge_timeout_->disableTimer();
+  }
+
   upstream_request_.reset();
   return true;
 }
@@ -728,9 +884,11 @@ void Filter::doRetry() {
   // It's possible we got immediately reset.
   if (upstream_request_) {
     if (callbacks_->decodingBuffer()) {
-      // If we are doing a retry we need to make a copy.
-      Buffer::OwnedImpl copy(*callbacks_->decodingBuffer());
-      upstream_request_->encodeData(copy, !downstream_trailers_);
+      // The buffered request is needed for any further retries. Retries only happen once the
+      // request is complete, so the retry can share its body rather than copy it.
+      Buffer::OwnedImpl body;
+      body.addBufferReference(*callbacks_->decodingBuffer());
+      upstream_request_->encodeData(body, !downstream_trailers_);
     }
 
     if (downstream_trailers_) {
@@ -743,7 +901,9 @@ void Filter::doRetry() {
 
 Filter::UpstreamRequest::UpstreamRequest(Filter& parent, Http::ConnectionPool::Instance& pool)
     : parent_(parent), conn_pool_(pool), grpc_rq_success_deferred_(false),
-      request_info_(pool.protocol()), calling_encode_headers_(false), upstream_canary_(false),
+      request_info_(pool.protocol(), parent.callbacks_->dispatcher().approximateSystemTimeSource(),
+                    parent.callbacks_->dispatcher().approximateMonotonicTimeSource()),
+      calling_encode_headers_(false), upstream_canary_(false),
       encode_complete_(false), encode_trailers_(false) {
 
   if (parent_.config_.start_child_span_) {
@@ -776,6 +936,7 @@ void Filter::UpstreamRequest::decodeHeaders(Http::HeaderMapPtr&& headers, bool e
   upstream_headers_ = headers.get();
   const uint64_t response_code = Http::Utility::getResponseStatus(*headers);
   request_info_.response_code_.value(static_cast<uint32_t>(response_code));
+  parent_.pickHedgeWinner(*this);
   parent_.onUpstreamHeaders(response_code, std::move(headers), end_stream);
 }
 
@@ -839,6 +1000,9 @@ void Filter::UpstreamRequest::onResetStream(Http::StreamResetReason reason) {
   clearRequestEncoder();
   if (!calling_encode_headers_) {
     request_info_.setResponseFlag(parent_.streamResetReasonToResponseFlag(reason));
+    if (parent_.dropFailedHedgeRequest(*this, UpstreamResetType::Reset)) {
+      return;
+    }
     parent_.onUpstreamReset(UpstreamResetType::Reset, Optional<Http::StreamResetReason>(reason));
   } else {
     deferred_reset_reason_ = reason;
@@ -877,6 +1041,9 @@ void Filter::UpstreamRequest::onPerTryTimeout() {
   }
   resetStream();
   request_info_.setResponseFlag(RequestInfo::ResponseFlag::UpstreamRequestTimeout);
+  if (parent_.dropFailedHedgeRequest(*this, UpstreamResetType::PerTryTimeout)) {
+    return;
+  }
   parent_.onUpstreamReset(UpstreamResetType::PerTryTimeout,
                           Optional<Http::StreamResetReason>(Http::StreamResetReason::LocalReset));
 }
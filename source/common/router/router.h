@@ -133,7 +133,7 @@ class Filter : Logger::Loggable<Logger::Id::router>,
 public:
   Filter(FilterConfig& config)
       : config_(config), downstream_response_started_(false), downstream_end_stream_(false),
-        do_shadowing_(false) {}
+        do_hedging_(false), choosing_hedge_host_(false) {}
 
   ~Filter();
 
@@ -148,7 +148,9 @@ public:
 
   // Upstream::LoadBalancerContext
   Optional<uint64_t> computeHashKey() override {
-    if (route_entry_ && downstream_headers_) {
+    // A hedged request goes to whichever host the load balancer picks without the hash, so that it
+    // is not sent to the same slow host again.
+    if (route_entry_ && downstream_headers_ && !choosing_hedge_host_) {
       auto hash_policy = route_entry_->hashPolicy();
       if (hash_policy) {
         return hash_policy->generateHash(
@@ -294,7 +296,14 @@ private:
                                          Event::Dispatcher& dispatcher,
                                          Upstream::ResourcePriority priority) PURE;
   Http::ConnectionPool::Instance* getConnPool();
-  void maybeDoShadowing();
+  void setupHedge();
+  void onHedgeTimeout();
+  // Called when one of the upstream requests receives response headers. If a hedged request is in
+  // flight, the other request is reset and the winner becomes upstream_request_.
+  void pickHedgeWinner(UpstreamRequest& winner);
+  // Called when one of the upstream requests fails. If a hedged request is in flight, the failed
+  // request is dropped and the other one carries on, so the failure is not handled.
+  bool dropFailedHedgeRequest(UpstreamRequest& failed, UpstreamResetType type);
   void onRequestComplete();
   void onResponseTimeout();
   void onUpstreamHeaders(uint64_t response_code, Http::HeaderMapPtr&& headers, bool end_stream);
@@ -322,6 +331,11 @@ private:
   FilterUtility::TimeoutData timeout_;
   Http::Code timeout_response_code_ = Http::Code::GatewayTimeout;
   UpstreamRequestPtr upstream_request_;
+  // The second request sent by hedging, while both it and upstream_request_ wait for a response.
+  UpstreamRequestPtr hedge_request_;
+  Event::TimerPtr hedge_timeout_;
+  // Set while the rest of the request is still to be sent to the shadow.
+  ShadowStream* shadow_stream_{};
   bool grpc_request_{};
   Http::HeaderMap* downstream_headers_{};
   Http::HeaderMap* downstream_trailers_{};
@@ -334,7 +348,8 @@ private:
 
   bool downstream_response_started_ : 1;
   bool downstream_end_stream_ : 1;
-  bool do_shadowing_ : 1;
+  bool do_hedging_ : 1;
+  bool choosing_hedge_host_ : 1;
 };
 
 class ProdFilter : public Filter {
@@ -3,20 +3,30 @@
 #include <chrono>
 #include <string>
 
+#include "common/buffer/buffer_impl.h"
 #include "common/common/assert.h"
+#include "common/http/header_map_impl.h"
 #include "common/http/headers.h"
 
 namespace Envoy {
 namespace Router {
 
-void ShadowWriterImpl::shadow(const std::string& cluster, Http::MessagePtr&& request,
-                              std::chrono::milliseconds timeout) {
-  // Switch authority to add a shadow postfix. This allows upstream logging to make a more sense.
+namespace {
+
+// Switch authority to add a shadow postfix. This allows upstream logging to make a more sense.
+void addShadowPostfix(Http::HeaderMap& headers) {
   // TODO PERF: Avoid copy.
-  std::string host = request->headers().Host()->value().c_str();
+  std::string host = headers.Host()->value().c_str();
   ASSERT(!host.empty());
   host += "-shadow";
-  request->headers().Host()->value(host);
+  headers.Host()->value(host);
+}
+
+} // namespace
+
+void ShadowWriterImpl::shadow(const std::string& cluster, Http::MessagePtr&& request,
+                              std::chrono::milliseconds timeout) {
+  addShadowPostfix(request->headers());
 
   // Configuration should guarantee that cluster exists before calling here. This is basically
   // fire and forget. We don't handle cancelling.
@@ -24,5 +34,114 @@ void ShadowWriterImpl::shadow(const std::string& cluster, Http::MessagePtr&& req
                                               Optional<std::chrono::milliseconds>(timeout));
 }
 
+ShadowStream* ShadowWriterImpl::streamShadow(const std::string& cluster,
+                                             Http::HeaderMapPtr&& headers, bool end_stream,
+                                             std::chrono::milliseconds timeout) {
+  addShadowPostfix(*headers);
+
+  // Configuration should guarantee that cluster exists before calling here. The stream deletes
+  // itself when it is done.
+  ShadowStreamImpl* stream =
+      new ShadowStreamImpl(cm_.httpAsyncClientForCluster(cluster), std::move(headers));
+  return stream->start(end_stream, timeout) ? stream : nullptr;
+}
+
+bool ShadowStreamImpl::start(bool end_stream, std::chrono::milliseconds timeout) {
+  stream_ = client_.start(*this, Optional<std::chrono::milliseconds>(timeout), false);
+  if (stream_ != nullptr) {
+    stream_->sendHeaders(*headers_, end_stream);
+  }
+
+  // The stream may also have been reset inline.
+  if (end_stream || stream_ == nullptr) {
+    onRequestDone();
+    return false;
+  }
+  return true;
+}
+
+void ShadowStreamImpl::sendData(Buffer::Instance& data, bool end_stream) {
+  ASSERT(!request_done_);
+  if (stream_ != nullptr && stream_->isAboveWriteBufferHighWatermark()) {
+    // Rather than buffer the request for the shadow, give up on it.
+    ENVOY_LOG(debug, "resetting shadow request whose upstream is backed up");
+    resetStream();
+  }
+  resetIfResponded();
+
+  if (stream_ != nullptr) {
+    Buffer::OwnedImpl copy(data);
+    stream_->sendData(copy, end_stream);
+  }
+
+  if (end_stream) {
+    onRequestDone();
+  }
+}
+
+void ShadowStreamImpl::sendTrailers(const Http::HeaderMap& trailers) {
+  ASSERT(!request_done_);
+  resetIfResponded();
+  if (stream_ != nullptr) {
+    trailers_.reset(new Http::HeaderMapImpl(trailers));
+    stream_->sendTrailers(*trailers_);
+  }
+  onRequestDone();
+}
+
+void ShadowStreamImpl::cancel() {
+  ASSERT(!request_done_);
+  resetStream();
+  onRequestDone();
+}
+
+void ShadowStreamImpl::onReset() {
+  stream_ = nullptr;
+  maybeDelete();
+}
+
+void ShadowStreamImpl::onResponse(bool end_stream) {
+  if (!end_stream) {
+    return;
+  }
+
+  response_done_ = true;
+  if (request_done_) {
+    // Both directions are complete, so the async client cleans the stream up.
+    stream_ = nullptr;
+    maybeDelete();
+  }
+}
+
+void ShadowStreamImpl::resetIfResponded() {
+  // The shadow responded before the whole request was sent to it, which leaves nothing to send
+  // the rest to. The stream is reset here rather than from within its own callbacks.
+  if (response_done_) {
+    resetStream();
+  }
+}
+
+void ShadowStreamImpl::resetStream() {
+  if (stream_ == nullptr) {
+    return;
+  }
+  Http::AsyncClient::Stream* stream = stream_;
+  stream_ = nullptr;
+  // Calls onReset().
+  stream->reset();
+}
+
+void ShadowStreamImpl::onRequestDone() {
+  request_done_ = true;
+  maybeDelete();
+}
+
+void ShadowStreamImpl::maybeDelete() {
+  if (request_done_ && stream_ == nullptr && !deleted_) {
+    deleted_ = true;
+    client_.dispatcher().deferredDelete(Event::DeferredDeletablePtr{this});
+  }
+}
+
 } // namespace Router
 } // namespace Envoy
@@ -3,9 +3,12 @@
 #include <chrono>
 #include <string>
 
+#include "envoy/event/deferred_deletable.h"
 #include "envoy/router/shadow_writer.h"
 #include "envoy/upstream/cluster_manager.h"
 
+#include "common/common/logger.h"
+
 namespace Envoy {
 namespace Router {
 
@@ -20,6 +23,8 @@ public:
   // Router::ShadowWriter
   void shadow(const std::string& cluster, Http::MessagePtr&& request,
               std::chrono::milliseconds timeout) override;
+  ShadowStream* streamShadow(const std::string& cluster, Http::HeaderMapPtr&& headers,
+                             bool end_stream, std::chrono::milliseconds timeout) override;
 
   // Http::AsyncClient::Callbacks
   void onSuccess(Http::MessagePtr&&) override {}
@@ -29,5 +34,55 @@ private:
   Upstream::ClusterManager& cm_;
 };
 
+/**
+ * A streamed shadow request. It deletes itself once both the request has been ended or cancelled
+ * through the handle and the async client stream is done.
+ */
+class ShadowStreamImpl : public ShadowStream,
+                         public Http::AsyncClient::StreamCallbacks,
+                         public Event::DeferredDeletable,
+                         Logger::Loggable<Logger::Id::router> {
+public:
+  ShadowStreamImpl(Http::AsyncClient& client, Http::HeaderMapPtr&& headers)
+      : client_(client), headers_(std::move(headers)) {}
+
+  /**
+   * Start the async client stream and send the headers.
+   * @return bool whether the handle may be used to send more.
+   */
+  bool start(bool end_stream, std::chrono::milliseconds timeout);
+
+  // Router::ShadowStream
+  void sendData(Buffer::Instance& data, bool end_stream) override;
+  void sendTrailers(const Http::HeaderMap& trailers) override;
+  void cancel() override;
+
+  // Http::AsyncClient::StreamCallbacks
+  void onHeaders(Http::HeaderMapPtr&&, bool end_stream) override { onResponse(end_stream); }
+  void onData(Buffer::Instance&, bool end_stream) override { onResponse(end_stream); }
+  void onTrailers(Http::HeaderMapPtr&&) override { onResponse(true); }
+  void onReset() override;
+  // The router checks isAboveWriteBufferHighWatermark() before each send instead.
+  void onAboveWriteBufferHighWatermark() override {}
+  void onBelowWriteBufferLowWatermark() override {}
+
+private:
+  void onResponse(bool end_stream);
+  void resetIfResponded();
+  void resetStream();
+  void onRequestDone();
+  void maybeDelete();
+
+  Http::AsyncClient& client_;
+  // The async client stream refers to these until it is done.
+  Http::HeaderMapPtr headers_;
+  Http::HeaderMapPtr trailers_;
+  // nullptr once the stream is done.
+  Http::AsyncClient::Stream* stream_{};
+  bool request_done_{};
+  bool response_done_{};
+  bool deleted_{};
+};
+
 } // namespace Router
 } // namespace Envoy
@@ -4,6 +4,7 @@
 #include <unistd.h>
 
 #include <cstdint>
+#include <cstring>
 #include <random>
 #include <string>
 
@@ -21,7 +22,25 @@
 namespace Envoy {
 namespace Runtime {
 
-const size_t RandomGeneratorImpl::UUID_LENGTH = 36;
+// The definition of the constant declared in envoy/runtime/runtime.h.
+const size_t RandomGenerator::UUID_LENGTH;
+
+namespace {
+// The two lowercase hex digits of every byte value.
+struct HexPairTable {
+  HexPairTable() {
+    static const char* const hex = "0123456789abcdef";
+    for (uint32_t i = 0; i < 256; i++) {
+      pairs_[i][0] = hex[i >> 4];
+      pairs_[i][1] = hex[i & 0x0f];
+    }
+  }
+
+  char pairs_[256][2];
+};
+
+const HexPairTable HexPairs;
+} // namespace
 
 uint64_t RandomGeneratorImpl::random() {
   // Prefetch 256 * sizeof(uint64_t) bytes of randomness. buffered_idx is initialized to 256,
@@ -61,7 +80,7 @@ uint64_t RandomGeneratorImpl::random() {
   return buffered[buffered_idx++];
 }
 
-std::string RandomGeneratorImpl::uuid() {
+void RandomGeneratorImpl::writeUuid(char* out) {
   // Prefetch 2048 bytes of randomness. buffered_idx is initialized to sizeof(buffered),
   // i.e. out-of-range value, so the buffer will be filled with randomness on the first
   // call to this function.
@@ -102,59 +121,33 @@ std::string RandomGeneratorImpl::uuid() {
   rand[6] = (rand[6] & 0x0f) | 0x40; // UUID version 4 (random)
   rand[8] = (rand[8] & 0x3f) | 0x80; // UUID variant 1 (RFC4122)
 
-  // Convert UUID to a string representation, e.g. a121e9e1-feae-4136-9e0e-6fac343d56c9.
-  static const char* const hex = "0123456789abcdef";
-  char uuid[UUID_LENGTH];
-
-  for (uint8_t i = 0; i < 4; i++) {
-    const uint8_t d = rand[i];
-    uuid[2 * i] = hex[d >> 4];
-    uuid[2 * i + 1] = hex[d & 0x0f];
-  }
-
-  uuid[8] = '-';
-
-  for (uint8_t i = 4; i < 6; i++) {
-    const uint8_t d = rand[i];
-    uuid[2 * i + 1] = hex[d >> 4];
-    uuid[2 * i + 2] = hex[d & 0x0f];
-  }
-
-  uuid[13] = '-';
-
-  for (uint8_t i = 6; i < 8; i++) {
-    const uint8_t d = rand[i];
-    uuid[2 * i + 2] = hex[d >> 4];
-    uuid[2 * i + 3] = hex[d & 0x0f];
-  }
-
-  uuid[18] = '-';
-
-  for (uint8_t i = 8; i < 10; i++) {
-    const uint8_t d = rand[i];
-    uuid[2 * i + 3] = hex[d >> 4];
-    uuid[2 * i + 4] = hex[d & 0x0f];
-  }
-
-  uuid[23] = '-';
-
-  for (uint8_t i = 10; i < 16; i++) {
-    const uint8_t d = rand[i];
-    uuid[2 * i + 4] = hex[d >> 4];
-    uuid[2 * i + 5] = hex[d & 0x0f];
+  // Convert UUID to a string representation, e.g. a121e9e1-feae-4136-9e0e-6fac343d56c9, two hex
+  // digits per byte at a time.
+  for (uint8_t i = 0; i < 16; i++) {
+    if (i == 4 || i == 6 || i == 8 || i == 10) {
+      *out++ = '-';
+    }
+    memcpy(out, HexPairs.pairs_[rand[i]], 2);
+    out += 2;
   }
+}
 
+std::string RandomGeneratorImpl::uuid() {
+  char uuid[UUID_LENGTH];
+  writeUuid(uuid);
   return std::string(uuid, UUID_LENGTH);
 }
 
 SnapshotImpl::SnapshotImpl(const std::string& root_path, const std::string& override_path,
                            RuntimeStats& stats, RandomGenerator& generator,
-                           Api::OsSysCalls& os_sys_calls)
-    : generator_(generator), os_sys_calls_(os_sys_calls) {
+                           Api::OsSysCalls& os_sys_calls, const SnapshotImpl* previous)
+    : stats_(stats), load_time_(std::chrono::system_clock::to_time_t(
+                         ProdSystemTimeSource::instance_.currentTime())),
+      generator_(generator), os_sys_calls_(os_sys_calls) {
   try {
-    walkDirectory(root_path, "");
+    walkDirectory(root_path, "", previous);
     if (Filesystem::directoryExists(override_path)) {
-      walkDirectory(override_path, "");
+      walkDirectory(override_path, "", previous);
       stats.override_dir_exists_.inc();
     } else {
       stats.override_dir_not_exists_.inc();
@@ -167,27 +160,38 @@ SnapshotImpl::SnapshotImpl(const std::string& root_path, const std::string& over
   }
 
   stats.num_keys_.set(values_.size());
+
+  for (const std::string& name : Key::names()) {
+    keys_.push_back(find(name));
+  }
 }
 
-const std::string& SnapshotImpl::get(const std::string& key) const {
+const SnapshotImpl::Entry* SnapshotImpl::find(const std::string& key) const {
   auto entry = values_.find(key);
-  if (entry == values_.end()) {
-    return EMPTY_STRING;
-  } else {
-    return entry->second.string_value_;
+  return entry == values_.end() ? nullptr : entry->second.get();
+}
+
+const SnapshotImpl::Entry* SnapshotImpl::find(const Key& key) const {
+  if (key.index() < keys_.size()) {
+    return keys_[key.index()];
   }
+  return find(key.name());
 }
 
-uint64_t SnapshotImpl::getInteger(const std::string& key, uint64_t default_value) const {
-  auto entry = values_.find(key);
-  if (entry == values_.end() || !entry->second.uint_value_.valid()) {
+const std::string& SnapshotImpl::stringValue(const Entry* entry) {
+  return entry == nullptr ? EMPTY_STRING : entry->string_value_;
+}
+
+uint64_t SnapshotImpl::integerValue(const Entry* entry, uint64_t default_value) {
+  if (entry == nullptr || !entry->uint_value_.valid()) {
     return default_value;
   } else {
-    return entry->second.uint_value_.value();
+    return entry->uint_value_.value();
   }
 }
 
-void SnapshotImpl::walkDirectory(const std::string& path, const std::string& prefix) {
+void SnapshotImpl::walkDirectory(const std::string& path, const std::string& prefix,
+                                 const SnapshotImpl* previous) {
   ENVOY_LOG(debug, "walking directory: {}", path);
   Directory current_dir(path);
   while (true) {
@@ -217,38 +221,63 @@ void SnapshotImpl::walkDirectory(const std::string& path, const std::string& pre
 
     if (S_ISDIR(stat_result.st_mode) && std::string(entry->d_name) != "." &&
         std::string(entry->d_name) != "..") {
-      walkDirectory(full_path, full_prefix);
+      walkDirectory(full_path, full_prefix, previous);
     } else if (S_ISREG(stat_result.st_mode)) {
-      // Suck the file into a string. This is not very efficient but it should be good enough
-      // for small files. Also, as noted elsewhere, none of this is non-blocking which could
-      // theoretically lead to issues.
-      ENVOY_LOG(debug, "reading file: {}", full_path);
-      Entry entry;
-
-      // Read the file and remove any comments. A comment is a line starting with a '#' character.
-      // Comments are useful for placeholder files with no value.
-      const std::vector<std::string> lines =
-          StringUtil::split(Filesystem::fileReadToEnd(full_path), "\n");
-      for (const std::string& line : lines) {
-        if (!line.empty() && line.at(0) == '#') {
-          continue;
-        }
-        entry.string_value_ += line + "\n";
-      }
-      StringUtil::rtrim(entry.string_value_);
-
-      // As a perf optimization, attempt to convert the string into an integer. If we don't
-      // succeed that's fine.
-      uint64_t converted;
-      if (StringUtil::atoul(entry.string_value_.c_str(), converted)) {
-        entry.uint_value_.value(converted);
-      }
-
-      values_[full_prefix] = entry;
+      values_[full_prefix] = loadFile(full_path, stat_result, previous);
     }
   }
 }
 
+SnapshotImpl::EntrySharedPtr SnapshotImpl::loadFile(const std::string& path,
+                                                    const struct stat& stat_result,
+                                                    const SnapshotImpl* previous) {
+  FileEntry& file = files_[path];
+  file.size_ = stat_result.st_size;
+  file.modified_ = stat_result.st_mtime;
+  // Modification times only have a resolution of a second, so a file that was written in the
+  // same second as it was read could change again without its modification time changing.
+  file.reusable_ = file.modified_ < load_time_ - 1;
+
+  if (previous != nullptr) {
+    auto previous_file = previous->files_.find(path);
+    if (previous_file != previous->files_.end() && previous_file->second.reusable_ &&
+        previous_file->second.size_ == file.size_ &&
+        previous_file->second.modified_ == file.modified_) {
+      ENVOY_LOG(trace, "reusing unchanged file: {}", path);
+      stats_.load_files_reused_.inc();
+      file.entry_ = previous_file->second.entry_;
+      return file.entry_;
+    }
+  }
+
+  // Suck the file into a string. This is not very efficient but it should be good enough
+  // for small files. Also, as noted elsewhere, none of this is non-blocking which could
+  // theoretically lead to issues.
+  ENVOY_LOG(debug, "reading file: {}", path);
+  std::shared_ptr<Entry> entry = std::make_shared<Entry>();
+
+  // Read the file and remove any comments. A comment is a line starting with a '#' character.
+  // Comments are useful for placeholder files with no value.
+  const std::vector<std::string> lines = StringUtil::split(Filesystem::fileReadToEnd(path), "\n");
+  for (const std::string& line : lines) {
+    if (!line.empty() && line.at(0) == '#') {
+      continue;
+    }
+    entry->string_value_ += line + "\n";
+  }
+  StringUtil::rtrim(entry->string_value_);
+
+  // As a perf optimization, attempt to convert the string into an integer. If we don't
+  // succeed that's fine.
+  uint64_t converted;
+  if (StringUtil::atoul(entry->string_value_.c_str(), converted)) {
+    entry->uint_value_.value(converted);
+  }
+
+  file.entry_ = entry;
+  return file.entry_;
+}
+
 LoaderImpl::LoaderImpl(Event::Dispatcher& dispatcher, ThreadLocal::SlotAllocator& tls,
                        const std::string& root_symlink_path, const std::string& subdir,
                        const std::string& override_dir, Stats::Store& store,
@@ -271,8 +300,8 @@ RuntimeStats LoaderImpl::generateStats(Stats::Store& store) {
 }
 
 void LoaderImpl::onSymlinkSwap() {
-  current_snapshot_.reset(
-      new SnapshotImpl(root_path_, override_path_, stats_, generator_, *os_sys_calls_));
+  current_snapshot_.reset(new SnapshotImpl(root_path_, override_path_, stats_, generator_,
+                                           *os_sys_calls_, current_snapshot_.get()));
   ThreadLocal::ThreadLocalObjectSharedPtr ptr_copy = current_snapshot_;
   tls_->set([ptr_copy](Event::Dispatcher&) -> ThreadLocal::ThreadLocalObjectSharedPtr {
     return ptr_copy;
@@ -1,11 +1,14 @@
 #pragma once
 
 #include <dirent.h>
+#include <sys/stat.h>
 
 #include <cstdint>
+#include <ctime>
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "envoy/api/os_sys_calls.h"
 #include "envoy/common/exception.h"
@@ -32,8 +35,7 @@ public:
   // Runtime::RandomGenerator
   uint64_t random() override;
   std::string uuid() override;
-
-  static const size_t UUID_LENGTH;
+  void writeUuid(char* out) override;
 };
 
 /**
@@ -45,6 +47,7 @@ public:
   COUNTER(override_dir_not_exists)                                                                 \
   COUNTER(override_dir_exists)                                                                     \
   COUNTER(load_success)                                                                            \
+  COUNTER(load_files_reused)                                                                       \
   GAUGE  (num_keys)
 // clang-format on
 
@@ -56,41 +59,54 @@ struct RuntimeStats {
 };
 
 /**
- * Implementation of Snapshot that reads from disk.
+ * Implementation of Snapshot that reads from disk. Files that have not changed since the previous
+ * snapshot was loaded are not read again, and their values are shared with it.
  */
 class SnapshotImpl : public Snapshot,
                      public ThreadLocal::ThreadLocalObject,
                      Logger::Loggable<Logger::Id::runtime> {
 public:
+  /**
+   * @param previous supplies the snapshot loaded before this one, if any, whose values are reused
+   *        for files that did not change.
+   */
   SnapshotImpl(const std::string& root_path, const std::string& override_path, RuntimeStats& stats,
-               RandomGenerator& generator, Api::OsSysCalls& os_sys_calls);
+               RandomGenerator& generator, Api::OsSysCalls& os_sys_calls,
+               const SnapshotImpl* previous);
 
   // Runtime::Snapshot
   bool featureEnabled(const std::string& key, uint64_t default_value, uint64_t random_value,
                       uint16_t num_buckets) const override {
-    return random_value % static_cast<uint64_t>(num_buckets) <
-           std::min(getInteger(key, default_value), static_cast<uint64_t>(num_buckets));
+    return enabled(getInteger(key, default_value), random_value, num_buckets);
   }
-
   bool featureEnabled(const std::string& key, uint64_t default_value) const override {
-    // Avoid PNRG if we know we don't need it.
-    uint64_t cutoff = std::min(getInteger(key, default_value), static_cast<uint64_t>(100));
-    if (cutoff == 0) {
-      return false;
-    } else if (cutoff == 100) {
-      return true;
-    } else {
-      return generator_.random() % 100 < cutoff;
-    }
+    return enabled(getInteger(key, default_value));
   }
-
   bool featureEnabled(const std::string& key, uint64_t default_value,
                       uint64_t random_value) const override {
-    return featureEnabled(key, default_value, random_value, 100);
+    return enabled(getInteger(key, default_value), random_value, 100);
+  }
+  const std::string& get(const std::string& key) const override {
+    return stringValue(find(key));
+  }
+  uint64_t getInteger(const std::string& key, uint64_t default_value) const override {
+    return integerValue(find(key), default_value);
+  }
+  bool featureEnabled(const Key& key, uint64_t default_value, uint64_t random_value,
+                      uint16_t num_buckets) const override {
+    return enabled(getInteger(key, default_value), random_value, num_buckets);
+  }
+  bool featureEnabled(const Key& key, uint64_t default_value) const override {
+    return enabled(getInteger(key, default_value));
+  }
+  bool featureEnabled(const Key& key, uint64_t default_value,
+                      uint64_t random_value) const override {
+    return enabled(getInteger(key, default_value), random_value, 100);
+  }
+  const std::string& get(const Key& key) const override { return stringValue(find(key)); }
+  uint64_t getInteger(const Key& key, uint64_t default_value) const override {
+    return integerValue(find(key), default_value);
   }
-
-  const std::string& get(const std::string& key) const override;
-  uint64_t getInteger(const std::string&, uint64_t default_value) const override;
 
 private:
   struct Directory {
@@ -111,9 +127,52 @@ private:
     Optional<uint64_t> uint_value_;
   };
 
-  void walkDirectory(const std::string& path, const std::string& prefix);
+  typedef std::shared_ptr<const Entry> EntrySharedPtr;
+
+  // The entry read from a file, and the size and modification time of the file at the time.
+  struct FileEntry {
+    EntrySharedPtr entry_;
+    off_t size_;
+    time_t modified_;
+    // Whether the file was last modified long enough before it was read that a later change is
+    // guaranteed to move its modification time.
+    bool reusable_;
+  };
+
+  bool enabled(uint64_t value, uint64_t random_value, uint16_t num_buckets) const {
+    return random_value % static_cast<uint64_t>(num_buckets) <
+           std::min(value, static_cast<uint64_t>(num_buckets));
+  }
+
+  bool enabled(uint64_t value) const {
+    // Avoid PNRG if we know we don't need it.
+    uint64_t cutoff = std::min(value, static_cast<uint64_t>(100));
+    if (cutoff == 0) {
+      return false;
+    } else if (cutoff == 100) {
+      return true;
+    } else {
+      return generator_.random() % 100 < cutoff;
+    }
+  }
 
-  std::unordered_map<std::string, Entry> values_;
+  const Entry* find(const std::string& key) const;
+  const Entry* find(const Key& key) const;
+  static const std::string& stringValue(const Entry* entry);
+  static uint64_t integerValue(const Entry* entry, uint64_t default_value);
+  void walkDirectory(const std::string& path, const std::string& prefix,
+                     const SnapshotImpl* previous);
+  EntrySharedPtr loadFile(const std::string& path, const struct stat& stat_result,
+                          const SnapshotImpl* previous);
+
+  std::unordered_map<std::string, EntrySharedPtr> values_;
+  // Keyed by the path of the file.
+  std::unordered_map<std::string, FileEntry> files_;
+  // The entries of the keys that existed when the snapshot was loaded, indexed by Key::index().
+  // Keys created later are looked up by name.
+  std::vector<const Entry*> keys_;
+  RuntimeStats& stats_;
+  const time_t load_time_;
   RandomGenerator& generator_;
   Api::OsSysCalls& os_sys_calls_;
 };
@@ -163,6 +222,9 @@ private:
     NullSnapshotImpl(RandomGenerator& generator) : generator_(generator) {}
 
     // Runtime::Snapshot
+    using Snapshot::featureEnabled;
+    using Snapshot::get;
+    using Snapshot::getInteger;
     bool featureEnabled(const std::string&, uint64_t default_value, uint64_t random_value,
                         uint16_t num_buckets) const override {
       return random_value % static_cast<uint64_t>(num_buckets) <
@@ -130,17 +130,40 @@ ServerContextConfigImpl::ServerContextConfigImpl(const envoy::api::v2::Downstrea
                                            config.session_ticket_keys_type_case()));
         }
 
+        return ret;
+      }()),
+      session_ticket_key_files_([&config] {
+        std::vector<std::string> ret;
+        if (config.session_ticket_keys_type_case() ==
+            envoy::api::v2::DownstreamTlsContext::kSessionTicketKeys) {
+          for (const auto& datasource : config.session_ticket_keys().keys()) {
+            if (datasource.specifier_case() != envoy::api::v2::DataSource::kFilename) {
+              return std::vector<std::string>{};
+            }
+            ret.push_back(datasource.filename());
+          }
+        }
+        return ret;
+      }()),
+      additional_certificates_([&config] {
+        std::vector<CertificateFiles> ret;
+        const auto& certificates = config.common_tls_context().tls_certificates();
+        for (int i = 1; i < certificates.size(); i++) {
+          ret.push_back({certificates[i].certificate_chain().filename(),
+                         certificates[i].private_key().filename()});
+        }
         return ret;
       }()) {
-  // TODO(PiotrSikora): Support multiple TLS certificates.
   // TODO(mattklein123): All of the ASSERTs in this file need to be converted to exceptions with
   //                     proper error handling.
   // TODO(htuch): Support inline cert material delivery.
-  ASSERT(config.common_tls_context().tls_certificates().size() == 1);
-  ASSERT(config.common_tls_context().tls_certificates()[0].certificate_chain().specifier_case() ==
-         envoy::api::v2::DataSource::kFilename);
-  ASSERT(config.common_tls_context().tls_certificates()[0].private_key().specifier_case() ==
-         envoy::api::v2::DataSource::kFilename);
+  const auto& certificates = config.common_tls_context().tls_certificates();
+  ASSERT(certificates.size() >= 1);
+  for (int i = 0; i < certificates.size(); i++) {
+    ASSERT(certificates[i].certificate_chain().specifier_case() ==
+           envoy::api::v2::DataSource::kFilename);
+    ASSERT(certificates[i].private_key().specifier_case() == envoy::api::v2::DataSource::kFilename);
+  }
 }
 
 ServerContextConfigImpl::ServerContextConfigImpl(const Json::Object& config)
@@ -150,6 +173,15 @@ ServerContextConfigImpl::ServerContextConfigImpl(const Json::Object& config)
         return downstream_tls_context;
       }()) {}
 
+std::vector<ServerContextConfig::SessionTicketKey>
+ServerContextConfigImpl::readSessionTicketKeys(const std::vector<std::string>& files) {
+  std::vector<SessionTicketKey> keys;
+  for (const std::string& file : files) {
+    validateAndAppendKey(keys, Filesystem::fileReadToEnd(file));
+  }
+  return keys;
+}
+
 // Append a SessionTicketKey to keys, initializing it with key_data.
 // Throws if key_data is invalid.
 void ServerContextConfigImpl::validateAndAppendKey(
@@ -74,10 +74,24 @@ public:
   const std::vector<SessionTicketKey>& sessionTicketKeys() const override {
     return session_ticket_keys_;
   }
+  const std::vector<std::string>& sessionTicketKeyFiles() const override {
+    return session_ticket_key_files_;
+  }
+  const std::vector<CertificateFiles>& additionalCertificates() const override {
+    return additional_certificates_;
+  }
+
+  /**
+   * Read session ticket keys from files, one key per file.
+   * Throws if any of the files cannot be read or does not hold a valid key.
+   */
+  static std::vector<SessionTicketKey> readSessionTicketKeys(const std::vector<std::string>& files);
 
 private:
   const bool require_client_certificate_;
   const std::vector<SessionTicketKey> session_ticket_keys_;
+  const std::vector<std::string> session_ticket_key_files_;
+  const std::vector<CertificateFiles> additional_certificates_;
 
   static void validateAndAppendKey(std::vector<ServerContextConfig::SessionTicketKey>& keys,
                                    const std::string& key_data);
@@ -1,6 +1,9 @@
 #include "common/ssl/context_impl.h"
 
 #include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iterator>
 #include <memory>
 #include <string>
 #include <vector>
@@ -10,10 +13,15 @@
 
 #include "common/common/assert.h"
 #include "common/common/hex.h"
+#include "common/common/utility.h"
+#include "common/ssl/context_config_impl.h"
 
 #include "fmt/format.h"
+#include "openssl/err.h"
 #include "openssl/hmac.h"
+#include "openssl/pem.h"
 #include "openssl/rand.h"
+#include "openssl/sha.h"
 #include "openssl/x509v3.h"
 
 namespace Envoy {
@@ -27,6 +35,26 @@ int ContextImpl::sslContextIndex() {
   }());
 }
 
+static int sslPrivateKeyConnectionIndex() {
+  CONSTRUCT_ON_FIRST_USE(int, []() -> int {
+    int ssl_private_key_connection_index =
+        SSL_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+    RELEASE_ASSERT(ssl_private_key_connection_index >= 0);
+    return ssl_private_key_connection_index;
+  }());
+}
+
+PrivateKeyConnection::PrivateKeyConnection(SSL* ssl, Event::Dispatcher& dispatcher,
+                                           PrivateKeyOperationCallbacks& callbacks)
+    : dispatcher_(dispatcher), callbacks_(callbacks) {
+  int rc = SSL_set_ex_data(ssl, sslPrivateKeyConnectionIndex(), this);
+  RELEASE_ASSERT(rc == 1);
+}
+
+PrivateKeyConnection* PrivateKeyConnection::get(SSL* ssl) {
+  return static_cast<PrivateKeyConnection*>(SSL_get_ex_data(ssl, sslPrivateKeyConnectionIndex()));
+}
+
 ContextImpl::ContextImpl(ContextManagerImpl& parent, Stats::Scope& scope,
                          const ContextConfig& config)
     : parent_(parent), ctx_(SSL_CTX_new(TLS_method())), scope_(scope), stats_(generateStats(scope)),
@@ -106,6 +134,74 @@ ContextImpl::ContextImpl(ContextManagerImpl& parent, Stats::Scope& scope,
   parsed_alpn_protocols_ = parseAlpnProtocols(config.alpnProtocols());
 }
 
+const SSL_PRIVATE_KEY_METHOD& ServerContextImpl::privateKeyMethod() {
+  CONSTRUCT_ON_FIRST_USE(SSL_PRIVATE_KEY_METHOD, []() -> SSL_PRIVATE_KEY_METHOD {
+    SSL_PRIVATE_KEY_METHOD method{};
+    method.sign = [](SSL* ssl, uint8_t*, size_t*, size_t, uint16_t signature_algorithm,
+                     const uint8_t* in, size_t in_len) -> ssl_private_key_result_t {
+      return startPrivateKeyOperation(
+          ssl, [&](PrivateKeyMethodProvider& provider, EVP_PKEY& key,
+                   PrivateKeyConnection& connection) -> PrivateKeyOperationPtr {
+            return provider.sign(key, signature_algorithm, in, in_len, connection.dispatcher_,
+                                 connection.callbacks_);
+          });
+    };
+    method.decrypt = [](SSL* ssl, uint8_t*, size_t*, size_t, const uint8_t* in,
+                        size_t in_len) -> ssl_private_key_result_t {
+      return startPrivateKeyOperation(
+          ssl, [&](PrivateKeyMethodProvider& provider, EVP_PKEY& key,
+                   PrivateKeyConnection& connection) -> PrivateKeyOperationPtr {
+            return provider.decrypt(key, in, in_len, connection.dispatcher_,
+                                    connection.callbacks_);
+          });
+    };
+    method.complete = privateKeyComplete;
+    return method;
+  }());
+}
+
+ssl_private_key_result_t
+ServerContextImpl::startPrivateKeyOperation(SSL* ssl, PrivateKeyOperationStartCb start) {
+  // The context may have been switched by SNI, so the key is that of the current one.
+  SSL_CTX* ctx = SSL_get_SSL_CTX(ssl);
+  ContextImpl* context_impl =
+      static_cast<ContextImpl*>(SSL_CTX_get_ex_data(ctx, sslContextIndex()));
+  PrivateKeyConnection* connection = PrivateKeyConnection::get(ssl);
+  // The key of the connection differs from that of the context if an additional certificate was
+  // selected for the client.
+  EVP_PKEY* key = SSL_get_privatekey(ssl);
+  if (connection == nullptr || key == nullptr) {
+    return ssl_private_key_failure;
+  }
+
+  ASSERT(connection->operation_ == nullptr);
+  connection->operation_ = start(*context_impl->privateKeyMethodProvider(), *key, *connection);
+  return connection->operation_ != nullptr ? ssl_private_key_retry : ssl_private_key_failure;
+}
+
+ssl_private_key_result_t ServerContextImpl::privateKeyComplete(SSL* ssl, uint8_t* out,
+                                                               size_t* out_len, size_t max_out) {
+  PrivateKeyConnection* connection = PrivateKeyConnection::get(ssl);
+  if (connection == nullptr || connection->operation_ == nullptr) {
+    return ssl_private_key_failure;
+  }
+
+  // The handshake is also driven by I/O on the connection while the operation runs.
+  if (!connection->operation_->completed()) {
+    return ssl_private_key_retry;
+  }
+
+  PrivateKeyOperationPtr operation = std::move(connection->operation_);
+  const std::vector<uint8_t>* output = operation->output();
+  if (output == nullptr || output->size() > max_out) {
+    return ssl_private_key_failure;
+  }
+
+  memcpy(out, output->data(), output->size());
+  *out_len = output->size();
+  return ssl_private_key_success;
+}
+
 int ServerContextImpl::alpnSelectCallback(const unsigned char** out, unsigned char* outlen,
                                           const unsigned char* in, unsigned int inlen) {
   // Currently this uses the standard selection algorithm in priority order.
@@ -158,6 +254,18 @@ bssl::UniquePtr<SSL> ContextImpl::newSsl() const {
 
 int ContextImpl::verifyCallback(X509_STORE_CTX* store_ctx, void* arg) {
   ContextImpl* impl = reinterpret_cast<ContextImpl*>(arg);
+  SSL* ssl = reinterpret_cast<SSL*>(
+      X509_STORE_CTX_get_ex_data(store_ctx, SSL_get_ex_data_X509_STORE_CTX_idx()));
+  bssl::UniquePtr<X509> cert(SSL_get_peer_certificate(ssl));
+
+  std::string digest;
+  if (cert != nullptr) {
+    digest = peerCertificatesDigest(ssl, cert.get());
+    if (impl->verifiedPeerCertificates(digest)) {
+      impl->stats_.verify_cache_hit_.inc();
+      return 1;
+    }
+  }
 
   int ret = X509_verify_cert(store_ctx);
   if (ret <= 0) {
@@ -165,10 +273,93 @@ int ContextImpl::verifyCallback(X509_STORE_CTX* store_ctx, void* arg) {
     return ret;
   }
 
-  SSL* ssl = reinterpret_cast<SSL*>(
-      X509_STORE_CTX_get_ex_data(store_ctx, SSL_get_ex_data_X509_STORE_CTX_idx()));
-  bssl::UniquePtr<X509> cert(SSL_get_peer_certificate(ssl));
-  return impl->verifyCertificate(cert.get());
+  ret = impl->verifyCertificate(cert.get());
+  if (ret == 1 && cert != nullptr) {
+    impl->addVerifiedPeerCertificates(digest, ssl, cert.get());
+  }
+  return ret;
+}
+
+std::string ContextImpl::peerCertificatesDigest(SSL* ssl, X509* cert) {
+  // The chain that the peer sent goes into the digest along with its certificate, since the
+  // result of building a chain to a trusted CA depends on it. Clients see the certificate of the
+  // server at the front of the chain, servers do not see the one of the client in there.
+  uint8_t digest[SHA256_DIGEST_LENGTH];
+  unsigned digest_len;
+  SHA256_CTX sha256;
+  SHA256_Init(&sha256);
+  int rc = X509_digest(cert, EVP_sha256(), digest, &digest_len);
+  RELEASE_ASSERT(rc == 1 && digest_len == SHA256_DIGEST_LENGTH);
+  SHA256_Update(&sha256, digest, digest_len);
+
+  STACK_OF(X509)* chain = SSL_get_peer_cert_chain(ssl);
+  for (size_t i = 0; chain != nullptr && i < sk_X509_num(chain); i++) {
+    rc = X509_digest(sk_X509_value(chain, i), EVP_sha256(), digest, &digest_len);
+    RELEASE_ASSERT(rc == 1 && digest_len == SHA256_DIGEST_LENGTH);
+    SHA256_Update(&sha256, digest, digest_len);
+  }
+  UNREFERENCED_PARAMETER(rc);
+
+  SHA256_Final(digest, &sha256);
+  return std::string(reinterpret_cast<const char*>(digest), sizeof(digest));
+}
+
+bool ContextImpl::verifiedPeerCertificates(const std::string& digest) {
+  std::unique_lock<std::mutex> lock(verify_cache_lock_);
+  auto it = verify_cache_.find(digest);
+  if (it == verify_cache_.end()) {
+    return false;
+  }
+  if (it->second <= ProdMonotonicTimeSource::instance_.currentTime()) {
+    verify_cache_.erase(it);
+    return false;
+  }
+  return true;
+}
+
+void ContextImpl::addVerifiedPeerCertificates(const std::string& digest, SSL* ssl, X509* cert) {
+  const Runtime::Snapshot& snapshot = parent_.runtime().snapshot();
+  const uint64_t max_entries = snapshot.getInteger("ssl.verify_cache.max_entries", 1024);
+  if (max_entries == 0) {
+    return;
+  }
+
+  // The result holds until the first of the certificates that it depends on expires. The CA
+  // certificate stands in for the chain that was built, which may hold more certificates than
+  // what the peer sent, and the TTL bounds the time until any other change is noticed.
+  int64_t valid_seconds = snapshot.getInteger("ssl.verify_cache.ttl_ms", 3600000) / 1000;
+  auto limit_validity = [&valid_seconds](const X509* cert) -> void {
+    int days, seconds;
+    if (!ASN1_TIME_diff(&days, &seconds, nullptr, X509_get_notAfter(cert))) {
+      valid_seconds = 0;
+      return;
+    }
+    valid_seconds = std::min<int64_t>(valid_seconds, days * 86400LL + seconds);
+  };
+  limit_validity(cert);
+  STACK_OF(X509)* chain = SSL_get_peer_cert_chain(ssl);
+  for (size_t i = 0; chain != nullptr && i < sk_X509_num(chain); i++) {
+    limit_validity(sk_X509_value(chain, i));
+  }
+  if (ca_cert_ != nullptr) {
+    limit_validity(ca_cert_.get());
+  }
+  if (valid_seconds <= 0) {
+    return;
+  }
+
+  const MonotonicTime now = ProdMonotonicTimeSource::instance_.currentTime();
+  std::unique_lock<std::mutex> lock(verify_cache_lock_);
+  if (verify_cache_.size() >= max_entries) {
+    // Make room by dropping the expired results, and everything if that is not enough.
+    for (auto it = verify_cache_.begin(); it != verify_cache_.end();) {
+      it = it->second <= now ? verify_cache_.erase(it) : std::next(it);
+    }
+    if (verify_cache_.size() >= max_entries) {
+      verify_cache_.clear();
+    }
+  }
+  verify_cache_[digest] = now + std::chrono::seconds(valid_seconds);
 }
 
 int ContextImpl::verifyCertificate(X509* cert) {
@@ -367,7 +558,10 @@ ServerContextImpl::ServerContextImpl(ContextManagerImpl& parent, const std::stri
                                      bool skip_context_update, Runtime::Loader& runtime)
     : ContextImpl(parent, scope, config), listener_name_(listener_name),
       server_names_(server_names), skip_context_update_(skip_context_update), runtime_(runtime),
-      session_ticket_keys_(config.sessionTicketKeys()) {
+      session_ticket_key_files_(config.sessionTicketKeyFiles()),
+      session_ticket_keys_(
+          std::make_shared<const std::vector<ServerContextConfig::SessionTicketKey>>(
+              config.sessionTicketKeys())) {
   SSL_CTX_set_select_certificate_cb(
       ctx_.get(), [](const SSL_CLIENT_HELLO* client_hello) -> ssl_select_cert_result_t {
         ContextImpl* context_impl = static_cast<ContextImpl*>(
@@ -390,6 +584,10 @@ ServerContextImpl::ServerContextImpl(ContextManagerImpl& parent, const std::stri
 
   parsed_alt_alpn_protocols_ = parseAlpnProtocols(config.altAlpnProtocols());
 
+  if (privateKeyMethodProvider() != nullptr) {
+    SSL_CTX_set_private_key_method(ctx_.get(), &privateKeyMethod());
+  }
+
   if (!parsed_alpn_protocols_.empty()) {
     SSL_CTX_set_alpn_select_cb(ctx_.get(),
                                [](SSL*, const unsigned char** out, unsigned char* outlen,
@@ -400,7 +598,7 @@ ServerContextImpl::ServerContextImpl(ContextManagerImpl& parent, const std::stri
                                this);
   }
 
-  if (!session_ticket_keys_.empty()) {
+  if (!session_ticket_keys_->empty()) {
     SSL_CTX_set_tlsext_ticket_key_cb(
         ctx_.get(),
         [](SSL* ssl, uint8_t* key_name, uint8_t* iv, EVP_CIPHER_CTX* ctx, HMAC_CTX* hmac_ctx,
@@ -414,6 +612,20 @@ ServerContextImpl::ServerContextImpl(ContextManagerImpl& parent, const std::stri
         });
   }
 
+  for (const auto& files : config.additionalCertificates()) {
+    additional_certificates_.push_back(loadCertificate(files));
+  }
+
+  if (runtime_.snapshot().getInteger("ssl.session_cache.max_entries", 0) > 0) {
+    enableSessionCache();
+  }
+
+  // 0-RTT saves resumed TLS 1.3 clients a round trip, but their first flight can be replayed. HTTP
+  // requests that arrive in it are marked with the early-data header so upstreams can refuse them.
+  if (runtime_.snapshot().featureEnabled("ssl.early_data", 0)) {
+    SSL_CTX_set_early_data_enabled(ctx_.get(), 1);
+  }
+
   uint8_t session_context_buf[EVP_MAX_MD_SIZE] = {};
   unsigned session_context_len = 0;
   EVP_MD_CTX md;
@@ -501,6 +713,7 @@ ServerContextImpl::ServerContextImpl(ContextManagerImpl& parent, const std::stri
 ssl_select_cert_result_t
 ServerContextImpl::processClientHello(const SSL_CLIENT_HELLO* client_hello) {
   if (skip_context_update_) {
+    selectCertificate(client_hello);
     return ssl_select_cert_success;
   }
 
@@ -535,14 +748,126 @@ ServerContextImpl::processClientHello(const SSL_CLIENT_HELLO* client_hello) {
   }
 
   // Update context if it changed.
-  if (new_ctx != this) {
-    ServerContextImpl* new_impl = dynamic_cast<ServerContextImpl*>(new_ctx);
+  ServerContextImpl* new_impl = dynamic_cast<ServerContextImpl*>(new_ctx);
+  if (new_impl != this) {
     new_impl->updateConnectionContext(client_hello->ssl);
   }
 
+  new_impl->selectCertificate(client_hello);
   return ssl_select_cert_success;
 }
 
+void ServerContextImpl::selectCertificate(const SSL_CLIENT_HELLO* client_hello) {
+  if (additional_certificates_.empty()) {
+    return;
+  }
+
+  // Only ECDSA keys depend on the client, every client supports RSA.
+  const bool ecdsa = clientSupportsEcdsa(client_hello);
+  auto supported = [ecdsa](EVP_PKEY* key) { return ecdsa || EVP_PKEY_id(key) != EVP_PKEY_EC; };
+  if (supported(SSL_CTX_get0_privatekey(ctx_.get()))) {
+    return;
+  }
+
+  SSL* ssl = client_hello->ssl;
+  for (const Certificate& certificate : additional_certificates_) {
+    if (supported(certificate.private_key_.get())) {
+      // The key is dropped if it does not match the new certificate, so it is set last.
+      int rc = SSL_use_certificate(ssl, certificate.cert_.get());
+      RELEASE_ASSERT(rc == 1);
+      rc = SSL_set1_chain(ssl, certificate.chain_.get());
+      RELEASE_ASSERT(rc == 1);
+      rc = SSL_use_PrivateKey(ssl, certificate.private_key_.get());
+      RELEASE_ASSERT(rc == 1);
+      return;
+    }
+  }
+}
+
+bool ServerContextImpl::clientSupportsEcdsa(const SSL_CLIENT_HELLO* client_hello) {
+  // TLS 1.3 clients offer cipher suites without an authentication method, and support ECDSA if
+  // they offer one of its signature algorithms. Older clients also have to offer an ECDSA cipher
+  // suite.
+  const uint8_t* data;
+  size_t len;
+  bool ecdsa_cipher = SSL_early_callback_ctx_extension_get(
+      client_hello, TLSEXT_TYPE_supported_versions, &data, &len);
+  CBS cipher_suites;
+  CBS_init(&cipher_suites, client_hello->cipher_suites, client_hello->cipher_suites_len);
+  while (!ecdsa_cipher && CBS_len(&cipher_suites) > 0) {
+    uint16_t id;
+    if (!CBS_get_u16(&cipher_suites, &id)) {
+      return false;
+    }
+    const SSL_CIPHER* cipher = SSL_get_cipher_by_value(id);
+    ecdsa_cipher = cipher != nullptr && strstr(SSL_CIPHER_get_name(cipher), "-ECDSA-") != nullptr;
+  }
+  if (!ecdsa_cipher) {
+    return false;
+  }
+
+  // Clients that do not send signature algorithms support ECDSA with SHA-1 if they offer an ECDSA
+  // cipher suite (RFC 5246, section 7.4.1.4.1). The certificates are expected to be on P-256,
+  // which all clients that support ECDSA support.
+  if (!SSL_early_callback_ctx_extension_get(client_hello, TLSEXT_TYPE_signature_algorithms, &data,
+                                            &len)) {
+    return true;
+  }
+  CBS extension, signature_algorithms;
+  CBS_init(&extension, data, len);
+  if (!CBS_get_u16_length_prefixed(&extension, &signature_algorithms)) {
+    return false;
+  }
+  while (CBS_len(&signature_algorithms) > 0) {
+    uint16_t signature_algorithm;
+    if (!CBS_get_u16(&signature_algorithms, &signature_algorithm)) {
+      return false;
+    }
+    switch (signature_algorithm) {
+    case SSL_SIGN_ECDSA_SHA1:
+    case SSL_SIGN_ECDSA_SECP256R1_SHA256:
+    case SSL_SIGN_ECDSA_SECP384R1_SHA384:
+    case SSL_SIGN_ECDSA_SECP521R1_SHA512:
+      return true;
+    default:
+      break;
+    }
+  }
+  return false;
+}
+
+ServerContextImpl::Certificate
+ServerContextImpl::loadCertificate(const ServerContextConfig::CertificateFiles& files) {
+  Certificate certificate;
+  bssl::UniquePtr<BIO> bio(BIO_new_file(files.cert_chain_file_.c_str(), "r"));
+  if (bio != nullptr) {
+    certificate.cert_.reset(PEM_read_bio_X509_AUX(bio.get(), nullptr, nullptr, nullptr));
+  }
+  if (certificate.cert_ == nullptr) {
+    throw EnvoyException(
+        fmt::format("Failed to load certificate chain file {}", files.cert_chain_file_));
+  }
+  certificate.chain_.reset(sk_X509_new_null());
+  RELEASE_ASSERT(certificate.chain_ != nullptr);
+  while (X509* intermediate = PEM_read_bio_X509(bio.get(), nullptr, nullptr, nullptr)) {
+    sk_X509_push(certificate.chain_.get(), intermediate);
+  }
+  // Reading stops at the end of the file, which leaves an error behind.
+  ERR_clear_error();
+
+  bio.reset(BIO_new_file(files.private_key_file_.c_str(), "r"));
+  if (bio != nullptr) {
+    certificate.private_key_.reset(PEM_read_bio_PrivateKey(bio.get(), nullptr, nullptr, nullptr));
+  }
+  if (certificate.private_key_ == nullptr ||
+      !X509_check_private_key(certificate.cert_.get(), certificate.private_key_.get())) {
+    ERR_clear_error();
+    throw EnvoyException(
+        fmt::format("Failed to load private key file {}", files.private_key_file_));
+  }
+  return certificate;
+}
+
 void ServerContextImpl::updateConnectionContext(SSL* ssl) {
   ASSERT(ctx_);
 
@@ -566,19 +891,98 @@ void ServerContextImpl::updateConnectionContext(SSL* ssl) {
   UNREFERENCED_PARAMETER(rc);
 }
 
+void ServerContextImpl::enableSessionCache() {
+  // Sessions are kept in the cache of the manager, which is shared by the server contexts of all
+  // listeners and outlives them, instead of in a cache of this context. Without configured keys,
+  // tickets would be encrypted with keys that are random to this context and be lost with it, so
+  // they are turned off in favor of the shared cache.
+  SSL_CTX_set_session_cache_mode(ctx_.get(), SSL_SESS_CACHE_SERVER | SSL_SESS_CACHE_NO_INTERNAL);
+  if (session_ticket_keys_->empty()) {
+    SSL_CTX_set_options(ctx_.get(), SSL_OP_NO_TICKET);
+  }
+
+  SSL_CTX_sess_set_new_cb(ctx_.get(), [](SSL* ssl, SSL_SESSION* session) -> int {
+    ContextImpl* context_impl =
+        static_cast<ContextImpl*>(SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), sslContextIndex()));
+    unsigned id_len;
+    const uint8_t* id = SSL_SESSION_get_id(session, &id_len);
+    uint8_t* data;
+    size_t data_len;
+    if (SSL_SESSION_to_bytes(session, &data, &data_len)) {
+      context_impl->sessionCache().insert(
+          std::string(reinterpret_cast<const char*>(id), id_len),
+          std::string(reinterpret_cast<const char*>(data), data_len));
+      OPENSSL_free(data);
+    }
+    // The cache holds a copy, so the session is not taken.
+    return 0;
+  });
+
+  SSL_CTX_sess_set_get_cb(
+      ctx_.get(), [](SSL* ssl, const uint8_t* id, int id_len, int* out_copy) -> SSL_SESSION* {
+        ContextImpl* context_impl = static_cast<ContextImpl*>(
+            SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), sslContextIndex()));
+        std::string data;
+        *out_copy = 0;
+        if (!context_impl->sessionCache().lookup(
+                std::string(reinterpret_cast<const char*>(id), id_len), data)) {
+          return nullptr;
+        }
+        // A session of another context is rejected by its session ID context, and an expired one
+        // by its timeout, after which it is removed through the callback below.
+        return SSL_SESSION_from_bytes(reinterpret_cast<const uint8_t*>(data.data()), data.size(),
+                                      SSL_get_SSL_CTX(ssl));
+      });
+
+  SSL_CTX_sess_set_remove_cb(ctx_.get(), [](SSL_CTX* ctx, SSL_SESSION* session) -> void {
+    ContextImpl* context_impl =
+        static_cast<ContextImpl*>(SSL_CTX_get_ex_data(ctx, sslContextIndex()));
+    unsigned id_len;
+    const uint8_t* id = SSL_SESSION_get_id(session, &id_len);
+    context_impl->sessionCache().remove(std::string(reinterpret_cast<const char*>(id), id_len));
+  });
+}
+
+bool ServerContextImpl::usesSessionTicketKeyFile(const std::string& file) const {
+  return std::find(session_ticket_key_files_.begin(), session_ticket_key_files_.end(), file) !=
+         session_ticket_key_files_.end();
+}
+
+void ServerContextImpl::reloadSessionTicketKeys() {
+  SessionTicketKeysConstSharedPtr keys;
+  try {
+    keys = std::make_shared<const std::vector<ServerContextConfig::SessionTicketKey>>(
+        ServerContextConfigImpl::readSessionTicketKeys(session_ticket_key_files_));
+  } catch (const EnvoyException& e) {
+    ENVOY_LOG(warn, "failed to reload TLS session ticket keys: {}", e.what());
+    stats_.session_ticket_keys_reload_failed_.inc();
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock(session_ticket_keys_lock_);
+  session_ticket_keys_ = keys;
+  stats_.session_ticket_keys_reloaded_.inc();
+}
+
+ServerContextImpl::SessionTicketKeysConstSharedPtr ServerContextImpl::sessionTicketKeys() {
+  std::unique_lock<std::mutex> lock(session_ticket_keys_lock_);
+  return session_ticket_keys_;
+}
+
 int ServerContextImpl::sessionTicketProcess(SSL*, uint8_t* key_name, uint8_t* iv,
                                             EVP_CIPHER_CTX* ctx, HMAC_CTX* hmac_ctx, int encrypt) {
   const EVP_MD* hmac = EVP_sha256();
   const EVP_CIPHER* cipher = EVP_aes_256_cbc();
+  const SessionTicketKeysConstSharedPtr session_ticket_keys = sessionTicketKeys();
 
   if (encrypt == 1) {
     // Encrypt
-    RELEASE_ASSERT(session_ticket_keys_.size() >= 1);
+    RELEASE_ASSERT(session_ticket_keys->size() >= 1);
     // TODO(ggreenway): validate in SDS that session_ticket_keys_ cannot be empty,
     // or if we allow it to be emptied, reconfigure the context so this callback
     // isn't set.
 
-    const ServerContextConfig::SessionTicketKey& key = session_ticket_keys_.front();
+    const ServerContextConfig::SessionTicketKey& key = session_ticket_keys->front();
 
     static_assert(std::tuple_size<decltype(key.name_)>::value == SSL_TICKET_KEY_NAME_LEN,
                   "Expected key.name length");
@@ -603,7 +1007,7 @@ int ServerContextImpl::sessionTicketProcess(SSL*, uint8_t* key_name, uint8_t* iv
   } else {
     // Decrypt
     bool is_enc_key = true; // first element is the encryption key
-    for (const ServerContextConfig::SessionTicketKey& key : session_ticket_keys_) {
+    for (const ServerContextConfig::SessionTicketKey& key : *session_ticket_keys) {
       static_assert(std::tuple_size<decltype(key.name_)>::value == SSL_TICKET_KEY_NAME_LEN,
                     "Expected key.name length");
       if (std::equal(key.name_.begin(), key.name_.end(), key_name)) {
@@ -1,14 +1,22 @@
 #pragma once
 
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
+#include "envoy/common/time.h"
+#include "envoy/event/dispatcher.h"
 #include "envoy/runtime/runtime.h"
 #include "envoy/ssl/context.h"
 #include "envoy/ssl/context_config.h"
+#include "envoy/ssl/private_key.h"
 #include "envoy/stats/stats.h"
 #include "envoy/stats/stats_macros.h"
 
+#include "common/common/logger.h"
 #include "common/ssl/context_impl.h"
 #include "common/ssl/context_manager_impl.h"
 
@@ -25,13 +33,18 @@ namespace Ssl {
 #define ALL_SSL_STATS(COUNTER, GAUGE, HISTOGRAM)                                                   \
   COUNTER(connection_error)                                                                        \
   COUNTER(handshake)                                                                               \
+  COUNTER(early_data_accepted)                                                                     \
+  COUNTER(kernel_tls_tx)                                                                           \
   COUNTER(session_reused)                                                                          \
+  COUNTER(session_ticket_keys_reloaded)                                                            \
+  COUNTER(session_ticket_keys_reload_failed)                                                       \
   COUNTER(no_certificate)                                                                          \
   COUNTER(fail_no_sni_match)                                                                       \
   COUNTER(fail_verify_no_cert)                                                                     \
   COUNTER(fail_verify_error)                                                                       \
   COUNTER(fail_verify_san)                                                                         \
-  COUNTER(fail_verify_cert_hash)
+  COUNTER(fail_verify_cert_hash)                                                                   \
+  COUNTER(verify_cache_hit)
 // clang-format on
 
 /**
@@ -41,6 +54,25 @@ struct SslStats {
   ALL_SSL_STATS(GENERATE_COUNTER_STRUCT, GENERATE_GAUGE_STRUCT, GENERATE_HISTOGRAM_STRUCT)
 };
 
+/**
+ * The asynchronous private key operation of the handshake on an SSL instance. The owner of an
+ * instance whose contexts have a PrivateKeyMethodProvider attaches one to the instance, and keeps
+ * it for as long as the instance.
+ */
+struct PrivateKeyConnection {
+  PrivateKeyConnection(SSL* ssl, Event::Dispatcher& dispatcher,
+                       PrivateKeyOperationCallbacks& callbacks);
+
+  /**
+   * @return PrivateKeyConnection* the one attached to an SSL instance, or nullptr if there is none.
+   */
+  static PrivateKeyConnection* get(SSL* ssl);
+
+  Event::Dispatcher& dispatcher_;
+  PrivateKeyOperationCallbacks& callbacks_;
+  PrivateKeyOperationPtr operation_;
+};
+
 class ContextImpl : public virtual Context {
 public:
   virtual bssl::UniquePtr<SSL> newSsl() const;
@@ -70,6 +102,27 @@ public:
 
   SslStats& stats() { return stats_; }
 
+  /**
+   * @return PrivateKeyMethodProvider* the provider that runs the private key operations of server
+   *         handshakes, or nullptr if they run inline.
+   */
+  PrivateKeyMethodProvider* privateKeyMethodProvider() const {
+    return parent_.privateKeyMethodProvider();
+  }
+
+  /**
+   * @return SessionCache& the session cache shared by all server contexts.
+   */
+  SessionCache& sessionCache() { return parent_.sessionCache(); }
+
+  /**
+   * @return bool whether connections should hand the encryption of their writes to the kernel
+   *         once their handshake completes, where the kernel and the negotiated cipher allow it.
+   */
+  bool kernelTlsEnabled() const {
+    return parent_.runtime().snapshot().featureEnabled("ssl.kernel_tls_tx", 0);
+  }
+
   // Ssl::Context
   size_t daysUntilFirstCertExpires() const override;
   std::string getCaCertInformation() const override;
@@ -87,6 +140,21 @@ protected:
   static int verifyCallback(X509_STORE_CTX* store_ctx, void* arg);
   int verifyCertificate(X509* cert);
 
+  /**
+   * @return std::string the SHA-256 digest of the certificate and the certificate chain that the
+   *         peer sent, which identifies the input of a verification.
+   */
+  static std::string peerCertificatesDigest(SSL* ssl, X509* cert);
+
+  /**
+   * Successful verifications are cached by the digest of the certificates of the peer, so that
+   * handshakes with the same peers skip building and checking the chain, and matching the subject
+   * alt names and hashes. The ssl.verify_cache.max_entries and ssl.verify_cache.ttl_ms runtime keys
+   * bound the number of results and how long they are kept.
+   */
+  bool verifiedPeerCertificates(const std::string& digest);
+  void addVerifiedPeerCertificates(const std::string& digest, SSL* ssl, X509* cert);
+
   /**
    * Verifies certificate hash for pinning. The hash is the SHA-256 has of the DER encoding of the
    * certificate.
@@ -118,6 +186,9 @@ protected:
   bssl::UniquePtr<X509> cert_chain_;
   std::string ca_file_path_;
   std::string cert_chain_file_path_;
+  // Shared by the handshakes on all workers.
+  std::mutex verify_cache_lock_;
+  std::unordered_map<std::string, MonotonicTime> verify_cache_;
   const uint16_t min_protocol_version_;
   const uint16_t max_protocol_version_;
   const std::string ecdh_curves_;
@@ -135,7 +206,9 @@ private:
   std::string server_name_indication_;
 };
 
-class ServerContextImpl : public ContextImpl, public ServerContext {
+class ServerContextImpl : public ContextImpl,
+                          public ServerContext,
+                          protected Logger::Loggable<Logger::Id::config> {
 public:
   ServerContextImpl(ContextManagerImpl& parent, const std::string& listener_name,
                     const std::vector<std::string>& server_names, Stats::Scope& scope,
@@ -143,10 +216,52 @@ public:
                     Runtime::Loader& runtime);
   ~ServerContextImpl() { parent_.releaseServerContext(this, listener_name_, server_names_); }
 
+  /**
+   * @return bool whether the session ticket keys of the context are read from a file.
+   */
+  bool usesSessionTicketKeyFile(const std::string& file) const;
+
+  /**
+   * Read the session ticket keys from their files again. The current keys stay in use if any of
+   * the files cannot be read or does not hold a valid key.
+   */
+  void reloadSessionTicketKeys();
+
 private:
+  typedef std::shared_ptr<const std::vector<ServerContextConfig::SessionTicketKey>>
+      SessionTicketKeysConstSharedPtr;
+
+  typedef std::function<PrivateKeyOperationPtr(PrivateKeyMethodProvider& provider, EVP_PKEY& key,
+                                               PrivateKeyConnection& connection)>
+      PrivateKeyOperationStartCb;
+
+  static const SSL_PRIVATE_KEY_METHOD& privateKeyMethod();
+  static ssl_private_key_result_t startPrivateKeyOperation(SSL* ssl,
+                                                           PrivateKeyOperationStartCb start);
+  static ssl_private_key_result_t privateKeyComplete(SSL* ssl, uint8_t* out, size_t* out_len,
+                                                     size_t max_out);
+
+  struct Certificate {
+    bssl::UniquePtr<X509> cert_;
+    // The intermediate certificates, without cert_.
+    bssl::UniquePtr<STACK_OF(X509)> chain_;
+    bssl::UniquePtr<EVP_PKEY> private_key_;
+  };
+
+  static Certificate loadCertificate(const ServerContextConfig::CertificateFiles& files);
+  static bool clientSupportsEcdsa(const SSL_CLIENT_HELLO* client_hello);
+
   ssl_select_cert_result_t processClientHello(const SSL_CLIENT_HELLO* client_hello);
   void updateConnectionContext(SSL* ssl);
 
+  /**
+   * Replace the certificate of the context on the connection with an additional one if the client
+   * does not support the key type of the former but does support that of the latter.
+   */
+  void selectCertificate(const SSL_CLIENT_HELLO* client_hello);
+  void enableSessionCache();
+  SessionTicketKeysConstSharedPtr sessionTicketKeys();
+
   int alpnSelectCallback(const unsigned char** out, unsigned char* outlen, const unsigned char* in,
                          unsigned int inlen);
   int sessionTicketProcess(SSL* ssl, uint8_t* key_name, uint8_t* iv, EVP_CIPHER_CTX* ctx,
@@ -157,7 +272,11 @@ private:
   const bool skip_context_update_;
   Runtime::Loader& runtime_;
   std::vector<uint8_t> parsed_alt_alpn_protocols_;
-  const std::vector<ServerContextConfig::SessionTicketKey> session_ticket_keys_;
+  const std::vector<std::string> session_ticket_key_files_;
+  // Replaced when the keys are reloaded, while handshakes on workers hold on to the keys they use.
+  std::mutex session_ticket_keys_lock_;
+  SessionTicketKeysConstSharedPtr session_ticket_keys_;
+  std::vector<Certificate> additional_certificates_;
 };
 
 } // namespace Ssl
@@ -2,6 +2,7 @@
 
 #include <functional>
 #include <shared_mutex>
+#include <string>
 
 #include "common/common/assert.h"
 #include "common/common/empty_string.h"
@@ -89,9 +90,29 @@ ServerContextPtr ContextManagerImpl::createSslServerContext(
     }
   }
 
+  if (session_ticket_key_watcher_ != nullptr) {
+    for (const std::string& file : config.sessionTicketKeyFiles()) {
+      if (watched_session_ticket_key_files_.insert(file).second) {
+        session_ticket_key_watcher_->addWatch(
+            file, Filesystem::Watcher::Events::MovedTo,
+            [this, file](uint32_t) -> void { onSessionTicketKeyFileChanged(file); });
+      }
+    }
+  }
+
   return context;
 }
 
+void ContextManagerImpl::onSessionTicketKeyFileChanged(const std::string& file) {
+  std::shared_lock<std::shared_timed_mutex> lock(contexts_lock_);
+  for (Context* context : contexts_) {
+    ServerContextImpl* server_context = dynamic_cast<ServerContextImpl*>(context);
+    if (server_context != nullptr && server_context->usesSessionTicketKeyFile(file)) {
+      server_context->reloadSessionTicketKeys();
+    }
+  }
+}
+
 ServerContext* ContextManagerImpl::findSslServerContext(const std::string& listener_name,
                                                         const std::string& server_name) const {
   // Find Ssl::ServerContext to use. The algorithm for "www.example.com" is as follows:
@@ -4,9 +4,15 @@
 #include <list>
 #include <shared_mutex>
 #include <unordered_map>
+#include <unordered_set>
 
+#include "envoy/event/dispatcher.h"
+#include "envoy/filesystem/filesystem.h"
 #include "envoy/runtime/runtime.h"
 #include "envoy/ssl/context_manager.h"
+#include "envoy/ssl/private_key.h"
+
+#include "common/ssl/session_cache.h"
 
 namespace Envoy {
 namespace Ssl {
@@ -20,7 +26,10 @@ namespace Ssl {
  */
 class ContextManagerImpl final : public ContextManager {
 public:
-  ContextManagerImpl(Runtime::Loader& runtime) : runtime_(runtime) {}
+  ContextManagerImpl(Runtime::Loader& runtime,
+                     PrivateKeyMethodProviderPtr&& private_key_method_provider = nullptr)
+      : runtime_(runtime), private_key_method_provider_(std::move(private_key_method_provider)),
+        session_cache_(runtime) {}
   ~ContextManagerImpl();
 
   /**
@@ -32,6 +41,31 @@ public:
   void releaseServerContext(ServerContext* context, const std::string& listener_name,
                             const std::vector<std::string>& server_names);
 
+  /**
+   * @return PrivateKeyMethodProvider* the provider that runs the private key operations of server
+   *         handshakes, or nullptr if they run inline.
+   */
+  PrivateKeyMethodProvider* privateKeyMethodProvider() const {
+    return private_key_method_provider_.get();
+  }
+
+  Runtime::Loader& runtime() { return runtime_; }
+
+  /**
+   * @return SessionCache& the session cache shared by all server contexts.
+   */
+  SessionCache& sessionCache() { return session_cache_; }
+
+  /**
+   * Watch the files that the session ticket keys of server contexts are read from, and reload the
+   * keys of the contexts when one of their files is moved into place. Must be called before any
+   * server context is created, on the thread of the dispatcher, which is the thread that creates
+   * server contexts from then on.
+   */
+  void watchSessionTicketKeyFiles(Event::Dispatcher& dispatcher) {
+    session_ticket_key_watcher_ = dispatcher.createFilesystemWatcher();
+  }
+
   // Ssl::ContextManager
   Ssl::ClientContextPtr createSslClientContext(Stats::Scope& scope,
                                                const ClientContextConfig& config) override;
@@ -47,12 +81,18 @@ public:
 
 private:
   static bool isWildcardServerName(const std::string& name);
+  void onSessionTicketKeyFileChanged(const std::string& file);
 
   Runtime::Loader& runtime_;
+  const PrivateKeyMethodProviderPtr private_key_method_provider_;
   std::list<Context*> contexts_;
   mutable std::shared_timed_mutex contexts_lock_;
   std::unordered_map<std::string, std::unordered_map<std::string, ServerContext*>> map_exact_;
   std::unordered_map<std::string, std::unordered_map<std::string, ServerContext*>> map_wildcard_;
+  SessionCache session_cache_;
+  Filesystem::WatcherPtr session_ticket_key_watcher_;
+  // Watches cannot be removed, so files stay in here after the contexts that use them are gone.
+  std::unordered_set<std::string> watched_session_ticket_key_files_;
 };
 
 } // namespace Ssl
@@ -0,0 +1,156 @@
+#include "common/ssl/private_key_method_provider_impl.h"
+
+#include "common/common/assert.h"
+
+#include "openssl/evp.h"
+#include "openssl/rsa.h"
+
+namespace Envoy {
+namespace Ssl {
+
+ThreadPoolPrivateKeyMethodProvider::ThreadPoolPrivateKeyMethodProvider(uint32_t threads) {
+  ASSERT(threads > 0);
+  for (uint32_t i = 0; i < threads; i++) {
+    threads_.emplace_back(new Thread::Thread([this]() -> void { threadRoutine(); }));
+  }
+}
+
+ThreadPoolPrivateKeyMethodProvider::~ThreadPoolPrivateKeyMethodProvider() {
+  {
+    std::unique_lock<std::mutex> lock(lock_);
+    exit_ = true;
+    work_event_.notify_all();
+  }
+
+  for (Thread::ThreadPtr& thread : threads_) {
+    thread->join();
+  }
+}
+
+PrivateKeyOperationPtr ThreadPoolPrivateKeyMethodProvider::sign(
+    EVP_PKEY& key, uint16_t signature_algorithm, const uint8_t* in, size_t in_len,
+    Event::Dispatcher& dispatcher, PrivateKeyOperationCallbacks& callbacks) {
+  return start(std::make_shared<State>(key, false, signature_algorithm, in, in_len, dispatcher,
+                                       callbacks));
+}
+
+PrivateKeyOperationPtr
+ThreadPoolPrivateKeyMethodProvider::decrypt(EVP_PKEY& key, const uint8_t* in, size_t in_len,
+                                            Event::Dispatcher& dispatcher,
+                                            PrivateKeyOperationCallbacks& callbacks) {
+  return start(std::make_shared<State>(key, true, 0, in, in_len, dispatcher, callbacks));
+}
+
+PrivateKeyOperationPtr ThreadPoolPrivateKeyMethodProvider::start(StateSharedPtr state) {
+  std::unique_lock<std::mutex> lock(lock_);
+  pending_.push_back(state);
+  work_event_.notify_one();
+  return PrivateKeyOperationPtr{new Operation(state)};
+}
+
+void ThreadPoolPrivateKeyMethodProvider::threadRoutine() {
+  std::unique_lock<std::mutex> lock(lock_);
+  while (true) {
+    while (pending_.empty() && !exit_) {
+      work_event_.wait(lock);
+    }
+
+    if (exit_) {
+      return;
+    }
+
+    StateSharedPtr state = pending_.front();
+    pending_.pop_front();
+    lock.unlock();
+    state->run();
+    lock.lock();
+  }
+}
+
+bool ThreadPoolPrivateKeyMethodProvider::sign(EVP_PKEY& key, uint16_t signature_algorithm,
+                                              const std::vector<uint8_t>& in,
+                                              std::vector<uint8_t>& out) {
+  bssl::ScopedEVP_MD_CTX ctx;
+  EVP_PKEY_CTX* pkey_ctx;
+  if (!EVP_DigestSignInit(ctx.get(), &pkey_ctx,
+                          SSL_get_signature_algorithm_digest(signature_algorithm), nullptr,
+                          &key)) {
+    return false;
+  }
+
+  if (SSL_is_signature_algorithm_rsa_pss(signature_algorithm) &&
+      (!EVP_PKEY_CTX_set_rsa_padding(pkey_ctx, RSA_PKCS1_PSS_PADDING) ||
+       !EVP_PKEY_CTX_set_rsa_pss_saltlen(pkey_ctx, -1))) {
+    return false;
+  }
+
+  size_t out_len = EVP_PKEY_size(&key);
+  out.resize(out_len);
+  if (!EVP_DigestSign(ctx.get(), out.data(), &out_len, in.data(), in.size())) {
+    return false;
+  }
+  out.resize(out_len);
+  return true;
+}
+
+bool ThreadPoolPrivateKeyMethodProvider::decrypt(EVP_PKEY& key, const std::vector<uint8_t>& in,
+                                                 std::vector<uint8_t>& out) {
+  RSA* rsa = EVP_PKEY_get0_RSA(&key);
+  if (rsa == nullptr) {
+    return false;
+  }
+
+  size_t out_len;
+  out.resize(RSA_size(rsa));
+  if (!RSA_decrypt(rsa, &out_len, out.data(), out.size(), in.data(), in.size(), RSA_NO_PADDING)) {
+    return false;
+  }
+  out.resize(out_len);
+  return true;
+}
+
+ThreadPoolPrivateKeyMethodProvider::State::State(EVP_PKEY& key, bool decrypt,
+                                                 uint16_t signature_algorithm, const uint8_t* in,
+                                                 size_t in_len, Event::Dispatcher& dispatcher,
+                                                 PrivateKeyOperationCallbacks& callbacks)
+    : key_(&key), decrypt_(decrypt), signature_algorithm_(signature_algorithm),
+      input_(in, in + in_len), dispatcher_(dispatcher), callbacks_(callbacks) {
+  EVP_PKEY_up_ref(&key);
+}
+
+void ThreadPoolPrivateKeyMethodProvider::State::run() {
+  {
+    std::unique_lock<std::mutex> lock(lock_);
+    if (cancelled_) {
+      return;
+    }
+  }
+
+  succeeded_ = decrypt_ ? ThreadPoolPrivateKeyMethodProvider::decrypt(*key_, input_, output_)
+                        : ThreadPoolPrivateKeyMethodProvider::sign(*key_, signature_algorithm_,
+                                                                   input_, output_);
+
+  // The dispatcher outlives the operation, which is cancelled before it is destroyed.
+  std::unique_lock<std::mutex> lock(lock_);
+  if (!cancelled_) {
+    StateSharedPtr self = shared_from_this();
+    dispatcher_.post([self]() -> void { self->complete(); });
+  }
+}
+
+void ThreadPoolPrivateKeyMethodProvider::State::complete() {
+  if (cancelled_) {
+    return;
+  }
+
+  completed_ = true;
+  callbacks_.onPrivateKeyOperationComplete();
+}
+
+ThreadPoolPrivateKeyMethodProvider::Operation::~Operation() {
+  std::unique_lock<std::mutex> lock(state_->lock_);
+  state_->cancelled_ = true;
+}
+
+} // namespace Ssl
+} // namespace Envoy
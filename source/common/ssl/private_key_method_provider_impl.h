@@ -0,0 +1,100 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "envoy/event/dispatcher.h"
+#include "envoy/ssl/private_key.h"
+
+#include "common/common/thread.h"
+
+#include "openssl/ssl.h"
+
+namespace Envoy {
+namespace Ssl {
+
+/**
+ * A PrivateKeyMethodProvider that runs private key operations on threads of its own and posts
+ * their completion to the dispatchers of the connections. Operations that are still queued when
+ * the provider is destroyed never complete.
+ */
+class ThreadPoolPrivateKeyMethodProvider : public PrivateKeyMethodProvider {
+public:
+  ThreadPoolPrivateKeyMethodProvider(uint32_t threads);
+  ~ThreadPoolPrivateKeyMethodProvider();
+
+  // Ssl::PrivateKeyMethodProvider
+  PrivateKeyOperationPtr sign(EVP_PKEY& key, uint16_t signature_algorithm, const uint8_t* in,
+                              size_t in_len, Event::Dispatcher& dispatcher,
+                              PrivateKeyOperationCallbacks& callbacks) override;
+  PrivateKeyOperationPtr decrypt(EVP_PKEY& key, const uint8_t* in, size_t in_len,
+                                 Event::Dispatcher& dispatcher,
+                                 PrivateKeyOperationCallbacks& callbacks) override;
+
+  /**
+   * Run the operations synchronously.
+   * @return bool whether the operation succeeded, in which case out holds its output.
+   */
+  static bool sign(EVP_PKEY& key, uint16_t signature_algorithm, const std::vector<uint8_t>& in,
+                   std::vector<uint8_t>& out);
+  static bool decrypt(EVP_PKEY& key, const std::vector<uint8_t>& in, std::vector<uint8_t>& out);
+
+private:
+  // Shared between an operation and the thread that runs it, which outlives the operation if it
+  // is cancelled.
+  struct State : public std::enable_shared_from_this<State> {
+    State(EVP_PKEY& key, bool decrypt, uint16_t signature_algorithm, const uint8_t* in,
+          size_t in_len, Event::Dispatcher& dispatcher, PrivateKeyOperationCallbacks& callbacks);
+
+    void run();
+    void complete();
+
+    bssl::UniquePtr<EVP_PKEY> key_;
+    const bool decrypt_;
+    const uint16_t signature_algorithm_;
+    const std::vector<uint8_t> input_;
+    std::vector<uint8_t> output_;
+    bool succeeded_{};
+    Event::Dispatcher& dispatcher_;
+    PrivateKeyOperationCallbacks& callbacks_;
+    // Only accessed on the thread of the dispatcher.
+    bool completed_{};
+    // Set on the thread of the dispatcher, and read under the lock by the thread that runs the
+    // operation, which only posts the completion while it is unset.
+    std::mutex lock_;
+    bool cancelled_{};
+  };
+
+  typedef std::shared_ptr<State> StateSharedPtr;
+
+  class Operation : public PrivateKeyOperation {
+  public:
+    Operation(StateSharedPtr state) : state_(state) {}
+    ~Operation();
+
+    // Ssl::PrivateKeyOperation
+    bool completed() const override { return state_->completed_; }
+    const std::vector<uint8_t>* output() const override {
+      return state_->succeeded_ ? &state_->output_ : nullptr;
+    }
+
+  private:
+    StateSharedPtr state_;
+  };
+
+  PrivateKeyOperationPtr start(StateSharedPtr state);
+  void threadRoutine();
+
+  std::mutex lock_;
+  std::condition_variable work_event_; // Signalled when an operation is queued or on exit.
+  std::deque<StateSharedPtr> pending_;
+  bool exit_{};
+  std::vector<Thread::ThreadPtr> threads_;
+};
+
+} // namespace Ssl
+} // namespace Envoy
@@ -0,0 +1,67 @@
+#include "common/ssl/session_cache.h"
+
+namespace Envoy {
+namespace Ssl {
+
+uint64_t SessionCache::maxEntries() const {
+  return runtime_.snapshot().getInteger("ssl.session_cache.max_entries", 0);
+}
+
+void SessionCache::insert(const std::string& id, std::string&& session) {
+  const uint64_t max_entries = maxEntries();
+  if (max_entries == 0) {
+    return;
+  }
+  const uint64_t max_shard_entries = (max_entries + Shards - 1) / Shards;
+
+  Shard& shard = this->shard(id);
+  std::unique_lock<std::mutex> lock(shard.lock_);
+  auto it = shard.sessions_.find(id);
+  if (it != shard.sessions_.end()) {
+    shard.lru_.erase(it->second);
+    shard.sessions_.erase(it);
+  }
+
+  while (shard.sessions_.size() >= max_shard_entries) {
+    shard.sessions_.erase(shard.lru_.back().first);
+    shard.lru_.pop_back();
+  }
+
+  shard.lru_.emplace_front(id, std::move(session));
+  shard.sessions_.emplace(id, shard.lru_.begin());
+}
+
+bool SessionCache::lookup(const std::string& id, std::string& session) {
+  Shard& shard = this->shard(id);
+  std::unique_lock<std::mutex> lock(shard.lock_);
+  auto it = shard.sessions_.find(id);
+  if (it == shard.sessions_.end()) {
+    return false;
+  }
+
+  shard.lru_.splice(shard.lru_.begin(), shard.lru_, it->second);
+  session = it->second->second;
+  return true;
+}
+
+void SessionCache::remove(const std::string& id) {
+  Shard& shard = this->shard(id);
+  std::unique_lock<std::mutex> lock(shard.lock_);
+  auto it = shard.sessions_.find(id);
+  if (it != shard.sessions_.end()) {
+    shard.lru_.erase(it->second);
+    shard.sessions_.erase(it);
+  }
+}
+
+uint64_t SessionCache::size() {
+  uint64_t size = 0;
+  for (Shard& shard : shards_) {
+    std::unique_lock<std::mutex> lock(shard.lock_);
+    size += shard.sessions_.size();
+  }
+  return size;
+}
+
+} // namespace Ssl
+} // namespace Envoy
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "envoy/runtime/runtime.h"
+
+namespace Envoy {
+namespace Ssl {
+
+/**
+ * A cache of serialized TLS sessions keyed by session ID, which is shared by the server contexts of
+ * all listeners and all workers. It is split into shards with locks of their own so that workers
+ * rarely wait on each other, and each shard drops its least recently used sessions once it is
+ * full. The runtime key ssl.session_cache.max_entries bounds the number of sessions.
+ */
+class SessionCache {
+public:
+  SessionCache(Runtime::Loader& runtime) : runtime_(runtime) {}
+
+  /**
+   * @return uint64_t the maximum number of sessions in the cache, 0 if it is disabled.
+   */
+  uint64_t maxEntries() const;
+
+  /**
+   * Insert a session, replacing any session with the same ID.
+   * @param id supplies the session ID.
+   * @param session supplies the serialized session.
+   */
+  void insert(const std::string& id, std::string&& session);
+
+  /**
+   * Look up a session and mark it as recently used.
+   * @param id supplies the session ID.
+   * @param session receives the serialized session if it is found.
+   * @return bool whether the session was found.
+   */
+  bool lookup(const std::string& id, std::string& session);
+
+  /**
+   * Remove a session if it is cached.
+   * @param id supplies the session ID.
+   */
+  void remove(const std::string& id);
+
+  /**
+   * @return uint64_t the number of cached sessions.
+   */
+  uint64_t size();
+
+  static const uint32_t Shards = 16;
+
+private:
+  struct Shard {
+    typedef std::list<std::pair<std::string, std::string>> Lru;
+
+    std::mutex lock_;
+    // Most recently used first.
+    Lru lru_;
+    std::unordered_map<std::string, Lru::iterator> sessions_;
+  };
+
+  Shard& shard(const std::string& id) { return shards_[std::hash<std::string>()(id) % Shards]; }
+
+  Runtime::Loader& runtime_;
+  std::array<Shard, Shards> shards_;
+};
+
+} // namespace Ssl
+} // namespace Envoy
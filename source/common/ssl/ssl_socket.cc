@@ -1,5 +1,12 @@
 #include "common/ssl/ssl_socket.h"
 
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <cstring>
+
 #include "common/common/assert.h"
 #include "common/common/empty_string.h"
 #include "common/common/hex.h"
@@ -7,6 +14,19 @@
 #include "openssl/err.h"
 #include "openssl/x509v3.h"
 
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/tls.h>)
+#include <linux/tls.h>
+#define ENVOY_KERNEL_TLS 1
+#ifndef TCP_ULP
+#define TCP_ULP 31
+#endif
+#ifndef SOL_TLS
+#define SOL_TLS 282
+#endif
+#endif
+#endif
+
 using Envoy::Network::PostIoAction;
 
 namespace Envoy {
@@ -29,6 +49,11 @@ void SslSocket::setTransportSocketCallbacks(Network::TransportSocketCallbacks& c
 
   BIO* bio = BIO_new_socket(callbacks_->fd(), 0);
   SSL_set_bio(ssl_.get(), bio, bio);
+
+  if (ctx_.privateKeyMethodProvider() != nullptr) {
+    private_key_connection_.reset(
+        new PrivateKeyConnection(ssl_.get(), callbacks_->connection().dispatcher(), *this));
+  }
 }
 
 Network::IoResult SslSocket::doRead(Buffer::Instance& read_buffer) {
@@ -42,6 +67,7 @@ Network::IoResult SslSocket::doRead(Buffer::Instance& read_buffer) {
   bool keep_reading = true;
   PostIoAction action = PostIoAction::KeepOpen;
   uint64_t bytes_read = 0;
+  received_early_data_ = false;
   while (keep_reading) {
     // We use 2 slices here so that we can use the remainder of an existing buffer chain element
     // if there is extra space. 16K read is arbitrary and can be tuned later.
@@ -49,9 +75,13 @@ Network::IoResult SslSocket::doRead(Buffer::Instance& read_buffer) {
     uint64_t slices_to_commit = 0;
     uint64_t num_slices = read_buffer.reserve(16384, slices, 2);
     for (uint64_t i = 0; i < num_slices; i++) {
+      // SSL_read() completes the handshake once the early data ends, so the data it returns may
+      // also include data sent after the handshake, which is conservatively counted as early.
+      const bool in_early_data = SSL_in_early_data(ssl_.get());
       int rc = SSL_read(ssl_.get(), slices[i].mem_, slices[i].len_);
       ENVOY_CONN_LOG(trace, "ssl read returns: {}", callbacks_->connection(), rc);
       if (rc > 0) {
+        received_early_data_ |= in_early_data;
         slices[i].len_ = rc;
         slices_to_commit++;
         bytes_read += rc;
@@ -92,6 +122,14 @@ PostIoAction SslSocket::doHandshake() {
     ENVOY_CONN_LOG(debug, "handshake complete", callbacks_->connection());
     handshake_complete_ = true;
     ctx_.logHandshake(ssl_.get());
+    if (SSL_in_early_data(ssl_.get())) {
+      // The server has accepted early data, and the handshake completes while it is read.
+      ENVOY_CONN_LOG(debug, "early data accepted", callbacks_->connection());
+      ctx_.stats().early_data_accepted_.inc();
+    }
+    if (ctx_.kernelTlsEnabled()) {
+      enableKernelTls();
+    }
     callbacks_->raiseEvent(Network::ConnectionEvent::Connected);
 
     // It's possible that we closed during the handshake callback.
@@ -104,6 +142,7 @@ PostIoAction SslSocket::doHandshake() {
     switch (err) {
     case SSL_ERROR_WANT_READ:
     case SSL_ERROR_WANT_WRITE:
+    case SSL_ERROR_WANT_PRIVATE_KEY_OPERATION:
       return PostIoAction::KeepOpen;
     default:
       drainErrorQueue();
@@ -112,6 +151,79 @@ PostIoAction SslSocket::doHandshake() {
   }
 }
 
+void SslSocket::enableKernelTls() {
+#ifdef ENVOY_KERNEL_TLS
+  // The kernel only implements AES-128-GCM with TLS 1.2.
+  if (SSL_version(ssl_.get()) != TLS1_2_VERSION ||
+      !SSL_CIPHER_is_AES128GCM(SSL_get_current_cipher(ssl_.get()))) {
+    return;
+  }
+
+  // The key block holds the client and server MAC keys, which AEAD ciphers do not have, then the
+  // client and server keys, then the client and server implicit IVs.
+  const size_t key_length = TLS_CIPHER_AES_GCM_128_KEY_SIZE;
+  const size_t salt_length = TLS_CIPHER_AES_GCM_128_SALT_SIZE;
+  uint8_t key_block[2 * (key_length + salt_length)];
+  if (SSL_get_key_block_len(ssl_.get()) != sizeof(key_block) ||
+      !SSL_generate_key_block(ssl_.get(), key_block, sizeof(key_block))) {
+    drainErrorQueue();
+    return;
+  }
+  const bool server = SSL_is_server(ssl_.get());
+
+  tls12_crypto_info_aes_gcm_128 crypto_info;
+  memset(&crypto_info, 0, sizeof(crypto_info));
+  crypto_info.info.version = TLS_1_2_VERSION;
+  crypto_info.info.cipher_type = TLS_CIPHER_AES_GCM_128;
+  memcpy(crypto_info.key, key_block + (server ? key_length : 0), key_length);
+  memcpy(crypto_info.salt, key_block + 2 * key_length + (server ? salt_length : 0), salt_length);
+  // BoringSSL uses the sequence number as the explicit part of the nonce, and so does the kernel
+  // from here on.
+  const uint64_t sequence = SSL_get_write_sequence(ssl_.get());
+  for (size_t i = 0; i < sizeof(crypto_info.rec_seq); i++) {
+    crypto_info.rec_seq[i] = crypto_info.iv[i] = sequence >> (8 * (sizeof(sequence) - 1 - i));
+  }
+
+  // Without the TLS_TX keys, the upper layer protocol passes writes on to TCP unchanged, so
+  // BoringSSL keeps working if only the second call fails.
+  const int fd = callbacks_->fd();
+  if (setsockopt(fd, SOL_TCP, TCP_ULP, "tls", sizeof("tls")) != 0 ||
+      setsockopt(fd, SOL_TLS, TLS_TX, &crypto_info, sizeof(crypto_info)) != 0) {
+    ENVOY_CONN_LOG(debug, "unable to enable kernel TLS: {}", callbacks_->connection(), errno);
+    return;
+  }
+
+  ENVOY_CONN_LOG(debug, "kernel TLS enabled for writes", callbacks_->connection());
+  kernel_tls_tx_ = true;
+  ctx_.stats().kernel_tls_tx_.inc();
+#endif
+}
+
+Network::IoResult SslSocket::doKernelTlsWrite(Buffer::Instance& write_buffer) {
+  // The kernel turns whatever is written to the socket into records.
+  uint64_t bytes_written = 0;
+  while (write_buffer.length() > 0) {
+    int rc = write_buffer.write(callbacks_->fd());
+    ENVOY_CONN_LOG(trace, "kernel TLS write returns: {}", callbacks_->connection(), rc);
+    if (rc == -1) {
+      if (errno == EAGAIN) {
+        break;
+      }
+      ENVOY_CONN_LOG(trace, "write error: {}", callbacks_->connection(), errno);
+      return {PostIoAction::Close, bytes_written};
+    }
+    bytes_written += rc;
+  }
+
+  return {PostIoAction::KeepOpen, bytes_written};
+}
+
+void SslSocket::onPrivateKeyOperationComplete() {
+  ENVOY_CONN_LOG(debug, "private key operation complete", callbacks_->connection());
+  // Resume the handshake.
+  callbacks_->setReadBufferReady();
+}
+
 void SslSocket::drainErrorQueue() {
   bool saw_error = false;
   bool saw_counted_error = false;
@@ -144,8 +256,32 @@ Network::IoResult SslSocket::doWrite(Buffer::Instance& write_buffer) {
     }
   }
 
+  if (kernel_tls_tx_) {
+    return doKernelTlsWrite(write_buffer);
+  }
+
   uint64_t original_buffer_length = write_buffer.length();
   uint64_t total_bytes_written = 0;
+
+  // SSL_write() requires that if a previous call returns SSL_ERROR_WANT_WRITE, we need to call it
+  // again with at least as many bytes. We only move() into the write buffer, so the record that
+  // could not be written is still at the front of the buffer, but it may have been coalesced from
+  // several slices.
+  if (bytes_to_retry_ > 0 && original_buffer_length > 0) {
+    ASSERT(bytes_to_retry_ <= original_buffer_length);
+    const uint64_t bytes_to_retry = bytes_to_retry_;
+    bytes_to_retry_ = 0;
+    const WriteResult result =
+        writeRecord(write_buffer.linearize(bytes_to_retry), bytes_to_retry);
+    if (result == WriteResult::Close) {
+      return {PostIoAction::Close, 0};
+    } else if (result == WriteResult::Blocked) {
+      return {PostIoAction::KeepOpen, 0};
+    }
+    write_buffer.drain(bytes_to_retry);
+    total_bytes_written += bytes_to_retry;
+  }
+
   bool keep_writing = true;
   while ((original_buffer_length != total_bytes_written) && keep_writing) {
     // Protect against stack overflow if the buffer has a very large buffer chain.
@@ -158,33 +294,57 @@ Network::IoResult SslSocket::doWrite(Buffer::Instance& write_buffer) {
     uint64_t num_slices = write_buffer.getRawSlices(slices, MAX_SLICES);
 
     uint64_t inner_bytes_written = 0;
-    for (uint64_t i = 0; (i < num_slices) && (original_buffer_length != total_bytes_written); i++) {
-      // SSL_write() requires that if a previous call returns SSL_ERROR_WANT_WRITE, we need to call
-      // it again with the same parameters. Most implementations keep track of the last write size.
-      // In our case we don't need to do that because: a) SSL_write() will not write partial
-      // buffers. b) We only move() into the write buffer, which means that it's impossible for a
-      // particular chain to increase in size. So as long as we start writing where we left off we
-      // are guaranteed to call SSL_write() with the same parameters.
-      int rc = SSL_write(ssl_.get(), slices[i].mem_, slices[i].len_);
-      ENVOY_CONN_LOG(trace, "ssl write returns: {}", callbacks_->connection(), rc);
-      if (rc > 0) {
-        inner_bytes_written += rc;
-        total_bytes_written += rc;
-      } else {
-        int err = SSL_get_error(ssl_.get(), rc);
-        switch (err) {
-        case SSL_ERROR_WANT_WRITE:
-          keep_writing = false;
-          break;
-        case SSL_ERROR_WANT_READ:
-          // Renegotiation has started. We don't handle renegotiation so just fall through.
-        default:
-          drainErrorQueue();
-          return {PostIoAction::Close, total_bytes_written};
+    uint64_t slice = 0;
+    uint64_t slice_offset = 0;
+    while ((slice < num_slices) && (original_buffer_length != total_bytes_written)) {
+      if (slice_offset == slices[slice].len_) {
+        slice++;
+        slice_offset = 0;
+        continue;
+      }
+
+      const uint64_t record_size =
+          std::min(recordSize(), original_buffer_length - total_bytes_written);
+      const uint8_t* record = static_cast<const uint8_t*>(slices[slice].mem_) + slice_offset;
+      uint64_t record_length = record_size;
+      if (slices[slice].len_ - slice_offset < record_size) {
+        // Small slices such as HTTP/2 frames are copied into a single record instead of each
+        // going out in a record and a write of its own.
+        static thread_local uint8_t record_buffer[MaxRecordSize];
+        record_length = 0;
+        uint64_t i = slice;
+        uint64_t offset = slice_offset;
+        while ((i < num_slices) && (record_length < record_size)) {
+          const uint64_t length = std::min(slices[i].len_ - offset, record_size - record_length);
+          memcpy(record_buffer + record_length,
+                 static_cast<const uint8_t*>(slices[i].mem_) + offset, length);
+          record_length += length;
+          i++;
+          offset = 0;
         }
+        record = record_buffer;
+      }
 
+      const WriteResult result = writeRecord(record, record_length);
+      if (result == WriteResult::Close) {
+        return {PostIoAction::Close, total_bytes_written};
+      } else if (result == WriteResult::Blocked) {
+        bytes_to_retry_ = record_length;
+        keep_writing = false;
         break;
       }
+
+      inner_bytes_written += record_length;
+      total_bytes_written += record_length;
+      for (uint64_t remaining = record_length; remaining > 0;) {
+        const uint64_t length = std::min(slices[slice].len_ - slice_offset, remaining);
+        slice_offset += length;
+        remaining -= length;
+        if (slice_offset == slices[slice].len_) {
+          slice++;
+          slice_offset = 0;
+        }
+      }
     }
 
     // Draining must be done within the inner loop, otherwise we will keep getting the same slices
@@ -197,6 +357,35 @@ Network::IoResult SslSocket::doWrite(Buffer::Instance& write_buffer) {
   return {PostIoAction::KeepOpen, total_bytes_written};
 }
 
+uint64_t SslSocket::recordSize() const {
+  // Records that fit in a single TCP segment can be decrypted by the peer as soon as the segment
+  // arrives, which matters while the connection starts up, and full records cost the least
+  // overhead once it transfers in bulk.
+  return bytes_written_ < DynamicRecordSizingThreshold ? SmallRecordSize : MaxRecordSize;
+}
+
+SslSocket::WriteResult SslSocket::writeRecord(const void* data, uint64_t length) {
+  int rc = SSL_write(ssl_.get(), data, length);
+  ENVOY_CONN_LOG(trace, "ssl write returns: {}", callbacks_->connection(), rc);
+  if (rc > 0) {
+    // SSL_write() does not write partial buffers.
+    ASSERT(static_cast<uint64_t>(rc) == length);
+    bytes_written_ += rc;
+    return WriteResult::Written;
+  }
+
+  int err = SSL_get_error(ssl_.get(), rc);
+  switch (err) {
+  case SSL_ERROR_WANT_WRITE:
+    return WriteResult::Blocked;
+  case SSL_ERROR_WANT_READ:
+    // Renegotiation has started. We don't handle renegotiation so just fall through.
+  default:
+    drainErrorQueue();
+    return WriteResult::Close;
+  }
+}
+
 void SslSocket::onConnected() { ASSERT(!handshake_complete_); }
 
 bool SslSocket::peerCertificatePresented() const {
@@ -283,7 +472,13 @@ std::string SslSocket::getUriSanFromCertificate(X509* cert) {
 }
 
 void SslSocket::closeSocket(Network::ConnectionEvent) {
-  if (handshake_complete_ &&
+  if (private_key_connection_ != nullptr) {
+    // The connection cannot be resumed anymore.
+    private_key_connection_->operation_.reset();
+  }
+
+  // BoringSSL cannot write a close_notify alert once the kernel owns the write keys and sequence.
+  if (handshake_complete_ && !kernel_tls_tx_ &&
       callbacks_->connection().state() != Network::Connection::State::Closed) {
     // Attempt to send a shutdown before closing the socket. It's possible this won't go out if
     // there is no room on the socket. We can extend the state machine to handle this at some point
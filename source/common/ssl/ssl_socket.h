@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <memory>
 #include <string>
 
 #include "envoy/network/transport_socket.h"
@@ -17,6 +18,7 @@ enum class InitialState { Client, Server };
 
 class SslSocket : public Network::TransportSocket,
                   public Connection,
+                  public PrivateKeyOperationCallbacks,
                   protected Logger::Loggable<Logger::Id::connection> {
 public:
   SslSocket(Context& ctx, InitialState state);
@@ -27,6 +29,7 @@ public:
   std::string sha256PeerCertificateDigest() override;
   std::string subjectPeerCertificate() const override;
   std::string uriSanPeerCertificate() override;
+  bool receivedEarlyData() const override { return received_early_data_; }
 
   // Network::TransportSocket
   void setTransportSocketCallbacks(Network::TransportSocketCallbacks& callbacks) override;
@@ -36,10 +39,38 @@ public:
   Network::IoResult doRead(Buffer::Instance& read_buffer) override;
   Network::IoResult doWrite(Buffer::Instance& write_buffer) override;
   void onConnected() override;
+  bool directWritesSupported() const override { return kernel_tls_tx_; }
+
+  // Ssl::PrivateKeyOperationCallbacks
+  void onPrivateKeyOperationComplete() override;
 
   SSL* rawSslForTest() { return ssl_.get(); }
 
+  static const uint64_t SmallRecordSize = 1400;
+  static const uint64_t MaxRecordSize = SSL3_RT_MAX_PLAIN_LENGTH;
+  // Bytes written before records grow from SmallRecordSize to MaxRecordSize.
+  static const uint64_t DynamicRecordSizingThreshold = 1024 * 1024;
+
 private:
+  enum class WriteResult { Written, Blocked, Close };
+
+  /**
+   * @return uint64_t the number of bytes to put into the next record.
+   */
+  uint64_t recordSize() const;
+
+  /**
+   * Write all of the data as a single record.
+   */
+  WriteResult writeRecord(const void* data, uint64_t length);
+
+  /**
+   * Install the write keys of the completed handshake into the kernel if it supports TLS for the
+   * negotiated version and cipher, after which writes bypass BoringSSL.
+   */
+  void enableKernelTls();
+  Network::IoResult doKernelTlsWrite(Buffer::Instance& write_buffer);
+
   Network::PostIoAction doHandshake();
   void drainErrorQueue();
   std::string getUriSanFromCertificate(X509* cert);
@@ -47,7 +78,14 @@ private:
   Network::TransportSocketCallbacks* callbacks_{};
   ContextImpl& ctx_;
   bssl::UniquePtr<SSL> ssl_;
+  // Declared after ssl_, which refers to it until it is destroyed.
+  std::unique_ptr<PrivateKeyConnection> private_key_connection_;
   bool handshake_complete_{};
+  uint64_t bytes_written_{};
+  // The length of the record to write again after SSL_ERROR_WANT_WRITE, or 0.
+  uint64_t bytes_to_retry_{};
+  bool kernel_tls_tx_{};
+  bool received_early_data_{};
 };
 
 } // namespace Ssl
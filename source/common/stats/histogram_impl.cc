@@ -0,0 +1,121 @@
+#include "common/stats/histogram_impl.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "common/common/assert.h"
+#include "common/common/utility.h"
+
+#include "fmt/format.h"
+
+namespace Envoy {
+namespace Stats {
+
+const uint32_t HistogramBuckets::SubBucketBits;
+const uint32_t HistogramBuckets::SubBuckets;
+const uint32_t HistogramBuckets::BucketCount;
+const uint32_t HistogramRecorder::BlockCount;
+
+HistogramRecorder::~HistogramRecorder() {
+  for (std::atomic<std::atomic<uint64_t>*>& block : blocks_) {
+    delete[] block.load();
+  }
+}
+
+std::atomic<uint64_t>* HistogramRecorder::block(uint32_t index) {
+  std::atomic<std::atomic<uint64_t>*>& slot = blocks_[index];
+  std::atomic<uint64_t>* block = slot.load(std::memory_order_acquire);
+  if (block == nullptr) {
+    // A recorder normally has a single writer, but the store falls back to a shared recorder
+    // when thread local caching is unavailable, so another writer may have won the race.
+    std::atomic<uint64_t>* new_block = new std::atomic<uint64_t>[HistogramBuckets::SubBuckets]();
+    if (slot.compare_exchange_strong(block, new_block, std::memory_order_acq_rel)) {
+      block = new_block;
+    } else {
+      delete[] new_block;
+    }
+  }
+  return block;
+}
+
+void HistogramRecorder::recordValue(uint64_t value) {
+  const uint32_t index = HistogramBuckets::index(value);
+  block(index / HistogramBuckets::SubBuckets)[index % HistogramBuckets::SubBuckets].fetch_add(
+      1, std::memory_order_relaxed);
+  sum_.fetch_add(value, std::memory_order_relaxed);
+}
+
+void HistogramRecorder::addTo(std::vector<uint64_t>& counts, uint64_t& sum) const {
+  ASSERT(counts.size() == HistogramBuckets::BucketCount);
+  for (uint32_t i = 0; i < BlockCount; i++) {
+    const std::atomic<uint64_t>* block = blocks_[i].load(std::memory_order_acquire);
+    if (block == nullptr) {
+      continue;
+    }
+    for (uint32_t j = 0; j < HistogramBuckets::SubBuckets; j++) {
+      counts[i * HistogramBuckets::SubBuckets + j] += block[j].load(std::memory_order_relaxed);
+    }
+  }
+  sum += sum_.load(std::memory_order_relaxed);
+}
+
+HistogramStatisticsImpl::HistogramStatisticsImpl()
+    : computed_quantiles_(supportedQuantiles().size(), std::nan("")) {}
+
+const std::vector<double>& HistogramStatisticsImpl::supportedQuantiles() const {
+  static const std::vector<double> supported_quantiles = {0,    0.25, 0.5,   0.75, 0.90,
+                                                          0.95, 0.99, 0.999, 1};
+  return supported_quantiles;
+}
+
+void HistogramStatisticsImpl::refresh(const std::vector<uint64_t>& counts, uint64_t sum) {
+  ASSERT(counts.size() == HistogramBuckets::BucketCount);
+  sample_count_ = 0;
+  for (uint64_t count : counts) {
+    sample_count_ += count;
+  }
+  sample_sum_ = sum;
+
+  const std::vector<double>& quantiles = supportedQuantiles();
+  if (sample_count_ == 0) {
+    std::fill(computed_quantiles_.begin(), computed_quantiles_.end(), std::nan(""));
+    return;
+  }
+
+  // Quantiles ascend, so a single pass over the buckets finds all of them.
+  uint32_t bucket = 0;
+  uint64_t below = 0;
+  for (size_t i = 0; i < quantiles.size(); i++) {
+    const double rank = quantiles[i] * (sample_count_ - 1);
+    while (below + counts[bucket] <= rank) {
+      below += counts[bucket++];
+    }
+    const uint64_t width = HistogramBuckets::width(bucket);
+    computed_quantiles_[i] = HistogramBuckets::lowerBound(bucket);
+    if (width > 1) {
+      computed_quantiles_[i] += width * (rank - below + 0.5) / counts[bucket];
+    }
+  }
+}
+
+std::string HistogramStatisticsImpl::summary() const {
+  const std::vector<double>& quantiles = supportedQuantiles();
+  std::vector<std::string> summary;
+  summary.reserve(quantiles.size());
+  for (size_t i = 0; i < quantiles.size(); i++) {
+    summary.push_back(fmt::format("P{:g}: {:.8g}", 100 * quantiles[i], computed_quantiles_[i]));
+  }
+  return StringUtil::join(summary, ", ");
+}
+
+std::string HistogramStatisticsImpl::quantileName(double quantile) {
+  std::string name = fmt::format("p{:g}", 100 * quantile);
+  std::replace(name.begin(), name.end(), '.', '_');
+  return name;
+}
+
+} // namespace Stats
+} // namespace Envoy
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "envoy/stats/stats.h"
+
+#include "common/common/non_copyable.h"
+
+namespace Envoy {
+namespace Stats {
+
+/**
+ * The log-linear bucket layout shared by every aggregated histogram. Values below 2 *
+ * SubBuckets get a bucket each. Above that every power of two is divided into SubBuckets equal
+ * buckets, so a value reported from a bucket is within 1 / SubBuckets (6.25%) of the sample.
+ */
+class HistogramBuckets {
+public:
+  static const uint32_t SubBucketBits = 4;
+  static const uint32_t SubBuckets = 1 << SubBucketBits;
+  static const uint32_t BucketCount = SubBuckets * (64 - SubBucketBits) + SubBuckets;
+
+  /**
+   * @return the index of the bucket that value falls in.
+   */
+  static uint32_t index(uint64_t value) {
+    if (value < 2 * SubBuckets) {
+      return value;
+    }
+    const uint32_t shift = 63 - __builtin_clzll(value) - SubBucketBits;
+    return SubBuckets * shift + static_cast<uint32_t>(value >> shift);
+  }
+
+  /**
+   * @return the smallest value in the bucket.
+   */
+  static uint64_t lowerBound(uint32_t index) {
+    if (index < 2 * SubBuckets) {
+      return index;
+    }
+    const uint32_t shift = index / SubBuckets - 1;
+    return static_cast<uint64_t>(index - SubBuckets * shift) << shift;
+  }
+
+  /**
+   * @return the number of distinct values in the bucket.
+   */
+  static uint64_t width(uint32_t index) {
+    return index < 2 * SubBuckets ? 1 : uint64_t(1) << (index / SubBuckets - 1);
+  }
+};
+
+/**
+ * Lock-free sample recorder written by one thread and read by the main thread during merges.
+ * Counts only ever grow, so readers compute intervals by differencing consecutive snapshots.
+ * Buckets are allocated SubBuckets at a time on first use since most histograms only see a few
+ * orders of magnitude.
+ */
+class HistogramRecorder : NonCopyable {
+public:
+  ~HistogramRecorder();
+
+  void recordValue(uint64_t value);
+
+  /**
+   * Add the counts recorded so far to counts, which must have HistogramBuckets::BucketCount
+   * entries, and their sum to sum.
+   */
+  void addTo(std::vector<uint64_t>& counts, uint64_t& sum) const;
+
+private:
+  static const uint32_t BlockCount = HistogramBuckets::BucketCount / HistogramBuckets::SubBuckets;
+
+  std::atomic<uint64_t>* block(uint32_t index);
+
+  std::atomic<std::atomic<uint64_t>*> blocks_[BlockCount]{};
+  std::atomic<uint64_t> sum_{};
+};
+
+typedef std::shared_ptr<HistogramRecorder> HistogramRecorderSharedPtr;
+
+/**
+ * Quantiles computed from dense HistogramBuckets counts.
+ */
+class HistogramStatisticsImpl : public HistogramStatistics {
+public:
+  HistogramStatisticsImpl();
+
+  /**
+   * Recompute the statistics. Values within a bucket are assumed to be spread evenly.
+   * @param counts supplies HistogramBuckets::BucketCount counts.
+   * @param sum supplies the sum of the samples.
+   */
+  void refresh(const std::vector<uint64_t>& counts, uint64_t sum);
+
+  // Stats::HistogramStatistics
+  std::string summary() const override;
+  const std::vector<double>& supportedQuantiles() const override;
+  const std::vector<double>& computedQuantiles() const override { return computed_quantiles_; }
+  uint64_t sampleCount() const override { return sample_count_; }
+  uint64_t sampleSum() const override { return sample_sum_; }
+
+  /**
+   * @return a name for quantile that is safe to use as a stat name component, e.g. "p99_9".
+   */
+  static std::string quantileName(double quantile);
+
+private:
+  std::vector<double> computed_quantiles_;
+  uint64_t sample_count_{};
+  uint64_t sample_sum_{};
+};
+
+} // namespace Stats
+} // namespace Envoy
@@ -0,0 +1,74 @@
+#include "common/stats/lazy_scope_impl.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Envoy {
+namespace Stats {
+
+std::string LazyCounterImpl::name() const {
+  Counter* counter = counter_.load(std::memory_order_acquire);
+  return counter != nullptr ? counter->name() : prefix_ + name_;
+}
+
+std::vector<Tag> LazyCounterImpl::tags() const {
+  Counter* counter = counter_.load(std::memory_order_acquire);
+  return counter != nullptr ? counter->tags() : std::vector<Tag>();
+}
+
+std::string LazyCounterImpl::tagExtractedName() const {
+  Counter* counter = counter_.load(std::memory_order_acquire);
+  return counter != nullptr ? counter->tagExtractedName() : prefix_ + name_;
+}
+
+uint64_t LazyCounterImpl::latch() {
+  Counter* counter = counter_.load(std::memory_order_acquire);
+  return counter != nullptr ? counter->latch() : 0;
+}
+
+void LazyCounterImpl::reset() {
+  Counter* counter = counter_.load(std::memory_order_acquire);
+  if (counter != nullptr) {
+    counter->reset();
+  }
+}
+
+bool LazyCounterImpl::used() const {
+  Counter* counter = counter_.load(std::memory_order_acquire);
+  return counter != nullptr && counter->used();
+}
+
+uint64_t LazyCounterImpl::value() const {
+  Counter* counter = counter_.load(std::memory_order_acquire);
+  return counter != nullptr ? counter->value() : 0;
+}
+
+Counter& LazyCounterImpl::get() {
+  Counter* counter = counter_.load(std::memory_order_acquire);
+  if (counter == nullptr) {
+    // Threads that race here get the same counter back from the scope.
+    counter = &scope_.counter(name_);
+    counter_.store(counter, std::memory_order_release);
+  }
+  return *counter;
+}
+
+void LazyScopeImpl::forEachLazyCounter(const std::function<void(Counter&)>& cb) const {
+  for (auto& counter : counters_) {
+    if (!counter.second->created()) {
+      cb(*counter.second);
+    }
+  }
+}
+
+Counter& LazyScopeImpl::counter(const std::string& name) {
+  auto it = counters_.emplace(name, nullptr).first;
+  if (it->second == nullptr) {
+    it->second.reset(new LazyCounterImpl(parent_, prefix_, it->first));
+  }
+  return *it->second;
+}
+
+} // namespace Stats
+} // namespace Envoy
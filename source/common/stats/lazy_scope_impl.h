@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "envoy/stats/stats.h"
+
+#include "common/common/non_copyable.h"
+
+namespace Envoy {
+namespace Stats {
+
+/**
+ * Counter that is only created in its scope when it is first written. Until then it reads as zero
+ * and costs a name and a pointer, rather than the storage, tag extraction and name interning of a
+ * real counter.
+ */
+class LazyCounterImpl : public Counter {
+public:
+  LazyCounterImpl(Scope& scope, const std::string& prefix, const std::string& name)
+      : scope_(scope), prefix_(prefix), name_(name) {}
+
+  /**
+   * @return whether the counter has been created in its scope.
+   */
+  bool created() const { return counter_.load(std::memory_order_acquire) != nullptr; }
+
+  // Stats::Metric
+  std::string name() const override;
+  std::vector<Tag> tags() const override;
+  std::string tagExtractedName() const override;
+
+  // Stats::Counter
+  void add(uint64_t amount) override { get().add(amount); }
+  void inc() override { get().inc(); }
+  uint64_t latch() override;
+  void reset() override;
+  bool used() const override;
+  uint64_t value() const override;
+
+private:
+  Counter& get();
+
+  Scope& scope_;
+  // The prefix of scope_, which is only used to name the counter before it is created.
+  const std::string& prefix_;
+  const std::string& name_;
+  std::atomic<Counter*> counter_{};
+};
+
+/**
+ * Scope that hands out LazyCounterImpl counters, for scopes with many counters that are rarely
+ * written, such as cluster stats. Gauges and histograms are created in the parent scope right
+ * away, since gauges tend to be set on creation.
+ */
+class LazyScopeImpl : public Scope, NonCopyable {
+public:
+  /**
+   * @param parent supplies the scope the stats are created in.
+   * @param prefix supplies the prefix of the parent scope, e.g. "cluster.foo.".
+   */
+  LazyScopeImpl(Scope& parent, const std::string& prefix) : parent_(parent), prefix_(prefix) {}
+
+  /**
+   * Invoke a callback for every counter of this scope that has not been created in the parent
+   * scope yet, e.g. to list it with a zero value.
+   * @param cb supplies the callback.
+   */
+  void forEachLazyCounter(const std::function<void(Counter&)>& cb) const;
+
+  // Stats::Scope
+  ScopePtr createScope(const std::string& name) override { return parent_.createScope(name); }
+  void deliverHistogramToSinks(const Histogram& histogram, uint64_t value) override {
+    parent_.deliverHistogramToSinks(histogram, value);
+  }
+  Counter& counter(const std::string& name) override;
+  Gauge& gauge(const std::string& name) override { return parent_.gauge(name); }
+  Histogram& histogram(const std::string& name) override { return parent_.histogram(name); }
+
+private:
+  Scope& parent_;
+  const std::string prefix_;
+  // Only written while the stats are generated, before the scope is shared with other threads.
+  // Counters reference their key as their name.
+  std::unordered_map<std::string, std::unique_ptr<LazyCounterImpl>> counters_;
+};
+
+} // namespace Stats
+} // namespace Envoy
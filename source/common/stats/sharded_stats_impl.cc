@@ -0,0 +1,129 @@
+#include "common/stats/sharded_stats_impl.h"
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+
+namespace Envoy {
+namespace Stats {
+
+const size_t ShardedStatsBlock::NUM_SHARDS;
+const size_t ShardedStatsBlock::CACHE_LINE_SIZE;
+
+namespace {
+const size_t SLOTS_PER_CACHE_LINE = ShardedStatsBlock::CACHE_LINE_SIZE / sizeof(uint64_t);
+} // namespace
+
+ShardedStatsBlock::ShardedStatsBlock(size_t num_slots)
+    : num_slots_(num_slots),
+      shard_stride_((num_slots + SLOTS_PER_CACHE_LINE - 1) / SLOTS_PER_CACHE_LINE *
+                    SLOTS_PER_CACHE_LINE),
+      // One extra cache line of slots leaves room to align the first shard.
+      slots_(new std::atomic<uint64_t>[NUM_SHARDS * shard_stride_ + SLOTS_PER_CACHE_LINE]()) {
+  const uintptr_t address = reinterpret_cast<uintptr_t>(slots_.get());
+  first_slot_ = (CACHE_LINE_SIZE - address % CACHE_LINE_SIZE) % CACHE_LINE_SIZE / sizeof(uint64_t);
+}
+
+uint64_t ShardedStatsBlock::sum(size_t slot) const {
+  ASSERT(slot < num_slots_);
+  uint64_t sum = 0;
+  for (size_t shard = 0; shard < NUM_SHARDS; shard++) {
+    sum += slots_[shardOffset(shard) + slot].load(std::memory_order_relaxed);
+  }
+  return sum;
+}
+
+void ShardedStatsBlock::clear(size_t slot) {
+  ASSERT(slot < num_slots_);
+  for (size_t shard = 0; shard < NUM_SHARDS; shard++) {
+    std::atomic<uint64_t>& value = slots_[shardOffset(shard) + slot];
+    value -= value.load();
+  }
+}
+
+size_t ShardedStatsBlock::currentShard() {
+  static std::atomic<size_t> next_shard{0};
+  static thread_local const size_t shard = next_shard++ % NUM_SHARDS;
+  return shard;
+}
+
+uint64_t ShardedCounterImpl::latch() {
+  const uint64_t current = value();
+  return current - latched_.exchange(current);
+}
+
+void ShardedCounterImpl::reset() {
+  block_.clear(slot_);
+  latched_ = 0;
+}
+
+void ShardedGaugeImpl::set(uint64_t value) {
+  base_ = value - block_.sum(slot_);
+  used_ = true;
+}
+
+Counter& ShardedStatsStore::counter(const std::string& name) {
+  counters_.emplace_back(new ShardedCounterImpl(internName(name), block_, nextSlot()));
+  return *counters_.back();
+}
+
+Gauge& ShardedStatsStore::gauge(const std::string& name) {
+  gauges_.emplace_back(new ShardedGaugeImpl(internName(name), block_, nextSlot()));
+  return *gauges_.back();
+}
+
+void ShardedStatsStore::rollUp(Counter& stat, Counter& rollup) {
+  for (const auto& counter : counters_) {
+    if (counter.get() == &stat) {
+      counter->rollUpInto(rollup);
+      return;
+    }
+  }
+  NOT_REACHED;
+}
+
+void ShardedStatsStore::rollUp(Gauge& stat, Gauge& rollup) {
+  for (const auto& gauge : gauges_) {
+    if (gauge.get() == &stat) {
+      gauge->rollUpInto(rollup);
+      return;
+    }
+  }
+  NOT_REACHED;
+}
+
+std::list<CounterSharedPtr>
+ShardedStatsStore::counters(const std::shared_ptr<const void>& owner) const {
+  std::list<CounterSharedPtr> counters;
+  for (const auto& counter : counters_) {
+    counters.emplace_back(owner, counter.get());
+  }
+  return counters;
+}
+
+std::list<GaugeSharedPtr>
+ShardedStatsStore::gauges(const std::shared_ptr<const void>& owner) const {
+  std::list<GaugeSharedPtr> gauges;
+  for (const auto& gauge : gauges_) {
+    gauges.emplace_back(owner, gauge.get());
+  }
+  return gauges;
+}
+
+size_t ShardedStatsStore::nextSlot() {
+  const size_t slot = counters_.size() + gauges_.size();
+  RELEASE_ASSERT(slot < block_.numSlots());
+  return slot;
+}
+
+const std::string& ShardedStatsStore::internName(const std::string& name) {
+  // Never freed, and the references stay valid as the set is node based.
+  static std::mutex* lock = new std::mutex();
+  static std::unordered_set<std::string>* names = new std::unordered_set<std::string>();
+  std::unique_lock<std::mutex> guard(*lock);
+  return *names->insert(name).first;
+}
+
+} // namespace Stats
+} // namespace Envoy
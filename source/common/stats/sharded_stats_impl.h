@@ -0,0 +1,216 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "envoy/stats/stats.h"
+
+#include "common/common/assert.h"
+#include "common/common/non_copyable.h"
+
+namespace Envoy {
+namespace Stats {
+
+/**
+ * A fixed number of 64 bit slots, repeated once per shard. Each thread writes to the shard picked
+ * for it on first use, and the shards are cache line aligned, so threads on different shards never
+ * write to the same cache line. Reading a slot sums it over all shards. Slots are unsigned and
+ * wrap, so a slot that is incremented on one shard and decremented on another still sums to the
+ * right value.
+ */
+class ShardedStatsBlock : NonCopyable {
+public:
+  static const size_t NUM_SHARDS = 8;
+  static const size_t CACHE_LINE_SIZE = 64;
+
+  ShardedStatsBlock(size_t num_slots);
+
+  /**
+   * @return std::atomic<uint64_t>& the calling thread's copy of a slot.
+   */
+  std::atomic<uint64_t>& local(size_t slot) { return slots_[shardOffset(currentShard()) + slot]; }
+
+  /**
+   * @return uint64_t the sum of a slot over all shards.
+   */
+  uint64_t sum(size_t slot) const;
+
+  /**
+   * Subtract the current value of a slot from each shard, so that it sums to zero.
+   */
+  void clear(size_t slot);
+
+  size_t numSlots() const { return num_slots_; }
+
+  /**
+   * @return size_t the shard of the calling thread. Threads are given shards round robin in the
+   *         order in which they first write a sharded stat.
+   */
+  static size_t currentShard();
+
+private:
+  size_t shardOffset(size_t shard) const { return first_slot_ + shard * shard_stride_; }
+
+  const size_t num_slots_;
+  // Slots per shard, rounded up to whole cache lines.
+  const size_t shard_stride_;
+  std::unique_ptr<std::atomic<uint64_t>[]> slots_;
+  // Index of the first cache line aligned slot in slots_.
+  size_t first_slot_;
+};
+
+/**
+ * Counter whose value lives in a ShardedStatsBlock slot. It has no tags, and its name is shared by
+ * every store that creates a stat of that name, so a stat costs little more than its slot.
+ */
+class ShardedCounterImpl : public Counter {
+public:
+  ShardedCounterImpl(const std::string& name, ShardedStatsBlock& block, size_t slot)
+      : name_(name), block_(block), slot_(slot) {}
+
+  // Stats::Metric
+  std::string name() const override { return name_; }
+  std::vector<Tag> tags() const override { return {}; }
+  std::string tagExtractedName() const override { return name_; }
+
+  // Stats::Counter
+  void add(uint64_t amount) override {
+    block_.local(slot_) += amount;
+    if (!used_) {
+      used_ = true;
+    }
+    if (rollup_ != nullptr) {
+      rollup_->add(amount);
+    }
+  }
+  void inc() override { add(1); }
+  uint64_t latch() override;
+  void reset() override;
+  bool used() const override { return used_; }
+  uint64_t value() const override { return block_.sum(slot_); }
+
+  /**
+   * Also add every increment to another counter. Must be called before the counter is shared
+   * with other threads.
+   */
+  void rollUpInto(Counter& rollup) { rollup_ = &rollup; }
+
+private:
+  const std::string& name_;
+  ShardedStatsBlock& block_;
+  const size_t slot_;
+  Counter* rollup_{};
+  // Value at the last latch(). Only written by the thread that latches.
+  std::atomic<uint64_t> latched_{};
+  std::atomic<bool> used_{};
+};
+
+/**
+ * Gauge whose increments and decrements live in a ShardedStatsBlock slot. set() is not an
+ * increment, so set() values are kept in one shared base value that the shards are added to.
+ * Gauges that are only ever set, such as estimates, behave as an unsharded gauge. Named like
+ * ShardedCounterImpl.
+ */
+class ShardedGaugeImpl : public Gauge {
+public:
+  ShardedGaugeImpl(const std::string& name, ShardedStatsBlock& block, size_t slot)
+      : name_(name), block_(block), slot_(slot) {}
+
+  // Stats::Metric
+  std::string name() const override { return name_; }
+  std::vector<Tag> tags() const override { return {}; }
+  std::string tagExtractedName() const override { return name_; }
+
+  // Stats::Gauge
+  void add(uint64_t amount) override {
+    block_.local(slot_) += amount;
+    if (!used_) {
+      used_ = true;
+    }
+    if (rollup_ != nullptr) {
+      rollup_->add(amount);
+    }
+  }
+  void dec() override { sub(1); }
+  void inc() override { add(1); }
+  void set(uint64_t value) override;
+  void sub(uint64_t amount) override {
+    ASSERT(used());
+    block_.local(slot_) -= amount;
+    if (rollup_ != nullptr) {
+      rollup_->sub(amount);
+    }
+  }
+  bool used() const override { return used_; }
+  uint64_t value() const override { return base_ + block_.sum(slot_); }
+
+  /**
+   * Also apply every increment and decrement to another gauge. set() is not passed on. Must be
+   * called before the gauge is shared with other threads.
+   */
+  void rollUpInto(Gauge& rollup) { rollup_ = &rollup; }
+
+private:
+  const std::string& name_;
+  ShardedStatsBlock& block_;
+  const size_t slot_;
+  Gauge* rollup_{};
+  std::atomic<uint64_t> base_{};
+  std::atomic<bool> used_{};
+};
+
+/**
+ * A fixed size set of counters and gauges backed by one ShardedStatsBlock, for stats that are
+ * written by every worker, such as per host stats. It provides what the POOL_COUNTER and
+ * POOL_GAUGE macros need, and lists its stats in creation order.
+ *
+ * There can be a store per host, so a store keeps no names of its own: stat names are interned
+ * process wide, which is cheap as all stores are created from the same few stat macros.
+ */
+class ShardedStatsStore : NonCopyable {
+public:
+  /**
+   * @param max_stats supplies the number of counters and gauges that will be created.
+   */
+  ShardedStatsStore(size_t max_stats) : block_(max_stats) {}
+
+  Counter& counter(const std::string& name);
+  Gauge& gauge(const std::string& name);
+
+  /**
+   * @param owner supplies an owner of this store, which the returned stats keep alive.
+   * @return the counters of the store.
+   */
+  std::list<CounterSharedPtr> counters(const std::shared_ptr<const void>& owner) const;
+
+  /**
+   * @param owner supplies an owner of this store, which the returned stats keep alive.
+   * @return the gauges of the store.
+   */
+  std::list<GaugeSharedPtr> gauges(const std::shared_ptr<const void>& owner) const;
+
+  /**
+   * Roll a stat of this store up into another stat, e.g. the per host stats of a locality into
+   * stats of the whole locality, so that the aggregate is kept up to date as the stat is written
+   * rather than summed on read. Must be called before the stats are shared with other threads.
+   * @param stat supplies a stat created by this store.
+   * @param rollup supplies the stat to add the changes to. It must outlive this store.
+   */
+  void rollUp(Counter& stat, Counter& rollup);
+  void rollUp(Gauge& stat, Gauge& rollup);
+
+private:
+  size_t nextSlot();
+  static const std::string& internName(const std::string& name);
+
+  ShardedStatsBlock block_;
+  std::vector<std::unique_ptr<ShardedCounterImpl>> counters_;
+  std::vector<std::unique_ptr<ShardedGaugeImpl>> gauges_;
+};
+
+} // namespace Stats
+} // namespace Envoy
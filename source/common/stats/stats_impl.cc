@@ -3,13 +3,16 @@
 #include <string.h>
 
 #include <algorithm>
+#include <cctype>
 #include <chrono>
 #include <string>
+#include <vector>
 
 #include "envoy/common/exception.h"
 
 #include "common/common/utility.h"
 #include "common/config/well_known_names.h"
+#include "common/memory/accounting.h"
 
 namespace Envoy {
 namespace Stats {
@@ -34,6 +37,11 @@ size_t RawStatData::size() {
   return roundUpMultipleNaturalAlignment(sizeof(RawStatData) + nameSize());
 }
 
+size_t RawStatData::sizeGivenName(const std::string& name) {
+  return roundUpMultipleNaturalAlignment(sizeof(RawStatData) +
+                                         std::min(name.size(), maxNameLength()) + 1);
+}
+
 size_t& RawStatData::initializeAndGetMutableMaxObjNameLength(size_t configured_size) {
   // Like CONSTRUCT_ON_FIRST_USE, but non-const so that the value can be changed by tests
   static size_t size = configured_size;
@@ -61,8 +69,138 @@ std::string Utility::sanitizeStatsName(const std::string& name) {
   return stats_name;
 }
 
+MetricImpl::MetricImpl(std::string&& tag_extracted_name, std::vector<Tag>&& tags,
+                       SymbolTable& symbol_table)
+    : symbol_table_(symbol_table) {
+  std::vector<std::string> names;
+  names.reserve(1 + 2 * tags.size());
+  names.push_back(std::move(tag_extracted_name));
+  for (Tag& tag : tags) {
+    names.push_back(std::move(tag.name_));
+    names.push_back(std::move(tag.value_));
+  }
+  names_ = symbol_table_.encode(names);
+}
+
+MetricImpl::~MetricImpl() { symbol_table_.free(names_); }
+
+std::string MetricImpl::tagExtractedName() const {
+  return std::move(symbol_table_.decode(names_).front());
+}
+
+std::vector<Tag> MetricImpl::tags() const {
+  std::vector<std::string> names = symbol_table_.decode(names_);
+  std::vector<Tag> tags;
+  tags.reserve(names.size() / 2);
+  for (size_t i = 1; i + 1 < names.size(); i += 2) {
+    tags.push_back({std::move(names[i]), std::move(names[i + 1])});
+  }
+  return tags;
+}
+
 TagExtractorImpl::TagExtractorImpl(const std::string& name, const std::string& regex)
-    : name_(name), regex_(regex) {}
+    : name_(name), regex_(regex) {
+  extractLiterals(regex, prefix_, substring_);
+}
+
+void TagExtractorImpl::extractLiterals(const std::string& regex, std::string& prefix,
+                                       std::string& substring) {
+  size_t i = 0;
+  bool in_prefix = !regex.empty() && regex[0] == '^';
+  if (in_prefix) {
+    i++;
+  }
+
+  std::string run;
+  bool last_was_literal = false;
+  const auto end_run = [&]() -> void {
+    if (in_prefix) {
+      // The prefix is checked separately, so look for a substring after it.
+      prefix = run;
+      in_prefix = false;
+    } else if (run.size() > substring.size()) {
+      substring = run;
+    }
+    run.clear();
+    last_was_literal = false;
+  };
+
+  uint32_t depth = 0;
+  while (i < regex.size()) {
+    const char c = regex[i];
+    if (c == '\\') {
+      // Escaped punctuation is literal. Anything else (\d, \w, \b, ...) is a class or assertion.
+      if (depth == 0 && i + 1 < regex.size() && ispunct(static_cast<unsigned char>(regex[i + 1]))) {
+        run.push_back(regex[i + 1]);
+        last_was_literal = true;
+      } else if (depth == 0) {
+        end_run();
+      }
+      i += 2;
+    } else if (c == '[') {
+      if (depth == 0) {
+        end_run();
+      }
+      // Skip the class, including escapes and [:name:] style class names.
+      i++;
+      if (i < regex.size() && regex[i] == '^') {
+        i++;
+      }
+      if (i < regex.size() && regex[i] == ']') {
+        i++;
+      }
+      while (i < regex.size() && regex[i] != ']') {
+        if (regex[i] == '\\') {
+          i += 2;
+        } else if (regex[i] == '[' && i + 1 < regex.size() &&
+                   (regex[i + 1] == ':' || regex[i + 1] == '.' || regex[i + 1] == '=')) {
+          const size_t close = regex.find(std::string{regex[i + 1], ']'}, i + 2);
+          i = close == std::string::npos ? regex.size() : close + 2;
+        } else {
+          i++;
+        }
+      }
+      i++;
+    } else if (c == '(') {
+      if (depth == 0) {
+        end_run();
+      }
+      depth++;
+      i++;
+    } else if (c == ')') {
+      if (depth > 0) {
+        depth--;
+      }
+      i++;
+    } else if (depth > 0) {
+      i++;
+    } else if (c == '|') {
+      // Any part of the regex may be skipped by the alternative.
+      prefix.clear();
+      substring.clear();
+      return;
+    } else if (c == '*' || c == '?' || c == '{') {
+      // The quantified atom may not appear at all.
+      if (last_was_literal) {
+        run.pop_back();
+      }
+      end_run();
+      i = c == '{' ? std::min(regex.find('}', i), regex.size()) + 1 : i + 1;
+    } else if (c == '+') {
+      // The quantified atom appears at least once, but whatever follows is not adjacent to it.
+      end_run();
+      i++;
+    } else if (c == '.' || c == '^' || c == '$') {
+      end_run();
+      i++;
+    } else {
+      run.push_back(c);
+      last_was_literal = true;
+      i++;
+    }
+  }
+  end_run();
+}
 
 TagExtractorPtr TagExtractorImpl::createTagExtractor(const std::string& name,
                                                      const std::string& regex) {
@@ -91,6 +229,13 @@ TagExtractorPtr TagExtractorImpl::createTagExtractor(const std::string& name,
 
 std::string TagExtractorImpl::extractTag(const std::string& tag_extracted_name,
                                          std::vector<Tag>& tags) const {
+  // Most extractors only apply to a few stat namespaces, so cheap literal checks rule out the
+  // regex for most names.
+  if ((!prefix_.empty() && tag_extracted_name.compare(0, prefix_.size(), prefix_) != 0) ||
+      (!substring_.empty() && tag_extracted_name.find(substring_) == std::string::npos)) {
+    return tag_extracted_name;
+  }
+
   std::smatch match;
   // The regex must match and contain one or more subexpressions (all after the first are ignored).
   if (std::regex_search(tag_extracted_name, match, regex_) && match.size() > 1) {
@@ -119,6 +264,7 @@ RawStatData* HeapRawStatDataAllocator::alloc(const std::string& name) {
   // This must be zero-initialized
   RawStatData* data = static_cast<RawStatData*>(::calloc(RawStatData::size(), 1));
   data->initialize(name);
+  Memory::Accounting::charge(Memory::Category::Stats, RawStatData::size());
   return data;
 }
 
@@ -126,6 +272,7 @@ void HeapRawStatDataAllocator::free(RawStatData& data) {
   // This allocator does not ever have concurrent access to the raw data.
   ASSERT(data.ref_count_ == 1);
   ::free(&data);
+  Memory::Accounting::credit(Memory::Category::Stats, RawStatData::size());
 }
 
 void RawStatData::initialize(const std::string& name) {
@@ -133,7 +280,10 @@ void RawStatData::initialize(const std::string& name) {
   ASSERT(name.size() <= maxNameLength());
   ASSERT(std::string::npos == name.find(':'));
   ref_count_ = 1;
-  StringUtil::strlcpy(name_, name.substr(0, maxNameLength()).c_str(), nameSize());
+  // Only write the bytes the name needs, since allocators may size the block with sizeGivenName().
+  const size_t length = std::min(name.size(), maxNameLength());
+  memcpy(name_, name.data(), length);
+  name_[length] = '\0';
 }
 
 bool RawStatData::matches(const std::string& name) {
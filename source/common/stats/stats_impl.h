@@ -16,6 +16,7 @@
 
 #include "common/common/assert.h"
 #include "common/protobuf/protobuf.h"
+#include "common/stats/symbol_table_impl.h"
 
 #include "api/bootstrap.pb.h"
 
@@ -38,8 +39,30 @@ public:
   std::string extractTag(const std::string& tag_extracted_name,
                          std::vector<Tag>& tags) const override;
 
+  /**
+   * @return literal text that every name matching the regex starts with, or an empty string if
+   *         the regex is not anchored. Names without it skip the regex.
+   */
+  const std::string& prefix() const { return prefix_; }
+
+  /**
+   * @return the longest literal text that every name matching the regex contains after prefix(),
+   *         or an empty string if none could be found. Names without it skip the regex.
+   */
+  const std::string& substring() const { return substring_; }
+
 private:
+  /**
+   * Scans the top level of regex, outside of groups, classes and quantified atoms, for the literal
+   * text returned by prefix() and substring(). Leaves both empty when the regex has a top level
+   * alternation.
+   */
+  static void extractLiterals(const std::string& regex, std::string& prefix,
+                              std::string& substring);
+
   const std::string name_;
+  std::string prefix_;
+  std::string substring_;
   const std::regex regex_;
 };
 
@@ -115,6 +138,12 @@ struct RawStatData {
    */
   static size_t size();
 
+  /**
+   * Returns the size of this struct when it only needs to hold name, truncated to
+   * maxNameLength(), for allocators that store names of variable length.
+   */
+  static size_t sizeGivenName(const std::string& name);
+
   /**
    * Initializes this object to have the specified name,
    * a refcount of 1, and all other values zero.
@@ -182,20 +211,26 @@ public:
 /**
  * Implementation of the Metric interface. Virtual inheritance is used because the interfaces that
  * will inherit from Metric will have other base classes that will also inherit from Metric.
+ *
+ * The tag extracted name and tags are interned in a SymbolTable and only rendered when sinks or
+ * admin ask for them. Derived classes supply name(), which counters and gauges already have in
+ * their RawStatData.
  */
 class MetricImpl : public virtual Metric {
 public:
-  MetricImpl(const std::string& name, std::string&& tag_extracted_name, std::vector<Tag>&& tags)
-      : name_(name), tag_extracted_name_(std::move(tag_extracted_name)), tags_(std::move(tags)) {}
+  MetricImpl(std::string&& tag_extracted_name, std::vector<Tag>&& tags,
+             SymbolTable& symbol_table);
+  ~MetricImpl();
 
-  const std::string& name() const override { return name_; }
-  const std::string& tagExtractedName() const override { return tag_extracted_name_; }
-  const std::vector<Tag>& tags() const override { return tags_; }
+  std::string tagExtractedName() const override;
+  std::vector<Tag> tags() const override;
+
+protected:
+  SymbolTable& symbol_table_;
 
 private:
-  const std::string name_;
-  const std::string tag_extracted_name_;
-  const std::vector<Tag> tags_;
+  // The tag extracted name followed by the name and value of each tag.
+  StatNameList names_;
 };
 
 /**
@@ -204,11 +239,14 @@ private:
 class CounterImpl : public Counter, public MetricImpl {
 public:
   CounterImpl(RawStatData& data, RawStatDataAllocator& alloc, std::string&& tag_extracted_name,
-              std::vector<Tag>&& tags)
-      : MetricImpl(data.name_, std::move(tag_extracted_name), std::move(tags)), data_(data),
+              std::vector<Tag>&& tags, SymbolTable& symbol_table)
+      : MetricImpl(std::move(tag_extracted_name), std::move(tags), symbol_table), data_(data),
         alloc_(alloc) {}
   ~CounterImpl() { alloc_.free(data_); }
 
+  // Stats::Metric
+  std::string name() const override { return data_.name_; }
+
   // Stats::Counter
   void add(uint64_t amount) override {
     data_.value_ += amount;
@@ -233,11 +271,14 @@ private:
 class GaugeImpl : public Gauge, public MetricImpl {
 public:
   GaugeImpl(RawStatData& data, RawStatDataAllocator& alloc, std::string&& tag_extracted_name,
-            std::vector<Tag>&& tags)
-      : MetricImpl(data.name_, std::move(tag_extracted_name), std::move(tags)), data_(data),
+            std::vector<Tag>&& tags, SymbolTable& symbol_table)
+      : MetricImpl(std::move(tag_extracted_name), std::move(tags), symbol_table), data_(data),
         alloc_(alloc) {}
   ~GaugeImpl() { alloc_.free(data_); }
 
+  // Stats::Metric
+  std::string name() const override { return data_.name_; }
+
   // Stats::Gauge
   virtual void add(uint64_t amount) override {
     data_.value_ += amount;
@@ -268,13 +309,21 @@ private:
 class HistogramImpl : public Histogram, public MetricImpl {
 public:
   HistogramImpl(const std::string& name, Store& parent, std::string&& tag_extracted_name,
-                std::vector<Tag>&& tags)
-      : MetricImpl(name, std::move(tag_extracted_name), std::move(tags)), parent_(parent) {}
+                std::vector<Tag>&& tags, SymbolTable& symbol_table)
+      : MetricImpl(std::move(tag_extracted_name), std::move(tags), symbol_table),
+        parent_(parent), name_(symbol_table.encode({name})) {}
+  ~HistogramImpl() { symbol_table_.free(name_); }
+
+  // Stats::Metric
+  std::string name() const override { return symbol_table_.decode(name_).front(); }
 
   // Stats::Histogram
   void recordValue(uint64_t value) override { parent_.deliverHistogramToSinks(*this, value); }
 
   Store& parent_;
+
+private:
+  StatNameList name_;
 };
 
 /**
@@ -317,6 +366,12 @@ public:
     return list;
   }
 
+  void forEach(const std::function<void(Base&)>& cb) const {
+    for (auto& stat : stats_) {
+      cb(*stat.second);
+    }
+  }
+
 private:
   std::unordered_map<std::string, std::shared_ptr<Impl>> stats_;
   Allocator alloc_;
@@ -330,13 +385,15 @@ public:
   IsolatedStoreImpl()
       : counters_([this](const std::string& name) -> CounterImpl* {
           return new CounterImpl(*alloc_.alloc(name), alloc_, std::string(name),
-                                 std::vector<Tag>());
+                                 std::vector<Tag>(), symbol_table_);
         }),
         gauges_([this](const std::string& name) -> GaugeImpl* {
-          return new GaugeImpl(*alloc_.alloc(name), alloc_, std::string(name), std::vector<Tag>());
+          return new GaugeImpl(*alloc_.alloc(name), alloc_, std::string(name), std::vector<Tag>(),
+                               symbol_table_);
         }),
         histograms_([this](const std::string& name) -> HistogramImpl* {
-          return new HistogramImpl(name, *this, std::string(name), std::vector<Tag>());
+          return new HistogramImpl(name, *this, std::string(name), std::vector<Tag>(),
+                                   symbol_table_);
         }) {}
 
   // Stats::Scope
@@ -354,6 +411,14 @@ public:
   // Stats::Store
   std::list<CounterSharedPtr> counters() const override { return counters_.toList(); }
   std::list<GaugeSharedPtr> gauges() const override { return gauges_.toList(); }
+  std::list<ParentHistogramSharedPtr> histograms() const override {
+    return std::list<ParentHistogramSharedPtr>{};
+  }
+  void forEachCounter(const std::function<void(Counter&)>& cb) const override {
+    counters_.forEach(cb);
+  }
+  void forEachGauge(const std::function<void(Gauge&)>& cb) const override { gauges_.forEach(cb); }
+  void forEachHistogram(const std::function<void(ParentHistogram&)>&) const override {}
 
 private:
   struct ScopeImpl : public Scope {
@@ -376,6 +441,7 @@ private:
   };
 
   HeapRawStatDataAllocator alloc_;
+  SymbolTable symbol_table_;
   IsolatedStatsCache<Counter, CounterImpl> counters_;
   IsolatedStatsCache<Gauge, GaugeImpl> gauges_;
   IsolatedStatsCache<Histogram, HistogramImpl> histograms_;
@@ -1,8 +1,13 @@
 #include "common/stats/statsd.h"
 
+#include <sys/socket.h>
+#include <sys/uio.h>
+
 #include <chrono>
+#include <cmath>
 #include <cstdint>
 #include <string>
+#include <vector>
 
 #include "envoy/common/exception.h"
 #include "envoy/event/dispatcher.h"
@@ -11,6 +16,7 @@
 #include "common/common/assert.h"
 #include "common/common/utility.h"
 #include "common/config/utility.h"
+#include "common/stats/histogram_impl.h"
 
 #include "fmt/format.h"
 
@@ -37,6 +43,30 @@ void Writer::write(const std::string& message) {
   ::send(fd_, message.c_str(), message.size(), MSG_DONTWAIT);
 }
 
+void Writer::writeBatch(const std::vector<std::string>& messages) {
+#if defined(__linux__)
+  std::vector<struct iovec> iovecs(messages.size());
+  std::vector<struct mmsghdr> headers(messages.size());
+  for (size_t i = 0; i < messages.size(); i++) {
+    iovecs[i].iov_base = const_cast<char*>(messages[i].data());
+    iovecs[i].iov_len = messages[i].size();
+    headers[i].msg_hdr.msg_iov = &iovecs[i];
+    headers[i].msg_hdr.msg_iovlen = 1;
+  }
+
+  size_t sent = 0;
+  while (sent < messages.size()) {
+    const int rc = ::sendmmsg(fd_, &headers[sent], messages.size() - sent, MSG_DONTWAIT);
+    // On failure the first unsent datagram is dropped, matching one failed write().
+    sent += rc > 0 ? rc : 1;
+  }
+#else
+  for (const std::string& message : messages) {
+    write(message);
+  }
+#endif
+}
+
 UdpStatsdSink::UdpStatsdSink(ThreadLocal::SlotAllocator& tls,
                              Network::Address::InstanceConstSharedPtr address, const bool use_tag)
     : tls_(tls.allocateSlot()), server_address_(std::move(address)), use_tag_(use_tag) {
@@ -45,24 +75,111 @@ UdpStatsdSink::UdpStatsdSink(ThreadLocal::SlotAllocator& tls,
   });
 }
 
+constexpr uint32_t UdpStatsdSink::MAX_DATAGRAM_BYTES;
+constexpr uint32_t UdpStatsdSink::MAX_BATCHED_DATAGRAMS;
+constexpr uint64_t UdpStatsdSink::MAX_IDLE_FLUSHES;
+
 void UdpStatsdSink::flushCounter(const Counter& counter, uint64_t delta) {
-  const std::string message(
-      fmt::format("envoy.{}:{}|c{}", getName(counter), delta, buildTagStr(counter.tags())));
-  tls_->getTyped<Writer>().write(message);
+  // statsd counters are deltas, so an unchanged counter carries no information. Skipping it
+  // before its name is built spares most of the flush on nodes where few counters change.
+  if (delta == 0) {
+    return;
+  }
+
+  addLine(cachedLine(counter_lines_, counter, "|c"), delta);
 }
 
 void UdpStatsdSink::flushGauge(const Gauge& gauge, uint64_t value) {
-  const std::string message(
-      fmt::format("envoy.{}:{}|g{}", getName(gauge), value, buildTagStr(gauge.tags())));
-  tls_->getTyped<Writer>().write(message);
+  addLine(cachedLine(gauge_lines_, gauge, "|g"), value);
 }
 
-void UdpStatsdSink::onHistogramComplete(const Histogram& histogram, uint64_t value) {
-  // For statsd histograms are all timers.
-  const std::string message(fmt::format("envoy.{}:{}|ms{}", getName(histogram),
-                                        std::chrono::milliseconds(value).count(),
-                                        buildTagStr(histogram.tags())));
-  tls_->getTyped<Writer>().write(message);
+void UdpStatsdSink::flushHistogram(const ParentHistogram& histogram) {
+  // Samples are already aggregated, so each quantile is sent as a gauge along with a counter of
+  // the samples seen during the interval.
+  const HistogramStatistics& statistics = histogram.intervalStatistics();
+  if (statistics.sampleCount() == 0) {
+    return;
+  }
+
+  const std::string name = getName(histogram);
+  const std::string tags = buildTagStr(histogram.tags());
+  addLine(fmt::format("envoy.{}.count:{}|c{}", name, statistics.sampleCount(), tags));
+  for (size_t i = 0; i < statistics.supportedQuantiles().size(); i++) {
+    addLine(fmt::format("envoy.{}.{}:{}|g{}", name,
+                        HistogramStatisticsImpl::quantileName(statistics.supportedQuantiles()[i]),
+                        static_cast<uint64_t>(std::round(statistics.computedQuantiles()[i])),
+                        tags));
+  }
+}
+
+void UdpStatsdSink::endFlush() {
+  if (!current_datagram_.empty()) {
+    datagrams_.push_back(std::move(current_datagram_));
+    current_datagram_.clear();
+  }
+  writeDatagrams();
+
+  // Forget the lines of metrics that were not flushed for a while, e.g. because they were deleted
+  // along with their scope, so that the caches do not grow without bound.
+  if (++flushes_ % MAX_IDLE_FLUSHES == 0) {
+    for (auto* lines : {&counter_lines_, &gauge_lines_}) {
+      for (auto it = lines->begin(); it != lines->end();) {
+        if (flushes_ - it->second.last_flush_ > MAX_IDLE_FLUSHES) {
+          it = lines->erase(it);
+        } else {
+          ++it;
+        }
+      }
+    }
+  }
+}
+
+const UdpStatsdSink::CachedLine& UdpStatsdSink::cachedLine(CachedLines& lines, const Metric& metric,
+                                                           const char* type) {
+  std::string name = metric.name();
+  auto it = lines.find(name);
+  if (it == lines.end()) {
+    const std::string prefix = fmt::format("envoy.{}:", getName(metric));
+    const std::string suffix = type + buildTagStr(metric.tags());
+    it = lines.emplace(std::move(name), CachedLine{prefix, suffix, 0}).first;
+  }
+  it->second.last_flush_ = flushes_;
+  return it->second;
+}
+
+void UdpStatsdSink::addLine(const CachedLine& line, uint64_t value) {
+  const fmt::FormatInt formatted(value);
+  startLine(line.prefix_.size() + formatted.size() + line.suffix_.size());
+  current_datagram_.append(line.prefix_);
+  current_datagram_.append(formatted.data(), formatted.size());
+  current_datagram_.append(line.suffix_);
+}
+
+void UdpStatsdSink::addLine(const std::string& line) {
+  startLine(line.size());
+  current_datagram_.append(line);
+}
+
+void UdpStatsdSink::startLine(size_t size) {
+  // A line that does not fit in an empty datagram is still sent, on its own.
+  if (!current_datagram_.empty() && current_datagram_.size() + 1 + size > MAX_DATAGRAM_BYTES) {
+    datagrams_.push_back(std::move(current_datagram_));
+    current_datagram_.clear();
+    if (datagrams_.size() == MAX_BATCHED_DATAGRAMS) {
+      writeDatagrams();
+    }
+  }
+
+  if (!current_datagram_.empty()) {
+    current_datagram_.push_back('\n');
+  }
+}
+
+void UdpStatsdSink::writeDatagrams() {
+  if (!datagrams_.empty()) {
+    tls_->getTyped<Writer>().writeBatch(datagrams_);
+    datagrams_.clear();
+  }
 }
 
 const std::string UdpStatsdSink::getName(const Metric& metric) {
@@ -159,6 +276,21 @@ void TcpStatsdSink::TlsSink::flushGauge(const std::string& name, uint64_t value)
   commonFlush(name, value, 'g');
 }
 
+void TcpStatsdSink::TlsSink::flushHistogram(const std::string& name,
+                                            const HistogramStatistics& statistics) {
+  // See UdpStatsdSink::flushHistogram().
+  if (statistics.sampleCount() == 0) {
+    return;
+  }
+
+  commonFlush(name + ".count", statistics.sampleCount(), 'c');
+  for (size_t i = 0; i < statistics.supportedQuantiles().size(); i++) {
+    commonFlush(name + "." +
+                    HistogramStatisticsImpl::quantileName(statistics.supportedQuantiles()[i]),
+                static_cast<uint64_t>(std::round(statistics.computedQuantiles()[i])), 'g');
+  }
+}
+
 void TcpStatsdSink::TlsSink::endFlush(bool do_write) {
   ASSERT(current_slice_mem_ != nullptr);
   current_buffer_slice_.len_ = usedBuffer();
@@ -176,24 +308,10 @@ void TcpStatsdSink::TlsSink::onEvent(Network::ConnectionEvent event) {
   }
 }
 
-void TcpStatsdSink::TlsSink::onTimespanComplete(const std::string& name,
-                                                std::chrono::milliseconds ms) {
-  // Ultimately it would be nice to perf optimize this path also, but it's not very frequent. It's
-  // also currently not possible that this interleaves with any counter/gauge flushing.
-  ASSERT(current_slice_mem_ == nullptr);
-  Buffer::OwnedImpl buffer(fmt::format("envoy.{}:{}|ms\n", name, ms.count()));
-  write(buffer);
-}
-
 void TcpStatsdSink::TlsSink::write(Buffer::Instance& buffer) {
   // Guard against the stats connection backing up. In this case we probably have no visibility
   // into what is going on externally, but we also increment a stat that should be viewable
   // locally.
-  // NOTE: In the current implementation, we write most stats on the main thread, but timers
-  //       get emitted on the worker threads. Since this is using global buffered data, it's
-  //       possible that we are about to kill the connection that is not actually backed up.
-  //       This is essentially a panic state, so it's not worth keeping per thread buffer stats,
-  //       since if we stay over, the other threads will eventually kill their connections too.
   // TODO(mattklein123): The use of the stat is somewhat of a hack, and should be replaced with
   // real flow control callbacks once they are available.
   if (parent_.cluster_info_->stats().upstream_cx_tx_bytes_buffered_.value() >
@@ -219,7 +337,8 @@ void TcpStatsdSink::TlsSink::write(Buffer::Instance& buffer) {
                                      parent_.cluster_info_->stats().upstream_cx_rx_bytes_buffered_,
                                      parent_.cluster_info_->stats().upstream_cx_tx_bytes_total_,
                                      parent_.cluster_info_->stats().upstream_cx_tx_bytes_buffered_,
-                                     &parent_.cluster_info_->stats().bind_errors_});
+                                     &parent_.cluster_info_->stats().bind_errors_, nullptr, nullptr,
+                                     nullptr});
     connection_->connect();
   }
 
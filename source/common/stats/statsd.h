@@ -3,6 +3,8 @@
 #include <chrono>
 #include <cstdint>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "envoy/local_info/local_info.h"
 #include "envoy/network/connection.h"
@@ -27,6 +29,13 @@ public:
   virtual ~Writer();
 
   virtual void write(const std::string& message);
+
+  /**
+   * Send each message as its own datagram, using as few system calls as the platform allows.
+   * Like write(), datagrams that cannot be sent are dropped.
+   */
+  virtual void writeBatch(const std::vector<std::string>& messages);
+
   // Called in unit test to validate address.
   int getFdForTests() const { return fd_; };
 
@@ -35,7 +44,10 @@ private:
 };
 
 /**
- * Implementation of Sink that writes to a UDP statsd address.
+ * Implementation of Sink that writes to a UDP statsd address. Metrics flushed between beginFlush()
+ * and endFlush() are packed as newline separated lines into datagrams of at most
+ * MAX_DATAGRAM_BYTES, which are sent in batches. Counters that did not change since the last flush
+ * are not sent.
  */
 class UdpStatsdSink : public Sink {
 public:
@@ -53,20 +65,55 @@ public:
   void beginFlush() override {}
   void flushCounter(const Counter& counter, uint64_t delta) override;
   void flushGauge(const Gauge& gauge, uint64_t value) override;
-  void endFlush() override {}
-  void onHistogramComplete(const Histogram& histogram, uint64_t value) override;
+  void flushHistogram(const ParentHistogram& histogram) override;
+  void endFlush() override;
 
   // Called in unit test to validate writer construction and address.
   int getFdForTests() { return tls_->getTyped<Writer>().getFdForTests(); }
   bool getUseTagForTest() { return use_tag_; }
 
+  // Fits in a single unfragmented packet on an Ethernet MTU for both IPv4 and IPv6.
+  static constexpr uint32_t MAX_DATAGRAM_BYTES = 1432;
+
+  // Bounds the memory used by pending datagrams during a flush.
+  static constexpr uint32_t MAX_BATCHED_DATAGRAMS = 64;
+
+  // The number of flushes after which the cached line of a metric that was not flushed is dropped.
+  static constexpr uint64_t MAX_IDLE_FLUSHES = 60;
+
 private:
+  /**
+   * The parts of the line of a counter or gauge around its value, e.g. "envoy.foo:" and "|c".
+   * They only depend on the name and tags of the metric, so they are formatted once and then reused
+   * on every flush rather than extracting the tags and formatting them again.
+   */
+  struct CachedLine {
+    const std::string prefix_;
+    const std::string suffix_;
+    uint64_t last_flush_;
+  };
+
+  // Keyed by metric name rather than by metric, since a deleted metric's address may be reused.
+  typedef std::unordered_map<std::string, CachedLine> CachedLines;
+
   const std::string getName(const Metric& metric);
   const std::string buildTagStr(const std::vector<Tag>& tags);
+  const CachedLine& cachedLine(CachedLines& lines, const Metric& metric, const char* type);
+  void addLine(const CachedLine& line, uint64_t value);
+  void addLine(const std::string& line);
+  void startLine(size_t size);
+  void writeDatagrams();
 
   ThreadLocal::SlotPtr tls_;
   Network::Address::InstanceConstSharedPtr server_address_;
   const bool use_tag_;
+  // The datagram being filled and the full datagrams waiting to be sent.
+  std::string current_datagram_;
+  std::vector<std::string> datagrams_;
+  // Only used by the flushing thread.
+  CachedLines counter_lines_;
+  CachedLines gauge_lines_;
+  uint64_t flushes_{};
 };
 
 /**
@@ -82,21 +129,22 @@ public:
   void beginFlush() override { tls_->getTyped<TlsSink>().beginFlush(true); }
 
   void flushCounter(const Counter& counter, uint64_t delta) override {
-    tls_->getTyped<TlsSink>().flushCounter(counter.name(), delta);
+    // As for UdpStatsdSink, unchanged counters are not sent.
+    if (delta > 0) {
+      tls_->getTyped<TlsSink>().flushCounter(counter.name(), delta);
+    }
   }
 
   void flushGauge(const Gauge& gauge, uint64_t value) override {
     tls_->getTyped<TlsSink>().flushGauge(gauge.name(), value);
   }
 
-  void endFlush() override { tls_->getTyped<TlsSink>().endFlush(true); }
-
-  void onHistogramComplete(const Histogram& histogram, uint64_t value) override {
-    // For statsd histograms are all timers.
-    tls_->getTyped<TlsSink>().onTimespanComplete(histogram.name(),
-                                                 std::chrono::milliseconds(value));
+  void flushHistogram(const ParentHistogram& histogram) override {
+    tls_->getTyped<TlsSink>().flushHistogram(histogram.name(), histogram.intervalStatistics());
   }
 
+  void endFlush() override { tls_->getTyped<TlsSink>().endFlush(true); }
+
 private:
   struct TlsSink : public ThreadLocal::ThreadLocalObject, public Network::ConnectionCallbacks {
     TlsSink(TcpStatsdSink& parent, Event::Dispatcher& dispatcher);
@@ -107,8 +155,8 @@ private:
     void commonFlush(const std::string& name, uint64_t value, char stat_type);
     void flushCounter(const std::string& name, uint64_t delta);
     void flushGauge(const std::string& name, uint64_t value);
+    void flushHistogram(const std::string& name, const HistogramStatistics& statistics);
     void endFlush(bool do_write);
-    void onTimespanComplete(const std::string& name, std::chrono::milliseconds ms);
     uint64_t usedBuffer();
     void write(Buffer::Instance& buffer);
 
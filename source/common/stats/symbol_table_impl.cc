@@ -0,0 +1,135 @@
+#include "common/stats/symbol_table_impl.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "common/common/assert.h"
+
+namespace Envoy {
+namespace Stats {
+
+SymbolTable::~SymbolTable() {
+  // Every metric must release its names before the store that owns the table is destroyed.
+  ASSERT(encode_map_.empty());
+}
+
+StatNameList SymbolTable::encode(const std::vector<std::string>& strings) {
+  // Layout: the number of strings, then for each string its number of tokens followed by one
+  // symbol per token.
+  std::vector<uint8_t> bytes;
+  writeVarint(strings.size(), bytes);
+  {
+    std::unique_lock<std::mutex> lock(lock_);
+    for (const std::string& string : strings) {
+      const size_t tokens = std::count(string.begin(), string.end(), '.') + 1;
+      writeVarint(tokens, bytes);
+      size_t start = 0;
+      for (size_t i = 0; i < tokens; i++) {
+        size_t end = string.find('.', start);
+        if (end == std::string::npos) {
+          end = string.size();
+        }
+        writeVarint(toSymbol(string.substr(start, end - start)), bytes);
+        start = end + 1;
+      }
+    }
+  }
+
+  StatNameList list;
+  list.storage_.reset(new uint8_t[bytes.size()]);
+  memcpy(list.storage_.get(), bytes.data(), bytes.size());
+  return list;
+}
+
+std::vector<std::string> SymbolTable::decode(const StatNameList& list) const {
+  ASSERT(!list.empty());
+  const uint8_t* in = list.storage_.get();
+  std::vector<std::string> strings(readVarint(in));
+
+  std::unique_lock<std::mutex> lock(lock_);
+  for (std::string& string : strings) {
+    const uint64_t tokens = readVarint(in);
+    for (uint64_t i = 0; i < tokens; i++) {
+      if (i > 0) {
+        string.push_back('.');
+      }
+      string.append(*decode_map_[readVarint(in)]);
+    }
+  }
+  return strings;
+}
+
+void SymbolTable::free(StatNameList& list) {
+  ASSERT(!list.empty());
+  const uint8_t* in = list.storage_.get();
+  const uint64_t strings = readVarint(in);
+
+  std::unique_lock<std::mutex> lock(lock_);
+  for (uint64_t i = 0; i < strings; i++) {
+    const uint64_t tokens = readVarint(in);
+    for (uint64_t j = 0; j < tokens; j++) {
+      const Symbol symbol = readVarint(in);
+      auto shared_symbol = encode_map_.find(*decode_map_[symbol]);
+      ASSERT(shared_symbol != encode_map_.end());
+      if (--shared_symbol->second.ref_count_ == 0) {
+        decode_map_[symbol] = nullptr;
+        free_symbols_.push_back(symbol);
+        encode_map_.erase(shared_symbol);
+      }
+    }
+  }
+  list.storage_.reset();
+}
+
+size_t SymbolTable::size() const {
+  std::unique_lock<std::mutex> lock(lock_);
+  return encode_map_.size();
+}
+
+Symbol SymbolTable::toSymbol(const std::string& token) {
+  auto shared_symbol = encode_map_.find(token);
+  if (shared_symbol != encode_map_.end()) {
+    shared_symbol->second.ref_count_++;
+    return shared_symbol->second.symbol_;
+  }
+
+  // Hand out the smallest ids first so that they take a single varint byte.
+  Symbol symbol;
+  if (free_symbols_.empty()) {
+    symbol = decode_map_.size();
+    decode_map_.push_back(nullptr);
+  } else {
+    symbol = free_symbols_.back();
+    free_symbols_.pop_back();
+  }
+  shared_symbol = encode_map_.emplace(token, SharedSymbol{symbol, 1}).first;
+  decode_map_[symbol] = &shared_symbol->first;
+  return symbol;
+}
+
+void SymbolTable::writeVarint(uint64_t value, std::vector<uint8_t>& out) {
+  while (value >= 0x80) {
+    out.push_back(static_cast<uint8_t>(value) | 0x80);
+    value >>= 7;
+  }
+  out.push_back(static_cast<uint8_t>(value));
+}
+
+uint64_t SymbolTable::readVarint(const uint8_t*& in) {
+  uint64_t value = 0;
+  for (uint32_t shift = 0;; shift += 7) {
+    const uint8_t byte = *in++;
+    value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      return value;
+    }
+  }
+}
+
+} // namespace Stats
+} // namespace Envoy
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common/common/non_copyable.h"
+
+namespace Envoy {
+namespace Stats {
+
+/**
+ * The interned id of one '.' separated token of a stat name or tag.
+ */
+typedef uint32_t Symbol;
+
+/**
+ * A list of strings stored as the varint encoded symbols of their tokens, so a typical stat name
+ * takes a few bytes instead of a heap allocated copy. Created by SymbolTable::encode() and must be
+ * released with SymbolTable::free() before it is destroyed.
+ */
+class StatNameList {
+public:
+  bool empty() const { return storage_ == nullptr; }
+
+private:
+  friend class SymbolTable;
+
+  std::unique_ptr<uint8_t[]> storage_;
+};
+
+/**
+ * Interns stat name tokens so that the many metrics sharing tokens such as "cluster" or
+ * "upstream_rq_2xx" share a single copy of each. Symbols are reference counted and recycled once no
+ * StatNameList uses them, so churning clusters does not grow the table. Metrics are created and
+ * destroyed on every thread, so all operations lock.
+ */
+class SymbolTable : NonCopyable {
+public:
+  ~SymbolTable();
+
+  /**
+   * @param strings supplies the strings to encode.
+   * @return the encoded list.
+   */
+  StatNameList encode(const std::vector<std::string>& strings);
+
+  /**
+   * @param list supplies a list created by encode().
+   * @return the strings passed to encode().
+   */
+  std::vector<std::string> decode(const StatNameList& list) const;
+
+  /**
+   * Release the symbols used by a list and clear it.
+   * @param list supplies a list created by encode().
+   */
+  void free(StatNameList& list);
+
+  /**
+   * @return the number of distinct tokens currently interned.
+   */
+  size_t size() const;
+
+private:
+  struct SharedSymbol {
+    Symbol symbol_;
+    uint32_t ref_count_;
+  };
+
+  Symbol toSymbol(const std::string& token);
+
+  static void writeVarint(uint64_t value, std::vector<uint8_t>& out);
+  static uint64_t readVarint(const uint8_t*& in);
+
+  mutable std::mutex lock_;
+  std::unordered_map<std::string, SharedSymbol> encode_map_;
+  // Indexed by symbol. Points at the keys of encode_map_, which never move.
+  std::vector<const std::string*> decode_map_;
+  // Symbols that were released and can be handed out again.
+  std::vector<Symbol> free_symbols_;
+};
+
+} // namespace Stats
+} // namespace Envoy
@@ -7,13 +7,77 @@
 #include <mutex>
 #include <string>
 #include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "common/common/utility.h"
+
+#include "fmt/format.h"
 
 namespace Envoy {
 namespace Stats {
 
+ParentHistogramImpl::ParentHistogramImpl(const std::string& name, std::string&& tag_extracted_name,
+                                         std::vector<Tag>&& tags, SymbolTable& symbol_table)
+    : MetricImpl(std::move(tag_extracted_name), std::move(tags), symbol_table),
+      name_(symbol_table.encode({name})), shared_recorder_(std::make_shared<HistogramRecorder>()),
+      recorders_({shared_recorder_}) {}
+
+ParentHistogramImpl::~ParentHistogramImpl() { symbol_table_.free(name_); }
+
+HistogramRecorderSharedPtr ParentHistogramImpl::allocateRecorder() {
+  HistogramRecorderSharedPtr recorder = std::make_shared<HistogramRecorder>();
+  std::unique_lock<std::mutex> lock(lock_);
+  recorders_.push_back(recorder);
+  return recorder;
+}
+
+void ParentHistogramImpl::merge() {
+  // Merges only happen on the main thread, so the scratch buffer can be reused across histograms.
+  static std::vector<uint64_t> counts(HistogramBuckets::BucketCount);
+  std::fill(counts.begin(), counts.end(), 0);
+  uint64_t sum = 0;
+  {
+    std::unique_lock<std::mutex> lock(lock_);
+    for (const HistogramRecorderSharedPtr& recorder : recorders_) {
+      recorder->addTo(counts, sum);
+    }
+  }
+  cumulative_statistics_.refresh(counts, sum);
+
+  std::vector<std::pair<uint32_t, uint64_t>> current_counts;
+  for (uint32_t i = 0; i < counts.size(); i++) {
+    if (counts[i] != 0) {
+      current_counts.emplace_back(i, counts[i]);
+    }
+  }
+  for (const std::pair<uint32_t, uint64_t>& previous : previous_counts_) {
+    counts[previous.first] -= previous.second;
+  }
+  interval_statistics_.refresh(counts, sum - previous_sum_);
+  previous_counts_ = std::move(current_counts);
+  previous_sum_ = sum;
+}
+
+std::string ParentHistogramImpl::summary() const {
+  const std::vector<double>& quantiles = interval_statistics_.supportedQuantiles();
+  std::vector<std::string> summary;
+  summary.reserve(quantiles.size());
+  for (size_t i = 0; i < quantiles.size(); i++) {
+    summary.push_back(fmt::format("P{:g}({:.8g},{:.8g})", 100 * quantiles[i],
+                                  interval_statistics_.computedQuantiles()[i],
+                                  cumulative_statistics_.computedQuantiles()[i]));
+  }
+  return StringUtil::join(summary, " ");
+}
+
 ThreadLocalStoreImpl::ThreadLocalStoreImpl(RawStatDataAllocator& alloc)
     : alloc_(alloc), default_scope_(createScope("")),
-      num_last_resort_stats_(default_scope_->counter("stats.overflow")) {}
+      num_last_resort_stats_(default_scope_->counter("stats.overflow")) {
+  Counter& central_cache_miss = default_scope_->counter("stats.central_cache_miss");
+  central_cache_lock_contended_ = &default_scope_->counter("stats.central_cache_lock_contended");
+  central_cache_miss_ = &central_cache_miss;
+}
 
 ThreadLocalStoreImpl::~ThreadLocalStoreImpl() {
   ASSERT(shutting_down_);
@@ -27,16 +91,67 @@ std::list<CounterSharedPtr> ThreadLocalStoreImpl::counters() const {
   std::unordered_set<std::string> names;
   std::unique_lock<std::mutex> lock(lock_);
   for (ScopeImpl* scope : scopes_) {
-    for (auto counter : scope->central_cache_.counters_) {
-      if (names.insert(counter.first).second) {
-        ret.push_back(counter.second);
-      }
-    }
+    scope->central_cache_.counters_.forEach(
+        [&ret, &names](const std::string& name, const CounterSharedPtr& counter) -> void {
+          if (names.insert(name).second) {
+            ret.push_back(counter);
+          }
+        });
+  }
+
+  return ret;
+}
+
+std::list<ParentHistogramSharedPtr> ThreadLocalStoreImpl::histograms() const {
+  // Handle de-dup due to overlapping scopes.
+  std::list<ParentHistogramSharedPtr> ret;
+  std::unordered_set<std::string> names;
+  std::unique_lock<std::mutex> lock(lock_);
+  for (ScopeImpl* scope : scopes_) {
+    scope->central_cache_.histograms_.forEach(
+        [&ret, &names](const std::string& name,
+                       const ParentHistogramImplSharedPtr& histogram) -> void {
+          if (names.insert(name).second) {
+            ret.push_back(histogram);
+          }
+        });
   }
 
   return ret;
 }
 
+template <class StatSharedPtr, class StatType>
+void ThreadLocalStoreImpl::forEachStat(ReadMostlyMap<StatSharedPtr> CentralCacheEntry::*map,
+                                       const std::function<void(StatType&)>& cb) const {
+  // Handle de-dup due to overlapping scopes. The names reference the central cache keys, which
+  // cannot be removed while the lock is held.
+  std::unordered_set<std::reference_wrapper<const std::string>, std::hash<std::string>,
+                     std::equal_to<std::string>>
+      names;
+  std::unique_lock<std::mutex> lock(lock_);
+  for (ScopeImpl* scope : scopes_) {
+    (scope->central_cache_.*map)
+        .forEach([&cb, &names](const std::string& name, const StatSharedPtr& stat) -> void {
+          if (names.insert(std::cref(name)).second) {
+            cb(*stat);
+          }
+        });
+  }
+}
+
+void ThreadLocalStoreImpl::forEachCounter(const std::function<void(Counter&)>& cb) const {
+  forEachStat(&CentralCacheEntry::counters_, cb);
+}
+
+void ThreadLocalStoreImpl::forEachGauge(const std::function<void(Gauge&)>& cb) const {
+  forEachStat(&CentralCacheEntry::gauges_, cb);
+}
+
+void ThreadLocalStoreImpl::forEachHistogram(
+    const std::function<void(ParentHistogram&)>& cb) const {
+  forEachStat(&CentralCacheEntry::histograms_, cb);
+}
+
 ScopePtr ThreadLocalStoreImpl::createScope(const std::string& name) {
   std::unique_ptr<ScopeImpl> new_scope(new ScopeImpl(*this, name));
   std::unique_lock<std::mutex> lock(lock_);
@@ -50,11 +165,12 @@ std::list<GaugeSharedPtr> ThreadLocalStoreImpl::gauges() const {
   std::unordered_set<std::string> names;
   std::unique_lock<std::mutex> lock(lock_);
   for (ScopeImpl* scope : scopes_) {
-    for (auto gauge : scope->central_cache_.gauges_) {
-      if (names.insert(gauge.first).second) {
-        ret.push_back(gauge.second);
-      }
-    }
+    scope->central_cache_.gauges_.forEach(
+        [&ret, &names](const std::string& name, const GaugeSharedPtr& gauge) -> void {
+          if (names.insert(name).second) {
+            ret.push_back(gauge);
+          }
+        });
   }
 
   return ret;
@@ -82,7 +198,8 @@ void ThreadLocalStoreImpl::releaseScopeCrossThread(ScopeImpl* scope) {
   // This can happen from any thread. We post() back to the main thread which will initiate the
   // cache flush operation.
   if (!shutting_down_ && main_thread_dispatcher_) {
-    main_thread_dispatcher_->post([this, scope]() -> void { clearScopeFromCaches(scope); });
+    const uint64_t scope_id = scope->scope_id_;
+    main_thread_dispatcher_->post([this, scope_id]() -> void { clearScopeFromCaches(scope_id); });
   }
 }
 
@@ -96,14 +213,30 @@ std::string ThreadLocalStoreImpl::getTagsForName(const std::string& name, std::v
   return tag_extracted_name;
 }
 
-void ThreadLocalStoreImpl::clearScopeFromCaches(ScopeImpl* scope) {
+void ThreadLocalStoreImpl::clearScopeFromCaches(uint64_t scope_id) {
   // If we are shutting down we no longer perform cache flushes as workers may be shutting down
   // at the same time.
   if (!shutting_down_) {
     // Perform a cache flush on all threads.
     tls_->runOnAllThreads(
-        [this, scope]() -> void { tls_->getTyped<TlsCache>().scope_cache_.erase(scope); });
+        [this, scope_id]() -> void { tls_->getTyped<TlsCache>().scope_cache_.erase(scope_id); });
+  }
+}
+
+std::unique_lock<std::mutex> ThreadLocalStoreImpl::lockCentralCache() {
+  std::unique_lock<std::mutex> lock(lock_, std::try_to_lock);
+  const bool contended = !lock.owns_lock();
+  if (contended) {
+    lock.lock();
   }
+
+  if (central_cache_miss_ != nullptr) {
+    central_cache_miss_->inc();
+    if (contended) {
+      central_cache_lock_contended_->inc();
+    }
+  }
+  return lock;
 }
 
 ThreadLocalStoreImpl::SafeAllocData ThreadLocalStoreImpl::safeAlloc(const std::string& name) {
@@ -130,7 +263,7 @@ Counter& ThreadLocalStoreImpl::ScopeImpl::counter(const std::string& name) {
   // is no cache entry.
   CounterSharedPtr* tls_ref = nullptr;
   if (!parent_.shutting_down_ && parent_.tls_) {
-    tls_ref = &parent_.tls_->getTyped<TlsCache>().scope_cache_[this].counters_[final_name];
+    tls_ref = &parent_.tls_->getTyped<TlsCache>().scope_cache_[scope_id_].counters_[final_name];
   }
 
   // If we have a valid cache entry, return it.
@@ -138,41 +271,32 @@ Counter& ThreadLocalStoreImpl::ScopeImpl::counter(const std::string& name) {
     return **tls_ref;
   }
 
-  // We must now look in the central store so we must be locked. We grab a reference to the
-  // central store location. It might contain nothing. In this case, we allocate a new stat.
-  std::unique_lock<std::mutex> lock(parent_.lock_);
-  CounterSharedPtr& central_ref = central_cache_.counters_[final_name];
+  // Next look in the central store, which does not need the lock. This finds stats created by
+  // other threads, e.g. every worker after the first during a CDS update.
+  const CounterSharedPtr* central_ref = central_cache_.counters_.find(final_name);
   if (!central_ref) {
-    SafeAllocData alloc = parent_.safeAlloc(final_name);
-    std::vector<Tag> tags;
-    std::string tag_extracted_name = parent_.getTagsForName(final_name, tags);
-    central_ref.reset(
-        new CounterImpl(alloc.data_, alloc.free_, std::move(tag_extracted_name), std::move(tags)));
+    // The stat has to be allocated, so we must be locked. Another thread may have inserted it
+    // since the lookup above, so look again.
+    std::unique_lock<std::mutex> lock = parent_.lockCentralCache();
+    central_ref = central_cache_.counters_.find(final_name);
+    if (!central_ref) {
+      SafeAllocData alloc = parent_.safeAlloc(final_name);
+      std::vector<Tag> tags;
+      std::string tag_extracted_name = parent_.getTagsForName(final_name, tags);
+      central_ref = &central_cache_.counters_.insert(
+          final_name, CounterSharedPtr{new CounterImpl(alloc.data_, alloc.free_,
+                                                       std::move(tag_extracted_name),
+                                                       std::move(tags), parent_.symbol_table_)});
+    }
   }
 
   // If we have a TLS location to store or allocation into, do it.
   if (tls_ref) {
-    *tls_ref = central_ref;
+    *tls_ref = *central_ref;
   }
 
   // Finally we return the reference.
-  return *central_ref;
-}
-
-void ThreadLocalStoreImpl::ScopeImpl::deliverHistogramToSinks(const Histogram& histogram,
-                                                              uint64_t value) {
-  // Thread local deliveries must be blocked outright for histograms and timers during shutdown.
-  // This is because the sinks may end up trying to create new connections via the thread local
-  // cluster manager which may already be destroyed (there is no way to sequence this because the
-  // cluster manager destroying can create deliveries). We special case this explicitly to avoid
-  // having to implement a shutdown() method (or similar) on every TLS object.
-  if (parent_.shutting_down_) {
-    return;
-  }
-
-  for (Sink& sink : parent_.timer_sinks_) {
-    sink.onHistogramComplete(histogram, value);
-  }
+  return **central_ref;
 }
 
 Gauge& ThreadLocalStoreImpl::ScopeImpl::gauge(const std::string& name) {
@@ -181,28 +305,33 @@ Gauge& ThreadLocalStoreImpl::ScopeImpl::gauge(const std::string& name) {
   std::string final_name = prefix_ + name;
   GaugeSharedPtr* tls_ref = nullptr;
   if (!parent_.shutting_down_ && parent_.tls_) {
-    tls_ref = &parent_.tls_->getTyped<TlsCache>().scope_cache_[this].gauges_[final_name];
+    tls_ref = &parent_.tls_->getTyped<TlsCache>().scope_cache_[scope_id_].gauges_[final_name];
   }
 
   if (tls_ref && *tls_ref) {
     return **tls_ref;
   }
 
-  std::unique_lock<std::mutex> lock(parent_.lock_);
-  GaugeSharedPtr& central_ref = central_cache_.gauges_[final_name];
+  const GaugeSharedPtr* central_ref = central_cache_.gauges_.find(final_name);
   if (!central_ref) {
-    SafeAllocData alloc = parent_.safeAlloc(final_name);
-    std::vector<Tag> tags;
-    std::string tag_extracted_name = parent_.getTagsForName(final_name, tags);
-    central_ref.reset(
-        new GaugeImpl(alloc.data_, alloc.free_, std::move(tag_extracted_name), std::move(tags)));
+    std::unique_lock<std::mutex> lock = parent_.lockCentralCache();
+    central_ref = central_cache_.gauges_.find(final_name);
+    if (!central_ref) {
+      SafeAllocData alloc = parent_.safeAlloc(final_name);
+      std::vector<Tag> tags;
+      std::string tag_extracted_name = parent_.getTagsForName(final_name, tags);
+      central_ref = &central_cache_.gauges_.insert(
+          final_name, GaugeSharedPtr{new GaugeImpl(alloc.data_, alloc.free_,
+                                                   std::move(tag_extracted_name),
+                                                   std::move(tags), parent_.symbol_table_)});
+    }
   }
 
   if (tls_ref) {
-    *tls_ref = central_ref;
+    *tls_ref = *central_ref;
   }
 
-  return *central_ref;
+  return **central_ref;
 }
 
 Histogram& ThreadLocalStoreImpl::ScopeImpl::histogram(const std::string& name) {
@@ -211,27 +340,36 @@ Histogram& ThreadLocalStoreImpl::ScopeImpl::histogram(const std::string& name) {
   std::string final_name = prefix_ + name;
   HistogramSharedPtr* tls_ref = nullptr;
   if (!parent_.shutting_down_ && parent_.tls_) {
-    tls_ref = &parent_.tls_->getTyped<TlsCache>().scope_cache_[this].histograms_[final_name];
+    tls_ref = &parent_.tls_->getTyped<TlsCache>().scope_cache_[scope_id_].histograms_[final_name];
   }
 
   if (tls_ref && *tls_ref) {
     return **tls_ref;
   }
 
-  std::unique_lock<std::mutex> lock(parent_.lock_);
-  HistogramSharedPtr& central_ref = central_cache_.histograms_[final_name];
+  const ParentHistogramImplSharedPtr* central_ref = central_cache_.histograms_.find(final_name);
   if (!central_ref) {
-    std::vector<Tag> tags;
-    std::string tag_extracted_name = parent_.getTagsForName(final_name, tags);
-    central_ref.reset(
-        new HistogramImpl(final_name, parent_, std::move(tag_extracted_name), std::move(tags)));
+    std::unique_lock<std::mutex> lock = parent_.lockCentralCache();
+    central_ref = central_cache_.histograms_.find(final_name);
+    if (!central_ref) {
+      std::vector<Tag> tags;
+      std::string tag_extracted_name = parent_.getTagsForName(final_name, tags);
+      central_ref = &central_cache_.histograms_.insert(
+          final_name, std::make_shared<ParentHistogramImpl>(
+                          final_name, std::move(tag_extracted_name), std::move(tags),
+                          parent_.symbol_table_));
+    }
   }
 
+  // Unlike counters and gauges, each thread gets its own histogram that records into a recorder
+  // only that thread writes to.
   if (tls_ref) {
-    *tls_ref = central_ref;
+    *tls_ref = std::make_shared<ThreadLocalHistogramImpl>(*central_ref,
+                                                          (*central_ref)->allocateRecorder());
+    return **tls_ref;
   }
 
-  return *central_ref;
+  return **central_ref;
 }
 
 } // namespace Stats
@@ -3,19 +3,91 @@
 #include <atomic>
 #include <chrono>
 #include <cstdint>
+#include <functional>
 #include <list>
 #include <mutex>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "envoy/thread_local/thread_local.h"
 
+#include "common/common/read_mostly_map.h"
+#include "common/stats/histogram_impl.h"
 #include "common/stats/stats_impl.h"
 
 namespace Envoy {
 namespace Stats {
 
+/**
+ * Histogram owned by the store's central cache. Every thread records into its own
+ * HistogramRecorder (see ThreadLocalHistogramImpl), and merge() sums them on the main thread.
+ */
+class ParentHistogramImpl : public ParentHistogram, public MetricImpl {
+public:
+  ParentHistogramImpl(const std::string& name, std::string&& tag_extracted_name,
+                      std::vector<Tag>&& tags, SymbolTable& symbol_table);
+  ~ParentHistogramImpl();
+
+  /**
+   * @return a recorder for the calling thread. It is included in every later merge().
+   */
+  HistogramRecorderSharedPtr allocateRecorder();
+
+  // Stats::Metric
+  std::string name() const override { return symbol_table_.decode(name_).front(); }
+
+  // Stats::Histogram
+  void recordValue(uint64_t value) override { shared_recorder_->recordValue(value); }
+
+  // Stats::ParentHistogram
+  void merge() override;
+  const HistogramStatistics& intervalStatistics() const override { return interval_statistics_; }
+  const HistogramStatistics& cumulativeStatistics() const override {
+    return cumulative_statistics_;
+  }
+  std::string summary() const override;
+
+private:
+  StatNameList name_;
+  // Used by threads without a thread local cache, e.g. before threading is initialized.
+  const HistogramRecorderSharedPtr shared_recorder_;
+  std::mutex lock_;
+  std::vector<HistogramRecorderSharedPtr> recorders_;
+  // Non-zero bucket counts and the sum as of the previous merge, for computing intervals.
+  std::vector<std::pair<uint32_t, uint64_t>> previous_counts_;
+  uint64_t previous_sum_{};
+  HistogramStatisticsImpl interval_statistics_;
+  HistogramStatisticsImpl cumulative_statistics_;
+};
+
+typedef std::shared_ptr<ParentHistogramImpl> ParentHistogramImplSharedPtr;
+
+/**
+ * The histogram handed out from a thread's cache. Recording only touches the thread's own
+ * recorder, so there is no locking or cross thread cache line sharing per sample.
+ */
+class ThreadLocalHistogramImpl : public Histogram {
+public:
+  ThreadLocalHistogramImpl(ParentHistogramImplSharedPtr parent,
+                           HistogramRecorderSharedPtr recorder)
+      : parent_(std::move(parent)), recorder_(std::move(recorder)) {}
+
+  // Stats::Metric
+  std::string name() const override { return parent_->name(); }
+  std::vector<Tag> tags() const override { return parent_->tags(); }
+  std::string tagExtractedName() const override { return parent_->tagExtractedName(); }
+
+  // Stats::Histogram
+  void recordValue(uint64_t value) override { recorder_->recordValue(value); }
+
+private:
+  const ParentHistogramImplSharedPtr parent_;
+  const HistogramRecorderSharedPtr recorder_;
+};
+
 /**
  * Store implementation with thread local caching. This implementation supports the following
  * features:
@@ -31,15 +103,22 @@ namespace Stats {
  * - Scopes can be deleted from any thread, and they are in practice as scopes are likely to be
  *   shared across all worker threads.
  * - Per thread caches are checked, and if empty, they are populated from the central cache.
+ * - Central cache lookups take no locks (see ReadMostlyMap). The store lock is only taken to
+ *   insert a stat that does not exist yet. "stats.central_cache_miss" counts those lookups and
+ *   "stats.central_cache_lock_contended" counts the ones that had to wait for the lock.
  * - Scopes are entirely owned by the caller. The store only keeps weak pointers.
  * - When a scope is destroyed, a cache flush operation is run on all threads to flush any cached
- *   data owned by the destroyed scope.
- * - NOTE: It is theoretically possible that when a scope is deleted, it could be reallocated
- *         with the same address, and a cache flush operation could race and delete cache data
- *         for the new scope. This is extremely unlikely, and if it happens the cache will be
- *         repopulated on the next access.
- * - Since it's possible to have overlapping scopes, we de-dup stats when counters() or gauges() is
- *   called since these are very uncommon operations.
+ *   data owned by the destroyed scope. Its stats are then freed, returning their memory to the
+ *   allocator, once no other scope or caller holds them.
+ * - Thread local caches are keyed by a scope id that is never reused, rather than by the scope's
+ *   address. A scope that is created at the address of a destroyed one, as happens when a cluster
+ *   or listener is removed and added back, therefore never sees the stats of the destroyed scope
+ *   that a worker has not flushed yet, and the flush cannot drop the new scope's entries.
+ * - Since it's possible to have overlapping scopes, we de-dup stats when counters(), gauges(),
+ *   histograms() or the forEach*() variants are called. The forEach*() variants de-dup by
+ *   referencing the central cache keys, so iterating does not copy names or stat pointers.
+ * - Histograms are not delivered to sinks per sample. Each thread records into its own lock-free
+ *   buckets, which ParentHistogram::merge() aggregates on the main thread at flush time.
  * - Though this implementation is designed to work with a fixed shared memory space, it will fall
  *   back to heap allocated stats if needed. NOTE: In this case, overlapping scopes will not share
  *   the same backing store. This is to keep things simple, it could be done in the future if
@@ -53,9 +132,7 @@ public:
   // Stats::Scope
   Counter& counter(const std::string& name) override { return default_scope_->counter(name); }
   ScopePtr createScope(const std::string& name) override;
-  void deliverHistogramToSinks(const Histogram& histogram, uint64_t value) override {
-    return default_scope_->deliverHistogramToSinks(histogram, value);
-  }
+  void deliverHistogramToSinks(const Histogram&, uint64_t) override {}
   Gauge& gauge(const std::string& name) override { return default_scope_->gauge(name); }
   Histogram& histogram(const std::string& name) override {
     return default_scope_->histogram(name);
@@ -64,9 +141,12 @@ public:
   // Stats::Store
   std::list<CounterSharedPtr> counters() const override;
   std::list<GaugeSharedPtr> gauges() const override;
+  std::list<ParentHistogramSharedPtr> histograms() const override;
+  void forEachCounter(const std::function<void(Counter&)>& cb) const override;
+  void forEachGauge(const std::function<void(Gauge&)>& cb) const override;
+  void forEachHistogram(const std::function<void(ParentHistogram&)>& cb) const override;
 
   // Stats::StoreRoot
-  void addSink(Sink& sink) override { timer_sinks_.push_back(sink); }
   void setTagExtractors(const std::vector<TagExtractorPtr>& tag_extractors) override {
     tag_extractors_ = &tag_extractors;
   }
@@ -81,9 +161,16 @@ private:
     std::unordered_map<std::string, HistogramSharedPtr> histograms_;
   };
 
+  struct CentralCacheEntry {
+    ReadMostlyMap<CounterSharedPtr> counters_;
+    ReadMostlyMap<GaugeSharedPtr> gauges_;
+    ReadMostlyMap<ParentHistogramImplSharedPtr> histograms_;
+  };
+
   struct ScopeImpl : public Scope {
     ScopeImpl(ThreadLocalStoreImpl& parent, const std::string& prefix)
-        : parent_(parent), prefix_(Utility::sanitizeStatsName(prefix)) {}
+        : parent_(parent), scope_id_(parent.next_scope_id_++),
+          prefix_(Utility::sanitizeStatsName(prefix)) {}
     ~ScopeImpl();
 
     // Stats::Scope
@@ -91,17 +178,19 @@ private:
     ScopePtr createScope(const std::string& name) override {
       return parent_.createScope(prefix_ + name);
     }
-    void deliverHistogramToSinks(const Histogram& histogram, uint64_t value) override;
+    void deliverHistogramToSinks(const Histogram&, uint64_t) override {}
     Gauge& gauge(const std::string& name) override;
     Histogram& histogram(const std::string& name) override;
 
     ThreadLocalStoreImpl& parent_;
+    const uint64_t scope_id_;
     const std::string prefix_;
-    TlsCacheEntry central_cache_;
+    CentralCacheEntry central_cache_;
   };
 
   struct TlsCache : public ThreadLocal::ThreadLocalObject {
-    std::unordered_map<ScopeImpl*, TlsCacheEntry> scope_cache_;
+    // Keyed by ScopeImpl::scope_id_.
+    std::unordered_map<uint64_t, TlsCacheEntry> scope_cache_;
   };
 
   struct SafeAllocData {
@@ -109,8 +198,12 @@ private:
     RawStatDataAllocator& free_;
   };
 
+  template <class StatSharedPtr, class StatType>
+  void forEachStat(ReadMostlyMap<StatSharedPtr> CentralCacheEntry::*map,
+                   const std::function<void(StatType&)>& cb) const;
   std::string getTagsForName(const std::string& name, std::vector<Tag>& tags);
-  void clearScopeFromCaches(ScopeImpl* scope);
+  void clearScopeFromCaches(uint64_t scope_id);
+  std::unique_lock<std::mutex> lockCentralCache();
   void releaseScopeCrossThread(ScopeImpl* scope);
   SafeAllocData safeAlloc(const std::string& name);
 
@@ -118,9 +211,14 @@ private:
   Event::Dispatcher* main_thread_dispatcher_{};
   ThreadLocal::SlotPtr tls_;
   mutable std::mutex lock_;
+  // Declared before any scope so that it outlives every metric.
+  SymbolTable symbol_table_;
   std::unordered_set<ScopeImpl*> scopes_;
+  std::atomic<uint64_t> next_scope_id_{};
+  // Null while the store allocates them during construction, so declared before default_scope_.
+  Counter* central_cache_miss_{};
+  Counter* central_cache_lock_contended_{};
   ScopePtr default_scope_;
-  std::list<std::reference_wrapper<Sink>> timer_sinks_;
   const std::vector<TagExtractorPtr>* tag_extractors_{};
   std::atomic<bool> shutting_down_{};
   Counter& num_last_resort_stats_;
@@ -1,13 +1,15 @@
 #include "common/thread_local/thread_local_impl.h"
 
+#include <algorithm>
 #include <atomic>
 #include <cstdint>
 #include <list>
+#include <mutex>
+#include <vector>
 
 #include "envoy/event/dispatcher.h"
 
 #include "common/common/assert.h"
-#include "common/common/stl_helpers.h"
 
 namespace Envoy {
 namespace ThreadLocal {
@@ -49,8 +51,38 @@ void InstanceImpl::registerThread(Event::Dispatcher& dispatcher, bool main_threa
   if (main_thread) {
     main_thread_dispatcher_ = &dispatcher;
   } else {
-    ASSERT(!containsReference(registered_threads_, dispatcher));
-    registered_threads_.push_back(dispatcher);
+    ASSERT(std::find_if(registered_threads_.begin(), registered_threads_.end(),
+                        [&dispatcher](const RegisteredThread& thread) -> bool {
+                          return &thread.dispatcher_ == &dispatcher;
+                        }) == registered_threads_.end());
+    registered_threads_.emplace_back(dispatcher);
+  }
+}
+
+void InstanceImpl::RegisteredThread::post(Event::PostCb cb) {
+  bool do_post;
+  {
+    std::unique_lock<std::mutex> lock(lock_);
+    do_post = pending_.empty();
+    pending_.push_back(std::move(cb));
+  }
+
+  // Only the first update since the thread last ran its queue needs to wake it up. Every later
+  // update is queued before the posted callback runs, so ordering with other posts is kept.
+  if (do_post) {
+    dispatcher_.post([this]() -> void { runPending(); });
+  }
+}
+
+void InstanceImpl::RegisteredThread::runPending() {
+  std::vector<Event::PostCb> pending;
+  {
+    std::unique_lock<std::mutex> lock(lock_);
+    pending.swap(pending_);
+  }
+
+  for (const Event::PostCb& cb : pending) {
+    cb();
   }
 }
 
@@ -81,8 +113,8 @@ void InstanceImpl::runOnAllThreads(Event::PostCb cb) {
   ASSERT(std::this_thread::get_id() == main_thread_id_);
   ASSERT(!shutdown_);
 
-  for (Event::Dispatcher& dispatcher : registered_threads_) {
-    dispatcher.post(cb);
+  for (RegisteredThread& thread : registered_threads_) {
+    thread.post(cb);
   }
 
   // Handle main thread.
@@ -93,9 +125,10 @@ void InstanceImpl::SlotImpl::set(InitializeCb cb) {
   ASSERT(std::this_thread::get_id() == parent_.main_thread_id_);
   ASSERT(!parent_.shutdown_);
 
-  for (Event::Dispatcher& dispatcher : parent_.registered_threads_) {
+  for (RegisteredThread& thread : parent_.registered_threads_) {
     const uint32_t index = index_;
-    dispatcher.post([index, cb, &dispatcher]() -> void { setThreadLocal(index, cb(dispatcher)); });
+    Event::Dispatcher& dispatcher = thread.dispatcher_;
+    thread.post([index, cb, &dispatcher]() -> void { setThreadLocal(index, cb(dispatcher)); });
   }
 
   // Handle main thread.
@@ -3,6 +3,7 @@
 #include <atomic>
 #include <cstdint>
 #include <list>
+#include <mutex>
 #include <vector>
 
 #include "envoy/thread_local/thread_local.h"
@@ -44,13 +45,29 @@ private:
     std::vector<ThreadLocalObjectSharedPtr> data_;
   };
 
+  /**
+   * A registered worker thread. Updates for the thread are queued here rather than posted one by
+   * one, and the thread runs everything that is queued with a single post to its dispatcher. A
+   * config change that updates thousands of slots thus only posts once to each worker.
+   */
+  struct RegisteredThread {
+    RegisteredThread(Event::Dispatcher& dispatcher) : dispatcher_(dispatcher) {}
+
+    void post(Event::PostCb cb);
+    void runPending();
+
+    Event::Dispatcher& dispatcher_;
+    std::mutex lock_;
+    std::vector<Event::PostCb> pending_;
+  };
+
   void removeSlot(SlotImpl& slot);
   void runOnAllThreads(Event::PostCb cb);
   static void setThreadLocal(uint32_t index, ThreadLocalObjectSharedPtr object);
 
   static thread_local ThreadLocalData thread_local_data_;
   std::vector<SlotImpl*> slots_;
-  std::list<std::reference_wrapper<Event::Dispatcher>> registered_threads_;
+  std::list<RegisteredThread> registered_threads_;
   std::thread::id main_thread_id_;
   Event::Dispatcher* main_thread_dispatcher_{};
   std::atomic<bool> shutdown_{};
@@ -165,6 +165,38 @@ void HttpTracerUtility::finalizeSpan(Span& span, const Http::HeaderMap* request_
   span.finishSpan();
 }
 
+TailSampledSpan::TailSampledSpan(HttpTracer& tracer, const Config& config,
+                                 Http::HeaderMap& request_headers,
+                                 const RequestInfo::RequestInfo& request_info,
+                                 std::chrono::milliseconds latency_threshold)
+    : tracer_(tracer), config_(config), request_headers_(request_headers),
+      request_info_(request_info), latency_threshold_(latency_threshold) {}
+
+void TailSampledSpan::setTag(const std::string& name, const std::string& value) {
+  if (name == Tracing::Tags::get().ERROR) {
+    error_ = true;
+  }
+  tags_.emplace_back(name, value);
+}
+
+void TailSampledSpan::finishSpan() {
+  if (!error_ && request_info_.duration() < latency_threshold_) {
+    return;
+  }
+
+  SpanPtr span = tracer_.startSpan(config_, request_headers_, request_info_);
+  if (!span) {
+    return;
+  }
+  if (!operation_.empty()) {
+    span->setOperation(operation_);
+  }
+  for (const auto& tag : tags_) {
+    span->setTag(tag.first, tag.second);
+  }
+  span->finishSpan();
+}
+
 HttpTracerImpl::HttpTracerImpl(DriverPtr&& driver, const LocalInfo::LocalInfo& local_info)
     : driver_(std::move(driver)), local_info_(local_info) {}
 
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <chrono>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "envoy/local_info/local_info.h"
 #include "envoy/runtime/runtime.h"
@@ -140,6 +143,38 @@ public:
   }
 };
 
+/**
+ * A span for a request that was not sampled up front. It records what is done to it, and once the
+ * request finishes it only starts and finishes a span of the tracer if the request failed or took
+ * at least the latency threshold. Its context is not propagated, so the trace covers this hop only,
+ * and the spans spawned from it are not recorded.
+ */
+class TailSampledSpan : public Span {
+public:
+  TailSampledSpan(HttpTracer& tracer, const Config& config, Http::HeaderMap& request_headers,
+                  const RequestInfo::RequestInfo& request_info,
+                  std::chrono::milliseconds latency_threshold);
+
+  // Tracing::Span
+  void setOperation(const std::string& operation) override { operation_ = operation; }
+  void setTag(const std::string& name, const std::string& value) override;
+  void finishSpan() override;
+  void injectContext(Http::HeaderMap&) override {}
+  SpanPtr spawnChild(const Config&, const std::string&, SystemTime) override {
+    return SpanPtr{new NullSpan()};
+  }
+
+private:
+  HttpTracer& tracer_;
+  const Config& config_;
+  Http::HeaderMap& request_headers_;
+  const RequestInfo::RequestInfo& request_info_;
+  const std::chrono::milliseconds latency_threshold_;
+  std::string operation_;
+  std::vector<std::pair<std::string, std::string>> tags_;
+  bool error_{};
+};
+
 class HttpNullTracer : public HttpTracer {
 public:
   // Tracing::HttpTracer
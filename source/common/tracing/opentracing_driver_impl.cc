@@ -1,5 +1,6 @@
 #include "common/tracing/opentracing_driver_impl.h"
 
+#include <algorithm>
 #include <sstream>
 
 #include "common/common/assert.h"
@@ -10,6 +11,22 @@ namespace Envoy {
 namespace Tracing {
 
 namespace {
+// The number of bytes of span context that are encoded at a time. A multiple of 3, so that only the
+// last group is padded.
+constexpr uint64_t BASE64_CHUNK_BYTES = 96;
+
+// Base64 encodes input into header, a chunk at a time through the stack, so that the encoded
+// characters are written into the header's own storage without an intermediate string.
+void setBase64(const std::string& input, Http::HeaderString& header) {
+  char encoded[Base64::encodedLength(BASE64_CHUNK_BYTES)];
+  header.clear();
+  for (uint64_t i = 0; i < input.size(); i += BASE64_CHUNK_BYTES) {
+    const uint64_t length = std::min<uint64_t>(BASE64_CHUNK_BYTES, input.size() - i);
+    Base64::encode(input.data() + i, length, encoded);
+    header.append(encoded, Base64::encodedLength(length));
+  }
+}
+
 class OpenTracingHTTPHeadersWriter : public opentracing::HTTPHeadersWriter {
 public:
   explicit OpenTracingHTTPHeadersWriter(Http::HeaderMap& request_headers)
@@ -101,9 +118,7 @@ void OpenTracingSpan::injectContext(Http::HeaderMap& request_headers) {
       driver_.tracerStats().span_context_injection_error_.inc();
       return;
     }
-    const std::string current_span_context = oss.str();
-    request_headers.insertOtSpanContext().value(
-        Base64::encode(current_span_context.c_str(), current_span_context.length()));
+    setBase64(oss.str(), request_headers.insertOtSpanContext().value());
   } else {
     // Inject the context using the tracer's standard HTTP header format.
     const OpenTracingHTTPHeadersWriter writer{request_headers};
@@ -135,7 +150,9 @@ SpanPtr OpenTracingDriver::startSpan(const Config&, Http::HeaderMap& request_hea
   std::unique_ptr<opentracing::SpanContext> parent_span_ctx;
   if (propagation_mode == PropagationMode::SingleHeader && request_headers.OtSpanContext()) {
     opentracing::expected<std::unique_ptr<opentracing::SpanContext>> parent_span_ctx_maybe;
-    std::string parent_context = Base64::decode(request_headers.OtSpanContext()->value().c_str());
+    const Http::HeaderString& encoded_context = request_headers.OtSpanContext()->value();
+    const std::string parent_context =
+        Base64::decode(encoded_context.c_str(), encoded_context.size());
 
     if (!parent_context.empty()) {
       InputConstMemoryStream istream{parent_context.data(), parent_context.size()};
@@ -3,8 +3,7 @@
 namespace Envoy {
 namespace Zipkin {
 
-// TODO(fabolive): Need to avoid the copy to improve performance.
-bool SpanBuffer::addSpan(const Span& span) {
+bool SpanBuffer::addSpan(Span&& span) {
   if (span_buffer_.size() == span_buffer_.capacity()) {
     // Buffer full
     return false;
@@ -29,5 +28,25 @@ std::string SpanBuffer::toStringifiedJsonArray() {
 
   return stringified_json_array;
 }
+
+void SpanBuffer::serialize(Buffer::Instance& buffer, SpanEncoding encoding) {
+  if (encoding == SpanEncoding::Thrift) {
+    ThriftWriter writer(buffer);
+    writer.writeListBegin(ThriftWriter::Type::Struct, span_buffer_.size());
+    for (const Span& span : span_buffer_) {
+      span.toThrift(writer);
+    }
+    return;
+  }
+
+  buffer.add("[", 1);
+  for (uint64_t i = 0; i < span_buffer_.size(); i++) {
+    if (i > 0) {
+      buffer.add(",", 1);
+    }
+    buffer.add(span_buffer_[i].toJson());
+  }
+  buffer.add("]", 1);
+}
 } // namespace Zipkin
 } // namespace Envoy
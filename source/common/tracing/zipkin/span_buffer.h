@@ -1,10 +1,17 @@
 #pragma once
 
+#include "envoy/buffer/buffer.h"
+
 #include "common/tracing/zipkin/zipkin_core_types.h"
 
 namespace Envoy {
 namespace Zipkin {
 
+/**
+ * The encodings in which spans can be sent to a Zipkin collector.
+ */
+enum class SpanEncoding { Json, Thrift };
+
 /**
  * This class implements a simple buffer to store Zipkin tracing spans
  * prior to flushing them.
@@ -32,13 +39,13 @@ public:
   void allocateBuffer(uint64_t size) { span_buffer_.reserve(size); }
 
   /**
-   * Adds the given Zipkin span to the buffer.
+   * Moves the given Zipkin span into the buffer.
    *
    * @param span The span to be added to the buffer.
    *
    * @return true if the span was successfully added, or false if the buffer was full.
    */
-  bool addSpan(const Span& span);
+  bool addSpan(Span&& span);
 
   /**
    * Empties the buffer. This method is supposed to be called when all buffered spans
@@ -57,8 +64,17 @@ public:
    */
   std::string toStringifiedJsonArray();
 
+  /**
+   * Appends the contents of the buffer to a request body, as a JSON array or a Thrift list of
+   * spans, without first building the whole body as a string.
+   *
+   * @param buffer The buffer to append to.
+   * @param encoding The encoding of the spans.
+   */
+  void serialize(Buffer::Instance& buffer, SpanEncoding encoding);
+
 private:
-  // We use a pre-allocated vector to improve performance
+  // We use a pre-allocated vector to improve performance. Clearing it keeps its capacity.
   std::vector<Span> span_buffer_;
 };
 } // namespace Zipkin
@@ -1,64 +1,33 @@
 #include "common/tracing/zipkin/span_context.h"
 
-#include "common/common/macros.h"
-#include "common/common/utility.h"
 #include "common/tracing/zipkin/zipkin_core_constants.h"
 
 namespace Envoy {
 namespace Zipkin {
 
 namespace {
-// The functions below are needed due to the "C++ static initialization order fiasco."
-
-/**
- * @return String that separates the span-context fields in its string-serialized form.
- */
-static const std::string& fieldSeparator() { CONSTRUCT_ON_FIRST_USE(std::string, ";") }
-
 /**
- * @return String value corresponding to an empty span context.
+ * The character that separates the span-context fields in its string-serialized form.
  */
-static const std::string& unitializedSpanContext() {
-  CONSTRUCT_ON_FIRST_USE(std::string, "0000000000000000" + fieldSeparator() + "0000000000000000" +
-                                          fieldSeparator() + "0000000000000000");
-}
-
-/**
- * @return String with regular expression to match a 16-digit hexadecimal number.
- */
-static const std::string& hexDigitGroupRegexStr() {
-  CONSTRUCT_ON_FIRST_USE(std::string, "([0-9,a-z]{16})");
-}
-
-/**
- * @return a string with a regular expression to match a valid string-serialized span context.
- *
- * Note that a function is needed because we cannot concatenate static strings from
- * different compilation units at initialization time (the initialization order is not
- * guaranteed). In this case, the compilation units are ZipkinCoreConstants and SpanContext.
- */
-static const std::string& spanContextRegexStr() {
-  // ^([0-9,a-z]{16});([0-9,a-z]{16});([0-9,a-z]{16})((;(cs|sr|cr|ss))*)$
-  CONSTRUCT_ON_FIRST_USE(std::string, "^" + hexDigitGroupRegexStr() + fieldSeparator() +
-                                          hexDigitGroupRegexStr() + fieldSeparator() +
-                                          hexDigitGroupRegexStr() + "((" + fieldSeparator() + "(" +
-                                          ZipkinCoreConstants::get().CLIENT_SEND + "|" +
-                                          ZipkinCoreConstants::get().SERVER_RECV + "|" +
-                                          ZipkinCoreConstants::get().CLIENT_RECV + "|" +
-                                          ZipkinCoreConstants::get().SERVER_SEND + "))*)$");
-}
+constexpr char FIELD_SEPARATOR = ';';
 
 /**
- * @return a regex to match a valid string-serialization of a span context.
- *
- * Note that a function is needed because the string used to build the regex
- * cannot be initialized statically.
+ * @return whether the two characters at data are one of the annotations "cs", "sr", "cr" or "ss".
  */
-static const std::regex& spanContextRegex() {
-  CONSTRUCT_ON_FIRST_USE(std::regex, spanContextRegexStr());
+bool isAnnotation(const char* data) {
+  const ZipkinCoreConstantValues& constants = ZipkinCoreConstants::get();
+  for (const std::string* annotation : {&constants.CLIENT_SEND, &constants.SERVER_RECV,
+                                        &constants.CLIENT_RECV, &constants.SERVER_SEND}) {
+    if (annotation->compare(0, annotation->size(), data, 2) == 0) {
+      return true;
+    }
+  }
+  return false;
 }
 } // namespace
 
+const size_t SpanContext::SERIALIZED_LENGTH;
+
 SpanContext::SpanContext(const Span& span) {
   trace_id_ = span.traceId();
   id_ = span.id();
@@ -67,33 +36,53 @@ SpanContext::SpanContext(const Span& span) {
   is_initialized_ = true;
 }
 
-const std::string SpanContext::serializeToString() {
-  if (!is_initialized_) {
-    return unitializedSpanContext();
-  }
-
-  std::string result;
-  result = traceIdAsHexString() + fieldSeparator() + idAsHexString() + fieldSeparator() +
-           parentIdAsHexString();
+void SpanContext::serializeToBuffer(char* out) const {
+  // The ids of a context that is not initialized are all zero.
+  Hex::uint64ToHex(trace_id_, out);
+  out += Hex::UINT64_HEX_LENGTH;
+  *out++ = FIELD_SEPARATOR;
+  Hex::uint64ToHex(id_, out);
+  out += Hex::UINT64_HEX_LENGTH;
+  *out++ = FIELD_SEPARATOR;
+  Hex::uint64ToHex(parent_id_, out);
+}
 
+const std::string SpanContext::serializeToString() {
+  std::string result(SERIALIZED_LENGTH, '0');
+  serializeToBuffer(&result[0]);
   return result;
 }
 
-void SpanContext::populateFromString(const std::string& span_context_str) {
-  std::smatch match;
-
+void SpanContext::populateFromString(const char* data, size_t length) {
   trace_id_ = parent_id_ = id_ = 0;
+  is_initialized_ = false;
+
+  // <trace id>;<span id>;<parent id> followed by any number of ;<annotation>. The fields are
+  // parsed straight out of the given characters.
+  if (length < SERIALIZED_LENGTH || (length - SERIALIZED_LENGTH) % 3 != 0 ||
+      data[Hex::UINT64_HEX_LENGTH] != FIELD_SEPARATOR ||
+      data[2 * Hex::UINT64_HEX_LENGTH + 1] != FIELD_SEPARATOR) {
+    return;
+  }
+  for (size_t i = SERIALIZED_LENGTH; i < length; i += 3) {
+    if (data[i] != FIELD_SEPARATOR || !isAnnotation(data + i + 1)) {
+      return;
+    }
+  }
 
-  if (std::regex_search(span_context_str, match, spanContextRegex())) {
-    // This is a valid string encoding of the context
-    trace_id_ = std::stoull(match.str(1), nullptr, 16);
-    id_ = std::stoull(match.str(2), nullptr, 16);
-    parent_id_ = std::stoull(match.str(3), nullptr, 16);
-
-    is_initialized_ = true;
-  } else {
-    is_initialized_ = false;
+  uint64_t trace_id;
+  uint64_t id;
+  uint64_t parent_id;
+  if (!Hex::hexToUint64(data, trace_id) ||
+      !Hex::hexToUint64(data + Hex::UINT64_HEX_LENGTH + 1, id) ||
+      !Hex::hexToUint64(data + 2 * (Hex::UINT64_HEX_LENGTH + 1), parent_id)) {
+    return;
   }
+
+  trace_id_ = trace_id;
+  id_ = id;
+  parent_id_ = parent_id;
+  is_initialized_ = true;
 }
 } // namespace Zipkin
 } // namespace Envoy
@@ -1,6 +1,7 @@
 #pragma once
 
-#include <regex>
+#include <cstddef>
+#include <string>
 
 #include "common/tracing/zipkin/util.h"
 #include "common/tracing/zipkin/zipkin_core_types.h"
@@ -58,13 +59,32 @@ public:
    */
   const std::string serializeToString();
 
+  /**
+   * Serializes the SpanContext object in the format of serializeToString() into a caller supplied
+   * buffer, e.g. one on the stack that is then copied into a header's inline storage.
+   *
+   * @param out The buffer to write to, which must have room for SERIALIZED_LENGTH characters. No
+   * null terminator is written.
+   */
+  void serializeToBuffer(char* out) const;
+
   /**
    * Initializes a SpanContext object based on the given string.
    *
    * @param span_context_str The string-encoding of a SpanContext in the same format produced by the
    * method serializeToString().
    */
-  void populateFromString(const std::string& span_context_str);
+  void populateFromString(const std::string& span_context_str) {
+    populateFromString(span_context_str.data(), span_context_str.size());
+  }
+
+  /**
+   * Initializes a SpanContext object based on the given characters, which are parsed in place.
+   *
+   * @param data The string-encoding of a SpanContext, which need not be null terminated.
+   * @param length The number of characters in data.
+   */
+  void populateFromString(const char* data, size_t length);
 
   /**
    * @return the span id as an integer
@@ -96,6 +116,9 @@ public:
    */
   std::string traceIdAsHexString() const { return Hex::uint64ToHex(trace_id_); }
 
+  // The length of the string-encoding of a SpanContext without annotations.
+  static constexpr size_t SERIALIZED_LENGTH = 3 * Hex::UINT64_HEX_LENGTH + 2;
+
 private:
   uint64_t trace_id_;
   uint64_t id_;
@@ -25,7 +25,7 @@ SpanPtr Tracer::startSpan(const Tracing::Config& config, const std::string& span
   }
 
   // Create an all-new span, with no parent id
-  SpanPtr span_ptr(new Span());
+  SpanPtr span_ptr = newSpan();
   span_ptr->setName(span_name);
   uint64_t random_number = random_generator_.random();
   span_ptr->setId(random_number);
@@ -52,7 +52,7 @@ SpanPtr Tracer::startSpan(const Tracing::Config& config, const std::string& span
 
 SpanPtr Tracer::startSpan(const Tracing::Config& config, const std::string& span_name,
                           SystemTime timestamp, SpanContext& previous_context) {
-  SpanPtr span_ptr(new Span());
+  SpanPtr span_ptr = newSpan();
   Annotation annotation;
   uint64_t timestamp_micro;
 
@@ -113,6 +113,22 @@ SpanPtr Tracer::startSpan(const Tracing::Config& config, const std::string& span
   return span_ptr;
 }
 
+void Tracer::releaseSpan(SpanPtr&& span) {
+  if (span_pool_.size() < MaxPooledSpans) {
+    *span = Span();
+    span_pool_.push_back(std::move(span));
+  }
+}
+
+SpanPtr Tracer::newSpan() {
+  if (span_pool_.empty()) {
+    return SpanPtr{new Span()};
+  }
+  SpanPtr span = std::move(span_pool_.back());
+  span_pool_.pop_back();
+  return span;
+}
+
 void Tracer::reportSpan(Span&& span) {
   if (reporter_) {
     reporter_->reportSpan(std::move(span));
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <vector>
+
 #include "envoy/common/pure.h"
 #include "envoy/common/time.h"
 #include "envoy/runtime/runtime.h"
@@ -30,7 +32,7 @@ public:
    *
    * @param span The span that needs action.
    */
-  virtual void reportSpan(const Span& span) PURE;
+  virtual void reportSpan(Span&& span) PURE;
 };
 
 typedef std::unique_ptr<Reporter> ReporterPtr;
@@ -79,6 +81,14 @@ public:
   SpanPtr startSpan(const Tracing::Config&, const std::string& span_name, SystemTime timestamp,
                     SpanContext& previous_context);
 
+  /**
+   * Hands back a span created by startSpan() whose contents were moved elsewhere, so that a later
+   * startSpan() on this tracer reuses it instead of allocating a new one.
+   *
+   * @param span The span to be reused.
+   */
+  void releaseSpan(SpanPtr&& span);
+
   /**
    * TracerInterface::reportSpan.
    */
@@ -104,11 +114,17 @@ public:
    */
   Runtime::RandomGenerator& randomGenerator() { return random_generator_; }
 
+  // The maximum number of released spans that are kept for reuse.
+  static const size_t MaxPooledSpans = 128;
+
 private:
+  SpanPtr newSpan();
+
   const std::string service_name_;
   Network::Address::InstanceConstSharedPtr address_;
   ReporterPtr reporter_;
   Runtime::RandomGenerator& random_generator_;
+  std::vector<SpanPtr> span_pool_;
 };
 
 typedef std::unique_ptr<Tracer> TracerPtr;
@@ -54,5 +54,34 @@ uint64_t Util::generateRandom64() {
   std::mt19937_64 rand_64(seed);
   return rand_64();
 }
+
+void ThriftWriter::writeFieldBegin(Type type, int16_t id) {
+  writeByte(static_cast<uint8_t>(type));
+  writeI16(id);
+}
+
+void ThriftWriter::writeListBegin(Type element_type, uint32_t size) {
+  writeByte(static_cast<uint8_t>(element_type));
+  writeI32(size);
+}
+
+void ThriftWriter::writeI16(int16_t value) { writeBigEndian(static_cast<uint16_t>(value), 2); }
+
+void ThriftWriter::writeI32(int32_t value) { writeBigEndian(static_cast<uint32_t>(value), 4); }
+
+void ThriftWriter::writeI64(int64_t value) { writeBigEndian(static_cast<uint64_t>(value), 8); }
+
+void ThriftWriter::writeBinary(const void* data, uint32_t size) {
+  writeI32(size);
+  buffer_.add(data, size);
+}
+
+void ThriftWriter::writeBigEndian(uint64_t value, uint32_t size) {
+  uint8_t bytes[8];
+  for (uint32_t i = 0; i < size; i++) {
+    bytes[i] = value >> (8 * (size - i - 1));
+  }
+  buffer_.add(bytes, size);
+}
 } // namespace Zipkin
 } // namespace Envoy
@@ -1,8 +1,11 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
+#include "envoy/buffer/buffer.h"
+
 namespace Envoy {
 namespace Zipkin {
 
@@ -45,5 +48,53 @@ public:
    */
   static uint64_t generateRandom64();
 };
+
+/**
+ * Writes values in the Thrift binary protocol straight into a buffer, which is how Zipkin
+ * collectors expect spans with the application/x-thrift content type.
+ */
+class ThriftWriter {
+public:
+  enum class Type : uint8_t {
+    Stop = 0,
+    Bool = 2,
+    I16 = 6,
+    I32 = 8,
+    I64 = 10,
+    String = 11,
+    Struct = 12,
+    List = 15
+  };
+
+  ThriftWriter(Buffer::Instance& buffer) : buffer_(buffer) {}
+
+  /**
+   * Writes the header of a field of a struct, which is followed by its value.
+   */
+  void writeFieldBegin(Type type, int16_t id);
+
+  /**
+   * Writes the end of the fields of a struct.
+   */
+  void writeFieldStop() { writeByte(static_cast<uint8_t>(Type::Stop)); }
+
+  /**
+   * Writes the header of a list, which is followed by its size elements.
+   */
+  void writeListBegin(Type element_type, uint32_t size);
+
+  void writeBool(bool value) { writeByte(value ? 1 : 0); }
+  void writeI16(int16_t value);
+  void writeI32(int32_t value);
+  void writeI64(int64_t value);
+  void writeString(const std::string& value) { writeBinary(value.data(), value.size()); }
+  void writeBinary(const void* data, uint32_t size);
+
+private:
+  void writeByte(uint8_t value) { buffer_.add(&value, 1); }
+  void writeBigEndian(uint64_t value, uint32_t size);
+
+  Buffer::Instance& buffer_;
+};
 } // namespace Zipkin
 } // namespace Envoy
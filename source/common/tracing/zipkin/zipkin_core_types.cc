@@ -1,5 +1,9 @@
 #include "common/tracing/zipkin/zipkin_core_types.h"
 
+#include <arpa/inet.h>
+
+#include <array>
+
 #include "common/common/utility.h"
 #include "common/tracing/zipkin/span_context.h"
 #include "common/tracing/zipkin/util.h"
@@ -54,6 +58,29 @@ const std::string Endpoint::toJson() {
   return json_string;
 }
 
+void Endpoint::toThrift(ThriftWriter& writer) const {
+  uint32_t ipv4 = 0;
+  uint16_t port = 0;
+  if (address_) {
+    if (address_->ip()->version() == Network::Address::IpVersion::v4) {
+      ipv4 = ntohl(address_->ip()->ipv4()->address());
+    }
+    port = address_->ip()->port();
+  }
+  writer.writeFieldBegin(ThriftWriter::Type::I32, 1);
+  writer.writeI32(ipv4);
+  writer.writeFieldBegin(ThriftWriter::Type::I16, 2);
+  writer.writeI16(port);
+  writer.writeFieldBegin(ThriftWriter::Type::String, 3);
+  writer.writeString(service_name_);
+  if (address_ && address_->ip()->version() == Network::Address::IpVersion::v6) {
+    const std::array<uint8_t, 16> ipv6 = address_->ip()->ipv6()->address();
+    writer.writeFieldBegin(ThriftWriter::Type::String, 4);
+    writer.writeBinary(ipv6.data(), ipv6.size());
+  }
+  writer.writeFieldStop();
+}
+
 Annotation::Annotation(const Annotation& ann) {
   timestamp_ = ann.timestamp();
   value_ = ann.value();
@@ -98,6 +125,18 @@ const std::string Annotation::toJson() {
   return json_string;
 }
 
+void Annotation::toThrift(ThriftWriter& writer) const {
+  writer.writeFieldBegin(ThriftWriter::Type::I64, 1);
+  writer.writeI64(timestamp_);
+  writer.writeFieldBegin(ThriftWriter::Type::String, 2);
+  writer.writeString(value_);
+  if (endpoint_.valid()) {
+    writer.writeFieldBegin(ThriftWriter::Type::Struct, 3);
+    endpoint_.value().toThrift(writer);
+  }
+  writer.writeFieldStop();
+}
+
 BinaryAnnotation::BinaryAnnotation(const BinaryAnnotation& ann) {
   key_ = ann.key();
   value_ = ann.value();
@@ -138,6 +177,24 @@ const std::string BinaryAnnotation::toJson() {
   return json_string;
 }
 
+void BinaryAnnotation::toThrift(ThriftWriter& writer) const {
+  // The values of the AnnotationType enum of the Zipkin Thrift IDL.
+  static const int32_t THRIFT_BOOL = 0;
+  static const int32_t THRIFT_STRING = 6;
+
+  writer.writeFieldBegin(ThriftWriter::Type::String, 1);
+  writer.writeString(key_);
+  writer.writeFieldBegin(ThriftWriter::Type::String, 2);
+  writer.writeString(value_);
+  writer.writeFieldBegin(ThriftWriter::Type::I32, 3);
+  writer.writeI32(annotation_type_ == BOOL ? THRIFT_BOOL : THRIFT_STRING);
+  if (endpoint_.valid()) {
+    writer.writeFieldBegin(ThriftWriter::Type::Struct, 4);
+    endpoint_.value().toThrift(writer);
+  }
+  writer.writeFieldStop();
+}
+
 const std::string Span::EMPTY_HEX_STRING_ = "0000000000000000";
 
 Span::Span(const Span& span) {
@@ -217,6 +274,54 @@ const std::string Span::toJson() {
   return json_string;
 }
 
+void Span::toThrift(ThriftWriter& writer) const {
+  writer.writeFieldBegin(ThriftWriter::Type::I64, 1);
+  writer.writeI64(trace_id_);
+  writer.writeFieldBegin(ThriftWriter::Type::String, 3);
+  writer.writeString(name_);
+  writer.writeFieldBegin(ThriftWriter::Type::I64, 4);
+  writer.writeI64(id_);
+
+  if (parent_id_.valid() && parent_id_.value()) {
+    writer.writeFieldBegin(ThriftWriter::Type::I64, 5);
+    writer.writeI64(parent_id_.value());
+  }
+
+  writer.writeFieldBegin(ThriftWriter::Type::List, 6);
+  writer.writeListBegin(ThriftWriter::Type::Struct, annotations_.size());
+  for (const Annotation& annotation : annotations_) {
+    annotation.toThrift(writer);
+  }
+
+  writer.writeFieldBegin(ThriftWriter::Type::List, 8);
+  writer.writeListBegin(ThriftWriter::Type::Struct, binary_annotations_.size());
+  for (const BinaryAnnotation& binary_annotation : binary_annotations_) {
+    binary_annotation.toThrift(writer);
+  }
+
+  if (debug_) {
+    writer.writeFieldBegin(ThriftWriter::Type::Bool, 9);
+    writer.writeBool(true);
+  }
+
+  if (timestamp_.valid()) {
+    writer.writeFieldBegin(ThriftWriter::Type::I64, 10);
+    writer.writeI64(timestamp_.value());
+  }
+
+  if (duration_.valid()) {
+    writer.writeFieldBegin(ThriftWriter::Type::I64, 11);
+    writer.writeI64(duration_.value());
+  }
+
+  if (trace_id_high_.valid()) {
+    writer.writeFieldBegin(ThriftWriter::Type::I64, 12);
+    writer.writeI64(trace_id_high_.value());
+  }
+
+  writer.writeFieldStop();
+}
+
 void Span::finish() {
   // Assumption: Span will have only one annotation when this method is called
   SpanContext context(*this);
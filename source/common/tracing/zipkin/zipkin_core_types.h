@@ -29,6 +29,11 @@ public:
    * the corresponding abstraction to a Zipkin-compliant JSON.
    */
   virtual const std::string toJson() PURE;
+
+  /**
+   * Writes the object as a struct in the Thrift binary protocol.
+   */
+  virtual void toThrift(ThriftWriter& writer) const PURE;
 };
 
 /**
@@ -47,6 +52,12 @@ public:
    */
   Endpoint& operator=(const Endpoint&);
 
+  /**
+   * Move constructor and assignment operator.
+   */
+  Endpoint(Endpoint&&) = default;
+  Endpoint& operator=(Endpoint&&) = default;
+
   /**
    * Default constructor. Creates an empty Endpoint.
    */
@@ -88,6 +99,8 @@ public:
    */
   const std::string toJson() override;
 
+  void toThrift(ThriftWriter& writer) const override;
+
 private:
   std::string service_name_;
   Network::Address::InstanceConstSharedPtr address_;
@@ -109,6 +122,12 @@ public:
    */
   Annotation& operator=(const Annotation&);
 
+  /**
+   * Move constructor and assignment operator.
+   */
+  Annotation(Annotation&&) = default;
+  Annotation& operator=(Annotation&&) = default;
+
   /**
    * Default constructor. Creates an empty annotation.
    */
@@ -180,6 +199,8 @@ public:
    */
   const std::string toJson() override;
 
+  void toThrift(ThriftWriter& writer) const override;
+
 private:
   uint64_t timestamp_;
   std::string value_;
@@ -208,6 +229,12 @@ public:
    */
   BinaryAnnotation& operator=(const BinaryAnnotation&);
 
+  /**
+   * Move constructor and assignment operator.
+   */
+  BinaryAnnotation(BinaryAnnotation&&) = default;
+  BinaryAnnotation& operator=(BinaryAnnotation&&) = default;
+
   /**
    * Default constructor. Creates an empty binary annotation.
    */
@@ -279,6 +306,8 @@ public:
    */
   const std::string toJson() override;
 
+  void toThrift(ThriftWriter& writer) const override;
+
 private:
   std::string key_;
   std::string value_;
@@ -298,6 +327,17 @@ public:
    */
   Span(const Span&);
 
+  /**
+   * Assignment operator.
+   */
+  Span& operator=(const Span&) = default;
+
+  /**
+   * Move constructor and assignment operator.
+   */
+  Span(Span&&) = default;
+  Span& operator=(Span&&) = default;
+
   /**
    * Default constructor. Creates an empty span.
    */
@@ -347,7 +387,7 @@ public:
   /**
    * Adds an annotation to the span (move semantics).
    */
-  void addAnnotation(const Annotation&& ann) { annotations_.push_back(ann); }
+  void addAnnotation(Annotation&& ann) { annotations_.push_back(std::move(ann)); }
 
   /**
    * Sets the span's binary annotations all at once.
@@ -362,7 +402,9 @@ public:
   /**
    * Adds a binary annotation to the span (move semantics).
    */
-  void addBinaryAnnotation(const BinaryAnnotation&& bann) { binary_annotations_.push_back(bann); }
+  void addBinaryAnnotation(BinaryAnnotation&& bann) {
+    binary_annotations_.push_back(std::move(bann));
+  }
 
   /**
    * Sets the span's debug attribute.
@@ -496,6 +538,8 @@ public:
    */
   const std::string toJson() override;
 
+  void toThrift(ThriftWriter& writer) const override;
+
   /**
    * Associates a Tracer object with the span. The tracer's reportSpan() method is invoked
    * by the span's finish() method so that the tracer can decide what to do with the span
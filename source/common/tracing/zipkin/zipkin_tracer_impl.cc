@@ -1,6 +1,7 @@
 #include "common/tracing/zipkin/zipkin_tracer_impl.h"
 
 #include "common/common/enum_to_int.h"
+#include "common/common/hex.h"
 #include "common/common/utility.h"
 #include "common/http/headers.h"
 #include "common/http/message_impl.h"
@@ -13,7 +14,8 @@
 namespace Envoy {
 namespace Zipkin {
 
-ZipkinSpan::ZipkinSpan(Zipkin::Span& span, Zipkin::Tracer& tracer) : span_(span), tracer_(tracer) {}
+ZipkinSpan::ZipkinSpan(Zipkin::Span&& span, Zipkin::Tracer& tracer)
+    : span_(std::move(span)), tracer_(tracer) {}
 
 void ZipkinSpan::finishSpan() { span_.finish(); }
 
@@ -25,27 +27,35 @@ void ZipkinSpan::setTag(const std::string& name, const std::string& value) {
 
 void ZipkinSpan::injectContext(Http::HeaderMap& request_headers) {
   // Set the trace-id and span-id headers properly, based on the newly-created span structure.
-  request_headers.insertXB3TraceId().value(span_.traceIdAsHexString());
-  request_headers.insertXB3SpanId().value(span_.idAsHexString());
+  // The ids are formatted on the stack and copied into the headers' inline storage.
+  char id[Hex::UINT64_HEX_LENGTH];
+  Hex::uint64ToHex(span_.traceId(), id);
+  request_headers.insertXB3TraceId().value(id, sizeof(id));
+  Hex::uint64ToHex(span_.id(), id);
+  request_headers.insertXB3SpanId().value(id, sizeof(id));
 
   // Set the parent-span header properly, based on the newly-created span structure.
   if (span_.isSetParentId()) {
-    request_headers.insertXB3ParentSpanId().value(span_.parentIdAsHexString());
+    Hex::uint64ToHex(span_.parentId(), id);
+    request_headers.insertXB3ParentSpanId().value(id, sizeof(id));
   }
 
   // Set the sampled header.
   request_headers.insertXB3Sampled().value().setReference(ZipkinCoreConstants::get().ALWAYS_SAMPLE);
 
   // Set the ot-span-context header with the new context.
-  SpanContext context(span_);
-  request_headers.insertOtSpanContext().value(context.serializeToString());
+  char context[SpanContext::SERIALIZED_LENGTH];
+  SpanContext(span_).serializeToBuffer(context);
+  request_headers.insertOtSpanContext().value(context, sizeof(context));
 }
 
 Tracing::SpanPtr ZipkinSpan::spawnChild(const Tracing::Config& config, const std::string& name,
                                         SystemTime start_time) {
   SpanContext context(span_);
-  return Tracing::SpanPtr{
-      new ZipkinSpan(*tracer_.startSpan(config, name, start_time, context), tracer_)};
+  SpanPtr child = tracer_.startSpan(config, name, start_time, context);
+  Tracing::SpanPtr span{new ZipkinSpan(std::move(*child), tracer_)};
+  tracer_.releaseSpan(std::move(child));
+  return span;
 }
 
 Driver::TlsTracer::TlsTracer(TracerPtr&& tracer, Driver& driver)
@@ -67,13 +77,17 @@ Driver::Driver(const Json::Object& config, Upstream::ClusterManager& cluster_man
 
   const std::string collector_endpoint =
       config.getString("collector_endpoint", ZipkinCoreConstants::get().DEFAULT_COLLECTOR_ENDPOINT);
+  const SpanEncoding encoding = config.getString("collector_encoding", "json") == "thrift"
+                                    ? SpanEncoding::Thrift
+                                    : SpanEncoding::Json;
 
-  tls_->set([this, collector_endpoint, &random_generator](
+  tls_->set([this, collector_endpoint, encoding, &random_generator](
                 Event::Dispatcher& dispatcher) -> ThreadLocal::ThreadLocalObjectSharedPtr {
     TracerPtr tracer(
         new Tracer(local_info_.clusterName(), local_info_.address(), random_generator));
     tracer->setReporter(
-        ReporterImpl::NewInstance(std::ref(*this), std::ref(dispatcher), collector_endpoint));
+        ReporterImpl::NewInstance(std::ref(*this), std::ref(dispatcher), collector_endpoint,
+                                  encoding));
     return ThreadLocal::ThreadLocalObjectSharedPtr{new TlsTracer(std::move(tracer), *this)};
   });
 }
@@ -90,7 +104,8 @@ Tracing::SpanPtr Driver::startSpan(const Tracing::Config& config, Http::HeaderMa
     // properly set the span id and the parent span id.
     SpanContext context;
 
-    context.populateFromString(request_headers.OtSpanContext()->value().c_str());
+    const Http::HeaderString& span_context = request_headers.OtSpanContext()->value();
+    context.populateFromString(span_context.c_str(), span_context.size());
 
     // Create either a child or a shared-context Zipkin span.
     //
@@ -125,13 +140,14 @@ Tracing::SpanPtr Driver::startSpan(const Tracing::Config& config, Http::HeaderMa
     new_zipkin_span = tracer.startSpan(config, request_headers.Host()->value().c_str(), start_time);
   }
 
-  ZipkinSpanPtr active_span(new ZipkinSpan(*new_zipkin_span, tracer));
+  ZipkinSpanPtr active_span(new ZipkinSpan(std::move(*new_zipkin_span), tracer));
+  tracer.releaseSpan(std::move(new_zipkin_span));
   return std::move(active_span);
 }
 
 ReporterImpl::ReporterImpl(Driver& driver, Event::Dispatcher& dispatcher,
-                           const std::string& collector_endpoint)
-    : driver_(driver), collector_endpoint_(collector_endpoint) {
+                           const std::string& collector_endpoint, SpanEncoding encoding)
+    : driver_(driver), collector_endpoint_(collector_endpoint), encoding_(encoding) {
   flush_timer_ = dispatcher.createTimer([this]() -> void {
     driver_.tracerStats().timer_flushed_.inc();
     flushSpans();
@@ -146,13 +162,13 @@ ReporterImpl::ReporterImpl(Driver& driver, Event::Dispatcher& dispatcher,
 }
 
 ReporterPtr ReporterImpl::NewInstance(Driver& driver, Event::Dispatcher& dispatcher,
-                                      const std::string& collector_endpoint) {
-  return ReporterPtr(new ReporterImpl(driver, dispatcher, collector_endpoint));
+                                      const std::string& collector_endpoint,
+                                      SpanEncoding encoding) {
+  return ReporterPtr(new ReporterImpl(driver, dispatcher, collector_endpoint, encoding));
 }
 
-// TODO(fabolive): Need to avoid the copy to improve performance.
-void ReporterImpl::reportSpan(const Span& span) {
-  span_buffer_.addSpan(span);
+void ReporterImpl::reportSpan(Span&& span) {
+  span_buffer_.addSpan(std::move(span));
 
   const uint64_t min_flush_spans =
       driver_.runtime().snapshot().getInteger("tracing.zipkin.min_flush_spans", 5U);
@@ -172,16 +188,16 @@ void ReporterImpl::flushSpans() {
   if (span_buffer_.pendingSpans()) {
     driver_.tracerStats().spans_sent_.add(span_buffer_.pendingSpans());
 
-    const std::string request_body = span_buffer_.toStringifiedJsonArray();
     Http::MessagePtr message(new Http::RequestMessageImpl());
     message->headers().insertMethod().value().setReference(Http::Headers::get().MethodValues.Post);
     message->headers().insertPath().value(collector_endpoint_);
     message->headers().insertHost().value(driver_.cluster()->name());
     message->headers().insertContentType().value().setReference(
-        Http::Headers::get().ContentTypeValues.Json);
+        encoding_ == SpanEncoding::Thrift ? ZipkinCoreConstants::get().THRIFT_CONTENT_TYPE
+                                          : Http::Headers::get().ContentTypeValues.Json);
 
     Buffer::InstancePtr body(new Buffer::OwnedImpl());
-    body->add(request_body);
+    span_buffer_.serialize(*body, encoding_);
     message->body() = std::move(body);
 
     const uint64_t timeout =
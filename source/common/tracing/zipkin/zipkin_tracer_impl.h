@@ -35,7 +35,7 @@ public:
    *
    * @param span to be wrapped.
    */
-  ZipkinSpan(Zipkin::Span& span, Zipkin::Tracer& tracer);
+  ZipkinSpan(Zipkin::Span&& span, Zipkin::Tracer& tracer);
 
   /**
    * Calls Zipkin::Span::finishSpan() to perform all actions needed to finalize the span.
@@ -129,7 +129,7 @@ private:
 /**
  * This class derives from the abstract Zipkin::Reporter.
  * It buffers spans and relies on Http::AsyncClient to send spans to
- * Zipkin using JSON over HTTP.
+ * Zipkin using JSON or Thrift over HTTP.
  *
  * Two runtime parameters control the span buffering/flushing behavior, namely:
  * tracing.zipkin.min_flush_spans and tracing.zipkin.flush_interval_ms.
@@ -150,9 +150,10 @@ public:
    * @param collector_endpoint String representing the Zipkin endpoint to be used
    * when making HTTP POST requests carrying spans. This value comes from the
    * Zipkin-related tracing configuration.
+   * @param encoding The encoding of the spans in the POST requests.
    */
   ReporterImpl(Driver& driver, Event::Dispatcher& dispatcher,
-               const std::string& collector_endpoint);
+               const std::string& collector_endpoint, SpanEncoding encoding = SpanEncoding::Json);
 
   /**
    * Implementation of Zipkin::Reporter::reportSpan().
@@ -161,7 +162,7 @@ public:
    *
    * @param span The span to be buffered.
    */
-  void reportSpan(const Span& span) override;
+  void reportSpan(Span&& span) override;
 
   // Http::AsyncClient::Callbacks.
   // The callbacks below record Zipkin-span-related stats.
@@ -176,11 +177,13 @@ public:
    * @param collector_endpoint String representing the Zipkin endpoint to be used
    * when making HTTP POST requests carrying spans. This value comes from the
    * Zipkin-related tracing configuration.
+   * @param encoding The encoding of the spans in the POST requests.
    *
    * @return Pointer to the newly-created ZipkinReporter.
    */
   static ReporterPtr NewInstance(Driver& driver, Event::Dispatcher& dispatcher,
-                                 const std::string& collector_endpoint);
+                                 const std::string& collector_endpoint,
+                                 SpanEncoding encoding = SpanEncoding::Json);
 
 private:
   /**
@@ -197,6 +200,7 @@ private:
   Event::TimerPtr flush_timer_;
   SpanBuffer span_buffer_;
   const std::string collector_endpoint_;
+  const SpanEncoding encoding_;
 };
 } // Zipkin
 } // namespace Envoy
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "common/common/assert.h"
+
+namespace Envoy {
+namespace Upstream {
+
+/**
+ * Walker's alias method for weighted picks. Building the table is O(n) and every pick is O(1)
+ * with a single random value, so it suits weights that change much less often than they are
+ * picked from. Each of the n columns holds 1/n of the total weight: the share of its own entry
+ * up to a threshold, and the rest from one other (alias) entry.
+ */
+class AliasTable {
+public:
+  AliasTable() {}
+
+  /**
+   * @param weights supplies the weight of each entry. Entries with a weight of 0 are never picked.
+   */
+  AliasTable(const std::vector<uint64_t>& weights) {
+    const uint64_t n = weights.size();
+    for (uint64_t weight : weights) {
+      total_ += weight;
+    }
+    if (total_ == 0) {
+      return;
+    }
+
+    // Weights are scaled by n, so that every column holds exactly total_ of scaled weight.
+    columns_.resize(n);
+    std::vector<uint64_t> scaled(n);
+    std::vector<uint32_t> small;
+    std::vector<uint32_t> large;
+    for (uint32_t i = 0; i < n; i++) {
+      scaled[i] = weights[i] * n;
+      (scaled[i] < total_ ? small : large).push_back(i);
+    }
+
+    // Fill each column that is short of total_ with weight from an entry that has too much.
+    while (!small.empty() && !large.empty()) {
+      const uint32_t s = small.back();
+      small.pop_back();
+      const uint32_t l = large.back();
+      large.pop_back();
+
+      columns_[s] = {scaled[s], l};
+      scaled[l] -= total_ - scaled[s];
+      (scaled[l] < total_ ? small : large).push_back(l);
+    }
+
+    // Whatever is left holds exactly total_, up to rounding, and needs no alias.
+    for (uint32_t i : large) {
+      columns_[i] = {total_, i};
+    }
+    for (uint32_t i : small) {
+      columns_[i] = {total_, i};
+    }
+  }
+
+  /**
+   * @return bool whether there is nothing to pick, because there are no entries or all weights are
+   *         0.
+   */
+  bool empty() const { return columns_.empty(); }
+
+  /**
+   * Pick an entry in proportion to its weight. The table must not be empty.
+   * @param random supplies a random value. The value modulo the number of columns picks the
+   *        column, and the quotient picks between the column's entry and its alias.
+   * @return uint32_t the index of the picked entry.
+   */
+  uint32_t pick(uint64_t random) const {
+    ASSERT(!empty());
+    const uint32_t index = random % columns_.size();
+    if ((random / columns_.size()) % total_ < columns_[index].threshold_) {
+      return index;
+    }
+    return columns_[index].alias_;
+  }
+
+private:
+  struct Column {
+    // The column picks its own entry if the random value is below threshold_, out of total_.
+    uint64_t threshold_;
+    uint32_t alias_;
+  };
+
+  uint64_t total_{};
+  std::vector<Column> columns_;
+};
+
+} // namespace Upstream
+} // namespace Envoy
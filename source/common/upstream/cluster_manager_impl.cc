@@ -11,6 +11,7 @@
 #include "envoy/network/dns.h"
 #include "envoy/runtime/runtime.h"
 
+#include "common/common/assert.h"
 #include "common/common/enum_to_int.h"
 #include "common/common/utility.h"
 #include "common/config/cds_json.h"
@@ -25,6 +26,7 @@
 #include "common/router/shadow_writer_impl.h"
 #include "common/upstream/cds_api_impl.h"
 #include "common/upstream/load_balancer_impl.h"
+#include "common/upstream/maglev_lb.h"
 #include "common/upstream/original_dst_cluster.h"
 #include "common/upstream/ring_hash_lb.h"
 #include "common/upstream/subset_lb.h"
@@ -228,6 +230,11 @@ ClusterManagerImpl::ClusterManagerImpl(const envoy::api::v2::Bootstrap& bootstra
     }
   }
 
+  // With thousands of clusters of which a worker only uses a few, creating every cluster's load
+  // balancer and async client on every worker dominates memory, so this can be deferred.
+  lazy_thread_local_clusters_ =
+      runtime_.snapshot().getInteger("upstream.lazy_thread_local_clusters", 0) != 0;
+
   tls_->set([this, local_cluster_name](
                 Event::Dispatcher& dispatcher) -> ThreadLocal::ThreadLocalObjectSharedPtr {
     return ThreadLocal::ThreadLocalObjectSharedPtr{
@@ -291,19 +298,21 @@ bool ClusterManagerImpl::addOrUpdatePrimaryCluster(const envoy::api::v2::Cluster
 
   loadCluster(cluster, true);
   ClusterInfoConstSharedPtr new_cluster = primary_clusters_.at(cluster_name).cluster_->info();
+  LoadBalancerFactorySharedPtr lb_factory =
+      primary_clusters_.at(cluster_name).loadBalancerFactory();
   ENVOY_LOG(info, "add/update cluster {}", cluster_name);
-  tls_->runOnAllThreads([this, new_cluster]() -> void {
+  tls_->runOnAllThreads([this, new_cluster, lb_factory]() -> void {
     ThreadLocalClusterManagerImpl& cluster_manager =
         tls_->getTyped<ThreadLocalClusterManagerImpl>();
 
-    if (cluster_manager.thread_local_clusters_.count(new_cluster->name()) > 0) {
+    if (cluster_manager.thread_local_clusters_.count(new_cluster->name()) > 0 ||
+        cluster_manager.lazy_clusters_.count(new_cluster->name()) > 0) {
       ENVOY_LOG(debug, "updating TLS cluster {}", new_cluster->name());
     } else {
       ENVOY_LOG(debug, "adding TLS cluster {}", new_cluster->name());
     }
 
-    cluster_manager.thread_local_clusters_[new_cluster->name()].reset(
-        new ThreadLocalClusterManagerImpl::ClusterEntry(cluster_manager, new_cluster));
+    cluster_manager.addCluster(new_cluster, lb_factory);
   });
 
   postInitializeCluster(*primary_clusters_.at(cluster_name).cluster_);
@@ -325,9 +334,12 @@ bool ClusterManagerImpl::removePrimaryCluster(const std::string& cluster_name) {
     ThreadLocalClusterManagerImpl& cluster_manager =
         tls_->getTyped<ThreadLocalClusterManagerImpl>();
 
-    ASSERT(cluster_manager.thread_local_clusters_.count(cluster_name) == 1);
+    ASSERT(cluster_manager.thread_local_clusters_.count(cluster_name) +
+               cluster_manager.lazy_clusters_.count(cluster_name) ==
+           1);
     ENVOY_LOG(debug, "removing TLS cluster {}", cluster_name);
     cluster_manager.thread_local_clusters_.erase(cluster_name);
+    cluster_manager.lazy_clusters_.erase(cluster_name);
   });
 
   return true;
@@ -345,6 +357,21 @@ void ClusterManagerImpl::loadCluster(const envoy::api::v2::Cluster& cluster, boo
     }
   }
 
+  // Load balancers that share their work with workers update on the main thread first, so they
+  // are up to date by the time workers apply the update posted below.
+  ThreadAwareLoadBalancerPtr thread_aware_lb;
+  if (!new_cluster->info()->lbSubsetInfo().isEnabled()) {
+    if (new_cluster->info()->lbType() == LoadBalancerType::RingHash) {
+      thread_aware_lb.reset(new RingHashLoadBalancer(new_cluster->prioritySet(),
+                                                     new_cluster->info()->stats(), runtime_,
+                                                     random_,
+                                                     new_cluster->info()->lbRingHashConfig()));
+    } else if (new_cluster->info()->lbType() == LoadBalancerType::Maglev) {
+      thread_aware_lb.reset(new MaglevLoadBalancer(
+          new_cluster->prioritySet(), new_cluster->info()->stats(), runtime_, random_));
+    }
+  }
+
   const Cluster& primary_cluster_reference = *new_cluster;
   new_cluster->prioritySet().addMemberUpdateCb(
       [&primary_cluster_reference, this](uint32_t priority,
@@ -377,7 +404,8 @@ void ClusterManagerImpl::loadCluster(const envoy::api::v2::Cluster& cluster, boo
   size_t num_erased = primary_clusters_.erase(primary_cluster_reference.info()->name());
   primary_clusters_.emplace(
       primary_cluster_reference.info()->name(),
-      PrimaryClusterData{MessageUtil::hash(cluster), added_via_api, std::move(new_cluster)});
+      PrimaryClusterData{MessageUtil::hash(cluster), added_via_api, std::move(new_cluster),
+                         std::move(thread_aware_lb)});
 
   cm_stats_.total_clusters_.set(primary_clusters_.size());
   if (num_erased) {
@@ -389,13 +417,35 @@ void ClusterManagerImpl::loadCluster(const envoy::api::v2::Cluster& cluster, boo
 
 ThreadLocalCluster* ClusterManagerImpl::get(const std::string& cluster) {
   ThreadLocalClusterManagerImpl& cluster_manager = tls_->getTyped<ThreadLocalClusterManagerImpl>();
+  return cluster_manager.getCluster(cluster);
+}
 
-  auto entry = cluster_manager.thread_local_clusters_.find(cluster);
-  if (entry != cluster_manager.thread_local_clusters_.end()) {
-    return entry->second.get();
-  } else {
+ClusterHandleConstSharedPtr ClusterManagerImpl::clusterHandle(const std::string& cluster) {
+  return std::make_shared<const ClusterHandleImpl>(*this, cluster, clusterId(cluster));
+}
+
+uint32_t ClusterManagerImpl::clusterId(const std::string& name) {
+  std::unique_lock<std::mutex> lock(cluster_ids_lock_);
+  return cluster_ids_.emplace(name, cluster_ids_.size()).first->second;
+}
+
+ThreadLocalCluster* ClusterManagerImpl::ClusterHandleImpl::get() const {
+  ThreadLocalClusterManagerImpl& cluster_manager =
+      parent_.tls_->getTyped<ThreadLocalClusterManagerImpl>();
+  return cluster_manager.getCluster(id_, name_);
+}
+
+Http::ConnectionPool::Instance*
+ClusterManagerImpl::ClusterHandleImpl::httpConnPool(ResourcePriority priority,
+                                                    LoadBalancerContext* context) const {
+  ThreadLocalClusterManagerImpl& cluster_manager =
+      parent_.tls_->getTyped<ThreadLocalClusterManagerImpl>();
+  ThreadLocalClusterManagerImpl::ClusterEntry* entry = cluster_manager.getCluster(id_, name_);
+  if (entry == nullptr) {
     return nullptr;
   }
+
+  return entry->connPool(priority, context);
 }
 
 Http::ConnectionPool::Instance*
@@ -403,13 +453,13 @@ ClusterManagerImpl::httpConnPoolForCluster(const std::string& cluster, ResourceP
                                            LoadBalancerContext* context) {
   ThreadLocalClusterManagerImpl& cluster_manager = tls_->getTyped<ThreadLocalClusterManagerImpl>();
 
-  auto entry = cluster_manager.thread_local_clusters_.find(cluster);
-  if (entry == cluster_manager.thread_local_clusters_.end()) {
+  ThreadLocalClusterManagerImpl::ClusterEntry* entry = cluster_manager.getCluster(cluster);
+  if (entry == nullptr) {
     return nullptr;
   }
 
   // Select a host and create a connection pool for it if it does not already exist.
-  return entry->second->connPool(priority, context);
+  return entry->connPool(priority, context);
 }
 
 void ClusterManagerImpl::postThreadLocalClusterUpdate(
@@ -453,25 +503,25 @@ Host::CreateConnectionData ClusterManagerImpl::tcpConnForCluster(const std::stri
                                                                  LoadBalancerContext* context) {
   ThreadLocalClusterManagerImpl& cluster_manager = tls_->getTyped<ThreadLocalClusterManagerImpl>();
 
-  auto entry = cluster_manager.thread_local_clusters_.find(cluster);
-  if (entry == cluster_manager.thread_local_clusters_.end()) {
+  ThreadLocalClusterManagerImpl::ClusterEntry* entry = cluster_manager.getCluster(cluster);
+  if (entry == nullptr) {
     throw EnvoyException(fmt::format("unknown cluster '{}'", cluster));
   }
 
-  HostConstSharedPtr logical_host = entry->second->lb_->chooseHost(context);
+  HostConstSharedPtr logical_host = entry->lb_->chooseHost(context);
   if (logical_host) {
     return logical_host->createConnection(cluster_manager.thread_local_dispatcher_);
   } else {
-    entry->second->cluster_info_->stats().upstream_cx_none_healthy_.inc();
+    entry->cluster_info_->stats().upstream_cx_none_healthy_.inc();
     return {nullptr, nullptr};
   }
 }
 
 Http::AsyncClient& ClusterManagerImpl::httpAsyncClientForCluster(const std::string& cluster) {
   ThreadLocalClusterManagerImpl& cluster_manager = tls_->getTyped<ThreadLocalClusterManagerImpl>();
-  auto entry = cluster_manager.thread_local_clusters_.find(cluster);
-  if (entry != cluster_manager.thread_local_clusters_.end()) {
-    return entry->second->http_async_client_;
+  ThreadLocalClusterManagerImpl::ClusterEntry* entry = cluster_manager.getCluster(cluster);
+  if (entry != nullptr) {
+    return entry->http_async_client_;
   } else {
     throw EnvoyException(fmt::format("unknown cluster '{}'", cluster));
   }
@@ -491,9 +541,9 @@ ClusterManagerImpl::ThreadLocalClusterManagerImpl::ThreadLocalClusterManagerImpl
   // If local cluster is defined then we need to initialize it first.
   if (local_cluster_name.valid()) {
     ENVOY_LOG(debug, "adding TLS local cluster {}", local_cluster_name.value());
-    auto& local_cluster = parent.primary_clusters_.at(local_cluster_name.value()).cluster_;
-    thread_local_clusters_[local_cluster_name.value()].reset(
-        new ClusterEntry(*this, local_cluster->info()));
+    auto& local_cluster = parent.primary_clusters_.at(local_cluster_name.value());
+    thread_local_clusters_[local_cluster_name.value()].reset(new ClusterEntry(
+        *this, local_cluster.cluster_->info(), local_cluster.loadBalancerFactory()));
   }
 
   local_priority_set_ = local_cluster_name.valid()
@@ -508,8 +558,7 @@ ClusterManagerImpl::ThreadLocalClusterManagerImpl::ThreadLocalClusterManagerImpl
 
     ENVOY_LOG(debug, "adding TLS initial cluster {}", cluster.first);
     ASSERT(thread_local_clusters_.count(cluster.first) == 0);
-    thread_local_clusters_[cluster.first].reset(
-        new ClusterEntry(*this, cluster.second.cluster_->info()));
+    addCluster(cluster.second.cluster_->info(), cluster.second.loadBalancerFactory());
   }
 }
 
@@ -530,6 +579,63 @@ ClusterManagerImpl::ThreadLocalClusterManagerImpl::~ThreadLocalClusterManagerImp
   thread_local_clusters_.clear();
 }
 
+void ClusterManagerImpl::ThreadLocalClusterManagerImpl::addCluster(
+    ClusterInfoConstSharedPtr cluster, LoadBalancerFactorySharedPtr lb_factory) {
+  const std::string& name = cluster->name();
+  // The original destination load balancer reads the primary cluster when it is created, which is
+  // only safe while the main thread waits for this update, so it is never deferred.
+  if (parent_.lazy_thread_local_clusters_ && cluster->lbType() != LoadBalancerType::OriginalDst) {
+    thread_local_clusters_.erase(name);
+    lazy_clusters_[name] = LazyCluster{cluster, lb_factory, {}};
+  } else {
+    lazy_clusters_.erase(name);
+    thread_local_clusters_[name].reset(new ClusterEntry(*this, cluster, lb_factory));
+  }
+}
+
+ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry*
+ClusterManagerImpl::ThreadLocalClusterManagerImpl::getCluster(uint32_t id,
+                                                              const std::string& name) {
+  if (id < clusters_by_id_.size() && clusters_by_id_[id] != nullptr) {
+    return clusters_by_id_[id];
+  }
+
+  // The cluster does not exist or its entry has not been created yet.
+  return getCluster(name);
+}
+
+ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry*
+ClusterManagerImpl::ThreadLocalClusterManagerImpl::getCluster(const std::string& name) {
+  auto entry = thread_local_clusters_.find(name);
+  if (entry != thread_local_clusters_.end()) {
+    return entry->second.get();
+  }
+
+  auto lazy_cluster = lazy_clusters_.find(name);
+  if (lazy_cluster == lazy_clusters_.end()) {
+    return nullptr;
+  }
+
+  ENVOY_LOG(debug, "creating TLS cluster {} on first use", name);
+  ClusterEntry* new_entry =
+      new ClusterEntry(*this, lazy_cluster->second.cluster_info_, lazy_cluster->second.lb_factory_);
+  thread_local_clusters_[name].reset(new_entry);
+  const std::vector<LazyCluster::HostSetSnapshot> host_sets =
+      std::move(lazy_cluster->second.host_sets_);
+  lazy_clusters_.erase(lazy_cluster);
+  for (uint32_t priority = 0; priority < host_sets.size(); priority++) {
+    const LazyCluster::HostSetSnapshot& host_set = host_sets[priority];
+    if (host_set.hosts_ == nullptr) {
+      continue;
+    }
+    new_entry->priority_set_.getOrCreateHostSet(priority).updateHosts(
+        host_set.hosts_, host_set.healthy_hosts_, host_set.hosts_per_locality_,
+        host_set.healthy_hosts_per_locality_, *host_set.hosts_, {});
+  }
+
+  return new_entry;
+}
+
 void ClusterManagerImpl::ThreadLocalClusterManagerImpl::drainConnPools(
     const std::vector<HostSharedPtr>& hosts) {
   for (const HostSharedPtr& host : hosts) {
@@ -583,6 +689,18 @@ void ClusterManagerImpl::ThreadLocalClusterManagerImpl::updateClusterMembership(
 
   ThreadLocalClusterManagerImpl& config = tls.getTyped<ThreadLocalClusterManagerImpl>();
 
+  auto lazy_cluster = config.lazy_clusters_.find(name);
+  if (lazy_cluster != config.lazy_clusters_.end()) {
+    // Only keep the latest membership until the cluster is used.
+    std::vector<LazyCluster::HostSetSnapshot>& host_sets = lazy_cluster->second.host_sets_;
+    if (host_sets.size() <= priority) {
+      host_sets.resize(priority + 1);
+    }
+    host_sets[priority] = {std::move(hosts), std::move(healthy_hosts),
+                           std::move(hosts_per_locality), std::move(healthy_hosts_per_locality)};
+    return;
+  }
+
   ASSERT(config.thread_local_clusters_.find(name) != config.thread_local_clusters_.end());
   config.thread_local_clusters_[name]->priority_set_.getOrCreateHostSet(priority).updateHosts(
       std::move(hosts), std::move(healthy_hosts), std::move(hosts_per_locality),
@@ -612,15 +730,24 @@ void ClusterManagerImpl::ThreadLocalClusterManagerImpl::onHostHealthFailure(
 }
 
 ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::ClusterEntry(
-    ThreadLocalClusterManagerImpl& parent, ClusterInfoConstSharedPtr cluster)
-    : parent_(parent), cluster_info_(cluster),
+    ThreadLocalClusterManagerImpl& parent, ClusterInfoConstSharedPtr cluster,
+    LoadBalancerFactorySharedPtr lb_factory)
+    : parent_(parent), id_(parent.parent_.clusterId(cluster->name())), cluster_info_(cluster),
+      lb_factory_(lb_factory),
       http_async_client_(*cluster, parent.parent_.stats_, parent.thread_local_dispatcher_,
                          parent.parent_.local_info_, parent.parent_, parent.parent_.runtime_,
                          parent.parent_.random_,
                          Router::ShadowWriterPtr{new Router::ShadowWriterImpl(parent.parent_)}) {
   priority_set_.getOrCreateHostSet(0);
+  // An entry that replaces one of the same cluster is created before the old one is destroyed.
+  if (id_ >= parent_.clusters_by_id_.size()) {
+    parent_.clusters_by_id_.resize(id_ + 1);
+  }
+  parent_.clusters_by_id_[id_] = this;
 
-  if (cluster->lbSubsetInfo().isEnabled()) {
+  if (lb_factory_ != nullptr) {
+    lb_ = lb_factory_->create();
+  } else if (cluster->lbSubsetInfo().isEnabled()) {
     lb_.reset(new SubsetLoadBalancer(cluster->lbType(), priority_set_, parent_.local_priority_set_,
                                      cluster->stats(), parent.parent_.runtime_,
                                      parent.parent_.random_, cluster->lbSubsetInfo(),
@@ -644,10 +771,10 @@ ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::ClusterEntry(
                                            parent.parent_.random_));
       break;
     }
-    case LoadBalancerType::RingHash: {
-      lb_.reset(new RingHashLoadBalancer(priority_set_, cluster->stats(), parent.parent_.runtime_,
-                                         parent.parent_.random_, cluster->lbRingHashConfig()));
-      break;
+    case LoadBalancerType::RingHash:
+    case LoadBalancerType::Maglev: {
+      // These are built on the main thread and handed out through lb_factory_.
+      NOT_REACHED;
     }
     case LoadBalancerType::OriginalDst: {
       lb_.reset(new OriginalDstCluster::LoadBalancer(
@@ -663,6 +790,11 @@ ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::ClusterEntry(
     // Even if two hosts actually point to the same address this will be safe, since if a
     // host is readded it will be a different physical HostSharedPtr.
     parent_.drainConnPools(hosts_removed);
+
+    // The main thread has already built the load balancer state for these hosts.
+    if (lb_factory_ != nullptr) {
+      lb_ = lb_factory_->create();
+    }
   });
 }
 
@@ -676,6 +808,10 @@ ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::~ClusterEntry()
   for (auto& host_set : priority_set_.hostSetsPerPriority()) {
     parent_.drainConnPools(host_set->hosts());
   }
+
+  if (parent_.clusters_by_id_[id_] == this) {
+    parent_.clusters_by_id_[id_] = nullptr;
+  }
 }
 
 Http::ConnectionPool::Instance*
@@ -5,6 +5,7 @@
 #include <functional>
 #include <list>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -156,6 +157,7 @@ public:
     return clusters_map;
   }
   ThreadLocalCluster* get(const std::string& cluster) override;
+  ClusterHandleConstSharedPtr clusterHandle(const std::string& cluster) override;
   Http::ConnectionPool::Instance* httpConnPoolForCluster(const std::string& cluster,
                                                          ResourcePriority priority,
                                                          LoadBalancerContext* context) override;
@@ -192,7 +194,8 @@ private:
     };
 
     struct ClusterEntry : public ThreadLocalCluster {
-      ClusterEntry(ThreadLocalClusterManagerImpl& parent, ClusterInfoConstSharedPtr cluster);
+      ClusterEntry(ThreadLocalClusterManagerImpl& parent, ClusterInfoConstSharedPtr cluster,
+                   LoadBalancerFactorySharedPtr lb_factory);
       ~ClusterEntry();
 
       Http::ConnectionPool::Instance* connPool(ResourcePriority priority,
@@ -204,17 +207,41 @@ private:
       LoadBalancer& loadBalancer() override { return *lb_; }
 
       ThreadLocalClusterManagerImpl& parent_;
+      // Index of the entry in parent_.clusters_by_id_.
+      const uint32_t id_;
       PrioritySetImpl priority_set_;
       LoadBalancerPtr lb_;
       ClusterInfoConstSharedPtr cluster_info_;
+      // Creates lb_ again after every membership update, if set.
+      LoadBalancerFactorySharedPtr lb_factory_;
       Http::AsyncClientImpl http_async_client_;
     };
 
     typedef std::unique_ptr<ClusterEntry> ClusterEntryPtr;
 
+    /**
+     * A cluster whose entry is only created when it is first used on this thread.
+     */
+    struct LazyCluster {
+      // The latest membership of one priority, which the entry starts with.
+      struct HostSetSnapshot {
+        HostVectorConstSharedPtr hosts_;
+        HostVectorConstSharedPtr healthy_hosts_;
+        HostListsConstSharedPtr hosts_per_locality_;
+        HostListsConstSharedPtr healthy_hosts_per_locality_;
+      };
+
+      ClusterInfoConstSharedPtr cluster_info_;
+      LoadBalancerFactorySharedPtr lb_factory_;
+      std::vector<HostSetSnapshot> host_sets_;
+    };
+
     ThreadLocalClusterManagerImpl(ClusterManagerImpl& parent, Event::Dispatcher& dispatcher,
                                   const Optional<std::string>& local_cluster_name);
     ~ThreadLocalClusterManagerImpl();
+    void addCluster(ClusterInfoConstSharedPtr cluster, LoadBalancerFactorySharedPtr lb_factory);
+    ClusterEntry* getCluster(const std::string& name);
+    ClusterEntry* getCluster(uint32_t id, const std::string& name);
     void drainConnPools(const std::vector<HostSharedPtr>& hosts);
     void drainConnPools(HostSharedPtr old_host, ConnPoolsContainer& container);
     static void updateClusterMembership(const std::string& name, uint32_t priority,
@@ -229,21 +256,54 @@ private:
 
     ClusterManagerImpl& parent_;
     Event::Dispatcher& thread_local_dispatcher_;
+    // The entries of thread_local_clusters_ by cluster id, so that handles find them without
+    // hashing the name. Declared first as entries remove themselves when they are destroyed.
+    std::vector<ClusterEntry*> clusters_by_id_;
     std::unordered_map<std::string, ClusterEntryPtr> thread_local_clusters_;
+    // Clusters that have not been used on this thread yet, if entries are created lazily.
+    std::unordered_map<std::string, LazyCluster> lazy_clusters_;
     std::unordered_map<HostConstSharedPtr, ConnPoolsContainer> host_http_conn_pool_map_;
     const PrioritySet* local_priority_set_{};
   };
 
   struct PrimaryClusterData {
-    PrimaryClusterData(uint64_t config_hash, bool added_via_api, ClusterSharedPtr&& cluster)
-        : config_hash_(config_hash), added_via_api_(added_via_api), cluster_(std::move(cluster)) {}
+    PrimaryClusterData(uint64_t config_hash, bool added_via_api, ClusterSharedPtr&& cluster,
+                       ThreadAwareLoadBalancerPtr&& thread_aware_lb)
+        : config_hash_(config_hash), added_via_api_(added_via_api), cluster_(std::move(cluster)),
+          thread_aware_lb_(std::move(thread_aware_lb)) {}
+
+    /**
+     * @return LoadBalancerFactorySharedPtr the factory for worker load balancers, or nullptr if
+     *         workers build their own load balancers.
+     */
+    LoadBalancerFactorySharedPtr loadBalancerFactory() const {
+      return thread_aware_lb_ != nullptr ? thread_aware_lb_->factory() : nullptr;
+    }
 
     const uint64_t config_hash_;
     const bool added_via_api_;
     ClusterSharedPtr cluster_;
+    // Load balancer for the cluster's priority set on the main thread, for load balancers that
+    // share their work with workers.
+    ThreadAwareLoadBalancerPtr thread_aware_lb_;
+  };
+
+  struct ClusterHandleImpl : public ClusterHandle {
+    ClusterHandleImpl(ClusterManagerImpl& parent, const std::string& name, uint32_t id)
+        : parent_(parent), name_(name), id_(id) {}
+
+    // Upstream::ClusterHandle
+    ThreadLocalCluster* get() const override;
+    Http::ConnectionPool::Instance* httpConnPool(ResourcePriority priority,
+                                                 LoadBalancerContext* context) const override;
+
+    ClusterManagerImpl& parent_;
+    const std::string name_;
+    const uint32_t id_;
   };
 
   static ClusterManagerStats generateStats(Stats::Scope& scope);
+  uint32_t clusterId(const std::string& name);
   void loadCluster(const envoy::api::v2::Cluster& cluster, bool added_via_api);
   void postInitializeCluster(Cluster& cluster);
   void postThreadLocalClusterUpdate(const Cluster& cluster, uint32_t priority,
@@ -268,6 +328,12 @@ private:
   LoadStatsReporterPtr load_stats_reporter_;
   // The name of the local cluster of this Envoy instance if defined, else the empty string.
   std::string local_cluster_name_;
+  // Whether workers only create their entry for a cluster when it is first used.
+  bool lazy_thread_local_clusters_{};
+  // An id per cluster name ever used, which handles and worker entries use in place of the name.
+  // Workers take ids when they create their entry of a cluster, so this is locked.
+  std::mutex cluster_ids_lock_;
+  std::unordered_map<std::string, uint32_t> cluster_ids_;
 };
 
 } // namespace Upstream
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <queue>
+#include <vector>
+
+#include "common/common/assert.h"
+
+namespace Envoy {
+namespace Upstream {
+
+/**
+ * Earliest deadline first (EDF) scheduler for weighted picks. Each entry is due again 1/weight
+ * after it was last picked, so over time every entry is picked in proportion to its weight, and
+ * picks are spread out instead of being bunched together. add() and pick() are O(log n).
+ */
+template <class C> class EdfScheduler {
+public:
+  /**
+   * Add an entry, due 1/weight after the last pick (or after the start).
+   * @param weight supplies the weight of the entry. Must be greater than 0.
+   * @param entry supplies the entry.
+   */
+  void add(double weight, std::shared_ptr<C> entry) {
+    ASSERT(weight > 0);
+    queue_.push({current_time_ + 1.0 / weight, order_offset_++, std::move(entry)});
+  }
+
+  /**
+   * Remove and return the entry with the earliest deadline. The caller adds it back with add() if
+   * it should be picked again.
+   * @return std::shared_ptr<C> the entry, or nullptr if the scheduler is empty.
+   */
+  std::shared_ptr<C> pick() {
+    if (queue_.empty()) {
+      return nullptr;
+    }
+
+    EdfEntry edf_entry = queue_.top();
+    queue_.pop();
+    current_time_ = edf_entry.deadline_;
+    return std::move(edf_entry.entry_);
+  }
+
+  /**
+   * @return bool whether the scheduler has no entries.
+   */
+  bool empty() const { return queue_.empty(); }
+
+private:
+  struct EdfEntry {
+    double deadline_;
+    // Breaks deadline ties in insertion order, so that equal weights are picked round robin.
+    uint64_t order_offset_;
+    std::shared_ptr<C> entry_;
+
+    // std::priority_queue is a max heap, so this sorts the earliest deadline to the top.
+    bool operator<(const EdfEntry& other) const {
+      return deadline_ > other.deadline_ ||
+             (deadline_ == other.deadline_ && order_offset_ > other.order_offset_);
+    }
+  };
+
+  double current_time_{};
+  uint64_t order_offset_{};
+  std::priority_queue<EdfEntry> queue_;
+};
+
+} // namespace Upstream
+} // namespace Envoy
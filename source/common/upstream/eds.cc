@@ -69,6 +69,10 @@ void EdsClusterImpl::onConfigUpdate(const ResourceVector& resources) {
       throw EnvoyException(
           fmt::format("Unexpected non-zero priority for RingHash cluster '{}'.", cluster_name_));
     }
+    if (priority > 0 && info()->lbType() == LoadBalancerType::Maglev) {
+      throw EnvoyException(
+          fmt::format("Unexpected non-zero priority for Maglev cluster '{}'.", cluster_name_));
+    }
     if (priority > 0 && !cluster_name_.empty() && cluster_name_ == cm_.localClusterName()) {
       throw EnvoyException(
           fmt::format("Unexpected non-zero priority for local cluster '{}'.", cluster_name_));
@@ -83,7 +87,7 @@ void EdsClusterImpl::onConfigUpdate(const ResourceVector& resources) {
       new_hosts[priority]->emplace_back(new HostImpl(
           info_, "", Network::Address::resolveProtoAddress(lb_endpoint.endpoint().address()),
           lb_endpoint.metadata(), lb_endpoint.load_balancing_weight().value(),
-          locality_lb_endpoint.locality()));
+          locality_lb_endpoint.locality(), priority));
     }
   }
 
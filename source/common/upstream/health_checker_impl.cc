@@ -14,6 +14,7 @@
 #include "common/buffer/buffer_impl.h"
 #include "common/common/empty_string.h"
 #include "common/common/enum_to_int.h"
+#include "common/common/hash.h"
 #include "common/common/hex.h"
 #include "common/common/utility.h"
 #include "common/http/codec_client.h"
@@ -61,7 +62,9 @@ HealthCheckerImplBase::HealthCheckerImplBase(const Cluster& cluster,
       stats_(generateStats(cluster.info()->statsScope())), runtime_(runtime), random_(random),
       reuse_connection_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, reuse_connection, true)),
       interval_(PROTOBUF_GET_MS_REQUIRED(config, interval)),
-      interval_jitter_(PROTOBUF_GET_MS_OR_DEFAULT(config, interval_jitter, 0)) {
+      interval_jitter_(PROTOBUF_GET_MS_OR_DEFAULT(config, interval_jitter, 0)),
+      spread_interval_(runtime.snapshot().getInteger("health_check.spread_interval", 0) != 0),
+      phase_seed_(spread_interval_ ? random.random() : 0) {
   cluster_.prioritySet().addMemberUpdateCb(
       [this](uint32_t, const std::vector<HostSharedPtr>& hosts_added,
              const std::vector<HostSharedPtr>& hosts_removed) -> void {
@@ -111,6 +114,14 @@ std::chrono::milliseconds HealthCheckerImplBase::interval() const {
   return std::chrono::milliseconds(final_ms);
 }
 
+uint64_t HealthCheckerImplBase::intervalPhase(const Host& host) const {
+  if (!spread_interval_) {
+    return 0;
+  }
+
+  return HashUtil::xxHash64(host.address()->asString()) + phase_seed_;
+}
+
 void HealthCheckerImplBase::addHosts(const std::vector<HostSharedPtr>& hosts) {
   for (const HostSharedPtr& host : hosts) {
     active_sessions_[host] = makeSession(host);
@@ -224,7 +235,7 @@ void HealthCheckerImplBase::ActiveHealthCheckSession::handleSuccess() {
   parent_.runCallbacks(host_, changed_state);
 
   timeout_timer_->disableTimer();
-  interval_timer_->enableTimer(parent_.interval());
+  scheduleNextCheck();
 }
 
 void HealthCheckerImplBase::ActiveHealthCheckSession::setUnhealthy(FailureType type) {
@@ -254,7 +265,20 @@ void HealthCheckerImplBase::ActiveHealthCheckSession::setUnhealthy(FailureType t
 void HealthCheckerImplBase::ActiveHealthCheckSession::handleFailure(FailureType type) {
   setUnhealthy(type);
   timeout_timer_->disableTimer();
-  interval_timer_->enableTimer(parent_.interval());
+  scheduleNextCheck();
+}
+
+void HealthCheckerImplBase::ActiveHealthCheckSession::scheduleNextCheck() {
+  std::chrono::milliseconds next_check = parent_.interval();
+  if (!phase_applied_ && next_check.count() > 0) {
+    // The first checks of all hosts run as soon as checking starts, so that hosts become healthy
+    // quickly. Delaying the second check of each host by its own phase within the interval keeps
+    // the checks of many hosts, and of many Envoys, from then all running at the same moments.
+    next_check += std::chrono::milliseconds(parent_.intervalPhase(*host_) % next_check.count());
+    phase_applied_ = true;
+  }
+
+  interval_timer_->enableTimer(next_check);
 }
 
 void HealthCheckerImplBase::ActiveHealthCheckSession::onIntervalBase() {
@@ -274,7 +298,15 @@ HttpHealthCheckerImpl::HttpHealthCheckerImpl(const Cluster& cluster,
                                              Runtime::Loader& runtime,
                                              Runtime::RandomGenerator& random)
     : HealthCheckerImplBase(cluster, config, dispatcher, runtime, random),
-      path_(config.http_health_check().path()) {
+      path_(config.http_health_check().path()),
+      // Checking an HTTP/2 cluster over HTTP/2 multiplexes every check of a host over one long
+      // lived connection, instead of holding, or with reuse_connection off re-establishing, an
+      // HTTP/1.1 connection just for health checks.
+      codec_client_type_(
+          (cluster.info()->features() & ClusterInfo::Features::HTTP2) &&
+                  runtime.snapshot().getInteger("health_check.use_cluster_http2", 0) != 0
+              ? Http::CodecClient::Type::HTTP2
+              : Http::CodecClient::Type::HTTP1) {
   if (!config.http_health_check().service_name().empty()) {
     service_name_.value(config.http_health_check().service_name());
   }
@@ -394,7 +426,7 @@ void HttpHealthCheckerImpl::HttpActiveHealthCheckSession::onTimeout() {
 
 Http::CodecClient*
 ProdHttpHealthCheckerImpl::createCodecClient(Upstream::Host::CreateConnectionData& data) {
-  return new Http::CodecClientProd(Http::CodecClient::Type::HTTP1, std::move(data.connection_),
+  return new Http::CodecClientProd(codecClientType(), std::move(data.connection_),
                                    data.host_description_);
 }
 
@@ -411,6 +443,15 @@ TcpHealthCheckMatcher::MatchSegments TcpHealthCheckMatcher::loadProtoBytes(
 }
 
 bool TcpHealthCheckMatcher::match(const MatchSegments& expected, const Buffer::Instance& buffer) {
+  // A response that has only partly arrived cannot match yet, so do not search it.
+  uint64_t expected_length = 0;
+  for (const std::vector<uint8_t>& segment : expected) {
+    expected_length += segment.size();
+  }
+  if (buffer.length() < expected_length) {
+    return false;
+  }
+
   uint64_t start_index = 0;
   for (const std::vector<uint8_t>& segment : expected) {
     ssize_t search_result = buffer.search(&segment[0], segment.size(), start_index);
@@ -98,6 +98,7 @@ protected:
   private:
     virtual void onInterval() PURE;
     void onIntervalBase();
+    void scheduleNextCheck();
     virtual void onTimeout() PURE;
     void onTimeoutBase();
 
@@ -107,6 +108,7 @@ protected:
     uint32_t num_unhealthy_{};
     uint32_t num_healthy_{};
     bool first_check_{true};
+    bool phase_applied_{};
   };
 
   typedef std::unique_ptr<ActiveHealthCheckSession> ActiveHealthCheckSessionPtr;
@@ -145,6 +147,7 @@ private:
   HealthCheckerStats generateStats(Stats::Scope& scope);
   void incHealthy();
   std::chrono::milliseconds interval() const;
+  uint64_t intervalPhase(const Host& host) const;
   void onClusterMemberUpdate(const std::vector<HostSharedPtr>& hosts_added,
                              const std::vector<HostSharedPtr>& hosts_removed);
   void refreshHealthyStat();
@@ -156,6 +159,10 @@ private:
   std::list<HostStatusCb> callbacks_;
   const std::chrono::milliseconds interval_;
   const std::chrono::milliseconds interval_jitter_;
+  // Whether the checks of the hosts are spread over the interval, and the seed that spreads the
+  // same host differently in each Envoy.
+  const bool spread_interval_;
+  const uint64_t phase_seed_;
   std::unordered_map<HostSharedPtr, ActiveHealthCheckSessionPtr> active_sessions_;
   uint64_t local_process_healthy_{};
 };
@@ -169,6 +176,11 @@ public:
                         Event::Dispatcher& dispatcher, Runtime::Loader& runtime,
                         Runtime::RandomGenerator& random);
 
+  /**
+   * @return Http::CodecClient::Type the protocol that health checks are sent with.
+   */
+  Http::CodecClient::Type codecClientType() const { return codec_client_type_; }
+
 private:
   struct HttpActiveHealthCheckSession : public ActiveHealthCheckSession,
                                         public Http::StreamDecoder,
@@ -230,6 +242,7 @@ private:
 
   const std::string path_;
   Optional<std::string> service_name_;
+  const Http::CodecClient::Type codec_client_type_;
 };
 
 /**
@@ -1,5 +1,6 @@
 #include "common/upstream/host_utility.h"
 
+#include <cstdint>
 #include <string>
 
 namespace Envoy {
@@ -22,5 +23,13 @@ std::string HostUtility::healthFlagsToString(const Host& host) {
   return ret;
 }
 
+void HostUtility::recordResponseTime(const HostDescription& host,
+                                     std::chrono::milliseconds time) {
+  Stats::Gauge& ewma = host.stats().rq_latency_ewma_us_;
+  const int64_t sample = std::chrono::duration_cast<std::chrono::microseconds>(time).count();
+  const int64_t current = ewma.value();
+  ewma.set(current == 0 ? sample : current + (sample - current) / 8);
+}
+
 } // namespace Upstream
 } // namespace Envoy
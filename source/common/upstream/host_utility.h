@@ -1,5 +1,6 @@
 #pragma once
 
+#include <chrono>
 #include <string>
 
 #include "envoy/upstream/upstream.h"
@@ -16,6 +17,13 @@ public:
    * Convert a host's health flags into a debug string.
    */
   static std::string healthFlagsToString(const Host& host);
+
+  /**
+   * Fold a response time into the host's rq_latency_ewma_us stat, which weighs the new sample at
+   * 1/8. Workers update the stat without coordination, so a concurrent sample can occasionally be
+   * lost, which is fine for an average.
+   */
+  static void recordResponseTime(const HostDescription& host, std::chrono::milliseconds time);
 };
 
 } // namespace Upstream
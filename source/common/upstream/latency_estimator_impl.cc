@@ -0,0 +1,51 @@
+#include "common/upstream/latency_estimator_impl.h"
+
+namespace Envoy {
+namespace Upstream {
+
+const uint64_t LatencyEstimatorImpl::DEFAULT_WINDOW_SIZE;
+
+LatencyEstimatorImpl::LatencyEstimatorImpl(uint64_t window_size) : window_size_(window_size) {
+  ASSERT(window_size_ > 0);
+  for (Window& window : windows_) {
+    window.clear();
+  }
+}
+
+void LatencyEstimatorImpl::Window::clear() {
+  for (std::atomic<uint32_t>& counter : bucket_.counters_) {
+    counter = 0;
+  }
+  total_ = 0;
+}
+
+void LatencyEstimatorImpl::putResponseTime(std::chrono::milliseconds response_time) {
+  const size_t current = current_window_;
+  Window& window = windows_[current];
+  window.bucket_.counters_[Outlier::LatencyAccumulatorBucket::bucketIndex(response_time.count())]++;
+
+  // Only the response that brings the total to exactly window_size_ rotates, so concurrent writers
+  // rotate once. Writers that loaded the old window just before the rotation add a few responses
+  // to the full window, which is harmless for an estimate.
+  if (++window.total_ == window_size_) {
+    windows_[1 - current].clear();
+    current_window_ = 1 - current;
+    full_window_ = true;
+  }
+}
+
+Optional<std::chrono::milliseconds> LatencyEstimatorImpl::percentile(double percentile) const {
+  if (!full_window_) {
+    return Optional<std::chrono::milliseconds>();
+  }
+
+  const Optional<uint64_t> value =
+      windows_[1 - current_window_].bucket_.getPercentile(1, percentile);
+  if (!value.valid()) {
+    return Optional<std::chrono::milliseconds>();
+  }
+  return Optional<std::chrono::milliseconds>(std::chrono::milliseconds(value.value()));
+}
+
+} // namespace Upstream
+} // namespace Envoy
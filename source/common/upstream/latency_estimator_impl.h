@@ -0,0 +1,52 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "envoy/upstream/upstream.h"
+
+#include "common/common/assert.h"
+#include "common/upstream/outlier_detection_impl.h"
+
+namespace Envoy {
+namespace Upstream {
+
+/**
+ * Estimates response time percentiles of a cluster from the last full window of responses. Each
+ * window counts a fixed number of responses in a latency histogram. The response that fills the
+ * current window makes it the one percentiles are read from, and empties the other window to be
+ * written next. Windows are sized in responses rather than time, so the estimate tracks busy
+ * clusters closely without a timer, and quiet clusters keep their last estimate.
+ */
+class LatencyEstimatorImpl : public LatencyEstimator {
+public:
+  static const uint64_t DEFAULT_WINDOW_SIZE = 1000;
+
+  /**
+   * @param window_size supplies the number of responses in each window.
+   */
+  LatencyEstimatorImpl(uint64_t window_size = DEFAULT_WINDOW_SIZE);
+
+  // Upstream::LatencyEstimator
+  void putResponseTime(std::chrono::milliseconds response_time) override;
+  Optional<std::chrono::milliseconds> percentile(double percentile) const override;
+
+private:
+  struct Window {
+    void clear();
+
+    Outlier::LatencyAccumulatorBucket bucket_;
+    std::atomic<uint64_t> total_;
+  };
+
+  const uint64_t window_size_;
+  std::array<Window, 2> windows_;
+  // The window being written. The other window is the last full one, once full_window_ is set.
+  std::atomic<size_t> current_window_{0};
+  std::atomic<bool> full_window_{false};
+};
+
+} // namespace Upstream
+} // namespace Envoy
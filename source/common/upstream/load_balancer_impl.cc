@@ -1,5 +1,6 @@
 #include "common/upstream/load_balancer_impl.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <string>
 #include <vector>
@@ -100,11 +101,13 @@ void LoadBalancerBase::regenerateLocalityRoutingStructures(uint32_t priority) {
   size_t num_localities = host_set.healthyHostsPerLocality().size();
   ASSERT(num_localities > 0);
 
+  // Every local Envoy sends about the same load, while upstream hosts can take load in proportion
+  // to their weights.
   uint64_t local_percentage[num_localities];
-  calculateLocalityPercentage(localHostSet().healthyHostsPerLocality(), local_percentage);
+  calculateLocalityPercentage(localHostSet().healthyHostsPerLocality(), false, local_percentage);
 
   uint64_t upstream_percentage[num_localities];
-  calculateLocalityPercentage(host_set.healthyHostsPerLocality(), upstream_percentage);
+  calculateLocalityPercentage(host_set.healthyHostsPerLocality(), true, upstream_percentage);
 
   // If we have lower percent of hosts in the local cluster in the same locality,
   // we can push all of the requests directly to upstream cluster in the same locality.
@@ -125,32 +128,22 @@ void LoadBalancerBase::regenerateLocalityRoutingStructures(uint32_t priority) {
   // locality we should route. Percentage of requests routed cross locality to a specific locality
   // needed be proportional to the residual capacity upstream locality has.
   //
-  // residual_capacity contains capacity left in a given locality, we keep accumulating residual
-  // capacity to make search for sampled value easier.
   // For example, if we have the following upstream and local percentage:
   // local_percentage: 40000 40000 20000
   // upstream_percentage: 25000 50000 25000
   // Residual capacity would look like: 0 10000 5000. Now we need to sample proportionally to
-  // bucket sizes (residual capacity). For simplicity of finding where specific
-  // sampled value is, we accumulate values in residual capacity. This is what it will look like:
-  // residual_capacity: 0 10000 15000
-  // Now to find a locality to route (bucket) we could simply iterate over residual_capacity
-  // searching where sampled value is placed.
-  state.residual_capacity_.resize(num_localities);
+  // these residual capacities, which an alias table does in constant time per pick. The table is
+  // only rebuilt here, when hosts change.
+  std::vector<uint64_t> residual_capacity(num_localities);
 
   // Local locality (index 0) does not have residual capacity as we have routed all we could.
-  state.residual_capacity_[0] = 0;
   for (size_t i = 1; i < num_localities; ++i) {
     // Only route to the localities that have additional capacity.
     if (upstream_percentage[i] > local_percentage[i]) {
-      state.residual_capacity_[i] =
-          state.residual_capacity_[i - 1] + upstream_percentage[i] - local_percentage[i];
-    } else {
-      // Locality with index "i" does not have residual capacity, but we keep accumulating previous
-      // values to make search easier on the next step.
-      state.residual_capacity_[i] = state.residual_capacity_[i - 1];
+      residual_capacity[i] = upstream_percentage[i] - local_percentage[i];
     }
   }
+  state.residual_capacity_ = AliasTable(residual_capacity);
 };
 
 void LoadBalancerBase::resizePerPriorityState() {
@@ -192,11 +185,14 @@ bool LoadBalancerBase::earlyExitNonLocalityRouting(uint32_t priority) {
 }
 
 bool LoadBalancerUtility::isGlobalPanic(const HostSet& host_set, Runtime::Loader& runtime) {
+  return isGlobalPanic(host_set.hosts().size(), host_set.healthyHosts().size(), runtime);
+}
+
+bool LoadBalancerUtility::isGlobalPanic(uint64_t num_hosts, uint64_t num_healthy_hosts,
+                                        Runtime::Loader& runtime) {
   uint64_t global_panic_threshold =
       std::min<uint64_t>(100, runtime.snapshot().getInteger(RuntimePanicThreshold, 50));
-  double healthy_percent = host_set.hosts().size() == 0
-                               ? 0
-                               : 100.0 * host_set.healthyHosts().size() / host_set.hosts().size();
+  double healthy_percent = num_hosts == 0 ? 0 : 100.0 * num_healthy_hosts / num_hosts;
 
   // If the % of healthy hosts in the cluster is less than our panic threshold, we use all hosts.
   if (healthy_percent < global_panic_threshold) {
@@ -207,15 +203,20 @@ bool LoadBalancerUtility::isGlobalPanic(const HostSet& host_set, Runtime::Loader
 }
 
 void LoadBalancerBase::calculateLocalityPercentage(
-    const std::vector<std::vector<HostSharedPtr>>& hosts_per_locality, uint64_t* ret) {
-  uint64_t total_hosts = 0;
-  for (const auto& locality_hosts : hosts_per_locality) {
-    total_hosts += locality_hosts.size();
+    const std::vector<std::vector<HostSharedPtr>>& hosts_per_locality, bool by_weight,
+    uint64_t* ret) {
+  const size_t num_localities = hosts_per_locality.size();
+  std::vector<uint64_t> locality_total(num_localities);
+  uint64_t total = 0;
+  for (size_t i = 0; i < num_localities; ++i) {
+    for (const HostSharedPtr& host : hosts_per_locality[i]) {
+      locality_total[i] += by_weight ? host->weight() : 1;
+    }
+    total += locality_total[i];
   }
 
-  size_t i = 0;
-  for (const auto& locality_hosts : hosts_per_locality) {
-    ret[i++] = total_hosts > 0 ? 10000ULL * locality_hosts.size() / total_hosts : 0;
+  for (size_t i = 0; i < num_localities; ++i) {
+    ret[i] = total > 0 ? 10000ULL * locality_total[i] / total : 0;
   }
 }
 
@@ -248,7 +249,7 @@ const std::vector<HostSharedPtr>& LoadBalancerBase::tryChooseLocalLocalityHosts(
 
   // This is *extremely* unlikely but possible due to rounding errors when calculating
   // locality percentages. In this case just select random locality.
-  if (state.residual_capacity_[number_of_localities - 1] == 0) {
+  if (state.residual_capacity_.empty()) {
     stats_.lb_zone_no_capacity_left_.inc();
     return best_available_host_set_
         ->healthyHostsPerLocality()[random_.random() % number_of_localities];
@@ -256,16 +257,8 @@ const std::vector<HostSharedPtr>& LoadBalancerBase::tryChooseLocalLocalityHosts(
 
   // Random sampling to select specific locality for cross locality traffic based on the additional
   // capacity in localities.
-  uint64_t threshold = random_.random() % state.residual_capacity_[number_of_localities - 1];
-
-  // This potentially can be optimized to be O(log(N)) where N is the number of localities.
-  // Linear scan should be faster for smaller N, in most of the scenarios N will be small.
-  int i = 0;
-  while (threshold > state.residual_capacity_[i]) {
-    i++;
-  }
-
-  return best_available_host_set_->healthyHostsPerLocality()[i];
+  return best_available_host_set_
+      ->healthyHostsPerLocality()[state.residual_capacity_.pick(random_.random())];
 }
 
 const std::vector<HostSharedPtr>& LoadBalancerBase::hostsToUse() {
@@ -300,69 +293,103 @@ const std::vector<HostSharedPtr>& LoadBalancerBase::hostsToUse() {
   return tryChooseLocalLocalityHosts();
 }
 
+RoundRobinLoadBalancer::RoundRobinLoadBalancer(const PrioritySet& priority_set,
+                                               const PrioritySet* local_priority_set,
+                                               ClusterStats& stats, Runtime::Loader& runtime,
+                                               Runtime::RandomGenerator& random)
+    : LoadBalancerBase(priority_set, local_priority_set, stats, runtime, random) {
+  priority_set.addMemberUpdateCb(
+      [this](uint32_t, const std::vector<HostSharedPtr>&,
+             const std::vector<HostSharedPtr>&) -> void { schedulers_.clear(); });
+}
+
+RoundRobinLoadBalancer::Scheduler&
+RoundRobinLoadBalancer::scheduler(const std::vector<HostSharedPtr>& hosts) {
+  ASSERT(!hosts.empty());
+  Scheduler& scheduler = schedulers_[&hosts];
+  if (scheduler.num_hosts_ == hosts.size()) {
+    return scheduler;
+  }
+
+  scheduler = Scheduler();
+  scheduler.num_hosts_ = hosts.size();
+  for (const HostSharedPtr& host : hosts) {
+    if (host->weight() != hosts[0]->weight()) {
+      scheduler.weighted_ = true;
+      break;
+    }
+  }
+
+  if (scheduler.weighted_) {
+    for (const HostSharedPtr& host : hosts) {
+      scheduler.edf_.add(host->weight(), host);
+    }
+  }
+
+  return scheduler;
+}
+
 HostConstSharedPtr RoundRobinLoadBalancer::chooseHost(LoadBalancerContext*) {
   const std::vector<HostSharedPtr>& hosts_to_use = hostsToUse();
   if (hosts_to_use.empty()) {
     return nullptr;
   }
 
-  return hosts_to_use[rr_index_++ % hosts_to_use.size()];
-}
+  Scheduler& hosts_scheduler = scheduler(hosts_to_use);
+  if (hosts_scheduler.weighted_ &&
+      runtime_.snapshot().getInteger("upstream.weight_enabled", 1UL) != 0) {
+    HostSharedPtr host = hosts_scheduler.edf_.pick();
+    hosts_scheduler.edf_.add(host->weight(), host);
+    return host;
+  }
 
-LeastRequestLoadBalancer::LeastRequestLoadBalancer(const PrioritySet& priority_set,
-                                                   const PrioritySet* local_priority_set,
-                                                   ClusterStats& stats, Runtime::Loader& runtime,
-                                                   Runtime::RandomGenerator& random)
-    : LoadBalancerBase(priority_set, local_priority_set, stats, runtime, random) {
-  priority_set.addMemberUpdateCb([this](uint32_t, const std::vector<HostSharedPtr>&,
-                                        const std::vector<HostSharedPtr>& hosts_removed) -> void {
-    if (last_host_) {
-      for (const HostSharedPtr& host : hosts_removed) {
-        if (host == last_host_) {
-          hits_left_ = 0;
-          last_host_.reset();
-
-          break;
-        }
-      }
-    }
-  });
+  return hosts_to_use[rr_index_++ % hosts_to_use.size()];
 }
 
-HostConstSharedPtr LeastRequestLoadBalancer::chooseHost(LoadBalancerContext*) {
-  bool is_weight_imbalanced = stats_.max_host_weight_.value() != 1;
-  bool is_weight_enabled = runtime_.snapshot().getInteger("upstream.weight_enabled", 1UL) != 0;
+double LeastRequestLoadBalancer::hostCost(const Host& host, bool use_weight,
+                                          bool use_latency) const {
+  // Count the request being placed, so that idle hosts are still told apart by weight and latency.
+  double cost = host.stats().rq_active_.value() + 1;
+  if (use_latency) {
+    // Hosts without a response time yet cost the least, which gets them measured.
+    cost *= host.stats().rq_latency_ewma_us_.value() + 1;
+  }
+  if (use_weight) {
+    cost /= host.weight();
+  }
 
-  if (is_weight_imbalanced && hits_left_ > 0 && is_weight_enabled) {
-    --hits_left_;
+  return cost;
+}
 
-    return last_host_;
-  } else {
-    // To avoid hit stale last_host_ when all hosts become weight balanced.
-    hits_left_ = 0;
-    last_host_.reset();
-  }
+const uint64_t LeastRequestLoadBalancer::MaxChoiceCount;
 
+HostConstSharedPtr LeastRequestLoadBalancer::chooseHost(LoadBalancerContext*) {
   const std::vector<HostSharedPtr>& hosts_to_use = hostsToUse();
   if (hosts_to_use.empty()) {
     return nullptr;
   }
 
-  // Make weighed random if we have hosts with non 1 weights.
-  if (is_weight_imbalanced & is_weight_enabled) {
-    last_host_ = hosts_to_use[random_.random() % hosts_to_use.size()];
-    hits_left_ = last_host_->weight() - 1;
-
-    return last_host_;
-  } else {
-    HostSharedPtr host1 = hosts_to_use[random_.random() % hosts_to_use.size()];
-    HostSharedPtr host2 = hosts_to_use[random_.random() % hosts_to_use.size()];
-    if (host1->stats().rq_active_.value() < host2->stats().rq_active_.value()) {
-      return host1;
-    } else {
-      return host2;
+  const bool use_weight = stats_.max_host_weight_.value() != 1 &&
+                          runtime_.snapshot().getInteger("upstream.weight_enabled", 1UL) != 0;
+  const bool use_latency =
+      runtime_.snapshot().getInteger("upstream.least_request.latency_enabled", 0UL) != 0;
+  const uint64_t choice_count = std::min(
+      std::max(runtime_.snapshot().getInteger("upstream.least_request.choice_count", 2UL), 1UL),
+      MaxChoiceCount);
+
+  // On a tie the later choice wins.
+  HostSharedPtr best_host;
+  double best_cost = 0;
+  for (uint64_t i = 0; i < choice_count; i++) {
+    const HostSharedPtr& host = hosts_to_use[random_.random() % hosts_to_use.size()];
+    const double cost = hostCost(*host, use_weight, use_latency);
+    if (best_host == nullptr || cost <= best_cost) {
+      best_host = host;
+      best_cost = cost;
     }
   }
+
+  return best_host;
 }
 
 HostConstSharedPtr RandomLoadBalancer::chooseHost(LoadBalancerContext*) {
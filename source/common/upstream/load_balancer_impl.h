@@ -2,12 +2,16 @@
 
 #include <cstdint>
 #include <set>
+#include <unordered_map>
 #include <vector>
 
 #include "envoy/runtime/runtime.h"
 #include "envoy/upstream/load_balancer.h"
 #include "envoy/upstream/upstream.h"
 
+#include "common/upstream/alias_table.h"
+#include "common/upstream/edf_scheduler.h"
+
 #include "api/cds.pb.h"
 
 namespace Envoy {
@@ -24,6 +28,12 @@ public:
    * requests to hosts regardless of whether they are healthy or not.
    */
   static bool isGlobalPanic(const HostSet& host_set, Runtime::Loader& runtime);
+
+  /**
+   * Same as above, for a host set of num_hosts hosts with num_healthy_hosts healthy ones.
+   */
+  static bool isGlobalPanic(uint64_t num_hosts, uint64_t num_healthy_hosts,
+                            Runtime::Loader& runtime);
 };
 
 /**
@@ -73,13 +83,14 @@ private:
   const std::vector<HostSharedPtr>& tryChooseLocalLocalityHosts();
 
   /**
-   * @return (number of hosts in a given locality)/(total number of hosts) in ret param.
+   * @return (number of hosts in a given locality)/(total number of hosts) in ret param, or with
+   * by_weight the same ratio of the sums of host weights.
    * The result is stored as integer number and scaled by 10000 multiplier for better precision.
    * Caller is responsible for allocation/de-allocation of ret.
    */
   void
   calculateLocalityPercentage(const std::vector<std::vector<HostSharedPtr>>& hosts_per_locality,
-                              uint64_t* ret);
+                              bool by_weight, uint64_t* ret);
 
   /**
    * Regenerate locality aware routing structures for fast decisions on upstream locality selection.
@@ -104,10 +115,10 @@ private:
     uint64_t local_percent_to_route_{};
     // Tracks the current state of locality based routing.
     LocalityRoutingState locality_routing_state_{LocalityRoutingState::NoLocalityRouting};
-    // When locality_routing_state_ == LocalityResidual this tracks the capacity
-    // for each of the non-local localities to determine what traffic should be
-    // routed where.
-    std::vector<uint64_t> residual_capacity_;
+    // When locality_routing_state_ == LocalityResidual this picks among the non-local
+    // localities in proportion to their residual capacity, to determine what traffic should be
+    // routed where. Empty if no locality has capacity left.
+    AliasTable residual_capacity_;
   };
   typedef std::unique_ptr<PerPriorityState> PerPriorityStatePtr;
   // Routing state broken out for each priority level in priority_set_.
@@ -119,47 +130,62 @@ private:
 };
 
 /**
- * Implementation of LoadBalancer that performs RR selection across the hosts in the cluster.
+ * Implementation of LoadBalancer that performs RR selection across the hosts in the cluster. If
+ * the hosts have different weights, they are picked in proportion to their weights with an
+ * earliest deadline first scheduler.
  */
 class RoundRobinLoadBalancer : public LoadBalancer, LoadBalancerBase {
 public:
   RoundRobinLoadBalancer(const PrioritySet& priority_set, const PrioritySet* local_priority_set,
                          ClusterStats& stats, Runtime::Loader& runtime,
-                         Runtime::RandomGenerator& random)
-      : LoadBalancerBase(priority_set, local_priority_set, stats, runtime, random) {}
+                         Runtime::RandomGenerator& random);
 
   // Upstream::LoadBalancer
   HostConstSharedPtr chooseHost(LoadBalancerContext* context) override;
 
 private:
+  struct Scheduler {
+    // The number of hosts the scheduler was built for, to catch host lists that were replaced
+    // without a membership update.
+    size_t num_hosts_{};
+    // Whether the hosts have different weights. Otherwise plain round robin is used.
+    bool weighted_{};
+    EdfScheduler<Host> edf_;
+  };
+
+  Scheduler& scheduler(const std::vector<HostSharedPtr>& hosts);
+
   size_t rr_index_{};
+  // Schedulers for each of the host lists that hostsToUse() returns, built on first use. They are
+  // all dropped when the membership or health of any host set changes.
+  std::unordered_map<const std::vector<HostSharedPtr>*, Scheduler> schedulers_;
 };
 
 /**
  * Weighted Least Request load balancer.
  *
- * In a normal setup when all hosts have the same weight of 1 it randomly picks up two healthy hosts
- * and compares number of active requests.
+ * Randomly picks a number of healthy hosts (two by default, the "power of two choices") and sends
+ * the request to the one with the lowest cost. The cost of a host is its number of active requests
+ * plus one, divided by its weight when the hosts have different weights. It can also be multiplied
+ * by the host's average response time, so that slow hosts get fewer requests.
  * Technique is based on http://www.eecs.harvard.edu/~michaelm/postscripts/mythesis.pdf
- *
- * When any of the hosts have non 1 weight, apply random weighted balancing.
- * Randomly pickup the host and send 'weight' number of requests to it.
- * This technique is acceptable for load testing but
- * will not work well in situations where requests take a long time.
- * In that case a different algorithm using a full scan will be required.
  */
 class LeastRequestLoadBalancer : public LoadBalancer, LoadBalancerBase {
 public:
   LeastRequestLoadBalancer(const PrioritySet& priority_set, const PrioritySet* local_priority_set,
                            ClusterStats& stats, Runtime::Loader& runtime,
-                           Runtime::RandomGenerator& random);
+                           Runtime::RandomGenerator& random)
+      : LoadBalancerBase(priority_set, local_priority_set, stats, runtime, random) {}
 
   // Upstream::LoadBalancer
   HostConstSharedPtr chooseHost(LoadBalancerContext* context) override;
 
 private:
-  HostSharedPtr last_host_;
-  uint32_t hits_left_{};
+  // Upper bound of the upstream.least_request.choice_count runtime key, so that a large value does
+  // not make every pick loop over that many random hosts.
+  static const uint64_t MaxChoiceCount = 10;
+
+  double hostCost(const Host& host, bool use_weight, bool use_latency) const;
 };
 
 /**
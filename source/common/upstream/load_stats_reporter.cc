@@ -49,6 +49,15 @@ void LoadStatsReporter::establishNewStream() {
 }
 
 void LoadStatsReporter::sendLoadStatsRequest() {
+  if (stream_->isAboveWriteBufferHighWatermark()) {
+    // The management server is not keeping up. The counters are not latched, so the next report
+    // covers this interval as well.
+    ENVOY_LOG(debug, "Load report stream is backed up, deferring report");
+    stats_.deferred_.inc();
+    response_timer_->enableTimer(std::chrono::milliseconds(RETRY_DELAY_MS));
+    return;
+  }
+
   request_.mutable_cluster_stats()->Clear();
   for (const std::string& cluster_name : clusters_) {
     auto cluster_info_map = cm_.clusters();
@@ -69,10 +78,18 @@ void LoadStatsReporter::sendLoadStatsRequest() {
         uint64_t rq_success = 0;
         uint64_t rq_error = 0;
         uint64_t rq_active = 0;
-        for (auto host : hosts) {
-          rq_success += host->stats().rq_success_.latch();
-          rq_error += host->stats().rq_error_.latch();
-          rq_active += host->stats().rq_active_.value();
+        LocalityLoadStats* load_stats = hosts[0]->localityLoadStats();
+        if (load_stats != nullptr) {
+          // The hosts of a locality roll their stats up into the same locality stats.
+          rq_success = load_stats->rq_success_.latch();
+          rq_error = load_stats->rq_error_.latch();
+          rq_active = load_stats->rq_active_.value();
+        } else {
+          for (auto host : hosts) {
+            rq_success += host->stats().rq_success_.latch();
+            rq_error += host->stats().rq_error_.latch();
+            rq_active += host->stats().rq_active_.value();
+          }
         }
         locality_stats->set_total_successful_requests(rq_success);
         locality_stats->set_total_error_requests(rq_error);
@@ -117,9 +134,17 @@ void LoadStatsReporter::onReceiveMessage(
     }
     auto& cluster = it->second.get();
     for (auto& host_set : cluster.prioritySet().hostSetsPerPriority()) {
-      for (auto host : host_set->hosts()) {
-        host->stats().rq_success_.latch();
-        host->stats().rq_error_.latch();
+      for (auto& hosts : host_set->hostsPerLocality()) {
+        LocalityLoadStats* load_stats = hosts[0]->localityLoadStats();
+        if (load_stats != nullptr) {
+          load_stats->rq_success_.latch();
+          load_stats->rq_error_.latch();
+          continue;
+        }
+        for (auto host : hosts) {
+          host->stats().rq_success_.latch();
+          host->stats().rq_error_.latch();
+        }
       }
     }
     cluster.info()->loadReportStats().upstream_rq_dropped_.latch();
@@ -75,6 +75,9 @@ private:
     const envoy::api::v2::Locality& locality() const override {
       return envoy::api::v2::Locality().default_instance();
     }
+    LocalityLoadStats* localityLoadStats() const override {
+      return logical_host_->localityLoadStats();
+    }
 
     Network::Address::InstanceConstSharedPtr address_;
     HostConstSharedPtr logical_host_;
@@ -0,0 +1,108 @@
+#include "common/upstream/maglev_lb.h"
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "common/common/assert.h"
+#include "common/common/hash.h"
+
+namespace Envoy {
+namespace Upstream {
+
+const uint64_t MaglevLoadBalancer::DefaultTableSize;
+
+MaglevLoadBalancer::MaglevLoadBalancer(PrioritySet& priority_set, ClusterStats& stats,
+                                       Runtime::Loader& runtime, Runtime::RandomGenerator& random,
+                                       uint64_t table_size)
+    : ThreadAwareLoadBalancerBase(priority_set, stats, runtime, random), table_size_(table_size) {
+  ASSERT(table_size_ > 1);
+  refresh();
+}
+
+ThreadAwareLoadBalancerBase::HashingLoadBalancerSharedPtr
+MaglevLoadBalancer::createTable(const std::vector<HostSharedPtr>& hosts) {
+  std::shared_ptr<Table> table(new Table());
+  table->create(hosts, table_size_);
+  return table;
+}
+
+HostConstSharedPtr MaglevLoadBalancer::Table::chooseHost(uint64_t h) const {
+  if (table_.empty()) {
+    return nullptr;
+  }
+
+  return hosts_[table_[h % table_.size()]];
+}
+
+HostConstSharedPtr MaglevLoadBalancer::Table::chooseHost(uint64_t h,
+                                                         const HostPredicate& accept) const {
+  if (table_.empty()) {
+    return nullptr;
+  }
+
+  // The slots that follow belong to hosts in no particular order, so walking them spreads the
+  // requests a host turns away over the other hosts.
+  const uint64_t slot = h % table_.size();
+  uint32_t rejected = std::numeric_limits<uint32_t>::max();
+  for (uint64_t i = 0; i < table_.size(); i++) {
+    const uint32_t index = table_[(slot + i) % table_.size()];
+    if (index != rejected) {
+      if (accept(*hosts_[index])) {
+        return hosts_[index];
+      }
+      rejected = index;
+    }
+  }
+
+  return hosts_[table_[slot]];
+}
+
+void MaglevLoadBalancer::Table::create(const std::vector<HostSharedPtr>& hosts,
+                                       uint64_t table_size) {
+  ENVOY_LOG(trace, "maglev: building table");
+  hosts_.clear();
+  table_.clear();
+  if (hosts.empty()) {
+    return;
+  }
+
+  // Each host's permutation of the table starts at offset and walks it in steps of skip. Both are
+  // taken from the hash of the host's address, so that they only depend on the host itself.
+  struct Permutation {
+    uint64_t offset_;
+    uint64_t skip_;
+    uint64_t next_;
+  };
+  std::vector<Permutation> permutations;
+  permutations.reserve(hosts.size());
+  hosts_.reserve(hosts.size());
+  for (const auto& host : hosts) {
+    const uint64_t hash = HashUtil::xxHash64(host->address()->asString());
+    permutations.push_back({hash % table_size, (hash >> 32) % (table_size - 1) + 1, 0});
+    hosts_.push_back(host);
+  }
+
+  // Hosts take turns claiming the next free slot of their permutation until the table is full.
+  const uint32_t empty_slot = std::numeric_limits<uint32_t>::max();
+  table_.assign(table_size, empty_slot);
+  uint64_t filled = 0;
+  while (filled < table_size) {
+    for (uint32_t i = 0; i < hosts_.size() && filled < table_size; i++) {
+      Permutation& permutation = permutations[i];
+      uint64_t slot;
+      do {
+        slot = (permutation.offset_ + permutation.skip_ * permutation.next_++) % table_size;
+      } while (table_[slot] != empty_slot);
+
+      table_[slot] = i;
+      filled++;
+    }
+  }
+
+  ENVOY_LOG(debug, "maglev: table_size={} hosts={}", table_size, hosts_.size());
+}
+
+} // namespace Upstream
+} // namespace Envoy
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "envoy/runtime/runtime.h"
+#include "envoy/upstream/load_balancer.h"
+
+#include "common/common/logger.h"
+#include "common/upstream/thread_aware_lb_impl.h"
+
+namespace Envoy {
+namespace Upstream {
+
+/**
+ * A load balancer that implements Maglev consistent hashing, as described in
+ * https://research.google.com/pubs/pub44824.html. Each host fills slots of a fixed size lookup
+ * table in the order of its own permutation of the table, so a pick is a single table lookup, and
+ * a membership change moves only a small share of the slots. Like the ring hash load balancer,
+ * zone aware routing and weighting are not supported, and a table is kept for all hosts as well as
+ * for healthy hosts. Unless we are in panic mode, the healthy host table is used. The tables are
+ * built on the main thread and shared with workers, see ThreadAwareLoadBalancerBase.
+ */
+class MaglevLoadBalancer : public ThreadAwareLoadBalancerBase,
+                           Logger::Loggable<Logger::Id::upstream> {
+public:
+  // The table size must be prime, so that every host's permutation covers the whole table. It
+  // should also be much larger than the number of hosts, as hosts are only spread over the table
+  // evenly to within one slot each.
+  static const uint64_t DefaultTableSize = 65537;
+
+  MaglevLoadBalancer(PrioritySet& priority_set, ClusterStats& stats, Runtime::Loader& runtime,
+                     Runtime::RandomGenerator& random, uint64_t table_size = DefaultTableSize);
+
+private:
+  struct Table : public HashingLoadBalancer {
+    // ThreadAwareLoadBalancerBase::HashingLoadBalancer
+    HostConstSharedPtr chooseHost(uint64_t hash) const override;
+    HostConstSharedPtr chooseHost(uint64_t hash, const HostPredicate& accept) const override;
+
+    void create(const std::vector<HostSharedPtr>& hosts, uint64_t table_size);
+
+    std::vector<HostConstSharedPtr> hosts_;
+    // Indexes into hosts_, which keeps the table at 4 bytes per slot.
+    std::vector<uint32_t> table_;
+  };
+
+  HashingLoadBalancerSharedPtr createTable(const std::vector<HostSharedPtr>& hosts);
+
+  // ThreadAwareLoadBalancerBase
+  HashingLoadBalancerSharedPtr createAllHostsLoadBalancer(const HostSet& host_set) override {
+    return createTable(host_set.hosts());
+  }
+  HashingLoadBalancerSharedPtr createHealthyHostsLoadBalancer(const HostSet& host_set) override {
+    return createTable(host_set.healthyHosts());
+  }
+
+  const uint64_t table_size_;
+};
+
+} // namespace Upstream
+} // namespace Envoy
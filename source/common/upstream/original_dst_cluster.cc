@@ -1,6 +1,10 @@
 #include "common/upstream/original_dst_cluster.h"
 
+#include <arpa/inet.h>
+
+#include <algorithm>
 #include <chrono>
+#include <cstring>
 #include <list>
 #include <string>
 #include <vector>
@@ -19,6 +23,73 @@ namespace Upstream {
 // OriginalDstCluster::LoadBalancer is never configured with any other type of cluster,
 // and throws an exception otherwise.
 
+bool OriginalDstCluster::LoadBalancer::HostMap::makeKey(const Network::Address::Instance& address,
+                                                        Key& key) {
+  const Network::Address::Ip* ip = address.ip();
+  if (!ip) {
+    return false;
+  }
+
+  key.fill(0);
+  if (ip->version() == Network::Address::IpVersion::v4) {
+    key[0] = 4;
+    const uint32_t ipv4 = ip->ipv4()->address();
+    memcpy(&key[1], &ipv4, sizeof(ipv4));
+  } else {
+    key[0] = 6;
+    const std::array<uint8_t, 16> ipv6 = ip->ipv6()->address();
+    memcpy(&key[1], ipv6.data(), ipv6.size());
+  }
+  const uint16_t port = htons(ip->port());
+  memcpy(&key[17], &port, sizeof(port));
+  return true;
+}
+
+bool OriginalDstCluster::LoadBalancer::HostMap::insert(const HostSharedPtr& host, bool check) {
+  Key key;
+  const bool is_ip = makeKey(*host->address(), key);
+  ASSERT(is_ip);
+  UNREFERENCED_PARAMETER(is_ip);
+  if (check) {
+    auto range = map_.equal_range(key);
+    auto it = std::find_if(
+        range.first, range.second,
+        [&host](const decltype(map_)::value_type& pair) { return pair.second == host; });
+    if (it != range.second) {
+      return false; // 'host' already in the map, no need to insert.
+    }
+  }
+  map_.emplace(key, host);
+  return true;
+}
+
+void OriginalDstCluster::LoadBalancer::HostMap::remove(const HostSharedPtr& host) {
+  Key key;
+  const bool is_ip = makeKey(*host->address(), key);
+  ASSERT(is_ip);
+  UNREFERENCED_PARAMETER(is_ip);
+  auto range = map_.equal_range(key);
+  auto it = std::find_if(
+      range.first, range.second,
+      [&host](const decltype(map_)::value_type& pair) { return pair.second == host; });
+  ASSERT(it != range.second);
+  map_.erase(it);
+}
+
+HostSharedPtr
+OriginalDstCluster::LoadBalancer::HostMap::find(const Network::Address::Instance& address) {
+  Key key;
+  if (!makeKey(address, key)) {
+    return nullptr;
+  }
+
+  auto it = map_.find(key);
+  if (it != map_.end()) {
+    return it->second;
+  }
+  return nullptr;
+}
+
 OriginalDstCluster::LoadBalancer::LoadBalancer(PrioritySet& priority_set, ClusterSharedPtr& parent)
     : priority_set_(priority_set), parent_(std::static_pointer_cast<OriginalDstCluster>(parent)),
       info_(parent->info()) {
@@ -99,19 +170,32 @@ OriginalDstCluster::OriginalDstCluster(const envoy::api::v2::Cluster& config,
                       added_via_api),
       dispatcher_(dispatcher), cleanup_interval_ms_(std::chrono::milliseconds(
                                    PROTOBUF_GET_MS_OR_DEFAULT(config, cleanup_interval, 5000))),
-      cleanup_timer_(dispatcher.createTimer([this]() -> void { cleanup(); })) {
+      cleanup_timer_(dispatcher.createTimer([this]() -> void { cleanup(); })),
+      add_hosts_timer_(dispatcher.createTimer([this]() -> void { addPendingHosts(); })) {
 
   cleanup_timer_->enableTimer(cleanup_interval_ms_);
 }
 
 void OriginalDstCluster::addHost(HostSharedPtr& host) {
+  if (pending_hosts_.empty()) {
+    add_hosts_timer_->enableTimer(std::chrono::milliseconds(0));
+  }
+  pending_hosts_.emplace_back(std::move(host));
+}
+
+void OriginalDstCluster::addPendingHosts() {
   // Given the current config, only EDS clusters support multiple priorities.
   ASSERT(priority_set_.hostSetsPerPriority().size() == 1);
   auto& first_host_set = priority_set_.getOrCreateHostSet(0);
-  HostVectorSharedPtr new_hosts(new std::vector<HostSharedPtr>(first_host_set.hosts()));
-  new_hosts->emplace_back(host);
+  HostVectorSharedPtr new_hosts(new std::vector<HostSharedPtr>());
+  new_hosts->reserve(first_host_set.hosts().size() + pending_hosts_.size());
+  new_hosts->insert(new_hosts->end(), first_host_set.hosts().begin(),
+                    first_host_set.hosts().end());
+  new_hosts->insert(new_hosts->end(), pending_hosts_.begin(), pending_hosts_.end());
+  std::vector<HostSharedPtr> hosts_added;
+  hosts_added.swap(pending_hosts_);
   first_host_set.updateHosts(new_hosts, createHealthyHostList(*new_hosts), empty_host_lists_,
-                             empty_host_lists_, {std::move(host)}, {});
+                             empty_host_lists_, hosts_added, {});
 }
 
 void OriginalDstCluster::cleanup() {
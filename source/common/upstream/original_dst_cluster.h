@@ -1,13 +1,16 @@
 #pragma once
 
+#include <array>
 #include <cstdint>
 #include <functional>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "envoy/thread_local/thread_local.h"
 
 #include "common/common/empty_string.h"
+#include "common/common/hash.h"
 #include "common/common/logger.h"
 #include "common/upstream/upstream_impl.h"
 
@@ -50,45 +53,32 @@ public:
   private:
     /**
      * Map from an host IP address/port to a HostSharedPtr. Due to races multiple distinct host
-     * objects with the same address can be created, so we need to use a multimap.
+     * objects with the same address can be created, so we need to use a multimap. Hosts are keyed
+     * by the binary form of their address so that lookups do not format or hash address strings.
      */
     class HostMap {
     public:
-      bool insert(const HostSharedPtr& host, bool check = true) {
-        if (check) {
-          auto range = map_.equal_range(host->address()->asString());
-          auto it = std::find_if(
-              range.first, range.second,
-              [&host](const decltype(map_)::value_type pair) { return pair.second == host; });
-          if (it != range.second) {
-            return false; // 'host' already in the map, no need to insert.
-          }
-        }
-        map_.emplace(host->address()->asString(), host);
-        return true;
-      }
-
-      void remove(const HostSharedPtr& host) {
-        auto range = map_.equal_range(host->address()->asString());
-        auto it =
-            std::find_if(range.first, range.second, [&host](const decltype(map_)::value_type pair) {
-              return pair.second == host;
-            });
-        ASSERT(it != range.second);
-        map_.erase(it);
-      }
-
-      HostSharedPtr find(const Network::Address::Instance& address) {
-        auto it = map_.find(address.asString());
-
-        if (it != map_.end()) {
-          return it->second;
-        }
-        return nullptr;
-      }
+      bool insert(const HostSharedPtr& host, bool check = true);
+      void remove(const HostSharedPtr& host);
+      HostSharedPtr find(const Network::Address::Instance& address);
 
     private:
-      std::unordered_multimap<std::string, HostSharedPtr> map_;
+      // The address family, the IP address (IPv4 in the first 4 bytes) and the port in network
+      // byte order.
+      typedef std::array<uint8_t, 19> Key;
+
+      struct KeyHash {
+        size_t operator()(const Key& key) const {
+          return HashUtil::xxHash64(reinterpret_cast<const char*>(key.data()), key.size());
+        }
+      };
+
+      /**
+       * @return bool whether address is an IP address, in which case key receives its key.
+       */
+      static bool makeKey(const Network::Address::Instance& address, Key& key);
+
+      std::unordered_multimap<Key, HostSharedPtr, KeyHash> map_;
     };
 
     PrioritySet& priority_set_;                // Thread local priority set.
@@ -99,6 +89,7 @@ public:
 
 private:
   void addHost(HostSharedPtr&);
+  void addPendingHosts();
   void cleanup();
 
   // ClusterImplBase
@@ -107,6 +98,11 @@ private:
   Event::Dispatcher& dispatcher_;
   const std::chrono::milliseconds cleanup_interval_ms_;
   Event::TimerPtr cleanup_timer_;
+  // Hosts that workers created since the host set was last updated. They are added in one update
+  // on the next iteration of the event loop, since every update copies the whole host set and
+  // propagates it to all workers.
+  std::vector<HostSharedPtr> pending_hosts_;
+  Event::TimerPtr add_hosts_timer_;
 };
 
 } // namespace Upstream
@@ -1,5 +1,6 @@
 #include "common/upstream/outlier_detection_impl.h"
 
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
 #include <memory>
@@ -20,6 +21,12 @@ namespace Envoy {
 namespace Upstream {
 namespace Outlier {
 
+namespace {
+// Looked up for every 5xx response.
+const Runtime::Key ConsecutiveGatewayFailureKey("outlier_detection.consecutive_gateway_failure");
+const Runtime::Key Consecutive5xxKey("outlier_detection.consecutive_5xx");
+} // namespace
+
 DetectorSharedPtr DetectorImplFactory::createForCluster(
     Cluster& cluster, const envoy::api::v2::Cluster& cluster_config, Event::Dispatcher& dispatcher,
     Runtime::Loader& runtime, EventLoggerSharedPtr event_logger) {
@@ -31,6 +38,17 @@ DetectorSharedPtr DetectorImplFactory::createForCluster(
   }
 }
 
+DetectorHostMonitorImpl::DetectorHostMonitorImpl(std::shared_ptr<DetectorImpl> detector,
+                                                 HostSharedPtr host)
+    : detector_(detector), host_(host), success_rate_(-1) {
+  // Point the success_rate_accumulator_bucket_ pointer to a bucket.
+  updateCurrentSuccessRateBucket();
+  if (detector->latencyDetectionEnabled()) {
+    latency_accumulator_.reset(new LatencyAccumulator());
+    updateCurrentLatencyBucket();
+  }
+}
+
 void DetectorHostMonitorImpl::eject(MonotonicTime ejection_time) {
   ASSERT(!host_.lock()->healthFlagGet(Host::HealthFlag::FAILED_OUTLIER_CHECK));
   host_.lock()->healthFlagSet(Host::HealthFlag::FAILED_OUTLIER_CHECK);
@@ -46,6 +64,19 @@ void DetectorHostMonitorImpl::updateCurrentSuccessRateBucket() {
   success_rate_accumulator_bucket_.store(success_rate_accumulator_.updateCurrentWriter());
 }
 
+void DetectorHostMonitorImpl::updateCurrentLatencyBucket() {
+  if (latency_accumulator_) {
+    latency_accumulator_bucket_.store(latency_accumulator_->updateCurrentWriter());
+  }
+}
+
+void DetectorHostMonitorImpl::putResponseTime(std::chrono::milliseconds response_time) {
+  LatencyAccumulatorBucket* bucket = latency_accumulator_bucket_.load();
+  if (bucket != nullptr) {
+    bucket->counters_[LatencyAccumulatorBucket::bucketIndex(response_time.count())]++;
+  }
+}
+
 void DetectorHostMonitorImpl::putHttpResponseCode(uint64_t response_code) {
   success_rate_accumulator_bucket_.load()->total_request_counter_++;
   if (Http::CodeUtility::is5xx(response_code)) {
@@ -55,9 +86,9 @@ void DetectorHostMonitorImpl::putHttpResponseCode(uint64_t response_code) {
       return;
     }
     if (Http::CodeUtility::isGatewayError(response_code)) {
-      if (++consecutive_gateway_failure_ == detector->runtime().snapshot().getInteger(
-                                                "outlier_detection.consecutive_gateway_failure",
-                                                detector->config().consecutiveGatewayFailure())) {
+      if (++consecutive_gateway_failure_ ==
+          detector->runtime().snapshot().getInteger(
+              ConsecutiveGatewayFailureKey, detector->config().consecutiveGatewayFailure())) {
         detector->onConsecutiveGatewayFailure(host_.lock());
       }
     } else {
@@ -65,7 +96,7 @@ void DetectorHostMonitorImpl::putHttpResponseCode(uint64_t response_code) {
     }
 
     if (++consecutive_5xx_ ==
-        detector->runtime().snapshot().getInteger("outlier_detection.consecutive_5xx",
+        detector->runtime().snapshot().getInteger(Consecutive5xxKey,
                                                   detector->config().consecutive5xx())) {
       detector->onConsecutive5xx(host_.lock());
     }
@@ -127,7 +158,10 @@ DetectorImpl::DetectorImpl(const Cluster& cluster,
                            const envoy::api::v2::Cluster::OutlierDetection& config,
                            Event::Dispatcher& dispatcher, Runtime::Loader& runtime,
                            MonotonicTimeSource& time_source, EventLoggerSharedPtr event_logger)
-    : config_(config), dispatcher_(dispatcher), runtime_(runtime), time_source_(time_source),
+    : config_(config), dispatcher_(dispatcher), runtime_(runtime),
+      latency_detection_enabled_(
+          runtime.snapshot().getInteger("outlier_detection.latency_enabled", 0) != 0),
+      time_source_(time_source),
       stats_(generateStats(cluster.info()->statsScope())),
       interval_timer_(dispatcher.createTimer([this]() -> void { onIntervalTimer(); })),
       event_logger_(event_logger), success_rate_average_(-1), success_rate_ejection_threshold_(-1) {
@@ -230,6 +264,8 @@ bool DetectorImpl::enforceEjection(EjectionType type) {
   case EjectionType::SuccessRate:
     return runtime_.snapshot().featureEnabled("outlier_detection.enforcing_success_rate",
                                               config_.enforcingSuccessRate());
+  case EjectionType::Latency:
+    return runtime_.snapshot().featureEnabled("outlier_detection.enforcing_latency", 100);
   }
 
   NOT_REACHED;
@@ -247,6 +283,9 @@ void DetectorImpl::updateEnforcedEjectionStats(EjectionType type) {
   case EjectionType::ConsecutiveGatewayFailure:
     stats_.ejections_enforced_consecutive_gateway_failure_.inc();
     break;
+  case EjectionType::Latency:
+    stats_.ejections_enforced_latency_.inc();
+    break;
   }
 }
 
@@ -340,6 +379,7 @@ void DetectorImpl::onConsecutiveErrorWorker(HostSharedPtr host, EjectionType typ
     host_monitors_[host]->resetConsecutiveGatewayFailure();
     break;
   case EjectionType::SuccessRate:
+  case EjectionType::Latency:
     NOT_REACHED;
   }
 }
@@ -428,6 +468,58 @@ void DetectorImpl::processSuccessRateEjections() {
   }
 }
 
+void DetectorImpl::processLatencyEjections() {
+  uint64_t latency_minimum_hosts =
+      runtime_.snapshot().getInteger("outlier_detection.latency_minimum_hosts", 5);
+  uint64_t latency_request_volume =
+      runtime_.snapshot().getInteger("outlier_detection.latency_request_volume", 100);
+  double latency_percentile = std::min<uint64_t>(
+      100, runtime_.snapshot().getInteger("outlier_detection.latency_percentile", 99));
+
+  // Exit early if there are not enough hosts.
+  if (host_monitors_.size() < latency_minimum_hosts) {
+    return;
+  }
+
+  std::vector<std::pair<HostSharedPtr, uint64_t>> valid_latency_hosts;
+  valid_latency_hosts.reserve(host_monitors_.size());
+  for (const auto& host : host_monitors_) {
+    // Don't do work if the host is already ejected.
+    if (!host.first->healthFlagGet(Host::HealthFlag::FAILED_OUTLIER_CHECK)) {
+      Optional<uint64_t> host_latency = host.second->latencyAccumulator()->getPercentile(
+          latency_request_volume, latency_percentile);
+      if (host_latency.valid()) {
+        valid_latency_hosts.emplace_back(host.first, host_latency.value());
+      }
+    }
+  }
+
+  if (valid_latency_hosts.size() < latency_minimum_hosts) {
+    return;
+  }
+
+  // A host is an outlier if its percentile is a factor above the median percentile of the
+  // cluster. The median is not moved by the outliers themselves, unlike the mean used for success
+  // rate, and it is floored to 1ms so that sub millisecond clusters don't eject on any jitter.
+  std::vector<uint64_t> latencies;
+  latencies.reserve(valid_latency_hosts.size());
+  for (const auto& host_latency_pair : valid_latency_hosts) {
+    latencies.push_back(host_latency_pair.second);
+  }
+  std::nth_element(latencies.begin(), latencies.begin() + latencies.size() / 2, latencies.end());
+  double latency_factor =
+      runtime_.snapshot().getInteger("outlier_detection.latency_factor", 3000) / 1000.0;
+  double latency_ejection_threshold =
+      std::max<uint64_t>(1, latencies[latencies.size() / 2]) * latency_factor;
+
+  for (const auto& host_latency_pair : valid_latency_hosts) {
+    if (host_latency_pair.second > latency_ejection_threshold) {
+      stats_.ejections_detected_latency_.inc();
+      ejectHost(host_latency_pair.first, EjectionType::Latency);
+    }
+  }
+}
+
 void DetectorImpl::onIntervalTimer() {
   MonotonicTime now = time_source_.currentTime();
 
@@ -436,12 +528,16 @@ void DetectorImpl::onIntervalTimer() {
 
     // Need to update the writer bucket to keep the data valid.
     host.second->updateCurrentSuccessRateBucket();
+    host.second->updateCurrentLatencyBucket();
     // Refresh host success rate stat for the /clusters endpoint. If there is a new valid value, it
     // will get updated in processSuccessRateEjections().
     host.second->successRate(-1);
   }
 
   processSuccessRateEjections();
+  if (latency_detection_enabled_) {
+    processLatencyEjections();
+  }
 
   armIntervalTimer();
 }
@@ -489,6 +585,7 @@ void EventLoggerImpl::logEject(HostDescriptionConstSharedPtr host, Detector& det
   switch (type) {
   case EjectionType::Consecutive5xx:
   case EjectionType::ConsecutiveGatewayFailure:
+  case EjectionType::Latency:
     file_->write(fmt::format(
         json_5xx, AccessLogDateTimeFormatter::fromTime(now),
         secsSinceLastAction(host->outlierDetector().lastUnejectionTime(), monotonic_now),
@@ -535,6 +632,8 @@ std::string EventLoggerImpl::typeToString(EjectionType type) {
     return "GatewayFailure";
   case EjectionType::SuccessRate:
     return "SuccessRate";
+  case EjectionType::Latency:
+    return "Latency";
   }
 
   NOT_REACHED;
@@ -567,6 +666,73 @@ Optional<double> SuccessRateAccumulator::getSuccessRate(uint64_t success_rate_re
                           backup_success_rate_bucket_->total_request_counter_);
 }
 
+const size_t LatencyAccumulatorBucket::NUM_BUCKETS;
+
+size_t LatencyAccumulatorBucket::bucketIndex(uint64_t latency_ms) {
+  if (latency_ms < 4) {
+    return latency_ms;
+  }
+
+  // Past the first four buckets, each power of two is split into four buckets by the two bits
+  // below the most significant bit.
+  const uint64_t msb = 63 - __builtin_clzll(latency_ms);
+  const uint64_t sub_bucket = (latency_ms >> (msb - 2)) & 3;
+  return std::min<uint64_t>(NUM_BUCKETS - 1, (msb - 1) * 4 + sub_bucket);
+}
+
+uint64_t LatencyAccumulatorBucket::bucketUpperBound(size_t index) {
+  if (index < 4) {
+    return index;
+  }
+
+  const uint64_t msb = index / 4 + 1;
+  const uint64_t sub_bucket = index % 4;
+  return ((4 + sub_bucket + 1) << (msb - 2)) - 1;
+}
+
+Optional<uint64_t> LatencyAccumulatorBucket::getPercentile(uint64_t request_volume,
+                                                           double percentile) const {
+  // Snapshot the counters once, so that the total and the walk below agree even if a worker is
+  // still writing to the bucket.
+  std::array<uint32_t, NUM_BUCKETS> counters;
+  uint64_t total = 0;
+  for (size_t i = 0; i < counters.size(); i++) {
+    counters[i] = counters_[i];
+    total += counters[i];
+  }
+
+  if (total == 0 || total < request_volume) {
+    return Optional<uint64_t>();
+  }
+
+  const uint64_t rank = std::max<uint64_t>(1, std::ceil(total * percentile / 100));
+  uint64_t seen = 0;
+  for (size_t i = 0; i < counters.size(); i++) {
+    seen += counters[i];
+    if (seen >= rank) {
+      return Optional<uint64_t>(bucketUpperBound(i));
+    }
+  }
+
+  NOT_REACHED;
+}
+
+LatencyAccumulatorBucket* LatencyAccumulator::updateCurrentWriter() {
+  // Right now current is being written to and backup is not. Flush the backup and swap.
+  for (std::atomic<uint32_t>& counter : backup_latency_bucket_->counters_) {
+    counter = 0;
+  }
+
+  current_latency_bucket_.swap(backup_latency_bucket_);
+
+  return current_latency_bucket_.get();
+}
+
+Optional<uint64_t> LatencyAccumulator::getPercentile(uint64_t latency_request_volume,
+                                                     double percentile) {
+  return backup_latency_bucket_->getPercentile(latency_request_volume, percentile);
+}
+
 } // namespace Outlier
 } // namespace Upstream
 } // namespace Envoy
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <atomic>
 #include <chrono>
 #include <cstdint>
@@ -97,6 +98,72 @@ private:
   std::unique_ptr<SuccessRateAccumulatorBucket> backup_success_rate_bucket_;
 };
 
+/**
+ * Latency histogram with a fixed set of logarithmically spaced buckets, four per power of two
+ * milliseconds, so that any recorded value is within 25% of its bucket's upper bound. Workers only
+ * ever increment the buckets, so response times are recorded without locking.
+ */
+struct LatencyAccumulatorBucket {
+  static const size_t NUM_BUCKETS = 64;
+
+  /**
+   * @param latency_ms supplies a response time in milliseconds.
+   * @return size_t the index of the bucket the response time is counted in.
+   */
+  static size_t bucketIndex(uint64_t latency_ms);
+
+  /**
+   * @param index supplies a bucket index.
+   * @return uint64_t the largest response time in milliseconds counted in the bucket.
+   */
+  static uint64_t bucketUpperBound(size_t index);
+
+  /**
+   * @param request_volume supplies the least number of response times that must have been counted
+   *        to get a significant percentile.
+   * @param percentile supplies the percentile to compute, between 0 and 100.
+   * @return Optional<uint64_t> the percentile in milliseconds, rounded up to the upper bound of its
+   *         bucket, or an invalid Optional if too few response times were counted.
+   */
+  Optional<uint64_t> getPercentile(uint64_t request_volume, double percentile) const;
+
+  std::array<std::atomic<uint32_t>, NUM_BUCKETS> counters_;
+};
+
+/**
+ * The LatencyAccumulator gets per host latency percentiles the same way that the
+ * SuccessRateAccumulator gets success rates: workers write to the current bucket, and the main
+ * thread reads the bucket of the last interval.
+ */
+class LatencyAccumulator {
+public:
+  LatencyAccumulator()
+      : current_latency_bucket_(new LatencyAccumulatorBucket()),
+        backup_latency_bucket_(new LatencyAccumulatorBucket()) {}
+
+  /**
+   * This function updates the bucket to write data to.
+   * @return a pointer to the LatencyAccumulatorBucket.
+   */
+  LatencyAccumulatorBucket* updateCurrentWriter();
+
+  /**
+   * This function returns a latency percentile of a host over the last window of time if the
+   * request volume is high enough.
+   * @param latency_request_volume the threshold of requests an accumulator has to have in order to
+   *                               be able to return a significant percentile.
+   * @param percentile supplies the percentile to compute, between 0 and 100.
+   * @return a valid Optional<uint64_t> with the percentile in milliseconds, rounded up to the upper
+   *         bound of its bucket. If there were not enough requests, an invalid Optional<uint64_t>
+   *         is returned.
+   */
+  Optional<uint64_t> getPercentile(uint64_t latency_request_volume, double percentile);
+
+private:
+  std::unique_ptr<LatencyAccumulatorBucket> current_latency_bucket_;
+  std::unique_ptr<LatencyAccumulatorBucket> backup_latency_bucket_;
+};
+
 class DetectorImpl;
 
 /**
@@ -104,16 +171,15 @@ class DetectorImpl;
  */
 class DetectorHostMonitorImpl : public DetectorHostMonitor {
 public:
-  DetectorHostMonitorImpl(std::shared_ptr<DetectorImpl> detector, HostSharedPtr host)
-      : detector_(detector), host_(host), success_rate_(-1) {
-    // Point the success_rate_accumulator_bucket_ pointer to a bucket.
-    updateCurrentSuccessRateBucket();
-  }
+  DetectorHostMonitorImpl(std::shared_ptr<DetectorImpl> detector, HostSharedPtr host);
 
   void eject(MonotonicTime ejection_time);
   void uneject(MonotonicTime ejection_time);
   void updateCurrentSuccessRateBucket();
+  void updateCurrentLatencyBucket();
   SuccessRateAccumulator& successRateAccumulator() { return success_rate_accumulator_; }
+  // Only present if latency detection was enabled when the detector was created.
+  LatencyAccumulator* latencyAccumulator() { return latency_accumulator_.get(); }
   void successRate(double new_success_rate) { success_rate_ = new_success_rate; }
   void resetConsecutive5xx() { consecutive_5xx_ = 0; }
   void resetConsecutiveGatewayFailure() { consecutive_gateway_failure_ = 0; }
@@ -122,7 +188,7 @@ public:
   uint32_t numEjections() override { return num_ejections_; }
   void putHttpResponseCode(uint64_t response_code) override;
   void putResult(Result result) override;
-  void putResponseTime(std::chrono::milliseconds) override {}
+  void putResponseTime(std::chrono::milliseconds response_time) override;
   const Optional<MonotonicTime>& lastEjectionTime() override { return last_ejection_time_; }
   const Optional<MonotonicTime>& lastUnejectionTime() override { return last_unejection_time_; }
   double successRate() const override { return success_rate_; }
@@ -137,6 +203,8 @@ private:
   uint32_t num_ejections_{};
   SuccessRateAccumulator success_rate_accumulator_;
   std::atomic<SuccessRateAccumulatorBucket*> success_rate_accumulator_bucket_;
+  std::unique_ptr<LatencyAccumulator> latency_accumulator_;
+  std::atomic<LatencyAccumulatorBucket*> latency_accumulator_bucket_{nullptr};
   double success_rate_;
 };
 
@@ -156,7 +224,9 @@ private:
   COUNTER(ejections_detected_success_rate)                                                         \
   COUNTER(ejections_enforced_success_rate)                                                         \
   COUNTER(ejections_detected_consecutive_gateway_failure)                                          \
-  COUNTER(ejections_enforced_consecutive_gateway_failure)
+  COUNTER(ejections_enforced_consecutive_gateway_failure)                                          \
+  COUNTER(ejections_detected_latency)                                                              \
+  COUNTER(ejections_enforced_latency)
 // clang-format on
 
 /**
@@ -216,6 +286,7 @@ public:
   void onConsecutiveGatewayFailure(HostSharedPtr host);
   Runtime::Loader& runtime() { return runtime_; }
   DetectorConfig& config() { return config_; }
+  bool latencyDetectionEnabled() const { return latency_detection_enabled_; }
 
   // Upstream::Outlier::Detector
   void addChangedStateCb(ChangeStateCb cb) override { callbacks_.push_back(cb); }
@@ -240,10 +311,14 @@ private:
   bool enforceEjection(EjectionType type);
   void updateEnforcedEjectionStats(EjectionType type);
   void processSuccessRateEjections();
+  void processLatencyEjections();
 
   DetectorConfig config_;
   Event::Dispatcher& dispatcher_;
   Runtime::Loader& runtime_;
+  // Latency histograms cost memory per host and work per request, so they are only kept if the
+  // outlier_detection.latency_enabled runtime key is set when the detector is created.
+  const bool latency_detection_enabled_;
   MonotonicTimeSource& time_source_;
   DetectionStats stats_;
   Event::TimerPtr interval_timer_;
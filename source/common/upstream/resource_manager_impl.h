@@ -1,7 +1,9 @@
 #pragma once
 
 #include <atomic>
+#include <algorithm>
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <string>
 
@@ -24,13 +26,23 @@ namespace Upstream {
  */
 class ResourceManagerImpl : public ResourceManager {
 public:
+  /**
+   * Returns the number of requests that are active or pending on the cluster.
+   */
+  typedef std::function<uint64_t()> ActiveRequestsCb;
+
+  /**
+   * @param active_requests supplies the number of requests a retry budget is a percentage of. If it
+   *        is empty, retries are only limited by max_retries.
+   */
   ResourceManagerImpl(Runtime::Loader& runtime, const std::string& runtime_key,
                       uint64_t max_connections, uint64_t max_pending_requests,
-                      uint64_t max_requests, uint64_t max_retries)
+                      uint64_t max_requests, uint64_t max_retries,
+                      ActiveRequestsCb active_requests = nullptr)
       : connections_(max_connections, runtime, runtime_key + "max_connections"),
         pending_requests_(max_pending_requests, runtime, runtime_key + "max_pending_requests"),
         requests_(max_requests, runtime, runtime_key + "max_requests"),
-        retries_(max_retries, runtime, runtime_key + "max_retries") {}
+        retries_(max_retries, runtime, runtime_key, active_requests) {}
 
   // Upstream::ResourceManager
   Resource& connections() override { return connections_; }
@@ -59,10 +71,43 @@ private:
     const std::string runtime_key_;
   };
 
+  /**
+   * Retries are limited by max_retries unless the retry_budget.budget_percent runtime key is set.
+   * A retry budget instead allows that percentage of the cluster's active and pending requests to
+   * be retries, and at least retry_budget.min_retry_concurrency, which defaults to max_retries. A
+   * budget scales with traffic, so it neither amplifies an outage at high load nor throttles
+   * retries at low load.
+   */
+  struct RetriesImpl : public ResourceImpl {
+    RetriesImpl(uint64_t max, Runtime::Loader& runtime, const std::string& runtime_key,
+                ActiveRequestsCb active_requests)
+        : ResourceImpl(max, runtime, runtime_key + "max_retries"),
+          budget_percent_key_(runtime_key + "retry_budget.budget_percent"),
+          min_retry_concurrency_key_(runtime_key + "retry_budget.min_retry_concurrency"),
+          active_requests_(active_requests) {}
+
+    // Upstream::Resource
+    uint64_t max() override {
+      const uint64_t budget_percent =
+          active_requests_ ? runtime_.snapshot().getInteger(budget_percent_key_, 0) : 0;
+      if (budget_percent == 0) {
+        return ResourceImpl::max();
+      }
+
+      const uint64_t min_retry_concurrency =
+          runtime_.snapshot().getInteger(min_retry_concurrency_key_, max_);
+      return std::max(min_retry_concurrency, active_requests_() * budget_percent / 100);
+    }
+
+    const std::string budget_percent_key_;
+    const std::string min_retry_concurrency_key_;
+    const ActiveRequestsCb active_requests_;
+  };
+
   ResourceImpl connections_;
   ResourceImpl pending_requests_;
   ResourceImpl requests_;
-  ResourceImpl retries_;
+  RetriesImpl retries_;
 };
 
 typedef std::unique_ptr<ResourceManagerImpl> ResourceManagerImplPtr;
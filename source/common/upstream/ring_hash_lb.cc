@@ -1,11 +1,13 @@
 #include "common/upstream/ring_hash_lb.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
 #include "common/common/assert.h"
-#include "common/upstream/load_balancer_impl.h"
+#include "common/common/hash.h"
 
 namespace Envoy {
 namespace Upstream {
@@ -14,43 +16,62 @@ RingHashLoadBalancer::RingHashLoadBalancer(
     PrioritySet& priority_set, ClusterStats& stats, Runtime::Loader& runtime,
     Runtime::RandomGenerator& random,
     const Optional<envoy::api::v2::Cluster::RingHashLbConfig>& config)
-    : host_set_(*priority_set.hostSetsPerPriority()[0]), stats_(stats), runtime_(runtime),
-      random_(random), config_(config) {
-  priority_set.addMemberUpdateCb([this](uint32_t priority, const std::vector<HostSharedPtr>&,
-                                        const std::vector<HostSharedPtr>&) -> void {
-    // priority!=0 will be blocked by EDS validation.
-    ASSERT(priority == 0); // TODO(alyssawilk) make ring hash LB priority-aware.
-    UNREFERENCED_PARAMETER(priority);
-    refresh();
-  });
-
+    : ThreadAwareLoadBalancerBase(priority_set, stats, runtime, random), config_(config) {
   refresh();
 }
 
-HostConstSharedPtr RingHashLoadBalancer::chooseHost(LoadBalancerContext* context) {
-  if (LoadBalancerUtility::isGlobalPanic(host_set_, runtime_)) {
-    stats_.lb_healthy_panic_.inc();
-    return all_hosts_ring_.chooseHost(context, random_);
+ThreadAwareLoadBalancerBase::HashingLoadBalancerSharedPtr
+RingHashLoadBalancer::createAllHostsLoadBalancer(const HostSet& host_set) {
+  std::shared_ptr<Ring> ring(new Ring());
+  if (all_hosts_ring_ == nullptr) {
+    ring->create(config_, host_set.hosts());
   } else {
-    return healthy_hosts_ring_.chooseHost(context, random_);
+    ring->update(*all_hosts_ring_, config_, host_set.hosts());
+  }
+
+  all_hosts_ring_ = ring;
+  return ring;
+}
+
+ThreadAwareLoadBalancerBase::HashingLoadBalancerSharedPtr
+RingHashLoadBalancer::createHealthyHostsLoadBalancer(const HostSet& host_set) {
+  ASSERT(all_hosts_ring_ != nullptr);
+  std::shared_ptr<Ring> ring(new Ring());
+  ring->filter(*all_hosts_ring_, host_set.healthyHosts());
+  return ring;
+}
+
+HostConstSharedPtr RingHashLoadBalancer::Ring::chooseHost(uint64_t h) const {
+  if (ring_.empty()) {
+    return nullptr;
   }
+
+  return ring_[entryIndex(h)].host_;
 }
 
-HostConstSharedPtr RingHashLoadBalancer::Ring::chooseHost(LoadBalancerContext* context,
-                                                          Runtime::RandomGenerator& random) {
+HostConstSharedPtr RingHashLoadBalancer::Ring::chooseHost(uint64_t h,
+                                                          const HostPredicate& accept) const {
   if (ring_.empty()) {
     return nullptr;
   }
 
-  // If there is no hash in the context, just choose a random value (this effectively becomes
-  // the random LB but it won't crash if someone configures it this way).
-  // computeHashKey() may be computed on demand, so get it only once.
-  Optional<uint64_t> hash;
-  if (context) {
-    hash = context->computeHashKey();
+  // Walk the ring clockwise, only asking about each run of entries of the same host once.
+  const size_t index = entryIndex(h);
+  const Host* rejected = nullptr;
+  for (size_t i = 0; i < ring_.size(); i++) {
+    const HostConstSharedPtr& host = ring_[(index + i) % ring_.size()].host_;
+    if (host.get() != rejected) {
+      if (accept(*host)) {
+        return host;
+      }
+      rejected = host.get();
+    }
   }
-  const uint64_t h = hash.valid() ? hash.value() : random.random();
 
+  return ring_[index].host_;
+}
+
+size_t RingHashLoadBalancer::Ring::entryIndex(uint64_t h) const {
   // Ported from https://github.com/RJ/ketama/blob/master/libketama/ketama.c (ketama_get_server)
   // I've generally kept the variable names to make the code easier to compare.
   // NOTE: The algorithm depends on using signed integers for lowp, midp, and highp. Do not
@@ -61,14 +82,14 @@ HostConstSharedPtr RingHashLoadBalancer::Ring::chooseHost(LoadBalancerContext* c
     int64_t midp = (lowp + highp) / 2;
 
     if (midp == static_cast<int64_t>(ring_.size())) {
-      return ring_[0].host_;
+      return 0;
     }
 
     uint64_t midval = ring_[midp].hash_;
     uint64_t midval1 = midp == 0 ? 0 : ring_[midp - 1].hash_;
 
     if (h <= midval && h > midval1) {
-      return ring_[midp].host_;
+      return midp;
     }
 
     if (midval < h) {
@@ -78,16 +99,39 @@ HostConstSharedPtr RingHashLoadBalancer::Ring::chooseHost(LoadBalancerContext* c
     }
 
     if (lowp > highp) {
-      return ring_[0].host_;
+      return 0;
+    }
+  }
+}
+
+namespace {
+
+uint64_t minRingSize(const Optional<envoy::api::v2::Cluster::RingHashLbConfig>& config) {
+  return config.valid() ? PROTOBUF_GET_WRAPPED_OR_DEFAULT(config.value(), minimum_ring_size, 1024)
+                        : 1024;
+}
+
+uint64_t hashesPerHost(uint64_t min_ring_size, uint64_t num_hosts) {
+  uint64_t hashes_per_host = 1;
+  if (num_hosts < min_ring_size) {
+    hashes_per_host = min_ring_size / num_hosts;
+    if ((min_ring_size % num_hosts) != 0) {
+      hashes_per_host++;
     }
   }
+
+  return hashes_per_host;
 }
 
+} // namespace
+
 void RingHashLoadBalancer::Ring::create(
     const Optional<envoy::api::v2::Cluster::RingHashLbConfig>& config,
     const std::vector<HostSharedPtr>& hosts) {
   ENVOY_LOG(trace, "ring hash: building ring");
   ring_.clear();
+  hosts_.clear();
+  hashes_per_host_ = 0;
   if (hosts.empty()) {
     return;
   }
@@ -95,32 +139,84 @@ void RingHashLoadBalancer::Ring::create(
   // Currently we specify the minimum size of the ring, and determine the replication factor
   // based on the number of hosts. It's possible we might want to support more sophisticated
   // configuration in the future.
-  // NOTE: Currently we keep a ring for healthy hosts and unhealthy hosts, and this is done per
-  //       thread. This is the simplest implementation, but it's expensive from a memory
-  //       standpoint and duplicates the regeneration computation. In the future we might want
-  //       to generate the rings centrally and then just RCU them out to each thread. This is
-  //       sufficient for getting started.
-  const uint64_t min_ring_size =
-      config.valid() ? PROTOBUF_GET_WRAPPED_OR_DEFAULT(config.value(), minimum_ring_size, 1024)
-                     : 1024;
+  const uint64_t min_ring_size = minRingSize(config);
+  hashes_per_host_ = hashesPerHost(min_ring_size, hosts.size());
+
+  ENVOY_LOG(info, "ring hash: min_ring_size={} hashes_per_host={}", min_ring_size,
+            hashes_per_host_);
+  ring_.reserve(hosts.size() * hashes_per_host_);
+  addEntries(config, hosts);
+  std::sort(ring_.begin(), ring_.end());
+#ifndef NVLOG
+  for (auto entry : ring_) {
+    ENVOY_LOG(trace, "ring hash: host={} hash={}", entry.host_->address()->asString(), entry.hash_);
+  }
+#endif
+}
 
-  uint64_t hashes_per_host = 1;
-  if (hosts.size() < min_ring_size) {
-    hashes_per_host = min_ring_size / hosts.size();
-    if ((min_ring_size % hosts.size()) != 0) {
-      hashes_per_host++;
+void RingHashLoadBalancer::Ring::update(
+    const Ring& previous, const Optional<envoy::api::v2::Cluster::RingHashLbConfig>& config,
+    const std::vector<HostSharedPtr>& hosts) {
+  if (previous.ring_.empty() || hosts.empty() ||
+      hashesPerHost(minRingSize(config), hosts.size()) != previous.hashes_per_host_) {
+    create(config, hosts);
+    return;
+  }
+
+  hashes_per_host_ = previous.hashes_per_host_;
+  std::vector<HostSharedPtr> added_hosts;
+  for (const auto& host : hosts) {
+    if (previous.hosts_.count(host.get()) == 0) {
+      added_hosts.push_back(host);
+    }
+  }
+
+  // Keep the entries of the hosts that are still there, which are already sorted.
+  for (const auto& host : hosts) {
+    hosts_.insert(host.get());
+  }
+  ring_.reserve(hosts.size() * hashes_per_host_);
+  for (const RingEntry& entry : previous.ring_) {
+    if (hosts_.count(entry.host_.get()) != 0) {
+      ring_.push_back(entry);
     }
   }
 
-  ENVOY_LOG(info, "ring hash: min_ring_size={} hashes_per_host={}", min_ring_size, hashes_per_host);
-  ring_.reserve(hosts.size() * hashes_per_host);
+  if (!added_hosts.empty()) {
+    const size_t old_size = ring_.size();
+    addEntries(config, added_hosts);
+    std::sort(ring_.begin() + old_size, ring_.end());
+    std::inplace_merge(ring_.begin(), ring_.begin() + old_size, ring_.end());
+  }
+
+  ENVOY_LOG(debug, "ring hash: updated ring, added_hosts={} ring_size={}", added_hosts.size(),
+            ring_.size());
+}
+
+void RingHashLoadBalancer::Ring::filter(const Ring& ring, const std::vector<HostSharedPtr>& hosts) {
+  hosts_.clear();
+  for (const auto& host : hosts) {
+    hosts_.insert(host.get());
+  }
 
+  ring_.clear();
+  for (const RingEntry& entry : ring.ring_) {
+    if (hosts_.count(entry.host_.get()) != 0) {
+      ring_.push_back(entry);
+    }
+  }
+}
+
+void RingHashLoadBalancer::Ring::addEntries(
+    const Optional<envoy::api::v2::Cluster::RingHashLbConfig>& config,
+    const std::vector<HostSharedPtr>& hosts) {
   const bool use_std_hash =
       config.valid()
           ? PROTOBUF_GET_WRAPPED_OR_DEFAULT(config.value().deprecated_v1(), use_std_hash, true)
           : true;
   for (const auto& host : hosts) {
-    for (uint64_t i = 0; i < hashes_per_host; i++) {
+    hosts_.insert(host.get());
+    for (uint64_t i = 0; i < hashes_per_host_; i++) {
       const std::string hash_key(host->address()->asString() + "_" + std::to_string(i));
       const uint64_t hash =
           use_std_hash ? std::hash<std::string>()(hash_key) : HashUtil::xxHash64(hash_key);
@@ -128,20 +224,6 @@ void RingHashLoadBalancer::Ring::create(
       ring_.push_back({hash, host});
     }
   }
-
-  std::sort(ring_.begin(), ring_.end(), [](const RingEntry& lhs, const RingEntry& rhs) -> bool {
-    return lhs.hash_ < rhs.hash_;
-  });
-#ifndef NVLOG
-  for (auto entry : ring_) {
-    ENVOY_LOG(trace, "ring hash: host={} hash={}", entry.host_->address()->asString(), entry.hash_);
-  }
-#endif
-}
-
-void RingHashLoadBalancer::refresh() {
-  all_hosts_ring_.create(config_, host_set_.hosts());
-  healthy_hosts_ring_.create(config_, host_set_.healthyHosts());
 }
 
 } // namespace Upstream
@@ -1,12 +1,15 @@
 #pragma once
 
 #include <cstdint>
+#include <memory>
+#include <unordered_set>
 #include <vector>
 
 #include "envoy/runtime/runtime.h"
 #include "envoy/upstream/load_balancer.h"
 
 #include "common/common/logger.h"
+#include "common/upstream/thread_aware_lb_impl.h"
 
 namespace Envoy {
 namespace Upstream {
@@ -14,44 +17,61 @@ namespace Upstream {
 /**
  * A load balancer that implements consistent modulo hashing ("ketama"). Currently, zone aware
  * routing is not supported. A ring is kept for all hosts as well as a ring for healthy hosts.
- * Unless we are in panic mode, the healthy host ring is used.
+ * Unless we are in panic mode, the healthy host ring is used. The healthy host ring is the all
+ * hosts ring without the entries of unhealthy hosts, so health changes do not move the keys of
+ * other hosts and never rehash anything. The rings are built on the main thread and shared with
+ * workers, see ThreadAwareLoadBalancerBase, which can also spread hot shards over the following
+ * hosts of the ring with bounded loads.
  * In the future it would be nice to support:
  * 1) Weighting.
  * 2) Per-zone rings and optional zone aware routing (not all applications will want this).
- * 3) Max request fallback to support hot shards (not all applications will want this).
  */
-class RingHashLoadBalancer : public LoadBalancer, Logger::Loggable<Logger::Id::upstream> {
+class RingHashLoadBalancer : public ThreadAwareLoadBalancerBase,
+                             Logger::Loggable<Logger::Id::upstream> {
 public:
   RingHashLoadBalancer(PrioritySet& priority_set, ClusterStats& stats, Runtime::Loader& runtime,
                        Runtime::RandomGenerator& random,
                        const Optional<envoy::api::v2::Cluster::RingHashLbConfig>& config);
 
-  // Upstream::LoadBalancer
-  HostConstSharedPtr chooseHost(LoadBalancerContext* context) override;
-
 private:
   struct RingEntry {
+    bool operator<(const RingEntry& other) const { return hash_ < other.hash_; }
+
     uint64_t hash_;
     HostConstSharedPtr host_;
   };
 
-  struct Ring {
-    HostConstSharedPtr chooseHost(LoadBalancerContext* context, Runtime::RandomGenerator& random);
+  struct Ring : public HashingLoadBalancer {
+    // ThreadAwareLoadBalancerBase::HashingLoadBalancer
+    HostConstSharedPtr chooseHost(uint64_t hash) const override;
+    HostConstSharedPtr chooseHost(uint64_t hash, const HostPredicate& accept) const override;
+
+    // The index of the entry for the hash. The ring must not be empty.
+    size_t entryIndex(uint64_t hash) const;
+
     void create(const Optional<envoy::api::v2::Cluster::RingHashLbConfig>& config,
                 const std::vector<HostSharedPtr>& hosts);
+    // Builds the ring for hosts from the previous ring, only hashing the entries of added hosts,
+    // unless the number of entries per host changes.
+    void update(const Ring& previous,
+                const Optional<envoy::api::v2::Cluster::RingHashLbConfig>& config,
+                const std::vector<HostSharedPtr>& hosts);
+    void filter(const Ring& ring, const std::vector<HostSharedPtr>& hosts);
+    void addEntries(const Optional<envoy::api::v2::Cluster::RingHashLbConfig>& config,
+                    const std::vector<HostSharedPtr>& hosts);
 
     std::vector<RingEntry> ring_;
+    uint64_t hashes_per_host_{};
+    std::unordered_set<const Host*> hosts_;
   };
 
-  void refresh();
+  // ThreadAwareLoadBalancerBase
+  HashingLoadBalancerSharedPtr createAllHostsLoadBalancer(const HostSet& host_set) override;
+  HashingLoadBalancerSharedPtr createHealthyHostsLoadBalancer(const HostSet& host_set) override;
 
-  HostSet& host_set_;
-  ClusterStats& stats_;
-  Runtime::Loader& runtime_;
-  Runtime::RandomGenerator& random_;
   const Optional<envoy::api::v2::Cluster::RingHashLbConfig>& config_;
-  Ring all_hosts_ring_;
-  Ring healthy_hosts_ring_;
+  // The most recent all hosts ring, which the next one is built from.
+  std::shared_ptr<const Ring> all_hosts_ring_;
 };
 
 } // namespace Upstream
@@ -1,6 +1,7 @@
 #include "common/upstream/subset_lb.h"
 
-#include <unordered_set>
+#include <algorithm>
+#include <unordered_map>
 
 #include "envoy/runtime/runtime.h"
 
@@ -9,6 +10,7 @@
 #include "common/config/well_known_names.h"
 #include "common/protobuf/utility.h"
 #include "common/upstream/load_balancer_impl.h"
+#include "common/upstream/maglev_lb.h"
 #include "common/upstream/ring_hash_lb.h"
 
 #include "api/cds.pb.h"
@@ -77,6 +79,10 @@ HostConstSharedPtr SubsetLoadBalancer::tryChooseHostFromContext(LoadBalancerCont
     return nullptr;
   }
 
+  if (!entry->initialized()) {
+    entry->initLoadBalancer(*this, entry->predicate_);
+  }
+
   host_chosen = true;
   stats_.lb_subsets_selected_.inc();
   return entry->lb_->chooseHost(context);
@@ -148,12 +154,12 @@ void SubsetLoadBalancer::updateFallbackSubset(uint32_t priority,
 }
 
 // Iterates over the added and removed hosts, looking up an LbSubsetEntryPtr for each. For every
-// unique LbSubsetEntryPtr found, it invokes cb with the LbSubsetEntryPtr, a HostPredicate that
-// selects hosts in the subset, and a flag indicating whether any hosts are being added.
+// unique LbSubsetEntryPtr found, it invokes cb with the LbSubsetEntryPtr and a SubsetUpdate with a
+// HostPredicate that selects hosts in the subset and the number of hosts added and removed.
 void SubsetLoadBalancer::processSubsets(
     const std::vector<HostSharedPtr>& hosts_added, const std::vector<HostSharedPtr>& hosts_removed,
-    std::function<void(LbSubsetEntryPtr, HostPredicate, bool)> cb) {
-  std::unordered_set<LbSubsetEntryPtr> subsets_modified;
+    std::function<void(LbSubsetEntryPtr, const SubsetUpdate&)> cb) {
+  std::unordered_map<LbSubsetEntryPtr, SubsetUpdate> subsets_modified;
 
   std::pair<const std::vector<HostSharedPtr>&, bool> steps[] = {{hosts_added, true},
                                                                 {hosts_removed, false}};
@@ -169,20 +175,20 @@ void SubsetLoadBalancer::processSubsets(
         if (!kvs.empty()) {
           // The host has metadata for each key, find or create its subset.
           LbSubsetEntryPtr entry = findOrCreateSubset(subsets_, kvs, 0);
-          if (subsets_modified.find(entry) != subsets_modified.end()) {
-            // We've already invoked the callback for this entry.
-            continue;
+          SubsetUpdate& subset_update = subsets_modified[entry];
+          if (!subset_update.predicate_) {
+            subset_update.predicate_ =
+                std::bind(&SubsetLoadBalancer::hostMatches, this, kvs, std::placeholders::_1);
           }
-          subsets_modified.emplace(entry);
-
-          HostPredicate predicate =
-              std::bind(&SubsetLoadBalancer::hostMatches, this, kvs, std::placeholders::_1);
-
-          cb(entry, predicate, adding_hosts);
+          (adding_hosts ? subset_update.num_added_ : subset_update.num_removed_)++;
         }
       }
     }
   }
+
+  for (const auto& it : subsets_modified) {
+    cb(it.first, it.second);
+  }
 }
 
 // Given the addition and/or removal of hosts, update all subsets for this priority level, creating
@@ -192,27 +198,30 @@ void SubsetLoadBalancer::update(uint32_t priority, const std::vector<HostSharedP
   updateFallbackSubset(priority, hosts_added, hosts_removed);
 
   processSubsets(hosts_added, hosts_removed,
-                 [&](LbSubsetEntryPtr entry, HostPredicate predicate, bool adding_host) {
-                   if (entry->initialized()) {
-                     const bool active_before = entry->active();
-                     entry->priority_subset_->update(priority, hosts_added, hosts_removed,
-                                                     predicate);
-
-                     if (active_before && !entry->active()) {
-                       stats_.lb_subsets_active_.dec();
-                       stats_.lb_subsets_removed_.inc();
-                     } else if (!active_before && entry->active()) {
-                       stats_.lb_subsets_active_.inc();
-                       stats_.lb_subsets_created_.inc();
-                     }
-                   } else if (adding_host) {
-                     // Initialize new entry with hosts and update stats. (An uninitialized entry
-                     // with only removed hosts is a degenerate case and we leave the entry
-                     // uninitialized.)
-                     entry->initLoadBalancer(*this, predicate);
+                 [&](LbSubsetEntryPtr entry, const SubsetUpdate& subset_update) {
+                   const bool active_before = entry->active();
+                   if (!entry->predicate_) {
+                     entry->predicate_ = subset_update.predicate_;
+                   }
+                   // Removing hosts that were never added is ignored.
+                   entry->num_hosts_ += subset_update.num_added_;
+                   entry->num_hosts_ -= std::min(entry->num_hosts_, subset_update.num_removed_);
+
+                   if (active_before && !entry->active()) {
+                     entry->resetLoadBalancer();
+                     stats_.lb_subsets_active_.dec();
+                     stats_.lb_subsets_removed_.inc();
+                   } else if (!active_before && entry->active()) {
                      stats_.lb_subsets_active_.inc();
                      stats_.lb_subsets_created_.inc();
                    }
+
+                   // A subset's load balancer is only created when the subset is first picked
+                   // from, and then kept up to date.
+                   if (entry->initialized()) {
+                     entry->priority_subset_->update(priority, hosts_added, hosts_removed,
+                                                     entry->predicate_);
+                   }
                  });
 }
 
@@ -349,6 +358,11 @@ void SubsetLoadBalancer::LbSubsetEntry::initLoadBalancer(const SubsetLoadBalance
                                        subset_lb.random_, subset_lb.lb_ring_hash_config_));
     break;
 
+  case LoadBalancerType::Maglev:
+    lb_.reset(new MaglevLoadBalancer(*priority_subset_, subset_lb.stats_, subset_lb.runtime_,
+                                     subset_lb.random_));
+    break;
+
   case LoadBalancerType::OriginalDst:
     NOT_REACHED;
   }
@@ -91,17 +91,34 @@ private:
     LbSubsetEntry() {}
 
     bool initialized() const { return lb_ != nullptr && priority_subset_ != nullptr; }
-    bool active() const { return initialized() && !priority_subset_->empty(); }
+    bool active() const { return num_hosts_ > 0; }
 
     void initLoadBalancer(const SubsetLoadBalancer& subset_lb, HostPredicate predicate);
+    void resetLoadBalancer() {
+      lb_.reset();
+      priority_subset_.reset();
+    }
 
     LbSubsetMap children_;
 
-    // Only initialized if a match exists at this level.
+    // Selects the hosts of this subset. Only set if a match exists at this level.
+    HostPredicate predicate_;
+    // The number of hosts in this subset, over all priorities.
+    uint64_t num_hosts_{};
+
+    // Only initialized when the subset is first picked from, since most workers only ever use a
+    // few of the subsets, and released when the subset has no hosts left.
     PrioritySubsetImplPtr priority_subset_;
     LoadBalancerPtr lb_;
   };
 
+  // The hosts added to and removed from one subset by an update.
+  struct SubsetUpdate {
+    HostPredicate predicate_;
+    uint64_t num_added_{};
+    uint64_t num_removed_{};
+  };
+
   // Called by HostSet::MemberUpdateCb
   void update(uint32_t priority, const std::vector<HostSharedPtr>& hosts_added,
               const std::vector<HostSharedPtr>& hosts_removed);
@@ -110,7 +127,7 @@ private:
                             const std::vector<HostSharedPtr>& hosts_removed);
   void processSubsets(const std::vector<HostSharedPtr>& hosts_added,
                       const std::vector<HostSharedPtr>& hosts_removed,
-                      std::function<void(LbSubsetEntryPtr, HostPredicate, bool)> cb);
+                      std::function<void(LbSubsetEntryPtr, const SubsetUpdate&)> cb);
 
   HostConstSharedPtr tryChooseHostFromContext(LoadBalancerContext* context, bool& host_chosen);
 
@@ -0,0 +1,91 @@
+#include "common/upstream/thread_aware_lb_impl.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "common/common/assert.h"
+#include "common/upstream/load_balancer_impl.h"
+
+namespace Envoy {
+namespace Upstream {
+
+ThreadAwareLoadBalancerBase::ThreadAwareLoadBalancerBase(PrioritySet& priority_set,
+                                                         ClusterStats& stats,
+                                                         Runtime::Loader& runtime,
+                                                         Runtime::RandomGenerator& random)
+    : host_set_(*priority_set.hostSetsPerPriority()[0]), stats_(stats), runtime_(runtime),
+      random_(random), factory_(new Factory(stats, runtime, random)) {
+  priority_set.addMemberUpdateCb([this](uint32_t priority, const std::vector<HostSharedPtr>&,
+                                        const std::vector<HostSharedPtr>&) -> void {
+    // priority!=0 will be blocked by EDS validation.
+    ASSERT(priority == 0); // TODO(alyssawilk) make consistent hashing LBs priority-aware.
+    UNREFERENCED_PARAMETER(priority);
+    refresh();
+  });
+}
+
+HostConstSharedPtr ThreadAwareLoadBalancerBase::chooseHost(LoadBalancerContext* context) {
+  return snapshot_->chooseHost(context, stats_, runtime_, random_);
+}
+
+void ThreadAwareLoadBalancerBase::refresh() {
+  std::shared_ptr<Snapshot> snapshot(new Snapshot());
+  snapshot->all_hosts_ = createAllHostsLoadBalancer(host_set_);
+  snapshot->healthy_hosts_ = createHealthyHostsLoadBalancer(host_set_);
+  snapshot->num_hosts_ = host_set_.hosts().size();
+  snapshot->num_healthy_hosts_ = host_set_.healthyHosts().size();
+  snapshot_ = snapshot;
+
+  std::unique_lock<std::mutex> lock(factory_->mutex_);
+  factory_->snapshot_ = snapshot_;
+}
+
+HostConstSharedPtr
+ThreadAwareLoadBalancerBase::Snapshot::chooseHost(LoadBalancerContext* context,
+                                                  ClusterStats& stats, Runtime::Loader& runtime,
+                                                  Runtime::RandomGenerator& random) const {
+  const HashingLoadBalancer* lb = healthy_hosts_.get();
+  uint64_t num_hosts = num_healthy_hosts_;
+  if (LoadBalancerUtility::isGlobalPanic(num_hosts_, num_healthy_hosts_, runtime)) {
+    stats.lb_healthy_panic_.inc();
+    lb = all_hosts_.get();
+    num_hosts = num_hosts_;
+  }
+
+  if (num_hosts == 0) {
+    return nullptr;
+  }
+
+  // If there is no hash in the context, just choose a random value (this effectively becomes
+  // the random LB but it won't crash if someone configures it this way).
+  // computeHashKey() may be computed on demand, so get it only once.
+  Optional<uint64_t> hash;
+  if (context) {
+    hash = context->computeHashKey();
+  }
+  const uint64_t h = hash.valid() ? hash.value() : random.random();
+
+  const uint64_t balance_factor =
+      runtime.snapshot().getInteger("upstream.consistent_hash_balance_factor", 0);
+  if (balance_factor <= 100) {
+    return lb->chooseHost(h);
+  }
+
+  // Each host may take up to balance_factor percent of its share of the cluster's active requests,
+  // counting the one being routed, rounded up so that there is always a host below the bound.
+  const uint64_t active = stats.upstream_rq_active_.value() + 1;
+  const uint64_t max_active = (active * balance_factor + 100 * num_hosts - 1) / (100 * num_hosts);
+  return lb->chooseHost(h, [max_active](const Host& host) -> bool {
+    return host.stats().rq_active_.value() < max_active;
+  });
+}
+
+LoadBalancerPtr ThreadAwareLoadBalancerBase::Factory::create() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  ASSERT(snapshot_ != nullptr);
+  return LoadBalancerPtr{new WorkerLoadBalancer(snapshot_, stats_, runtime_, random_)};
+}
+
+} // namespace Upstream
+} // namespace Envoy
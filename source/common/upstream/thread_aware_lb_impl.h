@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+#include "envoy/runtime/runtime.h"
+#include "envoy/upstream/load_balancer.h"
+#include "envoy/upstream/upstream.h"
+
+namespace Envoy {
+namespace Upstream {
+
+/**
+ * Base for consistent hashing load balancers, whose lookup structures are built on the main
+ * thread and shared read only with all workers. A lookup structure is kept for all hosts as well
+ * as for healthy hosts. Unless we are in panic mode, the healthy host one is used. Only priority 0
+ * is supported.
+ *
+ * The load balancer can also be used directly on the thread that owns the priority set, which is
+ * how the subset load balancer uses it.
+ *
+ * If the upstream.consistent_hash_balance_factor runtime key is set above 100, hashing uses
+ * bounded loads (https://arxiv.org/abs/1608.01350): a host whose active requests reach that
+ * percentage of the cluster's average per host is passed over for the next one in the lookup
+ * structure, so a hot key spills over to a few neighbouring hosts instead of overloading one.
+ */
+class ThreadAwareLoadBalancerBase : public LoadBalancer, public ThreadAwareLoadBalancer {
+public:
+  // Upstream::LoadBalancer
+  HostConstSharedPtr chooseHost(LoadBalancerContext* context) override;
+
+  // Upstream::ThreadAwareLoadBalancer
+  LoadBalancerFactorySharedPtr factory() override { return factory_; }
+
+protected:
+  /**
+   * Host lookup structure built from one host list. It is never changed once built, so it can be
+   * used from any thread.
+   */
+  class HashingLoadBalancer {
+  public:
+    typedef std::function<bool(const Host& host)> HostPredicate;
+
+    virtual ~HashingLoadBalancer() {}
+
+    /**
+     * @return HostConstSharedPtr the host for the hash, or nullptr if there are no hosts.
+     */
+    virtual HostConstSharedPtr chooseHost(uint64_t hash) const PURE;
+
+    /**
+     * @param hash supplies the hash.
+     * @param accept supplies whether a host may be chosen.
+     * @return HostConstSharedPtr the first accepted host, starting from the host for the hash and
+     *         moving on in the order of the lookup structure. If no host is accepted, the host for
+     *         the hash. nullptr if there are no hosts.
+     */
+    virtual HostConstSharedPtr chooseHost(uint64_t hash, const HostPredicate& accept) const PURE;
+  };
+
+  typedef std::shared_ptr<const HashingLoadBalancer> HashingLoadBalancerSharedPtr;
+
+  ThreadAwareLoadBalancerBase(PrioritySet& priority_set, ClusterStats& stats,
+                              Runtime::Loader& runtime, Runtime::RandomGenerator& random);
+
+  /**
+   * Build the lookup structures for the current hosts, and publish them to workers. Derived
+   * classes call this at the end of their constructor.
+   */
+  void refresh();
+
+  /**
+   * Build the lookup structure for all hosts. Called on every membership update.
+   */
+  virtual HashingLoadBalancerSharedPtr createAllHostsLoadBalancer(const HostSet& host_set) PURE;
+
+  /**
+   * Build the lookup structure for healthy hosts. Called on every membership update, right after
+   * createAllHostsLoadBalancer().
+   */
+  virtual HashingLoadBalancerSharedPtr createHealthyHostsLoadBalancer(const HostSet& host_set) PURE;
+
+private:
+  // The lookup structures for one membership update.
+  struct Snapshot {
+    HostConstSharedPtr chooseHost(LoadBalancerContext* context, ClusterStats& stats,
+                                  Runtime::Loader& runtime, Runtime::RandomGenerator& random) const;
+
+    HashingLoadBalancerSharedPtr all_hosts_;
+    HashingLoadBalancerSharedPtr healthy_hosts_;
+    uint64_t num_hosts_;
+    uint64_t num_healthy_hosts_;
+  };
+
+  typedef std::shared_ptr<const Snapshot> SnapshotConstSharedPtr;
+
+  struct WorkerLoadBalancer : public LoadBalancer {
+    WorkerLoadBalancer(SnapshotConstSharedPtr snapshot, ClusterStats& stats,
+                       Runtime::Loader& runtime, Runtime::RandomGenerator& random)
+        : snapshot_(std::move(snapshot)), stats_(stats), runtime_(runtime), random_(random) {}
+
+    // Upstream::LoadBalancer
+    HostConstSharedPtr chooseHost(LoadBalancerContext* context) override {
+      return snapshot_->chooseHost(context, stats_, runtime_, random_);
+    }
+
+    const SnapshotConstSharedPtr snapshot_;
+    ClusterStats& stats_;
+    Runtime::Loader& runtime_;
+    Runtime::RandomGenerator& random_;
+  };
+
+  struct Factory : public LoadBalancerFactory {
+    Factory(ClusterStats& stats, Runtime::Loader& runtime, Runtime::RandomGenerator& random)
+        : stats_(stats), runtime_(runtime), random_(random) {}
+
+    // Upstream::LoadBalancerFactory
+    LoadBalancerPtr create() override;
+
+    ClusterStats& stats_;
+    Runtime::Loader& runtime_;
+    Runtime::RandomGenerator& random_;
+    // Swapped by the main thread, and read by workers when they create load balancers.
+    std::mutex mutex_;
+    SnapshotConstSharedPtr snapshot_;
+  };
+
+  HostSet& host_set_;
+  ClusterStats& stats_;
+  Runtime::Loader& runtime_;
+  Runtime::RandomGenerator& random_;
+  SnapshotConstSharedPtr snapshot_;
+  std::shared_ptr<Factory> factory_;
+};
+
+} // namespace Upstream
+} // namespace Envoy
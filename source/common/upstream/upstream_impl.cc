@@ -5,6 +5,7 @@
 #include <list>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -48,8 +49,38 @@ getSourceAddress(const envoy::api::v2::Cluster& cluster,
   // If there's no source address in the cluster config, use any default from the bootstrap proto.
   return source_address;
 }
+
+/**
+ * Owns the stats of a LocalityLoadStats. Every worker writes them through the hosts of the
+ * locality, so they are sharded by thread like the host stats.
+ */
+struct LocalityLoadStatsHolder {
+  LocalityLoadStatsHolder()
+      : stats_{ALL_LOCALITY_LOAD_STATS(POOL_COUNTER(store_), POOL_GAUGE(store_))} {}
+
+  Stats::ShardedStatsStore store_{
+      0 ALL_LOCALITY_LOAD_STATS(GENERATE_STAT_COUNT, GENERATE_STAT_COUNT)};
+  LocalityLoadStats stats_;
+};
 } // namespace
 
+std::shared_ptr<const envoy::api::v2::Locality>
+HostDescriptionImpl::internLocality(const envoy::api::v2::Locality& locality) {
+  // Hosts are also created on the workers by original destination clusters. Never freed, and an
+  // entry is kept per locality ever seen, which are few.
+  static std::mutex* lock = new std::mutex();
+  static std::map<Locality, std::weak_ptr<const envoy::api::v2::Locality>>* localities =
+      new std::map<Locality, std::weak_ptr<const envoy::api::v2::Locality>>();
+  std::unique_lock<std::mutex> guard(*lock);
+  std::weak_ptr<const envoy::api::v2::Locality>& entry = (*localities)[Locality(locality)];
+  std::shared_ptr<const envoy::api::v2::Locality> interned = entry.lock();
+  if (interned == nullptr) {
+    interned = std::make_shared<const envoy::api::v2::Locality>(locality);
+    entry = interned;
+  }
+  return interned;
+}
+
 Host::CreateConnectionData HostImpl::createConnection(Event::Dispatcher& dispatcher) const {
   return {createConnection(dispatcher, *cluster_, address_), shared_from_this()};
 }
@@ -90,6 +121,22 @@ ClusterLoadReportStats ClusterInfoImpl::generateLoadReportStats(Stats::Scope& sc
   return {ALL_CLUSTER_LOAD_REPORT_STATS(POOL_COUNTER(scope))};
 }
 
+LocalityLoadStatsSharedPtr
+ClusterInfoImpl::localityLoadStats(const envoy::api::v2::Locality& locality,
+                                   uint32_t priority) const {
+  std::unique_lock<std::mutex> lock(locality_load_stats_lock_);
+  std::weak_ptr<LocalityLoadStats>& entry =
+      locality_load_stats_[std::make_pair(Locality(locality), priority)];
+  LocalityLoadStatsSharedPtr stats = entry.lock();
+  if (stats == nullptr) {
+    auto holder = std::make_shared<LocalityLoadStatsHolder>();
+    // Shares ownership of the holder, which keeps the stats alive.
+    stats = LocalityLoadStatsSharedPtr(holder, &holder->stats_);
+    entry = stats;
+  }
+  return stats;
+}
+
 ClusterInfoImpl::ClusterInfoImpl(const envoy::api::v2::Cluster& config,
                                  const Network::Address::InstanceConstSharedPtr source_address,
                                  Runtime::Loader& runtime, Stats::Store& stats,
@@ -102,12 +149,21 @@ ClusterInfoImpl::ClusterInfoImpl(const envoy::api::v2::Cluster& config,
       per_connection_buffer_limit_bytes_(
           PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, per_connection_buffer_limit_bytes, 1024 * 1024)),
       stats_scope_(stats.createScope(fmt::format("cluster.{}.", name_))),
-      stats_(generateStats(*stats_scope_)),
+      lazy_stats_scope_(runtime.snapshot().getInteger("upstream.lazy_stats", 0) != 0
+                            ? new Stats::LazyScopeImpl(*stats_scope_,
+                                                       fmt::format("cluster.{}.", name_))
+                            : nullptr),
+      stats_(generateStats(lazy_stats_scope_ ? *lazy_stats_scope_ : *stats_scope_)),
+      code_stats_(*stats_scope_),
       load_report_stats_(generateLoadReportStats(load_report_stats_store_)),
       features_(parseFeatures(config)),
-      http2_settings_(Http::Utility::parseHttp2Settings(config.http2_protocol_options())),
-      resource_managers_(config, runtime, name_),
+      http2_settings_(Http::Utility::parseHttp2Settings(
+          config.http2_protocol_options(), runtime,
+          fmt::format("upstream.http2_window_auto_tuning.{}", name_))),
+      resource_managers_(config, runtime, name_, stats_),
+      idle_timeout_runtime_key_(fmt::format("upstream.idle_timeout_ms.{}", name_)),
       maintenance_mode_runtime_key_(fmt::format("upstream.maintenance_mode.{}", name_)),
+      preconnect_percent_runtime_key_(fmt::format("upstream.preconnect_percent.{}", name_)),
       source_address_(getSourceAddress(config, source_address)),
       lb_ring_hash_config_(envoy::api::v2::Cluster::RingHashLbConfig(config.ring_hash_lb_config())),
       added_via_api_(added_via_api),
@@ -129,7 +185,11 @@ ClusterInfoImpl::ClusterInfoImpl(const envoy::api::v2::Cluster& config,
     lb_type_ = LoadBalancerType::Random;
     break;
   case envoy::api::v2::Cluster::RING_HASH:
-    lb_type_ = LoadBalancerType::RingHash;
+    // Maglev is an alternative consistent hashing policy that hashes the same keys, so it is
+    // selected per ring hash cluster.
+    lb_type_ = runtime.snapshot().getInteger(fmt::format("upstream.maglev.{}", name_), 0) != 0
+                   ? LoadBalancerType::Maglev
+                   : LoadBalancerType::RingHash;
     break;
   case envoy::api::v2::Cluster::ORIGINAL_DST_LB:
     if (config.type() != envoy::api::v2::Cluster::ORIGINAL_DST) {
@@ -281,10 +341,25 @@ ClusterImplBase::createHealthyHostLists(const std::vector<std::vector<HostShared
   return healthy_list;
 }
 
+void ClusterInfoImpl::forEachLazyCounter(
+    const std::function<void(Stats::Counter&)>& cb) const {
+  if (lazy_stats_scope_) {
+    lazy_stats_scope_->forEachLazyCounter(cb);
+  }
+}
+
+std::chrono::milliseconds ClusterInfoImpl::idleTimeout() const {
+  return std::chrono::milliseconds(runtime_.snapshot().getInteger(idle_timeout_runtime_key_, 0));
+}
+
 bool ClusterInfoImpl::maintenanceMode() const {
   return runtime_.snapshot().featureEnabled(maintenance_mode_runtime_key_, 0);
 }
 
+uint64_t ClusterInfoImpl::preconnectPercent() const {
+  return runtime_.snapshot().getInteger(preconnect_percent_runtime_key_, 0);
+}
+
 uint64_t ClusterInfoImpl::parseFeatures(const envoy::api::v2::Cluster& config) {
   uint64_t features = 0;
   if (config.has_http2_protocol_options()) {
@@ -392,17 +467,19 @@ void ClusterImplBase::reloadHealthyHosts() {
 
 ClusterInfoImpl::ResourceManagers::ResourceManagers(const envoy::api::v2::Cluster& config,
                                                     Runtime::Loader& runtime,
-                                                    const std::string& cluster_name) {
+                                                    const std::string& cluster_name,
+                                                    ClusterStats& stats) {
   managers_[enumToInt(ResourcePriority::Default)] =
-      load(config, runtime, cluster_name, envoy::api::v2::RoutingPriority::DEFAULT);
+      load(config, runtime, cluster_name, envoy::api::v2::RoutingPriority::DEFAULT, stats);
   managers_[enumToInt(ResourcePriority::High)] =
-      load(config, runtime, cluster_name, envoy::api::v2::RoutingPriority::HIGH);
+      load(config, runtime, cluster_name, envoy::api::v2::RoutingPriority::HIGH, stats);
 }
 
 ResourceManagerImplPtr
 ClusterInfoImpl::ResourceManagers::load(const envoy::api::v2::Cluster& config,
                                         Runtime::Loader& runtime, const std::string& cluster_name,
-                                        const envoy::api::v2::RoutingPriority& priority) {
+                                        const envoy::api::v2::RoutingPriority& priority,
+                                        ClusterStats& stats) {
   uint64_t max_connections = 1024;
   uint64_t max_pending_requests = 1024;
   uint64_t max_requests = 1024;
@@ -436,8 +513,12 @@ ClusterInfoImpl::ResourceManagers::load(const envoy::api::v2::Cluster& config,
     max_requests = PROTOBUF_GET_WRAPPED_OR_DEFAULT(*it, max_requests, max_requests);
     max_retries = PROTOBUF_GET_WRAPPED_OR_DEFAULT(*it, max_retries, max_retries);
   }
+  // Retry budgets are a percentage of the requests of the whole cluster, over all priorities.
   return ResourceManagerImplPtr{new ResourceManagerImpl(
-      runtime, runtime_prefix, max_connections, max_pending_requests, max_requests, max_retries)};
+      runtime, runtime_prefix, max_connections, max_pending_requests, max_requests, max_retries,
+      [&stats]() -> uint64_t {
+        return stats.upstream_rq_active_.value() + stats.upstream_rq_pending_active_.value();
+      })};
 }
 
 StaticClusterImpl::StaticClusterImpl(const envoy::api::v2::Cluster& cluster,
@@ -483,41 +564,39 @@ bool BaseDynamicClusterImpl::updateDynamicHostList(const std::vector<HostSharedP
   uint64_t max_host_weight = 1;
 
   // Go through and see if the list we have is different from what we just got. If it is, we
-  // make a new host list and raise a change notification. This uses an N^2 search given that
-  // this does not happen very often and the list sizes should be small. We also check for
-  // duplicates here. It's possible for DNS to return the same address multiple times, and a bad
-  // SDS implementation could do the same thing.
+  // make a new host list and raise a change notification. Current hosts are indexed by address,
+  // so this is linear in the size of both lists, which matters for large EDS clusters. We also
+  // check for duplicates here. It's possible for DNS to return the same address multiple times,
+  // and a bad SDS implementation could do the same thing.
+  std::unordered_map<std::string, size_t> current_host_indexes;
+  current_host_indexes.reserve(current_hosts.size());
+  for (size_t i = 0; i < current_hosts.size(); i++) {
+    current_host_indexes.emplace(current_hosts[i]->address()->asString(), i);
+  }
+
   std::unordered_set<std::string> host_addresses;
+  std::vector<bool> current_host_kept(current_hosts.size());
   std::vector<HostSharedPtr> final_hosts;
+  final_hosts.reserve(new_hosts.size());
   for (const HostSharedPtr& host : new_hosts) {
-    if (host_addresses.count(host->address()->asString())) {
+    const std::string& address = host->address()->asString();
+    if (!host_addresses.emplace(address).second) {
       continue;
     }
-    host_addresses.emplace(host->address()->asString());
 
-    bool found = false;
-    for (auto i = current_hosts.begin(); i != current_hosts.end();) {
-      // If we find a host matched based on address, we keep it. However we do change weight inline
-      // so do that here.
-      if (*(*i)->address() == *host->address()) {
-        if (host->weight() > max_host_weight) {
-          max_host_weight = host->weight();
-        }
-
-        (*i)->weight(host->weight());
-        final_hosts.push_back(*i);
-        i = current_hosts.erase(i);
-        found = true;
-      } else {
-        i++;
-      }
+    if (host->weight() > max_host_weight) {
+      max_host_weight = host->weight();
     }
 
-    if (!found) {
-      if (host->weight() > max_host_weight) {
-        max_host_weight = host->weight();
-      }
-
+    auto current_host = current_host_indexes.find(address);
+    if (current_host != current_host_indexes.end()) {
+      // If we find a host matched based on address, we keep it. However we do change weight inline
+      // so do that here.
+      const HostSharedPtr& existing_host = current_hosts[current_host->second];
+      existing_host->weight(host->weight());
+      final_hosts.push_back(existing_host);
+      current_host_kept[current_host->second] = true;
+    } else {
       final_hosts.push_back(host);
       hosts_added.push_back(host);
 
@@ -528,20 +607,34 @@ bool BaseDynamicClusterImpl::updateDynamicHostList(const std::vector<HostSharedP
     }
   }
 
+  // Leave only the hosts that are gone from the new list in current_hosts.
+  if (final_hosts.size() != current_hosts.size() || !hosts_added.empty()) {
+    std::vector<HostSharedPtr> remaining_hosts;
+    for (size_t i = 0; i < current_hosts.size(); i++) {
+      if (!current_host_kept[i]) {
+        remaining_hosts.push_back(std::move(current_hosts[i]));
+      }
+    }
+    current_hosts = std::move(remaining_hosts);
+  } else {
+    current_hosts.clear();
+  }
+
   // If there are removed hosts, check to see if we should only delete if unhealthy.
   if (!current_hosts.empty() && depend_on_hc) {
-    for (auto i = current_hosts.begin(); i != current_hosts.end();) {
-      if (!(*i)->healthFlagGet(Host::HealthFlag::FAILED_ACTIVE_HC)) {
-        if ((*i)->weight() > max_host_weight) {
-          max_host_weight = (*i)->weight();
+    std::vector<HostSharedPtr> unhealthy_hosts;
+    for (HostSharedPtr& host : current_hosts) {
+      if (!host->healthFlagGet(Host::HealthFlag::FAILED_ACTIVE_HC)) {
+        if (host->weight() > max_host_weight) {
+          max_host_weight = host->weight();
         }
 
-        final_hosts.push_back(*i);
-        i = current_hosts.erase(i);
+        final_hosts.push_back(std::move(host));
       } else {
-        i++;
+        unhealthy_hosts.push_back(std::move(host));
       }
     }
+    current_hosts = std::move(unhealthy_hosts);
   }
 
   info_->stats().max_host_weight_.set(max_host_weight);
@@ -551,8 +644,7 @@ bool BaseDynamicClusterImpl::updateDynamicHostList(const std::vector<HostSharedP
     current_hosts = std::move(final_hosts);
     return true;
   } else {
-    // During the search we moved all of the hosts from hosts_ into final_hosts so just
-    // move them back.
+    // No hosts were added or removed, so just take the new order.
     current_hosts = std::move(final_hosts);
     return false;
   }
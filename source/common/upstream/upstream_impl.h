@@ -6,7 +6,9 @@
 #include <cstdint>
 #include <functional>
 #include <list>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <utility>
 #include <vector>
@@ -27,7 +29,12 @@
 #include "common/common/logger.h"
 #include "common/config/metadata.h"
 #include "common/config/well_known_names.h"
+#include "common/http/codes.h"
+#include "common/memory/accounting.h"
+#include "common/stats/lazy_scope_impl.h"
+#include "common/stats/sharded_stats_impl.h"
 #include "common/stats/stats_impl.h"
+#include "common/upstream/latency_estimator_impl.h"
 #include "common/upstream/load_balancer_impl.h"
 #include "common/upstream/outlier_detection_impl.h"
 #include "common/upstream/resource_manager_impl.h"
@@ -69,13 +76,19 @@ public:
   HostDescriptionImpl(ClusterInfoConstSharedPtr cluster, const std::string& hostname,
                       Network::Address::InstanceConstSharedPtr dest_address,
                       const envoy::api::v2::Metadata& metadata,
-                      const envoy::api::v2::Locality& locality)
+                      const envoy::api::v2::Locality& locality, uint32_t priority = 0)
       : cluster_(cluster), hostname_(hostname), address_(dest_address),
         canary_(Config::Metadata::metadataValue(metadata, Config::MetadataFilters::get().ENVOY_LB,
                                                 Config::MetadataEnvoyLbKeys::get().CANARY)
                     .bool_value()),
-        metadata_(metadata), locality_(locality), stats_{ALL_HOST_STATS(POOL_COUNTER(stats_store_),
-                                                                        POOL_GAUGE(stats_store_))} {
+        metadata_(metadata), locality_(internLocality(locality)),
+        stats_{ALL_HOST_STATS(POOL_COUNTER(stats_store_), POOL_GAUGE(stats_store_))},
+        locality_load_stats_(cluster_->localityLoadStats(*locality_, priority)) {
+    if (locality_load_stats_ != nullptr) {
+      stats_store_.rollUp(stats_.rq_success_, locality_load_stats_->rq_success_);
+      stats_store_.rollUp(stats_.rq_error_, locality_load_stats_->rq_error_);
+      stats_store_.rollUp(stats_.rq_active_, locality_load_stats_->rq_active_);
+    }
   }
 
   // Upstream::HostDescription
@@ -103,17 +116,28 @@ public:
   const HostStats& stats() const override { return stats_; }
   const std::string& hostname() const override { return hostname_; }
   Network::Address::InstanceConstSharedPtr address() const override { return address_; }
-  const envoy::api::v2::Locality& locality() const override { return locality_; }
+  const envoy::api::v2::Locality& locality() const override { return *locality_; }
+  LocalityLoadStats* localityLoadStats() const override { return locality_load_stats_.get(); }
 
 protected:
+  /**
+   * @return a shared copy of a locality. Hosts of the same locality, which are usually many, share
+   *         one copy.
+   */
+  static std::shared_ptr<const envoy::api::v2::Locality>
+  internLocality(const envoy::api::v2::Locality& locality);
+
   ClusterInfoConstSharedPtr cluster_;
   const std::string hostname_;
   Network::Address::InstanceConstSharedPtr address_;
   const bool canary_;
   const envoy::api::v2::Metadata metadata_;
-  const envoy::api::v2::Locality locality_;
-  Stats::IsolatedStoreImpl stats_store_;
+  const std::shared_ptr<const envoy::api::v2::Locality> locality_;
+  // Every worker writes the stats of the hosts it sends to, so they are sharded by thread.
+  Stats::ShardedStatsStore stats_store_{
+      0 ALL_HOST_STATS(GENERATE_STAT_COUNT, GENERATE_STAT_COUNT)};
   HostStats stats_;
+  const LocalityLoadStatsSharedPtr locality_load_stats_;
   Outlier::DetectorHostMonitorPtr outlier_detector_;
   HealthCheckHostMonitorPtr health_checker_;
 };
@@ -128,15 +152,20 @@ public:
   HostImpl(ClusterInfoConstSharedPtr cluster, const std::string& hostname,
            Network::Address::InstanceConstSharedPtr address,
            const envoy::api::v2::Metadata& metadata, uint32_t initial_weight,
-           const envoy::api::v2::Locality& locality)
-      : HostDescriptionImpl(cluster, hostname, address, metadata, locality), used_(true) {
+           const envoy::api::v2::Locality& locality, uint32_t priority = 0)
+      : HostDescriptionImpl(cluster, hostname, address, metadata, locality, priority),
+        used_(true), accounted_(Memory::Category::Hosts, sizeof(HostImpl)) {
     weight(initial_weight);
   }
 
   // Upstream::Host
-  std::list<Stats::CounterSharedPtr> counters() const override { return stats_store_.counters(); }
+  std::list<Stats::CounterSharedPtr> counters() const override {
+    return stats_store_.counters(shared_from_this());
+  }
   CreateConnectionData createConnection(Event::Dispatcher& dispatcher) const override;
-  std::list<Stats::GaugeSharedPtr> gauges() const override { return stats_store_.gauges(); }
+  std::list<Stats::GaugeSharedPtr> gauges() const override {
+    return stats_store_.gauges(shared_from_this());
+  }
   void healthFlagClear(HealthFlag flag) override { health_flags_ &= ~enumToInt(flag); }
   bool healthFlagGet(HealthFlag flag) const override { return health_flags_ & enumToInt(flag); }
   void healthFlagSet(HealthFlag flag) override { health_flags_ |= enumToInt(flag); }
@@ -161,6 +190,7 @@ private:
   std::atomic<uint64_t> health_flags_{};
   std::atomic<uint32_t> weight_;
   std::atomic<bool> used_;
+  const Memory::AccountedBytes accounted_;
 };
 
 typedef std::shared_ptr<std::vector<HostSharedPtr>> HostVectorSharedPtr;
@@ -288,6 +318,7 @@ public:
   // Upstream::ClusterInfo
   bool addedViaApi() const override { return added_via_api_; }
   std::chrono::milliseconds connectTimeout() const override { return connect_timeout_; }
+  std::chrono::milliseconds idleTimeout() const override;
   uint32_t perConnectionBufferLimitBytes() const override {
     return per_connection_buffer_limit_bytes_;
   }
@@ -300,23 +331,30 @@ public:
   bool maintenanceMode() const override;
   uint64_t maxRequestsPerConnection() const override { return max_requests_per_connection_; }
   const std::string& name() const override { return name_; }
+  uint64_t preconnectPercent() const override;
   ResourceManager& resourceManager(ResourcePriority priority) const override;
   Ssl::ClientContext* sslContext() const override { return ssl_ctx_.get(); }
   ClusterStats& stats() const override { return stats_; }
   Stats::Scope& statsScope() const override { return *stats_scope_; }
+  void forEachLazyCounter(const std::function<void(Stats::Counter&)>& cb) const override;
   ClusterLoadReportStats& loadReportStats() const override { return load_report_stats_; }
+  Http::CodeStats& codeStats() const override { return code_stats_; }
+  LocalityLoadStatsSharedPtr localityLoadStats(const envoy::api::v2::Locality& locality,
+                                               uint32_t priority) const override;
   const Network::Address::InstanceConstSharedPtr& sourceAddress() const override {
     return source_address_;
   };
   const LoadBalancerSubsetInfo& lbSubsetInfo() const override { return lb_subset_; }
+  LatencyEstimator& latencyEstimator() const override { return latency_estimator_; }
 
 private:
   struct ResourceManagers {
     ResourceManagers(const envoy::api::v2::Cluster& config, Runtime::Loader& runtime,
-                     const std::string& cluster_name);
+                     const std::string& cluster_name, ClusterStats& stats);
     ResourceManagerImplPtr load(const envoy::api::v2::Cluster& config, Runtime::Loader& runtime,
                                 const std::string& cluster_name,
-                                const envoy::api::v2::RoutingPriority& priority);
+                                const envoy::api::v2::RoutingPriority& priority,
+                                ClusterStats& stats);
 
     typedef std::array<ResourceManagerImplPtr, NumResourcePriorities> Managers;
 
@@ -331,19 +369,30 @@ private:
   const std::chrono::milliseconds connect_timeout_;
   const uint32_t per_connection_buffer_limit_bytes_;
   Stats::ScopePtr stats_scope_;
+  // Set if the cluster's counters are only created in stats_scope_ when first written.
+  std::unique_ptr<Stats::LazyScopeImpl> lazy_stats_scope_;
   mutable ClusterStats stats_;
+  mutable Http::CodeStatsImpl code_stats_;
   Stats::IsolatedStoreImpl load_report_stats_store_;
   mutable ClusterLoadReportStats load_report_stats_;
+  // Original destination clusters create hosts on the workers, so lookups are locked. Entries of
+  // localities that no longer have hosts are reused if the locality comes back.
+  mutable std::mutex locality_load_stats_lock_;
+  mutable std::map<std::pair<Locality, uint32_t>, std::weak_ptr<LocalityLoadStats>>
+      locality_load_stats_;
   Ssl::ClientContextPtr ssl_ctx_;
   const uint64_t features_;
   const Http::Http2Settings http2_settings_;
   mutable ResourceManagers resource_managers_;
+  const std::string idle_timeout_runtime_key_;
   const std::string maintenance_mode_runtime_key_;
+  const std::string preconnect_percent_runtime_key_;
   const Network::Address::InstanceConstSharedPtr source_address_;
   LoadBalancerType lb_type_;
   Optional<envoy::api::v2::Cluster::RingHashLbConfig> lb_ring_hash_config_;
   const bool added_via_api_;
   LoadBalancerSubsetInfoImpl lb_subset_;
+  mutable LatencyEstimatorImpl latency_estimator_;
 };
 
 /**
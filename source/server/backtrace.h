@@ -1,5 +1,8 @@
 #pragma once
 
+#include <cstdint>
+#include <vector>
+
 #include <backward.hpp>
 
 #include "common/common/logger.h"
@@ -97,11 +100,49 @@ public:
     ENVOY_LOG(critical, "end backtrace thread {}", stack_trace_.thread_id());
   }
 
+  /**
+   * Log a stack that was captured elsewhere, such as by ThreadStackCapture from another thread,
+   * in the same format as logTrace().
+   * @param thread_id supplies the ID of the thread that the stack belongs to.
+   * @param frames supplies the return addresses, innermost first.
+   */
+  static void logFrames(int32_t thread_id, const std::vector<void*>& frames) {
+    if (frames.empty()) {
+      ENVOY_LOG(critical, "Back trace attempt failed");
+      return;
+    }
+
+    CapturedStack stack{frames};
+    backward::TraceResolver resolver;
+    resolver.load_stacktrace(stack);
+    auto obj_name = resolver.resolve(backward::Trace(frames[0], 0)).object_filename;
+
+    ENVOY_LOG(critical, "Backtrace obj<{}> thr<{}> (use tools/stack_decode.py):", obj_name,
+              thread_id);
+    for (size_t i = 0; i < frames.size(); ++i) {
+      backward::ResolvedTrace trace = resolver.resolve(backward::Trace(frames[i], i));
+      if (trace.object_filename != obj_name) {
+        obj_name = trace.object_filename;
+        ENVOY_LOG(critical, "thr<{}> obj<{}>", thread_id, obj_name);
+      }
+      ENVOY_LOG(critical, "thr<{}> #{} {}", thread_id, i, frames[i]);
+    }
+    ENVOY_LOG(critical, "end backtrace thread {}", thread_id);
+  }
+
   void logFault(const char* signame, const void* addr) {
     ENVOY_LOG(critical, "Caught {}, suspect faulting address {}", signame, addr);
   }
 
 private:
+  // The part of backward::StackTrace that backward::TraceResolver loads.
+  struct CapturedStack {
+    void* const* begin() const { return frames_.data(); }
+    size_t size() const { return frames_.size(); }
+
+    const std::vector<void*>& frames_;
+  };
+
   static const int MAX_STACK_DEPTH = 64;
   backward::StackTrace stack_trace_;
 };
@@ -0,0 +1,63 @@
+#include "server/config/access_log/structured_access_log.h"
+
+#include "envoy/common/exception.h"
+#include "envoy/registry/registry.h"
+#include "envoy/server/filter_config.h"
+
+#include "common/access_log/structured_access_log_impl.h"
+#include "common/config/well_known_names.h"
+#include "common/grpc/async_client_impl.h"
+#include "common/protobuf/protobuf.h"
+
+#include "fmt/format.h"
+
+namespace Envoy {
+namespace Server {
+namespace Configuration {
+
+AccessLog::InstanceSharedPtr StructuredAccessLogFactory::createAccessLogInstance(
+    const Protobuf::Message& config, AccessLog::FilterPtr&& filter, FactoryContext& context) {
+  const auto& sal_config = dynamic_cast<const envoy::accesslog::StructuredAccessLog&>(config);
+
+  switch (sal_config.sink_case()) {
+  case envoy::accesslog::StructuredAccessLog::kPath:
+    return AccessLog::InstanceSharedPtr{new AccessLog::BinaryFileAccessLog(
+        sal_config.path(), std::move(filter), context.accessLogManager())};
+  case envoy::accesslog::StructuredAccessLog::kClusterName: {
+    const std::string cluster_name = sal_config.cluster_name();
+    Upstream::ClusterManager& cm = context.clusterManager();
+    if (!cm.get(cluster_name)) {
+      throw EnvoyException(
+          fmt::format("unknown structured access log service cluster '{}'", cluster_name));
+    }
+    return AccessLog::InstanceSharedPtr{new AccessLog::GrpcAccessLog(
+        sal_config, std::move(filter),
+        [&cm, cluster_name]() -> AccessLog::AccessLogServiceAsyncClientPtr {
+          return AccessLog::AccessLogServiceAsyncClientPtr{
+              new Grpc::AsyncClientImpl<envoy::accesslog::StreamAccessLogsMessage,
+                                        envoy::accesslog::StreamAccessLogsResponse>(
+                  cm, cluster_name)};
+        },
+        context.threadLocal(), context.localInfo())};
+  }
+  default:
+    throw EnvoyException("structured access log requires either a path or a cluster_name");
+  }
+}
+
+ProtobufTypes::MessagePtr StructuredAccessLogFactory::createEmptyConfigProto() {
+  return ProtobufTypes::MessagePtr{new envoy::accesslog::StructuredAccessLog()};
+}
+
+std::string StructuredAccessLogFactory::name() const {
+  return Config::AccessLogNames::get().STRUCTURED;
+}
+
+/**
+ * Static registration for the structured access log. @see RegisterFactory.
+ */
+static Registry::RegisterFactory<StructuredAccessLogFactory, AccessLogInstanceFactory> register_;
+
+} // namespace Configuration
+} // namespace Server
+} // namespace Envoy
@@ -0,0 +1,33 @@
+#include "server/config/http/adaptive_concurrency.h"
+
+#include <string>
+
+#include "envoy/registry/registry.h"
+
+#include "common/common/utility.h"
+#include "common/http/filter/adaptive_concurrency_filter.h"
+
+namespace Envoy {
+namespace Server {
+namespace Configuration {
+
+HttpFilterFactoryCb AdaptiveConcurrencyFilterConfig::createFilter(const std::string& stats_prefix,
+                                                                  FactoryContext& context) {
+  // One controller per filter chain, shared by the filter instances on every worker.
+  Http::AdaptiveConcurrencyControllerSharedPtr controller =
+      std::make_shared<Http::AdaptiveConcurrencyController>(
+          context.runtime(), stats_prefix, context.scope(), ProdMonotonicTimeSource::instance_);
+  return [controller](Http::FilterChainFactoryCallbacks& callbacks) -> void {
+    callbacks.addStreamFilter(std::make_shared<Http::AdaptiveConcurrencyFilter>(controller));
+  };
+}
+
+/**
+ * Static registration for the adaptive concurrency filter. @see RegisterFactory.
+ */
+static Registry::RegisterFactory<AdaptiveConcurrencyFilterConfig, NamedHttpFilterConfigFactory>
+    register_;
+
+} // namespace Configuration
+} // namespace Server
+} // namespace Envoy
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+
+#include "envoy/server/filter_config.h"
+
+#include "common/config/well_known_names.h"
+
+#include "server/config/http/empty_http_filter_config.h"
+
+namespace Envoy {
+namespace Server {
+namespace Configuration {
+
+/**
+ * Config registration for the adaptive concurrency filter. The filter has no static
+ * configuration: it is tuned through the adaptive_concurrency.* runtime keys. @see
+ * NamedHttpFilterConfigFactory.
+ */
+class AdaptiveConcurrencyFilterConfig : public EmptyHttpFilterConfig {
+public:
+  HttpFilterFactoryCb createFilter(const std::string& stats_prefix,
+                                   FactoryContext& context) override;
+  std::string name() override { return Config::HttpFilterNames::get().ADAPTIVE_CONCURRENCY; }
+};
+
+} // namespace Configuration
+} // namespace Server
+} // namespace Envoy
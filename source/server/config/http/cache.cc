@@ -0,0 +1,45 @@
+#include "server/config/http/cache.h"
+
+#include <string>
+
+#include "envoy/registry/registry.h"
+
+#include "common/common/utility.h"
+#include "common/http/filter/cache/cache_filter.h"
+#include "common/protobuf/utility.h"
+
+namespace Envoy {
+namespace Server {
+namespace Configuration {
+
+HttpFilterFactoryCb HttpCacheFilterConfig::createFilterFactory(const Json::Object& json_config,
+                                                               const std::string& stats_prefix,
+                                                               FactoryContext& context) {
+  // One cache per filter chain, shared by the filter instances on every worker.
+  Http::Filter::Cache::CacheFilterConfigSharedPtr config =
+      std::make_shared<Http::Filter::Cache::CacheFilterConfig>(
+          json_config, stats_prefix, context.scope(), ProdSystemTimeSource::instance_);
+  return [config](Http::FilterChainFactoryCallbacks& callbacks) -> void {
+    callbacks.addStreamFilter(std::make_shared<Http::Filter::Cache::CacheFilter>(config));
+  };
+}
+
+HttpFilterFactoryCb
+HttpCacheFilterConfig::createFilterFactoryFromProto(const Protobuf::Message& proto_config,
+                                                    const std::string& stats_prefix,
+                                                    FactoryContext& context) {
+  // There is no v2 proto for the cache filter yet, so its config arrives as a Struct holding the
+  // v1 JSON config.
+  const Json::ObjectSharedPtr json_config =
+      MessageUtil::getJsonObjectFromMessage(dynamic_cast<const ProtobufWkt::Struct&>(proto_config));
+  return createFilterFactory(*json_config, stats_prefix, context);
+}
+
+/**
+ * Static registration for the HTTP cache filter. @see RegisterFactory.
+ */
+static Registry::RegisterFactory<HttpCacheFilterConfig, NamedHttpFilterConfigFactory> register_;
+
+} // namespace Configuration
+} // namespace Server
+} // namespace Envoy
@@ -0,0 +1,42 @@
+#include "server/config/http/gzip.h"
+
+#include <string>
+
+#include "envoy/registry/registry.h"
+
+#include "common/http/filter/gzip_filter.h"
+#include "common/protobuf/utility.h"
+
+namespace Envoy {
+namespace Server {
+namespace Configuration {
+
+HttpFilterFactoryCb GzipFilterConfig::createFilterFactory(const Json::Object& json_config,
+                                                          const std::string& stats_prefix,
+                                                          FactoryContext& context) {
+  Http::GzipFilterConfigSharedPtr config = std::make_shared<Http::GzipFilterConfig>(
+      json_config, stats_prefix, context.scope(), context.threadLocal());
+  return [config](Http::FilterChainFactoryCallbacks& callbacks) -> void {
+    callbacks.addStreamFilter(std::make_shared<Http::GzipFilter>(config));
+  };
+}
+
+HttpFilterFactoryCb
+GzipFilterConfig::createFilterFactoryFromProto(const Protobuf::Message& proto_config,
+                                               const std::string& stats_prefix,
+                                               FactoryContext& context) {
+  // There is no v2 proto for the gzip filter yet, so its config arrives as a Struct holding the v1
+  // JSON config.
+  const Json::ObjectSharedPtr json_config =
+      MessageUtil::getJsonObjectFromMessage(dynamic_cast<const ProtobufWkt::Struct&>(proto_config));
+  return createFilterFactory(*json_config, stats_prefix, context);
+}
+
+/**
+ * Static registration for the gzip filter. @see RegisterFactory.
+ */
+static Registry::RegisterFactory<GzipFilterConfig, NamedHttpFilterConfigFactory> register_;
+
+} // namespace Configuration
+} // namespace Server
+} // namespace Envoy
@@ -13,9 +13,10 @@ namespace Configuration {
 
 HttpFilterFactoryCb
 LuaFilterConfig::createFilter(const envoy::api::v2::filter::http::Lua& proto_config,
-                              const std::string&, FactoryContext& context) {
+                              const std::string& stat_prefix, FactoryContext& context) {
   Http::Filter::Lua::FilterConfigConstSharedPtr filter_config(new Http::Filter::Lua::FilterConfig{
-      proto_config.inline_code(), context.threadLocal(), context.clusterManager()});
+      proto_config.inline_code(), context.threadLocal(), context.clusterManager(),
+      context.runtime(), stat_prefix, context.scope()});
   return [filter_config](Http::FilterChainFactoryCallbacks& callbacks) -> void {
     callbacks.addStreamFilter(std::make_shared<Http::Filter::Lua::Filter>(filter_config));
   };
@@ -51,7 +51,7 @@ NetworkFilterFactoryCb HttpConnectionManagerFilterConfigFactory::createFilter(
           SINGLETON_MANAGER_REGISTERED_NAME(route_config_provider_manager), [&context] {
             return std::make_shared<Router::RouteConfigProviderManagerImpl>(
                 context.runtime(), context.dispatcher(), context.random(), context.localInfo(),
-                context.threadLocal(), context.admin());
+                context.threadLocal(), context.admin(), true);
           });
 
   std::shared_ptr<HttpConnectionManagerConfig> filter_config(new HttpConnectionManagerConfig(
@@ -119,7 +119,9 @@ HttpConnectionManagerConfig::HttpConnectionManagerConfig(
           Http::ConnectionManagerImpl::generateTracingStats(stats_prefix_, context_.scope())),
       use_remote_address_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, use_remote_address, false)),
       route_config_provider_manager_(route_config_provider_manager),
-      http2_settings_(Http::Utility::parseHttp2Settings(config.http2_protocol_options())),
+      http2_settings_(Http::Utility::parseHttp2Settings(
+          config.http2_protocol_options(), context_.runtime(),
+          stats_prefix_ + "http2_window_auto_tuning")),
       http1_settings_(Http::Utility::parseHttp1Settings(config.http_protocol_options())),
       drain_timeout_(PROTOBUF_GET_MS_OR_DEFAULT(config, drain_timeout, 5000)),
       generate_request_id_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, generate_request_id, true)),
@@ -240,7 +242,7 @@ HttpConnectionManagerConfig::HttpConnectionManagerConfig(
           Config::Utility::translateToFactoryConfig(proto_config, factory);
       callback = factory.createFilterFactoryFromProto(*message, stats_prefix_, context);
     }
-    filter_factories_.push_back(callback);
+    filter_factories_.emplace_back(string_name, callback);
   }
 }
 
@@ -270,8 +272,9 @@ HttpConnectionManagerConfig::createCodec(Network::Connection& connection,
 }
 
 void HttpConnectionManagerConfig::createFilterChain(Http::FilterChainFactoryCallbacks& callbacks) {
-  for (const HttpFilterFactoryCb& factory : filter_factories_) {
-    factory(callbacks);
+  for (const auto& factory : filter_factories_) {
+    callbacks.setFilterName(factory.first);
+    factory.second(callbacks);
   }
 }
 
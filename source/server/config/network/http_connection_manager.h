@@ -5,6 +5,7 @@
 #include <functional>
 #include <list>
 #include <string>
+#include <utility>
 
 #include "envoy/http/filter.h"
 #include "envoy/router/route_config_provider_manager.h"
@@ -103,7 +104,8 @@ private:
   enum class CodecType { HTTP1, HTTP2, AUTO };
 
   FactoryContext& context_;
-  std::list<HttpFilterFactoryCb> filter_factories_;
+  // The factory of each filter, with the name of the filter.
+  std::list<std::pair<std::string, HttpFilterFactoryCb>> filter_factories_;
   std::list<AccessLog::InstanceSharedPtr> access_logs_;
   const std::string stats_prefix_;
   Http::ConnectionManagerStats stats_;
@@ -5,6 +5,7 @@
 
 #include "envoy/registry/registry.h"
 
+#include "common/common/utility.h"
 #include "common/config/filter_json.h"
 #include "common/redis/codec_impl.h"
 #include "common/redis/command_splitter_impl.h"
@@ -32,8 +33,9 @@ NetworkFilterFactoryCb RedisProxyFilterConfigFactory::createFilter(
                                         Redis::ConnPool::ClientFactoryImpl::instance_,
                                         context.threadLocal(), proto_config.settings()));
   std::shared_ptr<Redis::CommandSplitter::Instance> splitter(
-      new Redis::CommandSplitter::InstanceImpl(std::move(conn_pool), context.scope(),
-                                               filter_config->stat_prefix_));
+      new Redis::CommandSplitter::InstanceImpl(
+          std::move(conn_pool), context.scope(), filter_config->stat_prefix_, context.runtime(),
+          context.threadLocal(), ProdMonotonicTimeSource::instance_));
   return [splitter, filter_config](Network::FilterManager& filter_manager) -> void {
     Redis::DecoderFactoryImpl factory;
     filter_manager.addReadFilter(std::make_shared<Redis::ProxyFilter>(
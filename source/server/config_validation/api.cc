@@ -5,8 +5,9 @@
 namespace Envoy {
 namespace Api {
 
-ValidationImpl::ValidationImpl(std::chrono::milliseconds file_flush_interval_msec)
-    : Impl(file_flush_interval_msec) {}
+ValidationImpl::ValidationImpl(std::chrono::milliseconds file_flush_interval_msec,
+                               uint64_t file_write_buffer_bytes)
+    : Impl(file_flush_interval_msec, file_write_buffer_bytes) {}
 
 Event::DispatcherPtr ValidationImpl::allocateDispatcher() {
   return Event::DispatcherPtr{new Event::ValidationDispatcher()};
@@ -14,7 +14,8 @@ namespace Api {
  */
 class ValidationImpl : public Impl {
 public:
-  ValidationImpl(std::chrono::milliseconds file_flush_interval_msec);
+  ValidationImpl(std::chrono::milliseconds file_flush_interval_msec,
+                 uint64_t file_write_buffer_bytes);
 
   Event::DispatcherPtr allocateDispatcher() override;
 };
@@ -37,7 +37,8 @@ ValidationInstance::ValidationInstance(Options& options,
                                        Thread::BasicLockable& access_log_lock,
                                        ComponentFactory& component_factory)
     : options_(options), stats_store_(store),
-      api_(new Api::ValidationImpl(options.fileFlushIntervalMsec())),
+      api_(new Api::ValidationImpl(options.fileFlushIntervalMsec(),
+                                   options.fileWriteBufferBytes())),
       dispatcher_(api_->allocateDispatcher()), singleton_manager_(new Singleton::ManagerImpl()),
       access_log_manager_(*api_, *dispatcher_, access_log_lock, store),
       listener_manager_(*this, *this, *this) {
@@ -65,7 +66,8 @@ void ValidationInstance::initialize(Options& options,
   // be ready to serve, then the config has passed validation.
   // Handle configuration that needs to take place prior to the main configuration load.
   envoy::api::v2::Bootstrap bootstrap;
-  InstanceUtil::loadBootstrapConfig(bootstrap, options.configPath(), options.v2ConfigOnly());
+  InstanceUtil::loadBootstrapConfig(bootstrap, options.configPath(), options.v2ConfigOnly(),
+                                    options.concurrency());
 
   tag_extractors_ = Config::Utility::createTagExtractors(bootstrap);
 
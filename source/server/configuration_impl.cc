@@ -16,6 +16,8 @@
 #include "common/config/lds_json.h"
 #include "common/config/utility.h"
 #include "common/protobuf/utility.h"
+#include "common/ratelimit/coalescing_ratelimit_impl.h"
+#include "common/ratelimit/local_ratelimit_impl.h"
 #include "common/ratelimit/ratelimit_impl.h"
 #include "common/tracing/http_tracer_impl.h"
 
@@ -38,16 +40,24 @@ bool FilterChainUtility::buildFilterChain(Network::FilterManager& filter_manager
 
 void MainImpl::initialize(const envoy::api::v2::Bootstrap& bootstrap, Instance& server,
                           Upstream::ClusterManagerFactory& cluster_manager_factory) {
+  MonotonicTime phase_start = ProdMonotonicTimeSource::instance_.currentTime();
   cluster_manager_ = cluster_manager_factory.clusterManagerFromProto(
       bootstrap, server.stats(), server.threadLocal(), server.runtime(), server.random(),
       server.localInfo(), server.accessLogManager());
+  server.startupPhases().emplace_back(
+      "clusters", std::chrono::duration_cast<std::chrono::milliseconds>(
+                      ProdMonotonicTimeSource::instance_.currentTime() - phase_start));
 
+  phase_start = ProdMonotonicTimeSource::instance_.currentTime();
   const auto& listeners = bootstrap.static_resources().listeners();
   ENVOY_LOG(info, "loading {} listener(s)", listeners.size());
   for (ssize_t i = 0; i < listeners.size(); i++) {
     ENVOY_LOG(debug, "listener #{}:", i);
     server.listenerManager().addOrUpdateListener(listeners[i]);
   }
+  server.startupPhases().emplace_back(
+      "listeners", std::chrono::duration_cast<std::chrono::milliseconds>(
+                       ProdMonotonicTimeSource::instance_.currentTime() - phase_start));
 
   if (bootstrap.dynamic_resources().has_lds_config()) {
     lds_api_.reset(new LdsApi(bootstrap.dynamic_resources().lds_config(), *cluster_manager_,
@@ -70,12 +80,19 @@ void MainImpl::initialize(const envoy::api::v2::Bootstrap& bootstrap, Instance&
 
   initializeTracers(bootstrap.tracing(), server);
 
+  RateLimit::ClientFactoryPtr global_ratelimit_client_factory;
   if (bootstrap.has_rate_limit_service()) {
-    ratelimit_client_factory_.reset(
-        new RateLimit::GrpcFactoryImpl(bootstrap.rate_limit_service(), *cluster_manager_));
+    global_ratelimit_client_factory.reset(new RateLimit::CoalescingFactoryImpl(
+        RateLimit::ClientFactoryPtr{
+            new RateLimit::GrpcFactoryImpl(bootstrap.rate_limit_service(), *cluster_manager_)},
+        server.threadLocal(), server.runtime(), server.stats(),
+        ProdMonotonicTimeSource::instance_));
   } else {
-    ratelimit_client_factory_.reset(new RateLimit::NullFactoryImpl());
+    global_ratelimit_client_factory.reset(new RateLimit::NullFactoryImpl());
   }
+  ratelimit_client_factory_.reset(new RateLimit::LocalFactoryImpl(
+      std::move(global_ratelimit_client_factory), server.threadLocal(), server.runtime(),
+      server.stats(), ProdMonotonicTimeSource::instance_));
 
   initializeStatsSinks(bootstrap, server);
 }
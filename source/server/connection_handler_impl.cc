@@ -1,22 +1,34 @@
 #include "server/connection_handler_impl.h"
 
+#include <algorithm>
+
 #include "envoy/event/dispatcher.h"
 #include "envoy/event/timer.h"
 #include "envoy/network/filter.h"
 #include "envoy/stats/timespan.h"
 
+#include "fmt/format.h"
+
 namespace Envoy {
 namespace Server {
 
 ConnectionHandlerImpl::ConnectionHandlerImpl(spdlog::logger& logger, Event::Dispatcher& dispatcher)
     : logger_(logger), dispatcher_(dispatcher) {}
 
+ConnectionHandlerImpl::ConnectionHandlerImpl(spdlog::logger& logger, Event::Dispatcher& dispatcher,
+                                             uint32_t worker_index)
+    : logger_(logger), dispatcher_(dispatcher),
+      per_worker_stat_prefix_(fmt::format("worker_{}.", worker_index)) {}
+
 void ConnectionHandlerImpl::addListener(Network::FilterChainFactory& factory,
                                         Network::ListenSocket& socket, Stats::Scope& scope,
                                         uint64_t listener_tag,
                                         const Network::ListenerOptions& listener_options) {
   ActiveListenerPtr l(
       new ActiveListener(*this, socket, factory, scope, listener_tag, listener_options));
+  if (disable_listeners_) {
+    l->listener_->disable();
+  }
   listeners_.emplace_back(socket.localAddress(), std::move(l));
 }
 
@@ -27,6 +39,9 @@ void ConnectionHandlerImpl::addSslListener(Network::FilterChainFactory& factory,
                                            const Network::ListenerOptions& listener_options) {
   ActiveListenerPtr l(new SslActiveListener(*this, ssl_ctx, socket, factory, scope, listener_tag,
                                             listener_options));
+  if (disable_listeners_) {
+    l->listener_->disable();
+  }
   listeners_.emplace_back(socket.localAddress(), std::move(l));
 }
 
@@ -44,6 +59,7 @@ void ConnectionHandlerImpl::stopListeners(uint64_t listener_tag) {
   for (auto& listener : listeners_) {
     if (listener.second->listener_tag_ == listener_tag) {
       listener.second->listener_.reset();
+      listener.second->startDrain();
     }
   }
 }
@@ -51,13 +67,33 @@ void ConnectionHandlerImpl::stopListeners(uint64_t listener_tag) {
 void ConnectionHandlerImpl::stopListeners() {
   for (auto& listener : listeners_) {
     listener.second->listener_.reset();
+    listener.second->startDrain();
+  }
+}
+
+void ConnectionHandlerImpl::disableListeners() {
+  disable_listeners_ = true;
+  for (auto& listener : listeners_) {
+    if (listener.second->listener_ != nullptr) {
+      listener.second->listener_->disable();
+    }
+  }
+}
+
+void ConnectionHandlerImpl::enableListeners() {
+  disable_listeners_ = false;
+  for (auto& listener : listeners_) {
+    if (listener.second->listener_ != nullptr) {
+      listener.second->listener_->enable();
+    }
   }
 }
 
 void ConnectionHandlerImpl::ActiveListener::removeConnection(ActiveConnection& connection) {
   ENVOY_CONN_LOG_TO_LOGGER(parent_.logger_, debug, "adding to cleanup list",
                            *connection.connection_);
-  ActiveConnectionPtr removed = connection.removeFromList(connections_);
+  ActiveConnectionPtr removed =
+      connection.removeFromList(connection.draining_ ? draining_connections_ : connections_);
   parent_.dispatcher_.deferredDelete(std::move(removed));
   ASSERT(parent_.num_connections_ > 0);
   parent_.num_connections_--;
@@ -69,21 +105,90 @@ ConnectionHandlerImpl::ActiveListener::ActiveListener(
     const Network::ListenerOptions& listener_options)
     : ActiveListener(
           parent, parent.dispatcher_.createListener(parent, socket, *this, scope, listener_options),
-          factory, scope, listener_tag) {}
+          factory, scope, listener_tag, listener_options) {}
 
-ConnectionHandlerImpl::ActiveListener::ActiveListener(ConnectionHandlerImpl& parent,
-                                                      Network::ListenerPtr&& listener,
-                                                      Network::FilterChainFactory& factory,
-                                                      Stats::Scope& scope, uint64_t listener_tag)
+ConnectionHandlerImpl::ActiveListener::ActiveListener(
+    ConnectionHandlerImpl& parent, Network::ListenerPtr&& listener,
+    Network::FilterChainFactory& factory, Stats::Scope& scope, uint64_t listener_tag,
+    const Network::ListenerOptions& listener_options)
     : parent_(parent), factory_(factory), listener_(std::move(listener)),
-      stats_(generateStats(scope)), listener_tag_(listener_tag) {}
+      stats_(generateStats(scope)), listener_tag_(listener_tag),
+      idle_buffer_release_interval_(listener_options.idle_buffer_release_interval_),
+      drain_connections_per_second_(listener_options.drain_connections_per_second_) {
+  if (!parent_.per_worker_stat_prefix_.empty()) {
+    per_worker_scope_ = scope.createScope(parent_.per_worker_stat_prefix_);
+    per_worker_stats_.reset(
+        new PerHandlerListenerStats(generatePerHandlerStats(*per_worker_scope_)));
+  }
+
+  // A single timer per listener sweeps all of its connections, rather than each connection keeping
+  // an idle timer of its own.
+  if (idle_buffer_release_interval_.count() > 0) {
+    idle_buffer_timer_ =
+        parent_.dispatcher_.createCoarseTimer([this]() -> void { onIdleBufferSweep(); });
+    idle_buffer_timer_->enableTimer(idle_buffer_release_interval_);
+  }
+}
 
 ConnectionHandlerImpl::ActiveListener::~ActiveListener() {
   while (!connections_.empty()) {
     connections_.front()->connection_->close(Network::ConnectionCloseType::NoFlush);
   }
+  while (!draining_connections_.empty()) {
+    draining_connections_.front()->connection_->close(Network::ConnectionCloseType::NoFlush);
+  }
 
   parent_.dispatcher_.clearDeferredDeleteList();
+  stats_.downstream_cx_idle_.sub(idle_connections_);
+  stats_.downstream_cx_idle_buffered_bytes_.sub(idle_buffered_bytes_);
+}
+
+void ConnectionHandlerImpl::ActiveListener::onIdleBufferSweep() {
+  uint64_t idle_connections = 0;
+  uint64_t idle_buffered_bytes = 0;
+  for (const ActiveConnectionPtr& active_connection : connections_) {
+    if (active_connection->connection_->releaseIdleBuffers()) {
+      idle_connections++;
+      idle_buffered_bytes += active_connection->connection_->bufferedBytes();
+    }
+  }
+
+  stats_.downstream_cx_idle_.add(idle_connections);
+  stats_.downstream_cx_idle_.sub(idle_connections_);
+  idle_connections_ = idle_connections;
+  stats_.downstream_cx_idle_buffered_bytes_.add(idle_buffered_bytes);
+  stats_.downstream_cx_idle_buffered_bytes_.sub(idle_buffered_bytes_);
+  idle_buffered_bytes_ = idle_buffered_bytes;
+
+  idle_buffer_timer_->enableTimer(idle_buffer_release_interval_);
+}
+
+void ConnectionHandlerImpl::ActiveListener::startDrain() {
+  if (drain_connections_per_second_ == 0 || drain_timer_ != nullptr) {
+    return;
+  }
+
+  drain_timer_ = parent_.dispatcher_.createCoarseTimer([this]() -> void { onDrainTick(); });
+  onDrainTick();
+}
+
+void ConnectionHandlerImpl::ActiveListener::onDrainTick() {
+  // Drain in batches at most ten times a second, so that the clients reconnect to the new
+  // listener at a steady rate instead of all at once when the drain time is up.
+  const uint32_t batch = std::max<uint32_t>(drain_connections_per_second_ / 10, 1);
+  for (uint32_t i = 0; i < batch && !connections_.empty(); i++) {
+    ActiveConnection& connection = *connections_.back();
+    connection.moveBetweenLists(connections_, draining_connections_);
+    connection.draining_ = true;
+    if (connection.connection_->startDrain()) {
+      stats_.downstream_cx_drain_requested_.inc();
+    }
+  }
+
+  if (!connections_.empty()) {
+    drain_timer_->enableTimer(
+        std::chrono::milliseconds(1000 * batch / drain_connections_per_second_));
+  }
 }
 
 ConnectionHandlerImpl::SslActiveListener::SslActiveListener(
@@ -93,7 +198,7 @@ ConnectionHandlerImpl::SslActiveListener::SslActiveListener(
     : ActiveListener(parent,
                      parent.dispatcher_.createSslListener(parent, ssl_ctx, socket, *this, scope,
                                                           listener_options),
-                     factory, scope, listener_tag) {}
+                     factory, scope, listener_tag, listener_options) {}
 
 Network::Listener*
 ConnectionHandlerImpl::findListenerByAddress(const Network::Address::Instance& address) {
@@ -127,6 +232,10 @@ ConnectionHandlerImpl::findListenerByAddress(const Network::Address::Instance& a
 void ConnectionHandlerImpl::ActiveListener::onNewConnection(
     Network::ConnectionPtr&& new_connection) {
   ENVOY_CONN_LOG_TO_LOGGER(parent_.logger_, debug, "new connection", *new_connection);
+  const uint32_t cap = parent_.connection_buffer_limit_cap_;
+  if (cap != 0 && (new_connection->bufferLimit() == 0 || new_connection->bufferLimit() > cap)) {
+    new_connection->setBufferLimits(cap);
+  }
   bool empty_filter_chain = !factory_.createFilterChain(*new_connection);
 
   // If the connection is already closed, we can just let this connection immediately die.
@@ -155,11 +264,18 @@ ConnectionHandlerImpl::ActiveConnection::ActiveConnection(ActiveListener& listen
   connection_->addConnectionCallbacks(*this);
   listener_.stats_.downstream_cx_total_.inc();
   listener_.stats_.downstream_cx_active_.inc();
+  if (listener_.per_worker_stats_) {
+    listener_.per_worker_stats_->downstream_cx_total_.inc();
+    listener_.per_worker_stats_->downstream_cx_active_.inc();
+  }
 }
 
 ConnectionHandlerImpl::ActiveConnection::~ActiveConnection() {
   listener_.stats_.downstream_cx_active_.dec();
   listener_.stats_.downstream_cx_destroy_.inc();
+  if (listener_.per_worker_stats_) {
+    listener_.per_worker_stats_->downstream_cx_active_.dec();
+  }
   conn_length_->complete();
 }
 
@@ -167,5 +283,9 @@ ListenerStats ConnectionHandlerImpl::generateStats(Stats::Scope& scope) {
   return {ALL_LISTENER_STATS(POOL_COUNTER(scope), POOL_GAUGE(scope), POOL_HISTOGRAM(scope))};
 }
 
+PerHandlerListenerStats ConnectionHandlerImpl::generatePerHandlerStats(Stats::Scope& scope) {
+  return {ALL_PER_HANDLER_LISTENER_STATS(POOL_COUNTER(scope), POOL_GAUGE(scope))};
+}
+
 } // namespace Server
 } // namespace Envoy
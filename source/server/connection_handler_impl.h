@@ -1,12 +1,15 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <list>
 #include <memory>
+#include <string>
 
 #include "envoy/common/time.h"
 #include "envoy/event/deferred_deletable.h"
+#include "envoy/event/timer.h"
 #include "envoy/network/connection.h"
 #include "envoy/network/connection_handler.h"
 #include "envoy/network/filter.h"
@@ -27,7 +30,14 @@ namespace Server {
   COUNTER  (downstream_cx_total)                                                                   \
   COUNTER  (downstream_cx_destroy)                                                                 \
   GAUGE    (downstream_cx_active)                                                                  \
+  GAUGE    (downstream_cx_idle)                                                                    \
+  GAUGE    (downstream_cx_idle_buffered_bytes)                                                     \
+  COUNTER  (downstream_cx_drain_requested)                                                         \
   HISTOGRAM(downstream_cx_length_ms)
+
+#define ALL_PER_HANDLER_LISTENER_STATS(COUNTER, GAUGE)                                             \
+  COUNTER(downstream_cx_total)                                                                     \
+  GAUGE  (downstream_cx_active)
 // clang-format on
 
 /**
@@ -37,6 +47,13 @@ struct ListenerStats {
   ALL_LISTENER_STATS(GENERATE_COUNTER_STRUCT, GENERATE_GAUGE_STRUCT, GENERATE_HISTOGRAM_STRUCT)
 };
 
+/**
+ * Wrapper struct for the stats a listener keeps per worker. @see stats_macros.h
+ */
+struct PerHandlerListenerStats {
+  ALL_PER_HANDLER_LISTENER_STATS(GENERATE_COUNTER_STRUCT, GENERATE_GAUGE_STRUCT)
+};
+
 /**
  * Server side connection handler. This is used both by workers as well as the
  * main thread for non-threaded listeners.
@@ -45,6 +62,14 @@ class ConnectionHandlerImpl : public Network::ConnectionHandler, NonCopyable {
 public:
   ConnectionHandlerImpl(spdlog::logger& logger, Event::Dispatcher& dispatcher);
 
+  /**
+   * @param worker_index supplies the index of the worker that owns the handler. Every listener
+   *        added to the handler also keeps its connection stats in a "worker_<index>." scope, which
+   *        shows how evenly the workers share the listener's connections.
+   */
+  ConnectionHandlerImpl(spdlog::logger& logger, Event::Dispatcher& dispatcher,
+                        uint32_t worker_index);
+
   // Network::ConnectionHandler
   uint64_t numConnections() override { return num_connections_; }
   void addListener(Network::FilterChainFactory& factory, Network::ListenSocket& socket,
@@ -57,6 +82,11 @@ public:
   void removeListeners(uint64_t listener_tag) override;
   void stopListeners(uint64_t listener_tag) override;
   void stopListeners() override;
+  void disableListeners() override;
+  void enableListeners() override;
+  void setConnectionBufferLimitCap(uint32_t limit) override {
+    connection_buffer_limit_cap_ = limit;
+  }
 
 private:
   struct ActiveConnection;
@@ -72,7 +102,7 @@ private:
 
     ActiveListener(ConnectionHandlerImpl& parent, Network::ListenerPtr&& listener,
                    Network::FilterChainFactory& factory, Stats::Scope& scope,
-                   uint64_t listener_tag);
+                   uint64_t listener_tag, const Network::ListenerOptions& listener_options);
 
     ~ActiveListener();
 
@@ -88,12 +118,36 @@ private:
      */
     void removeConnection(ActiveConnection& connection);
 
+    /**
+     * Release the buffers of the connections that did no I/O since the previous sweep, and update
+     * the idle connection stats.
+     */
+    void onIdleBufferSweep();
+
+    /**
+     * Start asking the connections to drain, oldest first, at the listener's drain rate. Called
+     * once the listener is stopped, so no connections are added afterwards.
+     */
+    void startDrain();
+    void onDrainTick();
+
     ConnectionHandlerImpl& parent_;
     Network::FilterChainFactory& factory_;
     Network::ListenerPtr listener_;
     ListenerStats stats_;
+    Stats::ScopePtr per_worker_scope_;
+    std::unique_ptr<PerHandlerListenerStats> per_worker_stats_;
     std::list<ActiveConnectionPtr> connections_;
+    // Connections that were asked to drain and have not closed yet.
+    std::list<ActiveConnectionPtr> draining_connections_;
     const uint64_t listener_tag_;
+    const std::chrono::milliseconds idle_buffer_release_interval_;
+    Event::TimerPtr idle_buffer_timer_;
+    // This handler's share of the idle gauges, which the listener's other handlers add to as well.
+    uint64_t idle_connections_{};
+    uint64_t idle_buffered_bytes_{};
+    const uint32_t drain_connections_per_second_;
+    Event::TimerPtr drain_timer_;
   };
 
   struct SslActiveListener : public ActiveListener {
@@ -128,14 +182,21 @@ private:
     ActiveListener& listener_;
     Network::ConnectionPtr connection_;
     Stats::TimespanPtr conn_length_;
+    // Whether the connection is in the listener's draining_connections_.
+    bool draining_{};
   };
 
   static ListenerStats generateStats(Stats::Scope& scope);
+  static PerHandlerListenerStats generatePerHandlerStats(Stats::Scope& scope);
 
   spdlog::logger& logger_;
   Event::Dispatcher& dispatcher_;
+  // Empty if the handler does not belong to a worker.
+  const std::string per_worker_stat_prefix_;
   std::list<std::pair<Network::Address::InstanceConstSharedPtr, ActiveListenerPtr>> listeners_;
   std::atomic<uint64_t> num_connections_{};
+  bool disable_listeners_{};
+  uint32_t connection_buffer_limit_cap_{};
 };
 
 } // Server
@@ -5,6 +5,8 @@
 
 #include "common/common/assert.h"
 
+#include "server/backtrace.h"
+#include "server/thread_stack_capture.h"
 #include "server/watchdog_impl.h"
 
 #include "fmt/format.h"
@@ -51,6 +53,7 @@ void GuardDogImpl::threadRoutine() {
           watchdog_miss_counter_.inc();
           watched_dog.last_alert_time_.value(ltt);
           watched_dog.miss_alerted_ = true;
+          logStall(*watched_dog.dog_, delta);
         }
       }
       if (delta > megamiss_timeout_) {
@@ -78,14 +81,27 @@ void GuardDogImpl::threadRoutine() {
   } while (waitOrDetectStop());
 }
 
+void GuardDogImpl::logStall(const WatchDogImpl& dog, std::chrono::steady_clock::duration stalled) {
+  const char* callback_type = dog.runningCallbackType();
+  ENVOY_LOG(warn, "GuardDog: thread {} stuck for {}ms while running a {} callback", dog.threadId(),
+            std::chrono::duration_cast<std::chrono::milliseconds>(stalled).count(),
+            callback_type != nullptr ? callback_type : "unknown");
+
+  std::vector<void*> frames;
+  if (ThreadStackCapture::capture(dog.threadId(), frames)) {
+    BackwardsTrace::logFrames(dog.threadId(), frames);
+  } else {
+    ENVOY_LOG(warn, "GuardDog: could not capture the stack of thread {}", dog.threadId());
+  }
+}
+
 WatchDogSharedPtr GuardDogImpl::createWatchDog(int32_t thread_id) {
   // Timer started by WatchDog will try to fire at 1/2 of the interval of the
   // minimum timeout specified. loop_interval_ is const so all shared state
   // accessed out of the locked section below is const (time_source_ has no
   // state).
   auto wd_interval = loop_interval_ / 2;
-  WatchDogSharedPtr new_watchdog =
-      std::make_shared<WatchDogImpl>(thread_id, time_source_, wd_interval);
+  auto new_watchdog = std::make_shared<WatchDogImpl>(thread_id, time_source_, wd_interval);
   WatchedDog watched_dog;
   watched_dog.dog_ = new_watchdog;
   {
@@ -15,6 +15,8 @@
 #include "common/common/thread.h"
 #include "common/event/libevent.h"
 
+#include "server/watchdog_impl.h"
+
 namespace Envoy {
 namespace Server {
 
@@ -25,9 +27,12 @@ namespace Server {
  * intervals. If it finds starved threads or suspected deadlocks it will take
  * the appropriate action depending on the config parameters described below.
  *
+ * When a thread first misses, the stack it is stuck in is captured and logged along with the kind
+ * of event callback its dispatcher is running, so that stalls can be diagnosed after the fact.
+ *
  * Thread lifetime is tied to GuardDog object lifetime (RAII style).
  */
-class GuardDogImpl : public GuardDog {
+class GuardDogImpl : public GuardDog, Logger::Loggable<Logger::Id::main> {
 public:
   /**
    * @param stats_scope Statistics scope to write watchdog_miss and
@@ -56,6 +61,7 @@ public:
 
 private:
   void threadRoutine();
+  void logStall(const WatchDogImpl& dog, std::chrono::steady_clock::duration stalled);
   /**
    * @return True if we should continue, false if signalled to stop.
    */
@@ -68,7 +74,7 @@ private:
   bool multikillEnabled() const { return multi_kill_timeout_ > std::chrono::milliseconds(0); }
 
   struct WatchedDog {
-    WatchDogSharedPtr dog_;
+    std::shared_ptr<WatchDogImpl> dog_;
     Optional<MonotonicTime> last_alert_time_;
     bool miss_alerted_{};
     bool megamiss_alerted_{};
@@ -5,7 +5,9 @@
 #include <sys/types.h>
 #include <sys/un.h>
 
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <string>
 
 #include "envoy/event/dispatcher.h"
@@ -14,6 +16,7 @@
 #include "envoy/server/options.h"
 
 #include "common/api/os_sys_calls_impl.h"
+#include "common/common/hash.h"
 #include "common/common/utility.h"
 #include "common/network/utility.h"
 
@@ -24,13 +27,21 @@ namespace Server {
 
 // Increment this whenever there is a shared memory / RPC change that will prevent a hot restart
 // from working. Operations code can then cope with this and do a full restart.
-const uint64_t SharedMemory::VERSION = 9;
+const uint64_t SharedMemory::VERSION = 12;
+
+const uint64_t SharedMemory::MAX_SEGMENTS;
+const uint64_t SharedMemory::NUM_FREE_LISTS;
+const uint64_t SharedMemory::SEGMENT_SHIFT;
+const uint64_t SharedMemory::EMPTY_SLOT;
+const uint64_t SharedMemory::FREED_SLOT;
 
 SharedMemory& SharedMemory::initialize(Options& options) {
   Api::OsSysCalls& os_sys_calls = Api::OsSysCallsSingleton::get();
 
   const uint64_t entry_size = Stats::RawStatData::size();
-  const uint64_t total_size = sizeof(SharedMemory) + (entry_size * options.maxStats());
+  const uint64_t segment_size = (sizeof(StatBlock) + entry_size) * options.maxStats();
+  const uint64_t index_size = indexSize(options.maxStats());
+  const uint64_t total_size = sizeof(SharedMemory) + segment_size + index_size * sizeof(uint64_t);
 
   int flags = O_RDWR;
   const std::string shmem_name = fmt::format("/envoy_shared_memory_{}", options.baseId());
@@ -40,6 +51,9 @@ SharedMemory& SharedMemory::initialize(Options& options) {
     // If we are meant to be first, attempt to unlink a previous shared memory instance. If this
     // is a clean restart this should then allow the shm_open() call below to succeed.
     os_sys_calls.shmUnlink(shmem_name.c_str());
+    for (uint64_t i = 1; i < MAX_SEGMENTS; i++) {
+      os_sys_calls.shmUnlink(segmentName(options.baseId(), i).c_str());
+    }
   }
 
   int shmem_fd = os_sys_calls.shmOpen(shmem_name.c_str(), flags, S_IRUSR | S_IWUSR);
@@ -63,6 +77,9 @@ SharedMemory& SharedMemory::initialize(Options& options) {
     shmem->version_ = VERSION;
     shmem->num_stats_ = options.maxStats();
     shmem->entry_size_ = entry_size;
+    shmem->num_segments_ = 1;
+    shmem->segment_sizes_[0] = segment_size;
+    shmem->index_size_ = index_size;
     shmem->initializeMutex(shmem->log_lock_);
     shmem->initializeMutex(shmem->access_log_lock_);
     shmem->initializeMutex(shmem->stat_lock_);
@@ -99,6 +116,30 @@ void SharedMemory::initializeMutex(pthread_mutex_t& mutex) {
   pthread_mutex_init(&mutex, &attribute);
 }
 
+std::string SharedMemory::segmentName(uint64_t base_id, uint64_t index) {
+  ASSERT(index > 0);
+  return fmt::format("/envoy_shared_memory_{}_stats_{}", base_id, index);
+}
+
+uint64_t SharedMemory::blockSize(const std::string& name) {
+  static_assert(sizeof(StatBlock) % alignof(Stats::RawStatData) == 0,
+                "stat blocks must keep Stats::RawStatData aligned");
+  return sizeof(StatBlock) + Stats::RawStatData::sizeGivenName(name);
+}
+
+uint64_t SharedMemory::freeListIndex(uint64_t block_size) {
+  return std::min(block_size / alignof(Stats::RawStatData), NUM_FREE_LISTS - 1);
+}
+
+uint64_t SharedMemory::indexSize(uint64_t max_num_stats) {
+  // A power of two so that probing can mask the hash.
+  uint64_t size = 4;
+  while (size < 2 * max_num_stats) {
+    size *= 2;
+  }
+  return size;
+}
+
 std::string SharedMemory::version(size_t max_num_stats, size_t max_stat_name_len) {
   return fmt::format("{}.{}.{}.{}", VERSION, sizeof(SharedMemory), max_num_stats,
                      max_stat_name_len);
@@ -111,7 +152,7 @@ std::string SharedMemory::version() {
 HotRestartImpl::HotRestartImpl(Options& options)
     : options_(options), shmem_(SharedMemory::initialize(options)), log_lock_(shmem_.log_lock_),
       access_log_lock_(shmem_.access_log_lock_), stat_lock_(shmem_.stat_lock_),
-      init_lock_(shmem_.init_lock_) {
+      init_lock_(shmem_.init_lock_), segments_{shmem_.stats_slots_} {
   my_domain_socket_ = bindDomainSocket(options.restartEpoch());
   child_address_ = createDomainSocketAddress((options.restartEpoch() + 1));
   initDomainSocketAddress(&parent_address_);
@@ -127,26 +168,123 @@ HotRestartImpl::HotRestartImpl(Options& options)
 }
 
 Stats::RawStatData* HotRestartImpl::alloc(const std::string& name) {
-  // Try to find the existing slot in shared memory, otherwise allocate a new one.
-  Stats::RawStatData* unused = nullptr;
+  // Try to find the existing stat in shared memory, otherwise allocate a new one.
   std::unique_lock<Thread::BasicLockable> lock(stat_lock_);
-  for (uint64_t i = 0; i < shmem_.num_stats_; i++) {
-    const size_t offset = shmem_.entry_size_ * i;
-    Stats::RawStatData* data = reinterpret_cast<Stats::RawStatData*>(shmem_.stats_slots_ + offset);
-    if (!data->initialized()) {
-      unused = data;
-    } else if (data->matches(name)) {
-      data->ref_count_++;
-      return data;
+  mapSegments();
+  if (shmem_.index_overflow_) {
+    return allocUnindexed(name);
+  }
+
+  const uint64_t hash =
+      nameHash(name.c_str(), std::min(name.size(), Stats::RawStatData::maxNameLength()));
+  uint64_t* slot = &indexSlot(name, hash);
+  if (*slot != SharedMemory::EMPTY_SLOT && *slot != SharedMemory::FREED_SLOT) {
+    Stats::RawStatData& data = statData(*slot);
+    data.ref_count_++;
+    return &data;
+  }
+
+  // Keep the index at most 3/4 full so that probes stay short.
+  if (*slot == SharedMemory::EMPTY_SLOT &&
+      4 * (shmem_.index_used_ + 1) > 3 * shmem_.index_size_) {
+    rebuildIndex();
+    if (4 * (shmem_.index_used_ + 1) > 3 * shmem_.index_size_) {
+      ENVOY_LOG(warn, "stat index is full, stats will be found by scanning shared memory");
+      shmem_.index_overflow_ = 1;
+      return allocUnindexed(name);
+    }
+    slot = &indexSlot(name, hash);
+  }
+
+  uint64_t ref;
+  SharedMemory::StatBlock* block = allocBlock(SharedMemory::blockSize(name), ref);
+  if (block == nullptr) {
+    return nullptr;
+  }
+
+  if (*slot == SharedMemory::EMPTY_SLOT) {
+    shmem_.index_used_++;
+  }
+  *slot = ref;
+  Stats::RawStatData* data = reinterpret_cast<Stats::RawStatData*>(block + 1);
+  data->initialize(name);
+  return data;
+}
+
+Stats::RawStatData* HotRestartImpl::allocUnindexed(const std::string& name) {
+  for (uint64_t i = 0; i < segments_.size(); i++) {
+    for (uint64_t offset = 0; offset < shmem_.segment_used_[i];) {
+      SharedMemory::StatBlock* block =
+          reinterpret_cast<SharedMemory::StatBlock*>(segments_[i] + offset);
+      Stats::RawStatData* data = reinterpret_cast<Stats::RawStatData*>(block + 1);
+      if (data->initialized() && data->matches(name)) {
+        data->ref_count_++;
+        return data;
+      }
+      offset += block->size_;
     }
   }
 
-  if (unused != nullptr) {
-    unused->initialize(name);
-    return unused;
+  uint64_t ref;
+  SharedMemory::StatBlock* block = allocBlock(SharedMemory::blockSize(name), ref);
+  if (block == nullptr) {
+    return nullptr;
   }
 
-  return nullptr;
+  Stats::RawStatData* data = reinterpret_cast<Stats::RawStatData*>(block + 1);
+  data->initialize(name);
+  return data;
+}
+
+uint64_t HotRestartImpl::nameHash(const char* name, size_t length) {
+  return HashUtil::xxHash64(name, length);
+}
+
+uint64_t& HotRestartImpl::indexSlot(const std::string& name, uint64_t hash) {
+  uint64_t* index = shmem_.index();
+  const uint64_t mask = shmem_.index_size_ - 1;
+  uint64_t* freed = nullptr;
+  for (uint64_t probe = 0; probe < shmem_.index_size_; probe++) {
+    uint64_t& slot = index[(hash + probe) & mask];
+    if (slot == SharedMemory::EMPTY_SLOT) {
+      return freed != nullptr ? *freed : slot;
+    }
+
+    if (slot == SharedMemory::FREED_SLOT) {
+      if (freed == nullptr) {
+        freed = &slot;
+      }
+    } else if (statData(slot).matches(name)) {
+      return slot;
+    }
+  }
+
+  // The index is never full of references, so a freed slot was seen.
+  ASSERT(freed != nullptr);
+  return *freed;
+}
+
+void HotRestartImpl::rebuildIndex() {
+  uint64_t* index = shmem_.index();
+  const uint64_t mask = shmem_.index_size_ - 1;
+  std::fill(index, index + shmem_.index_size_, SharedMemory::EMPTY_SLOT);
+  shmem_.index_used_ = 0;
+  for (uint64_t i = 0; i < segments_.size(); i++) {
+    for (uint64_t offset = 0; offset < shmem_.segment_used_[i];) {
+      SharedMemory::StatBlock* block =
+          reinterpret_cast<SharedMemory::StatBlock*>(segments_[i] + offset);
+      Stats::RawStatData* data = reinterpret_cast<Stats::RawStatData*>(block + 1);
+      if (data->initialized() && shmem_.index_used_ < shmem_.index_size_) {
+        uint64_t slot = nameHash(data->name_, strlen(data->name_)) & mask;
+        while (index[slot] != SharedMemory::EMPTY_SLOT) {
+          slot = (slot + 1) & mask;
+        }
+        index[slot] = ((i + 1) << SharedMemory::SEGMENT_SHIFT) | offset;
+        shmem_.index_used_++;
+      }
+      offset += block->size_;
+    }
+  }
 }
 
 void HotRestartImpl::free(Stats::RawStatData& data) {
@@ -157,7 +295,119 @@ void HotRestartImpl::free(Stats::RawStatData& data) {
     return;
   }
 
-  memset(&data, 0, Stats::RawStatData::size());
+  // Find the block's reference so it can be put on a free list that other processes can follow.
+  uint8_t* address = reinterpret_cast<uint8_t*>(&data) - sizeof(SharedMemory::StatBlock);
+  uint64_t ref = 0;
+  for (uint64_t i = 0; i < segments_.size(); i++) {
+    if (address >= segments_[i] && address < segments_[i] + shmem_.segment_sizes_[i]) {
+      ref = ((i + 1) << SharedMemory::SEGMENT_SHIFT) | (address - segments_[i]);
+      break;
+    }
+  }
+  ASSERT(ref != 0);
+
+  if (!shmem_.index_overflow_) {
+    uint64_t* index = shmem_.index();
+    const uint64_t mask = shmem_.index_size_ - 1;
+    uint64_t slot = nameHash(data.name_, strlen(data.name_)) & mask;
+    while (index[slot] != ref) {
+      ASSERT(index[slot] != SharedMemory::EMPTY_SLOT);
+      slot = (slot + 1) & mask;
+    }
+    index[slot] = SharedMemory::FREED_SLOT;
+  }
+
+  SharedMemory::StatBlock& freed = block(ref);
+  memset(&data, 0, freed.size_ - sizeof(SharedMemory::StatBlock));
+  uint64_t& head = shmem_.free_lists_[SharedMemory::freeListIndex(freed.size_)];
+  freed.next_free_ = head;
+  head = ref;
+}
+
+void HotRestartImpl::mapSegments() {
+  Api::OsSysCalls& os_sys_calls = Api::OsSysCallsSingleton::get();
+  while (segments_.size() < shmem_.num_segments_) {
+    const std::string name = SharedMemory::segmentName(options_.baseId(), segments_.size());
+    int fd = os_sys_calls.shmOpen(name.c_str(), O_RDWR, S_IRUSR | S_IWUSR);
+    RELEASE_ASSERT(fd != -1);
+    void* segment = os_sys_calls.mmap(nullptr, shmem_.segment_sizes_[segments_.size()],
+                                      PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    RELEASE_ASSERT(segment != MAP_FAILED);
+    os_sys_calls.close(fd);
+    segments_.push_back(static_cast<uint8_t*>(segment));
+  }
+}
+
+bool HotRestartImpl::createSegment(uint64_t min_size) {
+  if (shmem_.num_segments_ == SharedMemory::MAX_SEGMENTS) {
+    return false;
+  }
+
+  Api::OsSysCalls& os_sys_calls = Api::OsSysCallsSingleton::get();
+  const uint64_t size =
+      std::max(2 * shmem_.segment_sizes_[shmem_.num_segments_ - 1], min_size);
+  const std::string name = SharedMemory::segmentName(options_.baseId(), shmem_.num_segments_);
+  int fd = os_sys_calls.shmOpen(name.c_str(), O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+  if (fd == -1) {
+    ENVOY_LOG(warn, "cannot create shared memory region {} for stats", name);
+    return false;
+  }
+
+  void* segment = MAP_FAILED;
+  if (os_sys_calls.ftruncate(fd, size) != -1) {
+    segment = os_sys_calls.mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  os_sys_calls.close(fd);
+  if (segment == MAP_FAILED) {
+    ENVOY_LOG(warn, "cannot map shared memory region {} of {} bytes for stats", name, size);
+    os_sys_calls.shmUnlink(name.c_str());
+    return false;
+  }
+
+  // Only publish the segment once it is mapped, so that other processes can always map it.
+  segments_.push_back(static_cast<uint8_t*>(segment));
+  shmem_.segment_sizes_[shmem_.num_segments_] = size;
+  shmem_.num_segments_++;
+  return true;
+}
+
+SharedMemory::StatBlock& HotRestartImpl::block(uint64_t ref) {
+  const uint64_t segment = (ref >> SharedMemory::SEGMENT_SHIFT) - 1;
+  const uint64_t offset = ref & ((1UL << SharedMemory::SEGMENT_SHIFT) - 1);
+  ASSERT(segment < segments_.size());
+  return *reinterpret_cast<SharedMemory::StatBlock*>(segments_[segment] + offset);
+}
+
+SharedMemory::StatBlock* HotRestartImpl::allocBlock(uint64_t block_size, uint64_t& ref) {
+  // Blocks of an exact size class can be reused directly. The last list holds blocks of mixed
+  // sizes and takes the first one that is large enough.
+  const uint64_t index = SharedMemory::freeListIndex(block_size);
+  for (uint64_t* free_ref = &shmem_.free_lists_[index]; *free_ref != 0;
+       free_ref = &block(*free_ref).next_free_) {
+    SharedMemory::StatBlock& free_block = block(*free_ref);
+    if (free_block.size_ >= block_size) {
+      ref = *free_ref;
+      *free_ref = free_block.next_free_;
+      free_block.next_free_ = 0;
+      return &free_block;
+    }
+  }
+
+  uint64_t last = shmem_.num_segments_ - 1;
+  if (shmem_.segment_used_[last] + block_size > shmem_.segment_sizes_[last]) {
+    if (!createSegment(block_size)) {
+      return nullptr;
+    }
+    last++;
+  }
+
+  SharedMemory::StatBlock* new_block =
+      reinterpret_cast<SharedMemory::StatBlock*>(segments_[last] + shmem_.segment_used_[last]);
+  new_block->size_ = block_size;
+  new_block->next_free_ = 0;
+  ref = ((last + 1) << SharedMemory::SEGMENT_SHIFT) | shmem_.segment_used_[last];
+  shmem_.segment_used_[last] += block_size;
+  return new_block;
 }
 
 int HotRestartImpl::bindDomainSocket(uint64_t id) {
@@ -207,7 +457,8 @@ void HotRestartImpl::drainParentListeners() {
   shmem_.flags_ &= ~SharedMemory::Flags::INITIALIZING;
 }
 
-int HotRestartImpl::duplicateParentListenSocket(const std::string& address) {
+int HotRestartImpl::duplicateParentListenSocket(const std::string& address,
+                                                uint32_t worker_index) {
   if (options_.restartEpoch() == 0 || parent_terminated_) {
     return -1;
   }
@@ -215,6 +466,7 @@ int HotRestartImpl::duplicateParentListenSocket(const std::string& address) {
   RpcGetListenSocketRequest rpc;
   ASSERT(address.length() < sizeof(rpc.address_));
   StringUtil::strlcpy(rpc.address_, address.c_str(), sizeof(rpc.address_));
+  rpc.worker_index_ = worker_index;
   sendMessage(parent_address_, rpc);
   RpcGetListenSocketReply* reply =
       receiveTypedRpc<RpcGetListenSocketReply, RpcMessageType::GetListenSocketReply>();
@@ -253,6 +505,73 @@ void HotRestartImpl::getParentStats(GetParentStatsInfo& info) {
   info.num_connections_ = reply->num_connections_;
 }
 
+void HotRestartImpl::getParentDnsResults(std::vector<Network::DnsResult>& results) {
+  // See large comment in getParentStats() on why this operation is locked.
+  std::unique_lock<Thread::BasicLockable> lock(init_lock_);
+  if (options_.restartEpoch() == 0 || parent_terminated_) {
+    return;
+  }
+
+  RpcGetDnsResultsRequest rpc;
+  while (true) {
+    sendMessage(parent_address_, rpc);
+    RpcBase* base_message = receiveRpc(true);
+    // A parent that predates this request cannot hand over its results, which are only a hint.
+    if (base_message->type_ == RpcMessageType::UnknownRequestReply) {
+      return;
+    }
+
+    RELEASE_ASSERT(base_message->length_ == sizeof(RpcGetDnsResultsReply));
+    RELEASE_ASSERT(base_message->type_ == RpcMessageType::GetDnsResultsReply);
+    RpcGetDnsResultsReply* reply = reinterpret_cast<RpcGetDnsResultsReply*>(base_message);
+    decodeDnsResults(reply->results_, strnlen(reply->results_, sizeof(reply->results_)),
+                     results);
+    if (!reply->more_ || reply->next_index_ <= rpc.start_index_) {
+      return;
+    }
+    rpc.start_index_ = reply->next_index_;
+  }
+}
+
+size_t HotRestartImpl::encodeDnsResults(const std::vector<Network::DnsResult>& results,
+                                        size_t start_index, char* buffer, size_t length) {
+  // Leave room for the terminating null.
+  ASSERT(length > 0);
+  const size_t capacity = length - 1;
+  size_t used = 0;
+  size_t index = start_index;
+  for (; index < results.size(); index++) {
+    const Network::DnsResult& result = results[index];
+    const std::string line =
+        fmt::format("{} {} {}\n", result.dns_name_, static_cast<int>(result.dns_lookup_family_),
+                    StringUtil::join(result.addresses_, ","));
+    if (used + line.size() > capacity) {
+      if (used == 0) {
+        continue;
+      }
+      break;
+    }
+    memcpy(buffer + used, line.data(), line.size());
+    used += line.size();
+  }
+  buffer[used] = 0;
+  return index;
+}
+
+void HotRestartImpl::decodeDnsResults(const char* buffer, size_t length,
+                                      std::vector<Network::DnsResult>& results) {
+  for (const std::string& line : StringUtil::split(std::string(buffer, length), '\n')) {
+    const std::vector<std::string> fields = StringUtil::split(line, ' ');
+    uint64_t family;
+    if (fields.size() != 3 || !StringUtil::atoul(fields[1].c_str(), family) ||
+        family > static_cast<uint64_t>(Network::DnsLookupFamily::Auto)) {
+      continue;
+    }
+    results.push_back({fields[0], static_cast<Network::DnsLookupFamily>(family),
+                       StringUtil::split(fields[2], ',')});
+  }
+}
+
 void HotRestartImpl::initialize(Event::Dispatcher& dispatcher, Server::Instance& server) {
   socket_event_ =
       dispatcher.createFileEvent(my_domain_socket_,
@@ -349,7 +668,13 @@ void HotRestartImpl::onGetListenSocket(RpcGetListenSocketRequest& rpc) {
       Network::Utility::resolveUrl(std::string(rpc.address_));
   for (const auto& listener : server_->listenerManager().listeners()) {
     if (*listener.get().socket().localAddress() == *addr) {
-      reply.fd_ = listener.get().socket().fd();
+      // A listener with a socket per worker only hands out the requested worker's socket. If the
+      // child has more workers, it binds new SO_REUSEPORT sockets for the rest.
+      if (listener.get().numSockets() == 1) {
+        reply.fd_ = listener.get().socket().fd();
+      } else if (rpc.worker_index_ < listener.get().numSockets()) {
+        reply.fd_ = listener.get().workerSocket(rpc.worker_index_).fd();
+      }
       break;
     }
   }
@@ -419,6 +744,18 @@ void HotRestartImpl::onSocketEvent() {
       break;
     }
 
+    case RpcMessageType::GetDnsResultsRequest: {
+      RpcGetDnsResultsRequest* message = reinterpret_cast<RpcGetDnsResultsRequest*>(base_message);
+      std::vector<Network::DnsResult> results;
+      server_->getDnsResults(results);
+      RpcGetDnsResultsReply rpc;
+      rpc.next_index_ = encodeDnsResults(results, message->start_index_, rpc.results_,
+                                         sizeof(rpc.results_));
+      rpc.more_ = rpc.next_index_ < results.size();
+      sendMessage(child_address_, rpc);
+      break;
+    }
+
     case RpcMessageType::DrainListenersRequest: {
       server_->drainListeners();
       break;
@@ -7,6 +7,7 @@
 #include <atomic>
 #include <cstdint>
 #include <string>
+#include <vector>
 
 #include "envoy/server/hot_restart.h"
 #include "envoy/server/options.h"
@@ -20,6 +21,16 @@ namespace Server {
 /**
  * Shared memory segment. This structure is laid directly into shared memory and is used amongst
  * all running envoy processes.
+ *
+ * Stats live in a chain of segments so that the stat area can grow after startup. Segment 0 is
+ * stats_slots_ and is sized for --max-stats stats of the maximum name length. Once it fills up,
+ * further segments of twice the previous size are created as separate shared memory objects, which
+ * every process maps on demand. Each stat is stored in a block that is only as large as its name
+ * needs; freed blocks are kept on free lists by size and reused.
+ *
+ * Stats are found by name through an open addressing hash table of block references that follows
+ * segment 0, with twice as many slots as --max-stats. If the table fills up, which needs half as
+ * many stats again, allocation falls back to scanning the segments.
  */
 class SharedMemory {
 public:
@@ -32,6 +43,16 @@ private:
     static const uint64_t INITIALIZING = 0x1;
   };
 
+  /**
+   * Header of each stat block, followed by a Stats::RawStatData.
+   */
+  struct StatBlock {
+    // Size of the block including this header.
+    uint64_t size_;
+    // Reference to the next block on the same free list, or 0.
+    uint64_t next_free_;
+  };
+
   // Due to the flexible-array-length of stats_slots_, c-style allocation
   // and initialization are neccessary.
   SharedMemory() = delete;
@@ -48,7 +69,40 @@ private:
    */
   void initializeMutex(pthread_mutex_t& mutex);
 
+  /**
+   * @return the name of the shared memory object backing stat segment index, which must be > 0.
+   */
+  static std::string segmentName(uint64_t base_id, uint64_t index);
+
+  /**
+   * @return the size of the block needed for a stat with the given name.
+   */
+  static uint64_t blockSize(const std::string& name);
+
+  /**
+   * @return the free list holding blocks of size block_size.
+   */
+  static uint64_t freeListIndex(uint64_t block_size);
+
+  /**
+   * @return the number of slots of the stat index for max_num_stats stats.
+   */
+  static uint64_t indexSize(uint64_t max_num_stats);
+
+  /**
+   * @return the slots of the stat index.
+   */
+  uint64_t* index() { return reinterpret_cast<uint64_t*>(stats_slots_ + segment_sizes_[0]); }
+
   static const uint64_t VERSION;
+  static const uint64_t MAX_SEGMENTS = 32;
+  // Blocks are a multiple of the RawStatData alignment, so exact size classes cover blocks of up to
+  // (NUM_FREE_LISTS - 1) * alignof(Stats::RawStatData) bytes. The last list holds anything larger.
+  static const uint64_t NUM_FREE_LISTS = 64;
+  static const uint64_t SEGMENT_SHIFT = 40;
+  // Stat index slots that hold no reference. Block references are never this small.
+  static const uint64_t EMPTY_SLOT = 0;
+  static const uint64_t FREED_SLOT = 1;
 
   uint64_t size_;
   uint64_t version_;
@@ -59,9 +113,22 @@ private:
   pthread_mutex_t access_log_lock_;
   pthread_mutex_t stat_lock_;
   pthread_mutex_t init_lock_;
+  // The stat segments, protected by stat_lock_. Blocks are referenced across processes as
+  // ((segment + 1) << SEGMENT_SHIFT) | offset since every process maps segments at different
+  // addresses.
+  uint64_t num_segments_;
+  uint64_t segment_sizes_[MAX_SEGMENTS];
+  uint64_t segment_used_[MAX_SEGMENTS];
+  uint64_t free_lists_[NUM_FREE_LISTS];
+  // The stat index, protected by stat_lock_. index_used_ counts the slots that are not empty,
+  // including freed ones. Once the index overflows it is no longer maintained.
+  uint64_t index_size_;
+  uint64_t index_used_;
+  uint64_t index_overflow_;
   alignas(Stats::RawStatData) uint8_t
-      stats_slots_[]; // array of Stats::RawStatData, which has a flexible-array-length member
-                      // so non-fixed size
+      stats_slots_[]; // stat segment 0, a sequence of StatBlock headers each followed by a
+                      // Stats::RawStatData, which has a flexible-array-length member so non-fixed
+                      // size, and then the index_size_ slots of the stat index
 
   friend class HotRestartImpl;
 };
@@ -122,8 +189,9 @@ public:
 
   // Server::HotRestart
   void drainParentListeners() override;
-  int duplicateParentListenSocket(const std::string& address) override;
+  int duplicateParentListenSocket(const std::string& address, uint32_t worker_index) override;
   void getParentStats(GetParentStatsInfo& info) override;
+  void getParentDnsResults(std::vector<Network::DnsResult>& results) override;
   void initialize(Event::Dispatcher& dispatcher, Server::Instance& server) override;
   void shutdownParentAdmin(ShutdownParentAdminInfo& info) override;
   void terminateParent() override;
@@ -134,6 +202,21 @@ public:
   Stats::RawStatData* alloc(const std::string& name) override;
   void free(Stats::RawStatData& data) override;
 
+  /**
+   * Write results, starting at start_index, into buffer as lines of
+   * "<name> <lookup family> <address>,<address>,..." for as long as they fit. A result that does
+   * not fit into an empty buffer is skipped.
+   * @return size_t the index of the first result that was not written.
+   */
+  static size_t encodeDnsResults(const std::vector<Network::DnsResult>& results,
+                                 size_t start_index, char* buffer, size_t length);
+
+  /**
+   * Append the results that encodeDnsResults() wrote into buffer to results.
+   */
+  static void decodeDnsResults(const char* buffer, size_t length,
+                               std::vector<Network::DnsResult>& results);
+
 private:
   enum class RpcMessageType {
     DrainListenersRequest = 1,
@@ -144,7 +227,9 @@ private:
     TerminateRequest = 6,
     UnknownRequestReply = 7,
     GetStatsRequest = 8,
-    GetStatsReply = 9
+    GetStatsReply = 9,
+    GetDnsResultsRequest = 10,
+    GetDnsResultsReply = 11
   };
 
   struct RpcBase {
@@ -159,6 +244,7 @@ private:
     RpcGetListenSocketRequest() : RpcBase(RpcMessageType::GetListenSocketRequest, sizeof(*this)) {}
 
     char address_[256]{0};
+    uint32_t worker_index_{0};
   } __attribute__((packed));
 
   struct RpcGetListenSocketReply : public RpcBase {
@@ -181,6 +267,22 @@ private:
     uint64_t unused_[16]{0};
   } __attribute__((packed));
 
+  struct RpcGetDnsResultsRequest : public RpcBase {
+    RpcGetDnsResultsRequest() : RpcBase(RpcMessageType::GetDnsResultsRequest, sizeof(*this)) {}
+
+    uint64_t start_index_{0};
+  } __attribute__((packed));
+
+  // The results do not need to fit into a single reply, so the child asks for the rest starting at
+  // next_index_ while more_ is set.
+  struct RpcGetDnsResultsReply : public RpcBase {
+    RpcGetDnsResultsReply() : RpcBase(RpcMessageType::GetDnsResultsReply, sizeof(*this)) {}
+
+    uint64_t next_index_{0};
+    uint8_t more_{0};
+    char results_[3968]{0};
+  } __attribute__((packed));
+
   template <class rpc_class, RpcMessageType rpc_type> rpc_class* receiveTypedRpc() {
     RpcBase* base_message = receiveRpc(true);
     RELEASE_ASSERT(base_message->length_ == sizeof(rpc_class));
@@ -188,6 +290,62 @@ private:
     return reinterpret_cast<rpc_class*>(base_message);
   }
 
+  /**
+   * Map any stat segments that another process created since we last looked. Must be called with
+   * stat_lock_ held.
+   */
+  void mapSegments();
+
+  /**
+   * Create and map a new stat segment large enough for a block of min_size. Must be called with
+   * stat_lock_ held.
+   * @return false if the segment could not be created.
+   */
+  bool createSegment(uint64_t min_size);
+
+  /**
+   * @return the block referenced by ref, which must be in a mapped segment.
+   */
+  SharedMemory::StatBlock& block(uint64_t ref);
+
+  /**
+   * @return the stat stored in the block referenced by ref.
+   */
+  Stats::RawStatData& statData(uint64_t ref) {
+    return *reinterpret_cast<Stats::RawStatData*>(&block(ref) + 1);
+  }
+
+  /**
+   * Take a block of block_size bytes from the free lists or the end of the last segment, growing
+   * the stat area if needed. Must be called with stat_lock_ held.
+   * @param ref supplies where to store the reference of the block.
+   * @return the block or nullptr if no memory is available.
+   */
+  SharedMemory::StatBlock* allocBlock(uint64_t block_size, uint64_t& ref);
+
+  /**
+   * Find a stat by scanning every block, and allocate it if it does not exist. Used once the stat
+   * index has overflowed. Must be called with stat_lock_ held.
+   */
+  Stats::RawStatData* allocUnindexed(const std::string& name);
+
+  /**
+   * @return the hash of a stat name for the stat index, over the name as it is stored.
+   */
+  static uint64_t nameHash(const char* name, size_t length);
+
+  /**
+   * Look a stat up in the index. Must be called with stat_lock_ held.
+   * @return the slot that holds the stat, or else the slot a new stat with this name should use.
+   */
+  uint64_t& indexSlot(const std::string& name, uint64_t hash);
+
+  /**
+   * Rebuild the index from the stats in the segments, which drops freed slots. Must be called with
+   * stat_lock_ held.
+   */
+  void rebuildIndex();
+
   int bindDomainSocket(uint64_t id);
   void initDomainSocketAddress(sockaddr_un* address);
   sockaddr_un createDomainSocketAddress(uint64_t id);
@@ -202,6 +360,8 @@ private:
   ProcessSharedMutex access_log_lock_;
   ProcessSharedMutex stat_lock_;
   ProcessSharedMutex init_lock_;
+  // Base addresses of the stat segments this process has mapped, indexed by segment.
+  std::vector<uint8_t*> segments_;
   int my_domain_socket_{-1};
   sockaddr_un parent_address_;
   sockaddr_un child_address_;
@@ -1,10 +1,16 @@
 #include "server/http/admin.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <fstream>
+#include <map>
 #include <string>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
+#include "envoy/common/exception.h"
+#include "envoy/event/dispatcher.h"
 #include "envoy/filesystem/filesystem.h"
 #include "envoy/server/hot_restart.h"
 #include "envoy/server/instance.h"
@@ -18,6 +24,7 @@
 #include "common/buffer/buffer_impl.h"
 #include "common/common/assert.h"
 #include "common/common/enum_to_int.h"
+#include "common/common/regex.h"
 #include "common/common/utility.h"
 #include "common/common/version.h"
 #include "common/http/codes.h"
@@ -27,6 +34,7 @@
 #include "common/json/json_loader.h"
 #include "common/network/listen_socket_impl.h"
 #include "common/profiler/profiler.h"
+#include "common/profiler/sampling_profiler.h"
 #include "common/router/config_impl.h"
 #include "common/upstream/host_utility.h"
 
@@ -40,6 +48,7 @@
 #include "rapidjson/schema.h"
 #include "rapidjson/stream.h"
 #include "rapidjson/stringbuffer.h"
+#include "rapidjson/writer.h"
 #include "spdlog/spdlog.h"
 
 using namespace rapidjson;
@@ -47,6 +56,9 @@ using namespace rapidjson;
 namespace Envoy {
 namespace Server {
 
+#define MAKE_SNAPSHOT_HANDLER(X)                                                                   \
+  [this](const std::string& url) -> AdminImpl::RenderCb { return X(url); }
+
 AdminFilter::AdminFilter(AdminImpl& parent) : parent_(parent) {}
 
 Http::FilterHeadersStatus AdminFilter::decodeHeaders(Http::HeaderMap& headers, bool end_stream) {
@@ -142,59 +154,187 @@ void AdminImpl::addCircuitSettings(const std::string& cluster_name, const std::s
                            resource_manager.retries().max()));
 }
 
-Http::Code AdminImpl::handlerClusters(const std::string&, Buffer::Instance& response) {
-  response.add(fmt::format("version_info::{}\n", server_.clusterManager().versionInfo()));
+std::map<std::string, uint64_t> AdminImpl::hostStats(const Upstream::Host& host) {
+  std::map<std::string, uint64_t> all_stats;
+  for (const Stats::CounterSharedPtr& counter : host.counters()) {
+    all_stats[counter->name()] = counter->value();
+  }
 
-  for (auto& cluster : server_.clusterManager().clusters()) {
-    addOutlierInfo(cluster.second.get().info()->name(), cluster.second.get().outlierDetector(),
-                   response);
-
-    addCircuitSettings(
-        cluster.second.get().info()->name(), "default",
-        cluster.second.get().info()->resourceManager(Upstream::ResourcePriority::Default),
-        response);
-    addCircuitSettings(
-        cluster.second.get().info()->name(), "high",
-        cluster.second.get().info()->resourceManager(Upstream::ResourcePriority::High), response);
-
-    response.add(fmt::format("{}::added_via_api::{}\n", cluster.second.get().info()->name(),
-                             cluster.second.get().info()->addedViaApi()));
-    for (auto& host_set : cluster.second.get().prioritySet().hostSetsPerPriority()) {
-      for (auto& host : host_set->hosts()) {
-        std::map<std::string, uint64_t> all_stats;
-        for (const Stats::CounterSharedPtr& counter : host->counters()) {
-          all_stats[counter->name()] = counter->value();
-        }
+  for (const Stats::GaugeSharedPtr& gauge : host.gauges()) {
+    all_stats[gauge->name()] = gauge->value();
+  }
+  return all_stats;
+}
 
-        for (const Stats::GaugeSharedPtr& gauge : host->gauges()) {
-          all_stats[gauge->name()] = gauge->value();
-        }
+void AdminImpl::addClusterText(const Upstream::Cluster& cluster, const std::string* host_filter,
+                               Buffer::Instance& response) {
+  const std::string& name = cluster.info()->name();
+  addOutlierInfo(name, cluster.outlierDetector(), response);
+
+  addCircuitSettings(name, "default",
+                     cluster.info()->resourceManager(Upstream::ResourcePriority::Default),
+                     response);
+  addCircuitSettings(name, "high",
+                     cluster.info()->resourceManager(Upstream::ResourcePriority::High), response);
+
+  response.add(fmt::format("{}::added_via_api::{}\n", name, cluster.info()->addedViaApi()));
+  for (auto& host_set : cluster.prioritySet().hostSetsPerPriority()) {
+    for (auto& host : host_set->hosts()) {
+      const std::string address = host->address()->asString();
+      if (host_filter != nullptr && address != *host_filter) {
+        continue;
+      }
 
-        for (auto stat : all_stats) {
-          response.add(fmt::format("{}::{}::{}::{}\n", cluster.second.get().info()->name(),
-                                   host->address()->asString(), stat.first, stat.second));
-        }
+      for (auto stat : hostStats(*host)) {
+        response.add(fmt::format("{}::{}::{}::{}\n", name, address, stat.first, stat.second));
+      }
+
+      response.add(fmt::format("{}::{}::health_flags::{}\n", name, address,
+                               Upstream::HostUtility::healthFlagsToString(*host)));
+      response.add(fmt::format("{}::{}::weight::{}\n", name, address, host->weight()));
+      response.add(fmt::format("{}::{}::region::{}\n", name, address, host->locality().region()));
+      response.add(fmt::format("{}::{}::zone::{}\n", name, address, host->locality().zone()));
+      response.add(
+          fmt::format("{}::{}::sub_zone::{}\n", name, address, host->locality().sub_zone()));
+      response.add(fmt::format("{}::{}::canary::{}\n", name, address, host->canary()));
+      response.add(fmt::format("{}::{}::success_rate::{}\n", name, address,
+                               host->outlierDetector().successRate()));
+    }
+  }
+}
 
-        response.add(fmt::format("{}::{}::health_flags::{}\n", cluster.second.get().info()->name(),
-                                 host->address()->asString(),
-                                 Upstream::HostUtility::healthFlagsToString(*host)));
-        response.add(fmt::format("{}::{}::weight::{}\n", cluster.second.get().info()->name(),
-                                 host->address()->asString(), host->weight()));
-        response.add(fmt::format("{}::{}::region::{}\n", cluster.second.get().info()->name(),
-                                 host->address()->asString(), host->locality().region()));
-        response.add(fmt::format("{}::{}::zone::{}\n", cluster.second.get().info()->name(),
-                                 host->address()->asString(), host->locality().zone()));
-        response.add(fmt::format("{}::{}::sub_zone::{}\n", cluster.second.get().info()->name(),
-                                 host->address()->asString(), host->locality().sub_zone()));
-        response.add(fmt::format("{}::{}::canary::{}\n", cluster.second.get().info()->name(),
-                                 host->address()->asString(), host->canary()));
-        response.add(fmt::format("{}::{}::success_rate::{}\n", cluster.second.get().info()->name(),
-                                 host->address()->asString(),
-                                 host->outlierDetector().successRate()));
+void AdminImpl::addClusterJson(const Upstream::Cluster& cluster, const std::string* host_filter,
+                               Buffer::Instance& response) {
+  // Each cluster is written as a separate JSON value and moved into the response, so that the
+  // output never needs one contiguous document as large as the whole response.
+  rapidjson::StringBuffer strbuf;
+  rapidjson::Writer<rapidjson::StringBuffer> writer(strbuf);
+  writer.StartObject();
+  writer.Key("name");
+  writer.String(cluster.info()->name().c_str());
+  writer.Key("added_via_api");
+  writer.Bool(cluster.info()->addedViaApi());
+
+  if (cluster.outlierDetector() != nullptr) {
+    writer.Key("outlier");
+    writer.StartObject();
+    writer.Key("success_rate_average");
+    writer.Double(cluster.outlierDetector()->successRateAverage());
+    writer.Key("success_rate_ejection_threshold");
+    writer.Double(cluster.outlierDetector()->successRateEjectionThreshold());
+    writer.EndObject();
+  }
+
+  writer.Key("circuit_breakers");
+  writer.StartObject();
+  for (const auto priority : {std::make_pair("default", Upstream::ResourcePriority::Default),
+                              std::make_pair("high", Upstream::ResourcePriority::High)}) {
+    Upstream::ResourceManager& resource_manager = cluster.info()->resourceManager(priority.second);
+    writer.Key(priority.first);
+    writer.StartObject();
+    writer.Key("max_connections");
+    writer.Uint64(resource_manager.connections().max());
+    writer.Key("max_pending_requests");
+    writer.Uint64(resource_manager.pendingRequests().max());
+    writer.Key("max_requests");
+    writer.Uint64(resource_manager.requests().max());
+    writer.Key("max_retries");
+    writer.Uint64(resource_manager.retries().max());
+    writer.EndObject();
+  }
+  writer.EndObject();
+
+  writer.Key("hosts");
+  writer.StartArray();
+  for (auto& host_set : cluster.prioritySet().hostSetsPerPriority()) {
+    for (auto& host : host_set->hosts()) {
+      const std::string address = host->address()->asString();
+      if (host_filter != nullptr && address != *host_filter) {
+        continue;
+      }
+
+      writer.StartObject();
+      writer.Key("address");
+      writer.String(address.c_str());
+      writer.Key("stats");
+      writer.StartObject();
+      for (auto stat : hostStats(*host)) {
+        writer.Key(stat.first.c_str());
+        writer.Uint64(stat.second);
       }
+      writer.EndObject();
+      writer.Key("health_flags");
+      writer.String(Upstream::HostUtility::healthFlagsToString(*host).c_str());
+      writer.Key("weight");
+      writer.Uint(host->weight());
+      writer.Key("region");
+      writer.String(host->locality().region().c_str());
+      writer.Key("zone");
+      writer.String(host->locality().zone().c_str());
+      writer.Key("sub_zone");
+      writer.String(host->locality().sub_zone().c_str());
+      writer.Key("canary");
+      writer.Bool(host->canary());
+      writer.Key("success_rate");
+      writer.Double(host->outlierDetector().successRate());
+      writer.EndObject();
     }
   }
+  writer.EndArray();
+  writer.EndObject();
+  response.add(strbuf.GetString(), strbuf.GetSize());
+}
 
+Http::Code AdminImpl::handlerClusters(const std::string& url, Buffer::Instance& response) {
+  const Http::Utility::QueryParams params = Http::Utility::parseQueryString(url);
+  const auto format_param = params.find("format");
+  const bool json = format_param != params.end() && format_param->second == "json";
+  if (format_param != params.end() && !json) {
+    response.add("usage: /clusters?format=json&cluster=<name>&host=<address>\n");
+    return Http::Code::BadRequest;
+  }
+  const auto host_param = params.find("host");
+  const std::string* host_filter = host_param != params.end() ? &host_param->second : nullptr;
+
+  // A single cluster is looked up rather than filtered from all of them, so that tooling can
+  // cheaply query one cluster of a large config.
+  const Upstream::ClusterManager::ClusterInfoMap all_clusters = server_.clusterManager().clusters();
+  std::vector<std::reference_wrapper<const Upstream::Cluster>> clusters;
+  const auto cluster_param = params.find("cluster");
+  if (cluster_param != params.end()) {
+    const auto cluster = all_clusters.find(cluster_param->second);
+    if (cluster == all_clusters.end()) {
+      response.add(fmt::format("unknown cluster: {}\n", cluster_param->second));
+      return Http::Code::NotFound;
+    }
+    clusters.push_back(cluster->second);
+  } else {
+    for (auto& cluster : all_clusters) {
+      clusters.push_back(cluster.second);
+    }
+  }
+
+  if (!json) {
+    response.add(fmt::format("version_info::{}\n", server_.clusterManager().versionInfo()));
+    for (const Upstream::Cluster& cluster : clusters) {
+      addClusterText(cluster, host_filter, response);
+    }
+    return Http::Code::OK;
+  }
+
+  rapidjson::StringBuffer version_info;
+  rapidjson::Writer<rapidjson::StringBuffer> writer(version_info);
+  writer.String(server_.clusterManager().versionInfo().c_str());
+  response.add(fmt::format("{{\"version_info\":{},\"clusters\":[", version_info.GetString()));
+  bool first = true;
+  for (const Upstream::Cluster& cluster : clusters) {
+    if (!first) {
+      response.add(",");
+    }
+    first = false;
+    addClusterJson(cluster, host_filter, response);
+  }
+  response.add("]}\n");
   return Http::Code::OK;
 }
 
@@ -208,6 +348,10 @@ Http::Code AdminImpl::handlerCpuProfiler(const std::string& url, Buffer::Instanc
 
   bool enable = query_params.begin()->second == "y";
   if (enable && !Profiler::Cpu::profilerEnabled()) {
+    if (Profiler::Sampling::profilerEnabled()) {
+      response.add("the sampling profiler is running\n");
+      return Http::Code::BadRequest;
+    }
     if (!Profiler::Cpu::startProfiler(profile_path_)) {
       response.add("failure to start the profiler");
       return Http::Code::InternalServerError;
@@ -221,6 +365,64 @@ Http::Code AdminImpl::handlerCpuProfiler(const std::string& url, Buffer::Instanc
   return Http::Code::OK;
 }
 
+Http::Code AdminImpl::handlerHeapProfiler(const std::string& url, Buffer::Instance& response) {
+  Http::Utility::QueryParams query_params = Http::Utility::parseQueryString(url);
+  if (query_params.size() != 1 || query_params.begin()->first != "enable" ||
+      (query_params.begin()->second != "y" && query_params.begin()->second != "n" &&
+       query_params.begin()->second != "dump")) {
+    response.add("?enable=<y|n|dump>\n");
+    return Http::Code::BadRequest;
+  }
+
+  // Heap profiles are written next to the CPU profile, as <profile path>.<sequence>.heap.
+  const std::string& action = query_params.begin()->second;
+  if (action == "y" && !Profiler::Heap::profilerEnabled()) {
+    if (!Profiler::Heap::startProfiler(profile_path_)) {
+      response.add("failure to start the profiler");
+      return Http::Code::InternalServerError;
+    }
+  } else if (action == "dump") {
+    if (!Profiler::Heap::profilerEnabled()) {
+      response.add("the heap profiler is not running\n");
+      return Http::Code::BadRequest;
+    }
+    Profiler::Heap::dumpProfile("admin");
+  } else if (action == "n" && Profiler::Heap::profilerEnabled()) {
+    Profiler::Heap::dumpProfile("admin");
+    Profiler::Heap::stopProfiler();
+  }
+
+  response.add("OK\n");
+  return Http::Code::OK;
+}
+
+Http::Code AdminImpl::handlerProfile(const std::string& url, Buffer::Instance& response) {
+  Http::Utility::QueryParams query_params = Http::Utility::parseQueryString(url);
+  if (query_params.empty()) {
+    response.add(Profiler::Sampling::foldedStacks());
+    return Http::Code::OK;
+  }
+
+  if (query_params.size() != 1 || query_params.begin()->first != "enable" ||
+      (query_params.begin()->second != "y" && query_params.begin()->second != "n")) {
+    response.add("?enable=<y|n>\n");
+    return Http::Code::BadRequest;
+  }
+
+  bool enable = query_params.begin()->second == "y";
+  if (enable && !Profiler::Sampling::profilerEnabled()) {
+    if (!Profiler::Sampling::startProfiler(Profiler::Sampling::DEFAULT_FREQUENCY_HZ)) {
+      response.add("failure to start the profiler");
+      return Http::Code::InternalServerError;
+    }
+  } else if (!enable) {
+    Profiler::Sampling::stopProfiler();
+  }
+
+  response.add("OK\n");
+  return Http::Code::OK;
+}
+
 Http::Code AdminImpl::handlerHealthcheckFail(const std::string&, Buffer::Instance& response) {
   server_.failHealthcheck(true);
   response.add("OK\n");
@@ -263,10 +465,44 @@ Http::Code AdminImpl::handlerLogging(const std::string& url, Buffer::Instance& r
   return rc;
 }
 
-Http::Code AdminImpl::handlerResetCounters(const std::string&, Buffer::Instance& response) {
-  for (const Stats::CounterSharedPtr& counter : server_.stats().counters()) {
-    counter->reset();
+Http::Code AdminImpl::handlerFilterTimes(const std::string&, Buffer::Instance& response) {
+  // The total time and the number of sampled requests of each filter, keyed by the stat prefix
+  // of the filter, e.g. "http.ingress_http.filter.envoy.lua".
+  std::map<std::string, std::pair<uint64_t, uint64_t>> filters;
+  const std::string time_suffix = ".time_ns";
+  const std::string requests_suffix = ".rq_sampled";
+  server_.stats().forEachCounter([&](Stats::Counter& counter) {
+    const std::string name = counter.name();
+    if (name.find(".filter.") == std::string::npos) {
+      return;
+    }
+    if (StringUtil::endsWith(name, time_suffix)) {
+      filters[name.substr(0, name.size() - time_suffix.size())].first = counter.value();
+    } else if (StringUtil::endsWith(name, requests_suffix)) {
+      filters[name.substr(0, name.size() - requests_suffix.size())].second = counter.value();
+    }
+  });
+
+  // Rank by the average time per sampled request, in microseconds.
+  std::vector<std::pair<double, const std::string*>> ranked;
+  for (const auto& filter : filters) {
+    if (filter.second.second > 0) {
+      ranked.emplace_back(static_cast<double>(filter.second.first) / filter.second.second / 1000,
+                          &filter.first);
+    }
+  }
+  std::sort(ranked.begin(), ranked.end(),
+            [](const std::pair<double, const std::string*>& lhs,
+               const std::pair<double, const std::string*>& rhs) { return lhs.first > rhs.first; });
+  for (const auto& filter : ranked) {
+    response.add(fmt::format("{}: {:.1f}us per request, {} requests sampled\n", *filter.second,
+                             filter.first, filters[*filter.second].second));
   }
+  return Http::Code::OK;
+}
+
+Http::Code AdminImpl::handlerResetCounters(const std::string&, Buffer::Instance& response) {
+  server_.stats().forEachCounter([](Stats::Counter& counter) { counter.reset(); });
 
   response.add("OK\n");
   return Http::Code::OK;
@@ -279,42 +515,107 @@ Http::Code AdminImpl::handlerServerInfo(const std::string&, Buffer::Instance& re
                            current_time - server_.startTimeCurrentEpoch(),
                            current_time - server_.startTimeFirstEpoch(),
                            server_.options().restartEpoch()));
+  for (const auto& phase : server_.startupPhases()) {
+    response.add(fmt::format("startup {} {}ms\n", phase.first, phase.second.count()));
+  }
   return Http::Code::OK;
 }
 
-Http::Code AdminImpl::handlerStats(const std::string& url, Buffer::Instance& response) {
-  // We currently don't support timers locally (only via statsd) so just group all the counters
-  // and gauges together, alpha sort them, and spit them out.
-  Http::Code rc = Http::Code::OK;
+AdminImpl::RenderCb AdminImpl::snapshotStats(const std::string& url) {
   const Http::Utility::QueryParams params = Http::Utility::parseQueryString(url);
-  std::map<std::string, uint64_t> all_stats;
-  for (const Stats::CounterSharedPtr& counter : server_.stats().counters()) {
-    all_stats.emplace(counter->name(), counter->value());
+  const bool json = params.size() == 1 && params.begin()->first == "format" &&
+                    params.begin()->second == "json";
+  if (params.size() == 1 && params.begin()->first == "format" &&
+      params.begin()->second == "prometheus") {
+    // The store can be iterated from any thread, so nothing needs to be gathered up front.
+    const Stats::Store& store = server_.stats();
+    return [&store](Buffer::Instance& response) -> Http::Code {
+      AdminImpl::statsAsPrometheus(store, nullptr, response);
+      return Http::Code::OK;
+    };
+  }
+  if (params.size() > 0 && !json) {
+    return [](Buffer::Instance& response) -> Http::Code {
+      response.add("usage: /stats?format=json  or /stats?format=prometheus \n");
+      response.add("\n");
+      return Http::Code::NotFound;
+    };
+  }
+
+  // Group all the counters and gauges together. The lazy counters of clusters are only reachable
+  // through the cluster manager of the main thread, and histogram summaries are replaced at every
+  // stats flush, so the values are copied here and only sorted and formatted on the render thread.
+  auto all_stats = std::make_shared<std::vector<std::pair<std::string, uint64_t>>>();
+  server_.stats().forEachCounter([&all_stats](Stats::Counter& counter) {
+    all_stats->emplace_back(counter.name(), counter.value());
+  });
+  server_.stats().forEachGauge(
+      [&all_stats](Stats::Gauge& gauge) { all_stats->emplace_back(gauge.name(), gauge.value()); });
+  // Clusters may not have created all of their counters yet, list the rest as zero.
+  for (auto& cluster : server_.clusterManager().clusters()) {
+    cluster.second.get().info()->forEachLazyCounter([&all_stats](Stats::Counter& counter) {
+      all_stats->emplace_back(counter.name(), counter.value());
+    });
   }
 
-  for (const Stats::GaugeSharedPtr& gauge : server_.stats().gauges()) {
-    all_stats.emplace(gauge->name(), gauge->value());
+  auto all_histograms = std::make_shared<std::vector<std::pair<std::string, std::string>>>();
+  if (!json) {
+    server_.stats().forEachHistogram([&all_histograms](Stats::ParentHistogram& histogram) {
+      all_histograms->emplace_back(histogram.name(), histogram.summary());
+    });
   }
 
-  if (params.size() == 0) {
-    // No Arguments so use the standard.
-    for (auto stat : all_stats) {
+  return [all_stats, all_histograms, json](Buffer::Instance& response) -> Http::Code {
+    // Alpha sort the stats. A name that was gathered twice keeps its first value.
+    auto by_name = [](const std::pair<std::string, uint64_t>& lhs,
+                      const std::pair<std::string, uint64_t>& rhs) -> bool {
+      return lhs.first < rhs.first;
+    };
+    std::stable_sort(all_stats->begin(), all_stats->end(), by_name);
+    all_stats->erase(std::unique(all_stats->begin(), all_stats->end(),
+                                 [](const std::pair<std::string, uint64_t>& lhs,
+                                    const std::pair<std::string, uint64_t>& rhs) -> bool {
+                                   return lhs.first == rhs.first;
+                                 }),
+                     all_stats->end());
+    if (json) {
+      response.add(AdminImpl::statsAsJson(*all_stats));
+      return Http::Code::OK;
+    }
+
+    for (const auto& stat : *all_stats) {
       response.add(fmt::format("{}: {}\n", stat.first, stat.second));
     }
-  } else {
-    const std::string format_key = params.begin()->first;
-    const std::string format_value = params.begin()->second;
-    if (format_key == "format" && format_value == "json") {
-      response.add(AdminImpl::statsAsJson(all_stats));
-    } else if (format_key == "format" && format_value == "prometheus") {
-      AdminImpl::statsAsPrometheus(server_.stats().counters(), server_.stats().gauges(), response);
-    } else {
-      response.add("usage: /stats?format=json \n");
-      response.add("\n");
-      rc = Http::Code::NotFound;
+    // Histograms are listed after them with the quantiles computed at the last stats flush.
+    std::sort(all_histograms->begin(), all_histograms->end());
+    for (const auto& histogram : *all_histograms) {
+      response.add(fmt::format("{}: {}\n", histogram.first, histogram.second));
+    }
+    return Http::Code::OK;
+  };
+}
+
+AdminImpl::RenderCb AdminImpl::snapshotPrometheusStats(const std::string& url) {
+  const Http::Utility::QueryParams params = Http::Utility::parseQueryString(url);
+  std::shared_ptr<Regex::CompiledMatcher> filter;
+  const auto filter_param = params.find("filter");
+  if (filter_param != params.end()) {
+    try {
+      filter = Regex::Utility::parseRegex(filter_param->second);
+    } catch (const EnvoyException& e) {
+      const std::string error = e.what();
+      return [error](Buffer::Instance& response) -> Http::Code {
+        response.add(fmt::format("invalid filter regex: {}\n", error));
+        return Http::Code::BadRequest;
+      };
     }
   }
-  return rc;
+
+  const Stats::Store& store = server_.stats();
+  return [&store, filter](Buffer::Instance& response) -> Http::Code {
+    AdminImpl::statsAsPrometheus(store, filter.get(), response);
+    return Http::Code::OK;
+  };
 }
 
 std::string AdminImpl::sanitizePrometheusName(const std::string& name) {
@@ -338,25 +639,41 @@ std::string AdminImpl::prometheusMetricName(const std::string& extractedName) {
   return fmt::format("envoy_{0}", sanitizePrometheusName(extractedName));
 }
 
-void AdminImpl::statsAsPrometheus(const std::list<Stats::CounterSharedPtr>& counters,
-                                  const std::list<Stats::GaugeSharedPtr>& gauges,
+void AdminImpl::statsAsPrometheus(const Stats::Store& store, const Regex::CompiledMatcher* filter,
                                   Buffer::Instance& response) {
-  for (const auto& counter : counters) {
-    const std::string tags = formatTagsForPrometheus(counter->tags());
-    const std::string metric_name = prometheusMetricName(counter->tagExtractedName());
-    response.add(fmt::format("# TYPE {0} counter\n", metric_name));
-    response.add(fmt::format("{0}{{{1}}} {2}\n", metric_name, tags, counter->value()));
-  }
+  // Format into a bounded chunk that is moved into the response whenever it fills up, so that the
+  // output never needs one contiguous string as large as the whole response.
+  std::string chunk;
+  chunk.reserve(PROMETHEUS_CHUNK_SIZE);
+  auto add_metric = [filter, &chunk, &response](const Stats::Metric& metric, const char* type,
+                                                uint64_t value) {
+    const std::string name = metric.name();
+    if (filter != nullptr && !filter->match(name.c_str(), name.size())) {
+      return;
+    }
+
+    const std::string metric_name = prometheusMetricName(metric.tagExtractedName());
+    chunk.append(fmt::format("# TYPE {0} {1}\n", metric_name, type));
+    chunk.append(fmt::format("{0}{{{1}}} {2}\n", metric_name,
+                             formatTagsForPrometheus(metric.tags()), value));
+    if (chunk.size() >= PROMETHEUS_CHUNK_SIZE) {
+      response.add(chunk);
+      chunk.clear();
+    }
+  };
 
-  for (const auto& gauge : gauges) {
-    const std::string tags = formatTagsForPrometheus(gauge->tags());
-    const std::string metric_name = prometheusMetricName(gauge->tagExtractedName());
-    response.add(fmt::format("# TYPE {0} gauge\n", metric_name));
-    response.add(fmt::format("{0}{{{1}}} {2}\n", metric_name, tags, gauge->value()));
+  store.forEachCounter(
+      [&add_metric](Stats::Counter& counter) { add_metric(counter, "counter", counter.value()); });
+  store.forEachGauge(
+      [&add_metric](Stats::Gauge& gauge) { add_metric(gauge, "gauge", gauge.value()); });
+
+  if (!chunk.empty()) {
+    response.add(chunk);
   }
 }
 
-std::string AdminImpl::statsAsJson(const std::map<std::string, uint64_t>& all_stats) {
+std::string
+AdminImpl::statsAsJson(const std::vector<std::pair<std::string, uint64_t>>& all_stats) {
   rapidjson::Document document;
   document.SetObject();
   rapidjson::Value stats_array(rapidjson::kArrayType);
@@ -416,9 +733,16 @@ void AdminFilter::onComplete() {
   std::string path = request_headers_->Path()->value().c_str();
   ENVOY_STREAM_LOG(debug, "request complete: path: {}", *callbacks_, path);
 
-  Buffer::OwnedImpl response;
-  Http::Code code = parent_.runCallback(path, response);
+  std::shared_ptr<bool> destroyed = destroyed_;
+  parent_.runCallbackAsync(
+      path, [this, destroyed](Http::Code code, Buffer::Instance& response) -> void {
+        if (!*destroyed) {
+          sendResponse(code, response);
+        }
+      });
+}
 
+void AdminFilter::sendResponse(Http::Code code, Buffer::Instance& response) {
   Http::HeaderMapPtr headers{
       new Http::HeaderMapImpl{{Http::Headers::get().Status, std::to_string(enumToInt(code))}}};
   callbacks_->encodeHeaders(std::move(headers), response.length() == 0);
@@ -445,6 +769,10 @@ AdminImpl::AdminImpl(const std::string& access_log_path, const std::string& prof
           {"/clusters", "upstream cluster status", MAKE_ADMIN_HANDLER(handlerClusters), false},
           {"/cpuprofiler", "enable/disable the CPU profiler",
            MAKE_ADMIN_HANDLER(handlerCpuProfiler), false},
+          {"/heapprofiler", "enable/disable/dump the heap profiler",
+           MAKE_ADMIN_HANDLER(handlerHeapProfiler), false},
+          {"/filter_times", "rank HTTP filters by their sampled time per request",
+           MAKE_ADMIN_HANDLER(handlerFilterTimes), false},
           {"/healthcheck/fail", "cause the server to fail health checks",
            MAKE_ADMIN_HANDLER(handlerHealthcheckFail), false},
           {"/healthcheck/ok", "cause the server to pass health checks",
@@ -452,12 +780,17 @@ AdminImpl::AdminImpl(const std::string& access_log_path, const std::string& prof
           {"/hot_restart_version", "print the hot restart compatability version",
            MAKE_ADMIN_HANDLER(handlerHotRestartVersion), false},
           {"/logging", "query/change logging levels", MAKE_ADMIN_HANDLER(handlerLogging), false},
+          {"/profile", "enable/disable the sampling profiler or print its folded stacks",
+           MAKE_ADMIN_HANDLER(handlerProfile), false},
           {"/quitquitquit", "exit the server", MAKE_ADMIN_HANDLER(handlerQuitQuitQuit), false},
           {"/reset_counters", "reset all counters to zero",
            MAKE_ADMIN_HANDLER(handlerResetCounters), false},
           {"/server_info", "print server version/status information",
            MAKE_ADMIN_HANDLER(handlerServerInfo), false},
-          {"/stats", "print server stats", MAKE_ADMIN_HANDLER(handlerStats), false},
+          // Must precede "/stats" since handlers are matched by prefix in order.
+          {"/stats/prometheus", "print server stats in prometheus format", nullptr, false,
+           MAKE_SNAPSHOT_HANDLER(snapshotPrometheusStats)},
+          {"/stats", "print server stats", nullptr, false, MAKE_SNAPSHOT_HANDLER(snapshotStats)},
           {"/listeners", "print listener addresses", MAKE_ADMIN_HANDLER(handlerListenerInfo),
            false}},
       listener_stats_(
@@ -496,18 +829,22 @@ void AdminImpl::createFilterChain(Http::FilterChainFactoryCallbacks& callbacks)
   callbacks.addStreamDecoderFilter(Http::StreamDecoderFilterSharedPtr{new AdminFilter(*this)});
 }
 
-Http::Code AdminImpl::runCallback(const std::string& path, Buffer::Instance& response) {
-  Http::Code code = Http::Code::OK;
-  bool found_handler = false;
+const AdminImpl::UrlHandler* AdminImpl::findHandler(const std::string& path) const {
   for (const UrlHandler& handler : handlers_) {
     if (path.find(handler.prefix_) == 0) {
-      code = handler.handler_(path, response);
-      found_handler = true;
-      break;
+      return &handler;
     }
   }
+  return nullptr;
+}
 
-  if (!found_handler) {
+Http::Code AdminImpl::runCallback(const std::string& path, Buffer::Instance& response) {
+  Http::Code code = Http::Code::OK;
+  const UrlHandler* handler = findHandler(path);
+  if (handler != nullptr) {
+    code = handler->snapshot_ ? handler->snapshot_(path)(response)
+                              : handler->handler_(path, response);
+  } else {
     code = Http::Code::NotFound;
     response.add("envoy admin commands:\n");
 
@@ -525,6 +862,24 @@ Http::Code AdminImpl::runCallback(const std::string& path, Buffer::Instance& res
   return code;
 }
 
+void AdminImpl::runCallbackAsync(const std::string& path, const ResponseCb& done) {
+  const UrlHandler* handler = findHandler(path);
+  if (handler == nullptr || !handler->snapshot_) {
+    Buffer::OwnedImpl response;
+    const Http::Code code = runCallback(path, response);
+    done(code, response);
+    return;
+  }
+
+  const RenderCb render = handler->snapshot_(path);
+  Event::Dispatcher& dispatcher = server_.dispatcher();
+  render_thread_.post([render, done, &dispatcher]() -> void {
+    std::shared_ptr<Buffer::OwnedImpl> response = std::make_shared<Buffer::OwnedImpl>();
+    const Http::Code code = render(*response);
+    dispatcher.post([done, code, response]() -> void { done(code, *response); });
+  });
+}
+
 const Network::Address::Instance& AdminImpl::localAddress() {
   return *server_.localInfo().address();
 }
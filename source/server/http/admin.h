@@ -1,18 +1,26 @@
 #pragma once
 
 #include <chrono>
+#include <functional>
 #include <list>
+#include <map>
+#include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
+#include "envoy/common/regex.h"
 #include "envoy/http/filter.h"
 #include "envoy/network/listen_socket.h"
 #include "envoy/server/admin.h"
 #include "envoy/server/instance.h"
 #include "envoy/upstream/outlier_detection.h"
 #include "envoy/upstream/resource_manager.h"
+#include "envoy/upstream/upstream.h"
 
 #include "common/common/logger.h"
 #include "common/common/macros.h"
+#include "common/common/thread.h"
 #include "common/http/conn_manager_impl.h"
 #include "common/http/date_provider_impl.h"
 #include "common/http/utility.h"
@@ -35,7 +43,22 @@ public:
             const std::string& address_out_path, Network::Address::InstanceConstSharedPtr address,
             Server::Instance& server, Stats::Scope& listener_scope);
 
+  /**
+   * Receives the response of an admin request on the main thread.
+   */
+  typedef std::function<void(Http::Code code, Buffer::Instance& response)> ResponseCb;
+
   Http::Code runCallback(const std::string& path, Buffer::Instance& response);
+
+  /**
+   * Run the handler of a path like runCallback(), except that the response of a handler that
+   * supports it, e.g. a stats scrape, is rendered on the admin render thread, so that a large
+   * response does not hold up the main thread.
+   * @param path supplies the path of the request.
+   * @param done supplies the callback that receives the response, which is called before this
+   *        returns unless the response is rendered on the render thread.
+   */
+  void runCallbackAsync(const std::string& path, const ResponseCb& done);
   const Network::ListenSocket& socket() override { return *socket_; }
   Network::ListenSocket& mutable_socket() { return *socket_; }
 
@@ -80,13 +103,26 @@ public:
 
 private:
   /**
-   * Individual admin handler including prefix, help text, and callback.
+   * Renders a response from state that was gathered on the main thread. Runs on the render thread,
+   * so it must not touch state that is only safe to use on the main thread.
+   */
+  typedef std::function<Http::Code(Buffer::Instance& response)> RenderCb;
+
+  /**
+   * Gathers the state a response is rendered from on the main thread.
+   */
+  typedef std::function<RenderCb(const std::string& url)> SnapshotCb;
+
+  /**
+   * Individual admin handler including prefix, help text, and callback. Handlers that render their
+   * response off the main thread have a snapshot callback instead of a handler callback.
    */
   struct UrlHandler {
     const std::string prefix_;
     const std::string help_text_;
     const HandlerCb handler_;
     const bool removable_;
+    const SnapshotCb snapshot_{};
   };
 
   /**
@@ -113,9 +149,22 @@ private:
   void addOutlierInfo(const std::string& cluster_name,
                       const Upstream::Outlier::Detector* outlier_detector,
                       Buffer::Instance& response);
-  static std::string statsAsJson(const std::map<std::string, uint64_t>& all_stats);
-  static void statsAsPrometheus(const std::list<Stats::CounterSharedPtr>& counters,
-                                const std::list<Stats::GaugeSharedPtr>& gauges,
+  /**
+   * Write the state of a cluster and its hosts to the response of /clusters.
+   * @param host_filter if not nullptr, only the host with this address is written.
+   */
+  void addClusterText(const Upstream::Cluster& cluster, const std::string* host_filter,
+                      Buffer::Instance& response);
+  void addClusterJson(const Upstream::Cluster& cluster, const std::string* host_filter,
+                      Buffer::Instance& response);
+  static std::map<std::string, uint64_t> hostStats(const Upstream::Host& host);
+  const UrlHandler* findHandler(const std::string& path) const;
+  static std::string statsAsJson(const std::vector<std::pair<std::string, uint64_t>>& all_stats);
+  /**
+   * Write counters and gauges to response in the prometheus text exposition format.
+   * @param filter if not nullptr, only stats whose whole name matches are written.
+   */
+  static void statsAsPrometheus(const Stats::Store& store, const Regex::CompiledMatcher* filter,
                                 Buffer::Instance& response);
   static std::string sanitizePrometheusName(const std::string& name);
   static std::string formatTagsForPrometheus(const std::vector<Stats::Tag>& tags);
@@ -127,16 +176,27 @@ private:
   Http::Code handlerCerts(const std::string& url, Buffer::Instance& response);
   Http::Code handlerClusters(const std::string& url, Buffer::Instance& response);
   Http::Code handlerCpuProfiler(const std::string& url, Buffer::Instance& response);
+  Http::Code handlerFilterTimes(const std::string& url, Buffer::Instance& response);
+  Http::Code handlerHeapProfiler(const std::string& url, Buffer::Instance& response);
   Http::Code handlerHealthcheckFail(const std::string& url, Buffer::Instance& response);
   Http::Code handlerHealthcheckOk(const std::string& url, Buffer::Instance& response);
   Http::Code handlerHotRestartVersion(const std::string& url, Buffer::Instance& response);
   Http::Code handlerLogging(const std::string& url, Buffer::Instance& response);
   Http::Code handlerResetCounters(const std::string& url, Buffer::Instance& response);
   Http::Code handlerServerInfo(const std::string& url, Buffer::Instance& response);
-  Http::Code handlerStats(const std::string& url, Buffer::Instance& response);
+  Http::Code handlerProfile(const std::string& url, Buffer::Instance& response);
   Http::Code handlerQuitQuitQuit(const std::string& url, Buffer::Instance& response);
   Http::Code handlerListenerInfo(const std::string& url, Buffer::Instance& response);
 
+  /**
+   * URL handlers that render their response on the render thread.
+   */
+  RenderCb snapshotStats(const std::string& url);
+  RenderCb snapshotPrometheusStats(const std::string& url);
+
+  // Size at which prometheus output is moved into the response buffer.
+  static const size_t PROMETHEUS_CHUNK_SIZE = 16384;
+
   Server::Instance& server_;
   std::list<AccessLog::InstanceSharedPtr> access_logs_;
   const std::string profile_path_;
@@ -150,6 +210,9 @@ private:
   Http::SlowDateProviderImpl date_provider_;
   std::vector<Http::ClientCertDetailsType> set_current_client_cert_details_;
   Http::ConnectionManagerListenerStats listener_stats_;
+  // Renders the responses of snapshot handlers. Declared last so that it is stopped before the
+  // rest of the admin is destroyed.
+  Thread::WorkQueueThread render_thread_;
 };
 
 /**
@@ -158,9 +221,10 @@ private:
 class AdminFilter : public Http::StreamDecoderFilter, Logger::Loggable<Logger::Id::admin> {
 public:
   AdminFilter(AdminImpl& parent);
+  ~AdminFilter() { *destroyed_ = true; }
 
   // Http::StreamFilterBase
-  void onDestroy() override {}
+  void onDestroy() override { *destroyed_ = true; }
 
   // Http::StreamDecoderFilter
   Http::FilterHeadersStatus decodeHeaders(Http::HeaderMap& headers, bool end_stream) override;
@@ -175,10 +239,14 @@ private:
    * Called when an admin request has been completely received.
    */
   void onComplete();
+  void sendResponse(Http::Code code, Buffer::Instance& response);
 
   AdminImpl& parent_;
   Http::StreamDecoderFilterCallbacks* callbacks_{};
   Http::HeaderMap* request_headers_{};
+  // Shared with responses rendered on the render thread, since the stream may be reset or the
+  // filter destroyed before they are back on the main thread. Only used on the main thread.
+  std::shared_ptr<bool> destroyed_{std::make_shared<bool>(false)};
 };
 
 } // namespace Server
@@ -4,6 +4,7 @@
 
 #include "common/common/assert.h"
 #include "common/config/utility.h"
+#include "common/network/connection_balancer_impl.h"
 #include "common/network/listen_socket_impl.h"
 #include "common/network/utility.h"
 #include "common/protobuf/utility.h"
@@ -56,7 +57,7 @@ ProdListenerComponentFactory::createListenSocket(Network::Address::InstanceConst
   // TODO(mattklein123): UDS support.
   ASSERT(address->type() == Network::Address::Type::Ip);
   const std::string addr = fmt::format("tcp://{}", address->asString());
-  const int fd = server_.hotRestart().duplicateParentListenSocket(addr);
+  const int fd = server_.hotRestart().duplicateParentListenSocket(addr, 0);
   if (fd != -1) {
     ENVOY_LOG(debug, "obtained socket for address {} from parent", addr);
     return std::make_shared<Network::TcpListenSocket>(fd, address);
@@ -65,6 +66,19 @@ ProdListenerComponentFactory::createListenSocket(Network::Address::InstanceConst
   }
 }
 
+Network::ListenSocketSharedPtr ProdListenerComponentFactory::createReusePortListenSocket(
+    Network::Address::InstanceConstSharedPtr address, uint32_t worker_index) {
+  // As above, but the parent hands over the socket of the same worker if it has one.
+  const std::string addr = fmt::format("tcp://{}", address->asString());
+  const int fd = server_.hotRestart().duplicateParentListenSocket(addr, worker_index);
+  if (fd != -1) {
+    ENVOY_LOG(debug, "obtained socket for address {} worker {} from parent", addr, worker_index);
+    return std::make_shared<Network::TcpListenSocket>(fd, address);
+  } else {
+    return std::make_shared<Network::TcpListenSocket>(address, true, true);
+  }
+}
+
 DrainManagerPtr
 ProdListenerComponentFactory::createDrainManager(envoy::api::v2::Listener::DrainType drain_type) {
   return DrainManagerPtr{new DrainManagerImpl(server_, drain_type)};
@@ -81,11 +95,25 @@ ListenerImpl::ListenerImpl(const envoy::api::v2::Listener& config, ListenerManag
       listener_scope_(
           parent_.server_.stats().createScope(fmt::format("listener.{}.", address_->asString()))),
       bind_to_port_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(config.deprecated_v1(), bind_to_port, true)),
+      reuse_port_(bind_to_port_ && parent_.server_.runtime().snapshot().getInteger(
+                                       fmt::format("listener.{}.reuse_port", name), 0) != 0),
       use_proxy_proto_(
           PROTOBUF_GET_WRAPPED_OR_DEFAULT(config.filter_chains()[0], use_proxy_proto, false)),
       use_original_dst_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, use_original_dst, false)),
       per_connection_buffer_limit_bytes_(
           PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, per_connection_buffer_limit_bytes, 1024 * 1024)),
+      connection_balancer_(bind_to_port_ &&
+                                   parent_.server_.runtime().snapshot().getInteger(
+                                       fmt::format("listener.{}.connection_balance", name), 0) != 0
+                               ? new Network::ConnectionBalancerImpl()
+                               : nullptr),
+      defer_connection_creation_(
+          parent_.server_.runtime().snapshot().getInteger(
+              fmt::format("listener.{}.defer_connection_creation", name), 0) != 0),
+      idle_buffer_release_interval_(parent_.server_.runtime().snapshot().getInteger(
+          fmt::format("listener.{}.idle_buffer_release_ms", name), 0)),
+      drain_connections_per_second_(parent_.server_.runtime().snapshot().getInteger(
+          fmt::format("listener.{}.drain_connections_per_second", name), 0)),
       listener_tag_(parent_.factory_.nextListenerTag()), name_(name),
       workers_started_(workers_started), hash_(hash),
       local_drain_manager_(parent.factory_.createDrainManager(config.drain_type())) {
@@ -154,7 +182,10 @@ bool ListenerImpl::drainClose() const {
   // When a listener is draining, the "drain close" decision is the union of the per-listener drain
   // manager and the server wide drain manager. This allows individual listeners to be drained and
   // removed independently of a server-wide drain event (e.g., /healthcheck/fail or hot restart).
-  return local_drain_manager_->drainClose() || parent_.server_.drainManager().drainClose();
+  // Keep alive is also disabled while the server is overloaded, so that clients move their
+  // requests onto new connections that the overload manager may steer elsewhere.
+  return local_drain_manager_->drainClose() || parent_.server_.drainManager().drainClose() ||
+         parent_.server_.overloadManager().isActive(OverloadActionName::DisableHttpKeepAlive);
 }
 
 void ListenerImpl::debugLog(const std::string& message) {
@@ -184,9 +215,10 @@ Init::Manager& ListenerImpl::initManager() {
   }
 }
 
-void ListenerImpl::setSocket(const Network::ListenSocketSharedPtr& socket) {
-  ASSERT(!socket_);
-  socket_ = socket;
+void ListenerImpl::setSockets(const std::vector<Network::ListenSocketSharedPtr>& sockets) {
+  ASSERT(sockets_.empty());
+  ASSERT(!sockets.empty());
+  sockets_ = sockets;
 }
 
 ListenerManagerImpl::ListenerManagerImpl(Instance& server,
@@ -251,12 +283,12 @@ bool ListenerManagerImpl::addOrUpdateListener(const envoy::api::v2::Listener& co
     // In this case we can just replace inline.
     ASSERT(workers_started_);
     new_listener->debugLog("update warming listener");
-    new_listener->setSocket((*existing_warming_listener)->getSocket());
+    new_listener->setSockets((*existing_warming_listener)->getSockets());
     *existing_warming_listener = std::move(new_listener);
   } else if (existing_active_listener != active_listeners_.end()) {
     // In this case we have no warming listener, so what we do depends on whether workers
     // have been started or not. Either way we get the socket from the existing listener.
-    new_listener->setSocket((*existing_active_listener)->getSocket());
+    new_listener->setSockets((*existing_active_listener)->getSockets());
     if (workers_started_) {
       new_listener->debugLog("add warming listener");
       warming_listeners_.emplace_back(std::move(new_listener));
@@ -285,20 +317,14 @@ bool ListenerManagerImpl::addOrUpdateListener(const envoy::api::v2::Listener& co
     // to see if there is a listener that has a socket bound to the address we are configured for.
     // This is an edge case, but may happen if a listener is removed and then added back with a same
     // or different name and intended to listen on the same address. This should work and not fail.
-    Network::ListenSocketSharedPtr draining_listener_socket;
     auto existing_draining_listener = std::find_if(
         draining_listeners_.cbegin(), draining_listeners_.cend(),
         [&new_listener](const DrainingListener& listener) {
           return *new_listener->address() == *listener.listener_->socket().localAddress();
         });
-    if (existing_draining_listener != draining_listeners_.cend()) {
-      draining_listener_socket = existing_draining_listener->listener_->getSocket();
-    }
-
-    new_listener->setSocket(
-        draining_listener_socket
-            ? draining_listener_socket
-            : factory_.createListenSocket(new_listener->address(), new_listener->bindToPort()));
+    new_listener->setSockets(existing_draining_listener != draining_listeners_.cend()
+                                 ? existing_draining_listener->listener_->getSockets()
+                                 : createListenSockets(*new_listener));
     if (workers_started_) {
       new_listener->debugLog("add warming listener");
       warming_listeners_.emplace_back(std::move(new_listener));
@@ -331,6 +357,24 @@ bool ListenerManagerImpl::hasListenerWithAddress(const ListenerList& list,
   return false;
 }
 
+std::vector<Network::ListenSocketSharedPtr>
+ListenerManagerImpl::createListenSockets(ListenerImpl& listener) {
+  if (!listener.reusePort()) {
+    return {factory_.createListenSocket(listener.address(), listener.bindToPort())};
+  }
+
+  // Later sockets bind to the address of the first so that they share its port, which matters when
+  // binding to port zero.
+  std::vector<Network::ListenSocketSharedPtr> sockets{
+      factory_.createReusePortListenSocket(listener.address(), 0)};
+  const Network::Address::InstanceConstSharedPtr address =
+      sockets[0] ? sockets[0]->localAddress() : listener.address();
+  for (uint32_t i = 1; i < workers_.size(); i++) {
+    sockets.push_back(factory_.createReusePortListenSocket(address, i));
+  }
+  return sockets;
+}
+
 void ListenerManagerImpl::drainListener(ListenerImplPtr&& listener) {
   // First add the listener to the draining list.
   std::list<DrainingListener>::iterator draining_it = draining_listeners_.emplace(
@@ -39,6 +39,9 @@ public:
   }
   Network::ListenSocketSharedPtr
   createListenSocket(Network::Address::InstanceConstSharedPtr address, bool bind_to_port) override;
+  Network::ListenSocketSharedPtr
+  createReusePortListenSocket(Network::Address::InstanceConstSharedPtr address,
+                              uint32_t worker_index) override;
   DrainManagerPtr createDrainManager(envoy::api::v2::Listener::DrainType drain_type) override;
   uint64_t nextListenerTag() override { return next_listener_tag_++; }
 
@@ -106,6 +109,12 @@ private:
   };
 
   void addListenerToWorker(Worker& worker, ListenerImpl& listener);
+
+  /**
+   * Create the sockets for a new listener: one socket shared by all workers, or one SO_REUSEPORT
+   * socket per worker if the listener asks for it.
+   */
+  std::vector<Network::ListenSocketSharedPtr> createListenSockets(ListenerImpl& listener);
   static ListenerManagerStats generateStats(Stats::Scope& scope);
   static bool hasListenerWithAddress(const ListenerList& list,
                                      const Network::Address::Instance& address);
@@ -183,16 +192,27 @@ public:
   }
 
   Network::Address::InstanceConstSharedPtr address() const { return address_; }
-  const Network::ListenSocketSharedPtr& getSocket() const { return socket_; }
+  const std::vector<Network::ListenSocketSharedPtr>& getSockets() const { return sockets_; }
   uint64_t hash() const { return hash_; }
   void debugLog(const std::string& message);
   void initialize();
   DrainManager& localDrainManager() const { return *local_drain_manager_; }
-  void setSocket(const Network::ListenSocketSharedPtr& socket);
+  void setSockets(const std::vector<Network::ListenSocketSharedPtr>& sockets);
+
+  /**
+   * @return bool whether a newly created listener should get a SO_REUSEPORT socket per worker.
+   *         This is opted into per listener with the "listener.<name>.reuse_port" runtime key.
+   *         A listener that is updated keeps the sockets of the listener it replaces.
+   */
+  bool reusePort() const { return reuse_port_; }
 
   // Server::Listener
   Network::FilterChainFactory& filterChainFactory() override { return *this; }
-  Network::ListenSocket& socket() override { return *socket_; }
+  Network::ListenSocket& socket() override { return *sockets_[0]; }
+  uint32_t numSockets() override { return sockets_.size(); }
+  Network::ListenSocket& workerSocket(uint32_t worker_index) override {
+    return sockets_.size() == 1 ? *sockets_[0] : *sockets_[worker_index];
+  }
   bool bindToPort() override { return bind_to_port_; }
   Ssl::ServerContext* defaultSslContext() override {
     return tls_contexts_.empty() ? nullptr : tls_contexts_[0].get();
@@ -200,6 +220,12 @@ public:
   bool useProxyProto() override { return use_proxy_proto_; }
   bool useOriginalDst() override { return use_original_dst_; }
   uint32_t perConnectionBufferLimitBytes() override { return per_connection_buffer_limit_bytes_; }
+  Network::ConnectionBalancer* connectionBalancer() override { return connection_balancer_.get(); }
+  bool deferConnectionCreation() override { return defer_connection_creation_; }
+  std::chrono::milliseconds idleBufferReleaseInterval() override {
+    return idle_buffer_release_interval_;
+  }
+  uint32_t drainConnectionsPerSecond() override { return drain_connections_per_second_; }
   Stats::Scope& listenerScope() override { return *listener_scope_; }
   uint64_t listenerTag() override { return listener_tag_; }
   const std::string& name() const override { return name_; }
@@ -235,14 +261,24 @@ public:
 private:
   ListenerManagerImpl& parent_;
   Network::Address::InstanceConstSharedPtr address_;
-  Network::ListenSocketSharedPtr socket_;
+  // Either the single socket shared by all workers or one SO_REUSEPORT socket per worker.
+  std::vector<Network::ListenSocketSharedPtr> sockets_;
   Stats::ScopePtr global_scope_;   // Stats with global named scope, but needed for LDS cleanup.
   Stats::ScopePtr listener_scope_; // Stats with listener named scope.
   std::vector<Ssl::ServerContextPtr> tls_contexts_;
   const bool bind_to_port_;
+  const bool reuse_port_;
   const bool use_proxy_proto_;
   const bool use_original_dst_;
   const uint32_t per_connection_buffer_limit_bytes_;
+  // Set if the "listener.<name>.connection_balance" runtime key is non-zero. The worker listeners
+  // register with it and are all gone before this listener is destroyed.
+  Network::ConnectionBalancerPtr connection_balancer_;
+  // Set if the "listener.<name>.defer_connection_creation" runtime key is non-zero.
+  const bool defer_connection_creation_;
+  // The "listener.<name>.idle_buffer_release_ms" runtime key.
+  const std::chrono::milliseconds idle_buffer_release_interval_;
+  const uint32_t drain_connections_per_second_;
   const uint64_t listener_tag_;
   const std::string name_;
   const bool workers_started_;
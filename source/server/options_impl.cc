@@ -7,6 +7,7 @@
 
 #include "common/common/macros.h"
 #include "common/common/version.h"
+#include "common/filesystem/filesystem_impl.h"
 #include "common/stats/stats_impl.h"
 
 #include "fmt/format.h"
@@ -73,6 +74,10 @@ OptionsImpl::OptionsImpl(int argc, char** argv, const HotRestartVersionCb& hot_r
   TCLAP::ValueArg<uint32_t> file_flush_interval_msec("", "file-flush-interval-msec",
                                                      "Interval for log flushing in msec", false,
                                                      10000, "uint32_t", cmd);
+  TCLAP::ValueArg<uint64_t> file_write_buffer_bytes(
+      "", "file-write-buffer-bytes",
+      "Bytes each thread can buffer for a log file before its writes are dropped", false,
+      256 * 1024, "uint64_t", cmd);
   TCLAP::ValueArg<uint32_t> drain_time_s("", "drain-time-s", "Hot restart drain time in seconds",
                                          false, 600, "uint32_t", cmd);
   TCLAP::ValueArg<uint32_t> parent_shutdown_time_s("", "parent-shutdown-time-s",
@@ -92,6 +97,28 @@ OptionsImpl::OptionsImpl(int argc, char** argv, const HotRestartVersionCb& hot_r
                                              " the cluster name)",
                                              false, ENVOY_DEFAULT_MAX_OBJ_NAME_LENGTH, "uint64_t",
                                              cmd);
+  TCLAP::SwitchArg enable_dispatcher_stats("", "enable-dispatcher-stats",
+                                           "Time event loop iterations and callbacks of the main "
+                                           "thread and workers and export them as stats",
+                                           cmd, false);
+  TCLAP::SwitchArg log_async("", "log-async",
+                             "Buffer logging to stderr and write it from the file flush thread. "
+                             "Log lines that do not fit in the buffer are dropped",
+                             cmd, false);
+  TCLAP::SwitchArg worker_cpu_affinity("", "worker-cpu-affinity",
+                                       "Pin each worker thread to one of the CPUs the process may "
+                                       "run on, in order",
+                                       cmd, false);
+  TCLAP::ValueArg<uint32_t> ssl_private_key_threads(
+      "", "ssl-private-key-threads",
+      "# of threads to run the private key operations of TLS handshakes on listeners on, instead "
+      "of the workers (0 runs them on the workers)",
+      false, 0, "uint32_t", cmd);
+  TCLAP::ValueArg<uint32_t> dns_cache_ttl_ms(
+      "", "dns-cache-ttl-ms",
+      "Cache DNS results of clusters that use the server's resolver for this many milliseconds "
+      "(0 turns the cache off)",
+      false, 0, "uint32_t", cmd);
 
   cmd.setExceptionHandling(false);
   try {
@@ -118,6 +145,16 @@ OptionsImpl::OptionsImpl(int argc, char** argv, const HotRestartVersionCb& hot_r
     throw MalformedArgvException(message);
   }
 
+  const uint64_t min_file_write_buffer_bytes = Filesystem::FileImpl::MIN_FLUSH_SIZE;
+  if (file_write_buffer_bytes.getValue() < min_file_write_buffer_bytes) {
+    const std::string message =
+        fmt::format("error: the 'file-write-buffer-bytes' value specified ({}) is less than the "
+                    "minimum value of {}",
+                    file_write_buffer_bytes.getValue(), min_file_write_buffer_bytes);
+    std::cerr << message << std::endl;
+    throw MalformedArgvException(message);
+  }
+
   if (hot_restart_version_option.getValue()) {
     std::cerr << hot_restart_version_cb(max_stats.getValue(),
                                         max_obj_name_len.getValue() +
@@ -165,9 +202,15 @@ OptionsImpl::OptionsImpl(int argc, char** argv, const HotRestartVersionCb& hot_r
   service_node_ = service_node.getValue();
   service_zone_ = service_zone.getValue();
   file_flush_interval_msec_ = std::chrono::milliseconds(file_flush_interval_msec.getValue());
+  file_write_buffer_bytes_ = file_write_buffer_bytes.getValue();
   drain_time_ = std::chrono::seconds(drain_time_s.getValue());
   parent_shutdown_time_ = std::chrono::seconds(parent_shutdown_time_s.getValue());
   max_stats_ = max_stats.getValue();
   max_obj_name_length_ = max_obj_name_len.getValue();
+  dispatcher_stats_enabled_ = enable_dispatcher_stats.getValue();
+  log_async_ = log_async.getValue();
+  worker_cpu_affinity_ = worker_cpu_affinity.getValue();
+  ssl_private_key_threads_ = ssl_private_key_threads.getValue();
+  dns_cache_ttl_ = std::chrono::milliseconds(dns_cache_ttl_ms.getValue());
 }
 } // namespace Envoy
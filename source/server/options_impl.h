@@ -41,11 +41,17 @@ public:
   uint64_t restartEpoch() override { return restart_epoch_; }
   Server::Mode mode() const override { return mode_; }
   std::chrono::milliseconds fileFlushIntervalMsec() override { return file_flush_interval_msec_; }
+  uint64_t fileWriteBufferBytes() override { return file_write_buffer_bytes_; }
   const std::string& serviceClusterName() override { return service_cluster_; }
   const std::string& serviceNodeName() override { return service_node_; }
   const std::string& serviceZone() override { return service_zone_; }
   uint64_t maxStats() override { return max_stats_; }
   uint64_t maxObjNameLength() override { return max_obj_name_length_; }
+  bool dispatcherStatsEnabled() override { return dispatcher_stats_enabled_; }
+  bool logAsync() override { return log_async_; }
+  bool workerCpuAffinity() override { return worker_cpu_affinity_; }
+  uint32_t sslPrivateKeyThreads() override { return ssl_private_key_threads_; }
+  std::chrono::milliseconds dnsCacheTtl() override { return dns_cache_ttl_; }
 
 private:
   uint64_t base_id_;
@@ -61,11 +67,17 @@ private:
   std::string service_node_;
   std::string service_zone_;
   std::chrono::milliseconds file_flush_interval_msec_;
+  uint64_t file_write_buffer_bytes_;
   std::chrono::seconds drain_time_;
   std::chrono::seconds parent_shutdown_time_;
   Server::Mode mode_;
   uint64_t max_stats_;
   uint64_t max_obj_name_length_;
+  bool dispatcher_stats_enabled_;
+  bool log_async_;
+  bool worker_cpu_affinity_;
+  uint32_t ssl_private_key_threads_;
+  std::chrono::milliseconds dns_cache_ttl_;
 };
 
 /**
@@ -0,0 +1,130 @@
+#include "server/overload_manager_impl.h"
+
+#include <algorithm>
+
+#include "common/memory/stats.h"
+
+#include "fmt/format.h"
+
+namespace Envoy {
+namespace Server {
+
+namespace {
+
+uint64_t pressure(uint64_t used, uint64_t limit) {
+  return limit == 0 ? 0 : used * 100 / limit;
+}
+
+} // namespace
+
+OverloadManagerImpl::OverloadManagerImpl(Instance& server, MonotonicTimeSource& time_source)
+    : server_(server), time_source_(time_source),
+      stats_{ALL_OVERLOAD_MANAGER_STATS(POOL_GAUGE_PREFIX(server.stats(), "overload."))} {
+  // Indexed by OverloadActionName.
+  const std::vector<std::pair<std::string, uint64_t>> actions{
+      {"disable_http_keepalive", 80},
+      {"shrink_buffer_limits", 90},
+      {"stop_accepting_connections", 95},
+  };
+  for (const auto& action : actions) {
+    actions_.emplace_back(new Action(
+        action.first, action.second,
+        server.stats().gauge(fmt::format("overload.{}.active", action.first))));
+  }
+}
+
+void OverloadManagerImpl::start() {
+  refresh_timer_ = server_.dispatcher().createTimer([this]() -> void { refresh(); });
+  refresh();
+}
+
+void OverloadManagerImpl::registerForAction(OverloadActionName action_name,
+                                            Event::Dispatcher& dispatcher,
+                                            OverloadActionCb callback) {
+  Action& action = *actions_[static_cast<size_t>(action_name)];
+  action.callbacks_.push_back({dispatcher, callback});
+  if (action.active_) {
+    dispatcher.post([callback]() -> void { callback(OverloadActionState::Active); });
+  }
+
+  if (std::find_if(probed_dispatchers_.begin(), probed_dispatchers_.end(),
+                   [&dispatcher](const ProbedDispatcher& probed) -> bool {
+                     return &probed.dispatcher_ == &dispatcher;
+                   }) == probed_dispatchers_.end()) {
+    probed_dispatchers_.push_back({dispatcher, std::make_shared<EventLoopProbe>()});
+  }
+}
+
+void OverloadManagerImpl::refresh() {
+  Runtime::Snapshot& snapshot = server_.runtime().snapshot();
+
+  const uint64_t event_loop_lag_ms = probeEventLoops();
+  stats_.event_loop_lag_ms_.set(event_loop_lag_ms);
+
+  uint64_t max_pressure =
+      pressure(Memory::Stats::totalCurrentlyAllocated(),
+               snapshot.getInteger("overload.max_heap_size_bytes", 0));
+  max_pressure = std::max(max_pressure,
+                          pressure(server_.listenerManager().numConnections(),
+                                   snapshot.getInteger("overload.max_active_connections", 0)));
+  max_pressure = std::max(
+      max_pressure,
+      pressure(event_loop_lag_ms, snapshot.getInteger("overload.max_event_loop_lag_ms", 0)));
+  stats_.pressure_.set(max_pressure);
+
+  for (const ActionPtr& action : actions_) {
+    const uint64_t threshold = snapshot.getInteger(
+        fmt::format("overload.{}.threshold", action->name_), action->default_threshold_);
+    setActionState(*action, max_pressure >= threshold);
+  }
+
+  refresh_timer_->enableTimer(
+      std::chrono::milliseconds(snapshot.getInteger("overload.refresh_interval_ms", 1000)));
+}
+
+uint64_t OverloadManagerImpl::probeEventLoops() {
+  const MonotonicTime now = time_source_.currentTime();
+  uint64_t max_lag_ms = 0;
+  for (const ProbedDispatcher& probed : probed_dispatchers_) {
+    const std::shared_ptr<EventLoopProbe>& probe = probed.probe_;
+    if (probe->pending_) {
+      // The previous probe task has not run yet, so the loop is at least this far behind.
+      max_lag_ms = std::max<uint64_t>(
+          max_lag_ms,
+          std::chrono::duration_cast<std::chrono::milliseconds>(now - probe->posted_).count());
+      continue;
+    }
+
+    max_lag_ms = std::max<uint64_t>(max_lag_ms, probe->lag_ms_);
+    probe->posted_ = now;
+    probe->pending_ = true;
+    MonotonicTimeSource& time_source = time_source_;
+    probed.dispatcher_.post([probe, &time_source]() -> void {
+      probe->lag_ms_ = std::chrono::duration_cast<std::chrono::milliseconds>(
+                           time_source.currentTime() - probe->posted_)
+                           .count();
+      probe->pending_ = false;
+    });
+  }
+
+  return max_lag_ms;
+}
+
+void OverloadManagerImpl::setActionState(Action& action, bool active) {
+  if (action.active_ == active) {
+    return;
+  }
+
+  ENVOY_LOG(warn, "overload action {} is now {}", action.name_, active ? "active" : "inactive");
+  action.active_ = active;
+  action.active_gauge_.set(active ? 1 : 0);
+  const OverloadActionState state =
+      active ? OverloadActionState::Active : OverloadActionState::Inactive;
+  for (const Callback& callback : action.callbacks_) {
+    OverloadActionCb cb = callback.callback_;
+    callback.dispatcher_.post([cb, state]() -> void { cb(state); });
+  }
+}
+
+} // namespace Server
+} // namespace Envoy
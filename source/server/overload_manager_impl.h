@@ -0,0 +1,108 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "envoy/common/time.h"
+#include "envoy/event/dispatcher.h"
+#include "envoy/event/timer.h"
+#include "envoy/server/instance.h"
+#include "envoy/server/overload_manager.h"
+#include "envoy/stats/stats.h"
+#include "envoy/stats/stats_macros.h"
+
+#include "common/common/logger.h"
+
+namespace Envoy {
+namespace Server {
+
+/**
+ * All overload manager stats. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_OVERLOAD_MANAGER_STATS(GAUGE)                                                          \
+  GAUGE(pressure)                                                                                  \
+  GAUGE(event_loop_lag_ms)
+// clang-format on
+
+/**
+ * Struct definition for all overload manager stats. @see stats_macros.h
+ */
+struct OverloadManagerStats {
+  ALL_OVERLOAD_MANAGER_STATS(GENERATE_GAUGE_STRUCT)
+};
+
+/**
+ * Overload manager driven by runtime. Every "overload.refresh_interval_ms" (default 1000) it takes
+ * the pressure, as a percentage, of each resource that has a limit set:
+ * - "overload.max_heap_size_bytes": bytes allocated from the heap.
+ * - "overload.max_active_connections": connections open on all workers.
+ * - "overload.max_event_loop_lag_ms": the longest time a task posted to a registered dispatcher
+ *   waited to run.
+ * An action is active while the highest pressure is at least its "overload.<action>.threshold".
+ */
+class OverloadManagerImpl : public OverloadManager, Logger::Loggable<Logger::Id::main> {
+public:
+  OverloadManagerImpl(Instance& server, MonotonicTimeSource& time_source);
+
+  // Server::OverloadManager
+  void start() override;
+  void registerForAction(OverloadActionName action, Event::Dispatcher& dispatcher,
+                         OverloadActionCb callback) override;
+  bool isActive(OverloadActionName action) const override {
+    return actions_[static_cast<size_t>(action)]->active_;
+  }
+
+private:
+  struct Callback {
+    Event::Dispatcher& dispatcher_;
+    OverloadActionCb callback_;
+  };
+
+  struct Action {
+    Action(const std::string& name, uint64_t default_threshold, Stats::Gauge& active_gauge)
+        : name_(name), default_threshold_(default_threshold), active_gauge_(active_gauge) {}
+
+    const std::string name_;
+    const uint64_t default_threshold_;
+    Stats::Gauge& active_gauge_;
+    std::atomic<bool> active_{};
+    std::vector<Callback> callbacks_;
+  };
+
+  typedef std::unique_ptr<Action> ActionPtr;
+
+  /**
+   * Measures how long tasks posted to a dispatcher wait to run. Only one probe task per dispatcher
+   * is outstanding at a time.
+   */
+  struct EventLoopProbe {
+    std::atomic<bool> pending_{};
+    // Written by the main thread while no probe task is pending.
+    MonotonicTime posted_;
+    std::atomic<uint64_t> lag_ms_{};
+  };
+
+  struct ProbedDispatcher {
+    Event::Dispatcher& dispatcher_;
+    std::shared_ptr<EventLoopProbe> probe_;
+  };
+
+  void refresh();
+  uint64_t probeEventLoops();
+  void setActionState(Action& action, bool active);
+
+  Instance& server_;
+  MonotonicTimeSource& time_source_;
+  OverloadManagerStats stats_;
+  std::vector<ActionPtr> actions_;
+  std::vector<ProbedDispatcher> probed_dispatchers_;
+  Event::TimerPtr refresh_timer_;
+};
+
+} // namespace Server
+} // namespace Envoy
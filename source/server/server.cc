@@ -16,17 +16,21 @@
 
 #include "common/api/api_impl.h"
 #include "common/api/os_sys_calls_impl.h"
+#include "common/common/thread.h"
 #include "common/common/utility.h"
 #include "common/common/version.h"
 #include "common/config/bootstrap_json.h"
 #include "common/config/utility.h"
 #include "common/local_info/local_info_impl.h"
+#include "common/memory/accounting.h"
 #include "common/memory/stats.h"
 #include "common/network/address_impl.h"
+#include "common/network/caching_dns_resolver.h"
 #include "common/protobuf/utility.h"
 #include "common/router/rds_impl.h"
 #include "common/runtime/runtime_impl.h"
 #include "common/singleton/manager_impl.h"
+#include "common/ssl/private_key_method_provider_impl.h"
 #include "common/stats/thread_local_store.h"
 #include "common/upstream/cluster_manager_impl.h"
 
@@ -37,6 +41,8 @@
 
 #include "api/bootstrap.pb.h"
 #include "api/bootstrap.pb.validate.h"
+#include "api/cds.pb.validate.h"
+#include "api/lds.pb.validate.h"
 
 namespace Envoy {
 namespace Server {
@@ -47,20 +53,34 @@ InstanceImpl::InstanceImpl(Options& options, Network::Address::InstanceConstShar
                            ComponentFactory& component_factory, ThreadLocal::Instance& tls)
     : options_(options), restarter_(restarter), start_time_(time(nullptr)),
       original_start_time_(start_time_), stats_store_(store), thread_local_(tls),
-      api_(new Api::Impl(options.fileFlushIntervalMsec())), dispatcher_(api_->allocateDispatcher()),
+      api_(new Api::Impl(options.fileFlushIntervalMsec(), options.fileWriteBufferBytes())),
+      dispatcher_(api_->allocateDispatcher()),
       singleton_manager_(new Singleton::ManagerImpl()),
       handler_(new ConnectionHandlerImpl(ENVOY_LOGGER(), *dispatcher_)),
-      listener_component_factory_(*this), worker_factory_(thread_local_, *api_, hooks),
-      dns_resolver_(dispatcher_->createDnsResolver({})),
+      overload_manager_(*this, ProdMonotonicTimeSource::instance_),
+      listener_component_factory_(*this),
+      worker_factory_(thread_local_, *api_, hooks, store, overload_manager_,
+                      options.dispatcherStatsEnabled(),
+                      options.workerCpuAffinity() ? Thread::Thread::currentThreadCpus()
+                                                  : std::vector<uint32_t>()),
+      dns_resolver_(new Network::WarmDnsResolver(std::make_shared<Network::CachingDnsResolver>(
+          dispatcher_->createDnsResolver({}), options.dnsCacheTtl(),
+          ProdMonotonicTimeSource::instance_, store))),
       access_log_manager_(*api_, *dispatcher_, access_log_lock, store) {
 
   try {
-    if (!options.logPath().empty()) {
+    std::string log_path = options.logPath();
+    if (log_path.empty() && options.logAsync()) {
+      // stderr is written through the same per-thread buffers and flush thread as a log file, so
+      // that a slow terminal or pipe does not block the workers.
+      log_path = "/dev/stderr";
+    }
+    if (!log_path.empty()) {
       try {
-        Logger::Registry::getSink()->logToFile(options.logPath(), access_log_manager_);
+        Logger::Registry::getSink()->logToFile(log_path, access_log_manager_);
       } catch (const EnvoyException& e) {
         throw EnvoyException(
-            fmt::format("Failed to open log-file '{}'. e.what(): {}", options.logPath(), e.what()));
+            fmt::format("Failed to open log-file '{}'. e.what(): {}", log_path, e.what()));
       }
     }
 
@@ -105,28 +125,35 @@ void InstanceImpl::failHealthcheck(bool fail) {
   server_stats_->live_.set(!fail);
 }
 
-void InstanceUtil::flushCountersAndGaugesToSinks(const std::list<Stats::SinkPtr>& sinks,
-                                                 Stats::Store& store) {
+void InstanceUtil::flushMetricsToSinks(const std::list<Stats::SinkPtr>& sinks,
+                                       Stats::Store& store) {
   for (const auto& sink : sinks) {
     sink->beginFlush();
   }
 
-  for (const Stats::CounterSharedPtr& counter : store.counters()) {
-    uint64_t delta = counter->latch();
-    if (counter->used()) {
+  store.forEachCounter([&sinks](Stats::Counter& counter) {
+    uint64_t delta = counter.latch();
+    if (counter.used()) {
       for (const auto& sink : sinks) {
-        sink->flushCounter(*counter, delta);
+        sink->flushCounter(counter, delta);
       }
     }
-  }
+  });
 
-  for (const Stats::GaugeSharedPtr& gauge : store.gauges()) {
-    if (gauge->used()) {
+  store.forEachGauge([&sinks](Stats::Gauge& gauge) {
+    if (gauge.used()) {
       for (const auto& sink : sinks) {
-        sink->flushGauge(*gauge, gauge->value());
+        sink->flushGauge(gauge, gauge.value());
       }
     }
-  }
+  });
+
+  store.forEachHistogram([&sinks](Stats::ParentHistogram& histogram) {
+    histogram.merge();
+    for (const auto& sink : sinks) {
+      sink->flushHistogram(histogram);
+    }
+  });
 
   for (const auto& sink : sinks) {
     sink->endFlush();
@@ -141,12 +168,19 @@ void InstanceImpl::flushStats() {
   server_stats_->memory_allocated_.set(Memory::Stats::totalCurrentlyAllocated() +
                                        info.memory_allocated_);
   server_stats_->memory_heap_size_.set(Memory::Stats::totalCurrentlyReserved());
+  server_stats_->memory_buffers_.set(Memory::Accounting::bytes(Memory::Category::Buffers));
+  server_stats_->memory_stats_.set(Memory::Accounting::bytes(Memory::Category::Stats));
+  server_stats_->memory_route_configs_.set(
+      Memory::Accounting::bytes(Memory::Category::RouteConfigs));
+  server_stats_->memory_hosts_.set(Memory::Accounting::bytes(Memory::Category::Hosts));
+  server_stats_->memory_connection_pools_.set(
+      Memory::Accounting::bytes(Memory::Category::ConnectionPools));
   server_stats_->parent_connections_.set(info.num_connections_);
   server_stats_->total_connections_.set(numConnections() + info.num_connections_);
   server_stats_->days_until_first_cert_expiring_.set(
       sslContextManager().daysUntilFirstCertExpires());
 
-  InstanceUtil::flushCountersAndGaugesToSinks(config_->statsSinks(), stats_store_);
+  InstanceUtil::flushMetricsToSinks(config_->statsSinks(), stats_store_);
   stat_flush_timer_->enableTimer(config_->statsFlushInterval());
 }
 
@@ -158,10 +192,12 @@ void InstanceImpl::getParentStats(HotRestart::GetParentStatsInfo& info) {
 bool InstanceImpl::healthCheckFailed() { return server_stats_->live_.value() == 0; }
 
 void InstanceUtil::loadBootstrapConfig(envoy::api::v2::Bootstrap& bootstrap,
-                                       const std::string& config_path, bool v2_only) {
+                                       const std::string& config_path, bool v2_only,
+                                       uint32_t concurrency) {
   bool v2_config_loaded = false;
   try {
-    MessageUtil::loadFromFileAndValidate(config_path, bootstrap);
+    MessageUtil::loadFromFile(config_path, bootstrap);
+    validateBootstrap(bootstrap, concurrency);
     v2_config_loaded = true;
   } catch (const EnvoyException& e) {
     if (v2_only) {
@@ -173,8 +209,32 @@ void InstanceUtil::loadBootstrapConfig(envoy::api::v2::Bootstrap& bootstrap,
   }
   if (!v2_config_loaded) {
     Json::ObjectSharedPtr config_json = Json::Factory::loadFromFile(config_path);
-    Config::BootstrapJson::translateBootstrap(*config_json, bootstrap);
-    MessageUtil::validate(bootstrap);
+    bootstrap.Clear();
+    Config::BootstrapJson::translateBootstrap(*config_json, bootstrap, concurrency);
+    validateBootstrap(bootstrap, concurrency);
+  }
+}
+
+void InstanceUtil::validateBootstrap(envoy::api::v2::Bootstrap& bootstrap, uint32_t concurrency) {
+  const auto& clusters = bootstrap.static_resources().clusters();
+  const auto& listeners = bootstrap.static_resources().listeners();
+  Thread::parallelFor(clusters.size() + listeners.size(), concurrency, [&](size_t i) -> void {
+    if (i < static_cast<size_t>(clusters.size())) {
+      MessageUtil::validate(clusters[i]);
+    } else {
+      MessageUtil::validate(listeners[i - clusters.size()]);
+    }
+  });
+
+  // The rest of the config is validated with the clusters and listeners moved out of the way, so
+  // that they are not validated again.
+  envoy::api::v2::Bootstrap::StaticResources static_resources;
+  static_resources.Swap(bootstrap.mutable_static_resources());
+  std::string error;
+  const bool valid = Validate(bootstrap, &error);
+  static_resources.Swap(bootstrap.mutable_static_resources());
+  if (!valid) {
+    throw ProtoValidationException(error, bootstrap);
   }
 }
 
@@ -184,9 +244,14 @@ void InstanceImpl::initialize(Options& options,
   ENVOY_LOG(info, "initializing epoch {} (hot restart version={})", options.restartEpoch(),
             restarter_.version());
 
-  // Handle configuration that needs to take place prior to the main configuration load.
+  // Handle configuration that needs to take place prior to the main configuration load. The
+  // workers are not created yet, so the static clusters and listeners are translated and validated
+  // on as many threads as there will be workers.
+  MonotonicTime phase_start = ProdMonotonicTimeSource::instance_.currentTime();
   envoy::api::v2::Bootstrap bootstrap;
-  InstanceUtil::loadBootstrapConfig(bootstrap, options.configPath(), options.v2ConfigOnly());
+  InstanceUtil::loadBootstrapConfig(bootstrap, options.configPath(), options.v2ConfigOnly(),
+                                    options.concurrency());
+  recordStartupPhase("bootstrap", phase_start);
 
   // Needs to happen as early as possible in the instantiation to preempt the objects that require
   // stats.
@@ -204,6 +269,10 @@ void InstanceImpl::initialize(Options& options,
   }
 
   server_stats_->version_.set(version_int);
+  dispatcher_->initializeStats(stats_store_, "server.main_thread.");
+  if (options.dispatcherStatsEnabled()) {
+    dispatcher_->initializeLoopStats(stats_store_, "server.main_thread.");
+  }
   bootstrap.mutable_node()->set_build_version(VersionInfo::version());
 
   local_info_.reset(
@@ -217,6 +286,11 @@ void InstanceImpl::initialize(Options& options,
   info.original_start_time_ = original_start_time_;
   restarter_.shutdownParentAdmin(info);
   original_start_time_ = info.original_start_time_;
+  // Clusters that resolve their hosts through DNS start with the hosts our parent is using, rather
+  // than waiting for DNS before they can take traffic.
+  std::vector<Network::DnsResult> parent_dns_results;
+  restarter_.getParentDnsResults(parent_dns_results);
+  dns_resolver_->addHints(parent_dns_results);
   admin_scope_ = stats_store_.createScope("listener.admin.");
   admin_.reset(new AdminImpl(initial_config.admin().accessLogPath(),
                              initial_config.admin().profilePath(), options.adminAddressPath(),
@@ -240,10 +314,19 @@ void InstanceImpl::initialize(Options& options,
 
   // Runtime gets initialized before the main configuration since during main configuration
   // load things may grab a reference to the loader for later use.
+  phase_start = ProdMonotonicTimeSource::instance_.currentTime();
   runtime_loader_ = component_factory.createRuntime(*this, initial_config);
+  recordStartupPhase("runtime", phase_start);
 
   // Once we have runtime we can initialize the SSL context manager.
-  ssl_context_manager_.reset(new Ssl::ContextManagerImpl(*runtime_loader_));
+  Ssl::PrivateKeyMethodProviderPtr private_key_method_provider;
+  if (options.sslPrivateKeyThreads() > 0) {
+    private_key_method_provider.reset(
+        new Ssl::ThreadPoolPrivateKeyMethodProvider(options.sslPrivateKeyThreads()));
+  }
+  ssl_context_manager_.reset(
+      new Ssl::ContextManagerImpl(*runtime_loader_, std::move(private_key_method_provider)));
+  ssl_context_manager_->watchSessionTicketKeyFiles(*dispatcher_);
 
   cluster_manager_factory_.reset(new Upstream::ProdClusterManagerFactory(
       runtime(), stats(), threadLocal(), random(), dnsResolver(), sslContextManager(), dispatcher(),
@@ -255,10 +338,6 @@ void InstanceImpl::initialize(Options& options,
   config_.reset(main_config);
   main_config->initialize(bootstrap, *this, *cluster_manager_factory_);
 
-  for (Stats::SinkPtr& sink : main_config->statsSinks()) {
-    stats_store_.addSink(*sink);
-  }
-
   // Some of the stat sinks may need dispatcher support so don't flush until the main loop starts.
   // Just setup the timer.
   stat_flush_timer_ = dispatcher_->createTimer([this]() -> void { flushStats(); });
@@ -268,10 +347,22 @@ void InstanceImpl::initialize(Options& options,
   // started and before our own run() loop runs.
   guard_dog_.reset(
       new Server::GuardDogImpl(stats_store_, *config_, ProdMonotonicTimeSource::instance_));
+  initialized_time_ = ProdMonotonicTimeSource::instance_.currentTime();
+}
+
+void InstanceImpl::recordStartupPhase(const std::string& name, MonotonicTime start) {
+  const std::chrono::milliseconds duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+      ProdMonotonicTimeSource::instance_.currentTime() - start);
+  ENVOY_LOG(info, "startup phase {} took {}ms", name, duration.count());
+  startup_phases_.emplace_back(name, duration);
 }
 
 void InstanceImpl::startWorkers() {
+  // The workers start once the clusters initialized, which may involve health checks and
+  // discovery requests.
+  recordStartupPhase("cluster_initialization", initialized_time_);
   listener_manager_->startWorkers(*guard_dog_);
+  overload_manager_.start();
 
   // At this point we are ready to take traffic and all listening ports are up. Notify our parent
   // if applicable that they can stop listening and drain.
@@ -6,8 +6,10 @@
 #include <list>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "envoy/common/optional.h"
+#include "envoy/common/time.h"
 #include "envoy/server/configuration.h"
 #include "envoy/server/drain_manager.h"
 #include "envoy/server/guarddog.h"
@@ -18,12 +20,14 @@
 #include "envoy/tracing/http_tracer.h"
 
 #include "common/access_log/access_log_manager_impl.h"
+#include "common/network/warm_dns_resolver.h"
 #include "common/runtime/runtime_impl.h"
 #include "common/ssl/context_manager_impl.h"
 
 #include "server/http/admin.h"
 #include "server/init_manager_impl.h"
 #include "server/listener_manager_impl.h"
+#include "server/overload_manager_impl.h"
 #include "server/test_hooks.h"
 #include "server/worker_impl.h"
 
@@ -38,6 +42,11 @@ namespace Server {
   GAUGE(uptime)                                                                                    \
   GAUGE(memory_allocated)                                                                          \
   GAUGE(memory_heap_size)                                                                          \
+  GAUGE(memory_buffers)                                                                            \
+  GAUGE(memory_stats)                                                                              \
+  GAUGE(memory_route_configs)                                                                      \
+  GAUGE(memory_hosts)                                                                              \
+  GAUGE(memory_connection_pools)                                                                   \
   GAUGE(live)                                                                                      \
   GAUGE(parent_connections)                                                                        \
   GAUGE(total_connections)                                                                         \
@@ -79,22 +88,33 @@ public:
   static Runtime::LoaderPtr createRuntime(Instance& server, Server::Configuration::Initial& config);
 
   /**
-   * Helper for flushing counters and gauges to sinks. This takes care of calling beginFlush(),
-   * latching of counters and flushing, flushing of gauges, and calling endFlush(), on each sink.
+   * Helper for flushing stats to sinks. This takes care of calling beginFlush(), latching of
+   * counters and flushing, flushing of gauges, merging of histograms and flushing, and calling
+   * endFlush(), on each sink.
    * @param sinks supplies the list of sinks.
    * @param store supplies the store to flush.
    */
-  static void flushCountersAndGaugesToSinks(const std::list<Stats::SinkPtr>& sinks,
-                                            Stats::Store& store);
+  static void flushMetricsToSinks(const std::list<Stats::SinkPtr>& sinks, Stats::Store& store);
 
   /**
    * Load a bootstrap config from either v1 or v2 and perform validation.
    * @param bootstrap supplies the bootstrap to fill.
    * @param config_path supplies the config path.
    * @param v2_only supplies whether to attempt v1 fallback.
+   * @param concurrency supplies the number of threads to translate and validate the static
+   *        clusters and listeners on.
    */
   static void loadBootstrapConfig(envoy::api::v2::Bootstrap& bootstrap,
-                                  const std::string& config_path, bool v2_only);
+                                  const std::string& config_path, bool v2_only,
+                                  uint32_t concurrency = 1);
+
+  /**
+   * Validate a bootstrap config, with its static clusters and listeners validated in parallel.
+   * @param bootstrap supplies the config.
+   * @param concurrency supplies the number of threads to validate on.
+   * @throw ProtoValidationException if the config does not satisfy its type constraints.
+   */
+  static void validateBootstrap(envoy::api::v2::Bootstrap& bootstrap, uint32_t concurrency);
 };
 
 /**
@@ -143,6 +163,9 @@ public:
   AccessLog::AccessLogManager& accessLogManager() override { return access_log_manager_; }
   void failHealthcheck(bool fail) override;
   void getParentStats(HotRestart::GetParentStatsInfo& info) override;
+  void getDnsResults(std::vector<Network::DnsResult>& results) override {
+    results = dns_resolver_->results();
+  }
   HotRestart& hotRestart() override { return restarter_; }
   Init::Manager& initManager() override { return init_manager_; }
   ListenerManager& listenerManager() override { return *listener_manager_; }
@@ -157,8 +180,10 @@ public:
   Singleton::Manager& singletonManager() override { return *singleton_manager_; }
   bool healthCheckFailed() override;
   Options& options() override { return options_; }
+  OverloadManager& overloadManager() override { return overload_manager_; }
   time_t startTimeCurrentEpoch() override { return start_time_; }
   time_t startTimeFirstEpoch() override { return original_start_time_; }
+  StartupPhases& startupPhases() override { return startup_phases_; }
   Stats::Store& stats() override { return stats_store_; }
   Tracing::HttpTracer& httpTracer() override;
   ThreadLocal::Instance& threadLocal() override { return thread_local_; }
@@ -170,12 +195,15 @@ private:
                   ComponentFactory& component_factory);
   void loadServerFlags(const Optional<std::string>& flags_path);
   uint64_t numConnections();
+  void recordStartupPhase(const std::string& name, MonotonicTime start);
   void startWorkers();
 
   Options& options_;
   HotRestart& restarter_;
   const time_t start_time_;
   time_t original_start_time_;
+  StartupPhases startup_phases_;
+  MonotonicTime initialized_time_;
   Stats::StoreRoot& stats_store_;
   std::vector<Stats::TagExtractorPtr> tag_extractors_;
   std::unique_ptr<ServerStats> server_stats_;
@@ -188,12 +216,13 @@ private:
   Runtime::RandomGeneratorImpl random_generator_;
   Runtime::LoaderPtr runtime_loader_;
   std::unique_ptr<Ssl::ContextManagerImpl> ssl_context_manager_;
+  OverloadManagerImpl overload_manager_;
   ProdListenerComponentFactory listener_component_factory_;
   ProdWorkerFactory worker_factory_;
   std::unique_ptr<ListenerManager> listener_manager_;
   std::unique_ptr<Configuration::Main> config_;
   Stats::ScopePtr admin_scope_;
-  Network::DnsResolverSharedPtr dns_resolver_;
+  Network::WarmDnsResolverSharedPtr dns_resolver_;
   Event::TimerPtr stat_flush_timer_;
   LocalInfo::LocalInfoPtr local_info_;
   DrainManagerPtr drain_manager_;
@@ -0,0 +1,104 @@
+#include "server/thread_stack_capture.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+#ifdef __linux__
+#include <execinfo.h>
+#include <signal.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#endif
+
+namespace Envoy {
+namespace Server {
+
+#ifdef __linux__
+namespace {
+
+// The frames of the signal handler and of the signal trampoline that precede the interrupted one.
+const int SKIPPED_FRAMES = 2;
+const std::chrono::milliseconds CAPTURE_TIMEOUT(100);
+
+// A capture is requested, claimed by the handler while it writes the frames, and done. A request
+// that times out is withdrawn, so that a handler that runs late does not write the frames of the
+// next capture.
+enum CaptureState { Idle, Requested, Writing, Done };
+
+// Zero initialized, so that it is usable from the signal handler without any setup.
+std::atomic<int> state_;
+int depth_;
+void* frames_[ThreadStackCapture::MAX_STACK_DEPTH + SKIPPED_FRAMES];
+// Serializes captures. Never taken by the signal handler.
+std::mutex lock_;
+
+// Only calls functions that are safe in a signal handler once backtrace() has been called outside
+// of one, which capture() does.
+void onCapture(int) {
+  int expected = Requested;
+  if (!state_.compare_exchange_strong(expected, Writing)) {
+    return;
+  }
+
+  const int saved_errno = errno;
+  depth_ = backtrace(frames_, ThreadStackCapture::MAX_STACK_DEPTH + SKIPPED_FRAMES);
+  state_.store(Done, std::memory_order_release);
+  errno = saved_errno;
+}
+
+bool installHandler() {
+  // The first call to backtrace() may load the unwinder, which must not happen in the handler.
+  void* frame;
+  backtrace(&frame, 1);
+
+  // The handler stays installed, since the default action of a SIGUSR2 that arrives late would
+  // terminate the process.
+  struct sigaction action {};
+  action.sa_handler = onCapture;
+  action.sa_flags = SA_RESTART;
+  sigemptyset(&action.sa_mask);
+  return sigaction(SIGUSR2, &action, nullptr) == 0;
+}
+
+} // namespace
+
+bool ThreadStackCapture::capture(int32_t thread_id, std::vector<void*>& frames) {
+  std::unique_lock<std::mutex> lock(lock_);
+  static const bool installed = installHandler();
+  if (!installed) {
+    return false;
+  }
+
+  state_ = Requested;
+  if (syscall(SYS_tgkill, getpid(), thread_id, SIGUSR2) != 0) {
+    state_ = Idle;
+    return false;
+  }
+
+  const auto deadline = std::chrono::steady_clock::now() + CAPTURE_TIMEOUT;
+  while (state_.load(std::memory_order_acquire) != Done) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      int expected = Requested;
+      if (state_.compare_exchange_strong(expected, Idle)) {
+        return false;
+      }
+      // The handler claimed the request just now, so it is about to finish.
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  frames.assign(frames_ + std::min(depth_, SKIPPED_FRAMES), frames_ + depth_);
+  state_ = Idle;
+  return !frames.empty();
+}
+#else
+bool ThreadStackCapture::capture(int32_t, std::vector<void*>&) { return false; }
+#endif
+
+} // namespace Server
+} // namespace Envoy
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace Envoy {
+namespace Server {
+
+/**
+ * Captures the stack of another thread of this process by interrupting it with SIGUSR2, whose
+ * handler copies the return addresses of the interrupted stack into a static buffer. Only one
+ * capture runs at a time. This is meant for rare diagnostics such as reporting a stalled event
+ * loop, not for profiling.
+ */
+class ThreadStackCapture {
+public:
+  /**
+   * Capture the stack of a thread. Blocks until the thread has run the signal handler, which a
+   * thread that is blocked in a system call does right away, or until the capture times out.
+   * @param thread_id supplies the system thread ID, as returned by Thread::currentThreadId().
+   * @param frames receives the return addresses, innermost first.
+   * @return bool whether the stack was captured. Always false on platforms other than Linux.
+   */
+  static bool capture(int32_t thread_id, std::vector<void*>& frames);
+
+  static const uint32_t MAX_STACK_DEPTH = 64;
+};
+
+} // namespace Server
+} // namespace Envoy
@@ -8,6 +8,7 @@ namespace Envoy {
 namespace Server {
 
 void WatchDogImpl::startWatchdog(Event::Dispatcher& dispatcher) {
+  dispatcher_ = &dispatcher;
   timer_ = dispatcher.createTimer([this]() -> void {
     this->touch();
     timer_->enableTimer(timer_interval_);
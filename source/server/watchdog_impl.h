@@ -30,6 +30,16 @@ public:
     return MonotonicTime(latest_touch_time_since_epoch_.load());
   }
 
+  /**
+   * @return const char* the kind of event whose callback the watched thread's dispatcher is
+   *         running, or nullptr if it is not running one or startWatchdog() has not been called.
+   *         @see Event::Dispatcher::runningCallbackType().
+   */
+  const char* runningCallbackType() const {
+    const Event::Dispatcher* dispatcher = dispatcher_.load();
+    return dispatcher != nullptr ? dispatcher->runningCallbackType() : nullptr;
+  }
+
   // Server::WatchDog
   void startWatchdog(Event::Dispatcher& dispatcher) override;
   void touch() override {
@@ -41,6 +51,9 @@ private:
   MonotonicTimeSource& time_source_;
   std::atomic<std::chrono::steady_clock::duration> latest_touch_time_since_epoch_;
   Event::TimerPtr timer_;
+  // Read by the guard dog thread. The dispatcher outlives the watch, which is stopped before the
+  // watched thread returns.
+  std::atomic<Event::Dispatcher*> dispatcher_{};
   const std::chrono::milliseconds timer_interval_;
 };
 
@@ -1,6 +1,12 @@
 #include "server/worker_impl.h"
 
+#include <sys/socket.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
 #include <functional>
+#include <string>
 
 #include "envoy/event/dispatcher.h"
 #include "envoy/event/timer.h"
@@ -11,20 +17,52 @@
 
 #include "server/connection_handler_impl.h"
 
+#include "fmt/format.h"
+
 namespace Envoy {
 namespace Server {
 
 WorkerPtr ProdWorkerFactory::createWorker() {
   Event::DispatcherPtr dispatcher(api_.allocateDispatcher());
+  const uint32_t index = next_worker_index_++;
+  const std::string stat_prefix = fmt::format("server.worker_{}.", index);
+  dispatcher->initializeStats(stats_scope_, stat_prefix);
+  if (dispatcher_stats_enabled_) {
+    dispatcher->initializeLoopStats(stats_scope_, stat_prefix);
+  }
   return WorkerPtr{new WorkerImpl(
       tls_, hooks_, std::move(dispatcher),
-      Network::ConnectionHandlerPtr{new ConnectionHandlerImpl(ENVOY_LOGGER(), *dispatcher)})};
+      Network::ConnectionHandlerPtr{new ConnectionHandlerImpl(ENVOY_LOGGER(), *dispatcher, index)},
+      index, overload_manager_,
+      WorkerStats{ALL_WORKER_STATS(POOL_GAUGE_PREFIX(stats_scope_, stat_prefix))},
+      worker_cpus_.empty() ? Optional<uint32_t>()
+                           : Optional<uint32_t>(worker_cpus_[index % worker_cpus_.size()]))};
 }
 
+const uint32_t WorkerImpl::OVERLOAD_CONNECTION_BUFFER_LIMIT;
+const std::chrono::milliseconds WorkerImpl::CPU_TIME_UPDATE_INTERVAL{1000};
+
 WorkerImpl::WorkerImpl(ThreadLocal::Instance& tls, TestHooks& hooks,
-                       Event::DispatcherPtr&& dispatcher, Network::ConnectionHandlerPtr handler)
-    : tls_(tls), hooks_(hooks), dispatcher_(std::move(dispatcher)), handler_(std::move(handler)) {
+                       Event::DispatcherPtr&& dispatcher, Network::ConnectionHandlerPtr handler,
+                       uint32_t index, OverloadManager& overload_manager,
+                       const WorkerStats& stats, Optional<uint32_t> cpu)
+    : tls_(tls), hooks_(hooks), dispatcher_(std::move(dispatcher)), handler_(std::move(handler)),
+      index_(index), stats_(stats), cpu_(cpu) {
   tls_.registerThread(*dispatcher_, false);
+  overload_manager.registerForAction(OverloadActionName::StopAcceptingConnections, *dispatcher_,
+                                     [this](OverloadActionState state) -> void {
+                                       if (state == OverloadActionState::Active) {
+                                         handler_->disableListeners();
+                                       } else {
+                                         handler_->enableListeners();
+                                       }
+                                     });
+  overload_manager.registerForAction(
+      OverloadActionName::ShrinkBufferLimits, *dispatcher_,
+      [this](OverloadActionState state) -> void {
+        handler_->setConnectionBufferLimitCap(
+            state == OverloadActionState::Active ? OVERLOAD_CONNECTION_BUFFER_LIMIT : 0);
+      });
 }
 
 void WorkerImpl::addListener(Listener& listener, AddListenerCompletion completion) {
@@ -47,13 +85,25 @@ void WorkerImpl::addListenerWorker(Listener& listener) {
                                                      .use_proxy_proto_ = listener.useProxyProto(),
                                                      .use_original_dst_ = listener.useOriginalDst(),
                                                      .per_connection_buffer_limit_bytes_ =
-                                                         listener.perConnectionBufferLimitBytes()};
+                                                         listener.perConnectionBufferLimitBytes(),
+                                                     .connection_balancer_ =
+                                                         listener.connectionBalancer(),
+                                                     .defer_connection_creation_ =
+                                                         listener.deferConnectionCreation(),
+                                                     .idle_buffer_release_interval_ =
+                                                         listener.idleBufferReleaseInterval(),
+                                                     .drain_connections_per_second_ =
+                                                         listener.drainConnectionsPerSecond()};
+  if (cpu_.valid() && listener.numSockets() > 1) {
+    setIncomingCpu(listener.workerSocket(index_));
+  }
+
   if (listener.defaultSslContext()) {
     handler_->addSslListener(listener.filterChainFactory(), *listener.defaultSslContext(),
-                             listener.socket(), listener.listenerScope(), listener.listenerTag(),
-                             listener_options);
+                             listener.workerSocket(index_), listener.listenerScope(),
+                             listener.listenerTag(), listener_options);
   } else {
-    handler_->addListener(listener.filterChainFactory(), listener.socket(),
+    handler_->addListener(listener.filterChainFactory(), listener.workerSocket(index_),
                           listener.listenerScope(), listener.listenerTag(), listener_options);
   }
 
@@ -103,13 +153,39 @@ void WorkerImpl::stopListeners() {
   dispatcher_->post([this]() -> void { handler_->stopListeners(); });
 }
 
+void WorkerImpl::setIncomingCpu(Network::ListenSocket& socket) {
+#ifdef SO_INCOMING_CPU
+  // Among the SO_REUSEPORT sockets of a listener the kernel prefers the one whose incoming CPU is
+  // the CPU that processes the connection's packets.
+  const int cpu = cpu_.value();
+  if (setsockopt(socket.fd(), SOL_SOCKET, SO_INCOMING_CPU, &cpu, sizeof(cpu)) == -1) {
+    ENVOY_LOG(warn, "worker {}: cannot set SO_INCOMING_CPU: {}", index_, strerror(errno));
+  }
+#else
+  UNREFERENCED_PARAMETER(socket);
+#endif
+}
+
 void WorkerImpl::threadRoutine(GuardDog& guard_dog) {
+  if (cpu_.valid()) {
+    // Pinning before the dispatch loop runs keeps the memory the worker touches first, e.g. its
+    // thread local state and connection buffers, on the NUMA node of its CPU.
+    if (Thread::Thread::pinCurrentThread(cpu_.value())) {
+      ENVOY_LOG(info, "worker {} pinned to cpu {}", index_, cpu_.value());
+    } else {
+      ENVOY_LOG(warn, "worker {}: cannot pin to cpu {}", index_, cpu_.value());
+    }
+  }
+
   ENVOY_LOG(debug, "worker entering dispatch loop");
   auto watchdog = guard_dog.createWatchDog(Thread::Thread::currentThreadId());
   watchdog->startWatchdog(*dispatcher_);
+  cpu_time_timer_ = dispatcher_->createTimer([this]() -> void { updateCpuTime(); });
+  updateCpuTime();
   dispatcher_->run(Event::Dispatcher::RunType::Block);
   ENVOY_LOG(debug, "worker exited dispatch loop");
   guard_dog.stopWatching(watchdog);
+  cpu_time_timer_.reset();
 
   // We must close all active connections before we actually exit the thread. This prevents any
   // destructors from running on the main thread which might reference thread locals. Destroying
@@ -120,5 +196,13 @@ void WorkerImpl::threadRoutine(GuardDog& guard_dog) {
   watchdog.reset();
 }
 
+void WorkerImpl::updateCpuTime() {
+  // The gauge lets an operator spot a hot worker without attaching a profiler.
+  stats_.cpu_time_ms_.set(
+      std::chrono::duration_cast<std::chrono::milliseconds>(Thread::Thread::currentThreadCpuTime())
+          .count());
+  cpu_time_timer_->enableTimer(CPU_TIME_UPDATE_INTERVAL);
+}
+
 } // namespace Server
 } // namespace Envoy
@@ -1,13 +1,19 @@
 #pragma once
 
+#include <chrono>
 #include <functional>
 #include <memory>
+#include <vector>
 
 #include "envoy/api/api.h"
+#include "envoy/common/optional.h"
 #include "envoy/network/connection_handler.h"
 #include "envoy/server/guarddog.h"
 #include "envoy/server/listener_manager.h"
+#include "envoy/server/overload_manager.h"
 #include "envoy/server/worker.h"
+#include "envoy/stats/stats.h"
+#include "envoy/stats/stats_macros.h"
 #include "envoy/thread_local/thread_local.h"
 
 #include "common/common/logger.h"
@@ -18,10 +24,35 @@
 namespace Envoy {
 namespace Server {
 
+/**
+ * All worker stats. @see stats_macros.h
+ */
+// clang-format off
+#define ALL_WORKER_STATS(GAUGE)                                                                    \
+  GAUGE(cpu_time_ms)
+// clang-format on
+
+/**
+ * Struct definition for all worker stats. @see stats_macros.h
+ */
+struct WorkerStats {
+  ALL_WORKER_STATS(GENERATE_GAUGE_STRUCT)
+};
+
 class ProdWorkerFactory : public WorkerFactory, Logger::Loggable<Logger::Id::main> {
 public:
-  ProdWorkerFactory(ThreadLocal::Instance& tls, Api::Api& api, TestHooks& hooks)
-      : tls_(tls), api_(api), hooks_(hooks) {}
+  /**
+   * @param dispatcher_stats_enabled supplies whether worker dispatchers export event loop timing
+   *        stats. @see Event::Dispatcher::initializeLoopStats().
+   * @param worker_cpus supplies the CPUs that workers are pinned to, round robin in creation
+   *        order. Workers are not pinned if it is empty.
+   */
+  ProdWorkerFactory(ThreadLocal::Instance& tls, Api::Api& api, TestHooks& hooks,
+                    Stats::Scope& stats_scope, OverloadManager& overload_manager,
+                    bool dispatcher_stats_enabled, const std::vector<uint32_t>& worker_cpus)
+      : tls_(tls), api_(api), hooks_(hooks), stats_scope_(stats_scope),
+        overload_manager_(overload_manager), dispatcher_stats_enabled_(dispatcher_stats_enabled),
+        worker_cpus_(worker_cpus) {}
 
   // Server::WorkerFactory
   WorkerPtr createWorker() override;
@@ -30,6 +61,11 @@ private:
   ThreadLocal::Instance& tls_;
   Api::Api& api_;
   TestHooks& hooks_;
+  Stats::Scope& stats_scope_;
+  OverloadManager& overload_manager_;
+  const bool dispatcher_stats_enabled_;
+  const std::vector<uint32_t> worker_cpus_;
+  uint32_t next_worker_index_{};
 };
 
 /**
@@ -37,8 +73,25 @@ private:
  */
 class WorkerImpl : public Worker, Logger::Loggable<Logger::Id::main> {
 public:
+  /**
+   * @param index supplies the worker's position in creation order, which selects its socket for
+   *        listeners that have a socket per worker.
+   * @param overload_manager supplies the overload manager whose actions the worker carries out.
+   * @param stats supplies the stats of the worker.
+   * @param cpu supplies the CPU to pin the worker thread to, if any. Connections to listeners with
+   *        a socket per worker are then preferably accepted by the worker on the CPU that receives
+   *        them, via SO_INCOMING_CPU, so that they are handled on the CPU (and NUMA node) of the
+   *        NIC queue they arrive on.
+   */
   WorkerImpl(ThreadLocal::Instance& tls, TestHooks& hooks, Event::DispatcherPtr&& dispatcher,
-             Network::ConnectionHandlerPtr handler);
+             Network::ConnectionHandlerPtr handler, uint32_t index,
+             OverloadManager& overload_manager, const WorkerStats& stats,
+             Optional<uint32_t> cpu = {});
+
+  // Buffer limit cap of new connections while the shrink_buffer_limits overload action is active.
+  static const uint32_t OVERLOAD_CONNECTION_BUFFER_LIMIT = 32 * 1024;
+  // How often the worker thread refreshes its cpu_time_ms gauge.
+  static const std::chrono::milliseconds CPU_TIME_UPDATE_INTERVAL;
 
   // Server::Worker
   void addListener(Listener& listener, AddListenerCompletion completion) override;
@@ -51,13 +104,20 @@ public:
 
 private:
   void addListenerWorker(Listener& listener);
+  void setIncomingCpu(Network::ListenSocket& socket);
   void threadRoutine(GuardDog& guard_dog);
+  void updateCpuTime();
 
   ThreadLocal::Instance& tls_;
   TestHooks& hooks_;
   Event::DispatcherPtr dispatcher_;
   Network::ConnectionHandlerPtr handler_;
   Thread::ThreadPtr thread_;
+  const uint32_t index_;
+  WorkerStats stats_;
+  const Optional<uint32_t> cpu_;
+  // Only used on the worker thread.
+  Event::TimerPtr cpu_time_timer_;
 };
 
 } // namespace Server
@@ -0,0 +1,24 @@
+// NOLINT(namespace-envoy)
+// This is an Envoy driver for benchmarks.
+#include "common/common/logger.h"
+#include "common/common/thread.h"
+#include "common/event/libevent.h"
+
+#include "benchmark/benchmark.h"
+
+// Boilerplate main(), which discovers benchmarks in the same binary and runs them.
+int main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+
+  Envoy::Event::Libevent::Global::initialize();
+
+  // Benchmarks measure the data path, not logging; only surface critical messages.
+  Envoy::Thread::MutexBasicLockable lock;
+  Envoy::Logger::Registry::initialize(spdlog::level::critical, lock);
+
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
@@ -0,0 +1,70 @@
+#include <string>
+
+#include "common/access_log/access_log_formatter.h"
+#include "common/http/header_map_impl.h"
+
+#include "test/mocks/request_info/mocks.h"
+
+#include "benchmark/benchmark.h"
+#include "gmock/gmock.h"
+
+using testing::NiceMock;
+using testing::Return;
+using testing::ReturnRef;
+
+namespace Envoy {
+namespace AccessLog {
+
+class AccessLogFormatterPerf {
+public:
+  AccessLogFormatterPerf()
+      : request_headers_{{Http::Headers::get().Method, "GET"},
+                         {Http::Headers::get().Path, "/some/path?query=value"},
+                         {Http::Headers::get().Host, "www.example.com"},
+                         {Http::Headers::get().UserAgent, "curl/7.54.0"},
+                         {Http::Headers::get().ForwardedFor, "10.0.0.1"},
+                         {Http::Headers::get().RequestId, "a4e9f7c2-3f44-4d31-9b9d-5f8c1e0b6a21"}},
+        response_headers_{{Http::Headers::get().Status, "200"},
+                          {Http::Headers::get().EnvoyUpstreamServiceTime, "10"}},
+        protocol_(Http::Protocol::Http11), response_code_(200), downstream_address_("10.0.0.1") {
+    ON_CALL(request_info_, protocol()).WillByDefault(ReturnRef(protocol_));
+    ON_CALL(request_info_, responseCode()).WillByDefault(ReturnRef(response_code_));
+    ON_CALL(request_info_, bytesReceived()).WillByDefault(Return(1024));
+    ON_CALL(request_info_, bytesSent()).WillByDefault(Return(4096));
+    ON_CALL(request_info_, duration()).WillByDefault(Return(std::chrono::microseconds(15000)));
+    ON_CALL(request_info_, upstreamLocalAddress()).WillByDefault(ReturnRef(upstream_local_));
+    ON_CALL(request_info_, getDownstreamAddress()).WillByDefault(ReturnRef(downstream_address_));
+  }
+
+  void format(benchmark::State& state, const std::string& format) {
+    FormatterImpl formatter(format);
+    while (state.KeepRunning()) {
+      benchmark::DoNotOptimize(
+          formatter.format(request_headers_, response_headers_, request_info_));
+    }
+  }
+
+private:
+  Http::HeaderMapImpl request_headers_;
+  Http::HeaderMapImpl response_headers_;
+  NiceMock<RequestInfo::MockRequestInfo> request_info_;
+  Optional<Http::Protocol> protocol_;
+  Optional<uint32_t> response_code_;
+  Optional<std::string> upstream_local_;
+  std::string downstream_address_;
+};
+
+static void AccessLogFormatterDefault(benchmark::State& state) {
+  AccessLogFormatterPerf perf;
+  perf.format(state, AccessLogFormatUtils::DEFAULT_FORMAT);
+}
+BENCHMARK(AccessLogFormatterDefault);
+
+static void AccessLogFormatterPlainText(benchmark::State& state) {
+  AccessLogFormatterPerf perf;
+  perf.format(state, "plain text only, no substitution\n");
+}
+BENCHMARK(AccessLogFormatterPlainText);
+
+} // namespace AccessLog
+} // namespace Envoy
@@ -238,6 +238,22 @@ TEST(AccessLogFormatterTest, CompositeFormatterSuccess) {
   }
 }
 
+TEST(AccessLogFormatterTest, CompositeFormatterAppends) {
+  RequestInfo::MockRequestInfo request_info;
+  Http::TestHeaderMapImpl request_header{{"first", "GET"}, {":path", "/"}};
+  Http::TestHeaderMapImpl response_header{{"second", "PUT"}};
+  EXPECT_CALL(request_info, bytesReceived()).WillRepeatedly(Return(1024));
+  Optional<uint32_t> response_code{200};
+  EXPECT_CALL(request_info, responseCode()).WillRepeatedly(ReturnRef(response_code));
+
+  FormatterImpl formatter("%REQ(FIRST)% %RESP(SECOND):2% %RESP(THIRD)% %RESPONSE_CODE% "
+                          "%BYTES_RECEIVED%\n");
+  std::string output = "line: ";
+  formatter.formatTo(request_header, response_header, request_info, output);
+  EXPECT_EQ("line: GET PU - 200 1024\n", output);
+  EXPECT_EQ("GET PU - 200 1024\n", formatter.format(request_header, response_header, request_info));
+}
+
 TEST(AccessLogFormatterTest, ParserFailures) {
   AccessLogFormatParser parser;
 
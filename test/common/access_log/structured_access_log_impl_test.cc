@@ -0,0 +1,209 @@
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include "common/access_log/structured_access_log_impl.h"
+#include "common/http/header_map_impl.h"
+#include "common/protobuf/protobuf.h"
+
+#include "test/mocks/access_log/mocks.h"
+#include "test/mocks/event/mocks.h"
+#include "test/mocks/filesystem/mocks.h"
+#include "test/mocks/grpc/mocks.h"
+#include "test/mocks/local_info/mocks.h"
+#include "test/mocks/request_info/mocks.h"
+#include "test/mocks/thread_local/mocks.h"
+#include "test/test_common/printers.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::Invoke;
+using testing::NiceMock;
+using testing::Return;
+using testing::ReturnRef;
+using testing::SaveArg;
+using testing::_;
+
+namespace Envoy {
+namespace AccessLog {
+
+class StructuredAccessLogTest : public testing::Test {
+public:
+  StructuredAccessLogTest() {
+    ON_CALL(request_info_, protocol()).WillByDefault(ReturnRef(protocol_));
+    ON_CALL(request_info_, responseCode()).WillByDefault(ReturnRef(response_code_));
+    ON_CALL(request_info_, upstreamLocalAddress())
+        .WillByDefault(ReturnRef(upstream_local_address_));
+    ON_CALL(request_info_, getDownstreamAddress()).WillByDefault(ReturnRef(downstream_address_));
+    ON_CALL(request_info_, duration()).WillByDefault(Return(std::chrono::microseconds(2500)));
+    ON_CALL(request_info_, bytesReceived()).WillByDefault(Return(10));
+    ON_CALL(request_info_, bytesSent()).WillByDefault(Return(20));
+  }
+
+  Http::TestHeaderMapImpl request_headers_{{":method", "GET"},
+                                           {":path", "/foo"},
+                                           {":authority", "example.com"},
+                                           {"x-request-id", "id"}};
+  Http::TestHeaderMapImpl response_headers_{{":status", "200"}};
+  NiceMock<RequestInfo::MockRequestInfo> request_info_;
+  Optional<Http::Protocol> protocol_{Http::Protocol::Http11};
+  Optional<uint32_t> response_code_{200};
+  Optional<std::string> upstream_local_address_;
+  std::string downstream_address_{"127.0.0.1"};
+};
+
+TEST_F(StructuredAccessLogTest, FillEntry) {
+  envoy::accesslog::HttpAccessLogEntry entry;
+  StructuredAccessLogUtility::fillEntry(request_headers_, response_headers_, request_info_, entry);
+
+  EXPECT_EQ(2500, entry.duration_us());
+  EXPECT_EQ(0, entry.request_received_duration_us());
+  EXPECT_EQ("HTTP/1.1", entry.protocol());
+  EXPECT_EQ("GET", entry.method());
+  EXPECT_EQ("/foo", entry.path());
+  EXPECT_EQ("example.com", entry.authority());
+  EXPECT_EQ("id", entry.request_id());
+  EXPECT_EQ(200, entry.response_code());
+  EXPECT_EQ("-", entry.response_flags());
+  EXPECT_EQ(10, entry.bytes_received());
+  EXPECT_EQ(20, entry.bytes_sent());
+  EXPECT_EQ("10.0.0.1:443", entry.upstream_host());
+  EXPECT_EQ(request_info_.host_->cluster_.name_, entry.upstream_cluster());
+  EXPECT_EQ("", entry.upstream_local_address());
+  EXPECT_EQ("127.0.0.1", entry.downstream_address());
+}
+
+TEST_F(StructuredAccessLogTest, BinaryFile) {
+  NiceMock<MockAccessLogManager> log_manager;
+  std::shared_ptr<NiceMock<Filesystem::MockFile>> file(new NiceMock<Filesystem::MockFile>());
+  EXPECT_CALL(log_manager, createAccessLog("/dev/null")).WillOnce(Return(file));
+  BinaryFileAccessLog log("/dev/null", nullptr, log_manager);
+
+  std::string written;
+  EXPECT_CALL(*file, write(_)).Times(2).WillRepeatedly(Invoke([&](const std::string& data) {
+    written += data;
+  }));
+  log.log(&request_headers_, &response_headers_, request_info_);
+  log.log(nullptr, nullptr, request_info_);
+
+  Protobuf::io::CodedInputStream stream(reinterpret_cast<const uint8_t*>(written.data()),
+                                        written.size());
+  for (const std::string& method : {"GET", ""}) {
+    uint32_t length;
+    ASSERT_TRUE(stream.ReadVarint32(&length));
+    const auto limit = stream.PushLimit(length);
+    envoy::accesslog::HttpAccessLogEntry entry;
+    ASSERT_TRUE(entry.ParseFromCodedStream(&stream));
+    stream.PopLimit(limit);
+    EXPECT_EQ(method, entry.method());
+    EXPECT_EQ(200, entry.response_code());
+  }
+  EXPECT_EQ(static_cast<int>(written.size()), stream.CurrentPosition());
+}
+
+class GrpcAccessLogTest : public StructuredAccessLogTest {
+public:
+  typedef Grpc::MockAsyncClient<envoy::accesslog::StreamAccessLogsMessage,
+                                envoy::accesslog::StreamAccessLogsResponse>
+      MockClient;
+
+  void initialize(uint32_t buffer_size_bytes) {
+    envoy::accesslog::StructuredAccessLog config;
+    config.set_log_name("requests");
+    config.set_cluster_name("als");
+    config.set_buffer_size_bytes(buffer_size_bytes);
+    config.set_buffer_flush_interval_ms(500);
+
+    flush_timer_ = new Event::MockTimer(&tls_.dispatcher_);
+    EXPECT_CALL(*flush_timer_, enableTimer(std::chrono::milliseconds(500)));
+    log_.reset(new GrpcAccessLog(config, nullptr,
+                                 [this]() -> AccessLogServiceAsyncClientPtr {
+                                   return AccessLogServiceAsyncClientPtr{client_};
+                                 },
+                                 tls_, local_info_));
+  }
+
+  void expectStreamStart() {
+    EXPECT_CALL(*client_, start(_, _))
+        .WillOnce(Invoke([this](const Protobuf::MethodDescriptor& method,
+                                Grpc::AsyncStreamCallbacks<
+                                    envoy::accesslog::StreamAccessLogsResponse>& callbacks) {
+          EXPECT_EQ("envoy.accesslog.AccessLogService.StreamAccessLogs", method.full_name());
+          callbacks_ = &callbacks;
+          return &stream_;
+        }));
+  }
+
+  MockClient* client_{new MockClient()};
+  Grpc::MockAsyncStream<envoy::accesslog::StreamAccessLogsMessage> stream_;
+  Grpc::AsyncStreamCallbacks<envoy::accesslog::StreamAccessLogsResponse>* callbacks_{};
+  NiceMock<ThreadLocal::MockInstance> tls_;
+  NiceMock<LocalInfo::MockLocalInfo> local_info_;
+  Event::MockTimer* flush_timer_{};
+  std::unique_ptr<GrpcAccessLog> log_;
+};
+
+TEST_F(GrpcAccessLogTest, FlushOnTimer) {
+  initialize(1024 * 1024);
+
+  log_->log(&request_headers_, &response_headers_, request_info_);
+  log_->log(&request_headers_, &response_headers_, request_info_);
+
+  expectStreamStart();
+  envoy::accesslog::StreamAccessLogsMessage message;
+  EXPECT_CALL(stream_, sendMessage(_, false)).WillOnce(SaveArg<0>(&message));
+  EXPECT_CALL(*flush_timer_, enableTimer(std::chrono::milliseconds(500)));
+  flush_timer_->callback_();
+  EXPECT_EQ("node_name", message.identifier().node_id());
+  EXPECT_EQ("cluster_name", message.identifier().cluster());
+  EXPECT_EQ("requests", message.identifier().log_name());
+  EXPECT_EQ(2, message.entries_size());
+  EXPECT_EQ("/foo", message.entries(1).path());
+
+  // Nothing is sent while no entries are pending, and later messages on the stream do not repeat
+  // the identifier.
+  EXPECT_CALL(*flush_timer_, enableTimer(std::chrono::milliseconds(500)));
+  flush_timer_->callback_();
+
+  log_->log(&request_headers_, &response_headers_, request_info_);
+  EXPECT_CALL(stream_, sendMessage(_, false)).WillOnce(SaveArg<0>(&message));
+  EXPECT_CALL(*flush_timer_, enableTimer(std::chrono::milliseconds(500)));
+  flush_timer_->callback_();
+  EXPECT_FALSE(message.has_identifier());
+  EXPECT_EQ(1, message.entries_size());
+}
+
+TEST_F(GrpcAccessLogTest, FlushOnBufferSize) {
+  initialize(1);
+
+  expectStreamStart();
+  envoy::accesslog::StreamAccessLogsMessage message;
+  EXPECT_CALL(stream_, sendMessage(_, false)).WillOnce(SaveArg<0>(&message));
+  log_->log(&request_headers_, &response_headers_, request_info_);
+  EXPECT_EQ(1, message.entries_size());
+}
+
+TEST_F(GrpcAccessLogTest, StreamFailure) {
+  initialize(1);
+
+  // Entries are dropped while no stream can be opened.
+  EXPECT_CALL(*client_, start(_, _)).WillOnce(Return(nullptr));
+  log_->log(&request_headers_, &response_headers_, request_info_);
+
+  expectStreamStart();
+  EXPECT_CALL(stream_, sendMessage(_, false));
+  log_->log(&request_headers_, &response_headers_, request_info_);
+
+  // A closed stream is replaced by a new one, which starts with the identifier again.
+  callbacks_->onRemoteClose(Grpc::Status::GrpcStatus::Unavailable, "");
+  expectStreamStart();
+  envoy::accesslog::StreamAccessLogsMessage message;
+  EXPECT_CALL(stream_, sendMessage(_, false)).WillOnce(SaveArg<0>(&message));
+  log_->log(&request_headers_, &response_headers_, request_info_);
+  EXPECT_EQ("requests", message.identifier().log_name());
+}
+
+} // namespace AccessLog
+} // namespace Envoy
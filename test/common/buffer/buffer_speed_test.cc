@@ -0,0 +1,58 @@
+// Compares searching buffers made of many slices with each owned buffer implementation. Run with:
+// bazel run -c opt //test/common/buffer:buffer_speed_test
+
+#include <cstdint>
+#include <string>
+
+#include "common/buffer/buffer_impl.h"
+
+#include "benchmark/benchmark.h"
+
+namespace Envoy {
+namespace Buffer {
+
+// The size of the slices the buffers are made of, which is above the size that move() copies.
+static const uint64_t FragmentSize = 1024;
+
+// Builds a buffer of the given number of slices with the needle straddling the last two.
+template <class T> static void fillFragmented(T& buffer, uint64_t fragments, char filler) {
+  const std::string needle = "\r\n\r\n";
+  for (uint64_t i = 0; i < fragments; i++) {
+    std::string fragment(FragmentSize, filler);
+    if (i == fragments - 2) {
+      fragment.replace(FragmentSize - 2, 2, needle.substr(0, 2));
+    } else if (i == fragments - 1) {
+      fragment.replace(0, 2, needle.substr(2));
+    }
+    T other(fragment);
+    buffer.move(other);
+  }
+}
+
+// Searches for a needle whose first byte does not otherwise occur in the buffer.
+template <class T> static void BufferSearchFragmented(benchmark::State& state) {
+  T buffer;
+  fillFragmented(buffer, state.range(0), 'a');
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(buffer.search("\r\n\r\n", 4, 0));
+  }
+  state.SetBytesProcessed(state.iterations() * buffer.length());
+}
+BENCHMARK_TEMPLATE(BufferSearchFragmented, LibEventOwnedImpl)->Arg(2)->Arg(16)->Arg(256);
+BENCHMARK_TEMPLATE(BufferSearchFragmented, SliceOwnedImpl)->Arg(2)->Arg(16)->Arg(256);
+
+// Searches for a needle whose first byte is every other byte of the buffer, which is the worst
+// case for finding candidates by their first byte.
+template <class T> static void BufferSearchFragmentedFalseStarts(benchmark::State& state) {
+  T buffer;
+  fillFragmented(buffer, state.range(0), '\r');
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(buffer.search("\r\n\r\n", 4, 0));
+  }
+  state.SetBytesProcessed(state.iterations() * buffer.length());
+}
+BENCHMARK_TEMPLATE(BufferSearchFragmentedFalseStarts, LibEventOwnedImpl)->Arg(2)->Arg(16);
+BENCHMARK_TEMPLATE(BufferSearchFragmentedFalseStarts, SliceOwnedImpl)->Arg(2)->Arg(16);
+
+} // namespace Buffer
+} // namespace Envoy
@@ -0,0 +1,390 @@
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/stats/stats_impl.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Buffer {
+namespace {
+
+// Tests which apply to every owned buffer implementation.
+template <class T> class OwnedImplTest : public testing::Test {};
+
+typedef testing::Types<LibEventOwnedImpl, SliceOwnedImpl> OwnedImplTypes;
+TYPED_TEST_CASE(OwnedImplTest, OwnedImplTypes);
+
+template <class T> std::string bufferToString(const T& buffer) {
+  std::string output(buffer.length(), '\0');
+  buffer.copyOut(0, buffer.length(), &output[0]);
+  return output;
+}
+
+TYPED_TEST(OwnedImplTest, AddAndDrain) {
+  TypeParam buffer;
+  buffer.add("hello");
+  buffer.add(std::string(" world"));
+  EXPECT_EQ(11, buffer.length());
+  EXPECT_EQ("hello world", bufferToString(buffer));
+
+  buffer.drain(6);
+  EXPECT_EQ("world", bufferToString(buffer));
+  buffer.drain(5);
+  EXPECT_EQ(0, buffer.length());
+  EXPECT_EQ(0, buffer.getRawSlices(nullptr, 0));
+}
+
+TYPED_TEST(OwnedImplTest, AddLargerThanSlice) {
+  const std::string data(Slice::DefaultSize * 2 + 100, 'a');
+  TypeParam buffer(data);
+  EXPECT_EQ(data.size(), buffer.length());
+  EXPECT_EQ(data, bufferToString(buffer));
+
+  buffer.drain(Slice::DefaultSize + 50);
+  EXPECT_EQ(std::string(Slice::DefaultSize + 50, 'a'), bufferToString(buffer));
+}
+
+TYPED_TEST(OwnedImplTest, AddBuffer) {
+  TypeParam source("hello");
+  TypeParam buffer(" ");
+  buffer.add(source);
+  EXPECT_EQ(" hello", bufferToString(buffer));
+  EXPECT_EQ(5, source.length());
+}
+
+TYPED_TEST(OwnedImplTest, AddBufferReference) {
+  TypeParam buffer("a");
+  {
+    TypeParam source("hello");
+    buffer.addBufferReference(source);
+    EXPECT_EQ(5, source.length());
+    source.drain(2);
+  }
+  EXPECT_EQ("ahello", bufferToString(buffer));
+}
+
+TYPED_TEST(OwnedImplTest, Compact) {
+  TypeParam buffer;
+  TypeParam other("world");
+  buffer.add(std::string(1000, 'a') + "hello ");
+  buffer.move(other);
+  buffer.drain(1000);
+
+  buffer.compact();
+  EXPECT_EQ(1, buffer.getRawSlices(nullptr, 0));
+  EXPECT_EQ("hello world", bufferToString(buffer));
+
+  buffer.add("!");
+  EXPECT_EQ("hello world!", bufferToString(buffer));
+}
+
+TYPED_TEST(OwnedImplTest, CompactLeavesLargeBuffers) {
+  TypeParam buffer;
+  TypeParam other(std::string(TypeParam::CompactThreshold, 'b'));
+  buffer.add("a");
+  buffer.move(other);
+
+  buffer.compact();
+  EXPECT_EQ(TypeParam::CompactThreshold + 1, buffer.length());
+  EXPECT_EQ("a" + std::string(TypeParam::CompactThreshold, 'b'), bufferToString(buffer));
+}
+
+TYPED_TEST(OwnedImplTest, CopyOutAcrossSlices) {
+  TypeParam buffer;
+  TypeParam other("world");
+  buffer.add("hello ");
+  buffer.move(other);
+
+  char out[7];
+  buffer.copyOut(3, 7, out);
+  EXPECT_EQ("lo worl", std::string(out, 7));
+}
+
+TYPED_TEST(OwnedImplTest, ReserveCommit) {
+  TypeParam buffer("a");
+  RawSlice iovecs[2];
+  const uint64_t num_iovecs = buffer.reserve(100, iovecs, 2);
+  EXPECT_LE(1, num_iovecs);
+  EXPECT_LE(100, iovecs[0].len_ + (num_iovecs > 1 ? iovecs[1].len_ : 0));
+
+  memcpy(iovecs[0].mem_, "bcd", 3);
+  iovecs[0].len_ = 3;
+  buffer.commit(iovecs, 1);
+  EXPECT_EQ("abcd", bufferToString(buffer));
+  EXPECT_EQ(1, buffer.getRawSlices(nullptr, 0));
+}
+
+TYPED_TEST(OwnedImplTest, ReserveSingleIovec) {
+  TypeParam buffer("a");
+  RawSlice iovec;
+  EXPECT_EQ(1, buffer.reserve(Slice::DefaultSize * 2, &iovec, 1));
+  EXPECT_LE(Slice::DefaultSize * 2, iovec.len_);
+  memset(iovec.mem_, 'b', Slice::DefaultSize * 2);
+  iovec.len_ = Slice::DefaultSize * 2;
+  buffer.commit(&iovec, 1);
+  EXPECT_EQ("a" + std::string(Slice::DefaultSize * 2, 'b'), bufferToString(buffer));
+}
+
+TYPED_TEST(OwnedImplTest, CommitNothing) {
+  TypeParam buffer("a");
+  RawSlice iovecs[2];
+  const uint64_t num_iovecs = buffer.reserve(Slice::DefaultSize * 2, iovecs, 2);
+  for (uint64_t i = 0; i < num_iovecs; i++) {
+    iovecs[i].len_ = 0;
+  }
+  buffer.commit(iovecs, num_iovecs);
+  EXPECT_EQ(1, buffer.length());
+  EXPECT_EQ(1, buffer.getRawSlices(nullptr, 0));
+}
+
+TYPED_TEST(OwnedImplTest, Linearize) {
+  TypeParam buffer("hello ");
+  TypeParam other("world");
+  buffer.move(other);
+
+  const char* data = static_cast<const char*>(buffer.linearize(11));
+  EXPECT_EQ("hello world", std::string(data, 11));
+  EXPECT_EQ(11, buffer.length());
+  EXPECT_EQ("hello world", bufferToString(buffer));
+}
+
+TYPED_TEST(OwnedImplTest, Move) {
+  TypeParam buffer("hello");
+  TypeParam other(" world");
+  buffer.move(other);
+  EXPECT_EQ("hello world", bufferToString(buffer));
+  EXPECT_EQ(0, other.length());
+}
+
+TYPED_TEST(OwnedImplTest, MovePartial) {
+  const std::string data(Slice::DefaultSize + 10, 'a');
+  TypeParam other(data + "bcd");
+  TypeParam buffer;
+  buffer.move(other, Slice::DefaultSize + 11);
+  EXPECT_EQ(data + "b", bufferToString(buffer));
+  EXPECT_EQ("cd", bufferToString(other));
+
+  buffer.move(other, 2);
+  EXPECT_EQ(data + "bcd", bufferToString(buffer));
+  EXPECT_EQ(0, other.length());
+}
+
+TYPED_TEST(OwnedImplTest, Search) {
+  TypeParam buffer("abcab");
+  TypeParam other("cabd");
+  buffer.move(other);
+
+  EXPECT_EQ(0, buffer.search("abc", 3, 0));
+  EXPECT_EQ(3, buffer.search("abc", 3, 1));
+  EXPECT_EQ(6, buffer.search("abd", 3, 0));
+  EXPECT_EQ(-1, buffer.search("abe", 3, 0));
+  EXPECT_EQ(-1, buffer.search("abc", 3, 7));
+  EXPECT_EQ(-1, buffer.search("abc", 3, 100));
+}
+
+// Matches that start in one slice and end in the next are found, and partial matches at the end of
+// a slice do not hide later ones.
+TYPED_TEST(OwnedImplTest, SearchAcrossSlices) {
+  TypeParam buffer;
+  for (const std::string& fragment :
+       {std::string(1024, 'a') + "ab", "x" + std::string(1022, 'b') + "abc",
+        "d" + std::string(1023, 'c')}) {
+    TypeParam other(fragment);
+    buffer.move(other);
+  }
+  ASSERT_EQ(3076, buffer.length());
+
+  EXPECT_EQ(1024, buffer.search("abx", 3, 0));
+  EXPECT_EQ(2049, buffer.search("abcd", 4, 0));
+  EXPECT_EQ(2049, buffer.search("abcd", 4, 1025));
+  EXPECT_EQ(-1, buffer.search("abcd", 4, 2050));
+  EXPECT_EQ(2052, buffer.search("dc", 2, 0));
+  EXPECT_EQ(-1, buffer.search("abd", 3, 0));
+}
+
+TYPED_TEST(OwnedImplTest, ReadWrite) {
+  int fds[2];
+  ASSERT_EQ(0, pipe(fds));
+  ASSERT_EQ(0, fcntl(fds[0], F_SETFL, O_NONBLOCK));
+
+  const std::string data(Slice::DefaultSize + 100, 'a');
+  TypeParam write_buffer(data);
+  uint64_t written = 0;
+  while (written < data.size()) {
+    const int rc = write_buffer.write(fds[1]);
+    ASSERT_GT(rc, 0);
+    written += rc;
+  }
+  EXPECT_EQ(0, write_buffer.length());
+
+  TypeParam read_buffer;
+  while (read_buffer.length() < data.size()) {
+    const int rc = read_buffer.read(fds[0], 16384);
+    ASSERT_GT(rc, 0);
+  }
+  EXPECT_EQ(data, bufferToString(read_buffer));
+
+  EXPECT_EQ(-1, read_buffer.read(fds[0], 16384));
+  EXPECT_EQ(EAGAIN, errno);
+  EXPECT_EQ(data.size(), read_buffer.length());
+
+  close(fds[0]);
+  close(fds[1]);
+}
+
+// A single read takes everything that is available, up to max_length, even when that spans several
+// slices.
+TYPED_TEST(OwnedImplTest, ReadLarge) {
+  int fds[2];
+  ASSERT_EQ(0, pipe(fds));
+  ASSERT_EQ(0, fcntl(fds[0], F_SETFL, O_NONBLOCK));
+
+  const std::string data(60000, 'a');
+  TypeParam write_buffer(data);
+  while (write_buffer.length() > 0) {
+    ASSERT_GT(write_buffer.write(fds[1]), 0);
+  }
+
+  TypeParam read_buffer("b");
+  EXPECT_EQ(50000, read_buffer.read(fds[0], 50000));
+  EXPECT_EQ(10000, read_buffer.read(fds[0], 65536));
+  EXPECT_EQ("b" + data, bufferToString(read_buffer));
+
+  EXPECT_EQ(-1, read_buffer.read(fds[0], 65536));
+  EXPECT_EQ(EAGAIN, errno);
+  EXPECT_EQ(data.size() + 1, read_buffer.length());
+
+  close(fds[0]);
+  close(fds[1]);
+}
+
+TEST(LibEventOwnedImplTest, AddBufferReferenceSharesMemory) {
+  LibEventOwnedImpl source("hello");
+  RawSlice source_slice;
+  ASSERT_EQ(1, source.getRawSlices(&source_slice, 1));
+
+  LibEventOwnedImpl buffer;
+  buffer.addBufferReference(source);
+  RawSlice slice;
+  ASSERT_EQ(1, buffer.getRawSlices(&slice, 1));
+  EXPECT_EQ(source_slice.mem_, slice.mem_);
+  EXPECT_EQ(5, slice.len_);
+
+  // A buffer which holds references can only be copied.
+  LibEventOwnedImpl copy;
+  copy.addBufferReference(buffer);
+  EXPECT_EQ("hello", bufferToString(copy));
+}
+
+TEST(SliceOwnedImplTest, MoveTransfersSlices) {
+  const std::string data(SliceOwnedImpl::MoveCopyThreshold + 1, 'a');
+  SliceOwnedImpl source(data);
+  RawSlice source_slice;
+  ASSERT_EQ(1, source.getRawSlices(&source_slice, 1));
+
+  SliceOwnedImpl buffer("b");
+  buffer.move(source);
+
+  RawSlice slices[2];
+  ASSERT_EQ(2, buffer.getRawSlices(slices, 2));
+  EXPECT_EQ(source_slice.mem_, slices[1].mem_);
+  EXPECT_EQ(source_slice.len_, slices[1].len_);
+}
+
+TEST(SliceOwnedImplTest, MoveCoalescesSmallSlices) {
+  SliceOwnedImpl buffer("hello");
+  for (int i = 0; i < 10; i++) {
+    SliceOwnedImpl source("a");
+    buffer.move(source);
+  }
+
+  EXPECT_EQ(1, buffer.getRawSlices(nullptr, 0));
+  EXPECT_EQ("hello" + std::string(10, 'a'), bufferToString(buffer));
+}
+
+TEST(SliceOwnedImplTest, SlicesAreRecycled) {
+  {
+    SliceOwnedImpl buffer("a");
+  }
+  const uint64_t free_slices = SlicePool::current().size();
+  EXPECT_LT(0, free_slices);
+
+  SliceOwnedImpl buffer("a");
+  EXPECT_EQ(free_slices - 1, SlicePool::current().size());
+  buffer.drain(1);
+  EXPECT_EQ(free_slices, SlicePool::current().size());
+}
+
+TEST(SliceOwnedImplTest, CompactReleasesSlices) {
+  SliceOwnedImpl buffer("hello");
+  const uint64_t free_slices = SlicePool::current().size();
+
+  buffer.compact();
+  EXPECT_EQ(free_slices + 1, SlicePool::current().size());
+  EXPECT_EQ("hello", bufferToString(buffer));
+  buffer.drain(5);
+  EXPECT_EQ(free_slices + 1, SlicePool::current().size());
+}
+
+TEST(SliceOwnedImplTest, LargeSlicesAreNotRecycled) {
+  const uint64_t free_slices = SlicePool::current().size();
+  {
+    SlicePtr slice = Slice::create(Slice::DefaultSize + 1);
+    EXPECT_EQ(Slice::DefaultSize + 1, slice->capacity());
+  }
+  EXPECT_EQ(free_slices, SlicePool::current().size());
+}
+
+TEST(SlicePoolTest, InstalledPoolIsShared) {
+  Stats::IsolatedStoreImpl store;
+  SlicePool pool;
+  pool.initializeStats(store, "test.");
+  SlicePool* previous = SlicePool::setCurrent(&pool);
+  EXPECT_EQ(&pool, &SlicePool::current());
+
+  {
+    SliceOwnedImpl buffer1("a");
+    SliceOwnedImpl buffer2("b");
+  }
+  EXPECT_EQ(2, pool.size());
+  EXPECT_EQ(2, store.counter("test.slice_pool.allocated").value());
+  EXPECT_EQ(2, store.gauge("test.slice_pool.pooled").value());
+
+  SliceOwnedImpl buffer3("c");
+  EXPECT_EQ(1, pool.size());
+  EXPECT_EQ(1, store.counter("test.slice_pool.reused").value());
+  EXPECT_EQ(1, store.gauge("test.slice_pool.pooled").value());
+
+  EXPECT_EQ(&pool, SlicePool::setCurrent(previous));
+  EXPECT_NE(&pool, &SlicePool::current());
+}
+
+TEST(SlicePoolTest, TrimToLowWatermark) {
+  Stats::IsolatedStoreImpl store;
+  SlicePool pool(2, 4);
+  pool.initializeStats(store, "test.");
+
+  std::vector<SlicePtr> slices;
+  for (int i = 0; i < 5; i++) {
+    slices.emplace_back(pool.allocate());
+  }
+  for (int i = 0; i < 4; i++) {
+    pool.release(slices[i].release());
+  }
+  EXPECT_EQ(4, pool.size());
+  EXPECT_EQ(0, store.counter("test.slice_pool.freed").value());
+
+  pool.release(slices[4].release());
+  EXPECT_EQ(2, pool.size());
+  EXPECT_EQ(3, store.counter("test.slice_pool.freed").value());
+  EXPECT_EQ(2, store.gauge("test.slice_pool.pooled").value());
+}
+
+} // namespace
+} // namespace Buffer
+} // namespace Envoy
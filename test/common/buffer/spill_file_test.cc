@@ -0,0 +1,42 @@
+#include <string>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/buffer/spill_file.h"
+
+#include "test/test_common/environment.h"
+#include "test/test_common/utility.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Buffer {
+
+TEST(SpillFileTest, WriteAndReadBack) {
+  SpillFilePtr file = SpillFile::create(TestEnvironment::temporaryDirectory());
+  ASSERT_NE(nullptr, file);
+
+  OwnedImpl data("hello");
+  EXPECT_TRUE(file->write(data));
+  EXPECT_EQ(0, data.length());
+  OwnedImpl more(" world");
+  EXPECT_TRUE(file->write(more));
+  EXPECT_EQ(11, file->length());
+  EXPECT_EQ(11, file->unreadLength());
+
+  OwnedImpl out;
+  EXPECT_TRUE(file->read(out, 4));
+  EXPECT_EQ("hell", TestUtility::bufferToString(out));
+  EXPECT_EQ(7, file->unreadLength());
+
+  // Reads stop at the end of the data.
+  EXPECT_TRUE(file->read(out, 100));
+  EXPECT_EQ("hello world", TestUtility::bufferToString(out));
+  EXPECT_EQ(0, file->unreadLength());
+}
+
+TEST(SpillFileTest, CreateFailure) {
+  EXPECT_EQ(nullptr, SpillFile::create("/nonexistent/directory"));
+}
+
+} // namespace Buffer
+} // namespace Envoy
@@ -52,6 +52,26 @@ TEST_F(WatermarkBufferTest, AddString) {
   EXPECT_EQ(11, buffer_.length());
 }
 
+TEST_F(WatermarkBufferTest, AddBufferReference) {
+  OwnedImpl first(TEN_BYTES);
+  buffer_.addBufferReference(first);
+  EXPECT_EQ(0, times_high_watermark_called_);
+  OwnedImpl second("a");
+  buffer_.addBufferReference(second);
+  EXPECT_EQ(1, times_high_watermark_called_);
+  EXPECT_EQ(11, buffer_.length());
+}
+
+TEST_F(WatermarkBufferTest, Compact) {
+  buffer_.add(TEN_BYTES, 10);
+  buffer_.add("a", 1);
+  EXPECT_EQ(1, times_high_watermark_called_);
+  buffer_.compact();
+  EXPECT_EQ(1, times_high_watermark_called_);
+  EXPECT_EQ(0, times_low_watermark_called_);
+  EXPECT_EQ(11, buffer_.length());
+}
+
 TEST_F(WatermarkBufferTest, AddBuffer) {
   OwnedImpl first(TEN_BYTES);
   buffer_.add(first);
@@ -0,0 +1,86 @@
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <string>
+
+#include "common/common/arena.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+
+TEST(ArenaTest, AllocationsAreAlignedAndPacked) {
+  Arena arena(1024);
+  EXPECT_EQ(0U, arena.blockCount());
+
+  uint8_t* first = static_cast<uint8_t*>(arena.allocate(1));
+  uint8_t* second = static_cast<uint8_t*>(arena.allocate(24));
+  EXPECT_EQ(0U, reinterpret_cast<uintptr_t>(first) % alignof(std::max_align_t));
+  EXPECT_EQ(0U, reinterpret_cast<uintptr_t>(second) % alignof(std::max_align_t));
+  EXPECT_EQ(first + alignof(std::max_align_t), second);
+  EXPECT_EQ(1U, arena.blockCount());
+}
+
+TEST(ArenaTest, GrowsByBlocks) {
+  Arena arena(256);
+  for (size_t i = 0; i < 16; i++) {
+    memset(arena.allocate(64), 'a', 64);
+  }
+  EXPECT_EQ(4U, arena.blockCount());
+  EXPECT_EQ(1024U, arena.bytesAllocated());
+
+  // Oversized allocations get their own block.
+  memset(arena.allocate(4096), 'b', 4096);
+  EXPECT_EQ(5U, arena.blockCount());
+}
+
+class TestArenaObject : public ArenaAllocated {
+public:
+  TestArenaObject(int& destroyed) : destroyed_(destroyed) {}
+  virtual ~TestArenaObject() { destroyed_++; }
+
+  int& destroyed_;
+  std::string value_{"some value that is long enough to need its own allocation"};
+};
+
+class DerivedTestArenaObject : public TestArenaObject {
+public:
+  DerivedTestArenaObject(int& destroyed) : TestArenaObject(destroyed) {}
+
+  uint64_t extra_[8]{};
+};
+
+TEST(ArenaAllocatedTest, ArenaAndHeap) {
+  int destroyed = 0;
+  Arena arena;
+  {
+    std::unique_ptr<TestArenaObject> from_arena(new (&arena) TestArenaObject(destroyed));
+    std::unique_ptr<TestArenaObject> derived(new (&arena) DerivedTestArenaObject(destroyed));
+    std::unique_ptr<TestArenaObject> from_heap(new (nullptr) TestArenaObject(destroyed));
+    EXPECT_EQ(1U, arena.blockCount());
+    EXPECT_LT(sizeof(TestArenaObject) + sizeof(DerivedTestArenaObject), arena.bytesAllocated());
+  }
+  // Destructors run for all objects regardless of where they were allocated.
+  EXPECT_EQ(3, destroyed);
+}
+
+TEST(ArenaAllocatorTest, ListNodes) {
+  Arena arena;
+  std::list<std::string, ArenaAllocator<std::string>> from_arena(&arena);
+  std::list<std::string, ArenaAllocator<std::string>> from_heap(nullptr);
+  for (int i = 0; i < 4; i++) {
+    from_arena.push_back(std::to_string(i));
+    from_heap.push_back(std::to_string(i));
+  }
+  from_arena.pop_front();
+  from_heap.pop_front();
+
+  EXPECT_EQ(1U, arena.blockCount());
+  EXPECT_LE(4 * sizeof(std::string), arena.bytesAllocated());
+  EXPECT_EQ("1", from_arena.front());
+  EXPECT_EQ("1", from_heap.front());
+  EXPECT_TRUE(from_arena.get_allocator() != from_heap.get_allocator());
+}
+
+} // namespace Envoy
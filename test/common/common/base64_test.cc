@@ -1,9 +1,11 @@
 #include <string>
+#include <vector>
 
 #include "common/buffer/buffer_impl.h"
 #include "common/common/base64.h"
 
 #include "test/test_common/printers.h"
+#include "test/test_common/utility.h"
 
 #include "gtest/gtest.h"
 
@@ -74,6 +76,25 @@ TEST(Base64Test, Decode) {
   }
 }
 
+TEST(Base64Test, DecodeCharBuffer) {
+  // Only the given length is decoded.
+  const char* input = "Zm9vYmFy!";
+  EXPECT_EQ("foo", Base64::decode(input, 4));
+  EXPECT_EQ("foobar", Base64::decode(input, 8));
+  EXPECT_EQ("", Base64::decode(input, 9));
+  EXPECT_EQ("", Base64::decode(input, 0));
+}
+
+TEST(Base64Test, EncodeToCharBuffer) {
+  for (const std::string& input : {std::string(""), std::string("f"), std::string("fo"),
+                                   std::string("foo"), std::string("foobar"),
+                                   std::string("\0\1\2\3\b\n\t\xaa\xbc\xde", 10)}) {
+    std::string output(Base64::encodedLength(input.size()), '?');
+    Base64::encode(input.data(), input.size(), &output[0]);
+    EXPECT_EQ(Base64::encode(input.data(), input.size()), output);
+  }
+}
+
 TEST(Base64Test, DecodeFailure) {
   EXPECT_EQ("", Base64::decode("==Zg"));
   EXPECT_EQ("", Base64::decode("=Zm8"));
@@ -108,4 +129,64 @@ TEST(Base64Test, BinaryBufferEncode) {
   EXPECT_EQ("AAECAwgKCQCqvA==", Base64::encode(buffer, 10));
   EXPECT_EQ("AAECAwgKCQCqvN4=", Base64::encode(buffer, 30));
 }
+
+// Builds a buffer whose slices hold the given pieces, so that groups straddle slices.
+static void addSlices(Buffer::Instance& buffer, const std::vector<std::string>& pieces) {
+  for (const std::string& piece : pieces) {
+    Buffer::OwnedImpl slice(piece);
+    buffer.move(slice);
+  }
+}
+
+TEST(Base64Test, BufferToBufferEncode) {
+  const std::vector<std::vector<std::string>> inputs = {
+      {"foobar"}, {"f", "o", "o", "b", "a", "r"}, {"fo", "obar"}, {"foob", "ar"}, {"fooba"}};
+  for (const auto& pieces : inputs) {
+    Buffer::OwnedImpl input;
+    addSlices(input, pieces);
+    Buffer::OwnedImpl output("prefix:");
+    Base64::encode(input, output);
+    EXPECT_EQ("prefix:" + Base64::encode(input, input.length()),
+              TestUtility::bufferToString(output));
+  }
+
+  Buffer::OwnedImpl empty;
+  Buffer::OwnedImpl output;
+  Base64::encode(empty, output);
+  EXPECT_EQ(0, output.length());
+}
+
+TEST(Base64Test, BufferToBufferDecode) {
+  const std::vector<std::vector<std::string>> inputs = {
+      {"Zm9vYmFy"}, {"Z", "m9", "vYm", "Fy"}, {"Zm9vYg=", "="}, {"Zm9", "vYmE="}};
+  for (const auto& pieces : inputs) {
+    Buffer::OwnedImpl input;
+    addSlices(input, pieces);
+    Buffer::OwnedImpl output("prefix:");
+    EXPECT_TRUE(Base64::decode(input, output));
+    EXPECT_EQ("prefix:" + Base64::decode(TestUtility::bufferToString(input)),
+              TestUtility::bufferToString(output));
+  }
+
+  {
+    const std::string binary("\0\1\2\3\b\n\t\xaa\xbc\xde", 10);
+    Buffer::OwnedImpl input(binary);
+    Buffer::OwnedImpl encoded;
+    Buffer::OwnedImpl decoded;
+    Base64::encode(input, encoded);
+    EXPECT_TRUE(Base64::decode(encoded, decoded));
+    EXPECT_EQ(binary, TestUtility::bufferToString(decoded));
+  }
+}
+
+TEST(Base64Test, BufferToBufferDecodeFailure) {
+  for (const std::string& invalid : {"", "123", "==Zg", "Zm=8", "Zh==", "Zm9=", "Zg..",
+                                     "Zg==Zm9v", "Zm9vA==="}) {
+    Buffer::OwnedImpl input;
+    addSlices(input, {invalid.substr(0, 2), invalid.substr(2)});
+    Buffer::OwnedImpl output("prefix:");
+    EXPECT_FALSE(Base64::decode(input, output));
+    EXPECT_EQ("prefix:", TestUtility::bufferToString(output));
+  }
+}
 } // namespace Envoy
@@ -34,4 +34,29 @@ TEST(Hex, UIntToHex) {
   EXPECT_EQ("25c6f38dd0600e78", base16_string);
   EXPECT_EQ("0000000000000000", Hex::uint64ToHex(0ULL));
 }
+
+TEST(Hex, UIntToHexBuffer) {
+  char buffer[Hex::UINT64_HEX_LENGTH + 1] = {};
+  Hex::uint64ToHex(18446744073709551615ULL, buffer);
+  EXPECT_STREQ("ffffffffffffffff", buffer);
+  Hex::uint64ToHex(2722130815203937912ULL, buffer);
+  EXPECT_STREQ("25c6f38dd0600e78", buffer);
+}
+
+TEST(Hex, HexToUInt) {
+  uint64_t value = 0;
+  EXPECT_TRUE(Hex::hexToUint64("25c6f38dd0600e78", value));
+  EXPECT_EQ(2722130815203937912ULL, value);
+  EXPECT_TRUE(Hex::hexToUint64("25C6F38DD0600E78", value));
+  EXPECT_EQ(2722130815203937912ULL, value);
+  // Only the first 16 characters are read.
+  EXPECT_TRUE(Hex::hexToUint64("ffffffffffffffff;tail", value));
+  EXPECT_EQ(18446744073709551615ULL, value);
+
+  value = 1;
+  EXPECT_FALSE(Hex::hexToUint64("25c6f38dd0600e7g", value));
+  EXPECT_FALSE(Hex::hexToUint64("25c6f38dd0600e7", value));
+  EXPECT_FALSE(Hex::hexToUint64("-5c6f38dd0600e78", value));
+  EXPECT_EQ(1ULL, value);
+}
 } // namespace Envoy
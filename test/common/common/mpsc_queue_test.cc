@@ -0,0 +1,78 @@
+#include <deque>
+#include <thread>
+#include <vector>
+
+#include "common/common/mpsc_queue.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+
+struct TestElement : public MpscQueue<TestElement>::Node {
+  TestElement(uint32_t producer, uint32_t value) : producer_(producer), value_(value) {}
+
+  const uint32_t producer_;
+  const uint32_t value_;
+};
+
+TEST(MpscQueueTest, Fifo) {
+  MpscQueue<TestElement> queue;
+  EXPECT_EQ(nullptr, queue.pop());
+
+  TestElement a(0, 1);
+  TestElement b(0, 2);
+  TestElement c(0, 3);
+  queue.push(a);
+  EXPECT_EQ(&a, queue.pop());
+  EXPECT_EQ(nullptr, queue.pop());
+
+  queue.push(b);
+  queue.push(c);
+  EXPECT_EQ(&b, queue.pop());
+  queue.push(a);
+  EXPECT_EQ(&c, queue.pop());
+  EXPECT_EQ(&a, queue.pop());
+  EXPECT_EQ(nullptr, queue.pop());
+}
+
+// Every element pushed by concurrent producers is popped exactly once, in the order each producer
+// pushed them.
+TEST(MpscQueueTest, ConcurrentProducers) {
+  const uint32_t producers = 4;
+  const uint32_t per_producer = 10000;
+  MpscQueue<TestElement> queue;
+  std::vector<std::deque<TestElement>> elements(producers);
+  for (uint32_t i = 0; i < producers; i++) {
+    for (uint32_t j = 0; j < per_producer; j++) {
+      elements[i].emplace_back(i, j);
+    }
+  }
+
+  std::vector<std::thread> threads;
+  for (uint32_t i = 0; i < producers; i++) {
+    threads.emplace_back([&queue, &elements, i]() -> void {
+      for (TestElement& element : elements[i]) {
+        queue.push(element);
+      }
+    });
+  }
+
+  std::vector<uint32_t> next(producers, 0);
+  uint32_t popped = 0;
+  while (popped < producers * per_producer) {
+    TestElement* element = queue.pop();
+    if (element == nullptr) {
+      std::this_thread::yield();
+      continue;
+    }
+    ASSERT_EQ(next[element->producer_]++, element->value_);
+    popped++;
+  }
+
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(nullptr, queue.pop());
+}
+
+} // namespace Envoy
@@ -0,0 +1,87 @@
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/common/read_mostly_map.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+
+TEST(ReadMostlyMapTest, InsertAndFind) {
+  ReadMostlyMap<std::unique_ptr<int>> map;
+  EXPECT_EQ(nullptr, map.find("foo"));
+  EXPECT_EQ(0UL, map.size());
+
+  const std::unique_ptr<int>& foo = map.insert("foo", std::unique_ptr<int>{new int(1)});
+  EXPECT_EQ(1, *foo);
+  EXPECT_EQ(&foo, map.find("foo"));
+  EXPECT_EQ(nullptr, map.find("bar"));
+  EXPECT_EQ(nullptr, map.find(""));
+  EXPECT_EQ(1UL, map.size());
+}
+
+TEST(ReadMostlyMapTest, Grow) {
+  ReadMostlyMap<int> map;
+  std::vector<const int*> values;
+  for (int i = 0; i < 1000; i++) {
+    values.push_back(&map.insert(std::to_string(i), int(i)));
+  }
+  EXPECT_EQ(1000UL, map.size());
+
+  // Values never move, even when the table grows.
+  for (int i = 0; i < 1000; i++) {
+    EXPECT_EQ(values[i], map.find(std::to_string(i)));
+    EXPECT_EQ(i, *values[i]);
+  }
+  EXPECT_EQ(nullptr, map.find("1000"));
+
+  int expected = 0;
+  map.forEach([&expected](const std::string& key, const int& value) -> void {
+    EXPECT_EQ(std::to_string(expected), key);
+    EXPECT_EQ(expected++, value);
+  });
+  EXPECT_EQ(1000, expected);
+}
+
+TEST(ReadMostlyMapTest, ConcurrentReaders) {
+  ReadMostlyMap<int> map;
+  std::mutex lock;
+  std::atomic<bool> done{};
+  const int count = 10000;
+
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 4; i++) {
+    readers.emplace_back([&map, &done]() -> void {
+      while (!done) {
+        // Once a key is found every key inserted before it must be found too.
+        int found = -1;
+        for (int key = count - 1; key >= 0; key--) {
+          const int* value = map.find(std::to_string(key));
+          if (found == -1 && value != nullptr) {
+            found = key;
+          }
+          if (found != -1) {
+            ASSERT_NE(nullptr, value);
+            ASSERT_EQ(key, *value);
+          }
+        }
+      }
+    });
+  }
+
+  for (int key = 0; key < count; key++) {
+    std::unique_lock<std::mutex> guard(lock);
+    map.insert(std::to_string(key), int(key));
+  }
+  done = true;
+  for (std::thread& reader : readers) {
+    reader.join();
+  }
+  EXPECT_EQ(static_cast<size_t>(count), map.size());
+}
+
+} // namespace Envoy
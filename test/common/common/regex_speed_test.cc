@@ -0,0 +1,88 @@
+#include <string>
+#include <vector>
+
+#include "common/common/regex.h"
+
+#include "benchmark/benchmark.h"
+#include "fmt/format.h"
+
+namespace Envoy {
+namespace Regex {
+namespace {
+
+const std::vector<std::string>& paths() {
+  static const std::vector<std::string> paths{"/users/123/chargeaccounts/hello123",
+                                              "/users/123/chargeaccounts", "/rides/12345",
+                                              "/api/v2/users/abcdefghijklmnopqrstuvwxyz"};
+  return paths;
+}
+
+template <class T> void matchVirtualClusterPattern(benchmark::State& state) {
+  const T matcher("^/users/\\d+/chargeaccounts/[^v\\W]\\w*$");
+  while (state.KeepRunning()) {
+    for (const std::string& path : paths()) {
+      benchmark::DoNotOptimize(matcher.match(path.c_str(), path.size()));
+    }
+  }
+}
+
+// (a+)+b against a run of 'a's forces a backtracking engine to try every way of splitting the
+// run, so std::regex is exponential in the input length while RE2 stays linear.
+template <class T> void matchNestedQuantifiers(benchmark::State& state) {
+  const T matcher("(a+)+b");
+  const std::string value(state.range(0), 'a');
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(matcher.match(value.c_str(), value.size()));
+  }
+}
+
+// A virtual host with many virtual clusters, matched against a path that matches none of them.
+template <class T> void matchVirtualClusterSet(benchmark::State& state) {
+  std::vector<std::string> patterns;
+  for (int64_t i = 0; i < state.range(0); i++) {
+    patterns.push_back(fmt::format("^/service_{}/\\d+/resource$", i));
+  }
+  const T set(patterns);
+  const std::string path = "/service_unknown/12345/resource";
+  std::vector<uint32_t> matches;
+  while (state.KeepRunning()) {
+    matches.clear();
+    set.match(path.c_str(), path.size(), matches);
+    benchmark::DoNotOptimize(matches.data());
+  }
+}
+
+} // namespace
+
+static void StdRegexVirtualClusterPattern(benchmark::State& state) {
+  matchVirtualClusterPattern<StdRegexMatcher>(state);
+}
+BENCHMARK(StdRegexVirtualClusterPattern);
+
+static void Re2VirtualClusterPattern(benchmark::State& state) {
+  matchVirtualClusterPattern<Re2Matcher>(state);
+}
+BENCHMARK(Re2VirtualClusterPattern);
+
+static void StdRegexNestedQuantifiers(benchmark::State& state) {
+  matchNestedQuantifiers<StdRegexMatcher>(state);
+}
+BENCHMARK(StdRegexNestedQuantifiers)->Arg(8)->Arg(16)->Arg(20);
+
+static void Re2NestedQuantifiers(benchmark::State& state) {
+  matchNestedQuantifiers<Re2Matcher>(state);
+}
+BENCHMARK(Re2NestedQuantifiers)->Arg(8)->Arg(16)->Arg(20)->Arg(4096);
+
+static void StdRegexVirtualClusterSet(benchmark::State& state) {
+  matchVirtualClusterSet<StdRegexMatcherSet>(state);
+}
+BENCHMARK(StdRegexVirtualClusterSet)->Arg(10)->Arg(250);
+
+static void Re2VirtualClusterSet(benchmark::State& state) {
+  matchVirtualClusterSet<Re2MatcherSet>(state);
+}
+BENCHMARK(Re2VirtualClusterSet)->Arg(10)->Arg(250);
+
+} // namespace Regex
+} // namespace Envoy
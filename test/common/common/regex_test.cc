@@ -0,0 +1,124 @@
+#include <string>
+#include <vector>
+
+#include "common/common/regex.h"
+
+#include "test/test_common/utility.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Regex {
+
+template <class T> class CompiledMatcherTest : public testing::Test {};
+
+typedef testing::Types<StdRegexMatcher, Re2Matcher> MatcherTypes;
+TYPED_TEST_CASE(CompiledMatcherTest, MatcherTypes);
+
+TYPED_TEST(CompiledMatcherTest, FullMatch) {
+  const TypeParam matcher("/users/\\d+");
+  const std::string good = "/users/123";
+  const std::string suffix = "/users/123/location";
+  const std::string prefix = "/api/users/123";
+
+  EXPECT_TRUE(matcher.match(good.c_str(), good.size()));
+  EXPECT_FALSE(matcher.match(suffix.c_str(), suffix.size()));
+  EXPECT_FALSE(matcher.match(prefix.c_str(), prefix.size()));
+}
+
+TYPED_TEST(CompiledMatcherTest, MatchSubstringOnly) {
+  const TypeParam matcher("/b[io]t");
+  const std::string path = "/bit?query=true";
+
+  EXPECT_TRUE(matcher.match(path.c_str(), 4));
+  EXPECT_FALSE(matcher.match(path.c_str(), path.size()));
+  EXPECT_FALSE(matcher.match(path.c_str(), 0));
+}
+
+TYPED_TEST(CompiledMatcherTest, Anchors) {
+  const TypeParam matcher("^/rides$");
+  const std::string path = "/rides";
+
+  EXPECT_TRUE(matcher.match(path.c_str(), path.size()));
+}
+
+TYPED_TEST(CompiledMatcherTest, EmptyRegex) {
+  const TypeParam matcher("");
+
+  EXPECT_TRUE(matcher.match("", 0));
+  EXPECT_FALSE(matcher.match("a", 1));
+}
+
+TYPED_TEST(CompiledMatcherTest, InvalidRegex) {
+  EXPECT_THROW(TypeParam("/foo[bar"), EnvoyException);
+}
+
+template <class T> class CompiledMatcherSetTest : public testing::Test {};
+
+typedef testing::Types<StdRegexMatcherSet, Re2MatcherSet> MatcherSetTypes;
+TYPED_TEST_CASE(CompiledMatcherSetTest, MatcherSetTypes);
+
+TYPED_TEST(CompiledMatcherSetTest, MatchesInOrder) {
+  const TypeParam set({"^/users/\\d+$", "/rides", "/users/.*", ".*"});
+  std::vector<uint32_t> matches;
+
+  const std::string user = "/users/123";
+  set.match(user.c_str(), user.size(), matches);
+  EXPECT_EQ((std::vector<uint32_t>{0, 2, 3}), matches);
+
+  matches.clear();
+  const std::string rides = "/rides";
+  set.match(rides.c_str(), rides.size(), matches);
+  EXPECT_EQ((std::vector<uint32_t>{1, 3}), matches);
+
+  // Only whole value matches count.
+  matches.clear();
+  const std::string other = "/rides/1";
+  set.match(other.c_str(), 2, matches);
+  EXPECT_EQ((std::vector<uint32_t>{3}), matches);
+}
+
+TYPED_TEST(CompiledMatcherSetTest, NoMatch) {
+  const TypeParam set({"/foo", "/bar"});
+  std::vector<uint32_t> matches{42};
+
+  set.match("/baz", 4, matches);
+  EXPECT_EQ((std::vector<uint32_t>{42}), matches);
+}
+
+TYPED_TEST(CompiledMatcherSetTest, InvalidRegex) {
+  EXPECT_THROW(TypeParam({"/foo", "/foo[bar"}), EnvoyException);
+}
+
+TEST(Re2MatcherTest, LookaroundUnsupported) {
+  EXPECT_THROW_WITH_MESSAGE(Re2Matcher("/foo/(?!bar)\\w+"), EnvoyException,
+                            "invalid regex '/foo/(?!bar)\\w+': invalid perl operator: (?!");
+}
+
+// Pathological input for backtracking engines; RE2 matches it in linear time.
+TEST(Re2MatcherTest, NestedQuantifiers) {
+  const Re2Matcher matcher("(a+)+b");
+  const std::string value(4096, 'a');
+
+  EXPECT_FALSE(matcher.match(value.c_str(), value.size()));
+}
+
+TEST(RegexUtilityTest, ParseRegex) {
+  CompiledMatcherPtr matcher = Utility::parseRegex("/t[io]c");
+
+  EXPECT_TRUE(matcher->match("/tic", 4));
+  EXPECT_FALSE(matcher->match("/tac", 4));
+  EXPECT_THROW(Utility::parseRegex("(unbalanced"), EnvoyException);
+}
+
+TEST(RegexUtilityTest, ParseRegexSet) {
+  CompiledMatcherSetPtr set = Utility::parseRegexSet({"/t[io]c", "/ti."});
+  std::vector<uint32_t> matches;
+
+  set->match("/tic", 4, matches);
+  EXPECT_EQ((std::vector<uint32_t>{0, 1}), matches);
+  EXPECT_THROW(Utility::parseRegexSet({"(unbalanced"}), EnvoyException);
+}
+
+} // namespace Regex
+} // namespace Envoy
@@ -0,0 +1,86 @@
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include "common/common/thread.h"
+
+#include "test/test_common/utility.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Thread {
+
+#ifdef __linux__
+TEST(ThreadTest, PinCurrentThread) {
+  const std::vector<uint32_t> cpus = Thread::currentThreadCpus();
+  ASSERT_FALSE(cpus.empty());
+
+  // Pin a separate thread, so that the affinity of the test runner is left alone.
+  std::vector<uint32_t> pinned_cpus;
+  Thread thread([&]() -> void {
+    EXPECT_TRUE(Thread::pinCurrentThread(cpus.back()));
+    pinned_cpus = Thread::currentThreadCpus();
+  });
+  thread.join();
+  EXPECT_EQ(std::vector<uint32_t>({cpus.back()}), pinned_cpus);
+}
+#endif
+
+TEST(WorkQueueThreadTest, RunsInOrder) {
+  std::mutex lock;
+  std::condition_variable done_event;
+  std::vector<int> order;
+  const ThreadId thread_id = Thread::currentThreadId();
+  WorkQueueThread thread;
+  for (int i = 0; i < 10; i++) {
+    thread.post([&, i]() -> void {
+      EXPECT_NE(thread_id, Thread::currentThreadId());
+      std::unique_lock<std::mutex> guard(lock);
+      order.push_back(i);
+      done_event.notify_one();
+    });
+  }
+
+  std::unique_lock<std::mutex> guard(lock);
+  while (order.size() < 10) {
+    done_event.wait(guard);
+  }
+  EXPECT_EQ(std::vector<int>({0, 1, 2, 3, 4, 5, 6, 7, 8, 9}), order);
+}
+
+TEST(ParallelForTest, CallsEachIndexOnce) {
+  std::vector<uint32_t> calls(1000);
+  parallelFor(calls.size(), 4, [&calls](size_t i) -> void { calls[i]++; });
+  for (uint32_t count : calls) {
+    EXPECT_EQ(1U, count);
+  }
+}
+
+TEST(ParallelForTest, NoIndices) {
+  parallelFor(0, 4, [](size_t) -> void { FAIL(); });
+}
+
+TEST(ParallelForTest, CallingThreadOnly) {
+  const ThreadId thread_id = Thread::currentThreadId();
+  size_t calls = 0;
+  parallelFor(10, 1, [&](size_t) -> void {
+    EXPECT_EQ(thread_id, Thread::currentThreadId());
+    calls++;
+  });
+  EXPECT_EQ(10U, calls);
+}
+
+TEST(ParallelForTest, RethrowsException) {
+  EXPECT_THROW_WITH_MESSAGE(parallelFor(1000, 4,
+                                        [](size_t i) -> void {
+                                          if (i == 10) {
+                                            throw std::runtime_error("index 10");
+                                          }
+                                        }),
+                            std::runtime_error, "index 10");
+}
+
+} // namespace Thread
+} // namespace Envoy
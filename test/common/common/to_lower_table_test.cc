@@ -26,5 +26,27 @@ TEST(ToLowerTableTest, All) {
     table.toLowerCase(input);
     EXPECT_EQ(input, "\x90hello\x90");
   }
+  {
+    std::string input("X-FORWARDED-FOR: Content-Type@[`{\xC1\xDA");
+    table.toLowerCase(input);
+    EXPECT_EQ(input, "x-forwarded-for: content-type@[`{\xC1\xDA");
+  }
+}
+
+// Every byte value converts the same in each position of a word as through the table.
+TEST(ToLowerTableTest, Word) {
+  ToLowerTable table;
+  for (size_t c = 0; c < 256; c++) {
+    for (size_t position = 0; position < 8; position++) {
+      std::string expected(8, 'A');
+      expected[position] = c;
+      std::string converted = expected;
+      for (char& expected_c : expected) {
+        expected_c = (expected_c >= 'A' && expected_c <= 'Z') ? expected_c | 0x20 : expected_c;
+      }
+      table.toLowerCase(converted);
+      EXPECT_EQ(expected, converted);
+    }
+  }
 }
 } // namespace Envoy
@@ -0,0 +1,94 @@
+#include "common/buffer/buffer_impl.h"
+#include "common/compressor/brotli_compressor_impl.h"
+#include "common/decompressor/brotli_decompressor_impl.h"
+
+#include "test/test_common/utility.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Compressor {
+namespace {
+
+class BrotliCompressorImplTest : public testing::Test {
+protected:
+  static const uint32_t quality{5};
+  static const uint32_t window_bits{18};
+};
+
+class BrotliCompressorImplDeathTest : public BrotliCompressorImplTest {
+protected:
+  static void compressorBadInitTestHelper(uint32_t quality, uint32_t window_bits) {
+    BrotliCompressorImpl compressor;
+    compressor.init(quality, window_bits);
+  }
+};
+
+TEST_F(BrotliCompressorImplDeathTest, CompressorTestDeath) {
+  EXPECT_DEATH(compressorBadInitTestHelper(12, window_bits),
+               std::string{"assert failure: quality <= BROTLI_MAX_QUALITY"});
+  EXPECT_DEATH(compressorBadInitTestHelper(quality, 9), std::string{"assert failure"});
+  EXPECT_DEATH(compressorBadInitTestHelper(quality, 25), std::string{"assert failure"});
+}
+
+/**
+ * Flushed output decompresses to all of the input so far, and a reset compressor writes a new
+ * stream identical to the first.
+ */
+TEST_F(BrotliCompressorImplTest, CompressFlushFinishAndReset) {
+  BrotliCompressorImpl compressor;
+  compressor.init(quality, window_bits);
+
+  std::string streams[2];
+  for (std::string& stream : streams) {
+    Decompressor::BrotliDecompressorImpl decompressor;
+    Buffer::OwnedImpl decompressed;
+    Buffer::OwnedImpl input;
+    Buffer::OwnedImpl output;
+    std::string text;
+    for (int i = 0; i < 10; i++) {
+      TestUtility::feedBufferWithRandomCharacters(input, 1000, i);
+      text += TestUtility::bufferToString(input);
+      compressor.compress(input, output);
+      input.drain(input.length());
+      compressor.flush(output);
+
+      decompressor.decompress(output, decompressed);
+      EXPECT_EQ(text, TestUtility::bufferToString(decompressed));
+      stream += TestUtility::bufferToString(output);
+      output.drain(output.length());
+    }
+
+    compressor.finish(output);
+    decompressor.decompress(output, decompressed);
+    EXPECT_EQ(text, TestUtility::bufferToString(decompressed));
+    stream += TestUtility::bufferToString(output);
+    compressor.reset();
+  }
+  EXPECT_EQ(streams[0], streams[1]);
+}
+
+TEST_F(BrotliCompressorImplTest, CompressesJson) {
+  BrotliCompressorImpl compressor;
+  compressor.init(quality, window_bits);
+
+  std::string json = "[";
+  for (int i = 0; i < 100; i++) {
+    json += "{\"id\": " + std::to_string(i) + ", \"name\": \"item\", \"enabled\": true},";
+  }
+  json += "{}]";
+  Buffer::OwnedImpl input(json);
+  Buffer::OwnedImpl output;
+  compressor.compress(input, output);
+  compressor.finish(output);
+  EXPECT_LT(output.length(), json.size() / 10);
+
+  Decompressor::BrotliDecompressorImpl decompressor;
+  Buffer::OwnedImpl decompressed;
+  decompressor.decompress(output, decompressed);
+  EXPECT_EQ(json, TestUtility::bufferToString(decompressed));
+}
+
+} // namespace
+} // namespace Compressor
+} // namespace Envoy
@@ -0,0 +1,111 @@
+// Compares CPU time per byte and compression ratio of the compressors on JSON, the bulk of what
+// the gzip filter compresses. Set COMPRESSOR_SPEED_TEST_PAYLOAD to the path of a captured response
+// body to measure that instead of the generated payload. Run with:
+// bazel run -c opt //test/common/compressor:compressor_speed_test
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/compressor/brotli_compressor_impl.h"
+#include "common/compressor/zlib_compressor_impl.h"
+#include "common/compressor/zstd_compressor_impl.h"
+
+#include "benchmark/benchmark.h"
+#include "fmt/format.h"
+
+namespace Envoy {
+namespace Compressor {
+
+// An API listing response: an array of records with repeated keys, ids, timestamps and free text.
+static std::string generatedPayload() {
+  std::string payload = "{\"items\":[";
+  for (uint32_t i = 0; i < 500; i++) {
+    payload += fmt::format(
+        "{}{{\"id\":{},\"uuid\":\"{:08x}-4d31-9b9d-{:012x}\",\"name\":\"user {}\","
+        "\"email\":\"user{}@example.com\",\"active\":{},\"score\":{}.{},"
+        "\"created_at\":\"2018-01-{:02}T{:02}:{:02}:00Z\",\"tags\":[\"tag{}\",\"tag{}\"],"
+        "\"address\":{{\"street\":\"{} Main Street\",\"city\":\"City {}\",\"zip\":\"{:05}\"}}}}",
+        i == 0 ? "" : ",", i, i * 2654435761U, i * 40503U, i, i, i % 3 == 0 ? "false" : "true",
+        i % 100, i % 7, i % 28 + 1, i % 24, i % 60, i % 13, i % 29, i * 7, i % 50, i * 31 % 99999);
+  }
+  payload += "],\"next_page_token\":\"CAESBggBEAEYAQ\"}";
+  return payload;
+}
+
+static const std::string& payload() {
+  static const std::string* payload = [] {
+    const char* path = std::getenv("COMPRESSOR_SPEED_TEST_PAYLOAD");
+    if (path == nullptr) {
+      return new std::string(generatedPayload());
+    }
+    std::ifstream file(path);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    return new std::string(contents.str());
+  }();
+  return *payload;
+}
+
+// state.range(1) is the size of the frames the body arrives in, each of which is flushed as the
+// gzip filter does, or 0 to compress the whole body at once.
+static void compressPayload(benchmark::State& state, Compressor& compressor) {
+  const std::string& body = payload();
+  const size_t frame_size = state.range(1) > 0 ? state.range(1) : body.size();
+  uint64_t compressed_size = 0;
+  while (state.KeepRunning()) {
+    Buffer::OwnedImpl output;
+    for (size_t offset = 0; offset < body.size(); offset += frame_size) {
+      Buffer::OwnedImpl frame(body.data() + offset, std::min(frame_size, body.size() - offset));
+      compressor.compress(frame, output);
+      if (offset + frame_size < body.size()) {
+        compressor.flush(output);
+      }
+    }
+    compressor.finish(output);
+    compressed_size = output.length();
+    compressor.reset();
+  }
+  state.SetBytesProcessed(state.iterations() * body.size());
+  state.counters["ratio"] = static_cast<double>(body.size()) / compressed_size;
+}
+
+static void ZlibCompress(benchmark::State& state) {
+  ZlibCompressorImpl compressor;
+  // 31 window bits write a gzip stream with zlib's largest window.
+  compressor.init(static_cast<ZlibCompressorImpl::CompressionLevel>(state.range(0)),
+                  ZlibCompressorImpl::CompressionStrategy::Standard, 31, 8);
+  compressPayload(state, compressor);
+}
+BENCHMARK(ZlibCompress)->Apply([](benchmark::internal::Benchmark* b) {
+  for (int level : {1, 6, 9}) {
+    b->Args({level, 0})->Args({level, 4096});
+  }
+});
+
+static void BrotliCompress(benchmark::State& state) {
+  BrotliCompressorImpl compressor;
+  compressor.init(state.range(0), 18);
+  compressPayload(state, compressor);
+}
+BENCHMARK(BrotliCompress)->Apply([](benchmark::internal::Benchmark* b) {
+  for (int quality : {1, 5, 9, 11}) {
+    b->Args({quality, 0})->Args({quality, 4096});
+  }
+});
+
+static void ZstdCompress(benchmark::State& state) {
+  ZstdCompressorImpl compressor;
+  compressor.init(state.range(0));
+  compressPayload(state, compressor);
+}
+BENCHMARK(ZstdCompress)->Apply([](benchmark::internal::Benchmark* b) {
+  for (int level : {1, 3, 9, 19}) {
+    b->Args({level, 0})->Args({level, 4096});
+  }
+});
+
+} // namespace Compressor
+} // namespace Envoy
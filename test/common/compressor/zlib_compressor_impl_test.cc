@@ -281,6 +281,41 @@ TEST_F(ZlibCompressorImplTest, CompressWithNotCommonParams) {
   EXPECT_EQ("0000ffff", footer_hex_str.substr(footer_hex_str.size() - 8, 10));
 }
 
+/**
+ * Exercises finishing a stream, and reusing the compressor for a new stream after a reset.
+ */
+TEST_F(ZlibCompressorImplTest, FinishAndReset) {
+  Envoy::Compressor::ZlibCompressorImpl compressor;
+  compressor.init(ZlibCompressorImpl::CompressionLevel::Standard,
+                  ZlibCompressorImpl::CompressionStrategy::Standard, gzip_window_bits,
+                  memory_level);
+
+  std::string first_output;
+  for (uint64_t i = 0; i < 2; i++) {
+    Buffer::OwnedImpl input_buffer;
+    Buffer::OwnedImpl output_buffer;
+    TestUtility::feedBufferWithRandomCharacters(input_buffer, 1000, 1);
+    compressor.compress(input_buffer, output_buffer);
+    compressor.finish(output_buffer);
+
+    const std::string output = TestUtility::bufferToString(output_buffer);
+    const std::string hex_str =
+        Hex::encode(reinterpret_cast<const unsigned char*>(output.data()), output.size());
+    // HEADER 0x1f = 31 (window_bits)
+    EXPECT_EQ("1f8b", hex_str.substr(0, 4));
+    // FOOTER ends with the size of the input modulo 2^32, little endian.
+    EXPECT_EQ("e8030000", hex_str.substr(hex_str.size() - 8));
+
+    // A reset compressor produces the same stream for the same input.
+    if (i == 0) {
+      first_output = output;
+    } else {
+      EXPECT_EQ(first_output, output);
+    }
+    compressor.reset();
+  }
+}
+
 } // namespace
 } // namespace Compressor
 } // namespace Envoy
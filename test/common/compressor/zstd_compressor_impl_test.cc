@@ -0,0 +1,91 @@
+#include "common/buffer/buffer_impl.h"
+#include "common/compressor/zstd_compressor_impl.h"
+#include "common/decompressor/zstd_decompressor_impl.h"
+
+#include "test/test_common/utility.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Compressor {
+namespace {
+
+class ZstdCompressorImplTest : public testing::Test {
+protected:
+  static const int level{3};
+};
+
+class ZstdCompressorImplDeathTest : public ZstdCompressorImplTest {
+protected:
+  static void compressorBadInitTestHelper(int level) {
+    ZstdCompressorImpl compressor;
+    compressor.init(level);
+  }
+};
+
+TEST_F(ZstdCompressorImplDeathTest, CompressorTestDeath) {
+  EXPECT_DEATH(compressorBadInitTestHelper(0), std::string{"assert failure"});
+  EXPECT_DEATH(compressorBadInitTestHelper(ZSTD_maxCLevel() + 1), std::string{"assert failure"});
+}
+
+/**
+ * Flushed output decompresses to all of the input so far, and a reset compressor writes a new
+ * stream identical to the first.
+ */
+TEST_F(ZstdCompressorImplTest, CompressFlushFinishAndReset) {
+  ZstdCompressorImpl compressor;
+  compressor.init(level);
+
+  std::string streams[2];
+  for (std::string& stream : streams) {
+    Decompressor::ZstdDecompressorImpl decompressor;
+    Buffer::OwnedImpl decompressed;
+    Buffer::OwnedImpl input;
+    Buffer::OwnedImpl output;
+    std::string text;
+    for (int i = 0; i < 10; i++) {
+      TestUtility::feedBufferWithRandomCharacters(input, 1000, i);
+      text += TestUtility::bufferToString(input);
+      compressor.compress(input, output);
+      input.drain(input.length());
+      compressor.flush(output);
+
+      decompressor.decompress(output, decompressed);
+      EXPECT_EQ(text, TestUtility::bufferToString(decompressed));
+      stream += TestUtility::bufferToString(output);
+      output.drain(output.length());
+    }
+
+    compressor.finish(output);
+    decompressor.decompress(output, decompressed);
+    EXPECT_EQ(text, TestUtility::bufferToString(decompressed));
+    stream += TestUtility::bufferToString(output);
+    compressor.reset();
+  }
+  EXPECT_EQ(streams[0], streams[1]);
+}
+
+TEST_F(ZstdCompressorImplTest, CompressesJson) {
+  ZstdCompressorImpl compressor;
+  compressor.init(level);
+
+  std::string json = "[";
+  for (int i = 0; i < 100; i++) {
+    json += "{\"id\": " + std::to_string(i) + ", \"name\": \"item\", \"enabled\": true},";
+  }
+  json += "{}]";
+  Buffer::OwnedImpl input(json);
+  Buffer::OwnedImpl output;
+  compressor.compress(input, output);
+  compressor.finish(output);
+  EXPECT_LT(output.length(), json.size() / 10);
+
+  Decompressor::ZstdDecompressorImpl decompressor;
+  Buffer::OwnedImpl decompressed;
+  decompressor.decompress(output, decompressed);
+  EXPECT_EQ(json, TestUtility::bufferToString(decompressed));
+}
+
+} // namespace
+} // namespace Compressor
+} // namespace Envoy
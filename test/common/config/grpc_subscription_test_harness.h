@@ -91,11 +91,21 @@ public:
         response->add_resources()->PackFrom(*load_assignment);
       }
     }
-    EXPECT_CALL(callbacks_, onConfigUpdate(RepeatedProtoEq(typed_resources)))
-        .WillOnce(ThrowOnRejectedConfig(accept));
+    std::string resources_bytes;
+    for (const auto& resource : response->resources()) {
+      resources_bytes += resource.value();
+    }
+    if (accepted_resources_bytes_.valid() && accepted_resources_bytes_.value() == resources_bytes) {
+      // Resources that are unchanged since the last accepted update are not applied again.
+      EXPECT_TRUE(accept);
+    } else {
+      EXPECT_CALL(callbacks_, onConfigUpdate(RepeatedProtoEq(typed_resources)))
+          .WillOnce(ThrowOnRejectedConfig(accept));
+    }
     if (accept) {
       expectSendMessage(last_cluster_names_, version);
       version_ = version;
+      accepted_resources_bytes_.value(resources_bytes);
     } else {
       EXPECT_CALL(callbacks_, onConfigUpdateFailed(_));
       expectSendMessage(last_cluster_names_, version_);
@@ -128,6 +138,7 @@ public:
   std::unique_ptr<GrpcEdsSubscriptionImpl> subscription_;
   std::string last_response_nonce_;
   std::vector<std::string> last_cluster_names_;
+  Optional<std::string> accepted_resources_bytes_;
 };
 
 // TODO(danielhochman): test with RDS and ensure version_info is same as what API returned
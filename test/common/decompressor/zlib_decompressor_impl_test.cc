@@ -177,6 +177,46 @@ TEST_F(ZlibDecompressorImplTest, CompressDecompressWithUncommonParams) {
   EXPECT_EQ(original_text, decompressed_text);
 }
 
+/**
+ * Exercises compression and decompression with a preset dictionary, for zlib and raw deflate
+ * streams, across a compressor reset.
+ */
+TEST_F(ZlibDecompressorImplTest, CompressDecompressWithDictionary) {
+  const std::string dictionary = "{\"id\": , \"name\": \"\", \"tags\": []}";
+  const std::string text = "{\"id\": 7, \"name\": \"seven\", \"tags\": []}";
+
+  for (int64_t window_bits : {15, -15}) {
+    Envoy::Compressor::ZlibCompressorImpl compressor;
+    compressor.init(Envoy::Compressor::ZlibCompressorImpl::CompressionLevel::Standard,
+                    Envoy::Compressor::ZlibCompressorImpl::CompressionStrategy::Standard,
+                    window_bits, memory_level, dictionary);
+    Envoy::Compressor::ZlibCompressorImpl plain_compressor;
+    plain_compressor.init(Envoy::Compressor::ZlibCompressorImpl::CompressionLevel::Standard,
+                          Envoy::Compressor::ZlibCompressorImpl::CompressionStrategy::Standard,
+                          window_bits, memory_level);
+
+    for (int i = 0; i < 2; i++) {
+      Buffer::OwnedImpl input(text);
+      Buffer::OwnedImpl compressed;
+      compressor.compress(input, compressed);
+      compressor.finish(compressed);
+      compressor.reset();
+
+      Buffer::OwnedImpl plain_compressed;
+      plain_compressor.compress(input, plain_compressed);
+      plain_compressor.finish(plain_compressed);
+      plain_compressor.reset();
+      EXPECT_LT(compressed.length(), plain_compressed.length());
+
+      ZlibDecompressorImpl decompressor;
+      decompressor.init(window_bits, dictionary);
+      Buffer::OwnedImpl decompressed;
+      decompressor.decompress(compressed, decompressed);
+      EXPECT_EQ(text, TestUtility::bufferToString(decompressed));
+    }
+  }
+}
+
 } // namespace
 } // namespace Decompressor
 } // namespace Envoy
@@ -1,9 +1,11 @@
 #include <string>
 #include <vector>
 
+#include "envoy/json/json_object.h"
+
+#include "common/buffer/buffer_impl.h"
 #include "common/dynamo/dynamo_request_parser.h"
 #include "common/http/header_map_impl.h"
-#include "common/json/json_loader.h"
 
 #include "test/test_common/printers.h"
 #include "test/test_common/utility.h"
@@ -13,6 +15,10 @@
 namespace Envoy {
 namespace Dynamo {
 
+std::vector<Buffer::RawSlice> body(const std::string& json) {
+  return {{const_cast<char*>(json.data()), json.size()}};
+}
+
 TEST(DynamoRequestParser, parseOperation) {
   // Well formed x-amz-target header, in a format, Version.Operation
   {
@@ -53,40 +59,52 @@ TEST(DynamoRequestParser, parseTableNameSingleOperation) {
       }
     }
     )EOF";
-    Json::ObjectSharedPtr json_data = Json::Factory::loadFromString(json_string);
 
     // Supported operation
     for (const std::string& operation : supported_single_operations) {
-      EXPECT_EQ("Pets", RequestParser::parseTable(operation, *json_data).table_name);
+      EXPECT_EQ("Pets", RequestParser::parseTable(operation, body(json_string)).table_name);
     }
 
     // Not supported operation
-    EXPECT_EQ("", RequestParser::parseTable("NotSupportedOperation", *json_data).table_name);
+    EXPECT_EQ("",
+              RequestParser::parseTable("NotSupportedOperation", body(json_string)).table_name);
   }
 
   {
-    Json::ObjectSharedPtr json_data = Json::Factory::loadFromString("{\"TableName\":\"Pets\"}");
-    EXPECT_EQ("Pets", RequestParser::parseTable("GetItem", *json_data).table_name);
+    EXPECT_EQ("Pets",
+              RequestParser::parseTable("GetItem", body("{\"TableName\":\"Pets\"}")).table_name);
+  }
+
+  // Only top level table names count.
+  {
+    EXPECT_EQ("", RequestParser::parseTable("GetItem", body("{\"Key\":{\"TableName\":\"Pets\"}}"))
+                      .table_name);
   }
 }
 
 TEST(DynamoRequestParser, parseErrorType) {
   {
-    EXPECT_EQ("ResourceNotFoundException",
-              RequestParser::parseErrorType(*Json::Factory::loadFromString(
-                  "{\"__type\":\"com.amazonaws.dynamodb.v20120810#ResourceNotFoundException\"}")));
+    EXPECT_EQ(
+        "ResourceNotFoundException",
+        RequestParser::parseResponse(
+            body("{\"__type\":\"com.amazonaws.dynamodb.v20120810#ResourceNotFoundException\"}"),
+            RequestParser::ErrorType)
+            .error_type_);
   }
 
   {
     EXPECT_EQ("ResourceNotFoundException",
-              RequestParser::parseErrorType(*Json::Factory::loadFromString(
-                  "{\"__type\":\"com.amazonaws.dynamodb.v20120810#ResourceNotFoundException\","
-                  "\"message\":\"Requested resource not found: Table: tablename not found\"}")));
+              RequestParser::parseResponse(
+                  body("{\"__type\":\"com.amazonaws.dynamodb.v20120810#ResourceNotFoundException\","
+                       "\"message\":\"Requested resource not found: Table: tablename not found\"}"),
+                  RequestParser::ErrorType)
+                  .error_type_);
   }
 
   {
-    EXPECT_EQ("", RequestParser::parseErrorType(
-                      *Json::Factory::loadFromString("{\"__type\":\"UnKnownError\"}")));
+    EXPECT_EQ("", RequestParser::parseResponse(body("{\"__type\":\"UnKnownError\"}"),
+                                               RequestParser::ErrorType)
+                      .error_type_);
   }
 }
 
@@ -100,9 +118,9 @@ TEST(DynamoRequestParser, parseTableNameBatchOperation) {
       }
     }
     )EOF";
-    Json::ObjectSharedPtr json_data = Json::Factory::loadFromString(json_string);
 
-    RequestParser::TableDescriptor table = RequestParser::parseTable("BatchGetItem", *json_data);
+    RequestParser::TableDescriptor table =
+        RequestParser::parseTable("BatchGetItem", body(json_string));
     EXPECT_EQ("", table.table_name);
     EXPECT_FALSE(table.is_single_table);
   }
@@ -116,9 +134,9 @@ TEST(DynamoRequestParser, parseTableNameBatchOperation) {
       }
     }
     )EOF";
-    Json::ObjectSharedPtr json_data = Json::Factory::loadFromString(json_string);
 
-    RequestParser::TableDescriptor table = RequestParser::parseTable("BatchGetItem", *json_data);
+    RequestParser::TableDescriptor table =
+        RequestParser::parseTable("BatchGetItem", body(json_string));
     EXPECT_EQ("table_2", table.table_name);
     EXPECT_TRUE(table.is_single_table);
   }
@@ -133,9 +151,9 @@ TEST(DynamoRequestParser, parseTableNameBatchOperation) {
       }
     }
     )EOF";
-    Json::ObjectSharedPtr json_data = Json::Factory::loadFromString(json_string);
 
-    RequestParser::TableDescriptor table = RequestParser::parseTable("BatchGetItem", *json_data);
+    RequestParser::TableDescriptor table =
+        RequestParser::parseTable("BatchGetItem", body(json_string));
     EXPECT_EQ("", table.table_name);
     EXPECT_FALSE(table.is_single_table);
   }
@@ -149,51 +167,53 @@ TEST(DynamoRequestParser, parseTableNameBatchOperation) {
       }
     }
     )EOF";
-    Json::ObjectSharedPtr json_data = Json::Factory::loadFromString(json_string);
 
-    RequestParser::TableDescriptor table = RequestParser::parseTable("BatchWriteItem", *json_data);
+    RequestParser::TableDescriptor table =
+        RequestParser::parseTable("BatchWriteItem", body(json_string));
     EXPECT_EQ("table_2", table.table_name);
     EXPECT_TRUE(table.is_single_table);
   }
 
   {
-    Json::ObjectSharedPtr json_data = Json::Factory::loadFromString("{}");
-    RequestParser::TableDescriptor table =
-        RequestParser::parseTable("BatchWriteItem", *Json::Factory::loadFromString("{}"));
+    RequestParser::TableDescriptor table = RequestParser::parseTable("BatchWriteItem", body("{}"));
     EXPECT_EQ("", table.table_name);
     EXPECT_TRUE(table.is_single_table);
   }
 
   {
-    Json::ObjectSharedPtr json_data = Json::Factory::loadFromString("{\"RequestItems\":{}}");
-    RequestParser::TableDescriptor table = RequestParser::parseTable("BatchWriteItem", *json_data);
+    RequestParser::TableDescriptor table =
+        RequestParser::parseTable("BatchWriteItem", body("{\"RequestItems\":{}}"));
     EXPECT_EQ("", table.table_name);
     EXPECT_TRUE(table.is_single_table);
   }
 
   {
-    Json::ObjectSharedPtr json_data = Json::Factory::loadFromString("{}");
-    RequestParser::TableDescriptor table = RequestParser::parseTable("BatchGetItem", *json_data);
+    RequestParser::TableDescriptor table = RequestParser::parseTable("BatchGetItem", body("{}"));
     EXPECT_EQ("", table.table_name);
     EXPECT_TRUE(table.is_single_table);
   }
 }
+
 TEST(DynamoRequestParser, parseBatchUnProcessedKeys) {
   {
-    Json::ObjectSharedPtr json_data = Json::Factory::loadFromString("{}");
     std::vector<std::string> unprocessed_tables =
-        RequestParser::parseBatchUnProcessedKeys(*json_data);
+        RequestParser::parseResponse(body("{}"), RequestParser::UnprocessedKeys)
+            .unprocessed_tables_;
     EXPECT_EQ(0u, unprocessed_tables.size());
   }
   {
-    std::vector<std::string> unprocessed_tables = RequestParser::parseBatchUnProcessedKeys(
-        *Json::Factory::loadFromString("{\"UnprocessedKeys\":{}}"));
+    std::vector<std::string> unprocessed_tables =
+        RequestParser::parseResponse(body("{\"UnprocessedKeys\":{}}"),
+                                     RequestParser::UnprocessedKeys)
+            .unprocessed_tables_;
     EXPECT_EQ(0u, unprocessed_tables.size());
   }
 
   {
-    std::vector<std::string> unprocessed_tables = RequestParser::parseBatchUnProcessedKeys(
-        *Json::Factory::loadFromString("{\"UnprocessedKeys\":{\"table_1\" :{}}}"));
+    std::vector<std::string> unprocessed_tables =
+        RequestParser::parseResponse(body("{\"UnprocessedKeys\":{\"table_1\" :{}}}"),
+                                     RequestParser::UnprocessedKeys)
+            .unprocessed_tables_;
     EXPECT_EQ("table_1", unprocessed_tables[0]);
     EXPECT_EQ(1u, unprocessed_tables.size());
   }
@@ -207,10 +227,10 @@ TEST(DynamoRequestParser, parseBatchUnProcessedKeys) {
       }
     }
     )EOF";
-    Json::ObjectSharedPtr json_data = Json::Factory::loadFromString(json_string);
 
     std::vector<std::string> unprocessed_tables =
-        RequestParser::parseBatchUnProcessedKeys(*json_data);
+        RequestParser::parseResponse(body(json_string), RequestParser::UnprocessedKeys)
+            .unprocessed_tables_;
     EXPECT_TRUE(find(unprocessed_tables.begin(), unprocessed_tables.end(), "table_1") !=
                 unprocessed_tables.end());
     EXPECT_TRUE(find(unprocessed_tables.begin(), unprocessed_tables.end(), "table_2") !=
@@ -222,17 +242,20 @@ TEST(DynamoRequestParser, parseBatchUnProcessedKeys) {
 TEST(DynamoRequestParser, parsePartitionIds) {
   {
     std::vector<RequestParser::PartitionDescriptor> partitions =
-        RequestParser::parsePartitions(*Json::Factory::loadFromString("{}"));
+        RequestParser::parseResponse(body("{}"), RequestParser::Partitions).partitions_;
     EXPECT_EQ(0u, partitions.size());
   }
   {
     std::vector<RequestParser::PartitionDescriptor> partitions =
-        RequestParser::parsePartitions(*Json::Factory::loadFromString("{\"ConsumedCapacity\":{}}"));
+        RequestParser::parseResponse(body("{\"ConsumedCapacity\":{}}"), RequestParser::Partitions)
+            .partitions_;
     EXPECT_EQ(0u, partitions.size());
   }
   {
-    std::vector<RequestParser::PartitionDescriptor> partitions = RequestParser::parsePartitions(
-        *Json::Factory::loadFromString("{\"ConsumedCapacity\":{ \"Partitions\":{}}}"));
+    std::vector<RequestParser::PartitionDescriptor> partitions =
+        RequestParser::parseResponse(body("{\"ConsumedCapacity\":{ \"Partitions\":{}}}"),
+                                     RequestParser::Partitions)
+            .partitions_;
     EXPECT_EQ(0u, partitions.size());
   }
   {
@@ -246,10 +269,9 @@ TEST(DynamoRequestParser, parsePartitionIds) {
       }
     }
     )EOF";
-    Json::ObjectSharedPtr json_data = Json::Factory::loadFromString(json_string);
 
     std::vector<RequestParser::PartitionDescriptor> partitions =
-        RequestParser::parsePartitions(*json_data);
+        RequestParser::parseResponse(body(json_string), RequestParser::Partitions).partitions_;
     for (const RequestParser::PartitionDescriptor& partition : partitions) {
       if (partition.partition_id_ == "partition_1") {
         EXPECT_EQ(1u, partition.capacity_);
@@ -261,5 +283,78 @@ TEST(DynamoRequestParser, parsePartitionIds) {
   }
 }
 
+TEST(DynamoRequestParser, parseResponseAllFields) {
+  std::string json_string = R"EOF(
+  {
+    "__type": "com.amazonaws.dynamodb.v20120810#ThrottlingException",
+    "UnprocessedKeys": {
+      "table_1": { "Keys": [ { "ConsumedCapacity": { "Partitions": { "nested": 1 } } } ] }
+    },
+    "ConsumedCapacity": {
+      "Table": { "CapacityUnits": 2 },
+      "Partitions": { "partition_1": 2 }
+    }
+  }
+  )EOF";
+
+  RequestParser::ResponseDescriptor response = RequestParser::parseResponse(
+      body(json_string),
+      RequestParser::ErrorType | RequestParser::UnprocessedKeys | RequestParser::Partitions);
+  EXPECT_EQ("ThrottlingException", response.error_type_);
+  EXPECT_EQ(std::vector<std::string>{"table_1"}, response.unprocessed_tables_);
+  ASSERT_EQ(1u, response.partitions_.size());
+  EXPECT_EQ("partition_1", response.partitions_[0].partition_id_);
+  EXPECT_EQ(2u, response.partitions_[0].capacity_);
+
+  // Fields that are not asked for are left alone.
+  response = RequestParser::parseResponse(body(json_string), RequestParser::ErrorType);
+  EXPECT_EQ("ThrottlingException", response.error_type_);
+  EXPECT_TRUE(response.unprocessed_tables_.empty());
+  EXPECT_TRUE(response.partitions_.empty());
+}
+
+TEST(DynamoRequestParser, parseSlices) {
+  // The body may be split anywhere, including within keys and values, and contain empty slices.
+  Buffer::OwnedImpl buffer;
+  for (const std::string& part : {"{\"Key\":{}, \"Tab", "", "leNa", "me\":\"P", "ets\"}"}) {
+    Buffer::OwnedImpl slice(part);
+    buffer.move(slice);
+  }
+  std::vector<Buffer::RawSlice> slices(buffer.getRawSlices(nullptr, 0));
+  buffer.getRawSlices(slices.data(), slices.size());
+  slices.push_back({});
+
+  EXPECT_EQ("Pets", RequestParser::parseTable("GetItem", slices).table_name);
+}
+
+TEST(DynamoRequestParser, parseStopsEarly) {
+  // Parsing stops as soon as the fields are known, so whatever follows them is not looked at.
+  EXPECT_EQ(
+      "Pets",
+      RequestParser::parseTable("GetItem", body("{\"TableName\":\"Pets\", not json")).table_name);
+
+  RequestParser::TableDescriptor table = RequestParser::parseTable(
+      "BatchWriteItem", body("{\"RequestItems\":{\"table_1\":{},\"table_2\" not json"));
+  EXPECT_EQ("", table.table_name);
+  EXPECT_FALSE(table.is_single_table);
+
+  EXPECT_EQ(std::vector<std::string>{"table_1"},
+            RequestParser::parseResponse(body("{\"UnprocessedKeys\":{\"table_1\":{}}, not json"),
+                                         RequestParser::UnprocessedKeys)
+                .unprocessed_tables_);
+
+  // Invalid JSON before that point is still an error.
+  EXPECT_THROW(RequestParser::parseTable("GetItem", body("{\"Key\":{}, not json")),
+               Json::Exception);
+  EXPECT_THROW(RequestParser::parseTable("GetItem", body("{\"Key\":{}")), Json::Exception);
+  EXPECT_THROW(RequestParser::parseResponse(body("{\"__type\"}"), RequestParser::ErrorType),
+               Json::Exception);
+  EXPECT_THROW(RequestParser::parseResponse(body("{}}"), RequestParser::Partitions),
+               Json::Exception);
+
+  // Bodies of operations that have no table are not parsed at all.
+  EXPECT_EQ("", RequestParser::parseTable("ListTables", body("not json")).table_name);
+}
+
 } // namespace Dynamo
 } // namespace Envoy
@@ -1,13 +1,23 @@
+#include <chrono>
 #include <functional>
+#include <string>
+#include <thread>
 
+#include "common/buffer/buffer_impl.h"
 #include "common/event/dispatcher_impl.h"
+#include "common/stats/stats_impl.h"
 
 #include "test/mocks/common.h"
+#include "test/mocks/stats/mocks.h"
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
+using testing::Ge;
 using testing::InSequence;
+using testing::NiceMock;
+using testing::Property;
+using testing::_;
 
 namespace Envoy {
 namespace Event {
@@ -51,5 +61,165 @@ TEST(DispatcherImplTest, DeferredDelete) {
   dispatcher.clearDeferredDeleteList();
 }
 
+TEST(DispatcherImplTest, DeferredDeleteBoundedPerIteration) {
+  DispatcherImpl dispatcher;
+  const size_t total = DispatcherImpl::MAX_DEFERRED_DELETES_PER_ITERATION + 10;
+  size_t deleted = 0;
+  for (size_t i = 0; i < total; i++) {
+    dispatcher.deferredDelete(
+        DeferredDeletablePtr{new TestDeferredDeletable([&]() -> void { deleted++; })});
+  }
+
+  dispatcher.run(Dispatcher::RunType::NonBlock);
+  EXPECT_EQ(DispatcherImpl::MAX_DEFERRED_DELETES_PER_ITERATION, deleted);
+
+  // The rest is deleted in the next iteration.
+  dispatcher.run(Dispatcher::RunType::NonBlock);
+  EXPECT_EQ(total, deleted);
+}
+
+TEST(DispatcherImplTest, PostCallbacksBoundedPerIteration) {
+  DispatcherImpl dispatcher;
+  uint32_t ran = 0;
+  TimerPtr timer = dispatcher.createTimer([&]() -> void {
+    for (uint32_t i = 0; i < 3; i++) {
+      dispatcher.post([&]() -> void {
+        ran++;
+        std::this_thread::sleep_for(DispatcherImpl::POST_CALLBACK_BUDGET);
+      });
+    }
+  });
+  timer->enableTimer(std::chrono::milliseconds(0));
+
+  dispatcher.run(Dispatcher::RunType::NonBlock);
+  EXPECT_EQ(1U, ran);
+
+  dispatcher.run(Dispatcher::RunType::NonBlock);
+  EXPECT_EQ(3U, ran);
+}
+
+TEST(DispatcherImplTest, SlicePoolInstalledWhileRunning) {
+  Stats::IsolatedStoreImpl store;
+  DispatcherImpl dispatcher;
+  dispatcher.initializeStats(store, "test.");
+
+  Buffer::SlicePool* default_pool = &Buffer::SlicePool::current();
+  Buffer::SlicePool* running_pool = nullptr;
+  dispatcher.post([&]() -> void {
+    running_pool = &Buffer::SlicePool::current();
+    Buffer::SliceOwnedImpl buffer("hello");
+  });
+  dispatcher.run(Dispatcher::RunType::NonBlock);
+
+  EXPECT_NE(default_pool, running_pool);
+  EXPECT_EQ(default_pool, &Buffer::SlicePool::current());
+  EXPECT_EQ(1, store.counter("test.slice_pool.allocated").value());
+  EXPECT_EQ(1, store.gauge("test.slice_pool.pooled").value());
+}
+
+TEST(DispatcherImplTest, LoopStats) {
+  NiceMock<Stats::MockIsolatedStatsStore> store;
+  DispatcherImpl dispatcher;
+  dispatcher.initializeLoopStats(store, "test.");
+
+  TimerPtr timer = dispatcher.createTimer([]() -> void {
+    std::this_thread::sleep_for(DispatcherImpl::SLOW_CALLBACK_THRESHOLD);
+  });
+  timer->enableTimer(std::chrono::milliseconds(0));
+
+  EXPECT_CALL(store, deliverHistogramToSinks(
+                         Property(&Stats::Metric::name, "test.dispatcher.poll_delay_us"), _));
+  EXPECT_CALL(store,
+              deliverHistogramToSinks(
+                  Property(&Stats::Metric::name, "test.dispatcher.loop_duration_us"),
+                  Ge(std::chrono::microseconds(DispatcherImpl::SLOW_CALLBACK_THRESHOLD).count())));
+  dispatcher.run(Dispatcher::RunType::NonBlock);
+  EXPECT_EQ(1, store.counter("test.dispatcher.slow_callbacks").value());
+}
+
+TEST(DispatcherImplTest, PostStats) {
+  Stats::IsolatedStoreImpl store;
+  DispatcherImpl dispatcher;
+  dispatcher.initializeLoopStats(store, "test.");
+
+  uint32_t ran = 0;
+  std::thread thread([&]() -> void {
+    dispatcher.post([&]() -> void { ran++; });
+    dispatcher.post([&]() -> void { ran++; });
+  });
+  thread.join();
+  EXPECT_EQ(2, store.counter("test.dispatcher.posted_callbacks").value());
+  EXPECT_EQ(2, store.gauge("test.dispatcher.post_queue_depth").value());
+
+  dispatcher.run(Dispatcher::RunType::NonBlock);
+  EXPECT_EQ(2U, ran);
+  EXPECT_EQ(0, store.gauge("test.dispatcher.post_queue_depth").value());
+}
+
+TEST(DispatcherImplTest, TimedLoopExits) {
+  Stats::IsolatedStoreImpl store;
+  DispatcherImpl dispatcher;
+  dispatcher.initializeLoopStats(store, "test.");
+
+  bool timer_fired = false;
+  TimerPtr timer = dispatcher.createTimer([&]() -> void {
+    timer_fired = true;
+    dispatcher.exit();
+  });
+  timer->enableTimer(std::chrono::milliseconds(1));
+  dispatcher.run(Dispatcher::RunType::Block);
+  EXPECT_TRUE(timer_fired);
+  EXPECT_EQ(0, store.counter("test.dispatcher.slow_callbacks").value());
+}
+
+TEST(DispatcherImplTest, RunningCallbackType) {
+  DispatcherImpl dispatcher;
+  EXPECT_EQ(nullptr, dispatcher.runningCallbackType());
+
+  std::string timer_type;
+  std::string post_type;
+  TimerPtr timer = dispatcher.createTimer([&]() -> void {
+    timer_type = dispatcher.runningCallbackType();
+    dispatcher.post([&]() -> void { post_type = dispatcher.runningCallbackType(); });
+  });
+  timer->enableTimer(std::chrono::milliseconds(0));
+  dispatcher.run(Dispatcher::RunType::NonBlock);
+  dispatcher.run(Dispatcher::RunType::NonBlock);
+  EXPECT_EQ("timer", timer_type);
+  EXPECT_EQ("post", post_type);
+  EXPECT_EQ(nullptr, dispatcher.runningCallbackType());
+}
+
+TEST(DispatcherImplTest, ApproximateTimeCachedPerIteration) {
+  DispatcherImpl dispatcher;
+  MonotonicTimeSource& monotonic_time = dispatcher.approximateMonotonicTimeSource();
+  SystemTimeSource& system_time = dispatcher.approximateSystemTimeSource();
+
+  // Outside of the loop every read is exact.
+  const MonotonicTime before_run = monotonic_time.currentTime();
+  std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  EXPECT_LT(before_run, monotonic_time.currentTime());
+
+  MonotonicTime first_iteration;
+  TimerPtr second_timer = dispatcher.createTimer([&]() -> void {
+    EXPECT_LT(first_iteration, monotonic_time.currentTime());
+    dispatcher.exit();
+  });
+  TimerPtr first_timer = dispatcher.createTimer([&]() -> void {
+    first_iteration = monotonic_time.currentTime();
+    const SystemTime first_system_time = system_time.currentTime();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    EXPECT_EQ(first_iteration, monotonic_time.currentTime());
+    EXPECT_EQ(first_system_time, system_time.currentTime());
+    second_timer->enableTimer(std::chrono::milliseconds(0));
+  });
+  first_timer->enableTimer(std::chrono::milliseconds(0));
+  dispatcher.run(Dispatcher::RunType::Block);
+
+  const MonotonicTime after_run = monotonic_time.currentTime();
+  std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  EXPECT_LT(after_run, monotonic_time.currentTime());
+}
+
 } // namespace Event
 } // namespace Envoy
@@ -0,0 +1,38 @@
+#include <chrono>
+#include <vector>
+
+#include "common/event/dispatcher_impl.h"
+
+#include "benchmark/benchmark.h"
+
+namespace Envoy {
+namespace Event {
+
+// Re-arms every one of state.range(0) armed idle timers, as a busy worker does on each read.
+static void rearmTimers(benchmark::State& state, bool coarse) {
+  DispatcherImpl dispatcher;
+  std::vector<TimerPtr> timers;
+  for (int64_t i = 0; i < state.range(0); i++) {
+    TimerCb cb = []() -> void {};
+    timers.push_back(coarse ? dispatcher.createCoarseTimer(cb) : dispatcher.createTimer(cb));
+    timers.back()->enableTimer(std::chrono::milliseconds(60000 + i));
+  }
+
+  uint64_t round = 0;
+  while (state.KeepRunning()) {
+    round++;
+    for (TimerPtr& timer : timers) {
+      timer->enableTimer(std::chrono::milliseconds(60000 + round % 1000));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void LibeventTimerRearm(benchmark::State& state) { rearmTimers(state, false); }
+BENCHMARK(LibeventTimerRearm)->Arg(1000)->Arg(100000);
+
+static void CoarseTimerRearm(benchmark::State& state) { rearmTimers(state, true); }
+BENCHMARK(CoarseTimerRearm)->Arg(1000)->Arg(100000);
+
+} // namespace Event
+} // namespace Envoy
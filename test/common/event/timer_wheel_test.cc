@@ -0,0 +1,160 @@
+#include <chrono>
+#include <memory>
+
+#include "common/event/timer_wheel.h"
+
+#include "test/mocks/common.h"
+#include "test/mocks/event/mocks.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::InSequence;
+using testing::Invoke;
+using testing::NiceMock;
+using testing::SaveArg;
+using testing::_;
+
+namespace Envoy {
+namespace Event {
+
+class TimerWheelTest : public testing::Test {
+public:
+  TimerWheelTest() {
+    ON_CALL(time_source_, currentTime()).WillByDefault(Invoke([this]() -> MonotonicTime {
+      return MonotonicTime(std::chrono::milliseconds(1000) + now_);
+    }));
+    ON_CALL(*tick_timer_, enableTimer(_)).WillByDefault(SaveArg<0>(&tick_timer_delay_));
+    wheel_.reset(new TimerWheel(dispatcher_, time_source_));
+  }
+
+  TimerPtr createTimer(ReadyWatcher& watcher) {
+    return TimerPtr{new CoarseTimerImpl(*wheel_, [&watcher]() -> void { watcher.ready(); })};
+  }
+
+  // Advance time to when the tick timer is armed for and fire it.
+  void fireTickTimer() {
+    now_ += tick_timer_delay_;
+    tick_timer_->callback_();
+  }
+
+  NiceMock<MockDispatcher> dispatcher_;
+  MockTimer* tick_timer_ = new NiceMock<MockTimer>(&dispatcher_);
+  std::chrono::milliseconds tick_timer_delay_{};
+  NiceMock<MockMonotonicTimeSource> time_source_;
+  std::chrono::milliseconds now_{};
+  std::unique_ptr<TimerWheel> wheel_;
+};
+
+TEST_F(TimerWheelTest, FiresNoEarlierThanRequested) {
+  ReadyWatcher watcher;
+  TimerPtr timer = createTimer(watcher);
+
+  now_ = std::chrono::milliseconds(1);
+  timer->enableTimer(std::chrono::milliseconds(25));
+  EXPECT_EQ(std::chrono::milliseconds(29), tick_timer_delay_);
+
+  // An early wake up does not fire the timer, and waits for the rest of its tick.
+  now_ = std::chrono::milliseconds(25);
+  tick_timer_->callback_();
+  EXPECT_EQ(std::chrono::milliseconds(5), tick_timer_delay_);
+
+  EXPECT_CALL(watcher, ready());
+  now_ = std::chrono::milliseconds(30);
+  tick_timer_->callback_();
+}
+
+TEST_F(TimerWheelTest, RearmAndDisable) {
+  InSequence s;
+  ReadyWatcher watcher1;
+  ReadyWatcher watcher2;
+  TimerPtr timer1 = createTimer(watcher1);
+  TimerPtr timer2 = createTimer(watcher2);
+
+  timer1->enableTimer(std::chrono::milliseconds(100));
+  timer1->enableTimer(std::chrono::milliseconds(50));
+  timer2->enableTimer(std::chrono::milliseconds(70));
+  EXPECT_EQ(std::chrono::milliseconds(50), tick_timer_delay_);
+
+  EXPECT_CALL(watcher1, ready());
+  fireTickTimer();
+  EXPECT_EQ(std::chrono::milliseconds(20), tick_timer_delay_);
+
+  // Disabling the last armed timer disarms the tick timer too.
+  EXPECT_CALL(*tick_timer_, disableTimer());
+  timer2->disableTimer();
+  EXPECT_CALL(watcher2, ready()).Times(0);
+  now_ = std::chrono::milliseconds(1000);
+  tick_timer_->callback_();
+}
+
+TEST_F(TimerWheelTest, LongTimeoutsCascade) {
+  ReadyWatcher watcher1;
+  ReadyWatcher watcher2;
+  TimerPtr timer1 = createTimer(watcher1);
+  TimerPtr timer2 = createTimer(watcher2);
+
+  // Only the next first level wrap around is waited for, not every tick.
+  timer1->enableTimer(std::chrono::minutes(10));
+  EXPECT_EQ(TimerWheel::TICK * 256, tick_timer_delay_);
+  timer2->enableTimer(std::chrono::hours(1));
+
+  EXPECT_CALL(watcher1, ready()).Times(0);
+  while (now_ + tick_timer_delay_ < std::chrono::minutes(10)) {
+    fireTickTimer();
+  }
+
+  EXPECT_CALL(watcher1, ready());
+  fireTickTimer();
+  EXPECT_EQ(std::chrono::minutes(10), now_);
+
+  EXPECT_CALL(watcher2, ready()).Times(0);
+  while (now_ + tick_timer_delay_ < std::chrono::hours(1)) {
+    fireTickTimer();
+  }
+
+  EXPECT_CALL(watcher2, ready());
+  fireTickTimer();
+  EXPECT_EQ(std::chrono::hours(1), now_);
+}
+
+TEST_F(TimerWheelTest, CatchUpAfterStall) {
+  ReadyWatcher watcher1;
+  ReadyWatcher watcher2;
+  TimerPtr timer1 = createTimer(watcher1);
+  TimerPtr timer2 = createTimer(watcher2);
+  timer1->enableTimer(std::chrono::milliseconds(50));
+  timer2->enableTimer(std::chrono::seconds(30));
+
+  // The loop did not get to run the tick timer for a while, so everything due is fired at once.
+  EXPECT_CALL(watcher1, ready());
+  EXPECT_CALL(watcher2, ready());
+  now_ = std::chrono::seconds(31);
+  tick_timer_->callback_();
+}
+
+TEST_F(TimerWheelTest, CallbacksModifyTimers) {
+  ReadyWatcher watcher1;
+  ReadyWatcher watcher2;
+  TimerPtr timer2 = createTimer(watcher2);
+  TimerPtr timer1{new CoarseTimerImpl(*wheel_, [&]() -> void {
+    watcher1.ready();
+    // Destroying a timer that is due in the same tick keeps it from firing.
+    timer2.reset();
+    timer1->enableTimer(std::chrono::milliseconds(10));
+  })};
+
+  timer1->enableTimer(std::chrono::milliseconds(10));
+  timer2->enableTimer(std::chrono::milliseconds(10));
+
+  EXPECT_CALL(watcher1, ready());
+  fireTickTimer();
+  EXPECT_EQ(nullptr, timer2.get());
+
+  // The timer re-armed itself from its callback.
+  EXPECT_CALL(watcher1, ready());
+  fireTickTimer();
+}
+
+} // namespace Event
+} // namespace Envoy
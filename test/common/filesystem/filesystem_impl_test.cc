@@ -1,7 +1,9 @@
 #include <chrono>
 #include <string>
+#include <vector>
 
 #include "common/api/os_sys_calls_impl.h"
+#include "common/buffer/buffer_impl.h"
 #include "common/common/thread.h"
 #include "common/event/dispatcher_impl.h"
 #include "common/filesystem/filesystem_impl.h"
@@ -12,6 +14,7 @@
 #include "test/mocks/filesystem/mocks.h"
 #include "test/test_common/environment.h"
 #include "test/test_common/threadsafe_singleton_injector.h"
+#include "test/test_common/utility.h"
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -31,11 +34,34 @@ TEST(FileSystemImpl, BadFile) {
   Event::MockDispatcher dispatcher;
   Thread::MutexBasicLockable lock;
   Stats::IsolatedStoreImpl store;
+  Filesystem::FlushExecutor flush_executor;
   EXPECT_CALL(dispatcher, createTimer_(_));
-  EXPECT_THROW(Filesystem::FileImpl("", dispatcher, lock, store, std::chrono::milliseconds(10000)),
+  EXPECT_THROW(Filesystem::FileImpl("", dispatcher, lock, flush_executor, store,
+                                    std::chrono::milliseconds(10000), 1024 * 1024),
                EnvoyException);
 }
 
+TEST(FileSystemImpl, WriteRing) {
+  Filesystem::WriteRing ring(8);
+  Buffer::OwnedImpl output;
+  EXPECT_EQ(0U, ring.drainTo(output));
+
+  EXPECT_TRUE(ring.push("abcde"));
+  EXPECT_FALSE(ring.push("fghi"));
+  EXPECT_EQ(5U, ring.size());
+  EXPECT_EQ(5U, ring.drainTo(output));
+  EXPECT_EQ("abcde", TestUtility::bufferToString(output));
+  output.drain(output.length());
+
+  // Wraps around the end of the ring.
+  EXPECT_TRUE(ring.push("fghijkl"));
+  EXPECT_TRUE(ring.push("m"));
+  EXPECT_FALSE(ring.push("n"));
+  EXPECT_EQ(8U, ring.drainTo(output));
+  EXPECT_EQ("fghijklm", TestUtility::bufferToString(output));
+  EXPECT_EQ(0U, ring.size());
+}
+
 TEST(FileSystemImpl, fileExists) {
   EXPECT_TRUE(Filesystem::fileExists("/dev/null"));
   EXPECT_FALSE(Filesystem::fileExists("/dev/blahblahblah"));
@@ -83,13 +109,16 @@ TEST(FileSystemImpl, flushToLogFilePeriodically) {
 
   Thread::MutexBasicLockable mutex;
   Stats::IsolatedStoreImpl stats_store;
+  Filesystem::FlushExecutor flush_executor;
   NiceMock<Api::MockOsSysCalls> os_sys_calls;
   TestThreadsafeSingletonInjector<Api::OsSysCallsImpl> os_calls(&os_sys_calls);
 
   EXPECT_CALL(os_sys_calls, open_(_, _, _)).WillOnce(Return(5));
-  Filesystem::FileImpl file("", dispatcher, mutex, stats_store, std::chrono::milliseconds(40));
+  Filesystem::FileImpl file("", dispatcher, mutex, flush_executor, stats_store,
+                            std::chrono::milliseconds(40), 1024 * 1024);
 
-  EXPECT_CALL(*timer, enableTimer(std::chrono::milliseconds(40)));
+  // The first write enables the timer and the callback re-enables it.
+  EXPECT_CALL(*timer, enableTimer(std::chrono::milliseconds(40))).Times(2);
   EXPECT_CALL(os_sys_calls, write_(_, _, _))
       .WillOnce(Invoke([](int fd, const void* buffer, size_t num_bytes) -> ssize_t {
         std::string written = std::string(reinterpret_cast<const char*>(buffer), num_bytes);
@@ -100,6 +129,7 @@ TEST(FileSystemImpl, flushToLogFilePeriodically) {
       }));
 
   file.write("test");
+  timer->callback_();
 
   {
     std::unique_lock<Thread::BasicLockable> lock(os_sys_calls.write_mutex_);
@@ -136,17 +166,18 @@ TEST(FileSystemImpl, flushToLogFileOnDemand) {
 
   Thread::MutexBasicLockable mutex;
   Stats::IsolatedStoreImpl stats_store;
+  Filesystem::FlushExecutor flush_executor;
   NiceMock<Api::MockOsSysCalls> os_sys_calls;
   TestThreadsafeSingletonInjector<Api::OsSysCallsImpl> os_calls(&os_sys_calls);
 
   EXPECT_CALL(os_sys_calls, open_(_, _, _)).WillOnce(Return(5));
-  Filesystem::FileImpl file("", dispatcher, mutex, stats_store, std::chrono::milliseconds(40));
+  Filesystem::FileImpl file("", dispatcher, mutex, flush_executor, stats_store,
+                            std::chrono::milliseconds(40), 1024 * 1024);
 
   EXPECT_CALL(*timer, enableTimer(std::chrono::milliseconds(40)));
 
-  // The first write to a given file will start the flush thread, which can flush
-  // immediately (race on whether it will or not). So do a write and flush to
-  // get that state out of the way, then test that small writes don't trigger a flush.
+  // The first write to a given file enables the flush timer. Do a write and flush to get that
+  // out of the way, then test that small writes don't trigger a flush.
   EXPECT_CALL(os_sys_calls, write_(_, _, _))
       .WillOnce(Invoke([](int, const void*, size_t num_bytes) -> ssize_t { return num_bytes; }));
   file.write("prime-it");
@@ -203,18 +234,62 @@ TEST(FileSystemImpl, flushToLogFileOnDemand) {
   }
 }
 
+TEST(FileSystemImpl, sharedFlushExecutor) {
+  NiceMock<Event::MockDispatcher> dispatcher;
+  NiceMock<Event::MockTimer>* timer1 = new NiceMock<Event::MockTimer>(&dispatcher);
+  NiceMock<Event::MockTimer>* timer2 = new NiceMock<Event::MockTimer>(&dispatcher);
+
+  Thread::MutexBasicLockable mutex;
+  Stats::IsolatedStoreImpl stats_store;
+  Filesystem::FlushExecutor flush_executor;
+  NiceMock<Api::MockOsSysCalls> os_sys_calls;
+  TestThreadsafeSingletonInjector<Api::OsSysCallsImpl> os_calls(&os_sys_calls);
+
+  EXPECT_CALL(os_sys_calls, open_(_, _, _)).WillOnce(Return(5)).WillOnce(Return(6));
+  Filesystem::FileImpl file1("", dispatcher, mutex, flush_executor, stats_store,
+                             std::chrono::milliseconds(40), 1024 * 1024);
+  Filesystem::FileImpl file2("", dispatcher, mutex, flush_executor, stats_store,
+                             std::chrono::milliseconds(40), 1024 * 1024);
+
+  // Both files are flushed by the same executor thread.
+  EXPECT_CALL(os_sys_calls, write_(5, _, _))
+      .WillOnce(Invoke([](int, const void* buffer, size_t num_bytes) -> ssize_t {
+        EXPECT_EQ("file1", std::string(reinterpret_cast<const char*>(buffer), num_bytes));
+        return num_bytes;
+      }));
+  EXPECT_CALL(os_sys_calls, write_(6, _, _))
+      .WillOnce(Invoke([](int, const void* buffer, size_t num_bytes) -> ssize_t {
+        EXPECT_EQ("file2", std::string(reinterpret_cast<const char*>(buffer), num_bytes));
+        return num_bytes;
+      }));
+
+  file1.write("file1");
+  file2.write("file2");
+  timer1->callback_();
+  timer2->callback_();
+
+  {
+    std::unique_lock<Thread::BasicLockable> lock(os_sys_calls.write_mutex_);
+    while (os_sys_calls.num_writes_ != 2) {
+      os_sys_calls.write_event_.wait(os_sys_calls.write_mutex_);
+    }
+  }
+}
+
 TEST(FileSystemImpl, reopenFile) {
   NiceMock<Event::MockDispatcher> dispatcher;
   NiceMock<Event::MockTimer>* timer = new NiceMock<Event::MockTimer>(&dispatcher);
 
   Thread::MutexBasicLockable mutex;
   Stats::IsolatedStoreImpl stats_store;
+  Filesystem::FlushExecutor flush_executor;
   NiceMock<Api::MockOsSysCalls> os_sys_calls;
   TestThreadsafeSingletonInjector<Api::OsSysCallsImpl> os_calls(&os_sys_calls);
 
   Sequence sq;
   EXPECT_CALL(os_sys_calls, open_(_, _, _)).InSequence(sq).WillOnce(Return(5));
-  Filesystem::FileImpl file("", dispatcher, mutex, stats_store, std::chrono::milliseconds(40));
+  Filesystem::FileImpl file("", dispatcher, mutex, flush_executor, stats_store,
+                            std::chrono::milliseconds(40), 1024 * 1024);
 
   EXPECT_CALL(os_sys_calls, write_(_, _, _))
       .InSequence(sq)
@@ -269,6 +344,7 @@ TEST(FilesystemImpl, reopenThrows) {
 
   Thread::MutexBasicLockable mutex;
   Stats::IsolatedStoreImpl stats_store;
+  Filesystem::FlushExecutor flush_executor;
   NiceMock<Api::MockOsSysCalls> os_sys_calls;
   TestThreadsafeSingletonInjector<Api::OsSysCallsImpl> os_calls(&os_sys_calls);
 
@@ -283,7 +359,8 @@ TEST(FilesystemImpl, reopenThrows) {
   Sequence sq;
   EXPECT_CALL(os_sys_calls, open_(_, _, _)).InSequence(sq).WillOnce(Return(5));
 
-  Filesystem::FileImpl file("", dispatcher, mutex, stats_store, std::chrono::milliseconds(40));
+  Filesystem::FileImpl file("", dispatcher, mutex, flush_executor, stats_store,
+                            std::chrono::milliseconds(40), 1024 * 1024);
   EXPECT_CALL(os_sys_calls, close(5)).InSequence(sq);
   EXPECT_CALL(os_sys_calls, open_(_, _, _)).InSequence(sq).WillOnce(Return(-1));
 
@@ -316,10 +393,12 @@ TEST(FilesystemImpl, bigDataChunkShouldBeFlushedWithoutTimer) {
   NiceMock<Event::MockDispatcher> dispatcher;
   Thread::MutexBasicLockable mutex;
   Stats::IsolatedStoreImpl stats_store;
+  Filesystem::FlushExecutor flush_executor;
   NiceMock<Api::MockOsSysCalls> os_sys_calls;
   TestThreadsafeSingletonInjector<Api::OsSysCallsImpl> os_calls(&os_sys_calls);
 
-  Filesystem::FileImpl file("", dispatcher, mutex, stats_store, std::chrono::milliseconds(40));
+  Filesystem::FileImpl file("", dispatcher, mutex, flush_executor, stats_store,
+                            std::chrono::milliseconds(40), 1024 * 1024);
 
   EXPECT_CALL(os_sys_calls, write_(_, _, _))
       .WillOnce(Invoke([](int fd, const void* buffer, size_t num_bytes) -> ssize_t {
@@ -333,16 +412,14 @@ TEST(FilesystemImpl, bigDataChunkShouldBeFlushedWithoutTimer) {
       }));
 
   file.write("a");
+  file.flush();
 
   {
     std::unique_lock<Thread::BasicLockable> lock(os_sys_calls.write_mutex_);
-    while (os_sys_calls.num_writes_ != 1) {
-      os_sys_calls.write_event_.wait(os_sys_calls.write_mutex_);
-    }
+    EXPECT_EQ(1U, os_sys_calls.num_writes_);
   }
 
-  // First write happens without waiting on thread_flush_. Now make a big string and it should be
-  // flushed even when timer is not enabled
+  // Now make a big string and it should be flushed even when the timer does not fire.
   EXPECT_CALL(os_sys_calls, write_(_, _, _))
       .WillOnce(Invoke([](int fd, const void* buffer, size_t num_bytes) -> ssize_t {
         UNREFERENCED_PARAMETER(fd);
@@ -364,4 +441,82 @@ TEST(FilesystemImpl, bigDataChunkShouldBeFlushedWithoutTimer) {
     }
   }
 }
+
+TEST(FilesystemImpl, writeDroppedWhenBufferFull) {
+  NiceMock<Event::MockDispatcher> dispatcher;
+  Thread::MutexBasicLockable mutex;
+  Stats::IsolatedStoreImpl stats_store;
+  Filesystem::FlushExecutor flush_executor;
+  NiceMock<Api::MockOsSysCalls> os_sys_calls;
+  TestThreadsafeSingletonInjector<Api::OsSysCallsImpl> os_calls(&os_sys_calls);
+
+  Filesystem::FileImpl file("", dispatcher, mutex, flush_executor, stats_store,
+                            std::chrono::milliseconds(40), 16);
+
+  EXPECT_CALL(os_sys_calls, write_(_, _, _))
+      .WillOnce(Invoke([](int, const void* buffer, size_t num_bytes) -> ssize_t {
+        EXPECT_EQ("0123456789", std::string(reinterpret_cast<const char*>(buffer), num_bytes));
+        return num_bytes;
+      }))
+      .WillOnce(Invoke([](int, const void* buffer, size_t num_bytes) -> ssize_t {
+        EXPECT_EQ("abcdefghij", std::string(reinterpret_cast<const char*>(buffer), num_bytes));
+        return num_bytes;
+      }));
+
+  // The second write does not fit in the 16 bytes left and is dropped rather than blocking.
+  file.write("0123456789");
+  file.write("0123456789");
+  EXPECT_EQ(1U, stats_store.counter("filesystem.write_dropped").value());
+  EXPECT_EQ(1U, stats_store.counter("filesystem.write_buffered").value());
+  file.flush();
+
+  // Once flushed, there is room again.
+  file.write("abcdefghij");
+  file.flush();
+  EXPECT_EQ(1U, stats_store.counter("filesystem.write_dropped").value());
+  EXPECT_EQ(0U, stats_store.gauge("filesystem.write_total_buffered").value());
+}
+
+TEST(FilesystemImpl, writesFromManyThreads) {
+  NiceMock<Event::MockDispatcher> dispatcher;
+  Thread::MutexBasicLockable mutex;
+  Stats::IsolatedStoreImpl stats_store;
+  Filesystem::FlushExecutor flush_executor;
+  NiceMock<Api::MockOsSysCalls> os_sys_calls;
+  TestThreadsafeSingletonInjector<Api::OsSysCallsImpl> os_calls(&os_sys_calls);
+
+  Filesystem::FileImpl file("", dispatcher, mutex, flush_executor, stats_store,
+                            std::chrono::milliseconds(40), 1024 * 1024);
+
+  std::string written;
+  EXPECT_CALL(os_sys_calls, write_(_, _, _))
+      .WillRepeatedly(Invoke([&](int, const void* buffer, size_t num_bytes) -> ssize_t {
+        written.append(reinterpret_cast<const char*>(buffer), num_bytes);
+        return num_bytes;
+      }));
+
+  // Every thread buffers in a ring of its own. Lines of each thread stay in order.
+  std::vector<Thread::ThreadPtr> threads;
+  for (char c : {'a', 'b', 'c', 'd'}) {
+    threads.emplace_back(new Thread::Thread([&file, c]() -> void {
+      for (int i = 0; i < 1000; i++) {
+        file.write(std::string(1, c) + std::to_string(i) + "\n");
+      }
+    }));
+  }
+  for (Thread::ThreadPtr& thread : threads) {
+    thread->join();
+  }
+  file.flush();
+
+  EXPECT_EQ(0U, stats_store.counter("filesystem.write_dropped").value());
+  for (char c : {'a', 'b', 'c', 'd'}) {
+    size_t position = 0;
+    for (int i = 0; i < 1000; i++) {
+      const size_t found = written.find(std::string(1, c) + std::to_string(i) + "\n", position);
+      ASSERT_NE(std::string::npos, found);
+      position = found;
+    }
+  }
+}
 } // namespace Envoy
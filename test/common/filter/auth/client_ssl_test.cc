@@ -5,6 +5,7 @@
 #include "common/config/filter_json.h"
 #include "common/filesystem/filesystem_impl.h"
 #include "common/filter/auth/client_ssl.h"
+#include "common/http/headers.h"
 #include "common/http/message_impl.h"
 #include "common/network/address_impl.h"
 
@@ -93,8 +94,11 @@ public:
     EXPECT_CALL(cm_, httpAsyncClientForCluster("vpn")).WillOnce(ReturnRef(cm_.async_client_));
     EXPECT_CALL(cm_.async_client_, send_(_, _, _))
         .WillOnce(
-            Invoke([this](Http::MessagePtr&, Http::AsyncClient::Callbacks& callbacks,
+            Invoke([this](Http::MessagePtr& request, Http::AsyncClient::Callbacks& callbacks,
                           Optional<std::chrono::milliseconds>) -> Http::AsyncClient::Request* {
+              const Http::HeaderEntry* if_none_match =
+                  request->headers().get(Http::Headers::get().IfNoneMatch);
+              if_none_match_ = if_none_match != nullptr ? if_none_match->value().c_str() : "";
               callbacks_ = &callbacks;
               return &request_;
             }));
@@ -109,6 +113,7 @@ public:
   std::unique_ptr<Instance> instance_;
   Event::MockTimer* interval_timer_;
   Http::AsyncClient::Callbacks* callbacks_;
+  std::string if_none_match_;
   Ssl::MockConnection ssl_;
   Stats::IsolatedStoreImpl stats_store_;
   NiceMock<Runtime::MockRandomGenerator> random_;
@@ -257,6 +262,41 @@ TEST_F(ClientSslAuthFilterTest, Ssl) {
   EXPECT_EQ(4U, stats_store_.counter("auth.clientssl.vpn.update_failure").value());
 }
 
+// Refreshes are conditional on the ETag of the last list, and a 304 keeps the principals.
+TEST_F(ClientSslAuthFilterTest, NotModified) {
+  setup();
+  EXPECT_EQ("", if_none_match_);
+
+  EXPECT_CALL(*interval_timer_, enableTimer(_));
+  Http::MessagePtr message(new Http::ResponseMessageImpl(Http::HeaderMapPtr{
+      new Http::TestHeaderMapImpl{{":status", "200"}, {"etag", "\"v1\""}}}));
+  message->body().reset(new Buffer::OwnedImpl(Filesystem::fileReadToEnd(
+      TestEnvironment::runfilesPath("test/common/filter/auth/test_data/vpn_response_1.json"))));
+  callbacks_->onSuccess(std::move(message));
+  EXPECT_EQ(1U, stats_store_.gauge("auth.clientssl.vpn.total_principals").value());
+
+  setupRequest();
+  interval_timer_->callback_();
+  EXPECT_EQ("\"v1\"", if_none_match_);
+
+  EXPECT_CALL(*interval_timer_, enableTimer(_));
+  message.reset(new Http::ResponseMessageImpl(
+      Http::HeaderMapPtr{new Http::TestHeaderMapImpl{{":status", "304"}}}));
+  callbacks_->onSuccess(std::move(message));
+  EXPECT_EQ(1U, stats_store_.counter("auth.clientssl.vpn.update_success").value());
+  EXPECT_EQ(1U, stats_store_.counter("auth.clientssl.vpn.update_not_modified").value());
+  EXPECT_EQ(0U, stats_store_.counter("auth.clientssl.vpn.update_failure").value());
+  EXPECT_TRUE(config_->allowedPrincipals().allowed(
+      "1b7d42ef0025ad89c1c911d6c10d7e86a4cb7c5863b2980abcbad1895f8b5314"));
+
+  // The next refresh is still conditional on the same ETag.
+  setupRequest();
+  interval_timer_->callback_();
+  EXPECT_EQ("\"v1\"", if_none_match_);
+
+  EXPECT_CALL(request_, cancel());
+}
+
 } // namespace ClientSsl
 } // namespace Auth
 } // namespace Filter
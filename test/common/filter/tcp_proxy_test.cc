@@ -14,6 +14,7 @@
 #include "test/mocks/network/mocks.h"
 #include "test/mocks/runtime/mocks.h"
 #include "test/mocks/server/mocks.h"
+#include "test/mocks/thread_local/mocks.h"
 #include "test/mocks/upstream/host.h"
 #include "test/mocks/upstream/mocks.h"
 #include "test/test_common/printers.h"
@@ -21,8 +22,10 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
+using testing::DoAll;
 using testing::MatchesRegex;
 using testing::NiceMock;
+using testing::Ref;
 using testing::Return;
 using testing::ReturnPointee;
 using testing::ReturnRef;
@@ -354,6 +357,126 @@ TEST(TcpProxyConfigTest, AccessLogConfig) {
   EXPECT_EQ(2, config_obj.accessLogs().size());
 }
 
+class TcpProxyConnPoolTest : public testing::Test {
+public:
+  TcpProxyConnPoolTest() {
+    ON_CALL(runtime_.snapshot_, getInteger("tcp_proxy.conn_pool.target_size", 0))
+        .WillByDefault(Return(2));
+  }
+
+  // Expect the pool to open a connection, whose timer is returned.
+  NiceMock<Event::MockTimer>* expectConnect(NiceMock<Network::MockClientConnection>* connection) {
+    Upstream::MockHost::MockCreateConnectionData data;
+    data.connection_ = connection;
+    data.host_description_ = host_;
+    EXPECT_CALL(cluster_manager_, tcpConnForCluster_("fake_cluster", nullptr))
+        .WillOnce(Return(data))
+        .RetiresOnSaturation();
+    EXPECT_CALL(*connection, readDisable(true));
+    EXPECT_CALL(*connection, connect());
+    NiceMock<Event::MockTimer>* timer = new NiceMock<Event::MockTimer>(&tls_.dispatcher_);
+    EXPECT_CALL(*timer, enableTimer(std::chrono::milliseconds(1)));
+    return timer;
+  }
+
+  NiceMock<Upstream::MockClusterManager> cluster_manager_;
+  NiceMock<Runtime::MockLoader> runtime_;
+  NiceMock<ThreadLocal::MockInstance> tls_;
+  std::shared_ptr<NiceMock<Upstream::MockHost>> host_{new NiceMock<Upstream::MockHost>()};
+  TcpProxyConnPool pool_{cluster_manager_, runtime_, tls_};
+};
+
+TEST_F(TcpProxyConnPoolTest, Disabled) {
+  EXPECT_CALL(runtime_.snapshot_, getInteger("tcp_proxy.conn_pool.target_size", 0))
+      .WillRepeatedly(Return(0));
+  EXPECT_CALL(cluster_manager_, tcpConnForCluster_(_, _)).Times(0);
+  EXPECT_EQ(nullptr, pool_.take("fake_cluster").connection_);
+}
+
+TEST_F(TcpProxyConnPoolTest, OriginalDst) {
+  cluster_manager_.thread_local_cluster_.cluster_.info_->lb_type_ =
+      Upstream::LoadBalancerType::OriginalDst;
+  EXPECT_CALL(cluster_manager_, tcpConnForCluster_(_, _)).Times(0);
+  EXPECT_EQ(nullptr, pool_.take("fake_cluster").connection_);
+}
+
+TEST_F(TcpProxyConnPoolTest, TakeAndFill) {
+  NiceMock<Network::MockClientConnection>* connection1 =
+      new NiceMock<Network::MockClientConnection>();
+  NiceMock<Network::MockClientConnection>* connection2 =
+      new NiceMock<Network::MockClientConnection>();
+  NiceMock<Event::MockTimer>* timer1;
+  {
+    testing::InSequence sequence;
+    timer1 = expectConnect(connection1);
+    expectConnect(connection2);
+  }
+  EXPECT_EQ(nullptr, pool_.take("fake_cluster").connection_);
+
+  // Connections that are still connecting are not handed out.
+  EXPECT_CALL(cluster_manager_, tcpConnForCluster_(_, _)).Times(0);
+  EXPECT_EQ(nullptr, pool_.take("fake_cluster").connection_);
+
+  EXPECT_CALL(*timer1, enableTimer(std::chrono::milliseconds(60000)));
+  connection1->raiseEvent(Network::ConnectionEvent::Connected);
+
+  EXPECT_CALL(*timer1, disableTimer());
+  EXPECT_CALL(*connection1, readDisable(false));
+  NiceMock<Network::MockClientConnection>* connection3 =
+      new NiceMock<Network::MockClientConnection>();
+  expectConnect(connection3);
+  Upstream::Host::CreateConnectionData data = pool_.take("fake_cluster");
+  EXPECT_EQ(connection1, data.connection_.get());
+  EXPECT_EQ(host_, data.host_description_);
+  EXPECT_TRUE(connection1->callbacks_.empty());
+  data.connection_->close(Network::ConnectionCloseType::NoFlush);
+}
+
+TEST_F(TcpProxyConnPoolTest, ConnectFailure) {
+  NiceMock<Network::MockClientConnection>* connection1 =
+      new NiceMock<Network::MockClientConnection>();
+  NiceMock<Network::MockClientConnection>* connection2 =
+      new NiceMock<Network::MockClientConnection>();
+  NiceMock<Event::MockTimer>* timer2;
+  {
+    testing::InSequence sequence;
+    expectConnect(connection1);
+    timer2 = expectConnect(connection2);
+  }
+  EXPECT_EQ(nullptr, pool_.take("fake_cluster").connection_);
+
+  // Failed connections are replaced by the next take(), so retries follow the rate of sessions.
+  EXPECT_CALL(tls_.dispatcher_, deferredDelete_(_));
+  connection1->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  EXPECT_CALL(*connection2, close(Network::ConnectionCloseType::NoFlush));
+  EXPECT_CALL(tls_.dispatcher_, deferredDelete_(_));
+  timer2->callback_();
+
+  EXPECT_CALL(cluster_manager_, tcpConnForCluster_("fake_cluster", nullptr))
+      .WillOnce(Return(Upstream::MockHost::MockCreateConnectionData()));
+  EXPECT_EQ(nullptr, pool_.take("fake_cluster").connection_);
+}
+
+TEST_F(TcpProxyConnPoolTest, IdleTimeout) {
+  ON_CALL(runtime_.snapshot_, getInteger("tcp_proxy.conn_pool.target_size", 0))
+      .WillByDefault(Return(1));
+  EXPECT_CALL(runtime_.snapshot_, getInteger("tcp_proxy.conn_pool.max_idle_ms", 60000))
+      .WillRepeatedly(Return(100));
+  NiceMock<Network::MockClientConnection>* connection =
+      new NiceMock<Network::MockClientConnection>();
+  NiceMock<Event::MockTimer>* timer = expectConnect(connection);
+  EXPECT_EQ(nullptr, pool_.take("fake_cluster").connection_);
+
+  EXPECT_CALL(*timer, enableTimer(std::chrono::milliseconds(100)));
+  connection->raiseEvent(Network::ConnectionEvent::Connected);
+  EXPECT_CALL(*connection, close(Network::ConnectionCloseType::NoFlush));
+  timer->callback_();
+
+  EXPECT_CALL(cluster_manager_, tcpConnForCluster_("fake_cluster", nullptr))
+      .WillOnce(Return(Upstream::MockHost::MockCreateConnectionData()));
+  EXPECT_EQ(nullptr, pool_.take("fake_cluster").connection_);
+}
+
 class TcpProxyNoConfigTest : public testing::Test {
 public:
   TcpProxyNoConfigTest() {}
@@ -772,6 +895,102 @@ TEST_F(TcpProxyTest, IdleTimerDisabledUpstreamClose) {
   upstream_connections_.at(0)->raiseEvent(Network::ConnectionEvent::RemoteClose);
 }
 
+// Test that data is spliced between the connections once the upstream connects, if enabled.
+TEST_F(TcpProxyTest, Splice) {
+  ON_CALL(factory_context_.runtime_loader_.snapshot_,
+          featureEnabled("tcp_proxy.splice_enabled", 0))
+      .WillByDefault(Return(true));
+  envoy::api::v2::filter::network::TcpProxy config =
+      accessLogConfig("bytesreceived=%BYTES_RECEIVED% bytessent=%BYTES_SENT%");
+  config.mutable_idle_timeout()->set_seconds(1);
+  setup(1, config);
+
+  Event::MockTimer* idle_timer = new Event::MockTimer(&filter_callbacks_.connection_.dispatcher_);
+  EXPECT_CALL(*idle_timer, enableTimer(std::chrono::milliseconds(1000)));
+  Network::Connection::BytesSplicedCb downstream_cb;
+  Network::Connection::BytesSplicedCb upstream_cb;
+  EXPECT_CALL(filter_callbacks_.connection_, spliceTo(Ref(*upstream_connections_.at(0)), _))
+      .WillOnce(DoAll(SaveArg<1>(&downstream_cb), Return(true)));
+  EXPECT_CALL(*upstream_connections_.at(0), spliceTo(Ref(filter_callbacks_.connection_), _))
+      .WillOnce(DoAll(SaveArg<1>(&upstream_cb), Return(true)));
+  raiseEventUpstreamConnected(0);
+  EXPECT_EQ(1U, config_->stats().downstream_cx_splice_total_.value());
+
+  // Spliced data counts as received and sent, and keeps the connection from going idle.
+  EXPECT_CALL(*idle_timer, enableTimer(std::chrono::milliseconds(1000)));
+  downstream_cb(3);
+  EXPECT_CALL(*idle_timer, enableTimer(std::chrono::milliseconds(1000)));
+  upstream_cb(5);
+
+  // Data that was buffered before is still counted.
+  Buffer::OwnedImpl buffer("a");
+  EXPECT_CALL(*idle_timer, enableTimer(std::chrono::milliseconds(1000)));
+  filter_->onData(buffer);
+
+  EXPECT_CALL(*idle_timer, disableTimer());
+  upstream_connections_.at(0)->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  filter_.reset();
+  EXPECT_EQ("bytesreceived=4 bytessent=5", access_log_data_);
+}
+
+// Test that connections that cannot be spliced keep using buffers.
+TEST_F(TcpProxyTest, SpliceUnavailable) {
+  ON_CALL(factory_context_.runtime_loader_.snapshot_,
+          featureEnabled("tcp_proxy.splice_enabled", 0))
+      .WillByDefault(Return(true));
+  setup(1);
+
+  EXPECT_CALL(filter_callbacks_.connection_, spliceTo(_, _)).WillOnce(Return(false));
+  EXPECT_CALL(*upstream_connections_.at(0), spliceTo(_, _)).WillOnce(Return(false));
+  raiseEventUpstreamConnected(0);
+  EXPECT_EQ(0U, config_->stats().downstream_cx_splice_total_.value());
+
+  Buffer::OwnedImpl buffer("hello");
+  EXPECT_CALL(*upstream_connections_.at(0), write(BufferEqual(&buffer)));
+  filter_->onData(buffer);
+}
+
+// Test that sessions start right away on connections from the pool.
+TEST_F(TcpProxyTest, ConnPool) {
+  ON_CALL(factory_context_.runtime_loader_.snapshot_,
+          getInteger("tcp_proxy.conn_pool.target_size", 0))
+      .WillByDefault(Return(1));
+  configure(defaultConfig());
+
+  NiceMock<Network::MockClientConnection>* connection =
+      new NiceMock<Network::MockClientConnection>();
+  std::shared_ptr<NiceMock<Upstream::MockHost>> host(new NiceMock<Upstream::MockHost>());
+  ON_CALL(*host, cluster())
+      .WillByDefault(
+          ReturnPointee(factory_context_.cluster_manager_.thread_local_cluster_.cluster_.info_));
+  connection->local_address_ = Network::Utility::resolveUrl("tcp://2.2.2.2:50000");
+  Upstream::MockHost::MockCreateConnectionData conn_info;
+  conn_info.connection_ = connection;
+  conn_info.host_description_ = host;
+  EXPECT_CALL(factory_context_.cluster_manager_, tcpConnForCluster_("fake_cluster", nullptr))
+      .WillOnce(Return(conn_info))
+      .WillOnce(Return(Upstream::MockHost::MockCreateConnectionData()));
+  EXPECT_EQ(nullptr, config_->connPool().take("fake_cluster").connection_);
+  connection->raiseEvent(Network::ConnectionEvent::Connected);
+
+  EXPECT_CALL(*connection, connect()).Times(0);
+  EXPECT_CALL(*connection, addReadFilter(_)).WillOnce(SaveArg<0>(&upstream_read_filter_));
+  EXPECT_CALL(filter_callbacks_.connection_.dispatcher_, createTimer_(_)).Times(0);
+  filter_.reset(new TcpProxy(config_, factory_context_.cluster_manager_));
+  filter_->initializeReadFilterCallbacks(filter_callbacks_);
+  EXPECT_CALL(filter_callbacks_.connection_, readDisable(false));
+  EXPECT_EQ(Network::FilterStatus::Continue, filter_->onNewConnection());
+  EXPECT_EQ(1U, config_->stats().downstream_cx_pooled_total_.value());
+  EXPECT_EQ(host, filter_callbacks_.upstreamHost());
+
+  Buffer::OwnedImpl buffer("hello");
+  EXPECT_CALL(*connection, write(BufferEqual(&buffer)));
+  filter_->onData(buffer);
+
+  EXPECT_CALL(filter_callbacks_.connection_, close(Network::ConnectionCloseType::FlushWrite));
+  connection->raiseEvent(Network::ConnectionEvent::RemoteClose);
+}
+
 // Test that access log fields %UPSTREAM_HOST% and %UPSTREAM_CLUSTER% are correctly logged.
 TEST_F(TcpProxyTest, AccessLogUpstreamHost) {
   setup(1, accessLogConfig("%UPSTREAM_HOST% %UPSTREAM_CLUSTER%"));
@@ -0,0 +1,179 @@
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/event/dispatcher_impl.h"
+#include "common/filter/udp_proxy.h"
+#include "common/network/listen_socket_impl.h"
+#include "common/network/udp_listener_impl.h"
+#include "common/stats/stats_impl.h"
+
+#include "test/mocks/upstream/host.h"
+#include "test/mocks/upstream/mocks.h"
+#include "test/test_common/environment.h"
+#include "test/test_common/network_utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::NiceMock;
+using testing::Return;
+using testing::_;
+
+namespace Envoy {
+namespace Filter {
+
+class UdpProxyTest : public testing::TestWithParam<Network::Address::IpVersion> {
+public:
+  UdpProxyTest()
+      : upstream_socket_(Network::Test::getCanonicalLoopbackAddress(GetParam()), false),
+        listen_socket_(Network::Test::getCanonicalLoopbackAddress(GetParam()), false) {
+    ON_CALL(*cluster_manager_.thread_local_cluster_.lb_.host_, address())
+        .WillByDefault(Return(upstream_socket_.localAddress()));
+  }
+
+  ~UdpProxyTest() {
+    for (int fd : client_fds_) {
+      ::close(fd);
+    }
+  }
+
+  void initialize(std::chrono::milliseconds idle_timeout = std::chrono::seconds(60)) {
+    config_.cluster_ = "fake_cluster";
+    config_.idle_timeout_ = idle_timeout;
+    config_.stat_prefix_ = "dns";
+    proxy_.reset(new UdpProxy(dispatcher_, cluster_manager_, stats_store_, config_));
+    listener_.reset(new Network::UdpListenerImpl(dispatcher_, listen_socket_, *proxy_));
+    proxy_->setListener(*listener_);
+  }
+
+  int newClient() {
+    const int fd = listen_socket_.localAddress()->socket(Network::Address::SocketType::Datagram);
+    EXPECT_EQ(0, listen_socket_.localAddress()->connect(fd));
+    client_fds_.push_back(fd);
+    return fd;
+  }
+
+  void clientSend(int fd, const std::string& data) {
+    ASSERT_EQ(static_cast<ssize_t>(data.size()), ::send(fd, data.data(), data.size(), 0));
+  }
+
+  // Runs the dispatcher until the fd has a datagram, which is returned along with the address of
+  // its sender.
+  std::string recv(int fd, sockaddr_storage* peer = nullptr, socklen_t* peer_len = nullptr) {
+    char buffer[64];
+    sockaddr_storage from;
+    for (uint32_t i = 0; i < 1000; i++) {
+      socklen_t from_len = sizeof(from);
+      const ssize_t rc = ::recvfrom(fd, buffer, sizeof(buffer), MSG_DONTWAIT,
+                                    reinterpret_cast<sockaddr*>(&from), &from_len);
+      if (rc >= 0) {
+        if (peer != nullptr) {
+          memcpy(peer, &from, from_len);
+          *peer_len = from_len;
+        }
+        return std::string(buffer, rc);
+      }
+      dispatcher_.run(Event::Dispatcher::RunType::NonBlock);
+      usleep(1000);
+    }
+    return "";
+  }
+
+  // Reads a datagram on the upstream and echoes it back with a prefix.
+  std::string upstreamEcho() {
+    sockaddr_storage peer;
+    socklen_t peer_len;
+    const std::string data = recv(upstream_socket_.fd(), &peer, &peer_len);
+    const std::string reply = "re: " + data;
+    EXPECT_EQ(static_cast<ssize_t>(reply.size()),
+              ::sendto(upstream_socket_.fd(), reply.data(), reply.size(), 0,
+                       reinterpret_cast<const sockaddr*>(&peer), peer_len));
+    return data;
+  }
+
+  Event::DispatcherImpl dispatcher_;
+  Network::UdpListenSocket upstream_socket_;
+  Network::UdpListenSocket listen_socket_;
+  NiceMock<Upstream::MockClusterManager> cluster_manager_;
+  Stats::IsolatedStoreImpl stats_store_;
+  UdpProxyConfig config_;
+  std::unique_ptr<UdpProxy> proxy_;
+  std::unique_ptr<Network::UdpListenerImpl> listener_;
+  std::vector<int> client_fds_;
+};
+
+INSTANTIATE_TEST_CASE_P(IpVersions, UdpProxyTest,
+                        testing::ValuesIn(TestEnvironment::getIpVersionsForTest()));
+
+TEST_P(UdpProxyTest, RoundTrip) {
+  initialize();
+  const int client = newClient();
+
+  clientSend(client, "hello");
+  EXPECT_EQ("hello", upstreamEcho());
+  EXPECT_EQ("re: hello", recv(client));
+
+  clientSend(client, "world");
+  EXPECT_EQ("world", upstreamEcho());
+  EXPECT_EQ("re: world", recv(client));
+
+  EXPECT_EQ(1UL, proxy_->numSessions());
+  EXPECT_EQ(1UL, stats_store_.counter("udp.dns.downstream_sess_total").value());
+  EXPECT_EQ(1UL, stats_store_.gauge("udp.dns.downstream_sess_active").value());
+  EXPECT_EQ(2UL, stats_store_.counter("udp.dns.downstream_rx_datagrams").value());
+  EXPECT_EQ(2UL, stats_store_.counter("udp.dns.upstream_rx_datagrams").value());
+}
+
+// Each peer gets its own session, and replies go back to the peer whose session they arrive on.
+TEST_P(UdpProxyTest, SessionPerPeer) {
+  initialize();
+  const int client1 = newClient();
+  const int client2 = newClient();
+
+  clientSend(client1, "one");
+  EXPECT_EQ("one", upstreamEcho());
+  clientSend(client2, "two");
+  EXPECT_EQ("two", upstreamEcho());
+
+  EXPECT_EQ("re: two", recv(client2));
+  EXPECT_EQ("re: one", recv(client1));
+  EXPECT_EQ(2UL, proxy_->numSessions());
+  EXPECT_EQ(2UL, stats_store_.gauge("udp.dns.downstream_sess_active").value());
+}
+
+TEST_P(UdpProxyTest, NoHost) {
+  initialize();
+  EXPECT_CALL(cluster_manager_.thread_local_cluster_.lb_, chooseHost(_)).WillOnce(Return(nullptr));
+  const int client = newClient();
+
+  clientSend(client, "hello");
+  while (stats_store_.counter("udp.dns.downstream_sess_no_route").value() == 0) {
+    dispatcher_.run(Event::Dispatcher::RunType::NonBlock);
+  }
+  EXPECT_EQ(0UL, proxy_->numSessions());
+  EXPECT_EQ(0UL, stats_store_.counter("udp.dns.downstream_sess_total").value());
+}
+
+TEST_P(UdpProxyTest, IdleTimeout) {
+  initialize(std::chrono::milliseconds(10));
+  const int client = newClient();
+
+  clientSend(client, "hello");
+  EXPECT_EQ("hello", upstreamEcho());
+  EXPECT_EQ(1UL, proxy_->numSessions());
+
+  while (proxy_->numSessions() > 0) {
+    dispatcher_.run(Event::Dispatcher::RunType::NonBlock);
+    usleep(1000);
+  }
+  EXPECT_EQ(1UL, stats_store_.counter("udp.dns.idle_timeout").value());
+  EXPECT_EQ(0UL, stats_store_.gauge("udp.dns.downstream_sess_active").value());
+}
+
+} // namespace Filter
+} // namespace Envoy
@@ -8,6 +8,7 @@
 
 #include "test/proto/helloworld.pb.h"
 #include "test/test_common/printers.h"
+#include "test/test_common/utility.h"
 
 #include "gtest/gtest.h"
 
@@ -166,5 +167,53 @@ TEST(GrpcCodecTest, decodeMultipleFrame) {
   }
 }
 
+TEST(GrpcCodecTest, decodeByteByByte) {
+  helloworld::HelloRequest request;
+  request.set_name("hello");
+  const std::string request_buffer = request.SerializeAsString();
+
+  std::array<uint8_t, 5> header;
+  Encoder encoder;
+  encoder.newFrame(GRPC_FH_DEFAULT, request.ByteSize(), header);
+  std::string input;
+  for (int i = 0; i < 3; i++) {
+    input.append(reinterpret_cast<const char*>(header.data()), header.size());
+    input.append(request_buffer);
+  }
+
+  // Headers and data split at every possible point are put back together.
+  std::vector<Frame> frames;
+  Decoder decoder;
+  for (char c : input) {
+    Buffer::OwnedImpl buffer(&c, 1);
+    EXPECT_TRUE(decoder.decode(buffer, frames));
+    EXPECT_EQ(0, buffer.length());
+  }
+  EXPECT_EQ(3, frames.size());
+  for (Frame& frame : frames) {
+    EXPECT_EQ(static_cast<uint64_t>(request.ByteSize()), frame.length_);
+    EXPECT_EQ(request_buffer, TestUtility::bufferToString(*frame.data_));
+  }
+}
+
+TEST(GrpcCodecTest, decodeInvalidFrameAfterValidFrame) {
+  Buffer::OwnedImpl buffer;
+  std::array<uint8_t, 5> header;
+  Encoder encoder;
+  encoder.newFrame(GRPC_FH_DEFAULT, 3, header);
+  buffer.add(header.data(), 5);
+  buffer.add("abc");
+  encoder.newFrame(0b10u, 3, header);
+  buffer.add(header.data(), 5);
+  buffer.add("def");
+
+  std::vector<Frame> frames;
+  Decoder decoder;
+  EXPECT_FALSE(decoder.decode(buffer, frames));
+  EXPECT_EQ(1, frames.size());
+  EXPECT_EQ("abc", TestUtility::bufferToString(*frames[0].data_));
+  EXPECT_EQ(8, buffer.length());
+}
+
 } // namespace Grpc
 } // namespace Envoy
@@ -1,3 +1,4 @@
+#include "common/buffer/buffer_impl.h"
 #include "common/grpc/common.h"
 #include "common/http/headers.h"
 
@@ -77,6 +78,20 @@ TEST(GrpcCommonTest, PrepareHeaders) {
   EXPECT_STREQ("application/grpc", message->headers().ContentType()->value().c_str());
 }
 
+TEST(GrpcCommonTest, SerializeBodyAppends) {
+  helloworld::HelloRequest request;
+  request.set_name("hello");
+  const std::string serialized = request.SerializeAsString();
+
+  Buffer::OwnedImpl buffer("abc");
+  Common::serializeBody(request, buffer);
+  Common::serializeBody(request, buffer);
+  const std::string frame = std::string("\0\0\0\0", 4) +
+                            static_cast<char>(serialized.size()) + serialized;
+  EXPECT_EQ("abc" + frame + frame, TestUtility::bufferToString(buffer));
+  EXPECT_EQ(frame, TestUtility::bufferToString(*Common::serializeBody(request)));
+}
+
 TEST(GrpcCommonTest, ResolveServiceAndMethod) {
   std::string service;
   std::string method;
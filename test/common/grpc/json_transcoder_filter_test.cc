@@ -27,8 +27,6 @@ using testing::ReturnPointee;
 using testing::ReturnRef;
 using testing::_;
 
-using Envoy::Protobuf::MethodDescriptor;
-
 using Envoy::Protobuf::FileDescriptorProto;
 using Envoy::Protobuf::FileDescriptorSet;
 using Envoy::Protobuf::util::MessageDifferencer;
@@ -165,13 +163,33 @@ TEST_F(GrpcJsonTranscoderConfigTest, CreateTranscoder) {
 
   TranscoderInputStreamImpl request_in, response_in;
   std::unique_ptr<Transcoder> transcoder;
-  const MethodDescriptor* method_descriptor;
-  auto status =
-      config.createTranscoder(headers, request_in, response_in, transcoder, method_descriptor);
+  const MethodInfo* method_info;
+  auto status = config.createTranscoder(headers, request_in, response_in, transcoder, method_info);
+
+  EXPECT_TRUE(status.ok());
+  EXPECT_TRUE(transcoder);
+  EXPECT_EQ("bookstore.Bookstore.ListShelves", method_info->descriptor_->full_name());
+  EXPECT_EQ("/bookstore.Bookstore/ListShelves", method_info->grpc_path_);
+}
+
+TEST_F(GrpcJsonTranscoderConfigTest, CreateTranscoderWithVariableBindings) {
+  JsonTranscoderConfig config(getProtoConfig(
+      TestEnvironment::runfilesPath("test/proto/bookstore.descriptor"), "bookstore.Bookstore"));
+
+  Http::TestHeaderMapImpl headers{{":method", "DELETE"}, {":path", "/shelves/1/books/2"}};
+
+  TranscoderInputStreamImpl request_in, response_in;
+  std::unique_ptr<Transcoder> transcoder;
+  const MethodInfo* method_info;
+  auto status = config.createTranscoder(headers, request_in, response_in, transcoder, method_info);
 
   EXPECT_TRUE(status.ok());
   EXPECT_TRUE(transcoder);
-  EXPECT_EQ("bookstore.Bookstore.ListShelves", method_descriptor->full_name());
+  EXPECT_EQ("bookstore.Bookstore.DeleteBook", method_info->descriptor_->full_name());
+  // The path variables were resolved when the config was loaded.
+  EXPECT_EQ(2, method_info->field_paths_.size());
+  EXPECT_EQ("shelf", method_info->field_paths_.at("shelf")[0]->name());
+  EXPECT_EQ("book", method_info->field_paths_.at("book")[0]->name());
 }
 
 TEST_F(GrpcJsonTranscoderConfigTest, InvalidVariableBinding) {
@@ -185,9 +203,8 @@ TEST_F(GrpcJsonTranscoderConfigTest, InvalidVariableBinding) {
 
   TranscoderInputStreamImpl request_in, response_in;
   std::unique_ptr<Transcoder> transcoder;
-  const MethodDescriptor* method_descriptor;
-  auto status =
-      config.createTranscoder(headers, request_in, response_in, transcoder, method_descriptor);
+  const MethodInfo* method_info;
+  auto status = config.createTranscoder(headers, request_in, response_in, transcoder, method_info);
 
   EXPECT_EQ(Code::INVALID_ARGUMENT, status.error_code());
   EXPECT_EQ("Could not find field \"b\" in the type \"bookstore.GetBookRequest\".",
@@ -334,6 +351,53 @@ TEST_F(GrpcJsonTranscoderFilterTest, TranscodingUnaryError) {
   EXPECT_EQ(0, request_data.length());
 }
 
+TEST_F(GrpcJsonTranscoderFilterTest, TranscodingUnaryMessageTooLarge) {
+  ON_CALL(decoder_callbacks_, decoderBufferLimit()).WillByDefault(Return(32));
+  Http::TestHeaderMapImpl request_headers{
+      {"content-type", "application/json"}, {":method", "POST"}, {":path", "/shelf"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_.decodeHeaders(request_headers, false));
+
+  Buffer::OwnedImpl request_data{"{\"theme\": \"" + std::string(16, 'a')};
+  EXPECT_EQ(Http::FilterDataStatus::Continue, filter_.decodeData(request_data, false));
+  EXPECT_EQ(0, request_data.length());
+
+  EXPECT_CALL(decoder_callbacks_, encodeHeaders_(_, false))
+      .WillOnce(Invoke([](Http::HeaderMap& headers, bool) {
+        EXPECT_STREQ("413", headers.Status()->value().c_str());
+      }));
+  EXPECT_CALL(decoder_callbacks_, encodeData(_, true));
+  request_data.add(std::string(16, 'a'));
+  EXPECT_EQ(Http::FilterDataStatus::StopIterationNoBuffer,
+            filter_.decodeData(request_data, false));
+}
+
+TEST_F(GrpcJsonTranscoderFilterTest, TranscodingStreamingRequestLargerThanLimit) {
+  // Only a single message has to fit in the limit, not the whole stream.
+  ON_CALL(decoder_callbacks_, decoderBufferLimit()).WillByDefault(Return(64));
+  Http::TestHeaderMapImpl request_headers{
+      {"content-type", "application/json"}, {":method", "POST"}, {":path", "/bulk/shelves"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_.decodeHeaders(request_headers, false));
+  EXPECT_CALL(decoder_callbacks_, encodeHeaders_(_, _)).Times(0);
+
+  Decoder decoder;
+  std::vector<Frame> frames;
+  Buffer::OwnedImpl request_data{"["};
+  for (int i = 0; i < 10; i++) {
+    request_data.add((i == 0 ? "" : ",") + std::string("{\"theme\": \"Theme ") +
+                     std::to_string(i) + "\"}");
+    EXPECT_EQ(Http::FilterDataStatus::Continue, filter_.decodeData(request_data, false));
+    decoder.decode(request_data, frames);
+  }
+  request_data.add("]");
+  EXPECT_EQ(Http::FilterDataStatus::Continue, filter_.decodeData(request_data, true));
+  decoder.decode(request_data, frames);
+
+  EXPECT_EQ(10, frames.size());
+  bookstore::CreateShelfRequest request;
+  request.ParseFromString(TestUtility::bufferToString(*frames[9].data_));
+  EXPECT_EQ("Theme 9", request.shelf().theme());
+}
+
 struct GrpcJsonTranscoderFilterPrintTestParam {
   std::string config_json_;
   std::string expected_response_;
@@ -857,10 +857,49 @@ TEST_F(AsyncClientImplTest, WatermarkCallbacks) {
   stream->sendHeaders(headers, false);
   Http::StreamDecoderFilterCallbacks* filter_callbacks =
       static_cast<Http::AsyncStreamImpl*>(stream);
+  // Only the first and last of nested watermark events are passed on.
+  EXPECT_CALL(stream_callbacks_, onAboveWriteBufferHighWatermark());
   filter_callbacks->onDecoderFilterAboveWriteBufferHighWatermark();
+  filter_callbacks->onDecoderFilterAboveWriteBufferHighWatermark();
+  EXPECT_TRUE(stream->isAboveWriteBufferHighWatermark());
+  filter_callbacks->onDecoderFilterBelowWriteBufferLowWatermark();
+  EXPECT_CALL(stream_callbacks_, onBelowWriteBufferLowWatermark());
   filter_callbacks->onDecoderFilterBelowWriteBufferLowWatermark();
+  EXPECT_FALSE(stream->isAboveWriteBufferHighWatermark());
   EXPECT_CALL(stream_callbacks_, onReset());
 }
 
+TEST_F(AsyncClientImplTest, ReadDisable) {
+  EXPECT_CALL(cm_.conn_pool_, newStream(_, _))
+      .WillOnce(Invoke([&](StreamDecoder& decoder,
+                           ConnectionPool::Callbacks& callbacks) -> ConnectionPool::Cancellable* {
+        callbacks.onPoolReady(stream_encoder_, cm_.conn_pool_.host_);
+        response_decoder_ = &decoder;
+        return nullptr;
+      }));
+
+  TestHeaderMapImpl headers;
+  HttpTestUtility::addDefaultHeaders(headers);
+  AsyncClient::Stream* stream =
+      client_.start(stream_callbacks_, Optional<std::chrono::milliseconds>(), false);
+
+  // Reads disabled before the upstream request starts apply once it does.
+  stream->readDisable(true);
+  EXPECT_CALL(stream_encoder_.stream_, readDisable(true));
+  stream->sendHeaders(headers, false);
+
+  // Nested calls only reach the upstream stream on the outermost ones.
+  stream->readDisable(true);
+  stream->readDisable(false);
+  EXPECT_CALL(stream_encoder_.stream_, readDisable(false));
+  stream->readDisable(false);
+
+  EXPECT_CALL(stream_encoder_.stream_, readDisable(true));
+  stream->readDisable(true);
+
+  expectResponseHeaders(stream_callbacks_, 200, true);
+  response_decoder_->decodeHeaders(HeaderMapPtr(new TestHeaderMapImpl{{":status", "200"}}), true);
+}
+
 } // namespace Http
 } // namespace Envoy
@@ -173,6 +173,40 @@ TEST_F(CodeUtilityTest, PerZoneStats) {
   EXPECT_EQ(1U, cluster_scope_.counter("prefix.zone.from_az.to_az.upstream_rq_2xx").value());
 }
 
+TEST_F(CodeUtilityTest, CodeStats) {
+  CodeStatsImpl code_stats(cluster_scope_);
+  CodeUtility::ResponseStatInfo info{global_store_, cluster_scope_, EMPTY_STRING,   200,
+                                     false,         "test-vhost",   "test-cluster", EMPTY_STRING,
+                                     EMPTY_STRING,  true,           &code_stats};
+  CodeUtility::chargeResponseStat(info);
+  CodeUtility::chargeResponseStat(info);
+  code_stats.chargeResponseStat(503, false, true);
+  code_stats.chargeResponseStat(100, false, true);
+  code_stats.chargeResponseStat(600, false, true);
+
+  EXPECT_EQ(2U, cluster_scope_.counter("upstream_rq_2xx").value());
+  EXPECT_EQ(2U, cluster_scope_.counter("upstream_rq_200").value());
+  EXPECT_EQ(2U, cluster_scope_.counter("canary.upstream_rq_2xx").value());
+  EXPECT_EQ(2U, cluster_scope_.counter("canary.upstream_rq_200").value());
+  EXPECT_EQ(2U, cluster_scope_.counter("external.upstream_rq_2xx").value());
+  EXPECT_EQ(2U, cluster_scope_.counter("external.upstream_rq_200").value());
+  EXPECT_EQ(1U, cluster_scope_.counter("upstream_rq_5xx").value());
+  EXPECT_EQ(1U, cluster_scope_.counter("upstream_rq_503").value());
+  EXPECT_EQ(1U, cluster_scope_.counter("internal.upstream_rq_5xx").value());
+  EXPECT_EQ(1U, cluster_scope_.counter("internal.upstream_rq_503").value());
+
+  // 1xx codes and codes outside of the known ranges are charged with an empty class, as before.
+  EXPECT_EQ(2U, cluster_scope_.counter("upstream_rq_").value());
+  EXPECT_EQ(1U, cluster_scope_.counter("upstream_rq_100").value());
+  EXPECT_EQ(1U, cluster_scope_.counter("upstream_rq_600").value());
+  EXPECT_EQ(2U, cluster_scope_.counter("internal.upstream_rq_").value());
+
+  EXPECT_EQ(
+      2U, global_store_.counter("vhost.test-vhost.vcluster.test-cluster.upstream_rq_2xx").value());
+  EXPECT_EQ(
+      2U, global_store_.counter("vhost.test-vhost.vcluster.test-cluster.upstream_rq_200").value());
+}
+
 TEST(CodeUtilityResponseTimingTest, All) {
   Stats::MockStore global_store;
   Stats::MockStore cluster_scope;
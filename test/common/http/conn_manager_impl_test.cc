@@ -47,6 +47,7 @@ using testing::NiceMock;
 using testing::Ref;
 using testing::Return;
 using testing::ReturnRef;
+using testing::SaveArg;
 using testing::Sequence;
 using testing::Test;
 using testing::_;
@@ -344,6 +345,105 @@ TEST_F(HttpConnectionManagerImplTest, HeaderOnlyRequestAndResponse) {
   EXPECT_EQ(1U, listener_stats_.downstream_rq_2xx_.value());
 }
 
+TEST_F(HttpConnectionManagerImplTest, HeaderOnlyRequestAndResponseWithStreamArena) {
+  ON_CALL(runtime_.snapshot_, featureEnabled("http.stream_arena.enabled", 0))
+      .WillByDefault(Return(true));
+  setup(false, "envoy-custom-server", false);
+  setupFilterChain(2, 1);
+
+  EXPECT_CALL(*decoder_filters_[0], decodeHeaders(_, true))
+      .WillOnce(Return(FilterHeadersStatus::Continue));
+  EXPECT_CALL(*decoder_filters_[1], decodeHeaders(_, true))
+      .WillOnce(Return(FilterHeadersStatus::StopIteration));
+  EXPECT_CALL(*encoder_filters_[0], encodeHeaders(_, true))
+      .WillOnce(Return(FilterHeadersStatus::Continue));
+
+  NiceMock<MockStreamEncoder> encoder;
+  EXPECT_CALL(encoder, encodeHeaders(_, true));
+  EXPECT_CALL(*codec_, dispatch(_)).WillOnce(Invoke([&](Buffer::Instance& data) -> void {
+    StreamDecoder* decoder = &conn_manager_->newStream(encoder);
+    HeaderMapPtr headers{new TestHeaderMapImpl{{":authority", "host"}, {":path", "/"}}};
+    decoder->decodeHeaders(std::move(headers), true);
+
+    HeaderMapPtr response_headers{new TestHeaderMapImpl{{":status", "200"}}};
+    decoder_filters_[1]->callbacks_->encodeHeaders(std::move(response_headers), true);
+    data.drain(4);
+  }));
+
+  expectOnDestroy();
+
+  Buffer::OwnedImpl fake_input("1234");
+  conn_manager_->onData(fake_input);
+
+  EXPECT_EQ(1U, stats_.named_.downstream_rq_2xx_.value());
+}
+
+TEST_F(HttpConnectionManagerImplTest, RouteCache) {
+  ON_CALL(runtime_.snapshot_, featureEnabled("http.route_cache.enabled", 0))
+      .WillByDefault(Return(true));
+  setup(false, "");
+
+  // The second request with the same host and path reuses the route of the first.
+  ON_CALL(*route_config_provider_.route_config_, routeCacheable()).WillByDefault(Return(true));
+  EXPECT_CALL(*route_config_provider_.route_config_, route(_, _));
+
+  NiceMock<MockStreamEncoder> encoder;
+  EXPECT_CALL(*codec_, dispatch(_)).WillOnce(Invoke([&](Buffer::Instance& data) -> void {
+    for (int i = 0; i < 2; i++) {
+      StreamDecoder* decoder = &conn_manager_->newStream(encoder);
+      HeaderMapPtr headers{new TestHeaderMapImpl{{":authority", "host"}, {":path", "/"}}};
+      decoder->decodeHeaders(std::move(headers), true);
+    }
+    data.drain(4);
+  }));
+
+  Buffer::OwnedImpl fake_input("1234");
+  conn_manager_->onData(fake_input);
+}
+
+TEST_F(HttpConnectionManagerImplTest, FilterTiming) {
+  ON_CALL(runtime_.snapshot_, featureEnabled("http.filter_timing.enabled", 0))
+      .WillByDefault(Return(true));
+  setup(false, "");
+
+  const std::string dual_name = "envoy.dual";
+  const std::string decoder_name = "envoy.decoder";
+  NiceMock<MockStreamFilter>* filter = new NiceMock<MockStreamFilter>();
+  NiceMock<MockStreamDecoderFilter>* decoder_filter = new NiceMock<MockStreamDecoderFilter>();
+  EXPECT_CALL(filter_factory_, createFilterChain(_))
+      .WillOnce(Invoke([&](FilterChainFactoryCallbacks& callbacks) -> void {
+        callbacks.setFilterName(dual_name);
+        callbacks.addStreamFilter(StreamFilterSharedPtr{filter});
+        callbacks.setFilterName(decoder_name);
+        callbacks.addStreamDecoderFilter(StreamDecoderFilterSharedPtr{decoder_filter});
+      }));
+
+  EXPECT_CALL(*filter, decodeHeaders(_, true)).WillOnce(Return(FilterHeadersStatus::Continue));
+  EXPECT_CALL(*decoder_filter, decodeHeaders(_, true))
+      .WillOnce(Invoke([&](HeaderMap&, bool) -> FilterHeadersStatus {
+        HeaderMapPtr response_headers{new TestHeaderMapImpl{{":status", "200"}}};
+        decoder_filter->callbacks_->encodeHeaders(std::move(response_headers), true);
+        return FilterHeadersStatus::StopIteration;
+      }));
+  EXPECT_CALL(*filter, encodeHeaders(_, true)).WillOnce(Return(FilterHeadersStatus::Continue));
+
+  NiceMock<MockStreamEncoder> encoder;
+  EXPECT_CALL(*codec_, dispatch(_)).WillOnce(Invoke([&](Buffer::Instance& data) -> void {
+    StreamDecoder* decoder = &conn_manager_->newStream(encoder);
+    HeaderMapPtr headers{new TestHeaderMapImpl{{":authority", "host"}, {":path", "/"}}};
+    decoder->decodeHeaders(std::move(headers), true);
+    data.drain(4);
+  }));
+
+  Buffer::OwnedImpl fake_input("1234");
+  conn_manager_->onData(fake_input);
+  filter_callbacks_.connection_.dispatcher_.clearDeferredDeleteList();
+
+  // The decoding and encoding of the dual filter are recorded together.
+  EXPECT_EQ(1U, fake_stats_.counter("filter.envoy.dual.rq_sampled").value());
+  EXPECT_EQ(1U, fake_stats_.counter("filter.envoy.decoder.rq_sampled").value());
+}
+
 TEST_F(HttpConnectionManagerImplTest, InvalidPathWithDualFilter) {
   InSequence s;
   setup(false, "");
@@ -442,6 +542,54 @@ TEST_F(HttpConnectionManagerImplTest, StartAndFinishSpanNormalFlow) {
   EXPECT_EQ(0UL, tracing_stats_.random_sampling_.value());
 }
 
+TEST_F(HttpConnectionManagerImplTest, TailSampledSpanExportedOnError) {
+  setup(false, "");
+
+  EXPECT_CALL(runtime_.snapshot_, featureEnabled("tracing.tail_sampling", 0))
+      .WillOnce(Return(true));
+  EXPECT_CALL(*route_config_provider_.route_config_->route_, decorator())
+      .WillRepeatedly(Return(nullptr));
+
+  std::shared_ptr<MockStreamDecoderFilter> filter(new NiceMock<MockStreamDecoderFilter>());
+  EXPECT_CALL(filter_factory_, createFilterChain(_))
+      .WillRepeatedly(Invoke([&](FilterChainFactoryCallbacks& callbacks) -> void {
+        callbacks.addStreamDecoderFilter(filter);
+      }));
+  use_remote_address_ = false;
+
+  // The request is not sampled, so the span of the tracer is only started once it failed, with
+  // the tags that were recorded while it was in flight.
+  NiceMock<Tracing::MockSpan>* span = new NiceMock<Tracing::MockSpan>();
+  EXPECT_CALL(tracer_, startSpan_(_, _, _)).WillOnce(Return(span));
+  EXPECT_CALL(*span, setTag(_, _)).Times(testing::AnyNumber());
+  EXPECT_CALL(*span, setTag("service-cluster", "scoobydoo"));
+  EXPECT_CALL(*span, setTag(Tracing::Tags::get().ERROR, Tracing::Tags::get().TRUE));
+  EXPECT_CALL(*span, finishSpan());
+
+  StreamDecoder* decoder = nullptr;
+  NiceMock<MockStreamEncoder> encoder;
+  EXPECT_CALL(*codec_, dispatch(_)).WillRepeatedly(Invoke([&](Buffer::Instance& data) -> void {
+    decoder = &conn_manager_->newStream(encoder);
+
+    HeaderMapPtr headers{
+        new TestHeaderMapImpl{{":method", "GET"},
+                              {":authority", "host"},
+                              {":path", "/"},
+                              {"x-request-id", "125a4afb-6f55-44ba-ad80-413f09f48a28"}}};
+    decoder->decodeHeaders(std::move(headers), true);
+
+    HeaderMapPtr response_headers{new TestHeaderMapImpl{{":status", "503"}}};
+    filter->callbacks_->encodeHeaders(std::move(response_headers), true);
+    filter->callbacks_->activeSpan().setTag("service-cluster", "scoobydoo");
+    data.drain(4);
+  }));
+
+  Buffer::OwnedImpl fake_input("1234");
+  conn_manager_->onData(fake_input);
+  EXPECT_EQ(1UL, tracing_stats_.not_traceable_.value());
+  EXPECT_EQ(1UL, tracing_stats_.tail_sampling_.value());
+}
+
 TEST_F(HttpConnectionManagerImplTest, StartAndFinishSpanNormalFlowIngressDecorator) {
   setup(false, "");
 
@@ -1085,6 +1233,63 @@ TEST_F(HttpConnectionManagerImplTest, WebSocketPrefixAndAutoHostRewrite) {
   EXPECT_EQ(0U, stats_.named_.downstream_cx_websocket_active_.value());
 }
 
+TEST_F(HttpConnectionManagerImplTest, WebSocketIdleTimeout) {
+  setup(false, "");
+
+  ON_CALL(runtime_.snapshot_, getInteger("websocket.idle_timeout_ms", 0))
+      .WillByDefault(Return(1000));
+  Event::MockTimer* timer =
+      new NiceMock<Event::MockTimer>(&filter_callbacks_.connection_.dispatcher_);
+  StreamDecoder* decoder = nullptr;
+  NiceMock<MockStreamEncoder> encoder;
+  NiceMock<Network::MockClientConnection>* upstream_connection =
+      new NiceMock<Network::MockClientConnection>();
+  Upstream::MockHost::MockCreateConnectionData conn_info;
+
+  conn_info.connection_ = upstream_connection;
+  conn_info.host_description_.reset(
+      new Upstream::HostImpl(cluster_manager_.thread_local_cluster_.cluster_.info_, "newhost",
+                             Network::Utility::resolveUrl("tcp://127.0.0.1:80"),
+                             envoy::api::v2::Metadata::default_instance(), 1,
+                             envoy::api::v2::Locality().default_instance()));
+  EXPECT_CALL(cluster_manager_, tcpConnForCluster_("fake_cluster", _)).WillOnce(Return(conn_info));
+
+  ON_CALL(route_config_provider_.route_config_->route_->route_entry_, useWebSocket())
+      .WillByDefault(Return(true));
+
+  EXPECT_CALL(*codec_, dispatch(_)).WillOnce(Invoke([&](Buffer::Instance& data) -> void {
+    decoder = &conn_manager_->newStream(encoder);
+    HeaderMapPtr headers{new TestHeaderMapImpl{{":authority", "host"},
+                                               {":method", "GET"},
+                                               {":path", "/"},
+                                               {"connection", "Upgrade"},
+                                               {"upgrade", "websocket"}}};
+    decoder->decodeHeaders(std::move(headers), true);
+    data.drain(4);
+  }));
+
+  // The connect timeout.
+  EXPECT_CALL(*timer, enableTimer(_));
+  Buffer::OwnedImpl fake_input("1234");
+  conn_manager_->onData(fake_input);
+
+  // The idle timeout is armed once connected, and re-armed by traffic.
+  EXPECT_CALL(*timer, enableTimer(std::chrono::milliseconds(1000))).Times(2);
+  upstream_connection->raiseEvent(Network::ConnectionEvent::Connected);
+
+  EXPECT_CALL(*upstream_connection, write(BufferStringEqual("hello")))
+      .WillOnce(Invoke([](Buffer::Instance& data) -> void { data.drain(data.length()); }));
+  Buffer::OwnedImpl ws_data("hello");
+  conn_manager_->onData(ws_data);
+
+  EXPECT_CALL(filter_callbacks_.connection_, close(Network::ConnectionCloseType::NoFlush))
+      .WillOnce(Return());
+  timer->callback_();
+
+  filter_callbacks_.connection_.dispatcher_.clearDeferredDeleteList();
+  conn_manager_.reset();
+}
+
 TEST_F(HttpConnectionManagerImplTest, DrainClose) {
   setup(true, "");
 
@@ -1318,6 +1523,42 @@ TEST_F(HttpConnectionManagerImplTest, IdleTimeout) {
   EXPECT_EQ(1U, stats_.named_.downstream_cx_idle_timeout_.value());
 }
 
+TEST_F(HttpConnectionManagerImplTest, DrainRequestedNoCodec) {
+  // Not used in the test.
+  delete codec_;
+
+  std::function<void()> drain_cb;
+  EXPECT_CALL(filter_callbacks_.connection_, addDrainCallback(_)).WillOnce(SaveArg<0>(&drain_cb));
+  setup(false, "");
+
+  EXPECT_CALL(filter_callbacks_.connection_, close(Network::ConnectionCloseType::FlushWrite));
+  drain_cb();
+}
+
+TEST_F(HttpConnectionManagerImplTest, DrainRequested) {
+  std::function<void()> drain_cb;
+  EXPECT_CALL(filter_callbacks_.connection_, addDrainCallback(_)).WillOnce(SaveArg<0>(&drain_cb));
+  setup(false, "");
+
+  EXPECT_CALL(*codec_, dispatch(_));
+  Buffer::OwnedImpl fake_input("1234");
+  conn_manager_->onData(fake_input);
+
+  Event::MockTimer* drain_timer = new Event::MockTimer(&filter_callbacks_.connection_.dispatcher_);
+  EXPECT_CALL(*codec_, shutdownNotice());
+  EXPECT_CALL(*drain_timer, enableTimer(_));
+  drain_cb();
+  EXPECT_EQ(1U, stats_.named_.downstream_cx_drain_close_.value());
+
+  // A second request to drain does not restart the drain sequence.
+  drain_cb();
+
+  EXPECT_CALL(*codec_, goAway());
+  EXPECT_CALL(filter_callbacks_.connection_, close(Network::ConnectionCloseType::FlushWrite));
+  EXPECT_CALL(*drain_timer, disableTimer());
+  drain_timer->callback_();
+}
+
 TEST_F(HttpConnectionManagerImplTest, IntermediateBufferingEarlyResponse) {
   InSequence s;
   setup(false, "");
@@ -1513,6 +1754,63 @@ TEST_F(HttpConnectionManagerImplTest, FilterAddBodyInTrailersCallback) {
 }
 
 // Add*Data during the *Data callbacks.
+TEST_F(HttpConnectionManagerImplTest, FilterInjectsDecodedData) {
+  setup(false, "");
+
+  EXPECT_CALL(*codec_, dispatch(_)).WillOnce(Invoke([&](Buffer::Instance&) -> void {
+    StreamDecoder* decoder = &conn_manager_->newStream(response_encoder_);
+    HeaderMapPtr headers{new TestHeaderMapImpl{{":authority", "host"}, {":path", "/"}}};
+    decoder->decodeHeaders(std::move(headers), false);
+
+    Buffer::OwnedImpl data("hello");
+    decoder->decodeData(data, false);
+
+    HeaderMapPtr trailers{new TestHeaderMapImpl{{"foo", "bar"}}};
+    decoder->decodeTrailers(std::move(trailers));
+  }));
+
+  setupFilterChain(2, 2);
+
+  // The first filter holds the whole request back without the connection manager buffering it.
+  EXPECT_CALL(*decoder_filters_[0], decodeHeaders(_, false))
+      .WillOnce(Return(FilterHeadersStatus::StopIteration));
+  EXPECT_CALL(*decoder_filters_[0], decodeData(_, false))
+      .WillOnce(Invoke([&](Buffer::Instance& data, bool) -> FilterDataStatus {
+        data.drain(data.length());
+        return FilterDataStatus::StopIterationNoBuffer;
+      }));
+  EXPECT_CALL(*decoder_filters_[0], decodeTrailers(_))
+      .WillOnce(Return(FilterTrailersStatus::StopIteration));
+
+  // Kick off the incoming data.
+  Buffer::OwnedImpl fake_input("1234");
+  conn_manager_->onData(fake_input);
+
+  // Then it passes the body on in pieces, and the headers go ahead of the first one.
+  EXPECT_CALL(*decoder_filters_[1], decodeHeaders(_, false))
+      .WillOnce(Return(FilterHeadersStatus::Continue));
+  EXPECT_CALL(*decoder_filters_[1], decodeData(BufferStringEqual("hel"), false))
+      .WillOnce(Return(FilterDataStatus::Continue));
+  Buffer::OwnedImpl data1("hel");
+  decoder_filters_[0]->callbacks_->injectDecodedDataToFilterChain(data1, false);
+
+  EXPECT_CALL(*decoder_filters_[1], decodeData(BufferStringEqual("lo"), false))
+      .WillOnce(Return(FilterDataStatus::Continue));
+  Buffer::OwnedImpl data2("lo");
+  decoder_filters_[0]->callbacks_->injectDecodedDataToFilterChain(data2, false);
+
+  EXPECT_CALL(*decoder_filters_[1], decodeTrailers(_))
+      .WillOnce(Return(FilterTrailersStatus::Continue));
+  decoder_filters_[0]->callbacks_->continueDecoding();
+
+  EXPECT_CALL(*encoder_filters_[0], encodeHeaders(_, true));
+  EXPECT_CALL(*encoder_filters_[1], encodeHeaders(_, true));
+  EXPECT_CALL(response_encoder_, encodeHeaders(_, true));
+  expectOnDestroy();
+  decoder_filters_[1]->callbacks_->encodeHeaders(
+      HeaderMapPtr{new TestHeaderMapImpl{{":status", "200"}}}, true);
+}
+
 TEST_F(HttpConnectionManagerImplTest, FilterAddBodyDuringDecodeData) {
   InSequence s;
   setup(false, "");
@@ -1667,6 +1965,7 @@ TEST_F(HttpConnectionManagerImplTest, UpstreamWatermarkCallbacks) {
   ASSERT(decoder_filters_[0]->callbacks_ != nullptr);
   decoder_filters_[0]->callbacks_->onDecoderFilterAboveWriteBufferHighWatermark();
   EXPECT_EQ(1U, stats_.named_.downstream_flow_control_paused_reading_total_.value());
+  EXPECT_TRUE(decoder_filters_[1]->callbacks_->aboveDecoderWriteBufferHighWatermark());
 
   // Resume the flow of data. When the router buffer drains it calls
   // onDecoderFilterBelowWriteBufferLowWatermark which should re-enable reads on the stream.
@@ -1675,6 +1974,7 @@ TEST_F(HttpConnectionManagerImplTest, UpstreamWatermarkCallbacks) {
   ASSERT(decoder_filters_[0]->callbacks_ != nullptr);
   decoder_filters_[0]->callbacks_->onDecoderFilterBelowWriteBufferLowWatermark();
   EXPECT_EQ(1U, stats_.named_.downstream_flow_control_resumed_reading_total_.value());
+  EXPECT_FALSE(decoder_filters_[1]->callbacks_->aboveDecoderWriteBufferHighWatermark());
 
   // Backup upstream once again.
   EXPECT_CALL(response_encoder_, getStream()).Times(1).WillOnce(ReturnRef(stream_));
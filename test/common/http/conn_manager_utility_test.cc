@@ -403,6 +403,42 @@ TEST_F(ConnectionManagerUtilityTest, MutateResponseHeadersReturnXRequestId) {
   EXPECT_EQ("request-id", response_headers.get_("x-request-id"));
 }
 
+TEST_F(ConnectionManagerUtilityTest, EarlyData) {
+  NiceMock<Ssl::MockConnection> ssl;
+  ON_CALL(connection_, ssl()).WillByDefault(Return(&ssl));
+
+  {
+    TestHeaderMapImpl headers;
+    ConnectionManagerUtility::mutateRequestHeaders(headers, Protocol::Http2, connection_, config_,
+                                                   route_config_, random_, runtime_, local_info_);
+    EXPECT_FALSE(headers.has("early-data"));
+  }
+
+  ON_CALL(ssl, receivedEarlyData()).WillByDefault(Return(true));
+  {
+    TestHeaderMapImpl headers;
+    ConnectionManagerUtility::mutateRequestHeaders(headers, Protocol::Http2, connection_, config_,
+                                                   route_config_, random_, runtime_, local_info_);
+    EXPECT_EQ("1", headers.get_("early-data"));
+  }
+
+  {
+    TestHeaderMapImpl headers{{"early-data", "1"}};
+    ConnectionManagerUtility::mutateRequestHeaders(headers, Protocol::Http2, connection_, config_,
+                                                   route_config_, random_, runtime_, local_info_);
+    uint32_t count = 0;
+    headers.iterate(
+        [](const HeaderEntry& header, void* context) -> HeaderMap::Iterate {
+          if (header.key() == "early-data") {
+            (*static_cast<uint32_t*>(context))++;
+          }
+          return HeaderMap::Iterate::Continue;
+        },
+        &count);
+    EXPECT_EQ(1U, count);
+  }
+}
+
 TEST_F(ConnectionManagerUtilityTest, MtlsSanitizeClientCert) {
   NiceMock<Ssl::MockConnection> ssl;
   ON_CALL(ssl, peerCertificatePresented()).WillByDefault(Return(true));
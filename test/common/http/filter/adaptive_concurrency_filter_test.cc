@@ -0,0 +1,174 @@
+#include <chrono>
+#include <memory>
+
+#include "common/http/filter/adaptive_concurrency_filter.h"
+#include "common/http/header_map_impl.h"
+#include "common/stats/stats_impl.h"
+
+#include "test/mocks/common.h"
+#include "test/mocks/http/mocks.h"
+#include "test/mocks/runtime/mocks.h"
+#include "test/test_common/printers.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::Invoke;
+using testing::NiceMock;
+using testing::Return;
+using testing::_;
+
+namespace Envoy {
+namespace Http {
+
+class AdaptiveConcurrencyFilterTest : public testing::Test {
+public:
+  AdaptiveConcurrencyFilterTest() {
+    ON_CALL(time_source_, currentTime()).WillByDefault(Invoke([this]() { return now_; }));
+  }
+
+  void setup(uint64_t initial_limit, uint64_t window_size) {
+    ON_CALL(runtime_.snapshot_, getInteger("adaptive_concurrency.initial_limit", _))
+        .WillByDefault(Return(initial_limit));
+    ON_CALL(runtime_.snapshot_, getInteger("adaptive_concurrency.sample_window_size", _))
+        .WillByDefault(Return(window_size));
+    controller_ = std::make_shared<AdaptiveConcurrencyController>(runtime_, "", store_,
+                                                                  time_source_);
+  }
+
+  std::unique_ptr<AdaptiveConcurrencyFilter> newFilter() {
+    std::unique_ptr<AdaptiveConcurrencyFilter> filter(
+        new AdaptiveConcurrencyFilter(controller_));
+    filter->setDecoderFilterCallbacks(callbacks_);
+    return filter;
+  }
+
+  // Send a request through a new filter that takes rtt to get its response.
+  void sendRequest(std::chrono::milliseconds rtt, const std::string& status = "200") {
+    std::unique_ptr<AdaptiveConcurrencyFilter> filter = newFilter();
+    TestHeaderMapImpl request_headers;
+    EXPECT_EQ(FilterHeadersStatus::Continue, filter->decodeHeaders(request_headers, true));
+    now_ += rtt;
+    TestHeaderMapImpl response_headers{{":status", status}};
+    EXPECT_EQ(FilterHeadersStatus::Continue, filter->encodeHeaders(response_headers, true));
+    filter->onDestroy();
+  }
+
+  NiceMock<Runtime::MockLoader> runtime_;
+  NiceMock<MockMonotonicTimeSource> time_source_;
+  NiceMock<MockStreamDecoderFilterCallbacks> callbacks_;
+  Stats::IsolatedStoreImpl store_;
+  MonotonicTime now_;
+  AdaptiveConcurrencyControllerSharedPtr controller_;
+};
+
+TEST_F(AdaptiveConcurrencyFilterTest, RejectOverLimit) {
+  setup(2, 100);
+
+  TestHeaderMapImpl request_headers;
+  std::unique_ptr<AdaptiveConcurrencyFilter> filter1 = newFilter();
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter1->decodeHeaders(request_headers, true));
+  std::unique_ptr<AdaptiveConcurrencyFilter> filter2 = newFilter();
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter2->decodeHeaders(request_headers, true));
+  EXPECT_EQ(2U, store_.gauge("adaptive_concurrency.rq_active").value());
+
+  std::unique_ptr<AdaptiveConcurrencyFilter> filter3 = newFilter();
+  TestHeaderMapImpl response_headers{
+      {":status", "503"}, {"content-length", "25"}, {"content-type", "text/plain"}};
+  EXPECT_CALL(callbacks_.request_info_,
+              setResponseFlag(RequestInfo::ResponseFlag::UpstreamOverflow));
+  EXPECT_CALL(callbacks_, encodeHeaders_(HeaderMapEqualRef(&response_headers), false));
+  EXPECT_CALL(callbacks_, encodeData(_, true));
+  EXPECT_EQ(FilterHeadersStatus::StopIteration, filter3->decodeHeaders(request_headers, true));
+  filter3->onDestroy();
+  EXPECT_EQ(1U, store_.counter("adaptive_concurrency.rq_blocked").value());
+
+  // Completing a request makes room for the next one.
+  filter1->onDestroy();
+  std::unique_ptr<AdaptiveConcurrencyFilter> filter4 = newFilter();
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter4->decodeHeaders(request_headers, true));
+
+  filter2->onDestroy();
+  filter4->onDestroy();
+  EXPECT_EQ(0U, store_.gauge("adaptive_concurrency.rq_active").value());
+}
+
+TEST_F(AdaptiveConcurrencyFilterTest, LimitGrowsAtMinRtt) {
+  setup(16, 1);
+  EXPECT_EQ(16U, controller_->concurrencyLimit());
+
+  // Latency at the min RTT grows the limit by sqrt(limit) per window.
+  sendRequest(std::chrono::milliseconds(10));
+  EXPECT_EQ(20U, controller_->concurrencyLimit());
+  sendRequest(std::chrono::milliseconds(10));
+  EXPECT_EQ(24U, controller_->concurrencyLimit());
+  EXPECT_EQ(24U, store_.gauge("adaptive_concurrency.concurrency_limit").value());
+  EXPECT_EQ(10U, store_.gauge("adaptive_concurrency.min_rtt_ms").value());
+
+  // Latency within the tolerance of the min RTT still counts as not queueing.
+  sendRequest(std::chrono::milliseconds(15));
+  EXPECT_EQ(28U, controller_->concurrencyLimit());
+}
+
+TEST_F(AdaptiveConcurrencyFilterTest, LimitShrinksWhenLatencyRises) {
+  setup(100, 1);
+  sendRequest(std::chrono::milliseconds(10));
+  EXPECT_EQ(110U, controller_->concurrencyLimit());
+
+  // gradient = 1.5 * 10 / 20 = 0.75, limit = 110 * 0.75 + sqrt(110) = 92.
+  sendRequest(std::chrono::milliseconds(20));
+  EXPECT_EQ(92U, controller_->concurrencyLimit());
+
+  // The gradient is clamped at 0.5: limit = 92 * 0.5 + sqrt(92) = 55.
+  sendRequest(std::chrono::milliseconds(1000));
+  EXPECT_EQ(55U, controller_->concurrencyLimit());
+}
+
+TEST_F(AdaptiveConcurrencyFilterTest, LimitBounds) {
+  ON_CALL(runtime_.snapshot_, getInteger("adaptive_concurrency.max_limit", _))
+      .WillByDefault(Return(12));
+  ON_CALL(runtime_.snapshot_, getInteger("adaptive_concurrency.min_limit", _))
+      .WillByDefault(Return(8));
+  setup(100, 1);
+  EXPECT_EQ(12U, controller_->concurrencyLimit());
+
+  sendRequest(std::chrono::milliseconds(10));
+  EXPECT_EQ(12U, controller_->concurrencyLimit());
+  sendRequest(std::chrono::milliseconds(1000));
+  EXPECT_EQ(9U, controller_->concurrencyLimit());
+  sendRequest(std::chrono::milliseconds(1000));
+  EXPECT_EQ(8U, controller_->concurrencyLimit());
+}
+
+TEST_F(AdaptiveConcurrencyFilterTest, WindowMeanAndMinRttReset) {
+  ON_CALL(runtime_.snapshot_, getInteger("adaptive_concurrency.min_rtt_recalc_windows", _))
+      .WillByDefault(Return(3));
+  setup(100, 2);
+
+  // The limit only moves once the window is full, using the window's mean latency.
+  sendRequest(std::chrono::milliseconds(10));
+  EXPECT_EQ(100U, controller_->concurrencyLimit());
+  sendRequest(std::chrono::milliseconds(30));
+  // gradient = 1.5 * 10 / 20 = 0.75, limit = 100 * 0.75 + sqrt(100) = 85.
+  EXPECT_EQ(85U, controller_->concurrencyLimit());
+  EXPECT_EQ(10U, store_.gauge("adaptive_concurrency.min_rtt_ms").value());
+
+  // The second window keeps the lower min RTT, and the third starts over from its own minimum.
+  sendRequest(std::chrono::milliseconds(40));
+  sendRequest(std::chrono::milliseconds(40));
+  EXPECT_EQ(10U, store_.gauge("adaptive_concurrency.min_rtt_ms").value());
+  sendRequest(std::chrono::milliseconds(40));
+  sendRequest(std::chrono::milliseconds(40));
+  EXPECT_EQ(40U, store_.gauge("adaptive_concurrency.min_rtt_ms").value());
+}
+
+TEST_F(AdaptiveConcurrencyFilterTest, ErrorsNotSampled) {
+  setup(16, 1);
+  sendRequest(std::chrono::milliseconds(10), "503");
+  EXPECT_EQ(16U, controller_->concurrencyLimit());
+  EXPECT_EQ(0U, store_.gauge("adaptive_concurrency.rq_active").value());
+}
+
+} // namespace Http
+} // namespace Envoy
@@ -9,6 +9,8 @@
 
 #include "test/mocks/buffer/mocks.h"
 #include "test/mocks/http/mocks.h"
+#include "test/mocks/runtime/mocks.h"
+#include "test/test_common/environment.h"
 #include "test/test_common/printers.h"
 
 #include "gmock/gmock.h"
@@ -16,8 +18,10 @@
 
 using testing::DoAll;
 using testing::InSequence;
+using testing::Invoke;
 using testing::NiceMock;
 using testing::Return;
+using testing::ReturnRef;
 using testing::SaveArg;
 using testing::_;
 
@@ -28,7 +32,7 @@ class BufferFilterTest : public testing::Test {
 public:
   BufferFilterTest()
       : config_{new BufferFilterConfig{BufferFilter::generateStats("", store_), 1024 * 1024,
-                                       std::chrono::seconds(0)}},
+                                       std::chrono::seconds(0), runtime_}},
         filter_(config_) {
     filter_.setDecoderFilterCallbacks(callbacks_);
   }
@@ -37,6 +41,7 @@ public:
 
   NiceMock<MockStreamDecoderFilterCallbacks> callbacks_;
   Stats::IsolatedStoreImpl store_;
+  NiceMock<Runtime::MockLoader> runtime_;
   std::shared_ptr<BufferFilterConfig> config_;
   BufferFilter filter_;
   Event::MockTimer* timer_{};
@@ -99,5 +104,116 @@ TEST_F(BufferFilterTest, TxResetAfterEndStream) {
   filter_.onDestroy();
 }
 
+class BufferFilterSpillTest : public testing::Test {
+public:
+  BufferFilterSpillTest()
+      : config_{new BufferFilterConfig{BufferFilter::generateStats("", store_), 1024 * 1024,
+                                       std::chrono::seconds(0), runtime_}} {
+    ON_CALL(runtime_.snapshot_, getInteger("buffer.spill_threshold_bytes", 0))
+        .WillByDefault(Return(10));
+    ON_CALL(runtime_.snapshot_, get("buffer.spill_directory"))
+        .WillByDefault(ReturnRef(TestEnvironment::temporaryDirectory()));
+    ON_CALL(callbacks_, aboveDecoderWriteBufferHighWatermark()).WillByDefault(Return(false));
+    EXPECT_CALL(callbacks_, setDecoderBufferLimit(_)).Times(0);
+    filter_.reset(new BufferFilter(config_));
+    filter_->setDecoderFilterCallbacks(callbacks_);
+
+    new NiceMock<Event::MockTimer>(&callbacks_.dispatcher_);
+    TestHeaderMapImpl headers;
+    EXPECT_EQ(FilterHeadersStatus::StopIteration, filter_->decodeHeaders(headers, false));
+  }
+
+  ~BufferFilterSpillTest() { filter_->onDestroy(); }
+
+  void expectReplayTimerCreate() {
+    replay_timer_ = new NiceMock<Event::MockTimer>(&callbacks_.dispatcher_);
+  }
+
+  NiceMock<MockStreamDecoderFilterCallbacks> callbacks_;
+  Stats::IsolatedStoreImpl store_;
+  NiceMock<Runtime::MockLoader> runtime_;
+  std::shared_ptr<BufferFilterConfig> config_;
+  std::unique_ptr<BufferFilter> filter_;
+  Event::MockTimer* replay_timer_{};
+};
+
+TEST_F(BufferFilterSpillTest, SmallBodyIsHeldInMemory) {
+  Buffer::OwnedImpl data1("hello");
+  EXPECT_EQ(FilterDataStatus::StopIterationNoBuffer, filter_->decodeData(data1, false));
+  EXPECT_EQ(0, data1.length());
+
+  expectReplayTimerCreate();
+  EXPECT_CALL(*replay_timer_, enableTimer(std::chrono::milliseconds(0)));
+  Buffer::OwnedImpl data2(" you");
+  EXPECT_EQ(FilterDataStatus::StopIterationNoBuffer, filter_->decodeData(data2, true));
+
+  EXPECT_CALL(callbacks_, injectDecodedDataToFilterChain(BufferStringEqual("hello you"), true));
+  replay_timer_->callback_();
+  EXPECT_EQ(0U, config_->stats_.rq_spilled_.value());
+}
+
+TEST_F(BufferFilterSpillTest, LargeBodyIsSpilledAndReplayedInChunks) {
+  Buffer::OwnedImpl data1(std::string(BufferFilter::REPLAY_CHUNK_SIZE, 'a'));
+  EXPECT_EQ(FilterDataStatus::StopIterationNoBuffer, filter_->decodeData(data1, false));
+  EXPECT_EQ(1U, config_->stats_.rq_spilled_.value());
+
+  expectReplayTimerCreate();
+  Buffer::OwnedImpl data2("bbbbb");
+  EXPECT_EQ(FilterDataStatus::StopIterationNoBuffer, filter_->decodeData(data2, true));
+
+  InSequence s;
+  EXPECT_CALL(callbacks_, injectDecodedDataToFilterChain(_, false))
+      .WillOnce(Invoke([](Buffer::Instance& data, bool) -> void {
+        EXPECT_EQ(std::string(BufferFilter::REPLAY_CHUNK_SIZE, 'a'),
+                  TestUtility::bufferToString(data));
+      }));
+  EXPECT_CALL(callbacks_, injectDecodedDataToFilterChain(BufferStringEqual("bbbbb"), true));
+  replay_timer_->callback_();
+}
+
+TEST_F(BufferFilterSpillTest, ReplayWaitsForUpstream) {
+  Buffer::OwnedImpl data(std::string(20, 'a'));
+  EXPECT_EQ(FilterDataStatus::StopIterationNoBuffer, filter_->decodeData(data, false));
+
+  expectReplayTimerCreate();
+  Buffer::OwnedImpl empty;
+  EXPECT_EQ(FilterDataStatus::StopIterationNoBuffer, filter_->decodeData(empty, true));
+
+  EXPECT_CALL(callbacks_, aboveDecoderWriteBufferHighWatermark()).WillOnce(Return(true));
+  EXPECT_CALL(callbacks_, injectDecodedDataToFilterChain(_, _)).Times(0);
+  EXPECT_CALL(*replay_timer_, enableTimer(BufferFilter::REPLAY_RETRY_INTERVAL));
+  replay_timer_->callback_();
+
+  EXPECT_CALL(callbacks_, aboveDecoderWriteBufferHighWatermark()).WillOnce(Return(false));
+  EXPECT_CALL(callbacks_,
+              injectDecodedDataToFilterChain(BufferStringEqual(std::string(20, 'a')), true));
+  replay_timer_->callback_();
+}
+
+TEST_F(BufferFilterSpillTest, TrailersFollowBody) {
+  Buffer::OwnedImpl data(std::string(20, 'a'));
+  EXPECT_EQ(FilterDataStatus::StopIterationNoBuffer, filter_->decodeData(data, false));
+
+  expectReplayTimerCreate();
+  TestHeaderMapImpl trailers;
+  EXPECT_EQ(FilterTrailersStatus::StopIteration, filter_->decodeTrailers(trailers));
+
+  InSequence s;
+  EXPECT_CALL(callbacks_,
+              injectDecodedDataToFilterChain(BufferStringEqual(std::string(20, 'a')), false));
+  EXPECT_CALL(callbacks_, continueDecoding());
+  replay_timer_->callback_();
+}
+
+TEST_F(BufferFilterSpillTest, TooLarge) {
+  Buffer::OwnedImpl data(std::string(1024 * 1024 + 1, 'a'));
+  TestHeaderMapImpl response_headers{
+      {":status", "413"}, {"content-length", "17"}, {"content-type", "text/plain"}};
+  EXPECT_CALL(callbacks_, encodeHeaders_(HeaderMapEqualRef(&response_headers), false));
+  EXPECT_EQ(FilterDataStatus::StopIterationNoBuffer, filter_->decodeData(data, false));
+  EXPECT_EQ(1U, config_->stats_.rq_too_large_.value());
+  EXPECT_EQ(0U, config_->stats_.rq_spilled_.value());
+}
+
 } // namespace Http
 } // namespace Envoy
@@ -0,0 +1,327 @@
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/http/filter/cache/cache_filter.h"
+#include "common/http/filter/cache/lru_http_cache.h"
+#include "common/http/header_map_impl.h"
+#include "common/stats/stats_impl.h"
+
+#include "test/mocks/common.h"
+#include "test/mocks/http/mocks.h"
+#include "test/test_common/printers.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::Invoke;
+using testing::NiceMock;
+using testing::_;
+
+namespace Envoy {
+namespace Http {
+namespace Filter {
+namespace Cache {
+
+class CacheFilterTest : public testing::Test {
+public:
+  struct Stream {
+    Stream(const HeaderMap& request_headers) : request_headers_(request_headers) {}
+
+    NiceMock<MockStreamDecoderFilterCallbacks> callbacks_;
+    TestHeaderMapImpl request_headers_;
+    std::shared_ptr<CacheFilter> filter_;
+  };
+  typedef std::unique_ptr<Stream> StreamPtr;
+
+  CacheFilterTest() {
+    ON_CALL(time_source_, currentTime()).WillByDefault(Invoke([this]() { return now_; }));
+    setup(1024);
+  }
+
+  void setup(uint64_t max_entry_bytes) {
+    cache_ = std::make_shared<LruHttpCache>(1024 * 1024);
+    config_ = std::make_shared<CacheFilterConfig>(cache_, max_entry_bytes, "test.", store_,
+                                                  time_source_);
+  }
+
+  StreamPtr newStream(const HeaderMap& request_headers) {
+    StreamPtr stream(new Stream(request_headers));
+    stream->filter_ = std::make_shared<CacheFilter>(config_);
+    stream->filter_->setDecoderFilterCallbacks(stream->callbacks_);
+    return stream;
+  }
+
+  // Send a request that misses and goes upstream, and its response.
+  void sendUpstream(const HeaderMap& request_headers, const HeaderMap& response_headers,
+                    const std::string& body) {
+    StreamPtr stream = newStream(request_headers);
+    EXPECT_EQ(FilterHeadersStatus::Continue,
+              stream->filter_->decodeHeaders(stream->request_headers_, true));
+    respond(*stream, response_headers, body);
+    stream->filter_->onDestroy();
+  }
+
+  void respond(Stream& stream, const HeaderMap& response_headers, const std::string& body) {
+    TestHeaderMapImpl headers(response_headers);
+    EXPECT_EQ(FilterHeadersStatus::Continue,
+              stream.filter_->encodeHeaders(headers, body.empty()));
+    if (!body.empty()) {
+      Buffer::OwnedImpl data(body);
+      EXPECT_EQ(FilterDataStatus::Continue, stream.filter_->encodeData(data, true));
+    }
+  }
+
+  // Send a request that is expected to be served from the cache, and return the age and body that
+  // it was served with.
+  std::pair<std::string, std::string> sendHit(const HeaderMap& request_headers) {
+    StreamPtr stream = newStream(request_headers);
+    std::pair<std::string, std::string> age_and_body;
+    EXPECT_CALL(stream->callbacks_, encodeHeaders_(_, _))
+        .WillOnce(Invoke([&](HeaderMap& headers, bool) -> void {
+          age_and_body.first = headers.get(LowerCaseString("age"))->value().c_str();
+        }));
+    ON_CALL(stream->callbacks_, encodeData(_, true))
+        .WillByDefault(Invoke([&](Buffer::Instance& data, bool) -> void {
+          age_and_body.second = TestUtility::bufferToString(data);
+        }));
+    EXPECT_EQ(FilterHeadersStatus::StopIteration,
+              stream->filter_->decodeHeaders(stream->request_headers_, true));
+    stream->filter_->onDestroy();
+    return age_and_body;
+  }
+
+  // Send a request that is expected to miss, without sending a response.
+  void sendMiss(const HeaderMap& request_headers) {
+    StreamPtr stream = newStream(request_headers);
+    EXPECT_CALL(stream->callbacks_, encodeHeaders_(_, _)).Times(0);
+    EXPECT_EQ(FilterHeadersStatus::Continue,
+              stream->filter_->decodeHeaders(stream->request_headers_, true));
+    stream->filter_->onDestroy();
+  }
+
+  uint64_t counter(const std::string& name) { return store_.counter("test.cache." + name).value(); }
+
+  NiceMock<MockSystemTimeSource> time_source_;
+  SystemTime now_{std::chrono::seconds(1000)};
+  Stats::IsolatedStoreImpl store_;
+  std::shared_ptr<LruHttpCache> cache_;
+  CacheFilterConfigSharedPtr config_;
+  TestHeaderMapImpl request_headers_{{":method", "GET"}, {":authority", "host"}, {":path", "/"}};
+  TestHeaderMapImpl response_headers_{{":status", "200"}, {"cache-control", "max-age=60"}};
+};
+
+TEST_F(CacheFilterTest, MissThenHit) {
+  sendUpstream(request_headers_, response_headers_, "hello");
+  EXPECT_EQ(1U, counter("miss"));
+  EXPECT_EQ(1U, counter("insert"));
+
+  now_ += std::chrono::seconds(10);
+  EXPECT_EQ(std::make_pair(std::string("10"), std::string("hello")), sendHit(request_headers_));
+  EXPECT_EQ(1U, counter("hit"));
+
+  // Other paths and hosts are other keys.
+  sendMiss(TestHeaderMapImpl{{":method", "GET"}, {":authority", "host"}, {":path", "/other"}});
+  sendMiss(TestHeaderMapImpl{{":method", "GET"}, {":authority", "other"}, {":path", "/"}});
+}
+
+TEST_F(CacheFilterTest, SchemeIsPartOfKey) {
+  TestHeaderMapImpl http_request{
+      {":method", "GET"}, {":authority", "host"}, {":path", "/"}, {":scheme", "http"}};
+  TestHeaderMapImpl https_request{
+      {":method", "GET"}, {":authority", "host"}, {":path", "/"}, {":scheme", "https"}};
+  sendUpstream(http_request, response_headers_, "http");
+  EXPECT_EQ("http", sendHit(http_request).second);
+  sendMiss(https_request);
+  sendMiss(request_headers_);
+
+  // Without :scheme, the scheme comes from x-forwarded-proto.
+  EXPECT_EQ("http", sendHit(TestHeaderMapImpl{{":method", "GET"},
+                                              {":authority", "host"},
+                                              {":path", "/"},
+                                              {"x-forwarded-proto", "http"}})
+                        .second);
+  sendMiss(TestHeaderMapImpl{{":method", "GET"},
+                             {":authority", "host"},
+                             {":path", "/"},
+                             {"x-forwarded-proto", "https"}});
+}
+
+TEST_F(CacheFilterTest, HeadersOnlyResponse) {
+  sendUpstream(request_headers_, response_headers_, "");
+
+  StreamPtr stream = newStream(request_headers_);
+  EXPECT_CALL(stream->callbacks_, encodeHeaders_(_, true));
+  EXPECT_CALL(stream->callbacks_, encodeData(_, _)).Times(0);
+  EXPECT_EQ(FilterHeadersStatus::StopIteration,
+            stream->filter_->decodeHeaders(stream->request_headers_, true));
+}
+
+TEST_F(CacheFilterTest, Expired) {
+  sendUpstream(request_headers_, response_headers_, "hello");
+  now_ += std::chrono::seconds(60);
+  sendMiss(request_headers_);
+}
+
+TEST_F(CacheFilterTest, SharedMaxAgeAndUpstreamAge) {
+  sendUpstream(request_headers_,
+               TestHeaderMapImpl{
+                   {":status", "200"}, {"cache-control", "max-age=1, s-maxage=60"}, {"age", "50"}},
+               "hello");
+  now_ += std::chrono::seconds(5);
+  EXPECT_EQ("55", sendHit(request_headers_).first);
+  now_ += std::chrono::seconds(5);
+  sendMiss(request_headers_);
+}
+
+TEST_F(CacheFilterTest, UncacheableResponses) {
+  auto sendResponse = [this](const std::string& status, const std::string& cache_control,
+                             const std::string& vary) -> void {
+    TestHeaderMapImpl response_headers{{":status", status}};
+    if (!cache_control.empty()) {
+      response_headers.addCopy("cache-control", cache_control);
+    }
+    if (!vary.empty()) {
+      response_headers.addCopy("vary", vary);
+    }
+    sendUpstream(request_headers_, response_headers, "a");
+  };
+
+  sendResponse("404", "max-age=60", "");
+  sendResponse("200", "", "");
+  sendResponse("200", "max-age=0", "");
+  sendResponse("200", "no-store, max-age=60", "");
+  sendResponse("200", "private, max-age=60", "");
+  sendResponse("200", "no-cache, max-age=60", "");
+  sendResponse("200", "max-age=60", "*");
+  sendUpstream(request_headers_,
+               TestHeaderMapImpl{
+                   {":status", "200"}, {"cache-control", "max-age=60"}, {"set-cookie", "a=b"}},
+               "a");
+  EXPECT_EQ(0U, counter("insert"));
+  sendMiss(request_headers_);
+}
+
+TEST_F(CacheFilterTest, UncacheableRequests) {
+  sendUpstream(TestHeaderMapImpl{{":method", "POST"}, {":authority", "host"}, {":path", "/"}},
+               response_headers_, "a");
+  sendUpstream(TestHeaderMapImpl{{":method", "GET"},
+                                 {":authority", "host"},
+                                 {":path", "/"},
+                                 {"authorization", "x"}},
+               response_headers_, "a");
+  EXPECT_EQ(0U, counter("insert"));
+  EXPECT_EQ(0U, counter("miss"));
+
+  sendUpstream(request_headers_, response_headers_, "hello");
+  sendMiss(TestHeaderMapImpl{{":method", "GET"},
+                             {":authority", "host"},
+                             {":path", "/"},
+                             {"cache-control", "no-cache"}});
+  EXPECT_EQ(1U, counter("miss"));
+}
+
+TEST_F(CacheFilterTest, Vary) {
+  TestHeaderMapImpl gzip_request{{":method", "GET"},
+                                 {":authority", "host"},
+                                 {":path", "/"},
+                                 {"accept-encoding", "gzip"}};
+  TestHeaderMapImpl br_request{
+      {":method", "GET"}, {":authority", "host"}, {":path", "/"}, {"accept-encoding", "br"}};
+  TestHeaderMapImpl response_headers{
+      {":status", "200"}, {"cache-control", "max-age=60"}, {"vary", "Accept-Encoding"}};
+  sendUpstream(gzip_request, response_headers, "gzip");
+  EXPECT_EQ("gzip", sendHit(gzip_request).second);
+  sendMiss(br_request);
+  sendMiss(request_headers_);
+
+  sendUpstream(br_request, response_headers, "br");
+  EXPECT_EQ("br", sendHit(br_request).second);
+  EXPECT_EQ("gzip", sendHit(gzip_request).second);
+}
+
+TEST_F(CacheFilterTest, TooLarge) {
+  setup(4);
+  sendUpstream(request_headers_, response_headers_, "hello");
+  EXPECT_EQ(1U, counter("too_large"));
+  EXPECT_EQ(0U, counter("insert"));
+  sendMiss(request_headers_);
+}
+
+TEST_F(CacheFilterTest, InsertOnTrailers) {
+  StreamPtr stream = newStream(request_headers_);
+  EXPECT_EQ(FilterHeadersStatus::Continue,
+            stream->filter_->decodeHeaders(stream->request_headers_, true));
+  TestHeaderMapImpl response_headers(static_cast<const HeaderMap&>(response_headers_));
+  EXPECT_EQ(FilterHeadersStatus::Continue, stream->filter_->encodeHeaders(response_headers, false));
+  Buffer::OwnedImpl data("hello");
+  EXPECT_EQ(FilterDataStatus::Continue, stream->filter_->encodeData(data, false));
+  TestHeaderMapImpl trailers{{"grpc-status", "0"}};
+  EXPECT_EQ(FilterTrailersStatus::Continue, stream->filter_->encodeTrailers(trailers));
+  stream->filter_->onDestroy();
+
+  EXPECT_EQ("hello", sendHit(request_headers_).second);
+}
+
+TEST_F(CacheFilterTest, CollapseConcurrentMisses) {
+  StreamPtr leader = newStream(request_headers_);
+  EXPECT_EQ(FilterHeadersStatus::Continue,
+            leader->filter_->decodeHeaders(leader->request_headers_, true));
+
+  StreamPtr waiter = newStream(request_headers_);
+  EXPECT_EQ(FilterHeadersStatus::StopIteration,
+            waiter->filter_->decodeHeaders(waiter->request_headers_, true));
+  EXPECT_EQ(1U, counter("collapsed"));
+
+  // The waiter is served from the cache once the leader's response is cached.
+  EXPECT_CALL(waiter->callbacks_, encodeHeaders_(_, false));
+  EXPECT_CALL(waiter->callbacks_, encodeData(_, true));
+  EXPECT_CALL(waiter->callbacks_, continueDecoding()).Times(0);
+  respond(*leader, response_headers_, "hello");
+  EXPECT_EQ(1U, counter("hit"));
+
+  // Once released, the next miss leads again.
+  now_ += std::chrono::seconds(60);
+  sendUpstream(request_headers_, response_headers_, "hello");
+  leader->filter_->onDestroy();
+  waiter->filter_->onDestroy();
+}
+
+TEST_F(CacheFilterTest, CollapsedMissContinuesWhenUncacheable) {
+  StreamPtr leader = newStream(request_headers_);
+  EXPECT_EQ(FilterHeadersStatus::Continue,
+            leader->filter_->decodeHeaders(leader->request_headers_, true));
+  StreamPtr waiter = newStream(request_headers_);
+  EXPECT_EQ(FilterHeadersStatus::StopIteration,
+            waiter->filter_->decodeHeaders(waiter->request_headers_, true));
+
+  EXPECT_CALL(waiter->callbacks_, continueDecoding());
+  respond(*leader, TestHeaderMapImpl{{":status", "200"}, {"cache-control", "no-store"}}, "hello");
+  leader->filter_->onDestroy();
+  waiter->filter_->onDestroy();
+}
+
+TEST_F(CacheFilterTest, CollapsedMissContinuesWhenLeaderReset) {
+  StreamPtr leader = newStream(request_headers_);
+  EXPECT_EQ(FilterHeadersStatus::Continue,
+            leader->filter_->decodeHeaders(leader->request_headers_, true));
+  StreamPtr waiter = newStream(request_headers_);
+  EXPECT_EQ(FilterHeadersStatus::StopIteration,
+            waiter->filter_->decodeHeaders(waiter->request_headers_, true));
+  StreamPtr reset_waiter = newStream(request_headers_);
+  EXPECT_EQ(FilterHeadersStatus::StopIteration,
+            reset_waiter->filter_->decodeHeaders(reset_waiter->request_headers_, true));
+  reset_waiter->filter_->onDestroy();
+
+  EXPECT_CALL(waiter->callbacks_, continueDecoding());
+  EXPECT_CALL(reset_waiter->callbacks_, continueDecoding()).Times(0);
+  leader->filter_->onDestroy();
+  waiter->filter_->onDestroy();
+}
+
+} // namespace Cache
+} // namespace Filter
+} // namespace Http
+} // namespace Envoy
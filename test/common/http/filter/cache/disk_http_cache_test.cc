@@ -0,0 +1,160 @@
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/common/utility.h"
+#include "common/http/filter/cache/disk_http_cache.h"
+
+#include "test/test_common/environment.h"
+#include "test/test_common/printers.h"
+#include "test/test_common/utility.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Http {
+namespace Filter {
+namespace Cache {
+
+class DiskHttpCacheTest : public testing::Test {
+public:
+  DiskHttpCacheTest() : directory_(TestEnvironment::temporaryPath("disk_http_cache_test")) {
+    ::mkdir(directory_.c_str(), 0755);
+  }
+
+  std::vector<std::string> cacheFiles(const std::string& directory) {
+    std::vector<std::string> files;
+    DIR* dir = ::opendir(directory.c_str());
+    if (dir == nullptr) {
+      return files;
+    }
+    while (dirent* entry = ::readdir(dir)) {
+      if (StringUtil::startsWith(entry->d_name, DiskHttpCache::FILE_PREFIX)) {
+        files.push_back(entry->d_name);
+      }
+    }
+    ::closedir(dir);
+    return files;
+  }
+
+  void insert(DiskHttpCache& cache, const std::string& key, const std::string& body) {
+    Buffer::OwnedImpl buffer(body);
+    cache.insert(key, headers_, buffer, response_time_, std::chrono::seconds(60));
+  }
+
+  std::string body(const CachedResponse& response) {
+    Buffer::OwnedImpl buffer;
+    response.addBodyTo(buffer);
+    return TestUtility::bufferToString(buffer);
+  }
+
+  const std::string directory_;
+  TestHeaderMapImpl headers_{{":status", "200"}, {"content-type", "text/plain"}};
+  SystemTime response_time_{std::chrono::seconds(1000)};
+};
+
+TEST_F(DiskHttpCacheTest, InsertAndLookup) {
+  DiskHttpCache cache(directory_, 1024 * 1024);
+  EXPECT_EQ(nullptr, cache.lookup("a"));
+
+  insert(cache, "a", "hello");
+  CachedResponseConstSharedPtr response = cache.lookup("a");
+  ASSERT_NE(nullptr, response);
+  EXPECT_EQ("hello", body(*response));
+  EXPECT_EQ(5U, response->bodySize());
+  EXPECT_EQ(response_time_, response->responseTime());
+  EXPECT_EQ(std::chrono::seconds(60), response->maxAge());
+  EXPECT_EQ(headers_, HeaderMapImpl(response->headers()));
+  EXPECT_TRUE(response->varyHeaders().empty());
+  EXPECT_EQ(1U, cacheFiles(cache.directory()).size());
+
+  insert(cache, "a", "hi");
+  EXPECT_EQ("hi", body(*cache.lookup("a")));
+  EXPECT_EQ(1U, cacheFiles(cache.directory()).size());
+}
+
+TEST_F(DiskHttpCacheTest, VaryParsedOnLookup) {
+  DiskHttpCache cache(directory_, 1024 * 1024);
+  headers_.addCopy("vary", "Accept-Encoding");
+  insert(cache, "a", "hello");
+  EXPECT_EQ(std::vector<std::string>{"accept-encoding"}, cache.lookup("a")->varyHeaders());
+}
+
+TEST_F(DiskHttpCacheTest, EmptyBody) {
+  DiskHttpCache cache(directory_, 1024 * 1024);
+  insert(cache, "a", "");
+  CachedResponseConstSharedPtr response = cache.lookup("a");
+  ASSERT_NE(nullptr, response);
+  EXPECT_EQ(0U, response->bodySize());
+  EXPECT_EQ("", body(*response));
+}
+
+TEST_F(DiskHttpCacheTest, EvictLeastRecentlyUsed) {
+  DiskHttpCache cache(directory_, 1024 * 1024);
+  insert(cache, "a", std::string(100, 'a'));
+  const uint64_t file_size = cache.bytes();
+
+  DiskHttpCache small_cache(directory_, file_size * 2);
+  insert(small_cache, "a", std::string(100, 'a'));
+  insert(small_cache, "b", std::string(100, 'b'));
+  EXPECT_NE(nullptr, small_cache.lookup("a"));
+  insert(small_cache, "c", std::string(100, 'c'));
+  EXPECT_NE(nullptr, small_cache.lookup("a"));
+  EXPECT_EQ(nullptr, small_cache.lookup("b"));
+  EXPECT_NE(nullptr, small_cache.lookup("c"));
+  EXPECT_EQ(file_size * 2, small_cache.bytes());
+  EXPECT_EQ(2U, cacheFiles(small_cache.directory()).size());
+}
+
+TEST_F(DiskHttpCacheTest, MappedBodyOutlivesFileRemoval) {
+  Buffer::OwnedImpl buffer;
+  std::string cache_directory;
+  {
+    DiskHttpCache cache(directory_, 1024 * 1024);
+    cache_directory = cache.directory();
+    insert(cache, "a", std::string(100, 'a'));
+    cache.lookup("a")->addBodyTo(buffer);
+  }
+
+  EXPECT_EQ(0U, cacheFiles(cache_directory).size());
+  EXPECT_EQ(std::string(100, 'a'), TestUtility::bufferToString(buffer));
+}
+
+// Caches sharing a directory each use a subdirectory of their own, and only ever remove their own
+// files.
+TEST_F(DiskHttpCacheTest, SharedDirectory) {
+  DiskHttpCache first(directory_, 1024 * 1024);
+  insert(first, "a", "hello");
+  std::string second_directory;
+  {
+    DiskHttpCache second(directory_, 1024 * 1024);
+    second_directory = second.directory();
+    EXPECT_NE(first.directory(), second_directory);
+    EXPECT_EQ(1U, cacheFiles(first.directory()).size());
+    EXPECT_EQ(nullptr, second.lookup("a"));
+    insert(second, "a", "world");
+    EXPECT_EQ("hello", body(*first.lookup("a")));
+    EXPECT_EQ("world", body(*second.lookup("a")));
+  }
+
+  // Destroying the second cache removes its directory and leaves the first cache alone.
+  struct stat directory_stat;
+  EXPECT_NE(0, ::stat(second_directory.c_str(), &directory_stat));
+  EXPECT_EQ(1U, cacheFiles(first.directory()).size());
+  EXPECT_EQ("hello", body(*first.lookup("a")));
+}
+
+TEST_F(DiskHttpCacheTest, BadDirectory) {
+  EXPECT_THROW_WITH_MESSAGE(DiskHttpCache(directory_ + "/missing", 1024), EnvoyException,
+                            "unable to create cache directory in '" + directory_ + "/missing'");
+}
+
+} // namespace Cache
+} // namespace Filter
+} // namespace Http
+} // namespace Envoy
@@ -0,0 +1,100 @@
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/http/filter/cache/http_cache_impl.h"
+#include "common/http/filter/cache/lru_http_cache.h"
+
+#include "test/test_common/printers.h"
+#include "test/test_common/utility.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Http {
+namespace Filter {
+namespace Cache {
+
+TEST(CacheUtilityTest, ParseCacheControl) {
+  {
+    TestHeaderMapImpl headers;
+    CacheControl cache_control = CacheUtility::parseCacheControl(headers);
+    EXPECT_FALSE(cache_control.no_cache_);
+    EXPECT_FALSE(cache_control.no_store_);
+    EXPECT_FALSE(cache_control.private_);
+    EXPECT_FALSE(cache_control.max_age_.valid());
+    EXPECT_FALSE(cache_control.s_maxage_.valid());
+  }
+
+  {
+    TestHeaderMapImpl headers{{"cache-control", "Public, MAX-AGE=60 , s-maxage=120, foo=bar"}};
+    CacheControl cache_control = CacheUtility::parseCacheControl(headers);
+    EXPECT_FALSE(cache_control.no_cache_);
+    EXPECT_EQ(std::chrono::seconds(60), cache_control.max_age_.value());
+    EXPECT_EQ(std::chrono::seconds(120), cache_control.s_maxage_.value());
+  }
+
+  {
+    TestHeaderMapImpl headers{{"cache-control", "no-cache,no-store, private, max-age=abc"}};
+    CacheControl cache_control = CacheUtility::parseCacheControl(headers);
+    EXPECT_TRUE(cache_control.no_cache_);
+    EXPECT_TRUE(cache_control.no_store_);
+    EXPECT_TRUE(cache_control.private_);
+    EXPECT_FALSE(cache_control.max_age_.valid());
+  }
+}
+
+TEST(CacheUtilityTest, VaryHeaders) {
+  TestHeaderMapImpl headers{{"vary", "Accept-Encoding, ,User-Agent"}};
+  EXPECT_EQ((std::vector<std::string>{"accept-encoding", "user-agent"}),
+            CacheUtility::varyHeaders(headers));
+  EXPECT_TRUE(CacheUtility::varyHeaders(TestHeaderMapImpl{}).empty());
+}
+
+TEST(CacheUtilityTest, AddBufferReference) {
+  std::shared_ptr<std::string> data = std::make_shared<std::string>("hello");
+  {
+    Buffer::OwnedImpl buffer;
+    CacheUtility::addBufferReference(buffer, data->data(), data->size(), data);
+    EXPECT_EQ(2, data.use_count());
+
+    // The reference moves along with the data.
+    Buffer::OwnedImpl other;
+    other.move(buffer);
+    EXPECT_EQ(2, data.use_count());
+    EXPECT_EQ("hello", TestUtility::bufferToString(other));
+  }
+  EXPECT_EQ(1, data.use_count());
+}
+
+TEST(TieredHttpCacheTest, PromoteSecondTierHit) {
+  TestHeaderMapImpl headers{{":status", "200"}};
+  const SystemTime response_time{std::chrono::seconds(1000)};
+  std::shared_ptr<LruHttpCache> first = std::make_shared<LruHttpCache>(1024);
+  std::shared_ptr<LruHttpCache> second = std::make_shared<LruHttpCache>(1024);
+  TieredHttpCache cache(first, second);
+
+  Buffer::OwnedImpl body("hello");
+  cache.insert("a", headers, body, response_time, std::chrono::seconds(60));
+  EXPECT_NE(nullptr, first->lookup("a"));
+  EXPECT_NE(nullptr, second->lookup("a"));
+
+  second->insert("b", headers, body, response_time, std::chrono::seconds(60));
+  EXPECT_EQ(nullptr, first->lookup("b"));
+  CachedResponseConstSharedPtr response = cache.lookup("b");
+  ASSERT_NE(nullptr, response);
+  EXPECT_EQ(response_time, response->responseTime());
+
+  response = first->lookup("b");
+  ASSERT_NE(nullptr, response);
+  EXPECT_EQ(std::chrono::seconds(60), response->maxAge());
+  Buffer::OwnedImpl promoted_body;
+  response->addBodyTo(promoted_body);
+  EXPECT_EQ("hello", TestUtility::bufferToString(promoted_body));
+}
+
+} // namespace Cache
+} // namespace Filter
+} // namespace Http
+} // namespace Envoy
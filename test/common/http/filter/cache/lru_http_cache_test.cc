@@ -0,0 +1,102 @@
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/http/filter/cache/lru_http_cache.h"
+
+#include "test/test_common/printers.h"
+#include "test/test_common/utility.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Http {
+namespace Filter {
+namespace Cache {
+
+class LruHttpCacheTest : public testing::Test {
+public:
+  void insert(LruHttpCache& cache, const std::string& key, const std::string& body) {
+    Buffer::OwnedImpl buffer(body);
+    cache.insert(key, headers_, buffer, response_time_, std::chrono::seconds(60));
+  }
+
+  std::string body(const CachedResponse& response) {
+    Buffer::OwnedImpl buffer;
+    response.addBodyTo(buffer);
+    return TestUtility::bufferToString(buffer);
+  }
+
+  TestHeaderMapImpl headers_{{":status", "200"}};
+  SystemTime response_time_{std::chrono::seconds(1000)};
+};
+
+TEST_F(LruHttpCacheTest, InsertAndLookup) {
+  LruHttpCache cache(1024);
+  EXPECT_EQ(nullptr, cache.lookup("a"));
+
+  insert(cache, "a", "hello");
+  CachedResponseConstSharedPtr response = cache.lookup("a");
+  ASSERT_NE(nullptr, response);
+  EXPECT_EQ("hello", body(*response));
+  EXPECT_EQ(5U, response->bodySize());
+  EXPECT_EQ(response_time_, response->responseTime());
+  EXPECT_EQ(std::chrono::seconds(60), response->maxAge());
+  EXPECT_EQ(headers_, HeaderMapImpl(response->headers()));
+  EXPECT_TRUE(response->varyHeaders().empty());
+  EXPECT_EQ(1 + headers_.byteSize() + 5, cache.bytes());
+
+  // Replacing an entry replaces its size too.
+  insert(cache, "a", "hi");
+  EXPECT_EQ("hi", body(*cache.lookup("a")));
+  EXPECT_EQ(1 + headers_.byteSize() + 2, cache.bytes());
+}
+
+TEST_F(LruHttpCacheTest, VaryParsedOnInsert) {
+  LruHttpCache cache(1024);
+  headers_.addCopy("vary", "Accept-Encoding");
+  insert(cache, "a", "hello");
+  EXPECT_EQ(std::vector<std::string>{"accept-encoding"}, cache.lookup("a")->varyHeaders());
+}
+
+TEST_F(LruHttpCacheTest, EvictLeastRecentlyUsed) {
+  const uint64_t entry_size = 1 + headers_.byteSize() + 10;
+  LruHttpCache cache(entry_size * 2);
+  insert(cache, "a", std::string(10, 'a'));
+  insert(cache, "b", std::string(10, 'b'));
+
+  // Looking up a makes b the least recently used entry.
+  EXPECT_NE(nullptr, cache.lookup("a"));
+  insert(cache, "c", std::string(10, 'c'));
+  EXPECT_NE(nullptr, cache.lookup("a"));
+  EXPECT_EQ(nullptr, cache.lookup("b"));
+  EXPECT_NE(nullptr, cache.lookup("c"));
+  EXPECT_EQ(entry_size * 2, cache.bytes());
+}
+
+TEST_F(LruHttpCacheTest, SkipOversizeEntry) {
+  LruHttpCache cache(1 + headers_.byteSize() + 10);
+  insert(cache, "a", std::string(10, 'a'));
+  insert(cache, "b", std::string(11, 'b'));
+  EXPECT_NE(nullptr, cache.lookup("a"));
+  EXPECT_EQ(nullptr, cache.lookup("b"));
+}
+
+TEST_F(LruHttpCacheTest, ResponseOutlivesEviction) {
+  LruHttpCache cache(1 + headers_.byteSize() + 10);
+  insert(cache, "a", std::string(10, 'a'));
+  CachedResponseConstSharedPtr response = cache.lookup("a");
+  Buffer::OwnedImpl buffer;
+  response->addBodyTo(buffer);
+
+  insert(cache, "b", std::string(10, 'b'));
+  EXPECT_EQ(nullptr, cache.lookup("a"));
+  response.reset();
+  EXPECT_EQ(std::string(10, 'a'), TestUtility::bufferToString(buffer));
+}
+
+} // namespace Cache
+} // namespace Filter
+} // namespace Http
+} // namespace Envoy
@@ -0,0 +1,324 @@
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/decompressor/brotli_decompressor_impl.h"
+#include "common/decompressor/zlib_decompressor_impl.h"
+#include "common/decompressor/zstd_decompressor_impl.h"
+#include "common/http/filter/gzip_filter.h"
+#include "common/http/header_map_impl.h"
+#include "common/json/json_loader.h"
+#include "common/stats/stats_impl.h"
+
+#include "test/mocks/http/mocks.h"
+#include "test/mocks/thread_local/mocks.h"
+#include "test/test_common/environment.h"
+#include "test/test_common/printers.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::NiceMock;
+using testing::_;
+
+namespace Envoy {
+namespace Http {
+
+class GzipFilterTest : public testing::Test {
+public:
+  GzipFilterTest() { setup("{}"); }
+
+  void setup(const std::string& json) {
+    Json::ObjectSharedPtr json_config = Json::Factory::loadFromString(json);
+    config_ = std::make_shared<GzipFilterConfig>(*json_config, "test.", store_, tls_);
+    filter_.reset(new GzipFilter(config_));
+    filter_->setEncoderFilterCallbacks(encoder_callbacks_);
+  }
+
+  void sendRequest(const std::string& accept_encoding) {
+    TestHeaderMapImpl request_headers{{":method", "GET"}, {":path", "/"}};
+    if (!accept_encoding.empty()) {
+      request_headers.addCopy("accept-encoding", accept_encoding);
+    }
+    EXPECT_EQ(FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers, true));
+  }
+
+  std::string decompress(const Buffer::Instance& compressed) {
+    Decompressor::ZlibDecompressorImpl decompressor;
+    decompressor.init(31);
+    Buffer::OwnedImpl output;
+    decompressor.decompress(compressed, output);
+    return TestUtility::bufferToString(output);
+  }
+
+  // The filter modifies the response headers, so each stream gets its own copy of the defaults.
+  const HeaderMap& defaultResponseHeaders() { return response_headers_; }
+
+  static std::string dictionaryConfig(const std::string& encoding, const std::string& path) {
+    return fmt::format(R"EOF({{"dictionary" : {{"encoding" : "{}", "filename" : "{}"}}}})EOF",
+                       encoding, path);
+  }
+
+  std::string chooseEncoding(const std::string& accept_encoding) {
+    Optional<GzipFilterConfig::Encoding> encoding = config_->chooseEncoding(accept_encoding);
+    return encoding.valid() ? config_->encodingName(encoding.value()) : "";
+  }
+
+  uint64_t counter(const std::string& name) { return store_.counter("test.gzip." + name).value(); }
+
+  Stats::IsolatedStoreImpl store_;
+  NiceMock<ThreadLocal::MockInstance> tls_;
+  NiceMock<MockStreamEncoderFilterCallbacks> encoder_callbacks_;
+  GzipFilterConfigSharedPtr config_;
+  std::unique_ptr<GzipFilter> filter_;
+  TestHeaderMapImpl response_headers_{
+      {":status", "200"}, {"content-type", "text/html; charset=UTF-8"}, {"content-length", "100"}};
+};
+
+TEST_F(GzipFilterTest, AcceptsGzip) {
+  EXPECT_EQ("gzip", chooseEncoding("gzip"));
+  EXPECT_EQ("gzip", chooseEncoding("deflate, GZIP;q=0.5"));
+  EXPECT_EQ("gzip", chooseEncoding("*"));
+  // Only configured encodings are chosen.
+  EXPECT_EQ("gzip", chooseEncoding("br, *;q=0.1"));
+  EXPECT_EQ("", chooseEncoding(""));
+  EXPECT_EQ("", chooseEncoding("identity"));
+  EXPECT_EQ("", chooseEncoding("gzip;q=0"));
+  EXPECT_EQ("", chooseEncoding("gzip; q=0.000"));
+  EXPECT_EQ("", chooseEncoding("*, gzip;q=0"));
+  EXPECT_EQ("", chooseEncoding("*;q=0"));
+}
+
+TEST_F(GzipFilterTest, ChooseEncoding) {
+  setup(R"EOF({"encodings" : ["br", "zstd", "gzip"]})EOF");
+
+  // Equal weights go to the configured order.
+  EXPECT_EQ("br", chooseEncoding("gzip, deflate, br"));
+  EXPECT_EQ("zstd", chooseEncoding("gzip, zstd"));
+  EXPECT_EQ("br", chooseEncoding("*"));
+  // Otherwise the highest weight wins.
+  EXPECT_EQ("gzip", chooseEncoding("gzip, br;q=0.8, zstd;q=0.9"));
+  EXPECT_EQ("zstd", chooseEncoding("gzip;q=0.5, zstd;q=0.9, br;q=0.1"));
+  EXPECT_EQ("gzip", chooseEncoding("br;q=0, *;q=0.5, gzip"));
+  EXPECT_EQ("", chooseEncoding("identity, deflate"));
+  EXPECT_EQ("", chooseEncoding("br;q=0, zstd;q=0, gzip;q=0"));
+}
+
+TEST_F(GzipFilterTest, BrotliAndZstd) {
+  setup(R"EOF({"encodings" : ["br", "zstd", "gzip"]})EOF");
+  const std::string text(1000, 'a');
+
+  sendRequest("gzip, br");
+  TestHeaderMapImpl headers(defaultResponseHeaders());
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_->encodeHeaders(headers, false));
+  EXPECT_STREQ("br", headers.get(LowerCaseString("content-encoding"))->value().c_str());
+  Buffer::OwnedImpl data(text);
+  EXPECT_EQ(FilterDataStatus::Continue, filter_->encodeData(data, true));
+  Decompressor::BrotliDecompressorImpl brotli;
+  Buffer::OwnedImpl output;
+  brotli.decompress(data, output);
+  EXPECT_EQ(text, TestUtility::bufferToString(output));
+  filter_->onDestroy();
+
+  filter_.reset(new GzipFilter(config_));
+  sendRequest("gzip;q=0.5, zstd");
+  TestHeaderMapImpl zstd_headers(defaultResponseHeaders());
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_->encodeHeaders(zstd_headers, false));
+  EXPECT_STREQ("zstd", zstd_headers.get(LowerCaseString("content-encoding"))->value().c_str());
+  data.add(text);
+  EXPECT_EQ(FilterDataStatus::Continue, filter_->encodeData(data, true));
+  Decompressor::ZstdDecompressorImpl zstd;
+  output.drain(output.length());
+  zstd.decompress(data, output);
+  EXPECT_EQ(text, TestUtility::bufferToString(output));
+
+  EXPECT_EQ(2U, counter("compressed"));
+  EXPECT_EQ(1U, counter("compressed_br"));
+  EXPECT_EQ(1U, counter("compressed_zstd"));
+  EXPECT_EQ(0U, counter("compressed_gzip"));
+}
+
+TEST_F(GzipFilterTest, CompressStreamedBody) {
+  sendRequest("gzip, deflate");
+  TestHeaderMapImpl headers(defaultResponseHeaders());
+  headers.addCopy("etag", "\"abc\"");
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_->encodeHeaders(headers, false));
+  EXPECT_EQ(nullptr, headers.ContentLength());
+  EXPECT_STREQ("gzip", headers.get(LowerCaseString("content-encoding"))->value().c_str());
+  EXPECT_STREQ("accept-encoding", headers.get(LowerCaseString("vary"))->value().c_str());
+  EXPECT_STREQ("W/\"abc\"", headers.get(LowerCaseString("etag"))->value().c_str());
+
+  // Every frame is flushed as it passes through, so each can be decompressed on arrival.
+  const std::string text(1000, 'a');
+  Buffer::OwnedImpl compressed;
+  Buffer::OwnedImpl data(text);
+  EXPECT_EQ(FilterDataStatus::Continue, filter_->encodeData(data, false));
+  EXPECT_GT(data.length(), 0U);
+  EXPECT_LT(data.length(), text.size());
+  EXPECT_EQ(text, decompress(data));
+  compressed.move(data);
+
+  data.add(text);
+  EXPECT_EQ(FilterDataStatus::Continue, filter_->encodeData(data, true));
+  compressed.move(data);
+  EXPECT_EQ(text + text, decompress(compressed));
+
+  EXPECT_EQ(1U, counter("compressed"));
+  EXPECT_EQ(2000U, counter("total_uncompressed_bytes"));
+  EXPECT_EQ(compressed.length(), counter("total_compressed_bytes"));
+}
+
+TEST_F(GzipFilterTest, FinishOnTrailers) {
+  sendRequest("gzip");
+  TestHeaderMapImpl headers(defaultResponseHeaders());
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_->encodeHeaders(headers, false));
+  Buffer::OwnedImpl compressed("hello world");
+  EXPECT_EQ(FilterDataStatus::Continue, filter_->encodeData(compressed, false));
+
+  EXPECT_CALL(encoder_callbacks_, addEncodedData(_, true))
+      .WillOnce(testing::Invoke(
+          [&](Buffer::Instance& data, bool) -> void { compressed.move(data); }));
+  TestHeaderMapImpl trailers;
+  EXPECT_EQ(FilterTrailersStatus::Continue, filter_->encodeTrailers(trailers));
+  EXPECT_EQ("hello world", decompress(compressed));
+}
+
+TEST_F(GzipFilterTest, ReuseCompressor) {
+  for (int i = 0; i < 2; i++) {
+    filter_.reset(new GzipFilter(config_));
+    sendRequest("gzip");
+    TestHeaderMapImpl headers(defaultResponseHeaders());
+    EXPECT_EQ(FilterHeadersStatus::Continue, filter_->encodeHeaders(headers, false));
+    Buffer::OwnedImpl data("hello world");
+    EXPECT_EQ(FilterDataStatus::Continue, filter_->encodeData(data, true));
+    EXPECT_EQ("hello world", decompress(data));
+    filter_->onDestroy();
+  }
+
+  // A stream that is reset mid way still returns a usable compressor.
+  filter_.reset(new GzipFilter(config_));
+  sendRequest("gzip");
+  TestHeaderMapImpl headers(defaultResponseHeaders());
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_->encodeHeaders(headers, false));
+  Buffer::OwnedImpl data("partial");
+  EXPECT_EQ(FilterDataStatus::Continue, filter_->encodeData(data, false));
+  filter_->onDestroy();
+
+  filter_.reset(new GzipFilter(config_));
+  sendRequest("gzip");
+  TestHeaderMapImpl new_headers(defaultResponseHeaders());
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_->encodeHeaders(new_headers, false));
+  Buffer::OwnedImpl new_data("hello world");
+  EXPECT_EQ(FilterDataStatus::Continue, filter_->encodeData(new_data, true));
+  EXPECT_EQ("hello world", decompress(new_data));
+}
+
+TEST_F(GzipFilterTest, NoAcceptEncoding) {
+  sendRequest("");
+  TestHeaderMapImpl headers(defaultResponseHeaders());
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_->encodeHeaders(headers, false));
+  EXPECT_EQ(nullptr, headers.get(LowerCaseString("content-encoding")));
+  Buffer::OwnedImpl data("hello");
+  EXPECT_EQ(FilterDataStatus::Continue, filter_->encodeData(data, true));
+  EXPECT_EQ("hello", TestUtility::bufferToString(data));
+  EXPECT_EQ(1U, counter("no_accept_header"));
+}
+
+TEST_F(GzipFilterTest, NotCompressible) {
+  auto expectNotCompressed = [this](const HeaderMap& response_headers) -> void {
+    filter_.reset(new GzipFilter(config_));
+    TestHeaderMapImpl headers(response_headers);
+    sendRequest("gzip");
+    EXPECT_EQ(FilterHeadersStatus::Continue, filter_->encodeHeaders(headers, false));
+    Buffer::OwnedImpl data("hello");
+    EXPECT_EQ(FilterDataStatus::Continue, filter_->encodeData(data, true));
+    EXPECT_EQ("hello", TestUtility::bufferToString(data));
+  };
+
+  expectNotCompressed(TestHeaderMapImpl{{":status", "200"}, {"content-type", "image/png"}});
+  expectNotCompressed(TestHeaderMapImpl{{":status", "200"}});
+  expectNotCompressed(TestHeaderMapImpl{
+      {":status", "200"}, {"content-type", "text/html"}, {"content-length", "29"}});
+  expectNotCompressed(TestHeaderMapImpl{
+      {":status", "200"}, {"content-type", "text/html"}, {"content-encoding", "br"}});
+  expectNotCompressed(TestHeaderMapImpl{
+      {":status", "200"}, {"content-type", "text/html"}, {"cache-control", "no-transform"}});
+  EXPECT_EQ(5U, counter("not_compressed"));
+}
+
+TEST_F(GzipFilterTest, ConfiguredContentTypesAndVary) {
+  setup(R"EOF({"content_type": ["application/x-custom"], "content_length": 0,
+               "compression_level": "speed"})EOF");
+  sendRequest("gzip");
+  TestHeaderMapImpl headers{
+      {":status", "200"}, {"content-type", "application/x-custom"}, {"vary", "Cookie"}};
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_->encodeHeaders(headers, false));
+  EXPECT_STREQ("Cookie, accept-encoding", headers.get(LowerCaseString("vary"))->value().c_str());
+
+  filter_.reset(new GzipFilter(config_));
+  sendRequest("gzip");
+  TestHeaderMapImpl html_headers{{":status", "200"}, {"content-type", "text/html"}};
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_->encodeHeaders(html_headers, false));
+  EXPECT_EQ(nullptr, html_headers.get(LowerCaseString("content-encoding")));
+}
+
+TEST_F(GzipFilterTest, HeadersOnlyResponse) {
+  sendRequest("gzip");
+  TestHeaderMapImpl headers(defaultResponseHeaders());
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_->encodeHeaders(headers, true));
+  EXPECT_EQ(nullptr, headers.get(LowerCaseString("content-encoding")));
+  EXPECT_NE(nullptr, headers.ContentLength());
+}
+
+TEST_F(GzipFilterTest, Dictionary) {
+  const std::string dictionary =
+      "{\"id\": , \"name\": \"\", \"email\": \"@example.com\", \"created_at\": \"2018-01-\"}";
+  const std::string path = TestEnvironment::writeStringToFileForTest("gzip_dictionary", dictionary);
+  setup(dictionaryConfig("x-deflate-api", path));
+
+  // The client has to ask for the dictionary encoding by name.
+  EXPECT_EQ("gzip", chooseEncoding("gzip, *"));
+  EXPECT_EQ("x-deflate-api", chooseEncoding("gzip, x-deflate-api"));
+  EXPECT_EQ("gzip", chooseEncoding("gzip, x-deflate-api;q=0.5"));
+
+  const std::string body = "{\"id\": 42, \"name\": \"Alice\", \"email\": \"alice@example.com\", "
+                           "\"created_at\": \"2018-01-05\"}";
+  Buffer::OwnedImpl gzip_data;
+  Buffer::OwnedImpl dictionary_data;
+  for (const std::string& accept_encoding : {"gzip", "x-deflate-api"}) {
+    filter_.reset(new GzipFilter(config_));
+    sendRequest(accept_encoding);
+    TestHeaderMapImpl headers(defaultResponseHeaders());
+    EXPECT_EQ(FilterHeadersStatus::Continue, filter_->encodeHeaders(headers, false));
+    EXPECT_EQ(accept_encoding,
+              headers.get(LowerCaseString("content-encoding"))->value().c_str());
+    Buffer::OwnedImpl& data = accept_encoding == "gzip" ? gzip_data : dictionary_data;
+    data.add(body);
+    EXPECT_EQ(FilterDataStatus::Continue, filter_->encodeData(data, true));
+    filter_->onDestroy();
+  }
+  EXPECT_LT(dictionary_data.length(), gzip_data.length());
+  EXPECT_EQ(1U, counter("compressed_dictionary"));
+
+  Decompressor::ZlibDecompressorImpl decompressor;
+  decompressor.init(15, dictionary);
+  Buffer::OwnedImpl output;
+  decompressor.decompress(dictionary_data, output);
+  EXPECT_EQ(body, TestUtility::bufferToString(output));
+}
+
+TEST_F(GzipFilterTest, BadConfig) {
+  EXPECT_THROW(setup(R"EOF({"window_bits": 16})EOF"), Json::Exception);
+  EXPECT_THROW(setup(R"EOF({"compression_level": "fast"})EOF"), Json::Exception);
+
+  const std::string path = TestEnvironment::writeStringToFileForTest("gzip_dictionary", "dict");
+  EXPECT_THROW(setup(dictionaryConfig("gzip", path)), EnvoyException);
+  EXPECT_THROW(setup(dictionaryConfig("*", path)), EnvoyException);
+  EXPECT_THROW(setup(R"EOF({"dictionary" : {"encoding" : "x-deflate-api"}})EOF"),
+               Json::Exception);
+}
+
+} // namespace Http
+} // namespace Envoy
@@ -9,8 +9,7 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
-using testing::Return;
-using testing::_;
+using testing::ReturnRef;
 
 namespace Envoy {
 namespace Http {
@@ -22,8 +21,8 @@ public:
       "request_type" : "internal",
       "ip_tags" : [
         {
-          "ip_tag_name" : "test_internal",
-          "ip_list" : ["1.2.3.4"]
+          "ip_tag_name" : "internal_request",
+          "ip_list" : ["1.2.3.0/24"]
         }
       ]
     }
@@ -34,8 +33,8 @@ public:
       "request_type" : "external",
       "ip_tags" : [
         {
-          "ip_tag_name" : "test_external",
-          "ip_list" : ["1.2.3.4"]
+          "ip_tag_name" : "external_request",
+          "ip_list" : ["1.2.3.4/32"]
         }
       ]
     }
@@ -46,8 +45,12 @@ public:
       "request_type" : "both",
       "ip_tags" : [
         {
-          "ip_tag_name" : "test_both",
-          "ip_list" : ["1.2.3.4"]
+          "ip_tag_name" : "internal_request",
+          "ip_list" : ["1.2.3.0/24"]
+        },
+        {
+          "ip_tag_name" : "external_request",
+          "ip_list" : ["1.2.3.4/32", "2001:abcd:ef01:2345::/64"]
         }
       ]
     }
@@ -71,26 +74,105 @@ public:
 
 TEST_F(IpTaggingFilterTest, InternalRequest) {
   SetUpTest(internal_request_json);
+  std::string remote_address = "1.2.3.5";
+  EXPECT_CALL(filter_callbacks_, downstreamAddress()).WillOnce(ReturnRef(remote_address));
 
+  request_headers_.addCopy(Headers::get().EnvoyInternalRequest, "true");
   EXPECT_EQ(FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers_, false));
+  EXPECT_EQ("internal_request", request_headers_.get_(Headers::get().EnvoyIpTags));
   EXPECT_EQ(FilterDataStatus::Continue, filter_->decodeData(data_, false));
   EXPECT_EQ(FilterTrailersStatus::Continue, filter_->decodeTrailers(request_headers_));
 }
 
+TEST_F(IpTaggingFilterTest, InternalRequestNotTaggedByExternalConfig) {
+  SetUpTest(external_request_json);
+  EXPECT_CALL(filter_callbacks_, downstreamAddress()).Times(0);
+
+  request_headers_.addCopy(Headers::get().EnvoyInternalRequest, "true");
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers_, false));
+  EXPECT_FALSE(request_headers_.has(Headers::get().EnvoyIpTags));
+}
+
 TEST_F(IpTaggingFilterTest, ExternalRequest) {
   SetUpTest(external_request_json);
+  std::string remote_address = "1.2.3.4";
+  EXPECT_CALL(filter_callbacks_, downstreamAddress()).WillOnce(ReturnRef(remote_address));
 
   EXPECT_EQ(FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers_, false));
+  EXPECT_EQ("external_request", request_headers_.get_(Headers::get().EnvoyIpTags));
   EXPECT_EQ(FilterDataStatus::Continue, filter_->decodeData(data_, false));
   EXPECT_EQ(FilterTrailersStatus::Continue, filter_->decodeTrailers(request_headers_));
 }
 
+TEST_F(IpTaggingFilterTest, ExternalRequestNotTaggedByInternalConfig) {
+  SetUpTest(internal_request_json);
+  EXPECT_CALL(filter_callbacks_, downstreamAddress()).Times(0);
+
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers_, false));
+  EXPECT_FALSE(request_headers_.has(Headers::get().EnvoyIpTags));
+}
+
 TEST_F(IpTaggingFilterTest, BothRequest) {
   SetUpTest(both_request_json);
+  std::string internal_address = "1.2.3.4";
+  std::string external_address = "2001:abcd:ef01:2345::1";
+  EXPECT_CALL(filter_callbacks_, downstreamAddress())
+      .WillOnce(ReturnRef(internal_address))
+      .WillOnce(ReturnRef(external_address));
 
+  request_headers_.addCopy(Headers::get().EnvoyInternalRequest, "true");
   EXPECT_EQ(FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers_, false));
-  EXPECT_EQ(FilterDataStatus::Continue, filter_->decodeData(data_, false));
-  EXPECT_EQ(FilterTrailersStatus::Continue, filter_->decodeTrailers(request_headers_));
+  EXPECT_EQ("internal_request,external_request",
+            request_headers_.get_(Headers::get().EnvoyIpTags));
+
+  TestHeaderMapImpl external_headers;
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_->decodeHeaders(external_headers, false));
+  EXPECT_EQ("external_request", external_headers.get_(Headers::get().EnvoyIpTags));
+}
+
+TEST_F(IpTaggingFilterTest, AppendToExistingHeader) {
+  SetUpTest(external_request_json);
+  std::string remote_address = "1.2.3.4";
+  EXPECT_CALL(filter_callbacks_, downstreamAddress()).WillOnce(ReturnRef(remote_address));
+
+  request_headers_.addCopy(Headers::get().EnvoyIpTags, "existing_tag");
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers_, false));
+  EXPECT_EQ("existing_tag,external_request", request_headers_.get_(Headers::get().EnvoyIpTags));
+}
+
+TEST_F(IpTaggingFilterTest, NoMatch) {
+  SetUpTest(both_request_json);
+  std::string remote_address = "10.2.3.4";
+  EXPECT_CALL(filter_callbacks_, downstreamAddress()).WillOnce(ReturnRef(remote_address));
+
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers_, false));
+  EXPECT_FALSE(request_headers_.has(Headers::get().EnvoyIpTags));
+}
+
+TEST_F(IpTaggingFilterTest, InvalidDownstreamAddress) {
+  SetUpTest(both_request_json);
+  std::string remote_address = "not_an_address";
+  EXPECT_CALL(filter_callbacks_, downstreamAddress()).WillOnce(ReturnRef(remote_address));
+
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers_, false));
+  EXPECT_FALSE(request_headers_.has(Headers::get().EnvoyIpTags));
+}
+
+TEST(IpTaggingFilterConfigTest, InvalidCidr) {
+  const std::string json = R"EOF(
+    {
+      "ip_tags" : [
+        {
+          "ip_tag_name" : "bad",
+          "ip_list" : ["1.2.3.4/40"]
+        }
+      ]
+    }
+  )EOF";
+
+  Json::ObjectSharedPtr config = Json::Factory::loadFromString(json);
+  EXPECT_THROW_WITH_MESSAGE(IpTaggingFilterConfig{*config}, EnvoyException,
+                            "invalid ip/mask combo '1.2.3.4/40' (format is <ip>/<# mask bits>)");
 }
 
 } // namespace Http
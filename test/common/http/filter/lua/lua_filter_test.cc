@@ -3,6 +3,8 @@
 #include "common/http/message_impl.h"
 
 #include "test/mocks/http/mocks.h"
+#include "test/mocks/runtime/mocks.h"
+#include "test/mocks/stats/mocks.h"
 #include "test/mocks/thread_local/mocks.h"
 #include "test/mocks/upstream/mocks.h"
 #include "test/test_common/printers.h"
@@ -13,6 +15,7 @@
 using testing::AtLeast;
 using testing::InSequence;
 using testing::Invoke;
+using testing::Property;
 using testing::Return;
 using testing::StrEq;
 using testing::_;
@@ -59,7 +62,8 @@ public:
   ~LuaHttpFilterTest() { filter_->onDestroy(); }
 
   void setup(const std::string& lua_code) {
-    config_.reset(new FilterConfig(lua_code, tls_, cluster_manager_));
+    config_.reset(
+        new FilterConfig(lua_code, tls_, cluster_manager_, runtime_, "test.", stats_store_));
     filter_.reset(new TestFilter(config_));
     filter_->setDecoderFilterCallbacks(decoder_callbacks_);
     filter_->setEncoderFilterCallbacks(encoder_callbacks_);
@@ -67,6 +71,8 @@ public:
 
   NiceMock<ThreadLocal::MockInstance> tls_;
   Upstream::MockClusterManager cluster_manager_;
+  NiceMock<Runtime::MockLoader> runtime_;
+  NiceMock<Stats::MockIsolatedStatsStore> stats_store_;
   std::shared_ptr<FilterConfig> config_;
   std::unique_ptr<TestFilter> filter_;
   MockStreamDecoderFilterCallbacks decoder_callbacks_;
@@ -158,10 +164,31 @@ TEST(LuaHttpFilterConfigTest, BadCode) {
 
   NiceMock<ThreadLocal::MockInstance> tls;
   NiceMock<Upstream::MockClusterManager> cluster_manager;
-  EXPECT_THROW_WITH_MESSAGE(FilterConfig(SCRIPT, tls, cluster_manager), Envoy::Lua::LuaException,
+  NiceMock<Runtime::MockLoader> runtime;
+  Stats::IsolatedStoreImpl stats_store;
+  EXPECT_THROW_WITH_MESSAGE(FilterConfig(SCRIPT, tls, cluster_manager, runtime, "", stats_store),
+                            Envoy::Lua::LuaException,
                             "script load error: [string \"...\"]:3: '=' expected near '<eof>'");
 }
 
+// Once a stream that ran a script is done, the runtime controlled garbage collection step runs and
+// the memory used by the worker's state is recorded.
+TEST_F(LuaHttpFilterTest, GarbageCollectionOnStreamComplete) {
+  InSequence s;
+  setup(HEADER_ONLY_SCRIPT);
+
+  TestHeaderMapImpl request_headers{{":path", "/"}};
+  EXPECT_CALL(*filter_, scriptLog(spdlog::level::trace, StrEq("/")));
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers, true));
+
+  EXPECT_CALL(runtime_.snapshot_, getInteger("lua.gc_step_kb", 0)).WillOnce(Return(64));
+  EXPECT_CALL(stats_store_,
+              deliverHistogramToSinks(Property(&Stats::Metric::name, "test.lua.gc_step_us"), _));
+  EXPECT_CALL(stats_store_,
+              deliverHistogramToSinks(Property(&Stats::Metric::name, "test.lua.memory_kb"), _));
+  filter_->onDestroy();
+}
+
 // Script touching headers only, request that is headers only.
 TEST_F(LuaHttpFilterTest, ScriptHeadersOnlyRequestHeadersOnly) {
   InSequence s;
@@ -1169,6 +1196,135 @@ TEST_F(LuaHttpFilterTest, HttpCallInvalidHeaders) {
   EXPECT_EQ(FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers, false));
 }
 
+// Batched HTTP calls, which resume the script once all of them complete.
+TEST_F(LuaHttpFilterTest, HttpCalls) {
+  const std::string SCRIPT{R"EOF(
+    function envoy_on_request(request_handle)
+      local headers = {
+        [":method"] = "GET",
+        [":path"] = "/",
+        [":authority"] = "foo"
+      }
+      local results = request_handle:httpCalls({
+        {"cluster1", headers, nil, 5000},
+        {"cluster2", headers, "hello", 5000}
+      })
+      for i, result in ipairs(results) do
+        request_handle:logTrace(i .. " " .. result.headers[":status"] .. " " .. result.body)
+      end
+    end
+  )EOF"};
+
+  InSequence s;
+  setup(SCRIPT);
+
+  TestHeaderMapImpl request_headers{{":path", "/"}};
+  MockAsyncClientRequest request1(&cluster_manager_.async_client_);
+  MockAsyncClientRequest request2(&cluster_manager_.async_client_);
+  std::vector<AsyncClient::Callbacks*> callbacks;
+  EXPECT_CALL(cluster_manager_, get("cluster1"));
+  EXPECT_CALL(cluster_manager_, get("cluster2"));
+  EXPECT_CALL(cluster_manager_, httpAsyncClientForCluster("cluster1"));
+  EXPECT_CALL(cluster_manager_.async_client_, send_(_, _, _))
+      .WillOnce(Invoke([&](MessagePtr&, AsyncClient::Callbacks& cb,
+                           const Optional<std::chrono::milliseconds>&) -> AsyncClient::Request* {
+        callbacks.push_back(&cb);
+        return &request1;
+      }));
+  EXPECT_CALL(cluster_manager_, httpAsyncClientForCluster("cluster2"));
+  EXPECT_CALL(cluster_manager_.async_client_, send_(_, _, _))
+      .WillOnce(Invoke([&](MessagePtr& message, AsyncClient::Callbacks& cb,
+                           const Optional<std::chrono::milliseconds>&) -> AsyncClient::Request* {
+        EXPECT_EQ("hello", message->bodyAsString());
+        callbacks.push_back(&cb);
+        return &request2;
+      }));
+
+  EXPECT_EQ(FilterHeadersStatus::StopIteration, filter_->decodeHeaders(request_headers, true));
+
+  MessagePtr response_message(
+      new ResponseMessageImpl(HeaderMapPtr{new TestHeaderMapImpl{{":status", "200"}}}));
+  response_message->body().reset(new Buffer::OwnedImpl("response"));
+  callbacks[1]->onSuccess(std::move(response_message));
+
+  EXPECT_CALL(*filter_, scriptLog(spdlog::level::trace, StrEq("1 503 upstream failure")));
+  EXPECT_CALL(*filter_, scriptLog(spdlog::level::trace, StrEq("2 200 response")));
+  EXPECT_CALL(decoder_callbacks_, continueDecoding());
+  callbacks[0]->onFailure(AsyncClient::FailureReason::Reset);
+}
+
+// Batched HTTP calls that resume the script once the first one completes, which cancels the
+// other.
+TEST_F(LuaHttpFilterTest, HttpCallsWaitForFirst) {
+  const std::string SCRIPT{R"EOF(
+    function envoy_on_request(request_handle)
+      local headers = {
+        [":method"] = "GET",
+        [":path"] = "/",
+        [":authority"] = "foo"
+      }
+      local results = request_handle:httpCalls({
+        {"cluster", headers, nil, 5000},
+        {"cluster", headers, nil, 5000}
+      }, 1)
+      request_handle:logTrace(tostring(results[1]))
+      request_handle:logTrace(results[2].body)
+    end
+  )EOF"};
+
+  InSequence s;
+  setup(SCRIPT);
+
+  TestHeaderMapImpl request_headers{{":path", "/"}};
+  MockAsyncClientRequest request1(&cluster_manager_.async_client_);
+  MockAsyncClientRequest request2(&cluster_manager_.async_client_);
+  std::vector<AsyncClient::Callbacks*> callbacks;
+  EXPECT_CALL(cluster_manager_, get("cluster")).Times(2);
+  EXPECT_CALL(cluster_manager_, httpAsyncClientForCluster("cluster"));
+  EXPECT_CALL(cluster_manager_.async_client_, send_(_, _, _))
+      .WillOnce(Invoke([&](MessagePtr&, AsyncClient::Callbacks& cb,
+                           const Optional<std::chrono::milliseconds>&) -> AsyncClient::Request* {
+        callbacks.push_back(&cb);
+        return &request1;
+      }));
+  EXPECT_CALL(cluster_manager_, httpAsyncClientForCluster("cluster"));
+  EXPECT_CALL(cluster_manager_.async_client_, send_(_, _, _))
+      .WillOnce(Invoke([&](MessagePtr&, AsyncClient::Callbacks& cb,
+                           const Optional<std::chrono::milliseconds>&) -> AsyncClient::Request* {
+        callbacks.push_back(&cb);
+        return &request2;
+      }));
+
+  EXPECT_EQ(FilterHeadersStatus::StopIteration, filter_->decodeHeaders(request_headers, true));
+
+  MessagePtr response_message(
+      new ResponseMessageImpl(HeaderMapPtr{new TestHeaderMapImpl{{":status", "200"}}}));
+  response_message->body().reset(new Buffer::OwnedImpl("response"));
+  EXPECT_CALL(request1, cancel());
+  EXPECT_CALL(*filter_, scriptLog(spdlog::level::trace, StrEq("nil")));
+  EXPECT_CALL(*filter_, scriptLog(spdlog::level::trace, StrEq("response")));
+  EXPECT_CALL(decoder_callbacks_, continueDecoding());
+  callbacks[1]->onSuccess(std::move(response_message));
+}
+
+// Invalid number of batched HTTP calls to wait for.
+TEST_F(LuaHttpFilterTest, HttpCallsInvalidWaitFor) {
+  const std::string SCRIPT{R"EOF(
+    function envoy_on_request(request_handle)
+      request_handle:httpCalls({}, 1)
+    end
+  )EOF"};
+
+  InSequence s;
+  setup(SCRIPT);
+
+  TestHeaderMapImpl request_headers{{":path", "/"}};
+  EXPECT_CALL(*filter_, scriptLog(spdlog::level::err,
+                                  StrEq("[string \"...\"]:3: http calls must wait for between 1 "
+                                        "and the number of calls")));
+  EXPECT_EQ(FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers, false));
+}
+
 // Respond right away.
 TEST_F(LuaHttpFilterTest, ImmediateResponse) {
   const std::string SCRIPT{R"EOF(
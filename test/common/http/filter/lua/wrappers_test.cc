@@ -53,6 +53,27 @@ TEST_F(LuaHeaderMapWrapperTest, Methods) {
   start("callMe");
 }
 
+// Reading header values in place through LuaJIT FFI.
+TEST_F(LuaHeaderMapWrapperTest, GetRaw) {
+  const std::string SCRIPT{R"EOF(
+    function callMe(object)
+      local ffi = require("ffi")
+      local pointer, length = object:getRaw("hELLo")
+      testPrint(ffi.string(ffi.cast("const char*", pointer), length))
+      testPrint(tostring(object:getRaw("missing")))
+    end
+  )EOF"};
+
+  InSequence s;
+  setup(SCRIPT);
+
+  TestHeaderMapImpl headers{{"hello", "world"}};
+  HeaderMapWrapper::create(coroutine_->luaState(), headers, []() { return true; });
+  EXPECT_CALL(*this, testPrint("world"));
+  EXPECT_CALL(*this, testPrint("nil"));
+  start("callMe");
+}
+
 // Test modifiable methods.
 TEST_F(LuaHeaderMapWrapperTest, ModifiableMethods) {
   const std::string SCRIPT{R"EOF(
@@ -0,0 +1,114 @@
+#include <string>
+#include <vector>
+
+#include "common/http/header_map_impl.h"
+
+#include "benchmark/benchmark.h"
+
+namespace Envoy {
+namespace Http {
+
+// Header names used to populate maps with non-inline headers, as seen on typical requests
+// carrying tracing and application metadata.
+static const std::vector<LowerCaseString>& customHeaderNames() {
+  static const std::vector<LowerCaseString>* names = [] {
+    auto* names = new std::vector<LowerCaseString>();
+    for (size_t i = 0; i < 32; i++) {
+      names->emplace_back("x-custom-header-" + std::to_string(i));
+    }
+    return names;
+  }();
+  return *names;
+}
+
+// Build a request header map with the inline headers plus state.range(0) custom headers.
+static void populateRequestHeaders(HeaderMapImpl& headers, size_t custom_headers) {
+  headers.insertMethod().value(std::string("GET"));
+  headers.insertPath().value(std::string("/some/path?query=value"));
+  headers.insertHost().value(std::string("www.example.com"));
+  headers.insertScheme().value(std::string("https"));
+  headers.insertUserAgent().value(std::string("curl/7.54.0"));
+  headers.insertRequestId().value(std::string("a4e9f7c2-3f44-4d31-9b9d-5f8c1e0b6a21"));
+  for (size_t i = 0; i < custom_headers; i++) {
+    headers.addCopy(customHeaderNames()[i], "value");
+  }
+}
+
+static void HeaderMapImplPopulate(benchmark::State& state) {
+  const size_t custom_headers = state.range(0);
+  while (state.KeepRunning()) {
+    HeaderMapImpl headers;
+    populateRequestHeaders(headers, custom_headers);
+    benchmark::DoNotOptimize(headers.byteSize());
+  }
+}
+BENCHMARK(HeaderMapImplPopulate)->Arg(0)->Arg(4)->Arg(16)->Arg(32);
+
+// Add headers by name, as the codecs do, which looks each name up in the static lookup table.
+static void HeaderMapImplAddByName(benchmark::State& state) {
+  static const std::vector<LowerCaseString> names = {
+      LowerCaseString(":method"),         LowerCaseString(":path"),
+      LowerCaseString(":authority"),      LowerCaseString(":scheme"),
+      LowerCaseString("user-agent"),      LowerCaseString("accept"),
+      LowerCaseString("accept-encoding"), LowerCaseString("x-request-id"),
+      LowerCaseString("x-b3-traceid"),    LowerCaseString("content-type")};
+  while (state.KeepRunning()) {
+    HeaderMapImpl headers;
+    for (const LowerCaseString& name : names) {
+      headers.addCopy(name, "value");
+    }
+    benchmark::DoNotOptimize(headers.byteSize());
+  }
+}
+BENCHMARK(HeaderMapImplAddByName);
+
+static void HeaderMapImplInlineLookup(benchmark::State& state) {
+  HeaderMapImpl headers;
+  populateRequestHeaders(headers, state.range(0));
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(headers.Host());
+    benchmark::DoNotOptimize(headers.Path());
+  }
+}
+BENCHMARK(HeaderMapImplInlineLookup)->Arg(0)->Arg(16);
+
+static void HeaderMapImplCustomLookup(benchmark::State& state) {
+  const size_t custom_headers = state.range(0);
+  HeaderMapImpl headers;
+  populateRequestHeaders(headers, custom_headers);
+  // Look up the last custom header added, which is the worst case for a linear scan.
+  const LowerCaseString& key = customHeaderNames()[custom_headers - 1];
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(headers.get(key));
+  }
+}
+BENCHMARK(HeaderMapImplCustomLookup)->Arg(1)->Arg(4)->Arg(16)->Arg(32);
+
+static void HeaderMapImplCopy(benchmark::State& state) {
+  HeaderMapImpl headers;
+  populateRequestHeaders(headers, state.range(0));
+  const HeaderMap& source = headers;
+  while (state.KeepRunning()) {
+    HeaderMapImpl copy(source);
+    benchmark::DoNotOptimize(copy.byteSize());
+  }
+}
+BENCHMARK(HeaderMapImplCopy)->Arg(0)->Arg(16);
+
+static void HeaderMapImplRemove(benchmark::State& state) {
+  const size_t custom_headers = state.range(0);
+  while (state.KeepRunning()) {
+    state.PauseTiming();
+    HeaderMapImpl headers;
+    populateRequestHeaders(headers, custom_headers);
+    state.ResumeTiming();
+    for (size_t i = 0; i < custom_headers; i++) {
+      headers.remove(customHeaderNames()[i]);
+    }
+    headers.removeHost();
+  }
+}
+BENCHMARK(HeaderMapImplRemove)->Arg(4)->Arg(16);
+
+} // namespace Http
+} // namespace Envoy
@@ -1,4 +1,6 @@
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "common/http/header_map_impl.h"
 
@@ -10,6 +12,13 @@
 namespace Envoy {
 namespace Http {
 
+TEST(LowerCaseStringTest, All) {
+  EXPECT_EQ("content-type", LowerCaseString("Content-Type").get());
+  EXPECT_EQ("x-@[`{", LowerCaseString("X-@[`{").get());
+  EXPECT_EQ("\xC1\xDA", LowerCaseString("\xC1\xDA").get());
+  EXPECT_EQ("ABC", LowerCaseString(std::string("ABC"), false).get());
+}
+
 TEST(HeaderStringTest, All) {
   // Static LowerCaseString constructor
   {
@@ -305,6 +314,30 @@ TEST(HeaderMapImplTest, MoveIntoInline) {
   EXPECT_STREQ("hello", headers.Host()->value().c_str());
 }
 
+TEST(HeaderMapImplTest, MoveKeyThenFillValue) {
+  HeaderMapImpl headers;
+  HeaderString key;
+  key.setCopy("hello", 5);
+  HeaderEntry* entry = headers.addViaMoveKey(std::move(key));
+  EXPECT_TRUE(key.empty());
+  entry->value().append("wor", 3);
+  entry->value().append("ld", 2);
+  EXPECT_STREQ("world", headers.get(LowerCaseString("hello"))->value().c_str());
+
+  key.setCopy(Headers::get().Host.get().c_str(), Headers::get().Host.get().size());
+  entry = headers.addViaMoveKey(std::move(key));
+  EXPECT_TRUE(key.empty());
+  entry->value().append("example.com", 11);
+  EXPECT_EQ(entry, headers.Host());
+  EXPECT_STREQ("example.com", headers.Host()->value().c_str());
+
+  // A second copy of an inline header is dropped.
+  key.setCopy(Headers::get().Host.get().c_str(), Headers::get().Host.get().size());
+  EXPECT_EQ(nullptr, headers.addViaMoveKey(std::move(key)));
+  EXPECT_STREQ("example.com", headers.Host()->value().c_str());
+  EXPECT_EQ(2UL, headers.size());
+}
+
 TEST(HeaderMapImplTest, Remove) {
   HeaderMapImpl headers;
 
@@ -571,5 +604,177 @@ TEST(HeaderMapImplTest, Lookup) {
     EXPECT_EQ(nullptr, entry);
   }
 }
+
+// Every inline header, and only those, is found in the static lookup table. Keys that share a
+// size or a prefix with an inline header are not.
+TEST(HeaderMapImplTest, StaticLookup) {
+  TestHeaderMapImpl headers;
+  const HeaderEntry* entry;
+#define EXPECT_INLINE_LOOKUP(name)                                                                 \
+  EXPECT_EQ(HeaderMap::Lookup::NotFound, headers.lookup(Headers::get().name, &entry));
+  ALL_INLINE_HEADERS(EXPECT_INLINE_LOOKUP)
+#undef EXPECT_INLINE_LOOKUP
+
+  EXPECT_EQ(HeaderMap::Lookup::NotFound, headers.lookup(LowerCaseString{"host"}, &entry));
+  for (const std::string key : {":pbth", ":pat", ":paths", "", "x-envoy-", "hos",
+                                std::string(100, 'a')}) {
+    EXPECT_EQ(HeaderMap::Lookup::NotSupported, headers.lookup(LowerCaseString{key}, &entry));
+  }
+
+  headers.addCopy(":pbth", "/");
+  EXPECT_EQ(nullptr, headers.Path());
+  headers.addCopy("host", "lyft.com");
+  EXPECT_STREQ("lyft.com", headers.Host()->value().c_str());
+}
+
+// Large maps build an index over custom headers on lookup. Verify that get() and remove() keep
+// returning the same results as the list scan while headers are added and removed.
+TEST(HeaderMapImplTest, LargeMapCustomHeaderLookup) {
+  HeaderMapImpl headers;
+  headers.insertHost().value(std::string("host"));
+  for (size_t i = 0; i < 40; i++) {
+    headers.addCopy(LowerCaseString("x-custom-" + std::to_string(i)), std::to_string(i));
+  }
+  headers.addCopy(LowerCaseString("x-dup"), "first");
+  headers.addCopy(LowerCaseString("x-dup"), "second");
+
+  EXPECT_STREQ("39", headers.get(LowerCaseString("x-custom-39"))->value().c_str());
+  EXPECT_STREQ("0", headers.get(LowerCaseString("x-custom-0"))->value().c_str());
+  EXPECT_EQ(nullptr, headers.get(LowerCaseString("x-custom-40")));
+  EXPECT_STREQ("host", headers.get(Headers::get().Host)->value().c_str());
+  EXPECT_EQ(nullptr, headers.get(Headers::get().Path));
+
+  // Duplicate keys return the first header added.
+  EXPECT_STREQ("first", headers.get(LowerCaseString("x-dup"))->value().c_str());
+
+  // Headers added after the index is built are found.
+  headers.addCopy(LowerCaseString("x-late"), "late");
+  EXPECT_STREQ("late", headers.get(LowerCaseString("x-late"))->value().c_str());
+  headers.insertPath().value(std::string("/"));
+  EXPECT_STREQ("/", headers.get(Headers::get().Path)->value().c_str());
+
+  // Removing a key removes every header with that key.
+  headers.remove(LowerCaseString("x-dup"));
+  EXPECT_EQ(nullptr, headers.get(LowerCaseString("x-dup")));
+  headers.addCopy(LowerCaseString("x-dup"), "third");
+  EXPECT_STREQ("third", headers.get(LowerCaseString("x-dup"))->value().c_str());
+
+  // Removing an absent key is a no-op.
+  const size_t size = headers.size();
+  headers.remove(LowerCaseString("x-absent"));
+  EXPECT_EQ(size, headers.size());
+
+  // setReference replaces all values.
+  LowerCaseString ref_key("x-custom-5");
+  std::string ref_value("replaced");
+  headers.setReference(ref_key, ref_value);
+  EXPECT_STREQ("replaced", headers.get(LowerCaseString("x-custom-5"))->value().c_str());
+
+  headers.removeHost();
+  EXPECT_EQ(nullptr, headers.get(Headers::get().Host));
+}
+
+// The custom header index is built when headers are added, so that a map which is no longer
+// modified can be read concurrently. Run under TSAN to catch a lookup that writes to the map.
+TEST(HeaderMapImplTest, LargeMapConcurrentGet) {
+  HeaderMapImpl headers;
+  for (size_t i = 0; i < 40; i++) {
+    headers.addCopy(LowerCaseString("x-custom-" + std::to_string(i)), std::to_string(i));
+  }
+  const HeaderMapImpl& const_headers = headers;
+
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < 4; t++) {
+    threads.emplace_back([&const_headers]() {
+      for (size_t round = 0; round < 100; round++) {
+        for (size_t i = 0; i < 40; i++) {
+          const HeaderEntry* entry =
+              const_headers.get(LowerCaseString("x-custom-" + std::to_string(i)));
+          ASSERT_NE(nullptr, entry);
+          EXPECT_EQ(std::to_string(i), entry->value().c_str());
+        }
+        EXPECT_EQ(nullptr, const_headers.get(LowerCaseString("x-absent")));
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
+// Header storage is block allocated and recycled. Verify ordering and contents survive growing past
+// several blocks and reusing freed entries.
+TEST(HeaderMapImplTest, EntryStorageReuse) {
+  HeaderMapImpl headers;
+  for (size_t round = 0; round < 3; round++) {
+    for (size_t i = 0; i < 100; i++) {
+      headers.addCopy(LowerCaseString("x-" + std::to_string(i)), std::to_string(round));
+    }
+    headers.insertHost().value(std::string("host"));
+    EXPECT_EQ(101UL, headers.size());
+
+    size_t index = 0;
+    headers.iterate(
+        [](const HeaderEntry& header, void* context) -> HeaderMap::Iterate {
+          size_t& index = *static_cast<size_t*>(context);
+          if (index < 100) {
+            EXPECT_EQ("x-" + std::to_string(index), header.key().c_str());
+          } else {
+            EXPECT_STREQ(":authority", header.key().c_str());
+          }
+          index++;
+          return HeaderMap::Iterate::Continue;
+        },
+        &index);
+    EXPECT_EQ(101UL, index);
+
+    for (size_t i = 0; i < 100; i++) {
+      headers.remove(LowerCaseString("x-" + std::to_string(i)));
+    }
+    headers.removeHost();
+    EXPECT_EQ(0UL, headers.size());
+  }
+}
+
+// Moving a map keeps its entries, inline headers and custom header index, and leaves the moved from
+// map empty and usable.
+TEST(HeaderMapImplTest, Move) {
+  HeaderMapImpl headers;
+  headers.insertHost().value(std::string("host"));
+  for (size_t i = 0; i < 40; i++) {
+    headers.addCopy(LowerCaseString("x-custom-" + std::to_string(i)), std::to_string(i));
+  }
+  // Builds the custom header index.
+  EXPECT_STREQ("39", headers.get(LowerCaseString("x-custom-39"))->value().c_str());
+
+  HeaderMapImpl moved(std::move(headers));
+  EXPECT_EQ(41UL, moved.size());
+  EXPECT_STREQ("host", moved.Host()->value().c_str());
+  EXPECT_STREQ("0", moved.get(LowerCaseString("x-custom-0"))->value().c_str());
+  moved.addCopy(LowerCaseString("x-late"), "late");
+  EXPECT_STREQ("late", moved.get(LowerCaseString("x-late"))->value().c_str());
+
+  EXPECT_EQ(0UL, headers.size());
+  EXPECT_EQ(nullptr, headers.Host());
+  EXPECT_EQ(nullptr, headers.get(LowerCaseString("x-custom-0")));
+  headers.insertPath().value(std::string("/"));
+  headers.addCopy(LowerCaseString("x-custom-0"), "again");
+  EXPECT_EQ(2UL, headers.size());
+
+  // Move assignment frees the entries of the destination and takes over those of the source.
+  moved = std::move(headers);
+  EXPECT_EQ(2UL, moved.size());
+  EXPECT_EQ(nullptr, moved.Host());
+  EXPECT_STREQ("/", moved.Path()->value().c_str());
+  EXPECT_STREQ("again", moved.get(LowerCaseString("x-custom-0"))->value().c_str());
+  EXPECT_EQ(0UL, headers.size());
+
+  TestHeaderMapImpl test_headers = TestHeaderMapImpl{{":path", "/test"}, {"x-custom", "value"}};
+  EXPECT_STREQ("/test", test_headers.Path()->value().c_str());
+  test_headers = TestHeaderMapImpl{{":method", "GET"}};
+  EXPECT_EQ(nullptr, test_headers.Path());
+  EXPECT_EQ("GET", test_headers.get_(":method"));
+}
+
 } // namespace Http
 } // namespace Envoy
@@ -0,0 +1,198 @@
+#include <string>
+#include <vector>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/http/header_map_impl.h"
+#include "common/http/http1/codec_impl.h"
+
+#include "test/mocks/http/mocks.h"
+#include "test/mocks/network/mocks.h"
+
+#include "benchmark/benchmark.h"
+#include "gmock/gmock.h"
+
+using testing::Invoke;
+using testing::NiceMock;
+using testing::_;
+
+namespace Envoy {
+namespace Http {
+namespace Http1 {
+
+/**
+ * Drives a server codec through full request/response exchanges on one keep-alive connection.
+ * Response bytes written to the connection are discarded.
+ */
+class Http1ServerCodecPerf {
+public:
+  Http1ServerCodecPerf() : codec_(connection_, callbacks_, Http1Settings()) {
+    ON_CALL(connection_, write(_)).WillByDefault(Invoke([](Buffer::Instance& data) -> void {
+      data.drain(data.length());
+    }));
+    ON_CALL(callbacks_, newStream(_))
+        .WillByDefault(Invoke([this](StreamEncoder& encoder) -> StreamDecoder& {
+          response_encoder_ = &encoder;
+          return decoder_;
+        }));
+  }
+
+  void exchange(benchmark::State& state, const std::string& request) {
+    exchange(state, std::vector<std::string>{request});
+  }
+
+  // Each fragment is dispatched separately, as when a request head spans several reads.
+  void exchange(benchmark::State& state, const std::vector<std::string>& fragments) {
+    HeaderMapImpl response_headers{{Headers::get().Status, "200"}};
+    size_t request_size = 0;
+    for (const std::string& fragment : fragments) {
+      request_size += fragment.size();
+    }
+
+    while (state.KeepRunning()) {
+      for (const std::string& fragment : fragments) {
+        Buffer::OwnedImpl buffer(fragment);
+        codec_.dispatch(buffer);
+      }
+      response_encoder_->encodeHeaders(response_headers, true);
+    }
+    state.SetBytesProcessed(state.iterations() * request_size);
+  }
+
+private:
+  NiceMock<Network::MockConnection> connection_;
+  NiceMock<MockServerConnectionCallbacks> callbacks_;
+  NiceMock<MockStreamDecoder> decoder_;
+  ServerConnectionImpl codec_;
+  StreamEncoder* response_encoder_{};
+};
+
+/**
+ * Drives a client codec through full request/response exchanges on one keep-alive connection.
+ * Request bytes written to the connection are discarded.
+ */
+class Http1ClientCodecPerf {
+public:
+  Http1ClientCodecPerf() : codec_(connection_, callbacks_) {
+    ON_CALL(connection_, write(_)).WillByDefault(Invoke([](Buffer::Instance& data) -> void {
+      data.drain(data.length());
+    }));
+  }
+
+  void exchange(benchmark::State& state, const std::string& response) {
+    HeaderMapImpl request_headers{{Headers::get().Method, "GET"},
+                                  {Headers::get().Path, "/"},
+                                  {Headers::get().Host, "www.example.com"}};
+    while (state.KeepRunning()) {
+      StreamEncoder& request_encoder = codec_.newStream(decoder_);
+      request_encoder.encodeHeaders(request_headers, true);
+      Buffer::OwnedImpl buffer(response);
+      codec_.dispatch(buffer);
+    }
+    state.SetBytesProcessed(state.iterations() * response.size());
+  }
+
+private:
+  NiceMock<Network::MockConnection> connection_;
+  NiceMock<MockConnectionCallbacks> callbacks_;
+  NiceMock<MockStreamDecoder> decoder_;
+  ClientConnectionImpl codec_;
+};
+
+// Header set of a typical browser navigation, with the long cookie and user agent values seen at
+// the edge.
+static const std::string& browserRequest() {
+  static const std::string* request = new std::string(
+      "GET /products/category/item-1234567?ref=homepage&utm_source=newsletter HTTP/1.1\r\n"
+      "Host: www.example.com\r\n"
+      "Connection: keep-alive\r\n"
+      "Cache-Control: max-age=0\r\n"
+      "Upgrade-Insecure-Requests: 1\r\n"
+      "User-Agent: Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like "
+      "Gecko) Chrome/64.0.3282.186 Safari/537.36\r\n"
+      "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/webp,image/apng,*/*;"
+      "q=0.8\r\n"
+      "Referer: https://www.example.com/products/category\r\n"
+      "Accept-Encoding: gzip, deflate, br\r\n"
+      "Accept-Language: en-US,en;q=0.9,de;q=0.8\r\n"
+      "Cookie: _ga=GA1.2.1234567890.1519862400; _gid=GA1.2.987654321.1520035200; "
+      "session=eyJhbGciOiJIUzI1NiIsInR5cCI6IkpXVCJ9.eyJzdWIiOiIxMjM0NTY3ODkwIiwibmFtZSI6IkpvaG4"
+      "gRG9lIiwiaWF0IjoxNTE2MjM5MDIyfQ.SflKxwRJSMeKKF2QT4fwpMeJf36POk6yJV_adQssw5c; "
+      "prefs=lang%3Den%26currency%3DUSD%26theme%3Ddark\r\n"
+      "X-Forwarded-For: 203.0.113.195, 70.41.3.18, 150.172.238.178\r\n"
+      "X-Forwarded-Proto: https\r\n"
+      "X-Request-Id: a4e9f7c2-3f44-4d31-9b9d-5f8c1e0b6a21\r\n"
+      "DNT: 1\r\n"
+      "\r\n");
+  return *request;
+}
+
+static void Http1ServerCodecSimpleRequest(benchmark::State& state) {
+  Http1ServerCodecPerf perf;
+  perf.exchange(state, "GET / HTTP/1.1\r\nhost: www.example.com\r\n\r\n");
+}
+BENCHMARK(Http1ServerCodecSimpleRequest);
+
+static void Http1ServerCodecTypicalRequest(benchmark::State& state) {
+  Http1ServerCodecPerf perf;
+  perf.exchange(state, "GET /some/path?query=value HTTP/1.1\r\n"
+                       "host: www.example.com\r\n"
+                       "user-agent: Mozilla/5.0 (X11; Linux x86_64) Gecko/20100101 Firefox/57.0\r\n"
+                       "accept: text/html,application/xhtml+xml,application/xml;q=0.9\r\n"
+                       "accept-language: en-US,en;q=0.5\r\n"
+                       "accept-encoding: gzip, deflate, br\r\n"
+                       "cookie: session=0123456789abcdef0123456789abcdef\r\n"
+                       "x-forwarded-for: 10.0.0.1\r\n"
+                       "x-request-id: a4e9f7c2-3f44-4d31-9b9d-5f8c1e0b6a21\r\n"
+                       "\r\n");
+}
+BENCHMARK(Http1ServerCodecTypicalRequest);
+
+static void Http1ServerCodecPostRequest(benchmark::State& state) {
+  Http1ServerCodecPerf perf;
+  perf.exchange(state, "POST /upload HTTP/1.1\r\nhost: www.example.com\r\n"
+                       "content-length: 1024\r\n\r\n" +
+                           std::string(1024, 'a'));
+}
+BENCHMARK(Http1ServerCodecPostRequest);
+
+static void Http1ServerCodecBrowserRequest(benchmark::State& state) {
+  Http1ServerCodecPerf perf;
+  perf.exchange(state, browserRequest());
+}
+BENCHMARK(Http1ServerCodecBrowserRequest);
+
+static void Http1ServerCodecFragmentedBrowserRequest(benchmark::State& state) {
+  // Split inside the request line, a header name and a header value.
+  const std::string& request = browserRequest();
+  const size_t splits[] = {20, 250, 600};
+  std::vector<std::string> fragments;
+  size_t start = 0;
+  for (size_t split : splits) {
+    fragments.push_back(request.substr(start, split - start));
+    start = split;
+  }
+  fragments.push_back(request.substr(start));
+
+  Http1ServerCodecPerf perf;
+  perf.exchange(state, fragments);
+}
+BENCHMARK(Http1ServerCodecFragmentedBrowserRequest);
+
+static void Http1ClientCodecTypicalResponse(benchmark::State& state) {
+  Http1ClientCodecPerf perf;
+  perf.exchange(state, "HTTP/1.1 200 OK\r\n"
+                       "Date: Thu, 01 Mar 2018 12:00:00 GMT\r\n"
+                       "Content-Type: text/html; charset=utf-8\r\n"
+                       "Content-Length: 0\r\n"
+                       "Cache-Control: private, max-age=0\r\n"
+                       "Set-Cookie: session=0123456789abcdef0123456789abcdef; Path=/; Secure\r\n"
+                       "Strict-Transport-Security: max-age=31536000\r\n"
+                       "Vary: Accept-Encoding\r\n"
+                       "X-Content-Type-Options: nosniff\r\n"
+                       "\r\n");
+}
+BENCHMARK(Http1ClientCodecTypicalResponse);
+
+} // namespace Http1
+} // namespace Http
+} // namespace Envoy
@@ -1,4 +1,5 @@
 #include <string>
+#include <vector>
 
 #include "envoy/buffer/buffer.h"
 #include "envoy/event/dispatcher.h"
@@ -282,6 +283,32 @@ TEST_F(Http1ServerConnectionImplTest, HostHeaderTranslation) {
   EXPECT_EQ(0U, buffer.length());
 }
 
+TEST_F(Http1ServerConnectionImplTest, HeadersSplitAcrossDispatches) {
+  initialize();
+
+  InSequence sequence;
+
+  Http::MockStreamDecoder decoder;
+  EXPECT_CALL(callbacks_, newStream(_)).WillOnce(ReturnRef(decoder));
+
+  // The second host header is dropped, as the first one is kept for inline headers.
+  TestHeaderMapImpl expected_headers{{":authority", "hello"},
+                                     {"x-custom", "some value"},
+                                     {"x-empty", ""},
+                                     {":path", "/"},
+                                     {":method", "GET"}};
+  EXPECT_CALL(decoder, decodeHeaders_(HeaderMapEqual(&expected_headers), true)).Times(1);
+
+  const std::vector<std::string> fragments{"GET / HTTP/1.1\r\nHo", "st: hel", "lo\r\nX-Cus",
+                                           "tom: some ", "value\r\nx-empty:",
+                                           "\r\nhost: other\r\n\r\n"};
+  for (const std::string& fragment : fragments) {
+    Buffer::OwnedImpl buffer(fragment);
+    codec_->dispatch(buffer);
+    EXPECT_EQ(0U, buffer.length());
+  }
+}
+
 TEST_F(Http1ServerConnectionImplTest, CloseDuringHeadersComplete) {
   initialize();
 
@@ -374,6 +401,66 @@ TEST_F(Http1ServerConnectionImplTest, ChunkedResponse) {
             output);
 }
 
+TEST_F(Http1ServerConnectionImplTest, LargeChunkedResponse) {
+  initialize();
+
+  NiceMock<Http::MockStreamDecoder> decoder;
+  Http::StreamEncoder* response_encoder = nullptr;
+  EXPECT_CALL(callbacks_, newStream(_))
+      .WillOnce(Invoke([&](Http::StreamEncoder& encoder) -> Http::StreamDecoder& {
+        response_encoder = &encoder;
+        return decoder;
+      }));
+
+  Buffer::OwnedImpl buffer("GET / HTTP/1.1\r\n\r\n");
+  codec_->dispatch(buffer);
+  EXPECT_EQ(0U, buffer.length());
+
+  std::string output;
+  ON_CALL(connection_, write(_)).WillByDefault(AddBufferToString(&output));
+
+  TestHeaderMapImpl headers{{":status", "200"}};
+  response_encoder->encodeHeaders(headers, false);
+
+  const std::string body(65536 + 10, 'a');
+  Buffer::OwnedImpl data(body);
+  response_encoder->encodeData(data, true);
+  EXPECT_EQ("HTTP/1.1 200 OK\r\ntransfer-encoding: chunked\r\n\r\n1000a\r\n" + body +
+                "\r\n0\r\n\r\n",
+            output);
+}
+
+TEST_F(Http1ServerConnectionImplTest, UncommonStatusResponse) {
+  initialize();
+
+  NiceMock<Http::MockStreamDecoder> decoder;
+  Http::StreamEncoder* response_encoder = nullptr;
+  EXPECT_CALL(callbacks_, newStream(_))
+      .WillRepeatedly(Invoke([&](Http::StreamEncoder& encoder) -> Http::StreamDecoder& {
+        response_encoder = &encoder;
+        return decoder;
+      }));
+
+  std::string output;
+  ON_CALL(connection_, write(_)).WillByDefault(AddBufferToString(&output));
+
+  // Codes with and without a reason phrase, and one beyond the range of precomputed status lines.
+  const std::vector<std::pair<std::string, std::string>> statuses{
+      {"100", "HTTP/1.1 100 Continue\r\n"},
+      {"599", "HTTP/1.1 599 Unknown\r\n"},
+      {"1000", "HTTP/1.1 1000 Unknown\r\n"}};
+  for (const auto& status : statuses) {
+    Buffer::OwnedImpl buffer("GET / HTTP/1.1\r\n\r\n");
+    codec_->dispatch(buffer);
+    EXPECT_EQ(0U, buffer.length());
+
+    output.clear();
+    TestHeaderMapImpl headers{{":status", status.first}};
+    response_encoder->encodeHeaders(headers, true);
+    EXPECT_EQ(status.second + "content-length: 0\r\n\r\n", output);
+  }
+}
+
 TEST_F(Http1ServerConnectionImplTest, ContentLengthResponse) {
   initialize();
 
@@ -473,6 +560,64 @@ TEST_F(Http1ServerConnectionImplTest, DoubleRequest) {
   EXPECT_EQ(0U, buffer.length());
 }
 
+TEST_F(Http1ServerConnectionImplTest, PipelinedRequestsAnsweredWhileDecoding) {
+  initialize();
+
+  NiceMock<Http::MockStreamDecoder> decoder;
+  Http::StreamEncoder* response_encoder = nullptr;
+  EXPECT_CALL(callbacks_, newStream(_))
+      .Times(3)
+      .WillRepeatedly(Invoke([&](Http::StreamEncoder& encoder) -> Http::StreamDecoder& {
+        response_encoder = &encoder;
+        return decoder;
+      }));
+  EXPECT_CALL(decoder, decodeHeaders_(_, true))
+      .Times(3)
+      .WillRepeatedly(Invoke([&](HeaderMapPtr&, bool) -> void {
+        response_encoder->encodeHeaders(TestHeaderMapImpl{{":status", "200"}}, true);
+      }));
+
+  // All of the buffered requests are decoded in one dispatch and their responses are written
+  // together.
+  std::string output;
+  EXPECT_CALL(connection_, write(_)).WillOnce(AddBufferToString(&output));
+
+  std::string request("GET / HTTP/1.1\r\n\r\n");
+  Buffer::OwnedImpl buffer(request + request + request);
+  codec_->dispatch(buffer);
+  EXPECT_EQ(0U, buffer.length());
+
+  std::string response("HTTP/1.1 200 OK\r\ncontent-length: 0\r\n\r\n");
+  EXPECT_EQ(response + response + response, output);
+}
+
+TEST_F(Http1ServerConnectionImplTest, PipelinedRequestAfterConnectionClose) {
+  initialize();
+
+  NiceMock<Http::MockStreamDecoder> decoder;
+  Http::StreamEncoder* response_encoder = nullptr;
+  EXPECT_CALL(callbacks_, newStream(_))
+      .WillOnce(Invoke([&](Http::StreamEncoder& encoder) -> Http::StreamDecoder& {
+        response_encoder = &encoder;
+        return decoder;
+      }));
+  EXPECT_CALL(decoder, decodeHeaders_(_, true)).WillOnce(Invoke([&](HeaderMapPtr&, bool) -> void {
+    response_encoder->encodeHeaders(
+        TestHeaderMapImpl{{":status", "200"}, {"connection", "close"}}, true);
+  }));
+
+  std::string output;
+  ON_CALL(connection_, write(_)).WillByDefault(AddBufferToString(&output));
+
+  // The request that follows a response which closes the connection is left in the buffer.
+  std::string request("GET / HTTP/1.1\r\n\r\n");
+  Buffer::OwnedImpl buffer(request + request);
+  codec_->dispatch(buffer);
+  EXPECT_EQ(request.size(), buffer.length());
+  EXPECT_FALSE(codec_->wantsToWrite());
+  EXPECT_EQ("HTTP/1.1 200 OK\r\nconnection: close\r\ncontent-length: 0\r\n\r\n", output);
+}
+
 TEST_F(Http1ServerConnectionImplTest, RequestWithTrailers) {
   initialize();
 
@@ -262,6 +262,62 @@ TEST_F(Http1ConnPoolImplTest, MultipleRequestAndResponse) {
   dispatcher_.clearDeferredDeleteList();
 }
 
+/**
+ * Test that spare connections are opened ahead of demand, up to the connection limit.
+ */
+TEST_F(Http1ConnPoolImplTest, PreconnectSpareConnections) {
+  cluster_->resource_manager_.reset(
+      new Upstream::ResourceManagerImpl(runtime_, "fake_key", 2, 1024, 1024, 1));
+  ON_CALL(*cluster_, preconnectPercent()).WillByDefault(Return(100));
+  InSequence s;
+
+  // Request 1 kicks off its own connection and a spare one.
+  conn_pool_.expectClientCreate();
+  ActiveTestRequest r1(*this, 0, ActiveTestRequest::Type::CreateConnection);
+  r1.startRequest();
+  EXPECT_CALL(*conn_pool_.test_clients_[1].connect_timer_, disableTimer());
+  conn_pool_.test_clients_[1].connection_->raiseEvent(Network::ConnectionEvent::Connected);
+
+  // Request 2 uses the spare connection. No more are opened at the connection limit.
+  ActiveTestRequest r2(*this, 1, ActiveTestRequest::Type::Immediate);
+  r2.startRequest();
+  EXPECT_EQ(1U, cluster_->stats_.upstream_cx_preconnect_total_.value());
+  EXPECT_EQ(0U, cluster_->stats_.upstream_cx_overflow_.value());
+
+  r1.completeResponse(false);
+  r2.completeResponse(false);
+
+  conn_pool_.closeConnections();
+  EXPECT_CALL(conn_pool_, onClientDestroy()).Times(2);
+  dispatcher_.clearDeferredDeleteList();
+}
+
+/**
+ * Test that a connection that sits idle in the ready list is closed.
+ */
+TEST_F(Http1ConnPoolImplTest, IdleTimeout) {
+  ON_CALL(*cluster_, idleTimeout()).WillByDefault(Return(std::chrono::milliseconds(1000)));
+  InSequence s;
+
+  ActiveTestRequest r1(*this, 0, ActiveTestRequest::Type::CreateConnection);
+  r1.startRequest();
+  Event::MockTimer* idle_timer = new Event::MockTimer(&dispatcher_);
+  EXPECT_CALL(*idle_timer, enableTimer(std::chrono::milliseconds(1000)));
+  r1.completeResponse(false);
+
+  // Reusing the connection stops the timer, and it is started again once the connection is idle.
+  EXPECT_CALL(*idle_timer, disableTimer());
+  ActiveTestRequest r2(*this, 0, ActiveTestRequest::Type::Immediate);
+  r2.startRequest();
+  EXPECT_CALL(*idle_timer, enableTimer(std::chrono::milliseconds(1000)));
+  r2.completeResponse(false);
+
+  EXPECT_CALL(conn_pool_, onClientDestroy());
+  idle_timer->callback_();
+  dispatcher_.clearDeferredDeleteList();
+  EXPECT_EQ(1U, cluster_->stats_.upstream_cx_idle_timeout_.value());
+}
+
 /**
  * Test when we overflow max pending requests.
  */
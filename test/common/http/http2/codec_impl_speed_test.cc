@@ -0,0 +1,114 @@
+#include <string>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/http/header_map_impl.h"
+#include "common/http/http2/codec_impl.h"
+#include "common/stats/stats_impl.h"
+
+#include "test/mocks/http/mocks.h"
+#include "test/mocks/network/mocks.h"
+
+#include "benchmark/benchmark.h"
+#include "gmock/gmock.h"
+
+using testing::Invoke;
+using testing::NiceMock;
+using testing::_;
+
+namespace Envoy {
+namespace Http {
+namespace Http2 {
+
+/**
+ * Connects a client and a server codec back to back and runs request/response exchanges as
+ * streams on a single HTTP/2 connection. This exercises HPACK, framing and stream lifecycle on
+ * both sides.
+ */
+class Http2CodecPerf {
+public:
+  struct ConnectionWrapper {
+    void dispatch(Buffer::Instance& data, ConnectionImpl& connection) {
+      buffer_.move(data);
+      if (!dispatching_) {
+        while (buffer_.length() > 0) {
+          dispatching_ = true;
+          connection.dispatch(buffer_);
+          dispatching_ = false;
+        }
+      }
+    }
+
+    bool dispatching_{};
+    Buffer::OwnedImpl buffer_;
+  };
+
+  Http2CodecPerf()
+      : client_(client_connection_, client_callbacks_, stats_store_, Http2Settings()),
+        server_(server_connection_, server_callbacks_, stats_store_, Http2Settings()) {
+    ON_CALL(client_connection_, write(_)).WillByDefault(Invoke([this](Buffer::Instance& data) {
+      server_wrapper_.dispatch(data, server_);
+    }));
+    ON_CALL(server_connection_, write(_)).WillByDefault(Invoke([this](Buffer::Instance& data) {
+      client_wrapper_.dispatch(data, client_);
+    }));
+    ON_CALL(server_callbacks_, newStream(_))
+        .WillByDefault(Invoke([this](StreamEncoder& encoder) -> StreamDecoder& {
+          response_encoder_ = &encoder;
+          return request_decoder_;
+        }));
+  }
+
+  void exchange(benchmark::State& state, uint64_t body_size) {
+    HeaderMapImpl request_headers{{Headers::get().Method, "GET"},
+                                  {Headers::get().Path, "/some/path?query=value"},
+                                  {Headers::get().Host, "www.example.com"},
+                                  {Headers::get().Scheme, "https"},
+                                  {Headers::get().UserAgent, "curl/7.54.0"}};
+    HeaderMapImpl response_headers{{Headers::get().Status, "200"}};
+    const std::string body(body_size, 'a');
+    while (state.KeepRunning()) {
+      StreamEncoder& request_encoder = client_.newStream(response_decoder_);
+      request_encoder.encodeHeaders(request_headers, true);
+      if (body_size > 0) {
+        response_encoder_->encodeHeaders(response_headers, false);
+        Buffer::OwnedImpl data(body);
+        response_encoder_->encodeData(data, true);
+      } else {
+        response_encoder_->encodeHeaders(response_headers, true);
+      }
+      // Completed streams are deferred deleted; release them as the event loop would.
+      client_connection_.dispatcher_.clearDeferredDeleteList();
+      server_connection_.dispatcher_.clearDeferredDeleteList();
+    }
+  }
+
+private:
+  Stats::IsolatedStoreImpl stats_store_;
+  NiceMock<Network::MockConnection> client_connection_;
+  NiceMock<MockConnectionCallbacks> client_callbacks_;
+  ClientConnectionImpl client_;
+  ConnectionWrapper client_wrapper_;
+  NiceMock<Network::MockConnection> server_connection_;
+  NiceMock<MockServerConnectionCallbacks> server_callbacks_;
+  ServerConnectionImpl server_;
+  ConnectionWrapper server_wrapper_;
+  NiceMock<MockStreamDecoder> request_decoder_;
+  NiceMock<MockStreamDecoder> response_decoder_;
+  StreamEncoder* response_encoder_{};
+};
+
+static void Http2CodecHeaderOnlyExchange(benchmark::State& state) {
+  Http2CodecPerf perf;
+  perf.exchange(state, 0);
+}
+BENCHMARK(Http2CodecHeaderOnlyExchange);
+
+static void Http2CodecExchangeWithBody(benchmark::State& state) {
+  Http2CodecPerf perf;
+  perf.exchange(state, state.range(0));
+}
+BENCHMARK(Http2CodecExchangeWithBody)->Arg(1024)->Arg(16384);
+
+} // namespace Http2
+} // namespace Http
+} // namespace Envoy
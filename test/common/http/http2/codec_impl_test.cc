@@ -65,8 +65,8 @@ public:
 class Http2CodecImplTest : public testing::TestWithParam<Http2SettingsTestParam> {
 public:
   struct ConnectionWrapper {
-    void dispatch(const Buffer::Instance& data, ConnectionImpl& connection) {
-      buffer_.add(data);
+    void dispatch(Buffer::Instance& data, ConnectionImpl& connection) {
+      buffer_.move(data);
       if (!dispatching_) {
         while (buffer_.length() > 0) {
           dispatching_ = true;
@@ -209,10 +209,11 @@ TEST_P(Http2CodecImplTest, InvalidFrame) {
   initialize();
 
   ON_CALL(client_connection_, write(_)).WillByDefault(Invoke([&](Buffer::Instance& data) -> void {
-    server_wrapper_.buffer_.add(data);
+    server_wrapper_.buffer_.move(data);
   }));
   request_encoder_->encodeHeaders(TestHeaderMapImpl{}, true);
-  EXPECT_THROW(server_wrapper_.dispatch(Buffer::OwnedImpl(), server_), CodecProtocolException);
+  Buffer::OwnedImpl empty;
+  EXPECT_THROW(server_wrapper_.dispatch(empty, server_), CodecProtocolException);
 }
 
 TEST_P(Http2CodecImplTest, TrailingHeaders) {
@@ -238,12 +239,52 @@ TEST_P(Http2CodecImplTest, TrailingHeaders) {
   response_encoder_->encodeTrailers(TestHeaderMapImpl{{"trailing", "header"}});
 }
 
+TEST_P(Http2CodecImplTest, ResponseEncodedDuringDispatch) {
+  initialize();
+
+  TestHeaderMapImpl request_headers;
+  HttpTestUtility::addDefaultHeaders(request_headers);
+  EXPECT_CALL(request_decoder_, decodeHeaders_(_, true))
+      .WillOnce(Invoke([&](HeaderMapPtr&, bool) -> void {
+        // The server is dispatching, so the response is only serialized once dispatch is done.
+        // By then the map is gone, and its storage has been reused with other contents.
+        TestHeaderMapImpl response_headers{{":status", "200"}, {"x-custom", "some value"}};
+        response_encoder_->encodeHeaders(response_headers, true);
+        response_headers.remove(LowerCaseString("x-custom"));
+        response_headers.addCopy("x-other", "clobbered!");
+      }));
+
+  TestHeaderMapImpl expected_headers{{":status", "200"}, {"x-custom", "some value"}};
+  EXPECT_CALL(response_decoder_, decodeHeaders_(HeaderMapEqual(&expected_headers), true));
+  request_encoder_->encodeHeaders(request_headers, true);
+}
+
+TEST_P(Http2CodecImplTest, FramesWrittenTogether) {
+  initialize();
+
+  TestHeaderMapImpl request_headers;
+  HttpTestUtility::addDefaultHeaders(request_headers);
+  EXPECT_CALL(request_decoder_, decodeHeaders_(_, false));
+  request_encoder_->encodeHeaders(request_headers, false);
+
+  // The body is split into several DATA frames, which all fit in the initial windows and are
+  // written to the connection at once.
+  EXPECT_CALL(client_connection_, write(_)).WillOnce(Invoke([&](Buffer::Instance& data) -> void {
+    EXPECT_LT(48U * 1024, data.length());
+    server_wrapper_.dispatch(data, server_);
+  }));
+  EXPECT_CALL(request_decoder_, decodeData(_, false)).Times(AtLeast(1));
+  EXPECT_CALL(request_decoder_, decodeData(_, true));
+  Buffer::OwnedImpl body(std::string(48 * 1024, 'a'));
+  request_encoder_->encodeData(body, true);
+}
+
 TEST_P(Http2CodecImplTest, TrailingHeadersLargeBody) {
   initialize();
 
   // Buffer server data so we can make sure we don't get any window updates.
   ON_CALL(client_connection_, write(_)).WillByDefault(Invoke([&](Buffer::Instance& data) -> void {
-    server_wrapper_.buffer_.add(data);
+    server_wrapper_.buffer_.move(data);
   }));
 
   TestHeaderMapImpl request_headers;
@@ -258,7 +299,8 @@ TEST_P(Http2CodecImplTest, TrailingHeadersLargeBody) {
 
   // Flush pending data.
   setupDefaultConnectionMocks();
-  server_wrapper_.dispatch(Buffer::OwnedImpl(), server_);
+  Buffer::OwnedImpl empty;
+  server_wrapper_.dispatch(empty, server_);
 
   TestHeaderMapImpl response_headers{{":status", "200"}};
   EXPECT_CALL(response_decoder_, decodeHeaders_(_, false));
@@ -284,7 +326,7 @@ TEST_P(Http2CodecImplDeferredResetTest, DeferredResetClient) {
   // deferred reset, followed by a pending frames flush which will cause the stream to actually
   // be reset immediately since we are outside of dispatch context.
   ON_CALL(client_connection_, write(_)).WillByDefault(Invoke([&](Buffer::Instance& data) -> void {
-    server_wrapper_.buffer_.add(data);
+    server_wrapper_.buffer_.move(data);
   }));
   TestHeaderMapImpl request_headers;
   HttpTestUtility::addDefaultHeaders(request_headers);
@@ -308,7 +350,8 @@ TEST_P(Http2CodecImplDeferredResetTest, DeferredResetClient) {
   EXPECT_CALL(server_stream_callbacks_, onResetStream(StreamResetReason::RemoteReset));
 
   setupDefaultConnectionMocks();
-  server_wrapper_.dispatch(Buffer::OwnedImpl(), server_);
+  Buffer::OwnedImpl empty;
+  server_wrapper_.dispatch(empty, server_);
 }
 
 TEST_P(Http2CodecImplDeferredResetTest, DeferredResetServer) {
@@ -323,7 +366,7 @@ TEST_P(Http2CodecImplDeferredResetTest, DeferredResetServer) {
 
   // In this case we do the same thing as DeferredResetClient but on the server side.
   ON_CALL(server_connection_, write(_)).WillByDefault(Invoke([&](Buffer::Instance& data) -> void {
-    client_wrapper_.buffer_.add(data);
+    client_wrapper_.buffer_.move(data);
   }));
   TestHeaderMapImpl response_headers{{":status", "200"}};
   response_encoder_->encodeHeaders(response_headers, false);
@@ -339,7 +382,8 @@ TEST_P(Http2CodecImplDeferredResetTest, DeferredResetServer) {
   EXPECT_CALL(response_decoder_, decodeData(_, false)).Times(AtLeast(1));
   EXPECT_CALL(client_stream_callbacks, onResetStream(StreamResetReason::RemoteReset));
   setupDefaultConnectionMocks();
-  client_wrapper_.dispatch(Buffer::OwnedImpl(), client_);
+  Buffer::OwnedImpl empty;
+  client_wrapper_.dispatch(empty, client_);
 }
 
 class Http2CodecImplFlowControlTest : public Http2CodecImplTest {};
@@ -614,6 +658,72 @@ INSTANTIATE_TEST_CASE_P(Http2CodecImplTestDefaultSettings, Http2CodecImplTest,
 INSTANTIATE_TEST_CASE_P(Http2CodecImplTestEdgeSettings, Http2CodecImplTest,
                         ::testing::Combine(HTTP2SETTINGS_EDGE_COMBINE, HTTP2SETTINGS_EDGE_COMBINE));
 
+class Http2CodecImplWindowAutoTuningTest : public testing::Test {
+public:
+  static Http2Settings smallWindowSettings(bool window_auto_tuning) {
+    Http2Settings settings;
+    settings.initial_stream_window_size_ = Http2Settings::MIN_INITIAL_STREAM_WINDOW_SIZE;
+    settings.initial_connection_window_size_ = Http2Settings::MIN_INITIAL_CONNECTION_WINDOW_SIZE;
+    settings.window_auto_tuning_ = window_auto_tuning;
+    return settings;
+  }
+
+  Http2CodecImplWindowAutoTuningTest()
+      : client_(client_connection_, client_callbacks_, stats_store_, smallWindowSettings(true)),
+        server_(server_connection_, server_callbacks_, stats_store_, smallWindowSettings(false)) {
+    ON_CALL(client_connection_, write(_)).WillByDefault(Invoke([&](Buffer::Instance& data) -> void {
+      server_wrapper_.dispatch(data, server_);
+    }));
+    ON_CALL(server_connection_, write(_)).WillByDefault(Invoke([&](Buffer::Instance& data) -> void {
+      client_wrapper_.dispatch(data, client_);
+    }));
+  }
+
+  Stats::IsolatedStoreImpl stats_store_;
+  NiceMock<Network::MockConnection> client_connection_;
+  MockConnectionCallbacks client_callbacks_;
+  TestClientConnectionImpl client_;
+  Http2CodecImplTest::ConnectionWrapper client_wrapper_;
+  NiceMock<Network::MockConnection> server_connection_;
+  MockServerConnectionCallbacks server_callbacks_;
+  TestServerConnectionImpl server_;
+  Http2CodecImplTest::ConnectionWrapper server_wrapper_;
+  MockStreamDecoder response_decoder_;
+  MockStreamDecoder request_decoder_;
+  StreamEncoder* response_encoder_{};
+};
+
+// A response that fills the window within one round trip grows the client's receive windows.
+TEST_F(Http2CodecImplWindowAutoTuningTest, GrowWindowWhenRoundTripFillsIt) {
+  StreamEncoder& request_encoder = client_.newStream(response_decoder_);
+  EXPECT_CALL(server_callbacks_, newStream(_))
+      .WillOnce(Invoke([&](StreamEncoder& encoder) -> StreamDecoder& {
+        response_encoder_ = &encoder;
+        return request_decoder_;
+      }));
+
+  TestHeaderMapImpl request_headers;
+  HttpTestUtility::addDefaultHeaders(request_headers);
+  EXPECT_CALL(request_decoder_, decodeHeaders_(_, true));
+  request_encoder.encodeHeaders(request_headers, true);
+
+  TestHeaderMapImpl response_headers{{":status", "200"}};
+  EXPECT_CALL(response_decoder_, decodeHeaders_(_, false));
+  response_encoder_->encodeHeaders(response_headers, false);
+
+  EXPECT_CALL(response_decoder_, decodeData(_, false)).Times(AtLeast(1));
+  EXPECT_CALL(response_decoder_, decodeData(_, true));
+  Buffer::OwnedImpl body(std::string(Http2Settings::MIN_INITIAL_STREAM_WINDOW_SIZE, 'a'));
+  response_encoder_->encodeData(body, true);
+
+  // All but the first DATA frame arrived after the PING was sent, so the window grows to twice
+  // that. The server has acknowledged the new SETTINGS by now.
+  const uint32_t window = 2 * (Http2Settings::MIN_INITIAL_STREAM_WINDOW_SIZE - 16384);
+  EXPECT_EQ(1U, stats_store_.counter("http2.window_auto_tuned").value());
+  EXPECT_EQ(window, nghttp2_session_get_local_settings(client_.session(),
+                                                       NGHTTP2_SETTINGS_INITIAL_WINDOW_SIZE));
+}
+
 TEST(Http2CodecUtility, reconstituteCrumbledCookies) {
   {
     HeaderString key;
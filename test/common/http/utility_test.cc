@@ -173,6 +173,15 @@ TEST(HttpUtility, OneAddressInXFF) {
   EXPECT_EQ(first_address, Utility::getLastAddressFromXFF(request_headers));
 }
 
+// Addresses are separated by ", " only, and empty addresses at the end are skipped.
+TEST(HttpUtility, XFFSeparators) {
+  EXPECT_EQ("1.0.0.1,2.0.0.2", Utility::getLastAddressFromXFF(
+                                   TestHeaderMapImpl{{"x-forwarded-for", "1.0.0.1,2.0.0.2"}}));
+  EXPECT_EQ("2.0.0.2", Utility::getLastAddressFromXFF(
+                           TestHeaderMapImpl{{"x-forwarded-for", "1.0.0.1, 2.0.0.2, , "}}));
+  EXPECT_EQ("", Utility::getLastAddressFromXFF(TestHeaderMapImpl{{"x-forwarded-for", ", "}}));
+}
+
 TEST(HttpUtility, TestParseCookie) {
   TestHeaderMapImpl headers{
       {"someheader", "10.0.0.1"},
@@ -289,6 +289,11 @@ TEST(JsonLoaderTest, Schema) {
     EXPECT_THROW(json->validateSchema(invalid_schema), Exception);
     EXPECT_THROW(json->validateSchema(different_schema), Exception);
     EXPECT_NO_THROW(json->validateSchema(valid_schema));
+
+    // Compiled schemas are cached, and invalid ones are rejected every time.
+    EXPECT_THROW(json->validateSchema(invalid_json_schema), std::invalid_argument);
+    EXPECT_THROW(json->validateSchema(different_schema), Exception);
+    EXPECT_NO_THROW(json->validateSchema(valid_schema));
   }
 
   {
@@ -445,5 +450,21 @@ TEST(JsonLoaderTest, YamlObject) {
   }
 }
 
+TEST(JsonLoaderTest, YamlAsJsonString) {
+  EXPECT_EQ(R"EOF({"a":[true,"true",1,"1",1.5,null],"b":{"c":"d"}})EOF",
+            Factory::yamlAsJsonString(R"EOF(
+a: [true, "true", 1, "1", 1.5, ~]
+b:
+  c: d
+)EOF"));
+  EXPECT_EQ("\"foo\"", Factory::yamlAsJsonString("foo"));
+  EXPECT_THROW(Factory::yamlAsJsonString("{"), EnvoyException);
+}
+
+TEST(JsonLoaderTest, AsJsonStringScalar) {
+  EXPECT_EQ("\"foo\"", Factory::loadFromYamlString("foo")->asJsonString());
+  EXPECT_EQ("1", Factory::loadFromYamlString("1")->asJsonString());
+}
+
 } // namespace Json
 } // namespace Envoy
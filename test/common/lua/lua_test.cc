@@ -76,6 +76,52 @@ TEST_F(LuaTest, CoroutineRefCounting) {
   lua_gc(cr2->luaState(), LUA_GCCOLLECT, 0);
 }
 
+// Coroutines that finished without error are reused, others are not.
+TEST_F(LuaTest, CoroutineReuse) {
+  const std::string SCRIPT{R"EOF(
+    function callMe()
+    end
+
+    function fail()
+      error("failed")
+    end
+
+    function yieldMe()
+      coroutine.yield()
+    end
+  )EOF"};
+
+  setup(SCRIPT);
+  EXPECT_NE(LUA_REFNIL, state_->getGlobalRef(state_->registerGlobal("callMe")));
+  EXPECT_NE(LUA_REFNIL, state_->getGlobalRef(state_->registerGlobal("fail")));
+  EXPECT_NE(LUA_REFNIL, state_->getGlobalRef(state_->registerGlobal("yieldMe")));
+
+  CoroutinePtr cr(state_->createCoroutine());
+  lua_State* finished_state = cr->luaState();
+  cr->start(state_->getGlobalRef(0), 0, yield_callback_);
+  EXPECT_EQ(cr->state(), Coroutine::State::Finished);
+  cr.reset();
+
+  cr = state_->createCoroutine();
+  EXPECT_EQ(finished_state, cr->luaState());
+  EXPECT_EQ(0, lua_gettop(cr->luaState()));
+  EXPECT_THROW_WITH_MESSAGE(cr->start(state_->getGlobalRef(1), 0, yield_callback_), LuaException,
+                            "[string \"...\"]:6: failed");
+  cr.reset();
+
+  // Neither the failed nor the yielded coroutine can be started again, so they are dropped.
+  cr = state_->createCoroutine();
+  EXPECT_CALL(on_yield_, ready());
+  cr->start(state_->getGlobalRef(2), 0, yield_callback_);
+  EXPECT_EQ(cr->state(), Coroutine::State::Yielded);
+  cr.reset();
+
+  cr = state_->createCoroutine();
+  EXPECT_EQ(0, lua_gettop(cr->luaState()));
+  cr->start(state_->getGlobalRef(0), 0, yield_callback_);
+  EXPECT_EQ(cr->state(), Coroutine::State::Finished);
+}
+
 // Basic yield/resume functionality.
 TEST_F(LuaTest, YieldAndResume) {
   const std::string SCRIPT{R"EOF(
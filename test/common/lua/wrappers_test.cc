@@ -28,6 +28,30 @@ TEST_F(LuaBufferWrapperTest, Methods) {
   start("callMe");
 }
 
+// Reading the slices of a buffer in place through LuaJIT FFI, and bytes that span slices.
+TEST_F(LuaBufferWrapperTest, RawSlices) {
+  const std::string SCRIPT{R"EOF(
+    function callMe(object)
+      local ffi = require("ffi")
+      for pointer, length in object:rawSlices() do
+        testPrint(ffi.string(ffi.cast("const char*", pointer), length))
+      end
+      testPrint(object:getBytes(3, 4))
+    end
+  )EOF"};
+
+  setup(SCRIPT);
+  Buffer::OwnedImpl data("hello");
+  Buffer::OwnedImpl world("world");
+  data.move(world);
+  ASSERT_EQ(2UL, data.getRawSlices(nullptr, 0));
+  BufferWrapper::create(coroutine_->luaState(), data);
+  EXPECT_CALL(*this, testPrint("hello"));
+  EXPECT_CALL(*this, testPrint("world"));
+  EXPECT_CALL(*this, testPrint("lowo"));
+  start("callMe");
+}
+
 // Invalid params for the buffer wrapper getBytes() call.
 TEST_F(LuaBufferWrapperTest, GetBytesInvalidParams) {
   const std::string SCRIPT{R"EOF(
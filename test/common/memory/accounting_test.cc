@@ -0,0 +1,36 @@
+#include <memory>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/memory/accounting.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Memory {
+
+TEST(AccountingTest, AccountedBytes) {
+  const uint64_t hosts = Accounting::bytes(Category::Hosts);
+  const uint64_t stats = Accounting::bytes(Category::Stats);
+  {
+    AccountedBytes first(Category::Hosts, 100);
+    EXPECT_EQ(hosts + 100, Accounting::bytes(Category::Hosts));
+    std::unique_ptr<AccountedBytes> second(new AccountedBytes(Category::Hosts, 20));
+    EXPECT_EQ(hosts + 120, Accounting::bytes(Category::Hosts));
+    second.reset();
+    EXPECT_EQ(hosts + 100, Accounting::bytes(Category::Hosts));
+    EXPECT_EQ(stats, Accounting::bytes(Category::Stats));
+  }
+  EXPECT_EQ(hosts, Accounting::bytes(Category::Hosts));
+}
+
+TEST(AccountingTest, BufferSlices) {
+  const uint64_t buffers = Accounting::bytes(Category::Buffers);
+  {
+    Buffer::SlicePtr slice = Buffer::Slice::create(2 * Buffer::Slice::DefaultSize);
+    EXPECT_EQ(buffers + slice->capacity(), Accounting::bytes(Category::Buffers));
+  }
+  EXPECT_EQ(buffers, Accounting::bytes(Category::Buffers));
+}
+
+} // namespace Memory
+} // namespace Envoy
@@ -48,6 +48,45 @@ TEST(BsonImplTest, InvalodDocumentTermination) {
   EXPECT_THROW(DocumentImpl::create(buffer), EnvoyException);
 }
 
+TEST(BsonImplTest, InvalidEmbeddedDocument) {
+  Buffer::OwnedImpl buffer;
+  DocumentImpl::create()
+      ->addString("hello", "world")
+      ->addDocument("embedded", DocumentImpl::create()->addInt32("number", 1))
+      ->encode(buffer);
+
+  // Embedded documents are validated when the document that contains them is created.
+  std::string data = buffer.toString();
+  data[data.find("number") - 1] = 0x20;
+  Buffer::OwnedImpl invalid_buffer(data);
+  EXPECT_THROW(DocumentImpl::create(invalid_buffer), EnvoyException);
+}
+
+TEST(BsonImplTest, LazyDecode) {
+  DocumentSharedPtr doc = DocumentImpl::create()
+                              ->addString("hello", "world")
+                              ->addDocument("embedded", DocumentImpl::create()->addInt32("a", 1))
+                              ->addRegex("regex", {"pattern", "options"})
+                              ->addBinary("binary", "\x01\x02");
+  Buffer::OwnedImpl buffer;
+  doc->encode(buffer);
+  const std::string encoded = buffer.toString();
+
+  // Documents that are only measured or passed along are not decoded.
+  DocumentSharedPtr decoded = DocumentImpl::create(buffer);
+  EXPECT_EQ(0UL, buffer.length());
+  EXPECT_EQ(doc->byteSize(), decoded->byteSize());
+  decoded->encode(buffer);
+  EXPECT_EQ(encoded, buffer.toString());
+
+  EXPECT_EQ(1, decoded->find("embedded")->asDocument().find("a")->asInt32());
+  EXPECT_TRUE(*doc == *decoded);
+  EXPECT_EQ(doc->toString(), decoded->toString());
+
+  decoded->addNull("null");
+  EXPECT_EQ(doc->byteSize() + 6, decoded->byteSize());
+}
+
 TEST(BufferHelperTest, InvalidSize) {
   Buffer::OwnedImpl buffer;
   EXPECT_THROW(BufferHelper::peakInt32(buffer), EnvoyException);
@@ -13,12 +13,17 @@
 using testing::Eq;
 using testing::NiceMock;
 using testing::Pointee;
+using testing::Return;
+using testing::_;
 
 namespace Envoy {
 namespace Mongo {
 
 class TestDecoderCallbacks : public DecoderCallbacks {
 public:
+  TestDecoderCallbacks() { ON_CALL(*this, shouldDecode(_, _)).WillByDefault(Return(true)); }
+
+  MOCK_METHOD2(shouldDecode, bool(Message::OpCode op_code, int32_t response_to));
   void decodeGetMore(GetMoreMessagePtr&& message) override { decodeGetMore_(message); }
   void decodeInsert(InsertMessagePtr&& message) override { decodeInsert_(message); }
   void decodeKillCursors(KillCursorsMessagePtr&& message) override { decodeKillCursors_(message); }
@@ -314,6 +319,23 @@ TEST_F(MongoCodecImplTest, InvalidMessage) {
   EXPECT_THROW(decoder_.onData(output_), EnvoyException);
 }
 
+TEST_F(MongoCodecImplTest, SkipMessage) {
+  GetMoreMessageImpl get_more(1, 2);
+  get_more.fullCollectionName("test");
+  get_more.numberToReturn(20);
+  get_more.cursorId(20000);
+  encoder_.encodeGetMore(get_more);
+  encoder_.encodeGetMore(get_more);
+
+  // Skipped messages are drained without being decoded.
+  EXPECT_CALL(callbacks_, shouldDecode(Message::OpCode::OP_GET_MORE, 2))
+      .WillOnce(Return(false))
+      .WillOnce(Return(true));
+  EXPECT_CALL(callbacks_, decodeGetMore_(Pointee(Eq(get_more))));
+  decoder_.onData(output_);
+  EXPECT_EQ(0U, output_.length());
+}
+
 TEST_F(MongoCodecImplTest, QueryToStringWithEscape) {
   QueryMessageImpl query(1, 1);
   query.flags(0x4);
@@ -261,6 +261,47 @@ TEST_F(MongoProxyFilterTest, Stats) {
   EXPECT_EQ(0U, store_.counter("test.delays_injected").value());
 }
 
+TEST_F(MongoProxyFilterTest, DecodeSampling) {
+  initializeFilter();
+  ON_CALL(runtime_.snapshot_, getInteger("mongo.decode_sample_interval", 1))
+      .WillByDefault(Return(3));
+  EXPECT_CALL(*file_, write(_)).Times(AtLeast(1));
+
+  // One in three requests is decoded and charged for three.
+  EXPECT_CALL(*filter_->decoder_, onData(_)).WillOnce(Invoke([&](Buffer::Instance&) -> void {
+    for (int32_t request_id = 1; request_id <= 3; request_id++) {
+      if (filter_->callbacks_->shouldDecode(Message::OpCode::OP_QUERY, 0)) {
+        EXPECT_EQ(3, request_id);
+        QueryMessagePtr message(new QueryMessageImpl(request_id, 0));
+        message->fullCollectionName("db.test");
+        message->query(Bson::DocumentImpl::create());
+        filter_->callbacks_->decodeQuery(std::move(message));
+      }
+    }
+  }));
+  filter_->onData(fake_data_);
+
+  EXPECT_EQ(3U, store_.counter("test.op_query").value());
+  EXPECT_EQ(3U, store_.counter("test.op_query_scatter_get").value());
+  EXPECT_EQ(3U, store_.counter("test.collection.test.query.total").value());
+
+  // Replies are decoded when they answer a decoded query.
+  EXPECT_CALL(*filter_->decoder_, onData(_)).WillOnce(Invoke([&](Buffer::Instance&) -> void {
+    EXPECT_FALSE(filter_->callbacks_->shouldDecode(Message::OpCode::OP_REPLY, 1));
+    EXPECT_TRUE(filter_->callbacks_->shouldDecode(Message::OpCode::OP_REPLY, 3));
+    ReplyMessagePtr message(new ReplyMessageImpl(0, 3));
+    message->cursorId(1);
+    filter_->callbacks_->decodeReply(std::move(message));
+  }));
+  filter_->onWrite(fake_data_);
+
+  EXPECT_EQ(2U, store_.counter("test.op_reply").value());
+  EXPECT_EQ(3U, store_.counter("test.op_reply_valid_cursor").value());
+
+  // Op codes the decoder does not support are left to it.
+  EXPECT_TRUE(filter_->callbacks_->shouldDecode(Message::OpCode::OP_MSG, 0));
+}
+
 TEST_F(MongoProxyFilterTest, CommandStats) {
   initializeFilter();
 
@@ -0,0 +1,132 @@
+#include <chrono>
+#include <list>
+#include <string>
+#include <vector>
+
+#include "common/network/caching_dns_resolver.h"
+#include "common/network/utility.h"
+#include "common/stats/stats_impl.h"
+
+#include "test/mocks/common.h"
+#include "test/mocks/network/mocks.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::DoAll;
+using testing::NiceMock;
+using testing::Return;
+using testing::SaveArg;
+using testing::_;
+
+namespace Envoy {
+namespace Network {
+
+class CachingDnsResolverTest : public testing::Test {
+public:
+  CachingDnsResolverTest()
+      : resolver_(new MockDnsResolver()),
+        caching_resolver_(resolver_, std::chrono::milliseconds(1000), time_source_, store_) {
+    ON_CALL(time_source_, currentTime()).WillByDefault(Return(now_));
+  }
+
+  ActiveDnsQuery* resolve(const std::string& dns_name, std::vector<std::string>& addresses) {
+    return caching_resolver_.resolve(
+        dns_name, DnsLookupFamily::V4Only,
+        [&addresses](std::list<Address::InstanceConstSharedPtr>&& address_list) -> void {
+          addresses.clear();
+          for (const auto& address : address_list) {
+            addresses.push_back(address->ip()->addressAsString());
+          }
+          addresses.push_back("done");
+        });
+  }
+
+  void expectQuery(const std::string& dns_name) {
+    EXPECT_CALL(*resolver_, resolve(dns_name, DnsLookupFamily::V4Only, _))
+        .WillOnce(DoAll(SaveArg<2>(&callback_), Return(&resolver_->active_query_)));
+  }
+
+  uint64_t counter(const std::string& name) {
+    return store_.counter("dns_cache." + name).value();
+  }
+
+  MonotonicTime now_{std::chrono::milliseconds(1000000)};
+  NiceMock<MockMonotonicTimeSource> time_source_;
+  Stats::IsolatedStoreImpl store_;
+  std::shared_ptr<MockDnsResolver> resolver_;
+  CachingDnsResolver caching_resolver_;
+  DnsResolver::ResolveCb callback_;
+};
+
+TEST_F(CachingDnsResolverTest, CoalescesAndCaches) {
+  std::vector<std::string> addresses1;
+  std::vector<std::string> addresses2;
+  expectQuery("foo.com");
+  EXPECT_NE(nullptr, resolve("foo.com", addresses1));
+  EXPECT_NE(nullptr, resolve("foo.com", addresses2));
+  EXPECT_EQ(1UL, counter("miss"));
+  EXPECT_EQ(1UL, counter("coalesced"));
+
+  callback_({Utility::parseInternetAddress("10.0.0.1")});
+  EXPECT_EQ((std::vector<std::string>{"10.0.0.1", "done"}), addresses1);
+  EXPECT_EQ((std::vector<std::string>{"10.0.0.1", "done"}), addresses2);
+  EXPECT_EQ(1UL, store_.gauge("dns_cache.entries").value());
+
+  // Answered from the cache until the TTL passes.
+  std::vector<std::string> addresses3;
+  EXPECT_EQ(nullptr, resolve("foo.com", addresses3));
+  EXPECT_EQ((std::vector<std::string>{"10.0.0.1", "done"}), addresses3);
+  EXPECT_EQ(1UL, counter("hit"));
+
+  ON_CALL(time_source_, currentTime())
+      .WillByDefault(Return(now_ + std::chrono::milliseconds(1000)));
+  expectQuery("foo.com");
+  EXPECT_NE(nullptr, resolve("foo.com", addresses3));
+  EXPECT_EQ(2UL, counter("miss"));
+  EXPECT_EQ(0UL, store_.gauge("dns_cache.entries").value());
+
+  // Failures are not cached.
+  callback_({});
+  EXPECT_EQ((std::vector<std::string>{"done"}), addresses3);
+  expectQuery("foo.com");
+  resolve("foo.com", addresses3);
+  EXPECT_EQ(3UL, counter("miss"));
+}
+
+TEST_F(CachingDnsResolverTest, CancelOneWaiter) {
+  std::vector<std::string> addresses1;
+  std::vector<std::string> addresses2;
+  expectQuery("foo.com");
+  ActiveDnsQuery* query1 = resolve("foo.com", addresses1);
+  resolve("foo.com", addresses2);
+
+  // The query keeps going for the lookups that still wait for it.
+  EXPECT_CALL(resolver_->active_query_, cancel()).Times(0);
+  query1->cancel();
+  callback_({Utility::parseInternetAddress("10.0.0.1")});
+  EXPECT_TRUE(addresses1.empty());
+  EXPECT_EQ((std::vector<std::string>{"10.0.0.1", "done"}), addresses2);
+}
+
+TEST_F(CachingDnsResolverTest, InlineResolution) {
+  EXPECT_CALL(*resolver_, resolve("localhost", DnsLookupFamily::V4Only, _))
+      .WillOnce(testing::Invoke([](const std::string&, DnsLookupFamily,
+                                   DnsResolver::ResolveCb callback) -> ActiveDnsQuery* {
+        callback({Utility::parseInternetAddress("127.0.0.1")});
+        return nullptr;
+      }));
+  std::vector<std::string> addresses;
+  EXPECT_EQ(nullptr, resolve("localhost", addresses));
+  EXPECT_EQ((std::vector<std::string>{"127.0.0.1", "done"}), addresses);
+}
+
+TEST_F(CachingDnsResolverTest, DestroyWithQueryInFlight) {
+  std::vector<std::string> addresses;
+  expectQuery("foo.com");
+  resolve("foo.com", addresses);
+  EXPECT_CALL(resolver_->active_query_, cancel());
+}
+
+} // namespace Network
+} // namespace Envoy
@@ -0,0 +1,65 @@
+#include "common/network/address_impl.h"
+#include "common/network/connection_balancer_impl.h"
+
+#include "test/mocks/network/mocks.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::NiceMock;
+using testing::Return;
+using testing::_;
+
+namespace Envoy {
+namespace Network {
+
+class ConnectionBalancerImplTest : public testing::Test {
+public:
+  ConnectionBalancerImplTest() {
+    balancer_.registerHandler(handler0_);
+    balancer_.registerHandler(handler1_);
+    balancer_.registerHandler(handler2_);
+  }
+
+  bool balance(BalancedConnectionHandler& current) {
+    return balancer_.balance(current, 10, remote_address_, local_address_, false);
+  }
+
+  ConnectionBalancerImpl balancer_;
+  NiceMock<MockBalancedConnectionHandler> handler0_;
+  NiceMock<MockBalancedConnectionHandler> handler1_;
+  NiceMock<MockBalancedConnectionHandler> handler2_;
+  Address::InstanceConstSharedPtr remote_address_{new Address::Ipv4Instance("1.2.3.4", 1000)};
+  Address::InstanceConstSharedPtr local_address_{new Address::Ipv4Instance("127.0.0.1", 80)};
+};
+
+TEST_F(ConnectionBalancerImplTest, KeepWhenLeastLoaded) {
+  ON_CALL(handler0_, numConnections()).WillByDefault(Return(2));
+  ON_CALL(handler1_, numConnections()).WillByDefault(Return(2));
+  ON_CALL(handler2_, numConnections()).WillByDefault(Return(3));
+  EXPECT_CALL(handler1_, post(_, _, _, _)).Times(0);
+  EXPECT_CALL(handler2_, post(_, _, _, _)).Times(0);
+  EXPECT_FALSE(balance(handler0_));
+}
+
+TEST_F(ConnectionBalancerImplTest, PostToLeastLoaded) {
+  ON_CALL(handler0_, numConnections()).WillByDefault(Return(5));
+  ON_CALL(handler1_, numConnections()).WillByDefault(Return(3));
+  ON_CALL(handler2_, numConnections()).WillByDefault(Return(1));
+  EXPECT_CALL(handler1_, post(_, _, _, _)).Times(0);
+  EXPECT_CALL(handler2_, post(10, remote_address_, local_address_, false));
+  EXPECT_TRUE(balance(handler0_));
+}
+
+TEST_F(ConnectionBalancerImplTest, UnregisteredHandlerIsNotPicked) {
+  ON_CALL(handler0_, numConnections()).WillByDefault(Return(5));
+  ON_CALL(handler1_, numConnections()).WillByDefault(Return(3));
+  ON_CALL(handler2_, numConnections()).WillByDefault(Return(1));
+  balancer_.unregisterHandler(handler2_);
+  EXPECT_CALL(handler1_, post(10, remote_address_, local_address_, false));
+  EXPECT_CALL(handler2_, post(_, _, _, _)).Times(0);
+  EXPECT_TRUE(balance(handler0_));
+}
+
+} // namespace Network
+} // namespace Envoy
@@ -203,7 +203,8 @@ TEST_P(ConnectionImplTest, CloseDuringConnectCallback) {
 
 struct MockConnectionStats {
   Connection::ConnectionStats toBufferStats() {
-    return {rx_total_, rx_current_, tx_total_, tx_current_, &bind_errors_};
+    return {rx_total_,     rx_current_, tx_total_,    tx_current_,
+            &bind_errors_, &read_size_, &write_size_, &writes_per_flush_};
   }
 
   StrictMock<Stats::MockCounter> rx_total_;
@@ -211,6 +212,9 @@ struct MockConnectionStats {
   StrictMock<Stats::MockCounter> tx_total_;
   StrictMock<Stats::MockGauge> tx_current_;
   StrictMock<Stats::MockCounter> bind_errors_;
+  StrictMock<Stats::MockHistogram> read_size_;
+  StrictMock<Stats::MockHistogram> write_size_;
+  StrictMock<Stats::MockHistogram> writes_per_flush_;
 };
 
 TEST_P(ConnectionImplTest, ConnectionStats) {
@@ -233,6 +237,12 @@ TEST_P(ConnectionImplTest, ConnectionStats) {
   EXPECT_CALL(*filter, onWrite(_)).InSequence(s1).WillOnce(Return(FilterStatus::Continue));
   EXPECT_CALL(client_callbacks_, onEvent(ConnectionEvent::Connected)).InSequence(s1);
   EXPECT_CALL(client_connection_stats.tx_total_, add(4)).InSequence(s1);
+  EXPECT_CALL(client_connection_stats.write_size_, recordValue(4))
+      .InSequence(s1)
+      .WillOnce(Return());
+  EXPECT_CALL(client_connection_stats.writes_per_flush_, recordValue(1))
+      .InSequence(s1)
+      .WillOnce(Return());
 
   read_filter_.reset(new NiceMock<MockReadFilter>());
   MockConnectionStats server_connection_stats;
@@ -246,6 +256,7 @@ TEST_P(ConnectionImplTest, ConnectionStats) {
       }));
 
   Sequence s2;
+  EXPECT_CALL(server_connection_stats.read_size_, recordValue(4)).InSequence(s2).WillOnce(Return());
   EXPECT_CALL(server_connection_stats.rx_total_, add(4)).InSequence(s2);
   EXPECT_CALL(server_connection_stats.rx_current_, add(4)).InSequence(s2);
   EXPECT_CALL(server_connection_stats.rx_current_, sub(4)).InSequence(s2);
@@ -404,6 +415,73 @@ TEST_P(ConnectionImplTest, BasicWrite) {
   disconnect(true);
 }
 
+TEST_P(ConnectionImplTest, ReleaseIdleBuffers) {
+  setUpBasicConnection();
+  connect();
+
+  // Connecting counts as activity.
+  EXPECT_FALSE(client_connection_->releaseIdleBuffers());
+  EXPECT_TRUE(client_connection_->releaseIdleBuffers());
+  EXPECT_EQ(0, client_connection_->bufferedBytes());
+
+  Buffer::OwnedImpl data("hello");
+  client_connection_->write(data);
+  EXPECT_EQ(5, client_connection_->bufferedBytes());
+  EXPECT_FALSE(client_connection_->releaseIdleBuffers());
+  EXPECT_TRUE(client_connection_->releaseIdleBuffers());
+  EXPECT_EQ(5, client_connection_->bufferedBytes());
+
+  disconnect(true);
+}
+
+// Splice the server connection to itself, which echoes everything the client writes without the
+// server's read filter seeing it.
+TEST_P(ConnectionImplTest, Splice) {
+  setUpBasicConnection();
+  connect();
+
+  std::shared_ptr<MockReadFilter> client_read_filter(new NiceMock<MockReadFilter>());
+  std::shared_ptr<MockWriteFilter> client_write_filter(new NiceMock<MockWriteFilter>());
+  client_connection_->addReadFilter(client_read_filter);
+  client_connection_->addWriteFilter(client_write_filter);
+
+  // The write filters of the destination would not see spliced data.
+  EXPECT_FALSE(client_connection_->spliceTo(*client_connection_, nullptr));
+
+  uint64_t bytes_spliced = 0;
+  const bool spliced = server_connection_->spliceTo(
+      *server_connection_, [&](uint64_t bytes) -> void { bytes_spliced += bytes; });
+#ifdef __linux__
+  ASSERT_TRUE(spliced);
+#else
+  // There is nothing to test where splice(2) is not available.
+  EXPECT_FALSE(spliced);
+  disconnect(false);
+  return;
+#endif
+  EXPECT_FALSE(server_connection_->spliceTo(*client_connection_, nullptr));
+
+  std::string echoed;
+  EXPECT_CALL(*read_filter_, onData(_)).Times(0);
+  EXPECT_CALL(*client_read_filter, onData(_))
+      .WillRepeatedly(Invoke([&](Buffer::Instance& data) -> FilterStatus {
+        echoed.append(TestUtility::bufferToString(data));
+        data.drain(data.length());
+        if (echoed.size() == 11) {
+          dispatcher_->exit();
+        }
+        return FilterStatus::StopIteration;
+      }));
+
+  Buffer::OwnedImpl buffer("hello world");
+  client_connection_->write(buffer);
+  dispatcher_->run(Event::Dispatcher::RunType::Block);
+  EXPECT_EQ("hello world", echoed);
+  EXPECT_EQ(11U, bytes_spliced);
+
+  disconnect(true);
+}
+
 // Similar to BasicWrite, only with watermarks set.
 TEST_P(ConnectionImplTest, WriteWithWatermarks) {
   useMockBuffer();
@@ -459,6 +537,31 @@ TEST_P(ConnectionImplTest, WriteWithWatermarks) {
   disconnect(true);
 }
 
+// A write that the socket only partially accepts is not retried until the socket becomes writable
+// again, as a retry would just fail with EAGAIN.
+TEST_P(ConnectionImplTest, ShortWriteWaitsForWritable) {
+  useMockBuffer();
+
+  setUpBasicConnection();
+
+  connect();
+
+  std::string data_to_write = "hello world";
+  Buffer::OwnedImpl buffer_to_write(data_to_write);
+  EXPECT_CALL(*client_write_buffer_, write(_)).WillOnce(Invoke([&](int) -> int {
+    dispatcher_->exit();
+    client_write_buffer_->drain(5);
+    return 5;
+  }));
+  client_connection_->write(buffer_to_write);
+  dispatcher_->run(Event::Dispatcher::RunType::Block);
+  EXPECT_EQ(data_to_write.size() - 5, client_write_buffer_->length());
+
+  EXPECT_CALL(*client_write_buffer_, write(_))
+      .WillRepeatedly(Invoke(client_write_buffer_, &MockWatermarkBuffer::trackWrites));
+  disconnect(true);
+}
+
 // Read and write random bytes and ensure we don't encounter issues.
 TEST_P(ConnectionImplTest, WatermarkFuzzing) {
   useMockBuffer();
@@ -0,0 +1,126 @@
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/network/cidr_range.h"
+#include "common/network/lc_trie.h"
+#include "common/network/utility.h"
+
+#include "fmt/format.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::ElementsAre;
+using testing::IsEmpty;
+
+namespace Envoy {
+namespace Network {
+namespace LcTrie {
+
+class LcTrieTest : public testing::Test {
+public:
+  void setup(const std::vector<std::pair<std::string, std::vector<std::string>>>& tags) {
+    std::vector<std::pair<std::string, std::vector<Address::CidrRange>>> tag_data;
+    for (const auto& tag : tags) {
+      std::vector<Address::CidrRange> ranges;
+      for (const std::string& range : tag.second) {
+        ranges.push_back(Address::CidrRange::create(range));
+      }
+      tag_data.emplace_back(tag.first, ranges);
+    }
+    trie_.reset(new LcTrie(tag_data));
+  }
+
+  std::vector<std::string> getTags(const std::string& address) {
+    return trie_->getTags(*Utility::parseInternetAddress(address));
+  }
+
+  std::unique_ptr<LcTrie> trie_;
+};
+
+TEST_F(LcTrieTest, Empty) {
+  setup({});
+  EXPECT_THAT(getTags("1.2.3.4"), IsEmpty());
+  EXPECT_THAT(getTags("::1"), IsEmpty());
+}
+
+TEST_F(LcTrieTest, SingleRange) {
+  setup({{"tag", {"10.0.0.0/8"}}});
+  EXPECT_THAT(getTags("10.1.2.3"), ElementsAre("tag"));
+  EXPECT_THAT(getTags("11.1.2.3"), IsEmpty());
+  EXPECT_THAT(getTags("::ffff:10.1.2.3"), IsEmpty());
+}
+
+TEST_F(LcTrieTest, Ipv4) {
+  setup({{"a", {"1.2.3.4/32", "10.0.0.0/8"}},
+         {"b", {"192.168.0.0/16", "192.169.0.0/16"}},
+         {"c", {"0.0.0.0/1"}}});
+  EXPECT_THAT(getTags("1.2.3.4"), ElementsAre("a", "c"));
+  EXPECT_THAT(getTags("1.2.3.5"), ElementsAre("c"));
+  EXPECT_THAT(getTags("10.255.255.255"), ElementsAre("a", "c"));
+  EXPECT_THAT(getTags("192.168.1.1"), ElementsAre("b"));
+  EXPECT_THAT(getTags("192.169.255.1"), ElementsAre("b"));
+  EXPECT_THAT(getTags("192.170.0.1"), IsEmpty());
+  EXPECT_THAT(getTags("128.0.0.0"), IsEmpty());
+  EXPECT_THAT(getTags("127.255.255.255"), ElementsAre("c"));
+}
+
+TEST_F(LcTrieTest, Ipv6) {
+  setup({{"a", {"2001:abcd:ef01:2345::/64"}},
+         {"b", {"2001:abcd:ef01:2345:6789::/80", "::1/128"}},
+         {"c", {"::/0"}}});
+  EXPECT_THAT(getTags("2001:abcd:ef01:2345:6789::1"), ElementsAre("a", "b", "c"));
+  EXPECT_THAT(getTags("2001:abcd:ef01:2345:678a::1"), ElementsAre("a", "c"));
+  EXPECT_THAT(getTags("::1"), ElementsAre("b", "c"));
+  EXPECT_THAT(getTags("::2"), ElementsAre("c"));
+  EXPECT_THAT(getTags("1.2.3.4"), IsEmpty());
+}
+
+TEST_F(LcTrieTest, DuplicateAndNestedRanges) {
+  setup({{"a", {"10.0.0.0/8", "10.0.0.0/8", "10.1.0.0/16"}},
+         {"b", {"10.0.0.0/8", "10.1.2.0/24"}},
+         {"c", {"10.1.2.3/32"}}});
+  EXPECT_THAT(getTags("10.0.0.1"), ElementsAre("a", "b"));
+  EXPECT_THAT(getTags("10.1.0.1"), ElementsAre("a", "b"));
+  EXPECT_THAT(getTags("10.1.2.1"), ElementsAre("a", "b"));
+  EXPECT_THAT(getTags("10.1.2.3"), ElementsAre("a", "b", "c"));
+  EXPECT_THAT(getTags("9.255.255.255"), IsEmpty());
+  EXPECT_THAT(getTags("11.0.0.0"), IsEmpty());
+}
+
+// Compare lookups against a linear scan of CidrRange::isInRange() over randomly generated ranges.
+TEST_F(LcTrieTest, MatchesLinearScan) {
+  std::mt19937 random(0);
+  std::vector<std::pair<std::string, std::vector<std::string>>> tags;
+  for (uint32_t tag = 0; tag < 8; tag++) {
+    std::vector<std::string> ranges;
+    for (uint32_t i = 0; i < 200; i++) {
+      // Draw from a small address space so ranges overlap and nest.
+      ranges.push_back(fmt::format("10.{}.{}.0/{}", random() % 4, random() % 16,
+                                   8 + random() % 25));
+    }
+    tags.emplace_back(fmt::format("tag_{}", tag), ranges);
+  }
+  setup(tags);
+
+  for (uint32_t i = 0; i < 10000; i++) {
+    const std::string address =
+        fmt::format("10.{}.{}.{}", random() % 5, random() % 18, random() % 256);
+    std::vector<std::string> expected;
+    for (const auto& tag : tags) {
+      for (const std::string& range : tag.second) {
+        if (Address::CidrRange::create(range).isInRange(
+                *Utility::parseInternetAddress(address))) {
+          expected.push_back(tag.first);
+          break;
+        }
+      }
+    }
+    EXPECT_EQ(expected, getTags(address)) << address;
+  }
+}
+
+} // namespace LcTrie
+} // namespace Network
+} // namespace Envoy
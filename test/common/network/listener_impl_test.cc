@@ -327,5 +327,80 @@ TEST_P(ListenerImplTest, WildcardListenerUseActualDst) {
   dispatcher.run(Event::Dispatcher::RunType::Block);
 }
 
+// Connections to the same local address of a listener on the any address share its instance.
+TEST_P(ListenerImplTest, WildcardListenerSharesLocalAddress) {
+  Stats::IsolatedStoreImpl stats_store;
+  Event::DispatcherImpl dispatcher;
+  Network::TcpListenSocket socket(Network::Test::getAnyAddress(version_), true);
+  Network::MockListenerCallbacks listener_callbacks;
+  Network::MockConnectionHandler connection_handler;
+  Network::ListenerPtr listener =
+      dispatcher.createListener(connection_handler, socket, listener_callbacks, stats_store,
+                                Network::ListenerOptions::listenerOptionsWithBindToPort());
+
+  auto local_dst_address = Network::Utility::getAddressWithPort(
+      *Network::Test::getCanonicalLoopbackAddress(version_), socket.localAddress()->ip()->port());
+  std::vector<Network::ClientConnectionPtr> client_connections;
+  for (uint32_t i = 0; i < 2; i++) {
+    client_connections.push_back(dispatcher.createClientConnection(
+        local_dst_address, Network::Address::InstanceConstSharedPtr()));
+    client_connections.back()->connect();
+  }
+
+  std::vector<Address::InstanceConstSharedPtr> local_addresses;
+  EXPECT_CALL(listener_callbacks, onNewConnection_(_))
+      .Times(2)
+      .WillRepeatedly(Invoke([&](Network::ConnectionPtr& conn) -> void {
+        local_addresses.push_back(conn->localAddress());
+        conn->close(ConnectionCloseType::NoFlush);
+        if (local_addresses.size() == 2) {
+          for (auto& client_connection : client_connections) {
+            client_connection->close(ConnectionCloseType::NoFlush);
+          }
+          dispatcher.exit();
+        }
+      }));
+
+  dispatcher.run(Event::Dispatcher::RunType::Block);
+  EXPECT_EQ(*local_dst_address, *local_addresses[0]);
+  EXPECT_EQ(local_addresses[0].get(), local_addresses[1].get());
+}
+
+TEST_P(ListenerImplTest, DeferConnectionCreation) {
+  Stats::IsolatedStoreImpl stats_store;
+  Event::DispatcherImpl dispatcher;
+  Network::TcpListenSocket socket(Network::Test::getCanonicalLoopbackAddress(version_), true);
+  Network::MockListenerCallbacks listener_callbacks;
+  Network::MockConnectionHandler connection_handler;
+  Network::ListenerOptions listener_options =
+      Network::ListenerOptions::listenerOptionsWithBindToPort();
+  listener_options.defer_connection_creation_ = true;
+  Network::TestListenerImpl listener(connection_handler, dispatcher, socket, listener_callbacks,
+                                     stats_store, listener_options);
+
+  std::vector<Network::ClientConnectionPtr> client_connections;
+  for (uint32_t i = 0; i < 3; i++) {
+    client_connections.push_back(dispatcher.createClientConnection(
+        socket.localAddress(), Network::Address::InstanceConstSharedPtr()));
+    client_connections.back()->connect();
+  }
+
+  EXPECT_CALL(listener, newConnection(_, _, _, _)).Times(3);
+  uint32_t accepted = 0;
+  EXPECT_CALL(listener_callbacks, onNewConnection_(_))
+      .Times(3)
+      .WillRepeatedly(Invoke([&](Network::ConnectionPtr& conn) -> void {
+        conn->close(ConnectionCloseType::NoFlush);
+        if (++accepted == 3) {
+          for (auto& client_connection : client_connections) {
+            client_connection->close(ConnectionCloseType::NoFlush);
+          }
+          dispatcher.exit();
+        }
+      }));
+
+  dispatcher.run(Event::Dispatcher::RunType::Block);
+}
+
 } // namespace Network
 } // namespace Envoy
@@ -282,6 +282,133 @@ TEST_P(ProxyProtocolTest, ClosedEmpty) {
   dispatcher_.run(Event::Dispatcher::RunType::NonBlock);
 }
 
+// The V2 signature, version 2 and the PROXY command, TCP over IPv4, 12 bytes of addresses and a
+// 7 byte TLV: 1.2.3.4:65535 to 253.253.253.253:1234.
+const char V2_TCP4[] = "\x0d\x0a\x0d\x0a\x00\x0d\x0a\x51\x55\x49\x54\x0a"
+                       "\x21\x11\x00\x13"
+                       "\x01\x02\x03\x04\xfd\xfd\xfd\xfd\xff\xff\x04\xd2"
+                       "\x04\x00\x04\x74\x65\x73\x74";
+
+std::string v2Header(const char* header, size_t len) { return std::string(header, len); }
+
+TEST_P(ProxyProtocolTest, V2Basic) {
+  connect();
+  write(v2Header(V2_TCP4, sizeof(V2_TCP4) - 1) + "more data");
+
+  EXPECT_CALL(*read_filter_, onNewConnection());
+  EXPECT_CALL(*read_filter_, onData(_))
+      .WillOnce(Invoke([&](Buffer::Instance& buffer) -> FilterStatus {
+        EXPECT_EQ(server_connection_->remoteAddress()->asString(), "1.2.3.4:65535");
+        EXPECT_EQ(server_connection_->localAddress()->asString(), "253.253.253.253:1234");
+
+        EXPECT_EQ(TestUtility::bufferToString(buffer), "more data");
+        buffer.drain(9);
+        return Network::FilterStatus::Continue;
+      }));
+
+  dispatcher_.run(Event::Dispatcher::RunType::NonBlock);
+
+  disconnect();
+}
+
+TEST_P(ProxyProtocolTest, V2BasicV6) {
+  const char header[] = "\x0d\x0a\x0d\x0a\x00\x0d\x0a\x51\x55\x49\x54\x0a"
+                        "\x21\x21\x00\x24"
+                        "\x00\x01\x00\x02\x00\x03\x00\x00\x00\x00\x00\x00\x00\x00\x00\x04"
+                        "\x00\x05\x00\x06\x00\x00\x00\x00\x00\x00\x00\x00\x00\x07\x00\x08"
+                        "\xff\xff\x04\xd2";
+  connect();
+  write(v2Header(header, sizeof(header) - 1) + "more data");
+
+  EXPECT_CALL(*read_filter_, onNewConnection());
+  EXPECT_CALL(*read_filter_, onData(_))
+      .WillOnce(Invoke([&](Buffer::Instance& buffer) -> FilterStatus {
+        EXPECT_EQ(server_connection_->remoteAddress()->ip()->addressAsString(), "1:2:3::4");
+
+        EXPECT_EQ(TestUtility::bufferToString(buffer), "more data");
+        buffer.drain(9);
+        return Network::FilterStatus::Continue;
+      }));
+
+  dispatcher_.run(Event::Dispatcher::RunType::NonBlock);
+
+  disconnect();
+}
+
+TEST_P(ProxyProtocolTest, V2Local) {
+  // The LOCAL command keeps the connection's own addresses, and its addresses are ignored.
+  const char header[] = "\x0d\x0a\x0d\x0a\x00\x0d\x0a\x51\x55\x49\x54\x0a"
+                        "\x20\x11\x00\x0c"
+                        "\x01\x02\x03\x04\xfd\xfd\xfd\xfd\xff\xff\x04\xd2";
+  connect();
+  write(v2Header(header, sizeof(header) - 1));
+
+  dispatcher_.run(Event::Dispatcher::RunType::NonBlock);
+
+  disconnect();
+
+  EXPECT_EQ(server_connection_->remoteAddress()->ip()->addressAsString(),
+            conn_->localAddress()->ip()->addressAsString());
+}
+
+TEST_P(ProxyProtocolTest, V2PartialRead) {
+  const std::string header = v2Header(V2_TCP4, sizeof(V2_TCP4) - 1);
+  connect();
+
+  write(header.substr(0, 10));
+  dispatcher_.run(Event::Dispatcher::RunType::NonBlock);
+  write(header.substr(10, 10));
+  dispatcher_.run(Event::Dispatcher::RunType::NonBlock);
+  write(header.substr(20));
+  dispatcher_.run(Event::Dispatcher::RunType::NonBlock);
+
+  disconnect();
+
+  EXPECT_EQ(server_connection_->remoteAddress()->ip()->addressAsString(), "1.2.3.4");
+}
+
+TEST_P(ProxyProtocolTest, V2WrongVersion) {
+  std::string header = v2Header(V2_TCP4, sizeof(V2_TCP4) - 1);
+  header[12] = '\x31';
+  connectNoRead();
+  write(header);
+  expectProxyProtoError();
+}
+
+TEST_P(ProxyProtocolTest, V2Datagram) {
+  std::string header = v2Header(V2_TCP4, sizeof(V2_TCP4) - 1);
+  header[13] = '\x12';
+  connectNoRead();
+  write(header);
+  expectProxyProtoError();
+}
+
+TEST_P(ProxyProtocolTest, V2AddressesTooShort) {
+  const char header[] = "\x0d\x0a\x0d\x0a\x00\x0d\x0a\x51\x55\x49\x54\x0a"
+                        "\x21\x11\x00\x08"
+                        "\x01\x02\x03\x04\xfd\xfd\xfd\xfd";
+  connectNoRead();
+  write(v2Header(header, sizeof(header) - 1));
+  expectProxyProtoError();
+}
+
+TEST_P(ProxyProtocolTest, V2MalformedTlv) {
+  // The TLV claims 5 bytes of value but only 4 follow.
+  std::string header = v2Header(V2_TCP4, sizeof(V2_TCP4) - 1);
+  header[30] = '\x05';
+  connectNoRead();
+  write(header);
+  expectProxyProtoError();
+}
+
+TEST_P(ProxyProtocolTest, V2TooLong) {
+  std::string header = v2Header(V2_TCP4, 16);
+  header[14] = '\x10';
+  connectNoRead();
+  write(header);
+  expectProxyProtoError();
+}
+
 class WildcardProxyProtocolTest : public testing::TestWithParam<Address::IpVersion> {
 public:
   WildcardProxyProtocolTest()
@@ -0,0 +1,124 @@
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "common/buffer/buffer_impl.h"
+#include "common/network/raw_buffer_socket.h"
+
+#include "test/mocks/network/mocks.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::NiceMock;
+using testing::Return;
+
+namespace Envoy {
+namespace Network {
+
+// Records the size of every read.
+class ReadSizeTrackingBuffer : public Buffer::OwnedImpl {
+public:
+  int read(int fd, uint64_t max_length) override {
+    read_sizes_.push_back(max_length);
+    return Buffer::OwnedImpl::read(fd, max_length);
+  }
+
+  std::vector<uint64_t> read_sizes_;
+};
+
+class RawBufferSocketTest : public testing::Test, public TransportSocketCallbacks {
+public:
+  RawBufferSocketTest() {
+    EXPECT_EQ(0, pipe(fds_));
+    EXPECT_EQ(0, fcntl(fds_[0], F_SETFL, O_NONBLOCK));
+    // Room for the largest read.
+    const int max_read_size = RawBufferSocket::MAX_READ_SIZE;
+    EXPECT_LE(max_read_size, fcntl(fds_[1], F_SETPIPE_SZ, max_read_size));
+    socket_.setTransportSocketCallbacks(*this);
+  }
+
+  ~RawBufferSocketTest() {
+    close(fds_[0]);
+    close(fds_[1]);
+  }
+
+  void writeToPipe(uint64_t size) {
+    const std::string data(size, 'a');
+    EXPECT_EQ(static_cast<ssize_t>(size), ::write(fds_[1], data.data(), data.size()));
+  }
+
+  // Network::TransportSocketCallbacks
+  int fd() override { return fds_[0]; }
+  Network::Connection& connection() override { return connection_; }
+  bool shouldDrainReadBuffer() override { return false; }
+  void setReadBufferReady() override {}
+  void raiseEvent(ConnectionEvent) override {}
+
+  int fds_[2];
+  NiceMock<MockConnection> connection_;
+  RawBufferSocket socket_;
+  ReadSizeTrackingBuffer buffer_;
+};
+
+TEST_F(RawBufferSocketTest, ReadSizeAdapts) {
+  const uint64_t initial = RawBufferSocket::DEFAULT_READ_SIZE;
+
+  // A read that fills the read size doubles it. The final read only finds EAGAIN.
+  writeToPipe(initial);
+  EXPECT_EQ(initial, socket_.doRead(buffer_).bytes_processed_);
+  EXPECT_EQ((std::vector<uint64_t>{initial, initial * 2}), buffer_.read_sizes_);
+
+  // It takes two small reads in a row to halve it.
+  buffer_.read_sizes_.clear();
+  writeToPipe(100);
+  socket_.doRead(buffer_);
+  writeToPipe(100);
+  socket_.doRead(buffer_);
+  writeToPipe(100);
+  socket_.doRead(buffer_);
+  EXPECT_EQ((std::vector<uint64_t>{initial * 2, initial * 2, initial * 2, initial, initial,
+                                   initial}),
+            buffer_.read_sizes_);
+}
+
+TEST_F(RawBufferSocketTest, ReadSizeBounded) {
+  for (uint64_t size = RawBufferSocket::DEFAULT_READ_SIZE; size < RawBufferSocket::MAX_READ_SIZE;
+       size *= 2) {
+    writeToPipe(size);
+    socket_.doRead(buffer_);
+  }
+  buffer_.read_sizes_.clear();
+  writeToPipe(100);
+  socket_.doRead(buffer_);
+  EXPECT_EQ(RawBufferSocket::MAX_READ_SIZE, buffer_.read_sizes_.front());
+
+  for (int i = 0; i < 100; i++) {
+    writeToPipe(1);
+    socket_.doRead(buffer_);
+  }
+  buffer_.read_sizes_.clear();
+  writeToPipe(1);
+  socket_.doRead(buffer_);
+  EXPECT_EQ(RawBufferSocket::MIN_READ_SIZE, buffer_.read_sizes_.front());
+}
+
+// Reads do not go far past the read buffer limit.
+TEST_F(RawBufferSocketTest, ReadSizeHonorsBufferLimit) {
+  ON_CALL(connection_, bufferLimit()).WillByDefault(Return(RawBufferSocket::MIN_READ_SIZE * 2));
+  writeToPipe(100);
+  socket_.doRead(buffer_);
+  EXPECT_EQ(RawBufferSocket::MIN_READ_SIZE * 2, buffer_.read_sizes_.front());
+
+  // The buffer is already past its limit, so only the minimum is read.
+  buffer_.add(std::string(RawBufferSocket::MIN_READ_SIZE * 2, 'b'));
+  buffer_.read_sizes_.clear();
+  writeToPipe(100);
+  socket_.doRead(buffer_);
+  EXPECT_EQ(RawBufferSocket::MIN_READ_SIZE, buffer_.read_sizes_.front());
+}
+
+} // namespace Network
+} // namespace Envoy
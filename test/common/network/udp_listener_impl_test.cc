@@ -0,0 +1,128 @@
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "common/event/dispatcher_impl.h"
+#include "common/network/address_impl.h"
+#include "common/network/listen_socket_impl.h"
+#include "common/network/udp_listener_impl.h"
+
+#include "test/mocks/network/mocks.h"
+#include "test/test_common/environment.h"
+#include "test/test_common/network_utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::Invoke;
+using testing::_;
+
+namespace Envoy {
+namespace Network {
+
+class UdpListenerImplTest : public testing::TestWithParam<Address::IpVersion> {
+public:
+  UdpListenerImplTest()
+      : socket_(Network::Test::getCanonicalLoopbackAddress(GetParam()), false),
+        listener_(dispatcher_, socket_, callbacks_),
+        client_fd_(socket_.localAddress()->socket(Address::SocketType::Datagram)) {}
+
+  ~UdpListenerImplTest() { ::close(client_fd_); }
+
+  void sendToListener(const std::string& data) {
+    ASSERT_EQ(0, socket_.localAddress()->connect(client_fd_));
+    ASSERT_EQ(static_cast<ssize_t>(data.size()), ::send(client_fd_, data.data(), data.size(), 0));
+  }
+
+  // Runs the dispatcher until the client socket has a datagram.
+  std::string recvFromListener() {
+    char buffer[64];
+    for (uint32_t i = 0; i < 1000; i++) {
+      const ssize_t rc = ::recv(client_fd_, buffer, sizeof(buffer), MSG_DONTWAIT);
+      if (rc >= 0) {
+        return std::string(buffer, rc);
+      }
+      dispatcher_.run(Event::Dispatcher::RunType::NonBlock);
+      usleep(1000);
+    }
+    return "";
+  }
+
+  Event::DispatcherImpl dispatcher_;
+  UdpListenSocket socket_;
+  MockUdpListenerCallbacks callbacks_;
+  UdpListenerImpl listener_;
+  const int client_fd_;
+};
+
+INSTANTIATE_TEST_CASE_P(IpVersions, UdpListenerImplTest,
+                        testing::ValuesIn(TestEnvironment::getIpVersionsForTest()));
+
+// The datagrams that are ready are read as one batch, and the replies to them are sent once the
+// batch has been handled.
+TEST_P(UdpListenerImplTest, ReadAndReply) {
+  sendToListener("a");
+  sendToListener("bb");
+  sendToListener("ccc");
+
+  std::vector<std::string> received;
+  EXPECT_CALL(callbacks_, onData(_))
+      .Times(3)
+      .WillRepeatedly(Invoke([&](const UdpRecvData& data) -> void {
+        received.emplace_back(data.data_, data.length_);
+        listener_.send(data.peer_address_, data.peer_address_len_, data.data_, data.length_);
+      }));
+  EXPECT_CALL(callbacks_, onReadComplete()).WillOnce(Invoke([&]() -> void {
+    dispatcher_.exit();
+  }));
+  dispatcher_.run(Event::Dispatcher::RunType::Block);
+
+  EXPECT_EQ((std::vector<std::string>{"a", "bb", "ccc"}), received);
+  EXPECT_EQ("a", recvFromListener());
+  EXPECT_EQ("bb", recvFromListener());
+  EXPECT_EQ("ccc", recvFromListener());
+}
+
+// Datagrams larger than the receive buffers are dropped rather than passed on truncated.
+TEST_P(UdpListenerImplTest, DropTruncated) {
+  sendToListener(std::string(UdpRecvBatch::MAX_DATAGRAM_BYTES + 1, 'a'));
+  sendToListener("ok");
+
+  EXPECT_CALL(callbacks_, onData(_)).WillOnce(Invoke([](const UdpRecvData& data) -> void {
+    EXPECT_EQ("ok", std::string(data.data_, data.length_));
+  }));
+  EXPECT_CALL(callbacks_, onReadComplete()).WillRepeatedly(Invoke([&]() -> void {
+    dispatcher_.exit();
+  }));
+  dispatcher_.run(Event::Dispatcher::RunType::Block);
+}
+
+// A full send batch is sent right away.
+TEST_P(UdpListenerImplTest, SendFullBatch) {
+  sendToListener("x");
+  sockaddr_storage peer;
+  socklen_t peer_len = 0;
+  EXPECT_CALL(callbacks_, onData(_)).WillOnce(Invoke([&](const UdpRecvData& data) -> void {
+    memcpy(&peer, &data.peer_address_, data.peer_address_len_);
+    peer_len = data.peer_address_len_;
+  }));
+  EXPECT_CALL(callbacks_, onReadComplete()).WillOnce(Invoke([&]() -> void {
+    dispatcher_.exit();
+  }));
+  dispatcher_.run(Event::Dispatcher::RunType::Block);
+
+  for (uint32_t i = 0; i <= UdpSendBatch::MAX_DATAGRAMS; i++) {
+    const std::string data = std::to_string(i);
+    listener_.send(peer, peer_len, data.data(), data.size());
+  }
+  for (uint32_t i = 0; i < UdpSendBatch::MAX_DATAGRAMS; i++) {
+    EXPECT_EQ(std::to_string(i), recvFromListener());
+  }
+  listener_.flush();
+  EXPECT_EQ(std::to_string(UdpSendBatch::MAX_DATAGRAMS), recvFromListener());
+}
+
+} // namespace Network
+} // namespace Envoy
@@ -0,0 +1,92 @@
+#include <list>
+#include <string>
+#include <vector>
+
+#include "common/network/utility.h"
+#include "common/network/warm_dns_resolver.h"
+
+#include "test/mocks/network/mocks.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::DoAll;
+using testing::Return;
+using testing::SaveArg;
+using testing::_;
+
+namespace Envoy {
+namespace Network {
+
+class WarmDnsResolverTest : public testing::Test {
+public:
+  WarmDnsResolverTest() : resolver_(new MockDnsResolver()), warm_resolver_(resolver_) {}
+
+  std::vector<std::string> resolve(const std::string& dns_name, DnsLookupFamily family) {
+    std::vector<std::string> addresses;
+    warm_resolver_.resolve(dns_name, family,
+                           [&](std::list<Address::InstanceConstSharedPtr>&& address_list) -> void {
+                             for (const auto& address : address_list) {
+                               addresses.push_back(address->ip()->addressAsString());
+                             }
+                           });
+    return addresses;
+  }
+
+  std::shared_ptr<MockDnsResolver> resolver_;
+  WarmDnsResolver warm_resolver_;
+};
+
+TEST_F(WarmDnsResolverTest, RecordsResults) {
+  DnsResolver::ResolveCb callback;
+  EXPECT_CALL(*resolver_, resolve("foo.com", DnsLookupFamily::V4Only, _))
+      .WillOnce(DoAll(SaveArg<2>(&callback), Return(&resolver_->active_query_)));
+  bool called = false;
+  EXPECT_EQ(&resolver_->active_query_,
+            warm_resolver_.resolve("foo.com", DnsLookupFamily::V4Only,
+                                   [&](std::list<Address::InstanceConstSharedPtr>&& address_list)
+                                       -> void {
+                                     EXPECT_EQ(2UL, address_list.size());
+                                     called = true;
+                                   }));
+  EXPECT_TRUE(warm_resolver_.results().empty());
+
+  callback({Utility::parseInternetAddress("10.0.0.1"), Utility::parseInternetAddress("10.0.0.2")});
+  EXPECT_TRUE(called);
+  std::vector<DnsResult> results = warm_resolver_.results();
+  ASSERT_EQ(1UL, results.size());
+  EXPECT_EQ("foo.com", results[0].dns_name_);
+  EXPECT_EQ(DnsLookupFamily::V4Only, results[0].dns_lookup_family_);
+  EXPECT_EQ((std::vector<std::string>{"10.0.0.1", "10.0.0.2"}), results[0].addresses_);
+
+  // A failed resolution keeps the last result.
+  EXPECT_CALL(*resolver_, resolve("foo.com", DnsLookupFamily::V4Only, _))
+      .WillOnce(DoAll(SaveArg<2>(&callback), Return(&resolver_->active_query_)));
+  resolve("foo.com", DnsLookupFamily::V4Only);
+  callback({});
+  EXPECT_EQ((std::vector<std::string>{"10.0.0.1", "10.0.0.2"}),
+            warm_resolver_.results()[0].addresses_);
+}
+
+TEST_F(WarmDnsResolverTest, AnswersFirstLookupFromHints) {
+  warm_resolver_.addHints({{"foo.com", DnsLookupFamily::V4Only, {"10.0.0.1", "not an address"}},
+                           {"bar.com", DnsLookupFamily::V4Only, {"not an address"}}});
+
+  // The hint answers the first lookup inline.
+  EXPECT_CALL(*resolver_, resolve(_, _, _)).Times(0);
+  EXPECT_EQ((std::vector<std::string>{"10.0.0.1"}), resolve("foo.com", DnsLookupFamily::V4Only));
+  testing::Mock::VerifyAndClearExpectations(resolver_.get());
+
+  // Later lookups, other families and names without usable hints go to DNS.
+  EXPECT_CALL(*resolver_, resolve("foo.com", DnsLookupFamily::V4Only, _))
+      .WillOnce(Return(nullptr));
+  EXPECT_CALL(*resolver_, resolve("foo.com", DnsLookupFamily::Auto, _)).WillOnce(Return(nullptr));
+  EXPECT_CALL(*resolver_, resolve("bar.com", DnsLookupFamily::V4Only, _))
+      .WillOnce(Return(nullptr));
+  resolve("foo.com", DnsLookupFamily::V4Only);
+  resolve("foo.com", DnsLookupFamily::Auto);
+  resolve("bar.com", DnsLookupFamily::V4Only);
+}
+
+} // namespace Network
+} // namespace Envoy
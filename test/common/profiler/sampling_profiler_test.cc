@@ -0,0 +1,66 @@
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <string>
+
+#include "common/profiler/sampling_profiler.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Profiler {
+
+namespace {
+
+// Use CPU until the process has used at least the given CPU time, so that it gets sampled.
+void spin(std::chrono::milliseconds cpu_time) {
+  const std::clock_t end = std::clock() + cpu_time.count() * CLOCKS_PER_SEC / 1000;
+  volatile uint64_t sum = 0;
+  while (std::clock() < end) {
+    for (uint32_t i = 0; i < 1000; i++) {
+      sum += i;
+    }
+  }
+}
+
+uint64_t totalSamples(const std::string& folded) {
+  uint64_t total = 0;
+  size_t line_start = 0;
+  while (line_start < folded.size()) {
+    const size_t line_end = folded.find('\n', line_start);
+    const size_t count_start = folded.rfind(' ', line_end) + 1;
+    total += std::stoull(folded.substr(count_start, line_end - count_start));
+    line_start = line_end + 1;
+  }
+  return total;
+}
+
+} // namespace
+
+TEST(SamplingProfilerTest, StartStop) {
+  EXPECT_FALSE(Sampling::profilerEnabled());
+  EXPECT_FALSE(Sampling::startProfiler(0));
+
+  EXPECT_TRUE(Sampling::startProfiler(1000));
+  EXPECT_TRUE(Sampling::profilerEnabled());
+  EXPECT_FALSE(Sampling::startProfiler(1000));
+  spin(std::chrono::milliseconds(200));
+  Sampling::stopProfiler();
+  EXPECT_FALSE(Sampling::profilerEnabled());
+
+  // Samples are kept after the profiler stops, and the stacks are folded outermost frame first.
+  const std::string folded = Sampling::foldedStacks();
+  const uint64_t samples = totalSamples(folded);
+  EXPECT_LT(0UL, samples);
+  EXPECT_EQ(0UL, Sampling::droppedSamples());
+  spin(std::chrono::milliseconds(50));
+  EXPECT_EQ(folded, Sampling::foldedStacks());
+
+  // Starting again drops the previous samples.
+  EXPECT_TRUE(Sampling::startProfiler(Sampling::DEFAULT_FREQUENCY_HZ));
+  Sampling::stopProfiler();
+  EXPECT_GT(samples, totalSamples(Sampling::foldedStacks()));
+}
+
+} // namespace Profiler
+} // namespace Envoy
@@ -0,0 +1,250 @@
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "common/ratelimit/coalescing_ratelimit_impl.h"
+#include "common/stats/stats_impl.h"
+
+#include "test/mocks/common.h"
+#include "test/mocks/ratelimit/mocks.h"
+#include "test/mocks/runtime/mocks.h"
+#include "test/mocks/thread_local/mocks.h"
+#include "test/mocks/tracing/mocks.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::Invoke;
+using testing::NiceMock;
+using testing::Return;
+using testing::_;
+
+namespace Envoy {
+namespace RateLimit {
+
+class MockRequestCallbacks : public RequestCallbacks {
+public:
+  MOCK_METHOD1(complete, void(LimitStatus status));
+};
+
+/**
+ * Creates mock rate limit service clients that remember the callbacks of the last call.
+ */
+class TestClientFactory : public ClientFactory {
+public:
+  ClientPtr create(const Optional<std::chrono::milliseconds>&) override {
+    MockClient* client = new NiceMock<MockClient>();
+    ON_CALL(*client, limit(_, _, _, _))
+        .WillByDefault(Invoke([this](RequestCallbacks& callbacks, const std::string&,
+                                     const std::vector<Descriptor>&, Tracing::Span&) -> void {
+          last_callbacks_ = &callbacks;
+          if (inline_status_.valid()) {
+            callbacks.complete(inline_status_.value());
+          }
+        }));
+    clients_.push_back(client);
+    return ClientPtr{client};
+  }
+
+  std::vector<MockClient*> clients_;
+  RequestCallbacks* last_callbacks_{};
+  // Status that calls complete with before limit() returns, if any.
+  Optional<LimitStatus> inline_status_;
+};
+
+class CoalescingRateLimitTest : public testing::Test {
+public:
+  CoalescingRateLimitTest()
+      : global_factory_(new TestClientFactory()),
+        factory_(ClientFactoryPtr{global_factory_}, tls_, runtime_, store_, time_source_) {
+    ON_CALL(time_source_, currentTime()).WillByDefault(Invoke([this]() { return now_; }));
+  }
+
+  void coalesce() {
+    ON_CALL(runtime_.snapshot_, featureEnabled("ratelimit.coalesce_requests", 0))
+        .WillByDefault(Return(true));
+  }
+
+  ClientPtr limit(MockRequestCallbacks& callbacks, const std::vector<Descriptor>& descriptors) {
+    ClientPtr client = factory_.create(Optional<std::chrono::milliseconds>());
+    client->limit(callbacks, "domain", descriptors, span_);
+    return client;
+  }
+
+  NiceMock<ThreadLocal::MockInstance> tls_;
+  NiceMock<Runtime::MockLoader> runtime_;
+  NiceMock<MockMonotonicTimeSource> time_source_;
+  Stats::IsolatedStoreImpl store_;
+  MonotonicTime now_;
+  TestClientFactory* global_factory_;
+  CoalescingFactoryImpl factory_;
+  Tracing::MockSpan span_;
+  const std::vector<Descriptor> descriptors_{{{{"foo", "bar"}}}};
+};
+
+TEST_F(CoalescingRateLimitTest, NoCoalescing) {
+  MockRequestCallbacks callbacks1;
+  MockRequestCallbacks callbacks2;
+  ClientPtr client1 = limit(callbacks1, descriptors_);
+  RequestCallbacks* call1 = global_factory_->last_callbacks_;
+  ClientPtr client2 = limit(callbacks2, descriptors_);
+  RequestCallbacks* call2 = global_factory_->last_callbacks_;
+  EXPECT_EQ(2U, global_factory_->clients_.size());
+
+  EXPECT_CALL(callbacks2, complete(LimitStatus::OverLimit));
+  call2->complete(LimitStatus::OverLimit);
+  EXPECT_CALL(callbacks1, complete(LimitStatus::OK));
+  call1->complete(LimitStatus::OK);
+  EXPECT_EQ(0U, store_.counter("ratelimit.coalesced").value());
+}
+
+TEST_F(CoalescingRateLimitTest, CoalesceIdenticalRequests) {
+  coalesce();
+
+  MockRequestCallbacks callbacks1;
+  MockRequestCallbacks callbacks2;
+  MockRequestCallbacks callbacks3;
+  ClientPtr client1 = limit(callbacks1, descriptors_);
+  RequestCallbacks* call = global_factory_->last_callbacks_;
+  ClientPtr client2 = limit(callbacks2, descriptors_);
+  EXPECT_EQ(1U, global_factory_->clients_.size());
+  EXPECT_EQ(1U, store_.counter("ratelimit.coalesced").value());
+
+  // Different descriptors get their own call.
+  ClientPtr client3 = limit(callbacks3, {{{{"foo", "baz"}}}});
+  EXPECT_EQ(2U, global_factory_->clients_.size());
+
+  EXPECT_CALL(callbacks1, complete(LimitStatus::OK));
+  EXPECT_CALL(callbacks2, complete(LimitStatus::OK));
+  call->complete(LimitStatus::OK);
+
+  // Once the call completes, the next identical request makes a new one.
+  MockRequestCallbacks callbacks4;
+  ClientPtr client4 = limit(callbacks4, descriptors_);
+  EXPECT_EQ(3U, global_factory_->clients_.size());
+
+  EXPECT_CALL(*global_factory_->clients_[1], cancel());
+  client3->cancel();
+  EXPECT_CALL(*global_factory_->clients_[2], cancel());
+  client4.reset();
+}
+
+TEST_F(CoalescingRateLimitTest, CancelWaiter) {
+  coalesce();
+
+  MockRequestCallbacks callbacks1;
+  MockRequestCallbacks callbacks2;
+  ClientPtr client1 = limit(callbacks1, descriptors_);
+  RequestCallbacks* call = global_factory_->last_callbacks_;
+  ClientPtr client2 = limit(callbacks2, descriptors_);
+
+  // The call stays in flight while anyone still waits for it.
+  EXPECT_CALL(*global_factory_->clients_[0], cancel()).Times(0);
+  client1->cancel();
+  EXPECT_CALL(callbacks1, complete(_)).Times(0);
+  EXPECT_CALL(callbacks2, complete(LimitStatus::OK));
+  call->complete(LimitStatus::OK);
+}
+
+TEST_F(CoalescingRateLimitTest, CancelLastWaiter) {
+  coalesce();
+
+  MockRequestCallbacks callbacks1;
+  MockRequestCallbacks callbacks2;
+  ClientPtr client1 = limit(callbacks1, descriptors_);
+  ClientPtr client2 = limit(callbacks2, descriptors_);
+
+  client1->cancel();
+  EXPECT_CALL(*global_factory_->clients_[0], cancel());
+  client2->cancel();
+
+  // The cancelled call is no longer joined.
+  MockRequestCallbacks callbacks3;
+  ClientPtr client3 = limit(callbacks3, descriptors_);
+  EXPECT_EQ(2U, global_factory_->clients_.size());
+  EXPECT_CALL(*global_factory_->clients_[1], cancel());
+}
+
+TEST_F(CoalescingRateLimitTest, WaiterCancelledDuringCompletion) {
+  coalesce();
+
+  MockRequestCallbacks callbacks1;
+  MockRequestCallbacks callbacks2;
+  ClientPtr client1 = limit(callbacks1, descriptors_);
+  RequestCallbacks* call = global_factory_->last_callbacks_;
+  ClientPtr client2 = limit(callbacks2, descriptors_);
+
+  EXPECT_CALL(callbacks1, complete(LimitStatus::OK)).WillOnce(Invoke([&](LimitStatus) -> void {
+    client2->cancel();
+  }));
+  EXPECT_CALL(callbacks2, complete(_)).Times(0);
+  EXPECT_CALL(*global_factory_->clients_[0], cancel()).Times(0);
+  call->complete(LimitStatus::OK);
+}
+
+TEST_F(CoalescingRateLimitTest, InlineCompletion) {
+  coalesce();
+  global_factory_->inline_status_.value(LimitStatus::OK);
+
+  MockRequestCallbacks callbacks1;
+  EXPECT_CALL(callbacks1, complete(LimitStatus::OK));
+  ClientPtr client1 = limit(callbacks1, descriptors_);
+
+  // The completed call is no longer joined.
+  MockRequestCallbacks callbacks2;
+  EXPECT_CALL(callbacks2, complete(LimitStatus::OK));
+  ClientPtr client2 = limit(callbacks2, descriptors_);
+  EXPECT_EQ(2U, global_factory_->clients_.size());
+  EXPECT_EQ(0U, store_.counter("ratelimit.coalesced").value());
+}
+
+TEST_F(CoalescingRateLimitTest, CacheOverLimit) {
+  ON_CALL(runtime_.snapshot_, getInteger("ratelimit.over_limit_cache_ttl_ms", _))
+      .WillByDefault(Return(1000));
+
+  MockRequestCallbacks callbacks;
+  ClientPtr client1 = limit(callbacks, descriptors_);
+  EXPECT_CALL(callbacks, complete(LimitStatus::OverLimit));
+  global_factory_->last_callbacks_->complete(LimitStatus::OverLimit);
+
+  // Identical requests are over limit without a call until the answer expires.
+  EXPECT_CALL(callbacks, complete(LimitStatus::OverLimit));
+  ClientPtr client2 = limit(callbacks, descriptors_);
+  EXPECT_EQ(1U, global_factory_->clients_.size());
+  EXPECT_EQ(1U, store_.counter("ratelimit.over_limit_cache_hit").value());
+
+  now_ += std::chrono::milliseconds(1000);
+  ClientPtr client3 = limit(callbacks, descriptors_);
+  EXPECT_EQ(2U, global_factory_->clients_.size());
+  EXPECT_CALL(callbacks, complete(LimitStatus::OK));
+  global_factory_->last_callbacks_->complete(LimitStatus::OK);
+
+  // OK answers are not cached.
+  ClientPtr client4 = limit(callbacks, descriptors_);
+  EXPECT_EQ(3U, global_factory_->clients_.size());
+  EXPECT_CALL(*global_factory_->clients_[2], cancel());
+}
+
+TEST_F(CoalescingRateLimitTest, CacheFull) {
+  ON_CALL(runtime_.snapshot_, getInteger("ratelimit.over_limit_cache_ttl_ms", _))
+      .WillByDefault(Return(1000));
+  ON_CALL(runtime_.snapshot_, getInteger("ratelimit.over_limit_cache_max_entries", _))
+      .WillByDefault(Return(1));
+
+  MockRequestCallbacks callbacks;
+  EXPECT_CALL(callbacks, complete(LimitStatus::OverLimit)).Times(3);
+  ClientPtr client1 = limit(callbacks, descriptors_);
+  global_factory_->last_callbacks_->complete(LimitStatus::OverLimit);
+  ClientPtr client2 = limit(callbacks, {{{{"foo", "baz"}}}});
+  global_factory_->last_callbacks_->complete(LimitStatus::OverLimit);
+
+  // Only the first answer fit in the cache.
+  ClientPtr client3 = limit(callbacks, descriptors_);
+  EXPECT_EQ(2U, global_factory_->clients_.size());
+  ClientPtr client4 = limit(callbacks, {{{{"foo", "baz"}}}});
+  EXPECT_EQ(3U, global_factory_->clients_.size());
+  EXPECT_CALL(*global_factory_->clients_[2], cancel());
+}
+
+} // namespace RateLimit
+} // namespace Envoy
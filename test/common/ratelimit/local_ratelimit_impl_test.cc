@@ -0,0 +1,267 @@
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "common/ratelimit/local_ratelimit_impl.h"
+#include "common/stats/stats_impl.h"
+
+#include "test/mocks/common.h"
+#include "test/mocks/ratelimit/mocks.h"
+#include "test/mocks/runtime/mocks.h"
+#include "test/mocks/thread_local/mocks.h"
+#include "test/mocks/tracing/mocks.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::Invoke;
+using testing::NiceMock;
+using testing::Return;
+using testing::_;
+
+namespace Envoy {
+namespace RateLimit {
+
+class MockRequestCallbacks : public RequestCallbacks {
+public:
+  MOCK_METHOD1(complete, void(LimitStatus status));
+};
+
+class LocalRateLimitTest : public testing::Test {
+public:
+  LocalRateLimitTest() : limiter_(runtime_, store_, time_source_) {
+    ON_CALL(time_source_, currentTime()).WillByDefault(Invoke([this]() { return now_; }));
+  }
+
+  void setLimit(const std::string& keys, uint64_t tokens_per_second, uint64_t max_tokens) {
+    ON_CALL(runtime_.snapshot_,
+            getInteger("ratelimit.local.domain." + keys + ".tokens_per_second", _))
+        .WillByDefault(Return(tokens_per_second));
+    ON_CALL(runtime_.snapshot_, getInteger("ratelimit.local.domain." + keys + ".max_tokens", _))
+        .WillByDefault(Return(max_tokens));
+  }
+
+  NiceMock<Runtime::MockLoader> runtime_;
+  NiceMock<MockMonotonicTimeSource> time_source_;
+  Stats::IsolatedStoreImpl store_;
+  MonotonicTime now_{std::chrono::seconds(1000)};
+  LocalRateLimiter limiter_;
+};
+
+TEST_F(LocalRateLimitTest, TokenBucket) {
+  TokenBucket token_bucket(time_source_);
+
+  // A full bucket allows a burst of max_tokens.
+  EXPECT_TRUE(token_bucket.consume(10, 2));
+  EXPECT_TRUE(token_bucket.consume(10, 2));
+  EXPECT_FALSE(token_bucket.consume(10, 2));
+
+  // One token comes back every 100ms.
+  now_ += std::chrono::milliseconds(99);
+  EXPECT_FALSE(token_bucket.consume(10, 2));
+  now_ += std::chrono::milliseconds(1);
+  EXPECT_TRUE(token_bucket.consume(10, 2));
+  EXPECT_FALSE(token_bucket.consume(10, 2));
+
+  // The bucket refills up to max_tokens and no further.
+  now_ += std::chrono::seconds(10);
+  EXPECT_TRUE(token_bucket.consume(10, 2));
+  EXPECT_TRUE(token_bucket.consume(10, 2));
+  EXPECT_FALSE(token_bucket.consume(10, 2));
+
+  // Draining takes all tokens, and the bucket refills from empty.
+  now_ += std::chrono::seconds(10);
+  token_bucket.drain(10, 2);
+  EXPECT_FALSE(token_bucket.consume(10, 2));
+  now_ += std::chrono::milliseconds(100);
+  EXPECT_TRUE(token_bucket.consume(10, 2));
+}
+
+TEST_F(LocalRateLimitTest, NoLocalLimit) {
+  EXPECT_EQ(LimitStatus::OK, limiter_.limit("domain", {{{{"foo", "bar"}}}}));
+  EXPECT_EQ(0U, store_.counter("ratelimit.local.ok").value());
+}
+
+TEST_F(LocalRateLimitTest, BucketPerDescriptorValue) {
+  setLimit("remote_address", 1, 1);
+
+  EXPECT_EQ(LimitStatus::OK, limiter_.limit("domain", {{{{"remote_address", "10.0.0.1"}}}}));
+  EXPECT_EQ(LimitStatus::OverLimit,
+            limiter_.limit("domain", {{{{"remote_address", "10.0.0.1"}}}}));
+  EXPECT_EQ(LimitStatus::OK, limiter_.limit("domain", {{{{"remote_address", "10.0.0.2"}}}}));
+
+  // A descriptor with more entries has its own limit, and none is configured for it.
+  EXPECT_EQ(LimitStatus::OK, limiter_.limit("domain", {{{{"remote_address", "10.0.0.1"},
+                                                         {"path", "/foo"}}}}));
+  EXPECT_EQ(LimitStatus::OK, limiter_.limit("other_domain", {{{{"remote_address", "10.0.0.1"}}}}));
+
+  EXPECT_EQ(2U, store_.counter("ratelimit.local.ok").value());
+  EXPECT_EQ(1U, store_.counter("ratelimit.local.over_limit").value());
+}
+
+TEST_F(LocalRateLimitTest, AnyDescriptorOverLimit) {
+  setLimit("foo", 1, 1);
+  setLimit("baz", 100, 100);
+
+  EXPECT_EQ(LimitStatus::OK, limiter_.limit("domain", {{{{"foo", "bar"}}}, {{{"baz", "qux"}}}}));
+  EXPECT_EQ(LimitStatus::OverLimit,
+            limiter_.limit("domain", {{{{"baz", "qux"}}}, {{{"foo", "bar"}}}}));
+}
+
+TEST_F(LocalRateLimitTest, BucketOverflow) {
+  setLimit("remote_address", 1, 1);
+  ON_CALL(runtime_.snapshot_, getInteger("ratelimit.local.max_buckets", _))
+      .WillByDefault(Return(1));
+
+  EXPECT_EQ(LimitStatus::OK, limiter_.limit("domain", {{{{"remote_address", "10.0.0.1"}}}}));
+  EXPECT_EQ(LimitStatus::OK, limiter_.limit("domain", {{{{"remote_address", "10.0.0.2"}}}}));
+  EXPECT_EQ(LimitStatus::OK, limiter_.limit("domain", {{{{"remote_address", "10.0.0.2"}}}}));
+  EXPECT_EQ(2U, store_.counter("ratelimit.local.bucket_overflow").value());
+}
+
+/**
+ * Creates mock rate limit service clients that remember the callbacks of the last call.
+ */
+class TestClientFactory : public ClientFactory {
+public:
+  ClientPtr create(const Optional<std::chrono::milliseconds>&) override {
+    MockClient* client = new NiceMock<MockClient>();
+    ON_CALL(*client, limit(_, _, _, _))
+        .WillByDefault(Invoke([this](RequestCallbacks& callbacks, const std::string&,
+                                     const std::vector<Descriptor>&, Tracing::Span&) -> void {
+          last_callbacks_ = &callbacks;
+          if (inline_status_.valid()) {
+            callbacks.complete(inline_status_.value());
+          }
+        }));
+    clients_.push_back(client);
+    return ClientPtr{client};
+  }
+
+  std::vector<MockClient*> clients_;
+  RequestCallbacks* last_callbacks_{};
+  // Status that calls complete with before limit() returns, if any.
+  Optional<LimitStatus> inline_status_;
+};
+
+class LocalRateLimitClientTest : public LocalRateLimitTest {
+public:
+  LocalRateLimitClientTest()
+      : global_factory_(new TestClientFactory()),
+        factory_(ClientFactoryPtr{global_factory_}, tls_, runtime_, store_, time_source_),
+        client_(factory_.create(Optional<std::chrono::milliseconds>())) {
+    setLimit("foo", 1, 1);
+  }
+
+  void preauthorize() {
+    ON_CALL(runtime_.snapshot_, featureEnabled("ratelimit.local.preauthorize", 0))
+        .WillByDefault(Return(true));
+  }
+
+  LocalReconciler& reconciler() { return *static_cast<LocalReconciler*>(tls_.data_[0].get()); }
+
+  const std::vector<Descriptor> descriptors_{{{{"foo", "bar"}}}};
+  NiceMock<ThreadLocal::MockInstance> tls_;
+  TestClientFactory* global_factory_;
+  LocalFactoryImpl factory_;
+  ClientPtr client_;
+  MockRequestCallbacks request_callbacks_;
+  Tracing::MockSpan span_;
+};
+
+TEST_F(LocalRateLimitClientTest, OverLocalLimit) {
+  client_->limit(request_callbacks_, "domain", descriptors_, span_);
+  ASSERT_EQ(1U, global_factory_->clients_.size());
+  EXPECT_CALL(request_callbacks_, complete(LimitStatus::OK));
+  global_factory_->last_callbacks_->complete(LimitStatus::OK);
+
+  // The second request is rejected without calling the rate limit service.
+  EXPECT_CALL(*global_factory_->clients_[0], limit(_, _, _, _)).Times(0);
+  EXPECT_CALL(request_callbacks_, complete(LimitStatus::OverLimit));
+  client_->limit(request_callbacks_, "domain", descriptors_, span_);
+  EXPECT_EQ(1U, global_factory_->clients_.size());
+}
+
+TEST_F(LocalRateLimitClientTest, GlobalOverLimitDrains) {
+  setLimit("foo", 1, 2);
+
+  client_->limit(request_callbacks_, "domain", descriptors_, span_);
+  EXPECT_CALL(request_callbacks_, complete(LimitStatus::OverLimit));
+  global_factory_->last_callbacks_->complete(LimitStatus::OverLimit);
+  EXPECT_EQ(0U, store_.counter("ratelimit.local.reconcile_over_limit").value());
+
+  // The local bucket had a token left, but the service's verdict drained it.
+  EXPECT_CALL(request_callbacks_, complete(LimitStatus::OverLimit));
+  client_->limit(request_callbacks_, "domain", descriptors_, span_);
+}
+
+TEST_F(LocalRateLimitClientTest, Cancel) {
+  client_->limit(request_callbacks_, "domain", descriptors_, span_);
+  EXPECT_CALL(*global_factory_->clients_[0], cancel());
+  client_->cancel();
+}
+
+TEST_F(LocalRateLimitClientTest, Preauthorize) {
+  preauthorize();
+  setLimit("foo", 1, 2);
+
+  // The request is allowed before the rate limit service answers.
+  EXPECT_CALL(request_callbacks_, complete(LimitStatus::OK));
+  client_->limit(request_callbacks_, "domain", descriptors_, span_);
+  ASSERT_EQ(1U, global_factory_->clients_.size());
+  EXPECT_EQ(1U, reconciler().size());
+
+  // Reconciling with an over limit answer drains the local bucket.
+  global_factory_->last_callbacks_->complete(LimitStatus::OverLimit);
+  EXPECT_EQ(1U, store_.counter("ratelimit.local.reconcile_over_limit").value());
+  EXPECT_EQ(0U, reconciler().size());
+
+  EXPECT_CALL(request_callbacks_, complete(LimitStatus::OverLimit));
+  client_->limit(request_callbacks_, "domain", descriptors_, span_);
+}
+
+TEST_F(LocalRateLimitClientTest, PreauthorizeInlineGlobalResponse) {
+  preauthorize();
+  global_factory_->inline_status_.value(LimitStatus::OK);
+
+  EXPECT_CALL(request_callbacks_, complete(LimitStatus::OK));
+  client_->limit(request_callbacks_, "domain", descriptors_, span_);
+  EXPECT_EQ(0U, store_.counter("ratelimit.local.reconcile_over_limit").value());
+  EXPECT_EQ(0U, reconciler().size());
+}
+
+// The background call belongs to the worker, so a request that ends before the rate limit service
+// answers is still reconciled.
+TEST_F(LocalRateLimitClientTest, PreauthorizeClientDestroyedBeforeGlobalResponse) {
+  preauthorize();
+  setLimit("foo", 1, 2);
+
+  EXPECT_CALL(request_callbacks_, complete(LimitStatus::OK));
+  client_->limit(request_callbacks_, "domain", descriptors_, span_);
+  ASSERT_EQ(1U, global_factory_->clients_.size());
+  EXPECT_CALL(*global_factory_->clients_[0], cancel()).Times(0);
+  client_.reset();
+  EXPECT_EQ(1U, reconciler().size());
+
+  global_factory_->last_callbacks_->complete(LimitStatus::OverLimit);
+  EXPECT_EQ(1U, store_.counter("ratelimit.local.reconcile_over_limit").value());
+  EXPECT_EQ(0U, reconciler().size());
+
+  ClientPtr client = factory_.create(Optional<std::chrono::milliseconds>());
+  EXPECT_CALL(request_callbacks_, complete(LimitStatus::OverLimit));
+  client->limit(request_callbacks_, "domain", descriptors_, span_);
+}
+
+TEST_F(LocalRateLimitClientTest, ShutdownCancelsBackgroundCalls) {
+  preauthorize();
+
+  EXPECT_CALL(request_callbacks_, complete(LimitStatus::OK));
+  client_->limit(request_callbacks_, "domain", descriptors_, span_);
+  client_.reset();
+
+  EXPECT_CALL(*global_factory_->clients_[0], cancel());
+  tls_.shutdownThread_();
+}
+
+} // namespace RateLimit
+} // namespace Envoy
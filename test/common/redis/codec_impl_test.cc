@@ -155,6 +155,71 @@ TEST_F(RedisEncoderDecoderImplTest, NestedArray) {
   EXPECT_EQ(value, *decoded_values_[0]);
 }
 
+TEST_F(RedisEncoderDecoderImplTest, LargeBulkString) {
+  const std::string large(DecoderImpl::LARGE_BULK_STRING_SIZE, 'a');
+  buffer_.add("*2\r\n$" + std::to_string(large.size()) + "\r\n" + large + "\r\n$5\r\nsmall\r\n");
+  const std::string encoded = TestUtility::bufferToString(buffer_);
+  decoder_.decode(buffer_);
+  EXPECT_EQ(0UL, buffer_.length());
+
+  // The large bulk string is held in a buffer and moved out of it when encoded.
+  RespValue& value = *decoded_values_[0];
+  EXPECT_TRUE(value.asArray()[0].hasBuffer());
+  EXPECT_EQ(large, TestUtility::bufferToString(value.asArray()[0].asBuffer()));
+  EXPECT_FALSE(value.asArray()[1].hasBuffer());
+  EXPECT_EQ("small", value.asArray()[1].asString());
+
+  encoder_.encode(value, buffer_);
+  EXPECT_EQ(encoded, TestUtility::bufferToString(buffer_));
+  EXPECT_EQ(large.size(), value.asArray()[0].asBuffer().length());
+  buffer_.drain(buffer_.length());
+
+  encoder_.encode(std::move(decoded_values_[0]), buffer_);
+  EXPECT_EQ(encoded, TestUtility::bufferToString(buffer_));
+}
+
+TEST_F(RedisEncoderDecoderImplTest, Copy) {
+  const std::string large(DecoderImpl::LARGE_BULK_STRING_SIZE, 'a');
+  buffer_.add("*3\r\n$" + std::to_string(large.size()) + "\r\n" + large +
+              "\r\n:-5\r\n*1\r\n-error\r\n");
+  decoder_.decode(buffer_);
+
+  RespValue copy(*decoded_values_[0]);
+  EXPECT_TRUE(copy.asArray()[0].hasBuffer());
+  EXPECT_NE(&decoded_values_[0]->asArray()[0].asBuffer(), &copy.asArray()[0].asBuffer());
+  encoder_.encode(copy, buffer_);
+  const std::string encoded = TestUtility::bufferToString(buffer_);
+  buffer_.drain(buffer_.length());
+  encoder_.encode(*decoded_values_[0], buffer_);
+  EXPECT_EQ(encoded, TestUtility::bufferToString(buffer_));
+
+  RespValue assigned;
+  assigned.type(RespType::Integer);
+  assigned = copy;
+  EXPECT_EQ(copy, assigned);
+}
+
+TEST_F(RedisEncoderDecoderImplTest, LargeBulkStringPartial) {
+  const std::string large(DecoderImpl::LARGE_BULK_STRING_SIZE + 1, 'b');
+  const std::string encoded = "$" + std::to_string(large.size()) + "\r\n" + large + "\r\n";
+
+  // Feed the value in pieces that end both in the middle of the length and of the bulk string.
+  for (uint64_t offset = 0; offset < encoded.size(); offset += 1000) {
+    Buffer::OwnedImpl temp_buffer(encoded.substr(offset, 1000));
+    decoder_.decode(temp_buffer);
+    EXPECT_EQ(0UL, temp_buffer.length());
+  }
+
+  ASSERT_EQ(1UL, decoded_values_.size());
+  EXPECT_TRUE(decoded_values_[0]->hasBuffer());
+  EXPECT_EQ("\"" + large + "\"", decoded_values_[0]->toString());
+  EXPECT_TRUE(decoded_values_[0]->hasBuffer());
+
+  // Reading it as a string moves it out of the buffer.
+  EXPECT_EQ(large, decoded_values_[0]->asString());
+  EXPECT_FALSE(decoded_values_[0]->hasBuffer());
+}
+
 TEST_F(RedisEncoderDecoderImplTest, NullArray) {
   buffer_.add("*-1\r\n");
   decoder_.decode(buffer_);
@@ -9,6 +9,8 @@
 
 #include "test/mocks/common.h"
 #include "test/mocks/redis/mocks.h"
+#include "test/mocks/runtime/mocks.h"
+#include "test/mocks/thread_local/mocks.h"
 #include "test/test_common/printers.h"
 
 #include "fmt/format.h"
@@ -19,8 +21,10 @@ using testing::ByRef;
 using testing::DoAll;
 using testing::Eq;
 using testing::InSequence;
+using testing::NiceMock;
 using testing::Ref;
 using testing::Return;
+using testing::ReturnRef;
 using testing::WithArg;
 using testing::_;
 
@@ -43,7 +47,11 @@ public:
 
   ConnPool::MockInstance* conn_pool_{new ConnPool::MockInstance()};
   Stats::IsolatedStoreImpl store_;
-  InstanceImpl splitter_{ConnPool::InstancePtr{conn_pool_}, store_, "redis.foo."};
+  NiceMock<Runtime::MockLoader> runtime_;
+  NiceMock<ThreadLocal::MockInstance> tls_;
+  NiceMock<MockMonotonicTimeSource> time_source_;
+  InstanceImpl splitter_{ConnPool::InstancePtr{conn_pool_}, store_, "redis.foo.", runtime_, tls_,
+                         time_source_};
   MockSplitCallbacks callbacks_;
   SplitRequestPtr handle_;
 };
@@ -195,6 +203,73 @@ TEST_P(RedisSingleServerRequestTest, NoUpstream) {
   EXPECT_EQ(nullptr, handle_);
 };
 
+TEST_P(RedisSingleServerRequestTest, Redirected) {
+  InSequence s;
+
+  RespValue request;
+  makeBulkStringArray(request, {GetParam(), "hello"});
+  makeRequest("hello", request);
+  EXPECT_NE(nullptr, handle_);
+
+  // The request is made again where the redirection points to, once.
+  RespValuePtr moved(new RespValue());
+  moved->type(RespType::Error);
+  moved->asString() = "MOVED 866 10.0.0.2:6379";
+  RespValue expected_moved;
+  expected_moved.type(RespType::Error);
+  expected_moved.asString() = "MOVED 866 10.0.0.2:6379";
+  ConnPool::MockPoolRequest redirected_request;
+  EXPECT_CALL(*conn_pool_, makeRedirectedRequest(Eq(ByRef(expected_moved)), Ref(request), _))
+      .WillOnce(Return(&redirected_request));
+  pool_callbacks_->onResponse(std::move(moved));
+
+  RespValuePtr moved_again(new RespValue());
+  moved_again->type(RespType::Error);
+  moved_again->asString() = "MOVED 866 10.0.0.3:6379";
+  RespValue* moved_again_ptr = moved_again.get();
+  EXPECT_CALL(*conn_pool_, makeRedirectedRequest(_, _, _)).Times(0);
+  EXPECT_CALL(callbacks_, onResponse_(PointeesEq(moved_again_ptr)));
+  pool_callbacks_->onResponse(std::move(moved_again));
+};
+
+TEST_P(RedisSingleServerRequestTest, RedirectedCancel) {
+  InSequence s;
+
+  RespValue request;
+  makeBulkStringArray(request, {GetParam(), "hello"});
+  makeRequest("hello", request);
+  EXPECT_NE(nullptr, handle_);
+
+  RespValuePtr ask(new RespValue());
+  ask->type(RespType::Error);
+  ask->asString() = "ASK 866 10.0.0.2:6379";
+  ConnPool::MockPoolRequest redirected_request;
+  EXPECT_CALL(*conn_pool_, makeRedirectedRequest(_, Ref(request), _))
+      .WillOnce(Return(&redirected_request));
+  pool_callbacks_->onResponse(std::move(ask));
+
+  EXPECT_CALL(redirected_request, cancel());
+  handle_->cancel();
+};
+
+TEST_P(RedisSingleServerRequestTest, ErrorNotRedirected) {
+  InSequence s;
+
+  RespValue request;
+  makeBulkStringArray(request, {GetParam(), "hello"});
+  makeRequest("hello", request);
+  EXPECT_NE(nullptr, handle_);
+
+  RespValuePtr error(new RespValue());
+  error->type(RespType::Error);
+  error->asString() = "ERR wrong type";
+  RespValue* error_ptr = error.get();
+  EXPECT_CALL(*conn_pool_, makeRedirectedRequest(_, Ref(request), _))
+      .WillOnce(Return(nullptr));
+  EXPECT_CALL(callbacks_, onResponse_(PointeesEq(error_ptr)));
+  pool_callbacks_->onResponse(std::move(error));
+};
+
 INSTANTIATE_TEST_CASE_P(RedisSingleServerRequestTest, RedisSingleServerRequestTest,
                         testing::ValuesIn(SupportedCommands::simpleCommands()));
 
@@ -267,6 +342,80 @@ TEST_F(RedisSingleServerRequestTest, EvalNoUpstream) {
   EXPECT_EQ(nullptr, handle_);
 };
 
+TEST_F(RedisSingleServerRequestTest, ReadFromReplicas) {
+  InSequence s;
+
+  ON_CALL(runtime_.snapshot_, featureEnabled("redis.read_from_replicas", 0))
+      .WillByDefault(Return(true));
+
+  RespValue request;
+  makeBulkStringArray(request, {"get", "hello"});
+  EXPECT_CALL(*conn_pool_, makeReplicaRequest("hello", Ref(request), _))
+      .WillOnce(DoAll(WithArg<2>(SaveArgAddress(&pool_callbacks_)), Return(&pool_request_)));
+  handle_ = splitter_.makeRequest(request, callbacks_);
+  EXPECT_NE(nullptr, handle_);
+  respond();
+
+  // Writes are always made to the host that serves the key.
+  RespValue write_request;
+  makeBulkStringArray(write_request, {"set", "hello", "world"});
+  makeRequest("hello", write_request);
+  EXPECT_NE(nullptr, handle_);
+  respond();
+};
+
+TEST_F(RedisSingleServerRequestTest, HotKeyCache) {
+  const std::string prefixes{"hot:"};
+  ON_CALL(runtime_.snapshot_, getInteger("redis.hot_key_cache.ttl_ms", 0))
+      .WillByDefault(Return(1000));
+  ON_CALL(runtime_.snapshot_, get("redis.hot_key_cache.prefixes"))
+      .WillByDefault(ReturnRef(prefixes));
+  ON_CALL(time_source_, currentTime()).WillByDefault(Return(MonotonicTime()));
+
+  RespValue request;
+  makeBulkStringArray(request, {"get", "hot:hello"});
+  RespValue value;
+  value.type(RespType::BulkString);
+  value.asString() = "world";
+
+  // Errors are not cached.
+  makeRequest("hot:hello", request);
+  EXPECT_NE(nullptr, handle_);
+  fail();
+
+  makeRequest("hot:hello", request);
+  EXPECT_NE(nullptr, handle_);
+  EXPECT_CALL(callbacks_, onResponse_(PointeesEq(&value)));
+  pool_callbacks_->onResponse(RespValuePtr{new RespValue(value)});
+  EXPECT_EQ(2UL, store_.counter("redis.foo.splitter.hot_key_cache_miss").value());
+
+  EXPECT_CALL(callbacks_, onResponse_(PointeesEq(&value)));
+  EXPECT_EQ(nullptr, splitter_.makeRequest(request, callbacks_));
+  EXPECT_EQ(1UL, store_.counter("redis.foo.splitter.hot_key_cache_hit").value());
+
+  // Keys without a cached prefix are not looked up.
+  RespValue cold_request;
+  makeBulkStringArray(cold_request, {"get", "cold:hello"});
+  makeRequest("cold:hello", cold_request);
+  EXPECT_NE(nullptr, handle_);
+  respond();
+
+  // A write drops the cached response.
+  RespValue write_request;
+  makeBulkStringArray(write_request, {"set", "hot:hello", "world"});
+  makeRequest("hot:hello", write_request);
+  EXPECT_NE(nullptr, handle_);
+  respond();
+
+  makeRequest("hot:hello", request);
+  EXPECT_NE(nullptr, handle_);
+  EXPECT_EQ(3UL, store_.counter("redis.foo.splitter.hot_key_cache_miss").value());
+
+  EXPECT_CALL(pool_request_, cancel());
+  handle_->cancel();
+  EXPECT_EQ(1UL, store_.counter("redis.foo.splitter.hot_key_cache_hit").value());
+};
+
 class RedisMGETCommandHandlerTest : public RedisCommandSplitterImplTest {
 public:
   void setup(uint32_t num_gets, const std::list<uint64_t>& null_handle_indexes) {
@@ -277,6 +426,7 @@ public:
 
     RespValue request;
     makeBulkStringArray(request, request_strings);
+    EXPECT_CALL(*conn_pool_, groupKeys(_));
 
     std::vector<RespValue> tmp_expected_requests(num_gets);
     expected_requests_.swap(tmp_expected_requests);
@@ -449,6 +599,80 @@ TEST_F(RedisMGETCommandHandlerTest, Cancel) {
   handle_->cancel();
 };
 
+TEST_F(RedisMGETCommandHandlerTest, Grouped) {
+  InSequence s;
+
+  RespValue request;
+  makeBulkStringArray(request, {"mget", "a", "b", "c"});
+  EXPECT_CALL(*conn_pool_, groupKeys(_))
+      .WillOnce(Return(std::vector<std::vector<uint32_t>>{{0, 2}, {1}}));
+  RespValue expected_mget;
+  makeBulkStringArray(expected_mget, {"mget", "a", "c"});
+  RespValue expected_get;
+  makeBulkStringArray(expected_get, {"get", "b"});
+  pool_callbacks_.resize(2);
+  std::vector<ConnPool::MockPoolRequest> pool_requests(2);
+  pool_requests_.swap(pool_requests);
+  EXPECT_CALL(*conn_pool_, makeRequest("a", Eq(ByRef(expected_mget)), _))
+      .WillOnce(DoAll(WithArg<2>(SaveArgAddress(&pool_callbacks_[0])), Return(&pool_requests_[0])));
+  EXPECT_CALL(*conn_pool_, makeRequest("b", Eq(ByRef(expected_get)), _))
+      .WillOnce(DoAll(WithArg<2>(SaveArgAddress(&pool_callbacks_[1])), Return(&pool_requests_[1])));
+  handle_ = splitter_.makeRequest(request, callbacks_);
+  EXPECT_NE(nullptr, handle_);
+
+  RespValue expected_response;
+  expected_response.type(RespType::Array);
+  std::vector<RespValue> elements(3);
+  elements[0].type(RespType::BulkString);
+  elements[0].asString() = "1";
+  elements[1].type(RespType::BulkString);
+  elements[1].asString() = "2";
+  expected_response.asArray().swap(elements);
+
+  RespValuePtr get_response(new RespValue());
+  get_response->type(RespType::BulkString);
+  get_response->asString() = "2";
+  pool_callbacks_[1]->onResponse(std::move(get_response));
+
+  // The values of the MGET are assigned to its keys in order.
+  RespValuePtr mget_response(new RespValue());
+  mget_response->type(RespType::Array);
+  std::vector<RespValue> values(2);
+  values[0].type(RespType::BulkString);
+  values[0].asString() = "1";
+  mget_response->asArray().swap(values);
+  EXPECT_CALL(callbacks_, onResponse_(PointeesEq(&expected_response)));
+  pool_callbacks_[0]->onResponse(std::move(mget_response));
+};
+
+TEST_F(RedisMGETCommandHandlerTest, GroupedError) {
+  InSequence s;
+
+  RespValue request;
+  makeBulkStringArray(request, {"mget", "a", "b"});
+  EXPECT_CALL(*conn_pool_, groupKeys(_))
+      .WillOnce(Return(std::vector<std::vector<uint32_t>>{{0, 1}}));
+  pool_callbacks_.resize(1);
+  std::vector<ConnPool::MockPoolRequest> pool_requests(1);
+  pool_requests_.swap(pool_requests);
+  EXPECT_CALL(*conn_pool_, makeRequest("a", _, _))
+      .WillOnce(DoAll(WithArg<2>(SaveArgAddress(&pool_callbacks_[0])), Return(&pool_requests_[0])));
+  handle_ = splitter_.makeRequest(request, callbacks_);
+  EXPECT_NE(nullptr, handle_);
+
+  // An error of the whole MGET is the response for each of its keys.
+  RespValue expected_response;
+  expected_response.type(RespType::Array);
+  std::vector<RespValue> elements(2);
+  elements[0].type(RespType::Error);
+  elements[0].asString() = "upstream failure";
+  elements[1].type(RespType::Error);
+  elements[1].asString() = "upstream failure";
+  expected_response.asArray().swap(elements);
+  EXPECT_CALL(callbacks_, onResponse_(PointeesEq(&expected_response)));
+  pool_callbacks_[0]->onFailure();
+};
+
 class RedisMSETCommandHandlerTest : public RedisCommandSplitterImplTest {
 public:
   void setup(uint32_t num_sets, const std::list<uint64_t>& null_handle_indexes) {
@@ -462,6 +686,7 @@ public:
 
     RespValue request;
     makeBulkStringArray(request, request_strings);
+    EXPECT_CALL(*conn_pool_, groupKeys(_));
 
     std::vector<RespValue> tmp_expected_requests(num_sets);
     expected_requests_.swap(tmp_expected_requests);
@@ -563,6 +788,40 @@ TEST_F(RedisMSETCommandHandlerTest, WrongNumberOfArgs) {
   EXPECT_EQ(nullptr, splitter_.makeRequest(request, callbacks_));
 };
 
+TEST_F(RedisMSETCommandHandlerTest, Grouped) {
+  InSequence s;
+
+  RespValue request;
+  makeBulkStringArray(request, {"mset", "a", "1", "b", "2", "c", "3"});
+  EXPECT_CALL(*conn_pool_, groupKeys(_))
+      .WillOnce(Return(std::vector<std::vector<uint32_t>>{{0, 2}, {1}}));
+  RespValue expected_mset;
+  makeBulkStringArray(expected_mset, {"mset", "a", "1", "c", "3"});
+  RespValue expected_set;
+  makeBulkStringArray(expected_set, {"set", "b", "2"});
+  pool_callbacks_.resize(2);
+  std::vector<ConnPool::MockPoolRequest> pool_requests(2);
+  pool_requests_.swap(pool_requests);
+  EXPECT_CALL(*conn_pool_, makeRequest("a", Eq(ByRef(expected_mset)), _))
+      .WillOnce(DoAll(WithArg<2>(SaveArgAddress(&pool_callbacks_[0])), Return(&pool_requests_[0])));
+  EXPECT_CALL(*conn_pool_, makeRequest("b", Eq(ByRef(expected_set)), _))
+      .WillOnce(DoAll(WithArg<2>(SaveArgAddress(&pool_callbacks_[1])), Return(&pool_requests_[1])));
+  handle_ = splitter_.makeRequest(request, callbacks_);
+  EXPECT_NE(nullptr, handle_);
+
+  RespValuePtr set_response(new RespValue());
+  set_response->type(RespType::SimpleString);
+  set_response->asString() = "OK";
+  pool_callbacks_[1]->onResponse(std::move(set_response));
+
+  // Errors are counted per key.
+  RespValue expected_response;
+  expected_response.type(RespType::Error);
+  expected_response.asString() = "finished with 2 error(s)";
+  EXPECT_CALL(callbacks_, onResponse_(PointeesEq(&expected_response)));
+  pool_callbacks_[0]->onFailure();
+};
+
 class RedisSplitKeysSumResultHandlerTest : public RedisCommandSplitterImplTest,
                                            public testing::WithParamInterface<std::string> {
 public:
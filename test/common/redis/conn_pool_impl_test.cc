@@ -5,6 +5,8 @@
 #include "common/redis/conn_pool_impl.h"
 #include "common/upstream/upstream_impl.h"
 
+#include "test/common/upstream/utility.h"
+#include "test/mocks/buffer/mocks.h"
 #include "test/mocks/network/mocks.h"
 #include "test/mocks/redis/mocks.h"
 #include "test/mocks/thread_local/mocks.h"
@@ -14,9 +16,12 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
+using testing::ByRef;
 using testing::Eq;
 using testing::InSequence;
 using testing::Invoke;
+using testing::NiceMock;
+using testing::Property;
 using testing::Ref;
 using testing::Return;
 using testing::ReturnRef;
@@ -87,6 +92,8 @@ public:
   const std::string cluster_name_{"foo"};
   std::shared_ptr<Upstream::MockHost> host_{new NiceMock<Upstream::MockHost>()};
   Event::MockDispatcher dispatcher_;
+  // Created before connect_or_op_timer_ so that it is handed out second.
+  Event::MockTimer* flush_timer_{new NiceMock<Event::MockTimer>(&dispatcher_)};
   Event::MockTimer* connect_or_op_timer_{new Event::MockTimer(&dispatcher_)};
   MockEncoder* encoder_{new MockEncoder()};
   MockDecoder* decoder_{new MockDecoder()};
@@ -115,6 +122,7 @@ TEST_F(RedisClientImplTest, Basic) {
   EXPECT_CALL(*encoder_, encode(Ref(request2), _));
   PoolRequest* handle2 = client_->makeRequest(request2, callbacks2);
   EXPECT_NE(nullptr, handle2);
+  flush_timer_->callback_();
 
   EXPECT_EQ(2UL, host_->cluster_.stats_.upstream_rq_total_.value());
   EXPECT_EQ(2UL, host_->cluster_.stats_.upstream_rq_active_.value());
@@ -161,6 +169,7 @@ TEST_F(RedisClientImplTest, Cancel) {
   EXPECT_CALL(*encoder_, encode(Ref(request2), _));
   PoolRequest* handle2 = client_->makeRequest(request2, callbacks2);
   EXPECT_NE(nullptr, handle2);
+  flush_timer_->callback_();
 
   handle1->cancel();
 
@@ -355,6 +364,74 @@ TEST_F(RedisClientImplTest, OpTimeout) {
   EXPECT_EQ(1UL, host_->cluster_.stats_.upstream_rq_timeout_.value());
 }
 
+TEST_F(RedisClientImplTest, BatchRequests) {
+  InSequence s;
+
+  setup();
+
+  // Requests made in the same dispatcher iteration are written together once it has run them.
+  RespValue request1;
+  MockPoolCallbacks callbacks1;
+  EXPECT_CALL(*encoder_, encode(Ref(request1), _))
+      .WillOnce(Invoke([](const RespValue&, Buffer::Instance& out) -> void { out.add("1"); }));
+  EXPECT_CALL(*flush_timer_, enableTimer(std::chrono::milliseconds(0)));
+  client_->makeRequest(request1, callbacks1);
+
+  onConnected();
+
+  RespValue request2;
+  MockPoolCallbacks callbacks2;
+  EXPECT_CALL(*encoder_, encode(Ref(request2), _))
+      .WillOnce(Invoke([](const RespValue&, Buffer::Instance& out) -> void { out.add("2"); }));
+  client_->makeRequest(request2, callbacks2);
+
+  EXPECT_CALL(host_->cluster_.stats_store_,
+              deliverHistogramToSinks(
+                  Property(&Stats::Metric::name, "redis.upstream_rq_batch_size"), 2));
+  EXPECT_CALL(host_->cluster_.stats_store_,
+              deliverHistogramToSinks(
+                  Property(&Stats::Metric::name, "redis.upstream_rq_pipeline_depth"), 2));
+  EXPECT_CALL(*upstream_connection_, write(BufferStringEqual("12")))
+      .WillOnce(Invoke([](Buffer::Instance& data) -> void { data.drain(data.length()); }));
+  flush_timer_->callback_();
+
+  // A request that fills the buffer is written right away, along with those before it.
+  RespValue request3;
+  MockPoolCallbacks callbacks3;
+  EXPECT_CALL(*encoder_, encode(Ref(request3), _))
+      .WillOnce(Invoke([](const RespValue&, Buffer::Instance& out) -> void { out.add("3"); }));
+  EXPECT_CALL(*flush_timer_, enableTimer(std::chrono::milliseconds(0)));
+  client_->makeRequest(request3, callbacks3);
+
+  const std::string big(64 * 1024, 'a');
+  RespValue request4;
+  MockPoolCallbacks callbacks4;
+  EXPECT_CALL(*encoder_, encode(Ref(request4), _))
+      .WillOnce(Invoke([&](const RespValue&, Buffer::Instance& out) -> void { out.add(big); }));
+  EXPECT_CALL(host_->cluster_.stats_store_,
+              deliverHistogramToSinks(
+                  Property(&Stats::Metric::name, "redis.upstream_rq_batch_size"), 2));
+  EXPECT_CALL(host_->cluster_.stats_store_,
+              deliverHistogramToSinks(
+                  Property(&Stats::Metric::name, "redis.upstream_rq_pipeline_depth"), 4));
+  EXPECT_CALL(*upstream_connection_, write(BufferStringEqual("3" + big)))
+      .WillOnce(Invoke([](Buffer::Instance& data) -> void { data.drain(data.length()); }));
+  client_->makeRequest(request4, callbacks4);
+
+  // Nothing is left to write once the timer fires.
+  EXPECT_CALL(*upstream_connection_, write(_)).Times(0);
+  flush_timer_->callback_();
+
+  EXPECT_CALL(*upstream_connection_, close(Network::ConnectionCloseType::NoFlush));
+  EXPECT_CALL(callbacks1, onFailure());
+  EXPECT_CALL(callbacks2, onFailure());
+  EXPECT_CALL(callbacks3, onFailure());
+  EXPECT_CALL(callbacks4, onFailure());
+  EXPECT_CALL(*connect_or_op_timer_, disableTimer());
+  EXPECT_CALL(*flush_timer_, disableTimer());
+  client_->close();
+}
+
 TEST(RedisClientFactoryImplTest, Basic) {
   ClientFactoryImpl factory;
   Upstream::MockHost::MockCreateConnectionData conn_info;
@@ -479,6 +556,246 @@ TEST_F(RedisConnPoolImplTest, RemoteClose) {
   tls_.shutdownThread();
 }
 
+TEST(RedisClusterSlotTest, ClusterSlot) {
+  EXPECT_EQ(12739, InstanceImpl::clusterSlot("123456789"));
+  EXPECT_EQ(12182, InstanceImpl::clusterSlot("foo"));
+  EXPECT_EQ(5061, InstanceImpl::clusterSlot("bar"));
+  EXPECT_EQ(0, InstanceImpl::clusterSlot(""));
+
+  // Only the hash tag is hashed, unless it is empty.
+  EXPECT_EQ(InstanceImpl::clusterSlot("user1000"),
+            InstanceImpl::clusterSlot("{user1000}.following"));
+  EXPECT_EQ(InstanceImpl::clusterSlot("{bar"), InstanceImpl::clusterSlot("foo{{bar}}zap"));
+  EXPECT_EQ(8363, InstanceImpl::clusterSlot("foo{}{bar}"));
+  EXPECT_EQ(15278, InstanceImpl::clusterSlot("foo{bar"));
+}
+
+class RedisConnPoolRedirectionTest : public RedisConnPoolImplTest {
+public:
+  RedisConnPoolRedirectionTest() {
+    cm_.thread_local_cluster_.cluster_.prioritySet().getMockHostSet(0)->hosts_ = {host1_, host2_};
+  }
+
+  static void makeBulkStringArray(RespValue& value, const std::vector<std::string>& strings) {
+    std::vector<RespValue> values(strings.size());
+    for (uint64_t i = 0; i < strings.size(); i++) {
+      values[i].type(RespType::BulkString);
+      values[i].asString() = strings[i];
+    }
+    value.type(RespType::Array);
+    value.asArray().swap(values);
+  }
+
+  static RespValuePtr makeError(const std::string& error) {
+    RespValuePtr value(new RespValue());
+    value->type(RespType::Error);
+    value->asString() = error;
+    return value;
+  }
+
+  Upstream::HostSharedPtr host1_{
+      Upstream::makeTestHost(cm_.thread_local_cluster_.cluster_.info_, "tcp://10.0.0.1:6379")};
+  Upstream::HostSharedPtr host2_{
+      Upstream::makeTestHost(cm_.thread_local_cluster_.cluster_.info_, "tcp://10.0.0.2:6379")};
+};
+
+TEST_F(RedisConnPoolRedirectionTest, GroupKeys) {
+  InSequence s;
+
+  const std::string a("a"), b("b"), c("c"), d("d");
+  EXPECT_CALL(cm_.thread_local_cluster_.lb_, chooseHost(_))
+      .WillOnce(Return(host1_))
+      .WillOnce(Return(host2_))
+      .WillOnce(Return(host1_))
+      .WillOnce(Return(nullptr));
+  EXPECT_EQ((std::vector<std::vector<uint32_t>>{{0, 2}, {1}, {3}}),
+            conn_pool_->groupKeys({&a, &b, &c, &d}));
+
+  tls_.shutdownThread();
+}
+
+TEST_F(RedisConnPoolRedirectionTest, NotRedirection) {
+  RespValue value;
+  MockPoolCallbacks callbacks;
+  EXPECT_EQ(nullptr, conn_pool_->makeRedirectedRequest(*makeError("ERR wrong type"), value,
+                                                       callbacks));
+  EXPECT_EQ(nullptr, conn_pool_->makeRedirectedRequest(*makeError("MOVED 12182"), value,
+                                                       callbacks));
+  EXPECT_EQ(nullptr, conn_pool_->makeRedirectedRequest(*makeError("MOVED 16384 10.0.0.2:6379"),
+                                                       value, callbacks));
+  // Hosts that are not part of the cluster are not redirected to.
+  EXPECT_EQ(nullptr, conn_pool_->makeRedirectedRequest(*makeError("MOVED 12182 10.0.0.3:6379"),
+                                                       value, callbacks));
+
+  tls_.shutdownThread();
+}
+
+TEST_F(RedisConnPoolRedirectionTest, Moved) {
+  InSequence s;
+
+  RespValue value;
+  MockPoolCallbacks callbacks;
+  MockPoolRequest active_request;
+  MockPoolRequest refresh_request;
+  MockClient* client1 = new NiceMock<MockClient>();
+  MockClient* client2 = new NiceMock<MockClient>();
+
+  // A MOVED redirection routes the slot to the named host and refreshes the slot map from it.
+  RespValue cluster_slots;
+  makeBulkStringArray(cluster_slots, {"CLUSTER", "SLOTS"});
+  PoolCallbacks* refresh_callbacks{};
+  EXPECT_CALL(*this, create_(Eq(host2_))).WillOnce(Return(client2));
+  EXPECT_CALL(*client2, makeRequest(Eq(ByRef(cluster_slots)), _))
+      .WillOnce(Invoke([&](const RespValue&, PoolCallbacks& callbacks) -> PoolRequest* {
+        refresh_callbacks = &callbacks;
+        return &refresh_request;
+      }));
+  EXPECT_CALL(*client2, makeRequest(Ref(value), Ref(callbacks))).WillOnce(Return(&active_request));
+  EXPECT_EQ(&active_request, conn_pool_->makeRedirectedRequest(
+                                 *makeError("MOVED 12182 10.0.0.2:6379"), value, callbacks));
+
+  EXPECT_CALL(cm_.thread_local_cluster_.lb_, chooseHost(_)).Times(0);
+  EXPECT_CALL(*client2, makeRequest(Ref(value), Ref(callbacks))).WillOnce(Return(&active_request));
+  EXPECT_EQ(&active_request, conn_pool_->makeRequest("foo", value, callbacks));
+
+  // Slots whose host is not known yet are routed by the load balancer.
+  EXPECT_CALL(cm_.thread_local_cluster_.lb_, chooseHost(_)).WillOnce(Return(host2_));
+  EXPECT_CALL(*client2, makeRequest(Ref(value), Ref(callbacks))).WillOnce(Return(&active_request));
+  EXPECT_EQ(&active_request, conn_pool_->makeRequest("bar", value, callbacks));
+
+  // CLUSTER SLOTS replaces the slot map. Ranges of unknown hosts are ignored.
+  RespValuePtr slots(new RespValue());
+  slots->type(RespType::Array);
+  struct SlotRange {
+    int64_t first_;
+    int64_t last_;
+    std::string ip_;
+  };
+  for (const SlotRange& range : std::vector<SlotRange>{
+           {0, 5460, "10.0.0.1"}, {5461, 10922, "10.0.0.3"}, {10923, 16383, "10.0.0.2"}}) {
+    std::vector<RespValue> values(3);
+    values[0].type(RespType::Integer);
+    values[0].asInteger() = range.first_;
+    values[1].type(RespType::Integer);
+    values[1].asInteger() = range.last_;
+    makeBulkStringArray(values[2], {range.ip_, ""});
+    values[2].asArray()[1].type(RespType::Integer);
+    values[2].asArray()[1].asInteger() = 6379;
+    slots->asArray().emplace_back();
+    slots->asArray().back().type(RespType::Array);
+    slots->asArray().back().asArray().swap(values);
+  }
+  refresh_callbacks->onResponse(std::move(slots));
+
+  EXPECT_CALL(*this, create_(Eq(host1_))).WillOnce(Return(client1));
+  EXPECT_CALL(*client1, makeRequest(Ref(value), Ref(callbacks))).WillOnce(Return(&active_request));
+  EXPECT_EQ(&active_request, conn_pool_->makeRequest("bar", value, callbacks));
+
+  EXPECT_CALL(*client2, makeRequest(Ref(value), Ref(callbacks))).WillOnce(Return(&active_request));
+  EXPECT_EQ(&active_request, conn_pool_->makeRequest("{foo}bar", value, callbacks));
+
+  // Keys are only grouped with keys of the same slot.
+  const std::string foo("foo"), tagged_foo("{foo}bar"), bar("bar"), other("123456789");
+  EXPECT_EQ((std::vector<std::vector<uint32_t>>{{0, 1}, {2}, {3}}),
+            conn_pool_->groupKeys({&foo, &tagged_foo, &bar, &other}));
+
+  // Slots of removed hosts are routed by the load balancer again.
+  EXPECT_CALL(*client1, close());
+  cm_.thread_local_cluster_.cluster_.prioritySet().getMockHostSet(0)->runCallbacks({}, {host1_});
+  EXPECT_CALL(cm_.thread_local_cluster_.lb_, chooseHost(_)).WillOnce(Return(host2_));
+  EXPECT_CALL(*client2, makeRequest(Ref(value), Ref(callbacks))).WillOnce(Return(&active_request));
+  EXPECT_EQ(&active_request, conn_pool_->makeRequest("bar", value, callbacks));
+
+  EXPECT_CALL(*client2, close());
+  tls_.shutdownThread();
+}
+
+TEST_F(RedisConnPoolRedirectionTest, Ask) {
+  InSequence s;
+
+  RespValue value;
+  MockPoolCallbacks callbacks;
+  MockPoolRequest active_request;
+  MockClient* client2 = new NiceMock<MockClient>();
+
+  // An ASK redirection is preceded by ASKING and leaves the slot map alone.
+  RespValue asking;
+  makeBulkStringArray(asking, {"ASKING"});
+  EXPECT_CALL(*this, create_(Eq(host2_))).WillOnce(Return(client2));
+  EXPECT_CALL(*client2, makeRequest(Eq(ByRef(asking)), _));
+  EXPECT_CALL(*client2, makeRequest(Ref(value), Ref(callbacks))).WillOnce(Return(&active_request));
+  EXPECT_EQ(&active_request, conn_pool_->makeRedirectedRequest(
+                                 *makeError("ASK 12182 10.0.0.2:6379"), value, callbacks));
+
+  EXPECT_CALL(cm_.thread_local_cluster_.lb_, chooseHost(_)).WillOnce(Return(host2_));
+  EXPECT_CALL(*client2, makeRequest(Ref(value), Ref(callbacks))).WillOnce(Return(&active_request));
+  EXPECT_EQ(&active_request, conn_pool_->makeRequest("foo", value, callbacks));
+
+  EXPECT_CALL(*client2, close());
+  tls_.shutdownThread();
+}
+
+TEST_F(RedisConnPoolRedirectionTest, Replica) {
+  InSequence s;
+
+  RespValue value;
+  MockPoolCallbacks callbacks;
+  MockPoolRequest active_request;
+  MockPoolRequest refresh_request;
+  MockClient* client1 = new NiceMock<MockClient>();
+  MockClient* client2 = new NiceMock<MockClient>();
+
+  // Without a slot map there are no known replicas.
+  EXPECT_CALL(cm_.thread_local_cluster_.lb_, chooseHost(_)).WillOnce(Return(host1_));
+  EXPECT_CALL(*this, create_(Eq(host1_))).WillOnce(Return(client1));
+  EXPECT_CALL(*client1, makeRequest(Ref(value), Ref(callbacks))).WillOnce(Return(&active_request));
+  EXPECT_EQ(&active_request, conn_pool_->makeReplicaRequest("foo", value, callbacks));
+
+  PoolCallbacks* refresh_callbacks{};
+  EXPECT_CALL(*client1, makeRequest(_, _))
+      .WillOnce(Invoke([&](const RespValue&, PoolCallbacks& callbacks) -> PoolRequest* {
+        refresh_callbacks = &callbacks;
+        return &refresh_request;
+      }));
+  EXPECT_CALL(*client1, makeRequest(Ref(value), Ref(callbacks))).WillOnce(Return(&active_request));
+  EXPECT_EQ(&active_request, conn_pool_->makeRedirectedRequest(
+                                 *makeError("MOVED 12182 10.0.0.1:6379"), value, callbacks));
+
+  RespValuePtr slots(new RespValue());
+  slots->type(RespType::Array);
+  std::vector<RespValue> range(4);
+  range[0].type(RespType::Integer);
+  range[0].asInteger() = 0;
+  range[1].type(RespType::Integer);
+  range[1].asInteger() = 16383;
+  makeBulkStringArray(range[2], {"10.0.0.1", ""});
+  makeBulkStringArray(range[3], {"10.0.0.2", ""});
+  for (uint64_t i = 2; i < range.size(); i++) {
+    range[i].asArray()[1].type(RespType::Integer);
+    range[i].asArray()[1].asInteger() = 6379;
+  }
+  slots->asArray().resize(1);
+  slots->asArray()[0].type(RespType::Array);
+  slots->asArray()[0].asArray().swap(range);
+  refresh_callbacks->onResponse(std::move(slots));
+
+  // Replicas are told to serve reads once per connection.
+  RespValue readonly;
+  makeBulkStringArray(readonly, {"READONLY"});
+  EXPECT_CALL(*this, create_(Eq(host2_))).WillOnce(Return(client2));
+  EXPECT_CALL(*client2, makeRequest(Eq(ByRef(readonly)), _));
+  EXPECT_CALL(*client2, makeRequest(Ref(value), Ref(callbacks))).WillOnce(Return(&active_request));
+  EXPECT_EQ(&active_request, conn_pool_->makeReplicaRequest("foo", value, callbacks));
+
+  EXPECT_CALL(*client2, makeRequest(Ref(value), Ref(callbacks))).WillOnce(Return(&active_request));
+  EXPECT_EQ(&active_request, conn_pool_->makeReplicaRequest("bar", value, callbacks));
+
+  EXPECT_CALL(*client1, makeRequest(Ref(value), Ref(callbacks))).WillOnce(Return(&active_request));
+  EXPECT_EQ(&active_request, conn_pool_->makeRequest("foo", value, callbacks));
+
+  tls_.shutdownThread();
+}
+
 } // namespace ConnPool
 } // namespace Redis
 } // namespace Envoy
@@ -0,0 +1,148 @@
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "common/redis/hot_key_cache.h"
+
+#include "test/mocks/common.h"
+#include "test/mocks/redis/mocks.h"
+#include "test/mocks/runtime/mocks.h"
+#include "test/mocks/thread_local/mocks.h"
+#include "test/test_common/printers.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::Invoke;
+using testing::NiceMock;
+using testing::Return;
+using testing::ReturnRef;
+
+namespace Envoy {
+namespace Redis {
+
+class RedisHotKeyCacheTest : public testing::Test {
+public:
+  RedisHotKeyCacheTest() {
+    ON_CALL(runtime_.snapshot_, getInteger("redis.hot_key_cache.ttl_ms", 0))
+        .WillByDefault(Return(1000));
+    ON_CALL(runtime_.snapshot_, get("redis.hot_key_cache.prefixes"))
+        .WillByDefault(ReturnRef(prefixes_));
+    ON_CALL(time_source_, currentTime()).WillByDefault(Invoke([this]() { return now_; }));
+  }
+
+  RespValue makeRequest(const std::vector<std::string>& strings) {
+    std::vector<RespValue> values(strings.size());
+    for (uint64_t i = 0; i < strings.size(); i++) {
+      values[i].type(RespType::BulkString);
+      values[i].asString() = strings[i];
+    }
+
+    RespValue request;
+    request.type(RespType::Array);
+    request.asArray().swap(values);
+    return request;
+  }
+
+  RespValue makeResponse(const std::string& value) {
+    RespValue response;
+    response.type(RespType::BulkString);
+    response.asString() = value;
+    return response;
+  }
+
+  std::string prefixes_{"a:,b:"};
+  MonotonicTime now_;
+  NiceMock<Runtime::MockLoader> runtime_;
+  NiceMock<ThreadLocal::MockInstance> tls_;
+  NiceMock<MockMonotonicTimeSource> time_source_;
+  HotKeyCache cache_{runtime_, tls_, time_source_};
+};
+
+TEST_F(RedisHotKeyCacheTest, Enabled) {
+  EXPECT_TRUE(cache_.enabled("a:1"));
+  EXPECT_TRUE(cache_.enabled("b:1"));
+  EXPECT_FALSE(cache_.enabled("c:1"));
+  EXPECT_FALSE(cache_.enabled("a"));
+
+  // Prefixes are picked up when they change.
+  prefixes_ = "c:";
+  EXPECT_FALSE(cache_.enabled("a:1"));
+  EXPECT_TRUE(cache_.enabled("c:1"));
+
+  EXPECT_CALL(runtime_.snapshot_, getInteger("redis.hot_key_cache.ttl_ms", 0))
+      .WillRepeatedly(Return(0));
+  EXPECT_FALSE(cache_.enabled("c:1"));
+}
+
+TEST_F(RedisHotKeyCacheTest, LookupInsert) {
+  const RespValue request = makeRequest({"hget", "a:1", "field"});
+  const RespValue other_request = makeRequest({"hget", "a:1", "other"});
+  const RespValue response = makeResponse("value");
+
+  uint64_t generation;
+  EXPECT_EQ(nullptr, cache_.lookup(request, generation));
+  cache_.insert(request, response, generation);
+
+  RespValuePtr cached = cache_.lookup(request, generation);
+  ASSERT_NE(nullptr, cached);
+  EXPECT_EQ(response, *cached);
+
+  // Responses are cached by all arguments of the request.
+  EXPECT_EQ(nullptr, cache_.lookup(other_request, generation));
+  EXPECT_EQ(nullptr, cache_.lookup(makeRequest({"hget", "a:2", "field"}), generation));
+
+  // Until they expire.
+  now_ += std::chrono::milliseconds(1000);
+  EXPECT_EQ(nullptr, cache_.lookup(request, generation));
+}
+
+TEST_F(RedisHotKeyCacheTest, Invalidate) {
+  const RespValue request = makeRequest({"get", "a:1"});
+  const RespValue response = makeResponse("value");
+
+  uint64_t generation;
+  EXPECT_EQ(nullptr, cache_.lookup(request, generation));
+  cache_.insert(request, response, generation);
+  cache_.invalidate(makeRequest({"del", "a:2", "a:1"}));
+  EXPECT_EQ(nullptr, cache_.lookup(request, generation));
+
+  // A response to a read that was in flight during a write is not cached.
+  const uint64_t in_flight_generation = generation;
+  cache_.invalidate(makeRequest({"set", "a:1", "new"}));
+  EXPECT_EQ(nullptr, cache_.lookup(request, generation));
+  cache_.insert(request, response, in_flight_generation);
+  EXPECT_EQ(nullptr, cache_.lookup(request, generation));
+
+  cache_.insert(request, response, generation);
+  EXPECT_NE(nullptr, cache_.lookup(request, generation));
+}
+
+TEST_F(RedisHotKeyCacheTest, MaxEntries) {
+  EXPECT_CALL(runtime_.snapshot_, getInteger("redis.hot_key_cache.max_entries", 10000))
+      .WillRepeatedly(Return(2));
+  const RespValue request1 = makeRequest({"get", "a:1"});
+  const RespValue request2 = makeRequest({"get", "a:2"});
+  const RespValue request3 = makeRequest({"get", "a:3"});
+  const RespValue response = makeResponse("value");
+
+  uint64_t generation;
+  EXPECT_EQ(nullptr, cache_.lookup(request1, generation));
+  cache_.insert(request1, response, generation);
+  uint64_t failed_generation;
+  EXPECT_EQ(nullptr, cache_.lookup(request2, failed_generation));
+
+  // Keys without responses make room first.
+  EXPECT_EQ(nullptr, cache_.lookup(request3, generation));
+  cache_.insert(request3, response, generation);
+  cache_.insert(request2, response, failed_generation);
+  EXPECT_NE(nullptr, cache_.lookup(request1, generation));
+  EXPECT_NE(nullptr, cache_.lookup(request3, generation));
+
+  // Everything goes if that is not enough.
+  EXPECT_EQ(nullptr, cache_.lookup(request2, generation));
+  EXPECT_EQ(nullptr, cache_.lookup(request1, generation));
+}
+
+} // namespace Redis
+} // namespace Envoy
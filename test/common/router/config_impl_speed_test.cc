@@ -0,0 +1,81 @@
+#include <string>
+
+#include "common/http/header_map_impl.h"
+#include "common/http/headers.h"
+#include "common/router/config_impl.h"
+
+#include "test/mocks/runtime/mocks.h"
+#include "test/mocks/upstream/mocks.h"
+
+#include "api/rds.pb.h"
+#include "benchmark/benchmark.h"
+#include "gmock/gmock.h"
+
+using testing::NiceMock;
+
+namespace Envoy {
+namespace Router {
+
+/**
+ * Builds a route table with the given number of virtual hosts, each with the given number of prefix
+ * routes, and matches a request against the last route of the last virtual host. With
+ * wildcard_domains each virtual host is reached through a "*.tenantN.example.com" domain rather
+ * than an exact one.
+ */
+class RouteMatcherPerf {
+public:
+  RouteMatcherPerf(size_t virtual_hosts, size_t routes_per_host, bool wildcard_domains = false) {
+    for (size_t i = 0; i < virtual_hosts; i++) {
+      auto* virtual_host = route_config_.add_virtual_hosts();
+      virtual_host->set_name("vhost_" + std::to_string(i));
+      virtual_host->add_domains(domain(i, wildcard_domains ? "*" : "host"));
+      for (size_t j = 0; j < routes_per_host; j++) {
+        auto* route = virtual_host->add_routes();
+        route->mutable_match()->set_prefix("/service_" + std::to_string(j) + "/");
+        route->mutable_route()->set_cluster("cluster_" + std::to_string(j));
+      }
+    }
+    config_.reset(new ConfigImpl(route_config_, runtime_, cm_, false));
+
+    headers_.insertHost().value(domain(virtual_hosts - 1, wildcard_domains ? "api" : "host"));
+    headers_.insertPath().value("/service_" + std::to_string(routes_per_host - 1) + "/method");
+    headers_.insertMethod().value(std::string("GET"));
+  }
+
+  void route(benchmark::State& state) {
+    while (state.KeepRunning()) {
+      benchmark::DoNotOptimize(config_->route(headers_, 0));
+    }
+  }
+
+private:
+  static std::string domain(size_t i, const std::string& leading_label) {
+    return leading_label + ".tenant" + std::to_string(i) + ".example.com";
+  }
+
+  envoy::api::v2::RouteConfiguration route_config_;
+  NiceMock<Runtime::MockLoader> runtime_;
+  NiceMock<Upstream::MockClusterManager> cm_;
+  std::unique_ptr<ConfigImpl> config_;
+  Http::HeaderMapImpl headers_;
+};
+
+static void RouteMatcherPrefixRoute(benchmark::State& state) {
+  RouteMatcherPerf perf(state.range(0), state.range(1));
+  perf.route(state);
+}
+BENCHMARK(RouteMatcherPrefixRoute)
+    ->Args({1, 1})
+    ->Args({1, 10})
+    ->Args({1, 100})
+    ->Args({10, 10})
+    ->Args({100, 10});
+
+static void RouteMatcherWildcardDomain(benchmark::State& state) {
+  RouteMatcherPerf perf(state.range(0), 1, true);
+  perf.route(state);
+}
+BENCHMARK(RouteMatcherWildcardDomain)->Arg(1)->Arg(100)->Arg(5000);
+
+} // namespace Router
+} // namespace Envoy
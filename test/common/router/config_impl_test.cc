@@ -209,7 +209,7 @@ TEST(RouteMatcherTest, TestRoutes) {
         {"pattern": "^/rides$", "method": "POST", "name": "ride_request"},
         {"pattern": "^/rides/\\d+$", "method": "PUT", "name": "update_ride"},
         {"pattern": "^/users/\\d+/chargeaccounts$", "method": "POST", "name": "cc_add"},
-        {"pattern": "^/users/\\d+/chargeaccounts/(?!validate)\\w+$", "method": "PUT",
+        {"pattern": "^/users/\\d+/chargeaccounts/[^v\\W]\\w*$", "method": "PUT",
          "name": "cc_add"},
         {"pattern": "^/users$", "method": "POST", "name": "create_user_login"},
         {"pattern": "^/users/\\d+$", "method": "PUT", "name": "update_user"},
@@ -477,6 +477,58 @@ TEST(RouteMatcherTest, TestRoutes) {
 }
 
 // Validates behavior of request_headers_to_add at router, vhost, and route levels.
+// Virtual hosts with many routes match through a PathMatchIndex. Verify that first-match
+// semantics across prefix, path, regex, case insensitive and header constrained routes hold.
+TEST(RouteMatcherTest, TestIndexedRoutes) {
+  envoy::api::v2::RouteConfiguration route_config;
+  auto* virtual_host = route_config.add_virtual_hosts();
+  virtual_host->set_name("indexed");
+  virtual_host->add_domains("*");
+  auto add_route = [virtual_host](const std::string& cluster) -> envoy::api::v2::RouteMatch& {
+    auto* route = virtual_host->add_routes();
+    route->mutable_route()->set_cluster(cluster);
+    return *route->mutable_match();
+  };
+
+  envoy::api::v2::RouteMatch& header_constrained = add_route("header_constrained");
+  header_constrained.set_prefix("/api");
+  header_constrained.add_headers()->set_name("x-api");
+  add_route("exact_api").set_path("/api/v1");
+  add_route("regex").set_regex("/api/v[0-9]+/users");
+  add_route("api_v1").set_prefix("/api/v1");
+  envoy::api::v2::RouteMatch& insensitive = add_route("insensitive");
+  insensitive.set_prefix("/CaSe");
+  insensitive.mutable_case_sensitive()->set_value(false);
+  for (size_t i = 0; i < 20; i++) {
+    add_route("service_" + std::to_string(i)).set_prefix("/service_" + std::to_string(i) + "/");
+  }
+  add_route("api").set_prefix("/api");
+  add_route("default").set_prefix("/");
+
+  NiceMock<Runtime::MockLoader> runtime;
+  NiceMock<Upstream::MockClusterManager> cm;
+  ConfigImpl config(route_config, runtime, cm, false);
+
+  auto cluster = [&config](const std::string& path) -> std::string {
+    return config.route(genHeaders("host", path, "GET"), 0)->routeEntry()->clusterName();
+  };
+
+  EXPECT_EQ("exact_api", cluster("/api/v1"));
+  EXPECT_EQ("exact_api", cluster("/api/v1?foo=bar"));
+  EXPECT_EQ("regex", cluster("/api/v2/users"));
+  EXPECT_EQ("api_v1", cluster("/api/v1/users/more"));
+  EXPECT_EQ("api", cluster("/api/v2"));
+  EXPECT_EQ("insensitive", cluster("/case/foo"));
+  EXPECT_EQ("service_7", cluster("/service_7/method"));
+  EXPECT_EQ("service_13", cluster("/service_13/"));
+  EXPECT_EQ("default", cluster("/service_13"));
+  EXPECT_EQ("default", cluster("/other"));
+
+  Http::TestHeaderMapImpl headers = genHeaders("host", "/api/v1", "GET");
+  headers.addCopy("x-api", "true");
+  EXPECT_EQ("header_constrained", config.route(headers, 0)->routeEntry()->clusterName());
+}
+
 TEST(RouteMatcherTest, TestAddRemoveRequestHeaders) {
   std::string json = R"EOF(
 {
@@ -838,6 +890,84 @@ TEST(RouteMatcherTest, Priority) {
             config.route(genHeaders("www.lyft.com", "/bar", "GET"), 0)->routeEntry()->priority());
 }
 
+// Wildcard domains are honored even when no virtual host has an exact domain.
+TEST(RouteMatcherTest, WildcardDomainsWithoutExactDomains) {
+  std::string json = R"EOF(
+{
+  "virtual_hosts": [
+    {
+      "name": "wildcard",
+      "domains": ["*.foo.com"],
+      "routes": [
+        {
+          "prefix": "/",
+          "cluster": "wildcard"
+        }
+      ]
+    },
+    {
+      "name": "default",
+      "domains": ["*"],
+      "routes": [
+        {
+          "prefix": "/",
+          "cluster": "default"
+        }
+      ]
+    }
+  ]
+}
+  )EOF";
+
+  NiceMock<Runtime::MockLoader> runtime;
+  NiceMock<Upstream::MockClusterManager> cm;
+  ConfigImpl config(parseRouteConfigurationFromJson(json), runtime, cm, true);
+
+  EXPECT_EQ("wildcard",
+            config.route(genHeaders("www.foo.com", "/", "GET"), 0)->routeEntry()->clusterName());
+  EXPECT_EQ("default",
+            config.route(genHeaders("foo.com", "/", "GET"), 0)->routeEntry()->clusterName());
+}
+
+// Virtual clusters whose patterns overlap resolve to the first entry whose method also matches.
+TEST(RouteMatcherTest, VirtualClusterOverlappingPatterns) {
+  std::string json = R"EOF(
+{
+  "virtual_hosts": [
+    {
+      "name": "local_service",
+      "domains": ["*"],
+      "routes": [
+        {
+          "prefix": "/",
+          "cluster": "local_service"
+        }
+      ],
+      "virtual_clusters": [
+        {"pattern": "^/users/\\d+$", "method": "POST", "name": "user_post"},
+        {"pattern": "^/users/.*", "name": "users"},
+        {"pattern": "^/users/\\d+$", "method": "GET", "name": "user_get"}]
+    }
+  ]
+}
+  )EOF";
+
+  NiceMock<Runtime::MockLoader> runtime;
+  NiceMock<Upstream::MockClusterManager> cm;
+  ConfigImpl config(parseRouteConfigurationFromJson(json), runtime, cm, true);
+
+  auto virtual_cluster = [&config](const std::string& path,
+                                   const std::string& method) -> std::string {
+    Http::TestHeaderMapImpl headers = genHeaders("api.lyft.com", path, method);
+    return config.route(headers, 0)->routeEntry()->virtualCluster(headers)->name();
+  };
+
+  EXPECT_EQ("user_post", virtual_cluster("/users/123", "POST"));
+  EXPECT_EQ("users", virtual_cluster("/users/123", "GET"));
+  EXPECT_EQ("users", virtual_cluster("/users/abc", "POST"));
+  EXPECT_EQ("other", virtual_cluster("/rides/123", "GET"));
+}
+
 TEST(RouteMatcherTest, NoHostRewriteAndAutoRewrite) {
   std::string json = R"EOF(
 {
@@ -995,6 +1125,56 @@ TEST(RouteMatcherTest, HeaderMatchedRouting) {
   }
 }
 
+// Matchers on inline headers read them directly rather than by name.
+TEST(RouteMatcherTest, InlineHeaderMatchedRouting) {
+  std::string json = R"EOF(
+{
+  "virtual_hosts": [
+    {
+      "name": "local_service",
+      "domains": ["*"],
+      "routes": [
+        {
+          "prefix": "/",
+          "cluster": "post",
+          "headers" : [
+            {"name": ":method", "value": "POST"},
+            {"name": ":authority", "value": "^api\\..*$", "regex": true}
+          ]
+        },
+        {
+          "prefix": "/",
+          "cluster": "user_agent",
+          "headers" : [
+            {"name": "user-agent"}
+          ]
+        },
+        {
+          "prefix": "/",
+          "cluster": "default"
+        }
+      ]
+    }
+  ]
+}
+  )EOF";
+
+  NiceMock<Runtime::MockLoader> runtime;
+  NiceMock<Upstream::MockClusterManager> cm;
+  ConfigImpl config(parseRouteConfigurationFromJson(json), runtime, cm, true);
+
+  EXPECT_EQ("post",
+            config.route(genHeaders("api.lyft.com", "/", "POST"), 0)->routeEntry()->clusterName());
+  EXPECT_EQ("default",
+            config.route(genHeaders("www.lyft.com", "/", "POST"), 0)->routeEntry()->clusterName());
+  EXPECT_EQ("default",
+            config.route(genHeaders("api.lyft.com", "/", "PUT"), 0)->routeEntry()->clusterName());
+
+  Http::TestHeaderMapImpl headers = genHeaders("api.lyft.com", "/", "GET");
+  headers.addCopy("user-agent", "curl");
+  EXPECT_EQ("user_agent", config.route(headers, 0)->routeEntry()->clusterName());
+}
+
 class RouterMatcherHashPolicyTest : public testing::Test {
 public:
   RouterMatcherHashPolicyTest()
@@ -1296,6 +1476,99 @@ TEST_F(RouterMatcherHashPolicyTest, InvalidHashPolicies) {
   }
 }
 
+TEST(RouteMatcherTest, ClusterHandles) {
+  std::string json = R"EOF(
+{
+  "virtual_hosts": [
+    {
+      "name": "local_service",
+      "domains": ["*"],
+      "routes": [
+        {
+          "prefix": "/foo",
+          "cluster": "foo"
+        },
+        {
+          "prefix": "/weighted",
+          "weighted_clusters": {
+            "clusters" : [{ "name" : "cluster1", "weight" : 30 },
+                          { "name" : "cluster2", "weight" : 70 }]
+          }
+        },
+        {
+          "prefix": "/header",
+          "cluster_header": "some_header"
+        }
+      ]
+    }
+  ]
+}
+  )EOF";
+
+  NiceMock<Runtime::MockLoader> runtime;
+  NiceMock<Upstream::MockClusterManager> cm;
+  std::map<std::string, Upstream::ClusterHandleConstSharedPtr> handles;
+  for (const std::string name : {"foo", "cluster1", "cluster2"}) {
+    handles[name] = std::make_shared<Upstream::MockClusterHandle>();
+    EXPECT_CALL(cm, clusterHandle(name)).WillOnce(Return(handles[name]));
+  }
+  ConfigImpl config(parseRouteConfigurationFromJson(json), runtime, cm, false);
+
+  auto cluster_handle = [&config](const std::string& path,
+                                  uint64_t random_value) -> const Upstream::ClusterHandle* {
+    return config.route(genHeaders("www.lyft.com", path, "GET"), random_value)
+        ->routeEntry()
+        ->clusterHandle();
+  };
+  EXPECT_EQ(handles["foo"].get(), cluster_handle("/foo", 0));
+  EXPECT_EQ(handles["cluster1"].get(), cluster_handle("/weighted", 0));
+  EXPECT_EQ(handles["cluster2"].get(), cluster_handle("/weighted", 50));
+
+  Http::TestHeaderMapImpl headers = genHeaders("www.lyft.com", "/header", "GET");
+  headers.addCopy("some_header", "foo");
+  EXPECT_EQ(nullptr, config.route(headers, 0)->routeEntry()->clusterHandle());
+}
+
+TEST(RouteMatcherTest, RouteCacheable) {
+  NiceMock<Runtime::MockLoader> runtime;
+  NiceMock<Upstream::MockClusterManager> cm;
+  auto cacheable = [&](const std::string& route, const std::string& require_ssl) -> bool {
+    const std::string json = R"EOF(
+{
+  "virtual_hosts": [
+    {
+      "name": "foo",
+      "domains": ["foo.com"],
+      "routes": [{ "prefix": "/foo", "cluster": "foo" }]
+    },
+    {
+      "name": "local_service",
+      "domains": ["*"],
+      )EOF" + require_ssl + R"EOF(
+      "routes": [)EOF" + route + R"EOF(]
+    }
+  ]
+}
+  )EOF";
+    return ConfigImpl(parseRouteConfigurationFromJson(json), runtime, cm, false).routeCacheable();
+  };
+
+  EXPECT_TRUE(cacheable(R"EOF({ "path": "/bar", "cluster": "bar" })EOF", ""));
+  EXPECT_TRUE(cacheable(R"EOF({ "regex": "/ba.", "host_redirect": "bar.com" })EOF", ""));
+  EXPECT_FALSE(cacheable(R"EOF({ "prefix": "/", "cluster": "bar" })EOF",
+                         R"EOF("require_ssl": "all",)EOF"));
+  EXPECT_FALSE(cacheable(R"EOF({ "prefix": "/", "cluster": "bar",
+                                 "runtime": { "key": "bar", "default": 50 } })EOF",
+                         ""));
+  EXPECT_FALSE(cacheable(R"EOF({ "prefix": "/", "cluster": "bar",
+                                 "headers": [{ "name": "x-bar", "value": "bar" }] })EOF",
+                         ""));
+  EXPECT_FALSE(cacheable(R"EOF({ "prefix": "/", "cluster_header": "x-cluster" })EOF", ""));
+  EXPECT_FALSE(cacheable(R"EOF({ "prefix": "/", "weighted_clusters": {
+                                 "clusters": [{ "name": "bar", "weight": 100 }] } })EOF",
+                         ""));
+}
+
 TEST(RouteMatcherTest, ClusterHeader) {
   std::string json = R"EOF(
 {
@@ -1680,6 +1953,59 @@ TEST(RouteMatcherTest, Shadow) {
                     .runtimeKey());
 }
 
+TEST(RouteMatcherTest, HedgePolicy) {
+  std::string yaml = R"EOF(
+virtual_hosts:
+  - name: "www2"
+    domains: ["www.lyft.com"]
+    routes:
+      - match: { prefix: "/foo" }
+        route: { cluster: "www2" }
+        metadata:
+          filter_metadata:
+            envoy.router:
+              hedge_latency_percentile: 95
+              hedge_min_delay_ms: 10
+      - match: { prefix: "/bar" }
+        route: { cluster: "www2" }
+  )EOF";
+
+  NiceMock<Runtime::MockLoader> runtime;
+  NiceMock<Upstream::MockClusterManager> cm;
+  ConfigImpl config(parseRouteConfigurationFromV2Yaml(yaml), runtime, cm, false);
+
+  const HedgePolicy& hedge_policy =
+      config.route(genHeaders("www.lyft.com", "/foo", "GET"), 0)->routeEntry()->hedgePolicy();
+  EXPECT_EQ(95, hedge_policy.latencyPercentile());
+  EXPECT_EQ(std::chrono::milliseconds(10), hedge_policy.minDelay());
+
+  const HedgePolicy& no_hedge_policy =
+      config.route(genHeaders("www.lyft.com", "/bar", "GET"), 0)->routeEntry()->hedgePolicy();
+  EXPECT_EQ(0, no_hedge_policy.latencyPercentile());
+  EXPECT_EQ(std::chrono::milliseconds(0), no_hedge_policy.minDelay());
+}
+
+TEST(RouteMatcherTest, HedgePolicyBadPercentile) {
+  std::string yaml = R"EOF(
+virtual_hosts:
+  - name: "www2"
+    domains: ["www.lyft.com"]
+    routes:
+      - match: { prefix: "/foo" }
+        route: { cluster: "www2" }
+        metadata:
+          filter_metadata:
+            envoy.router:
+              hedge_latency_percentile: 101
+  )EOF";
+
+  NiceMock<Runtime::MockLoader> runtime;
+  NiceMock<Upstream::MockClusterManager> cm;
+  EXPECT_THROW_WITH_MESSAGE(
+      ConfigImpl(parseRouteConfigurationFromV2Yaml(yaml), runtime, cm, false), EnvoyException,
+      "route: hedge_latency_percentile 101 must be between 0 and 100");
+}
+
 TEST(RouteMatcherTest, Retry) {
   std::string json = R"EOF(
 {
@@ -2795,6 +3121,8 @@ TEST(RoutePropertyTest, TestVHostCorsConfig) {
 
   EXPECT_EQ(cors_policy->enabled(), true);
   EXPECT_THAT(cors_policy->allowOrigins(), ElementsAreArray({"test-origin"}));
+  EXPECT_TRUE(cors_policy->originAllowed("test-origin"));
+  EXPECT_FALSE(cors_policy->originAllowed("test-origin2"));
   EXPECT_EQ(cors_policy->allowMethods(), "test-methods");
   EXPECT_EQ(cors_policy->allowHeaders(), "test-headers");
   EXPECT_EQ(cors_policy->exposeHeaders(), "test-expose-headers");
@@ -2844,6 +3172,42 @@ TEST(RoutePropertyTest, TestRouteCorsConfig) {
   EXPECT_EQ(cors_policy->allowCredentials(), true);
 }
 
+TEST(RoutePropertyTest, TestCorsConfigAnyOrigin) {
+  std::string json = R"EOF(
+{
+  "virtual_hosts": [
+    {
+      "name": "default",
+      "domains": ["*"],
+      "cors" : {
+        "allow_origin": ["test-origin", "*"]
+      },
+      "routes": [
+        {
+          "prefix": "/api",
+          "cluster": "ats"
+        }
+      ]
+    }
+  ]
+}
+)EOF";
+
+  NiceMock<Runtime::MockLoader> runtime;
+  NiceMock<Upstream::MockClusterManager> cm;
+  ConfigImpl config(parseRouteConfigurationFromJson(json), runtime, cm, true);
+
+  const Router::CorsPolicy* cors_policy =
+      config.route(genHeaders("api.lyft.com", "/api", "GET"), 0)
+          ->routeEntry()
+          ->virtualHost()
+          .corsPolicy();
+
+  EXPECT_THAT(cors_policy->allowOrigins(), ElementsAreArray({"test-origin", "*"}));
+  EXPECT_TRUE(cors_policy->originAllowed("test-origin"));
+  EXPECT_TRUE(cors_policy->originAllowed("test-origin2"));
+}
+
 TEST(RoutePropertyTest, TestBadCorsConfig) {
   std::string json = R"EOF(
 {
@@ -0,0 +1,72 @@
+#include <string>
+
+#include "common/router/domain_match_index.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Router {
+
+class DomainMatchIndexTest : public testing::Test {
+public:
+  uint32_t find(const std::string& host) { return index_.find(host.c_str(), host.size()); }
+
+  DomainMatchIndex index_;
+};
+
+TEST_F(DomainMatchIndexTest, Empty) {
+  EXPECT_TRUE(index_.empty());
+  EXPECT_EQ(DomainMatchIndex::NoMatch, find("www.lyft.com"));
+  EXPECT_EQ(DomainMatchIndex::NoMatch, find(""));
+}
+
+TEST_F(DomainMatchIndexTest, Exact) {
+  EXPECT_TRUE(index_.addExact("www.lyft.com", 0));
+  EXPECT_TRUE(index_.addExact("lyft.com", 1));
+  EXPECT_FALSE(index_.addExact("www.lyft.com", 2));
+  EXPECT_FALSE(index_.empty());
+
+  EXPECT_EQ(0, find("www.lyft.com"));
+  EXPECT_EQ(1, find("lyft.com"));
+  EXPECT_EQ(DomainMatchIndex::NoMatch, find("ww.lyft.com"));
+  EXPECT_EQ(DomainMatchIndex::NoMatch, find("api.lyft.com"));
+  EXPECT_EQ(DomainMatchIndex::NoMatch, find("yft.com"));
+  EXPECT_EQ(DomainMatchIndex::NoMatch, find("xlyft.com"));
+}
+
+TEST_F(DomainMatchIndexTest, LongestWildcardSuffix) {
+  index_.addWildcardSuffix(".baz.com", 0);
+  index_.addWildcardSuffix("-bar.baz.com", 1);
+  index_.addWildcardSuffix(".com", 2);
+  index_.addWildcardSuffix(".baz.com", 3);
+
+  EXPECT_EQ(1, find("foo-bar.baz.com"));
+  EXPECT_EQ(0, find("foo.baz.com"));
+  EXPECT_EQ(0, find("foo.-bar.baz.com.baz.com"));
+  EXPECT_EQ(2, find("foo.com"));
+  EXPECT_EQ(2, find("baz.com"));
+  EXPECT_EQ(DomainMatchIndex::NoMatch, find("foo.net"));
+}
+
+TEST_F(DomainMatchIndexTest, WildcardRequiresNonEmptyMatch) {
+  index_.addWildcardSuffix(".foo.com", 0);
+
+  EXPECT_EQ(DomainMatchIndex::NoMatch, find(".foo.com"));
+  EXPECT_EQ(0, find("a.foo.com"));
+}
+
+TEST_F(DomainMatchIndexTest, ExactPreferredOverWildcard) {
+  index_.addWildcardSuffix(".lyft.com", 0);
+  index_.addWildcardSuffix("lyft.com", 1);
+  EXPECT_TRUE(index_.addExact("www.lyft.com", 2));
+  EXPECT_TRUE(index_.addExact(".lyft.com", 3));
+
+  EXPECT_EQ(2, find("www.lyft.com"));
+  EXPECT_EQ(0, find("api.lyft.com"));
+  EXPECT_EQ(3, find(".lyft.com"));
+  EXPECT_EQ(1, find("alyft.com"));
+  EXPECT_EQ(DomainMatchIndex::NoMatch, find("lyft.com"));
+}
+
+} // namespace Router
+} // namespace Envoy
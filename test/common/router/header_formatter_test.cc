@@ -212,6 +212,42 @@ TEST(RequestInfoFormatterTest, TestFormatWithUpstreamMetadataVariableMissingHost
   EXPECT_EQ("", formatted_string);
 }
 
+TEST(RequestInfoFormatterTest, EvaluateUpstreamMetadataVariable) {
+  NiceMock<Envoy::RequestInfo::MockRequestInfo> request_info;
+  std::shared_ptr<NiceMock<Envoy::Upstream::MockHostDescription>> host(
+      new NiceMock<Envoy::Upstream::MockHostDescription>());
+  envoy::api::v2::Metadata metadata = TestUtility::parseYaml<envoy::api::v2::Metadata>(
+      R"EOF(
+        filter_metadata:
+          namespace:
+            str_key: str_value
+            bool_key: true
+            num_key: 3.14
+            null_key: null
+      )EOF");
+  ON_CALL(request_info, upstreamHost()).WillByDefault(Return(host));
+  ON_CALL(*host, metadata()).WillByDefault(ReturnRef(metadata));
+
+  const Http::LowerCaseString key("x-metadata");
+  Http::TestHeaderMapImpl headers{{"x-metadata", "old-value"}};
+  RequestInfoHeaderFormatter("UPSTREAM_METADATA([\"namespace\", \"str_key\"])", false)
+      .evaluate(headers, key, request_info);
+  EXPECT_EQ("str_value", headers.get_("x-metadata"));
+  RequestInfoHeaderFormatter("UPSTREAM_METADATA([\"namespace\", \"bool_key\"])", false)
+      .evaluate(headers, key, request_info);
+  EXPECT_EQ("true", headers.get_("x-metadata"));
+  RequestInfoHeaderFormatter("UPSTREAM_METADATA([\"namespace\", \"num_key\"])", false)
+      .evaluate(headers, key, request_info);
+  EXPECT_EQ("3.14", headers.get_("x-metadata"));
+
+  // Missing and unsupported values add nothing.
+  RequestInfoHeaderFormatter("UPSTREAM_METADATA([\"namespace\", \"null_key\"])", true)
+      .evaluate(headers, key, request_info);
+  RequestInfoHeaderFormatter("UPSTREAM_METADATA([\"namespace\", \"missing\"])", true)
+      .evaluate(headers, key, request_info);
+  EXPECT_EQ(1UL, headers.size());
+}
+
 TEST(RequestInfoHeaderFormatterTest, WrongVariableToFormat) {
   NiceMock<Envoy::RequestInfo::MockRequestInfo> request_info;
   const std::string downstream_addr = "127.0.0.1";
@@ -383,6 +419,9 @@ TEST(HeaderParserTest, EvaluateStaticHeaders) {
   req_header_parser->evaluateHeaders(headerMap, request_info);
   EXPECT_TRUE(headerMap.has("static-header"));
   EXPECT_EQ("static-value", headerMap.get_("static-header"));
+  // The value is referenced rather than copied.
+  EXPECT_EQ(Http::HeaderString::Type::Reference,
+            headerMap.get(Http::LowerCaseString("static-header"))->value().type());
 }
 
 TEST(HeaderParserTest, EvaluateHeadersWithAppendFalse) {
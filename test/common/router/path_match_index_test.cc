@@ -0,0 +1,75 @@
+#include <string>
+#include <vector>
+
+#include "common/router/path_match_index.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::ElementsAre;
+using testing::IsEmpty;
+
+namespace Envoy {
+namespace Router {
+
+class PathMatchIndexTest : public testing::Test {
+public:
+  std::vector<uint32_t> find(const std::string& path) {
+    size_t path_without_query_size = path.find('?');
+    if (path_without_query_size == std::string::npos) {
+      path_without_query_size = path.size();
+    }
+    std::vector<uint32_t> candidates;
+    index_.findCandidates(path.c_str(), path.size(), path_without_query_size, candidates);
+    return candidates;
+  }
+
+  PathMatchIndex index_;
+};
+
+TEST_F(PathMatchIndexTest, Empty) { EXPECT_THAT(find("/foo"), IsEmpty()); }
+
+TEST_F(PathMatchIndexTest, Prefixes) {
+  index_.addPrefix("/foo/bar", 0);
+  index_.addPrefix("/foo", 1);
+  index_.addPrefix("/", 2);
+  index_.addPrefix("/baz", 3);
+  index_.addPrefix("", 4);
+
+  EXPECT_THAT(find("/foo/bar/baz"), ElementsAre(0, 1, 2, 4));
+  EXPECT_THAT(find("/foo"), ElementsAre(1, 2, 4));
+  EXPECT_THAT(find("/fo"), ElementsAre(2, 4));
+  EXPECT_THAT(find("/baz?foo"), ElementsAre(2, 3, 4));
+  EXPECT_THAT(find("no_slash"), ElementsAre(4));
+  // Prefixes are matched against the full path including the query string.
+  index_.addPrefix("/q?a=b", 5);
+  EXPECT_THAT(find("/q?a=b"), ElementsAre(2, 4, 5));
+}
+
+TEST_F(PathMatchIndexTest, Paths) {
+  index_.addPath("/foo", 0);
+  index_.addPath("/foo/bar", 1);
+  index_.addPath("/foo", 2);
+
+  EXPECT_THAT(find("/foo"), ElementsAre(0, 2));
+  EXPECT_THAT(find("/foo?bar=baz"), ElementsAre(0, 2));
+  EXPECT_THAT(find("/foo/bar"), ElementsAre(1));
+  EXPECT_THAT(find("/foo/"), IsEmpty());
+  EXPECT_THAT(find("/fo"), IsEmpty());
+}
+
+TEST_F(PathMatchIndexTest, MixedKeepsRankOrder) {
+  index_.addUnindexed(3);
+  index_.addPath("/foo", 1);
+  index_.addPrefix("/f", 2);
+  index_.addPrefix("/", 5);
+  index_.addUnindexed(4);
+  index_.addPath("/other", 0);
+
+  EXPECT_THAT(find("/foo"), ElementsAre(1, 2, 3, 4, 5));
+  EXPECT_THAT(find("/other"), ElementsAre(0, 3, 4, 5));
+  EXPECT_THAT(find("/bar"), ElementsAre(3, 4, 5));
+}
+
+} // namespace Router
+} // namespace Envoy
@@ -1,5 +1,8 @@
 #include <chrono>
+#include <condition_variable>
+#include <mutex>
 #include <string>
+#include <vector>
 
 #include "common/config/filter_json.h"
 #include "common/config/utility.h"
@@ -133,6 +136,48 @@ TEST_F(RdsImplTest, RdsAndStatic) {
                EnvoyException);
 }
 
+TEST_F(RdsImplTest, StaticConfigShared) {
+  envoy::api::v2::RouteConfiguration route_config;
+  auto* virtual_host = route_config.add_virtual_hosts();
+  virtual_host->set_name("foo");
+  virtual_host->add_domains("*");
+  auto* route = virtual_host->add_routes();
+  route->mutable_match()->set_prefix("/");
+  route->mutable_route()->set_cluster("foo");
+
+  RouteConfigProviderSharedPtr provider1 =
+      route_config_provider_manager_->getStaticRouteConfigProvider(route_config, runtime_, cm_);
+  RouteConfigProviderSharedPtr provider2 =
+      route_config_provider_manager_->getStaticRouteConfigProvider(route_config, runtime_, cm_);
+  EXPECT_NE(provider1, provider2);
+  EXPECT_EQ(provider1->config(), provider2->config());
+  EXPECT_EQ("static", provider2->versionInfo());
+
+  envoy::api::v2::RouteConfiguration other_route_config = route_config;
+  other_route_config.mutable_virtual_hosts(0)->mutable_routes(0)->mutable_route()->set_cluster(
+      "bar");
+  RouteConfigProviderSharedPtr provider3 = route_config_provider_manager_
+                                               ->getStaticRouteConfigProvider(other_route_config,
+                                                                              runtime_, cm_);
+  EXPECT_NE(provider1->config(), provider3->config());
+
+  // A shared route table is still validated for each provider.
+  EXPECT_CALL(cm_, get("foo")).WillOnce(Return(nullptr));
+  EXPECT_THROW_WITH_MESSAGE(
+      route_config_provider_manager_->getStaticRouteConfigProvider(route_config, runtime_, cm_),
+      EnvoyException, "route: unknown cluster 'foo'");
+
+  // Once every provider of a route table is gone, an equal route config builds a new one.
+  provider1.reset();
+  provider2.reset();
+  RouteConfigProviderSharedPtr provider4 =
+      route_config_provider_manager_->getStaticRouteConfigProvider(route_config, runtime_, cm_);
+  EXPECT_EQ("foo", provider4->config()
+                       ->route(Http::TestHeaderMapImpl{{":authority", "foo"}, {":path", "/"}}, 0)
+                       ->routeEntry()
+                       ->clusterName());
+}
+
 TEST_F(RdsImplTest, LocalInfoNotDefined) {
   const std::string config_json = R"EOF(
     {
@@ -407,6 +452,68 @@ TEST_F(RdsImplTest, FailureArray) {
   EXPECT_EQ(1UL, store_.counter("foo.rds.foo_route_config.update_failure").value());
 }
 
+TEST_F(RdsImplTest, BuildOnConfigThread) {
+  EXPECT_CALL(admin_, addHandler("/routes", _, _, true)).WillOnce(Return(true));
+  EXPECT_CALL(admin_, removeHandler("/routes"));
+  route_config_provider_manager_.reset(new RouteConfigProviderManagerImpl(
+      runtime_, dispatcher_, random_, local_info_, tls_, admin_, true));
+
+  // Keep what the config thread posts back to the main thread until the test runs it.
+  std::mutex lock;
+  std::condition_variable posted_event;
+  std::vector<Event::PostCb> posted;
+  EXPECT_CALL(dispatcher_, post(_)).WillRepeatedly(Invoke([&](Event::PostCb callback) -> void {
+    std::unique_lock<std::mutex> guard(lock);
+    posted.push_back(callback);
+    posted_event.notify_one();
+  }));
+
+  setup();
+
+  const std::string response_json = R"EOF(
+  {
+    "virtual_hosts": [
+    {
+      "name": "local_service",
+      "domains": ["*"],
+      "routes": [
+        {
+          "prefix": "/foo",
+          "cluster": "foo"
+        }
+      ]
+    }
+  ]
+  }
+  )EOF";
+
+  Http::MessagePtr message(new Http::ResponseMessageImpl(
+      Http::HeaderMapPtr{new Http::TestHeaderMapImpl{{":status", "200"}}}));
+  message->body().reset(new Buffer::OwnedImpl(response_json));
+  EXPECT_CALL(*interval_timer_, enableTimer(_));
+  callbacks_->onSuccess(std::move(message));
+
+  Event::PostCb built;
+  {
+    std::unique_lock<std::mutex> guard(lock);
+    while (posted.empty()) {
+      posted_event.wait(guard);
+    }
+    built = posted[0];
+  }
+
+  // The old route table serves until the new one is swapped in on the main thread.
+  EXPECT_EQ(nullptr, rds_->config()->route(
+                         Http::TestHeaderMapImpl{{":authority", "foo"}, {":path", "/foo"}}, 0));
+  EXPECT_CALL(init_manager_.initialized_, ready());
+  built();
+  EXPECT_EQ("foo", rds_->config()
+                       ->route(Http::TestHeaderMapImpl{{":authority", "foo"}, {":path", "/foo"}}, 0)
+                       ->routeEntry()
+                       ->clusterName());
+  EXPECT_EQ(1UL, store_.counter("foo.rds.foo_route_config.config_reload").value());
+}
+
 class RouteConfigProviderManagerImplTest : public testing::Test {
 public:
   void setup() {
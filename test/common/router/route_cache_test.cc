@@ -0,0 +1,81 @@
+#include <memory>
+
+#include "common/router/route_cache.h"
+
+#include "test/mocks/router/mocks.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::NiceMock;
+using testing::Return;
+using testing::_;
+
+namespace Envoy {
+namespace Router {
+
+class RouteCacheTest : public testing::Test {
+public:
+  RouteCacheTest() { ON_CALL(*config_, routeCacheable()).WillByDefault(Return(true)); }
+
+  RouteConstSharedPtr route(const std::string& host, const std::string& path) {
+    Http::TestHeaderMapImpl headers{{":authority", host}, {":path", path}};
+    return cache_.route(config_, headers, 0);
+  }
+
+  std::shared_ptr<NiceMock<MockConfig>> config_{new NiceMock<MockConfig>()};
+  RouteCache cache_{2};
+};
+
+TEST_F(RouteCacheTest, Hit) {
+  EXPECT_CALL(*config_, route(_, _)).Times(2);
+  EXPECT_EQ(config_->route_, route("foo", "/"));
+  EXPECT_EQ(config_->route_, route("foo", "/"));
+  EXPECT_EQ(config_->route_, route("foo", "/bar"));
+  EXPECT_EQ(config_->route_, route("foo", "/bar"));
+  EXPECT_EQ(2U, cache_.size());
+}
+
+TEST_F(RouteCacheTest, NullRoute) {
+  EXPECT_CALL(*config_, route(_, _)).WillOnce(Return(nullptr));
+  EXPECT_EQ(nullptr, route("foo", "/"));
+  EXPECT_EQ(nullptr, route("foo", "/"));
+}
+
+TEST_F(RouteCacheTest, LeastRecentlyUsedEvicted) {
+  EXPECT_CALL(*config_, route(_, _)).Times(4);
+  route("foo", "/a");
+  route("foo", "/b");
+  route("foo", "/a");
+  // Evicts /b.
+  route("bar", "/a");
+  EXPECT_EQ(2U, cache_.size());
+  route("foo", "/a");
+  route("bar", "/a");
+  route("foo", "/b");
+}
+
+TEST_F(RouteCacheTest, NotCacheable) {
+  ON_CALL(*config_, routeCacheable()).WillByDefault(Return(false));
+  EXPECT_CALL(*config_, route(_, _)).Times(2);
+  route("foo", "/");
+  route("foo", "/");
+  EXPECT_EQ(0U, cache_.size());
+}
+
+TEST_F(RouteCacheTest, ConfigChange) {
+  EXPECT_CALL(*config_, route(_, _));
+  route("foo", "/");
+
+  auto old_config = config_;
+  config_.reset(new NiceMock<MockConfig>());
+  ON_CALL(*config_, routeCacheable()).WillByDefault(Return(true));
+  EXPECT_CALL(*config_, route(_, _));
+  EXPECT_EQ(config_->route_, route("foo", "/"));
+  EXPECT_EQ(config_->route_, route("foo", "/"));
+  EXPECT_EQ(1U, cache_.size());
+}
+
+} // namespace Router
+} // namespace Envoy
@@ -8,6 +8,7 @@
 #include "common/upstream/upstream_impl.h"
 
 #include "test/common/http/common.h"
+#include "test/mocks/buffer/mocks.h"
 #include "test/mocks/http/mocks.h"
 #include "test/mocks/local_info/mocks.h"
 #include "test/mocks/network/mocks.h"
@@ -85,6 +86,21 @@ public:
     EXPECT_CALL(*per_try_timeout_, disableTimer());
   }
 
+  // Make the next connection pool lookup, the one for a hedged request, pick another host.
+  void expectHedgePool() {
+    ON_CALL(*hedge_pool_.host_, address()).WillByDefault(Return(host_address_));
+    ON_CALL(*hedge_pool_.host_, locality()).WillByDefault(ReturnRef(upstream_locality_));
+    EXPECT_CALL(cm_, httpConnPoolForCluster(_, _, _))
+        .WillOnce(Return(&hedge_pool_))
+        .RetiresOnSaturation();
+  }
+
+  void primeLatencyEstimator(std::chrono::milliseconds response_time) {
+    for (uint64_t i = 0; i < Upstream::LatencyEstimatorImpl::DEFAULT_WINDOW_SIZE; i++) {
+      cm_.thread_local_cluster_.cluster_.info_->latency_estimator_.putResponseTime(response_time);
+    }
+  }
+
   AssertionResult verifyHostUpstreamStats(uint64_t success, uint64_t error) {
     if (success != cm_.conn_pool_.host_->stats_store_.counter("rq_success").value()) {
       return AssertionFailure() << fmt::format(
@@ -103,6 +119,7 @@ public:
   envoy::api::v2::Locality upstream_locality_;
   Stats::IsolatedStoreImpl stats_store_;
   NiceMock<Upstream::MockClusterManager> cm_;
+  NiceMock<Http::ConnectionPool::MockInstance> hedge_pool_;
   NiceMock<Runtime::MockLoader> runtime_;
   NiceMock<Runtime::MockRandomGenerator> random_;
   Http::ConnectionPool::MockCancellable cancellable_;
@@ -438,6 +455,24 @@ TEST_F(RouterTest, CancelBeforeBoundToPool) {
   EXPECT_TRUE(verifyHostUpstreamStats(0, 0));
 }
 
+TEST_F(RouterTest, ClusterHandle) {
+  NiceMock<Upstream::MockClusterHandle> cluster_handle;
+  ON_CALL(callbacks_.route_->route_entry_, clusterHandle()).WillByDefault(Return(&cluster_handle));
+  EXPECT_CALL(cm_, get(_)).Times(0);
+  EXPECT_CALL(cm_, httpConnPoolForCluster(_, _, _)).Times(0);
+  EXPECT_CALL(cluster_handle, get()).WillOnce(Return(&cm_.thread_local_cluster_));
+  EXPECT_CALL(cluster_handle, httpConnPool(_, &router_)).WillOnce(Return(&cm_.conn_pool_));
+  EXPECT_CALL(cm_.conn_pool_, newStream(_, _)).WillOnce(Return(&cancellable_));
+  expectResponseTimerCreate();
+
+  Http::TestHeaderMapImpl headers;
+  HttpTestUtility::addDefaultHeaders(headers);
+  router_.decodeHeaders(headers, true);
+
+  EXPECT_CALL(cancellable_, cancel());
+  router_.onDestroy();
+}
+
 TEST_F(RouterTest, NoHost) {
   EXPECT_CALL(cm_, httpConnPoolForCluster(_, _, _)).WillOnce(Return(nullptr));
 
@@ -1376,23 +1411,21 @@ TEST_F(RouterTest, Shadow) {
 
   EXPECT_CALL(runtime_.snapshot_, featureEnabled("bar", 0, 43, 10000)).WillOnce(Return(true));
 
+  // The shadow starts with the headers and is sent the rest of the request as it arrives, so the
+  // request is not buffered for it.
+  MockShadowStream shadow_stream;
+  EXPECT_CALL(*shadow_writer_, streamShadow_("foo", _, false, std::chrono::milliseconds(10)))
+      .WillOnce(Return(&shadow_stream));
   Http::TestHeaderMapImpl headers;
   HttpTestUtility::addDefaultHeaders(headers);
   router_.decodeHeaders(headers, false);
 
-  Buffer::InstancePtr body_data(new Buffer::OwnedImpl("hello"));
-  EXPECT_EQ(Http::FilterDataStatus::StopIterationAndBuffer, router_.decodeData(*body_data, false));
+  Buffer::OwnedImpl body_data("hello");
+  EXPECT_CALL(shadow_stream, sendData(BufferStringEqual("hello"), false));
+  EXPECT_EQ(Http::FilterDataStatus::StopIterationNoBuffer, router_.decodeData(body_data, false));
 
   Http::TestHeaderMapImpl trailers{{"some", "trailer"}};
-  EXPECT_CALL(callbacks_, decodingBuffer())
-      .Times(AtLeast(1))
-      .WillRepeatedly(Return(body_data.get()));
-  EXPECT_CALL(*shadow_writer_, shadow_("foo", _, std::chrono::milliseconds(10)))
-      .WillOnce(Invoke(
-          [](const std::string&, Http::MessagePtr& request, std::chrono::milliseconds) -> void {
-            EXPECT_NE(nullptr, request->body());
-            EXPECT_NE(nullptr, request->trailers());
-          }));
+  EXPECT_CALL(shadow_stream, sendTrailers(HeaderMapEqualRef(&trailers)));
   router_.decodeTrailers(trailers);
 
   Http::HeaderMapPtr response_headers(new Http::TestHeaderMapImpl{{":status", "200"}});
@@ -1400,6 +1433,287 @@ TEST_F(RouterTest, Shadow) {
   EXPECT_TRUE(verifyHostUpstreamStats(1, 0));
 }
 
+TEST_F(RouterTest, ShadowCancelledOnReset) {
+  callbacks_.route_->route_entry_.shadow_policy_.cluster_ = "foo";
+  callbacks_.route_->route_entry_.shadow_policy_.runtime_key_ = "bar";
+  ON_CALL(callbacks_, streamId()).WillByDefault(Return(43));
+
+  NiceMock<Http::MockStreamEncoder> encoder;
+  EXPECT_CALL(cm_.conn_pool_, newStream(_, _))
+      .WillOnce(Invoke([&](Http::StreamDecoder&, Http::ConnectionPool::Callbacks& callbacks)
+                           -> Http::ConnectionPool::Cancellable* {
+        callbacks.onPoolReady(encoder, cm_.conn_pool_.host_);
+        return nullptr;
+      }));
+  EXPECT_CALL(runtime_.snapshot_, featureEnabled("bar", 0, 43, 10000)).WillOnce(Return(true));
+
+  MockShadowStream shadow_stream;
+  EXPECT_CALL(*shadow_writer_, streamShadow_("foo", _, false, _)).WillOnce(Return(&shadow_stream));
+  Http::TestHeaderMapImpl headers;
+  HttpTestUtility::addDefaultHeaders(headers);
+  router_.decodeHeaders(headers, false);
+
+  EXPECT_CALL(shadow_stream, cancel());
+  EXPECT_CALL(encoder.stream_, resetStream(Http::StreamResetReason::LocalReset));
+  router_.onDestroy();
+}
+
+TEST_F(RouterTest, HedgeWithoutLatencyEstimate) {
+  callbacks_.route_->route_entry_.hedge_policy_.latency_percentile_ = 90;
+
+  NiceMock<Http::MockStreamEncoder> encoder;
+  Http::StreamDecoder* response_decoder = nullptr;
+  EXPECT_CALL(cm_.conn_pool_, newStream(_, _))
+      .WillOnce(Invoke([&](Http::StreamDecoder& decoder, Http::ConnectionPool::Callbacks& callbacks)
+                           -> Http::ConnectionPool::Cancellable* {
+        response_decoder = &decoder;
+        callbacks.onPoolReady(encoder, cm_.conn_pool_.host_);
+        return nullptr;
+      }));
+  // Only the response timer is created.
+  expectResponseTimerCreate();
+
+  Http::TestHeaderMapImpl headers;
+  HttpTestUtility::addDefaultHeaders(headers);
+  router_.decodeHeaders(headers, true);
+
+  Http::HeaderMapPtr response_headers(new Http::TestHeaderMapImpl{{":status", "200"}});
+  response_decoder->decodeHeaders(std::move(response_headers), true);
+  EXPECT_EQ(0U, cm_.thread_local_cluster_.cluster_.info_->stats_store_
+                    .counter("upstream_rq_hedge")
+                    .value());
+  EXPECT_TRUE(verifyHostUpstreamStats(1, 0));
+}
+
+TEST_F(RouterTest, HedgeResponseWins) {
+  callbacks_.route_->route_entry_.hedge_policy_.latency_percentile_ = 90;
+  primeLatencyEstimator(std::chrono::milliseconds(3));
+
+  NiceMock<Http::MockStreamEncoder> encoder1;
+  EXPECT_CALL(cm_.conn_pool_, newStream(_, _))
+      .WillOnce(Invoke([&](Http::StreamDecoder&, Http::ConnectionPool::Callbacks& callbacks)
+                           -> Http::ConnectionPool::Cancellable* {
+        callbacks.onPoolReady(encoder1, cm_.conn_pool_.host_);
+        return nullptr;
+      }));
+  Event::MockTimer* hedge_timeout = new Event::MockTimer(&callbacks_.dispatcher_);
+  EXPECT_CALL(*hedge_timeout, enableTimer(std::chrono::milliseconds(3)));
+  EXPECT_CALL(*hedge_timeout, disableTimer()).Times(AtLeast(1));
+  expectResponseTimerCreate();
+
+  Http::TestHeaderMapImpl headers;
+  HttpTestUtility::addDefaultHeaders(headers);
+  router_.decodeHeaders(headers, true);
+
+  expectHedgePool();
+  NiceMock<Http::MockStreamEncoder> encoder2;
+  Http::StreamDecoder* response_decoder = nullptr;
+  EXPECT_CALL(hedge_pool_, newStream(_, _))
+      .WillOnce(Invoke([&](Http::StreamDecoder& decoder, Http::ConnectionPool::Callbacks& callbacks)
+                           -> Http::ConnectionPool::Cancellable* {
+        response_decoder = &decoder;
+        callbacks.onPoolReady(encoder2, hedge_pool_.host_);
+        return nullptr;
+      }));
+  hedge_timeout->callback_();
+  EXPECT_EQ(1U, cm_.thread_local_cluster_.cluster_.info_->stats_store_
+                    .counter("upstream_rq_hedge")
+                    .value());
+
+  // The first response is used and the other request is reset.
+  EXPECT_CALL(encoder1.stream_, resetStream(Http::StreamResetReason::LocalReset));
+  EXPECT_CALL(encoder2.stream_, resetStream(_)).Times(0);
+  EXPECT_CALL(callbacks_, encodeHeaders_(_, true));
+  Http::HeaderMapPtr response_headers(new Http::TestHeaderMapImpl{{":status", "200"}});
+  response_decoder->decodeHeaders(std::move(response_headers), true);
+  EXPECT_EQ(1U, cm_.thread_local_cluster_.cluster_.info_->stats_store_
+                    .counter("upstream_rq_hedge_success")
+                    .value());
+  EXPECT_TRUE(verifyHostUpstreamStats(0, 0));
+  EXPECT_EQ(1U, hedge_pool_.host_->stats_store_.counter("rq_success").value());
+}
+
+TEST_F(RouterTest, HedgedRequestLoses) {
+  callbacks_.route_->route_entry_.hedge_policy_.latency_percentile_ = 90;
+  callbacks_.route_->route_entry_.hedge_policy_.min_delay_ = std::chrono::milliseconds(5);
+  primeLatencyEstimator(std::chrono::milliseconds(3));
+
+  NiceMock<Http::MockStreamEncoder> encoder1;
+  Http::StreamDecoder* response_decoder = nullptr;
+  EXPECT_CALL(cm_.conn_pool_, newStream(_, _))
+      .WillOnce(Invoke([&](Http::StreamDecoder& decoder, Http::ConnectionPool::Callbacks& callbacks)
+                           -> Http::ConnectionPool::Cancellable* {
+        response_decoder = &decoder;
+        callbacks.onPoolReady(encoder1, cm_.conn_pool_.host_);
+        return nullptr;
+      }));
+  Event::MockTimer* hedge_timeout = new Event::MockTimer(&callbacks_.dispatcher_);
+  EXPECT_CALL(*hedge_timeout, enableTimer(std::chrono::milliseconds(5)));
+  EXPECT_CALL(*hedge_timeout, disableTimer()).Times(AtLeast(1));
+  expectResponseTimerCreate();
+
+  Http::TestHeaderMapImpl headers;
+  HttpTestUtility::addDefaultHeaders(headers);
+  router_.decodeHeaders(headers, true);
+
+  expectHedgePool();
+  NiceMock<Http::MockStreamEncoder> encoder2;
+  EXPECT_CALL(hedge_pool_, newStream(_, _))
+      .WillOnce(Invoke([&](Http::StreamDecoder&, Http::ConnectionPool::Callbacks& callbacks)
+                           -> Http::ConnectionPool::Cancellable* {
+        callbacks.onPoolReady(encoder2, hedge_pool_.host_);
+        return nullptr;
+      }));
+  hedge_timeout->callback_();
+
+  EXPECT_CALL(encoder1.stream_, resetStream(_)).Times(0);
+  EXPECT_CALL(encoder2.stream_, resetStream(Http::StreamResetReason::LocalReset));
+  EXPECT_CALL(callbacks_, encodeHeaders_(_, true));
+  Http::HeaderMapPtr response_headers(new Http::TestHeaderMapImpl{{":status", "200"}});
+  response_decoder->decodeHeaders(std::move(response_headers), true);
+  EXPECT_EQ(0U, cm_.thread_local_cluster_.cluster_.info_->stats_store_
+                    .counter("upstream_rq_hedge_success")
+                    .value());
+  EXPECT_TRUE(verifyHostUpstreamStats(1, 0));
+}
+
+// A failure of one of the hedged requests is not handled while the other one may still respond.
+TEST_F(RouterTest, HedgedRequestResetWhileOtherInFlight) {
+  callbacks_.route_->route_entry_.hedge_policy_.latency_percentile_ = 90;
+  primeLatencyEstimator(std::chrono::milliseconds(3));
+
+  NiceMock<Http::MockStreamEncoder> encoder1;
+  EXPECT_CALL(cm_.conn_pool_, newStream(_, _))
+      .WillOnce(Invoke([&](Http::StreamDecoder&, Http::ConnectionPool::Callbacks& callbacks)
+                           -> Http::ConnectionPool::Cancellable* {
+        callbacks.onPoolReady(encoder1, cm_.conn_pool_.host_);
+        return nullptr;
+      }));
+  Event::MockTimer* hedge_timeout = new Event::MockTimer(&callbacks_.dispatcher_);
+  EXPECT_CALL(*hedge_timeout, enableTimer(_));
+  EXPECT_CALL(*hedge_timeout, disableTimer()).Times(AtLeast(1));
+  expectResponseTimerCreate();
+
+  Http::TestHeaderMapImpl headers;
+  HttpTestUtility::addDefaultHeaders(headers);
+  router_.decodeHeaders(headers, true);
+
+  expectHedgePool();
+  NiceMock<Http::MockStreamEncoder> encoder2;
+  Http::StreamDecoder* response_decoder = nullptr;
+  EXPECT_CALL(hedge_pool_, newStream(_, _))
+      .WillOnce(Invoke([&](Http::StreamDecoder& decoder, Http::ConnectionPool::Callbacks& callbacks)
+                           -> Http::ConnectionPool::Cancellable* {
+        response_decoder = &decoder;
+        callbacks.onPoolReady(encoder2, hedge_pool_.host_);
+        return nullptr;
+      }));
+  hedge_timeout->callback_();
+
+  EXPECT_CALL(*router_.retry_state_, shouldRetry(_, _, _)).Times(0);
+  EXPECT_CALL(callbacks_, encodeHeaders_(_, _)).Times(0);
+  EXPECT_CALL(cm_.conn_pool_.host_->outlier_detector_, putHttpResponseCode(503));
+  encoder1.stream_.resetStream(Http::StreamResetReason::RemoteReset);
+  EXPECT_TRUE(verifyHostUpstreamStats(0, 1));
+
+  EXPECT_CALL(*router_.retry_state_, shouldRetry(_, _, _)).WillOnce(Return(RetryStatus::No));
+  EXPECT_CALL(callbacks_, encodeHeaders_(_, true));
+  EXPECT_CALL(hedge_pool_.host_->outlier_detector_, putHttpResponseCode(200));
+  Http::HeaderMapPtr response_headers(new Http::TestHeaderMapImpl{{":status", "200"}});
+  response_decoder->decodeHeaders(std::move(response_headers), true);
+  EXPECT_TRUE(verifyHostUpstreamStats(0, 1));
+  EXPECT_EQ(1U, hedge_pool_.host_->stats_store_.counter("rq_success").value());
+}
+
+// The load balancer is asked again when it picks the host of the original request.
+TEST_F(RouterTest, HedgeRepicksOriginalHost) {
+  callbacks_.route_->route_entry_.hedge_policy_.latency_percentile_ = 90;
+  primeLatencyEstimator(std::chrono::milliseconds(3));
+
+  NiceMock<Http::MockStreamEncoder> encoder1;
+  Http::StreamDecoder* response_decoder = nullptr;
+  EXPECT_CALL(cm_.conn_pool_, newStream(_, _))
+      .WillOnce(Invoke([&](Http::StreamDecoder& decoder, Http::ConnectionPool::Callbacks& callbacks)
+                           -> Http::ConnectionPool::Cancellable* {
+        response_decoder = &decoder;
+        callbacks.onPoolReady(encoder1, cm_.conn_pool_.host_);
+        return nullptr;
+      }));
+  Event::MockTimer* hedge_timeout = new Event::MockTimer(&callbacks_.dispatcher_);
+  EXPECT_CALL(*hedge_timeout, enableTimer(_));
+  EXPECT_CALL(*hedge_timeout, disableTimer()).Times(AtLeast(1));
+  expectResponseTimerCreate();
+
+  Http::TestHeaderMapImpl headers;
+  HttpTestUtility::addDefaultHeaders(headers);
+  router_.decodeHeaders(headers, true);
+
+  // The first pick is the original host, the second another one.
+  expectHedgePool();
+  EXPECT_CALL(cm_, httpConnPoolForCluster(_, _, _))
+      .WillOnce(Return(&cm_.conn_pool_))
+      .RetiresOnSaturation();
+  NiceMock<Http::MockStreamEncoder> encoder2;
+  EXPECT_CALL(hedge_pool_, newStream(_, _))
+      .WillOnce(Invoke([&](Http::StreamDecoder&, Http::ConnectionPool::Callbacks& callbacks)
+                           -> Http::ConnectionPool::Cancellable* {
+        callbacks.onPoolReady(encoder2, hedge_pool_.host_);
+        return nullptr;
+      }));
+  hedge_timeout->callback_();
+  EXPECT_EQ(1U, cm_.thread_local_cluster_.cluster_.info_->stats_store_
+                    .counter("upstream_rq_hedge")
+                    .value());
+  EXPECT_EQ(0U, cm_.thread_local_cluster_.cluster_.info_->stats_store_
+                    .counter("upstream_rq_hedge_same_host")
+                    .value());
+
+  EXPECT_CALL(encoder2.stream_, resetStream(Http::StreamResetReason::LocalReset));
+  EXPECT_CALL(callbacks_, encodeHeaders_(_, true));
+  Http::HeaderMapPtr response_headers(new Http::TestHeaderMapImpl{{":status", "200"}});
+  response_decoder->decodeHeaders(std::move(response_headers), true);
+  EXPECT_TRUE(verifyHostUpstreamStats(1, 0));
+}
+
+// A request is not hedged when the load balancer keeps picking the host of the original request.
+TEST_F(RouterTest, HedgeSkippedOnOriginalHost) {
+  callbacks_.route_->route_entry_.hedge_policy_.latency_percentile_ = 90;
+  primeLatencyEstimator(std::chrono::milliseconds(3));
+
+  NiceMock<Http::MockStreamEncoder> encoder;
+  Http::StreamDecoder* response_decoder = nullptr;
+  EXPECT_CALL(cm_.conn_pool_, newStream(_, _))
+      .WillOnce(Invoke([&](Http::StreamDecoder& decoder, Http::ConnectionPool::Callbacks& callbacks)
+                           -> Http::ConnectionPool::Cancellable* {
+        response_decoder = &decoder;
+        callbacks.onPoolReady(encoder, cm_.conn_pool_.host_);
+        return nullptr;
+      }));
+  Event::MockTimer* hedge_timeout = new Event::MockTimer(&callbacks_.dispatcher_);
+  EXPECT_CALL(*hedge_timeout, enableTimer(_));
+  EXPECT_CALL(*hedge_timeout, disableTimer()).Times(AtLeast(1));
+  expectResponseTimerCreate();
+
+  Http::TestHeaderMapImpl headers;
+  HttpTestUtility::addDefaultHeaders(headers);
+  router_.decodeHeaders(headers, true);
+
+  EXPECT_CALL(cm_, httpConnPoolForCluster(_, _, _)).Times(3);
+  EXPECT_CALL(cm_.conn_pool_, newStream(_, _)).Times(0);
+  hedge_timeout->callback_();
+  EXPECT_EQ(0U, cm_.thread_local_cluster_.cluster_.info_->stats_store_
+                    .counter("upstream_rq_hedge")
+                    .value());
+  EXPECT_EQ(1U, cm_.thread_local_cluster_.cluster_.info_->stats_store_
+                    .counter("upstream_rq_hedge_same_host")
+                    .value());
+
+  EXPECT_CALL(callbacks_, encodeHeaders_(_, true));
+  Http::HeaderMapPtr response_headers(new Http::TestHeaderMapImpl{{":status", "200"}});
+  response_decoder->decodeHeaders(std::move(response_headers), true);
+  EXPECT_TRUE(verifyHostUpstreamStats(1, 0));
+}
+
 TEST_F(RouterTest, AltStatName) {
   // Also test no upstream timeout here.
   EXPECT_CALL(callbacks_.route_->route_entry_, timeout())
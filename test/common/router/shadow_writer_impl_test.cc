@@ -1,16 +1,21 @@
 #include <chrono>
 #include <string>
 
+#include "common/buffer/buffer_impl.h"
 #include "common/http/headers.h"
 #include "common/http/message_impl.h"
 #include "common/router/shadow_writer_impl.h"
 
+#include "test/mocks/buffer/mocks.h"
+#include "test/mocks/http/mocks.h"
 #include "test/mocks/upstream/mocks.h"
+#include "test/test_common/utility.h"
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
 using testing::Invoke;
+using testing::Return;
 using testing::_;
 
 namespace Envoy {
@@ -59,5 +64,116 @@ TEST(ShadowWriterImplTest, All) {
   callback->onFailure(Http::AsyncClient::FailureReason::Reset);
 }
 
+class ShadowStreamTest : public testing::Test {
+public:
+  ShadowStream* startShadow() {
+    Http::HeaderMapPtr headers{new Http::TestHeaderMapImpl{{":authority", "cluster1"}}};
+    EXPECT_CALL(cm_, httpAsyncClientForCluster("foo")).WillOnce(ReturnRef(cm_.async_client_));
+    EXPECT_CALL(cm_.async_client_,
+                start(_, Optional<std::chrono::milliseconds>(std::chrono::milliseconds(5)), false))
+        .WillOnce(Invoke([&](Http::AsyncClient::StreamCallbacks& callbacks,
+                             const Optional<std::chrono::milliseconds>&,
+                             bool) -> Http::AsyncClient::Stream* {
+          callbacks_ = &callbacks;
+          return &stream_;
+        }));
+    EXPECT_CALL(stream_, sendHeaders(_, false)).WillOnce(Invoke([](Http::HeaderMap& headers, bool) {
+      EXPECT_STREQ("cluster1-shadow", headers.Host()->value().c_str());
+    }));
+    return writer_.streamShadow("foo", std::move(headers), false, std::chrono::milliseconds(5));
+  }
+
+  void expectDeferredDelete() { EXPECT_CALL(cm_.async_client_.dispatcher_, deferredDelete_(_)); }
+
+  Upstream::MockClusterManager cm_;
+  ShadowWriterImpl writer_{cm_};
+  Http::MockAsyncClientStream stream_;
+  Http::AsyncClient::StreamCallbacks* callbacks_{};
+};
+
+TEST_F(ShadowStreamTest, StreamsRequest) {
+  ShadowStream* shadow = startShadow();
+  ASSERT_NE(nullptr, shadow);
+
+  Buffer::OwnedImpl data("hello");
+  EXPECT_CALL(stream_, sendData(BufferStringEqual("hello"), false));
+  shadow->sendData(data, false);
+  // The router still owns the data and forwards it to the primary upstream.
+  EXPECT_EQ(5UL, data.length());
+
+  Http::TestHeaderMapImpl trailers{{"some", "trailer"}};
+  EXPECT_CALL(stream_, sendTrailers(HeaderMapEqualRef(&trailers)));
+  shadow->sendTrailers(trailers);
+
+  expectDeferredDelete();
+  callbacks_->onHeaders(Http::HeaderMapPtr{new Http::TestHeaderMapImpl{{":status", "200"}}},
+                        true);
+}
+
+TEST_F(ShadowStreamTest, EndStreamWithHeaders) {
+  Http::HeaderMapPtr headers{new Http::TestHeaderMapImpl{{":authority", "cluster1"}}};
+  EXPECT_CALL(cm_, httpAsyncClientForCluster("foo")).WillOnce(ReturnRef(cm_.async_client_));
+  EXPECT_CALL(cm_.async_client_, start(_, _, false))
+      .WillOnce(Invoke([&](Http::AsyncClient::StreamCallbacks& callbacks,
+                           const Optional<std::chrono::milliseconds>&,
+                           bool) -> Http::AsyncClient::Stream* {
+        callbacks_ = &callbacks;
+        return &stream_;
+      }));
+  EXPECT_CALL(stream_, sendHeaders(_, true));
+  EXPECT_EQ(nullptr,
+            writer_.streamShadow("foo", std::move(headers), true, std::chrono::milliseconds(5)));
+
+  // Nothing is left to send, but the stream lives on until the shadow responds.
+  expectDeferredDelete();
+  callbacks_->onHeaders(Http::HeaderMapPtr{new Http::TestHeaderMapImpl{{":status", "200"}}},
+                        true);
+}
+
+TEST_F(ShadowStreamTest, StartFailure) {
+  Http::HeaderMapPtr headers{new Http::TestHeaderMapImpl{{":authority", "cluster1"}}};
+  EXPECT_CALL(cm_, httpAsyncClientForCluster("foo")).WillOnce(ReturnRef(cm_.async_client_));
+  EXPECT_CALL(cm_.async_client_, start(_, _, false)).WillOnce(Return(nullptr));
+  expectDeferredDelete();
+  EXPECT_EQ(nullptr,
+            writer_.streamShadow("foo", std::move(headers), false, std::chrono::milliseconds(5)));
+}
+
+TEST_F(ShadowStreamTest, ResetWhenAboveHighWatermark) {
+  ShadowStream* shadow = startShadow();
+
+  Buffer::OwnedImpl data("hello");
+  EXPECT_CALL(stream_, isAboveWriteBufferHighWatermark()).WillOnce(Return(true));
+  EXPECT_CALL(stream_, reset()).WillOnce(Invoke([&]() { callbacks_->onReset(); }));
+  EXPECT_CALL(stream_, sendData(_, _)).Times(0);
+  shadow->sendData(data, false);
+
+  expectDeferredDelete();
+  shadow->sendData(data, true);
+}
+
+TEST_F(ShadowStreamTest, ResetWhenRespondedEarly) {
+  ShadowStream* shadow = startShadow();
+
+  callbacks_->onHeaders(Http::HeaderMapPtr{new Http::TestHeaderMapImpl{{":status", "413"}}},
+                        true);
+
+  Buffer::OwnedImpl data("hello");
+  EXPECT_CALL(stream_, reset()).WillOnce(Invoke([&]() { callbacks_->onReset(); }));
+  EXPECT_CALL(stream_, sendData(_, _)).Times(0);
+  shadow->sendData(data, false);
+
+  expectDeferredDelete();
+  shadow->cancel();
+}
+
+TEST_F(ShadowStreamTest, Cancel) {
+  ShadowStream* shadow = startShadow();
+
+  EXPECT_CALL(stream_, reset()).WillOnce(Invoke([&]() { callbacks_->onReset(); }));
+  expectDeferredDelete();
+  shadow->cancel();
+}
+
 } // namespace Router
 } // namespace Envoy
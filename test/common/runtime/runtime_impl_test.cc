@@ -1,6 +1,8 @@
 #include <memory>
+#include <regex>
 #include <string>
 
+#include "common/common/utility.h"
 #include "common/runtime/runtime_impl.h"
 #include "common/stats/stats_impl.h"
 
@@ -18,6 +20,7 @@ using testing::Invoke;
 using testing::NiceMock;
 using testing::Return;
 using testing::ReturnNew;
+using testing::SaveArg;
 using testing::_;
 
 namespace Envoy {
@@ -52,6 +55,18 @@ TEST(UUID, checkLengthOfUUID) {
   EXPECT_EQ(expected_length, result.length());
 }
 
+TEST(UUID, writeUuid) {
+  RandomGeneratorImpl random;
+
+  char uuid[RandomGenerator::UUID_LENGTH];
+  random.writeUuid(uuid);
+  const std::string result(uuid, sizeof(uuid));
+  EXPECT_TRUE(std::regex_match(
+      result, std::regex("[0-9a-f]{8}-[0-9a-f]{4}-4[0-9a-f]{3}-[89ab][0-9a-f]{3}-[0-9a-f]{12}")))
+      << result;
+  EXPECT_NE(result, random.uuid());
+}
+
 TEST(UUID, sanityCheckOfUniqueness) {
   std::set<std::string> uuids;
   const size_t num_of_uuids = 100000;
@@ -134,6 +149,72 @@ TEST_F(RuntimeImplTest, All) {
   EXPECT_EQ("hello override", loader->snapshot().get("file1"));
 }
 
+TEST_F(RuntimeImplTest, Keys) {
+  const Key file3("file3");
+  const Key file4("file4");
+  const Key subdir_file3("subdir.file3");
+  const Key invalid("invalid");
+  EXPECT_EQ("file3", file3.name());
+  EXPECT_EQ(file3.index(), Key("file3").index());
+  EXPECT_NE(file3.index(), file4.index());
+
+  setup();
+  run("test/common/runtime/test_data/current", "envoy_override");
+
+  EXPECT_EQ("hello\nworld", loader->snapshot().get(subdir_file3));
+  EXPECT_EQ("", loader->snapshot().get(invalid));
+  EXPECT_EQ(2UL, loader->snapshot().getInteger(file3, 1));
+  EXPECT_EQ(1UL, loader->snapshot().getInteger(invalid, 1));
+
+  EXPECT_CALL(generator, random()).WillOnce(Return(1));
+  EXPECT_TRUE(loader->snapshot().featureEnabled(file3, 1));
+  EXPECT_TRUE(loader->snapshot().featureEnabled(file3, 1, 1));
+  EXPECT_FALSE(loader->snapshot().featureEnabled(file3, 1, 3));
+  EXPECT_FALSE(loader->snapshot().featureEnabled(file4, 1, 200, 300));
+  EXPECT_TRUE(loader->snapshot().featureEnabled(file4, 1, 122, 300));
+
+  // Keys created after the snapshot was loaded are looked up by name.
+  const Key file1("file1");
+  const Key file5("file5");
+  EXPECT_EQ("hello override", loader->snapshot().get(file1));
+  EXPECT_EQ(123UL, loader->snapshot().getInteger(file5, 1));
+}
+
+// Files that did not change since the previous snapshot are not read again.
+TEST_F(RuntimeImplTest, ReuseUnchangedFiles) {
+  TestEnvironment::writeStringToFileForTest("runtime_reuse/envoy/file1", "1");
+  TestEnvironment::writeStringToFileForTest("runtime_reuse/envoy/file2", "2");
+
+  Filesystem::MockWatcher* watcher = new NiceMock<Filesystem::MockWatcher>();
+  Filesystem::Watcher::OnChangedCb on_changed;
+  EXPECT_CALL(dispatcher, createFilesystemWatcher_()).WillOnce(Return(watcher));
+  EXPECT_CALL(*watcher, addWatch(_, _, _)).WillOnce(SaveArg<2>(&on_changed));
+
+  // Pretend that the files were written long ago, and control when file1 looks modified.
+  time_t file1_modified = 1000;
+  os_sys_calls_ = new NiceMock<Api::MockOsSysCalls>;
+  ON_CALL(*os_sys_calls_, stat(_, _))
+      .WillByDefault(Invoke([&](const char* filename, struct stat* stat) {
+        const int rc = ::stat(filename, stat);
+        if (rc == 0 && S_ISREG(stat->st_mode)) {
+          stat->st_mtime = StringUtil::endsWith(filename, "file1") ? file1_modified : 1000;
+        }
+        return rc;
+      }));
+  run("runtime_reuse", "envoy_override");
+  EXPECT_EQ(1UL, loader->snapshot().getInteger("file1", 0));
+  EXPECT_EQ(2UL, loader->snapshot().getInteger("file2", 0));
+
+  // Rewrite both files without changing their sizes, but only make file1 look modified.
+  TestEnvironment::writeStringToFileForTest("runtime_reuse/envoy/file1", "3");
+  TestEnvironment::writeStringToFileForTest("runtime_reuse/envoy/file2", "4");
+  file1_modified = 2000;
+  on_changed(Filesystem::Watcher::Events::MovedTo);
+  EXPECT_EQ(3UL, loader->snapshot().getInteger("file1", 0));
+  EXPECT_EQ(2UL, loader->snapshot().getInteger("file2", 0));
+  EXPECT_EQ(1UL, store.counter("runtime.load_files_reused").value());
+}
+
 TEST_F(RuntimeImplTest, BadDirectory) {
   setup();
   run("/baddir", "/baddir");
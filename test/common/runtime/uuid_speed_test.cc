@@ -0,0 +1,37 @@
+// Compares formatting a request ID into a string and copying it into the header with writing it
+// straight into the header. Run with:
+// bazel run -c opt //test/common/runtime:uuid_speed_test
+
+#include "common/http/header_map_impl.h"
+#include "common/runtime/runtime_impl.h"
+
+#include "benchmark/benchmark.h"
+
+namespace Envoy {
+namespace Runtime {
+
+// The request ID of an edge request, generated as a string and copied into the header.
+static void UuidToHeaderViaString(benchmark::State& state) {
+  RandomGeneratorImpl random;
+  Http::HeaderMapImpl headers;
+  while (state.KeepRunning()) {
+    const std::string uuid = random.uuid();
+    headers.insertRequestId().value(uuid);
+  }
+}
+BENCHMARK(UuidToHeaderViaString);
+
+// The request ID of an edge request, written straight into the inline buffer of the header.
+static void UuidToHeaderDirect(benchmark::State& state) {
+  RandomGeneratorImpl random;
+  Http::HeaderMapImpl headers;
+  while (state.KeepRunning()) {
+    char uuid[RandomGenerator::UUID_LENGTH];
+    random.writeUuid(uuid);
+    headers.insertRequestId().value(uuid, sizeof(uuid));
+  }
+}
+BENCHMARK(UuidToHeaderDirect);
+
+} // namespace Runtime
+} // namespace Envoy
@@ -1,17 +1,26 @@
 #include <string>
 #include <vector>
 
+#include "common/filesystem/filesystem_impl.h"
 #include "common/json/json_loader.h"
 #include "common/ssl/context_config_impl.h"
 #include "common/ssl/context_impl.h"
 #include "common/stats/stats_impl.h"
 
 #include "test/common/ssl/ssl_certs_test.h"
+#include "test/mocks/event/mocks.h"
+#include "test/mocks/filesystem/mocks.h"
 #include "test/mocks/runtime/mocks.h"
 #include "test/test_common/environment.h"
+#include "test/test_common/utility.h"
 
+#include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
+using testing::Return;
+using testing::SaveArg;
+using testing::_;
+
 namespace Envoy {
 namespace Ssl {
 
@@ -266,5 +275,100 @@ TEST_F(SslServerContextImplTicketTest, TicketKeyInlineFailTooSmall) {
   EXPECT_THROW(loadConfigV2(cfg), EnvoyException);
 }
 
+TEST_F(SslServerContextImplTicketTest, TicketKeyRotation) {
+  const std::string key_a = Filesystem::fileReadToEnd(
+      TestEnvironment::runfilesPath("test/common/ssl/test_data/ticket_key_a"));
+  const std::string key_b = Filesystem::fileReadToEnd(
+      TestEnvironment::runfilesPath("test/common/ssl/test_data/ticket_key_b"));
+  const std::string key_file =
+      TestEnvironment::writeStringToFileForTest("ticket_key_rotation", key_a);
+
+  Runtime::MockLoader runtime;
+  ContextManagerImpl manager(runtime);
+  Event::MockDispatcher dispatcher;
+  Filesystem::MockWatcher* watcher = new Filesystem::MockWatcher();
+  EXPECT_CALL(dispatcher, createFilesystemWatcher_()).WillOnce(Return(watcher));
+  manager.watchSessionTicketKeyFiles(dispatcher);
+
+  Filesystem::Watcher::OnChangedCb on_changed;
+  EXPECT_CALL(*watcher, addWatch(key_file, Filesystem::Watcher::Events::MovedTo, _))
+      .WillOnce(SaveArg<2>(&on_changed));
+  envoy::api::v2::DownstreamTlsContext cfg;
+  cfg.mutable_session_ticket_keys()->add_keys()->set_filename(key_file);
+  envoy::api::v2::TlsCertificate* server_cert =
+      cfg.mutable_common_tls_context()->add_tls_certificates();
+  server_cert->mutable_certificate_chain()->set_filename(
+      TestEnvironment::substitute("{{ test_tmpdir }}/unittestcert.pem"));
+  server_cert->mutable_private_key()->set_filename(
+      TestEnvironment::substitute("{{ test_tmpdir }}/unittestkey.pem"));
+  ServerContextConfigImpl server_context_config(cfg);
+  Stats::IsolatedStoreImpl store;
+  ServerContextPtr server_ctx(
+      manager.createSslServerContext("", {}, store, server_context_config, true));
+
+  // The current keys stay in use when the file is invalid.
+  TestEnvironment::writeStringToFileForTest("ticket_key_rotation", "invalid");
+  on_changed(Filesystem::Watcher::Events::MovedTo);
+  EXPECT_EQ(1UL, store.counter("ssl.session_ticket_keys_reload_failed").value());
+  EXPECT_EQ(0UL, store.counter("ssl.session_ticket_keys_reloaded").value());
+
+  TestEnvironment::writeStringToFileForTest("ticket_key_rotation", key_b);
+  on_changed(Filesystem::Watcher::Events::MovedTo);
+  EXPECT_EQ(1UL, store.counter("ssl.session_ticket_keys_reloaded").value());
+
+  // Nothing happens once the context is gone.
+  server_ctx.reset();
+  on_changed(Filesystem::Watcher::Events::MovedTo);
+  EXPECT_EQ(1UL, store.counter("ssl.session_ticket_keys_reloaded").value());
+}
+
+TEST_F(SslServerContextImplTicketTest, TicketKeyFilesInline) {
+  envoy::api::v2::DownstreamTlsContext cfg;
+  cfg.mutable_session_ticket_keys()->add_keys()->set_filename(
+      TestEnvironment::runfilesPath("test/common/ssl/test_data/ticket_key_a"));
+  cfg.mutable_session_ticket_keys()->add_keys()->set_inline_(std::string(80, '\0'));
+  envoy::api::v2::TlsCertificate* server_cert =
+      cfg.mutable_common_tls_context()->add_tls_certificates();
+  server_cert->mutable_certificate_chain()->set_filename(
+      TestEnvironment::substitute("{{ test_tmpdir }}/unittestcert.pem"));
+  server_cert->mutable_private_key()->set_filename(
+      TestEnvironment::substitute("{{ test_tmpdir }}/unittestkey.pem"));
+  ServerContextConfigImpl server_context_config(cfg);
+  EXPECT_EQ(2U, server_context_config.sessionTicketKeys().size());
+  EXPECT_TRUE(server_context_config.sessionTicketKeyFiles().empty());
+}
+
+TEST_F(SslServerContextImplTicketTest, AdditionalCertificates) {
+  envoy::api::v2::DownstreamTlsContext cfg;
+  envoy::api::v2::TlsCertificate* server_cert =
+      cfg.mutable_common_tls_context()->add_tls_certificates();
+  server_cert->mutable_certificate_chain()->set_filename(
+      TestEnvironment::runfilesPath("test/common/ssl/test_data/san_dns_ecdsa_cert.pem"));
+  server_cert->mutable_private_key()->set_filename(
+      TestEnvironment::runfilesPath("test/common/ssl/test_data/san_dns_ecdsa_key.pem"));
+  server_cert = cfg.mutable_common_tls_context()->add_tls_certificates();
+  server_cert->mutable_certificate_chain()->set_filename(
+      TestEnvironment::runfilesPath("test/common/ssl/test_data/san_dns_cert.pem"));
+  server_cert->mutable_private_key()->set_filename(
+      TestEnvironment::runfilesPath("test/common/ssl/test_data/san_dns_key.pem"));
+
+  {
+    ServerContextConfigImpl server_context_config(cfg);
+    ASSERT_EQ(1U, server_context_config.additionalCertificates().size());
+    EXPECT_EQ(TestEnvironment::runfilesPath("test/common/ssl/test_data/san_dns_cert.pem"),
+              server_context_config.additionalCertificates()[0].cert_chain_file_);
+    EXPECT_NO_THROW(loadConfig(server_context_config));
+  }
+
+  // The key of an additional certificate has to match it.
+  server_cert->mutable_private_key()->set_filename(
+      TestEnvironment::runfilesPath("test/common/ssl/test_data/san_dns_key2.pem"));
+  ServerContextConfigImpl server_context_config(cfg);
+  EXPECT_THROW_WITH_MESSAGE(loadConfig(server_context_config), EnvoyException,
+                            "Failed to load private key file " +
+                                TestEnvironment::runfilesPath(
+                                    "test/common/ssl/test_data/san_dns_key2.pem"));
+}
+
 } // namespace Ssl
 } // namespace Envoy
@@ -0,0 +1,68 @@
+#include <string>
+
+#include "common/ssl/session_cache.h"
+
+#include "test/mocks/runtime/mocks.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::NiceMock;
+using testing::Return;
+
+namespace Envoy {
+namespace Ssl {
+
+class SslSessionCacheTest : public testing::Test {
+public:
+  SslSessionCacheTest() {
+    ON_CALL(runtime_.snapshot_, getInteger("ssl.session_cache.max_entries", 0))
+        .WillByDefault(Return(SessionCache::Shards));
+  }
+
+  NiceMock<Runtime::MockLoader> runtime_;
+  SessionCache cache_{runtime_};
+};
+
+TEST_F(SslSessionCacheTest, Disabled) {
+  EXPECT_CALL(runtime_.snapshot_, getInteger("ssl.session_cache.max_entries", 0))
+      .WillRepeatedly(Return(0));
+  cache_.insert("id", "session");
+  std::string session;
+  EXPECT_FALSE(cache_.lookup("id", session));
+  EXPECT_EQ(0U, cache_.size());
+}
+
+TEST_F(SslSessionCacheTest, InsertLookupRemove) {
+  std::string session;
+  EXPECT_FALSE(cache_.lookup("id", session));
+
+  cache_.insert("id", "session");
+  EXPECT_TRUE(cache_.lookup("id", session));
+  EXPECT_EQ("session", session);
+
+  cache_.insert("id", "new session");
+  EXPECT_TRUE(cache_.lookup("id", session));
+  EXPECT_EQ("new session", session);
+  EXPECT_EQ(1U, cache_.size());
+
+  cache_.remove("id");
+  EXPECT_FALSE(cache_.lookup("id", session));
+  cache_.remove("id");
+  EXPECT_EQ(0U, cache_.size());
+}
+
+TEST_F(SslSessionCacheTest, MaxEntries) {
+  // Each shard holds a single session, so the last session inserted is always cached.
+  const uint64_t shards = SessionCache::Shards;
+  std::string session;
+  for (uint64_t i = 0; i < 10 * shards; i++) {
+    const std::string id = std::to_string(i);
+    cache_.insert(id, "session");
+    EXPECT_TRUE(cache_.lookup(id, session));
+    EXPECT_GE(shards, cache_.size());
+  }
+}
+
+} // namespace Ssl
+} // namespace Envoy
@@ -11,6 +11,7 @@
 #include "common/network/utility.h"
 #include "common/ssl/context_config_impl.h"
 #include "common/ssl/context_impl.h"
+#include "common/ssl/private_key_method_provider_impl.h"
 #include "common/ssl/ssl_socket.h"
 #include "common/stats/stats_impl.h"
 
@@ -29,6 +30,7 @@
 #include "openssl/ssl.h"
 
 using testing::Invoke;
+using testing::Return;
 using testing::StrictMock;
 using testing::_;
 
@@ -575,15 +577,149 @@ TEST_P(SslSocketTest, ClientAuthMultipleCAs) {
   EXPECT_EQ(1UL, stats_store.counter("ssl.handshake").value());
 }
 
+// Verify that the second handshake with the same client certificate uses the cached result of the
+// first verification.
+TEST_P(SslSocketTest, VerifyCache) {
+  Stats::IsolatedStoreImpl stats_store;
+  Runtime::MockLoader runtime;
+
+  std::string server_ctx_json = R"EOF(
+  {
+    "cert_chain_file": "{{ test_tmpdir }}/unittestcert.pem",
+    "private_key_file": "{{ test_tmpdir }}/unittestkey.pem",
+    "ca_cert_file": "{{ test_rundir }}/test/common/ssl/test_data/ca_cert.pem",
+    "verify_subject_alt_name": [ "spiffe://lyft.com/test-team" ]
+  }
+  )EOF";
+
+  Json::ObjectSharedPtr server_ctx_loader = TestEnvironment::jsonLoadFromString(server_ctx_json);
+  ServerContextConfigImpl server_ctx_config(*server_ctx_loader);
+  ContextManagerImpl manager(runtime);
+  ServerContextPtr server_ctx(
+      manager.createSslServerContext("", {}, stats_store, server_ctx_config, true));
+
+  Event::DispatcherImpl dispatcher;
+  Network::TcpListenSocket socket(Network::Test::getCanonicalLoopbackAddress(GetParam()), true);
+  Network::MockListenerCallbacks callbacks;
+  Network::MockConnectionHandler connection_handler;
+  Network::ListenerPtr listener =
+      dispatcher.createSslListener(connection_handler, *server_ctx, socket, callbacks, stats_store,
+                                   Network::ListenerOptions::listenerOptionsWithBindToPort());
+
+  std::string client_ctx_json = R"EOF(
+  {
+    "cert_chain_file": "{{ test_rundir }}/test/common/ssl/test_data/san_uri_cert.pem",
+    "private_key_file": "{{ test_rundir }}/test/common/ssl/test_data/san_uri_key.pem"
+  }
+  )EOF";
+
+  Json::ObjectSharedPtr client_ctx_loader = TestEnvironment::jsonLoadFromString(client_ctx_json);
+  ClientContextConfigImpl client_ctx_config(*client_ctx_loader);
+  ClientContextPtr client_ctx(manager.createSslClientContext(stats_store, client_ctx_config));
+
+  for (uint64_t i = 0; i < 2; i++) {
+    Network::ClientConnectionPtr client_connection = dispatcher.createSslClientConnection(
+        *client_ctx, socket.localAddress(), Network::Address::InstanceConstSharedPtr());
+    client_connection->connect();
+
+    Network::MockConnectionCallbacks server_connection_callbacks;
+    Network::ConnectionPtr server_connection;
+    EXPECT_CALL(callbacks, onNewConnection_(_))
+        .WillOnce(Invoke([&](Network::ConnectionPtr& conn) -> void {
+          server_connection = std::move(conn);
+          server_connection->addConnectionCallbacks(server_connection_callbacks);
+        }));
+
+    EXPECT_CALL(server_connection_callbacks, onEvent(Network::ConnectionEvent::Connected))
+        .WillOnce(Invoke([&](Network::ConnectionEvent) -> void {
+          EXPECT_EQ("spiffe://lyft.com/test-team",
+                    server_connection->ssl()->uriSanPeerCertificate());
+          server_connection->close(Network::ConnectionCloseType::NoFlush);
+          client_connection->close(Network::ConnectionCloseType::NoFlush);
+          dispatcher.exit();
+        }));
+    EXPECT_CALL(server_connection_callbacks, onEvent(Network::ConnectionEvent::LocalClose));
+
+    dispatcher.run(Event::Dispatcher::RunType::Block);
+
+    EXPECT_EQ(i, stats_store.counter("ssl.verify_cache_hit").value());
+  }
+}
+
+// Verify that handshakes complete when the private key operations run on the threads of a
+// PrivateKeyMethodProvider, both for signatures (ECDHE) and for decryption (RSA key exchange).
+TEST_P(SslSocketTest, PrivateKeyMethodProvider) {
+  for (const std::string cipher_suites : {"ECDHE-RSA-AES128-GCM-SHA256", "AES128-SHA"}) {
+    Stats::IsolatedStoreImpl stats_store;
+    Runtime::MockLoader runtime;
+    ContextManagerImpl manager(
+        runtime, PrivateKeyMethodProviderPtr{new ThreadPoolPrivateKeyMethodProvider(1)});
+
+    std::string server_ctx_json = R"EOF(
+    {
+      "cert_chain_file": "{{ test_tmpdir }}/unittestcert.pem",
+      "private_key_file": "{{ test_tmpdir }}/unittestkey.pem"
+    }
+    )EOF";
+    Json::ObjectSharedPtr server_ctx_loader = TestEnvironment::jsonLoadFromString(server_ctx_json);
+    ServerContextConfigImpl server_ctx_config(*server_ctx_loader);
+    ServerContextPtr server_ctx(
+        manager.createSslServerContext("", {}, stats_store, server_ctx_config, true));
+
+    Event::DispatcherImpl dispatcher;
+    Network::TcpListenSocket socket(Network::Test::getCanonicalLoopbackAddress(GetParam()), true);
+    Network::MockListenerCallbacks callbacks;
+    Network::MockConnectionHandler connection_handler;
+    Network::ListenerPtr listener = dispatcher.createSslListener(
+        connection_handler, *server_ctx, socket, callbacks, stats_store,
+        Network::ListenerOptions::listenerOptionsWithBindToPort());
+
+    std::string client_ctx_json = R"EOF(
+    {
+      "cipher_suites": ")EOF" + cipher_suites + R"EOF("
+    }
+    )EOF";
+    Json::ObjectSharedPtr client_ctx_loader = TestEnvironment::jsonLoadFromString(client_ctx_json);
+    ClientContextConfigImpl client_ctx_config(*client_ctx_loader);
+    ClientContextPtr client_ctx(manager.createSslClientContext(stats_store, client_ctx_config));
+    Network::ClientConnectionPtr client_connection = dispatcher.createSslClientConnection(
+        *client_ctx, socket.localAddress(), Network::Address::InstanceConstSharedPtr());
+    client_connection->connect();
+
+    Network::ConnectionPtr server_connection;
+    Network::MockConnectionCallbacks server_connection_callbacks;
+    EXPECT_CALL(callbacks, onNewConnection_(_))
+        .WillOnce(Invoke([&](Network::ConnectionPtr& conn) -> void {
+          server_connection = std::move(conn);
+          server_connection->addConnectionCallbacks(server_connection_callbacks);
+        }));
+
+    EXPECT_CALL(server_connection_callbacks, onEvent(Network::ConnectionEvent::Connected))
+        .WillOnce(Invoke([&](Network::ConnectionEvent) -> void {
+          server_connection->close(Network::ConnectionCloseType::NoFlush);
+          client_connection->close(Network::ConnectionCloseType::NoFlush);
+          dispatcher.exit();
+        }));
+    EXPECT_CALL(server_connection_callbacks, onEvent(Network::ConnectionEvent::LocalClose));
+
+    dispatcher.run(Event::Dispatcher::RunType::Block);
+
+    EXPECT_EQ(1UL, stats_store.counter("ssl.handshake").value());
+  }
+}
+
 namespace {
 
 // Test connecting with a client to server1, then trying to reuse the session on server2
 void testTicketSessionResumption(const std::string& server_ctx_json1,
                                  const std::string& server_ctx_json2,
                                  const std::string& client_ctx_json, bool expect_reuse,
-                                 const Network::Address::IpVersion ip_version) {
+                                 const Network::Address::IpVersion ip_version,
+                                 uint64_t session_cache_max_entries = 0) {
   Stats::IsolatedStoreImpl stats_store;
   Runtime::MockLoader runtime;
+  ON_CALL(runtime.snapshot_, getInteger("ssl.session_cache.max_entries", 0))
+      .WillByDefault(Return(session_cache_max_entries));
 
   Json::ObjectSharedPtr server_ctx_loader1 = TestEnvironment::jsonLoadFromString(server_ctx_json1);
   Json::ObjectSharedPtr server_ctx_loader2 = TestEnvironment::jsonLoadFromString(server_ctx_json2);
@@ -697,6 +833,26 @@ TEST_P(SslSocketTest, TicketSessionResumption) {
   testTicketSessionResumption(server_ctx_json, server_ctx_json, client_ctx_json, true, GetParam());
 }
 
+// Sessions are resumed from the cache shared by the contexts instead of from tickets once the cache
+// is enabled.
+TEST_P(SslSocketTest, SharedSessionCacheResumption) {
+  std::string server_ctx_json = R"EOF(
+  {
+    "cert_chain_file": "{{ test_tmpdir }}/unittestcert.pem",
+    "private_key_file": "{{ test_tmpdir }}/unittestkey.pem"
+  }
+  )EOF";
+
+  std::string client_ctx_json = R"EOF(
+  {
+  }
+  )EOF";
+
+  testTicketSessionResumption(server_ctx_json, server_ctx_json, client_ctx_json, false, GetParam());
+  testTicketSessionResumption(server_ctx_json, server_ctx_json, client_ctx_json, true, GetParam(),
+                              1000);
+}
+
 TEST_P(SslSocketTest, TicketSessionResumptionWithClientCA) {
   std::string server_ctx_json = R"EOF(
   {
@@ -1092,6 +1248,54 @@ TEST_P(SslSocketTest, ProtocolVersions) {
   testUtilV2(listener, client_ctx, "", true, "TLSv1.3", "", "", "", "ssl.handshake", 2, GetParam());
 }
 
+TEST_P(SslSocketTest, MultipleCertificates) {
+  const std::string ecdsa_digest =
+      "b23683a37a0181c22e48f74df215d7f2d14137a265a8a3b20f63f4f719f923a1";
+  const std::string rsa_digest = "1406294e80c818158697d65d2aaca16748ff132442ab0e2f28bc1109f1d47a2e";
+
+  envoy::api::v2::Listener listener;
+  envoy::api::v2::FilterChain* filter_chain = listener.add_filter_chains();
+  envoy::api::v2::CommonTlsContext* server_ctx =
+      filter_chain->mutable_tls_context()->mutable_common_tls_context();
+  envoy::api::v2::TlsCertificate* ecdsa_cert = server_ctx->add_tls_certificates();
+  ecdsa_cert->mutable_certificate_chain()->set_filename(TestEnvironment::substitute(
+      "{{ test_rundir }}/test/common/ssl/test_data/san_dns_ecdsa_cert.pem"));
+  ecdsa_cert->mutable_private_key()->set_filename(TestEnvironment::substitute(
+      "{{ test_rundir }}/test/common/ssl/test_data/san_dns_ecdsa_key.pem"));
+  envoy::api::v2::TlsCertificate* rsa_cert = server_ctx->add_tls_certificates();
+  rsa_cert->mutable_certificate_chain()->set_filename(
+      TestEnvironment::substitute("{{ test_rundir }}/test/common/ssl/test_data/san_dns_cert.pem"));
+  rsa_cert->mutable_private_key()->set_filename(
+      TestEnvironment::substitute("{{ test_rundir }}/test/common/ssl/test_data/san_dns_key.pem"));
+  server_ctx->mutable_tls_params()->set_tls_maximum_protocol_version(
+      envoy::api::v2::TlsParameters::TLSv1_3);
+
+  envoy::api::v2::UpstreamTlsContext client_ctx;
+  envoy::api::v2::TlsParameters* client_params =
+      client_ctx.mutable_common_tls_context()->mutable_tls_params();
+
+  // Clients that support ECDSA get the first certificate.
+  testUtilV2(listener, client_ctx, "", true, "TLSv1.2", ecdsa_digest, "", "", "ssl.handshake", 2,
+             GetParam());
+
+  // TLS 1.3 clients pick the signature algorithm instead of the cipher suite.
+  client_params->set_tls_maximum_protocol_version(envoy::api::v2::TlsParameters::TLSv1_3);
+  testUtilV2(listener, client_ctx, "", true, "TLSv1.3", ecdsa_digest, "", "", "ssl.handshake", 2,
+             GetParam());
+
+  // Clients that only offer RSA cipher suites get the RSA certificate.
+  client_params->clear_tls_maximum_protocol_version();
+  client_params->add_cipher_suites("ECDHE-RSA-AES128-GCM-SHA256");
+  testUtilV2(listener, client_ctx, "", true, "TLSv1.2", rsa_digest, "", "", "ssl.handshake", 2,
+             GetParam());
+
+  // The order of the certificates is kept when the client supports both.
+  server_ctx->mutable_tls_certificates()->SwapElements(0, 1);
+  client_params->clear_cipher_suites();
+  testUtilV2(listener, client_ctx, "", true, "TLSv1.2", rsa_digest, "", "", "ssl.handshake", 2,
+             GetParam());
+}
+
 TEST_P(SslSocketTest, SniCertificate) {
   envoy::api::v2::Listener listener;
 
@@ -1773,6 +1977,65 @@ TEST_P(SslReadBufferLimitTest, WritesSmallerThanBufferLimit) { singleWriteTest(5
 
 TEST_P(SslReadBufferLimitTest, WritesLargerThanBufferLimit) { singleWriteTest(1024, 5 * 1024); }
 
+// Verify that writes go through whether or not the kernel can take over the encryption of the
+// client's writes, which depends on the kernel and the negotiated cipher.
+TEST_P(SslReadBufferLimitTest, KernelTlsTx) {
+  ON_CALL(runtime_.snapshot_, featureEnabled("ssl.kernel_tls_tx", 0)).WillByDefault(Return(true));
+  readBufferLimitTest(0, 256 * 1024, 256 * 1024, 1, false);
+  EXPECT_GE(1UL, stats_store_.counter("ssl.kernel_tls_tx").value());
+}
+
+// Verify that small slices in the write buffer go out in a single record.
+TEST_P(SslReadBufferLimitTest, SmallSlicesCoalesced) {
+  initialize(0);
+
+  uint32_t records = 0;
+  EXPECT_CALL(listener_callbacks_, onNewConnection_(_))
+      .WillOnce(Invoke([&](Network::ConnectionPtr& conn) -> void {
+        server_connection_ = std::move(conn);
+        server_connection_->addConnectionCallbacks(server_callbacks_);
+        server_connection_->addReadFilter(read_filter_);
+        SSL* ssl = dynamic_cast<Ssl::SslSocket*>(server_connection_->ssl())->rawSslForTest();
+        SSL_set_msg_callback(ssl, [](int write_p, int, int content_type, const void* buf, size_t,
+                                     SSL*, void* arg) -> void {
+          if (!write_p && content_type == SSL3_RT_HEADER &&
+              static_cast<const uint8_t*>(buf)[0] == SSL3_RT_APPLICATION_DATA) {
+            (*static_cast<uint32_t*>(arg))++;
+          }
+        });
+        SSL_set_msg_callback_arg(ssl, &records);
+      }));
+
+  EXPECT_CALL(client_callbacks_, onEvent(Network::ConnectionEvent::Connected))
+      .WillOnce(Invoke([&](Network::ConnectionEvent) -> void { dispatcher_->exit(); }));
+  dispatcher_->run(Event::Dispatcher::RunType::Block);
+
+  uint32_t filter_seen = 0;
+  EXPECT_CALL(*read_filter_, onNewConnection());
+  EXPECT_CALL(*read_filter_, onData(_))
+      .WillRepeatedly(Invoke([&](Buffer::Instance& data) -> Network::FilterStatus {
+        filter_seen += data.length();
+        data.drain(data.length());
+        if (filter_seen == 1200) {
+          dispatcher_->exit();
+        }
+        return Network::FilterStatus::StopIteration;
+      }));
+
+  Buffer::OwnedImpl data;
+  for (uint32_t i = 0; i < 30; i++) {
+    Buffer::OwnedImpl slice(std::string(40, 'a'));
+    data.move(slice);
+  }
+  client_connection_->write(data);
+  dispatcher_->run(Event::Dispatcher::RunType::Block);
+
+  EXPECT_EQ(1200U, filter_seen);
+  EXPECT_EQ(1U, records);
+
+  disconnect();
+}
+
 TEST_P(SslReadBufferLimitTest, TestBind) {
   std::string address_string = TestUtility::getIpv4Loopback();
   if (GetParam() == Network::Address::IpVersion::v4) {
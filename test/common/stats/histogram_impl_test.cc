@@ -0,0 +1,133 @@
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "common/stats/histogram_impl.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Stats {
+
+TEST(HistogramBucketsTest, Layout) {
+  // Small values are exact.
+  for (uint64_t value = 0; value < 2 * HistogramBuckets::SubBuckets; value++) {
+    EXPECT_EQ(value, HistogramBuckets::index(value));
+    EXPECT_EQ(value, HistogramBuckets::lowerBound(value));
+    EXPECT_EQ(1UL, HistogramBuckets::width(value));
+  }
+
+  // Buckets are contiguous and cover every 64 bit value.
+  EXPECT_EQ(0UL, HistogramBuckets::lowerBound(0));
+  for (uint32_t index = 1; index < HistogramBuckets::BucketCount; index++) {
+    EXPECT_EQ(HistogramBuckets::lowerBound(index - 1) + HistogramBuckets::width(index - 1),
+              HistogramBuckets::lowerBound(index));
+    EXPECT_EQ(index, HistogramBuckets::index(HistogramBuckets::lowerBound(index)));
+    EXPECT_EQ(index - 1, HistogramBuckets::index(HistogramBuckets::lowerBound(index) - 1));
+  }
+  EXPECT_EQ(HistogramBuckets::BucketCount - 1, HistogramBuckets::index(UINT64_MAX));
+  EXPECT_EQ(0UL, HistogramBuckets::lowerBound(HistogramBuckets::BucketCount - 1) +
+                     HistogramBuckets::width(HistogramBuckets::BucketCount - 1));
+
+  // The relative error of a bucket is bounded by 1 / SubBuckets.
+  for (uint32_t index = 2 * HistogramBuckets::SubBuckets; index < HistogramBuckets::BucketCount;
+       index++) {
+    EXPECT_LE(HistogramBuckets::width(index) * HistogramBuckets::SubBuckets,
+              HistogramBuckets::lowerBound(index));
+  }
+}
+
+TEST(HistogramRecorderTest, AddTo) {
+  HistogramRecorder recorder;
+  std::vector<uint64_t> counts(HistogramBuckets::BucketCount);
+  uint64_t sum = 0;
+  recorder.addTo(counts, sum);
+  EXPECT_EQ(std::vector<uint64_t>(HistogramBuckets::BucketCount), counts);
+  EXPECT_EQ(0UL, sum);
+
+  recorder.recordValue(0);
+  recorder.recordValue(7);
+  recorder.recordValue(7);
+  recorder.recordValue(1000);
+  recorder.recordValue(UINT64_MAX);
+
+  // Counts are added to, not overwritten.
+  counts[HistogramBuckets::index(7)] = 1;
+  sum = 1;
+  recorder.addTo(counts, sum);
+  EXPECT_EQ(1UL, counts[0]);
+  EXPECT_EQ(3UL, counts[HistogramBuckets::index(7)]);
+  EXPECT_EQ(1UL, counts[HistogramBuckets::index(1000)]);
+  EXPECT_EQ(1UL, counts[HistogramBuckets::BucketCount - 1]);
+  uint64_t total = 0;
+  for (uint64_t count : counts) {
+    total += count;
+  }
+  EXPECT_EQ(6UL, total);
+  // The sum wraps like any other unsigned arithmetic.
+  EXPECT_EQ(1UL + 7 + 7 + 1000 + UINT64_MAX, sum);
+}
+
+TEST(HistogramStatisticsImplTest, Empty) {
+  HistogramStatisticsImpl statistics;
+  EXPECT_EQ(statistics.supportedQuantiles().size(), statistics.computedQuantiles().size());
+  for (double value : statistics.computedQuantiles()) {
+    EXPECT_TRUE(std::isnan(value));
+  }
+  EXPECT_EQ("P0: nan, P25: nan, P50: nan, P75: nan, P90: nan, P95: nan, P99: nan, P99.9: nan, "
+            "P100: nan",
+            statistics.summary());
+
+  statistics.refresh(std::vector<uint64_t>(HistogramBuckets::BucketCount), 0);
+  EXPECT_EQ(0UL, statistics.sampleCount());
+  EXPECT_TRUE(std::isnan(statistics.computedQuantiles().front()));
+}
+
+TEST(HistogramStatisticsImplTest, ExactValues) {
+  HistogramRecorder recorder;
+  for (uint64_t value = 1; value <= 9; value++) {
+    recorder.recordValue(value);
+  }
+  recorder.recordValue(30);
+
+  std::vector<uint64_t> counts(HistogramBuckets::BucketCount);
+  uint64_t sum = 0;
+  recorder.addTo(counts, sum);
+  HistogramStatisticsImpl statistics;
+  statistics.refresh(counts, sum);
+  EXPECT_EQ(10UL, statistics.sampleCount());
+  EXPECT_EQ(75UL, statistics.sampleSum());
+  EXPECT_EQ("P0: 1, P25: 3, P50: 5, P75: 7, P90: 9, P95: 9, P99: 9, P99.9: 9, P100: 30",
+            statistics.summary());
+}
+
+TEST(HistogramStatisticsImplTest, ApproximateValues) {
+  HistogramRecorder recorder;
+  for (uint64_t value = 1; value <= 100000; value++) {
+    recorder.recordValue(value);
+  }
+
+  std::vector<uint64_t> counts(HistogramBuckets::BucketCount);
+  uint64_t sum = 0;
+  recorder.addTo(counts, sum);
+  HistogramStatisticsImpl statistics;
+  statistics.refresh(counts, sum);
+  EXPECT_EQ(100000UL, statistics.sampleCount());
+  for (size_t i = 0; i < statistics.supportedQuantiles().size(); i++) {
+    const double expected = 1 + statistics.supportedQuantiles()[i] * 99999;
+    EXPECT_NEAR(expected, statistics.computedQuantiles()[i],
+                expected / HistogramBuckets::SubBuckets);
+  }
+}
+
+TEST(HistogramStatisticsImplTest, QuantileName) {
+  EXPECT_EQ("p0", HistogramStatisticsImpl::quantileName(0));
+  EXPECT_EQ("p50", HistogramStatisticsImpl::quantileName(0.5));
+  EXPECT_EQ("p90", HistogramStatisticsImpl::quantileName(0.9));
+  EXPECT_EQ("p99_9", HistogramStatisticsImpl::quantileName(0.999));
+  EXPECT_EQ("p100", HistogramStatisticsImpl::quantileName(1));
+}
+
+} // namespace Stats
+} // namespace Envoy
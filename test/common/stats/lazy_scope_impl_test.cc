@@ -0,0 +1,56 @@
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/stats/lazy_scope_impl.h"
+#include "common/stats/stats_impl.h"
+
+#include "test/test_common/utility.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Stats {
+
+TEST(LazyScopeImplTest, CounterCreatedOnFirstWrite) {
+  IsolatedStoreImpl store;
+  ScopePtr parent = store.createScope("prefix.");
+  LazyScopeImpl scope(*parent, "prefix.");
+
+  Counter& counter = scope.counter("c");
+  EXPECT_EQ(&counter, &scope.counter("c"));
+  EXPECT_EQ("prefix.c", counter.name());
+  EXPECT_EQ("prefix.c", counter.tagExtractedName());
+  EXPECT_FALSE(counter.used());
+  EXPECT_EQ(0U, counter.value());
+  EXPECT_EQ(0U, counter.latch());
+  counter.reset();
+  EXPECT_EQ(nullptr, TestUtility::findCounter(store, "prefix.c"));
+
+  std::vector<std::string> lazy;
+  scope.forEachLazyCounter([&lazy](Counter& counter) { lazy.push_back(counter.name()); });
+  EXPECT_EQ(std::vector<std::string>{"prefix.c"}, lazy);
+
+  // Gauges are created right away.
+  scope.gauge("g");
+  EXPECT_NE(nullptr, TestUtility::findGauge(store, "prefix.g"));
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; i++) {
+    threads.emplace_back([&counter]() -> void { counter.inc(); });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(4U, TestUtility::findCounter(store, "prefix.c")->value());
+  EXPECT_TRUE(counter.used());
+  EXPECT_EQ(4U, counter.value());
+  EXPECT_EQ(4U, counter.latch());
+
+  lazy.clear();
+  scope.forEachLazyCounter([&lazy](Counter& counter) { lazy.push_back(counter.name()); });
+  EXPECT_TRUE(lazy.empty());
+}
+
+} // namespace Stats
+} // namespace Envoy
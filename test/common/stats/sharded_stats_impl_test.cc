@@ -0,0 +1,127 @@
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/stats/sharded_stats_impl.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Stats {
+
+TEST(ShardedStatsBlockTest, ShardsAreCacheLineAligned) {
+  ShardedStatsBlock block(3);
+  std::vector<uintptr_t> addresses;
+  std::vector<std::thread> threads;
+  std::mutex lock;
+  for (size_t i = 0; i < ShardedStatsBlock::NUM_SHARDS; i++) {
+    threads.emplace_back([&]() -> void {
+      std::unique_lock<std::mutex> guard(lock);
+      addresses.push_back(reinterpret_cast<uintptr_t>(&block.local(0)));
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  for (uintptr_t address : addresses) {
+    EXPECT_EQ(0U, address % ShardedStatsBlock::CACHE_LINE_SIZE);
+  }
+}
+
+TEST(ShardedStatsStoreTest, CounterAndGauge) {
+  ShardedStatsStore store(2);
+  Counter& counter = store.counter("c");
+  Gauge& gauge = store.gauge("g");
+  EXPECT_EQ("c", counter.name());
+  EXPECT_EQ("g", gauge.name());
+  EXPECT_FALSE(counter.used());
+  EXPECT_FALSE(gauge.used());
+
+  const uint64_t per_thread = 1000;
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < 2 * ShardedStatsBlock::NUM_SHARDS; i++) {
+    threads.emplace_back([&]() -> void {
+      for (uint64_t j = 0; j < per_thread; j++) {
+        counter.inc();
+        gauge.inc();
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  const uint64_t total = 2 * ShardedStatsBlock::NUM_SHARDS * per_thread;
+  EXPECT_TRUE(counter.used());
+  EXPECT_EQ(total, counter.value());
+  EXPECT_EQ(total, counter.latch());
+  EXPECT_EQ(0U, counter.latch());
+  counter.add(5);
+  EXPECT_EQ(5U, counter.latch());
+  counter.reset();
+  EXPECT_EQ(0U, counter.value());
+
+  // Decrements on another thread than the increments still sum up.
+  std::thread([&]() -> void { gauge.sub(total - 1); }).join();
+  EXPECT_EQ(1U, gauge.value());
+  gauge.set(100);
+  EXPECT_EQ(100U, gauge.value());
+  gauge.dec();
+  EXPECT_EQ(99U, gauge.value());
+
+  EXPECT_EQ(1U, store.counters(nullptr).size());
+  EXPECT_EQ(1U, store.gauges(nullptr).size());
+}
+
+TEST(ShardedStatsStoreTest, ListedStatsKeepOwnerAlive) {
+  std::shared_ptr<ShardedStatsStore> store(new ShardedStatsStore(2));
+  store->counter("c").inc();
+  store->gauge("g").set(2);
+  std::weak_ptr<ShardedStatsStore> weak_store = store;
+
+  std::list<CounterSharedPtr> counters = store->counters(store);
+  std::list<GaugeSharedPtr> gauges = store->gauges(store);
+  store.reset();
+  EXPECT_FALSE(weak_store.expired());
+  EXPECT_EQ("c", counters.front()->name());
+  EXPECT_EQ("c", counters.front()->tagExtractedName());
+  EXPECT_TRUE(counters.front()->tags().empty());
+  EXPECT_EQ(1U, counters.front()->value());
+  EXPECT_EQ("g", gauges.front()->name());
+  EXPECT_EQ(2U, gauges.front()->value());
+
+  counters.clear();
+  gauges.clear();
+  EXPECT_TRUE(weak_store.expired());
+}
+
+TEST(ShardedStatsStoreTest, RollUp) {
+  ShardedStatsStore rollup_store(2);
+  Counter& rollup_counter = rollup_store.counter("c");
+  Gauge& rollup_gauge = rollup_store.gauge("g");
+
+  ShardedStatsStore store1(2);
+  ShardedStatsStore store2(2);
+  for (ShardedStatsStore* store : {&store1, &store2}) {
+    Counter& counter = store->counter("c");
+    Gauge& gauge = store->gauge("g");
+    store->rollUp(counter, rollup_counter);
+    store->rollUp(gauge, rollup_gauge);
+    counter.add(3);
+    gauge.add(4);
+    gauge.dec();
+    EXPECT_EQ(3U, counter.value());
+    EXPECT_EQ(3U, gauge.value());
+  }
+
+  EXPECT_EQ(6U, rollup_counter.value());
+  EXPECT_EQ(6U, rollup_gauge.value());
+}
+
+} // namespace Stats
+} // namespace Envoy
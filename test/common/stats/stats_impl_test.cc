@@ -53,6 +53,35 @@ TEST(StatsIsolatedStoreImplTest, All) {
   EXPECT_EQ(2UL, store.gauges().size());
 }
 
+TEST(StatsMetricImplTest, Tags) {
+  IsolatedStoreImpl store;
+  HeapRawStatDataAllocator alloc;
+  SymbolTable symbol_table;
+  {
+    CounterImpl counter(*alloc.alloc("cluster.foo.bar.upstream_rq_2xx"), alloc,
+                        "cluster.upstream_rq_xx",
+                        {{"envoy.cluster_name", "foo.bar"}, {"envoy.response_code_class", "2"}},
+                        symbol_table);
+    EXPECT_EQ("cluster.foo.bar.upstream_rq_2xx", counter.name());
+    EXPECT_EQ("cluster.upstream_rq_xx", counter.tagExtractedName());
+    std::vector<Tag> tags = counter.tags();
+    ASSERT_EQ(2, tags.size());
+    EXPECT_EQ("envoy.cluster_name", tags[0].name_);
+    EXPECT_EQ("foo.bar", tags[0].value_);
+    EXPECT_EQ("envoy.response_code_class", tags[1].name_);
+    EXPECT_EQ("2", tags[1].value_);
+
+    HistogramImpl histogram("cluster.foo.bar.upstream_rq_time", store, "cluster.upstream_rq_time",
+                            {{"envoy.cluster_name", "foo.bar"}}, symbol_table);
+    EXPECT_EQ("cluster.foo.bar.upstream_rq_time", histogram.name());
+    EXPECT_EQ("cluster.upstream_rq_time", histogram.tagExtractedName());
+    EXPECT_EQ(1, histogram.tags().size());
+  }
+
+  // Every token is released with the metrics that used it.
+  EXPECT_EQ(0UL, symbol_table.size());
+}
+
 /**
  * Test stats macros. @see stats_macros.h
  */
@@ -110,6 +139,44 @@ TEST(TagExtractorTest, EmptyName) {
                             EnvoyException, "tag_name cannot be empty");
 }
 
+TEST(TagExtractorTest, Literals) {
+  const auto literals = [](const std::string& regex) -> std::pair<std::string, std::string> {
+    TagExtractorImpl tag_extractor("name", regex);
+    return {tag_extractor.prefix(), tag_extractor.substring()};
+  };
+
+  EXPECT_EQ(std::make_pair(std::string("cluster."), std::string("")),
+            literals("^cluster\\.((.*?)\\.)"));
+  EXPECT_EQ(std::make_pair(std::string("cluster"), std::string(".grpc.")),
+            literals("^cluster(?=\\.).*?\\.grpc\\.((.*?)\\.)"));
+  EXPECT_EQ(std::make_pair(std::string(""), std::string("http.")),
+            literals("^(?:|listener(?=\\.).*?\\.)http\\.((.*?)\\.)"));
+  EXPECT_EQ(std::make_pair(std::string(""), std::string("_rq_")), literals("_rq_(\\d)xx$"));
+  EXPECT_EQ(std::make_pair(std::string("listener."), std::string("")),
+            literals("^listener\\.(((?:[_.[:digit:]]*|[_\\[\\]aAbB[:digit:]]*))\\.)"));
+
+  // Quantified atoms are optional or repeated, so they end the literal.
+  EXPECT_EQ(std::make_pair(std::string("ab"), std::string("cde")), literals("^abc?cde"));
+  EXPECT_EQ(std::make_pair(std::string("abc"), std::string("d")), literals("^abc+d"));
+  EXPECT_EQ(std::make_pair(std::string("a"), std::string("xyz")), literals("^ab{2}xyz"));
+  EXPECT_EQ(std::make_pair(std::string("a"), std::string("bcd")), literals("^a[.(]bcd"));
+  EXPECT_EQ(std::make_pair(std::string(""), std::string("")), literals("^\\w+"));
+
+  // A top level alternation may skip any literal.
+  EXPECT_EQ(std::make_pair(std::string(""), std::string("")), literals("^foo\\.bar|baz"));
+
+  // Escaped bytes outside of ASCII are not treated as punctuation, and end the literal.
+  EXPECT_EQ(std::make_pair(std::string("ab"), std::string("cd")), literals("^ab\\\xe9" "cd"));
+}
+
+TEST(TagExtractorTest, LiteralMismatch) {
+  TagExtractorImpl tag_extractor("cluster_name", "^cluster\\.((.*?)\\.)");
+  std::vector<Tag> tags;
+  EXPECT_EQ("http.cluster.foo.bar", tag_extractor.extractTag("http.cluster.foo.bar", tags));
+  EXPECT_EQ("cluster", tag_extractor.extractTag("cluster", tags));
+  EXPECT_TRUE(tags.empty());
+}
+
 class DefaultTagRegexTester {
 public:
   DefaultTagRegexTester() {
@@ -73,6 +73,7 @@ TEST_F(TcpStatsdSinkTest, BasicFlow) {
 
   sink_->beginFlush();
   sink_->flushCounter(counter, 1);
+  sink_->flushCounter(counter, 0);
   sink_->flushGauge(gauge, 2);
 
   expectCreateConnection();
@@ -85,10 +86,20 @@ TEST_F(TcpStatsdSinkTest, BasicFlow) {
 
   expectCreateConnection();
 
-  NiceMock<MockHistogram> timer;
+  NiceMock<MockParentHistogram> timer;
   timer.name_ = "test_timer";
-  EXPECT_CALL(*connection_, write(BufferStringEqual("envoy.test_timer:5|ms\n")));
-  sink_->onHistogramComplete(timer, 5);
+  std::vector<uint64_t> counts(HistogramBuckets::BucketCount);
+  counts[HistogramBuckets::index(5)] = 1;
+  timer.interval_statistics_.refresh(counts, 5);
+  EXPECT_CALL(*connection_,
+              write(BufferStringEqual(
+                  "envoy.test_timer.count:1|c\nenvoy.test_timer.p0:5|g\nenvoy.test_timer.p25:5|g\n"
+                  "envoy.test_timer.p50:5|g\nenvoy.test_timer.p75:5|g\nenvoy.test_timer.p90:5|g\n"
+                  "envoy.test_timer.p95:5|g\nenvoy.test_timer.p99:5|g\n"
+                  "envoy.test_timer.p99_9:5|g\nenvoy.test_timer.p100:5|g\n")));
+  sink_->beginFlush();
+  sink_->flushHistogram(timer);
+  sink_->endFlush();
 
   EXPECT_CALL(*connection_, close(Network::ConnectionCloseType::NoFlush));
   tls_.shutdownThread();
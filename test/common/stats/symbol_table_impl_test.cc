@@ -0,0 +1,76 @@
+#include <string>
+#include <vector>
+
+#include "common/stats/symbol_table_impl.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Stats {
+
+TEST(SymbolTableTest, RoundTrip) {
+  SymbolTable table;
+  const std::vector<std::string> strings{"cluster.foo.upstream_rq_2xx",
+                                         "",
+                                         "no_dots",
+                                         ".leading.and.trailing.",
+                                         "double..dot",
+                                         "tag:value with spaces"};
+  StatNameList list = table.encode(strings);
+  EXPECT_FALSE(list.empty());
+  EXPECT_EQ(strings, table.decode(list));
+
+  table.free(list);
+  EXPECT_TRUE(list.empty());
+  EXPECT_EQ(0UL, table.size());
+}
+
+TEST(SymbolTableTest, SharedTokens) {
+  SymbolTable table;
+  StatNameList list1 = table.encode({"cluster.foo.upstream_rq_2xx", "cluster.upstream_rq_2xx"});
+  EXPECT_EQ(3UL, table.size());
+  StatNameList list2 = table.encode({"cluster.bar.upstream_rq_2xx"});
+  EXPECT_EQ(4UL, table.size());
+
+  // Tokens stay interned while any list uses them.
+  table.free(list1);
+  EXPECT_EQ(3UL, table.size());
+  EXPECT_EQ(std::vector<std::string>{"cluster.bar.upstream_rq_2xx"}, table.decode(list2));
+
+  table.free(list2);
+  EXPECT_EQ(0UL, table.size());
+}
+
+TEST(SymbolTableTest, SymbolReuse) {
+  SymbolTable table;
+  std::vector<StatNameList> lists;
+  std::vector<std::string> names;
+  // Enough distinct tokens to need multi-byte symbols.
+  for (int i = 0; i < 1000; i++) {
+    names.push_back("cluster.c" + std::to_string(i) + ".upstream_cx_total");
+    lists.push_back(table.encode({names.back()}));
+  }
+  EXPECT_EQ(1002UL, table.size());
+
+  for (int i = 0; i < 1000; i += 2) {
+    table.free(lists[i]);
+  }
+  EXPECT_EQ(502UL, table.size());
+
+  // Released symbols are handed out again without disturbing the remaining lists.
+  for (int i = 0; i < 1000; i += 2) {
+    names[i] = "listener.l" + std::to_string(i) + ".downstream_cx_total";
+    lists[i] = table.encode({names[i]});
+  }
+  for (int i = 0; i < 1000; i++) {
+    EXPECT_EQ(std::vector<std::string>{names[i]}, table.decode(lists[i]));
+  }
+
+  for (StatNameList& list : lists) {
+    table.free(list);
+  }
+  EXPECT_EQ(0UL, table.size());
+}
+
+} // namespace Stats
+} // namespace Envoy
@@ -0,0 +1,155 @@
+#include <list>
+#include <string>
+#include <vector>
+
+#include "common/config/well_known_names.h"
+#include "common/stats/stats_impl.h"
+#include "common/stats/thread_local_store.h"
+
+#include "test/mocks/event/mocks.h"
+#include "test/mocks/thread_local/mocks.h"
+
+#include "benchmark/benchmark.h"
+
+namespace Envoy {
+namespace Stats {
+
+class ThreadLocalStorePerf {
+public:
+  ThreadLocalStorePerf() : store_(alloc_) {
+    for (size_t i = 0; i < 100; i++) {
+      names_.push_back("cluster.service_" + std::to_string(i) + ".upstream_rq_total");
+    }
+  }
+
+  ~ThreadLocalStorePerf() {
+    store_.shutdownThreading();
+    tls_.shutdownThread();
+  }
+
+  void initThreading() { store_.initializeThreading(dispatcher_, tls_); }
+
+  void lookupCounters(benchmark::State& state) {
+    while (state.KeepRunning()) {
+      for (const std::string& name : names_) {
+        store_.counter(name).inc();
+      }
+    }
+  }
+
+  void lookupScopedCounters(benchmark::State& state) {
+    ScopePtr scope = store_.createScope("listener.0.0.0.0_80.");
+    while (state.KeepRunning()) {
+      for (const std::string& name : names_) {
+        scope->counter(name).inc();
+      }
+    }
+  }
+
+  void recordHistograms(benchmark::State& state) {
+    std::vector<Histogram*> histograms;
+    for (const std::string& name : names_) {
+      histograms.push_back(&store_.histogram(name));
+    }
+    uint64_t value = 0;
+    while (state.KeepRunning()) {
+      for (Histogram* histogram : histograms) {
+        histogram->recordValue(value++ % 1000);
+      }
+    }
+  }
+
+  void mergeHistograms(benchmark::State& state) {
+    for (const std::string& name : names_) {
+      Histogram& histogram = store_.histogram(name);
+      for (uint64_t value = 0; value < 10000; value++) {
+        histogram.recordValue(value);
+      }
+    }
+    std::list<ParentHistogramSharedPtr> histograms = store_.histograms();
+    while (state.KeepRunning()) {
+      for (const ParentHistogramSharedPtr& histogram : histograms) {
+        histogram->merge();
+      }
+    }
+  }
+
+  void createClusterStats(benchmark::State& state) {
+    for (const auto& name_regex_pair : Config::TagNames::get().name_regex_pairs_) {
+      tag_extractors_.emplace_back(TagExtractorImpl::createTagExtractor(name_regex_pair.first, ""));
+    }
+    store_.setTagExtractors(tag_extractors_);
+
+    const std::vector<std::string> suffixes = {
+        "upstream_cx_total",     "upstream_cx_active",   "upstream_rq_total",
+        "upstream_rq_2xx",       "upstream_rq_200",      "upstream_rq_5xx",
+        "upstream_rq_503",       "upstream_rq_timeout",  "membership_healthy",
+        "membership_total",      "lb_healthy_panic",     "update_success",
+        "grpc.svc.method.total", "upstream_cx_connect_ms"};
+    while (state.KeepRunning()) {
+      std::vector<ScopePtr> scopes;
+      for (size_t i = 0; i < 10000; i++) {
+        scopes.push_back(store_.createScope("cluster.service_" + std::to_string(i) + "."));
+        for (const std::string& suffix : suffixes) {
+          scopes.back()->counter(suffix);
+        }
+      }
+    }
+  }
+
+private:
+  std::vector<TagExtractorPtr> tag_extractors_;
+  HeapRawStatDataAllocator alloc_;
+  testing::NiceMock<Event::MockDispatcher> dispatcher_;
+  testing::NiceMock<ThreadLocal::MockInstance> tls_;
+  ThreadLocalStoreImpl store_;
+  std::vector<std::string> names_;
+};
+
+// Counter lookups before threading is initialized, which go through the central cache.
+static void ThreadLocalStoreCounterCentral(benchmark::State& state) {
+  ThreadLocalStorePerf perf;
+  perf.lookupCounters(state);
+}
+BENCHMARK(ThreadLocalStoreCounterCentral);
+
+// Counter lookups served from the per-thread cache.
+static void ThreadLocalStoreCounterTls(benchmark::State& state) {
+  ThreadLocalStorePerf perf;
+  perf.initThreading();
+  perf.lookupCounters(state);
+}
+BENCHMARK(ThreadLocalStoreCounterTls);
+
+static void ThreadLocalStoreScopedCounterTls(benchmark::State& state) {
+  ThreadLocalStorePerf perf;
+  perf.initThreading();
+  perf.lookupScopedCounters(state);
+}
+BENCHMARK(ThreadLocalStoreScopedCounterTls);
+
+// Samples recorded into the per-thread histograms, which used to be delivered to every sink.
+static void ThreadLocalStoreHistogramRecordTls(benchmark::State& state) {
+  ThreadLocalStorePerf perf;
+  perf.initThreading();
+  perf.recordHistograms(state);
+}
+BENCHMARK(ThreadLocalStoreHistogramRecordTls);
+
+// Flush-time merge of 100 histograms that each span 10000 distinct values.
+static void ThreadLocalStoreHistogramMerge(benchmark::State& state) {
+  ThreadLocalStorePerf perf;
+  perf.initThreading();
+  perf.mergeHistograms(state);
+}
+BENCHMARK(ThreadLocalStoreHistogramMerge);
+
+// Startup of 10k clusters with the default tag extractors.
+static void ThreadLocalStoreCreateClusterStats(benchmark::State& state) {
+  ThreadLocalStorePerf perf;
+  perf.createClusterStats(state);
+}
+BENCHMARK(ThreadLocalStoreCreateClusterStats)->Unit(benchmark::kMillisecond);
+
+} // namespace Stats
+} // namespace Envoy
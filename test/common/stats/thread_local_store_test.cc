@@ -17,8 +17,8 @@
 using testing::InSequence;
 using testing::Invoke;
 using testing::NiceMock;
-using testing::Ref;
 using testing::Return;
+using testing::SaveArg;
 using testing::_;
 
 namespace Envoy {
@@ -76,8 +76,9 @@ public:
     }));
 
     EXPECT_CALL(*this, alloc("stats.overflow"));
+    EXPECT_CALL(*this, alloc("stats.central_cache_miss"));
+    EXPECT_CALL(*this, alloc("stats.central_cache_lock_contended"));
     store_.reset(new ThreadLocalStoreImpl(*this));
-    store_->addSink(sink_);
   }
 
   MOCK_METHOD1(alloc, RawStatData*(const std::string& name));
@@ -86,7 +87,6 @@ public:
   NiceMock<Event::MockDispatcher> main_thread_dispatcher_;
   NiceMock<ThreadLocal::MockInstance> tls_;
   TestAllocator alloc_;
-  MockSink sink_;
   std::unique_ptr<ThreadLocalStoreImpl> store_;
 };
 
@@ -102,20 +102,25 @@ TEST_F(StatsThreadLocalStoreTest, NoTls) {
 
   Histogram& h1 = store_->histogram("h1");
   EXPECT_EQ(&h1, &store_->histogram("h1"));
-  EXPECT_CALL(sink_, onHistogramComplete(Ref(h1), 200));
   h1.recordValue(200);
-  EXPECT_CALL(sink_, onHistogramComplete(Ref(h1), 100));
-  store_->deliverHistogramToSinks(h1, 100);
+  h1.recordValue(100);
+
+  EXPECT_EQ(1UL, store_->histograms().size());
+  ParentHistogramSharedPtr parent = store_->histograms().front();
+  EXPECT_EQ(&h1, parent.get());
+  parent->merge();
+  EXPECT_EQ(2UL, parent->intervalStatistics().sampleCount());
+  EXPECT_EQ(300UL, parent->intervalStatistics().sampleSum());
 
-  EXPECT_EQ(2UL, store_->counters().size());
-  EXPECT_EQ(&c1, store_->counters().front().get());
-  EXPECT_EQ(2L, store_->counters().front().use_count());
+  EXPECT_EQ(4UL, store_->counters().size());
+  EXPECT_EQ(&c1, TestUtility::findCounter(*store_, "c1").get());
+  EXPECT_EQ(2L, TestUtility::findCounter(*store_, "c1").use_count());
   EXPECT_EQ(1UL, store_->gauges().size());
   EXPECT_EQ(&g1, store_->gauges().front().get());
   EXPECT_EQ(2L, store_->gauges().front().use_count());
 
-  // Includes overflow stat.
-  EXPECT_CALL(*this, free(_)).Times(3);
+  // Includes overflow and central cache stats.
+  EXPECT_CALL(*this, free(_)).Times(5);
 
   store_->shutdownThreading();
 }
@@ -135,9 +140,9 @@ TEST_F(StatsThreadLocalStoreTest, Tls) {
   Histogram& h1 = store_->histogram("h1");
   EXPECT_EQ(&h1, &store_->histogram("h1"));
 
-  EXPECT_EQ(2UL, store_->counters().size());
-  EXPECT_EQ(&c1, store_->counters().front().get());
-  EXPECT_EQ(3L, store_->counters().front().use_count());
+  EXPECT_EQ(4UL, store_->counters().size());
+  EXPECT_EQ(&c1, TestUtility::findCounter(*store_, "c1").get());
+  EXPECT_EQ(3L, TestUtility::findCounter(*store_, "c1").use_count());
   EXPECT_EQ(1UL, store_->gauges().size());
   EXPECT_EQ(&g1, store_->gauges().front().get());
   EXPECT_EQ(3L, store_->gauges().front().use_count());
@@ -145,14 +150,67 @@ TEST_F(StatsThreadLocalStoreTest, Tls) {
   store_->shutdownThreading();
   tls_.shutdownThread();
 
-  EXPECT_EQ(2UL, store_->counters().size());
-  EXPECT_EQ(&c1, store_->counters().front().get());
-  EXPECT_EQ(2L, store_->counters().front().use_count());
+  EXPECT_EQ(4UL, store_->counters().size());
+  EXPECT_EQ(&c1, TestUtility::findCounter(*store_, "c1").get());
+  EXPECT_EQ(2L, TestUtility::findCounter(*store_, "c1").use_count());
   EXPECT_EQ(1UL, store_->gauges().size());
   EXPECT_EQ(&g1, store_->gauges().front().get());
   EXPECT_EQ(2L, store_->gauges().front().use_count());
 
-  // Includes overflow stat.
+  // Includes overflow and central cache stats.
+  EXPECT_CALL(*this, free(_)).Times(5);
+}
+
+TEST_F(StatsThreadLocalStoreTest, HistogramMerge) {
+  InSequence s;
+  store_->initializeThreading(main_thread_dispatcher_, tls_);
+
+  Histogram& h1 = store_->histogram("h1");
+  EXPECT_EQ(1UL, store_->histograms().size());
+  ParentHistogramSharedPtr parent = store_->histograms().front();
+  EXPECT_NE(&h1, parent.get());
+  EXPECT_EQ("h1", h1.name());
+
+  parent->merge();
+  EXPECT_EQ(0UL, parent->cumulativeStatistics().sampleCount());
+  EXPECT_EQ("P0(nan,nan) P25(nan,nan) P50(nan,nan) P75(nan,nan) P90(nan,nan) P95(nan,nan) "
+            "P99(nan,nan) P99.9(nan,nan) P100(nan,nan)",
+            parent->summary());
+
+  // Samples recorded through the thread local histogram and the parent (used by threads without
+  // a cache) are merged together.
+  h1.recordValue(10);
+  parent->recordValue(10);
+  parent->merge();
+  EXPECT_EQ(2UL, parent->intervalStatistics().sampleCount());
+  EXPECT_EQ(20UL, parent->intervalStatistics().sampleSum());
+  EXPECT_EQ("P0(10,10) P25(10,10) P50(10,10) P75(10,10) P90(10,10) P95(10,10) P99(10,10) "
+            "P99.9(10,10) P100(10,10)",
+            parent->summary());
+
+  // The interval only covers samples recorded since the previous merge.
+  parent->merge();
+  EXPECT_EQ(0UL, parent->intervalStatistics().sampleCount());
+  EXPECT_EQ(2UL, parent->cumulativeStatistics().sampleCount());
+  EXPECT_EQ("P0(nan,10) P25(nan,10) P50(nan,10) P75(nan,10) P90(nan,10) P95(nan,10) "
+            "P99(nan,10) P99.9(nan,10) P100(nan,10)",
+            parent->summary());
+
+  for (uint64_t value = 1; value <= 100; value++) {
+    h1.recordValue(value);
+  }
+  parent->merge();
+  EXPECT_EQ(100UL, parent->intervalStatistics().sampleCount());
+  EXPECT_EQ(5050UL, parent->intervalStatistics().sampleSum());
+  EXPECT_EQ(102UL, parent->cumulativeStatistics().sampleCount());
+  EXPECT_EQ(1, parent->intervalStatistics().computedQuantiles().front());
+  EXPECT_NEAR(50.5, parent->intervalStatistics().computedQuantiles()[2], 50.5 / 16);
+  EXPECT_NEAR(100, parent->intervalStatistics().computedQuantiles().back(), 100.0 / 16);
+
+  store_->shutdownThreading();
+  tls_.shutdownThread();
+
+  // Includes overflow and central cache stats.
   EXPECT_CALL(*this, free(_)).Times(3);
 }
 
@@ -176,18 +234,15 @@ TEST_F(StatsThreadLocalStoreTest, BasicScope) {
   Histogram& h2 = scope1->histogram("h2");
   EXPECT_EQ("h1", h1.name());
   EXPECT_EQ("scope1.h2", h2.name());
-  EXPECT_CALL(sink_, onHistogramComplete(Ref(h1), 100));
   h1.recordValue(100);
-  EXPECT_CALL(sink_, onHistogramComplete(Ref(h2), 200));
   h2.recordValue(200);
+  EXPECT_EQ(2UL, store_->histograms().size());
 
   store_->shutdownThreading();
-  scope1->deliverHistogramToSinks(h1, 100);
-  scope1->deliverHistogramToSinks(h2, 200);
   tls_.shutdownThread();
 
-  // Includes overflow stat.
-  EXPECT_CALL(*this, free(_)).Times(5);
+  // Includes overflow and central cache stats.
+  EXPECT_CALL(*this, free(_)).Times(7);
 }
 
 TEST_F(StatsThreadLocalStoreTest, ScopeDelete) {
@@ -197,14 +252,14 @@ TEST_F(StatsThreadLocalStoreTest, ScopeDelete) {
   ScopePtr scope1 = store_->createScope("scope1.");
   EXPECT_CALL(*this, alloc(_));
   scope1->counter("c1");
-  EXPECT_EQ(2UL, store_->counters().size());
-  CounterSharedPtr c1 = store_->counters().front();
+  EXPECT_EQ(4UL, store_->counters().size());
+  CounterSharedPtr c1 = TestUtility::findCounter(*store_, "scope1.c1");
   EXPECT_EQ("scope1.c1", c1->name());
 
   EXPECT_CALL(main_thread_dispatcher_, post(_));
   EXPECT_CALL(tls_, runOnAllThreads(_));
   scope1.reset();
-  EXPECT_EQ(1UL, store_->counters().size());
+  EXPECT_EQ(3UL, store_->counters().size());
 
   EXPECT_CALL(*this, free(_));
   EXPECT_EQ(1L, c1.use_count());
@@ -213,8 +268,47 @@ TEST_F(StatsThreadLocalStoreTest, ScopeDelete) {
   store_->shutdownThreading();
   tls_.shutdownThread();
 
-  // Includes overflow stat.
+  // Includes overflow and central cache stats.
+  EXPECT_CALL(*this, free(_)).Times(3);
+}
+
+// A scope created before the cache flush of a deleted scope with the same prefix has run must not
+// see the deleted scope's cached stats, and the flush must not drop the new scope's.
+TEST_F(StatsThreadLocalStoreTest, ScopeRecreatedBeforeCacheFlush) {
+  InSequence s;
+  store_->initializeThreading(main_thread_dispatcher_, tls_);
+
+  ScopePtr scope1 = store_->createScope("scope1.");
+  EXPECT_CALL(*this, alloc(_));
+  Counter& c1 = scope1->counter("c1");
+  c1.inc();
+
+  Event::PostCb flush;
+  EXPECT_CALL(main_thread_dispatcher_, post(_)).WillOnce(SaveArg<0>(&flush));
+  scope1.reset();
+
+  ScopePtr scope2 = store_->createScope("scope1.");
+  EXPECT_CALL(*this, alloc(_));
+  Counter& c2 = scope2->counter("c1");
+  EXPECT_NE(&c1, &c2);
+  EXPECT_EQ(1UL, c2.value());
+
+  // Drops the last reference to the deleted scope's counter, but not to the shared storage.
+  EXPECT_CALL(tls_, runOnAllThreads(_));
   EXPECT_CALL(*this, free(_));
+  flush();
+  EXPECT_EQ(&c2, &scope2->counter("c1"));
+
+  EXPECT_CALL(main_thread_dispatcher_, post(_));
+  EXPECT_CALL(tls_, runOnAllThreads(_));
+  EXPECT_CALL(*this, free(_));
+  scope2.reset();
+
+  store_->shutdownThreading();
+  tls_.shutdownThread();
+
+  // Includes overflow and central cache stats.
+  EXPECT_CALL(*this, free(_)).Times(3);
 }
 
 TEST_F(StatsThreadLocalStoreTest, NestedScopes) {
@@ -244,8 +338,8 @@ TEST_F(StatsThreadLocalStoreTest, NestedScopes) {
   store_->shutdownThreading();
   tls_.shutdownThread();
 
-  // Includes overflow stat.
-  EXPECT_CALL(*this, free(_)).Times(4);
+  // Includes overflow and central cache stats.
+  EXPECT_CALL(*this, free(_)).Times(6);
 }
 
 TEST_F(StatsThreadLocalStoreTest, OverlappingScopes) {
@@ -270,7 +364,10 @@ TEST_F(StatsThreadLocalStoreTest, OverlappingScopes) {
   EXPECT_EQ(2UL, c2.value());
 
   // We should dedup when we fetch all counters to handle the overlapping case.
-  EXPECT_EQ(2UL, store_->counters().size());
+  EXPECT_EQ(4UL, store_->counters().size());
+  uint64_t num_counters = 0;
+  store_->forEachCounter([&num_counters](Counter&) { num_counters++; });
+  EXPECT_EQ(4UL, num_counters);
 
   // Gauges should work the same way.
   EXPECT_CALL(*this, alloc(_)).Times(2);
@@ -284,13 +381,16 @@ TEST_F(StatsThreadLocalStoreTest, OverlappingScopes) {
   EXPECT_EQ(1UL, g1.value());
   EXPECT_EQ(1UL, g2.value());
   EXPECT_EQ(1UL, store_->gauges().size());
+  std::vector<std::string> gauge_names;
+  store_->forEachGauge([&gauge_names](Gauge& gauge) { gauge_names.push_back(gauge.name()); });
+  EXPECT_EQ(std::vector<std::string>{"scope1.g"}, gauge_names);
 
   // Deleting scope 1 will call free but will be reference counted. It still leaves scope 2 valid.
   EXPECT_CALL(*this, free(_)).Times(2);
   scope1.reset();
   c2.inc();
   EXPECT_EQ(3UL, c2.value());
-  EXPECT_EQ(2UL, store_->counters().size());
+  EXPECT_EQ(4UL, store_->counters().size());
   g2.set(10);
   EXPECT_EQ(10UL, g2.value());
   EXPECT_EQ(1UL, store_->gauges().size());
@@ -298,8 +398,8 @@ TEST_F(StatsThreadLocalStoreTest, OverlappingScopes) {
   store_->shutdownThreading();
   tls_.shutdownThread();
 
-  // Includes overflow stat.
-  EXPECT_CALL(*this, free(_)).Times(3);
+  // Includes overflow and central cache stats.
+  EXPECT_CALL(*this, free(_)).Times(5);
 }
 
 TEST_F(StatsThreadLocalStoreTest, AllocFailed) {
@@ -316,8 +416,43 @@ TEST_F(StatsThreadLocalStoreTest, AllocFailed) {
   store_->shutdownThreading();
   tls_.shutdownThread();
 
-  // Includes overflow but not the failsafe stat which we allocated from the heap.
-  EXPECT_CALL(*this, free(_));
+  // Includes overflow and central cache stats but not the failsafe stat which we allocated from
+  // the heap.
+  EXPECT_CALL(*this, free(_)).Times(3);
+}
+
+TEST_F(StatsThreadLocalStoreTest, CentralCacheStats) {
+  InSequence s;
+  Counter& miss = store_->counter("stats.central_cache_miss");
+  Counter& contended = store_->counter("stats.central_cache_lock_contended");
+  EXPECT_EQ(0UL, miss.value());
+
+  // Without TLS every lookup goes to the central cache, but only the ones that have to allocate
+  // take the lock.
+  EXPECT_CALL(*this, alloc(_)).Times(2);
+  store_->counter("c1");
+  store_->counter("c1");
+  store_->gauge("g1");
+  store_->gauge("g1");
+  store_->histogram("h1");
+  store_->histogram("h1");
+  EXPECT_EQ(3UL, miss.value());
+  EXPECT_EQ(0UL, contended.value());
+
+  // The same holds once the stat is cached per thread.
+  store_->initializeThreading(main_thread_dispatcher_, tls_);
+  EXPECT_CALL(*this, alloc(_));
+  store_->counter("c1");
+  store_->counter("c2");
+  store_->counter("c2");
+  EXPECT_EQ(4UL, miss.value());
+  EXPECT_EQ(0UL, contended.value());
+
+  store_->shutdownThreading();
+  tls_.shutdownThread();
+
+  // Includes overflow and central cache stats.
+  EXPECT_CALL(*this, free(_)).Times(6);
 }
 
 TEST_F(StatsThreadLocalStoreTest, ShuttingDown) {
@@ -339,8 +474,8 @@ TEST_F(StatsThreadLocalStoreTest, ShuttingDown) {
 
   tls_.shutdownThread();
 
-  // Includes overflow stat.
-  EXPECT_CALL(*this, free(_)).Times(5);
+  // Includes overflow and central cache stats.
+  EXPECT_CALL(*this, free(_)).Times(7);
 }
 
 } // namespace Stats
@@ -1,5 +1,11 @@
+#include <sys/socket.h>
+#include <unistd.h>
+
 #include <chrono>
+#include <string>
+#include <vector>
 
+#include "common/common/utility.h"
 #include "common/network/address_impl.h"
 #include "common/network/utility.h"
 #include "common/stats/statsd.h"
@@ -13,7 +19,9 @@
 #include "gtest/gtest.h"
 #include "spdlog/spdlog.h"
 
+using testing::Invoke;
 using testing::NiceMock;
+using testing::_;
 
 namespace Envoy {
 namespace Stats {
@@ -22,6 +30,13 @@ namespace Statsd {
 class MockWriter : public Writer {
 public:
   MOCK_METHOD1(write, void(const std::string& message));
+
+  // Route batches through write() so tests can check each datagram.
+  void writeBatch(const std::vector<std::string>& messages) override {
+    for (const std::string& message : messages) {
+      write(message);
+    }
+  }
 };
 
 class UdpStatsdSinkTest : public testing::TestWithParam<Network::Address::IpVersion> {};
@@ -39,6 +54,7 @@ TEST_P(UdpStatsdSinkTest, InitWithIpAddress) {
   EXPECT_NE(fd, -1);
 
   // Check that fd has not changed.
+  sink.beginFlush();
   NiceMock<MockCounter> counter;
   counter.name_ = "test_counter";
   sink.flushCounter(counter, 1);
@@ -47,9 +63,10 @@ TEST_P(UdpStatsdSinkTest, InitWithIpAddress) {
   gauge.name_ = "test_gauge";
   sink.flushGauge(gauge, 1);
 
-  NiceMock<MockHistogram> timer;
+  NiceMock<MockParentHistogram> timer;
   timer.name_ = "test_timer";
-  sink.onHistogramComplete(timer, 5);
+  sink.flushHistogram(timer);
+  sink.endFlush();
 
   EXPECT_EQ(fd, sink.getFdForTests());
 
@@ -76,6 +93,7 @@ TEST_P(UdpStatsdSinkWithTagsTest, InitWithIpAddress) {
   EXPECT_NE(fd, -1);
 
   // Check that fd has not changed.
+  sink.beginFlush();
   std::vector<Tag> tags = {Tag{"node", "test"}};
   NiceMock<MockCounter> counter;
   counter.name_ = "test_counter";
@@ -88,10 +106,11 @@ TEST_P(UdpStatsdSinkWithTagsTest, InitWithIpAddress) {
   gauge.tags_ = tags;
   sink.flushGauge(gauge, 1);
 
-  NiceMock<MockHistogram> timer;
+  NiceMock<MockParentHistogram> timer;
   timer.name_ = "test_timer";
   timer.tags_ = tags;
-  sink.onHistogramComplete(timer, 5);
+  sink.flushHistogram(timer);
+  sink.endFlush();
 
   EXPECT_EQ(fd, sink.getFdForTests());
 
@@ -103,6 +122,19 @@ TEST_P(UdpStatsdSinkWithTagsTest, InitWithIpAddress) {
   tls_.shutdownThread();
 }
 
+TEST(UdpStatsdSinkTest, UnchangedCounterNotSent) {
+  auto writer_ptr = std::make_shared<NiceMock<MockWriter>>();
+  NiceMock<ThreadLocal::MockInstance> tls_;
+  UdpStatsdSink sink(tls_, writer_ptr, false);
+
+  NiceMock<MockCounter> counter;
+  counter.name_ = "test_counter";
+  EXPECT_CALL(*writer_ptr, write(_)).Times(0);
+  sink.beginFlush();
+  sink.flushCounter(counter, 0);
+  sink.endFlush();
+}
+
 TEST(UdpStatsdSinkTest, CheckActualStats) {
   auto writer_ptr = std::make_shared<NiceMock<MockWriter>>();
   NiceMock<ThreadLocal::MockInstance> tls_;
@@ -113,18 +145,32 @@ TEST(UdpStatsdSinkTest, CheckActualStats) {
   EXPECT_CALL(*std::dynamic_pointer_cast<NiceMock<MockWriter>>(writer_ptr),
               write("envoy.test_counter:1|c"));
   sink.flushCounter(counter, 1);
+  sink.endFlush();
 
   NiceMock<MockGauge> gauge;
   gauge.name_ = "test_gauge";
   EXPECT_CALL(*std::dynamic_pointer_cast<NiceMock<MockWriter>>(writer_ptr),
               write("envoy.test_gauge:1|g"));
   sink.flushGauge(gauge, 1);
+  sink.endFlush();
 
-  NiceMock<MockHistogram> timer;
+  // Histograms without samples in the interval are skipped.
+  NiceMock<MockParentHistogram> timer;
   timer.name_ = "test_timer";
+  sink.flushHistogram(timer);
+  sink.endFlush();
+
+  std::vector<uint64_t> counts(HistogramBuckets::BucketCount);
+  counts[HistogramBuckets::index(5)] = 2;
+  timer.interval_statistics_.refresh(counts, 10);
   EXPECT_CALL(*std::dynamic_pointer_cast<NiceMock<MockWriter>>(writer_ptr),
-              write("envoy.test_timer:5|ms"));
-  sink.onHistogramComplete(timer, 5);
+              write("envoy.test_timer.count:2|c\nenvoy.test_timer.p0:5|g\n"
+                    "envoy.test_timer.p25:5|g\nenvoy.test_timer.p50:5|g\n"
+                    "envoy.test_timer.p75:5|g\nenvoy.test_timer.p90:5|g\n"
+                    "envoy.test_timer.p95:5|g\nenvoy.test_timer.p99:5|g\n"
+                    "envoy.test_timer.p99_9:5|g\nenvoy.test_timer.p100:5|g"));
+  sink.flushHistogram(timer);
+  sink.endFlush();
 
   tls_.shutdownThread();
 }
@@ -141,6 +187,7 @@ TEST(UdpStatsdSinkWithTagsTest, CheckActualStats) {
   EXPECT_CALL(*std::dynamic_pointer_cast<NiceMock<MockWriter>>(writer_ptr),
               write("envoy.test_counter:1|c|#key1:value1,key2:value2"));
   sink.flushCounter(counter, 1);
+  sink.endFlush();
 
   NiceMock<MockGauge> gauge;
   gauge.name_ = "test_gauge";
@@ -148,17 +195,149 @@ TEST(UdpStatsdSinkWithTagsTest, CheckActualStats) {
   EXPECT_CALL(*std::dynamic_pointer_cast<NiceMock<MockWriter>>(writer_ptr),
               write("envoy.test_gauge:1|g|#key1:value1,key2:value2"));
   sink.flushGauge(gauge, 1);
+  sink.endFlush();
 
-  NiceMock<MockHistogram> timer;
+  NiceMock<MockParentHistogram> timer;
   timer.name_ = "test_timer";
   timer.tags_ = tags;
+  std::vector<uint64_t> counts(HistogramBuckets::BucketCount);
+  counts[HistogramBuckets::index(5)] = 1;
+  timer.interval_statistics_.refresh(counts, 5);
+  std::vector<std::string> lines = {"envoy.test_timer.count:1|c|#key1:value1,key2:value2"};
+  for (const std::string& quantile :
+       {"p0", "p25", "p50", "p75", "p90", "p95", "p99", "p99_9", "p100"}) {
+    lines.push_back(fmt::format("envoy.test_timer.{}:5|g|#key1:value1,key2:value2", quantile));
+  }
   EXPECT_CALL(*std::dynamic_pointer_cast<NiceMock<MockWriter>>(writer_ptr),
-              write("envoy.test_timer:5|ms|#key1:value1,key2:value2"));
-  sink.onHistogramComplete(timer, 5);
+              write(StringUtil::join(lines, "\n")));
+  sink.flushHistogram(timer);
+  sink.endFlush();
+
+  tls_.shutdownThread();
+}
+
+TEST(UdpStatsdSinkWithTagsTest, CachedLines) {
+  auto writer_ptr = std::make_shared<NiceMock<MockWriter>>();
+  NiceMock<ThreadLocal::MockInstance> tls_;
+  UdpStatsdSink sink(tls_, writer_ptr, true);
+
+  NiceMock<MockCounter> counter;
+  counter.name_ = "test_counter";
+  counter.tags_ = {Tag{"key1", "value1"}};
+  NiceMock<MockGauge> gauge;
+  gauge.name_ = "test_counter";
+  gauge.tags_ = {Tag{"key1", "value1"}};
+
+  // The tags are only extracted on the first flush. Counters and gauges of the same name are
+  // cached apart.
+  EXPECT_CALL(counter, tags()).Times(1);
+  EXPECT_CALL(gauge, tags()).Times(1);
+  EXPECT_CALL(*writer_ptr, write("envoy.test_counter:1|c|#key1:value1
+"
+                                 "envoy.test_counter:7|g|#key1:value1"));
+  EXPECT_CALL(*writer_ptr, write("envoy.test_counter:12345|c|#key1:value1
+"
+                                 "envoy.test_counter:0|g|#key1:value1"));
+  sink.beginFlush();
+  sink.flushCounter(counter, 1);
+  sink.flushGauge(gauge, 7);
+  sink.endFlush();
+  sink.beginFlush();
+  sink.flushCounter(counter, 12345);
+  sink.flushGauge(gauge, 0);
+  sink.endFlush();
+  testing::Mock::VerifyAndClearExpectations(&counter);
+  testing::Mock::VerifyAndClearExpectations(writer_ptr.get());
+
+  // The line of a counter that was not flushed for a while is formatted again.
+  EXPECT_CALL(*writer_ptr, write("envoy.test_counter:1|g|#key1:value1"))
+      .Times(2 * UdpStatsdSink::MAX_IDLE_FLUSHES);
+  for (uint64_t i = 0; i < 2 * UdpStatsdSink::MAX_IDLE_FLUSHES; i++) {
+    sink.beginFlush();
+    sink.flushGauge(gauge, 1);
+    sink.endFlush();
+  }
+  EXPECT_CALL(counter, tags()).Times(1);
+  EXPECT_CALL(*writer_ptr, write("envoy.test_counter:1|c|#key1:value1"));
+  sink.beginFlush();
+  sink.flushCounter(counter, 1);
+  sink.endFlush();
+
+  tls_.shutdownThread();
+}
+
+TEST(UdpStatsdSinkTest, PackDatagrams) {
+  auto writer_ptr = std::make_shared<NiceMock<MockWriter>>();
+  NiceMock<ThreadLocal::MockInstance> tls_;
+  UdpStatsdSink sink(tls_, writer_ptr, false);
+
+  // Nothing is written for an empty flush.
+  EXPECT_CALL(*writer_ptr, write(_)).Times(0);
+  sink.beginFlush();
+  sink.endFlush();
+  testing::Mock::VerifyAndClearExpectations(writer_ptr.get());
+
+  // "envoy.counter_NNNN:1|c" is 22 bytes, so 62 lines (61 separators) fill 1425 bytes of a
+  // datagram and the 63rd would overflow it.
+  const uint32_t lines_per_datagram = 62;
+  const uint32_t datagrams = UdpStatsdSink::MAX_BATCHED_DATAGRAMS + 1;
+  std::vector<std::string> written;
+  EXPECT_CALL(*writer_ptr, write(_))
+      .Times(datagrams + 1)
+      .WillRepeatedly(
+          Invoke([&written](const std::string& message) { written.push_back(message); }));
+
+  sink.beginFlush();
+  NiceMock<MockCounter> counter;
+  for (uint32_t i = 0; i < datagrams * lines_per_datagram + 1; i++) {
+    counter.name_ = fmt::format("counter_{:04}", i % 10000);
+    sink.flushCounter(counter, 1);
+  }
+  // A full batch is sent as soon as it is ready, before endFlush().
+  EXPECT_EQ(UdpStatsdSink::MAX_BATCHED_DATAGRAMS, written.size());
+  sink.endFlush();
+
+  ASSERT_EQ(datagrams + 1, written.size());
+  uint32_t line = 0;
+  for (uint32_t i = 0; i < written.size(); i++) {
+    EXPECT_GE(UdpStatsdSink::MAX_DATAGRAM_BYTES, written[i].size());
+    for (const std::string& message : StringUtil::split(written[i], '\n')) {
+      EXPECT_EQ(fmt::format("envoy.counter_{:04}:1|c", line++ % 10000), message);
+    }
+  }
+  EXPECT_EQ(datagrams * lines_per_datagram + 1, line);
+  EXPECT_EQ("envoy.counter_4030:1|c", written.back());
+
+  // Lines longer than a datagram are sent on their own.
+  EXPECT_CALL(*writer_ptr, write(_)).Times(3);
+  sink.beginFlush();
+  counter.name_ = "short";
+  sink.flushCounter(counter, 1);
+  counter.name_ = std::string(UdpStatsdSink::MAX_DATAGRAM_BYTES, 'a');
+  sink.flushCounter(counter, 1);
+  counter.name_ = "short";
+  sink.flushCounter(counter, 1);
+  sink.endFlush();
 
   tls_.shutdownThread();
 }
 
+TEST_P(UdpStatsdSinkTest, WriteBatch) {
+  std::pair<Network::Address::InstanceConstSharedPtr, int> server =
+      Network::Test::bindFreeLoopbackPort(GetParam(), Network::Address::SocketType::Datagram);
+  Writer writer(server.first);
+  writer.writeBatch({"envoy.a:1|c", "envoy.b:2|c\nenvoy.c:3|g"});
+
+  char buffer[128];
+  ssize_t rc = ::recv(server.second, buffer, sizeof(buffer), 0);
+  ASSERT_GT(rc, 0);
+  EXPECT_EQ("envoy.a:1|c", std::string(buffer, rc));
+  rc = ::recv(server.second, buffer, sizeof(buffer), 0);
+  ASSERT_GT(rc, 0);
+  EXPECT_EQ("envoy.b:2|c\nenvoy.c:3|g", std::string(buffer, rc));
+  ::close(server.second);
+}
+
 } // namespace Statsd
 } // namespace Stats
 } // namespace Envoy
@@ -5,8 +5,10 @@
 #include "gmock/gmock.h"
 
 using testing::InSequence;
+using testing::InvokeArgument;
 using testing::Ref;
 using testing::ReturnPointee;
+using testing::SaveArg;
 using testing::_;
 
 namespace Envoy {
@@ -31,7 +33,7 @@ public:
   TestThreadLocalObject& setObject(Slot& slot) {
     std::shared_ptr<TestThreadLocalObject> object(new TestThreadLocalObject());
     TestThreadLocalObject& object_ref = *object;
-    EXPECT_CALL(thread_dispatcher_, post(_));
+    EXPECT_CALL(thread_dispatcher_, post(_)).WillOnce(InvokeArgument<0>());
     EXPECT_CALL(*this, createThreadLocal(Ref(thread_dispatcher_))).WillOnce(ReturnPointee(&object));
     EXPECT_CALL(*this, createThreadLocal(Ref(main_dispatcher_))).WillOnce(ReturnPointee(&object));
     slot.set([this](Event::Dispatcher& dispatcher) -> ThreadLocalObjectSharedPtr {
@@ -50,7 +52,7 @@ TEST_F(ThreadLocalInstanceImplTest, All) {
   InSequence s;
 
   // Free a slot without ever calling set.
-  EXPECT_CALL(thread_dispatcher_, post(_));
+  EXPECT_CALL(thread_dispatcher_, post(_)).WillOnce(InvokeArgument<0>());
   SlotPtr slot1 = tls_.allocateSlot();
   slot1.reset();
 
@@ -59,7 +61,7 @@ TEST_F(ThreadLocalInstanceImplTest, All) {
   SlotPtr slot2 = tls_.allocateSlot();
   TestThreadLocalObject& object_ref2 = setObject(*slot2);
 
-  EXPECT_CALL(thread_dispatcher_, post(_));
+  EXPECT_CALL(thread_dispatcher_, post(_)).WillOnce(InvokeArgument<0>());
   EXPECT_CALL(object_ref2, onDestroy());
   slot2.reset();
 
@@ -79,5 +81,44 @@ TEST_F(ThreadLocalInstanceImplTest, All) {
   tls_.shutdownThread();
 }
 
+// Updates that are queued before a worker runs its queue are delivered with a single post, in the
+// order they were made.
+TEST_F(ThreadLocalInstanceImplTest, BatchedUpdates) {
+  InSequence s;
+
+  SlotPtr slot1 = tls_.allocateSlot();
+  SlotPtr slot2 = tls_.allocateSlot();
+
+  Event::PostCb post_cb;
+  EXPECT_CALL(thread_dispatcher_, post(_)).WillOnce(SaveArg<0>(&post_cb));
+  std::shared_ptr<TestThreadLocalObject> object1(new TestThreadLocalObject());
+  std::shared_ptr<TestThreadLocalObject> object2(new TestThreadLocalObject());
+  slot1->set([object1](Event::Dispatcher&) -> ThreadLocalObjectSharedPtr { return object1; });
+  slot2->set([object2](Event::Dispatcher&) -> ThreadLocalObjectSharedPtr { return object2; });
+  std::vector<uint32_t> ran;
+  slot1->runOnAllThreads([&ran]() -> void { ran.push_back(ran.size()); });
+  EXPECT_EQ(1UL, ran.size());
+
+  post_cb();
+  EXPECT_EQ((std::vector<uint32_t>{0, 1}), ran);
+  EXPECT_EQ(object1, slot1->get());
+  EXPECT_EQ(object2, slot2->get());
+
+  // The queue was run, so the next update posts again.
+  EXPECT_CALL(thread_dispatcher_, post(_)).WillOnce(InvokeArgument<0>());
+  slot1->runOnAllThreads([&ran]() -> void { ran.push_back(ran.size()); });
+  EXPECT_EQ(4UL, ran.size());
+
+  tls_.shutdownGlobalThreading();
+  slot1.reset();
+  slot2.reset();
+
+  EXPECT_CALL(*object2, onDestroy());
+  EXPECT_CALL(*object1, onDestroy());
+  object1.reset();
+  object2.reset();
+  tls_.shutdownThread();
+}
+
 } // namespace ThreadLocal
 } // namespace Envoy
@@ -459,5 +459,52 @@ TEST_F(HttpTracerImplTest, BasicFunctionalityNodeSet) {
   tracer_->startSpan(config_, request_headers_, request_info_);
 }
 
+TEST(TailSampledSpanTest, ExportsSlowOrFailedRequests) {
+  MockHttpTracer tracer;
+  NiceMock<MockConfig> config;
+  NiceMock<RequestInfo::MockRequestInfo> request_info;
+  Http::TestHeaderMapImpl request_headers{{":path", "/"}, {":method", "GET"}};
+
+  // Fast requests that did not fail are dropped.
+  {
+    TailSampledSpan span(tracer, config, request_headers, request_info,
+                         std::chrono::milliseconds(100));
+    span.setTag("foo", "bar");
+    SpanPtr child = span.spawnChild(config, "child", SystemTime());
+    EXPECT_NE(nullptr, dynamic_cast<NullSpan*>(child.get()));
+    EXPECT_CALL(request_info, duration()).WillOnce(Return(std::chrono::milliseconds(10)));
+    EXPECT_CALL(tracer, startSpan_(_, _, _)).Times(0);
+    span.finishSpan();
+  }
+
+  // Slow requests are exported with what was recorded.
+  {
+    TailSampledSpan span(tracer, config, request_headers, request_info,
+                         std::chrono::milliseconds(100));
+    span.setOperation("op");
+    span.setTag("foo", "bar");
+    EXPECT_CALL(request_info, duration()).WillOnce(Return(std::chrono::milliseconds(100)));
+    NiceMock<MockSpan>* exported = new NiceMock<MockSpan>();
+    EXPECT_CALL(tracer, startSpan_(_, _, _)).WillOnce(Return(exported));
+    EXPECT_CALL(*exported, setOperation("op"));
+    EXPECT_CALL(*exported, setTag("foo", "bar"));
+    EXPECT_CALL(*exported, finishSpan());
+    span.finishSpan();
+  }
+
+  // Failed requests are exported however fast they were.
+  {
+    TailSampledSpan span(tracer, config, request_headers, request_info,
+                         std::chrono::milliseconds(100));
+    span.setTag(Tags::get().ERROR, Tags::get().TRUE);
+    NiceMock<MockSpan>* exported = new NiceMock<MockSpan>();
+    EXPECT_CALL(tracer, startSpan_(_, _, _)).WillOnce(Return(exported));
+    EXPECT_CALL(*exported, setOperation(_)).Times(0);
+    EXPECT_CALL(*exported, setTag(Tags::get().ERROR, Tags::get().TRUE));
+    EXPECT_CALL(*exported, finishSpan());
+    span.finishSpan();
+  }
+}
+
 } // namespace Tracing
 } // namespace Envoy
@@ -362,6 +362,38 @@ TEST_F(LightStepDriverTest, SerializeAndDeserializeContext) {
   }
 }
 
+// A context that is encoded in several chunks replaces the existing header value, and round trips.
+TEST_F(LightStepDriverTest, SerializeAndDeserializeLargeContext) {
+  setupValidDriver(OpenTracingDriver::PropagationMode::SingleHeader);
+
+  std::unique_ptr<opentracing::Span> ot_span =
+      driver_->tracer().StartSpan(operation_name_, {opentracing::StartTimestamp(start_time_)});
+  ot_span->SetBaggageItem("key", std::string(500, 'v'));
+  OpenTracingSpan span{*driver_, std::move(ot_span)};
+
+  request_headers_.insertOtSpanContext().value(std::string(1000, '!'));
+  span.injectContext(request_headers_);
+  const Http::HeaderString& injected_ctx = request_headers_.OtSpanContext()->value();
+
+  stats_.counter("tracing.opentracing.span_context_extraction_error").reset();
+  SpanPtr child = driver_->startSpan(config_, request_headers_, operation_name_, start_time_);
+  EXPECT_EQ(0U, stats_.counter("tracing.opentracing.span_context_extraction_error").value());
+
+  const std::string context = Base64::decode(injected_ctx.c_str(), injected_ctx.size());
+  std::istringstream iss{context, std::ios::binary};
+  opentracing::expected<std::unique_ptr<opentracing::SpanContext>> extracted =
+      driver_->tracer().Extract(iss);
+  ASSERT_TRUE(extracted);
+  EXPECT_EQ(Base64::encode(context.data(), context.size()), injected_ctx.c_str());
+  std::string baggage;
+  (*extracted)->ForeachBaggageItem([&](const std::string& key, const std::string& value) -> bool {
+    EXPECT_EQ("key", key);
+    baggage = value;
+    return true;
+  });
+  EXPECT_EQ(std::string(500, 'v'), baggage);
+}
+
 TEST_F(LightStepDriverTest, SpawnChild) {
   setupValidDriver();
 
@@ -1,5 +1,9 @@
+#include "common/buffer/buffer_impl.h"
+#include "common/common/hex.h"
 #include "common/tracing/zipkin/span_buffer.h"
 
+#include "test/test_common/utility.h"
+
 #include "gtest/gtest.h"
 
 namespace Envoy {
@@ -101,5 +105,27 @@ TEST(ZipkinSpanBufferTest, sizeConstructorEndtoEnd) {
   EXPECT_EQ(0ULL, buffer.pendingSpans());
   EXPECT_EQ("[]", buffer.toStringifiedJsonArray());
 }
+
+TEST(ZipkinSpanBufferTest, serialize) {
+  SpanBuffer buffer(2);
+  buffer.addSpan(Span());
+  buffer.addSpan(Span());
+
+  Buffer::OwnedImpl json;
+  buffer.serialize(json, SpanEncoding::Json);
+  EXPECT_EQ(buffer.toStringifiedJsonArray(), TestUtility::bufferToString(json));
+
+  Buffer::OwnedImpl thrift;
+  buffer.serialize(thrift, SpanEncoding::Thrift);
+  const std::string empty_span = "0a00010000000000000000"
+                                 "0b000300000000"
+                                 "0a00040000000000000000"
+                                 "0f00060c00000000"
+                                 "0f00080c00000000"
+                                 "00";
+  const std::string body = TestUtility::bufferToString(thrift);
+  EXPECT_EQ("0c00000002" + empty_span + empty_span,
+            Hex::encode(reinterpret_cast<const uint8_t*>(body.data()), body.size()));
+}
 } // namespace Zipkin
 } // namespace Envoy
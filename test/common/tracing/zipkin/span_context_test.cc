@@ -39,6 +39,39 @@ TEST(ZipkinSpanContextTest, populateFromString) {
   EXPECT_EQ("0000000000000000;0000000000000000;0000000000000000", span_context.serializeToString());
 }
 
+TEST(ZipkinSpanContextTest, populateFromStringWithAnnotations) {
+  SpanContext span_context;
+
+  span_context.populateFromString("25c6f38dd0600e79;56707c7b3e1092af;c49193ea42335d1c;cs;sr");
+  EXPECT_EQ(2722130815203937913ULL, span_context.trace_id());
+  EXPECT_EQ(6228615153417491119ULL, span_context.id());
+  EXPECT_EQ(14164264937399213340ULL, span_context.parent_id());
+
+  // Uppercase digits are accepted.
+  span_context.populateFromString("25C6F38DD0600E79;56707C7B3E1092AF;C49193EA42335D1C");
+  EXPECT_EQ(2722130815203937913ULL, span_context.trace_id());
+
+  // Unknown and partial annotations, and non-hex digits, are rejected.
+  for (const char* invalid :
+       {"25c6f38dd0600e79;56707c7b3e1092af;c49193ea42335d1c;xx",
+        "25c6f38dd0600e79;56707c7b3e1092af;c49193ea42335d1c;c",
+        "25c6f38dd0600e79;56707c7b3e1092af;c49193ea42335d1c,cs",
+        "25c6f38dd0600e79;56707c7b3e1092af;c49193ea42335d1",
+        "25c6f38dd0600e79;56707c7b3e1092af;z49193ea42335d1c",
+        "25c6f38dd0600e79,56707c7b3e1092af;c49193ea42335d1c"}) {
+    span_context.populateFromString("25c6f38dd0600e79;56707c7b3e1092af;c49193ea42335d1c");
+    span_context.populateFromString(invalid);
+    EXPECT_EQ(0ULL, span_context.trace_id()) << invalid;
+    EXPECT_EQ("0000000000000000;0000000000000000;0000000000000000",
+              span_context.serializeToString());
+  }
+
+  // Only the given number of characters is parsed.
+  const std::string with_tail = "25c6f38dd0600e79;56707c7b3e1092af;c49193ea42335d1c;garbage";
+  span_context.populateFromString(with_tail.c_str(), SpanContext::SERIALIZED_LENGTH);
+  EXPECT_EQ(14164264937399213340ULL, span_context.parent_id());
+}
+
 TEST(ZipkinSpanContextTest, populateFromSpan) {
   Span span;
   SpanContext span_context(span);
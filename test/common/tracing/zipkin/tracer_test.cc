@@ -22,7 +22,7 @@ namespace Zipkin {
 class TestReporterImpl : public Reporter {
 public:
   TestReporterImpl(int value) : value_(value) {}
-  void reportSpan(const Span& span) { reported_spans_.push_back(span); }
+  void reportSpan(Span&& span) { reported_spans_.push_back(std::move(span)); }
   int getValue() { return value_; }
   std::vector<Span>& reportedSpans() { return reported_spans_; }
 
@@ -273,13 +273,15 @@ TEST(ZipkinTracerTest, finishSpan) {
 
   // Finishing a server-side span with an SR annotation must add an SS annotation
   server_side->finish();
-  EXPECT_EQ(2ULL, server_side->annotations().size());
 
-  // Test if the reporter's reportSpan method was actually called upon finishing the span
+  // Test if the reporter's reportSpan method was actually called upon finishing the span. The
+  // span is moved into the reporter.
   EXPECT_EQ(1ULL, reporter_object->reportedSpans().size());
+  const Span& reported_span = reporter_object->reportedSpans()[0];
+  EXPECT_EQ(2ULL, reported_span.annotations().size());
 
   // Check the SR annotation added at span-creation time
-  ann = server_side->annotations()[0];
+  ann = reported_span.annotations()[0];
   EXPECT_EQ(ZipkinCoreConstants::get().SERVER_RECV, ann.value());
   // Annotation's timestamp must be set
   EXPECT_EQ(
@@ -290,12 +292,32 @@ TEST(ZipkinTracerTest, finishSpan) {
   EXPECT_EQ("my_service_name", endpoint.serviceName());
 
   // Check the SS annotation added when ending the span
-  ann = server_side->annotations()[1];
+  ann = reported_span.annotations()[1];
   EXPECT_EQ(ZipkinCoreConstants::get().SERVER_SEND, ann.value());
   EXPECT_NE(0ULL, ann.timestamp()); // annotation's timestamp must be set
   EXPECT_TRUE(ann.isSetEndpoint());
   endpoint = ann.endpoint();
   EXPECT_EQ("my_service_name", endpoint.serviceName());
 }
+
+TEST(ZipkinTracerTest, releasedSpansAreReused) {
+  Network::Address::InstanceConstSharedPtr addr =
+      Network::Utility::parseInternetAddressAndPort("127.0.0.1:9000");
+  NiceMock<Runtime::MockRandomGenerator> random_generator;
+  Tracer tracer("my_service_name", addr, random_generator);
+  NiceMock<Tracing::MockConfig> config;
+  ON_CALL(config, operationName()).WillByDefault(Return(Tracing::OperationName::Egress));
+
+  SpanPtr span = tracer.startSpan(config, "first", SystemTime());
+  span->setTag("key", "value");
+  const Span* first = span.get();
+  tracer.releaseSpan(std::move(span));
+
+  span = tracer.startSpan(config, "second", SystemTime());
+  EXPECT_EQ(first, span.get());
+  EXPECT_EQ("second", span->name());
+  EXPECT_EQ(1ULL, span->annotations().size());
+  EXPECT_EQ(0ULL, span->binaryAnnotations().size());
+}
 } // namespace Zipkin
 } // namespace Envoy
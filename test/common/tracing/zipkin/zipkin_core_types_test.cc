@@ -1,9 +1,13 @@
+#include "common/buffer/buffer_impl.h"
+#include "common/common/hex.h"
 #include "common/common/utility.h"
 #include "common/network/address_impl.h"
 #include "common/network/utility.h"
 #include "common/tracing/zipkin/zipkin_core_constants.h"
 #include "common/tracing/zipkin/zipkin_core_types.h"
 
+#include "test/test_common/utility.h"
+
 #include "gtest/gtest.h"
 
 namespace Envoy {
@@ -442,6 +446,8 @@ TEST(ZipkinCoreTypesSpanTest, defaultConstructor) {
 
   // Test setSourceServiceName and setDestinationServiceName
 
+  // The endpoint of ann was moved into the span above.
+  ann.setEndpoint(endpoint);
   ann.setValue(Zipkin::ZipkinCoreConstants::get().CLIENT_RECV);
   span.addAnnotation(ann);
   span.setServiceName("NEW_SERVICE_NAME");
@@ -567,5 +573,61 @@ TEST(ZipkinCoreTypesSpanTest, setTag) {
   EXPECT_EQ("key2", bann.key());
   EXPECT_EQ("value2", bann.value());
 }
+
+TEST(ZipkinCoreTypesSpanTest, toThrift) {
+  Endpoint endpoint(std::string("svc"),
+                    Network::Utility::parseInternetAddressAndPort("127.0.0.1:3306"));
+  Span span;
+  span.setTraceId(1);
+  span.setName("n");
+  span.setId(2);
+  span.setParentId(3);
+  span.setTimestamp(4);
+  span.setDuration(5);
+  span.addAnnotation(Annotation(1, "cs", endpoint));
+  span.addBinaryAnnotation(BinaryAnnotation("k", "v"));
+
+  Buffer::OwnedImpl buffer;
+  ThriftWriter writer(buffer);
+  span.toThrift(writer);
+
+  const std::string endpoint_thrift = "0800017f000001"
+                                      "0600020cea"
+                                      "0b000300000003737663"
+                                      "00";
+  const std::string annotation_thrift = "0a00010000000000000001"
+                                        "0b0002000000026373"
+                                        "0c0003" +
+                                        endpoint_thrift + "00";
+  const std::string binary_annotation_thrift = "0b0001000000016b"
+                                               "0b00020000000176"
+                                               "08000300000006"
+                                               "00";
+  const std::string expected = "0a00010000000000000001"
+                               "0b0003000000016e"
+                               "0a00040000000000000002"
+                               "0a00050000000000000003"
+                               "0f00060c00000001" +
+                               annotation_thrift + "0f00080c00000001" + binary_annotation_thrift +
+                               "0a000a0000000000000004"
+                               "0a000b0000000000000005"
+                               "00";
+  const std::string body = TestUtility::bufferToString(buffer);
+  EXPECT_EQ(expected, Hex::encode(reinterpret_cast<const uint8_t*>(body.data()), body.size()));
+
+  // IPv6 endpoints are written as binary after a zero IPv4 address.
+  Buffer::OwnedImpl ipv6_buffer;
+  ThriftWriter ipv6_writer(ipv6_buffer);
+  Endpoint(std::string(""), Network::Utility::parseInternetAddressAndPort("[::1]:80"))
+      .toThrift(ipv6_writer);
+  const std::string ipv6_body = TestUtility::bufferToString(ipv6_buffer);
+  EXPECT_EQ("08000100000000"
+            "0600020050"
+            "0b000300000000"
+            "0b000400000010"
+            "00000000000000000000000000000001"
+            "00",
+            Hex::encode(reinterpret_cast<const uint8_t*>(ipv6_body.data()), ipv6_body.size()));
+}
 } // namespace Zipkin
 } // namespace Envoy
@@ -217,6 +217,46 @@ TEST_F(ZipkinDriverTest, FlushOneSpanReportFailure) {
   EXPECT_EQ(0U, stats_.counter("tracing.zipkin.reports_failed").value());
 }
 
+TEST_F(ZipkinDriverTest, FlushThriftSpans) {
+  EXPECT_CALL(cm_, get("fake_cluster")).WillRepeatedly(Return(&cm_.thread_local_cluster_));
+  std::string thrift_config = R"EOF(
+    {
+     "collector_cluster": "fake_cluster",
+     "collector_encoding": "thrift"
+    }
+  )EOF";
+  Json::ObjectSharedPtr loader = Json::Factory::loadFromString(thrift_config);
+  setup(*loader, true);
+
+  Http::MockAsyncClientRequest request(&cm_.async_client_);
+  const Optional<std::chrono::milliseconds> timeout(std::chrono::seconds(5));
+
+  EXPECT_CALL(cm_.async_client_, send_(_, _, timeout))
+      .WillOnce(
+          Invoke([&](Http::MessagePtr& message, Http::AsyncClient::Callbacks&,
+                     const Optional<std::chrono::milliseconds>&) -> Http::AsyncClient::Request* {
+            EXPECT_STREQ("/api/v1/spans", message->headers().Path()->value().c_str());
+            EXPECT_STREQ("application/x-thrift",
+                         message->headers().ContentType()->value().c_str());
+
+            // A Thrift list of one struct.
+            const std::string body = TestUtility::bufferToString(*message->body());
+            EXPECT_EQ(std::string("\x0c\x00\x00\x00\x01", 5), body.substr(0, 5));
+
+            return &request;
+          }));
+  EXPECT_CALL(runtime_.snapshot_, getInteger("tracing.zipkin.min_flush_spans", 5))
+      .WillOnce(Return(1));
+  EXPECT_CALL(runtime_.snapshot_, getInteger("tracing.zipkin.request_timeout", 5000U))
+      .WillOnce(Return(5000U));
+
+  Tracing::SpanPtr span =
+      driver_->startSpan(config_, request_headers_, operation_name_, start_time_);
+  span->finishSpan();
+
+  EXPECT_EQ(1U, stats_.counter("tracing.zipkin.spans_sent").value());
+}
+
 TEST_F(ZipkinDriverTest, FlushSpansTimer) {
   setupValidDriver();
 
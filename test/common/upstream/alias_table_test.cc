@@ -0,0 +1,46 @@
+#include <cstdint>
+#include <vector>
+
+#include "common/upstream/alias_table.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Upstream {
+
+TEST(AliasTableTest, Empty) {
+  EXPECT_TRUE(AliasTable().empty());
+  EXPECT_TRUE(AliasTable(std::vector<uint64_t>()).empty());
+  EXPECT_TRUE(AliasTable({0, 0}).empty());
+}
+
+// Every (column, threshold) pair comes up once as the random value runs over columns * total
+// weight, so each entry is then picked exactly columns * weight times.
+TEST(AliasTableTest, ExactProportions) {
+  const std::vector<uint64_t> weights{0, 667, 667, 5, 1000, 0, 1};
+  uint64_t total = 0;
+  for (uint64_t weight : weights) {
+    total += weight;
+  }
+
+  AliasTable table(weights);
+  ASSERT_FALSE(table.empty());
+  std::vector<uint64_t> picks(weights.size());
+  for (uint64_t random = 0; random < weights.size() * total; random++) {
+    picks[table.pick(random)]++;
+  }
+
+  for (size_t i = 0; i < weights.size(); i++) {
+    EXPECT_EQ(weights.size() * weights[i], picks[i]);
+  }
+}
+
+TEST(AliasTableTest, SingleEntry) {
+  AliasTable table({0, 3, 0});
+  for (uint64_t random = 0; random < 100; random++) {
+    EXPECT_EQ(1U, table.pick(random));
+  }
+}
+
+} // namespace Upstream
+} // namespace Envoy
@@ -559,6 +559,41 @@ TEST_F(ClusterManagerImplTest, ShutdownOrder) {
   EXPECT_EQ(3U, cluster.info().use_count());
 }
 
+// Validate that with lazy thread local clusters, the thread local cluster is only created on first
+// use, with the latest membership.
+TEST_F(ClusterManagerImplTest, LazyThreadLocalClusters) {
+  ON_CALL(factory_.runtime_.snapshot_, getInteger("upstream.lazy_thread_local_clusters", 0))
+      .WillByDefault(Return(1));
+  const std::string json =
+      fmt::sprintf("{%s}", clustersJson({defaultStaticClusterJson("cluster_1")}));
+
+  create(parseBootstrapFromJson(json));
+  const Cluster& cluster = cluster_manager_->clusters().begin()->second;
+  ThreadLocalCluster* thread_local_cluster = cluster_manager_->get("cluster_1");
+  ASSERT_NE(nullptr, thread_local_cluster);
+  EXPECT_EQ(cluster.info(), thread_local_cluster->info());
+  EXPECT_EQ(1UL, thread_local_cluster->prioritySet().hostSetsPerPriority()[0]->hosts().size());
+  EXPECT_EQ(cluster.prioritySet().hostSetsPerPriority()[0]->hosts()[0],
+            thread_local_cluster->loadBalancer().chooseHost(nullptr));
+  EXPECT_EQ(thread_local_cluster, cluster_manager_->get("cluster_1"));
+
+  std::shared_ptr<MockCluster> cluster2(new NiceMock<MockCluster>());
+  cluster2->prioritySet().getMockHostSet(0)->hosts_ = {
+      makeTestHost(cluster2->info_, "tcp://127.0.0.1:80")};
+  EXPECT_CALL(factory_, clusterFromProto_(_, _, _, _)).WillOnce(Return(cluster2));
+  EXPECT_TRUE(cluster_manager_->addOrUpdatePrimaryCluster(defaultStaticCluster("fake_cluster")));
+  Http::ConnectionPool::MockInstance* cp = new NiceMock<Http::ConnectionPool::MockInstance>();
+  EXPECT_CALL(factory_, allocateConnPool_(_)).WillOnce(Return(cp));
+  EXPECT_EQ(cp, cluster_manager_->httpConnPoolForCluster("fake_cluster", ResourcePriority::Default,
+                                                         nullptr));
+  EXPECT_EQ(cluster2->info_, cluster_manager_->get("fake_cluster")->info());
+
+  EXPECT_TRUE(cluster_manager_->removePrimaryCluster("fake_cluster"));
+  EXPECT_EQ(nullptr, cluster_manager_->get("fake_cluster"));
+  EXPECT_EQ(nullptr, cluster_manager_->get("hello"));
+  factory_.tls_.shutdownThread();
+}
+
 TEST_F(ClusterManagerImplTest, InitializeOrder) {
   const std::string json = fmt::sprintf(
       R"EOF(
@@ -765,6 +800,48 @@ TEST_F(ClusterManagerImplTest, DynamicAddRemove) {
   EXPECT_TRUE(Mock::VerifyAndClearExpectations(cluster2.get()));
 }
 
+TEST_F(ClusterManagerImplTest, ClusterHandle) {
+  const std::string json = R"EOF(
+  {
+    "clusters": []
+  }
+  )EOF";
+
+  create(parseBootstrapFromJson(json));
+
+  // Handles may be resolved before their cluster exists.
+  ClusterHandleConstSharedPtr handle = cluster_manager_->clusterHandle("fake_cluster");
+  ClusterHandleConstSharedPtr other_handle = cluster_manager_->clusterHandle("other_cluster");
+  EXPECT_EQ(nullptr, handle->get());
+  EXPECT_EQ(nullptr, handle->httpConnPool(ResourcePriority::Default, nullptr));
+
+  std::shared_ptr<MockCluster> cluster1(new NiceMock<MockCluster>());
+  EXPECT_CALL(factory_, clusterFromProto_(_, _, _, _)).WillOnce(Return(cluster1));
+  EXPECT_TRUE(cluster_manager_->addOrUpdatePrimaryCluster(defaultStaticCluster("fake_cluster")));
+  EXPECT_EQ(cluster1->info_, handle->get()->info());
+  EXPECT_EQ(nullptr, other_handle->get());
+
+  // The handle follows an update of the cluster.
+  auto update_cluster = defaultStaticCluster("fake_cluster");
+  update_cluster.mutable_per_connection_buffer_limit_bytes()->set_value(12345);
+  std::shared_ptr<MockCluster> cluster2(new NiceMock<MockCluster>());
+  cluster2->prioritySet().getMockHostSet(0)->hosts_ = {
+      makeTestHost(cluster2->info_, "tcp://127.0.0.1:80")};
+  EXPECT_CALL(factory_, clusterFromProto_(_, _, _, _)).WillOnce(Return(cluster2));
+  EXPECT_TRUE(cluster_manager_->addOrUpdatePrimaryCluster(update_cluster));
+  EXPECT_EQ(cluster2->info_, handle->get()->info());
+  EXPECT_EQ(handle->get(), cluster_manager_->clusterHandle("fake_cluster")->get());
+
+  Http::ConnectionPool::MockInstance* cp = new Http::ConnectionPool::MockInstance();
+  EXPECT_CALL(factory_, allocateConnPool_(_)).WillOnce(Return(cp));
+  EXPECT_EQ(cp, handle->httpConnPool(ResourcePriority::Default, nullptr));
+
+  EXPECT_CALL(*cp, addDrainedCallback(_));
+  EXPECT_TRUE(cluster_manager_->removePrimaryCluster("fake_cluster"));
+  EXPECT_EQ(nullptr, handle->get());
+  EXPECT_EQ(nullptr, handle->httpConnPool(ResourcePriority::Default, nullptr));
+}
+
 TEST_F(ClusterManagerImplTest, AddOrUpdatePrimaryClusterStaticExists) {
   const std::string json =
       fmt::sprintf("{%s}", clustersJson({defaultStaticClusterJson("some_cluster")}));
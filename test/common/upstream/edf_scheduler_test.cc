@@ -0,0 +1,48 @@
+#include <memory>
+#include <vector>
+
+#include "common/upstream/edf_scheduler.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Upstream {
+
+TEST(EdfSchedulerTest, Empty) {
+  EdfScheduler<uint32_t> sched;
+  EXPECT_TRUE(sched.empty());
+  EXPECT_EQ(nullptr, sched.pick());
+}
+
+// Entries are picked in proportion to their weights, interleaved by deadline. Ties are broken in
+// the order the entries were added.
+TEST(EdfSchedulerTest, WeightedPicks) {
+  EdfScheduler<uint32_t> sched;
+  std::vector<std::shared_ptr<uint32_t>> entries{std::make_shared<uint32_t>(0),
+                                                 std::make_shared<uint32_t>(1),
+                                                 std::make_shared<uint32_t>(2)};
+  const std::vector<double> weights{1, 2, 4};
+  for (uint32_t i = 0; i < entries.size(); ++i) {
+    sched.add(weights[i], entries[i]);
+  }
+
+  const std::vector<uint32_t> expected{2, 1, 2, 2, 0, 1, 2};
+  for (uint32_t value : expected) {
+    std::shared_ptr<uint32_t> picked = sched.pick();
+    EXPECT_EQ(value, *picked);
+    sched.add(weights[*picked], picked);
+  }
+
+  std::vector<uint32_t> counts(entries.size());
+  for (uint32_t i = 0; i < 700; ++i) {
+    std::shared_ptr<uint32_t> picked = sched.pick();
+    counts[*picked]++;
+    sched.add(weights[*picked], picked);
+  }
+  EXPECT_EQ(100U, counts[0]);
+  EXPECT_EQ(200U, counts[1]);
+  EXPECT_EQ(400U, counts[2]);
+}
+
+} // namespace Upstream
+} // namespace Envoy
@@ -0,0 +1,106 @@
+#include <cstdint>
+#include <memory>
+
+#include "common/stats/stats_impl.h"
+#include "common/upstream/eds.h"
+
+#include "test/common/upstream/utility.h"
+#include "test/mocks/local_info/mocks.h"
+#include "test/mocks/runtime/mocks.h"
+#include "test/mocks/ssl/mocks.h"
+#include "test/mocks/upstream/mocks.h"
+
+#include "api/eds.pb.h"
+#include "benchmark/benchmark.h"
+#include "fmt/format.h"
+#include "gmock/gmock.h"
+
+using testing::NiceMock;
+
+namespace Envoy {
+namespace Upstream {
+
+/**
+ * Holds an EDS cluster that has been updated with the given number of endpoints.
+ */
+class EdsPerf {
+public:
+  EdsPerf(uint32_t num_hosts) {
+    envoy::api::v2::ConfigSource eds_config;
+    eds_config.mutable_api_config_source()->add_cluster_name("eds");
+    eds_config.mutable_api_config_source()->mutable_refresh_delay()->set_seconds(1);
+    eds_cluster_ = parseSdsClusterFromJson(R"EOF(
+    {
+      "name": "name",
+      "connect_timeout_ms": 250,
+      "type": "sds",
+      "lb_type": "round_robin",
+      "service_name": "fare"
+    }
+    )EOF",
+                                           eds_config);
+    cluster_.reset(new EdsClusterImpl(eds_cluster_, runtime_, stats_, ssl_context_manager_,
+                                      local_info_, cm_, dispatcher_, random_, false));
+
+    auto* cluster_load_assignment = resources_.Add();
+    cluster_load_assignment->set_cluster_name("fare");
+    auto* endpoints = cluster_load_assignment->add_endpoints();
+    for (uint32_t i = 0; i < num_hosts; i++) {
+      auto* socket_address = endpoints->add_lb_endpoints()
+                                 ->mutable_endpoint()
+                                 ->mutable_address()
+                                 ->mutable_socket_address();
+      socket_address->set_address(fmt::format("10.0.{}.{}", i / 256, i % 256));
+      socket_address->set_port_value(80);
+    }
+
+    cluster_->initialize([] {});
+    cluster_->onConfigUpdate(resources_);
+  }
+
+  // Move the first endpoint to another port, which removes one host and adds one.
+  void changeOneEndpoint(uint32_t port) {
+    resources_[0]
+        .mutable_endpoints(0)
+        ->mutable_lb_endpoints(0)
+        ->mutable_endpoint()
+        ->mutable_address()
+        ->mutable_socket_address()
+        ->set_port_value(port);
+    cluster_->onConfigUpdate(resources_);
+  }
+
+  Stats::IsolatedStoreImpl stats_;
+  NiceMock<Ssl::MockContextManager> ssl_context_manager_;
+  envoy::api::v2::Cluster eds_cluster_;
+  NiceMock<MockClusterManager> cm_;
+  NiceMock<Event::MockDispatcher> dispatcher_;
+  NiceMock<Runtime::MockRandomGenerator> random_;
+  NiceMock<Runtime::MockLoader> runtime_;
+  NiceMock<LocalInfo::MockLocalInfo> local_info_;
+  std::shared_ptr<EdsClusterImpl> cluster_;
+  Protobuf::RepeatedPtrField<envoy::api::v2::ClusterLoadAssignment> resources_;
+};
+
+// The cost of an EDS update that changes a single endpoint, by cluster size.
+static void EdsUpdateOneEndpoint(benchmark::State& state) {
+  EdsPerf perf(state.range(0));
+  bool moved = false;
+  while (state.KeepRunning()) {
+    moved = !moved;
+    perf.changeOneEndpoint(moved ? 81 : 80);
+  }
+}
+BENCHMARK(EdsUpdateOneEndpoint)->Arg(100)->Arg(1000)->Arg(10000)->Arg(20000);
+
+// The cost of an EDS update that changes nothing, by cluster size.
+static void EdsUpdateNoChange(benchmark::State& state) {
+  EdsPerf perf(state.range(0));
+  while (state.KeepRunning()) {
+    perf.cluster_->onConfigUpdate(perf.resources_);
+  }
+}
+BENCHMARK(EdsUpdateNoChange)->Arg(100)->Arg(1000)->Arg(10000)->Arg(20000);
+
+} // namespace Upstream
+} // namespace Envoy
@@ -350,6 +350,66 @@ TEST_F(EdsTest, EndpointHostsPerPriority) {
   EXPECT_EQ(4, cluster_->prioritySet().hostSetsPerPriority()[3]->hosts().size());
 }
 
+// Validate that onConfigUpdate() keeps the hosts that are still present, and only reports the
+// endpoints that changed.
+TEST_F(EdsTest, EndpointUpdateKeepsExistingHosts) {
+  Protobuf::RepeatedPtrField<envoy::api::v2::ClusterLoadAssignment> resources;
+  auto* cluster_load_assignment = resources.Add();
+  cluster_load_assignment->set_cluster_name("fare");
+  auto set_hosts = [cluster_load_assignment](const std::vector<uint32_t>& ports, uint32_t weight) {
+    cluster_load_assignment->clear_endpoints();
+    auto* endpoints = cluster_load_assignment->add_endpoints();
+    for (uint32_t port : ports) {
+      auto* endpoint = endpoints->add_lb_endpoints();
+      auto* socket_address =
+          endpoint->mutable_endpoint()->mutable_address()->mutable_socket_address();
+      socket_address->set_address("1.2.3.4");
+      socket_address->set_port_value(port);
+      endpoint->mutable_load_balancing_weight()->set_value(weight);
+    }
+  };
+
+  set_hosts({80, 81, 82}, 1);
+  bool initialized = false;
+  cluster_->initialize([&initialized] { initialized = true; });
+  VERBOSE_EXPECT_NO_THROW(cluster_->onConfigUpdate(resources));
+  EXPECT_TRUE(initialized);
+  const std::vector<HostSharedPtr> old_hosts =
+      cluster_->prioritySet().hostSetsPerPriority()[0]->hosts();
+
+  std::vector<HostSharedPtr> hosts_added;
+  std::vector<HostSharedPtr> hosts_removed;
+  uint32_t updates = 0;
+  cluster_->prioritySet().addMemberUpdateCb(
+      [&](uint32_t, const std::vector<HostSharedPtr>& added,
+          const std::vector<HostSharedPtr>& removed) -> void {
+        updates++;
+        hosts_added = added;
+        hosts_removed = removed;
+      });
+
+  // Drop 81, add 83 and change the weights.
+  set_hosts({82, 80, 83}, 3);
+  VERBOSE_EXPECT_NO_THROW(cluster_->onConfigUpdate(resources));
+  EXPECT_EQ(1, updates);
+  const auto& hosts = cluster_->prioritySet().hostSetsPerPriority()[0]->hosts();
+  ASSERT_EQ(3, hosts.size());
+  EXPECT_EQ(old_hosts[2], hosts[0]);
+  EXPECT_EQ(old_hosts[0], hosts[1]);
+  EXPECT_EQ("1.2.3.4:83", hosts[2]->address()->asString());
+  EXPECT_EQ(3, hosts[0]->weight());
+  EXPECT_EQ(3, hosts[1]->weight());
+  ASSERT_EQ(1, hosts_added.size());
+  EXPECT_EQ(hosts[2], hosts_added[0]);
+  ASSERT_EQ(1, hosts_removed.size());
+  EXPECT_EQ(old_hosts[1], hosts_removed[0]);
+  EXPECT_EQ(3, cluster_->info()->stats().max_host_weight_.value());
+
+  // The same endpoints again are not a membership change.
+  VERBOSE_EXPECT_NO_THROW(cluster_->onConfigUpdate(resources));
+  EXPECT_EQ(1, updates);
+}
+
 // Make sure config updates with P!=0 are rejected for the local cluster.
 TEST_F(EdsTest, NoPriorityForLocalCluster) {
   cm_.local_cluster_name_ = "fare";
@@ -25,5 +25,18 @@ TEST(HostUtilityTest, All) {
   EXPECT_EQ("/failed_outlier_check", HostUtility::healthFlagsToString(*host));
 }
 
+TEST(HostUtilityTest, RecordResponseTime) {
+  ClusterInfoConstSharedPtr cluster{new MockClusterInfo()};
+  HostSharedPtr host = makeTestHost(cluster, "tcp://127.0.0.1:80");
+
+  // The first sample is taken as is, later ones are weighed at 1/8.
+  HostUtility::recordResponseTime(*host, std::chrono::milliseconds(8));
+  EXPECT_EQ(8000U, host->stats().rq_latency_ewma_us_.value());
+  HostUtility::recordResponseTime(*host, std::chrono::milliseconds(16));
+  EXPECT_EQ(9000U, host->stats().rq_latency_ewma_us_.value());
+  HostUtility::recordResponseTime(*host, std::chrono::milliseconds(1));
+  EXPECT_EQ(8000U, host->stats().rq_latency_ewma_us_.value());
+}
+
 } // namespace Upstream
 } // namespace Envoy
@@ -0,0 +1,48 @@
+#include <chrono>
+
+#include "common/upstream/latency_estimator_impl.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Upstream {
+
+TEST(LatencyEstimatorImplTest, NoEstimateUntilWindowFull) {
+  LatencyEstimatorImpl estimator(4);
+  for (int i = 0; i < 3; i++) {
+    estimator.putResponseTime(std::chrono::milliseconds(1));
+    EXPECT_FALSE(estimator.percentile(50).valid());
+  }
+
+  estimator.putResponseTime(std::chrono::milliseconds(1));
+  EXPECT_EQ(std::chrono::milliseconds(1), estimator.percentile(50).value());
+}
+
+// Percentiles come from the last full window, and not from the window being written.
+TEST(LatencyEstimatorImplTest, PercentileOfLastFullWindow) {
+  LatencyEstimatorImpl estimator(4);
+  estimator.putResponseTime(std::chrono::milliseconds(1));
+  estimator.putResponseTime(std::chrono::milliseconds(1));
+  estimator.putResponseTime(std::chrono::milliseconds(1));
+  estimator.putResponseTime(std::chrono::milliseconds(3));
+  EXPECT_EQ(std::chrono::milliseconds(1), estimator.percentile(50).value());
+  EXPECT_EQ(std::chrono::milliseconds(3), estimator.percentile(100).value());
+
+  for (int i = 0; i < 3; i++) {
+    estimator.putResponseTime(std::chrono::milliseconds(2));
+  }
+  EXPECT_EQ(std::chrono::milliseconds(3), estimator.percentile(100).value());
+
+  estimator.putResponseTime(std::chrono::milliseconds(2));
+  EXPECT_EQ(std::chrono::milliseconds(2), estimator.percentile(50).value());
+  EXPECT_EQ(std::chrono::milliseconds(2), estimator.percentile(100).value());
+
+  // The window that is written next starts empty.
+  for (int i = 0; i < 4; i++) {
+    estimator.putResponseTime(std::chrono::milliseconds(0));
+  }
+  EXPECT_EQ(std::chrono::milliseconds(0), estimator.percentile(100).value());
+}
+
+} // namespace Upstream
+} // namespace Envoy
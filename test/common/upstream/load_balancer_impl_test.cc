@@ -180,6 +180,44 @@ TEST_P(RoundRobinLoadBalancerTest, Normal) {
   EXPECT_EQ(hostSet().healthy_hosts_[0], lb_->chooseHost(nullptr));
 }
 
+TEST_P(RoundRobinLoadBalancerTest, WeightedHosts) {
+  hostSet().healthy_hosts_ = {makeTestHost(info_, "tcp://127.0.0.1:80", 1),
+                              makeTestHost(info_, "tcp://127.0.0.1:81", 4)};
+  hostSet().hosts_ = hostSet().healthy_hosts_;
+  init(false);
+
+  // The heavier host gets four picks for every pick of the lighter one.
+  for (uint32_t i = 0; i < 2; ++i) {
+    EXPECT_EQ(hostSet().healthy_hosts_[1], lb_->chooseHost(nullptr));
+    EXPECT_EQ(hostSet().healthy_hosts_[1], lb_->chooseHost(nullptr));
+    EXPECT_EQ(hostSet().healthy_hosts_[1], lb_->chooseHost(nullptr));
+    EXPECT_EQ(hostSet().healthy_hosts_[0], lb_->chooseHost(nullptr));
+    EXPECT_EQ(hostSet().healthy_hosts_[1], lb_->chooseHost(nullptr));
+  }
+
+  // Weights can be turned off at runtime.
+  ON_CALL(runtime_.snapshot_, getInteger("upstream.weight_enabled", 1)).WillByDefault(Return(0));
+  EXPECT_EQ(hostSet().healthy_hosts_[0], lb_->chooseHost(nullptr));
+  EXPECT_EQ(hostSet().healthy_hosts_[1], lb_->chooseHost(nullptr));
+}
+
+TEST_P(RoundRobinLoadBalancerTest, WeightedHostsMembershipUpdate) {
+  hostSet().healthy_hosts_ = {makeTestHost(info_, "tcp://127.0.0.1:80", 1),
+                              makeTestHost(info_, "tcp://127.0.0.1:81", 4)};
+  hostSet().hosts_ = hostSet().healthy_hosts_;
+  init(false);
+  EXPECT_EQ(hostSet().healthy_hosts_[1], lb_->chooseHost(nullptr));
+
+  // After an update with equal weights, hosts are picked in turn again.
+  hostSet().healthy_hosts_ = {makeTestHost(info_, "tcp://127.0.0.1:82", 2),
+                              makeTestHost(info_, "tcp://127.0.0.1:83", 2)};
+  hostSet().hosts_ = hostSet().healthy_hosts_;
+  hostSet().runCallbacks({}, {});
+  EXPECT_EQ(hostSet().healthy_hosts_[0], lb_->chooseHost(nullptr));
+  EXPECT_EQ(hostSet().healthy_hosts_[1], lb_->chooseHost(nullptr));
+  EXPECT_EQ(hostSet().healthy_hosts_[0], lb_->chooseHost(nullptr));
+}
+
 TEST_P(RoundRobinLoadBalancerTest, MaxUnhealthyPanic) {
   hostSet().healthy_hosts_ = {makeTestHost(info_, "tcp://127.0.0.1:80"),
                               makeTestHost(info_, "tcp://127.0.0.1:81")};
@@ -343,11 +381,43 @@ TEST_P(RoundRobinLoadBalancerTest, ZoneAwareRoutingSmallZone) {
   EXPECT_EQ(1U, stats_.lb_zone_routing_sampled_.value());
 
   // Force request out of small zone.
-  EXPECT_CALL(random_, random()).WillOnce(Return(9999)).WillOnce(Return(2));
+  EXPECT_CALL(random_, random()).WillOnce(Return(9999)).WillOnce(Return(1));
   EXPECT_EQ(hostSet().healthy_hosts_per_locality_[1][1], lb_->chooseHost(nullptr));
   EXPECT_EQ(1U, stats_.lb_zone_routing_cross_zone_.value());
 }
 
+// Upstream locality capacity is in proportion to host weights. By count the local locality has a
+// third of the upstream hosts for half of the local Envoys, but it has 60% of the weight.
+TEST_P(RoundRobinLoadBalancerTest, ZoneAwareRoutingHostWeights) {
+  HostVectorSharedPtr upstream_hosts(new std::vector<HostSharedPtr>(
+      {makeTestHost(info_, "tcp://127.0.0.1:80", 3), makeTestHost(info_, "tcp://127.0.0.1:81"),
+       makeTestHost(info_, "tcp://127.0.0.1:82")}));
+  HostVectorSharedPtr local_hosts(new std::vector<HostSharedPtr>(
+      {makeTestHost(info_, "tcp://127.0.0.1:0"), makeTestHost(info_, "tcp://127.0.0.1:1")}));
+
+  HostListsSharedPtr upstream_hosts_per_locality(new std::vector<std::vector<HostSharedPtr>>(
+      {{(*upstream_hosts)[0]}, {(*upstream_hosts)[1], (*upstream_hosts)[2]}}));
+  HostListsSharedPtr local_hosts_per_locality(new std::vector<std::vector<HostSharedPtr>>(
+      {{(*local_hosts)[0]}, {(*local_hosts)[1]}}));
+
+  EXPECT_CALL(runtime_.snapshot_, getInteger("upstream.healthy_panic_threshold", 50))
+      .WillRepeatedly(Return(50));
+  EXPECT_CALL(runtime_.snapshot_, featureEnabled("upstream.zone_routing.enabled", 100))
+      .WillRepeatedly(Return(true));
+  EXPECT_CALL(runtime_.snapshot_, getInteger("upstream.zone_routing.min_cluster_size", 6))
+      .WillRepeatedly(Return(3));
+
+  hostSet().healthy_hosts_ = *upstream_hosts;
+  hostSet().hosts_ = *upstream_hosts;
+  hostSet().healthy_hosts_per_locality_ = *upstream_hosts_per_locality;
+  init(true);
+  local_host_set_->updateHosts(local_hosts, local_hosts, local_hosts_per_locality,
+                               local_hosts_per_locality, empty_host_vector_, empty_host_vector_);
+
+  EXPECT_EQ(hostSet().healthy_hosts_per_locality_[0][0], lb_->chooseHost(nullptr));
+  EXPECT_EQ(1U, stats_.lb_zone_routing_all_directly_.value());
+}
+
 TEST_P(RoundRobinLoadBalancerTest, LowPrecisionForDistribution) {
   // upstream_hosts and local_hosts do not matter, zone aware routing is based on per zone hosts.
   HostVectorSharedPtr upstream_hosts(
@@ -499,19 +569,13 @@ TEST_P(LeastRequestLoadBalancerTest, SingleHost) {
 
   // Host weight is 100.
   {
-    EXPECT_CALL(random_, random()).WillOnce(Return(2));
+    EXPECT_CALL(random_, random()).WillOnce(Return(2)).WillOnce(Return(3));
     stats_.max_host_weight_.set(100UL);
     EXPECT_EQ(hostSet().healthy_hosts_[0], lb_.chooseHost(nullptr));
   }
 
-  std::vector<HostSharedPtr> empty;
-  {
-    hostSet().runCallbacks(empty, empty);
-    EXPECT_CALL(random_, random()).WillOnce(Return(2));
-    EXPECT_EQ(hostSet().healthy_hosts_[0], lb_.chooseHost(nullptr));
-  }
-
   {
+    std::vector<HostSharedPtr> empty;
     std::vector<HostSharedPtr> remove_hosts;
     remove_hosts.push_back(hostSet().hosts_[0]);
     hostSet().runCallbacks(empty, remove_hosts);
@@ -542,12 +606,39 @@ TEST_P(LeastRequestLoadBalancerTest, Normal) {
   EXPECT_EQ(hostSet().healthy_hosts_[1], lb_.chooseHost(nullptr));
 }
 
+TEST_P(LeastRequestLoadBalancerTest, ChoiceCount) {
+  ON_CALL(runtime_.snapshot_, getInteger("upstream.least_request.choice_count", 2))
+      .WillByDefault(Return(3));
+
+  hostSet().healthy_hosts_ = {makeTestHost(info_, "tcp://127.0.0.1:80"),
+                              makeTestHost(info_, "tcp://127.0.0.1:81"),
+                              makeTestHost(info_, "tcp://127.0.0.1:82")};
+  stats_.max_host_weight_.set(1UL);
+  hostSet().hosts_ = hostSet().healthy_hosts_;
+  hostSet().runCallbacks({}, {}); // Trigger callbacks. The added/removed lists are not relevant.
+  hostSet().healthy_hosts_[0]->stats().rq_active_.set(3);
+  hostSet().healthy_hosts_[1]->stats().rq_active_.set(1);
+  hostSet().healthy_hosts_[2]->stats().rq_active_.set(2);
+
+  EXPECT_CALL(random_, random()).WillOnce(Return(0)).WillOnce(Return(1)).WillOnce(Return(2));
+  EXPECT_EQ(hostSet().healthy_hosts_[1], lb_.chooseHost(nullptr));
+
+  // A choice count of 0 is treated as 1, which is a random pick.
+  ON_CALL(runtime_.snapshot_, getInteger("upstream.least_request.choice_count", 2))
+      .WillByDefault(Return(0));
+  EXPECT_CALL(random_, random()).WillOnce(Return(0));
+  EXPECT_EQ(hostSet().healthy_hosts_[0], lb_.chooseHost(nullptr));
+
+  // Large choice counts are capped at 10 picks.
+  ON_CALL(runtime_.snapshot_, getInteger("upstream.least_request.choice_count", 2))
+      .WillByDefault(Return(1000000));
+  EXPECT_CALL(random_, random()).Times(10).WillRepeatedly(Return(1));
+  EXPECT_EQ(hostSet().healthy_hosts_[1], lb_.chooseHost(nullptr));
+}
+
 TEST_P(LeastRequestLoadBalancerTest, WeightImbalanceRuntimeOff) {
   // Disable weight balancing.
-  EXPECT_CALL(runtime_.snapshot_, getInteger("upstream.weight_enabled", 1))
-      .WillRepeatedly(Return(0));
-  EXPECT_CALL(runtime_.snapshot_, getInteger("upstream.healthy_panic_threshold", 50))
-      .WillRepeatedly(Return(50));
+  ON_CALL(runtime_.snapshot_, getInteger("upstream.weight_enabled", 1)).WillByDefault(Return(0));
 
   hostSet().healthy_hosts_ = {makeTestHost(info_, "tcp://127.0.0.1:80", 1),
                               makeTestHost(info_, "tcp://127.0.0.1:81", 3)};
@@ -572,66 +663,46 @@ TEST_P(LeastRequestLoadBalancerTest, WeightImbalance) {
 
   hostSet().hosts_ = hostSet().healthy_hosts_;
   hostSet().runCallbacks({}, {}); // Trigger callbacks. The added/removed lists are not relevant.
-  EXPECT_CALL(runtime_.snapshot_, getInteger("upstream.healthy_panic_threshold", 50))
-      .WillRepeatedly(Return(50));
 
-  EXPECT_CALL(runtime_.snapshot_, getInteger("upstream.weight_enabled", 1))
-      .WillRepeatedly(Return(1));
-  EXPECT_CALL(runtime_.snapshot_, getInteger("upstream.healthy_panic_threshold", 50))
-      .WillRepeatedly(Return(50));
-
-  // As max weight higher then 1 we do random host pick and keep it for weight requests.
-  EXPECT_CALL(random_, random()).WillOnce(Return(1));
-  EXPECT_EQ(hostSet().healthy_hosts_[1], lb_.chooseHost(nullptr));
-
-  // Same host stays as we have to hit it 3 times.
-  hostSet().healthy_hosts_[0]->stats().rq_active_.set(2);
-  hostSet().healthy_hosts_[1]->stats().rq_active_.set(1);
-  EXPECT_CALL(random_, random()).Times(0);
-  EXPECT_EQ(hostSet().healthy_hosts_[1], lb_.chooseHost(nullptr));
-
-  // Same host stays as we have to hit it 3 times.
-  EXPECT_CALL(random_, random()).Times(0);
+  // The heavier host wins while it has fewer than 3 times the requests of the lighter one.
+  hostSet().healthy_hosts_[0]->stats().rq_active_.set(1);
+  hostSet().healthy_hosts_[1]->stats().rq_active_.set(4);
+  EXPECT_CALL(random_, random()).WillOnce(Return(1)).WillOnce(Return(0));
   EXPECT_EQ(hostSet().healthy_hosts_[1], lb_.chooseHost(nullptr));
 
-  // Get random host after previous one was selected 3 times in a row.
-  EXPECT_CALL(random_, random()).WillOnce(Return(2));
+  hostSet().healthy_hosts_[1]->stats().rq_active_.set(6);
+  EXPECT_CALL(random_, random()).WillOnce(Return(1)).WillOnce(Return(0));
   EXPECT_EQ(hostSet().healthy_hosts_[0], lb_.chooseHost(nullptr));
 
-  // Select second host again.
-  EXPECT_CALL(random_, random()).WillOnce(Return(1));
-  EXPECT_EQ(hostSet().healthy_hosts_[1], lb_.chooseHost(nullptr));
-
-  // Set weight to 1, we will switch to the two random hosts mode.
+  // Set weight to 1, we will compare active requests only.
   stats_.max_host_weight_.set(1UL);
-  EXPECT_CALL(random_, random()).WillOnce(Return(2)).WillOnce(Return(3));
-  EXPECT_EQ(hostSet().healthy_hosts_[1], lb_.chooseHost(nullptr));
-
-  EXPECT_CALL(random_, random()).WillOnce(Return(2)).WillOnce(Return(2));
+  hostSet().healthy_hosts_[1]->stats().rq_active_.set(4);
+  EXPECT_CALL(random_, random()).WillOnce(Return(1)).WillOnce(Return(0));
   EXPECT_EQ(hostSet().healthy_hosts_[0], lb_.chooseHost(nullptr));
 }
 
-TEST_P(LeastRequestLoadBalancerTest, WeightImbalanceCallbacks) {
-  hostSet().healthy_hosts_ = {makeTestHost(info_, "tcp://127.0.0.1:80", 1),
-                              makeTestHost(info_, "tcp://127.0.0.1:81", 3)};
-  stats_.max_host_weight_.set(3UL);
+TEST_P(LeastRequestLoadBalancerTest, Latency) {
+  ON_CALL(runtime_.snapshot_, getInteger("upstream.least_request.latency_enabled", 0))
+      .WillByDefault(Return(1));
 
+  hostSet().healthy_hosts_ = {makeTestHost(info_, "tcp://127.0.0.1:80"),
+                              makeTestHost(info_, "tcp://127.0.0.1:81")};
+  stats_.max_host_weight_.set(1UL);
   hostSet().hosts_ = hostSet().healthy_hosts_;
   hostSet().runCallbacks({}, {}); // Trigger callbacks. The added/removed lists are not relevant.
 
-  EXPECT_CALL(random_, random()).WillOnce(Return(1));
-  EXPECT_EQ(hostSet().healthy_hosts_[1], lb_.chooseHost(nullptr));
-
-  // Same host stays as we have to hit it 3 times, but we remove it and fire callback.
-  std::vector<HostSharedPtr> empty;
-  std::vector<HostSharedPtr> hosts_removed;
-  hosts_removed.push_back(hostSet().hosts_[1]);
-  hostSet().hosts_.erase(hostSet().hosts_.begin() + 1);
-  hostSet().healthy_hosts_.erase(hostSet().healthy_hosts_.begin() + 1);
-  hostSet().runCallbacks(empty, hosts_removed);
-
-  EXPECT_CALL(random_, random()).WillOnce(Return(1));
+  // The slow host loses even with fewer active requests.
+  hostSet().healthy_hosts_[0]->stats().rq_active_.set(3);
+  hostSet().healthy_hosts_[0]->stats().rq_latency_ewma_us_.set(999);
+  hostSet().healthy_hosts_[1]->stats().rq_active_.set(1);
+  hostSet().healthy_hosts_[1]->stats().rq_latency_ewma_us_.set(9999);
+  EXPECT_CALL(random_, random()).WillOnce(Return(0)).WillOnce(Return(1));
   EXPECT_EQ(hostSet().healthy_hosts_[0], lb_.chooseHost(nullptr));
+
+  // A host without a response time yet is preferred.
+  hostSet().healthy_hosts_[1]->stats().rq_latency_ewma_us_.set(0);
+  EXPECT_CALL(random_, random()).WillOnce(Return(0)).WillOnce(Return(1));
+  EXPECT_EQ(hostSet().healthy_hosts_[1], lb_.chooseHost(nullptr));
 }
 
 INSTANTIATE_TEST_CASE_P(PrimaryOrFailover, LeastRequestLoadBalancerTest,
@@ -0,0 +1,133 @@
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "common/runtime/runtime_impl.h"
+#include "common/stats/stats_impl.h"
+#include "common/upstream/load_balancer_impl.h"
+#include "common/upstream/maglev_lb.h"
+#include "common/upstream/ring_hash_lb.h"
+#include "common/upstream/upstream_impl.h"
+
+#include "test/common/upstream/utility.h"
+#include "test/mocks/runtime/mocks.h"
+#include "test/mocks/upstream/mocks.h"
+
+#include "benchmark/benchmark.h"
+#include "fmt/format.h"
+#include "gmock/gmock.h"
+
+using testing::NiceMock;
+
+namespace Envoy {
+namespace Upstream {
+
+class HashKeyLoadBalancerContext : public LoadBalancerContext {
+public:
+  // Upstream::LoadBalancerContext
+  Optional<uint64_t> computeHashKey() override { return hash_key_; }
+  const Router::MetadataMatchCriteria* metadataMatchCriteria() const override { return nullptr; }
+  const Network::Connection* downstreamConnection() const override { return nullptr; }
+
+  Optional<uint64_t> hash_key_;
+};
+
+/**
+ * Holds a single priority cluster with the given number of healthy hosts.
+ */
+class LoadBalancerPerf {
+public:
+  LoadBalancerPerf(uint64_t num_hosts) : stats_(ClusterInfoImpl::generateStats(stats_store_)) {
+    for (uint64_t i = 0; i < num_hosts; i++) {
+      host_set_.hosts_.push_back(
+          makeTestHost(info_, fmt::format("tcp://10.0.{}.{}:6379", i / 256, i % 256)));
+    }
+    host_set_.healthy_hosts_ = host_set_.hosts_;
+    host_set_.runCallbacks({}, {});
+  }
+
+  void chooseHosts(benchmark::State& state, LoadBalancer& lb, LoadBalancerContext* context) {
+    while (state.KeepRunning()) {
+      benchmark::DoNotOptimize(lb.chooseHost(context));
+    }
+  }
+
+  NiceMock<MockPrioritySet> priority_set_;
+  MockHostSet& host_set_ = *priority_set_.getMockHostSet(0);
+  std::shared_ptr<MockClusterInfo> info_{new NiceMock<MockClusterInfo>()};
+  Stats::IsolatedStoreImpl stats_store_;
+  ClusterStats stats_;
+  NiceMock<Runtime::MockLoader> runtime_;
+  Runtime::RandomGeneratorImpl random_;
+};
+
+static void RoundRobinLoadBalancerChooseHost(benchmark::State& state) {
+  LoadBalancerPerf perf(state.range(0));
+  RoundRobinLoadBalancer lb(perf.priority_set_, nullptr, perf.stats_, perf.runtime_, perf.random_);
+  perf.chooseHosts(state, lb, nullptr);
+}
+BENCHMARK(RoundRobinLoadBalancerChooseHost)->Arg(10)->Arg(100)->Arg(1000);
+
+static void LeastRequestLoadBalancerChooseHost(benchmark::State& state) {
+  LoadBalancerPerf perf(state.range(0));
+  LeastRequestLoadBalancer lb(perf.priority_set_, nullptr, perf.stats_, perf.runtime_,
+                              perf.random_);
+  perf.chooseHosts(state, lb, nullptr);
+}
+BENCHMARK(LeastRequestLoadBalancerChooseHost)->Arg(10)->Arg(100)->Arg(1000);
+
+static void RandomLoadBalancerChooseHost(benchmark::State& state) {
+  LoadBalancerPerf perf(state.range(0));
+  RandomLoadBalancer lb(perf.priority_set_, nullptr, perf.stats_, perf.runtime_, perf.random_);
+  perf.chooseHosts(state, lb, nullptr);
+}
+BENCHMARK(RandomLoadBalancerChooseHost)->Arg(10)->Arg(100)->Arg(1000);
+
+static void RingHashLoadBalancerChooseHost(benchmark::State& state) {
+  LoadBalancerPerf perf(state.range(0));
+  RingHashLoadBalancer lb(perf.priority_set_, perf.stats_, perf.runtime_, perf.random_,
+                          Optional<envoy::api::v2::Cluster::RingHashLbConfig>());
+  HashKeyLoadBalancerContext context;
+  uint64_t hash_key = 0;
+  while (state.KeepRunning()) {
+    context.hash_key_.value(hash_key++);
+    benchmark::DoNotOptimize(lb.chooseHost(&context));
+  }
+}
+BENCHMARK(RingHashLoadBalancerChooseHost)->Arg(10)->Arg(100)->Arg(1000);
+
+// Ring construction cost, which is paid on every host set membership change.
+static void RingHashLoadBalancerBuildRing(benchmark::State& state) {
+  LoadBalancerPerf perf(state.range(0));
+  while (state.KeepRunning()) {
+    RingHashLoadBalancer lb(perf.priority_set_, perf.stats_, perf.runtime_, perf.random_,
+                            Optional<envoy::api::v2::Cluster::RingHashLbConfig>());
+    benchmark::DoNotOptimize(&lb);
+  }
+}
+BENCHMARK(RingHashLoadBalancerBuildRing)->Arg(10)->Arg(100)->Arg(1000);
+
+static void MaglevLoadBalancerChooseHost(benchmark::State& state) {
+  LoadBalancerPerf perf(state.range(0));
+  MaglevLoadBalancer lb(perf.priority_set_, perf.stats_, perf.runtime_, perf.random_);
+  HashKeyLoadBalancerContext context;
+  uint64_t hash_key = 0;
+  while (state.KeepRunning()) {
+    context.hash_key_.value(hash_key++);
+    benchmark::DoNotOptimize(lb.chooseHost(&context));
+  }
+}
+BENCHMARK(MaglevLoadBalancerChooseHost)->Arg(10)->Arg(100)->Arg(1000);
+
+// Table construction cost, which is paid on every host set membership change.
+static void MaglevLoadBalancerBuildTable(benchmark::State& state) {
+  LoadBalancerPerf perf(state.range(0));
+  while (state.KeepRunning()) {
+    MaglevLoadBalancer lb(perf.priority_set_, perf.stats_, perf.runtime_, perf.random_);
+    benchmark::DoNotOptimize(&lb);
+  }
+}
+BENCHMARK(MaglevLoadBalancerBuildTable)->Arg(10)->Arg(100)->Arg(1000);
+
+} // namespace Upstream
+} // namespace Envoy
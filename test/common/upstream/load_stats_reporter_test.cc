@@ -101,5 +101,23 @@ TEST_F(LoadStatsReporterTest, RemoteStreamClose) {
   retry_timer_cb_();
 }
 
+// Validate that a report is deferred while the stream is backed up, and sent once it drains.
+TEST_F(LoadStatsReporterTest, DeferReportWhileBackedUp) {
+  EXPECT_CALL(*async_client_, start(_, _)).WillOnce(Return(&async_stream_));
+  expectSendMessage({});
+  createLoadStatsReporter();
+  deliverLoadStatsResponse({});
+
+  EXPECT_CALL(async_stream_, isAboveWriteBufferHighWatermark()).WillOnce(Return(true));
+  EXPECT_CALL(async_stream_, sendMessage(_, _)).Times(0);
+  EXPECT_CALL(*response_timer_, enableTimer(std::chrono::milliseconds(5000)));
+  response_timer_cb_();
+  EXPECT_EQ(1UL, stats_store_.counter("load_reporter.deferred").value());
+
+  EXPECT_CALL(async_stream_, isAboveWriteBufferHighWatermark()).WillOnce(Return(false));
+  expectSendMessage({});
+  response_timer_cb_();
+}
+
 } // namespace Upstream
 } // namespace Envoy
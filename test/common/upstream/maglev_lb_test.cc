@@ -0,0 +1,168 @@
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "envoy/router/router.h"
+
+#include "common/network/utility.h"
+#include "common/upstream/maglev_lb.h"
+#include "common/upstream/upstream_impl.h"
+
+#include "test/common/upstream/utility.h"
+#include "test/mocks/runtime/mocks.h"
+#include "test/mocks/upstream/mocks.h"
+
+#include "fmt/format.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::NiceMock;
+using testing::Return;
+
+namespace Envoy {
+namespace Upstream {
+
+class TestLoadBalancerContext : public LoadBalancerContext {
+public:
+  TestLoadBalancerContext(uint64_t hash_key) : hash_key_(hash_key) {}
+
+  // Upstream::LoadBalancerContext
+  Optional<uint64_t> computeHashKey() override { return hash_key_; }
+  const Router::MetadataMatchCriteria* metadataMatchCriteria() const override { return nullptr; }
+  const Network::Connection* downstreamConnection() const override { return nullptr; }
+
+  Optional<uint64_t> hash_key_;
+};
+
+class MaglevLoadBalancerTest : public testing::Test {
+public:
+  MaglevLoadBalancerTest() : stats_(ClusterInfoImpl::generateStats(stats_store_)) {}
+
+  void init(uint64_t table_size) {
+    lb_.reset(new MaglevLoadBalancer(priority_set_, stats_, runtime_, random_, table_size));
+  }
+
+  NiceMock<MockPrioritySet> priority_set_;
+  MockHostSet& host_set_ = *priority_set_.getMockHostSet(0);
+  std::shared_ptr<MockClusterInfo> info_{new NiceMock<MockClusterInfo>()};
+  Stats::IsolatedStoreImpl stats_store_;
+  ClusterStats stats_;
+  NiceMock<Runtime::MockLoader> runtime_;
+  NiceMock<Runtime::MockRandomGenerator> random_;
+  std::unique_ptr<MaglevLoadBalancer> lb_;
+};
+
+TEST_F(MaglevLoadBalancerTest, NoHost) {
+  init(7);
+  EXPECT_EQ(nullptr, lb_->chooseHost(nullptr));
+};
+
+TEST_F(MaglevLoadBalancerTest, Basic) {
+  host_set_.hosts_ = {
+      makeTestHost(info_, "tcp://127.0.0.1:90"), makeTestHost(info_, "tcp://127.0.0.1:91"),
+      makeTestHost(info_, "tcp://127.0.0.1:92"), makeTestHost(info_, "tcp://127.0.0.1:93"),
+      makeTestHost(info_, "tcp://127.0.0.1:94"), makeTestHost(info_, "tcp://127.0.0.1:95")};
+  host_set_.healthy_hosts_ = host_set_.hosts_;
+  host_set_.runCallbacks({}, {});
+  init(7);
+
+  // maglev table:
+  // slot | port
+  // ------------
+  // 0    | :92
+  // 1    | :94
+  // 2    | :90
+  // 3    | :91
+  // 4    | :90
+  // 5    | :93
+  // 6    | :95
+  const std::vector<uint32_t> expected{2, 4, 0, 1, 0, 3, 5};
+  for (uint64_t hash = 0; hash < 14; hash++) {
+    TestLoadBalancerContext context(hash);
+    EXPECT_EQ(host_set_.hosts_[expected[hash % 7]], lb_->chooseHost(&context));
+  }
+  {
+    EXPECT_CALL(random_, random()).WillOnce(Return(10));
+    EXPECT_EQ(host_set_.hosts_[1], lb_->chooseHost(nullptr));
+  }
+  EXPECT_EQ(0UL, stats_.lb_healthy_panic_.value());
+
+  host_set_.healthy_hosts_.clear();
+  host_set_.runCallbacks({}, {});
+  {
+    TestLoadBalancerContext context(0);
+    EXPECT_EQ(host_set_.hosts_[2], lb_->chooseHost(&context));
+  }
+  EXPECT_EQ(1UL, stats_.lb_healthy_panic_.value());
+}
+
+// With bounded loads, a host at its share of the active requests is passed over for the host of
+// the next slot.
+TEST_F(MaglevLoadBalancerTest, BoundedLoads) {
+  host_set_.hosts_ = {
+      makeTestHost(info_, "tcp://127.0.0.1:90"), makeTestHost(info_, "tcp://127.0.0.1:91"),
+      makeTestHost(info_, "tcp://127.0.0.1:92"), makeTestHost(info_, "tcp://127.0.0.1:93"),
+      makeTestHost(info_, "tcp://127.0.0.1:94"), makeTestHost(info_, "tcp://127.0.0.1:95")};
+  host_set_.healthy_hosts_ = host_set_.hosts_;
+  host_set_.runCallbacks({}, {});
+  init(7);
+
+  // 6 active requests including the new one, with a factor of 150%, allow 2 per host. Slots 0, 1
+  // and 2 belong to :92, :94 and :90, see Basic.
+  EXPECT_CALL(runtime_.snapshot_, getInteger("upstream.consistent_hash_balance_factor", 0))
+      .WillRepeatedly(Return(150));
+  stats_.upstream_rq_active_.set(5);
+  TestLoadBalancerContext context(0);
+  EXPECT_EQ(host_set_.hosts_[2], lb_->chooseHost(&context));
+  host_set_.hosts_[2]->stats().rq_active_.set(2);
+  EXPECT_EQ(host_set_.hosts_[4], lb_->chooseHost(&context));
+  host_set_.hosts_[4]->stats().rq_active_.set(2);
+  EXPECT_EQ(host_set_.hosts_[0], lb_->chooseHost(&context));
+
+  // More active requests in the cluster raise the bound.
+  stats_.upstream_rq_active_.set(11);
+  EXPECT_EQ(host_set_.hosts_[2], lb_->chooseHost(&context));
+}
+
+// Hosts get an even share of the table, and removing a host moves few of the other hosts' keys.
+TEST_F(MaglevLoadBalancerTest, Disruption) {
+  for (uint32_t i = 0; i < 10; i++) {
+    host_set_.hosts_.push_back(makeTestHost(info_, fmt::format("tcp://127.0.0.1:{}", 90 + i)));
+  }
+  host_set_.healthy_hosts_ = host_set_.hosts_;
+  host_set_.runCallbacks({}, {});
+  init(MaglevLoadBalancer::DefaultTableSize);
+
+  std::vector<HostConstSharedPtr> before;
+  std::map<HostConstSharedPtr, uint64_t> counts;
+  for (uint64_t hash = 0; hash < MaglevLoadBalancer::DefaultTableSize; hash++) {
+    TestLoadBalancerContext context(hash);
+    before.push_back(lb_->chooseHost(&context));
+    counts[before.back()]++;
+  }
+  EXPECT_EQ(10U, counts.size());
+  for (const auto& count : counts) {
+    EXPECT_GE(count.second, 6553U);
+    EXPECT_LE(count.second, 6554U);
+  }
+
+  const HostSharedPtr removed = host_set_.hosts_.back();
+  host_set_.hosts_.pop_back();
+  host_set_.healthy_hosts_ = host_set_.hosts_;
+  host_set_.runCallbacks({}, {removed});
+
+  uint64_t moved = 0;
+  for (uint64_t hash = 0; hash < MaglevLoadBalancer::DefaultTableSize; hash++) {
+    TestLoadBalancerContext context(hash);
+    HostConstSharedPtr host = lb_->chooseHost(&context);
+    EXPECT_NE(removed, host);
+    if (before[hash] != removed && before[hash] != host) {
+      moved++;
+    }
+  }
+  EXPECT_LT(moved, MaglevLoadBalancer::DefaultTableSize / 100);
+}
+
+} // namespace Upstream
+} // namespace Envoy
@@ -46,10 +46,13 @@ public:
 
 class OriginalDstClusterTest : public testing::Test {
 public:
-  // cleanup timer must be created before the cluster (in setup()), so that we can set expectations
-  // on it. Ownership is transferred to the cluster at the cluster constructor, so the cluster will
-  // take care of destructing it!
-  OriginalDstClusterTest() : cleanup_timer_(new Event::MockTimer(&dispatcher_)) {}
+  // Timers must be created before the cluster (in setup()), so that we can set expectations on
+  // them. Ownership is transferred to the cluster at the cluster constructor, so the cluster will
+  // take care of destructing them! The cluster creates the cleanup timer first, and the most
+  // recently created mock timer is returned first.
+  OriginalDstClusterTest()
+      : add_hosts_timer_(new Event::MockTimer(&dispatcher_)),
+        cleanup_timer_(new Event::MockTimer(&dispatcher_)) {}
 
   void setup(const std::string& json) {
     NiceMock<MockClusterManager> cm;
@@ -68,6 +71,7 @@ public:
   ReadyWatcher initialized_;
   NiceMock<Runtime::MockLoader> runtime_;
   NiceMock<Event::MockDispatcher> dispatcher_;
+  Event::MockTimer* add_hosts_timer_;
   Event::MockTimer* cleanup_timer_;
 };
 
@@ -211,7 +215,9 @@ TEST_F(OriginalDstClusterTest, Membership) {
   Event::PostCb post_cb;
   EXPECT_CALL(dispatcher_, post(_)).WillOnce(SaveArg<0>(&post_cb));
   HostConstSharedPtr host = lb.chooseHost(&lb_context);
+  EXPECT_CALL(*add_hosts_timer_, enableTimer(std::chrono::milliseconds(0)));
   post_cb();
+  add_hosts_timer_->callback_();
   auto cluster_hosts = cluster_->prioritySet().hostSetsPerPriority()[0]->hosts();
 
   ASSERT_NE(host, nullptr);
@@ -257,7 +263,9 @@ TEST_F(OriginalDstClusterTest, Membership) {
   EXPECT_CALL(membership_updated_, ready());
   EXPECT_CALL(dispatcher_, post(_)).WillOnce(SaveArg<0>(&post_cb));
   HostConstSharedPtr host3 = lb.chooseHost(&lb_context);
+  EXPECT_CALL(*add_hosts_timer_, enableTimer(std::chrono::milliseconds(0)));
   post_cb();
+  add_hosts_timer_->callback_();
   EXPECT_NE(host3, nullptr);
   EXPECT_NE(host3, host);
   EXPECT_NE(cluster_hosts,
@@ -305,14 +313,18 @@ TEST_F(OriginalDstClusterTest, Membership2) {
   Event::PostCb post_cb;
   EXPECT_CALL(dispatcher_, post(_)).WillOnce(SaveArg<0>(&post_cb));
   HostConstSharedPtr host1 = lb.chooseHost(&lb_context1);
+  EXPECT_CALL(*add_hosts_timer_, enableTimer(std::chrono::milliseconds(0)));
   post_cb();
+  add_hosts_timer_->callback_();
   ASSERT_NE(host1, nullptr);
   EXPECT_EQ(*connection1.local_address_, *host1->address());
 
   EXPECT_CALL(membership_updated_, ready());
   EXPECT_CALL(dispatcher_, post(_)).WillOnce(SaveArg<0>(&post_cb));
   HostConstSharedPtr host2 = lb.chooseHost(&lb_context2);
+  EXPECT_CALL(*add_hosts_timer_, enableTimer(std::chrono::milliseconds(0)));
   post_cb();
+  add_hosts_timer_->callback_();
   ASSERT_NE(host2, nullptr);
   EXPECT_EQ(*connection2.local_address_, *host2->address());
 
@@ -356,6 +368,60 @@ TEST_F(OriginalDstClusterTest, Membership2) {
   EXPECT_EQ(0UL, cluster_->prioritySet().hostSetsPerPriority()[0]->hosts().size());
 }
 
+TEST_F(OriginalDstClusterTest, BatchedMembership) {
+  std::string json = R"EOF(
+  {
+    "name": "name",
+    "connect_timeout_ms": 1250,
+    "type": "original_dst",
+    "lb_type": "original_dst_lb"
+  }
+  )EOF";
+
+  EXPECT_CALL(initialized_, ready());
+  EXPECT_CALL(*cleanup_timer_, enableTimer(_));
+  setup(json);
+
+  NiceMock<Network::MockConnection> connection1;
+  TestLoadBalancerContext lb_context1(&connection1);
+  connection1.local_address_ = std::make_shared<Network::Address::Ipv4Instance>("10.10.11.11");
+  EXPECT_CALL(connection1, usingOriginalDst()).WillRepeatedly(Return(true));
+
+  NiceMock<Network::MockConnection> connection2;
+  TestLoadBalancerContext lb_context2(&connection2);
+  connection2.local_address_ = std::make_shared<Network::Address::Ipv6Instance>("FD00::1", 80);
+  EXPECT_CALL(connection2, usingOriginalDst()).WillRepeatedly(Return(true));
+
+  OriginalDstCluster::LoadBalancer lb(cluster_->prioritySet(), cluster_);
+
+  Event::PostCb post_cb1;
+  Event::PostCb post_cb2;
+  EXPECT_CALL(dispatcher_, post(_))
+      .WillOnce(SaveArg<0>(&post_cb1))
+      .WillOnce(SaveArg<0>(&post_cb2));
+  HostConstSharedPtr host1 = lb.chooseHost(&lb_context1);
+  HostConstSharedPtr host2 = lb.chooseHost(&lb_context2);
+  ASSERT_NE(host1, nullptr);
+  ASSERT_NE(host2, nullptr);
+  EXPECT_NE(host1, host2);
+
+  // Both hosts are found in the thread local map before they are added to the host set.
+  EXPECT_EQ(host1, lb.chooseHost(&lb_context1));
+  EXPECT_EQ(host2, lb.chooseHost(&lb_context2));
+
+  // The timer is only armed once, and both hosts are added in a single update.
+  EXPECT_CALL(*add_hosts_timer_, enableTimer(std::chrono::milliseconds(0)));
+  post_cb1();
+  post_cb2();
+  EXPECT_EQ(0UL, cluster_->prioritySet().hostSetsPerPriority()[0]->hosts().size());
+
+  EXPECT_CALL(membership_updated_, ready());
+  add_hosts_timer_->callback_();
+  ASSERT_EQ(2UL, cluster_->prioritySet().hostSetsPerPriority()[0]->hosts().size());
+  EXPECT_EQ(host1, cluster_->prioritySet().hostSetsPerPriority()[0]->hosts()[0]);
+  EXPECT_EQ(host2, cluster_->prioritySet().hostSetsPerPriority()[0]->hosts()[1]);
+}
+
 TEST_F(OriginalDstClusterTest, Connection) {
   std::string json = R"EOF(
   {
@@ -388,7 +454,9 @@ TEST_F(OriginalDstClusterTest, Connection) {
   Event::PostCb post_cb;
   EXPECT_CALL(dispatcher_, post(_)).WillOnce(SaveArg<0>(&post_cb));
   HostConstSharedPtr host = lb.chooseHost(&lb_context);
+  EXPECT_CALL(*add_hosts_timer_, enableTimer(std::chrono::milliseconds(0)));
   post_cb();
+  add_hosts_timer_->callback_();
   ASSERT_NE(host, nullptr);
   EXPECT_EQ(*connection.local_address_, *host->address());
 
@@ -438,7 +506,9 @@ TEST_F(OriginalDstClusterTest, MultipleClusters) {
   Event::PostCb post_cb;
   EXPECT_CALL(dispatcher_, post(_)).WillOnce(SaveArg<0>(&post_cb));
   HostConstSharedPtr host = lb1.chooseHost(&lb_context);
+  EXPECT_CALL(*add_hosts_timer_, enableTimer(std::chrono::milliseconds(0)));
   post_cb();
+  add_hosts_timer_->callback_();
   ASSERT_NE(host, nullptr);
   EXPECT_EQ(*connection.local_address_, *host->address());
 
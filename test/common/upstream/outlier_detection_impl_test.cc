@@ -1,5 +1,6 @@
 #include <chrono>
 #include <cstdint>
+#include <limits>
 #include <memory>
 #include <string>
 #include <vector>
@@ -535,6 +536,76 @@ TEST_F(OutlierDetectorImplTest, BasicFlowSuccessRate) {
   EXPECT_EQ(-1, detector->successRateEjectionThreshold());
 }
 
+TEST_F(OutlierDetectorImplTest, BasicFlowLatency) {
+  EXPECT_CALL(cluster_.prioritySet(), addMemberUpdateCb(_));
+  addHosts({
+      "tcp://127.0.0.1:80",
+      "tcp://127.0.0.1:81",
+      "tcp://127.0.0.1:82",
+      "tcp://127.0.0.1:83",
+      "tcp://127.0.0.1:84",
+  });
+
+  ON_CALL(runtime_.snapshot_, getInteger("outlier_detection.latency_enabled", 0))
+      .WillByDefault(Return(1));
+  ON_CALL(runtime_.snapshot_, featureEnabled("outlier_detection.enforcing_latency", 100))
+      .WillByDefault(Return(true));
+  EXPECT_CALL(*interval_timer_, enableTimer(std::chrono::milliseconds(10000)));
+  std::shared_ptr<DetectorImpl> detector(DetectorImpl::create(
+      cluster_, empty_outlier_detection_, dispatcher_, runtime_, time_source_, event_logger_));
+  detector->addChangedStateCb([&](HostSharedPtr host) -> void { checker_.check(host); });
+
+  // Four hosts answer in 10ms and one answers successfully, but in 200ms.
+  for (uint64_t i = 0; i < hosts_.size(); i++) {
+    for (int j = 0; j < 100; j++) {
+      hosts_[i]->outlierDetector().putResponseTime(std::chrono::milliseconds(i == 4 ? 200 : 10));
+    }
+  }
+
+  EXPECT_CALL(time_source_, currentTime())
+      .Times(2)
+      .WillRepeatedly(Return(MonotonicTime(std::chrono::milliseconds(10000))));
+  EXPECT_CALL(checker_, check(hosts_[4]));
+  EXPECT_CALL(*event_logger_, logEject(std::static_pointer_cast<const HostDescription>(hosts_[4]),
+                                       _, EjectionType::Latency, true));
+  EXPECT_CALL(*interval_timer_, enableTimer(std::chrono::milliseconds(10000)));
+  interval_timer_->callback_();
+  EXPECT_TRUE(hosts_[4]->healthFlagGet(Host::HealthFlag::FAILED_OUTLIER_CHECK));
+  EXPECT_EQ(1UL, cluster_.info_->stats_store_.gauge("outlier_detection.ejections_active").value());
+  EXPECT_EQ(1UL,
+            cluster_.info_->stats_store_.counter("outlier_detection.ejections_detected_latency")
+                .value());
+  EXPECT_EQ(1UL,
+            cluster_.info_->stats_store_.counter("outlier_detection.ejections_enforced_latency")
+                .value());
+
+  // With the slow host ejected, too few hosts are left to compare. Should not cause an ejection.
+  for (uint64_t i = 0; i < 4; i++) {
+    for (int j = 0; j < 100; j++) {
+      hosts_[i]->outlierDetector().putResponseTime(std::chrono::milliseconds(i == 3 ? 200 : 10));
+    }
+  }
+
+  EXPECT_CALL(time_source_, currentTime())
+      .WillOnce(Return(MonotonicTime(std::chrono::milliseconds(19999))));
+  EXPECT_CALL(*interval_timer_, enableTimer(std::chrono::milliseconds(10000)));
+  interval_timer_->callback_();
+  EXPECT_FALSE(hosts_[3]->healthFlagGet(Host::HealthFlag::FAILED_OUTLIER_CHECK));
+  EXPECT_EQ(1UL, cluster_.info_->stats_store_.gauge("outlier_detection.ejections_active").value());
+}
+
+TEST_F(OutlierDetectorImplTest, LatencyDisabled) {
+  EXPECT_CALL(cluster_.prioritySet(), addMemberUpdateCb(_));
+  addHosts({"tcp://127.0.0.1:80"});
+  EXPECT_CALL(*interval_timer_, enableTimer(std::chrono::milliseconds(10000)));
+  std::shared_ptr<DetectorImpl> detector(DetectorImpl::create(
+      cluster_, empty_outlier_detection_, dispatcher_, runtime_, time_source_, event_logger_));
+
+  EXPECT_FALSE(detector->latencyDetectionEnabled());
+  // Response times are dropped without a histogram to record them in.
+  hosts_[0]->outlierDetector().putResponseTime(std::chrono::milliseconds(10));
+}
+
 TEST_F(OutlierDetectorImplTest, RemoveWhileEjected) {
   EXPECT_CALL(cluster_.prioritySet(), addMemberUpdateCb(_));
   addHosts({"tcp://127.0.0.1:80"});
@@ -822,6 +893,39 @@ TEST(OutlierUtility, SRThreshold) {
   EXPECT_EQ(90.0, ejection_pair.success_rate_average_);
 }
 
+TEST(OutlierLatencyAccumulator, Buckets) {
+  EXPECT_EQ(0UL, LatencyAccumulatorBucket::bucketIndex(0));
+  EXPECT_EQ(3UL, LatencyAccumulatorBucket::bucketIndex(3));
+  EXPECT_EQ(4UL, LatencyAccumulatorBucket::bucketIndex(4));
+  EXPECT_EQ(9UL, LatencyAccumulatorBucket::bucketIndex(10));
+  EXPECT_EQ(11UL, LatencyAccumulatorBucket::bucketUpperBound(9));
+  EXPECT_EQ(26UL, LatencyAccumulatorBucket::bucketIndex(200));
+  EXPECT_EQ(223UL, LatencyAccumulatorBucket::bucketUpperBound(26));
+  EXPECT_EQ(LatencyAccumulatorBucket::NUM_BUCKETS - 1,
+            LatencyAccumulatorBucket::bucketIndex(std::numeric_limits<uint64_t>::max()));
+}
+
+TEST(OutlierLatencyAccumulator, Percentile) {
+  LatencyAccumulator accumulator;
+  LatencyAccumulatorBucket* bucket = accumulator.updateCurrentWriter();
+  for (uint64_t i = 0; i < 100; i++) {
+    bucket->counters_[LatencyAccumulatorBucket::bucketIndex(i < 90 ? 1 : 100)]++;
+  }
+
+  // The writes are only read after the next swap.
+  EXPECT_FALSE(accumulator.getPercentile(1, 50).valid());
+  accumulator.updateCurrentWriter();
+  EXPECT_FALSE(accumulator.getPercentile(101, 50).valid());
+  EXPECT_EQ(1UL, accumulator.getPercentile(100, 50).value());
+  EXPECT_EQ(1UL, accumulator.getPercentile(100, 90).value());
+  EXPECT_EQ(111UL, accumulator.getPercentile(100, 91).value());
+  EXPECT_EQ(111UL, accumulator.getPercentile(100, 100).value());
+
+  // The swap after that starts over.
+  accumulator.updateCurrentWriter();
+  EXPECT_FALSE(accumulator.getPercentile(0, 50).valid());
+}
+
 } // namespace Outlier
 } // namespace Upstream
 } // namespace Envoy
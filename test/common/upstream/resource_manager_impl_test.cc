@@ -47,5 +47,41 @@ TEST(ResourceManagerImplTest, RuntimeResourceManager) {
   EXPECT_FALSE(resource_manager.retries().canCreate());
 }
 
+TEST(ResourceManagerImplTest, RetryBudget) {
+  NiceMock<Runtime::MockLoader> runtime;
+  uint64_t active_requests = 0;
+  ResourceManagerImpl resource_manager(runtime, "circuit_breakers.retry_budget_test.default.", 0,
+                                       0, 0, 3, [&active_requests]() { return active_requests; });
+
+  // Without a budget, max_retries applies.
+  active_requests = 100;
+  EXPECT_EQ(3U, resource_manager.retries().max());
+
+  ON_CALL(runtime.snapshot_,
+          getInteger("circuit_breakers.retry_budget_test.default.retry_budget.budget_percent", 0))
+      .WillByDefault(Return(20U));
+  EXPECT_EQ(20U, resource_manager.retries().max());
+
+  // max_retries is the default floor.
+  active_requests = 10;
+  EXPECT_EQ(3U, resource_manager.retries().max());
+
+  ON_CALL(runtime.snapshot_,
+          getInteger(
+              "circuit_breakers.retry_budget_test.default.retry_budget.min_retry_concurrency", 3))
+      .WillByDefault(Return(1U));
+  EXPECT_EQ(2U, resource_manager.retries().max());
+  EXPECT_TRUE(resource_manager.retries().canCreate());
+  resource_manager.retries().inc();
+  resource_manager.retries().inc();
+  EXPECT_FALSE(resource_manager.retries().canCreate());
+
+  // The budget grows with the number of requests.
+  active_requests = 15;
+  EXPECT_TRUE(resource_manager.retries().canCreate());
+  resource_manager.retries().dec();
+  resource_manager.retries().dec();
+}
+
 } // namespace Upstream
 } // namespace Envoy
@@ -1,5 +1,6 @@
 #include <cstdint>
 #include <string>
+#include <vector>
 
 #include "envoy/router/router.h"
 
@@ -213,6 +214,142 @@ TEST_F(RingHashLoadBalancerTest, UnevenHosts) {
   }
 }
 
+// Adding and removing hosts without changing the number of entries per host updates the ring in
+// place, which must give the same ring as building it from scratch.
+TEST_F(RingHashLoadBalancerTest, IncrementalUpdate) {
+  for (uint32_t i = 0; i < 6; i++) {
+    host_set_.hosts_.push_back(makeTestHost(info_, fmt::format("tcp://127.0.0.1:{}", 90 + i)));
+  }
+  host_set_.healthy_hosts_ = host_set_.hosts_;
+  host_set_.runCallbacks({}, {});
+
+  config_.value(envoy::api::v2::Cluster::RingHashLbConfig());
+  config_.value().mutable_minimum_ring_size()->set_value(1);
+  config_.value().mutable_deprecated_v1()->mutable_use_std_hash()->set_value(false);
+  init();
+
+  const HostSharedPtr removed = host_set_.hosts_[2];
+  const HostSharedPtr added = makeTestHost(info_, "tcp://127.0.0.1:96");
+  host_set_.hosts_.erase(host_set_.hosts_.begin() + 2);
+  host_set_.hosts_.push_back(added);
+  host_set_.healthy_hosts_ = host_set_.hosts_;
+  host_set_.runCallbacks({added}, {removed});
+
+  RingHashLoadBalancer fresh_lb(priority_set_, stats_, runtime_, random_, config_);
+  for (uint64_t i = 0; i < 1000; i++) {
+    TestLoadBalancerContext context(i * (std::numeric_limits<uint64_t>::max() / 1000));
+    HostConstSharedPtr host = lb_->chooseHost(&context);
+    EXPECT_NE(removed, host);
+    EXPECT_EQ(fresh_lb.chooseHost(&context), host);
+  }
+}
+
+// A host that becomes unhealthy only gives up its own keys.
+TEST_F(RingHashLoadBalancerTest, UnhealthyHostKeepsOtherKeys) {
+  for (uint32_t i = 0; i < 6; i++) {
+    host_set_.hosts_.push_back(makeTestHost(info_, fmt::format("tcp://127.0.0.1:{}", 90 + i)));
+  }
+  host_set_.healthy_hosts_ = host_set_.hosts_;
+  host_set_.runCallbacks({}, {});
+
+  config_.value(envoy::api::v2::Cluster::RingHashLbConfig());
+  config_.value().mutable_minimum_ring_size()->set_value(60);
+  config_.value().mutable_deprecated_v1()->mutable_use_std_hash()->set_value(false);
+  init();
+
+  std::vector<HostConstSharedPtr> before;
+  for (uint64_t i = 0; i < 1000; i++) {
+    TestLoadBalancerContext context(i * (std::numeric_limits<uint64_t>::max() / 1000));
+    before.push_back(lb_->chooseHost(&context));
+  }
+
+  const HostSharedPtr unhealthy = host_set_.hosts_[1];
+  host_set_.healthy_hosts_.erase(host_set_.healthy_hosts_.begin() + 1);
+  host_set_.runCallbacks({}, {});
+
+  for (uint64_t i = 0; i < 1000; i++) {
+    TestLoadBalancerContext context(i * (std::numeric_limits<uint64_t>::max() / 1000));
+    HostConstSharedPtr host = lb_->chooseHost(&context);
+    EXPECT_NE(unhealthy, host);
+    if (before[i] != unhealthy) {
+      EXPECT_EQ(before[i], host);
+    }
+  }
+  EXPECT_EQ(0UL, stats_.lb_healthy_panic_.value());
+}
+
+// Workers get load balancers that share the ring of the current hosts, and keep using it until
+// they create a new one.
+TEST_F(RingHashLoadBalancerTest, WorkerLoadBalancer) {
+  host_set_.hosts_ = {makeTestHost(info_, "tcp://127.0.0.1:90"),
+                      makeTestHost(info_, "tcp://127.0.0.1:91")};
+  host_set_.healthy_hosts_ = host_set_.hosts_;
+  host_set_.runCallbacks({}, {});
+
+  config_.value(envoy::api::v2::Cluster::RingHashLbConfig());
+  config_.value().mutable_minimum_ring_size()->set_value(12);
+  config_.value().mutable_deprecated_v1()->mutable_use_std_hash()->set_value(false);
+  init();
+
+  LoadBalancerFactorySharedPtr factory = lb_->factory();
+  LoadBalancerPtr worker_lb = factory->create();
+  for (uint64_t i = 0; i < 100; i++) {
+    TestLoadBalancerContext context(i * (std::numeric_limits<uint64_t>::max() / 100));
+    EXPECT_EQ(lb_->chooseHost(&context), worker_lb->chooseHost(&context));
+  }
+
+  const HostSharedPtr removed = host_set_.hosts_[0];
+  host_set_.hosts_.erase(host_set_.hosts_.begin());
+  host_set_.healthy_hosts_ = host_set_.hosts_;
+  host_set_.runCallbacks({}, {removed});
+
+  LoadBalancerPtr new_worker_lb = factory->create();
+  bool old_ring_used = false;
+  for (uint64_t i = 0; i < 100; i++) {
+    TestLoadBalancerContext context(i * (std::numeric_limits<uint64_t>::max() / 100));
+    EXPECT_EQ(host_set_.hosts_[0], new_worker_lb->chooseHost(&context));
+    old_ring_used |= worker_lb->chooseHost(&context) == removed;
+  }
+  EXPECT_TRUE(old_ring_used);
+}
+
+// With bounded loads, a host at its share of the active requests is passed over for the next host
+// on the ring.
+TEST_F(RingHashLoadBalancerTest, BoundedLoads) {
+  host_set_.hosts_ = {
+      makeTestHost(info_, "tcp://127.0.0.1:90"), makeTestHost(info_, "tcp://127.0.0.1:91"),
+      makeTestHost(info_, "tcp://127.0.0.1:92"), makeTestHost(info_, "tcp://127.0.0.1:93"),
+      makeTestHost(info_, "tcp://127.0.0.1:94"), makeTestHost(info_, "tcp://127.0.0.1:95")};
+  host_set_.healthy_hosts_ = host_set_.hosts_;
+  host_set_.runCallbacks({}, {});
+
+  config_.value(envoy::api::v2::Cluster::RingHashLbConfig());
+  config_.value().mutable_minimum_ring_size()->set_value(12);
+  config_.value().mutable_deprecated_v1()->mutable_use_std_hash()->set_value(false);
+  init();
+
+  // 6 active requests including the new one, with a factor of 150%, allow 2 per host. Hash 0 maps
+  // to :94, which is followed by :92 and :90 on the ring, see Basic.
+  stats_.upstream_rq_active_.set(5);
+  host_set_.hosts_[4]->stats().rq_active_.set(2);
+  TestLoadBalancerContext context(0);
+  EXPECT_EQ(host_set_.hosts_[4], lb_->chooseHost(&context));
+
+  EXPECT_CALL(runtime_.snapshot_, getInteger("upstream.consistent_hash_balance_factor", 0))
+      .WillRepeatedly(Return(150));
+  EXPECT_EQ(host_set_.hosts_[2], lb_->chooseHost(&context));
+  host_set_.hosts_[2]->stats().rq_active_.set(3);
+  EXPECT_EQ(host_set_.hosts_[0], lb_->chooseHost(&context));
+  host_set_.hosts_[4]->stats().rq_active_.set(1);
+  EXPECT_EQ(host_set_.hosts_[4], lb_->chooseHost(&context));
+
+  // If every host is loaded, the host for the hash is used.
+  for (const auto& host : host_set_.hosts_) {
+    host->stats().rq_active_.set(2);
+  }
+  EXPECT_EQ(host_set_.hosts_[4], lb_->chooseHost(&context));
+}
+
 /**
  * This test is for simulation only and should not be run as part of unit tests. In order to run the
  * simulation remove the DISABLED_ prefix from the TEST_F invocation. Run bazel with
@@ -525,6 +525,40 @@ TEST_P(SubsetLoadBalancerTest, UpdateRemovingLastSubsetHost) {
   EXPECT_EQ(1U, stats_.lb_subsets_removed_.value());
 }
 
+TEST_P(SubsetLoadBalancerTest, UpdateRefillingEmptiedSubset) {
+  EXPECT_CALL(subset_info_, fallbackPolicy())
+      .WillRepeatedly(Return(envoy::api::v2::Cluster::LbSubsetConfig::NO_FALLBACK));
+
+  std::vector<std::set<std::string>> subset_keys = {{"version"}};
+  EXPECT_CALL(subset_info_, subsetKeys()).WillRepeatedly(ReturnRef(subset_keys));
+
+  init({
+      {"tcp://127.0.0.1:80", {{"version", "1.0"}}},
+      {"tcp://127.0.0.1:81", {{"version", "1.1"}}},
+  });
+
+  TestLoadBalancerContext context({{"version", "1.0"}});
+  EXPECT_EQ(host_set_.hosts_[0], lb_->chooseHost(&context));
+
+  modifyHosts({}, {host_set_.hosts_[0]});
+  EXPECT_EQ(nullptr, lb_->chooseHost(&context));
+  EXPECT_EQ(1U, stats_.lb_subsets_active_.value());
+  EXPECT_EQ(1U, stats_.lb_subsets_removed_.value());
+
+  // The subset's load balancer is created again, with only the new hosts.
+  HostSharedPtr host_a = makeHost("tcp://127.0.0.1:82", {{"version", "1.0"}});
+  HostSharedPtr host_b = makeHost("tcp://127.0.0.1:83", {{"version", "1.0"}});
+  modifyHosts({host_a, host_b}, {});
+  EXPECT_EQ(2U, stats_.lb_subsets_active_.value());
+  EXPECT_EQ(3U, stats_.lb_subsets_created_.value());
+
+  HostConstSharedPtr first = lb_->chooseHost(&context);
+  HostConstSharedPtr second = lb_->chooseHost(&context);
+  EXPECT_TRUE(first == host_a || first == host_b);
+  EXPECT_TRUE(second == host_a || second == host_b);
+  EXPECT_NE(first, second);
+}
+
 TEST_P(SubsetLoadBalancerTest, UpdateRemovingUnknownHost) {
   EXPECT_CALL(subset_info_, fallbackPolicy())
       .WillRepeatedly(Return(envoy::api::v2::Cluster::LbSubsetConfig::NO_FALLBACK));
@@ -1,6 +1,8 @@
 #include <chrono>
 #include <cstdint>
 #include <list>
+#include <map>
+#include <memory>
 #include <string>
 #include <tuple>
 #include <vector>
@@ -28,6 +30,7 @@
 using testing::ContainerEq;
 using testing::Invoke;
 using testing::NiceMock;
+using testing::Return;
 using testing::_;
 
 namespace Envoy {
@@ -238,6 +241,12 @@ TEST(StrictDnsClusterImplTest, Basic) {
 
   EXPECT_CALL(runtime.snapshot_, featureEnabled("upstream.maintenance_mode.name", 0));
   EXPECT_FALSE(cluster.info()->maintenanceMode());
+  EXPECT_CALL(runtime.snapshot_, getInteger("upstream.idle_timeout_ms.name", 0))
+      .WillOnce(Return(30000));
+  EXPECT_EQ(std::chrono::milliseconds(30000), cluster.info()->idleTimeout());
+  EXPECT_CALL(runtime.snapshot_, getInteger("upstream.preconnect_percent.name", 0))
+      .WillOnce(Return(50));
+  EXPECT_EQ(50U, cluster.info()->preconnectPercent());
 
   ReadyWatcher membership_updated;
   cluster.prioritySet().addMemberUpdateCb(
@@ -353,6 +362,44 @@ TEST(HostImplTest, HostnameCanaryAndLocality) {
   EXPECT_EQ("world", host.locality().sub_zone());
 }
 
+TEST(HostImplTest, SharedLocalityAndStats) {
+  MockCluster cluster;
+  envoy::api::v2::Locality locality;
+  locality.set_zone("hello");
+  HostSharedPtr host1(new HostImpl(cluster.info_, "",
+                                   Network::Utility::resolveUrl("tcp://10.0.0.1:1"),
+                                   envoy::api::v2::Metadata::default_instance(), 1, locality));
+  HostSharedPtr host2(new HostImpl(cluster.info_, "",
+                                   Network::Utility::resolveUrl("tcp://10.0.0.1:2"),
+                                   envoy::api::v2::Metadata::default_instance(), 1, locality));
+  EXPECT_EQ(&host1->locality(), &host2->locality());
+  EXPECT_NE(&host1->locality(),
+            &makeTestHost(cluster.info_, "tcp://10.0.0.1:3", 1)->locality());
+
+  host1->stats().rq_total_.inc();
+  host1->stats().cx_active_.inc();
+  std::list<Stats::CounterSharedPtr> counters = host1->counters();
+  std::list<Stats::GaugeSharedPtr> gauges = host1->gauges();
+  std::weak_ptr<Host> weak_host = host1;
+  host1.reset();
+  EXPECT_FALSE(weak_host.expired());
+
+  std::map<std::string, uint64_t> values;
+  for (const Stats::CounterSharedPtr& counter : counters) {
+    values[counter->name()] = counter->value();
+  }
+  for (const Stats::GaugeSharedPtr& gauge : gauges) {
+    values[gauge->name()] = gauge->value();
+  }
+  EXPECT_EQ(1U, values["rq_total"]);
+  EXPECT_EQ(1U, values["cx_active"]);
+  EXPECT_EQ(0U, values["rq_error"]);
+
+  counters.clear();
+  gauges.clear();
+  EXPECT_TRUE(weak_host.expired());
+}
+
 TEST(StaticClusterImplTest, EmptyHostname) {
   Stats::IsolatedStoreImpl stats;
   Ssl::MockContextManager ssl_context_manager;
@@ -377,6 +424,89 @@ TEST(StaticClusterImplTest, EmptyHostname) {
   EXPECT_FALSE(cluster.info()->addedViaApi());
 }
 
+TEST(StaticClusterImplTest, LocalityLoadStats) {
+  Stats::IsolatedStoreImpl stats;
+  Ssl::MockContextManager ssl_context_manager;
+  NiceMock<Runtime::MockLoader> runtime;
+  const std::string json = R"EOF(
+  {
+    "name": "staticcluster",
+    "connect_timeout_ms": 250,
+    "type": "static",
+    "lb_type": "random",
+    "hosts": [{"url": "tcp://10.0.0.1:11001"}, {"url": "tcp://10.0.0.2:11001"}]
+  }
+  )EOF";
+
+  NiceMock<MockClusterManager> cm;
+  StaticClusterImpl cluster(parseClusterFromJson(json), runtime, stats, ssl_context_manager, cm,
+                            false);
+  cluster.initialize([] {});
+
+  const std::vector<HostSharedPtr>& hosts = cluster.prioritySet().hostSetsPerPriority()[0]->hosts();
+  LocalityLoadStats* load_stats = hosts[0]->localityLoadStats();
+  ASSERT_NE(nullptr, load_stats);
+  EXPECT_EQ(load_stats, hosts[1]->localityLoadStats());
+
+  hosts[0]->stats().rq_success_.inc();
+  hosts[1]->stats().rq_success_.add(2);
+  hosts[1]->stats().rq_error_.inc();
+  hosts[0]->stats().rq_active_.inc();
+  hosts[1]->stats().rq_active_.inc();
+  hosts[0]->stats().rq_active_.dec();
+  EXPECT_EQ(3U, load_stats->rq_success_.value());
+  EXPECT_EQ(1U, load_stats->rq_error_.value());
+  EXPECT_EQ(1U, load_stats->rq_active_.value());
+  EXPECT_EQ(1U, hosts[0]->stats().rq_success_.value());
+
+  envoy::api::v2::Locality locality;
+  locality.set_zone("other");
+  EXPECT_NE(load_stats, cluster.info()->localityLoadStats(locality, 0).get());
+  EXPECT_NE(load_stats,
+            cluster.info()->localityLoadStats(envoy::api::v2::Locality(), 1).get());
+}
+
+TEST(StaticClusterImplTest, LazyStats) {
+  Stats::IsolatedStoreImpl stats;
+  Ssl::MockContextManager ssl_context_manager;
+  NiceMock<Runtime::MockLoader> runtime;
+  ON_CALL(runtime.snapshot_, getInteger("upstream.lazy_stats", 0)).WillByDefault(Return(1));
+  const std::string json = R"EOF(
+  {
+    "name": "staticcluster",
+    "connect_timeout_ms": 250,
+    "type": "static",
+    "lb_type": "random",
+    "hosts": [{"url": "tcp://10.0.0.1:11001"}]
+  }
+  )EOF";
+
+  NiceMock<MockClusterManager> cm;
+  StaticClusterImpl cluster(parseClusterFromJson(json), runtime, stats, ssl_context_manager, cm,
+                            false);
+  cluster.initialize([] {});
+
+  const std::string name = "cluster.staticcluster.upstream_rq_total";
+  std::map<std::string, uint64_t> lazy_counters;
+  auto list_lazy_counters = [&]() -> void {
+    lazy_counters.clear();
+    cluster.info()->forEachLazyCounter([&](Stats::Counter& counter) -> void {
+      lazy_counters[counter.name()] = counter.value();
+    });
+  };
+  list_lazy_counters();
+  EXPECT_EQ(nullptr, TestUtility::findCounter(stats, name));
+  EXPECT_EQ(0U, lazy_counters.at(name));
+  EXPECT_EQ(0U, cluster.info()->stats().upstream_rq_total_.value());
+  EXPECT_NE(nullptr, TestUtility::findGauge(stats, "cluster.staticcluster.membership_total"));
+
+  cluster.info()->stats().upstream_rq_total_.inc();
+  list_lazy_counters();
+  EXPECT_EQ(1U, TestUtility::findCounter(stats, name)->value());
+  EXPECT_EQ(0U, lazy_counters.count(name));
+  EXPECT_EQ(1U, cluster.info()->stats().upstream_rq_total_.value());
+}
+
 TEST(StaticClusterImplTest, RingHash) {
   Stats::IsolatedStoreImpl stats;
   Ssl::MockContextManager ssl_context_manager;
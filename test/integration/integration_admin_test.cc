@@ -148,6 +148,22 @@ TEST_P(IntegrationAdminTest, Admin) {
   EXPECT_THAT(
       response->body(),
       testing::HasSubstr("envoy_cluster_upstream_cx_active{envoy_cluster_name=\"cluster_0\"} 0\n"));
+
+  response = IntegrationUtil::makeSingleRequest(lookupPort("admin"), "GET",
+                                                "/stats/prometheus?filter=cluster\\..*", "",
+                                                downstreamProtocol(), version_);
+  EXPECT_TRUE(response->complete());
+  EXPECT_STREQ("200", response->headers().Status()->value().c_str());
+  EXPECT_THAT(
+      response->body(),
+      testing::HasSubstr("envoy_cluster_upstream_cx_active{envoy_cluster_name=\"cluster_0\"} 0\n"));
+  EXPECT_THAT(response->body(), testing::Not(testing::HasSubstr("envoy_http_downstream_rq_xx")));
+
+  response = IntegrationUtil::makeSingleRequest(
+      lookupPort("admin"), "GET", "/stats/prometheus?filter=(", "", downstreamProtocol(), version_);
+  EXPECT_TRUE(response->complete());
+  EXPECT_STREQ("400", response->headers().Status()->value().c_str());
+
   response = IntegrationUtil::makeSingleRequest(lookupPort("admin"), "GET", "/clusters", "",
                                                 downstreamProtocol(), version_);
   EXPECT_TRUE(response->complete());
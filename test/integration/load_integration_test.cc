@@ -0,0 +1,303 @@
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "envoy/common/time.h"
+
+#include "common/common/utility.h"
+#include "common/http/utility.h"
+#include "common/memory/stats.h"
+#include "common/ssl/context_manager_impl.h"
+
+#include "test/integration/http_integration.h"
+#include "test/integration/ssl_utility.h"
+#include "test/mocks/runtime/mocks.h"
+#include "test/test_common/network_utility.h"
+
+#include "fmt/format.h"
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace {
+
+// The load is configured through the environment so that the same target serves as a quick smoke
+// test by default and as a benchmark when run by hand, see README.md. ENVOY_LOAD_TEST_CONNECTIONS
+// sets the number of HTTP/1 connections, which bounds the requests in flight.
+uint64_t loadTestSetting(const char* name, uint64_t default_value) {
+  const char* value = ::getenv(name);
+  uint64_t out;
+  return value != nullptr && StringUtil::atoul(value, out) && out > 0 ? out : default_value;
+}
+
+// The ip version, the downstream protocol, and whether the downstream connections use TLS.
+typedef std::tuple<Network::Address::IpVersion, Http::CodecClient::Type, bool> LoadTestParams;
+
+/**
+ * Open loop load test: requests are sent through Envoy to an autonomous upstream at a fixed rate,
+ * whether or not earlier requests have completed, and their latency is measured from the time
+ * they were due. Requests that are due while all connections are busy wait for one, so a server
+ * that falls behind shows up as latency rather than as a lower request rate.
+ */
+class LoadIntegrationTest : public HttpIntegrationTest,
+                            public testing::TestWithParam<LoadTestParams> {
+public:
+  LoadIntegrationTest()
+      : HttpIntegrationTest(std::get<1>(GetParam()), std::get<0>(GetParam())),
+        qps_(loadTestSetting("ENVOY_LOAD_TEST_QPS", 100)),
+        duration_(loadTestSetting("ENVOY_LOAD_TEST_DURATION_MS", 1000)),
+        connections_(loadTestSetting("ENVOY_LOAD_TEST_CONNECTIONS", 16)) {}
+
+  void initialize() override {
+    autonomous_upstream_ = true;
+    if (downstreamProtocol() == Http::CodecClient::Type::HTTP2) {
+      setUpstreamProtocol(FakeHttpConnection::Type::HTTP2);
+    }
+    if (tls()) {
+      config_helper_.addSslConfig();
+    }
+    HttpIntegrationTest::initialize();
+
+    if (tls()) {
+      runtime_.reset(new testing::NiceMock<Runtime::MockLoader>());
+      context_manager_.reset(new Ssl::ContextManagerImpl(*runtime_));
+      client_ssl_ctx_ = Ssl::createClientSslContext(
+          downstreamProtocol() == Http::CodecClient::Type::HTTP2, false, *context_manager_);
+    }
+  }
+
+  void TearDown() override {
+    for (Client& client : clients_) {
+      client.codec_->close();
+    }
+    clients_.clear();
+    test_server_.reset();
+    fake_upstreams_.clear();
+    client_ssl_ctx_.reset();
+    context_manager_.reset();
+    runtime_.reset();
+  }
+
+protected:
+  struct Client;
+
+  struct Request : public Http::StreamDecoder, public Http::StreamCallbacks {
+    Request(LoadIntegrationTest& parent) : parent_(parent) {}
+
+    void onComplete(bool success) { parent_.onRequestComplete(*this, success); }
+
+    // Http::StreamDecoder
+    void decodeHeaders(Http::HeaderMapPtr&& headers, bool end_stream) override {
+      success_ = Http::Utility::getResponseStatus(*headers) == 200;
+      if (end_stream) {
+        onComplete(success_);
+      }
+    }
+    void decodeData(Buffer::Instance&, bool end_stream) override {
+      if (end_stream) {
+        onComplete(success_);
+      }
+    }
+    void decodeTrailers(Http::HeaderMapPtr&&) override { onComplete(success_); }
+
+    // Http::StreamCallbacks
+    void onResetStream(Http::StreamResetReason) override { onComplete(false); }
+    void onAboveWriteBufferHighWatermark() override {}
+    void onBelowWriteBufferLowWatermark() override {}
+
+    LoadIntegrationTest& parent_;
+    Client* client_{};
+    MonotonicTime due_;
+    bool success_{};
+  };
+
+  typedef std::unique_ptr<Request> RequestPtr;
+
+  struct Client {
+    IntegrationCodecClientPtr codec_;
+    uint32_t active_{};
+  };
+
+  bool tls() const { return std::get<2>(GetParam()); }
+
+  Network::ClientConnectionPtr makeLoadClientConnection() {
+    if (tls()) {
+      return dispatcher_->createSslClientConnection(
+          *client_ssl_ctx_, Ssl::getSslAddress(version_, lookupPort("http")), nullptr);
+    }
+    return makeClientConnection(lookupPort("http"));
+  }
+
+  // HTTP/1 connections carry a single request at a time, while HTTP/2 requests are spread over
+  // the connections as streams.
+  uint32_t maxActivePerClient() const {
+    return downstreamProtocol() == Http::CodecClient::Type::HTTP2 ? 100 : 1;
+  }
+
+  void onRequestComplete(Request& request, bool success) {
+    latencies_us_.push_back(std::chrono::duration_cast<std::chrono::microseconds>(
+                                std::chrono::steady_clock::now() - request.due_)
+                                .count());
+    if (!success) {
+      errors_++;
+    }
+    request.client_->active_--;
+    // The request may still be referenced by the codec until this callback returns, so it is only
+    // reused on the next tick.
+    completed_.push_back(&request);
+  }
+
+  // Send the requests that are due and that a connection is available for.
+  void onTick() {
+    const MonotonicTime now = std::chrono::steady_clock::now();
+    const uint64_t elapsed_ms =
+        std::chrono::duration_cast<std::chrono::milliseconds>(now - start_).count();
+    const uint64_t due = std::min(total_, qps_ * std::min(elapsed_ms, duration_) / 1000);
+    for (; scheduled_ < due; scheduled_++) {
+      // The time the request was due rather than the time it was noticed on this tick.
+      backlog_.push_back(start_ + std::chrono::milliseconds(scheduled_ * 1000 / qps_));
+    }
+
+    for (Request* request : completed_) {
+      free_.push_back(request);
+    }
+    completed_.clear();
+
+    while (!backlog_.empty()) {
+      auto client = std::min_element(
+          clients_.begin(), clients_.end(),
+          [](const Client& lhs, const Client& rhs) { return lhs.active_ < rhs.active_; });
+      if (client->active_ >= maxActivePerClient()) {
+        break;
+      }
+
+      if (free_.empty()) {
+        requests_.emplace_back(new Request(*this));
+        free_.push_back(requests_.back().get());
+      }
+      Request* request = free_.back();
+      free_.pop_back();
+      request->client_ = &*client;
+      request->due_ = backlog_.front();
+      request->success_ = false;
+      backlog_.pop_front();
+      client->active_++;
+
+      Http::StreamEncoder& encoder = client->codec_->newStream(*request);
+      encoder.getStream().addCallbacks(*request);
+      encoder.encodeHeaders(request_headers_, true);
+    }
+
+    if (latencies_us_.size() == total_) {
+      dispatcher_->exit();
+      return;
+    }
+    timer_->enableTimer(std::chrono::milliseconds(1));
+  }
+
+  static uint64_t percentile(const std::vector<uint64_t>& sorted, double quantile) {
+    return sorted.empty() ? 0 : sorted[static_cast<size_t>((sorted.size() - 1) * quantile)];
+  }
+
+  void runLoad(const std::string& name) {
+    initialize();
+    const uint32_t clients =
+        downstreamProtocol() == Http::CodecClient::Type::HTTP2 ? 1 : connections_;
+    for (uint32_t i = 0; i < clients; i++) {
+      clients_.emplace_back();
+      clients_.back().codec_ = makeHttpConnection(makeLoadClientConnection());
+    }
+
+    total_ = qps_ * duration_ / 1000;
+    rusage usage_before;
+    getrusage(RUSAGE_SELF, &usage_before);
+    start_ = std::chrono::steady_clock::now();
+    timer_ = dispatcher_->createTimer([this]() -> void { onTick(); });
+    timer_->enableTimer(std::chrono::milliseconds(0));
+    dispatcher_->run(Event::Dispatcher::RunType::Block);
+    const double elapsed_s =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+    rusage usage_after;
+    getrusage(RUSAGE_SELF, &usage_after);
+    timer_.reset();
+
+    // Envoy runs in this process, so the CPU time and memory include the client and upstream.
+    const auto cpu_s = [](const rusage& usage) -> double {
+      return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+             (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+    };
+    std::vector<uint64_t> sorted(latencies_us_);
+    std::sort(sorted.begin(), sorted.end());
+    std::cout << fmt::format(
+                     "load test {} {} {}{}: {} requests at {} qps, {} errors, {:.0f} requests/s, "
+                     "latency p50 {}us p99 {}us p999 {}us, cpu {:.2f}s, max rss {}kB, heap {}kB",
+                     name, Network::Test::addressVersionAsString(version_),
+                     downstreamProtocol() == Http::CodecClient::Type::HTTP2 ? "http2" : "http1",
+                     tls() ? " tls" : "", latencies_us_.size(), qps_, errors_,
+                     latencies_us_.size() / elapsed_s, percentile(sorted, 0.5),
+                     percentile(sorted, 0.99), percentile(sorted, 0.999),
+                     cpu_s(usage_after) - cpu_s(usage_before), usage_after.ru_maxrss,
+                     Memory::Stats::totalCurrentlyAllocated() / 1024)
+              << std::endl;
+
+    EXPECT_EQ(total_, latencies_us_.size());
+    EXPECT_EQ(0U, errors_);
+  }
+
+  const uint64_t qps_;
+  const uint64_t duration_;
+  const uint64_t connections_;
+  const Http::TestHeaderMapImpl request_headers_{
+      {":method", "GET"}, {":path", "/test/long/url"}, {":scheme", "http"}, {":authority", "host"}};
+
+  std::unique_ptr<Runtime::MockLoader> runtime_;
+  std::unique_ptr<Ssl::ContextManager> context_manager_;
+  Ssl::ClientContextPtr client_ssl_ctx_;
+  std::vector<Client> clients_;
+  std::vector<RequestPtr> requests_;
+  std::vector<Request*> free_;
+  std::vector<Request*> completed_;
+  std::deque<MonotonicTime> backlog_;
+  std::vector<uint64_t> latencies_us_;
+  Event::TimerPtr timer_;
+  MonotonicTime start_;
+  uint64_t total_{};
+  uint64_t scheduled_{};
+  uint64_t errors_{};
+};
+
+INSTANTIATE_TEST_CASE_P(
+    Protocols, LoadIntegrationTest,
+    testing::Combine(testing::ValuesIn(TestEnvironment::getIpVersionsForTest()),
+                     testing::Values(Http::CodecClient::Type::HTTP1,
+                                     Http::CodecClient::Type::HTTP2),
+                     testing::Bool()));
+
+TEST_P(LoadIntegrationTest, Router) { runLoad("router"); }
+
+TEST_P(LoadIntegrationTest, RouterAndLua) {
+  config_helper_.addFilter(R"EOF(
+name: envoy.lua
+config:
+  inline_code: |
+    function envoy_on_request(request_handle)
+      request_handle:headers():add("x-load-test", "request")
+    end
+
+    function envoy_on_response(response_handle)
+      response_handle:headers():add("x-load-test", "response")
+    end
+)EOF");
+  runLoad("router+lua");
+}
+
+} // namespace
+} // namespace Envoy
@@ -47,12 +47,18 @@ public:
   std::chrono::milliseconds fileFlushIntervalMsec() override {
     return std::chrono::milliseconds(50);
   }
+  uint64_t fileWriteBufferBytes() override { return 1024 * 1024; }
   Mode mode() const override { return Mode::Serve; }
   const std::string& serviceClusterName() override { return service_cluster_name_; }
   const std::string& serviceNodeName() override { return service_node_name_; }
   const std::string& serviceZone() override { return service_zone_; }
   uint64_t maxStats() override { return 16384; }
   uint64_t maxObjNameLength() override { return 60; }
+  bool dispatcherStatsEnabled() override { return true; }
+  bool logAsync() override { return false; }
+  bool workerCpuAffinity() override { return false; }
+  uint32_t sslPrivateKeyThreads() override { return 0; }
+  std::chrono::milliseconds dnsCacheTtl() override { return std::chrono::milliseconds(0); }
 
 private:
   const std::string config_path_;
@@ -162,9 +168,24 @@ public:
     std::unique_lock<std::mutex> lock(lock_);
     return store_.gauges();
   }
+  std::list<ParentHistogramSharedPtr> histograms() const override {
+    std::unique_lock<std::mutex> lock(lock_);
+    return store_.histograms();
+  }
+  void forEachCounter(const std::function<void(Counter&)>& cb) const override {
+    std::unique_lock<std::mutex> lock(lock_);
+    store_.forEachCounter(cb);
+  }
+  void forEachGauge(const std::function<void(Gauge&)>& cb) const override {
+    std::unique_lock<std::mutex> lock(lock_);
+    store_.forEachGauge(cb);
+  }
+  void forEachHistogram(const std::function<void(ParentHistogram&)>& cb) const override {
+    std::unique_lock<std::mutex> lock(lock_);
+    store_.forEachHistogram(cb);
+  }
 
   // Stats::StoreRoot
-  void addSink(Sink&) override {}
   void setTagExtractors(const std::vector<TagExtractorPtr>&) override {}
   void initializeThreading(Event::Dispatcher&, ThreadLocal::Instance&) override {}
   void shutdownThreading() override {}
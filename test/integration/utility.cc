@@ -90,7 +90,7 @@ IntegrationUtil::makeSingleRequest(uint32_t port, const std::string& method, con
 RawConnectionDriver::RawConnectionDriver(uint32_t port, Buffer::Instance& initial_data,
                                          ReadCallback data_callback,
                                          Network::Address::IpVersion version) {
-  api_.reset(new Api::Impl(std::chrono::milliseconds(10000)));
+  api_.reset(new Api::Impl(std::chrono::milliseconds(10000), 1024 * 1024));
   dispatcher_ = api_->allocateDispatcher();
   client_ = dispatcher_->createClientConnection(
       Network::Utility::resolveUrl(
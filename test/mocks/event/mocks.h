@@ -16,6 +16,8 @@
 #include "envoy/network/listener.h"
 #include "envoy/ssl/context.h"
 
+#include "common/common/utility.h"
+
 #include "test/mocks/buffer/mocks.h"
 
 #include "gmock/gmock.h"
@@ -69,6 +71,10 @@ public:
 
   TimerPtr createTimer(TimerCb cb) override { return TimerPtr{createTimer_(cb)}; }
 
+  // Coarse timers are handed out through createTimer_() too, so that tests do not need to care
+  // which kind of timer the code under test asks for.
+  TimerPtr createCoarseTimer(TimerCb cb) override { return TimerPtr{createTimer_(cb)}; }
+
   void deferredDelete(DeferredDeletablePtr&& to_delete) override {
     deferredDelete_(to_delete);
     if (to_delete) {
@@ -112,6 +118,15 @@ public:
   MOCK_METHOD1(post, void(std::function<void()> callback));
   MOCK_METHOD1(run, void(RunType type));
   Buffer::WatermarkFactory& getWatermarkFactory() override { return buffer_factory_; }
+  MOCK_METHOD2(initializeStats, void(Stats::Scope& scope, const std::string& prefix));
+  MOCK_METHOD2(initializeLoopStats, void(Stats::Scope& scope, const std::string& prefix));
+  MonotonicTimeSource& approximateMonotonicTimeSource() override {
+    return ProdMonotonicTimeSource::instance_;
+  }
+  SystemTimeSource& approximateSystemTimeSource() override {
+    return ProdSystemTimeSource::instance_;
+  }
+  MOCK_CONST_METHOD0(runningCallbackType, const char*());
 
   std::list<DeferredDeletablePtr> to_delete_;
   MockBufferFactory buffer_factory_;
@@ -1,5 +1,7 @@
 #include "mocks.h"
 
+#include <limits>
+
 #include "envoy/buffer/buffer.h"
 #include "envoy/event/dispatcher.h"
 
@@ -63,7 +65,10 @@ MockServerConnection::MockServerConnection() {
 
 MockServerConnection::~MockServerConnection() {}
 
-MockClientConnection::MockClientConnection() {}
+MockClientConnection::MockClientConnection() {
+  ON_CALL(*this, maxConcurrentStreams())
+      .WillByDefault(Return(std::numeric_limits<uint32_t>::max()));
+}
 MockClientConnection::~MockClientConnection() {}
 
 MockFilterChainFactory::MockFilterChainFactory() {}
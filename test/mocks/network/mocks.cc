@@ -67,6 +67,10 @@ template <class T> static void initializeMockConnection(T& connection) {
       .WillByDefault(Invoke([&connection](Network::ConnectionCallbacks& callbacks) -> void {
         connection.callbacks_.push_back(&callbacks);
       }));
+  ON_CALL(connection, removeConnectionCallbacks(_))
+      .WillByDefault(Invoke([&connection](Network::ConnectionCallbacks& callbacks) -> void {
+        connection.callbacks_.remove(&callbacks);
+      }));
   ON_CALL(connection, addBytesSentCallback(_))
       .WillByDefault(Invoke([&connection](Network::Connection::BytesSentCb cb) {
         connection.bytes_sent_callbacks_.emplace_back(cb);
@@ -139,6 +143,12 @@ MockFilter::~MockFilter() {}
 MockListenerCallbacks::MockListenerCallbacks() {}
 MockListenerCallbacks::~MockListenerCallbacks() {}
 
+MockUdpListenerCallbacks::MockUdpListenerCallbacks() {}
+MockUdpListenerCallbacks::~MockUdpListenerCallbacks() {}
+
+MockBalancedConnectionHandler::MockBalancedConnectionHandler() {}
+MockBalancedConnectionHandler::~MockBalancedConnectionHandler() {}
+
 MockDrainDecision::MockDrainDecision() {}
 MockDrainDecision::~MockDrainDecision() {}
 
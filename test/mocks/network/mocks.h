@@ -54,6 +54,7 @@ public:
 
   // Network::Connection
   MOCK_METHOD1(addConnectionCallbacks, void(ConnectionCallbacks& cb));
+  MOCK_METHOD1(removeConnectionCallbacks, void(ConnectionCallbacks& cb));
   MOCK_METHOD1(addBytesSentCallback, void(BytesSentCb cb));
   MOCK_METHOD1(addWriteFilter, void(WriteFilterSharedPtr filter));
   MOCK_METHOD1(addFilter, void(FilterSharedPtr filter));
@@ -78,6 +79,11 @@ public:
   MOCK_CONST_METHOD0(bufferLimit, uint32_t());
   MOCK_CONST_METHOD0(usingOriginalDst, bool());
   MOCK_CONST_METHOD0(aboveHighWatermark, bool());
+  MOCK_METHOD2(spliceTo, bool(Connection& destination, BytesSplicedCb cb));
+  MOCK_METHOD0(releaseIdleBuffers, bool());
+  MOCK_METHOD1(addDrainCallback, void(std::function<void()> cb));
+  MOCK_METHOD0(startDrain, bool());
+  MOCK_CONST_METHOD0(bufferedBytes, uint64_t());
 };
 
 /**
@@ -91,6 +97,7 @@ public:
 
   // Network::Connection
   MOCK_METHOD1(addConnectionCallbacks, void(ConnectionCallbacks& cb));
+  MOCK_METHOD1(removeConnectionCallbacks, void(ConnectionCallbacks& cb));
   MOCK_METHOD1(addBytesSentCallback, void(BytesSentCb cb));
   MOCK_METHOD1(addWriteFilter, void(WriteFilterSharedPtr filter));
   MOCK_METHOD1(addFilter, void(FilterSharedPtr filter));
@@ -115,6 +122,11 @@ public:
   MOCK_CONST_METHOD0(bufferLimit, uint32_t());
   MOCK_CONST_METHOD0(usingOriginalDst, bool());
   MOCK_CONST_METHOD0(aboveHighWatermark, bool());
+  MOCK_METHOD2(spliceTo, bool(Connection& destination, BytesSplicedCb cb));
+  MOCK_METHOD0(releaseIdleBuffers, bool());
+  MOCK_METHOD1(addDrainCallback, void(std::function<void()> cb));
+  MOCK_METHOD0(startDrain, bool());
+  MOCK_CONST_METHOD0(bufferedBytes, uint64_t());
 
   // Network::ClientConnection
   MOCK_METHOD0(connect, void());
@@ -198,6 +210,26 @@ public:
   MOCK_METHOD1(onNewConnection_, void(ConnectionPtr& conn));
 };
 
+class MockUdpListenerCallbacks : public UdpListenerCallbacks {
+public:
+  MockUdpListenerCallbacks();
+  ~MockUdpListenerCallbacks();
+
+  MOCK_METHOD1(onData, void(const UdpRecvData& data));
+  MOCK_METHOD0(onReadComplete, void());
+};
+
+class MockBalancedConnectionHandler : public BalancedConnectionHandler {
+public:
+  MockBalancedConnectionHandler();
+  ~MockBalancedConnectionHandler();
+
+  MOCK_METHOD0(numConnections, uint64_t());
+  MOCK_METHOD4(post, void(int fd, Address::InstanceConstSharedPtr remote_address,
+                          Address::InstanceConstSharedPtr local_address,
+                          bool using_original_dst));
+};
+
 class MockDrainDecision : public DrainDecision {
 public:
   MockDrainDecision();
@@ -232,6 +264,8 @@ public:
   ~MockListener();
 
   MOCK_METHOD0(onDestroy, void());
+  MOCK_METHOD0(disable, void());
+  MOCK_METHOD0(enable, void());
 };
 
 class MockConnectionHandler : public ConnectionHandler {
@@ -253,6 +287,9 @@ public:
   MOCK_METHOD1(removeListeners, void(uint64_t listener_tag));
   MOCK_METHOD1(stopListeners, void(uint64_t listener_tag));
   MOCK_METHOD0(stopListeners, void());
+  MOCK_METHOD0(disableListeners, void());
+  MOCK_METHOD0(enableListeners, void());
+  MOCK_METHOD1(setConnectionBufferLimitCap, void(uint32_t limit));
 };
 
 class MockResolvedAddress : public Address::Instance {
@@ -289,6 +326,7 @@ public:
   MOCK_METHOD1(doRead, IoResult(Buffer::Instance& buffer));
   MOCK_METHOD1(doWrite, IoResult(Buffer::Instance& buffer));
   MOCK_METHOD0(onConnected, void());
+  MOCK_CONST_METHOD0(directWritesSupported, bool());
 };
 
 } // namespace Network
@@ -81,7 +81,18 @@ MockPoolRequest::~MockPoolRequest() {}
 MockPoolCallbacks::MockPoolCallbacks() {}
 MockPoolCallbacks::~MockPoolCallbacks() {}
 
-MockInstance::MockInstance() {}
+MockInstance::MockInstance() {
+  ON_CALL(*this, groupKeys(_))
+      .WillByDefault(Invoke([](const std::vector<const std::string*>& hash_keys)
+                                -> std::vector<std::vector<uint32_t>> {
+        std::vector<std::vector<uint32_t>> groups;
+        for (uint32_t i = 0; i < hash_keys.size(); i++) {
+          groups.push_back({i});
+        }
+        return groups;
+      }));
+}
+
 MockInstance::~MockInstance() {}
 
 } // namespace ConnPool
@@ -3,6 +3,7 @@
 #include <cstdint>
 #include <list>
 #include <string>
+#include <vector>
 
 #include "envoy/redis/command_splitter.h"
 #include "envoy/redis/conn_pool.h"
@@ -24,6 +25,7 @@ public:
   ~MockEncoder();
 
   MOCK_METHOD2(encode, void(const RespValue& value, Buffer::Instance& out));
+  void encode(RespValuePtr&& value, Buffer::Instance& out) override { encode(*value, out); }
 
 private:
   EncoderImpl real_encoder_;
@@ -83,6 +85,14 @@ public:
 
   MOCK_METHOD3(makeRequest, PoolRequest*(const std::string& hash_key, const RespValue& request,
                                          PoolCallbacks& callbacks));
+  MOCK_METHOD3(makeReplicaRequest,
+               PoolRequest*(const std::string& hash_key, const RespValue& request,
+                            PoolCallbacks& callbacks));
+  MOCK_METHOD1(groupKeys, std::vector<std::vector<uint32_t>>(
+                             const std::vector<const std::string*>& hash_keys));
+  MOCK_METHOD3(makeRedirectedRequest,
+               PoolRequest*(const RespValue& redirection, const RespValue& request,
+                            PoolCallbacks& callbacks));
 };
 
 } // namespace ConnPool
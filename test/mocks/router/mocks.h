@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
 #include <list>
@@ -41,6 +42,11 @@ class TestCorsPolicy : public CorsPolicy {
 public:
   // Router::CorsPolicy
   const std::list<std::string>& allowOrigins() const override { return allow_origin_; };
+  bool originAllowed(const std::string& origin) const override {
+    return std::find_if(allow_origin_.begin(), allow_origin_.end(), [&](const std::string& o) {
+             return o == "*" || o == origin;
+           }) != allow_origin_.end();
+  };
   const std::string& allowMethods() const override { return allow_methods_; };
   const std::string& allowHeaders() const override { return allow_headers_; };
   const std::string& exposeHeaders() const override { return expose_headers_; };
@@ -126,6 +132,27 @@ public:
   std::string runtime_key_;
 };
 
+class TestHedgePolicy : public HedgePolicy {
+public:
+  // Router::HedgePolicy
+  double latencyPercentile() const override { return latency_percentile_; }
+  std::chrono::milliseconds minDelay() const override { return min_delay_; }
+
+  double latency_percentile_{};
+  std::chrono::milliseconds min_delay_{0};
+};
+
+class MockShadowStream : public ShadowStream {
+public:
+  MockShadowStream();
+  ~MockShadowStream();
+
+  // Router::ShadowStream
+  MOCK_METHOD2(sendData, void(Buffer::Instance& data, bool end_stream));
+  MOCK_METHOD1(sendTrailers, void(const Http::HeaderMap& trailers));
+  MOCK_METHOD0(cancel, void());
+};
+
 class MockShadowWriter : public ShadowWriter {
 public:
   MockShadowWriter();
@@ -136,9 +163,15 @@ public:
               std::chrono::milliseconds timeout) override {
     shadow_(cluster, request, timeout);
   }
+  ShadowStream* streamShadow(const std::string& cluster, Http::HeaderMapPtr&& headers,
+                             bool end_stream, std::chrono::milliseconds timeout) override {
+    return streamShadow_(cluster, *headers, end_stream, timeout);
+  }
 
   MOCK_METHOD3(shadow_, void(const std::string& cluster, Http::MessagePtr& request,
                              std::chrono::milliseconds timeout));
+  MOCK_METHOD4(streamShadow_, ShadowStream*(const std::string& cluster, Http::HeaderMap& headers,
+                                            bool end_stream, std::chrono::milliseconds timeout));
 };
 
 class TestVirtualCluster : public VirtualCluster {
@@ -192,6 +225,7 @@ public:
 
   // Router::Config
   MOCK_CONST_METHOD0(clusterName, const std::string&());
+  MOCK_CONST_METHOD0(clusterHandle, const Upstream::ClusterHandle*());
   MOCK_CONST_METHOD0(clusterNotFoundResponseCode, Http::Code());
   MOCK_CONST_METHOD2(finalizeRequestHeaders,
                      void(Http::HeaderMap& headers, const RequestInfo::RequestInfo& request_info));
@@ -203,6 +237,7 @@ public:
   MOCK_CONST_METHOD0(rateLimitPolicy, const RateLimitPolicy&());
   MOCK_CONST_METHOD0(retryPolicy, const RetryPolicy&());
   MOCK_CONST_METHOD0(shadowPolicy, const ShadowPolicy&());
+  MOCK_CONST_METHOD0(hedgePolicy, const HedgePolicy&());
   MOCK_CONST_METHOD0(timeout, std::chrono::milliseconds());
   MOCK_CONST_METHOD1(virtualCluster, const VirtualCluster*(const Http::HeaderMap& headers));
   MOCK_CONST_METHOD0(virtualHostName, const std::string&());
@@ -219,6 +254,7 @@ public:
   TestRetryPolicy retry_policy_;
   testing::NiceMock<MockRateLimitPolicy> rate_limit_policy_;
   TestShadowPolicy shadow_policy_;
+  TestHedgePolicy hedge_policy_;
   testing::NiceMock<MockVirtualHost> virtual_host_;
   MockHashPolicy hash_policy_;
   MockMetadataMatchCriteria metadata_matches_criteria_;
@@ -258,6 +294,7 @@ public:
 
   // Router::Config
   MOCK_CONST_METHOD2(route, RouteConstSharedPtr(const Http::HeaderMap&, uint64_t random_value));
+  MOCK_CONST_METHOD0(routeCacheable, bool());
   MOCK_CONST_METHOD0(internalOnlyHeaders, const std::list<Http::LowerCaseString>&());
 
   std::shared_ptr<MockRoute> route_;
@@ -275,6 +312,10 @@ public:
                                             Upstream::ClusterManager& cm, Stats::Scope& scope,
                                             const std::string& stat_prefix,
                                             Init::Manager& init_manager));
+  MOCK_METHOD3(getStaticRouteConfigProvider,
+               RouteConfigProviderSharedPtr(const envoy::api::v2::RouteConfiguration& route_config,
+                                            Runtime::Loader& runtime,
+                                            Upstream::ClusterManager& cm));
   MOCK_METHOD1(removeRouteConfigProvider, void(const std::string& identifier));
 };
 
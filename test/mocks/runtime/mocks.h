@@ -26,6 +26,11 @@ public:
   MockSnapshot();
   ~MockSnapshot();
 
+  // Lookups through a Runtime::Key forward to the mocked lookups by name.
+  using Snapshot::featureEnabled;
+  using Snapshot::get;
+  using Snapshot::getInteger;
+
   MOCK_CONST_METHOD2(featureEnabled, bool(const std::string& key, uint64_t default_value));
   MOCK_CONST_METHOD3(featureEnabled,
                      bool(const std::string& key, uint64_t default_value, uint64_t random_value));
@@ -5,6 +5,7 @@
 
 using testing::Invoke;
 using testing::NiceMock;
+using testing::ReturnPointee;
 using testing::ReturnRef;
 using testing::_;
 
@@ -12,16 +13,16 @@ namespace Envoy {
 namespace Stats {
 
 MockCounter::MockCounter() {
-  ON_CALL(*this, name()).WillByDefault(ReturnRef(name_));
-  ON_CALL(*this, tagExtractedName()).WillByDefault(ReturnRef(name_));
-  ON_CALL(*this, tags()).WillByDefault(ReturnRef(tags_));
+  ON_CALL(*this, name()).WillByDefault(ReturnPointee(&name_));
+  ON_CALL(*this, tagExtractedName()).WillByDefault(ReturnPointee(&name_));
+  ON_CALL(*this, tags()).WillByDefault(ReturnPointee(&tags_));
 }
 MockCounter::~MockCounter() {}
 
 MockGauge::MockGauge() {
-  ON_CALL(*this, name()).WillByDefault(ReturnRef(name_));
-  ON_CALL(*this, tagExtractedName()).WillByDefault(ReturnRef(name_));
-  ON_CALL(*this, tags()).WillByDefault(ReturnRef(tags_));
+  ON_CALL(*this, name()).WillByDefault(ReturnPointee(&name_));
+  ON_CALL(*this, tagExtractedName()).WillByDefault(ReturnPointee(&name_));
+  ON_CALL(*this, tags()).WillByDefault(ReturnPointee(&tags_));
 }
 MockGauge::~MockGauge() {}
 
@@ -31,11 +32,19 @@ MockHistogram::MockHistogram() {
       store_->deliverHistogramToSinks(*this, value);
     }
   }));
-  ON_CALL(*this, tagExtractedName()).WillByDefault(ReturnRef(name_));
-  ON_CALL(*this, tags()).WillByDefault(ReturnRef(tags_));
+  ON_CALL(*this, tagExtractedName()).WillByDefault(ReturnPointee(&name_));
+  ON_CALL(*this, tags()).WillByDefault(ReturnPointee(&tags_));
 }
 MockHistogram::~MockHistogram() {}
 
+MockParentHistogram::MockParentHistogram() {
+  ON_CALL(*this, tagExtractedName()).WillByDefault(ReturnPointee(&name_));
+  ON_CALL(*this, tags()).WillByDefault(ReturnPointee(&tags_));
+  ON_CALL(*this, intervalStatistics()).WillByDefault(ReturnRef(interval_statistics_));
+  ON_CALL(*this, cumulativeStatistics()).WillByDefault(ReturnRef(cumulative_statistics_));
+}
+MockParentHistogram::~MockParentHistogram() {}
+
 MockSink::MockSink() {}
 MockSink::~MockSink() {}
 
@@ -48,6 +57,25 @@ MockStore::MockStore() {
     histograms_.emplace_back(histogram);
     return *histogram;
   }));
+  // Iterate whatever the list accessors are set up to return.
+  ON_CALL(*this, forEachCounter(_))
+      .WillByDefault(Invoke([this](const std::function<void(Counter&)>& cb) {
+        for (const CounterSharedPtr& counter : counters()) {
+          cb(*counter);
+        }
+      }));
+  ON_CALL(*this, forEachGauge(_))
+      .WillByDefault(Invoke([this](const std::function<void(Gauge&)>& cb) {
+        for (const GaugeSharedPtr& gauge : gauges()) {
+          cb(*gauge);
+        }
+      }));
+  ON_CALL(*this, forEachHistogram(_))
+      .WillByDefault(Invoke([this](const std::function<void(ParentHistogram&)>& cb) {
+        for (const ParentHistogramSharedPtr& histogram : histograms()) {
+          cb(*histogram);
+        }
+      }));
 }
 MockStore::~MockStore() {}
 
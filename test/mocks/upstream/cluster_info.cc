@@ -34,6 +34,7 @@ MockClusterInfo::MockClusterInfo()
   ON_CALL(*this, stats()).WillByDefault(ReturnRef(stats_));
   ON_CALL(*this, statsScope()).WillByDefault(ReturnRef(stats_store_));
   ON_CALL(*this, loadReportStats()).WillByDefault(ReturnRef(load_report_stats_));
+  ON_CALL(*this, codeStats()).WillByDefault(ReturnRef(code_stats_));
   ON_CALL(*this, sourceAddress()).WillByDefault(ReturnRef(source_address_));
   ON_CALL(*this, resourceManager(_))
       .WillByDefault(Invoke(
@@ -42,6 +43,7 @@ MockClusterInfo::MockClusterInfo()
   ON_CALL(*this, sourceAddress()).WillByDefault(ReturnRef(source_address_));
   ON_CALL(*this, lbSubsetInfo()).WillByDefault(ReturnRef(lb_subset_));
   ON_CALL(*this, lbRingHashConfig()).WillByDefault(ReturnRef(lb_ring_hash_config_));
+  ON_CALL(*this, latencyEstimator()).WillByDefault(ReturnRef(latency_estimator_));
 }
 
 MockClusterInfo::~MockClusterInfo() {}
@@ -2,12 +2,16 @@
 
 #include <chrono>
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <string>
 
 #include "envoy/upstream/cluster_manager.h"
 #include "envoy/upstream/upstream.h"
 
+#include "common/http/codes.h"
+#include "common/upstream/latency_estimator_impl.h"
+
 #include "test/mocks/runtime/mocks.h"
 #include "test/mocks/stats/mocks.h"
 
@@ -42,6 +46,7 @@ public:
   // Upstream::ClusterInfo
   MOCK_CONST_METHOD0(addedViaApi, bool());
   MOCK_CONST_METHOD0(connectTimeout, std::chrono::milliseconds());
+  MOCK_CONST_METHOD0(idleTimeout, std::chrono::milliseconds());
   MOCK_CONST_METHOD0(perConnectionBufferLimitBytes, uint32_t());
   MOCK_CONST_METHOD0(features, uint64_t());
   MOCK_CONST_METHOD0(http2Settings, const Http::Http2Settings&());
@@ -51,19 +56,27 @@ public:
   MOCK_CONST_METHOD0(maintenanceMode, bool());
   MOCK_CONST_METHOD0(maxRequestsPerConnection, uint64_t());
   MOCK_CONST_METHOD0(name, const std::string&());
+  MOCK_CONST_METHOD0(preconnectPercent, uint64_t());
   MOCK_CONST_METHOD1(resourceManager, ResourceManager&(ResourcePriority priority));
   MOCK_CONST_METHOD0(sslContext, Ssl::ClientContext*());
   MOCK_CONST_METHOD0(stats, ClusterStats&());
   MOCK_CONST_METHOD0(statsScope, Stats::Scope&());
   MOCK_CONST_METHOD0(loadReportStats, ClusterLoadReportStats&());
+  MOCK_CONST_METHOD0(codeStats, Http::CodeStats&());
+  MOCK_CONST_METHOD1(forEachLazyCounter, void(const std::function<void(Stats::Counter&)>& cb));
+  MOCK_CONST_METHOD2(localityLoadStats,
+                     LocalityLoadStatsSharedPtr(const envoy::api::v2::Locality& locality,
+                                                uint32_t priority));
   MOCK_CONST_METHOD0(sourceAddress, const Network::Address::InstanceConstSharedPtr&());
   MOCK_CONST_METHOD0(lbSubsetInfo, const LoadBalancerSubsetInfo&());
+  MOCK_CONST_METHOD0(latencyEstimator, LatencyEstimator&());
 
   std::string name_{"fake_cluster"};
   Http::Http2Settings http2_settings_{};
   uint64_t max_requests_per_connection_{};
   NiceMock<Stats::MockIsolatedStatsStore> stats_store_;
   ClusterStats stats_;
+  Http::CodeStatsImpl code_stats_{stats_store_};
   NiceMock<Stats::MockIsolatedStatsStore> load_report_stats_store_;
   ClusterLoadReportStats load_report_stats_;
   NiceMock<Runtime::MockLoader> runtime_;
@@ -72,6 +85,7 @@ public:
   LoadBalancerType lb_type_{LoadBalancerType::RoundRobin};
   NiceMock<MockLoadBalancerSubsetInfo> lb_subset_;
   Optional<envoy::api::v2::Cluster::RingHashLbConfig> lb_ring_hash_config_;
+  LatencyEstimatorImpl latency_estimator_;
 };
 
 } // namespace Upstream
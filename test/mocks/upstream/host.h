@@ -84,6 +84,7 @@ public:
   MOCK_CONST_METHOD0(hostname, const std::string&());
   MOCK_CONST_METHOD0(stats, HostStats&());
   MOCK_CONST_METHOD0(locality, const envoy::api::v2::Locality&());
+  MOCK_CONST_METHOD0(localityLoadStats, LocalityLoadStats*());
 
   std::string hostname_;
   Network::Address::InstanceConstSharedPtr address_;
@@ -139,6 +140,7 @@ public:
   MOCK_CONST_METHOD0(used, bool());
   MOCK_METHOD1(used, void(bool new_used));
   MOCK_CONST_METHOD0(locality, const envoy::api::v2::Locality&());
+  MOCK_CONST_METHOD0(localityLoadStats, LocalityLoadStats*());
 
   testing::NiceMock<MockClusterInfo> cluster_;
   testing::NiceMock<Outlier::MockDetectorHostMonitor> outlier_detector_;
@@ -81,6 +81,9 @@ MockThreadLocalCluster::MockThreadLocalCluster() {
 
 MockThreadLocalCluster::~MockThreadLocalCluster() {}
 
+MockClusterHandle::MockClusterHandle() {}
+MockClusterHandle::~MockClusterHandle() {}
+
 MockClusterManager::MockClusterManager() {
   ON_CALL(*this, httpConnPoolForCluster(_, _, _)).WillByDefault(Return(&conn_pool_));
   ON_CALL(*this, httpAsyncClientForCluster(_)).WillByDefault(ReturnRef(async_client_));
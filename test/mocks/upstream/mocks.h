@@ -137,6 +137,17 @@ public:
   NiceMock<MockLoadBalancer> lb_;
 };
 
+class MockClusterHandle : public ClusterHandle {
+public:
+  MockClusterHandle();
+  ~MockClusterHandle();
+
+  // Upstream::ClusterHandle
+  MOCK_CONST_METHOD0(get, ThreadLocalCluster*());
+  MOCK_CONST_METHOD2(httpConnPool, Http::ConnectionPool::Instance*(ResourcePriority priority,
+                                                                   LoadBalancerContext* context));
+};
+
 class MockClusterManager : public ClusterManager {
 public:
   MockClusterManager();
@@ -153,6 +164,7 @@ public:
   MOCK_METHOD1(setInitializedCb, void(std::function<void()>));
   MOCK_METHOD0(clusters, ClusterInfoMap());
   MOCK_METHOD1(get, ThreadLocalCluster*(const std::string& cluster));
+  MOCK_METHOD1(clusterHandle, ClusterHandleConstSharedPtr(const std::string& cluster));
   MOCK_METHOD3(httpConnPoolForCluster,
                Http::ConnectionPool::Instance*(const std::string& cluster,
                                                ResourcePriority priority,
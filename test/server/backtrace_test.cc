@@ -1,3 +1,7 @@
+#include <execinfo.h>
+
+#include <vector>
+
 #include "server/backtrace.h"
 
 #include "gtest/gtest.h"
@@ -17,4 +21,12 @@ TEST(Backward, InvalidUsageTest) {
   BackwardsTrace tracer;
   tracer.logTrace();
 }
+
+TEST(Backward, LogFramesTest) {
+  void* frames[2];
+  const int depth = backtrace(frames, 2);
+  BackwardsTrace::logFrames(1, std::vector<void*>(frames, frames + depth));
+  // Nothing but the failure is logged for an empty stack.
+  BackwardsTrace::logFrames(1, {});
+}
 } // namespace Envoy
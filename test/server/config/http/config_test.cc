@@ -9,12 +9,15 @@
 #include "common/protobuf/utility.h"
 #include "common/router/router.h"
 
+#include "server/config/http/adaptive_concurrency.h"
 #include "server/config/http/buffer.h"
+#include "server/config/http/cache.h"
 #include "server/config/http/dynamo.h"
 #include "server/config/http/fault.h"
 #include "server/config/http/grpc_http1_bridge.h"
 #include "server/config/http/grpc_json_transcoder.h"
 #include "server/config/http/grpc_web.h"
+#include "server/config/http/gzip.h"
 #include "server/config/http/ip_tagging.h"
 #include "server/config/http/lua.h"
 #include "server/config/http/ratelimit.h"
@@ -202,6 +205,76 @@ TEST(HttpFilterConfigTest, BadRateLimitFilterConfig) {
   EXPECT_THROW(factory.createFilterFactory(*json_config, "stats", context), Json::Exception);
 }
 
+TEST(HttpFilterConfigTest, AdaptiveConcurrencyFilter) {
+  NiceMock<MockFactoryContext> context;
+  AdaptiveConcurrencyFilterConfig factory;
+  HttpFilterFactoryCb cb =
+      factory.createFilterFactoryFromProto(*factory.createEmptyConfigProto(), "stats", context);
+  Http::MockFilterChainFactoryCallbacks filter_callback;
+  EXPECT_CALL(filter_callback, addStreamFilter(_));
+  cb(filter_callback);
+}
+
+TEST(HttpFilterConfigTest, HttpCacheFilter) {
+  std::string json_string = R"EOF(
+  {
+    "max_memory_bytes" : 1048576,
+    "max_entry_bytes" : 1024
+  }
+  )EOF";
+
+  Json::ObjectSharedPtr json_config = Json::Factory::loadFromString(json_string);
+  NiceMock<MockFactoryContext> context;
+  HttpCacheFilterConfig factory;
+  HttpFilterFactoryCb cb = factory.createFilterFactory(*json_config, "stats", context);
+  Http::MockFilterChainFactoryCallbacks filter_callback;
+  EXPECT_CALL(filter_callback, addStreamFilter(_));
+  cb(filter_callback);
+}
+
+TEST(HttpFilterConfigTest, HttpCacheFilterProto) {
+  NiceMock<MockFactoryContext> context;
+  HttpCacheFilterConfig factory;
+  ProtobufTypes::MessagePtr proto_config = factory.createEmptyConfigProto();
+  MessageUtil::loadFromJson("{\"max_entry_bytes\": 1024}", *proto_config);
+  HttpFilterFactoryCb cb = factory.createFilterFactoryFromProto(*proto_config, "stats", context);
+  Http::MockFilterChainFactoryCallbacks filter_callback;
+  EXPECT_CALL(filter_callback, addStreamFilter(_));
+  cb(filter_callback);
+}
+
+TEST(HttpFilterConfigTest, BadHttpCacheFilterConfig) {
+  std::string json_string = R"EOF(
+  {
+    "disk_cache" : {}
+  }
+  )EOF";
+
+  Json::ObjectSharedPtr json_config = Json::Factory::loadFromString(json_string);
+  NiceMock<MockFactoryContext> context;
+  HttpCacheFilterConfig factory;
+  EXPECT_THROW(factory.createFilterFactory(*json_config, "stats", context), Json::Exception);
+}
+
+TEST(HttpFilterConfigTest, GzipFilter) {
+  std::string json_string = R"EOF(
+  {
+    "compression_level" : "speed",
+    "content_length" : 100,
+    "content_type" : ["text/html"],
+    "encodings" : ["br", "gzip"]
+  }
+  )EOF";
+
+  Json::ObjectSharedPtr json_config = Json::Factory::loadFromString(json_string);
+  NiceMock<MockFactoryContext> context;
+  GzipFilterConfig factory;
+  HttpFilterFactoryCb cb = factory.createFilterFactory(*json_config, "stats", context);
+  Http::MockFilterChainFactoryCallbacks filter_callback;
+  EXPECT_CALL(filter_callback, addStreamFilter(_));
+  cb(filter_callback);
+}
+
 TEST(HttpFilterConfigTest, DynamoFilter) {
   std::string json_string = R"EOF(
   {
@@ -402,7 +475,7 @@ TEST(HttpFilterConfigTest, IpTaggingFilter) {
     "request_type" : "internal",
     "ip_tags" : [
       { "ip_tag_name" : "example_tag",
-        "ip_list" : ["0.0.0.0"]
+        "ip_list" : ["0.0.0.0/0"]
       }
     ]
   }
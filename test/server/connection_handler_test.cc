@@ -4,6 +4,7 @@
 
 #include "server/connection_handler_impl.h"
 
+#include "test/mocks/event/mocks.h"
 #include "test/mocks/network/mocks.h"
 #include "test/mocks/server/mocks.h"
 
@@ -147,6 +148,173 @@ TEST_F(ConnectionHandlerTest, CloseConnectionOnEmptyFilterChain) {
   EXPECT_CALL(*listener, onDestroy());
 }
 
+TEST_F(ConnectionHandlerTest, PerWorkerStats) {
+  handler_.reset(new ConnectionHandlerImpl(ENVOY_LOGGER(), dispatcher_, 3));
+
+  Network::MockListener* listener = new NiceMock<Network::MockListener>();
+  Network::ListenerCallbacks* listener_callbacks;
+  EXPECT_CALL(dispatcher_, createListener_(_, _, _, _, _))
+      .WillOnce(Invoke([&](Network::ConnectionHandler&, Network::ListenSocket&,
+                           Network::ListenerCallbacks& cb, Stats::Scope&,
+                           const Network::ListenerOptions&) -> Network::Listener* {
+        listener_callbacks = &cb;
+        return listener;
+
+      }));
+  handler_->addListener(factory_, socket_, stats_store_, 1,
+                        Network::ListenerOptions::listenerOptionsWithBindToPort());
+
+  Network::MockConnection* connection = new NiceMock<Network::MockConnection>();
+  EXPECT_CALL(factory_, createFilterChain(_)).WillOnce(Return(true));
+  listener_callbacks->onNewConnection(Network::ConnectionPtr{connection});
+  EXPECT_EQ(1UL, stats_store_.counter("worker_3.downstream_cx_total").value());
+  EXPECT_EQ(1UL, stats_store_.gauge("worker_3.downstream_cx_active").value());
+  EXPECT_EQ(1UL, stats_store_.gauge("downstream_cx_active").value());
+
+  connection->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  dispatcher_.to_delete_.clear();
+  EXPECT_EQ(0UL, stats_store_.gauge("worker_3.downstream_cx_active").value());
+
+  EXPECT_CALL(*listener, onDestroy());
+  handler_.reset();
+}
+
+TEST_F(ConnectionHandlerTest, OverloadActions) {
+  Network::MockListener* listener = new NiceMock<Network::MockListener>();
+  Network::ListenerCallbacks* listener_callbacks;
+  EXPECT_CALL(dispatcher_, createListener_(_, _, _, _, _))
+      .WillOnce(Invoke([&](Network::ConnectionHandler&, Network::ListenSocket&,
+                           Network::ListenerCallbacks& cb, Stats::Scope&,
+                           const Network::ListenerOptions&) -> Network::Listener* {
+        listener_callbacks = &cb;
+        return listener;
+
+      }));
+  handler_->addListener(factory_, socket_, stats_store_, 1,
+                        Network::ListenerOptions::listenerOptionsWithBindToPort());
+
+  EXPECT_CALL(*listener, disable());
+  handler_->disableListeners();
+  EXPECT_CALL(*listener, enable());
+  handler_->enableListeners();
+
+  // Listeners added while disabled start out disabled.
+  handler_->disableListeners();
+  Network::MockListener* listener2 = new NiceMock<Network::MockListener>();
+  EXPECT_CALL(dispatcher_, createListener_(_, _, _, _, _)).WillOnce(Return(listener2));
+  EXPECT_CALL(*listener2, disable());
+  handler_->addListener(factory_, socket_, stats_store_, 2,
+                        Network::ListenerOptions::listenerOptionsWithBindToPort());
+
+  handler_->setConnectionBufferLimitCap(1024);
+  Network::MockConnection* connection = new NiceMock<Network::MockConnection>();
+  ON_CALL(*connection, bufferLimit()).WillByDefault(Return(1024 * 1024));
+  EXPECT_CALL(*connection, setBufferLimits(1024));
+  EXPECT_CALL(factory_, createFilterChain(_)).WillOnce(Return(true));
+  listener_callbacks->onNewConnection(Network::ConnectionPtr{connection});
+
+  // Connections with a smaller limit keep it.
+  Network::MockConnection* connection2 = new NiceMock<Network::MockConnection>();
+  ON_CALL(*connection2, bufferLimit()).WillByDefault(Return(512));
+  EXPECT_CALL(*connection2, setBufferLimits(_)).Times(0);
+  EXPECT_CALL(factory_, createFilterChain(_)).WillOnce(Return(true));
+  listener_callbacks->onNewConnection(Network::ConnectionPtr{connection2});
+
+  EXPECT_CALL(*listener, onDestroy());
+  EXPECT_CALL(*listener2, onDestroy());
+  handler_.reset();
+}
+
+TEST_F(ConnectionHandlerTest, IdleBufferSweep) {
+  Event::MockTimer* timer = new Event::MockTimer(&dispatcher_);
+  EXPECT_CALL(*timer, enableTimer(std::chrono::milliseconds(1000)));
+  Network::MockListener* listener = new NiceMock<Network::MockListener>();
+  Network::ListenerCallbacks* listener_callbacks;
+  EXPECT_CALL(dispatcher_, createListener_(_, _, _, _, _))
+      .WillOnce(Invoke([&](Network::ConnectionHandler&, Network::ListenSocket&,
+                           Network::ListenerCallbacks& cb, Stats::Scope&,
+                           const Network::ListenerOptions&) -> Network::Listener* {
+        listener_callbacks = &cb;
+        return listener;
+
+      }));
+  Network::ListenerOptions listener_options =
+      Network::ListenerOptions::listenerOptionsWithBindToPort();
+  listener_options.idle_buffer_release_interval_ = std::chrono::milliseconds(1000);
+  handler_->addListener(factory_, socket_, stats_store_, 1, listener_options);
+
+  Network::MockConnection* idle_connection = new NiceMock<Network::MockConnection>();
+  Network::MockConnection* active_connection = new NiceMock<Network::MockConnection>();
+  EXPECT_CALL(factory_, createFilterChain(_)).WillRepeatedly(Return(true));
+  listener_callbacks->onNewConnection(Network::ConnectionPtr{idle_connection});
+  listener_callbacks->onNewConnection(Network::ConnectionPtr{active_connection});
+
+  EXPECT_CALL(*idle_connection, releaseIdleBuffers()).WillOnce(Return(true));
+  EXPECT_CALL(*idle_connection, bufferedBytes()).WillOnce(Return(10));
+  EXPECT_CALL(*active_connection, releaseIdleBuffers()).WillOnce(Return(false));
+  EXPECT_CALL(*active_connection, bufferedBytes()).Times(0);
+  EXPECT_CALL(*timer, enableTimer(std::chrono::milliseconds(1000)));
+  timer->callback_();
+  EXPECT_EQ(1UL, stats_store_.gauge("downstream_cx_idle").value());
+  EXPECT_EQ(10UL, stats_store_.gauge("downstream_cx_idle_buffered_bytes").value());
+
+  EXPECT_CALL(*idle_connection, releaseIdleBuffers()).WillOnce(Return(false));
+  EXPECT_CALL(*active_connection, releaseIdleBuffers()).WillOnce(Return(false));
+  EXPECT_CALL(*timer, enableTimer(std::chrono::milliseconds(1000)));
+  timer->callback_();
+  EXPECT_EQ(0UL, stats_store_.gauge("downstream_cx_idle").value());
+  EXPECT_EQ(0UL, stats_store_.gauge("downstream_cx_idle_buffered_bytes").value());
+
+  EXPECT_CALL(*listener, onDestroy());
+  handler_.reset();
+}
+
+TEST_F(ConnectionHandlerTest, DrainConnectionsOnStop) {
+  Network::MockListener* listener = new NiceMock<Network::MockListener>();
+  Network::ListenerCallbacks* listener_callbacks;
+  EXPECT_CALL(dispatcher_, createListener_(_, _, _, _, _))
+      .WillOnce(Invoke([&](Network::ConnectionHandler&, Network::ListenSocket&,
+                           Network::ListenerCallbacks& cb, Stats::Scope&,
+                           const Network::ListenerOptions&) -> Network::Listener* {
+        listener_callbacks = &cb;
+        return listener;
+
+      }));
+  Network::ListenerOptions listener_options =
+      Network::ListenerOptions::listenerOptionsWithBindToPort();
+  listener_options.drain_connections_per_second_ = 5;
+  handler_->addListener(factory_, socket_, stats_store_, 1, listener_options);
+
+  std::vector<Network::MockConnection*> connections;
+  EXPECT_CALL(factory_, createFilterChain(_)).WillRepeatedly(Return(true));
+  for (int i = 0; i < 3; i++) {
+    connections.push_back(new NiceMock<Network::MockConnection>());
+    listener_callbacks->onNewConnection(Network::ConnectionPtr{connections.back()});
+  }
+
+  // The oldest connection is drained as soon as the listener stops, the others one per tick.
+  Event::MockTimer* timer = new Event::MockTimer(&dispatcher_);
+  EXPECT_CALL(*listener, onDestroy());
+  EXPECT_CALL(*connections[0], startDrain()).WillOnce(Return(true));
+  EXPECT_CALL(*timer, enableTimer(std::chrono::milliseconds(200)));
+  handler_->stopListeners(1);
+
+  // A connection without drain callbacks is skipped.
+  EXPECT_CALL(*connections[1], startDrain()).WillOnce(Return(false));
+  EXPECT_CALL(*timer, enableTimer(std::chrono::milliseconds(200)));
+  timer->callback_();
+
+  EXPECT_CALL(*connections[2], startDrain()).WillOnce(Return(true));
+  timer->callback_();
+  EXPECT_EQ(2UL, stats_store_.counter("downstream_cx_drain_requested").value());
+
+  // A drained connection that closes is removed as usual.
+  connections[0]->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  EXPECT_EQ(2UL, handler_->numConnections());
+
+  handler_.reset();
+}
+
 TEST_F(ConnectionHandlerTest, FindListenerByAddress) {
   Network::Address::InstanceConstSharedPtr alt_address(
       new Network::Address::Ipv4Instance("127.0.0.1", 10001));
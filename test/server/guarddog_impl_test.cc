@@ -4,12 +4,14 @@
 
 #include "envoy/common/time.h"
 
+#include "common/common/thread.h"
 #include "common/common/utility.h"
 #include "common/stats/stats_impl.h"
 
 #include "server/guarddog_impl.h"
 
 #include "test/mocks/common.h"
+#include "test/mocks/event/mocks.h"
 #include "test/mocks/server/mocks.h"
 #include "test/mocks/stats/mocks.h"
 
@@ -18,6 +20,7 @@
 
 using testing::InSequence;
 using testing::NiceMock;
+using testing::Return;
 
 namespace Envoy {
 namespace Server {
@@ -230,6 +233,22 @@ TEST_F(GuardDogMissTest, MissCountTest) {
   sometimes_pet_dog = nullptr;
 }
 
+TEST_F(GuardDogMissTest, MissLogsStallTest) {
+  // The miss of a thread that is really blocked, here in forceCheckForTest(), captures its stack
+  // along with the kind of callback its dispatcher is running.
+  GuardDogImpl gd(stats_store_, config_miss_, time_source_);
+  Event::MockDispatcher dispatcher;
+  new NiceMock<Event::MockTimer>(&dispatcher);
+  auto unpet_dog = gd.createWatchDog(Thread::Thread::currentThreadId());
+  unpet_dog->startWatchdog(dispatcher);
+  EXPECT_CALL(dispatcher, runningCallbackType()).WillOnce(Return("timer"));
+  mock_time_ += 501;
+  gd.forceCheckForTest();
+  EXPECT_EQ(1UL, stats_store_.counter("server.watchdog_miss").value());
+  gd.stopWatching(unpet_dog);
+  unpet_dog = nullptr;
+}
+
 TEST(GuardDogBasicTest, StartStopTest) {
   NiceMock<Stats::MockStore> stats;
   NiceMock<Configuration::MockMain> config(0, 0, 0, 0);
@@ -1,3 +1,7 @@
+#include <cstring>
+#include <string>
+#include <vector>
+
 #include "common/api/os_sys_calls_impl.h"
 #include "common/stats/stats_impl.h"
 
@@ -7,11 +11,15 @@
 #include "test/mocks/server/mocks.h"
 #include "test/test_common/threadsafe_singleton_injector.h"
 
+#include "fmt/format.h"
 #include "gtest/gtest.h"
 
+using testing::AnyNumber;
 using testing::Invoke;
 using testing::InvokeWithoutArgs;
 using testing::Return;
+using testing::StartsWith;
+using testing::StrEq;
 using testing::WithArg;
 using testing::_;
 
@@ -21,7 +29,9 @@ namespace Server {
 class HotRestartImplTest : public testing::Test {
 public:
   void setup() {
-    EXPECT_CALL(os_sys_calls_, shmUnlink(_));
+    EXPECT_CALL(os_sys_calls_, shmUnlink(StrEq("/envoy_shared_memory_0")));
+    EXPECT_CALL(os_sys_calls_, shmUnlink(StartsWith("/envoy_shared_memory_0_stats_")))
+        .Times(AnyNumber());
     EXPECT_CALL(os_sys_calls_, shmOpen(_, _, _));
     EXPECT_CALL(os_sys_calls_, ftruncate(_, _)).WillOnce(WithArg<1>(Invoke([this](off_t size) {
       buffer_.resize(size);
@@ -50,9 +60,45 @@ public:
   TestThreadsafeSingletonInjector<Api::OsSysCallsImpl> os_calls{&os_sys_calls_};
   NiceMock<MockOptions> options_;
   std::vector<uint8_t> buffer_;
+  std::vector<uint8_t> segment_buffer_;
   std::unique_ptr<HotRestartImpl> hot_restart_;
 };
 
+TEST(HotRestartImplDnsResultsTest, EncodeDecode) {
+  std::vector<Network::DnsResult> results;
+  results.push_back({"foo.com", Network::DnsLookupFamily::V4Only, {"10.0.0.1", "10.0.0.2"}});
+  results.push_back({std::string(200, 'a'), Network::DnsLookupFamily::Auto, {"::1"}});
+  results.push_back({"bar.com", Network::DnsLookupFamily::V6Only, {"fe80::1"}});
+
+  // Only what fits is written and the rest is picked up from the returned index.
+  char buffer[64];
+  EXPECT_EQ(1UL, HotRestartImpl::encodeDnsResults(results, 0, buffer, sizeof(buffer)));
+  std::vector<Network::DnsResult> decoded;
+  HotRestartImpl::decodeDnsResults(buffer, strlen(buffer), decoded);
+  ASSERT_EQ(1UL, decoded.size());
+  EXPECT_EQ("foo.com", decoded[0].dns_name_);
+  EXPECT_EQ(Network::DnsLookupFamily::V4Only, decoded[0].dns_lookup_family_);
+  EXPECT_EQ((std::vector<std::string>{"10.0.0.1", "10.0.0.2"}), decoded[0].addresses_);
+
+  // A result that can never fit is skipped.
+  EXPECT_EQ(3UL, HotRestartImpl::encodeDnsResults(results, 1, buffer, sizeof(buffer)));
+  decoded.clear();
+  HotRestartImpl::decodeDnsResults(buffer, strlen(buffer), decoded);
+  ASSERT_EQ(1UL, decoded.size());
+  EXPECT_EQ("bar.com", decoded[0].dns_name_);
+  EXPECT_EQ(Network::DnsLookupFamily::V6Only, decoded[0].dns_lookup_family_);
+
+  EXPECT_EQ(3UL, HotRestartImpl::encodeDnsResults(results, 3, buffer, sizeof(buffer)));
+  EXPECT_STREQ("", buffer);
+
+  // Malformed lines are ignored.
+  const std::string malformed = "foo.com 7 10.0.0.1\nfoo.com\nbar.com 0 10.0.0.3\n";
+  decoded.clear();
+  HotRestartImpl::decodeDnsResults(malformed.c_str(), malformed.size(), decoded);
+  ASSERT_EQ(1UL, decoded.size());
+  EXPECT_EQ("bar.com", decoded[0].dns_name_);
+}
+
 TEST_F(HotRestartImplTest, versionString) {
   setup();
   EXPECT_EQ(hot_restart_->version(),
@@ -87,16 +133,130 @@ TEST_F(HotRestartImplTest, crossAlloc) {
   EXPECT_EQ(stat5, stat5_prime);
 }
 
+TEST_F(HotRestartImplTest, freeReuse) {
+  setup();
+
+  Stats::RawStatData* stat1 = hot_restart_->alloc("stat1");
+  Stats::RawStatData* stat2 = hot_restart_->alloc("stat2");
+  hot_restart_->free(*stat1);
+
+  // A name of the same length reuses the freed block, longer names need a new one.
+  Stats::RawStatData* stat3 = hot_restart_->alloc(std::string(64, 'a'));
+  Stats::RawStatData* stat4 = hot_restart_->alloc("stat4");
+  EXPECT_NE(stat1, stat3);
+  EXPECT_EQ(stat1, stat4);
+  EXPECT_EQ(0UL, stat4->value_.load());
+  EXPECT_EQ(1U, stat4->ref_count_.load());
+  EXPECT_STREQ("stat2", stat2->name_);
+}
+
+TEST_F(HotRestartImplTest, indexFreedSlots) {
+  setup();
+
+  // Stats are found past the slots of freed ones, and new stats reuse those slots.
+  std::vector<Stats::RawStatData*> stats;
+  for (int i = 0; i < 64; i++) {
+    stats.push_back(hot_restart_->alloc(fmt::format("stat{}", i)));
+  }
+  for (int i = 0; i < 64; i += 2) {
+    hot_restart_->free(*stats[i]);
+  }
+  for (int i = 1; i < 64; i += 2) {
+    Stats::RawStatData* stat = hot_restart_->alloc(fmt::format("stat{}", i));
+    EXPECT_EQ(stats[i], stat);
+    EXPECT_EQ(2U, stat->ref_count_.load());
+  }
+  for (int i = 0; i < 64; i += 2) {
+    EXPECT_STREQ(fmt::format("stat{}", i).c_str(),
+                 hot_restart_->alloc(fmt::format("stat{}", i))->name_);
+  }
+}
+
+TEST_F(HotRestartImplTest, indexOverflow) {
+  EXPECT_CALL(options_, maxStats()).WillRepeatedly(Return(2));
+  setup();
+
+  // The index of 4 slots takes 3 stats. Short names leave room in the first segment for more.
+  Stats::RawStatData* stat1 = hot_restart_->alloc("stat1");
+  Stats::RawStatData* stat2 = hot_restart_->alloc("stat2");
+  hot_restart_->free(*stat2);
+  EXPECT_NE(nullptr, hot_restart_->alloc("stat3"));
+  EXPECT_NE(nullptr, hot_restart_->alloc("stat4"));
+  Stats::RawStatData* stat5 = hot_restart_->alloc("stat5");
+  EXPECT_NE(nullptr, stat5);
+
+  // Stats are still found once the index is no longer used.
+  EXPECT_EQ(stat1, hot_restart_->alloc("stat1"));
+  EXPECT_EQ(stat5, hot_restart_->alloc("stat5"));
+  hot_restart_->free(*stat1);
+  hot_restart_->free(*stat1);
+  EXPECT_EQ(stat1, hot_restart_->alloc("stat6"));
+}
+
+TEST_F(HotRestartImplTest, growSegments) {
+  EXPECT_CALL(options_, maxStats()).WillRepeatedly(Return(2));
+  setup();
+
+  // Stats with names of the maximum length fill the first segment after maxStats() of them.
+  auto name = [](char c) { return std::string(Stats::RawStatData::maxNameLength(), c); };
+  EXPECT_NE(nullptr, hot_restart_->alloc(name('1')));
+  EXPECT_NE(nullptr, hot_restart_->alloc(name('2')));
+
+  // The first segment is full, so the next stat creates a second one.
+  EXPECT_CALL(os_sys_calls_, shmOpen(StrEq("/envoy_shared_memory_0_stats_1"),
+                                     O_RDWR | O_CREAT | O_EXCL, _))
+      .WillOnce(Return(1));
+  EXPECT_CALL(os_sys_calls_, ftruncate(1, _)).WillOnce(WithArg<1>(Invoke([this](off_t size) {
+    segment_buffer_.resize(size);
+    return 0;
+  })));
+  EXPECT_CALL(os_sys_calls_, mmap(_, _, _, _, 1, _)).WillOnce(InvokeWithoutArgs([this]() {
+    return segment_buffer_.data();
+  }));
+  EXPECT_CALL(os_sys_calls_, close(1));
+  Stats::RawStatData* stat3 = hot_restart_->alloc(name('3'));
+  EXPECT_GE(reinterpret_cast<uint8_t*>(stat3), segment_buffer_.data());
+  EXPECT_LT(reinterpret_cast<uint8_t*>(stat3), segment_buffer_.data() + segment_buffer_.size());
+
+  // A hot restarted process maps the segment the first time it allocates.
+  EXPECT_CALL(options_, restartEpoch()).WillRepeatedly(Return(1));
+  EXPECT_CALL(os_sys_calls_, shmOpen(StrEq("/envoy_shared_memory_0"), _, _));
+  EXPECT_CALL(os_sys_calls_, mmap(_, _, _, _, 0, _)).WillOnce(Return(buffer_.data()));
+  EXPECT_CALL(os_sys_calls_, bind(_, _, _));
+  HotRestartImpl hot_restart2(options_);
+
+  EXPECT_CALL(os_sys_calls_, shmOpen(StrEq("/envoy_shared_memory_0_stats_1"), O_RDWR, _))
+      .WillOnce(Return(2));
+  EXPECT_CALL(os_sys_calls_, mmap(_, segment_buffer_.size(), _, _, 2, _))
+      .WillOnce(Return(segment_buffer_.data()));
+  EXPECT_CALL(os_sys_calls_, close(2));
+  EXPECT_EQ(stat3, hot_restart2.alloc(name('3')));
+}
+
 TEST_F(HotRestartImplTest, allocFail) {
   EXPECT_CALL(options_, maxStats()).WillRepeatedly(Return(2));
   setup();
 
-  Stats::RawStatData* s1 = hot_restart_->alloc("1");
-  Stats::RawStatData* s2 = hot_restart_->alloc("2");
-  Stats::RawStatData* s3 = hot_restart_->alloc("3");
+  auto name = [](char c) { return std::string(Stats::RawStatData::maxNameLength(), c); };
+  Stats::RawStatData* s1 = hot_restart_->alloc(name('1'));
+  Stats::RawStatData* s2 = hot_restart_->alloc(name('2'));
+  EXPECT_CALL(os_sys_calls_, shmOpen(_, _, _)).WillOnce(Return(-1));
+  Stats::RawStatData* s3 = hot_restart_->alloc(name('3'));
   EXPECT_NE(s1, nullptr);
   EXPECT_NE(s2, nullptr);
   EXPECT_EQ(s3, nullptr);
+
+  // Failing to map a new segment removes it again.
+  EXPECT_CALL(os_sys_calls_, shmOpen(_, _, _)).WillOnce(Return(1));
+  EXPECT_CALL(os_sys_calls_, ftruncate(1, _)).WillOnce(Return(0));
+  EXPECT_CALL(os_sys_calls_, mmap(_, _, _, _, 1, _)).WillOnce(Return(MAP_FAILED));
+  EXPECT_CALL(os_sys_calls_, close(1));
+  EXPECT_CALL(os_sys_calls_, shmUnlink(StrEq("/envoy_shared_memory_0_stats_1")));
+  EXPECT_EQ(nullptr, hot_restart_->alloc(name('3')));
+
+  // Freed space can still be used.
+  hot_restart_->free(*s1);
+  EXPECT_EQ(s1, hot_restart_->alloc(name('3')));
 }
 
 // Because the shared memory is managed manually, make sure it meets
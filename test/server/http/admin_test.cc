@@ -1,11 +1,15 @@
+#include <condition_variable>
 #include <fstream>
+#include <mutex>
 
 #include "common/http/message_impl.h"
 #include "common/profiler/profiler.h"
+#include "common/profiler/sampling_profiler.h"
 
 #include "server/http/admin.h"
 
 #include "test/mocks/server/mocks.h"
+#include "test/mocks/upstream/mocks.h"
 #include "test/test_common/environment.h"
 #include "test/test_common/network_utility.h"
 #include "test/test_common/printers.h"
@@ -14,7 +18,9 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
+using testing::Invoke;
 using testing::NiceMock;
+using testing::Return;
 using testing::_;
 
 namespace Envoy {
@@ -39,6 +45,30 @@ public:
   Http::TestHeaderMapImpl request_headers_;
 };
 
+/**
+ * Completes a request to a path whose response is rendered on the render thread, and waits for
+ * the response to be posted back to the main thread.
+ * @return Event::PostCb the posted callback, which sends the response.
+ */
+Event::PostCb renderOnRenderThread(NiceMock<MockInstance>& server, AdminFilter& filter,
+                                   Http::TestHeaderMapImpl& request_headers) {
+  std::mutex lock;
+  std::condition_variable posted_event;
+  Event::PostCb posted;
+  EXPECT_CALL(server.dispatcher_, post(_)).WillOnce(Invoke([&](Event::PostCb cb) -> void {
+    std::unique_lock<std::mutex> guard(lock);
+    posted = cb;
+    posted_event.notify_one();
+  }));
+  filter.decodeHeaders(request_headers, true);
+
+  std::unique_lock<std::mutex> guard(lock);
+  while (!posted) {
+    posted_event.wait(guard);
+  }
+  return posted;
+}
+
 INSTANTIATE_TEST_CASE_P(IpVersions, AdminFilterTest,
                         testing::ValuesIn(TestEnvironment::getIpVersionsForTest()));
 
@@ -54,6 +84,21 @@ TEST_P(AdminFilterTest, Body) {
   filter_.decodeData(data, true);
 }
 
+TEST_P(AdminFilterTest, StatsRenderedOnRenderThread) {
+  request_headers_.Path()->value(std::string("/stats/prometheus"));
+  Event::PostCb send_response = renderOnRenderThread(server_, filter_, request_headers_);
+  EXPECT_CALL(callbacks_, encodeHeaders_(_, _));
+  send_response();
+}
+
+TEST_P(AdminFilterTest, StatsRenderedAfterReset) {
+  request_headers_.Path()->value(std::string("/stats"));
+  Event::PostCb send_response = renderOnRenderThread(server_, filter_, request_headers_);
+  filter_.onDestroy();
+  EXPECT_CALL(callbacks_, encodeHeaders_(_, _)).Times(0);
+  send_response();
+}
+
 TEST_P(AdminFilterTest, Trailers) {
   filter_.decodeHeaders(request_headers_, false);
   Buffer::OwnedImpl data("hello");
@@ -95,6 +140,15 @@ TEST_P(AdminInstanceTest, AdminProfiler) {
   EXPECT_FALSE(Profiler::Cpu::profilerEnabled());
 }
 
+TEST_P(AdminInstanceTest, AdminHeapProfilerRunning) {
+  Buffer::OwnedImpl data;
+  EXPECT_EQ(Http::Code::OK, admin_.runCallback("/heapprofiler?enable=y", data));
+  EXPECT_TRUE(Profiler::Heap::profilerEnabled());
+  EXPECT_EQ(Http::Code::OK, admin_.runCallback("/heapprofiler?enable=dump", data));
+  EXPECT_EQ(Http::Code::OK, admin_.runCallback("/heapprofiler?enable=n", data));
+  EXPECT_FALSE(Profiler::Heap::profilerEnabled());
+}
+
 #endif
 
 TEST_P(AdminInstanceTest, AdminBadProfiler) {
@@ -106,6 +160,30 @@ TEST_P(AdminInstanceTest, AdminBadProfiler) {
   EXPECT_FALSE(Profiler::Cpu::profilerEnabled());
 }
 
+// As with the CPU profiler, the heap profiler only starts when it is linked in.
+TEST_P(AdminInstanceTest, AdminHeapProfiler) {
+  Buffer::OwnedImpl data;
+  EXPECT_EQ(Http::Code::BadRequest, admin_.runCallback("/heapprofiler", data));
+  EXPECT_EQ(Http::Code::BadRequest, admin_.runCallback("/heapprofiler?enable=x", data));
+  EXPECT_EQ(Http::Code::BadRequest, admin_.runCallback("/heapprofiler?enable=dump", data));
+  EXPECT_EQ(Http::Code::OK, admin_.runCallback("/heapprofiler?enable=n", data));
+  EXPECT_FALSE(Profiler::Heap::profilerEnabled());
+}
+
+TEST_P(AdminInstanceTest, AdminSamplingProfiler) {
+  Buffer::OwnedImpl data;
+  EXPECT_EQ(Http::Code::BadRequest, admin_.runCallback("/profile?enable=x", data));
+  EXPECT_EQ(Http::Code::OK, admin_.runCallback("/profile?enable=y", data));
+  EXPECT_TRUE(Profiler::Sampling::profilerEnabled());
+  EXPECT_EQ(Http::Code::OK, admin_.runCallback("/profile?enable=y", data));
+  EXPECT_EQ(Http::Code::OK, admin_.runCallback("/profile?enable=n", data));
+  EXPECT_FALSE(Profiler::Sampling::profilerEnabled());
+
+  data.drain(data.length());
+  EXPECT_EQ(Http::Code::OK, admin_.runCallback("/profile", data));
+  EXPECT_EQ(Profiler::Sampling::foldedStacks(), TestUtility::bufferToString(data));
+}
+
 TEST_P(AdminInstanceTest, WriteAddressToFile) {
   std::ifstream address_file(address_out_path_);
   std::string address_from_file;
@@ -148,5 +226,59 @@ TEST_P(AdminInstanceTest, CustomHandler) {
   EXPECT_EQ(Http::Code::Accepted, admin_.runCallback("/foo/bar", response));
 }
 
+TEST_P(AdminInstanceTest, ServerInfoStartupPhases) {
+  server_.startup_phases_.emplace_back("bootstrap", std::chrono::milliseconds(12));
+  server_.startup_phases_.emplace_back("clusters", std::chrono::milliseconds(345));
+
+  Buffer::OwnedImpl response;
+  EXPECT_EQ(Http::Code::OK, admin_.runCallback("/server_info", response));
+  const std::string info = TestUtility::bufferToString(response);
+  EXPECT_EQ(0, info.find("envoy "));
+  EXPECT_NE(std::string::npos, info.find("\nstartup bootstrap 12ms\nstartup clusters 345ms\n"));
+}
+
+TEST_P(AdminInstanceTest, ClustersFilterAndFormat) {
+  NiceMock<Upstream::MockCluster> cluster;
+  Upstream::ClusterManager::ClusterInfoMap cluster_map;
+  cluster_map.emplace("fake_cluster", cluster);
+  ON_CALL(server_.cluster_manager_, clusters()).WillByDefault(Return(cluster_map));
+
+  Buffer::OwnedImpl response;
+  EXPECT_EQ(Http::Code::OK, admin_.runCallback("/clusters?cluster=fake_cluster", response));
+  EXPECT_NE(std::string::npos,
+            TestUtility::bufferToString(response).find("fake_cluster::added_via_api::false\n"));
+
+  Buffer::OwnedImpl json_response;
+  EXPECT_EQ(Http::Code::OK,
+            admin_.runCallback("/clusters?format=json&cluster=fake_cluster", json_response));
+  EXPECT_EQ(0, TestUtility::bufferToString(json_response)
+                   .find("{\"version_info\":\"\",\"clusters\":[{\"name\":\"fake_cluster\","
+                         "\"added_via_api\":false,\"circuit_breakers\":{\"default\":{"));
+
+  Buffer::OwnedImpl unknown_response;
+  EXPECT_EQ(Http::Code::NotFound, admin_.runCallback("/clusters?cluster=other", unknown_response));
+  EXPECT_EQ("unknown cluster: other\n", TestUtility::bufferToString(unknown_response));
+
+  Buffer::OwnedImpl bad_response;
+  EXPECT_EQ(Http::Code::BadRequest, admin_.runCallback("/clusters?format=xml", bad_response));
+}
+
+TEST_P(AdminInstanceTest, FilterTimes) {
+  Stats::Store& store = server_.stats_store_;
+  store.counter("http.ingress.filter.envoy.router.time_ns").add(20000);
+  store.counter("http.ingress.filter.envoy.router.rq_sampled").add(10);
+  store.counter("http.ingress.filter.envoy.lua.time_ns").add(150000);
+  store.counter("http.ingress.filter.envoy.lua.rq_sampled").add(10);
+  // Never sampled.
+  store.counter("http.ingress.filter.envoy.cors.time_ns");
+  store.counter("http.ingress.downstream_rq_total").add(10);
+
+  Buffer::OwnedImpl response;
+  EXPECT_EQ(Http::Code::OK, admin_.runCallback("/filter_times", response));
+  EXPECT_EQ("http.ingress.filter.envoy.lua: 15.0us per request, 10 requests sampled\n"
+            "http.ingress.filter.envoy.router: 2.0us per request, 10 requests sampled\n",
+            TestUtility::bufferToString(response));
+}
+
 } // namespace Server
 } // namespace Envoy
@@ -519,6 +519,75 @@ TEST_F(ListenerManagerImplTest, CantBindSocket) {
                EnvoyException);
 }
 
+TEST_F(ListenerManagerImplTest, ReusePortSocketPerWorker) {
+  // Use a manager with two workers.
+  ON_CALL(server_.options_, concurrency()).WillByDefault(Return(2));
+  EXPECT_CALL(worker_factory_, createWorker_())
+      .WillOnce(Return(new MockWorker()))
+      .WillOnce(Return(new MockWorker()));
+  ListenerManagerImpl manager(server_, listener_factory_, worker_factory_);
+
+  const std::string listener_foo_json = R"EOF(
+  {
+    "name": "foo",
+    "address": "tcp://127.0.0.1:0",
+    "filters": []
+  }
+  )EOF";
+
+  ON_CALL(server_.runtime_loader_.snapshot_, getInteger("listener.foo.reuse_port", 0))
+      .WillByDefault(Return(1));
+  auto socket0 = std::make_shared<NiceMock<Network::MockListenSocket>>();
+  auto socket1 = std::make_shared<NiceMock<Network::MockListenSocket>>();
+  ListenerHandle* listener_foo = expectListenerCreate(false);
+  EXPECT_CALL(listener_factory_, createListenSocket(_, _)).Times(0);
+  EXPECT_CALL(listener_factory_, createReusePortListenSocket(_, 0)).WillOnce(Return(socket0));
+  // The second socket binds to the port the first one got.
+  EXPECT_CALL(listener_factory_, createReusePortListenSocket(socket0->local_address_, 1))
+      .WillOnce(Return(socket1));
+  EXPECT_TRUE(manager.addOrUpdateListener(parseListenerFromJson(listener_foo_json)));
+
+  Listener& listener = manager.listeners()[0].get();
+  EXPECT_EQ(2U, listener.numSockets());
+  EXPECT_EQ(socket0.get(), &listener.socket());
+  EXPECT_EQ(socket0.get(), &listener.workerSocket(0));
+  EXPECT_EQ(socket1.get(), &listener.workerSocket(1));
+  EXPECT_CALL(*listener_foo, onDestroy());
+}
+
+TEST_F(ListenerManagerImplTest, ConnectionBalance) {
+  const std::string listener_foo_json = R"EOF(
+  {
+    "name": "foo",
+    "address": "tcp://127.0.0.1:1234",
+    "filters": []
+  }
+  )EOF";
+
+  ListenerHandle* listener_foo = expectListenerCreate(false);
+  EXPECT_CALL(listener_factory_, createListenSocket(_, true));
+  EXPECT_TRUE(manager_->addOrUpdateListener(parseListenerFromJson(listener_foo_json)));
+  EXPECT_EQ(nullptr, manager_->listeners()[0].get().connectionBalancer());
+
+  const std::string listener_bar_json = R"EOF(
+  {
+    "name": "bar",
+    "address": "tcp://127.0.0.1:1235",
+    "filters": []
+  }
+  )EOF";
+
+  ON_CALL(server_.runtime_loader_.snapshot_, getInteger("listener.bar.connection_balance", 0))
+      .WillByDefault(Return(1));
+  ListenerHandle* listener_bar = expectListenerCreate(false);
+  EXPECT_CALL(listener_factory_, createListenSocket(_, true));
+  EXPECT_TRUE(manager_->addOrUpdateListener(parseListenerFromJson(listener_bar_json)));
+  EXPECT_NE(nullptr, manager_->listeners()[1].get().connectionBalancer());
+
+  EXPECT_CALL(*listener_foo, onDestroy());
+  EXPECT_CALL(*listener_bar, onDestroy());
+}
+
 TEST_F(ListenerManagerImplTest, ListenerDraining) {
   InSequence s;
 
@@ -544,6 +613,13 @@ TEST_F(ListenerManagerImplTest, ListenerDraining) {
   EXPECT_CALL(server_.drain_manager_, drainClose()).WillOnce(Return(false));
   EXPECT_FALSE(listener_foo->context_->drainDecision().drainClose());
 
+  // Keep alive is disabled while the overload manager says so.
+  EXPECT_CALL(*listener_foo->drain_manager_, drainClose()).WillOnce(Return(false));
+  EXPECT_CALL(server_.drain_manager_, drainClose()).WillOnce(Return(false));
+  EXPECT_CALL(server_.overload_manager_, isActive(OverloadActionName::DisableHttpKeepAlive))
+      .WillOnce(Return(true));
+  EXPECT_TRUE(listener_foo->context_->drainDecision().drainClose());
+
   EXPECT_CALL(*worker_, stopListener(_));
   EXPECT_CALL(*listener_foo->drain_manager_, startDrainSequence(_));
   EXPECT_TRUE(manager_->removeListener("foo"));
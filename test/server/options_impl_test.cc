@@ -60,12 +60,20 @@ TEST(OptionsImplTest, All) {
   std::unique_ptr<OptionsImpl> options = createOptionsImpl(
       "envoy --mode validate --concurrency 2 -c hello --admin-address-path path --restart-epoch 1 "
       "--local-address-ip-version v6 -l info --service-cluster cluster --service-node node "
-      "--service-zone zone --file-flush-interval-msec 9000 --drain-time-s 60 "
-      "--parent-shutdown-time-s 90 --log-path /foo/bar --v2-config-only");
+      "--service-zone zone --file-flush-interval-msec 9000 --file-write-buffer-bytes 131072 "
+      "--drain-time-s 60 "
+      "--parent-shutdown-time-s 90 --log-path /foo/bar --v2-config-only "
+      "--enable-dispatcher-stats --log-async --worker-cpu-affinity --ssl-private-key-threads 4 "
+      "--dns-cache-ttl-ms 3000");
   EXPECT_EQ(Server::Mode::Validate, options->mode());
   EXPECT_EQ(2U, options->concurrency());
   EXPECT_EQ("hello", options->configPath());
   EXPECT_TRUE(options->v2ConfigOnly());
+  EXPECT_TRUE(options->dispatcherStatsEnabled());
+  EXPECT_TRUE(options->logAsync());
+  EXPECT_TRUE(options->workerCpuAffinity());
+  EXPECT_EQ(4U, options->sslPrivateKeyThreads());
+  EXPECT_EQ(std::chrono::milliseconds(3000), options->dnsCacheTtl());
   EXPECT_EQ("path", options->adminAddressPath());
   EXPECT_EQ(Network::Address::IpVersion::v6, options->localAddressIpVersion());
   EXPECT_EQ(1U, options->restartEpoch());
@@ -75,6 +83,7 @@ TEST(OptionsImplTest, All) {
   EXPECT_EQ("node", options->serviceNodeName());
   EXPECT_EQ("zone", options->serviceZone());
   EXPECT_EQ(std::chrono::milliseconds(9000), options->fileFlushIntervalMsec());
+  EXPECT_EQ(131072U, options->fileWriteBufferBytes());
   EXPECT_EQ(std::chrono::seconds(60), options->drainTime());
   EXPECT_EQ(std::chrono::seconds(90), options->parentShutdownTime());
 }
@@ -86,6 +95,11 @@ TEST(OptionsImplTest, DefaultParams) {
   EXPECT_EQ("", options->adminAddressPath());
   EXPECT_EQ(Network::Address::IpVersion::v4, options->localAddressIpVersion());
   EXPECT_EQ(Server::Mode::Serve, options->mode());
+  EXPECT_FALSE(options->dispatcherStatsEnabled());
+  EXPECT_FALSE(options->logAsync());
+  EXPECT_FALSE(options->workerCpuAffinity());
+  EXPECT_EQ(0U, options->sslPrivateKeyThreads());
+  EXPECT_EQ(std::chrono::milliseconds(0), options->dnsCacheTtl());
 }
 
 TEST(OptionsImplTest, BadCliOption) {
@@ -105,4 +119,14 @@ TEST(OptionsImplTest, BadObjNameLenOption) {
     EXPECT_THAT(e.what(), HasSubstr("'max-obj-name-len' value specified"));
   }
 }
+
+TEST(OptionsImplTest, BadFileWriteBufferBytesOption) {
+  try {
+    createOptionsImpl("envoy --file-write-buffer-bytes 0");
+    FAIL();
+  } catch (const MalformedArgvException& e) {
+    EXPECT_THAT(e.what(), HasSubstr("'file-write-buffer-bytes' value specified (0) is less than "
+                                    "the minimum value of 65536"));
+  }
+}
 } // namespace Envoy
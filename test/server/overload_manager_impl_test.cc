@@ -0,0 +1,147 @@
+#include <chrono>
+
+#include "server/overload_manager_impl.h"
+
+#include "test/mocks/common.h"
+#include "test/mocks/event/mocks.h"
+#include "test/mocks/server/mocks.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::Invoke;
+using testing::NiceMock;
+using testing::Return;
+using testing::_;
+
+namespace Envoy {
+namespace Server {
+
+class OverloadManagerImplTest : public testing::Test {
+public:
+  OverloadManagerImplTest() {
+    ON_CALL(time_source_, currentTime()).WillByDefault(Invoke([this]() -> MonotonicTime {
+      return MonotonicTime(std::chrono::milliseconds(now_ms_));
+    }));
+    ON_CALL(server_.runtime_loader_.snapshot_, getInteger("overload.max_active_connections", _))
+        .WillByDefault(Return(100));
+  }
+
+  void setConnections(uint64_t connections) {
+    ON_CALL(server_.listener_manager_, numConnections()).WillByDefault(Return(connections));
+  }
+
+  uint64_t gauge(const std::string& name) { return server_.stats_store_.gauge(name).value(); }
+
+  NiceMock<MockInstance> server_;
+  NiceMock<MockMonotonicTimeSource> time_source_;
+  uint64_t now_ms_{};
+};
+
+TEST_F(OverloadManagerImplTest, ActionsFollowPressure) {
+  OverloadManagerImpl manager(server_, time_source_);
+
+  NiceMock<Event::MockDispatcher> worker_dispatcher;
+  std::vector<OverloadActionState> stop_accepting_states;
+  manager.registerForAction(OverloadActionName::StopAcceptingConnections, worker_dispatcher,
+                            [&](OverloadActionState state) -> void {
+                              stop_accepting_states.push_back(state);
+                            });
+
+  Event::MockTimer* refresh_timer = new Event::MockTimer(&server_.dispatcher_);
+  EXPECT_CALL(*refresh_timer, enableTimer(std::chrono::milliseconds(1000)));
+  setConnections(10);
+  manager.start();
+  EXPECT_EQ(10UL, gauge("overload.pressure"));
+  EXPECT_FALSE(manager.isActive(OverloadActionName::DisableHttpKeepAlive));
+  EXPECT_TRUE(stop_accepting_states.empty());
+
+  // Keep alive is disabled first, and connections are still accepted.
+  EXPECT_CALL(*refresh_timer, enableTimer(_));
+  setConnections(85);
+  refresh_timer->callback_();
+  EXPECT_EQ(85UL, gauge("overload.pressure"));
+  EXPECT_TRUE(manager.isActive(OverloadActionName::DisableHttpKeepAlive));
+  EXPECT_FALSE(manager.isActive(OverloadActionName::ShrinkBufferLimits));
+  EXPECT_EQ(1UL, gauge("overload.disable_http_keepalive.active"));
+  EXPECT_TRUE(stop_accepting_states.empty());
+
+  EXPECT_CALL(*refresh_timer, enableTimer(_));
+  setConnections(100);
+  refresh_timer->callback_();
+  EXPECT_TRUE(manager.isActive(OverloadActionName::StopAcceptingConnections));
+  EXPECT_EQ(std::vector<OverloadActionState>{OverloadActionState::Active}, stop_accepting_states);
+
+  // Registering for an active action immediately delivers its state.
+  std::vector<OverloadActionState> late_states;
+  manager.registerForAction(
+      OverloadActionName::StopAcceptingConnections, worker_dispatcher,
+      [&](OverloadActionState state) -> void { late_states.push_back(state); });
+  EXPECT_EQ(std::vector<OverloadActionState>{OverloadActionState::Active}, late_states);
+
+  EXPECT_CALL(*refresh_timer, enableTimer(_));
+  setConnections(0);
+  refresh_timer->callback_();
+  EXPECT_FALSE(manager.isActive(OverloadActionName::StopAcceptingConnections));
+  EXPECT_EQ(0UL, gauge("overload.stop_accepting_connections.active"));
+  EXPECT_EQ((std::vector<OverloadActionState>{OverloadActionState::Active,
+                                              OverloadActionState::Inactive}),
+            stop_accepting_states);
+}
+
+TEST_F(OverloadManagerImplTest, RuntimeThreshold) {
+  ON_CALL(server_.runtime_loader_.snapshot_,
+          getInteger("overload.stop_accepting_connections.threshold", _))
+      .WillByDefault(Return(50));
+  OverloadManagerImpl manager(server_, time_source_);
+
+  new NiceMock<Event::MockTimer>(&server_.dispatcher_);
+  setConnections(60);
+  manager.start();
+  EXPECT_TRUE(manager.isActive(OverloadActionName::StopAcceptingConnections));
+  EXPECT_FALSE(manager.isActive(OverloadActionName::ShrinkBufferLimits));
+}
+
+TEST_F(OverloadManagerImplTest, EventLoopLag) {
+  ON_CALL(server_.runtime_loader_.snapshot_, getInteger("overload.max_event_loop_lag_ms", _))
+      .WillByDefault(Return(1000));
+  OverloadManagerImpl manager(server_, time_source_);
+
+  // Hold on to the probe tasks posted to the worker so the test decides when they run.
+  NiceMock<Event::MockDispatcher> worker_dispatcher;
+  std::vector<Event::PostCb> posted;
+  ON_CALL(worker_dispatcher, post(_)).WillByDefault(Invoke([&](Event::PostCb cb) -> void {
+    posted.push_back(cb);
+  }));
+  manager.registerForAction(OverloadActionName::ShrinkBufferLimits, worker_dispatcher,
+                            [](OverloadActionState) -> void {});
+
+  NiceMock<Event::MockTimer>* refresh_timer =
+      new NiceMock<Event::MockTimer>(&server_.dispatcher_);
+  manager.start();
+  ASSERT_EQ(1UL, posted.size());
+  EXPECT_EQ(0UL, gauge("overload.event_loop_lag_ms"));
+
+  // The probe has not run yet, so the loop is at least as far behind as the probe is old.
+  now_ms_ = 95;
+  refresh_timer->callback_();
+  EXPECT_EQ(1UL, posted.size());
+  EXPECT_EQ(95UL, gauge("overload.event_loop_lag_ms"));
+  EXPECT_EQ(9UL, gauge("overload.pressure"));
+
+  // Once it runs its lag is reported, and a new probe is posted.
+  posted[0]();
+  posted.clear();
+  now_ms_ = 100;
+  refresh_timer->callback_();
+  EXPECT_EQ(95UL, gauge("overload.event_loop_lag_ms"));
+  EXPECT_EQ(1UL, posted.size());
+
+  posted[0]();
+  refresh_timer->callback_();
+  EXPECT_EQ(0UL, gauge("overload.event_loop_lag_ms"));
+  EXPECT_EQ(0UL, gauge("overload.pressure"));
+}
+
+} // namespace Server
+} // namespace Envoy
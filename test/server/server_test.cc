@@ -14,6 +14,8 @@
 using testing::HasSubstr;
 using testing::InSequence;
 using testing::Property;
+using testing::Ref;
+using testing::Return;
 using testing::SaveArg;
 using testing::StrictMock;
 using testing::_;
@@ -35,7 +37,26 @@ TEST(ServerInstanceUtil, flushHelper) {
 
   std::list<Stats::SinkPtr> sinks;
   sinks.emplace_back(std::move(sink));
-  InstanceUtil::flushCountersAndGaugesToSinks(sinks, store);
+  InstanceUtil::flushMetricsToSinks(sinks, store);
+}
+
+TEST(ServerInstanceUtil, flushHistograms) {
+  InSequence s;
+
+  NiceMock<Stats::MockStore> store;
+  auto histogram = std::make_shared<NiceMock<Stats::MockParentHistogram>>();
+  histogram->name_ = "timer";
+  ON_CALL(store, histograms())
+      .WillByDefault(Return(std::list<Stats::ParentHistogramSharedPtr>{histogram}));
+  std::unique_ptr<Stats::MockSink> sink(new StrictMock<Stats::MockSink>());
+  EXPECT_CALL(*sink, beginFlush());
+  EXPECT_CALL(*histogram, merge());
+  EXPECT_CALL(*sink, flushHistogram(Ref(*histogram)));
+  EXPECT_CALL(*sink, endFlush());
+
+  std::list<Stats::SinkPtr> sinks;
+  sinks.emplace_back(std::move(sink));
+  InstanceUtil::flushMetricsToSinks(sinks, store);
 }
 
 class RunHelperTest : public testing::Test {
@@ -148,6 +169,20 @@ TEST_P(ServerInstanceImplTest, V1ConfigFallback) {
   initialize(std::string());
 }
 
+TEST_P(ServerInstanceImplTest, ParallelV1ConfigLoad) {
+  options_.service_cluster_name_ = "some_cluster_name";
+  options_.service_node_name_ = "some_node_name";
+  ON_CALL(options_, concurrency()).WillByDefault(Return(4));
+  initialize(std::string());
+
+  std::vector<std::string> phases;
+  for (const auto& phase : server_->startupPhases()) {
+    phases.push_back(phase.first);
+  }
+  EXPECT_EQ(std::vector<std::string>({"bootstrap", "runtime", "clusters", "listeners"}), phases);
+  EXPECT_FALSE(server_->listenerManager().listeners().empty());
+}
+
 TEST_P(ServerInstanceImplTest, Stats) {
   options_.service_cluster_name_ = "some_cluster_name";
   options_.service_node_name_ = "some_node_name";
@@ -0,0 +1,45 @@
+#include <atomic>
+#include <vector>
+
+#include "common/common/thread.h"
+
+#include "server/thread_stack_capture.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Server {
+
+#ifdef __linux__
+TEST(ThreadStackCaptureTest, CaptureOtherThread) {
+  std::atomic<int32_t> thread_id{};
+  std::atomic<bool> done{};
+  Thread::Thread thread([&]() -> void {
+    thread_id = Thread::Thread::currentThreadId();
+    while (!done) {
+    }
+  });
+  while (thread_id == 0) {
+  }
+
+  // Twice, to check that the first capture leaves the state for the next.
+  for (int i = 0; i < 2; i++) {
+    std::vector<void*> frames;
+    EXPECT_TRUE(ThreadStackCapture::capture(thread_id, frames));
+    EXPECT_FALSE(frames.empty());
+    EXPECT_GE(ThreadStackCapture::MAX_STACK_DEPTH, frames.size());
+  }
+
+  done = true;
+  thread.join();
+}
+#endif
+
+TEST(ThreadStackCaptureTest, NoSuchThread) {
+  std::vector<void*> frames;
+  EXPECT_FALSE(ThreadStackCapture::capture(0, frames));
+  EXPECT_TRUE(frames.empty());
+}
+
+} // namespace Server
+} // namespace Envoy
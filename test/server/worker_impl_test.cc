@@ -1,4 +1,5 @@
 #include "common/event/dispatcher_impl.h"
+#include "common/stats/stats_impl.h"
 
 #include "server/worker_impl.h"
 
@@ -13,6 +14,7 @@ using testing::InSequence;
 using testing::InvokeWithoutArgs;
 using testing::NiceMock;
 using testing::Return;
+using testing::SaveArg;
 using testing::Throw;
 using testing::_;
 
@@ -32,8 +34,15 @@ public:
   Network::MockConnectionHandler* handler_ = new Network::MockConnectionHandler();
   NiceMock<MockGuardDog> guard_dog_;
   DefaultTestHooks hooks_;
-  WorkerImpl worker_{tls_, hooks_, Event::DispatcherPtr{dispatcher_},
-                     Network::ConnectionHandlerPtr{handler_}};
+  NiceMock<MockOverloadManager> overload_manager_;
+  Stats::IsolatedStoreImpl stats_store_;
+  WorkerImpl worker_{tls_,
+                     hooks_,
+                     Event::DispatcherPtr{dispatcher_},
+                     Network::ConnectionHandlerPtr{handler_},
+                     0,
+                     overload_manager_,
+                     WorkerStats{ALL_WORKER_STATS(POOL_GAUGE(stats_store_))}};
   Event::TimerPtr no_exit_timer_ = dispatcher_->createTimer([]() -> void {});
 };
 
@@ -126,5 +135,35 @@ TEST_F(WorkerImplTest, ListenerException) {
   worker_.stop();
 }
 
+TEST_F(WorkerImplTest, OverloadActions) {
+  NiceMock<MockOverloadManager> overload_manager;
+  OverloadActionCb stop_accepting_connections;
+  OverloadActionCb shrink_buffer_limits;
+  EXPECT_CALL(overload_manager,
+              registerForAction(OverloadActionName::StopAcceptingConnections, _, _))
+      .WillOnce(SaveArg<2>(&stop_accepting_connections));
+  EXPECT_CALL(overload_manager, registerForAction(OverloadActionName::ShrinkBufferLimits, _, _))
+      .WillOnce(SaveArg<2>(&shrink_buffer_limits));
+
+  Network::MockConnectionHandler* handler = new Network::MockConnectionHandler();
+  WorkerImpl worker{tls_,
+                    hooks_,
+                    Event::DispatcherPtr{new Event::DispatcherImpl()},
+                    Network::ConnectionHandlerPtr{handler},
+                    1,
+                    overload_manager,
+                    WorkerStats{ALL_WORKER_STATS(POOL_GAUGE(stats_store_))}};
+
+  EXPECT_CALL(*handler, disableListeners());
+  stop_accepting_connections(OverloadActionState::Active);
+  EXPECT_CALL(*handler, enableListeners());
+  stop_accepting_connections(OverloadActionState::Inactive);
+
+  EXPECT_CALL(*handler, setConnectionBufferLimitCap(WorkerImpl::OVERLOAD_CONNECTION_BUFFER_LIMIT));
+  shrink_buffer_limits(OverloadActionState::Active);
+  EXPECT_CALL(*handler, setConnectionBufferLimitCap(0));
+  shrink_buffer_limits(OverloadActionState::Inactive);
+}
+
 } // namespace Server
 } // namespace Envoy